@@ -14,20 +14,39 @@
  *                Basic I/O primitives                                  *
  ************************************************************************/
 
+/* Observers that have more than this waiting to be written are
+ * too slow to keep up, and get disconnected.
+ */
+#define MAX_OBSERVER_BACKLOG (32 * 1024 * 1024)
+
+/* A read-only client. It gets the same messages as the client that
+ * owns the output, which are only encoded once. Writes to it never
+ * block, whatever it can't take yet is queued.
+ */
+typedef struct {
+  GIOStream *connection;
+  GQueue pending;         /* GBytes, the head is written up to pending_offset */
+  gsize pending_offset;
+  gsize pending_size;
+  GSource *source;        /* waiting for the connection to take more */
+  gboolean failed;
+} BroadwayObserver;
+
 struct BroadwayOutput {
   GOutputStream *out;
   GString *buf;
   int error;
   guint32 serial;
+  GPtrArray *observers;
 };
 
-static void
-broadway_output_send_cmd (BroadwayOutput *output,
-                          gboolean fin, BroadwayWSOpCode code,
-                          const void *buf, gsize count)
+static gsize
+broadway_output_build_header (guchar           header[16],
+                              gboolean         fin,
+                              BroadwayWSOpCode code,
+                              gsize            count)
 {
   gboolean mask = FALSE;
-  guchar header[16];
   size_t p;
 
   gboolean mid_header = count > 125 && count <= 65535;
@@ -48,12 +67,205 @@ broadway_output_send_cmd (BroadwayOutput *output,
       *(guint64 *)(header + p) = GUINT64_TO_BE( count );
       p += 8;
     }
+
+  return p;
+}
+
+static void
+broadway_output_send_cmd (BroadwayOutput *output,
+                          gboolean fin, BroadwayWSOpCode code,
+                          const void *buf, gsize count)
+{
+  guchar header[16];
+  size_t p;
+
+  p = broadway_output_build_header (header, fin, code, count);
+
   // FIXME: if we are paranoid we should 'mask' the data
   // FIXME: we should really emit these as a single write
   g_output_stream_write_all (output->out, header, p, NULL, NULL, NULL);
   g_output_stream_write_all (output->out, buf, count, NULL, NULL, NULL);
 }
 
+static void
+broadway_observer_free (BroadwayObserver *observer)
+{
+  if (observer->source)
+    {
+      g_source_destroy (observer->source);
+      g_source_unref (observer->source);
+    }
+  g_queue_clear_full (&observer->pending, (GDestroyNotify) g_bytes_unref);
+  g_io_stream_close (observer->connection, NULL, NULL);
+  g_object_unref (observer->connection);
+  g_free (observer);
+}
+
+static gboolean broadway_observer_writable_cb (GObject  *stream,
+                                               gpointer  data);
+
+/* Writes as much of the queue as the connection takes without blocking */
+static void
+broadway_observer_drain (BroadwayObserver *observer)
+{
+  GPollableOutputStream *out;
+  GBytes *bytes;
+
+  out = G_POLLABLE_OUTPUT_STREAM (g_io_stream_get_output_stream (observer->connection));
+
+  while ((bytes = g_queue_peek_head (&observer->pending)) != NULL)
+    {
+      const guchar *data;
+      gsize size;
+      gssize written;
+      GError *error = NULL;
+
+      data = g_bytes_get_data (bytes, &size);
+      written = g_pollable_output_stream_write_nonblocking (out,
+                                                           data + observer->pending_offset,
+                                                           size - observer->pending_offset,
+                                                           NULL, &error);
+      if (written < 0)
+        {
+          if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+            {
+              if (observer->source == NULL)
+                {
+                  observer->source = g_pollable_output_stream_create_source (out, NULL);
+                  g_source_set_callback (observer->source, (GSourceFunc) broadway_observer_writable_cb, observer, NULL);
+                  g_source_attach (observer->source, NULL);
+                }
+            }
+          else
+            observer->failed = TRUE;
+
+          g_error_free (error);
+          return;
+        }
+
+      observer->pending_offset += written;
+      observer->pending_size -= written;
+      if (observer->pending_offset == size)
+        {
+          g_bytes_unref (g_queue_pop_head (&observer->pending));
+          observer->pending_offset = 0;
+        }
+    }
+}
+
+static gboolean
+broadway_observer_writable_cb (GObject  *stream,
+                               gpointer  data)
+{
+  BroadwayObserver *observer = data;
+
+  broadway_observer_drain (observer);
+
+  if (observer->failed || g_queue_is_empty (&observer->pending))
+    {
+      g_clear_pointer (&observer->source, g_source_unref);
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+broadway_observer_send (BroadwayObserver *observer,
+                        GBytes           *message)
+{
+  if (observer->failed)
+    return;
+
+  if (observer->pending_size + g_bytes_get_size (message) > MAX_OBSERVER_BACKLOG)
+    {
+      g_debug ("Broadway observer fell behind, disconnecting it");
+      observer->failed = TRUE;
+      return;
+    }
+
+  g_queue_push_tail (&observer->pending, g_bytes_ref (message));
+  observer->pending_size += g_bytes_get_size (message);
+
+  if (observer->source == NULL)
+    broadway_observer_drain (observer);
+}
+
+/* Frames the buffer as a websocket message, once for all observers */
+static GBytes *
+broadway_output_build_message (BroadwayOutput *output)
+{
+  guchar header[16];
+  gsize p;
+  GByteArray *message;
+
+  p = broadway_output_build_header (header, TRUE, BROADWAY_WS_BINARY, output->buf->len);
+
+  message = g_byte_array_sized_new (p + output->buf->len);
+  g_byte_array_append (message, header, p);
+  g_byte_array_append (message, (const guint8 *) output->buf->str, output->buf->len);
+
+  return g_byte_array_free_to_bytes (message);
+}
+
+static void
+broadway_output_send_to_observers (BroadwayOutput *output)
+{
+  GBytes *message;
+  guint i;
+
+  for (i = output->observers->len; i > 0; i--)
+    {
+      BroadwayObserver *observer = g_ptr_array_index (output->observers, i - 1);
+
+      if (observer->failed)
+        g_ptr_array_remove_index_fast (output->observers, i - 1);
+    }
+
+  if (output->observers->len == 0)
+    return;
+
+  message = broadway_output_build_message (output);
+
+  for (i = 0; i < output->observers->len; i++)
+    broadway_observer_send (g_ptr_array_index (output->observers, i), message);
+
+  g_bytes_unref (message);
+}
+
+/* Adds a read-only client. It gets what was written since the last
+ * flush, which must be everything it needs to catch up, and after that
+ * everything the client that owns the output gets.
+ */
+void
+broadway_output_add_observer (BroadwayOutput *output,
+                              GIOStream      *connection)
+{
+  BroadwayObserver *observer;
+  GBytes *message;
+
+  observer = g_new0 (BroadwayObserver, 1);
+  observer->connection = g_object_ref (connection);
+  g_queue_init (&observer->pending);
+
+  if (output->buf->len > 0)
+    {
+      message = broadway_output_build_message (output);
+      broadway_observer_send (observer, message);
+      g_bytes_unref (message);
+
+      g_string_set_size (output->buf, 0);
+    }
+
+  g_ptr_array_add (output->observers, observer);
+}
+
+guint
+broadway_output_get_n_observers (BroadwayOutput *output)
+{
+  return output->observers->len;
+}
+
 void broadway_output_pong (BroadwayOutput *output)
 {
   broadway_output_send_cmd (output, TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
@@ -68,6 +280,8 @@ broadway_output_flush (BroadwayOutput *output)
   broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
                             output->buf->str, output->buf->len);
 
+  broadway_output_send_to_observers (output);
+
   g_string_set_size (output->buf, 0);
 
   return !output->error;
@@ -84,6 +298,7 @@ broadway_output_new (GOutputStream *out, guint32 serial)
   output->out = g_object_ref (out);
   output->buf = g_string_new ("");
   output->serial = serial;
+  output->observers = g_ptr_array_new_with_free_func ((GDestroyNotify) broadway_observer_free);
 
   return output;
 }
@@ -91,6 +306,7 @@ broadway_output_new (GOutputStream *out, guint32 serial)
 void
 broadway_output_free (BroadwayOutput *output)
 {
+  g_ptr_array_unref (output->observers);
   g_object_unref (output->out);
   free (output);
 }
@@ -611,6 +827,35 @@ broadway_output_upload_texture (BroadwayOutput *output,
   g_string_append_len (output->buf, g_bytes_get_data (texture, NULL), len);
 }
 
+/* Creates texture @id from texture @base_id with the PNG in @patch
+ * drawn at @x, @y. An empty @patch means the contents are the same.
+ */
+void
+broadway_output_upload_texture_delta (BroadwayOutput *output,
+                                      guint32 id,
+                                      guint32 base_id,
+                                      guint32 x,
+                                      guint32 y,
+                                      GBytes *patch)
+{
+  gsize len = g_bytes_get_size (patch);
+  write_header (output, BROADWAY_OP_UPLOAD_TEXTURE_DELTA);
+  append_uint32 (output, id);
+  append_uint32 (output, base_id);
+  append_uint32 (output, x);
+  append_uint32 (output, y);
+  append_uint32 (output, (guint32)len);
+  g_string_append_len (output->buf, g_bytes_get_data (patch, NULL), len);
+}
+
+void
+broadway_output_frame (BroadwayOutput *output,
+                       guint32 id)
+{
+  write_header (output, BROADWAY_OP_FRAME);
+  append_uint32 (output, id);
+}
+
 void
 broadway_output_release_texture (BroadwayOutput *output,
                                  guint32 id)
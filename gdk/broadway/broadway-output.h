@@ -25,6 +25,9 @@ int             broadway_output_has_error           (BroadwayOutput *output);
 void            broadway_output_set_next_serial     (BroadwayOutput *output,
                                                      guint32         serial);
 guint32         broadway_output_get_next_serial     (BroadwayOutput *output);
+void            broadway_output_add_observer        (BroadwayOutput *output,
+                                                     GIOStream      *connection);
+guint           broadway_output_get_n_observers     (BroadwayOutput *output);
 void            broadway_output_new_surface         (BroadwayOutput *output,
                                                      int             id,
                                                      int             x,
@@ -64,6 +67,14 @@ void            broadway_output_surface_set_nodes   (BroadwayOutput *output,
 void            broadway_output_upload_texture      (BroadwayOutput *output,
                                                      guint32         id,
                                                      GBytes         *texture);
+void            broadway_output_upload_texture_delta (BroadwayOutput *output,
+                                                     guint32         id,
+                                                     guint32         base_id,
+                                                     guint32         x,
+                                                     guint32         y,
+                                                     GBytes         *patch);
+void            broadway_output_frame               (BroadwayOutput *output,
+                                                     guint32         id);
 void            broadway_output_release_texture     (BroadwayOutput *output,
                                                      guint32         id);
 void            broadway_output_grab_pointer        (BroadwayOutput *output,
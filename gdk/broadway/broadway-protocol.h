@@ -66,6 +66,7 @@ typedef enum {
   BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 12,
   BROADWAY_EVENT_FOCUS = 13,
   BROADWAY_EVENT_ROUNDTRIP_NOTIFY = 14,
+  BROADWAY_EVENT_FRAME_ACK = 15,
 } BroadwayEventType;
 
 typedef enum {
@@ -86,6 +87,8 @@ typedef enum {
   BROADWAY_OP_RELEASE_TEXTURE = 14,
   BROADWAY_OP_SET_NODES = 15,
   BROADWAY_OP_ROUNDTRIP = 16,
+  BROADWAY_OP_UPLOAD_TEXTURE_DELTA = 17,
+  BROADWAY_OP_FRAME = 18,
 } BroadwayOpType;
 
 typedef struct {
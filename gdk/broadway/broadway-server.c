@@ -6,6 +6,7 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <cairo.h>
 #include "gdktypes.h"
 #include "gdkinternals.h"
 #include <stdlib.h>
@@ -41,6 +42,17 @@ typedef struct {
   guint32 tag;
 } BroadwayOutstandingRoundtrip;
 
+typedef struct {
+  guint32 id;
+  gint64 sent_time;
+} BroadwayOutstandingFrame;
+
+/* If the client hasn't shown this many frames yet, new node trees
+ * are not sent right away. Instead only the latest tree of each
+ * surface is sent once the client catches up.
+ */
+#define MAX_FRAMES_IN_FLIGHT 2
+
 typedef struct BroadwayInput BroadwayInput;
 typedef struct BroadwaySurface BroadwaySurface;
 struct _BroadwayServer {
@@ -67,6 +79,9 @@ struct _BroadwayServer {
 
   guint32 next_texture_id;
   GHashTable *textures;
+  GHashTable *texture_contents; /* GBytes => BroadwayTexture */
+  GQueue texture_cache;         /* Unused textures the client still has, oldest first */
+  gsize texture_cache_size;
 
   guint32 screen_scale;
 
@@ -88,6 +103,14 @@ struct _BroadwayServer {
   int future_mouse_in_surface;
 
   GList *outstanding_roundtrips;
+
+  /* Frame throttling */
+  guint32 next_frame_id;
+  gboolean frame_pending;       /* Nodes were sent since the last frame */
+  GQueue outstanding_frames;    /* BroadwayOutstandingFrame, oldest first */
+  guint n_deferred_surfaces;
+  gint64 frame_latency;         /* Smoothed, in microseconds */
+  guint64 n_coalesced_frames;
 };
 
 struct _BroadwayServerClass
@@ -124,21 +147,51 @@ struct BroadwaySurface {
   gboolean visible;
   gint32 transient_for;
   guint32 texture;
-  BroadwayNode *nodes;
+  BroadwayNode *nodes;          /* What the client has */
   GHashTable *node_lookup;
+  BroadwayNode *deferred_nodes; /* Not sent yet due to throttling */
+  GHashTable *deferred_node_lookup;
 };
 
+/* Textures are only sent to the client once a node uses them, so
+ * that a texture replacing another one in the same place can be sent
+ * as a delta against it.
+ *
+ * When the last reference to a texture that the client has is dropped,
+ * we don't tell the client right away. Instead the texture moves to an
+ * LRU cache, so that identical contents uploaded again, like images
+ * scrolling back into view, can reuse it without sending any data.
+ */
+#define TEXTURE_CACHE_SIZE (64 * 1024 * 1024)
+
+/* Deltas bigger than this fraction of the texture are not worth it */
+#define TEXTURE_DELTA_MAX_FRACTION 2
+
 struct _BroadwayTexture {
   grefcount refcount;
   guint32 id;
   GBytes *bytes;
+  int width;
+  int height;
+  gboolean sent;              /* The client has the texture */
+  gboolean cached;            /* Unused, in server->texture_cache */
+  GList cache_link;
+  cairo_surface_t *surface;   /* Decoded pixels, only while used for deltas */
 };
 
 static void broadway_server_resync_surfaces (BroadwayServer *server);
 static void send_outstanding_roundtrips (BroadwayServer *server);
+static void broadway_server_frame_acked (BroadwayServer *server,
+                                         guint32         id);
+static void broadway_server_reset_frames (BroadwayServer *server);
+static void broadway_server_add_observer (BroadwayServer *server,
+                                          GIOStream      *connection);
 
 static void broadway_server_ref_texture (BroadwayServer   *server,
                                          guint32           id);
+static void broadway_server_send_textures (BroadwayServer *server,
+                                           BroadwayNode   *node,
+                                           BroadwayNode   *old_root);
 
 static GType broadway_server_get_type (void);
 
@@ -147,6 +200,7 @@ G_DEFINE_TYPE (BroadwayServer, broadway_server, G_TYPE_OBJECT)
 static void
 broadway_texture_free (BroadwayTexture *texture)
 {
+  g_clear_pointer (&texture->surface, cairo_surface_destroy);
   g_bytes_unref (texture->bytes);
   g_free (texture);
 }
@@ -264,6 +318,9 @@ broadway_server_init (BroadwayServer *server)
   server->id_counter = 0;
   server->textures = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
                                             (GDestroyNotify)broadway_texture_free);
+  server->texture_contents = g_hash_table_new (g_bytes_hash, g_bytes_equal);
+  g_queue_init (&server->texture_cache);
+  g_queue_init (&server->outstanding_frames);
 
   root = g_new0 (BroadwaySurface, 1);
   root->id = server->id_counter++;
@@ -287,6 +344,8 @@ broadway_server_finalize (GObject *object)
   g_free (server->address);
   g_free (server->ssl_cert);
   g_free (server->ssl_key);
+  g_queue_clear_full (&server->outstanding_frames, g_free);
+  g_hash_table_destroy (server->texture_contents);
   g_hash_table_destroy (server->textures);
 
   G_OBJECT_CLASS (broadway_server_parent_class)->finalize (object);
@@ -306,7 +365,13 @@ broadway_surface_free (BroadwayServer *server,
 {
   if (surface->nodes)
     broadway_node_unref (server, surface->nodes);
+  if (surface->deferred_nodes)
+    {
+      broadway_node_unref (server, surface->deferred_nodes);
+      server->n_deferred_surfaces--;
+    }
   g_hash_table_unref (surface->node_lookup);
+  g_hash_table_unref (surface->deferred_node_lookup);
   g_free (surface);
 }
 
@@ -720,6 +785,11 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
 
     break;
 
+  case BROADWAY_EVENT_FRAME_ACK:
+    /* Only used for throttling, clients never see these */
+    broadway_server_frame_acked (server, ntohl (*p++));
+    return;
+
   case BROADWAY_EVENT_SCREEN_SIZE_CHANGED:
     msg.screen_resize_notify.width = ntohl (*p++);
     msg.screen_resize_notify.height = ntohl (*p++);
@@ -986,9 +1056,29 @@ broadway_server_fake_roundtrip_reply (BroadwayServer *server,
   queue_process_input_at_idle (server);
 }
 
+static void
+broadway_server_end_frame (BroadwayServer *server)
+{
+  BroadwayOutstandingFrame *frame;
+
+  if (!server->frame_pending)
+    return;
+
+  frame = g_new (BroadwayOutstandingFrame, 1);
+  frame->id = ++server->next_frame_id;
+  frame->sent_time = g_get_monotonic_time ();
+  g_queue_push_tail (&server->outstanding_frames, frame);
+
+  broadway_output_frame (server->output, frame->id);
+  server->frame_pending = FALSE;
+}
+
 void
 broadway_server_flush (BroadwayServer *server)
 {
+  if (server->output)
+    broadway_server_end_frame (server);
+
   if (server->output &&
       !broadway_output_flush (server->output))
     {
@@ -996,7 +1086,115 @@ broadway_server_flush (BroadwayServer *server)
       broadway_output_free (server->output);
       server->output = NULL;
       send_outstanding_roundtrips (server);
+      broadway_server_reset_frames (server);
+    }
+}
+
+static void
+broadway_server_send_nodes (BroadwayServer  *server,
+                            BroadwaySurface *surface,
+                            BroadwayNode    *root,
+                            gboolean         send)
+{
+  if (send && server->output != NULL)
+    {
+      broadway_server_send_textures (server, root, surface->nodes);
+      broadway_output_surface_set_nodes (server->output, surface->id,
+                                         root,
+                                         surface->nodes,
+                                         surface->node_lookup);
+      server->frame_pending = TRUE;
+    }
+
+  if (surface->nodes)
+    broadway_node_unref (server, surface->nodes);
+
+  surface->nodes = root;
+
+  g_hash_table_remove_all (surface->node_lookup);
+  broadway_node_add_to_lookup (root, surface->node_lookup);
+}
+
+/* Makes the deferred nodes of @surface current, sending them
+ * to the client if @send is %TRUE.
+ */
+static void
+broadway_server_send_deferred_nodes (BroadwayServer  *server,
+                                     BroadwaySurface *surface,
+                                     gboolean         send)
+{
+  BroadwayNode *root = surface->deferred_nodes;
+
+  if (root == NULL)
+    return;
+
+  surface->deferred_nodes = NULL;
+  g_hash_table_remove_all (surface->deferred_node_lookup);
+  server->n_deferred_surfaces--;
+
+  broadway_server_send_nodes (server, surface, root, send);
+}
+
+static void
+broadway_server_frame_acked (BroadwayServer *server,
+                             guint32         id)
+{
+  BroadwayOutstandingFrame *frame;
+  gint64 latency = -1;
+  GList *l;
+
+  /* Frames are shown in order, so this acks all earlier ones too */
+  while ((frame = g_queue_peek_head (&server->outstanding_frames)) != NULL &&
+         (gint32) (id - frame->id) >= 0)
+    {
+      latency = g_get_monotonic_time () - frame->sent_time;
+      g_free (g_queue_pop_head (&server->outstanding_frames));
     }
+
+  if (latency < 0)
+    return;
+
+  if (server->frame_latency == 0)
+    server->frame_latency = latency;
+  else
+    server->frame_latency = (server->frame_latency * 7 + latency) / 8;
+
+  g_debug ("Frame %u shown after %" G_GINT64_FORMAT " ms (average %" G_GINT64_FORMAT " ms, %" G_GUINT64_FORMAT " coalesced)",
+           id, latency / 1000, server->frame_latency / 1000, server->n_coalesced_frames);
+
+  if (server->n_deferred_surfaces == 0)
+    return;
+
+  for (l = server->surfaces; l != NULL; l = l->next)
+    broadway_server_send_deferred_nodes (server, l->data, TRUE);
+
+  broadway_server_flush (server);
+}
+
+static void
+broadway_server_reset_frames (BroadwayServer *server)
+{
+  GList *l;
+
+  g_queue_clear_full (&server->outstanding_frames, g_free);
+  server->frame_pending = FALSE;
+
+  /* Whoever connects next gets the full trees */
+  for (l = server->surfaces; l != NULL; l = l->next)
+    broadway_server_send_deferred_nodes (server, l->data, FALSE);
+}
+
+/**
+ * broadway_server_get_frame_latency:
+ * @server: a #BroadwayServer
+ *
+ * Returns the smoothed time between sending a frame and the client
+ * showing it, in microseconds, or 0 if no frame was shown yet.
+ */
+gint64
+broadway_server_get_frame_latency (BroadwayServer *server)
+{
+  return server->frame_latency;
 }
 
 void
@@ -1083,7 +1281,8 @@ generate_handshake_response_wsietf_v7 (const char *key)
 }
 
 static void
-start_input (HttpRequest *request)
+start_input (HttpRequest *request,
+             gboolean     observe)
 {
   char **lines;
   const char *p;
@@ -1125,6 +1324,14 @@ start_input (HttpRequest *request)
       return;
     }
 
+  /* There is only something to observe while a client is connected */
+  if (observe && request->server->output == NULL)
+    {
+      g_strfreev (lines);
+      send_error (request, 503, "No client to observe");
+      return;
+    }
+
   if (key != NULL)
     {
       char* accept = generate_handshake_response_wsietf_v7 (key);
@@ -1159,6 +1366,19 @@ start_input (HttpRequest *request)
   setsockopt (g_socket_get_fd (socket), IPPROTO_TCP,
               TCP_NODELAY, (char *) &flag, sizeof(int));
 
+  if (observe)
+    {
+      BroadwayServer *server = request->server;
+      GIOStream *connection = g_object_ref (request->connection);
+
+      /* Observers don't send input, nothing is read from them */
+      http_request_free (request);
+      broadway_server_add_observer (server, connection);
+      g_object_unref (connection);
+      g_strfreev (lines);
+      return;
+    }
+
   input = g_new0 (BroadwayInput, 1);
   input->server = request->server;
   input->connection = g_object_ref (request->connection);
@@ -1311,7 +1531,9 @@ got_request (HttpRequest *request)
   else if (strcmp (escaped, "/broadway.js") == 0)
     send_data (request, "text/javascript", broadway_js, G_N_ELEMENTS(broadway_js) - 1);
   else if (strcmp (escaped, "/socket") == 0)
-    start_input (request);
+    start_input (request, FALSE);
+  else if (strcmp (escaped, "/observe") == 0)
+    start_input (request, TRUE);
   else
     send_error (request, 404, "File not found");
 
@@ -1736,7 +1958,7 @@ rotl (guint32 value, int shift)
 
 static BroadwayNode *
 decode_nodes (BroadwayServer *server,
-              BroadwaySurface *surface,
+              GHashTable *node_lookup,
               int len,
               guint32 data[],
               GHashTable  *client_texture_map,
@@ -1760,7 +1982,7 @@ decode_nodes (BroadwayServer *server,
   id = data[(*pos)++];
   switch (type) {
   case BROADWAY_NODE_REUSE:
-    node = g_hash_table_lookup (surface->node_lookup, GINT_TO_POINTER(id));
+    node = g_hash_table_lookup (node_lookup, GINT_TO_POINTER(id));
     g_assert (node != NULL);
     return broadway_node_ref (node);
     break;
@@ -1847,7 +2069,7 @@ decode_nodes (BroadwayServer *server,
     }
 
   for (i = 0; i < n_children; i++)
-    node->children[i] = decode_nodes (server, surface, len, data, client_texture_map, pos);
+    node->children[i] = decode_nodes (server, node_lookup, len, data, client_texture_map, pos);
 
   hash = node->type << 16;
 
@@ -1878,21 +2100,327 @@ broadway_server_surface_update_nodes (BroadwayServer   *server,
   if (surface == NULL)
     return;
 
-  root = decode_nodes (server, surface, len, data, client_texture_map, &pos);
+  /* The client reuses nodes from the last tree it sent us */
+  root = decode_nodes (server,
+                       surface->deferred_nodes ? surface->deferred_node_lookup : surface->node_lookup,
+                       len, data, client_texture_map, &pos);
 
-  if (server->output != NULL)
-    broadway_output_surface_set_nodes (server->output, surface->id,
-                                       root,
-                                       surface->nodes,
-                                       surface->node_lookup);
+  if (server->output == NULL ||
+      g_queue_get_length (&server->outstanding_frames) < MAX_FRAMES_IN_FLIGHT)
+    {
+      broadway_server_send_deferred_nodes (server, surface, TRUE);
+      broadway_server_send_nodes (server, surface, root, TRUE);
+      return;
+    }
 
-  if (surface->nodes)
-    broadway_node_unref (server, surface->nodes);
+  /* The client is behind, replace whatever is waiting with this tree */
+  if (surface->deferred_nodes)
+    {
+      broadway_node_unref (server, surface->deferred_nodes);
+      server->n_coalesced_frames++;
+    }
+  else
+    server->n_deferred_surfaces++;
 
-  surface->nodes = root;
+  surface->deferred_nodes = root;
 
-  g_hash_table_remove_all (surface->node_lookup);
-  broadway_node_add_to_lookup (root, surface->node_lookup);
+  g_hash_table_remove_all (surface->deferred_node_lookup);
+  broadway_node_add_to_lookup (root, surface->deferred_node_lookup);
+}
+
+static gsize
+broadway_texture_get_memory_size (BroadwayTexture *texture)
+{
+  return (gsize) texture->width * texture->height * 4;
+}
+
+static void
+broadway_texture_read_size (BroadwayTexture *texture)
+{
+  static const guchar png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  const guchar *data;
+  gsize size;
+
+  /* The IHDR chunk always comes first */
+  data = g_bytes_get_data (texture->bytes, &size);
+  if (size < 24 || memcmp (data, png_signature, 8) != 0)
+    return;
+
+  texture->width = (data[16] << 24) | (data[17] << 16) | (data[18] << 8) | data[19];
+  texture->height = (data[20] << 24) | (data[21] << 16) | (data[22] << 8) | data[23];
+}
+
+typedef struct {
+  const guchar *data;
+  gsize size;
+} PngReader;
+
+static cairo_status_t
+read_png_cb (void          *closure,
+             unsigned char *data,
+             unsigned int   length)
+{
+  PngReader *reader = closure;
+
+  if (reader->size < length)
+    return CAIRO_STATUS_READ_ERROR;
+
+  memcpy (data, reader->data, length);
+  reader->data += length;
+  reader->size -= length;
+
+  return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+write_png_cb (void                *closure,
+              const unsigned char *data,
+              unsigned int         length)
+{
+  g_byte_array_append (closure, data, length);
+
+  return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_surface_t *
+broadway_texture_get_surface (BroadwayTexture *texture)
+{
+  if (texture->surface == NULL)
+    {
+      PngReader reader;
+
+      reader.data = g_bytes_get_data (texture->bytes, &reader.size);
+      texture->surface = cairo_image_surface_create_from_png_stream (read_png_cb, &reader);
+    }
+
+  if (cairo_surface_status (texture->surface) != CAIRO_STATUS_SUCCESS)
+    return NULL;
+
+  return texture->surface;
+}
+
+/* Finds the bounding box of the pixels that differ between the two
+ * surfaces, returns FALSE if they can't be compared.
+ */
+static gboolean
+find_changed_area (cairo_surface_t       *surface,
+                   cairo_surface_t       *base,
+                   cairo_rectangle_int_t *area)
+{
+  int width, height, stride;
+  const guchar *data, *base_data;
+  int x0, y0, x1, y1;
+  int x, y;
+
+  if (cairo_image_surface_get_format (surface) != cairo_image_surface_get_format (base) ||
+      cairo_image_surface_get_width (surface) != cairo_image_surface_get_width (base) ||
+      cairo_image_surface_get_height (surface) != cairo_image_surface_get_height (base) ||
+      cairo_image_surface_get_stride (surface) != cairo_image_surface_get_stride (base))
+    return FALSE;
+
+  width = cairo_image_surface_get_width (surface);
+  height = cairo_image_surface_get_height (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  data = cairo_image_surface_get_data (surface);
+  base_data = cairo_image_surface_get_data (base);
+
+  x0 = width;
+  y0 = height;
+  x1 = y1 = 0;
+
+  for (y = 0; y < height; y++)
+    {
+      const guint32 *row = (const guint32 *) (data + y * stride);
+      const guint32 *base_row = (const guint32 *) (base_data + y * stride);
+
+      if (memcmp (row, base_row, width * 4) == 0)
+        continue;
+
+      y0 = MIN (y0, y);
+      y1 = y + 1;
+
+      for (x = 0; x < x0; x++)
+        if (row[x] != base_row[x])
+          {
+            x0 = x;
+            break;
+          }
+
+      for (x = width - 1; x >= x1; x--)
+        if (row[x] != base_row[x])
+          {
+            x1 = x + 1;
+            break;
+          }
+    }
+
+  if (y1 == 0)
+    {
+      area->x = area->y = area->width = area->height = 0;
+      return TRUE;
+    }
+
+  area->x = x0;
+  area->y = y0;
+  area->width = x1 - x0;
+  area->height = y1 - y0;
+
+  return TRUE;
+}
+
+static gboolean
+broadway_server_send_texture_delta (BroadwayServer  *server,
+                                    BroadwayTexture *texture,
+                                    BroadwayTexture *base)
+{
+  cairo_surface_t *surface, *base_surface, *patch;
+  cairo_rectangle_int_t area;
+  GByteArray *png;
+  GBytes *bytes;
+  int stride;
+
+  if (texture->width != base->width ||
+      texture->height != base->height ||
+      texture->width == 0 || texture->height == 0)
+    return FALSE;
+
+  surface = broadway_texture_get_surface (texture);
+  base_surface = broadway_texture_get_surface (base);
+  if (surface == NULL || base_surface == NULL)
+    return FALSE;
+
+  if (!find_changed_area (surface, base_surface, &area))
+    return FALSE;
+
+  if ((gsize) area.width * area.height * TEXTURE_DELTA_MAX_FRACTION >
+      (gsize) texture->width * texture->height)
+    return FALSE;
+
+  png = g_byte_array_new ();
+  if (area.width > 0)
+    {
+      stride = cairo_image_surface_get_stride (surface);
+      patch = cairo_image_surface_create_for_data (cairo_image_surface_get_data (surface) + area.y * stride + area.x * 4,
+                                                   cairo_image_surface_get_format (surface),
+                                                   area.width, area.height,
+                                                   stride);
+      cairo_surface_write_to_png_stream (patch, write_png_cb, png);
+      cairo_surface_destroy (patch);
+    }
+  bytes = g_byte_array_free_to_bytes (png);
+
+  broadway_output_upload_texture_delta (server->output, texture->id, base->id,
+                                        area.x, area.y, bytes);
+  g_bytes_unref (bytes);
+
+  /* The base is on its way out, but this texture may be the next base */
+  g_clear_pointer (&base->surface, cairo_surface_destroy);
+
+  return TRUE;
+}
+
+static BroadwayNode *
+find_texture_node_at (BroadwayNode *node,
+                      const guint32 rect[4])
+{
+  guint32 i;
+
+  if (node->type == BROADWAY_NODE_TEXTURE &&
+      memcmp (node->data, rect, 4 * sizeof (guint32)) == 0)
+    return node;
+
+  for (i = 0; i < node->n_children; i++)
+    {
+      BroadwayNode *found = find_texture_node_at (node->children[i], rect);
+      if (found)
+        return found;
+    }
+
+  return NULL;
+}
+
+/* Sends all textures used by @node that the client doesn't have yet.
+ * If a texture node in the same place in @old_root has a texture with
+ * the same size, only the changed area is sent.
+ */
+static void
+broadway_server_send_textures (BroadwayServer *server,
+                               BroadwayNode   *node,
+                               BroadwayNode   *old_root)
+{
+  guint32 i;
+
+  if (node->type == BROADWAY_NODE_TEXTURE)
+    {
+      BroadwayTexture *texture, *base = NULL;
+
+      texture = g_hash_table_lookup (server->textures, GINT_TO_POINTER (node->texture_id));
+      if (texture == NULL || texture->sent)
+        return;
+
+      if (old_root)
+        {
+          BroadwayNode *old_node = find_texture_node_at (old_root, node->data);
+          if (old_node)
+            base = g_hash_table_lookup (server->textures, GINT_TO_POINTER (old_node->texture_id));
+        }
+
+      if (base == NULL || !base->sent || base == texture ||
+          !broadway_server_send_texture_delta (server, texture, base))
+        broadway_output_upload_texture (server->output, texture->id, texture->bytes);
+
+      texture->sent = TRUE;
+      return;
+    }
+
+  for (i = 0; i < node->n_children; i++)
+    broadway_server_send_textures (server, node->children[i], old_root);
+}
+
+static void
+broadway_server_forget_texture (BroadwayServer  *server,
+                                BroadwayTexture *texture)
+{
+  guint32 id = texture->id;
+
+  if (texture->sent && server->output)
+    broadway_output_release_texture (server->output, id);
+
+  g_hash_table_remove (server->texture_contents, texture->bytes);
+  g_hash_table_remove (server->textures, GINT_TO_POINTER (id));
+}
+
+static void
+broadway_server_trim_texture_cache (BroadwayServer *server,
+                                    gsize           max_size)
+{
+  while (server->texture_cache_size > max_size)
+    {
+      GList *link = g_queue_pop_head_link (&server->texture_cache);
+      BroadwayTexture *texture = link->data;
+
+      server->texture_cache_size -= broadway_texture_get_memory_size (texture);
+      texture->cached = FALSE;
+      broadway_server_forget_texture (server, texture);
+    }
+}
+
+/* Called when a new client connects, it doesn't have any textures */
+static void
+broadway_server_reset_textures (BroadwayServer *server)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, server->textures);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      BroadwayTexture *texture = value;
+
+      texture->sent = FALSE;
+    }
+
+  broadway_server_trim_texture_cache (server, 0);
 }
 
 guint32
@@ -1901,17 +2429,33 @@ broadway_server_upload_texture (BroadwayServer   *server,
 {
   BroadwayTexture *texture;
 
+  texture = g_hash_table_lookup (server->texture_contents, bytes);
+  if (texture)
+    {
+      if (texture->cached)
+        {
+          g_queue_unlink (&server->texture_cache, &texture->cache_link);
+          server->texture_cache_size -= broadway_texture_get_memory_size (texture);
+          texture->cached = FALSE;
+          g_ref_count_init (&texture->refcount);
+        }
+      else
+        g_ref_count_inc (&texture->refcount);
+
+      return texture->id;
+    }
+
   texture = g_new0 (BroadwayTexture, 1);
   g_ref_count_init (&texture->refcount);
   texture->id = ++server->next_texture_id;
   texture->bytes = g_bytes_ref (bytes);
+  texture->cache_link.data = texture;
+  broadway_texture_read_size (texture);
 
   g_hash_table_replace (server->textures,
                         GINT_TO_POINTER (texture->id),
                         texture);
-
-  if (server->output)
-    broadway_output_upload_texture (server->output, texture->id, texture->bytes);
+  g_hash_table_insert (server->texture_contents, texture->bytes, texture);
 
   return texture->id;
 }
@@ -1937,10 +2481,17 @@ broadway_server_release_texture (BroadwayServer   *server,
 
   if (texture && g_ref_count_dec (&texture->refcount))
     {
-      g_hash_table_remove (server->textures, GINT_TO_POINTER (id));
+      if (!texture->sent || server->output == NULL)
+        {
+          broadway_server_forget_texture (server, texture);
+          return;
+        }
 
-      if (server->output)
-        broadway_output_release_texture (server->output, id);
+      g_clear_pointer (&texture->surface, cairo_surface_destroy);
+      texture->cached = TRUE;
+      g_queue_push_tail_link (&server->texture_cache, &texture->cache_link);
+      server->texture_cache_size += broadway_texture_get_memory_size (texture);
+      broadway_server_trim_texture_cache (server, TEXTURE_CACHE_SIZE);
     }
 }
 
@@ -2086,6 +2637,7 @@ broadway_server_new_surface (BroadwayServer *server,
   surface->width = width;
   surface->height = height;
   surface->node_lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
+  surface->deferred_node_lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   g_hash_table_insert (server->surface_id_hash,
                        GINT_TO_POINTER (surface->id),
@@ -2106,27 +2658,18 @@ broadway_server_new_surface (BroadwayServer *server,
   return surface->id;
 }
 
+/* Writes everything a client needs to show the current state.
+ * Textures that the clients have are uploaded again, so a client
+ * that just joined has the same ones as everybody else.
+ */
 static void
-broadway_server_resync_surfaces (BroadwayServer *server)
+broadway_server_send_state (BroadwayServer *server)
 {
   GHashTableIter iter;
-  gpointer key, value;
+  gpointer value;
   GList *l;
 
-  if (server->output == NULL)
-    return;
-
-  /* First upload all textures */
-  g_hash_table_iter_init (&iter, server->textures);
-  while (g_hash_table_iter_next (&iter, &key, &value))
-    {
-      BroadwayTexture *texture = value;
-      broadway_output_upload_texture (server->output,
-                                      GPOINTER_TO_INT (key),
-                                      texture->bytes);
-    }
-
-  /* Then create all surfaces */
+  /* First create all surfaces */
   for (l = server->surfaces; l != NULL; l = l->next)
     {
       BroadwaySurface *surface = l->data;
@@ -2142,6 +2685,15 @@ broadway_server_resync_surfaces (BroadwayServer *server)
                                    surface->height);
     }
 
+  g_hash_table_iter_init (&iter, server->textures);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      BroadwayTexture *texture = value;
+
+      if (texture->sent)
+        broadway_output_upload_texture (server->output, texture->id, texture->bytes);
+    }
+
   /* Then do everything that may reference other surfaces */
   for (l = server->surfaces; l != NULL; l = l->next)
     {
@@ -2155,9 +2707,13 @@ broadway_server_resync_surfaces (BroadwayServer *server)
                                            surface->transient_for);
 
       if (surface->nodes)
-        broadway_output_surface_set_nodes (server->output, surface->id,
-                                           surface->nodes,
-                                           NULL, NULL);
+        {
+          broadway_server_send_textures (server, surface->nodes, NULL);
+          broadway_output_surface_set_nodes (server->output, surface->id,
+                                             surface->nodes,
+                                             NULL, NULL);
+          server->frame_pending = TRUE;
+        }
 
       if (surface->visible)
         broadway_output_show_surface (server->output, surface->id);
@@ -2165,6 +2721,41 @@ broadway_server_resync_surfaces (BroadwayServer *server)
 
   if (server->show_keyboard)
     broadway_output_set_show_keyboard (server->output, TRUE);
+}
 
+static void
+broadway_server_resync_surfaces (BroadwayServer *server)
+{
+  if (server->output == NULL)
+    return;
+
+  /* Textures get uploaded again as the nodes need them */
+  broadway_server_reset_textures (server);
+  broadway_server_reset_frames (server);
+
+  broadway_server_send_state (server);
+
+  broadway_server_flush (server);
+}
+
+/* Observers are read-only clients that see what the client that
+ * owns the output sees. Everything sent is encoded once for all of
+ * them, an observer joining only costs sending it the current state.
+ */
+static void
+broadway_server_add_observer (BroadwayServer *server,
+                              GIOStream      *connection)
+{
   broadway_server_flush (server);
+  if (server->output == NULL)
+    {
+      g_io_stream_close (connection, NULL, NULL);
+      return;
+    }
+
+  broadway_server_send_state (server);
+  broadway_output_add_observer (server->output, connection);
+
+  g_debug ("Broadway observer joined, %u watching",
+           broadway_output_get_n_observers (server->output));
 }
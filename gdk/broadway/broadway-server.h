@@ -68,6 +68,7 @@ void                broadway_server_get_screen_size           (BroadwayServer  *
                                                                guint32         *scale);
 guint32             broadway_server_get_next_serial           (BroadwayServer  *server);
 guint32             broadway_server_get_last_seen_time        (BroadwayServer  *server);
+gint64              broadway_server_get_frame_latency         (BroadwayServer  *server);
 gboolean            broadway_server_lookahead_event           (BroadwayServer  *server,
                                                                const char      *types);
 void                broadway_server_query_mouse               (BroadwayServer  *server,
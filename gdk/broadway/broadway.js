@@ -38,6 +38,8 @@ const BROADWAY_OP_UPLOAD_TEXTURE = 13;
 const BROADWAY_OP_RELEASE_TEXTURE = 14;
 const BROADWAY_OP_SET_NODES = 15;
 const BROADWAY_OP_ROUNDTRIP = 16;
+const BROADWAY_OP_UPLOAD_TEXTURE_DELTA = 17;
+const BROADWAY_OP_FRAME = 18;
 
 const BROADWAY_EVENT_ENTER = 0;
 const BROADWAY_EVENT_LEAVE = 1;
@@ -54,6 +56,7 @@ const BROADWAY_EVENT_CONFIGURE_NOTIFY = 11;
 const BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 12;
 const BROADWAY_EVENT_FOCUS = 13;
 const BROADWAY_EVENT_ROUNDTRIP_NOTIFY = 14;
+const BROADWAY_EVENT_FRAME_ACK = 15;
 
 const DISPLAY_OP_REPLACE_CHILD = 0;
 const DISPLAY_OP_APPEND_CHILD = 1;
@@ -68,6 +71,7 @@ const DISPLAY_OP_RESTACK_SURFACES = 9;
 const DISPLAY_OP_DELETE_SURFACE = 10;
 const DISPLAY_OP_CHANGE_TEXTURE = 11;
 const DISPLAY_OP_CHANGE_TRANSFORM = 12;
+const DISPLAY_OP_FRAME_ACK = 13;
 
 // GdkCrossingMode
 const GDK_CROSSING_NORMAL = 0;
@@ -270,7 +274,64 @@ function Texture(id, data) {
     image.src = this.url;
     this.image = image;
     this.decoded = image.decode();
+    if (id != null)
+        textures[id] = this;
+}
+
+// A texture made by drawing a png patch over another texture. The url
+// is only available once it has been decoded.
+function TextureFromDelta(id, base, x, y, data) {
+    this.url = null;
+    this.refcount = 1;
+    this.id = id;
     textures[id] = this;
+
+    base.ref();
+    var patch = null;
+    if (data.length > 0)
+        patch = new Texture(null, data);
+
+    var texture = this;
+    var decodes = [base.decoded];
+    if (patch)
+        decodes.push(patch.decoded);
+    this.decoded = Promise.all(decodes).then(function() {
+        var canvas = document.createElement("canvas");
+        canvas.width = base.image.naturalWidth;
+        canvas.height = base.image.naturalHeight;
+        var context = canvas.getContext("2d");
+        context.drawImage(base.image, 0, 0);
+        if (patch) {
+            context.clearRect(x, y, patch.image.naturalWidth, patch.image.naturalHeight);
+            context.drawImage(patch.image, x, y);
+            patch.unref();
+        }
+        base.unref();
+
+        if (useDataUrls)
+            return canvas.toDataURL("image/png");
+        return new Promise(function(resolve) {
+            canvas.toBlob(function(blob) { resolve(window.URL.createObjectURL(blob)); }, "image/png");
+        });
+    }).then(function(url) {
+        texture.url = url;
+        var image = new Image();
+        image.src = url;
+        texture.image = image;
+        return image.decode();
+    });
+}
+TextureFromDelta.prototype = Texture.prototype;
+
+Texture.prototype.setImageSource = function(image) {
+    var texture = this;
+    if (this.url) {
+        image.src = this.url;
+    } else {
+        this.decoded.then(function() { image.src = texture.url; });
+    }
+    // Unref blob url when loaded
+    image.onload = function() { texture.unref(); };
 }
 
 Texture.prototype.ref = function() {
@@ -281,10 +342,11 @@ Texture.prototype.ref = function() {
 Texture.prototype.unref = function() {
     this.refcount -= 1;
     if (this.refcount == 0) {
-        if (this.url.startsWith("blob")) {
+        if (this.url && this.url.startsWith("blob")) {
             window.URL.revokeObjectURL(this.url);
         }
-        delete textures[this.id];
+        if (this.id != null)
+            delete textures[this.id];
     }
 }
 
@@ -605,10 +667,7 @@ TransformNodes.prototype.insertNode = function(parent, previousSibling, is_tople
             image.height = rect.height;
             image.style["position"] = "absolute";
             set_rect_style(image, rect);
-            var texture = textures[texture_id].ref();
-            image.src = texture.url;
-            // Unref blob url when loaded
-            image.onload = function() { texture.unref(); };
+            textures[texture_id].ref().setImageSource(image);
             newNode = image;
         }
         break;
@@ -992,19 +1051,16 @@ function handleDisplayCommands(display_commands)
         case DISPLAY_OP_CHANGE_TEXTURE:
             var image = cmd[1];
             var texture = cmd[2];
-            // We need a new closure here to have a separate copy of "texture" for each iteration in the onload callback...
-            var block = function(t) {
-                image.src = t.url;
-                // Unref blob url when loaded
-                image.onload = function() { t.unref(); };
-            };
-            block(texture);
+            texture.setImageSource(image);
             break;
         case DISPLAY_OP_CHANGE_TRANSFORM:
             var div = cmd[1];
             var transform_string = cmd[2];
             div.style["transform"] = transform_string;
             break;
+        case DISPLAY_OP_FRAME_ACK:
+            sendInput(BROADWAY_EVENT_FRAME_ACK, [cmd[1]]);
+            break;
         default:
             alert("Unknown display op " + command);
         }
@@ -1095,6 +1151,11 @@ function handleCommands(cmd, display_commands, new_textures, modified_trees)
             cmdRoundtrip(id, tag);
             break;
 
+        case BROADWAY_OP_FRAME:
+            // Acked once everything before it is on screen
+            display_commands.push([DISPLAY_OP_FRAME_ACK, cmd.get_32()]);
+            break;
+
         case BROADWAY_OP_MOVE_RESIZE:
             id = cmd.get_16();
             var ops = cmd.get_flags();
@@ -1134,6 +1195,16 @@ function handleCommands(cmd, display_commands, new_textures, modified_trees)
             new_textures.push(texture);
             break;
 
+        case BROADWAY_OP_UPLOAD_TEXTURE_DELTA:
+            id = cmd.get_32();
+            var base_id = cmd.get_32();
+            var x = cmd.get_32();
+            var y = cmd.get_32();
+            var data = cmd.get_data();
+            var texture = new TextureFromDelta (id, textures[base_id], x, y, data);
+            new_textures.push(texture);
+            break;
+
         case BROADWAY_OP_RELEASE_TEXTURE:
             id = cmd.get_32();
             textures[id].unref();
@@ -3209,6 +3280,7 @@ function connect()
 {
     var url = window.location.toString();
     var query_string = url.split("?");
+    var observe = false;
     if (query_string.length > 1) {
         var params = query_string[1].split("&");
 
@@ -3216,16 +3288,20 @@ function connect()
             var pair = params[i].split("=");
             if (pair[0] == "debug" && pair[1] == "decoding")
                 debugDecoding = true;
+            if (pair[0] == "observe")
+                observe = true;
         }
     }
 
     var loc = window.location.toString().replace("http:", "ws:").replace("https:", "wss:");
-    loc = loc.substr(0, loc.lastIndexOf('/')) + "/socket";
+    loc = loc.substr(0, loc.lastIndexOf('/')) + (observe ? "/observe" : "/socket");
     ws = new WebSocket(loc, "broadway");
     ws.binaryType = "arraybuffer";
 
     ws.onopen = function() {
-        inputSocket = ws;
+        /* Observers only watch, they never send input */
+        if (!observe)
+            inputSocket = ws;
     };
     ws.onclose = function() {
         if (inputSocket != null)
@@ -33,6 +33,8 @@
 
 #include "gdk-private.h"
 
+#include "gdktelemetryprivate.h"
+
 #include "gdkconstructor.h"
 
 #ifndef HAVE_XCONVERTCASE
@@ -151,6 +153,7 @@ static const GdkDebugKey gdk_debug_keys[] = {
   { "vulkan-disable",  GDK_DEBUG_VULKAN_DISABLE, "Disable Vulkan support" },
   { "vulkan-validate", GDK_DEBUG_VULKAN_VALIDATE, "Load the Vulkan validation layer" },
   { "default-settings",GDK_DEBUG_DEFAULT_SETTINGS, "Force default values for xsettings" },
+  { "watchdog",        GDK_DEBUG_WATCHDOG, "Report main loop stalls with a backtrace" },
 };
 #endif
 
@@ -294,10 +297,15 @@ gdk_pre_parse (void)
 
   gdk_ensure_resources ();
 
+  gdk_telemetry_init ();
+
 #ifdef G_ENABLE_DEBUG
   _gdk_debug_flags = gdk_parse_debug_var ("GDK_DEBUG",
                                           gdk_debug_keys,
                                           G_N_ELEMENTS (gdk_debug_keys));
+
+  if (_gdk_debug_flags & GDK_DEBUG_WATCHDOG)
+    gdk_telemetry_start_watchdog ();
 #else
   if (g_getenv ("GDK_DEBUG"))
     g_warning ("GDK_DEBUG set but ignored because GTK isn't built with G_ENABLE_DEBUG");
@@ -0,0 +1,153 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * gdkallocstats.c: Allocation counters per subsystem
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkallocstatsprivate.h"
+
+#include "gdkprofilerprivate.h"
+
+#include <string.h>
+
+/* Counting is compiled out entirely unless HAVE_ALLOC_STATS is set,
+ * in which case every counted allocation costs two atomic adds.
+ * Render nodes may be created and freed on other threads, so all
+ * counters are updated atomically.
+ */
+
+static const char *names[] = {
+  [GDK_ALLOC_CSS_VALUE] = "CSS values",
+  [GDK_ALLOC_RENDER_NODE] = "Render nodes",
+  [GDK_ALLOC_SIZE_REQUEST] = "Size request cache",
+  [GDK_ALLOC_RB_TREE] = "RB tree nodes",
+};
+
+G_STATIC_ASSERT (G_N_ELEMENTS (names) == GDK_ALLOC_N_SUBSYSTEMS);
+
+const char *
+gdk_alloc_stats_get_name (GdkAllocSubsystem subsystem)
+{
+  return names[subsystem];
+}
+
+#ifdef HAVE_ALLOC_STATS
+
+static GdkAllocStats stats[GDK_ALLOC_N_SUBSYSTEMS];
+
+void
+(gdk_alloc_stats_add) (GdkAllocSubsystem subsystem,
+                       gsize             size)
+{
+  g_atomic_pointer_add (&stats[subsystem].allocations, 1);
+  g_atomic_pointer_add (&stats[subsystem].allocated_bytes, size);
+  g_atomic_pointer_add (&stats[subsystem].live, 1);
+  g_atomic_pointer_add (&stats[subsystem].live_bytes, size);
+}
+
+/*< private >
+ * gdk_alloc_stats_remove:
+ * @subsystem: the subsystem
+ * @size: the size of the freed memory, or -1 if it is not known
+ *
+ * Counts memory being freed. When the size is not known, the average
+ * size of the allocations in @subsystem is used instead.
+ */
+void
+(gdk_alloc_stats_remove) (GdkAllocSubsystem subsystem,
+                          gssize            size)
+{
+  if (size < 0)
+    {
+      gssize allocations = (gssize) g_atomic_pointer_get (&stats[subsystem].allocations);
+
+      size = (gssize) g_atomic_pointer_get (&stats[subsystem].allocated_bytes) / MAX (allocations, 1);
+    }
+
+  g_atomic_pointer_add (&stats[subsystem].live, -1);
+  g_atomic_pointer_add (&stats[subsystem].live_bytes, -size);
+}
+
+/*< private >
+ * gdk_alloc_stats_get:
+ * @subsystem: the subsystem
+ * @stats: (out): return location for the counters
+ *
+ * Gets the allocation counters of @subsystem.
+ *
+ * Returns: %FALSE if GTK was built without allocation counting
+ */
+gboolean
+gdk_alloc_stats_get (GdkAllocSubsystem  subsystem,
+                     GdkAllocStats     *result)
+{
+  result->allocations = (gssize) g_atomic_pointer_get (&stats[subsystem].allocations);
+  result->allocated_bytes = (gssize) g_atomic_pointer_get (&stats[subsystem].allocated_bytes);
+  result->live = (gssize) g_atomic_pointer_get (&stats[subsystem].live);
+  result->live_bytes = (gssize) g_atomic_pointer_get (&stats[subsystem].live_bytes);
+
+  return TRUE;
+}
+
+void
+(gdk_alloc_stats_update_profiler) (void)
+{
+  static guint live_counters[GDK_ALLOC_N_SUBSYSTEMS];
+  static guint bytes_counters[GDK_ALLOC_N_SUBSYSTEMS];
+  static gboolean defined;
+  int i;
+
+  if (!GDK_PROFILER_IS_RUNNING)
+    return;
+
+  if (!defined)
+    {
+      for (i = 0; i < GDK_ALLOC_N_SUBSYSTEMS; i++)
+        {
+          char *name;
+
+          name = g_strdup_printf ("%s live", names[i]);
+          live_counters[i] = gdk_profiler_define_int_counter (name, "Number of live allocations");
+          g_free (name);
+
+          name = g_strdup_printf ("%s bytes", names[i]);
+          bytes_counters[i] = gdk_profiler_define_int_counter (name, "Bytes in live allocations");
+          g_free (name);
+        }
+
+      defined = TRUE;
+    }
+
+  for (i = 0; i < GDK_ALLOC_N_SUBSYSTEMS; i++)
+    {
+      gdk_profiler_set_int_counter (live_counters[i], (gssize) g_atomic_pointer_get (&stats[i].live));
+      gdk_profiler_set_int_counter (bytes_counters[i], (gssize) g_atomic_pointer_get (&stats[i].live_bytes));
+    }
+}
+
+#else
+
+gboolean
+gdk_alloc_stats_get (GdkAllocSubsystem  subsystem,
+                     GdkAllocStats     *result)
+{
+  memset (result, 0, sizeof (GdkAllocStats));
+
+  return FALSE;
+}
+
+#endif
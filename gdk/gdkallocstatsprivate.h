@@ -0,0 +1,62 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_ALLOC_STATS_PRIVATE_H__
+#define __GDK_ALLOC_STATS_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Subsystems whose allocations are counted when GTK is built
+ * with -Dalloc-stats=true. These are allocated in large numbers
+ * and are not GObjects, so they don't show up in the instance
+ * counts of GObject.
+ */
+typedef enum {
+  GDK_ALLOC_CSS_VALUE,
+  GDK_ALLOC_RENDER_NODE,
+  GDK_ALLOC_SIZE_REQUEST,
+  GDK_ALLOC_RB_TREE,
+  GDK_ALLOC_N_SUBSYSTEMS
+} GdkAllocSubsystem;
+
+typedef struct {
+  gssize allocations;     /* since startup */
+  gssize allocated_bytes; /* since startup */
+  gssize live;
+  gssize live_bytes;
+} GdkAllocStats;
+
+void         gdk_alloc_stats_add             (GdkAllocSubsystem  subsystem,
+                                              gsize              size);
+void         gdk_alloc_stats_remove          (GdkAllocSubsystem  subsystem,
+                                              gssize             size);
+
+gboolean     gdk_alloc_stats_get             (GdkAllocSubsystem  subsystem,
+                                              GdkAllocStats     *stats);
+const char * gdk_alloc_stats_get_name        (GdkAllocSubsystem  subsystem);
+void         gdk_alloc_stats_update_profiler (void);
+
+#ifndef HAVE_ALLOC_STATS
+#define gdk_alloc_stats_add(s, n)
+#define gdk_alloc_stats_remove(s, n)
+#define gdk_alloc_stats_update_profiler()
+#endif
+
+G_END_DECLS
+
+#endif /* __GDK_ALLOC_STATS_PRIVATE_H__ */
@@ -74,6 +74,10 @@ struct _GdkContentFormats
   gsize n_mime_types;
   GType *gtypes;
   gsize n_gtypes;
+
+  /* One bit per contained value, see signature_bit() */
+  guint64 mime_type_signature;
+  guint64 gtype_signature;
 };
 
 G_DEFINE_BOXED_TYPE (GdkContentFormats, gdk_content_formats,
@@ -112,6 +116,18 @@ gdk_intern_mime_type (const char *string)
   return string;
 }
 
+/* Formats are compared by pointer, since mime types are interned.
+ * Each value maps to one bit of a 64 bit signature, so a value can
+ * only be contained in formats that have its bit set, and formats
+ * can only match if their signatures have a bit in common. This
+ * rejects most lookups without looking at the arrays.
+ */
+static inline guint64
+signature_bit (gsize value)
+{
+  return G_GUINT64_CONSTANT (1) << ((value * G_GUINT64_CONSTANT (0x9E3779B97F4A7C15)) >> 58);
+}
+
 static GdkContentFormats *
 gdk_content_formats_new_take (GType *      gtypes,
                               gsize        n_gtypes,
@@ -119,6 +135,8 @@ gdk_content_formats_new_take (GType *      gtypes,
                               gsize        n_mime_types)
 {
   GdkContentFormats *result = g_slice_new0 (GdkContentFormats);
+  gsize i;
+
   result->ref_count = 1;
 
   result->gtypes = gtypes;
@@ -126,6 +144,11 @@ gdk_content_formats_new_take (GType *      gtypes,
   result->mime_types = mime_types;
   result->n_mime_types = n_mime_types;
 
+  for (i = 0; i < n_gtypes; i++)
+    result->gtype_signature |= signature_bit (gtypes[i]);
+  for (i = 0; i < n_mime_types; i++)
+    result->mime_type_signature |= signature_bit (GPOINTER_TO_SIZE (mime_types[i]));
+
   return result;
 }
 
@@ -318,6 +341,9 @@ gdk_content_formats_contain_interned_mime_type (const GdkContentFormats *formats
 {
   gsize i;
 
+  if ((formats->mime_type_signature & signature_bit (GPOINTER_TO_SIZE (mime_type))) == 0)
+    return FALSE;
+
   for (i = 0; i < formats->n_mime_types; i++)
     {
       if (mime_type == formats->mime_types[i])
@@ -367,6 +393,9 @@ gdk_content_formats_match_gtype (const GdkContentFormats *first,
   g_return_val_if_fail (first != NULL, FALSE);
   g_return_val_if_fail (second != NULL, FALSE);
 
+  if ((first->gtype_signature & second->gtype_signature) == 0)
+    return G_TYPE_INVALID;
+
   for (i = 0; i < first->n_gtypes; i++)
     {
       if (gdk_content_formats_contain_gtype (second, first->gtypes[i]))
@@ -396,6 +425,9 @@ gdk_content_formats_match_mime_type (const GdkContentFormats *first,
   g_return_val_if_fail (first != NULL, FALSE);
   g_return_val_if_fail (second != NULL, FALSE);
 
+  if ((first->mime_type_signature & second->mime_type_signature) == 0)
+    return NULL;
+
   for (i = 0; i < first->n_mime_types; i++)
     {
       if (gdk_content_formats_contain_interned_mime_type (second, first->mime_types[i]))
@@ -418,9 +450,12 @@ gboolean
 gdk_content_formats_contain_gtype (const GdkContentFormats *formats,
                                    GType                    type)
 {
+  gsize i;
+
   g_return_val_if_fail (formats != NULL, FALSE);
 
-  gsize i;
+  if ((formats->gtype_signature & signature_bit (type)) == 0)
+    return FALSE;
 
   for (i = 0; i < formats->n_gtypes; i++)
     {
@@ -587,14 +587,149 @@ gdk_content_serialize_finish (GAsyncResult  *result,
 
 /*** SERIALIZERS ***/
 
+/* Textures are immutable, so the last encoding of a texture is kept
+ * with it. Pasting the same image again, which is common, then only
+ * has to write out the data. Large encodings are not kept.
+ */
+#define MAX_CACHED_ENCODING_SIZE (16 * 1024 * 1024)
+
+typedef struct {
+  const char *name; /* interned */
+  GBytes *bytes;
+} CachedEncoding;
+
+static GQuark cached_encoding_quark;
+
+static void
+cached_encoding_free (gpointer data)
+{
+  CachedEncoding *cached = data;
+
+  g_bytes_unref (cached->bytes);
+  g_slice_free (CachedEncoding, cached);
+}
+
+typedef struct {
+  GdkPixbuf *pixbuf;
+  const char *name; /* interned */
+  GOutputStream *stream;
+  GByteArray *encoded; /* NULL if not cached */
+} PixbufEncoding;
+
+static void
+pixbuf_encoding_free (gpointer data)
+{
+  PixbufEncoding *encoding = data;
+
+  g_object_unref (encoding->pixbuf);
+  g_object_unref (encoding->stream);
+  if (encoding->encoded)
+    g_byte_array_unref (encoding->encoded);
+  g_slice_free (PixbufEncoding, encoding);
+}
+
+/* Runs in the encoding thread. The encoded data is written out in the
+ * chunks the encoder produces it in.
+ */
+static gboolean
+pixbuf_encoding_write (const char  *buf,
+                       gsize        count,
+                       GError     **error,
+                       gpointer     data)
+{
+  GTask *task = data;
+  PixbufEncoding *encoding = g_task_get_task_data (task);
+
+  if (!g_output_stream_write_all (encoding->stream,
+                                  buf, count,
+                                  NULL,
+                                  g_task_get_cancellable (task),
+                                  error))
+    return FALSE;
+
+  if (encoding->encoded)
+    {
+      if (encoding->encoded->len + count > MAX_CACHED_ENCODING_SIZE)
+        g_clear_pointer (&encoding->encoded, g_byte_array_unref);
+      else
+        g_byte_array_append (encoding->encoded, (const guint8 *) buf, count);
+    }
+
+  return TRUE;
+}
+
+static void
+pixbuf_encoding_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+  PixbufEncoding *encoding = task_data;
+  GError *error = NULL;
+  gboolean result;
+
+  if (g_str_equal (encoding->name, "png"))
+    result = gdk_pixbuf_save_to_callback (encoding->pixbuf,
+                                          pixbuf_encoding_write, task,
+                                          encoding->name,
+                                          &error,
+                                          "compression", "2",
+                                          NULL);
+  else
+    result = gdk_pixbuf_save_to_callback (encoding->pixbuf,
+                                          pixbuf_encoding_write, task,
+                                          encoding->name,
+                                          &error,
+                                          NULL);
+
+  if (result)
+    g_task_return_boolean (task, TRUE);
+  else
+    g_task_return_error (task, error);
+}
+
 static void
 pixbuf_serializer_finish (GObject      *source,
                           GAsyncResult *res,
                           gpointer      serializer)
 {
+  PixbufEncoding *encoding = g_task_get_task_data (G_TASK (res));
   GError *error = NULL;
 
-  if (!gdk_pixbuf_save_to_stream_finish (res, &error))
+  if (!g_task_propagate_boolean (G_TASK (res), &error))
+    {
+      gdk_content_serializer_return_error (serializer, error);
+      return;
+    }
+
+  if (encoding->encoded)
+    {
+      const GValue *value = gdk_content_serializer_get_value (serializer);
+      CachedEncoding *cached;
+
+      cached = g_slice_new (CachedEncoding);
+      cached->name = encoding->name;
+      cached->bytes = g_byte_array_free_to_bytes (encoding->encoded);
+      encoding->encoded = NULL;
+
+      g_object_set_qdata_full (g_value_get_object (value),
+                               cached_encoding_quark,
+                               cached,
+                               cached_encoding_free);
+    }
+
+  gdk_content_serializer_return_success (serializer);
+}
+
+static void
+cached_encoding_serializer_finish (GObject      *source,
+                                   GAsyncResult *result,
+                                   gpointer      serializer)
+{
+  GOutputStream *stream = G_OUTPUT_STREAM (source);
+  GError *error = NULL;
+
+  if (!g_output_stream_write_all_finish (stream, result, NULL, &error))
     gdk_content_serializer_return_error (serializer, error);
   else
     gdk_content_serializer_return_success (serializer);
@@ -604,10 +739,12 @@ static void
 pixbuf_serializer (GdkContentSerializer *serializer)
 {
   const GValue *value;
+  PixbufEncoding *encoding;
   GdkPixbuf *pixbuf;
   const char *name;
+  GTask *task;
   
-  name = gdk_content_serializer_get_user_data (serializer);
+  name = g_intern_string (gdk_content_serializer_get_user_data (serializer));
   value = gdk_content_serializer_get_value (serializer);
 
   if (G_VALUE_HOLDS (value, GDK_TYPE_PIXBUF))
@@ -617,7 +754,36 @@ pixbuf_serializer (GdkContentSerializer *serializer)
   else if (G_VALUE_HOLDS (value, GDK_TYPE_TEXTURE))
     {
       GdkTexture *texture = g_value_get_object (value);
-      cairo_surface_t *surface = gdk_texture_download_surface (texture);
+      CachedEncoding *cached;
+      cairo_surface_t *surface;
+
+      cached = g_object_get_qdata (G_OBJECT (texture), cached_encoding_quark);
+      if (cached && cached->name == name)
+        {
+          gsize size;
+          gconstpointer data;
+
+          /* The output stream keeps no reference to the data, so keep
+           * it alive with the serializer until the write is done.
+           */
+          data = g_bytes_get_data (cached->bytes, &size);
+          gdk_content_serializer_set_task_data (serializer,
+                                                g_bytes_ref (cached->bytes),
+                                                (GDestroyNotify) g_bytes_unref);
+          g_output_stream_write_all_async (gdk_content_serializer_get_output_stream (serializer),
+                                           data,
+                                           size,
+                                           gdk_content_serializer_get_priority (serializer),
+                                           gdk_content_serializer_get_cancellable (serializer),
+                                           cached_encoding_serializer_finish,
+                                           serializer);
+          return;
+        }
+
+      /* GL textures can only be downloaded here, the encoding happens
+       * in a thread.
+       */
+      surface = gdk_texture_download_surface (texture);
       pixbuf = gdk_pixbuf_get_from_surface (surface,
                                             0, 0,
                                             gdk_texture_get_width (texture), gdk_texture_get_height (texture));
@@ -628,15 +794,22 @@ pixbuf_serializer (GdkContentSerializer *serializer)
       g_assert_not_reached ();
     }
 
-  gdk_pixbuf_save_to_stream_async (pixbuf,
-                                   gdk_content_serializer_get_output_stream (serializer),
-                                   name,
-				   gdk_content_serializer_get_cancellable (serializer),
-                                   pixbuf_serializer_finish,
-                                   serializer,
-                                   g_str_equal (name, "png") ? "compression" : NULL, "2",
-                                   NULL);
-  g_object_unref (pixbuf);
+  encoding = g_slice_new0 (PixbufEncoding);
+  encoding->pixbuf = pixbuf;
+  encoding->name = name;
+  encoding->stream = g_object_ref (gdk_content_serializer_get_output_stream (serializer));
+  if (G_VALUE_HOLDS (value, GDK_TYPE_TEXTURE))
+    encoding->encoded = g_byte_array_new ();
+
+  task = g_task_new (NULL,
+                     gdk_content_serializer_get_cancellable (serializer),
+                     pixbuf_serializer_finish,
+                     serializer);
+  g_task_set_source_tag (task, pixbuf_serializer);
+  g_task_set_priority (task, gdk_content_serializer_get_priority (serializer));
+  g_task_set_task_data (task, encoding, pixbuf_encoding_free);
+  g_task_run_in_thread (task, pixbuf_encoding_thread);
+  g_object_unref (task);
 }
 
 static void
@@ -858,6 +1031,8 @@ init (void)
 
   initialized = TRUE;
 
+  cached_encoding_quark = g_quark_from_static_string ("gdk-content-serializer-cached-encoding");
+
   formats = gdk_pixbuf_get_formats ();
 
   /* Make sure png comes first */
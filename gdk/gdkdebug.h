@@ -43,7 +43,8 @@ typedef enum {
   GDK_DEBUG_GL_DEBUG        = 1 << 17,
   GDK_DEBUG_VULKAN_DISABLE  = 1 << 18,
   GDK_DEBUG_VULKAN_VALIDATE = 1 << 19,
-  GDK_DEBUG_DEFAULT_SETTINGS= 1 << 20
+  GDK_DEBUG_DEFAULT_SETTINGS= 1 << 20,
+  GDK_DEBUG_WATCHDOG        = 1 << 21
 } GdkDebugFlags;
 
 extern guint _gdk_debug_flags;
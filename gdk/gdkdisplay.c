@@ -34,6 +34,7 @@
 #include "gdkinternals.h"
 #include "gdkmonitorprivate.h"
 #include "gdkframeclockidleprivate.h"
+#include "gdkprofilerprivate.h"
 
 #include <math.h>
 #include <glib.h>
@@ -1134,6 +1135,125 @@ _gdk_display_unpause_events (GdkDisplay *display)
   display->event_pause_count--;
 }
 
+/* How long to hold back events if no frame comes along to flush them */
+#define EVENT_FRAME_TIMEOUT (G_USEC_PER_SEC / 60)
+
+static guint queue_depth_counter;
+static guint frame_events_counter;
+
+/*<private>
+ * _gdk_display_dispatch_events:
+ * @display: a #GdkDisplay
+ *
+ * Fetches all pending events from the windowing system in one go and
+ * emits what is ready of them, up to the per-frame limit. This is what
+ * the event sources of the backends do when dispatched.
+ */
+void
+_gdk_display_dispatch_events (GdkDisplay *display)
+{
+  GdkEvent *event;
+
+  g_return_if_fail (GDK_IS_DISPLAY (display));
+
+  if (queue_depth_counter == 0)
+    {
+      queue_depth_counter = gdk_profiler_define_int_counter ("event queue depth",
+                                                             "Events queued when dispatching");
+      frame_events_counter = gdk_profiler_define_int_counter ("frame events",
+                                                              "Events dispatched per frame");
+    }
+
+  if (display->event_pause_count == 0)
+    GDK_DISPLAY_GET_CLASS (display)->queue_events (display);
+
+  gdk_profiler_set_int_counter (queue_depth_counter,
+                                g_queue_get_length (&display->queued_events));
+
+  g_object_ref (display);
+
+  while (!_gdk_display_events_throttled (display, NULL) &&
+         (event = _gdk_event_unqueue (display)))
+    {
+      if (display->frame_event_count++ == 0)
+        display->frame_event_start = g_get_monotonic_time ();
+
+      _gdk_event_emit (event);
+      gdk_event_unref (event);
+    }
+
+  /* Make sure a frame comes along to flush the rest */
+  if (display->frame_event_count >= GDK_MAX_EVENTS_PER_FRAME)
+    {
+      GList *l;
+
+      for (l = g_queue_peek_head_link (&display->queued_events); l; l = l->next)
+        {
+          GdkSurface *surface = gdk_event_get_surface (l->data);
+          GdkFrameClock *clock;
+
+          if (surface != NULL && (clock = gdk_surface_get_frame_clock (surface)))
+            {
+              gdk_frame_clock_request_phase (clock, GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS);
+              break;
+            }
+        }
+    }
+
+  g_object_unref (display);
+}
+
+/*<private>
+ * _gdk_display_events_throttled:
+ * @display: a #GdkDisplay
+ * @timeout: (out) (optional): return location for the time in
+ *   milliseconds until events are dispatched again
+ *
+ * Checks whether @display has used up its events for the current
+ * frame. Event sources should not become ready while that is the
+ * case, so that the frame clock gets to run.
+ *
+ * Returns: %TRUE if events should wait for the next frame
+ */
+gboolean
+_gdk_display_events_throttled (GdkDisplay *display,
+                               int        *timeout)
+{
+  gint64 remaining;
+
+  if (display->frame_event_count < GDK_MAX_EVENTS_PER_FRAME)
+    return FALSE;
+
+  remaining = display->frame_event_start + EVENT_FRAME_TIMEOUT - g_get_monotonic_time ();
+  if (remaining <= 0)
+    {
+      _gdk_display_end_event_frame (display);
+      return FALSE;
+    }
+
+  if (timeout)
+    *timeout = (remaining + 999) / 1000;
+
+  return TRUE;
+}
+
+/*<private>
+ * _gdk_display_end_event_frame:
+ * @display: a #GdkDisplay
+ *
+ * Resets the per-frame event limit. Called when a frame flushes events.
+ */
+void
+_gdk_display_end_event_frame (GdkDisplay *display)
+{
+  if (display->frame_event_count == 0)
+    return;
+
+  gdk_profiler_set_int_counter (frame_events_counter, display->frame_event_count);
+
+  display->frame_event_count = 0;
+}
+
 GdkSurface *
 gdk_display_create_surface (GdkDisplay     *display,
                             GdkSurfaceType  surface_type,
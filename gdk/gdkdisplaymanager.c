@@ -44,6 +44,10 @@
 #include "macos/gdkmacosdisplay-private.h"
 #endif
 
+#ifdef HAVE_HEADLESS_BACKEND
+#include "headless/gdkprivate-headless.h"
+#endif
+
 #ifdef GDK_WINDOWING_WIN32
 #include "win32/gdkwin32.h"
 #include "win32/gdkprivate-win32.h"
@@ -235,6 +239,10 @@ static const char *allowed_backends;
  * broadway, wayland. You can also include a * in the
  * list to try all remaining backends.
  *
+ * There is also a headless backend for running tests
+ * without a display. It is never picked by *, only when
+ * it is named explicitly.
+ *
  * This call must happen prior to gdk_display_open(),
  * gtk_init(), or gtk_init_check()
  * in order to take effect.
@@ -250,6 +258,7 @@ typedef struct _GdkBackend GdkBackend;
 struct _GdkBackend {
   const char *name;
   GdkDisplay * (* open_display) (const char *name);
+  gboolean explicit_only;
 };
 
 static GdkBackend gdk_backends[] = {
@@ -267,6 +276,9 @@ static GdkBackend gdk_backends[] = {
 #endif
 #ifdef GDK_WINDOWING_BROADWAY
   { "broadway", _gdk_broadway_display_open },
+#endif
+#ifdef HAVE_HEADLESS_BACKEND
+  { "headless", _gdk_headless_display_open, TRUE },
 #endif
   /* NULL-terminating this array so we can use commas above */
   { NULL, NULL }
@@ -412,7 +424,7 @@ gdk_display_manager_open_display (GdkDisplayManager *manager,
 
       for (j = 0; gdk_backends[j].name != NULL; j++)
         {
-          if ((any && allow_any) ||
+          if ((any && allow_any && !gdk_backends[j].explicit_only) ||
               (any && strstr (allowed_backends, gdk_backends[j].name)) ||
               g_str_equal (backend, gdk_backends[j].name))
             {
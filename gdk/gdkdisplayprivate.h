@@ -55,6 +55,14 @@ typedef struct
   guint implicit : 1;
 } GdkDeviceGrabInfo;
 
+/* Under an input storm, dispatching events as long as there are any
+ * starves the frame clock, which runs at a lower priority. So only this
+ * many are dispatched between two frames; the rest stays queued and is
+ * emitted by the flush-events phase of the next frame. Backends also
+ * fetch no more than this many native events at a time.
+ */
+#define GDK_MAX_EVENTS_PER_FRAME 64
+
 /* Tracks information about which surface and position the pointer last was in.
  * This is useful when we need to synthesize events later.
  * Note that we track toplevel_under_pointer using enter/leave events,
@@ -79,6 +87,9 @@ struct _GdkDisplay
 
   guint event_pause_count;       /* How many times events are blocked */
 
+  guint frame_event_count;       /* Events dispatched since the last frame */
+  gint64 frame_event_start;      /* When the first of them was dispatched */
+
   guint closed             : 1;  /* Whether this display has been closed */
 
   GHashTable *device_grabs;
@@ -203,6 +214,10 @@ void                _gdk_display_pointer_info_foreach (GdkDisplay       *display
 gulong              _gdk_display_get_next_serial      (GdkDisplay       *display);
 void                _gdk_display_pause_events         (GdkDisplay       *display);
 void                _gdk_display_unpause_events       (GdkDisplay       *display);
+void                _gdk_display_dispatch_events      (GdkDisplay       *display);
+gboolean            _gdk_display_events_throttled     (GdkDisplay       *display,
+                                                       int              *timeout);
+void                _gdk_display_end_event_frame      (GdkDisplay       *display);
 GdkSurface *        gdk_display_create_surface        (GdkDisplay       *display,
                                                        GdkSurfaceType    surface_type,
                                                        GdkSurface       *parent,
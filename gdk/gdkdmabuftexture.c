@@ -0,0 +1,337 @@
+/*
+ * Copyright © 2021 GTK developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkdmabuftextureprivate.h"
+
+#include "gdkmemorytextureprivate.h"
+
+#include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_LINUX_DMA_BUF_H
+#include <sys/ioctl.h>
+#include <linux/dma-buf.h>
+#endif
+
+struct _GdkDmabufTexture
+{
+  GdkTexture parent_instance;
+
+  guint32 fourcc;
+  guint64 modifier;
+
+  guint n_planes;
+  int fds[GDK_DMABUF_MAX_PLANES];
+  guint offsets[GDK_DMABUF_MAX_PLANES];
+  guint strides[GDK_DMABUF_MAX_PLANES];
+
+  GDestroyNotify destroy;
+  gpointer data;
+};
+
+struct _GdkDmabufTextureClass
+{
+  GdkTextureClass parent_class;
+};
+
+G_DEFINE_TYPE (GdkDmabufTexture, gdk_dmabuf_texture, GDK_TYPE_TEXTURE)
+
+typedef struct {
+  guint32 fourcc;
+  GdkMemoryFormat memory_format;
+  gboolean opaque;
+} DmabufFormat;
+
+/* DRM formats are little-endian, so the byte order in memory
+ * doesn't depend on the architecture. */
+static const DmabufFormat supported_formats[] = {
+  { GDK_DRM_FORMAT_ARGB8888, GDK_MEMORY_B8G8R8A8_PREMULTIPLIED, FALSE },
+  { GDK_DRM_FORMAT_XRGB8888, GDK_MEMORY_B8G8R8A8_PREMULTIPLIED, TRUE },
+  { GDK_DRM_FORMAT_ABGR8888, GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, FALSE },
+  { GDK_DRM_FORMAT_XBGR8888, GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, TRUE },
+  { GDK_DRM_FORMAT_BGRA8888, GDK_MEMORY_A8R8G8B8_PREMULTIPLIED, FALSE },
+  { GDK_DRM_FORMAT_RGB888,   GDK_MEMORY_B8G8R8,                 TRUE },
+  { GDK_DRM_FORMAT_BGR888,   GDK_MEMORY_R8G8B8,                 TRUE },
+};
+
+static const DmabufFormat *
+find_format (guint32 fourcc)
+{
+  gsize i;
+
+  for (i = 0; i < G_N_ELEMENTS (supported_formats); i++)
+    {
+      if (supported_formats[i].fourcc == fourcc)
+        return &supported_formats[i];
+    }
+
+  return NULL;
+}
+
+static void
+gdk_dmabuf_texture_dispose (GObject *object)
+{
+  GdkDmabufTexture *self = GDK_DMABUF_TEXTURE (object);
+
+  if (self->destroy)
+    {
+      self->destroy (self->data);
+      self->destroy = NULL;
+      self->data = NULL;
+    }
+
+  G_OBJECT_CLASS (gdk_dmabuf_texture_parent_class)->dispose (object);
+}
+
+#ifdef HAVE_LINUX_DMA_BUF_H
+static void
+sync_dmabuf (int    fd,
+             guint  flags)
+{
+  struct dma_buf_sync sync = { .flags = DMA_BUF_SYNC_READ | flags };
+
+  /* Not all exporters implement this, and plain memory doesn't need it */
+  ioctl (fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
+#endif
+
+static void
+gdk_dmabuf_texture_download (GdkTexture         *texture,
+                             const GdkRectangle *area,
+                             guchar             *data,
+                             gsize               stride)
+{
+  GdkDmabufTexture *self = GDK_DMABUF_TEXTURE (texture);
+  const DmabufFormat *format = find_format (self->fourcc);
+  int y;
+#ifdef HAVE_SYS_MMAN_H
+  gsize bpp, size;
+  guchar *map;
+
+  /* Tiled and compressed layouts can only be read by the GPU */
+  if (self->n_planes != 1 ||
+      (self->modifier != GDK_DRM_FORMAT_MOD_LINEAR &&
+       self->modifier != GDK_DRM_FORMAT_MOD_INVALID))
+    goto fail;
+
+  size = (gsize) self->offsets[0] + (gsize) self->strides[0] * texture->height;
+  map = mmap (NULL, size, PROT_READ, MAP_SHARED, self->fds[0], 0);
+  if (map == MAP_FAILED)
+    goto fail;
+
+#ifdef HAVE_LINUX_DMA_BUF_H
+  sync_dmabuf (self->fds[0], DMA_BUF_SYNC_START);
+#endif
+
+  bpp = gdk_memory_format_bytes_per_pixel (format->memory_format);
+  gdk_memory_convert (data, stride,
+                      GDK_MEMORY_CAIRO_FORMAT_ARGB32,
+                      map + self->offsets[0]
+                        + area->x * bpp
+                        + area->y * self->strides[0],
+                      self->strides[0],
+                      format->memory_format,
+                      area->width, area->height);
+
+#ifdef HAVE_LINUX_DMA_BUF_H
+  sync_dmabuf (self->fds[0], DMA_BUF_SYNC_END);
+#endif
+
+  munmap (map, size);
+
+  /* The X channel is undefined, treat it like an opaque alpha value */
+  if (format->opaque)
+    {
+      for (y = 0; y < area->height; y++)
+        {
+          guint32 *row = (guint32 *) (data + y * stride);
+          int x;
+
+          for (x = 0; x < area->width; x++)
+            row[x] |= 0xFF000000;
+        }
+    }
+
+  return;
+
+fail:
+#endif
+  g_warning ("Cannot read back dmabuf texture with format %.4s, modifier %#" G_GINT64_MODIFIER "x",
+             (char *) &format->fourcc, self->modifier);
+
+  for (y = 0; y < area->height; y++)
+    memset (data + y * stride, 0, area->width * 4);
+}
+
+static void
+gdk_dmabuf_texture_class_init (GdkDmabufTextureClass *klass)
+{
+  GdkTextureClass *texture_class = GDK_TEXTURE_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  texture_class->download = gdk_dmabuf_texture_download;
+  gobject_class->dispose = gdk_dmabuf_texture_dispose;
+}
+
+static void
+gdk_dmabuf_texture_init (GdkDmabufTexture *self)
+{
+}
+
+/**
+ * gdk_dmabuf_texture_is_supported_fourcc:
+ * @fourcc: a DRM format code, as defined in drm_fourcc.h
+ *
+ * Checks if gdk_dmabuf_texture_new() accepts buffers with
+ * the given format.
+ *
+ * Currently, these are the packed 8 bit RGB formats
+ * DRM_FORMAT_ARGB8888, DRM_FORMAT_XRGB8888, DRM_FORMAT_ABGR8888,
+ * DRM_FORMAT_XBGR8888, DRM_FORMAT_BGRA8888, DRM_FORMAT_RGB888
+ * and DRM_FORMAT_BGR888. The color channels in formats with
+ * alpha must be premultiplied.
+ *
+ * Returns: %TRUE if @fourcc is supported
+ */
+gboolean
+gdk_dmabuf_texture_is_supported_fourcc (guint32 fourcc)
+{
+  return find_format (fourcc) != NULL;
+}
+
+/**
+ * gdk_dmabuf_texture_new:
+ * @width: the width of the texture
+ * @height: the height of the texture
+ * @fourcc: the DRM format of the buffer, as defined in drm_fourcc.h
+ * @modifier: the DRM format modifier describing the layout,
+ *     or DRM_FORMAT_MOD_INVALID to use the driver's implicit one
+ * @n_planes: the number of planes, at most 4
+ * @fds: (array length=n_planes): the dmabuf file descriptor of each plane
+ * @offsets: (array length=n_planes): the offset of each plane in its buffer
+ * @strides: (array length=n_planes): the stride of each plane
+ * @destroy: a destroy notify that will be called when the buffers
+ *     are no longer used
+ * @data: data that gets passed to @destroy
+ *
+ * Creates a new texture for buffers that were shared with the Linux
+ * DMA-BUF mechanism, such as decoded video frames or camera images.
+ *
+ * Renderers that can import such buffers use them on the GPU without
+ * copying the pixel data. Everything else, including gdk_texture_download(),
+ * reads them through a memory mapping, which only works for buffers
+ * with a linear layout.
+ *
+ * The file descriptors are not duplicated, they must stay open and
+ * the buffer contents must not be modified until @destroy is called,
+ * which happens when the texture is finalized.
+ *
+ * @fourcc must be a format that gdk_dmabuf_texture_is_supported_fourcc()
+ * accepts.
+ *
+ * Return value: (transfer full): A newly-created #GdkTexture
+ */
+GdkTexture *
+gdk_dmabuf_texture_new (int             width,
+                        int             height,
+                        guint32         fourcc,
+                        guint64         modifier,
+                        guint           n_planes,
+                        const int      *fds,
+                        const guint    *offsets,
+                        const guint    *strides,
+                        GDestroyNotify  destroy,
+                        gpointer        data)
+{
+  GdkDmabufTexture *self;
+  guint i;
+
+  g_return_val_if_fail (width > 0, NULL);
+  g_return_val_if_fail (height > 0, NULL);
+  g_return_val_if_fail (gdk_dmabuf_texture_is_supported_fourcc (fourcc), NULL);
+  g_return_val_if_fail (n_planes > 0 && n_planes <= GDK_DMABUF_MAX_PLANES, NULL);
+  g_return_val_if_fail (fds != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+  g_return_val_if_fail (strides != NULL, NULL);
+
+  self = g_object_new (GDK_TYPE_DMABUF_TEXTURE,
+                       "width", width,
+                       "height", height,
+                       NULL);
+
+  self->fourcc = fourcc;
+  self->modifier = modifier;
+  self->n_planes = n_planes;
+  for (i = 0; i < n_planes; i++)
+    {
+      self->fds[i] = fds[i];
+      self->offsets[i] = offsets[i];
+      self->strides[i] = strides[i];
+    }
+  self->destroy = destroy;
+  self->data = data;
+
+  return GDK_TEXTURE (self);
+}
+
+guint32
+gdk_dmabuf_texture_get_fourcc (GdkDmabufTexture *self)
+{
+  return self->fourcc;
+}
+
+guint64
+gdk_dmabuf_texture_get_modifier (GdkDmabufTexture *self)
+{
+  return self->modifier;
+}
+
+guint
+gdk_dmabuf_texture_get_n_planes (GdkDmabufTexture *self)
+{
+  return self->n_planes;
+}
+
+int
+gdk_dmabuf_texture_get_fd (GdkDmabufTexture *self,
+                           guint             plane)
+{
+  g_return_val_if_fail (plane < self->n_planes, -1);
+
+  return self->fds[plane];
+}
+
+guint
+gdk_dmabuf_texture_get_offset (GdkDmabufTexture *self,
+                               guint             plane)
+{
+  g_return_val_if_fail (plane < self->n_planes, 0);
+
+  return self->offsets[plane];
+}
+
+guint
+gdk_dmabuf_texture_get_stride (GdkDmabufTexture *self,
+                               guint             plane)
+{
+  g_return_val_if_fail (plane < self->n_planes, 0);
+
+  return self->strides[plane];
+}
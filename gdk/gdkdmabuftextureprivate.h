@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2021 GTK developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_DMABUF_TEXTURE_PRIVATE_H__
+#define __GDK_DMABUF_TEXTURE_PRIVATE_H__
+
+#include "gdkdmabuftexture.h"
+
+#include "gdktextureprivate.h"
+
+G_BEGIN_DECLS
+
+#define GDK_DMABUF_MAX_PLANES 4
+
+/* From drm_fourcc.h, so we don't need libdrm */
+#define GDK_DRM_FOURCC(a, b, c, d) ((guint32) (a) | ((guint32) (b) << 8) | \
+                                    ((guint32) (c) << 16) | ((guint32) (d) << 24))
+
+#define GDK_DRM_FORMAT_ARGB8888 GDK_DRM_FOURCC ('A', 'R', '2', '4')
+#define GDK_DRM_FORMAT_XRGB8888 GDK_DRM_FOURCC ('X', 'R', '2', '4')
+#define GDK_DRM_FORMAT_ABGR8888 GDK_DRM_FOURCC ('A', 'B', '2', '4')
+#define GDK_DRM_FORMAT_XBGR8888 GDK_DRM_FOURCC ('X', 'B', '2', '4')
+#define GDK_DRM_FORMAT_BGRA8888 GDK_DRM_FOURCC ('B', 'A', '2', '4')
+#define GDK_DRM_FORMAT_RGB888   GDK_DRM_FOURCC ('R', 'G', '2', '4')
+#define GDK_DRM_FORMAT_BGR888   GDK_DRM_FOURCC ('B', 'G', '2', '4')
+
+#define GDK_DRM_FORMAT_MOD_LINEAR  ((guint64) 0)
+#define GDK_DRM_FORMAT_MOD_INVALID ((guint64) 0x00ffffffffffffffULL)
+
+guint32                 gdk_dmabuf_texture_get_fourcc   (GdkDmabufTexture       *self);
+guint64                 gdk_dmabuf_texture_get_modifier (GdkDmabufTexture       *self);
+guint                   gdk_dmabuf_texture_get_n_planes (GdkDmabufTexture       *self);
+int                     gdk_dmabuf_texture_get_fd       (GdkDmabufTexture       *self,
+                                                         guint                   plane);
+guint                   gdk_dmabuf_texture_get_offset   (GdkDmabufTexture       *self,
+                                                         guint                   plane);
+guint                   gdk_dmabuf_texture_get_stride   (GdkDmabufTexture       *self,
+                                                         guint                   plane);
+
+G_END_DECLS
+
+#endif /* __GDK_DMABUF_TEXTURE_PRIVATE_H__ */
@@ -32,6 +32,7 @@
 #include "gdkdropprivate.h"
 #include "gdkkeysprivate.h"
 #include "gdk-private.h"
+#include "gdktelemetryprivate.h"
 
 #include <gobject/gvaluecollector.h>
 
@@ -486,6 +487,8 @@ check_event_sanity (GdkEvent *event)
 void
 _gdk_event_emit (GdkEvent *event)
 {
+  gint64 begin_time;
+
 #ifdef G_ENABLE_DEBUG
   if (!check_event_sanity (event))
     return;
@@ -494,7 +497,11 @@ _gdk_event_emit (GdkEvent *event)
   if (gdk_drag_handle_source_event (event))
     return;
 
+  begin_time = g_get_monotonic_time ();
+
   gdk_surface_handle_event (event);
+
+  gdk_telemetry_end (GDK_TELEMETRY_EVENT, begin_time, event->event_type);
 }
 
 /*********************************************
@@ -602,6 +609,38 @@ _gdk_event_unqueue (GdkDisplay *display)
   return event;
 }
 
+/* Motion and scroll histories are needed for every frame with
+ * ongoing input, so keep a few arrays around instead of allocating
+ * them for each frame. Events are only used in the main thread.
+ */
+#define HISTORY_POOL_SIZE 8
+#define HISTORY_POOL_MAX_LENGTH 256
+
+static GArray *history_pool[HISTORY_POOL_SIZE];
+static guint history_pool_len;
+
+static GArray *
+history_array_new (void)
+{
+  if (history_pool_len > 0)
+    return history_pool[--history_pool_len];
+
+  return g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+}
+
+static void
+history_array_free (GArray *history)
+{
+  if (history_pool_len < HISTORY_POOL_SIZE &&
+      history->len <= HISTORY_POOL_MAX_LENGTH)
+    {
+      g_array_set_size (history, 0);
+      history_pool[history_pool_len++] = history;
+    }
+  else
+    g_array_free (history, TRUE);
+}
+
 /*
  * If the last N events in the event queue are smooth scroll events
  * for the same surface and device, combine them into one.
@@ -658,7 +697,7 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
       double dx, dy;
 
       if (!history)
-        history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+        history = history_array_new ();
 
       gdk_scroll_event_get_deltas (event, &dx, &dy);
       delta_x += dx;
@@ -716,6 +755,7 @@ gdk_motion_event_push_history (GdkEvent *event,
                                GdkEvent *history_event)
 {
   GdkMotionEvent *self = (GdkMotionEvent *) event;
+  GdkMotionEvent *other = (GdkMotionEvent *) history_event;
   GdkDeviceTool *tool;
   GdkTimeCoord hist;
   int i;
@@ -723,20 +763,31 @@ gdk_motion_event_push_history (GdkEvent *event,
   g_assert (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY));
   g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_MOTION_NOTIFY));
 
-  if (!self->tool)
-    return;
+  if (G_UNLIKELY (!self->history))
+    self->history = history_array_new ();
+
+  /* Keep the history from earlier compressions */
+  if (other->history)
+    g_array_append_vals (self->history, other->history->data, other->history->len);
 
   tool = gdk_event_get_device_tool (history_event);
 
   memset (&hist, 0, sizeof (GdkTimeCoord));
   hist.time = gdk_event_get_time (history_event);
-  hist.flags = gdk_device_tool_get_axes (tool);
 
-  for (i = GDK_AXIS_X; i < GDK_AXIS_LAST; i++)
-    gdk_event_get_axis (history_event, i, &hist.axes[i]);
+  if (tool)
+    {
+      hist.flags = gdk_device_tool_get_axes (tool);
 
-  if (G_UNLIKELY (!self->history))
-    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+      for (i = GDK_AXIS_X; i < GDK_AXIS_LAST; i++)
+        gdk_event_get_axis (history_event, i, &hist.axes[i]);
+    }
+  else
+    {
+      /* Mice don't have tools, but their positions are just as useful */
+      hist.flags = GDK_AXIS_FLAG_X | GDK_AXIS_FLAG_Y;
+      gdk_event_get_position (history_event, &hist.axes[GDK_AXIS_X], &hist.axes[GDK_AXIS_Y]);
+    }
 
   g_array_append_val (self->history, hist);
 }
@@ -788,14 +839,7 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
       GList *next = pending_motions->next;
 
       if (last_motion != NULL)
-        {
-          GdkModifierType state = gdk_event_get_modifier_state (last_motion);
-
-          if (state &
-              (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK |
-               GDK_BUTTON4_MASK | GDK_BUTTON5_MASK))
-           gdk_motion_event_push_history (last_motion, pending_motions->data);
-        }
+        gdk_motion_event_push_history (last_motion, pending_motions->data);
 
       gdk_event_unref (pending_motions->data);
       g_queue_delete_link (&display->queued_events, pending_motions);
@@ -2242,7 +2286,7 @@ gdk_scroll_event_finalize (GdkEvent *event)
 
   g_clear_object (&self->tool);
   if (self->history)
-    g_array_free (self->history, TRUE);
+    history_array_free (self->history);
 
   GDK_EVENT_SUPER (self)->finalize (event);
 }
@@ -2764,7 +2808,7 @@ gdk_motion_event_finalize (GdkEvent *event)
   g_clear_object (&self->tool);
   g_clear_pointer (&self->axes, g_free);
   if (self->history)
-    g_array_free (self->history, TRUE);
+    history_array_free (self->history);
 
   GDK_EVENT_SUPER (event)->finalize (event);
 }
@@ -2862,8 +2906,9 @@ gdk_motion_event_new (GdkSurface      *surface,
  * The history includes events that are not delivered to the application
  * because they occurred in the same frame as @event.
  *
- * Note that only motion and scroll events record history, and motion
- * events only if one of the mouse buttons is down.
+ * Note that only motion and scroll events record history. For
+ * motion events, the history contains the positions, and for
+ * devices with tools also the other axes of the tool.
  *
  * Returns: (transfer container) (array length=out_n_coords) (nullable): an
  *   array of time and coordinates
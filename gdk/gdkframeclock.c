@@ -27,6 +27,9 @@
 #include "gdkframeclockprivate.h"
 #include "gdkinternals.h"
 
+#include <math.h>
+#include <string.h>
+
 /**
  * SECTION:gdkframeclock
  * @Title: GdkFrameClock
@@ -91,6 +94,33 @@ static guint fps_counter;
 
 #define FRAME_HISTORY_MAX_LENGTH 16
 
+/* The statistics are kept in log-linear histograms, like HdrHistogram:
+ * values below 2 * HISTOGRAM_SUB_BUCKETS microseconds get their own
+ * bucket, and every further power of two is split into
+ * HISTOGRAM_SUB_BUCKETS buckets, so that percentiles are accurate to
+ * about 6% up to HISTOGRAM_MAX_VALUE (over an hour).
+ */
+#define HISTOGRAM_SUB_BUCKETS 16
+#define HISTOGRAM_SUB_BUCKETS_BITS 4
+#define HISTOGRAM_MAX_VALUE ((G_GINT64_CONSTANT (1) << 32) - 1)
+#define HISTOGRAM_N_BUCKETS (HISTOGRAM_SUB_BUCKETS * (33 - HISTOGRAM_SUB_BUCKETS_BITS))
+
+typedef struct
+{
+  guint64 count;
+  gint64 max;
+  gint64 sum;
+  guint64 buckets[HISTOGRAM_N_BUCKETS];
+} Histogram;
+
+typedef struct
+{
+  gint64 counter;      /* The last frame that was added */
+  guint64 n_frames;
+  guint64 n_missed_frames;
+  Histogram histograms[GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY + 1];
+} FrameStats;
+
 struct _GdkFrameClockPrivate
 {
   gint64 frame_counter;
@@ -98,6 +128,10 @@ struct _GdkFrameClockPrivate
   int current;
   GdkFrameTimings *timings[FRAME_HISTORY_MAX_LENGTH];
   int n_freeze_inhibitors;
+
+  FrameStats *stats;
+
+  guint low_latency : 1;
 };
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GdkFrameClock, gdk_frame_clock, G_TYPE_OBJECT)
@@ -115,6 +149,8 @@ gdk_frame_clock_finalize (GObject *object)
     if (priv->timings[i] != 0)
       gdk_frame_timings_unref (priv->timings[i]);
 
+  g_free (priv->stats);
+
   G_OBJECT_CLASS (gdk_frame_clock_parent_class)->finalize (object);
 }
 
@@ -261,6 +297,9 @@ gdk_frame_clock_init (GdkFrameClock *clock)
   priv->frame_counter = -1;
   priv->current = FRAME_HISTORY_MAX_LENGTH - 1;
 
+  priv->stats = g_new0 (FrameStats, 1);
+  priv->stats->counter = -1;
+
   if (fps_counter == 0)
     fps_counter = gdk_profiler_define_counter ("fps", "Frames per Second");
 }
@@ -442,6 +481,10 @@ gdk_frame_clock_get_history_start (GdkFrameClock *frame_clock)
   return priv->frame_counter + 1 - priv->n_timings;
 }
 
+static void
+update_stats (GdkFrameClock *frame_clock,
+              gint64         force_counter);
+
 void
 _gdk_frame_clock_begin_frame (GdkFrameClock *frame_clock)
 {
@@ -451,6 +494,10 @@ _gdk_frame_clock_begin_frame (GdkFrameClock *frame_clock)
 
   priv = frame_clock->priv;
 
+  /* Account for the frame that is about to drop out of the history,
+   * whether it got presented or not */
+  update_stats (frame_clock, priv->frame_counter + 1 - FRAME_HISTORY_MAX_LENGTH);
+
   priv->frame_counter++;
   priv->current = (priv->current + 1) % FRAME_HISTORY_MAX_LENGTH;
 
@@ -530,6 +577,337 @@ gdk_frame_clock_get_current_timings (GdkFrameClock *frame_clock)
 }
 
 
+static int
+histogram_bucket (gint64 value)
+{
+  int shift;
+
+  value = CLAMP (value, 0, HISTOGRAM_MAX_VALUE);
+
+  if (value < 2 * HISTOGRAM_SUB_BUCKETS)
+    return value;
+
+  shift = g_bit_nth_msf (value, -1) - HISTOGRAM_SUB_BUCKETS_BITS;
+
+  return HISTOGRAM_SUB_BUCKETS * (shift + 1) + (value >> shift) - HISTOGRAM_SUB_BUCKETS;
+}
+
+/* The largest value that falls into @bucket */
+static gint64
+histogram_bucket_max (int bucket)
+{
+  int shift;
+
+  if (bucket < 2 * HISTOGRAM_SUB_BUCKETS)
+    return bucket;
+
+  shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+
+  return (((gint64) (bucket % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS + 1)) << shift) - 1;
+}
+
+static void
+histogram_add (Histogram *histogram,
+               gint64     value)
+{
+  value = CLAMP (value, 0, HISTOGRAM_MAX_VALUE);
+
+  histogram->buckets[histogram_bucket (value)]++;
+  histogram->count++;
+  histogram->sum += value;
+  histogram->max = MAX (histogram->max, value);
+}
+
+static void
+add_timings_to_stats (FrameStats      *stats,
+                      GdkFrameTimings *timings)
+{
+  stats->n_frames++;
+
+  if (timings->layout_start_time != 0)
+    {
+      gint64 layout_end_time = timings->paint_start_time ? timings->paint_start_time
+                                                          : timings->frame_end_time;
+
+      if (layout_end_time != 0)
+        histogram_add (&stats->histograms[GDK_FRAME_CLOCK_STAT_LAYOUT],
+                       layout_end_time - timings->layout_start_time);
+    }
+
+  if (timings->paint_start_time != 0 && timings->frame_end_time != 0)
+    histogram_add (&stats->histograms[GDK_FRAME_CLOCK_STAT_PAINT],
+                   timings->frame_end_time - timings->paint_start_time);
+
+  if (timings->presentation_time != 0 && timings->frame_time != 0)
+    {
+      gint64 latency = timings->presentation_time - timings->frame_time;
+
+      histogram_add (&stats->histograms[GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY], latency);
+
+      /* A frame that starts right after a vblank should be on screen
+       * at the next one, or the one after that with triple-buffering */
+      if (timings->refresh_interval != 0 &&
+          latency > 2 * timings->refresh_interval)
+        stats->n_missed_frames++;
+    }
+}
+
+/* Adds the frames that are complete to the statistics, in order. Frames
+ * up to @force_counter are added even if they are not complete. */
+static void
+update_stats (GdkFrameClock *frame_clock,
+              gint64         force_counter)
+{
+  GdkFrameClockPrivate *priv = frame_clock->priv;
+  FrameStats *stats = priv->stats;
+
+  while (stats->counter < priv->frame_counter)
+    {
+      GdkFrameTimings *timings;
+
+      timings = gdk_frame_clock_get_timings (frame_clock, stats->counter + 1);
+      if (timings != NULL)
+        {
+          if (!timings->complete && stats->counter + 1 > force_counter)
+            break;
+
+          add_timings_to_stats (stats, timings);
+        }
+
+      stats->counter++;
+    }
+}
+
+/**
+ * gdk_frame_clock_get_n_frames:
+ * @frame_clock: a #GdkFrameClock
+ *
+ * Gets the number of frames that the statistics of @frame_clock
+ * cover. Frames are added once their timings are complete, see
+ * gdk_frame_timings_get_complete().
+ *
+ * Returns: the number of frames since the last call to
+ *   gdk_frame_clock_reset_stats()
+ */
+guint64
+gdk_frame_clock_get_n_frames (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+
+  update_stats (frame_clock, -1);
+
+  return frame_clock->priv->stats->n_frames;
+}
+
+/**
+ * gdk_frame_clock_get_n_missed_frames:
+ * @frame_clock: a #GdkFrameClock
+ *
+ * Gets the number of frames that took more than two refresh intervals
+ * from the start of the frame until they were presented, and thus
+ * missed at least one refresh of the display.
+ *
+ * Returns: the number of missed frames since the last call to
+ *   gdk_frame_clock_reset_stats()
+ */
+guint64
+gdk_frame_clock_get_n_missed_frames (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+
+  update_stats (frame_clock, -1);
+
+  return frame_clock->priv->stats->n_missed_frames;
+}
+
+/**
+ * gdk_frame_clock_get_stat_count:
+ * @frame_clock: a #GdkFrameClock
+ * @stat: the statistic to query
+ *
+ * Gets the number of values recorded for @stat. This can be smaller
+ * than gdk_frame_clock_get_n_frames(), for example frames that don't
+ * need a layout don't record a layout time, and not all backends
+ * report presentation times.
+ *
+ * Returns: the number of values
+ */
+guint64
+gdk_frame_clock_get_stat_count (GdkFrameClock     *frame_clock,
+                                GdkFrameClockStat  stat)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+  g_return_val_if_fail (stat <= GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY, 0);
+
+  update_stats (frame_clock, -1);
+
+  return frame_clock->priv->stats->histograms[stat].count;
+}
+
+/**
+ * gdk_frame_clock_get_stat_mean:
+ * @frame_clock: a #GdkFrameClock
+ * @stat: the statistic to query
+ *
+ * Gets the mean of the values recorded for @stat.
+ *
+ * Returns: the mean in microseconds, or 0 if no values were recorded
+ */
+gint64
+gdk_frame_clock_get_stat_mean (GdkFrameClock     *frame_clock,
+                               GdkFrameClockStat  stat)
+{
+  Histogram *histogram;
+
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+  g_return_val_if_fail (stat <= GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY, 0);
+
+  update_stats (frame_clock, -1);
+
+  histogram = &frame_clock->priv->stats->histograms[stat];
+  if (histogram->count == 0)
+    return 0;
+
+  return histogram->sum / (gint64) histogram->count;
+}
+
+/**
+ * gdk_frame_clock_get_stat_max:
+ * @frame_clock: a #GdkFrameClock
+ * @stat: the statistic to query
+ *
+ * Gets the largest value recorded for @stat.
+ *
+ * Returns: the largest value in microseconds, or 0 if no values
+ *   were recorded
+ */
+gint64
+gdk_frame_clock_get_stat_max (GdkFrameClock     *frame_clock,
+                              GdkFrameClockStat  stat)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+  g_return_val_if_fail (stat <= GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY, 0);
+
+  update_stats (frame_clock, -1);
+
+  return frame_clock->priv->stats->histograms[stat].max;
+}
+
+/**
+ * gdk_frame_clock_get_stat_percentile:
+ * @frame_clock: a #GdkFrameClock
+ * @stat: the statistic to query
+ * @percentile: the percentile to compute, from 0 to 100
+ *
+ * Gets the value below which @percentile percent of the values
+ * recorded for @stat fall, within about 6%. For example, with a
+ * @percentile of 99, 99% of frames took at most the returned time.
+ *
+ * Returns: the percentile in microseconds, or 0 if no values were
+ *   recorded
+ */
+gint64
+gdk_frame_clock_get_stat_percentile (GdkFrameClock     *frame_clock,
+                                     GdkFrameClockStat  stat,
+                                     double             percentile)
+{
+  Histogram *histogram;
+  guint64 wanted, seen;
+  int i;
+
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), 0);
+  g_return_val_if_fail (stat <= GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY, 0);
+
+  update_stats (frame_clock, -1);
+
+  histogram = &frame_clock->priv->stats->histograms[stat];
+  if (histogram->count == 0)
+    return 0;
+
+  percentile = CLAMP (percentile, 0.0, 100.0);
+  wanted = MAX (1, (guint64) ceil (histogram->count * percentile / 100.0));
+
+  seen = 0;
+  for (i = 0; i < HISTOGRAM_N_BUCKETS; i++)
+    {
+      seen += histogram->buckets[i];
+      if (seen >= wanted)
+        return MIN (histogram_bucket_max (i), histogram->max);
+    }
+
+  return histogram->max;
+}
+
+/**
+ * gdk_frame_clock_reset_stats:
+ * @frame_clock: a #GdkFrameClock
+ *
+ * Clears the statistics of @frame_clock, so that they only cover
+ * the frames from now on. This is useful to export statistics for
+ * fixed intervals.
+ */
+void
+gdk_frame_clock_reset_stats (GdkFrameClock *frame_clock)
+{
+  GdkFrameClockPrivate *priv;
+  gint64 counter;
+
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  priv = frame_clock->priv;
+
+  /* Frames that are still in flight go into the new statistics */
+  update_stats (frame_clock, -1);
+  counter = priv->stats->counter;
+
+  memset (priv->stats, 0, sizeof (FrameStats));
+  priv->stats->counter = counter;
+}
+
+/**
+ * gdk_frame_clock_set_low_latency:
+ * @frame_clock: a #GdkFrameClock
+ * @low_latency: %TRUE to reduce latency
+ *
+ * Sets whether @frame_clock should try to reduce the time from input
+ * to the frame being shown.
+ *
+ * By default, frames start right after the previous frame was shown.
+ * In low-latency mode, the frame clock learns how long frames take
+ * from the recent frame timings, and starts frames just early enough
+ * to be ready for the next refresh, so that they include the latest
+ * input. This is useful while typing or dragging, but it makes it more
+ * likely to miss a refresh when the cost of frames changes.
+ *
+ * On displays with variable refresh rates, frames are instead started
+ * as soon as they are needed.
+ */
+void
+gdk_frame_clock_set_low_latency (GdkFrameClock *frame_clock,
+                                 gboolean       low_latency)
+{
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  frame_clock->priv->low_latency = !!low_latency;
+}
+
+/**
+ * gdk_frame_clock_get_low_latency:
+ * @frame_clock: a #GdkFrameClock
+ *
+ * Returns whether @frame_clock is in low-latency mode.
+ * See gdk_frame_clock_set_low_latency().
+ *
+ * Returns: %TRUE if @frame_clock tries to reduce latency
+ */
+gboolean
+gdk_frame_clock_get_low_latency (GdkFrameClock *frame_clock)
+{
+  g_return_val_if_fail (GDK_IS_FRAME_CLOCK (frame_clock), FALSE);
+
+  return frame_clock->priv->low_latency;
+}
+
 #ifdef G_ENABLE_DEBUG
 void
 _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
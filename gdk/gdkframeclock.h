@@ -70,6 +70,22 @@ typedef enum {
   GDK_FRAME_CLOCK_PHASE_AFTER_PAINT   = 1 << 6
 } GdkFrameClockPhase;
 
+/**
+ * GdkFrameClockStat:
+ * @GDK_FRAME_CLOCK_STAT_LAYOUT: the time spent in the layout phase
+ * @GDK_FRAME_CLOCK_STAT_PAINT: the time spent in the paint phase
+ * @GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY: the time from the start of a
+ *   frame until it was presented on the display
+ *
+ * The statistics that #GdkFrameClock collects about its frames.
+ * See gdk_frame_clock_get_stat_percentile().
+ */
+typedef enum {
+  GDK_FRAME_CLOCK_STAT_LAYOUT,
+  GDK_FRAME_CLOCK_STAT_PAINT,
+  GDK_FRAME_CLOCK_STAT_PRESENT_LATENCY
+} GdkFrameClockStat;
+
 GDK_AVAILABLE_IN_ALL
 GType    gdk_frame_clock_get_type             (void) G_GNUC_CONST;
 
@@ -106,6 +122,33 @@ void gdk_frame_clock_get_refresh_info (GdkFrameClock *frame_clock,
 GDK_AVAILABLE_IN_ALL
 double gdk_frame_clock_get_fps (GdkFrameClock *frame_clock);
 
+GDK_AVAILABLE_IN_ALL
+void     gdk_frame_clock_set_low_latency (GdkFrameClock *frame_clock,
+                                          gboolean       low_latency);
+GDK_AVAILABLE_IN_ALL
+gboolean gdk_frame_clock_get_low_latency (GdkFrameClock *frame_clock);
+
+/* Statistics */
+GDK_AVAILABLE_IN_ALL
+guint64 gdk_frame_clock_get_n_frames        (GdkFrameClock     *frame_clock);
+GDK_AVAILABLE_IN_ALL
+guint64 gdk_frame_clock_get_n_missed_frames (GdkFrameClock     *frame_clock);
+GDK_AVAILABLE_IN_ALL
+guint64 gdk_frame_clock_get_stat_count      (GdkFrameClock     *frame_clock,
+                                             GdkFrameClockStat  stat);
+GDK_AVAILABLE_IN_ALL
+gint64  gdk_frame_clock_get_stat_mean       (GdkFrameClock     *frame_clock,
+                                             GdkFrameClockStat  stat);
+GDK_AVAILABLE_IN_ALL
+gint64  gdk_frame_clock_get_stat_max        (GdkFrameClock     *frame_clock,
+                                             GdkFrameClockStat  stat);
+GDK_AVAILABLE_IN_ALL
+gint64  gdk_frame_clock_get_stat_percentile (GdkFrameClock     *frame_clock,
+                                             GdkFrameClockStat  stat,
+                                             double             percentile);
+GDK_AVAILABLE_IN_ALL
+void    gdk_frame_clock_reset_stats         (GdkFrameClock     *frame_clock);
+
 G_END_DECLS
 
 #endif /* __GDK_FRAME_CLOCK_H__ */
@@ -29,7 +29,9 @@
 #include "gdkinternals.h"
 #include "gdkframeclockprivate.h"
 #include "gdk.h"
+#include "gdkallocstatsprivate.h"
 #include "gdkprofilerprivate.h"
+#include "gdktelemetryprivate.h"
 
 #ifdef G_OS_WIN32
 #include <windows.h>
@@ -37,6 +39,10 @@
 
 #define FRAME_INTERVAL 16667 /* microseconds */
 
+/* In low-latency mode, how much earlier than the next refresh a frame
+ * should be done, to leave time for the compositor */
+#define MIN_DEADLINE_MARGIN 2000 /* microseconds */
+
 typedef enum {
   SMOOTH_PHASE_STATE_VALID = 0,    /* explicit, since we count on zero-init */
   SMOOTH_PHASE_STATE_AWAIT_FIRST,
@@ -51,6 +57,7 @@ struct _GdkFrameClockIdlePrivate
   gint64 smoothed_frame_time_reported; /* Ensures we are always monotonic */
   gint64 smoothed_frame_time_phase;    /* The offset of the first reported frame time, in the current animation sequence, from the preceding vsync */
   gint64 min_next_frame_time;          /* We're not synced to vblank, so wait at least until this before next cycle to avoid busy looping */
+  gint64 frame_delay;                  /* In low-latency mode, how much min_next_frame_time was moved past the start of the refresh cycle */
   SmoothDeltaState smooth_phase_state; /* The state of smoothed_frame_time_phase - is it valid, awaiting vsync etc. Thanks to zero-init, the initial value
                                           of smoothed_frame_time_phase is `0`. This is valid, since we didn't get a "frame drawn" event yet. Accordingly,
                                           the initial value of smooth_phase_state is SMOOTH_PHASE_STATE_VALID. See the comment in gdk_frame_clock_paint_idle()
@@ -69,6 +76,7 @@ struct _GdkFrameClockIdlePrivate
 
   guint in_paint_idle : 1;
   guint paint_is_thaw : 1;
+  guint variable_refresh : 1;
 #ifdef G_OS_WIN32
   guint begin_period : 1;
 #endif
@@ -392,6 +400,116 @@ positive_modulo (int i, int n)
   return (i % n + n) % n;
 }
 
+/* Estimates how long the next frame will take from its start until
+ * it is done painting, from the recent frames. Returns -1 if there
+ * is no data, or if a recent frame missed its refresh, since then
+ * the estimate can't be trusted.
+ */
+static gint64
+predict_frame_cost (GdkFrameClock *clock)
+{
+  gint64 cost = -1;
+  gint64 i;
+
+  for (i = gdk_frame_clock_get_history_start (clock);
+       i <= gdk_frame_clock_get_frame_counter (clock);
+       i++)
+    {
+      GdkFrameTimings *timings = gdk_frame_clock_get_timings (clock, i);
+
+      if (timings == NULL || timings->frame_end_time == 0)
+        continue;
+
+      if (timings->presentation_time != 0 && timings->refresh_interval != 0 &&
+          timings->presentation_time - timings->frame_time > 2 * timings->refresh_interval)
+        return -1;
+
+      /* Use the slowest recent frame, missing a refresh costs more
+       * than the latency we could save */
+      cost = MAX (cost, timings->frame_end_time - timings->frame_time);
+    }
+
+  return cost;
+}
+
+/* Displays with variable refresh rates show frames when they arrive,
+ * so the times between presentations are not multiples of the refresh
+ * interval.
+ */
+static gboolean
+detect_variable_refresh (GdkFrameClock *clock)
+{
+  GdkFrameTimings *previous = NULL;
+  int n_intervals = 0;
+  int n_off_grid = 0;
+  gint64 i;
+
+  for (i = gdk_frame_clock_get_history_start (clock);
+       i <= gdk_frame_clock_get_frame_counter (clock);
+       i++)
+    {
+      GdkFrameTimings *timings = gdk_frame_clock_get_timings (clock, i);
+      gint64 interval, offset;
+
+      if (timings == NULL || !timings->complete ||
+          timings->presentation_time == 0 || timings->refresh_interval == 0)
+        {
+          previous = NULL;
+          continue;
+        }
+
+      if (previous != NULL)
+        {
+          interval = timings->presentation_time - previous->presentation_time;
+          offset = interval % timings->refresh_interval;
+          offset = MIN (offset, timings->refresh_interval - offset);
+
+          n_intervals++;
+          if (offset > timings->refresh_interval / 5)
+            n_off_grid++;
+        }
+
+      previous = timings;
+    }
+
+  return n_intervals >= 4 && n_off_grid * 2 > n_intervals;
+}
+
+/* Instead of starting the next frame right at the start of the refresh
+ * cycle, start it as late as possible so that it is still done before
+ * the deadline, which reduces the time from input to the frame being
+ * shown.
+ */
+static void
+schedule_low_latency (GdkFrameClockIdle *clock_idle)
+{
+  GdkFrameClock *clock = GDK_FRAME_CLOCK (clock_idle);
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 period = priv->smoothed_frame_time_period;
+  gint64 cost, delay;
+
+  priv->variable_refresh = detect_variable_refresh (clock);
+  if (priv->variable_refresh)
+    {
+      /* There is no deadline, frames are shown once they are done. So
+       * start them as soon as they are needed, but not faster than the
+       * display can refresh. */
+      priv->min_next_frame_time = priv->frame_time + period;
+      return;
+    }
+
+  cost = predict_frame_cost (clock);
+  if (cost < 0)
+    return;
+
+  delay = period - cost - MAX (MIN_DEADLINE_MARGIN, period / 4);
+  if (delay <= 0)
+    return;
+
+  priv->frame_delay = delay;
+  priv->min_next_frame_time += delay;
+}
+
 static gboolean
 gdk_frame_clock_paint_idle (void *data)
 {
@@ -400,12 +518,17 @@ gdk_frame_clock_paint_idle (void *data)
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
   gboolean skip_to_resume_events;
   GdkFrameTimings *timings = NULL;
+  gint64 delayed_frame_time;
+  gint64 cycle_time;
+  gint64 cycle_start;
   gint64 before G_GNUC_UNUSED;
 
   before = GDK_PROFILER_CURRENT_TIME;
+  cycle_start = g_get_monotonic_time ();
 
   priv->paint_idle_id = 0;
   priv->in_paint_idle = TRUE;
+  delayed_frame_time = priv->min_next_frame_time;
   priv->min_next_frame_time = 0;
 
   skip_to_resume_events =
@@ -435,6 +558,15 @@ gdk_frame_clock_paint_idle (void *data)
 
               priv->frame_time = g_get_monotonic_time ();
 
+              /* A frame that was delayed on purpose still belongs to the
+               * refresh cycle it was scheduled in */
+              cycle_time = priv->frame_time;
+              if (priv->frame_delay > 0 &&
+                  priv->frame_time < delayed_frame_time + priv->smoothed_frame_time_period / 2)
+                cycle_time -= CLAMP (priv->frame_time - (delayed_frame_time - priv->frame_delay),
+                                     0, priv->frame_delay);
+              priv->frame_delay = 0;
+
               /*
                * The first clock cycle of an animation might have been triggered by some external event. An external
                * event can be an input event, an expired timer, data arriving over the network etc. This can happen at
@@ -496,21 +628,23 @@ gdk_frame_clock_paint_idle (void *data)
                   /* First vsync-related animation cycle, we can now compute the phase. We want the phase to satisfy
                      0 <= phase < frame_interval */
                   priv->smoothed_frame_time_phase =
-                      positive_modulo (priv->smoothed_frame_time_base - priv->frame_time,
+                      positive_modulo (priv->smoothed_frame_time_base - cycle_time,
                                        frame_interval);
                   priv->smooth_phase_state = SMOOTH_PHASE_STATE_VALID;
                 }
 
-              if (priv->smoothed_frame_time_base == 0)
+              if (priv->smoothed_frame_time_base == 0 || priv->variable_refresh)
                 {
-                  /* First frame ever, or first cycle in a new animation sequence. Ensure monotonicity */
-                  priv->smoothed_frame_time_base = MAX (priv->frame_time, priv->smoothed_frame_time_reported);
+                  /* First frame ever, or first cycle in a new animation sequence. Ensure monotonicity.
+                   * Variable refresh displays show frames when they are ready, so there is no grid
+                   * to align to. */
+                  priv->smoothed_frame_time_base = MAX (cycle_time, priv->smoothed_frame_time_reported);
                 }
               else
                 {
                   /* compute_smooth_frame_time() ensures monotonicity */
                   priv->smoothed_frame_time_base =
-                      compute_smooth_frame_time (clock, priv->frame_time + priv->smoothed_frame_time_phase,
+                      compute_smooth_frame_time (clock, cycle_time + priv->smoothed_frame_time_phase,
                                                  priv->paint_is_thaw,
                                                  priv->smoothed_frame_time_base,
                                                  priv->smoothed_frame_time_period);
@@ -556,14 +690,9 @@ gdk_frame_clock_paint_idle (void *data)
           if (priv->freeze_count == 0)
             {
 	      int iter;
-#ifdef G_ENABLE_DEBUG
-              if (GDK_DEBUG_CHECK (FRAMES))
-                {
-                  if (priv->phase != GDK_FRAME_CLOCK_PHASE_LAYOUT &&
-                      (priv->requested & GDK_FRAME_CLOCK_PHASE_LAYOUT))
-                    timings->layout_start_time = g_get_monotonic_time ();
-                }
-#endif
+              if (priv->phase != GDK_FRAME_CLOCK_PHASE_LAYOUT &&
+                  (priv->requested & GDK_FRAME_CLOCK_PHASE_LAYOUT))
+                timings->layout_start_time = g_get_monotonic_time ();
 
               priv->phase = GDK_FRAME_CLOCK_PHASE_LAYOUT;
 	      /* We loop in the layout phase, because we don't want to progress
@@ -586,14 +715,9 @@ gdk_frame_clock_paint_idle (void *data)
         case GDK_FRAME_CLOCK_PHASE_PAINT:
           if (priv->freeze_count == 0)
             {
-#ifdef G_ENABLE_DEBUG
-              if (GDK_DEBUG_CHECK (FRAMES))
-                {
-                  if (priv->phase != GDK_FRAME_CLOCK_PHASE_PAINT &&
-                      (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT))
-                    timings->paint_start_time = g_get_monotonic_time ();
-                }
-#endif
+              if (priv->phase != GDK_FRAME_CLOCK_PHASE_PAINT &&
+                  (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT))
+                timings->paint_start_time = g_get_monotonic_time ();
 
               priv->phase = GDK_FRAME_CLOCK_PHASE_PAINT;
               if (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT)
@@ -613,10 +737,9 @@ gdk_frame_clock_paint_idle (void *data)
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
             }
-#ifdef G_ENABLE_DEBUG
-            if (GDK_DEBUG_CHECK (FRAMES))
-              timings->frame_end_time = g_get_monotonic_time ();
-#endif /* G_ENABLE_DEBUG */
+          /* Recorded for the frame clock statistics */
+          if (timings)
+            timings->frame_end_time = g_get_monotonic_time ();
           G_GNUC_FALLTHROUGH;
 
         case GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS:
@@ -655,13 +778,21 @@ gdk_frame_clock_paint_idle (void *data)
       gint64 smooth_cycle_start = priv->smoothed_frame_time_base - priv->smoothed_frame_time_phase;
       priv->min_next_frame_time = smooth_cycle_start + priv->smoothed_frame_time_period;
 
+      priv->frame_delay = 0;
+      priv->variable_refresh = FALSE;
+      if (gdk_frame_clock_get_low_latency (clock))
+        schedule_low_latency (clock_idle);
+
       maybe_start_idle (clock_idle, FALSE);
     }
 
   if (priv->freeze_count == 0)
     priv->sleep_serial = get_sleep_serial ();
 
+  gdk_telemetry_end (GDK_TELEMETRY_FRAME, cycle_start,
+                     gdk_frame_clock_get_frame_counter (clock));
   gdk_profiler_end_mark (before, "frameclock cycle", NULL);
+  gdk_alloc_stats_update_profiler ();
 
   return FALSE;
 }
@@ -753,6 +884,21 @@ gdk_frame_clock_idle_thaw (GdkFrameClock *clock)
   priv->freeze_count--;
   if (priv->freeze_count == 0)
     {
+      /* Backends that throttle freeze us until the previous frame was
+       * presented, so the end of gdk_frame_clock_paint_idle() didn't get
+       * to schedule the next one. The thaw is the start of the refresh
+       * cycle, so delay from here.
+       */
+      if (gdk_frame_clock_get_low_latency (clock) &&
+          !priv->in_paint_idle && priv->paint_idle_id == 0 &&
+          RUN_PAINT_IDLE (priv))
+        {
+          priv->min_next_frame_time = g_get_monotonic_time ();
+          priv->frame_delay = 0;
+          priv->variable_refresh = FALSE;
+          schedule_low_latency (clock_idle);
+        }
+
       maybe_start_idle (clock_idle, TRUE);
       /* If nothing is requested so we didn't start an idle, we need
        * to skip to the end of the state chain, since the idle won't
@@ -222,6 +222,133 @@ gdk_gl_context_get_property (GObject    *gobject,
     }
 }
 
+/*<private>
+ * gdk_gl_context_import_dmabuf:
+ * @context: a #GdkGLContext
+ * @texture: a #GdkDmabufTexture
+ * @texture_target: the binding point of the texture to import to
+ *
+ * Makes the GL texture currently bound to @texture_target in @context
+ * use the buffers of @texture as its storage, without copying them.
+ *
+ * Returns: %TRUE if the backend could import the buffers
+ */
+gboolean
+gdk_gl_context_import_dmabuf (GdkGLContext     *context,
+                              GdkDmabufTexture *texture,
+                              guint             texture_target)
+{
+  GdkGLContextClass *klass = GDK_GL_CONTEXT_GET_CLASS (context);
+
+  g_return_val_if_fail (GDK_IS_GL_CONTEXT (context), FALSE);
+  g_return_val_if_fail (GDK_IS_DMABUF_TEXTURE (texture), FALSE);
+
+  if (klass->import_dmabuf == NULL)
+    return FALSE;
+
+  return klass->import_dmabuf (context, texture, texture_target);
+}
+
+/*<private>
+ * gdk_gl_context_get_deep_format:
+ * @context: a #GdkGLContext
+ * @format: a #GdkMemoryFormat
+ * @out_internalformat: (out): return location for the texture format
+ * @out_format: (out): return location for the data format
+ * @out_type: (out): return location for the data type
+ *
+ * Gets the GL formats to upload data in one of the deep memory
+ * formats with, if @context can take it without converting it
+ * to 8 bits first.
+ *
+ * Returns: %TRUE if the data can be uploaded as-is
+ */
+gboolean
+gdk_gl_context_get_deep_format (GdkGLContext    *context,
+                                GdkMemoryFormat  format,
+                                guint           *out_internalformat,
+                                guint           *out_format,
+                                guint           *out_type)
+{
+  GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
+  gboolean has_float, has_norm16;
+
+  /* Float textures are core in GL 3.0 and GLES 3.0, but GLES can't
+   * filter 32 bit floats or have 16 bit normalized textures without
+   * extensions, and can't upload 3 channel data to 4 channel textures.
+   */
+  if (priv->use_es)
+    {
+      has_float = FALSE;
+      has_norm16 = FALSE;
+
+      if (priv->gl_version >= 30 && format == GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED)
+        {
+          *out_internalformat = GL_RGBA16F;
+          *out_format = GL_RGBA;
+          *out_type = GL_HALF_FLOAT;
+          return TRUE;
+        }
+    }
+  else
+    {
+      has_float = priv->gl_version >= 30 || epoxy_has_gl_extension ("GL_ARB_texture_float");
+      has_norm16 = TRUE;
+    }
+
+  switch (format)
+    {
+    case GDK_MEMORY_R16G16B16:
+      *out_internalformat = GL_RGBA16;
+      *out_format = GL_RGB;
+      *out_type = GL_UNSIGNED_SHORT;
+      return has_norm16;
+
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+      *out_internalformat = GL_RGBA16;
+      *out_format = GL_RGBA;
+      *out_type = GL_UNSIGNED_SHORT;
+      return has_norm16;
+
+    case GDK_MEMORY_R16G16B16_FLOAT:
+      *out_internalformat = GL_RGBA16F;
+      *out_format = GL_RGB;
+      *out_type = GL_HALF_FLOAT;
+      return has_float;
+
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      *out_internalformat = GL_RGBA16F;
+      *out_format = GL_RGBA;
+      *out_type = GL_HALF_FLOAT;
+      return has_float;
+
+    case GDK_MEMORY_R32G32B32_FLOAT:
+      *out_internalformat = GL_RGBA32F;
+      *out_format = GL_RGB;
+      *out_type = GL_FLOAT;
+      return has_float;
+
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      *out_internalformat = GL_RGBA32F;
+      *out_format = GL_RGBA;
+      *out_type = GL_FLOAT;
+      return has_float;
+
+    case GDK_MEMORY_B8G8R8A8_PREMULTIPLIED:
+    case GDK_MEMORY_A8R8G8B8_PREMULTIPLIED:
+    case GDK_MEMORY_R8G8B8A8_PREMULTIPLIED:
+    case GDK_MEMORY_B8G8R8A8:
+    case GDK_MEMORY_A8R8G8B8:
+    case GDK_MEMORY_R8G8B8A8:
+    case GDK_MEMORY_A8B8G8R8:
+    case GDK_MEMORY_R8G8B8:
+    case GDK_MEMORY_B8G8R8:
+    case GDK_MEMORY_N_FORMATS:
+    default:
+      return FALSE;
+    }
+}
+
 void
 gdk_gl_context_upload_texture (GdkGLContext    *context,
                                const guchar    *data,
@@ -233,13 +360,20 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
 {
   GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
   guchar *copy = NULL;
+  guint gl_internalformat;
   guint gl_format;
   guint gl_type;
   guint bpp;
 
   g_return_if_fail (GDK_IS_GL_CONTEXT (context));
 
-  if (priv->use_es)
+  if (gdk_gl_context_get_deep_format (context, data_format,
+                                      &gl_internalformat, &gl_format, &gl_type))
+    {
+      /* Deep data goes to the GPU as-is */
+      bpp = gdk_memory_format_bytes_per_pixel (data_format);
+    }
+  else if (priv->use_es)
     {
       /* GLES only supports rgba, so convert if necessary */
       if (data_format != GDK_MEMORY_R8G8B8A8_PREMULTIPLIED)
@@ -254,11 +388,14 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
         }
 
       bpp = 4;
+      gl_internalformat = GL_RGBA;
       gl_format = GL_RGBA;
       gl_type = GL_UNSIGNED_BYTE;
     }
   else
     {
+      gl_internalformat = GL_RGBA;
+
       if (data_format == GDK_MEMORY_DEFAULT) /* Cairo surface format */
         {
           gl_format = GL_BGRA;
@@ -293,7 +430,7 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
     {
       glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
 
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, data);
+      glTexImage2D (texture_target, 0, gl_internalformat, width, height, 0, gl_format, gl_type, data);
       glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
     }
   else if ((!priv->use_es ||
@@ -301,14 +438,14 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
     {
       glPixelStorei (GL_UNPACK_ROW_LENGTH, stride / bpp);
 
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, data);
+      glTexImage2D (texture_target, 0, gl_internalformat, width, height, 0, gl_format, gl_type, data);
 
       glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
     }
   else
     {
       int i;
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, NULL);
+      glTexImage2D (texture_target, 0, gl_internalformat, width, height, 0, gl_format, gl_type, NULL);
       for (i = 0; i < height; i++)
         glTexSubImage2D (texture_target, 0, 0, i, width, 1, gl_format, gl_type, data + (i * stride));
     }
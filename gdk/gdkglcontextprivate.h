@@ -24,6 +24,7 @@
 #include "gdkglcontext.h"
 #include "gdkdrawcontextprivate.h"
 #include "gdkmemorytexture.h"
+#include "gdkdmabuftexture.h"
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,10 @@ struct _GdkGLContextClass
                         GError **error);
 
   cairo_region_t * (* get_damage) (GdkGLContext *context);
+
+  gboolean (* import_dmabuf) (GdkGLContext     *context,
+                              GdkDmabufTexture *texture,
+                              guint             texture_target);
 };
 
 typedef struct {
@@ -76,6 +81,14 @@ typedef struct {
 void                    gdk_gl_context_set_is_legacy            (GdkGLContext    *context,
                                                                  gboolean         is_legacy);
 
+gboolean                gdk_gl_context_import_dmabuf            (GdkGLContext     *context,
+                                                                 GdkDmabufTexture *texture,
+                                                                 guint             texture_target);
+gboolean                gdk_gl_context_get_deep_format          (GdkGLContext    *context,
+                                                                 GdkMemoryFormat  format,
+                                                                 guint           *out_internalformat,
+                                                                 guint           *out_format,
+                                                                 guint           *out_type);
 void                    gdk_gl_context_upload_texture           (GdkGLContext    *context,
                                                                  const guchar    *data,
                                                                  int              width,
@@ -30,6 +30,7 @@ struct _GdkGLTexture {
 
   GdkGLContext *context;
   guint id;
+  gpointer sync;
 
   cairo_surface_t *saved;
 
@@ -57,6 +58,7 @@ gdk_gl_texture_dispose (GObject *object)
 
   g_clear_object (&self->context);
   self->id = 0;
+  self->sync = NULL;
 
   if (self->saved)
     {
@@ -131,6 +133,23 @@ gdk_gl_texture_get_id (GdkGLTexture *self)
   return self->id;
 }
 
+/* The fence is owned by whoever created the texture, and must stay
+ * valid until the destroy notify is called. Consumers in the same
+ * share group can wait for it on the GPU instead of calling glFinish().
+ */
+void
+gdk_gl_texture_set_sync (GdkGLTexture *self,
+                         gpointer      sync)
+{
+  self->sync = sync;
+}
+
+gpointer
+gdk_gl_texture_get_sync (GdkGLTexture *self)
+{
+  return self->sync;
+}
+
 /**
  * gdk_gl_texture_release:
  * @self: a #GdkTexture wrapping a GL texture
@@ -173,6 +192,7 @@ gdk_gl_texture_release (GdkGLTexture *self)
 
   g_clear_object (&self->context);
   self->id = 0;
+  self->sync = NULL;
 }
 
 /**
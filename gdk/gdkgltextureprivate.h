@@ -9,6 +9,9 @@ G_BEGIN_DECLS
 
 GdkGLContext *          gdk_gl_texture_get_context      (GdkGLTexture           *self);
 guint                   gdk_gl_texture_get_id           (GdkGLTexture           *self);
+void                    gdk_gl_texture_set_sync         (GdkGLTexture           *self,
+                                                         gpointer                sync);
+gpointer                gdk_gl_texture_get_sync         (GdkGLTexture           *self);
 
 G_END_DECLS
 
@@ -0,0 +1,134 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Build tool that decodes the images we ship as resources, so that
+ * they can be used without decoding them at runtime. See
+ * gdkpredecodedprivate.h for the format.
+ *
+ * Usage: gdk-image-predecode SRCDIR OUTDIR IMAGE...
+ *
+ * Each IMAGE is a path relative to SRCDIR. Its predecoded copy is
+ * written to OUTDIR, with the directory separators in the path
+ * replaced by dashes, so that it can be listed as a build output.
+ */
+
+#include "config.h"
+
+#include "gdkpredecodedprivate.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <stdlib.h>
+#include <string.h>
+
+static gboolean
+predecode (const char  *input,
+           const char  *output,
+           GError     **error)
+{
+  GdkPredecodedHeader header = { { 0, }, };
+  GdkPixbuf *pixbuf;
+  const guchar *pixels;
+  guchar *data;
+  gsize size;
+  int width, height, stride, n_channels;
+  gboolean has_alpha;
+  gboolean result;
+  int x, y;
+
+  pixbuf = gdk_pixbuf_new_from_file (input, error);
+  if (pixbuf == NULL)
+    return FALSE;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+  stride = gdk_pixbuf_get_rowstride (pixbuf);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+  has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+  pixels = gdk_pixbuf_read_pixels (pixbuf);
+
+  memcpy (header.magic, GDK_PREDECODED_MAGIC, sizeof (header.magic));
+  header.width = width;
+  header.height = height;
+  header.stride = width * 4;
+
+  size = sizeof (header) + (gsize) header.stride * height;
+  data = g_malloc (size);
+  memcpy (data, &header, sizeof (header));
+
+  for (y = 0; y < height; y++)
+    {
+      const guchar *src = pixels + (gsize) y * stride;
+      guint32 *dest = (guint32 *) (data + sizeof (header) + (gsize) y * header.stride);
+
+      for (x = 0; x < width; x++)
+        {
+          guint a = has_alpha ? src[3] : 255;
+          guint r = (src[0] * a + 127) / 255;
+          guint g = (src[1] * a + 127) / 255;
+          guint b = (src[2] * a + 127) / 255;
+
+          /* cairo's ARGB32 is a native endian 32 bit value */
+          dest[x] = (a << 24) | (r << 16) | (g << 8) | b;
+          src += n_channels;
+        }
+    }
+
+  result = g_file_set_contents (output, (const char *) data, size, error);
+
+  g_free (data);
+  g_object_unref (pixbuf);
+
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  int i;
+
+  if (argc < 3)
+    {
+      g_printerr ("Usage: %s SRCDIR OUTDIR IMAGE...\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 3; i < argc; i++)
+    {
+      char *input, *flat, *output;
+      char **parts;
+
+      input = g_build_filename (argv[1], argv[i], NULL);
+
+      parts = g_strsplit (argv[i], "/", -1);
+      flat = g_strjoinv ("-", parts);
+      g_strfreev (parts);
+
+      output = g_strconcat (argv[2], G_DIR_SEPARATOR_S, flat, GDK_PREDECODED_SUFFIX, NULL);
+
+      if (!predecode (input, output, &error))
+        {
+          g_printerr ("%s: %s\n", input, error->message);
+          g_error_free (error);
+          return EXIT_FAILURE;
+        }
+
+      g_free (input);
+      g_free (flat);
+      g_free (output);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -29,6 +29,8 @@
 #include "gdkdisplay.h"
 #include "gdkdisplaymanagerprivate.h"
 
+#include <string.h>
+
 
 /**
  * SECTION:keys
@@ -220,6 +222,8 @@ gdk_keymap_keys_changed (GdkKeymap *keymap)
   g_array_append_val (keymap->cached_keys, key);
 
   g_hash_table_remove_all (keymap->cache);
+
+  gdk_keymap_clear_translations (keymap);
 }
 
 static void
@@ -729,16 +733,57 @@ gdk_keymap_translate_keyboard_state (GdkKeymap       *keymap,
                                      int             *level,
                                      GdkModifierType *consumed_modifiers)
 {
+  GdkKeymapTranslation *t;
+  guint hash;
+
   g_return_val_if_fail (GDK_IS_KEYMAP (keymap), FALSE);
 
-  return GDK_KEYMAP_GET_CLASS (keymap)->translate_keyboard_state (keymap,
-								  hardware_keycode,
-								  state,
-								  group,
-								  keyval,
-								  effective_group,
-								  level,
-								  consumed_modifiers);
+  hash = (hardware_keycode ^ ((guint) state << 8) ^ ((guint) group << 29)) * 2654435761u;
+  t = &keymap->translations[hash % GDK_KEYMAP_N_TRANSLATIONS];
+
+  if (!t->cached ||
+      t->keycode != hardware_keycode ||
+      t->state != state ||
+      t->group != group)
+    {
+      t->found = GDK_KEYMAP_GET_CLASS (keymap)->translate_keyboard_state (keymap,
+                                                                          hardware_keycode,
+                                                                          state,
+                                                                          group,
+                                                                          &t->keyval,
+                                                                          &t->effective_group,
+                                                                          &t->level,
+                                                                          &t->consumed);
+      t->keycode = hardware_keycode;
+      t->state = state;
+      t->group = group;
+      t->cached = TRUE;
+    }
+
+  if (keyval)
+    *keyval = t->keyval;
+  if (effective_group)
+    *effective_group = t->effective_group;
+  if (level)
+    *level = t->level;
+  if (consumed_modifiers)
+    *consumed_modifiers = t->consumed;
+
+  return t->found;
+}
+
+/*
+ * gdk_keymap_clear_translations:
+ * @keymap: a #GdkKeymap
+ *
+ * Forgets the results of earlier calls to
+ * gdk_keymap_translate_keyboard_state(). Backends must call this
+ * when the translation changes without ::keys-changed being emitted.
+ */
+void
+gdk_keymap_clear_translations (GdkKeymap *keymap)
+{
+  memset (keymap->translations, 0, sizeof (keymap->translations));
 }
 
 #include "gdkkeynames.c"
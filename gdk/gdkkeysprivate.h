@@ -68,6 +68,23 @@ struct _GdkKeymapClass
   void (*state_changed)     (GdkKeymap *keymap);
 };
 
+/* Every key event gets translated at least twice, with and without
+ * the lock modifiers, so recent translations are kept around.
+ */
+#define GDK_KEYMAP_N_TRANSLATIONS 256
+
+typedef struct {
+  guint keycode;
+  GdkModifierType state;
+  int group;
+  guint keyval;
+  int effective_group;
+  int level;
+  GdkModifierType consumed;
+  guint cached : 1;
+  guint found  : 1;
+} GdkKeymapTranslation;
+
 struct _GdkKeymap
 {
   GObject     parent_instance;
@@ -83,6 +100,11 @@ struct _GdkKeymap
    */
   GArray *cached_keys;
   GHashTable *cache;
+
+  /* Direct-mapped on keycode, state and group. Cleared along
+   * with the caches above.
+   */
+  GdkKeymapTranslation translations[GDK_KEYMAP_N_TRANSLATIONS];
 };
 
 GType gdk_keymap_get_type (void) G_GNUC_CONST;
@@ -120,6 +142,7 @@ void           gdk_keymap_get_cached_entries_for_keyval (GdkKeymap     *keymap,
                                                          guint          keyval,
                                                          GdkKeymapKey **keys,
                                                          guint         *n_keys);
+void           gdk_keymap_clear_translations            (GdkKeymap     *keymap);
 
 G_END_DECLS
 
@@ -56,6 +56,20 @@ gdk_memory_format_bytes_per_pixel (GdkMemoryFormat format)
     case GDK_MEMORY_B8G8R8:
       return 3;
 
+    case GDK_MEMORY_R16G16B16:
+    case GDK_MEMORY_R16G16B16_FLOAT:
+      return 6;
+
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      return 8;
+
+    case GDK_MEMORY_R32G32B32_FLOAT:
+      return 12;
+
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      return 16;
+
     case GDK_MEMORY_N_FORMATS:
     default:
       g_assert_not_reached ();
@@ -63,6 +77,46 @@ gdk_memory_format_bytes_per_pixel (GdkMemoryFormat format)
     }
 }
 
+/*<private>
+ * gdk_memory_format_is_deep:
+ * @format: a #GdkMemoryFormat
+ *
+ * Checks if @format has more than 8 bits per channel, so that
+ * converting it to one of the 8 bit formats loses precision.
+ *
+ * Returns: %TRUE if @format has more than 8 bits per channel
+ */
+gboolean
+gdk_memory_format_is_deep (GdkMemoryFormat format)
+{
+  return format >= GDK_MEMORY_R16G16B16 && format < GDK_MEMORY_N_FORMATS;
+}
+
+/*<private>
+ * gdk_memory_format_is_opaque:
+ * @format: a #GdkMemoryFormat
+ *
+ * Checks if @format has no alpha channel.
+ *
+ * Returns: %TRUE if all pixels in @format are opaque
+ */
+gboolean
+gdk_memory_format_is_opaque (GdkMemoryFormat format)
+{
+  switch (format)
+    {
+    case GDK_MEMORY_R8G8B8:
+    case GDK_MEMORY_B8G8R8:
+    case GDK_MEMORY_R16G16B16:
+    case GDK_MEMORY_R16G16B16_FLOAT:
+    case GDK_MEMORY_R32G32B32_FLOAT:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
 static void
 gdk_memory_texture_dispose (GObject *object)
 {
@@ -276,6 +330,104 @@ SWIZZLE_PREMULTIPLY (3,0,1,2, 0,1,2,3)
 SWIZZLE_PREMULTIPLY (3,0,1,2, 3,0,1,2)
 SWIZZLE_PREMULTIPLY (3,0,1,2, 0,3,2,1)
 
+static inline float
+half_to_float (guint16 h)
+{
+  const guint32 sign = (h & 0x8000) << 16;
+  guint32 exponent = (h >> 10) & 0x1f;
+  guint32 mantissa = h & 0x3ff;
+  union { guint32 u; float f; } result;
+
+  if (exponent == 0x1f)
+    {
+      /* Infinity and NaN */
+      result.u = sign | 0x7f800000 | (mantissa << 13);
+    }
+  else if (exponent != 0)
+    {
+      result.u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+  else if (mantissa != 0)
+    {
+      /* Denormals, which are normal floats */
+      exponent = 113;
+      while ((mantissa & 0x400) == 0)
+        {
+          mantissa <<= 1;
+          exponent--;
+        }
+      result.u = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  else
+    {
+      result.u = sign;
+    }
+
+  return result.f;
+}
+
+static inline guchar
+float_to_8bit (float f)
+{
+  /* written so that NaN gives 0 */
+  if (!(f > 0.f))
+    return 0;
+  if (f >= 1.f)
+    return 255;
+
+  return (guchar) (f * 255.f + .5f);
+}
+
+#define U16_TO_8BIT(v) ((guchar) (((v) * 255 + 32895) >> 16))
+#define HALF_TO_8BIT(v) float_to_8bit (half_to_float (v))
+#define FLOAT_TO_8BIT(v) float_to_8bit (v)
+
+/* The deep formats are all red, green, blue and maybe alpha, with
+ * premultiplied colors, so getting them down to 8 bits is just a
+ * matter of placing the rounded values. */
+#define CONVERT_DEEP(NAME,TYPE,N_CHANNELS,TO_8BIT, A,R,G,B) \
+static void \
+convert_ ## NAME ## _ ## A ## R ## G ## B (guchar       *dest_data, \
+                                          gsize         dest_stride, \
+                                          const guchar *src_data, \
+                                          gsize         src_stride, \
+                                          gsize         width, \
+                                          gsize         height) \
+{ \
+  gsize x, y; \
+\
+  for (y = 0; y < height; y++) \
+    { \
+      const TYPE *src = (const TYPE *) src_data; \
+\
+      for (x = 0; x < width; x++) \
+        { \
+          dest_data[4 * x + R] = TO_8BIT (src[N_CHANNELS * x + 0]); \
+          dest_data[4 * x + G] = TO_8BIT (src[N_CHANNELS * x + 1]); \
+          dest_data[4 * x + B] = TO_8BIT (src[N_CHANNELS * x + 2]); \
+          if (N_CHANNELS == 4) \
+            dest_data[4 * x + A] = TO_8BIT (src[N_CHANNELS * x + N_CHANNELS - 1]); \
+          else \
+            dest_data[4 * x + A] = 0xFF; \
+        } \
+\
+      dest_data += dest_stride; \
+      src_data += src_stride; \
+    } \
+}
+
+#define CONVERT_DEEP_ALL(NAME,TYPE,N_CHANNELS,TO_8BIT) \
+CONVERT_DEEP(NAME,TYPE,N_CHANNELS,TO_8BIT, 3,2,1,0) \
+CONVERT_DEEP(NAME,TYPE,N_CHANNELS,TO_8BIT, 0,1,2,3) \
+CONVERT_DEEP(NAME,TYPE,N_CHANNELS,TO_8BIT, 3,0,1,2)
+
+CONVERT_DEEP_ALL (rgb16, guint16, 3, U16_TO_8BIT)
+CONVERT_DEEP_ALL (rgba16, guint16, 4, U16_TO_8BIT)
+CONVERT_DEEP_ALL (rgb16f, guint16, 3, HALF_TO_8BIT)
+CONVERT_DEEP_ALL (rgba16f, guint16, 4, HALF_TO_8BIT)
+CONVERT_DEEP_ALL (rgb32f, float, 3, FLOAT_TO_8BIT)
+CONVERT_DEEP_ALL (rgba32f, float, 4, FLOAT_TO_8BIT)
+
 typedef void (* ConversionFunc) (guchar       *dest_data,
                                  gsize         dest_stride,
                                  const guchar *src_data,
@@ -283,19 +435,361 @@ typedef void (* ConversionFunc) (guchar       *dest_data,
                                  gsize         width,
                                  gsize         height);
 
-static ConversionFunc converters[GDK_MEMORY_N_FORMATS][3] =
+typedef enum {
+  CONVERT_COPY,
+  CONVERT_SWIZZLE,
+  CONVERT_SWIZZLE_OPAQUE,
+  CONVERT_SWIZZLE_PREMULTIPLY,
+  CONVERT_DEEP
+} ConversionKind;
+
+/* Besides the scalar function, each conversion describes which source
+ * byte every destination byte comes from (0x80 for the opaque alpha)
+ * and where the alpha ends up, which is what the vectorized kernels
+ * need to build their shuffle masks. */
+typedef struct
 {
-  { convert_memcpy, convert_swizzle3210, convert_swizzle2103 },
-  { convert_swizzle3210, convert_memcpy, convert_swizzle3012 },
-  { convert_swizzle2103, convert_swizzle1230, convert_memcpy },
-  { convert_swizzle_premultiply_3210_3210, convert_swizzle_premultiply_0123_3210, convert_swizzle_premultiply_3012_3210,  },
-  { convert_swizzle_premultiply_3210_0123, convert_swizzle_premultiply_0123_0123, convert_swizzle_premultiply_3012_0123 },
-  { convert_swizzle_premultiply_3210_3012, convert_swizzle_premultiply_0123_3012, convert_swizzle_premultiply_3012_3012 },
-  { convert_swizzle_premultiply_3210_0321, convert_swizzle_premultiply_0123_0321, convert_swizzle_premultiply_3012_0321 },
-  { convert_swizzle_opaque_3210, convert_swizzle_opaque_0123, convert_swizzle_opaque_3012 },
-  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321, convert_swizzle_opaque_3210 }
+  ConversionFunc func;
+  ConversionKind kind;
+  guint8 shuffle[4];
+  guint8 alpha;
+} Conversion;
+
+#define COPY \
+  { convert_memcpy, CONVERT_COPY, { 0, 1, 2, 3 }, 0 }
+#define SWIZZLED(A,R,G,B) \
+  { convert_swizzle ## A ## R ## G ## B, CONVERT_SWIZZLE, \
+    { [A] = 0, [R] = 1, [G] = 2, [B] = 3 }, A }
+#define SWIZZLED_OPAQUE(A,R,G,B) \
+  { convert_swizzle_opaque_ ## A ## R ## G ## B, CONVERT_SWIZZLE_OPAQUE, \
+    { [A] = 0x80, [R] = 0, [G] = 1, [B] = 2 }, A }
+#define SWIZZLED_PREMULTIPLIED(A,R,G,B, A2,R2,G2,B2) \
+  { convert_swizzle_premultiply_ ## A ## R ## G ## B ## _ ## A2 ## R2 ## G2 ## B2, CONVERT_SWIZZLE_PREMULTIPLY, \
+    { [A] = A2, [R] = R2, [G] = G2, [B] = B2 }, A }
+#define DEEP(NAME) \
+  { convert_ ## NAME ## _3210, CONVERT_DEEP, { 0, }, 3 }, \
+  { convert_ ## NAME ## _0123, CONVERT_DEEP, { 0, }, 0 }, \
+  { convert_ ## NAME ## _3012, CONVERT_DEEP, { 0, }, 3 }
+
+static const Conversion converters[GDK_MEMORY_N_FORMATS][3] =
+{
+  { COPY, SWIZZLED (3,2,1,0), SWIZZLED (2,1,0,3) },
+  { SWIZZLED (3,2,1,0), COPY, SWIZZLED (3,0,1,2) },
+  { SWIZZLED (2,1,0,3), SWIZZLED (1,2,3,0), COPY },
+  { SWIZZLED_PREMULTIPLIED (3,2,1,0, 3,2,1,0), SWIZZLED_PREMULTIPLIED (0,1,2,3, 3,2,1,0), SWIZZLED_PREMULTIPLIED (3,0,1,2, 3,2,1,0) },
+  { SWIZZLED_PREMULTIPLIED (3,2,1,0, 0,1,2,3), SWIZZLED_PREMULTIPLIED (0,1,2,3, 0,1,2,3), SWIZZLED_PREMULTIPLIED (3,0,1,2, 0,1,2,3) },
+  { SWIZZLED_PREMULTIPLIED (3,2,1,0, 3,0,1,2), SWIZZLED_PREMULTIPLIED (0,1,2,3, 3,0,1,2), SWIZZLED_PREMULTIPLIED (3,0,1,2, 3,0,1,2) },
+  { SWIZZLED_PREMULTIPLIED (3,2,1,0, 0,3,2,1), SWIZZLED_PREMULTIPLIED (0,1,2,3, 0,3,2,1), SWIZZLED_PREMULTIPLIED (3,0,1,2, 0,3,2,1) },
+  { SWIZZLED_OPAQUE (3,2,1,0), SWIZZLED_OPAQUE (0,1,2,3), SWIZZLED_OPAQUE (3,0,1,2) },
+  { SWIZZLED_OPAQUE (3,0,1,2), SWIZZLED_OPAQUE (0,3,2,1), SWIZZLED_OPAQUE (3,2,1,0) },
+  { DEEP (rgb16) },
+  { DEEP (rgba16) },
+  { DEEP (rgb16f) },
+  { DEEP (rgba16f) },
+  { DEEP (rgb32f) },
+  { DEEP (rgba32f) }
 };
 
+/* Vectorized kernels. They convert as many whole vectors of pixels
+ * as fit in each row and return how many columns they did, the scalar
+ * function takes care of the rest. The results are bit-identical to
+ * the scalar code.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_CONVERT_X86 1
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+#define HAVE_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef gsize (* ConvertRowsFunc) (const Conversion *conversion,
+                                   guchar           *dest_data,
+                                   gsize             dest_stride,
+                                   const guchar     *src_data,
+                                   gsize             src_stride,
+                                   gsize             width,
+                                   gsize             height);
+
+typedef struct
+{
+  const char *name;
+  ConvertRowsFunc convert;
+} ConvertImpl;
+
+static inline gsize
+conversion_bytes_per_pixel (const Conversion *conversion)
+{
+  return conversion->kind == CONVERT_SWIZZLE_OPAQUE ? 3 : 4;
+}
+
+/* The kernels load 16 bytes for every 4 pixels, which for 3 byte
+ * pixels reads 4 bytes past the last one, so they have to stop early.
+ */
+static inline gsize
+vector_columns (gsize width,
+                gsize bpp,
+                gsize n_pixels)
+{
+  if (bpp == 3)
+    width = width > 2 ? width - 2 : 0;
+
+  return width - width % n_pixels;
+}
+
+#if defined(HAVE_CONVERT_X86) || defined(HAVE_CONVERT_NEON)
+/* Masks for 4 pixels: the shuffle into destination order, the shuffle
+ * spreading each pixel's alpha over its color channels, and the alpha
+ * bytes to set. */
+static void
+init_masks (const Conversion *conversion,
+            guint8            shuffle[16],
+            guint8            alpha[16],
+            guint8            fill[16])
+{
+  const gsize bpp = conversion_bytes_per_pixel (conversion);
+  int p, i;
+
+  for (p = 0; p < 4; p++)
+    for (i = 0; i < 4; i++)
+      {
+        guint8 s = conversion->shuffle[i];
+
+        shuffle[4 * p + i] = s == 0x80 ? 0x80 : p * bpp + s;
+        alpha[4 * p + i] = i == conversion->alpha ? 0x80 : 4 * p + conversion->alpha;
+        fill[4 * p + i] = i == conversion->alpha ? 0xFF : 0;
+      }
+}
+#endif
+
+#ifdef HAVE_CONVERT_X86
+
+/* Same rounding as PREMULTIPLY() */
+__attribute__((target ("ssse3")))
+static inline __m128i
+premultiply_sse2 (__m128i v,
+                  __m128i a)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i half = _mm_set1_epi16 (0x80);
+  __m128i lo, hi;
+
+  lo = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpacklo_epi8 (v, zero), _mm_unpacklo_epi8 (a, zero)), half);
+  hi = _mm_add_epi16 (_mm_mullo_epi16 (_mm_unpackhi_epi8 (v, zero), _mm_unpackhi_epi8 (a, zero)), half);
+  lo = _mm_srli_epi16 (_mm_add_epi16 (lo, _mm_srli_epi16 (lo, 8)), 8);
+  hi = _mm_srli_epi16 (_mm_add_epi16 (hi, _mm_srli_epi16 (hi, 8)), 8);
+
+  return _mm_packus_epi16 (lo, hi);
+}
+
+__attribute__((target ("ssse3")))
+static gsize
+convert_rows_ssse3 (const Conversion *conversion,
+                    guchar           *dest_data,
+                    gsize             dest_stride,
+                    const guchar     *src_data,
+                    gsize             src_stride,
+                    gsize             width,
+                    gsize             height)
+{
+  const gsize bpp = conversion_bytes_per_pixel (conversion);
+  const gsize n = vector_columns (width, bpp, 4);
+  guint8 masks[3][16];
+  __m128i shuffle, alpha, fill;
+  gsize x, y;
+
+  init_masks (conversion, masks[0], masks[1], masks[2]);
+  shuffle = _mm_loadu_si128 ((const __m128i *) masks[0]);
+  alpha = _mm_loadu_si128 ((const __m128i *) masks[1]);
+  fill = _mm_loadu_si128 ((const __m128i *) masks[2]);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < n; x += 4)
+        {
+          __m128i v = _mm_loadu_si128 ((const __m128i *) (src_data + x * bpp));
+
+          v = _mm_shuffle_epi8 (v, shuffle);
+          if (conversion->kind == CONVERT_SWIZZLE_OPAQUE)
+            v = _mm_or_si128 (v, fill);
+          else if (conversion->kind == CONVERT_SWIZZLE_PREMULTIPLY)
+            v = premultiply_sse2 (v, _mm_or_si128 (_mm_shuffle_epi8 (v, alpha), fill));
+
+          _mm_storeu_si128 ((__m128i *) (dest_data + x * 4), v);
+        }
+
+      dest_data += dest_stride;
+      src_data += src_stride;
+    }
+
+  return n;
+}
+
+__attribute__((target ("avx2")))
+static inline __m256i
+premultiply_avx2 (__m256i v,
+                  __m256i a)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i half = _mm256_set1_epi16 (0x80);
+  __m256i lo, hi;
+
+  lo = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpacklo_epi8 (v, zero), _mm256_unpacklo_epi8 (a, zero)), half);
+  hi = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpackhi_epi8 (v, zero), _mm256_unpackhi_epi8 (a, zero)), half);
+  lo = _mm256_srli_epi16 (_mm256_add_epi16 (lo, _mm256_srli_epi16 (lo, 8)), 8);
+  hi = _mm256_srli_epi16 (_mm256_add_epi16 (hi, _mm256_srli_epi16 (hi, 8)), 8);
+
+  /* unpack and pack both work within 128 bit lanes, so this is in order */
+  return _mm256_packus_epi16 (lo, hi);
+}
+
+__attribute__((target ("avx2")))
+static gsize
+convert_rows_avx2 (const Conversion *conversion,
+                   guchar           *dest_data,
+                   gsize             dest_stride,
+                   const guchar     *src_data,
+                   gsize             src_stride,
+                   gsize             width,
+                   gsize             height)
+{
+  const gsize bpp = conversion_bytes_per_pixel (conversion);
+  const gsize n = vector_columns (width, bpp, 8);
+  guint8 masks[3][16];
+  __m256i shuffle, alpha, fill;
+  gsize x, y;
+
+  init_masks (conversion, masks[0], masks[1], masks[2]);
+  shuffle = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) masks[0]));
+  alpha = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) masks[1]));
+  fill = _mm256_broadcastsi128_si256 (_mm_loadu_si128 ((const __m128i *) masks[2]));
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < n; x += 8)
+        {
+          const guchar *src = src_data + x * bpp;
+          __m256i v;
+
+          /* Shuffles can't cross lanes, so each lane gets its own 4 pixels */
+          if (bpp == 3)
+            v = _mm256_inserti128_si256 (_mm256_castsi128_si256 (_mm_loadu_si128 ((const __m128i *) src)),
+                                         _mm_loadu_si128 ((const __m128i *) (src + 12)), 1);
+          else
+            v = _mm256_loadu_si256 ((const __m256i *) src);
+
+          v = _mm256_shuffle_epi8 (v, shuffle);
+          if (conversion->kind == CONVERT_SWIZZLE_OPAQUE)
+            v = _mm256_or_si256 (v, fill);
+          else if (conversion->kind == CONVERT_SWIZZLE_PREMULTIPLY)
+            v = premultiply_avx2 (v, _mm256_or_si256 (_mm256_shuffle_epi8 (v, alpha), fill));
+
+          _mm256_storeu_si256 ((__m256i *) (dest_data + x * 4), v);
+        }
+
+      dest_data += dest_stride;
+      src_data += src_stride;
+    }
+
+  return n;
+}
+
+#endif /* HAVE_CONVERT_X86 */
+
+#ifdef HAVE_CONVERT_NEON
+
+static gsize
+convert_rows_neon (const Conversion *conversion,
+                   guchar           *dest_data,
+                   gsize             dest_stride,
+                   const guchar     *src_data,
+                   gsize             src_stride,
+                   gsize             width,
+                   gsize             height)
+{
+  const gsize bpp = conversion_bytes_per_pixel (conversion);
+  const gsize n = vector_columns (width, bpp, 4);
+  const uint16x8_t half = vdupq_n_u16 (0x80);
+  guint8 masks[3][16];
+  uint8x16_t shuffle, alpha, fill;
+  gsize x, y;
+
+  init_masks (conversion, masks[0], masks[1], masks[2]);
+  shuffle = vld1q_u8 (masks[0]);
+  alpha = vld1q_u8 (masks[1]);
+  fill = vld1q_u8 (masks[2]);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < n; x += 4)
+        {
+          uint8x16_t v = vld1q_u8 (src_data + x * bpp);
+
+          /* Out of range indices like 0x80 give 0, as with pshufb */
+          v = vqtbl1q_u8 (v, shuffle);
+          if (conversion->kind == CONVERT_SWIZZLE_OPAQUE)
+            {
+              v = vorrq_u8 (v, fill);
+            }
+          else if (conversion->kind == CONVERT_SWIZZLE_PREMULTIPLY)
+            {
+              uint8x16_t a = vorrq_u8 (vqtbl1q_u8 (v, alpha), fill);
+              uint16x8_t lo = vmlal_u8 (half, vget_low_u8 (v), vget_low_u8 (a));
+              uint16x8_t hi = vmlal_high_u8 (half, v, a);
+
+              lo = vsraq_n_u16 (lo, lo, 8);
+              hi = vsraq_n_u16 (hi, hi, 8);
+              v = vcombine_u8 (vshrn_n_u16 (lo, 8), vshrn_n_u16 (hi, 8));
+            }
+
+          vst1q_u8 (dest_data + x * 4, v);
+        }
+
+      dest_data += dest_stride;
+      src_data += src_stride;
+    }
+
+  return n;
+}
+
+#endif /* HAVE_CONVERT_NEON */
+
+static const ConvertImpl *
+get_convert_impl (void)
+{
+  static const ConvertImpl *impl;
+
+  if (g_once_init_enter (&impl))
+    {
+      static const ConvertImpl impls[] = {
+        { "scalar", NULL },
+#ifdef HAVE_CONVERT_X86
+        { "ssse3", convert_rows_ssse3 },
+        { "avx2", convert_rows_avx2 },
+#endif
+#ifdef HAVE_CONVERT_NEON
+        { "neon", convert_rows_neon },
+#endif
+      };
+      const ConvertImpl *result = &impls[0];
+
+#ifdef HAVE_CONVERT_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+        result = &impls[2];
+      else if (__builtin_cpu_supports ("ssse3"))
+        result = &impls[1];
+#endif
+#ifdef HAVE_CONVERT_NEON
+      result = &impls[1];
+#endif
+
+      g_once_init_leave (&impl, result);
+    }
+
+  return impl;
+}
+
 void
 gdk_memory_convert (guchar          *dest_data,
                     gsize            dest_stride,
@@ -306,8 +800,37 @@ gdk_memory_convert (guchar          *dest_data,
                     gsize            width,
                     gsize            height)
 {
+  const Conversion *conversion;
+  const ConvertImpl *impl;
+  gsize done = 0;
+
   g_assert (dest_format < 3);
   g_assert (src_format < GDK_MEMORY_N_FORMATS);
 
-  converters[src_format][dest_format] (dest_data, dest_stride, src_data, src_stride, width, height);
+  conversion = &converters[src_format][dest_format];
+  impl = get_convert_impl ();
+
+  if (impl->convert != NULL &&
+      conversion->kind != CONVERT_COPY &&
+      conversion->kind != CONVERT_DEEP)
+    done = impl->convert (conversion, dest_data, dest_stride, src_data, src_stride, width, height);
+
+  if (done < width)
+    conversion->func (dest_data + 4 * done, dest_stride,
+                      src_data + conversion_bytes_per_pixel (conversion) * done, src_stride,
+                      width - done, height);
+}
+
+/*<private>
+ * gdk_memory_convert_get_implementation:
+ *
+ * Gets the name of the pixel conversion kernels that were picked
+ * for this CPU.
+ *
+ * Returns: the name of the implementation
+ */
+const char *
+gdk_memory_convert_get_implementation (void)
+{
+  return get_convert_impl ()->name;
 }
@@ -32,6 +32,8 @@ G_BEGIN_DECLS
 #define GDK_MEMORY_CAIRO_FORMAT_ARGB32 GDK_MEMORY_DEFAULT
 
 gsize                   gdk_memory_format_bytes_per_pixel   (GdkMemoryFormat    format);
+gboolean                gdk_memory_format_is_deep           (GdkMemoryFormat    format);
+gboolean                gdk_memory_format_is_opaque         (GdkMemoryFormat    format);
 
 GdkMemoryFormat         gdk_memory_texture_get_format       (GdkMemoryTexture  *self);
 const guchar *          gdk_memory_texture_get_data         (GdkMemoryTexture  *self);
@@ -45,6 +47,7 @@ void                    gdk_memory_convert                  (guchar            *
                                                              GdkMemoryFormat    src_format,
                                                              gsize              width,
                                                              gsize              height);
+const char *            gdk_memory_convert_get_implementation (void);
 
 
 G_END_DECLS
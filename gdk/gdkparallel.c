@@ -0,0 +1,260 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * gdkparallel.c: The thread pool shared by GDK, GSK and GTK
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkparallelprivate.h"
+
+/* All work that is split over threads goes through one pool, with a
+ * thread less than there are processors, since the calling thread
+ * works too. Separate pools per user would each be sized for the
+ * whole machine and oversubscribe it when they are busy at once.
+ *
+ * A thread that waits for a task that no pool thread has picked up
+ * yet runs it itself. So waiting never depends on free pool threads,
+ * and jobs may use the pool themselves, like the tiles of the cairo
+ * renderer rendering glyphs.
+ */
+
+typedef enum {
+  TASK_PENDING,
+  TASK_RUNNING,
+  TASK_DONE
+} TaskState;
+
+struct _GdkParallelTask
+{
+  GdkParallelBatch *batch;
+  gpointer job;
+  int state; /* TaskState, atomic */
+};
+
+struct _GdkParallelBatch
+{
+  int ref_count; /* atomic, one for the owner and one per queued task */
+  GMutex mutex;
+  GCond cond;
+  GdkParallelFunc func;
+  gpointer user_data;
+  GPtrArray *tasks; /* only touched by the owner */
+};
+
+static void
+gdk_parallel_batch_unref (GdkParallelBatch *batch)
+{
+  if (!g_atomic_int_dec_and_test (&batch->ref_count))
+    return;
+
+  g_ptr_array_free (batch->tasks, TRUE);
+  g_mutex_clear (&batch->mutex);
+  g_cond_clear (&batch->cond);
+  g_slice_free (GdkParallelBatch, batch);
+}
+
+/* Runs @task unless another thread already claimed it */
+static gboolean
+gdk_parallel_task_run (GdkParallelTask *task)
+{
+  GdkParallelBatch *batch = task->batch;
+
+  if (!g_atomic_int_compare_and_exchange (&task->state, TASK_PENDING, TASK_RUNNING))
+    return FALSE;
+
+  batch->func (task->job, batch->user_data);
+
+  g_mutex_lock (&batch->mutex);
+  g_atomic_int_set (&task->state, TASK_DONE);
+  g_cond_broadcast (&batch->cond);
+  g_mutex_unlock (&batch->mutex);
+
+  return TRUE;
+}
+
+static void
+gdk_parallel_pool_func (gpointer data,
+                        gpointer user_data)
+{
+  GdkParallelTask *task = data;
+  GdkParallelBatch *batch = task->batch;
+
+  gdk_parallel_task_run (task);
+  gdk_parallel_batch_unref (batch);
+}
+
+static GThreadPool *
+get_pool (void)
+{
+  static GThreadPool *pool;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (gdk_parallel_pool_func, NULL,
+                                    MAX (1, (int) gdk_parallel_get_n_threads () - 1),
+                                    FALSE, NULL);
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+/**
+ * gdk_parallel_get_n_threads:
+ *
+ * Returns the number of threads that work on a batch, counting the
+ * calling thread. Work should be split into at least this many jobs
+ * to use them all. If it is 1, there is no point in splitting.
+ *
+ * Returns: the number of threads
+ */
+guint
+gdk_parallel_get_n_threads (void)
+{
+  return g_get_num_processors ();
+}
+
+/**
+ * gdk_parallel_batch_new:
+ * @func: the function to call for every job
+ * @user_data: data to pass to @func
+ *
+ * Creates a batch of jobs for the shared thread pool. The owner pushes
+ * jobs with gdk_parallel_batch_push() and must end the batch with
+ * gdk_parallel_batch_finish().
+ *
+ * Returns: a new batch
+ */
+GdkParallelBatch *
+gdk_parallel_batch_new (GdkParallelFunc func,
+                        gpointer        user_data)
+{
+  GdkParallelBatch *batch;
+
+  batch = g_slice_new (GdkParallelBatch);
+  batch->ref_count = 1;
+  g_mutex_init (&batch->mutex);
+  g_cond_init (&batch->cond);
+  batch->func = func;
+  batch->user_data = user_data;
+  batch->tasks = g_ptr_array_new_with_free_func (g_free);
+
+  return batch;
+}
+
+/**
+ * gdk_parallel_batch_push:
+ * @batch: a #GdkParallelBatch
+ * @job: the job to pass to the function of @batch
+ *
+ * Queues @job on the shared thread pool. @job must stay valid until
+ * it was waited for.
+ *
+ * Returns: (transfer none): the task to wait for the job with,
+ *   owned by @batch
+ */
+GdkParallelTask *
+gdk_parallel_batch_push (GdkParallelBatch *batch,
+                         gpointer          job)
+{
+  GdkParallelTask *task;
+
+  task = g_new (GdkParallelTask, 1);
+  task->batch = batch;
+  task->job = job;
+  task->state = TASK_PENDING;
+  g_ptr_array_add (batch->tasks, task);
+
+  g_atomic_int_inc (&batch->ref_count);
+  g_thread_pool_push (get_pool (), task, NULL);
+
+  return task;
+}
+
+/**
+ * gdk_parallel_task_wait:
+ * @task: a #GdkParallelTask
+ *
+ * Waits until the job of @task is done. If no thread has started it
+ * yet, it is run on the calling thread.
+ */
+void
+gdk_parallel_task_wait (GdkParallelTask *task)
+{
+  GdkParallelBatch *batch = task->batch;
+
+  if (gdk_parallel_task_run (task))
+    return;
+
+  g_mutex_lock (&batch->mutex);
+  while (g_atomic_int_get (&task->state) != TASK_DONE)
+    g_cond_wait (&batch->cond, &batch->mutex);
+  g_mutex_unlock (&batch->mutex);
+}
+
+/**
+ * gdk_parallel_batch_finish:
+ * @batch: (transfer full): a #GdkParallelBatch
+ *
+ * Waits for all jobs of @batch and frees it.
+ */
+void
+gdk_parallel_batch_finish (GdkParallelBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->tasks->len; i++)
+    gdk_parallel_task_wait (g_ptr_array_index (batch->tasks, i));
+
+  gdk_parallel_batch_unref (batch);
+}
+
+/**
+ * gdk_parallel_run:
+ * @jobs: an array of @n_jobs jobs
+ * @job_size: the size of one job in @jobs
+ * @n_jobs: the number of jobs
+ * @func: the function to call for every job
+ * @user_data: data to pass to @func
+ *
+ * Calls @func for every job in @jobs, spread over the shared thread
+ * pool, and returns when all of them are done. The calling thread
+ * runs the first job and helps with the others.
+ */
+void
+gdk_parallel_run (gpointer        jobs,
+                  gsize           job_size,
+                  guint           n_jobs,
+                  GdkParallelFunc func,
+                  gpointer        user_data)
+{
+  GdkParallelBatch *batch;
+  guint i;
+
+  if (n_jobs == 0)
+    return;
+
+  batch = gdk_parallel_batch_new (func, user_data);
+
+  for (i = 1; i < n_jobs; i++)
+    gdk_parallel_batch_push (batch, (guchar *) jobs + i * job_size);
+
+  func (jobs, user_data);
+
+  gdk_parallel_batch_finish (batch);
+}
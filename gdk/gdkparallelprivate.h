@@ -0,0 +1,47 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_PARALLEL_PRIVATE_H__
+#define __GDK_PARALLEL_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GdkParallelBatch GdkParallelBatch;
+typedef struct _GdkParallelTask GdkParallelTask;
+
+typedef void (* GdkParallelFunc) (gpointer job,
+                                  gpointer user_data);
+
+guint              gdk_parallel_get_n_threads   (void);
+
+GdkParallelBatch * gdk_parallel_batch_new       (GdkParallelFunc   func,
+                                                 gpointer          user_data);
+GdkParallelTask *  gdk_parallel_batch_push      (GdkParallelBatch *batch,
+                                                 gpointer          job);
+void               gdk_parallel_task_wait       (GdkParallelTask  *task);
+void               gdk_parallel_batch_finish    (GdkParallelBatch *batch);
+
+void               gdk_parallel_run             (gpointer          jobs,
+                                                 gsize             job_size,
+                                                 guint             n_jobs,
+                                                 GdkParallelFunc   func,
+                                                 gpointer          user_data);
+
+G_END_DECLS
+
+#endif /* __GDK_PARALLEL_PRIVATE_H__ */
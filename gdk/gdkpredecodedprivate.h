@@ -0,0 +1,49 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_PREDECODED_PRIVATE_H__
+#define __GDK_PREDECODED_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Images we ship as resources can be accompanied by a predecoded
+ * copy, stored under the image's path with GDK_PREDECODED_SUFFIX
+ * appended. It is made by gdk-image-predecode during the build.
+ *
+ * The header is followed by the pixels, premultiplied and in the
+ * native byte order of cairo's ARGB32, which is GDK_MEMORY_DEFAULT.
+ * Since it is made during the build, the byte order of the build
+ * machine is the one that is used.
+ *
+ * This header is used by the build tool too, so it must only
+ * depend on GLib.
+ */
+
+#define GDK_PREDECODED_SUFFIX ".predecoded"
+#define GDK_PREDECODED_MAGIC "GdkPix01"
+
+typedef struct {
+  char magic[8];
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 reserved; /* keeps the pixels 8-byte aligned */
+} GdkPredecodedHeader;
+
+G_END_DECLS
+
+#endif /* __GDK_PREDECODED_PRIVATE_H__ */
@@ -33,9 +33,19 @@
 #include "gdkframeclockprivate.h"
 
 
+/* Marks can be added from other threads, e.g. while snapshotting,
+ * so the mark func needs to be thread-safe. It is only set and
+ * unset from the main thread.
+ */
+static GdkProfilerMarkFunc mark_func;
+static gpointer mark_func_data;
+
 gboolean
 gdk_profiler_is_running (void)
 {
+  if (mark_func != NULL)
+    return TRUE;
+
 #ifdef HAVE_SYSPROF
   return sysprof_collector_is_active ();
 #else
@@ -43,54 +53,111 @@ gdk_profiler_is_running (void)
 #endif
 }
 
+/*
+ * gdk_profiler_set_mark_func:
+ * @func: (nullable): function to call for every mark
+ * @user_data: data to pass to @func
+ *
+ * Sets a function that gets all marks, in addition to sysprof.
+ * This is used by the inspector to show where the time of a
+ * frame went.
+ */
 void
-(gdk_profiler_add_mark) (gint64      begin_time,
-                         gint64      duration,
-                         const char *name,
-                         const char *message)
+gdk_profiler_set_mark_func (GdkProfilerMarkFunc func,
+                            gpointer            user_data)
+{
+  mark_func = func;
+  mark_func_data = user_data;
+}
+
+/* Whether a mark func is set. Marks that are too fine-grained for
+ * sysprof captures, such as one per widget, are only added then.
+ */
+gboolean
+gdk_profiler_is_collecting (void)
+{
+  return mark_func != NULL;
+}
+
+static void
+gdk_profiler_mark (gint64      begin_time,
+                   gint64      duration,
+                   const char *name,
+                   const char *message)
 {
 #ifdef HAVE_SYSPROF
   sysprof_collector_mark (begin_time, duration, "gtk", name, message);
 #endif
+
+  if (mark_func)
+    mark_func (begin_time, duration, name, message, mark_func_data);
+}
+
+static void
+gdk_profiler_mark_valist (gint64      begin_time,
+                          gint64      duration,
+                          const char *name,
+                          const char *message_format,
+                          va_list     args)
+{
+  char *message;
+
+  if (!GDK_PROFILER_IS_RUNNING)
+    return;
+
+  message = g_strdup_vprintf (message_format, args);
+  gdk_profiler_mark (begin_time, duration, name, message);
+  g_free (message);
 }
 
 void
-(gdk_profiler_end_mark) (gint64      begin_time,
-                         const char *name,
-                         const char *message)
+gdk_profiler_add_mark (gint64      begin_time,
+                       gint64      duration,
+                       const char *name,
+                       const char *message)
 {
-#ifdef HAVE_SYSPROF
-  sysprof_collector_mark (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, "gtk", name, message);
-#endif
+  if (!GDK_PROFILER_IS_RUNNING)
+    return;
+
+  gdk_profiler_mark (begin_time, duration, name, message);
 }
 
 void
-(gdk_profiler_add_markf) (gint64       begin_time,
-                          gint64       duration,
-                          const gchar *name,
-                          const gchar *message_format,
-                          ...)
+gdk_profiler_end_mark (gint64      begin_time,
+                       const char *name,
+                       const char *message)
+{
+  if (!GDK_PROFILER_IS_RUNNING)
+    return;
+
+  gdk_profiler_mark (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, name, message);
+}
+
+void
+gdk_profiler_add_markf (gint64       begin_time,
+                        gint64       duration,
+                        const gchar *name,
+                        const gchar *message_format,
+                        ...)
 {
-#ifdef HAVE_SYSPROF
   va_list args;
+
   va_start (args, message_format);
-  sysprof_collector_mark_vprintf (begin_time, duration, "gtk", name, message_format, args);
+  gdk_profiler_mark_valist (begin_time, duration, name, message_format, args);
   va_end (args);
-#endif  /* HAVE_SYSPROF */
 }
 
 void
-(gdk_profiler_end_markf) (gint64       begin_time,
-                          const gchar *name,
-                          const gchar *message_format,
-                          ...)
+gdk_profiler_end_markf (gint64       begin_time,
+                        const gchar *name,
+                        const gchar *message_format,
+                        ...)
 {
-#ifdef HAVE_SYSPROF
   va_list args;
+
   va_start (args, message_format);
-  sysprof_collector_mark_vprintf (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, "gtk", name, message_format, args);
+  gdk_profiler_mark_valist (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, name, message_format, args);
   va_end (args);
-#endif  /* HAVE_SYSPROF */
 }
 
 guint
@@ -32,16 +32,29 @@
 
 G_BEGIN_DECLS
 
-#ifdef HAVE_SYSPROF
+/* Marks go to sysprof when it is running, and to the mark func
+ * when one is set, so they are available without sysprof too.
+ * Counters only go to sysprof.
+ */
 #define GDK_PROFILER_IS_RUNNING (gdk_profiler_is_running ())
+#ifdef HAVE_SYSPROF
 #define GDK_PROFILER_CURRENT_TIME SYSPROF_CAPTURE_CURRENT_TIME
 #else
-#define GDK_PROFILER_IS_RUNNING 0
-#define GDK_PROFILER_CURRENT_TIME 0
+#define GDK_PROFILER_CURRENT_TIME (g_get_monotonic_time () * 1000)
 #endif
 
 gboolean gdk_profiler_is_running (void);
 
+typedef void (* GdkProfilerMarkFunc) (gint64      begin_time,
+                                      gint64      duration,
+                                      const char *name,
+                                      const char *message,
+                                      gpointer    user_data);
+
+void     gdk_profiler_set_mark_func  (GdkProfilerMarkFunc func,
+                                      gpointer            user_data);
+gboolean gdk_profiler_is_collecting  (void);
+
 /* Note: Times and durations are in nanoseconds;
  * g_get_monotonic_time(), and GdkFrameClock times
  * are in microseconds, so multiply by 1000.
@@ -73,19 +86,6 @@ void    gdk_profiler_set_int_counter    (guint  id,
                                          gint64 value);
 
 #ifndef HAVE_SYSPROF
-#define gdk_profiler_add_mark(b, d, n, m)
-#define gdk_profiler_end_mark(b, n, m)
-/* Optimise the whole call out */
-#if defined(G_HAVE_ISO_VARARGS)
-#define gdk_profiler_add_markf(b, d, n, m, ...)
-#define gdk_profiler_end_markf(b, n, m, ...)
-#elif defined(G_HAVE_GNUC_VARARGS)
-#define gdk_profiler_add_markf(b, d, n, m...)
-#define gdk_profiler_end_markf(b, n, m...)
-#else
-/* no varargs macro support; the call will have to be optimised out by the compiler */
-#endif
-
 #define gdk_profiler_define_counter(n, d) 0
 #define gdk_profiler_define_int_counter(n, d) 0
 #define gdk_profiler_set_counter(i, v)
@@ -2369,6 +2369,7 @@ gdk_surface_flush_events (GdkFrameClock *clock,
   GdkSurface *surface = GDK_SURFACE (data);
 
   _gdk_event_queue_flush (surface->display);
+  _gdk_display_end_event_frame (surface->display);
   gdk_surface_ensure_motion (surface);
   _gdk_display_pause_events (surface->display);
 
@@ -2570,6 +2571,38 @@ gdk_surface_set_opaque_region (GdkSurface      *surface,
     class->set_opaque_region (surface, region);
 }
 
+/*< private >
+ * gdk_surface_offload_texture:
+ * @surface: a #GdkSurface
+ * @texture: (nullable): the texture to show
+ * @area: (nullable): where to show @texture, in surface coordinates
+ *
+ * Asks the windowing system to show @texture in @area, on top of the
+ * contents of @surface, without compositing it into them. This lets
+ * the compositor scan out video frames and the like directly.
+ *
+ * Passing %NULL for @texture stops showing a previous texture.
+ *
+ * Returns: %TRUE if @texture is shown, %FALSE if the caller needs
+ *   to draw it
+ */
+gboolean
+gdk_surface_offload_texture (GdkSurface         *surface,
+                             GdkTexture         *texture,
+                             const GdkRectangle *area)
+{
+  GdkSurfaceClass *class;
+
+  g_return_val_if_fail (GDK_IS_SURFACE (surface), FALSE);
+  g_return_val_if_fail (texture == NULL || area != NULL, FALSE);
+
+  class = GDK_SURFACE_GET_CLASS (surface);
+  if (class->offload_texture == NULL || GDK_SURFACE_DESTROYED (surface))
+    return texture == NULL;
+
+  return class->offload_texture (surface, texture, area);
+}
+
 /**
  * gdk_surface_set_shadow_width:
  * @surface: a #GdkSurface
@@ -2716,7 +2749,6 @@ add_event_mark (GdkEvent *event,
                 gint64    time,
                 gint64    end_time)
 {
-#ifdef HAVE_SYSPROF
   char *message = NULL;
   const char *kind;
   GEnumClass *class;
@@ -2808,7 +2840,6 @@ add_event_mark (GdkEvent *event,
   gdk_profiler_add_mark (time, end_time - time, "event", message ? message : kind);
 
   g_free (message);
-#endif
 }
 
 gboolean
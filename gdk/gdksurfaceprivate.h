@@ -169,6 +169,9 @@ struct _GdkSurfaceClass
                                            gboolean        attached,
                                            GdkGLContext   *share,
                                            GError        **error);
+  gboolean     (* offload_texture)        (GdkSurface         *surface,
+                                           GdkTexture         *texture,
+                                           const GdkRectangle *area);
 };
 
 #define GDK_SURFACE_DESTROYED(d) (((GdkSurface *)(d))->destroyed)
@@ -258,6 +261,9 @@ void       gdk_surface_invalidate_rect    (GdkSurface           *surface,
                                            const GdkRectangle   *rect);
 void       gdk_surface_invalidate_region  (GdkSurface           *surface,
                                            const cairo_region_t *region);
+gboolean   gdk_surface_offload_texture    (GdkSurface           *surface,
+                                           GdkTexture           *texture,
+                                           const GdkRectangle   *area);
 void       _gdk_surface_clear_update_area (GdkSurface      *surface);
 void       _gdk_surface_update_size       (GdkSurface      *surface);
 
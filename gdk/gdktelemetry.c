@@ -0,0 +1,412 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * gdktelemetry.c: An always-on record of recent frame timings
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdktelemetryprivate.h"
+
+#include "gdkprofilerprivate.h"
+
+#ifdef G_OS_UNIX
+#include <glib-unix.h>
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+#ifdef HAVE_EXECINFO_H
+#include <execinfo.h>
+#endif
+
+/* Unlike the profiler, this is meant to be running all the time, so
+ * that a misbehaving application can be asked what happened in the
+ * last seconds. Recording an entry takes an atomic increment and a
+ * few stores into a fixed ring, and nothing is ever allocated.
+ *
+ * Entries may be written from several threads. Each entry carries
+ * the serial it was written with, and is cleared to 0 while being
+ * written, so a reader can tell torn or stale entries apart.
+ */
+
+#define RING_SIZE 4096 /* must be a power of 2 */
+#define KEEP_TIME (10 * G_USEC_PER_SEC)
+
+typedef struct
+{
+  gint64 begin_time;
+  gint64 duration;
+  gint64 detail;
+  guint kind;
+  guint serial;
+} Entry;
+
+static Entry ring[RING_SIZE];
+static guint ring_serial;
+
+static const struct {
+  const char *name;
+  const char *detail;
+  gint64 threshold;
+} kinds[] = {
+  [GDK_TELEMETRY_FRAME] = { "frame", "counter", 0 },
+  [GDK_TELEMETRY_MAIN_LOOP] = { "main loop iteration", NULL, 20 * 1000 },
+  [GDK_TELEMETRY_EVENT] = { "event", "type", 8 * 1000 },
+  [GDK_TELEMETRY_STYLE] = { "style recompute", "nodes", 2 * 1000 },
+  [GDK_TELEMETRY_TEXTURE_UPLOAD] = { "texture upload", "bytes", 4 * 1000 },
+};
+
+G_STATIC_ASSERT (G_N_ELEMENTS (kinds) == GDK_TELEMETRY_N_KINDS);
+
+void
+gdk_telemetry_record (GdkTelemetryKind kind,
+                      gint64           begin_time,
+                      gint64           duration,
+                      gint64           detail)
+{
+  guint serial;
+  Entry *entry;
+
+  if (duration < kinds[kind].threshold)
+    return;
+
+  serial = (guint) g_atomic_int_add (&ring_serial, 1) + 1;
+  if (serial == 0)
+    serial = (guint) g_atomic_int_add (&ring_serial, 1) + 1;
+
+  entry = &ring[serial & (RING_SIZE - 1)];
+
+  g_atomic_int_set (&entry->serial, 0);
+  entry->begin_time = begin_time;
+  entry->duration = duration;
+  entry->detail = detail;
+  entry->kind = kind;
+  g_atomic_int_set (&entry->serial, serial);
+}
+
+void
+gdk_telemetry_end (GdkTelemetryKind kind,
+                   gint64           begin_time,
+                   gint64           detail)
+{
+  gdk_telemetry_record (kind, begin_time, g_get_monotonic_time () - begin_time, detail);
+}
+
+/* Main loop iterations are measured from the moment poll() returns
+ * until it is called again, so time spent waiting does not count.
+ */
+static GPollFunc default_poll_func;
+static gint64 iteration_start;
+static gboolean watchdog_running;
+
+static void watchdog_iteration_end   (void);
+static void watchdog_iteration_start (gint64 now);
+
+static int
+gdk_telemetry_poll (GPollFD *fds,
+                    guint    nfds,
+                    int      timeout)
+{
+  int result;
+
+  if (iteration_start != 0)
+    gdk_telemetry_end (GDK_TELEMETRY_MAIN_LOOP, iteration_start, 0);
+
+  if (watchdog_running)
+    watchdog_iteration_end ();
+
+  result = default_poll_func (fds, nfds, timeout);
+
+  iteration_start = g_get_monotonic_time ();
+
+  if (watchdog_running)
+    watchdog_iteration_start (iteration_start);
+
+  return result;
+}
+
+void
+gdk_telemetry_init (void)
+{
+  if (default_poll_func != NULL)
+    return;
+
+  default_poll_func = g_main_context_get_poll_func (NULL);
+  g_main_context_set_poll_func (NULL, gdk_telemetry_poll);
+}
+
+static int
+compare_entries (gconstpointer a,
+                 gconstpointer b)
+{
+  const Entry *ea = a;
+  const Entry *eb = b;
+
+  if (ea->begin_time < eb->begin_time)
+    return -1;
+  if (ea->begin_time > eb->begin_time)
+    return 1;
+
+  return 0;
+}
+
+/* The watchdog is a thread that wakes up regularly and checks whether
+ * the main thread has been busy for longer than the deadline, which
+ * means no frame could be drawn in that time. If so, it interrupts
+ * the main thread with SIGUSR1 to capture its backtrace and the name
+ * of the source being dispatched. The stall is reported once the
+ * main thread gets back to polling.
+ */
+#if defined(G_OS_UNIX) && defined(HAVE_EXECINFO_H)
+#define WATCHDOG_DEADLINE (200 * 1000)
+#define WATCHDOG_MAX_FRAMES 64
+
+static GMutex watchdog_lock;
+static gint64 busy_since; /* 0 while polling */
+static gboolean stall_signalled;
+static pthread_t main_thread;
+
+/* Written by the signal handler on the main thread */
+static volatile sig_atomic_t stall_captured;
+static void *stall_frames[WATCHDOG_MAX_FRAMES];
+static int n_stall_frames;
+static char stall_source[64];
+
+static void
+watchdog_capture (int signum)
+{
+  GSource *source;
+  const char *name = NULL;
+
+  n_stall_frames = backtrace (stall_frames, WATCHDOG_MAX_FRAMES);
+
+  /* Only reads thread-local and source fields, no locks */
+  source = g_main_current_source ();
+  if (source)
+    name = g_source_get_name (source);
+  g_strlcpy (stall_source, name ? name : "unnamed source", sizeof (stall_source));
+
+  stall_captured = 1;
+}
+
+static void
+watchdog_iteration_start (gint64 now)
+{
+  g_mutex_lock (&watchdog_lock);
+  busy_since = now;
+  stall_signalled = FALSE;
+  g_mutex_unlock (&watchdog_lock);
+}
+
+static void
+watchdog_iteration_end (void)
+{
+  gint64 begin_time;
+  gint64 duration;
+
+  g_mutex_lock (&watchdog_lock);
+  begin_time = busy_since;
+  busy_since = 0;
+  g_mutex_unlock (&watchdog_lock);
+
+  if (!stall_captured)
+    return;
+
+  duration = g_get_monotonic_time () - begin_time;
+
+  gdk_profiler_add_mark (begin_time * 1000, duration * 1000, "main loop stall", stall_source);
+
+  g_printerr ("Main loop stalled for %" G_GINT64_FORMAT " ms in %s:\n",
+              duration / 1000, stall_source);
+  backtrace_symbols_fd (stall_frames, n_stall_frames, 2);
+
+  stall_captured = 0;
+}
+
+static gpointer
+watchdog_thread_func (gpointer data)
+{
+  while (TRUE)
+    {
+      g_usleep (WATCHDOG_DEADLINE / 4);
+
+      g_mutex_lock (&watchdog_lock);
+      if (busy_since != 0 && !stall_signalled &&
+          g_get_monotonic_time () - busy_since > WATCHDOG_DEADLINE)
+        {
+          stall_signalled = TRUE;
+          pthread_kill (main_thread, SIGUSR1);
+        }
+      g_mutex_unlock (&watchdog_lock);
+    }
+
+  return NULL;
+}
+
+/*< private >
+ * gdk_telemetry_start_watchdog:
+ *
+ * Starts watching the main thread for iterations of the main loop that
+ * take longer than 200 ms, and prints their backtrace to stderr. Must
+ * be called from the main thread, after gdk_telemetry_init().
+ */
+void
+gdk_telemetry_start_watchdog (void)
+{
+  struct sigaction action = { 0, };
+
+  if (watchdog_running)
+    return;
+
+  /* The first backtrace() call may load libgcc, which is not
+   * something to do in a signal handler.
+   */
+  n_stall_frames = backtrace (stall_frames, WATCHDOG_MAX_FRAMES);
+
+  action.sa_handler = watchdog_capture;
+  action.sa_flags = SA_RESTART;
+  sigemptyset (&action.sa_mask);
+  sigaction (SIGUSR1, &action, NULL);
+
+  main_thread = pthread_self ();
+  watchdog_running = TRUE;
+
+  g_thread_unref (g_thread_new ("gdk-watchdog", watchdog_thread_func, NULL));
+}
+#else
+static void
+watchdog_iteration_start (gint64 now)
+{
+}
+
+static void
+watchdog_iteration_end (void)
+{
+}
+
+void
+gdk_telemetry_start_watchdog (void)
+{
+  g_warning ("The main loop watchdog is not supported on this platform");
+}
+#endif
+
+/*< private >
+ * gdk_telemetry_dump:
+ *
+ * Formats the entries of the last 10 seconds, oldest first, followed
+ * by a summary of the frame times.
+ *
+ * Returns: (transfer full): the formatted entries
+ */
+char *
+gdk_telemetry_dump (void)
+{
+  GArray *entries;
+  GString *string;
+  gint64 now;
+  gint64 frame_total = 0;
+  gint64 frame_max = 0;
+  guint n_frames = 0;
+  guint i;
+
+  now = g_get_monotonic_time ();
+  entries = g_array_sized_new (FALSE, FALSE, sizeof (Entry), RING_SIZE);
+
+  for (i = 0; i < RING_SIZE; i++)
+    {
+      Entry entry;
+      guint serial;
+
+      serial = g_atomic_int_get (&ring[i].serial);
+      if (serial == 0)
+        continue;
+
+      entry = ring[i];
+      if (g_atomic_int_get (&ring[i].serial) != serial)
+        continue;
+
+      if (entry.begin_time < now - KEEP_TIME)
+        continue;
+
+      g_array_append_val (entries, entry);
+    }
+
+  g_array_sort (entries, compare_entries);
+
+  string = g_string_new ("GTK telemetry of the last 10 seconds (times in ms):\n");
+
+  for (i = 0; i < entries->len; i++)
+    {
+      const Entry *entry = &g_array_index (entries, Entry, i);
+
+      g_string_append_printf (string, "  %9.3f  %-20s %8.3f",
+                              (entry->begin_time - now) / 1000.,
+                              kinds[entry->kind].name,
+                              entry->duration / 1000.);
+      if (kinds[entry->kind].detail)
+        g_string_append_printf (string, "  %s %" G_GINT64_FORMAT,
+                                kinds[entry->kind].detail, entry->detail);
+      g_string_append_c (string, '\n');
+
+      if (entry->kind == GDK_TELEMETRY_FRAME)
+        {
+          n_frames++;
+          frame_total += entry->duration;
+          frame_max = MAX (frame_max, entry->duration);
+        }
+    }
+
+  if (n_frames > 0)
+    g_string_append_printf (string, "%u frames, average %.3f, longest %.3f\n",
+                            n_frames,
+                            frame_total / 1000. / n_frames,
+                            frame_max / 1000.);
+
+  g_array_unref (entries);
+
+  return g_string_free (string, FALSE);
+}
+
+#ifdef G_OS_UNIX
+static gboolean
+dump_on_signal (gpointer data)
+{
+  char *dump;
+
+  dump = gdk_telemetry_dump ();
+  g_printerr ("%s", dump);
+  g_free (dump);
+
+  return G_SOURCE_CONTINUE;
+}
+#endif
+
+/*< private >
+ * gdk_telemetry_install_dump_signal:
+ *
+ * Makes SIGUSR2 print the telemetry to stderr.
+ */
+void
+gdk_telemetry_install_dump_signal (void)
+{
+#ifdef G_OS_UNIX
+  static guint signal_id;
+
+  if (signal_id == 0)
+    signal_id = g_unix_signal_add (SIGUSR2, dump_on_signal, NULL);
+#endif
+}
@@ -0,0 +1,53 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_TELEMETRY_PRIVATE_H__
+#define __GDK_TELEMETRY_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Kinds of events kept in the telemetry ring. Everything but
+ * frames is only recorded when it takes longer than the threshold
+ * for its kind.
+ */
+typedef enum {
+  GDK_TELEMETRY_FRAME,
+  GDK_TELEMETRY_MAIN_LOOP,
+  GDK_TELEMETRY_EVENT,
+  GDK_TELEMETRY_STYLE,
+  GDK_TELEMETRY_TEXTURE_UPLOAD,
+  GDK_TELEMETRY_N_KINDS
+} GdkTelemetryKind;
+
+/* Times are in microseconds, as returned by g_get_monotonic_time() */
+void     gdk_telemetry_record             (GdkTelemetryKind kind,
+                                           gint64           begin_time,
+                                           gint64           duration,
+                                           gint64           detail);
+void     gdk_telemetry_end                (GdkTelemetryKind kind,
+                                           gint64           begin_time,
+                                           gint64           detail);
+
+void     gdk_telemetry_init               (void);
+char *   gdk_telemetry_dump               (void);
+void     gdk_telemetry_install_dump_signal (void);
+void     gdk_telemetry_start_watchdog     (void);
+
+G_END_DECLS
+
+#endif /* __GDK_TELEMETRY_PRIVATE_H__ */
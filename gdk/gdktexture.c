@@ -42,10 +42,13 @@
 
 #include "gdkinternals.h"
 #include "gdkmemorytextureprivate.h"
+#include "gdkpredecodedprivate.h"
+#include "gdktiledtextureprivate.h"
 #include "gdkpaintable.h"
 #include "gdksnapshot.h"
 
 #include <graphene.h>
+#include <string.h>
 
 /* HACK: So we don't need to include any (not-yet-created) GSK or GTK headers */
 void
@@ -178,12 +181,18 @@ gdk_texture_get_property (GObject    *gobject,
     }
 }
 
+static void clear_render_slot (GdkTexture           *self,
+                               GdkTextureRenderSlot *slot,
+                               gboolean              unref_key);
+
 static void
 gdk_texture_dispose (GObject *object)
 {
   GdkTexture *self = GDK_TEXTURE (object);
+  int i;
 
-  gdk_texture_clear_render_data (self);
+  for (i = 0; i < GDK_TEXTURE_N_RENDER_SLOTS; i++)
+    clear_render_slot (self, &self->render_slots[i], TRUE);
 
   G_OBJECT_CLASS (gdk_texture_parent_class)->dispose (object);
 }
@@ -311,6 +320,60 @@ gdk_texture_new_for_pixbuf (GdkPixbuf *pixbuf)
   return texture;
 }
 
+/*
+ * gdk_texture_new_from_predecoded_resource:
+ * @resource_path: the path of an image resource
+ *
+ * Looks for a predecoded copy of the image at @resource_path, see
+ * gdkpredecodedprivate.h. The pixels are used straight from the
+ * resource data, without decoding or copying them.
+ *
+ * Returns: (nullable): a new texture, or %NULL if there is no
+ *   predecoded copy
+ */
+GdkTexture *
+gdk_texture_new_from_predecoded_resource (const char *resource_path)
+{
+  const GdkPredecodedHeader *header;
+  GdkTexture *texture;
+  GBytes *bytes, *pixels;
+  char *path;
+  gsize size;
+
+  path = g_strconcat (resource_path, GDK_PREDECODED_SUFFIX, NULL);
+  bytes = g_resources_lookup_data (path, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL);
+  g_free (path);
+
+  if (bytes == NULL)
+    return NULL;
+
+  header = g_bytes_get_data (bytes, &size);
+  if (size < sizeof (GdkPredecodedHeader) ||
+      memcmp (header->magic, GDK_PREDECODED_MAGIC, sizeof (header->magic)) != 0 ||
+      header->width == 0 || header->height == 0 ||
+      header->stride < header->width * 4 ||
+      size - sizeof (GdkPredecodedHeader) < (gsize) header->stride * header->height)
+    {
+      g_warning ("Invalid predecoded image for %s", resource_path);
+      g_bytes_unref (bytes);
+      return NULL;
+    }
+
+  pixels = g_bytes_new_from_bytes (bytes,
+                                   sizeof (GdkPredecodedHeader),
+                                   (gsize) header->stride * header->height);
+  texture = gdk_memory_texture_new (header->width,
+                                    header->height,
+                                    GDK_MEMORY_DEFAULT,
+                                    pixels,
+                                    header->stride);
+
+  g_bytes_unref (pixels);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
 /**
  * gdk_texture_new_from_resource:
  * @resource_path: the path of the resource file
@@ -336,6 +399,10 @@ gdk_texture_new_from_resource (const char *resource_path)
 
   g_return_val_if_fail (resource_path != NULL, NULL);
 
+  texture = gdk_texture_new_from_predecoded_resource (resource_path);
+  if (texture)
+    return texture;
+
   pixbuf = gdk_pixbuf_new_from_resource (resource_path, &error);
   if (pixbuf == NULL)
     g_error ("Resource path %s is not a valid image: %s", resource_path, error->message);
@@ -367,10 +434,23 @@ gdk_texture_new_from_file (GFile   *file,
   GdkTexture *texture;
   GdkPixbuf *pixbuf;
   GInputStream *stream;
+  const char *path;
 
   g_return_val_if_fail (G_IS_FILE (file), NULL);
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
+  /* Huge images get decoded on demand, in the parts and at the
+   * sizes they are drawn at */
+  path = g_file_peek_path (file);
+  if (path != NULL)
+    {
+      int width, height;
+
+      if (gdk_pixbuf_get_file_info (path, &width, &height) != NULL &&
+          (gint64) width * height > GDK_TILED_TEXTURE_MIN_PIXELS)
+        return gdk_tiled_texture_new (file, width, height);
+    }
+
   stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
   if (stream == NULL)
     return NULL;
@@ -386,6 +466,308 @@ gdk_texture_new_from_file (GFile   *file,
   return texture;
 }
 
+typedef struct
+{
+  GFile *file;
+  char *resource_path;
+  int width;
+  int height;
+} LoadData;
+
+static void
+load_data_free (gpointer data)
+{
+  LoadData *load = data;
+
+  g_clear_object (&load->file);
+  g_free (load->resource_path);
+  g_slice_free (LoadData, load);
+}
+
+/* Only ever scales down, keeping the aspect ratio */
+static void
+load_size_prepared (GdkPixbufLoader *loader,
+                    int              width,
+                    int              height,
+                    gpointer         user_data)
+{
+  LoadData *load = user_data;
+  double scale = 1.0;
+
+  if (load->width > 0 && width > load->width)
+    scale = (double) load->width / width;
+  if (load->height > 0 && height > load->height)
+    scale = MIN (scale, (double) load->height / height);
+
+  if (scale < 1.0)
+    gdk_pixbuf_loader_set_size (loader,
+                                MAX (1, (int) (width * scale + 0.5)),
+                                MAX (1, (int) (height * scale + 0.5)));
+}
+
+static GdkPixbuf *
+load_pixbuf (LoadData      *load,
+             GInputStream  *stream,
+             GCancellable  *cancellable,
+             GError       **error)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf = NULL;
+  guchar buffer[65536];
+  gssize n_read;
+  gboolean ok;
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared", G_CALLBACK (load_size_prepared), load);
+
+  do
+    {
+      n_read = g_input_stream_read (stream, buffer, sizeof (buffer), cancellable, error);
+      if (n_read < 0)
+        break;
+      if (n_read > 0 && !gdk_pixbuf_loader_write (loader, buffer, n_read, error))
+        {
+          n_read = -1;
+          break;
+        }
+    }
+  while (n_read > 0);
+
+  if (n_read < 0)
+    {
+      gdk_pixbuf_loader_close (loader, NULL);
+      g_object_unref (loader);
+      return NULL;
+    }
+
+  ok = gdk_pixbuf_loader_close (loader, error);
+  if (ok)
+    {
+      pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+      if (pixbuf != NULL)
+        g_object_ref (pixbuf);
+      else
+        g_set_error_literal (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED,
+                             "Image data is incomplete");
+    }
+
+  g_object_unref (loader);
+
+  return pixbuf;
+}
+
+static void
+load_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+  LoadData *load = task_data;
+  GInputStream *stream;
+  GdkPixbuf *pixbuf;
+  GdkTexture *texture;
+  GError *error = NULL;
+
+  if (load->file)
+    {
+      const char *path = g_file_peek_path (load->file);
+      int width, height;
+
+      /* Like gdk_texture_new_from_file(), this leaves huge images
+       * to be decoded on demand, unless they get scaled anyway */
+      if (path != NULL && load->width <= 0 && load->height <= 0 &&
+          gdk_pixbuf_get_file_info (path, &width, &height) != NULL &&
+          (gint64) width * height > GDK_TILED_TEXTURE_MIN_PIXELS)
+        {
+          g_task_return_pointer (task,
+                                 gdk_tiled_texture_new (load->file, width, height),
+                                 g_object_unref);
+          return;
+        }
+
+      stream = G_INPUT_STREAM (g_file_read (load->file, cancellable, &error));
+    }
+  else
+    {
+      if (load->width <= 0 && load->height <= 0)
+        {
+          texture = gdk_texture_new_from_predecoded_resource (load->resource_path);
+          if (texture)
+            {
+              g_task_return_pointer (task, texture, g_object_unref);
+              return;
+            }
+        }
+
+      stream = g_resources_open_stream (load->resource_path, 0, &error);
+    }
+
+  if (stream == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  pixbuf = load_pixbuf (load, stream, cancellable, &error);
+  g_object_unref (stream);
+  if (pixbuf == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  texture = gdk_texture_new_for_pixbuf (pixbuf);
+  g_object_unref (pixbuf);
+
+  g_task_return_pointer (task, texture, g_object_unref);
+}
+
+static void
+load_async (LoadData            *load,
+            int                  io_priority,
+            GCancellable        *cancellable,
+            GAsyncReadyCallback  callback,
+            gpointer             user_data,
+            gpointer             source_tag)
+{
+  GTask *task;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, source_tag);
+  g_task_set_priority (task, io_priority);
+  g_task_set_return_on_cancel (task, TRUE);
+  g_task_set_task_data (task, load, load_data_free);
+  g_task_run_in_thread (task, load_thread);
+  g_object_unref (task);
+}
+
+/**
+ * gdk_texture_new_from_file_async:
+ * @file: #GFile to load
+ * @width: the maximum width of the texture, or -1
+ * @height: the maximum height of the texture, or -1
+ * @io_priority: the [I/O priority][io-priority] of the request
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     texture has been created
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Asynchronously creates a new texture by loading an image from a file.
+ * This is the asynchronous version of gdk_texture_new_from_file(); the
+ * image is read and decoded in a thread, so it does not block the main
+ * loop.
+ *
+ * If @width or @height are positive, images that are larger than that
+ * are scaled down while they are decoded, keeping their aspect ratio.
+ *
+ * When the operation is finished, @callback will be called. You can then
+ * call gdk_texture_new_from_file_finish() to get the result.
+ */
+void
+gdk_texture_new_from_file_async (GFile               *file,
+                                 int                  width,
+                                 int                  height,
+                                 int                  io_priority,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  LoadData *load;
+
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load = g_slice_new0 (LoadData);
+  load->file = g_object_ref (file);
+  load->width = width;
+  load->height = height;
+
+  load_async (load, io_priority, cancellable, callback, user_data,
+              gdk_texture_new_from_file_async);
+}
+
+/**
+ * gdk_texture_new_from_file_finish:
+ * @result: a #GAsyncResult
+ * @error: Return location for an error
+ *
+ * Finishes an operation started with gdk_texture_new_from_file_async().
+ *
+ * If %NULL is returned, then @error will be set.
+ *
+ * Return value: A newly-created #GdkTexture or %NULL if an error occurred.
+ */
+GdkTexture *
+gdk_texture_new_from_file_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gdk_texture_new_from_file_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * gdk_texture_new_from_resource_async:
+ * @resource_path: the path of the resource file
+ * @width: the maximum width of the texture, or -1
+ * @height: the maximum height of the texture, or -1
+ * @io_priority: the [I/O priority][io-priority] of the request
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     texture has been created
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Asynchronously creates a new texture by loading an image from a resource.
+ * See gdk_texture_new_from_file_async() for details.
+ *
+ * Unlike gdk_texture_new_from_resource(), an invalid resource is not
+ * a fatal error, it is reported by gdk_texture_new_from_resource_finish().
+ */
+void
+gdk_texture_new_from_resource_async (const char          *resource_path,
+                                     int                  width,
+                                     int                  height,
+                                     int                  io_priority,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  LoadData *load;
+
+  g_return_if_fail (resource_path != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load = g_slice_new0 (LoadData);
+  load->resource_path = g_strdup (resource_path);
+  load->width = width;
+  load->height = height;
+
+  load_async (load, io_priority, cancellable, callback, user_data,
+              gdk_texture_new_from_resource_async);
+}
+
+/**
+ * gdk_texture_new_from_resource_finish:
+ * @result: a #GAsyncResult
+ * @error: Return location for an error
+ *
+ * Finishes an operation started with gdk_texture_new_from_resource_async().
+ *
+ * If %NULL is returned, then @error will be set.
+ *
+ * Return value: A newly-created #GdkTexture or %NULL if an error occurred.
+ */
+GdkTexture *
+gdk_texture_new_from_resource_finish (GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gdk_texture_new_from_resource_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * gdk_texture_get_width:
  * @texture: a #GdkTexture
@@ -495,43 +877,128 @@ gdk_texture_download (GdkTexture *texture,
                              stride);
 }
 
+/* Renderers cache their copies of a texture in one of a few slots,
+ * keyed by the renderer object. A slot is cleared when either the
+ * texture or the renderer goes away, so a texture that is shown by
+ * several renderers stays cached in all of them.
+ */
+static void render_key_destroyed (gpointer  data,
+                                  GObject  *where_the_key_was);
+
+static void
+clear_render_slot (GdkTexture           *self,
+                   GdkTextureRenderSlot *slot,
+                   gboolean              unref_key)
+{
+  GDestroyNotify notify = slot->notify;
+  gpointer data = slot->data;
+
+  if (slot->key == NULL)
+    return;
+
+  if (unref_key)
+    g_object_weak_unref (slot->key, render_key_destroyed, self);
+
+  /* Clear the slot first, the notify may call back into us */
+  slot->key = NULL;
+  slot->data = NULL;
+  slot->notify = NULL;
+
+  if (notify)
+    notify (data);
+}
+
+static GdkTextureRenderSlot *
+find_render_slot (GdkTexture *self,
+                  gpointer    key)
+{
+  int i;
+
+  for (i = 0; i < GDK_TEXTURE_N_RENDER_SLOTS; i++)
+    {
+      if (self->render_slots[i].key == key)
+        return &self->render_slots[i];
+    }
+
+  return NULL;
+}
+
+static void
+render_key_destroyed (gpointer  data,
+                      GObject  *where_the_key_was)
+{
+  GdkTexture *self = data;
+  GdkTextureRenderSlot *slot;
+
+  slot = find_render_slot (self, where_the_key_was);
+  if (slot)
+    clear_render_slot (self, slot, FALSE);
+}
+
+/*< private >
+ * gdk_texture_set_render_data:
+ * @self: a #GdkTexture
+ * @key: the #GObject of the renderer caching the data
+ * @data: the data to cache
+ * @notify: (nullable): called when the data is cleared
+ *
+ * Caches renderer-specific @data for @self. Data that was
+ * previously set for @key is cleared.
+ *
+ * Returns: %FALSE if all slots are in use by other renderers
+ */
 gboolean
 gdk_texture_set_render_data (GdkTexture     *self,
                              gpointer        key,
                              gpointer        data,
                              GDestroyNotify  notify)
 {
+  GdkTextureRenderSlot *slot;
+
+  g_return_val_if_fail (G_IS_OBJECT (key), FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
- 
-  if (self->render_key != NULL)
-    return FALSE;
 
-  self->render_key = key;
-  self->render_data = data;
-  self->render_notify = notify;
+  slot = find_render_slot (self, key);
+  if (slot)
+    clear_render_slot (self, slot, FALSE);
+  else
+    {
+      slot = find_render_slot (self, NULL);
+      if (slot == NULL)
+        return FALSE;
+
+      g_object_weak_ref (key, render_key_destroyed, self);
+    }
+
+  slot->key = key;
+  slot->data = data;
+  slot->notify = notify;
 
   return TRUE;
 }
 
 void
-gdk_texture_clear_render_data (GdkTexture *self)
+gdk_texture_clear_render_data (GdkTexture *self,
+                               gpointer    key)
 {
-  if (self->render_notify)
-    self->render_notify (self->render_data);
+  GdkTextureRenderSlot *slot;
 
-  self->render_key = NULL;
-  self->render_data = NULL;
-  self->render_notify = NULL;
+  slot = find_render_slot (self, key);
+  if (slot)
+    clear_render_slot (self, slot, TRUE);
 }
 
 gpointer
 gdk_texture_get_render_data (GdkTexture  *self,
                              gpointer     key)
 {
-  if (self->render_key != key)
+  GdkTextureRenderSlot *slot;
+
+  slot = find_render_slot (self, key);
+  if (slot == NULL)
     return NULL;
 
-  return self->render_data;
+  return slot->data;
 }
 
 /**
@@ -9,6 +9,16 @@ G_BEGIN_DECLS
 #define GDK_IS_TEXTURE_CLASS(klass)         (G_TYPE_CHECK_CLASS_TYPE ((klass), GDK_TYPE_TEXTURE))
 #define GDK_TEXTURE_GET_CLASS(obj)          (G_TYPE_INSTANCE_GET_CLASS ((obj), GDK_TYPE_TEXTURE, GdkTextureClass))
 
+/* The number of renderers that can cache data for a texture at once */
+#define GDK_TEXTURE_N_RENDER_SLOTS 4
+
+typedef struct
+{
+  gpointer key;
+  gpointer data;
+  GDestroyNotify notify;
+} GdkTextureRenderSlot;
+
 struct _GdkTexture
 {
   GObject parent_instance;
@@ -16,9 +26,7 @@ struct _GdkTexture
   int width;
   int height;
 
-  gpointer render_key;
-  gpointer render_data;
-  GDestroyNotify render_notify;
+  GdkTextureRenderSlot render_slots[GDK_TEXTURE_N_RENDER_SLOTS];
 };
 
 struct _GdkTextureClass {
@@ -34,6 +42,8 @@ gpointer                gdk_texture_new                 (const GdkTextureClass
                                                          int                     width,
                                                          int                     height);
 GdkTexture *            gdk_texture_new_for_surface     (cairo_surface_t        *surface);
+GdkTexture *            gdk_texture_new_from_predecoded_resource
+                                                        (const char             *resource_path);
 cairo_surface_t *       gdk_texture_download_surface    (GdkTexture             *texture);
 void                    gdk_texture_download_area       (GdkTexture             *texture,
                                                          const GdkRectangle     *area,
@@ -44,7 +54,8 @@ gboolean                gdk_texture_set_render_data     (GdkTexture
                                                          gpointer                key,
                                                          gpointer                data,
                                                          GDestroyNotify          notify);
-void                    gdk_texture_clear_render_data   (GdkTexture             *self);
+void                    gdk_texture_clear_render_data   (GdkTexture             *self,
+                                                         gpointer                key);
 gpointer                gdk_texture_get_render_data     (GdkTexture             *self,
                                                          gpointer                key);
 
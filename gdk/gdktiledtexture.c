@@ -0,0 +1,519 @@
+/*
+ * Copyright © 2021 GTK developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdktiledtextureprivate.h"
+
+#include "gdkinternals.h"
+#include "gdkmemorytextureprivate.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <string.h>
+
+/* A texture for huge image files that only keeps the decoded tiles
+ * around that were recently asked for, at the mip level they were
+ * asked for. Level n is the image scaled down by 2^n.
+ *
+ * GdkPixbuf can only decode whole images, so a cache miss decodes
+ * the full level and slices it into tiles. The tiles that were not
+ * asked for are kept too, as far as the cache has room for them, so
+ * panning around doesn't decode the level again for every new tile.
+ * Loaders like the JPEG one decode downscaled levels directly, which
+ * makes zoomed out views cheap.
+ *
+ * Renderers may draw the texture from several threads, so the cache
+ * is protected by a mutex. Decoding happens with the mutex held, so
+ * two threads missing the same level decode it only once.
+ */
+
+/* How much memory unpinned tiles may hold on to */
+#define CACHE_SIZE (64 * 1024 * 1024)
+
+#define TILE_KEY(level, col, row) (((guint64) (level) << 48) | ((guint64) (row) << 24) | (guint64) (col))
+
+typedef struct {
+  guint64 key;
+  GdkTexture *texture;
+  guint64 last_used;
+} Tile;
+
+struct _GdkTiledTexture
+{
+  GdkTexture parent_instance;
+
+  GFile *file;
+  guint n_levels;
+
+  GMutex lock; /* protects everything below */
+  gboolean failed; /* Don't retry decoding a broken file every frame */
+  GHashTable *tiles; /* TILE_KEY -> Tile */
+  gsize cache_size;
+  guint64 counter;
+};
+
+struct _GdkTiledTextureClass
+{
+  GdkTextureClass parent_class;
+};
+
+G_DEFINE_TYPE (GdkTiledTexture, gdk_tiled_texture, GDK_TYPE_TEXTURE)
+
+static void
+tile_free (gpointer data)
+{
+  Tile *tile = data;
+
+  g_object_unref (tile->texture);
+  g_slice_free (Tile, tile);
+}
+
+static gsize
+tile_size (const Tile *tile)
+{
+  return (gsize) tile->texture->width * tile->texture->height * 4;
+}
+
+static void
+gdk_tiled_texture_dispose (GObject *object)
+{
+  GdkTiledTexture *self = GDK_TILED_TEXTURE (object);
+
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->tiles, g_hash_table_unref);
+
+  G_OBJECT_CLASS (gdk_tiled_texture_parent_class)->dispose (object);
+}
+
+static void
+gdk_tiled_texture_finalize (GObject *object)
+{
+  GdkTiledTexture *self = GDK_TILED_TEXTURE (object);
+
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (gdk_tiled_texture_parent_class)->finalize (object);
+}
+
+static int
+compare_tiles_by_use (gconstpointer a,
+                      gconstpointer b)
+{
+  const Tile *tile_a = *(const Tile **) a;
+  const Tile *tile_b = *(const Tile **) b;
+
+  if (tile_a->last_used < tile_b->last_used)
+    return -1;
+  if (tile_a->last_used > tile_b->last_used)
+    return 1;
+  return 0;
+}
+
+/* Drops the least recently used tiles until the cache fits, except
+ * the ones used since @pinned. Called with the lock held. */
+static void
+trim_cache (GdkTiledTexture *self,
+            guint64          pinned)
+{
+  GHashTableIter iter;
+  GPtrArray *unpinned;
+  Tile *tile;
+  guint i;
+
+  if (self->cache_size <= CACHE_SIZE)
+    return;
+
+  unpinned = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, self->tiles);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &tile))
+    {
+      if (tile->last_used < pinned)
+        g_ptr_array_add (unpinned, tile);
+    }
+
+  g_ptr_array_sort (unpinned, compare_tiles_by_use);
+
+  for (i = 0; i < unpinned->len && self->cache_size > CACHE_SIZE; i++)
+    {
+      tile = g_ptr_array_index (unpinned, i);
+      self->cache_size -= tile_size (tile);
+      g_hash_table_remove (self->tiles, &tile->key);
+    }
+
+  g_ptr_array_free (unpinned, TRUE);
+}
+
+static GdkPixbuf *
+decode_level (GdkTiledTexture *self,
+              guint            level)
+{
+  GInputStream *stream;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  int width, height;
+
+  if (self->failed)
+    return NULL;
+
+  gdk_tiled_texture_get_level_size (self, level, &width, &height);
+
+  stream = G_INPUT_STREAM (g_file_read (self->file, NULL, &error));
+  if (stream == NULL)
+    goto fail;
+
+  pixbuf = gdk_pixbuf_new_from_stream_at_scale (stream, width, height, FALSE, NULL, &error);
+  g_object_unref (stream);
+  if (pixbuf == NULL)
+    goto fail;
+
+  /* Loaders may round differently */
+  if (gdk_pixbuf_get_width (pixbuf) != width ||
+      gdk_pixbuf_get_height (pixbuf) != height)
+    {
+      GdkPixbuf *scaled;
+
+      scaled = gdk_pixbuf_scale_simple (pixbuf, width, height, GDK_INTERP_BILINEAR);
+      g_object_unref (pixbuf);
+      pixbuf = scaled;
+    }
+
+  GDK_NOTE (MISC, g_message ("Decoded level %u of %s, %dx%d", level, g_file_peek_path (self->file), width, height));
+
+  return pixbuf;
+
+fail:
+  g_warning ("Could not decode level %u of texture: %s", level, error->message);
+  g_error_free (error);
+  self->failed = TRUE;
+  return NULL;
+}
+
+static GdkTexture *
+create_tile (GdkPixbuf *pixbuf,
+             int        col,
+             int        row)
+{
+  const int x = col * GDK_TILED_TEXTURE_TILE_SIZE;
+  const int y = row * GDK_TILED_TEXTURE_TILE_SIZE;
+  const int width = MIN (GDK_TILED_TEXTURE_TILE_SIZE, gdk_pixbuf_get_width (pixbuf) - x);
+  const int height = MIN (GDK_TILED_TEXTURE_TILE_SIZE, gdk_pixbuf_get_height (pixbuf) - y);
+  const gboolean has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
+  const int stride = gdk_pixbuf_get_rowstride (pixbuf);
+  GdkTexture *texture;
+  GBytes *bytes;
+  guchar *data;
+
+  data = g_malloc (width * height * 4);
+  gdk_memory_convert (data, width * 4,
+                      GDK_MEMORY_DEFAULT,
+                      gdk_pixbuf_get_pixels (pixbuf) + y * stride + x * (has_alpha ? 4 : 3),
+                      stride,
+                      has_alpha ? GDK_MEMORY_GDK_PIXBUF_ALPHA : GDK_MEMORY_GDK_PIXBUF_OPAQUE,
+                      width, height);
+
+  bytes = g_bytes_new_take (data, width * height * 4);
+  texture = gdk_memory_texture_new (width, height, GDK_MEMORY_DEFAULT, bytes, width * 4);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+static Tile *
+add_tile (GdkTiledTexture *self,
+          GdkPixbuf       *pixbuf,
+          guint            level,
+          int              col,
+          int              row,
+          guint64          last_used)
+{
+  Tile *tile;
+
+  tile = g_slice_new (Tile);
+  tile->key = TILE_KEY (level, col, row);
+  tile->texture = create_tile (pixbuf, col, row);
+  tile->last_used = last_used;
+  g_hash_table_insert (self->tiles, &tile->key, tile);
+  self->cache_size += tile_size (tile);
+
+  return tile;
+}
+
+/* Slices the tiles of @level that nobody asked for out of the decoded
+ * @pixbuf, while the cache has room for them. They are marked as the
+ * least recently used, so they are the first to go when the cache
+ * fills up. */
+static void
+add_remaining_tiles (GdkTiledTexture *self,
+                     GdkPixbuf       *pixbuf,
+                     guint            level)
+{
+  const gsize full_tile = (gsize) GDK_TILED_TEXTURE_TILE_SIZE * GDK_TILED_TEXTURE_TILE_SIZE * 4;
+  int n_cols, n_rows;
+  int col, row;
+
+  n_cols = (gdk_pixbuf_get_width (pixbuf) + GDK_TILED_TEXTURE_TILE_SIZE - 1) / GDK_TILED_TEXTURE_TILE_SIZE;
+  n_rows = (gdk_pixbuf_get_height (pixbuf) + GDK_TILED_TEXTURE_TILE_SIZE - 1) / GDK_TILED_TEXTURE_TILE_SIZE;
+
+  for (row = 0; row < n_rows; row++)
+    for (col = 0; col < n_cols; col++)
+      {
+        guint64 key = TILE_KEY (level, col, row);
+
+        if (self->cache_size + full_tile > CACHE_SIZE)
+          return;
+
+        if (!g_hash_table_contains (self->tiles, &key))
+          add_tile (self, pixbuf, level, col, row, 0);
+      }
+}
+
+/* Called with the lock held */
+static void
+ensure_tiles_locked (GdkTiledTexture    *self,
+                     guint               level,
+                     const GdkRectangle *tiles)
+{
+  GdkPixbuf *pixbuf = NULL;
+  GdkRectangle range;
+  guint64 pinned;
+  int width, height;
+  int col, row;
+
+  gdk_tiled_texture_get_level_size (self, level, &width, &height);
+  if (!gdk_rectangle_intersect (tiles,
+                                &(GdkRectangle) {
+                                  0, 0,
+                                  (width + GDK_TILED_TEXTURE_TILE_SIZE - 1) / GDK_TILED_TEXTURE_TILE_SIZE,
+                                  (height + GDK_TILED_TEXTURE_TILE_SIZE - 1) / GDK_TILED_TEXTURE_TILE_SIZE
+                                },
+                                &range))
+    return;
+
+  pinned = ++self->counter;
+
+  for (row = range.y; row < range.y + range.height; row++)
+    for (col = range.x; col < range.x + range.width; col++)
+      {
+        guint64 key = TILE_KEY (level, col, row);
+        Tile *tile;
+
+        tile = g_hash_table_lookup (self->tiles, &key);
+        if (tile == NULL)
+          {
+            if (pixbuf == NULL)
+              {
+                pixbuf = decode_level (self, level);
+                if (pixbuf == NULL)
+                  return;
+              }
+
+            tile = add_tile (self, pixbuf, level, col, row, pinned);
+          }
+
+        tile->last_used = pinned;
+      }
+
+  trim_cache (self, pinned);
+
+  if (pixbuf)
+    {
+      add_remaining_tiles (self, pixbuf, level);
+      g_object_unref (pixbuf);
+    }
+}
+
+/**
+ * gdk_tiled_texture_ensure_tiles:
+ * @self: a #GdkTiledTexture
+ * @level: the mip level
+ * @tiles: the range of tiles, in columns and rows
+ *
+ * Decodes the tiles in @tiles if they are not cached yet, and keeps
+ * them in the cache until the next call. Callers about to use a
+ * number of tiles should call this first, so the image is decoded
+ * at most once.
+ *
+ * This function may be called from any thread.
+ */
+void
+gdk_tiled_texture_ensure_tiles (GdkTiledTexture    *self,
+                                guint               level,
+                                const GdkRectangle *tiles)
+{
+  g_return_if_fail (level < self->n_levels);
+
+  g_mutex_lock (&self->lock);
+  ensure_tiles_locked (self, level, tiles);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * gdk_tiled_texture_ref_tile:
+ * @self: a #GdkTiledTexture
+ * @level: the mip level
+ * @col: the column of the tile
+ * @row: the row of the tile
+ *
+ * Gets the contents of a tile, decoding them if necessary.
+ *
+ * This function may be called from any thread.
+ *
+ * Returns: (transfer full) (nullable): the tile, or %NULL if
+ *   the image could not be decoded
+ */
+GdkTexture *
+gdk_tiled_texture_ref_tile (GdkTiledTexture *self,
+                            guint            level,
+                            int              col,
+                            int              row)
+{
+  guint64 key = TILE_KEY (level, col, row);
+  GdkTexture *result = NULL;
+  Tile *tile;
+
+  g_return_val_if_fail (level < self->n_levels, NULL);
+
+  g_mutex_lock (&self->lock);
+
+  tile = g_hash_table_lookup (self->tiles, &key);
+  if (tile == NULL)
+    {
+      ensure_tiles_locked (self, level, &(GdkRectangle) { col, row, 1, 1 });
+      tile = g_hash_table_lookup (self->tiles, &key);
+    }
+
+  if (tile)
+    {
+      tile->last_used = ++self->counter;
+      result = g_object_ref (tile->texture);
+    }
+
+  g_mutex_unlock (&self->lock);
+
+  return result;
+}
+
+static void
+gdk_tiled_texture_download (GdkTexture         *texture,
+                            const GdkRectangle *area,
+                            guchar             *data,
+                            gsize               stride)
+{
+  GdkTiledTexture *self = GDK_TILED_TEXTURE (texture);
+  const int size = GDK_TILED_TEXTURE_TILE_SIZE;
+  GdkRectangle tiles;
+  int col, row;
+
+  tiles.x = area->x / size;
+  tiles.y = area->y / size;
+  tiles.width = (area->x + area->width + size - 1) / size - tiles.x;
+  tiles.height = (area->y + area->height + size - 1) / size - tiles.y;
+
+  gdk_tiled_texture_ensure_tiles (self, 0, &tiles);
+
+  for (row = tiles.y; row < tiles.y + tiles.height; row++)
+    for (col = tiles.x; col < tiles.x + tiles.width; col++)
+      {
+        GdkRectangle tile_area = { col * size, row * size, size, size };
+        GdkRectangle dest;
+        GdkTexture *tile;
+
+        if (!gdk_rectangle_intersect (&tile_area, area, &dest))
+          continue;
+
+        tile = gdk_tiled_texture_ref_tile (self, 0, col, row);
+        if (tile == NULL)
+          {
+            int y;
+
+            for (y = 0; y < dest.height; y++)
+              memset (data + (dest.y - area->y + y) * stride + (dest.x - area->x) * 4, 0, dest.width * 4);
+            continue;
+          }
+
+        gdk_texture_download_area (tile,
+                                   &(GdkRectangle) { dest.x - tile_area.x, dest.y - tile_area.y,
+                                                     dest.width, dest.height },
+                                   data + (dest.y - area->y) * stride + (dest.x - area->x) * 4,
+                                   stride);
+        g_object_unref (tile);
+      }
+
+  /* Don't keep a full download around */
+  g_mutex_lock (&self->lock);
+  trim_cache (self, self->counter + 1);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gdk_tiled_texture_class_init (GdkTiledTextureClass *klass)
+{
+  GdkTextureClass *texture_class = GDK_TEXTURE_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  texture_class->download = gdk_tiled_texture_download;
+  gobject_class->dispose = gdk_tiled_texture_dispose;
+  gobject_class->finalize = gdk_tiled_texture_finalize;
+}
+
+static void
+gdk_tiled_texture_init (GdkTiledTexture *self)
+{
+  g_mutex_init (&self->lock);
+  self->tiles = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, tile_free);
+}
+
+GdkTexture *
+gdk_tiled_texture_new (GFile *file,
+                       int    width,
+                       int    height)
+{
+  GdkTiledTexture *self;
+  int size;
+
+  self = g_object_new (GDK_TYPE_TILED_TEXTURE,
+                       "width", width,
+                       "height", height,
+                       NULL);
+
+  self->file = g_object_ref (file);
+
+  /* Down to the level that fits into a single tile */
+  self->n_levels = 1;
+  for (size = MAX (width, height); size > GDK_TILED_TEXTURE_TILE_SIZE; size = (size + 1) / 2)
+    self->n_levels++;
+
+  return GDK_TEXTURE (self);
+}
+
+guint
+gdk_tiled_texture_get_n_levels (GdkTiledTexture *self)
+{
+  return self->n_levels;
+}
+
+void
+gdk_tiled_texture_get_level_size (GdkTiledTexture *self,
+                                  guint            level,
+                                  int             *width,
+                                  int             *height)
+{
+  GdkTexture *texture = GDK_TEXTURE (self);
+
+  *width = MAX (1, (texture->width + (1 << level) - 1) >> level);
+  *height = MAX (1, (texture->height + (1 << level) - 1) >> level);
+}
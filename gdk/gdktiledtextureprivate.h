@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2021 GTK developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_TILED_TEXTURE_PRIVATE_H__
+#define __GDK_TILED_TEXTURE_PRIVATE_H__
+
+#include "gdktextureprivate.h"
+
+G_BEGIN_DECLS
+
+/* Images bigger than this many pixels are decoded lazily */
+#define GDK_TILED_TEXTURE_MIN_PIXELS (4096 * 4096)
+
+#define GDK_TILED_TEXTURE_TILE_SIZE 512
+
+#define GDK_TYPE_TILED_TEXTURE (gdk_tiled_texture_get_type ())
+
+#define GDK_TILED_TEXTURE(obj)          (G_TYPE_CHECK_INSTANCE_CAST ((obj), GDK_TYPE_TILED_TEXTURE, GdkTiledTexture))
+#define GDK_IS_TILED_TEXTURE(obj)       (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GDK_TYPE_TILED_TEXTURE))
+
+typedef struct _GdkTiledTexture         GdkTiledTexture;
+typedef struct _GdkTiledTextureClass    GdkTiledTextureClass;
+
+GType                   gdk_tiled_texture_get_type              (void) G_GNUC_CONST;
+
+GdkTexture *            gdk_tiled_texture_new                   (GFile                  *file,
+                                                                 int                     width,
+                                                                 int                     height);
+
+guint                   gdk_tiled_texture_get_n_levels          (GdkTiledTexture        *self);
+void                    gdk_tiled_texture_get_level_size        (GdkTiledTexture        *self,
+                                                                 guint                   level,
+                                                                 int                    *width,
+                                                                 int                    *height);
+void                    gdk_tiled_texture_ensure_tiles          (GdkTiledTexture        *self,
+                                                                 guint                   level,
+                                                                 const GdkRectangle     *tiles);
+GdkTexture *            gdk_tiled_texture_ref_tile              (GdkTiledTexture        *self,
+                                                                 guint                   level,
+                                                                 int                     col,
+                                                                 int                     row);
+
+G_END_DECLS
+
+#endif /* __GDK_TILED_TEXTURE_PRIVATE_H__ */
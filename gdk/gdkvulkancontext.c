@@ -454,6 +454,9 @@ gdk_vulkan_context_begin_frame (GdkDrawContext *draw_context,
   cairo_region_union (region, priv->regions[priv->draw_index]);
 }
 
+/* Damage with more rectangles than this is presented as its extents */
+#define MAX_PRESENT_RECTANGLES 16
+
 static void
 gdk_vulkan_context_end_frame (GdkDrawContext *draw_context,
                               cairo_region_t *painted)
@@ -463,24 +466,42 @@ gdk_vulkan_context_end_frame (GdkDrawContext *draw_context,
   GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
   VkPresentRegionsKHR *regionsptr = VK_NULL_HANDLE;
   VkPresentRegionsKHR regions;
-  cairo_rectangle_int_t extents;
+  VkRectLayerKHR *rectangles;
+  int i, n_rectangles;
   int scale;
 
-  cairo_region_get_extents (painted, &extents);
   scale = gdk_surface_get_scale_factor (surface);
+  n_rectangles = cairo_region_num_rectangles (painted);
+  if (n_rectangles > MAX_PRESENT_RECTANGLES)
+    n_rectangles = 1;
+  rectangles = g_newa (VkRectLayerKHR, MAX (n_rectangles, 1));
+
+  /* Tell the compositor about every damaged rectangle, not just
+   * their extents, so it can skip the parts in between.
+   */
+  for (i = 0; i < n_rectangles; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      if (n_rectangles == 1)
+        cairo_region_get_extents (painted, &rect);
+      else
+        cairo_region_get_rectangle (painted, i, &rect);
+      rectangles[i] = (VkRectLayerKHR) {
+          .layer = 0,
+          .offset.x = rect.x * scale,
+          .offset.y = rect.y * scale,
+          .extent.width = rect.width * scale,
+          .extent.height = rect.height * scale,
+      };
+    }
 
   regions = (VkPresentRegionsKHR) {
       .sType = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR,
       .swapchainCount = 1,
       .pRegions = &(VkPresentRegionKHR) {
-          .rectangleCount = 1,
-          .pRectangles = &(VkRectLayerKHR) {
-              .layer = 0,
-              .offset.x = extents.x * scale,
-              .offset.y = extents.y * scale,
-              .extent.width = extents.width * scale,
-              .extent.height = extents.height * scale,
-          }
+          .rectangleCount = n_rectangles,
+          .pRectangles = rectangles,
       },
   };
 
@@ -0,0 +1,98 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprivate-headless.h"
+
+#include "gdkcairo.h"
+
+G_DEFINE_TYPE (GdkHeadlessCairoContext, gdk_headless_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
+
+static void
+gdk_headless_cairo_context_begin_frame (GdkDrawContext *draw_context,
+                                        cairo_region_t *region)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+  GdkHeadlessSurface *impl = GDK_HEADLESS_SURFACE (surface);
+  cairo_surface_t *content;
+  cairo_t *cr;
+
+  /* A new content surface has nothing we could keep */
+  if (impl->content == NULL)
+    {
+      cairo_region_t *repaint_region;
+
+      repaint_region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) {
+                                                        0, 0,
+                                                        gdk_surface_get_width (surface),
+                                                        gdk_surface_get_height (surface) });
+      cairo_region_union (region, repaint_region);
+      cairo_region_destroy (repaint_region);
+    }
+
+  content = gdk_headless_surface_ensure_content (impl);
+
+  /* clear the repaint area */
+  cr = cairo_create (content);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  gdk_cairo_region (cr, region);
+  cairo_fill (cr);
+  cairo_destroy (cr);
+}
+
+static void
+gdk_headless_cairo_context_end_frame (GdkDrawContext *draw_context,
+                                      cairo_region_t *painted)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+
+  cairo_surface_flush (GDK_HEADLESS_SURFACE (surface)->content);
+}
+
+static void
+gdk_headless_cairo_context_surface_resized (GdkDrawContext *draw_context)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+
+  g_clear_pointer (&GDK_HEADLESS_SURFACE (surface)->content, cairo_surface_destroy);
+}
+
+static cairo_t *
+gdk_headless_cairo_context_cairo_create (GdkCairoContext *context)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (context));
+
+  return cairo_create (GDK_HEADLESS_SURFACE (surface)->content);
+}
+
+static void
+gdk_headless_cairo_context_class_init (GdkHeadlessCairoContextClass *klass)
+{
+  GdkDrawContextClass *draw_context_class = GDK_DRAW_CONTEXT_CLASS (klass);
+  GdkCairoContextClass *cairo_context_class = GDK_CAIRO_CONTEXT_CLASS (klass);
+
+  draw_context_class->begin_frame = gdk_headless_cairo_context_begin_frame;
+  draw_context_class->end_frame = gdk_headless_cairo_context_end_frame;
+  draw_context_class->surface_resized = gdk_headless_cairo_context_surface_resized;
+
+  cairo_context_class->cairo_create = gdk_headless_cairo_context_cairo_create;
+}
+
+static void
+gdk_headless_cairo_context_init (GdkHeadlessCairoContext *self)
+{
+}
@@ -0,0 +1,93 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprivate-headless.h"
+
+/* There is no pointer or keyboard behind these devices. Events
+ * for them can only be synthesized, e.g. by tests.
+ */
+
+typedef struct
+{
+  GdkDevice parent_instance;
+} GdkHeadlessDevice;
+
+typedef GdkDeviceClass GdkHeadlessDeviceClass;
+
+G_DEFINE_TYPE (GdkHeadlessDevice, gdk_headless_device, GDK_TYPE_DEVICE)
+
+static void
+gdk_headless_device_set_surface_cursor (GdkDevice  *device,
+                                        GdkSurface *surface,
+                                        GdkCursor  *cursor)
+{
+}
+
+static GdkGrabStatus
+gdk_headless_device_grab (GdkDevice    *device,
+                          GdkSurface   *surface,
+                          gboolean      owner_events,
+                          GdkEventMask  event_mask,
+                          GdkSurface   *confine_to,
+                          GdkCursor    *cursor,
+                          guint32       time_)
+{
+  return GDK_GRAB_SUCCESS;
+}
+
+static void
+gdk_headless_device_ungrab (GdkDevice *device,
+                            guint32    time_)
+{
+}
+
+static GdkSurface *
+gdk_headless_device_surface_at_position (GdkDevice       *device,
+                                         double          *win_x,
+                                         double          *win_y,
+                                         GdkModifierType *mask)
+{
+  if (win_x)
+    *win_x = 0;
+  if (win_y)
+    *win_y = 0;
+  if (mask)
+    *mask = 0;
+
+  return NULL;
+}
+
+static void
+gdk_headless_device_class_init (GdkHeadlessDeviceClass *klass)
+{
+  GdkDeviceClass *device_class = GDK_DEVICE_CLASS (klass);
+
+  device_class->set_surface_cursor = gdk_headless_device_set_surface_cursor;
+  device_class->grab = gdk_headless_device_grab;
+  device_class->ungrab = gdk_headless_device_ungrab;
+  device_class->surface_at_position = gdk_headless_device_surface_at_position;
+}
+
+static void
+gdk_headless_device_init (GdkHeadlessDevice *self)
+{
+  GdkDevice *device = GDK_DEVICE (self);
+
+  _gdk_device_add_axis (device, GDK_AXIS_X, 0, 0, 1);
+  _gdk_device_add_axis (device, GDK_AXIS_Y, 0, 0, 1);
+}
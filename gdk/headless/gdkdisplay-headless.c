@@ -0,0 +1,293 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprivate-headless.h"
+
+#include "gdkseatdefaultprivate.h"
+
+#include <stdlib.h>
+
+G_DEFINE_TYPE (GdkHeadlessDisplay, gdk_headless_display, GDK_TYPE_DISPLAY)
+
+#define DEFAULT_MONITORS "1024x768"
+
+static void
+gdk_headless_display_init (GdkHeadlessDisplay *self)
+{
+  self->monitors = g_list_store_new (GDK_TYPE_MONITOR);
+}
+
+/* Monitors are given as a comma-separated list of
+ * WIDTHxHEIGHT[@REFRESH][*SCALE], e.g. "1920x1080@60*2,1280x1024".
+ * Without a refresh rate, frames are not throttled at all.
+ */
+static gboolean
+parse_monitor (const char   *spec,
+               GdkRectangle *geometry,
+               int          *refresh_rate,
+               int          *scale)
+{
+  const char *p = spec;
+  char *end;
+
+  geometry->width = strtol (p, &end, 10);
+  if (end == p || *end != 'x' || geometry->width <= 0)
+    return FALSE;
+
+  p = end + 1;
+  geometry->height = strtol (p, &end, 10);
+  if (end == p || geometry->height <= 0)
+    return FALSE;
+
+  *refresh_rate = 0;
+  *scale = 1;
+
+  p = end;
+  if (*p == '@')
+    {
+      p++;
+      *refresh_rate = (int) (g_ascii_strtod (p, &end) * 1000);
+      if (end == p || *refresh_rate < 0)
+        return FALSE;
+      p = end;
+    }
+
+  if (*p == '*')
+    {
+      p++;
+      *scale = strtol (p, &end, 10);
+      if (end == p || *scale < 1)
+        return FALSE;
+      p = end;
+    }
+
+  return *p == '\0';
+}
+
+static void
+gdk_headless_display_add_monitors (GdkHeadlessDisplay *self,
+                                   const char         *specs)
+{
+  GdkDisplay *display = GDK_DISPLAY (self);
+  char **monitors;
+  int x = 0;
+  int i;
+
+  monitors = g_strsplit (specs, ",", 0);
+
+  for (i = 0; monitors[i]; i++)
+    {
+      GdkMonitor *monitor;
+      GdkRectangle geometry;
+      int refresh_rate, scale;
+      char *connector;
+
+      if (!parse_monitor (monitors[i], &geometry, &refresh_rate, &scale))
+        {
+          g_warning ("Invalid headless monitor \"%s\", expected WIDTHxHEIGHT[@REFRESH][*SCALE]",
+                     monitors[i]);
+          continue;
+        }
+
+      /* Monitors are lined up left to right */
+      geometry.x = x;
+      geometry.y = 0;
+      x += geometry.width;
+
+      connector = g_strdup_printf ("Headless-%d", i + 1);
+
+      monitor = g_object_new (GDK_TYPE_MONITOR,
+                              "display", display,
+                              NULL);
+      gdk_monitor_set_manufacturer (monitor, "GTK");
+      gdk_monitor_set_model (monitor, "Headless");
+      gdk_monitor_set_connector (monitor, connector);
+      gdk_monitor_set_geometry (monitor, &geometry);
+      gdk_monitor_set_physical_size (monitor,
+                                     geometry.width * 25.4 / 96,
+                                     geometry.height * 25.4 / 96);
+      gdk_monitor_set_scale_factor (monitor, scale);
+      gdk_monitor_set_refresh_rate (monitor, refresh_rate);
+
+      g_list_store_append (self->monitors, monitor);
+
+      g_object_unref (monitor);
+      g_free (connector);
+    }
+
+  g_strfreev (monitors);
+}
+
+static GdkDevice *
+create_device (GdkDisplay     *display,
+               const char     *name,
+               GdkInputSource  source,
+               gboolean        has_cursor)
+{
+  return g_object_new (GDK_TYPE_HEADLESS_DEVICE,
+                       "name", name,
+                       "source", source,
+                       "has-cursor", has_cursor,
+                       "display", display,
+                       NULL);
+}
+
+GdkDisplay *
+_gdk_headless_display_open (const char *display_name)
+{
+  GdkHeadlessDisplay *self;
+  GdkDisplay *display;
+  const char *monitors;
+  GdkSeat *seat;
+
+  display = g_object_new (GDK_TYPE_HEADLESS_DISPLAY, NULL);
+  self = GDK_HEADLESS_DISPLAY (display);
+
+  monitors = display_name;
+  if (monitors == NULL)
+    monitors = g_getenv ("GDK_HEADLESS_MONITORS");
+  if (monitors == NULL)
+    monitors = DEFAULT_MONITORS;
+
+  gdk_headless_display_add_monitors (self, monitors);
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->monitors)) == 0)
+    gdk_headless_display_add_monitors (self, DEFAULT_MONITORS);
+
+  self->core_pointer = create_device (display, "Core Pointer", GDK_SOURCE_MOUSE, TRUE);
+  self->core_keyboard = create_device (display, "Core Keyboard", GDK_SOURCE_KEYBOARD, FALSE);
+  _gdk_device_set_associated_device (self->core_pointer, self->core_keyboard);
+  _gdk_device_set_associated_device (self->core_keyboard, self->core_pointer);
+
+  seat = gdk_seat_default_new_for_logical_pair (self->core_pointer, self->core_keyboard);
+  gdk_display_add_seat (display, seat);
+  g_object_unref (seat);
+
+  g_signal_emit_by_name (display, "opened");
+
+  return display;
+}
+
+static const char *
+gdk_headless_display_get_name (GdkDisplay *display)
+{
+  return "Headless";
+}
+
+static void
+gdk_headless_display_beep (GdkDisplay *display)
+{
+}
+
+static void
+gdk_headless_display_sync (GdkDisplay *display)
+{
+}
+
+static void
+gdk_headless_display_flush (GdkDisplay *display)
+{
+}
+
+static gboolean
+gdk_headless_display_has_pending (GdkDisplay *display)
+{
+  return FALSE;
+}
+
+static void
+gdk_headless_display_queue_events (GdkDisplay *display)
+{
+}
+
+static gulong
+gdk_headless_display_get_next_serial (GdkDisplay *display)
+{
+  static gulong serial = 0;
+
+  return ++serial;
+}
+
+static void
+gdk_headless_display_notify_startup_complete (GdkDisplay *display,
+                                              const char *startup_id)
+{
+}
+
+static GListModel *
+gdk_headless_display_get_monitors (GdkDisplay *display)
+{
+  return G_LIST_MODEL (GDK_HEADLESS_DISPLAY (display)->monitors);
+}
+
+static gboolean
+gdk_headless_display_get_setting (GdkDisplay *display,
+                                  const char *name,
+                                  GValue     *value)
+{
+  return FALSE;
+}
+
+static void
+gdk_headless_display_dispose (GObject *object)
+{
+  GdkHeadlessDisplay *self = GDK_HEADLESS_DISPLAY (object);
+
+  g_list_store_remove_all (self->monitors);
+
+  G_OBJECT_CLASS (gdk_headless_display_parent_class)->dispose (object);
+}
+
+static void
+gdk_headless_display_finalize (GObject *object)
+{
+  GdkHeadlessDisplay *self = GDK_HEADLESS_DISPLAY (object);
+
+  g_clear_object (&self->monitors);
+  g_clear_object (&self->keymap);
+  g_clear_object (&self->core_pointer);
+  g_clear_object (&self->core_keyboard);
+
+  G_OBJECT_CLASS (gdk_headless_display_parent_class)->finalize (object);
+}
+
+static void
+gdk_headless_display_class_init (GdkHeadlessDisplayClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+  GdkDisplayClass *display_class = GDK_DISPLAY_CLASS (class);
+
+  object_class->dispose = gdk_headless_display_dispose;
+  object_class->finalize = gdk_headless_display_finalize;
+
+  display_class->cairo_context_type = GDK_TYPE_HEADLESS_CAIRO_CONTEXT;
+
+  display_class->get_name = gdk_headless_display_get_name;
+  display_class->beep = gdk_headless_display_beep;
+  display_class->sync = gdk_headless_display_sync;
+  display_class->flush = gdk_headless_display_flush;
+  display_class->has_pending = gdk_headless_display_has_pending;
+  display_class->queue_events = gdk_headless_display_queue_events;
+
+  display_class->get_next_serial = gdk_headless_display_get_next_serial;
+  display_class->notify_startup_complete = gdk_headless_display_notify_startup_complete;
+  display_class->create_surface = _gdk_headless_display_create_surface;
+  display_class->get_keymap = _gdk_headless_display_get_keymap;
+
+  display_class->get_monitors = gdk_headless_display_get_monitors;
+  display_class->get_setting = gdk_headless_display_get_setting;
+}
@@ -0,0 +1,104 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_PRIVATE_HEADLESS_H__
+#define __GDK_PRIVATE_HEADLESS_H__
+
+#include "gdkcairocontextprivate.h"
+#include "gdkdeviceprivate.h"
+#include "gdkdisplayprivate.h"
+#include "gdkinternals.h"
+#include "gdkkeysprivate.h"
+#include "gdkmonitorprivate.h"
+#include "gdksurfaceprivate.h"
+
+G_BEGIN_DECLS
+
+/* The headless backend has no windowing system behind it. Surfaces
+ * are drawn with cairo into memory, and their frame clocks run on a
+ * virtual refresh cycle instead of waiting for a compositor. It is
+ * meant for running tests and benchmarks without a display.
+ */
+
+#define GDK_TYPE_HEADLESS_DISPLAY       (gdk_headless_display_get_type ())
+#define GDK_HEADLESS_DISPLAY(object)    (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_HEADLESS_DISPLAY, GdkHeadlessDisplay))
+#define GDK_IS_HEADLESS_DISPLAY(object) (G_TYPE_CHECK_INSTANCE_TYPE ((object), GDK_TYPE_HEADLESS_DISPLAY))
+
+#define GDK_TYPE_HEADLESS_SURFACE       (gdk_headless_surface_get_type ())
+#define GDK_HEADLESS_SURFACE(object)    (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_HEADLESS_SURFACE, GdkHeadlessSurface))
+#define GDK_IS_HEADLESS_SURFACE(object) (G_TYPE_CHECK_INSTANCE_TYPE ((object), GDK_TYPE_HEADLESS_SURFACE))
+
+#define GDK_TYPE_HEADLESS_DEVICE        (gdk_headless_device_get_type ())
+
+#define GDK_TYPE_HEADLESS_CAIRO_CONTEXT       (gdk_headless_cairo_context_get_type ())
+#define GDK_HEADLESS_CAIRO_CONTEXT(object)    (G_TYPE_CHECK_INSTANCE_CAST ((object), GDK_TYPE_HEADLESS_CAIRO_CONTEXT, GdkHeadlessCairoContext))
+
+typedef struct _GdkHeadlessDisplay GdkHeadlessDisplay;
+typedef struct _GdkDisplayClass GdkHeadlessDisplayClass;
+typedef struct _GdkHeadlessSurface GdkHeadlessSurface;
+typedef struct _GdkSurfaceClass GdkHeadlessSurfaceClass;
+typedef struct _GdkHeadlessCairoContext GdkHeadlessCairoContext;
+typedef struct _GdkCairoContextClass GdkHeadlessCairoContextClass;
+
+struct _GdkHeadlessDisplay
+{
+  GdkDisplay parent_instance;
+
+  GListStore *monitors;
+  GdkKeymap *keymap;
+
+  GdkDevice *core_pointer;
+  GdkDevice *core_keyboard;
+};
+
+struct _GdkHeadlessSurface
+{
+  GdkSurface parent_instance;
+
+  /* The contents, kept between frames like a real surface would */
+  cairo_surface_t *content;
+
+  GdkGeometry geometry_hints;
+  GdkSurfaceHints geometry_hints_mask;
+
+  gint64 last_presentation_time;
+};
+
+struct _GdkHeadlessCairoContext
+{
+  GdkCairoContext parent_instance;
+};
+
+GType        gdk_headless_display_get_type       (void) G_GNUC_CONST;
+GType        gdk_headless_surface_get_type       (void) G_GNUC_CONST;
+GType        gdk_headless_device_get_type        (void) G_GNUC_CONST;
+GType        gdk_headless_cairo_context_get_type (void) G_GNUC_CONST;
+
+GdkDisplay * _gdk_headless_display_open          (const char     *display_name);
+GdkKeymap *  _gdk_headless_display_get_keymap    (GdkDisplay     *display);
+GdkSurface * _gdk_headless_display_create_surface (GdkDisplay    *display,
+                                                  GdkSurfaceType  surface_type,
+                                                  GdkSurface     *parent,
+                                                  int             x,
+                                                  int             y,
+                                                  int             width,
+                                                  int             height);
+
+cairo_surface_t * gdk_headless_surface_ensure_content (GdkHeadlessSurface *self);
+
+G_END_DECLS
+
+#endif /* __GDK_PRIVATE_HEADLESS_H__ */
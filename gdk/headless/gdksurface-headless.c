@@ -0,0 +1,781 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprivate-headless.h"
+
+#include "gdkdragsurfaceprivate.h"
+#include "gdkframeclockidleprivate.h"
+#include "gdkframeclockprivate.h"
+#include "gdkpopupprivate.h"
+#include "gdkprofilerprivate.h"
+#include "gdktoplevelprivate.h"
+
+G_DEFINE_TYPE (GdkHeadlessSurface, gdk_headless_surface, GDK_TYPE_SURFACE)
+
+#define GDK_TYPE_HEADLESS_TOPLEVEL      (gdk_headless_toplevel_get_type ())
+#define GDK_TYPE_HEADLESS_POPUP         (gdk_headless_popup_get_type ())
+#define GDK_TYPE_HEADLESS_DRAG_SURFACE  (gdk_headless_drag_surface_get_type ())
+
+GType gdk_headless_toplevel_get_type     (void) G_GNUC_CONST;
+GType gdk_headless_popup_get_type        (void) G_GNUC_CONST;
+GType gdk_headless_drag_surface_get_type (void) G_GNUC_CONST;
+
+static void
+gdk_headless_surface_init (GdkHeadlessSurface *self)
+{
+}
+
+static int
+gdk_headless_surface_get_scale_factor (GdkSurface *surface)
+{
+  GdkMonitor *monitor;
+
+  if (GDK_SURFACE_DESTROYED (surface))
+    return 1;
+
+  monitor = gdk_display_get_monitor_at_surface (gdk_surface_get_display (surface), surface);
+  if (monitor == NULL)
+    return 1;
+
+  return gdk_monitor_get_scale_factor (monitor);
+}
+
+/*< private >
+ * gdk_headless_surface_ensure_content:
+ *
+ * Makes sure there is an image surface matching the current size
+ * and scale to draw into, creating a new, empty one if needed.
+ *
+ * Returns: (transfer none): the contents of @self
+ */
+cairo_surface_t *
+gdk_headless_surface_ensure_content (GdkHeadlessSurface *self)
+{
+  GdkSurface *surface = GDK_SURFACE (self);
+  int scale;
+
+  if (self->content)
+    return self->content;
+
+  scale = gdk_surface_get_scale_factor (surface);
+
+  self->content = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                              MAX (1, surface->width) * scale,
+                                              MAX (1, surface->height) * scale);
+  cairo_surface_set_device_scale (self->content, scale, scale);
+
+  return self->content;
+}
+
+/* There is nobody to present the frame to, so it counts as presented
+ * as soon as it is drawn. The refresh interval of the monitor paces
+ * the frame clock; without one, frames are drawn back to back.
+ */
+static void
+on_frame_clock_after_paint (GdkFrameClock *clock,
+                            GdkSurface    *surface)
+{
+  GdkHeadlessSurface *self = GDK_HEADLESS_SURFACE (surface);
+  GdkFrameTimings *timings;
+  GdkMonitor *monitor;
+  int refresh_rate = 0;
+
+  timings = gdk_frame_clock_get_current_timings (clock);
+  if (timings == NULL)
+    return;
+
+  monitor = gdk_display_get_monitor_at_surface (gdk_surface_get_display (surface), surface);
+  if (monitor)
+    refresh_rate = gdk_monitor_get_refresh_rate (monitor);
+
+  if (refresh_rate > 0)
+    timings->refresh_interval = (G_GINT64_CONSTANT (1000000000) + refresh_rate / 2) / refresh_rate;
+  else
+    timings->refresh_interval = 1;
+
+  timings->presentation_time = MAX (timings->frame_time, self->last_presentation_time + 1);
+  timings->complete = TRUE;
+
+  self->last_presentation_time = timings->presentation_time;
+
+#ifdef G_ENABLE_DEBUG
+  if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+    _gdk_frame_clock_debug_print_timings (clock, timings);
+
+  if (GDK_PROFILER_IS_RUNNING)
+    _gdk_frame_clock_add_timings_to_profiler (clock, timings);
+#endif
+}
+
+static void
+connect_frame_clock (GdkSurface *surface)
+{
+  GdkFrameClock *frame_clock = gdk_surface_get_frame_clock (surface);
+
+  g_signal_connect (frame_clock, "after-paint",
+                    G_CALLBACK (on_frame_clock_after_paint), surface);
+}
+
+static void
+disconnect_frame_clock (GdkSurface *surface)
+{
+  GdkFrameClock *frame_clock = gdk_surface_get_frame_clock (surface);
+
+  g_signal_handlers_disconnect_by_func (frame_clock,
+                                        on_frame_clock_after_paint, surface);
+}
+
+GdkSurface *
+_gdk_headless_display_create_surface (GdkDisplay     *display,
+                                      GdkSurfaceType  surface_type,
+                                      GdkSurface     *parent,
+                                      int             x,
+                                      int             y,
+                                      int             width,
+                                      int             height)
+{
+  GdkFrameClock *frame_clock;
+  GdkSurface *surface;
+  GType type;
+
+  if (parent)
+    frame_clock = g_object_ref (gdk_surface_get_frame_clock (parent));
+  else
+    frame_clock = _gdk_frame_clock_idle_new ();
+
+  switch (surface_type)
+    {
+    case GDK_SURFACE_TOPLEVEL:
+      type = GDK_TYPE_HEADLESS_TOPLEVEL;
+      break;
+    case GDK_SURFACE_POPUP:
+      type = GDK_TYPE_HEADLESS_POPUP;
+      break;
+    case GDK_SURFACE_TEMP:
+      type = GDK_TYPE_HEADLESS_DRAG_SURFACE;
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+    }
+
+  surface = g_object_new (type,
+                          "display", display,
+                          "frame-clock", frame_clock,
+                          NULL);
+
+  g_object_unref (frame_clock);
+
+  surface->parent = parent;
+  surface->x = x;
+  surface->y = y;
+  surface->width = width;
+  surface->height = height;
+
+  connect_frame_clock (surface);
+
+  return surface;
+}
+
+static void
+gdk_headless_surface_finalize (GObject *object)
+{
+  GdkHeadlessSurface *self = GDK_HEADLESS_SURFACE (object);
+
+  g_clear_pointer (&self->content, cairo_surface_destroy);
+
+  G_OBJECT_CLASS (gdk_headless_surface_parent_class)->finalize (object);
+}
+
+static cairo_surface_t *
+gdk_headless_surface_ref_cairo_surface (GdkSurface *surface)
+{
+  if (GDK_SURFACE_DESTROYED (surface))
+    return NULL;
+
+  return cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+}
+
+static void
+gdk_headless_surface_destroy (GdkSurface *surface,
+                              gboolean    foreign_destroy)
+{
+  GdkHeadlessSurface *self = GDK_HEADLESS_SURFACE (surface);
+
+  disconnect_frame_clock (surface);
+
+  g_clear_pointer (&self->content, cairo_surface_destroy);
+}
+
+static void
+gdk_headless_surface_destroy_notify (GdkSurface *surface)
+{
+  if (!GDK_SURFACE_DESTROYED (surface))
+    _gdk_surface_destroy (surface, TRUE);
+}
+
+static void
+gdk_headless_surface_hide (GdkSurface *surface)
+{
+  _gdk_surface_clear_update_area (surface);
+}
+
+static void
+gdk_headless_surface_get_geometry (GdkSurface *surface,
+                                   int        *x,
+                                   int        *y,
+                                   int        *width,
+                                   int        *height)
+{
+  if (x)
+    *x = surface->x;
+  if (y)
+    *y = surface->y;
+  if (width)
+    *width = surface->width;
+  if (height)
+    *height = surface->height;
+}
+
+static void
+gdk_headless_surface_get_root_coords (GdkSurface *surface,
+                                      int         x,
+                                      int         y,
+                                      int        *root_x,
+                                      int        *root_y)
+{
+  GdkSurface *s;
+
+  for (s = surface; s != NULL; s = s->parent)
+    {
+      x += s->x;
+      y += s->y;
+    }
+
+  if (root_x)
+    *root_x = x;
+  if (root_y)
+    *root_y = y;
+}
+
+static gboolean
+gdk_headless_surface_get_device_state (GdkSurface      *surface,
+                                       GdkDevice       *device,
+                                       double          *x,
+                                       double          *y,
+                                       GdkModifierType *mask)
+{
+  *x = -1;
+  *y = -1;
+  *mask = 0;
+
+  return FALSE;
+}
+
+static void
+gdk_headless_surface_set_input_region (GdkSurface     *surface,
+                                       cairo_region_t *shape_region)
+{
+}
+
+static GdkDrag *
+gdk_headless_surface_drag_begin (GdkSurface         *surface,
+                                 GdkDevice          *device,
+                                 GdkContentProvider *content,
+                                 GdkDragAction       actions,
+                                 double              dx,
+                                 double              dy)
+{
+  return NULL;
+}
+
+static void
+gdk_headless_surface_class_init (GdkHeadlessSurfaceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GdkSurfaceClass *impl_class = GDK_SURFACE_CLASS (klass);
+
+  object_class->finalize = gdk_headless_surface_finalize;
+
+  impl_class->ref_cairo_surface = gdk_headless_surface_ref_cairo_surface;
+  impl_class->hide = gdk_headless_surface_hide;
+  impl_class->get_geometry = gdk_headless_surface_get_geometry;
+  impl_class->get_root_coords = gdk_headless_surface_get_root_coords;
+  impl_class->get_device_state = gdk_headless_surface_get_device_state;
+  impl_class->set_input_region = gdk_headless_surface_set_input_region;
+  impl_class->destroy = gdk_headless_surface_destroy;
+  impl_class->destroy_notify = gdk_headless_surface_destroy_notify;
+  impl_class->drag_begin = gdk_headless_surface_drag_begin;
+  impl_class->get_scale_factor = gdk_headless_surface_get_scale_factor;
+}
+
+static void
+gdk_headless_surface_move_resize (GdkSurface *surface,
+                                  gboolean    with_move,
+                                  int         x,
+                                  int         y,
+                                  int         width,
+                                  int         height)
+{
+  if (with_move)
+    {
+      surface->x = x;
+      surface->y = y;
+    }
+
+  width = MAX (1, width);
+  height = MAX (1, height);
+
+  if (width != surface->width || height != surface->height)
+    {
+      surface->width = width;
+      surface->height = height;
+      _gdk_surface_update_size (surface);
+    }
+}
+
+static void
+show_surface (GdkSurface *surface)
+{
+  if (surface->destroyed || GDK_SURFACE_IS_MAPPED (surface))
+    return;
+
+  gdk_synthesize_surface_state (surface, GDK_TOPLEVEL_STATE_WITHDRAWN, 0);
+  gdk_surface_invalidate_rect (surface, NULL);
+}
+
+#define LAST_PROP 1
+
+typedef struct
+{
+  GdkHeadlessSurface parent_instance;
+} GdkHeadlessPopup;
+
+typedef struct
+{
+  GdkHeadlessSurfaceClass parent_class;
+} GdkHeadlessPopupClass;
+
+static void gdk_headless_popup_iface_init (GdkPopupInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GdkHeadlessPopup, gdk_headless_popup, GDK_TYPE_HEADLESS_SURFACE,
+                         G_IMPLEMENT_INTERFACE (GDK_TYPE_POPUP,
+                                                gdk_headless_popup_iface_init))
+
+static void
+gdk_headless_popup_init (GdkHeadlessPopup *popup)
+{
+}
+
+static void
+gdk_headless_popup_get_property (GObject    *object,
+                                 guint       prop_id,
+                                 GValue     *value,
+                                 GParamSpec *pspec)
+{
+  GdkSurface *surface = GDK_SURFACE (object);
+
+  switch (prop_id)
+    {
+    case LAST_PROP + GDK_POPUP_PROP_PARENT:
+      g_value_set_object (value, surface->parent);
+      break;
+
+    case LAST_PROP + GDK_POPUP_PROP_AUTOHIDE:
+      g_value_set_boolean (value, surface->autohide);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gdk_headless_popup_set_property (GObject      *object,
+                                 guint         prop_id,
+                                 const GValue *value,
+                                 GParamSpec   *pspec)
+{
+  GdkSurface *surface = GDK_SURFACE (object);
+
+  switch (prop_id)
+    {
+    case LAST_PROP + GDK_POPUP_PROP_PARENT:
+      surface->parent = g_value_dup_object (value);
+      if (surface->parent != NULL)
+        surface->parent->children = g_list_prepend (surface->parent->children, surface);
+      break;
+
+    case LAST_PROP + GDK_POPUP_PROP_AUTOHIDE:
+      surface->autohide = g_value_get_boolean (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gdk_headless_popup_class_init (GdkHeadlessPopupClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->get_property = gdk_headless_popup_get_property;
+  object_class->set_property = gdk_headless_popup_set_property;
+
+  gdk_popup_install_properties (object_class, 1);
+}
+
+static gboolean
+gdk_headless_popup_present (GdkPopup       *popup,
+                            int             width,
+                            int             height,
+                            GdkPopupLayout *layout)
+{
+  GdkSurface *surface = GDK_SURFACE (popup);
+  GdkMonitor *monitor;
+  GdkRectangle bounds;
+  GdkRectangle final_rect;
+
+  monitor = gdk_surface_get_layout_monitor (surface, layout,
+                                            gdk_monitor_get_geometry);
+  gdk_monitor_get_geometry (monitor, &bounds);
+
+  gdk_surface_layout_popup_helper (surface,
+                                   width,
+                                   height,
+                                   monitor,
+                                   &bounds,
+                                   layout,
+                                   &final_rect);
+
+  gdk_headless_surface_move_resize (surface, TRUE,
+                                    final_rect.x, final_rect.y,
+                                    final_rect.width, final_rect.height);
+
+  show_surface (surface);
+
+  return TRUE;
+}
+
+static GdkGravity
+gdk_headless_popup_get_surface_anchor (GdkPopup *popup)
+{
+  return GDK_SURFACE (popup)->popup.surface_anchor;
+}
+
+static GdkGravity
+gdk_headless_popup_get_rect_anchor (GdkPopup *popup)
+{
+  return GDK_SURFACE (popup)->popup.rect_anchor;
+}
+
+static int
+gdk_headless_popup_get_position_x (GdkPopup *popup)
+{
+  return GDK_SURFACE (popup)->x;
+}
+
+static int
+gdk_headless_popup_get_position_y (GdkPopup *popup)
+{
+  return GDK_SURFACE (popup)->y;
+}
+
+static void
+gdk_headless_popup_iface_init (GdkPopupInterface *iface)
+{
+  iface->present = gdk_headless_popup_present;
+  iface->get_surface_anchor = gdk_headless_popup_get_surface_anchor;
+  iface->get_rect_anchor = gdk_headless_popup_get_rect_anchor;
+  iface->get_position_x = gdk_headless_popup_get_position_x;
+  iface->get_position_y = gdk_headless_popup_get_position_y;
+}
+
+typedef struct
+{
+  GdkHeadlessSurface parent_instance;
+} GdkHeadlessToplevel;
+
+typedef struct
+{
+  GdkHeadlessSurfaceClass parent_class;
+} GdkHeadlessToplevelClass;
+
+static void gdk_headless_toplevel_iface_init (GdkToplevelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GdkHeadlessToplevel, gdk_headless_toplevel, GDK_TYPE_HEADLESS_SURFACE,
+                         G_IMPLEMENT_INTERFACE (GDK_TYPE_TOPLEVEL,
+                                                gdk_headless_toplevel_iface_init))
+
+static void
+gdk_headless_toplevel_init (GdkHeadlessToplevel *toplevel)
+{
+}
+
+static void
+gdk_headless_toplevel_set_property (GObject      *object,
+                                    guint         prop_id,
+                                    const GValue *value,
+                                    GParamSpec   *pspec)
+{
+  switch (prop_id)
+    {
+    case LAST_PROP + GDK_TOPLEVEL_PROP_TITLE:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_TRANSIENT_FOR:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_STARTUP_ID:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_MODAL:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_ICON_LIST:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_DECORATED:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_DELETABLE:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_SHORTCUTS_INHIBITED:
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gdk_headless_toplevel_get_property (GObject    *object,
+                                    guint       prop_id,
+                                    GValue     *value,
+                                    GParamSpec *pspec)
+{
+  GdkSurface *surface = GDK_SURFACE (object);
+
+  switch (prop_id)
+    {
+    case LAST_PROP + GDK_TOPLEVEL_PROP_STATE:
+      g_value_set_flags (value, surface->state);
+      break;
+
+    case LAST_PROP + GDK_TOPLEVEL_PROP_TITLE:
+      g_value_set_string (value, "");
+      break;
+
+    case LAST_PROP + GDK_TOPLEVEL_PROP_STARTUP_ID:
+      g_value_set_string (value, "");
+      break;
+
+    case LAST_PROP + GDK_TOPLEVEL_PROP_TRANSIENT_FOR:
+      g_value_set_object (value, NULL);
+      break;
+
+    case LAST_PROP + GDK_TOPLEVEL_PROP_ICON_LIST:
+      g_value_set_pointer (value, NULL);
+      break;
+
+    case LAST_PROP + GDK_TOPLEVEL_PROP_MODAL:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_DECORATED:
+    case LAST_PROP + GDK_TOPLEVEL_PROP_DELETABLE:
+      break;
+
+    case LAST_PROP + GDK_TOPLEVEL_PROP_SHORTCUTS_INHIBITED:
+      g_value_set_boolean (value, surface->shortcuts_inhibited);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+gdk_headless_toplevel_class_init (GdkHeadlessToplevelClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->get_property = gdk_headless_toplevel_get_property;
+  object_class->set_property = gdk_headless_toplevel_set_property;
+
+  gdk_toplevel_install_properties (object_class, 1);
+}
+
+static gboolean
+gdk_headless_toplevel_present (GdkToplevel       *toplevel,
+                               GdkToplevelLayout *layout)
+{
+  GdkSurface *surface = GDK_SURFACE (toplevel);
+  GdkHeadlessSurface *self = GDK_HEADLESS_SURFACE (surface);
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkMonitor *monitor;
+  GdkToplevelSize size;
+  int bounds_width, bounds_height;
+  int width, height;
+
+  monitor = gdk_display_get_monitor_at_surface (display, surface);
+  if (monitor)
+    {
+      GdkRectangle monitor_geometry;
+
+      gdk_monitor_get_geometry (monitor, &monitor_geometry);
+      bounds_width = monitor_geometry.width;
+      bounds_height = monitor_geometry.height;
+    }
+  else
+    {
+      bounds_width = G_MAXINT;
+      bounds_height = G_MAXINT;
+    }
+
+  gdk_toplevel_size_init (&size, bounds_width, bounds_height);
+  gdk_toplevel_notify_compute_size (toplevel, &size);
+  g_warn_if_fail (size.width > 0);
+  g_warn_if_fail (size.height > 0);
+  width = size.width;
+  height = size.height;
+
+  if (gdk_toplevel_layout_get_resizable (layout))
+    {
+      self->geometry_hints.min_width = size.min_width;
+      self->geometry_hints.min_height = size.min_height;
+      self->geometry_hints_mask = GDK_HINT_MIN_SIZE;
+    }
+  else
+    {
+      self->geometry_hints.max_width = self->geometry_hints.min_width = width;
+      self->geometry_hints.max_height = self->geometry_hints.min_height = height;
+      self->geometry_hints_mask = GDK_HINT_MIN_SIZE | GDK_HINT_MAX_SIZE;
+    }
+  gdk_surface_constrain_size (&self->geometry_hints, self->geometry_hints_mask,
+                              width, height, &width, &height);
+
+  if (gdk_toplevel_layout_get_maximized (layout) && monitor)
+    {
+      gdk_surface_constrain_size (&self->geometry_hints, self->geometry_hints_mask,
+                                  bounds_width, bounds_height, &width, &height);
+      gdk_synthesize_surface_state (surface, 0, GDK_TOPLEVEL_STATE_MAXIMIZED);
+    }
+  else
+    {
+      gdk_synthesize_surface_state (surface, GDK_TOPLEVEL_STATE_MAXIMIZED, 0);
+    }
+
+  gdk_headless_surface_move_resize (surface, FALSE, 0, 0, width, height);
+
+  show_surface (surface);
+
+  return TRUE;
+}
+
+static gboolean
+gdk_headless_toplevel_minimize (GdkToplevel *toplevel)
+{
+  return FALSE;
+}
+
+static gboolean
+gdk_headless_toplevel_lower (GdkToplevel *toplevel)
+{
+  return FALSE;
+}
+
+static void
+gdk_headless_toplevel_focus (GdkToplevel *toplevel,
+                             guint32      timestamp)
+{
+}
+
+static gboolean
+gdk_headless_toplevel_show_window_menu (GdkToplevel *toplevel,
+                                        GdkEvent    *event)
+{
+  return FALSE;
+}
+
+static void
+gdk_headless_toplevel_begin_resize (GdkToplevel    *toplevel,
+                                    GdkSurfaceEdge  edge,
+                                    GdkDevice      *device,
+                                    int             button,
+                                    double          x,
+                                    double          y,
+                                    guint32         timestamp)
+{
+}
+
+static void
+gdk_headless_toplevel_begin_move (GdkToplevel *toplevel,
+                                  GdkDevice   *device,
+                                  int          button,
+                                  double       x,
+                                  double       y,
+                                  guint32      timestamp)
+{
+}
+
+static void
+gdk_headless_toplevel_iface_init (GdkToplevelInterface *iface)
+{
+  iface->present = gdk_headless_toplevel_present;
+  iface->minimize = gdk_headless_toplevel_minimize;
+  iface->lower = gdk_headless_toplevel_lower;
+  iface->focus = gdk_headless_toplevel_focus;
+  iface->show_window_menu = gdk_headless_toplevel_show_window_menu;
+  iface->begin_resize = gdk_headless_toplevel_begin_resize;
+  iface->begin_move = gdk_headless_toplevel_begin_move;
+}
+
+typedef struct
+{
+  GdkHeadlessSurface parent_instance;
+} GdkHeadlessDragSurface;
+
+typedef struct
+{
+  GdkHeadlessSurfaceClass parent_class;
+} GdkHeadlessDragSurfaceClass;
+
+static void gdk_headless_drag_surface_iface_init (GdkDragSurfaceInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (GdkHeadlessDragSurface, gdk_headless_drag_surface, GDK_TYPE_HEADLESS_SURFACE,
+                         G_IMPLEMENT_INTERFACE (GDK_TYPE_DRAG_SURFACE,
+                                                gdk_headless_drag_surface_iface_init))
+
+static void
+gdk_headless_drag_surface_init (GdkHeadlessDragSurface *surface)
+{
+}
+
+static void
+gdk_headless_drag_surface_class_init (GdkHeadlessDragSurfaceClass *class)
+{
+}
+
+static gboolean
+gdk_headless_drag_surface_present (GdkDragSurface *drag_surface,
+                                   int             width,
+                                   int             height)
+{
+  GdkSurface *surface = GDK_SURFACE (drag_surface);
+
+  gdk_headless_surface_move_resize (surface, FALSE, 0, 0, width, height);
+  show_surface (surface);
+
+  return TRUE;
+}
+
+static void
+gdk_headless_drag_surface_iface_init (GdkDragSurfaceInterface *iface)
+{
+  iface->present = gdk_headless_drag_surface_present;
+}
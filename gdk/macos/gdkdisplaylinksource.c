@@ -75,8 +75,11 @@ gdk_display_link_source_finalize (GSource *source)
 {
   GdkDisplayLinkSource *impl = (GdkDisplayLinkSource *)source;
 
-  CVDisplayLinkStop (impl->display_link);
-  CVDisplayLinkRelease (impl->display_link);
+  if (impl->display_link != NULL)
+    {
+      CVDisplayLinkStop (impl->display_link);
+      CVDisplayLinkRelease (impl->display_link);
+    }
 }
 
 static GSourceFuncs gdk_display_link_source_funcs = {
@@ -89,13 +92,15 @@ static GSourceFuncs gdk_display_link_source_funcs = {
 void
 gdk_display_link_source_pause (GdkDisplayLinkSource *source)
 {
-  CVDisplayLinkStop (source->display_link);
+  if (source->display_link != NULL)
+    CVDisplayLinkStop (source->display_link);
 }
 
 void
 gdk_display_link_source_unpause (GdkDisplayLinkSource *source)
 {
-  CVDisplayLinkStart (source->display_link);
+  if (source->display_link != NULL)
+    CVDisplayLinkStart (source->display_link);
 }
 
 static CVReturn
@@ -114,6 +119,15 @@ gdk_display_link_source_frame_cb (CVDisplayLinkRef   display_link,
 
   presentation_time = host_to_frame_clock_time (inOutputTime->hostTime);
 
+  /* Variable refresh rate panels (such as ProMotion) change their period
+   * from frame to frame, so prefer what the link tells us for this one
+   * over the nominal period we calculated up front.
+   */
+  if ((inOutputTime->flags & kCVTimeStampVideoRefreshPeriodValid) &&
+      inOutputTime->videoTimeScale != 0 &&
+      inOutputTime->videoRefreshPeriod != 0)
+    impl->refresh_interval = inOutputTime->videoRefreshPeriod * G_USEC_PER_SEC / inOutputTime->videoTimeScale;
+
   impl->presentation_time = presentation_time;
   impl->needs_dispatch = TRUE;
 
@@ -146,10 +160,16 @@ gdk_display_link_source_frame_cb (CVDisplayLinkRef   display_link,
 
 /**
  * gdk_display_link_source_new:
+ * @display_id: the display to follow, or %kCGNullDirectDisplay
  *
  * Creates a new #GSource that will activate the dispatch function upon
  * notification from a CVDisplayLink that a new frame should be drawn.
  *
+ * The link follows the vertical blank of @display_id so that surfaces
+ * on monitors with different refresh rates each get their own pace. If
+ * @display_id is %kCGNullDirectDisplay, a link that tries to work for all
+ * of the currently connected displays is used instead.
+ *
  * Effort is made to keep the transition from the high-priority
  * CVDisplayLink thread into this GSource lightweight. However, this is
  * somewhat non-ideal since the best case would be to do the drawing
@@ -158,7 +178,7 @@ gdk_display_link_source_frame_cb (CVDisplayLinkRef   display_link,
  * Returns: (transfer full): A newly created #GSource.
  */
 GSource *
-gdk_display_link_source_new (void)
+gdk_display_link_source_new (CGDirectDisplayID display_id)
 {
   GdkDisplayLinkSource *impl;
   GSource *source;
@@ -168,13 +188,11 @@ gdk_display_link_source_new (void)
   source = g_source_new (&gdk_display_link_source_funcs, sizeof *impl);
   impl = (GdkDisplayLinkSource *)source;
 
-  /*
-   * Create our link based on currently connected displays.
-   * If there are multiple displays, this will be something that tries
-   * to work for all of them. In the future, we may want to explore multiple
-   * links based on the connected displays.
-   */
-  ret = CVDisplayLinkCreateWithActiveCGDisplays (&impl->display_link);
+  if (display_id != kCGNullDirectDisplay)
+    ret = CVDisplayLinkCreateWithCGDisplay (display_id, &impl->display_link);
+  else
+    ret = CVDisplayLinkCreateWithActiveCGDisplays (&impl->display_link);
+
   if (ret != kCVReturnSuccess)
     {
       g_warning ("Failed to initialize CVDisplayLink!");
@@ -182,9 +200,18 @@ gdk_display_link_source_new (void)
     }
 
   /*
-   * Determine our nominal period between frames.
+   * Determine our nominal period between frames. The actual period is
+   * only known once the link has been running for a while, so fall back
+   * to the nominal one reported for the display mode.
    */
   period = CVDisplayLinkGetActualOutputVideoRefreshPeriod (impl->display_link);
+  if (period == 0.0)
+    {
+      CVTime nominal = CVDisplayLinkGetNominalOutputVideoRefreshPeriod (impl->display_link);
+
+      if (!(nominal.flags & kCVTimeIsIndefinite) && nominal.timeScale != 0)
+        period = (double)nominal.timeValue / (double)nominal.timeScale;
+    }
   if (period == 0.0)
     period = 1.0 / 60.0;
   impl->refresh_interval = period * 1000000L;
@@ -33,14 +33,14 @@ typedef struct
   GSource          source;
 
   CVDisplayLinkRef display_link;
-  gint64           refresh_interval;
+  volatile gint64  refresh_interval;
   guint            refresh_rate;
 
   volatile gint64  presentation_time;
   volatile guint   needs_dispatch;
 } GdkDisplayLinkSource;
 
-GSource *gdk_display_link_source_new     (void);
+GSource *gdk_display_link_source_new     (CGDirectDisplayID     display_id);
 void     gdk_display_link_source_pause   (GdkDisplayLinkSource *source);
 void     gdk_display_link_source_unpause (GdkDisplayLinkSource *source);
 
@@ -287,7 +287,10 @@ _gdk_macos_display_reload_monitors (GdkMacosDisplay *self)
         }
 
       if (!found)
-        g_list_store_remove (self->monitors, i - 1);
+        {
+          _gdk_macos_monitor_release_frames (monitor);
+          g_list_store_remove (self->monitors, i - 1);
+        }
     }
 
   g_array_unref (seen);
@@ -345,7 +348,7 @@ gdk_macos_display_frame_cb (gpointer data)
 static void
 gdk_macos_display_load_display_link (GdkMacosDisplay *self)
 {
-  self->frame_source = gdk_display_link_source_new ();
+  self->frame_source = gdk_display_link_source_new (kCGNullDirectDisplay);
   g_source_set_callback (self->frame_source,
                          gdk_macos_display_frame_cb,
                          self,
@@ -425,10 +428,15 @@ gdk_macos_display_queue_events (GdkDisplay *display)
 {
   GdkMacosDisplay *self = (GdkMacosDisplay *)display;
   NSEvent *nsevent;
+  guint n_events = 0;
 
   g_return_if_fail (GDK_IS_MACOS_DISPLAY (self));
 
-  if ((nsevent = _gdk_macos_event_source_get_pending ()))
+  /* Translate what is pending in one pass, so that a whole batch of
+   * events gets dispatched before the frame clock runs.
+   */
+  while (n_events++ < GDK_MAX_EVENTS_PER_FRAME &&
+         (nsevent = _gdk_macos_event_source_get_pending ()))
     {
       GdkEvent *event = _gdk_macos_display_translate (self, nsevent);
 
@@ -482,8 +490,7 @@ _gdk_macos_display_surface_removed (GdkMacosDisplay *self,
   if (queue_contains (&self->main_surfaces, &surface->main))
     _gdk_macos_display_surface_resigned_main (self, surface);
 
-  if (queue_contains (&self->awaiting_frames, &surface->frame))
-    g_queue_unlink (&self->awaiting_frames, &surface->frame);
+  _gdk_macos_display_remove_frame_callback (self, surface);
 
   g_return_if_fail (self->keyboard_surface != surface);
 }
@@ -910,14 +917,6 @@ _gdk_macos_display_break_all_grabs (GdkMacosDisplay *self,
     }
 }
 
-void
-_gdk_macos_display_queue_events (GdkMacosDisplay *self)
-{
-  g_return_if_fail (GDK_IS_MACOS_DISPLAY (self));
-
-  gdk_macos_display_queue_events (GDK_DISPLAY (self));
-}
-
 static GdkMacosSurface *
 _gdk_macos_display_get_surface_at_coords (GdkMacosDisplay *self,
                                           int              x,
@@ -986,16 +985,27 @@ void
 _gdk_macos_display_add_frame_callback (GdkMacosDisplay *self,
                                        GdkMacosSurface *surface)
 {
+  GdkMonitor *monitor;
+
   g_return_if_fail (GDK_IS_MACOS_DISPLAY (self));
   g_return_if_fail (GDK_IS_MACOS_SURFACE (surface));
 
-  if (!queue_contains (&self->awaiting_frames, &surface->frame))
-    {
-      g_queue_push_tail_link (&self->awaiting_frames, &surface->frame);
+  if (surface->frame_monitor != NULL ||
+      queue_contains (&self->awaiting_frames, &surface->frame))
+    return;
 
-      if (self->awaiting_frames.length == 1)
-        gdk_display_link_source_unpause ((GdkDisplayLinkSource *)self->frame_source);
-    }
+  /* Prefer the link of the monitor the surface is mostly on so that it
+   * is paced at that monitor's refresh rate.
+   */
+  monitor = _gdk_macos_surface_get_best_monitor (surface);
+  if (monitor != NULL &&
+      _gdk_macos_monitor_add_frame_callback (GDK_MACOS_MONITOR (monitor), surface))
+    return;
+
+  g_queue_push_tail_link (&self->awaiting_frames, &surface->frame);
+
+  if (self->awaiting_frames.length == 1)
+    gdk_display_link_source_unpause ((GdkDisplayLinkSource *)self->frame_source);
 }
 
 void
@@ -1005,7 +1015,9 @@ _gdk_macos_display_remove_frame_callback (GdkMacosDisplay *self,
   g_return_if_fail (GDK_IS_MACOS_DISPLAY (self));
   g_return_if_fail (GDK_IS_MACOS_SURFACE (surface));
 
-  if (queue_contains (&self->awaiting_frames, &surface->frame))
+  if (surface->frame_monitor != NULL)
+    _gdk_macos_monitor_remove_frame_callback (surface->frame_monitor, surface);
+  else if (queue_contains (&self->awaiting_frames, &surface->frame))
     {
       g_queue_unlink (&self->awaiting_frames, &surface->frame);
 
@@ -672,7 +672,9 @@ gdk_macos_event_source_prepare (GSource *source,
 
   *timeout = -1;
 
-  if (event_source->display->event_pause_count > 0)
+  if (_gdk_display_events_throttled (event_source->display, timeout))
+    retval = FALSE;
+  else if (event_source->display->event_pause_count > 0)
     retval = _gdk_event_queue_find_first (event_source->display) != NULL;
   else
     retval = (_gdk_event_queue_find_first (event_source->display) != NULL ||
@@ -687,7 +689,9 @@ gdk_macos_event_source_check (GSource *source)
   GdkMacosEventSource *event_source = (GdkMacosEventSource *)source;
   gboolean retval;
 
-  if (event_source->display->event_pause_count > 0)
+  if (_gdk_display_events_throttled (event_source->display, NULL))
+    retval = FALSE;
+  else if (event_source->display->event_pause_count > 0)
     retval = _gdk_event_queue_find_first (event_source->display) != NULL;
   else
     retval = (_gdk_event_queue_find_first (event_source->display) != NULL ||
@@ -702,18 +706,8 @@ gdk_macos_event_source_dispatch (GSource     *source,
                                  gpointer     user_data)
 {
   GdkMacosEventSource *event_source = (GdkMacosEventSource *)source;
-  GdkEvent *event;
 
-  _gdk_macos_display_queue_events (GDK_MACOS_DISPLAY (event_source->display));
-
-  event = _gdk_event_unqueue (event_source->display);
-
-  if (event)
-    {
-      _gdk_event_emit (event);
-
-      gdk_event_unref (event);
-    }
+  _gdk_display_dispatch_events (event_source->display);
 
   return TRUE;
 }
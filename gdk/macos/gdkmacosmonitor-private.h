@@ -24,15 +24,21 @@
 
 #include "gdkmacosdisplay.h"
 #include "gdkmacosmonitor.h"
+#include "gdkmacossurface.h"
 
 #include "gdkmonitorprivate.h"
 
 G_BEGIN_DECLS
 
-GdkMacosMonitor   *_gdk_macos_monitor_new           (GdkMacosDisplay   *display,
-                                                     CGDirectDisplayID  screen_id);
-CGDirectDisplayID  _gdk_macos_monitor_get_screen_id (GdkMacosMonitor   *self);
-gboolean           _gdk_macos_monitor_reconfigure   (GdkMacosMonitor   *self);
+GdkMacosMonitor   *_gdk_macos_monitor_new                   (GdkMacosDisplay   *display,
+                                                             CGDirectDisplayID  screen_id);
+CGDirectDisplayID  _gdk_macos_monitor_get_screen_id         (GdkMacosMonitor   *self);
+gboolean           _gdk_macos_monitor_reconfigure           (GdkMacosMonitor   *self);
+gboolean           _gdk_macos_monitor_add_frame_callback    (GdkMacosMonitor   *self,
+                                                             GdkMacosSurface   *surface);
+void               _gdk_macos_monitor_remove_frame_callback (GdkMacosMonitor   *self,
+                                                             GdkMacosSurface   *surface);
+void               _gdk_macos_monitor_release_frames        (GdkMacosMonitor   *self);
 
 G_END_DECLS
 
@@ -22,8 +22,10 @@
 #include <gdk/gdk.h>
 #include <math.h>
 
+#include "gdkdisplaylinksource.h"
 #include "gdkmacosdisplay-private.h"
 #include "gdkmacosmonitor-private.h"
+#include "gdkmacossurface-private.h"
 #include "gdkmacosutils-private.h"
 
 struct _GdkMacosMonitor
@@ -31,6 +33,16 @@ struct _GdkMacosMonitor
   GdkMonitor        parent_instance;
   CGDirectDisplayID screen_id;
   NSRect            workarea;
+
+  /* A CVDisplayLink following this monitor's vertical blank, so that
+   * surfaces on it are paced at its own refresh rate rather than that
+   * of whichever display the shared link picked.
+   */
+  GSource          *display_link;
+
+  /* Surfaces waiting on display_link, using the GdkMacosSurface.frame link */
+  GQueue            awaiting_frames;
+
   guint             has_opengl : 1;
 };
 
@@ -79,9 +91,28 @@ gdk_macos_monitor_get_workarea (GdkMonitor   *monitor,
   GDK_END_MACOS_ALLOC_POOL;
 }
 
+static void
+gdk_macos_monitor_dispose (GObject *object)
+{
+  GdkMacosMonitor *self = (GdkMacosMonitor *)object;
+
+  g_assert (self->awaiting_frames.length == 0);
+
+  if (self->display_link != NULL)
+    {
+      g_source_destroy (self->display_link);
+      g_clear_pointer (&self->display_link, g_source_unref);
+    }
+
+  G_OBJECT_CLASS (gdk_macos_monitor_parent_class)->dispose (object);
+}
+
 static void
 gdk_macos_monitor_class_init (GdkMacosMonitorClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gdk_macos_monitor_dispose;
 }
 
 static void
@@ -203,6 +234,7 @@ _gdk_macos_monitor_reconfigure (GdkMacosMonitor *self)
   size_t pixel_width;
   char *connector;
   char *name;
+  double mode_refresh_rate;
   int refresh_rate;
   int scale_factor = 1;
   int width_mm;
@@ -240,7 +272,11 @@ _gdk_macos_monitor_reconfigure (GdkMacosMonitor *self)
    * can fallback by getting it from CoreVideo based on a CVDisplayLink
    * setting (which is also used by the frame clock).
    */
-  if (!(refresh_rate = CGDisplayModeGetRefreshRate (mode)))
+  if ((mode_refresh_rate = CGDisplayModeGetRefreshRate (mode)))
+    refresh_rate = mode_refresh_rate * 1000;
+  else if (self->display_link != NULL)
+    refresh_rate = ((GdkDisplayLinkSource *)self->display_link)->refresh_rate;
+  else
     refresh_rate = _gdk_macos_display_get_nominal_refresh_rate (display);
 
   gdk_monitor_set_connector (GDK_MONITOR (self), connector);
@@ -268,6 +304,62 @@ _gdk_macos_monitor_reconfigure (GdkMacosMonitor *self)
   return TRUE;
 }
 
+static gboolean
+gdk_macos_monitor_frame_cb (gpointer data)
+{
+  GdkMacosMonitor *self = data;
+  GdkDisplayLinkSource *source;
+  GList *iter;
+
+  g_assert (GDK_IS_MACOS_MONITOR (self));
+
+  source = (GdkDisplayLinkSource *)self->display_link;
+
+  g_object_ref (self);
+
+  iter = self->awaiting_frames.head;
+
+  while (iter != NULL)
+    {
+      GdkMacosSurface *surface = iter->data;
+
+      g_assert (GDK_IS_MACOS_SURFACE (surface));
+
+      iter = iter->next;
+
+      _gdk_macos_monitor_remove_frame_callback (self, surface);
+      _gdk_macos_surface_thaw (surface,
+                               source->presentation_time,
+                               source->refresh_interval);
+    }
+
+  g_object_unref (self);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gdk_macos_monitor_load_display_link (GdkMacosMonitor *self)
+{
+  GdkDisplayLinkSource *source;
+
+  source = (GdkDisplayLinkSource *)gdk_display_link_source_new (self->screen_id);
+
+  /* Without a link of our own, surfaces fall back to the display's */
+  if (source->display_link == NULL)
+    {
+      g_source_unref ((GSource *)source);
+      return;
+    }
+
+  self->display_link = (GSource *)source;
+  g_source_set_callback (self->display_link,
+                         gdk_macos_monitor_frame_cb,
+                         self,
+                         NULL);
+  g_source_attach (self->display_link, NULL);
+}
+
 GdkMacosMonitor *
 _gdk_macos_monitor_new (GdkMacosDisplay   *display,
                         CGDirectDisplayID  screen_id)
@@ -282,6 +374,7 @@ _gdk_macos_monitor_new (GdkMacosDisplay   *display,
 
   self->screen_id = screen_id;
 
+  gdk_macos_monitor_load_display_link (self);
   _gdk_macos_monitor_reconfigure (self);
 
   return g_steal_pointer (&self);
@@ -294,3 +387,71 @@ _gdk_macos_monitor_get_screen_id (GdkMacosMonitor *self)
 
   return self->screen_id;
 }
+
+gboolean
+_gdk_macos_monitor_add_frame_callback (GdkMacosMonitor *self,
+                                       GdkMacosSurface *surface)
+{
+  g_return_val_if_fail (GDK_IS_MACOS_MONITOR (self), FALSE);
+  g_return_val_if_fail (GDK_IS_MACOS_SURFACE (surface), FALSE);
+  g_return_val_if_fail (surface->frame_monitor == NULL, FALSE);
+
+  if (self->display_link == NULL)
+    return FALSE;
+
+  surface->frame_monitor = g_object_ref (self);
+  g_queue_push_tail_link (&self->awaiting_frames, &surface->frame);
+
+  if (self->awaiting_frames.length == 1)
+    gdk_display_link_source_unpause ((GdkDisplayLinkSource *)self->display_link);
+
+  return TRUE;
+}
+
+void
+_gdk_macos_monitor_remove_frame_callback (GdkMacosMonitor *self,
+                                          GdkMacosSurface *surface)
+{
+  g_return_if_fail (GDK_IS_MACOS_MONITOR (self));
+  g_return_if_fail (GDK_IS_MACOS_SURFACE (surface));
+  g_return_if_fail (surface->frame_monitor == self);
+
+  g_queue_unlink (&self->awaiting_frames, &surface->frame);
+
+  if (self->awaiting_frames.length == 0)
+    gdk_display_link_source_pause ((GdkDisplayLinkSource *)self->display_link);
+
+  /* May drop the last reference to @self */
+  g_clear_object (&surface->frame_monitor);
+}
+
+/* Called when the monitor goes away, as its link may not fire again */
+void
+_gdk_macos_monitor_release_frames (GdkMacosMonitor *self)
+{
+  gint64 refresh_interval;
+  gint64 now;
+
+  g_return_if_fail (GDK_IS_MACOS_MONITOR (self));
+
+  if (self->display_link == NULL)
+    return;
+
+  refresh_interval = ((GdkDisplayLinkSource *)self->display_link)->refresh_interval;
+  now = g_get_monotonic_time ();
+
+  g_object_ref (self);
+
+  while (self->awaiting_frames.head != NULL)
+    {
+      GdkMacosSurface *surface = self->awaiting_frames.head->data;
+
+      _gdk_macos_monitor_remove_frame_callback (self, surface);
+      _gdk_macos_surface_thaw (surface, now, refresh_interval);
+    }
+
+  g_source_destroy (self->display_link);
+  g_clear_pointer (&self->display_link, g_source_unref);
+
+  g_object_unref (self);
+}
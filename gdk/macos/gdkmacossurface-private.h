@@ -27,6 +27,7 @@
 #include "gdksurfaceprivate.h"
 
 #include "gdkmacosdisplay.h"
+#include "gdkmacosmonitor.h"
 #include "gdkmacossurface.h"
 
 #import "GdkMacosWindow.h"
@@ -47,6 +48,7 @@ struct _GdkMacosSurface
 
   GdkMacosWindow *window;
   GPtrArray *monitors;
+  GdkMacosMonitor *frame_monitor;
   cairo_region_t *input_region;
   char *title;
 
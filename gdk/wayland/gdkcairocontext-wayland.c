@@ -25,6 +25,12 @@
 #include "gdkinternals.h"
 #include "gdkprofilerprivate.h"
 
+/* Buffers are kept in a pool that holds as many of them as the
+ * compositor kept attached at once over the last POOL_WINDOW_FRAMES
+ * frames, plus the one we paint to.
+ */
+#define POOL_WINDOW_FRAMES 120
+
 static const cairo_user_data_key_t gdk_wayland_cairo_context_key;
 static const cairo_user_data_key_t gdk_wayland_cairo_region_key;
 
@@ -84,6 +90,9 @@ gdk_wayland_cairo_context_remove_surface (GdkWaylandCairoContext *self,
                                           cairo_surface_t        *surface)
 {
   self->surfaces = g_slist_remove (self->surfaces, surface);
+  self->free_surfaces = g_slist_remove (self->free_surfaces, surface);
+  if (self->committed_surface == surface)
+    self->committed_surface = NULL;
 
   cairo_surface_set_user_data (surface, &gdk_wayland_cairo_context_key, NULL, NULL);
   cairo_surface_destroy (surface);
@@ -100,10 +109,15 @@ gdk_wayland_cairo_context_buffer_release (void             *_data,
   if (self == NULL)
     return;
 
-  /* Cache one surface for reuse when drawing */
-  if (self->cached_surface == NULL)
+  if (self->n_attached > 0)
+    self->n_attached--;
+
+  /* Keep the surface for reuse unless the pool is big enough already.
+   * The last committed surface is kept as the source of our copies. */
+  if (cairo_surface == self->committed_surface ||
+      self->n_attached + g_slist_length (self->free_surfaces) < self->max_attached + 1)
     {
-      self->cached_surface = cairo_surface;
+      self->free_surfaces = g_slist_prepend (self->free_surfaces, cairo_surface);
       return;
     }
 
@@ -111,6 +125,23 @@ gdk_wayland_cairo_context_buffer_release (void             *_data,
   gdk_wayland_cairo_context_remove_surface (self, cairo_surface);
 }
 
+static void
+gdk_wayland_cairo_context_trim_pool (GdkWaylandCairoContext *self)
+{
+  GSList *l, *next;
+
+  for (l = self->free_surfaces; l; l = next)
+    {
+      next = l->next;
+
+      if (self->n_attached + g_slist_length (self->free_surfaces) <= self->max_attached + 1)
+        break;
+
+      if (l->data != self->committed_surface)
+        gdk_wayland_cairo_context_remove_surface (self, l->data);
+    }
+}
+
 static const struct wl_buffer_listener buffer_listener = {
   gdk_wayland_cairo_context_buffer_release
 };
@@ -150,14 +181,44 @@ gdk_wayland_cairo_context_begin_frame (GdkDrawContext *draw_context,
   GSList *l;
   cairo_t *cr;
 
-  if (self->cached_surface)
-    self->paint_surface = g_steal_pointer (&self->cached_surface);
+  if (self->free_surfaces)
+    {
+      /* Prefer the committed surface, it needs no copying */
+      l = g_slist_find (self->free_surfaces, self->committed_surface);
+      if (l == NULL)
+        l = self->free_surfaces;
+      self->paint_surface = l->data;
+      self->free_surfaces = g_slist_delete_link (self->free_surfaces, l);
+    }
   else
     self->paint_surface = gdk_wayland_cairo_context_create_surface (self);
 
+  /* The surface is missing the damage of the frames since it was last
+   * painted. Copy that from the last presented buffer instead of making
+   * the application repaint it; only a new frame's damage gets redrawn. */
   surface_region = gdk_wayland_cairo_context_surface_get_region (self->paint_surface);
-  if (surface_region)
-    cairo_region_union (region, surface_region);
+  if (surface_region && !cairo_region_is_empty (surface_region))
+    {
+      if (self->committed_surface && self->committed_surface != self->paint_surface)
+        {
+          cairo_region_t *stale = cairo_region_copy (surface_region);
+
+          cairo_region_subtract (stale, region);
+
+          cr = cairo_create (self->paint_surface);
+          cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          cairo_set_source_surface (cr, self->committed_surface, 0, 0);
+          gdk_cairo_region (cr, stale);
+          cairo_fill (cr);
+          cairo_destroy (cr);
+
+          cairo_region_destroy (stale);
+        }
+      else
+        {
+          cairo_region_union (region, surface_region);
+        }
+    }
 
   for (l = self->surfaces; l; l = l->next)
     {
@@ -188,15 +249,32 @@ gdk_wayland_cairo_context_end_frame (GdkDrawContext *draw_context,
   gdk_wayland_surface_notify_committed (surface);
 
   gdk_wayland_cairo_context_surface_clear_region (self->paint_surface);
+  self->committed_surface = self->paint_surface;
   self->paint_surface = NULL;
+
+  self->n_attached++;
+  self->max_attached = MAX (self->max_attached, self->n_attached);
+  self->window_max_attached = MAX (self->window_max_attached, self->n_attached);
+
+  /* Shrink the pool when the compositor started releasing buffers earlier */
+  if (++self->window_frames >= POOL_WINDOW_FRAMES)
+    {
+      self->max_attached = self->window_max_attached;
+      self->window_max_attached = self->n_attached;
+      self->window_frames = 0;
+
+      gdk_wayland_cairo_context_trim_pool (self);
+    }
 }
 
 static void
 gdk_wayland_cairo_context_clear_all_cairo_surfaces (GdkWaylandCairoContext *self)
 {
-  self->cached_surface = NULL;
   while (self->surfaces)
     gdk_wayland_cairo_context_remove_surface (self, self->surfaces->data);
+
+  /* Buffers we destroyed are never released */
+  self->n_attached = 0;
 }
 
 static void
@@ -40,8 +40,15 @@ struct _GdkWaylandCairoContext
   GdkCairoContext parent_instance;
 
   GSList *surfaces;
-  cairo_surface_t *cached_surface;
+  GSList *free_surfaces;        /* released by the compositor */
   cairo_surface_t *paint_surface;
+  cairo_surface_t *committed_surface;
+
+  /* The compositor's release pattern, to size the pool */
+  guint n_attached;
+  guint max_attached;
+  guint window_max_attached;
+  guint window_frames;
 };
 
 struct _GdkWaylandCairoContextClass
@@ -27,7 +27,6 @@
 
 #include <glib-unix.h>
 #include <gio/gunixinputstream.h>
-#include <gio/gunixoutputstream.h>
 
 typedef struct _GdkWaylandClipboardClass GdkWaylandClipboardClass;
 
@@ -107,7 +106,7 @@ gdk_wayland_clipboard_data_source_send (void                  *data,
                                    source, mime_type, fd));
 
   mime_type = gdk_intern_mime_type (mime_type);
-  stream = g_unix_output_stream_new (fd, TRUE);
+  stream = gdk_wayland_pipe_stream_new (fd);
 
   gdk_clipboard_write_async (GDK_CLIPBOARD (cb),
                              mime_type,
@@ -48,6 +48,7 @@
 #include "gdkvulkancontext-wayland.h"
 #include "gdkwaylandmonitor.h"
 #include "gdkprofilerprivate.h"
+#include "gdkdmabuftextureprivate.h"
 #include <wayland/pointer-gestures-unstable-v1-client-protocol.h>
 #include "tablet-unstable-v2-client-protocol.h"
 #include <wayland/xdg-shell-unstable-v6-client-protocol.h>
@@ -364,6 +365,81 @@ static const struct wl_shm_listener wl_shm_listener = {
   wl_shm_format
 };
 
+typedef struct {
+  guint32 fourcc;
+  guint64 modifier;
+} GdkWaylandDmabufFormat;
+
+static void
+add_dmabuf_format (GdkWaylandDisplay *display_wayland,
+                   guint32            fourcc,
+                   guint64            modifier)
+{
+  GdkWaylandDmabufFormat format = { fourcc, modifier };
+
+  g_array_append_val (display_wayland->dmabuf_formats, format);
+}
+
+static void
+linux_dmabuf_format (void                       *data,
+                     struct zwp_linux_dmabuf_v1 *linux_dmabuf,
+                     uint32_t                    format)
+{
+  /* Sent before version 3, for buffers without explicit modifier */
+  add_dmabuf_format (data, format, GDK_DRM_FORMAT_MOD_INVALID);
+}
+
+static void
+linux_dmabuf_modifier (void                       *data,
+                       struct zwp_linux_dmabuf_v1 *linux_dmabuf,
+                       uint32_t                    format,
+                       uint32_t                    modifier_hi,
+                       uint32_t                    modifier_lo)
+{
+  add_dmabuf_format (data, format, ((guint64) modifier_hi << 32) | modifier_lo);
+}
+
+static const struct zwp_linux_dmabuf_v1_listener linux_dmabuf_listener = {
+  linux_dmabuf_format,
+  linux_dmabuf_modifier,
+};
+
+static void
+presentation_clock_id (void                   *data,
+                       struct wp_presentation *presentation,
+                       uint32_t                clk_id)
+{
+  GdkWaylandDisplay *display_wayland = data;
+
+  display_wayland->presentation_clock_id = clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+  presentation_clock_id
+};
+
+gboolean
+gdk_wayland_display_supports_dmabuf (GdkWaylandDisplay *display_wayland,
+                                     guint32            fourcc,
+                                     guint64            modifier)
+{
+  guint i;
+
+  if (display_wayland->linux_dmabuf == NULL)
+    return FALSE;
+
+  for (i = 0; i < display_wayland->dmabuf_formats->len; i++)
+    {
+      const GdkWaylandDmabufFormat *format = &g_array_index (display_wayland->dmabuf_formats,
+                                                             GdkWaylandDmabufFormat, i);
+
+      if (format->fourcc == fourcc && format->modifier == modifier)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 static void
 server_decoration_manager_default_mode (void                                          *data,
                                         struct org_kde_kwin_server_decoration_manager *manager,
@@ -561,6 +637,35 @@ gdk_registry_handle_global (void               *data,
         wl_registry_bind (display_wayland->wl_registry, id,
                           &zwp_idle_inhibit_manager_v1_interface, 1);
     }
+  else if (strcmp (interface, "wp_viewporter") == 0)
+    {
+      display_wayland->viewporter =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &wp_viewporter_interface, 1);
+    }
+  else if (strcmp (interface, "wp_presentation") == 0)
+    {
+      /* Until we know the clock, we can't use the timestamps */
+      display_wayland->presentation_clock_id = (guint32) -1;
+      display_wayland->presentation =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &wp_presentation_interface, 1);
+      wp_presentation_add_listener (display_wayland->presentation,
+                                    &presentation_listener,
+                                    display_wayland);
+      _gdk_wayland_display_async_roundtrip (display_wayland);
+    }
+  else if (strcmp (interface, "zwp_linux_dmabuf_v1") == 0 && version >= 2)
+    {
+      /* Version 2 for create_immed, version 3 for modifiers */
+      display_wayland->linux_dmabuf =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &zwp_linux_dmabuf_v1_interface, MIN (version, 3));
+      zwp_linux_dmabuf_v1_add_listener (display_wayland->linux_dmabuf,
+                                        &linux_dmabuf_listener,
+                                        display_wayland);
+      _gdk_wayland_display_async_roundtrip (display_wayland);
+    }
 
   g_hash_table_insert (display_wayland->known_globals,
                        GUINT_TO_POINTER (id), g_strdup (interface));
@@ -761,6 +866,8 @@ gdk_wayland_display_finalize (GObject *object)
   g_list_store_remove_all (display_wayland->monitors);
   g_object_unref (display_wayland->monitors);
 
+  g_array_unref (display_wayland->dmabuf_formats);
+
   if (display_wayland->settings)
     g_hash_table_destroy (display_wayland->settings);
 
@@ -1038,6 +1145,8 @@ gdk_wayland_display_init (GdkWaylandDisplay *display)
   display->xkb_context = xkb_context_new (0);
 
   display->monitors = g_list_store_new (GDK_TYPE_MONITOR);
+
+  display->dmabuf_formats = g_array_new (FALSE, FALSE, sizeof (GdkWaylandDmabufFormat));
 }
 
 GList *
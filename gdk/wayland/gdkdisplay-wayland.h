@@ -37,6 +37,9 @@
 #include <gdk/wayland/xdg-output-unstable-v1-client-protocol.h>
 #include <gdk/wayland/idle-inhibit-unstable-v1-client-protocol.h>
 #include <gdk/wayland/primary-selection-unstable-v1-client-protocol.h>
+#include <gdk/wayland/viewporter-client-protocol.h>
+#include <gdk/wayland/linux-dmabuf-unstable-v1-client-protocol.h>
+#include <gdk/wayland/presentation-time-client-protocol.h>
 
 #include <glib.h>
 #include <gdk/gdkkeys.h>
@@ -112,6 +115,13 @@ struct _GdkWaylandDisplay
   struct org_kde_kwin_server_decoration_manager *server_decoration_manager;
   struct zxdg_output_manager_v1 *xdg_output_manager;
   struct zwp_idle_inhibit_manager_v1 *idle_inhibit_manager;
+  struct wp_viewporter *viewporter;
+  struct zwp_linux_dmabuf_v1 *linux_dmabuf;
+  struct wp_presentation *presentation;
+  guint32 presentation_clock_id;
+
+  /* The dmabuf formats the compositor can import, GdkWaylandDmabufFormat */
+  GArray *dmabuf_formats;
 
   GList *async_roundtrips;
 
@@ -158,6 +168,8 @@ struct _GdkWaylandDisplay
   guint have_egl_buffer_age : 1;
   guint have_egl_swap_buffers_with_damage : 1;
   guint have_egl_surfaceless_context : 1;
+  guint have_egl_dma_buf_import : 1;
+  guint have_egl_dma_buf_import_modifiers : 1;
 };
 
 struct _GdkWaylandDisplayClass
@@ -166,6 +178,9 @@ struct _GdkWaylandDisplayClass
 };
 
 gboolean                gdk_wayland_display_prefers_ssd         (GdkDisplay *display);
+gboolean                gdk_wayland_display_supports_dmabuf     (GdkWaylandDisplay *display_wayland,
+                                                                 guint32            fourcc,
+                                                                 guint64            modifier);
 
 G_END_DECLS
 
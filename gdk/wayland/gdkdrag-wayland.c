@@ -30,7 +30,6 @@
 
 #include <glib-unix.h>
 #include <gio/gunixinputstream.h>
-#include <gio/gunixoutputstream.h>
 #include <string.h>
 
 #define GDK_TYPE_WAYLAND_DRAG              (gdk_wayland_drag_get_type ())
@@ -250,7 +249,7 @@ data_source_send (void                  *data,
 
   //mime_type = gdk_intern_mime_type (mime_type);
   mime_type = g_intern_string (mime_type);
-  stream = g_unix_output_stream_new (fd, TRUE);
+  stream = gdk_wayland_pipe_stream_new (fd);
 
   gdk_drag_write_async (drag,
                         mime_type,
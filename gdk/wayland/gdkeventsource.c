@@ -37,19 +37,22 @@ gdk_event_source_prepare (GSource *base,
 {
   GdkWaylandEventSource *source = (GdkWaylandEventSource *) base;
   GdkWaylandDisplay *display = (GdkWaylandDisplay *) source->display;
+  gboolean throttled;
   GList *l;
 
   *timeout = -1;
 
+  throttled = _gdk_display_events_throttled (source->display, timeout);
+
   if (source->display->event_pause_count > 0)
-    return _gdk_event_queue_find_first (source->display) != NULL;
+    return !throttled && _gdk_event_queue_find_first (source->display) != NULL;
 
   /* We have to add/remove the GPollFD if we want to update our
    * poll event mask dynamically.  Instead, let's just flush all
    * write on idle instead, which is what this amounts to.
    */
 
-  if (_gdk_event_queue_find_first (source->display) != NULL)
+  if (!throttled && _gdk_event_queue_find_first (source->display) != NULL)
     return TRUE;
 
   /* wl_display_prepare_read() needs to be balanced with either
@@ -60,7 +63,7 @@ gdk_event_source_prepare (GSource *base,
 
   /* if prepare_read() returns non-zero, there are events to be dispatched */
   if (wl_display_prepare_read (display->wl_display) != 0)
-    return TRUE;
+    return !throttled;
 
   /* We need to check whether there are pending events on the surface queues as well,
    * but we also need to make sure to only have one active "read" in the end,
@@ -74,7 +77,7 @@ gdk_event_source_prepare (GSource *base,
       if (wl_display_prepare_read_queue (display->wl_display, queue) != 0)
         {
           wl_display_cancel_read (display->wl_display);
-          return TRUE;
+          return !throttled;
         }
       wl_display_cancel_read (display->wl_display);
     }
@@ -121,6 +124,10 @@ gdk_event_source_check (GSource *base)
       source->reading = FALSE;
     }
 
+  /* What was read stays in the queues until the next frame */
+  if (_gdk_display_events_throttled (source->display, NULL))
+    return FALSE;
+
   return _gdk_event_queue_find_first (source->display) != NULL ||
     source->pfd.revents;
 }
@@ -131,17 +138,8 @@ gdk_event_source_dispatch (GSource     *base,
 			   gpointer     data)
 {
   GdkWaylandEventSource *source = (GdkWaylandEventSource *) base;
-  GdkDisplay *display = source->display;
-  GdkEvent *event;
 
-  event = gdk_display_get_event (display);
-
-  if (event)
-    {
-      _gdk_event_emit (event);
-
-      gdk_event_unref (event);
-    }
+  _gdk_display_dispatch_events (source->display);
 
   return TRUE;
 }
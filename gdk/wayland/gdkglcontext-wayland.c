@@ -29,12 +29,15 @@
 #include "gdkwaylandsurface.h"
 #include "gdkprivate-wayland.h"
 
+#include "gdkdmabuftextureprivate.h"
 #include "gdkinternals.h"
 #include "gdksurfaceprivate.h"
 #include "gdkprofilerprivate.h"
 
 #include "gdkintl.h"
 
+#include <epoxy/gl.h>
+
 G_DEFINE_TYPE (GdkWaylandGLContext, gdk_wayland_gl_context, GDK_TYPE_GL_CONTEXT)
 
 static void gdk_wayland_gl_context_dispose (GObject *gobject);
@@ -162,6 +165,90 @@ gdk_wayland_gl_context_realize (GdkGLContext *context,
   return TRUE;
 }
 
+#define MAX_DMABUF_ATTRS (7 + GDK_DMABUF_MAX_PLANES * 10)
+
+static gboolean
+gdk_wayland_gl_context_import_dmabuf (GdkGLContext     *context,
+                                      GdkDmabufTexture *texture,
+                                      guint             texture_target)
+{
+  static const EGLint plane_attrs[GDK_DMABUF_MAX_PLANES][5] = {
+    { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+      EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+      EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+      EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+      EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT },
+  };
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (context));
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (display);
+  GdkTexture *gdk_texture = GDK_TEXTURE (texture);
+  guint64 modifier = gdk_dmabuf_texture_get_modifier (texture);
+  guint n_planes = gdk_dmabuf_texture_get_n_planes (texture);
+  EGLint attrs[MAX_DMABUF_ATTRS];
+  EGLImageKHR image;
+  guint plane;
+  int i = 0;
+
+  if (!display_wayland->have_egl_dma_buf_import ||
+      !epoxy_has_gl_extension ("GL_OES_EGL_image"))
+    return FALSE;
+
+  /* Explicit modifiers and 4 planes need the modifiers extension */
+  if ((modifier != GDK_DRM_FORMAT_MOD_INVALID || n_planes > 3) &&
+      !display_wayland->have_egl_dma_buf_import_modifiers)
+    return FALSE;
+
+  attrs[i++] = EGL_WIDTH;
+  attrs[i++] = gdk_texture_get_width (gdk_texture);
+  attrs[i++] = EGL_HEIGHT;
+  attrs[i++] = gdk_texture_get_height (gdk_texture);
+  attrs[i++] = EGL_LINUX_DRM_FOURCC_EXT;
+  attrs[i++] = gdk_dmabuf_texture_get_fourcc (texture);
+
+  for (plane = 0; plane < n_planes; plane++)
+    {
+      attrs[i++] = plane_attrs[plane][0];
+      attrs[i++] = gdk_dmabuf_texture_get_fd (texture, plane);
+      attrs[i++] = plane_attrs[plane][1];
+      attrs[i++] = gdk_dmabuf_texture_get_offset (texture, plane);
+      attrs[i++] = plane_attrs[plane][2];
+      attrs[i++] = gdk_dmabuf_texture_get_stride (texture, plane);
+
+      if (modifier != GDK_DRM_FORMAT_MOD_INVALID)
+        {
+          attrs[i++] = plane_attrs[plane][3];
+          attrs[i++] = modifier & 0xFFFFFFFF;
+          attrs[i++] = modifier >> 32;
+        }
+    }
+
+  attrs[i++] = EGL_NONE;
+
+  g_assert (i <= MAX_DMABUF_ATTRS);
+
+  image = eglCreateImageKHR (display_wayland->egl_display,
+                             EGL_NO_CONTEXT,
+                             EGL_LINUX_DMA_BUF_EXT,
+                             (EGLClientBuffer) NULL,
+                             attrs);
+  if (image == EGL_NO_IMAGE_KHR)
+    {
+      GDK_DISPLAY_NOTE (display, OPENGL,
+                        g_message ("Importing dmabuf failed: %#x", eglGetError ()));
+      return FALSE;
+    }
+
+  glEGLImageTargetTexture2DOES (texture_target, image);
+
+  /* The texture keeps the buffers alive */
+  eglDestroyImageKHR (display_wayland->egl_display, image);
+
+  return TRUE;
+}
+
 static cairo_region_t *
 gdk_wayland_gl_context_get_damage (GdkGLContext *context)
 {
@@ -278,6 +365,7 @@ gdk_wayland_gl_context_class_init (GdkWaylandGLContextClass *klass)
 
   context_class->realize = gdk_wayland_gl_context_realize;
   context_class->get_damage = gdk_wayland_gl_context_get_damage;
+  context_class->import_dmabuf = gdk_wayland_gl_context_import_dmabuf;
 }
 
 static void
@@ -358,6 +446,14 @@ gdk_wayland_display_init_gl (GdkDisplay *display)
   display_wayland->have_egl_surfaceless_context =
     epoxy_has_egl_extension (dpy, "EGL_KHR_surfaceless_context");
 
+  display_wayland->have_egl_dma_buf_import =
+    epoxy_has_egl_extension (dpy, "EGL_EXT_image_dma_buf_import") &&
+    epoxy_has_egl_extension (dpy, "EGL_KHR_image_base");
+
+  display_wayland->have_egl_dma_buf_import_modifiers =
+    display_wayland->have_egl_dma_buf_import &&
+    epoxy_has_egl_extension (dpy, "EGL_EXT_image_dma_buf_import_modifiers");
+
   GDK_DISPLAY_NOTE (display, OPENGL,
             g_message ("EGL API version %d.%d found\n"
                        " - Vendor: %s\n"
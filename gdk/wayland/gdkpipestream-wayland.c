@@ -0,0 +1,339 @@
+/* GDK - The GIMP Drawing Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprivate-wayland.h"
+
+#include <glib-unix.h>
+#include <gio/gunixoutputstream.h>
+
+#ifdef HAVE_SPLICE
+#include <gio/gfiledescriptorbased.h>
+
+#include <errno.h>
+#include <fcntl.h> /* splice() */
+#include <poll.h>
+
+/* The stream we hand to content providers for the fds we get in
+ * wl_data_source.send and friends. Those are usually pipes, so when a
+ * provider splices a file or another pipe into it, the data can be moved
+ * by the kernel with splice() instead of going through a userspace
+ * buffer. The pipe limits how much is in flight, and we wait for it to
+ * drain whenever the reader falls behind.
+ */
+
+/* Bytes moved per splice() call, the default capacity of a pipe */
+#define SPLICE_CHUNK_SIZE (64 * 1024)
+/* Chunks moved before giving the main loop a chance to run */
+#define SPLICE_CHUNKS_PER_DISPATCH 16
+
+typedef struct _GdkWaylandPipeStream GdkWaylandPipeStream;
+typedef struct _GdkWaylandPipeStreamClass GdkWaylandPipeStreamClass;
+
+struct _GdkWaylandPipeStream
+{
+  GUnixOutputStream parent_instance;
+};
+
+struct _GdkWaylandPipeStreamClass
+{
+  GUnixOutputStreamClass parent_class;
+};
+
+typedef struct
+{
+  GInputStream *source;
+  GOutputStreamSpliceFlags flags;
+  int in_fd;
+  int out_fd;
+  gssize n_spliced;
+  GSource *watch;
+} SpliceData;
+
+GType gdk_wayland_pipe_stream_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (GdkWaylandPipeStream, gdk_wayland_pipe_stream, G_TYPE_UNIX_OUTPUT_STREAM)
+
+static void
+splice_data_free (gpointer data)
+{
+  SpliceData *splice = data;
+
+  if (splice->watch)
+    {
+      g_source_destroy (splice->watch);
+      g_source_unref (splice->watch);
+    }
+  g_object_unref (splice->source);
+  g_slice_free (SpliceData, splice);
+}
+
+static void
+splice_finish_task (GTask  *task,
+                    GError *error)
+{
+  GOutputStream *stream = g_task_get_source_object (task);
+  SpliceData *splice = g_task_get_task_data (task);
+  GCancellable *cancellable = g_task_get_cancellable (task);
+
+  if (splice->flags & G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE)
+    g_input_stream_close (splice->source, cancellable, NULL);
+
+  /* Like the default splice implementation, close below the pending flag */
+  if (splice->flags & G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET)
+    {
+      GOutputStreamClass *class = G_OUTPUT_STREAM_CLASS (gdk_wayland_pipe_stream_parent_class);
+      GError *close_error = NULL;
+
+      if (!class->close_fn (stream, cancellable, &close_error))
+        {
+          if (error == NULL)
+            error = close_error;
+          else
+            g_error_free (close_error);
+        }
+    }
+
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_int (task, splice->n_spliced);
+
+  g_object_unref (task);
+}
+
+static void
+gdk_wayland_pipe_stream_fallback_done (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      data)
+{
+  GOutputStreamClass *class = G_OUTPUT_STREAM_CLASS (gdk_wayland_pipe_stream_parent_class);
+  GTask *task = data;
+  GError *error = NULL;
+  gssize n;
+
+  n = class->splice_finish (G_OUTPUT_STREAM (object), result, &error);
+  if (n < 0)
+    g_task_return_error (task, error);
+  else
+    g_task_return_int (task, n);
+
+  g_object_unref (task);
+}
+
+static void splice_step (GTask *task);
+
+static gboolean
+splice_ready (int          fd,
+              GIOCondition condition,
+              gpointer     data)
+{
+  GTask *task = data;
+  SpliceData *splice = g_task_get_task_data (task);
+
+  g_clear_pointer (&splice->watch, g_source_unref);
+  splice_step (task);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Waits for whichever end is blocking us: the reader draining the pipe,
+ * or more data arriving when the source is a pipe itself.
+ */
+static void
+splice_wait (GTask *task)
+{
+  SpliceData *splice = g_task_get_task_data (task);
+  struct pollfd pfd = { splice->out_fd, POLLOUT, 0 };
+  int fd;
+  GIOCondition condition;
+
+  if (poll (&pfd, 1, 0) == 1 && (pfd.revents & POLLOUT))
+    {
+      fd = splice->in_fd;
+      condition = G_IO_IN | G_IO_HUP | G_IO_ERR;
+    }
+  else
+    {
+      fd = splice->out_fd;
+      condition = G_IO_OUT | G_IO_HUP | G_IO_ERR;
+    }
+
+  splice->watch = g_unix_fd_source_new (fd, condition);
+  g_source_set_priority (splice->watch, g_task_get_priority (task));
+  g_source_set_callback (splice->watch, (GSourceFunc) splice_ready, task, NULL);
+  g_source_set_name (splice->watch, "[gdk] wayland pipe stream splice");
+  g_source_attach (splice->watch, g_task_get_context (task));
+}
+
+static void
+splice_step (GTask *task)
+{
+  SpliceData *splice = g_task_get_task_data (task);
+  GError *error = NULL;
+  guint i;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  for (i = 0; i < SPLICE_CHUNKS_PER_DISPATCH; i++)
+    {
+      gssize n;
+
+      n = splice (splice->in_fd, NULL,
+                  splice->out_fd, NULL,
+                  SPLICE_CHUNK_SIZE,
+                  SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+      if (n > 0)
+        {
+          splice->n_spliced += n;
+          continue;
+        }
+
+      if (n == 0)
+        {
+          splice_finish_task (task, NULL);
+          return;
+        }
+
+      if (errno == EINTR)
+        continue;
+
+      if (errno == EAGAIN)
+        {
+          splice_wait (task);
+          return;
+        }
+
+      /* Neither end is a pipe, or the source can't be spliced from */
+      if ((errno == EINVAL || errno == ENOSYS) && splice->n_spliced == 0)
+        {
+          GOutputStreamClass *class = G_OUTPUT_STREAM_CLASS (gdk_wayland_pipe_stream_parent_class);
+
+          class->splice_async (g_task_get_source_object (task),
+                               splice->source,
+                               splice->flags,
+                               g_task_get_priority (task),
+                               g_task_get_cancellable (task),
+                               gdk_wayland_pipe_stream_fallback_done,
+                               task);
+          return;
+        }
+
+      g_set_error (&error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Error splicing to pipe: %s", g_strerror (errno));
+      splice_finish_task (task, error);
+      return;
+    }
+
+  /* The pipe is still writable, so this dispatches right away */
+  splice_wait (task);
+}
+
+static void
+gdk_wayland_pipe_stream_splice_async (GOutputStream            *stream,
+                                      GInputStream             *source,
+                                      GOutputStreamSpliceFlags  flags,
+                                      int                       io_priority,
+                                      GCancellable             *cancellable,
+                                      GAsyncReadyCallback       callback,
+                                      gpointer                  user_data)
+{
+  SpliceData *splice;
+  GTask *task;
+  int in_fd, out_fd;
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gdk_wayland_pipe_stream_splice_async);
+  g_task_set_priority (task, io_priority);
+
+  in_fd = G_IS_FILE_DESCRIPTOR_BASED (source)
+          ? g_file_descriptor_based_get_fd (G_FILE_DESCRIPTOR_BASED (source))
+          : -1;
+  out_fd = g_unix_output_stream_get_fd (G_UNIX_OUTPUT_STREAM (stream));
+
+  if (in_fd < 0)
+    {
+      GOutputStreamClass *class = G_OUTPUT_STREAM_CLASS (gdk_wayland_pipe_stream_parent_class);
+
+      class->splice_async (stream, source, flags, io_priority, cancellable,
+                           gdk_wayland_pipe_stream_fallback_done, task);
+      return;
+    }
+
+  splice = g_slice_new0 (SpliceData);
+  splice->source = g_object_ref (source);
+  splice->flags = flags;
+  splice->in_fd = in_fd;
+  splice->out_fd = out_fd;
+  g_task_set_task_data (task, splice, splice_data_free);
+
+  splice_step (task);
+}
+
+static gssize
+gdk_wayland_pipe_stream_splice_finish (GOutputStream  *stream,
+                                       GAsyncResult   *result,
+                                       GError        **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, stream), -1);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gdk_wayland_pipe_stream_splice_async, -1);
+
+  return g_task_propagate_int (G_TASK (result), error);
+}
+
+static void
+gdk_wayland_pipe_stream_class_init (GdkWaylandPipeStreamClass *class)
+{
+  GOutputStreamClass *stream_class = G_OUTPUT_STREAM_CLASS (class);
+
+  stream_class->splice_async = gdk_wayland_pipe_stream_splice_async;
+  stream_class->splice_finish = gdk_wayland_pipe_stream_splice_finish;
+}
+
+static void
+gdk_wayland_pipe_stream_init (GdkWaylandPipeStream *stream)
+{
+}
+#endif /* HAVE_SPLICE */
+
+/*<private>
+ * gdk_wayland_pipe_stream_new:
+ * @fd: the fd to write the transfer to
+ *
+ * Creates the stream that data is written to when another client asks
+ * for the contents of our clipboard or drag. The stream takes ownership
+ * of @fd.
+ *
+ * Returns: (transfer full): a new #GOutputStream
+ */
+GOutputStream *
+gdk_wayland_pipe_stream_new (int fd)
+{
+#ifdef HAVE_SPLICE
+  return g_object_new (gdk_wayland_pipe_stream_get_type (),
+                       "fd", fd,
+                       "close-fd", TRUE,
+                       NULL);
+#else
+  return g_unix_output_stream_new (fd, TRUE);
+#endif
+}
@@ -27,7 +27,6 @@
 
 #include <glib-unix.h>
 #include <gio/gunixinputstream.h>
-#include <gio/gunixoutputstream.h>
 
 typedef struct _GdkWaylandPrimaryClass GdkWaylandPrimaryClass;
 
@@ -217,7 +216,7 @@ gdk_wayland_primary_data_source_send (void                                   *da
                                    source, mime_type, fd));
 
   mime_type = gdk_intern_mime_type (mime_type);
-  stream = g_unix_output_stream_new (fd, TRUE);
+  stream = gdk_wayland_pipe_stream_new (fd);
 
   gdk_clipboard_write_async (GDK_CLIPBOARD (cb),
                              mime_type,
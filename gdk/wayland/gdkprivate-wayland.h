@@ -120,6 +120,8 @@ void             gdk_wayland_drop_set_source_actions       (GdkDrop
 void             gdk_wayland_drop_set_action               (GdkDrop               *drop,
                                                             uint32_t               action);
 
+GOutputStream *  gdk_wayland_pipe_stream_new               (int                    fd);
+
 GdkSurface * _gdk_wayland_display_create_surface (GdkDisplay *display,
                                                   GdkSurfaceType surface_type,
                                                   GdkSurface *parent,
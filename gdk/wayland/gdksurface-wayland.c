@@ -32,6 +32,7 @@
 #include "gdksurfaceprivate.h"
 #include "gdktoplevelprivate.h"
 #include "gdkdevice-wayland-private.h"
+#include "gdkdmabuftextureprivate.h"
 
 #include <wayland/xdg-shell-unstable-v6-client-protocol.h>
 
@@ -42,6 +43,7 @@
 
 #include <netinet/in.h>
 #include <unistd.h>
+#include <time.h>
 
 #define SURFACE_IS_TOPLEVEL(surface)  TRUE
 
@@ -122,6 +124,9 @@ struct _GdkWaylandSurface
   gint64 pending_frame_counter;
   guint32 scale;
 
+  /* PresentationFeedback for frames that are not presented yet */
+  GSList *presentation_feedbacks;
+
   int margin_left;
   int margin_right;
   int margin_top;
@@ -147,6 +152,15 @@ struct _GdkWaylandSurface
 
   gulong parent_surface_committed_handler;
 
+  /* A subsurface showing a texture the renderer offloaded to us */
+  struct {
+    struct wl_surface *wl_surface;
+    struct wl_subsurface *wl_subsurface;
+    struct wp_viewport *viewport;
+    GdkTexture *texture;
+    GdkRectangle area;
+  } offload;
+
   struct {
     GdkToplevelLayout *layout;
   } toplevel;
@@ -473,6 +487,150 @@ finish_pending_relayout (GdkSurface *surface)
   thaw_popup_toplevel_state (surface);
 }
 
+typedef struct {
+  GdkSurface *surface;
+  struct wp_presentation_feedback *feedback;
+  gint64 frame_counter;
+} PresentationFeedback;
+
+static gboolean
+has_presentation_feedback (GdkWaylandSurface *impl,
+                           gint64             frame_counter)
+{
+  GSList *l;
+
+  for (l = impl->presentation_feedbacks; l; l = l->next)
+    {
+      PresentationFeedback *feedback = l->data;
+
+      if (feedback->frame_counter == frame_counter)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+presentation_feedback_free (PresentationFeedback *feedback)
+{
+  wp_presentation_feedback_destroy (feedback->feedback);
+  g_free (feedback);
+}
+
+static void
+complete_frame_timings (GdkFrameClock   *clock,
+                        GdkFrameTimings *timings)
+{
+  timings->complete = TRUE;
+
+#ifdef G_ENABLE_DEBUG
+  if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+    _gdk_frame_clock_debug_print_timings (clock, timings);
+#endif
+
+  if (GDK_PROFILER_IS_RUNNING)
+    _gdk_frame_clock_add_timings_to_profiler (clock, timings);
+}
+
+static void
+presentation_feedback_finish (PresentationFeedback *feedback,
+                              gint64                presentation_time,
+                              gint64                refresh_interval)
+{
+  GdkSurface *surface = feedback->surface;
+  GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (surface);
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  GdkFrameTimings *timings;
+
+  impl->presentation_feedbacks = g_slist_remove (impl->presentation_feedbacks, feedback);
+
+  timings = gdk_frame_clock_get_timings (clock, feedback->frame_counter);
+  if (timings != NULL && !timings->complete)
+    {
+      if (presentation_time != 0)
+        timings->presentation_time = presentation_time;
+      if (refresh_interval != 0)
+        timings->refresh_interval = refresh_interval;
+      else if (timings->refresh_interval == 0)
+        timings->refresh_interval = 16667;
+
+      complete_frame_timings (clock, timings);
+    }
+
+  presentation_feedback_free (feedback);
+}
+
+static void
+presentation_feedback_sync_output (void                            *data,
+                                   struct wp_presentation_feedback *wp_feedback,
+                                   struct wl_output                *output)
+{
+}
+
+static void
+presentation_feedback_presented (void                            *data,
+                                 struct wp_presentation_feedback *wp_feedback,
+                                 uint32_t                         tv_sec_hi,
+                                 uint32_t                         tv_sec_lo,
+                                 uint32_t                         tv_nsec,
+                                 uint32_t                         refresh,
+                                 uint32_t                         seq_hi,
+                                 uint32_t                         seq_lo,
+                                 uint32_t                         flags)
+{
+  PresentationFeedback *feedback = data;
+  gint64 presentation_time;
+
+  gdk_profiler_add_mark (GDK_PROFILER_CURRENT_TIME, 0, "wayland", "presented");
+
+  /* We only ask for feedback if the compositor's presentation clock
+   * is the monotonic clock that frame times use */
+  presentation_time = ((((gint64) tv_sec_hi << 32) | tv_sec_lo) * G_USEC_PER_SEC) + tv_nsec / 1000;
+
+  presentation_feedback_finish (feedback, presentation_time, refresh / 1000);
+}
+
+static void
+presentation_feedback_discarded (void                            *data,
+                                 struct wp_presentation_feedback *wp_feedback)
+{
+  presentation_feedback_finish (data, 0, 0);
+}
+
+static const struct wp_presentation_feedback_listener presentation_feedback_listener = {
+  presentation_feedback_sync_output,
+  presentation_feedback_presented,
+  presentation_feedback_discarded
+};
+
+static void
+request_presentation_feedback (GdkSurface *surface,
+                               gint64      frame_counter)
+{
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+  GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (surface);
+  PresentationFeedback *feedback;
+
+  if (display_wayland->presentation == NULL ||
+      display_wayland->presentation_clock_id != CLOCK_MONOTONIC)
+    return;
+
+  if (has_presentation_feedback (impl, frame_counter))
+    return;
+
+  feedback = g_new0 (PresentationFeedback, 1);
+  feedback->surface = surface;
+  feedback->frame_counter = frame_counter;
+  feedback->feedback = wp_presentation_feedback (display_wayland->presentation,
+                                                 impl->display_server.wl_surface);
+  wl_proxy_set_queue ((struct wl_proxy *) feedback->feedback, NULL);
+  wp_presentation_feedback_add_listener (feedback->feedback,
+                                         &presentation_feedback_listener,
+                                         feedback);
+
+  impl->presentation_feedbacks = g_slist_prepend (impl->presentation_feedbacks, feedback);
+}
+
 static void
 frame_callback (void               *data,
                 struct wl_callback *callback,
@@ -517,10 +675,13 @@ frame_callback (void               *data,
     }
 
   timings = gdk_frame_clock_get_timings (clock, impl->pending_frame_counter);
-  impl->pending_frame_counter = 0;
 
-  if (timings == NULL)
-    return;
+  /* The presentation feedback may have completed the timings already */
+  if (timings == NULL || timings->complete)
+    {
+      impl->pending_frame_counter = 0;
+      return;
+    }
 
   timings->refresh_interval = 16667; /* default to 1/60th of a second */
   if (impl->display_server.outputs)
@@ -534,17 +695,18 @@ frame_callback (void               *data,
         timings->refresh_interval = G_GINT64_CONSTANT(1000000000) / refresh_rate;
     }
 
-  fill_presentation_time_from_frame_time (timings, time);
-
-  timings->complete = TRUE;
+  /* With presentation feedback, the compositor tells us the real
+   * presentation time and refresh interval once the frame is shown */
+  if (has_presentation_feedback (impl, impl->pending_frame_counter))
+    {
+      impl->pending_frame_counter = 0;
+      return;
+    }
+  impl->pending_frame_counter = 0;
 
-#ifdef G_ENABLE_DEBUG
-  if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
-    _gdk_frame_clock_debug_print_timings (clock, timings);
-#endif
+  fill_presentation_time_from_frame_time (timings, time);
 
-  if (GDK_PROFILER_IS_RUNNING)
-    _gdk_frame_clock_add_timings_to_profiler (clock, timings);
+  complete_frame_timings (clock, timings);
 }
 
 static const struct wl_callback_listener frame_listener = {
@@ -601,6 +763,8 @@ gdk_wayland_surface_request_frame (GdkSurface *surface)
   wl_callback_add_listener (callback, &frame_listener, surface);
   impl->pending_frame_counter = gdk_frame_clock_get_frame_counter (clock);
   impl->awaiting_frame = TRUE;
+
+  request_presentation_feedback (surface, impl->pending_frame_counter);
 }
 
 void
@@ -2671,6 +2835,166 @@ unmap_popups_for_surface (GdkSurface *surface)
     }
 }
 
+typedef struct {
+  struct wl_buffer *wl_buffer;
+  GdkTexture *texture;
+} OffloadBuffer;
+
+static void
+offload_buffer_release (void             *data,
+                        struct wl_buffer *wl_buffer)
+{
+  OffloadBuffer *buffer = data;
+
+  /* The compositor is done with the dmabuf, the texture can go */
+  wl_buffer_destroy (buffer->wl_buffer);
+  g_object_unref (buffer->texture);
+  g_free (buffer);
+}
+
+static const struct wl_buffer_listener offload_buffer_listener = {
+  offload_buffer_release
+};
+
+static struct wl_buffer *
+create_offload_buffer (GdkWaylandDisplay *display_wayland,
+                       GdkDmabufTexture  *texture)
+{
+  struct zwp_linux_buffer_params_v1 *params;
+  OffloadBuffer *buffer;
+  guint64 modifier;
+  guint i;
+
+  modifier = gdk_dmabuf_texture_get_modifier (texture);
+
+  params = zwp_linux_dmabuf_v1_create_params (display_wayland->linux_dmabuf);
+  for (i = 0; i < gdk_dmabuf_texture_get_n_planes (texture); i++)
+    zwp_linux_buffer_params_v1_add (params,
+                                    gdk_dmabuf_texture_get_fd (texture, i),
+                                    i,
+                                    gdk_dmabuf_texture_get_offset (texture, i),
+                                    gdk_dmabuf_texture_get_stride (texture, i),
+                                    modifier >> 32,
+                                    modifier & 0xffffffff);
+
+  buffer = g_new (OffloadBuffer, 1);
+  buffer->texture = g_object_ref (GDK_TEXTURE (texture));
+  buffer->wl_buffer = zwp_linux_buffer_params_v1_create_immed (params,
+                                                               gdk_texture_get_width (GDK_TEXTURE (texture)),
+                                                               gdk_texture_get_height (GDK_TEXTURE (texture)),
+                                                               gdk_dmabuf_texture_get_fourcc (texture),
+                                                               0);
+  zwp_linux_buffer_params_v1_destroy (params);
+
+  wl_buffer_add_listener (buffer->wl_buffer, &offload_buffer_listener, buffer);
+
+  return buffer->wl_buffer;
+}
+
+static void
+gdk_wayland_surface_hide_offload (GdkSurface *surface)
+{
+  GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (surface);
+
+  if (impl->offload.texture == NULL)
+    return;
+
+  wl_surface_attach (impl->offload.wl_surface, NULL, 0, 0);
+  wl_surface_commit (impl->offload.wl_surface);
+  g_clear_object (&impl->offload.texture);
+}
+
+static void
+gdk_wayland_surface_destroy_offload (GdkSurface *surface)
+{
+  GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (surface);
+
+  g_clear_pointer (&impl->offload.viewport, wp_viewport_destroy);
+  g_clear_pointer (&impl->offload.wl_subsurface, wl_subsurface_destroy);
+  g_clear_pointer (&impl->offload.wl_surface, wl_surface_destroy);
+  g_clear_object (&impl->offload.texture);
+}
+
+static gboolean
+gdk_wayland_surface_offload_texture (GdkSurface         *surface,
+                                     GdkTexture         *texture,
+                                     const GdkRectangle *area)
+{
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+  GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (surface);
+  gboolean was_shown;
+
+  if (texture == NULL)
+    {
+      gdk_wayland_surface_hide_offload (surface);
+      return TRUE;
+    }
+
+  if (impl->display_server.wl_surface == NULL ||
+      display_wayland->subcompositor == NULL ||
+      display_wayland->viewporter == NULL ||
+      !GDK_IS_DMABUF_TEXTURE (texture) ||
+      !gdk_wayland_display_supports_dmabuf (display_wayland,
+                                            gdk_dmabuf_texture_get_fourcc (GDK_DMABUF_TEXTURE (texture)),
+                                            gdk_dmabuf_texture_get_modifier (GDK_DMABUF_TEXTURE (texture))))
+    {
+      gdk_wayland_surface_hide_offload (surface);
+      return FALSE;
+    }
+
+  if (impl->offload.wl_surface == NULL)
+    {
+      struct wl_region *region;
+
+      impl->offload.wl_surface = wl_compositor_create_surface (display_wayland->compositor);
+      impl->offload.wl_subsurface = wl_subcompositor_get_subsurface (display_wayland->subcompositor,
+                                                                     impl->offload.wl_surface,
+                                                                     impl->display_server.wl_surface);
+      wl_subsurface_place_above (impl->offload.wl_subsurface, impl->display_server.wl_surface);
+      /* Let new frames show up without waiting for the parent to commit */
+      wl_subsurface_set_desync (impl->offload.wl_subsurface);
+      impl->offload.viewport = wp_viewporter_get_viewport (display_wayland->viewporter,
+                                                           impl->offload.wl_surface);
+
+      /* Input goes to the parent, where the widgets are */
+      region = wl_compositor_create_region (display_wayland->compositor);
+      wl_surface_set_input_region (impl->offload.wl_surface, region);
+      wl_region_destroy (region);
+    }
+
+  was_shown = impl->offload.texture != NULL;
+
+  /* The position is applied with the next commit of the parent */
+  if (!was_shown ||
+      impl->offload.area.x != area->x || impl->offload.area.y != area->y)
+    wl_subsurface_set_position (impl->offload.wl_subsurface, area->x, area->y);
+
+  if (was_shown &&
+      texture == impl->offload.texture &&
+      impl->offload.area.width == area->width &&
+      impl->offload.area.height == area->height)
+    {
+      impl->offload.area = *area;
+      return TRUE;
+    }
+
+  wp_viewport_set_destination (impl->offload.viewport, area->width, area->height);
+  impl->offload.area = *area;
+
+  if (texture != impl->offload.texture)
+    {
+      wl_surface_attach (impl->offload.wl_surface,
+                         create_offload_buffer (display_wayland, GDK_DMABUF_TEXTURE (texture)),
+                         0, 0);
+      wl_surface_damage (impl->offload.wl_surface, 0, 0, G_MAXINT32, G_MAXINT32);
+      g_set_object (&impl->offload.texture, texture);
+    }
+
+  wl_surface_commit (impl->offload.wl_surface);
+
+  return TRUE;
+}
+
 static void
 gdk_wayland_surface_hide_surface (GdkSurface *surface)
 {
@@ -2787,6 +3111,12 @@ gdk_wayland_surface_hide_surface (GdkSurface *surface)
           impl->application.was_set = FALSE;
         }
 
+      gdk_wayland_surface_destroy_offload (surface);
+
+      g_slist_free_full (impl->presentation_feedbacks,
+                         (GDestroyNotify) presentation_feedback_free);
+      impl->presentation_feedbacks = NULL;
+
       wl_surface_destroy (impl->display_server.wl_surface);
       impl->display_server.wl_surface = NULL;
 
@@ -4025,6 +4355,7 @@ gdk_wayland_surface_class_init (GdkWaylandSurfaceClass *klass)
   impl_class->set_opaque_region = gdk_wayland_surface_set_opaque_region;
   impl_class->set_shadow_width = gdk_wayland_surface_set_shadow_width;
   impl_class->create_gl_context = gdk_wayland_surface_create_gl_context;
+  impl_class->offload_texture = gdk_wayland_surface_offload_texture;
 }
 
 void
@@ -29,6 +29,11 @@
 
 #include <Windows.h>
 
+#define COBJMACROS
+#include <initguid.h>
+#include <d3d11.h>
+#include <dxgi1_2.h>
+
 G_DEFINE_TYPE (GdkWin32CairoContext, gdk_win32_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
 static cairo_surface_t *
@@ -91,6 +96,344 @@ create_cairo_surface_for_surface (GdkSurface *surface,
   return cairo_surface;
 }
 
+/* Non-layered windows are presented through a DXGI flip-model swap
+ * chain when possible. Painting still happens with cairo, into an image
+ * surface that keeps the whole window contents; only the rectangles that
+ * the two back buffers miss are uploaded, and the painted ones are passed
+ * to Present1() as dirty rectangles so DWM only recomposes those. This is
+ * opaque only: flip-model swap chains for a HWND ignore alpha.
+ *
+ * Set GDK_WIN32_CAIRO_DXGI=0 to always draw with GDI.
+ */
+typedef HRESULT (WINAPI *GdkD3D11CreateDevice) (IDXGIAdapter *, D3D_DRIVER_TYPE, HMODULE, UINT,
+                                                const D3D_FEATURE_LEVEL *, UINT, UINT,
+                                                ID3D11Device **, D3D_FEATURE_LEVEL *,
+                                                ID3D11DeviceContext **);
+
+static void
+gdk_win32_cairo_context_release_swap_chain (GdkWin32CairoContext *self)
+{
+  int i;
+
+  if (self->swap_chain)
+    IDXGISwapChain1_Release (self->swap_chain);
+  self->swap_chain = NULL;
+
+  if (self->d3d_context)
+    ID3D11DeviceContext_Release (self->d3d_context);
+  self->d3d_context = NULL;
+
+  if (self->d3d_device)
+    ID3D11Device_Release (self->d3d_device);
+  self->d3d_device = NULL;
+
+  g_clear_pointer (&self->swap_chain_surface, cairo_surface_destroy);
+  for (i = 0; i < G_N_ELEMENTS (self->buffer_stale); i++)
+    g_clear_pointer (&self->buffer_stale[i], cairo_region_destroy);
+
+  self->last_sync_qpc = 0;
+  self->last_sync_refresh_count = 0;
+}
+
+static gboolean
+create_swap_chain (GdkWin32CairoContext *self,
+                   GdkSurface           *surface,
+                   int                   width,
+                   int                   height)
+{
+  static GdkD3D11CreateDevice d3d11_create_device = NULL;
+  static gboolean d3d11_loaded = FALSE;
+  IDXGIDevice *dxgi_device = NULL;
+  IDXGIAdapter *adapter = NULL;
+  IDXGIFactory2 *factory = NULL;
+  DXGI_SWAP_CHAIN_DESC1 desc = { 0, };
+  HRESULT hr;
+
+  if (!d3d11_loaded)
+    {
+      HMODULE d3d11 = LoadLibrary ("d3d11.dll");
+
+      if (d3d11 != NULL)
+        d3d11_create_device = (GdkD3D11CreateDevice) GetProcAddress (d3d11, "D3D11CreateDevice");
+      d3d11_loaded = TRUE;
+    }
+
+  if (d3d11_create_device == NULL)
+    return FALSE;
+
+  hr = d3d11_create_device (NULL, D3D_DRIVER_TYPE_HARDWARE, NULL,
+                            D3D11_CREATE_DEVICE_BGRA_SUPPORT,
+                            NULL, 0, D3D11_SDK_VERSION,
+                            &self->d3d_device, NULL, &self->d3d_context);
+  if (FAILED (hr))
+    return FALSE;
+
+  /* IDXGIFactory2 needs Windows 8 or the platform update for 7; flip
+   * model swap chains for windows fail to create on the latter.
+   */
+  hr = ID3D11Device_QueryInterface (self->d3d_device, &IID_IDXGIDevice, (void **) &dxgi_device);
+  if (SUCCEEDED (hr))
+    hr = IDXGIDevice_GetAdapter (dxgi_device, &adapter);
+  if (SUCCEEDED (hr))
+    hr = IDXGIAdapter_GetParent (adapter, &IID_IDXGIFactory2, (void **) &factory);
+
+  if (SUCCEEDED (hr))
+    {
+      desc.Width = width;
+      desc.Height = height;
+      desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+      desc.SampleDesc.Count = 1;
+      desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+      desc.BufferCount = G_N_ELEMENTS (self->buffer_stale);
+      desc.Scaling = DXGI_SCALING_NONE;
+      desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+      desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+
+      hr = IDXGIFactory2_CreateSwapChainForHwnd (factory,
+                                                 (IUnknown *) self->d3d_device,
+                                                 GDK_SURFACE_HWND (surface),
+                                                 &desc, NULL, NULL,
+                                                 &self->swap_chain);
+      if (SUCCEEDED (hr))
+        IDXGIFactory2_MakeWindowAssociation (factory, GDK_SURFACE_HWND (surface), DXGI_MWA_NO_ALT_ENTER);
+    }
+
+  if (factory)
+    IDXGIFactory2_Release (factory);
+  if (adapter)
+    IDXGIAdapter_Release (adapter);
+  if (dxgi_device)
+    IDXGIDevice_Release (dxgi_device);
+
+  return SUCCEEDED (hr);
+}
+
+static gboolean
+gdk_win32_cairo_context_ensure_swap_chain (GdkWin32CairoContext *self,
+                                           GdkSurface           *surface,
+                                           int                   width,
+                                           int                   height,
+                                           int                   scale)
+{
+  cairo_surface_t *contents;
+  cairo_rectangle_int_t rect = { 0, 0, width, height };
+  int i;
+
+  if (self->swap_chain_failed)
+    return FALSE;
+
+  if (self->swap_chain == NULL)
+    {
+      if (!create_swap_chain (self, surface, width, height))
+        {
+          GDK_NOTE (MISC, g_print ("Not using a DXGI swap chain for drawing\n"));
+          gdk_win32_cairo_context_release_swap_chain (self);
+          self->swap_chain_failed = TRUE;
+          return FALSE;
+        }
+    }
+  else if (width == cairo_image_surface_get_width (self->swap_chain_surface) &&
+           height == cairo_image_surface_get_height (self->swap_chain_surface))
+    {
+      cairo_surface_set_device_scale (self->swap_chain_surface, scale, scale);
+      return TRUE;
+    }
+  else if (FAILED (IDXGISwapChain1_ResizeBuffers (self->swap_chain, 0, width, height,
+                                                  DXGI_FORMAT_UNKNOWN, 0)))
+    {
+      gdk_win32_cairo_context_release_swap_chain (self);
+      self->swap_chain_failed = TRUE;
+      return FALSE;
+    }
+
+  /* Keep what we have, it is copied to the new buffers */
+  contents = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  if (self->swap_chain_surface)
+    {
+      cairo_t *cr = cairo_create (contents);
+
+      cairo_surface_set_device_scale (self->swap_chain_surface, 1, 1);
+      cairo_set_source_surface (cr, self->swap_chain_surface, 0, 0);
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_paint (cr);
+      cairo_destroy (cr);
+      cairo_surface_destroy (self->swap_chain_surface);
+    }
+  cairo_surface_set_device_scale (contents, scale, scale);
+  self->swap_chain_surface = contents;
+
+  for (i = 0; i < G_N_ELEMENTS (self->buffer_stale); i++)
+    {
+      g_clear_pointer (&self->buffer_stale[i], cairo_region_destroy);
+      self->buffer_stale[i] = cairo_region_create_rectangle (&rect);
+    }
+  self->back_buffer = 0;
+
+  return TRUE;
+}
+
+static void
+gdk_win32_cairo_context_update_timings (GdkWin32CairoContext *self,
+                                        GdkSurface           *surface)
+{
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  DXGI_FRAME_STATISTICS stats;
+  LARGE_INTEGER tick_frequency;
+  GdkFrameTimings *timings;
+  UINT present_count;
+  guint slot;
+
+  if (clock == NULL ||
+      FAILED (IDXGISwapChain1_GetLastPresentCount (self->swap_chain, &present_count)))
+    return;
+
+  slot = present_count % G_N_ELEMENTS (self->presents);
+  self->presents[slot].present_count = present_count;
+  self->presents[slot].frame_counter = gdk_frame_clock_get_frame_counter (clock);
+
+  /* The statistics are about the last vblank with a present on it,
+   * which typically is a frame or two behind this one */
+  if (FAILED (IDXGISwapChain1_GetFrameStatistics (self->swap_chain, &stats)) ||
+      !QueryPerformanceFrequency (&tick_frequency))
+    return;
+
+  if (self->last_sync_refresh_count != 0 &&
+      stats.SyncRefreshCount > self->last_sync_refresh_count &&
+      stats.SyncQPCTime.QuadPart > self->last_sync_qpc)
+    self->refresh_interval = (stats.SyncQPCTime.QuadPart - self->last_sync_qpc) * (double)G_USEC_PER_SEC /
+                             tick_frequency.QuadPart / (stats.SyncRefreshCount - self->last_sync_refresh_count);
+  self->last_sync_qpc = stats.SyncQPCTime.QuadPart;
+  self->last_sync_refresh_count = stats.SyncRefreshCount;
+
+  slot = stats.PresentCount % G_N_ELEMENTS (self->presents);
+  if (self->presents[slot].present_count != stats.PresentCount)
+    return;
+
+  timings = gdk_frame_clock_get_timings (clock, self->presents[slot].frame_counter);
+  if (timings == NULL)
+    return;
+
+  timings->presentation_time = stats.SyncQPCTime.QuadPart * (double)G_USEC_PER_SEC / tick_frequency.QuadPart;
+  if (self->refresh_interval != 0)
+    timings->refresh_interval = self->refresh_interval;
+}
+
+static void
+gdk_win32_cairo_context_present (GdkWin32CairoContext *self,
+                                 GdkSurface           *surface,
+                                 cairo_region_t       *painted,
+                                 int                   scale)
+{
+  cairo_rectangle_int_t bounds = { 0, 0, 0, 0 };
+  DXGI_PRESENT_PARAMETERS params = { 0, };
+  ID3D11Texture2D *back_buffer;
+  cairo_region_t *dirty, *upload;
+  const guchar *data;
+  RECT *rects;
+  int stride, n_rects, i;
+  guint other;
+  HRESULT hr;
+
+  cairo_surface_flush (self->swap_chain_surface);
+  data = cairo_image_surface_get_data (self->swap_chain_surface);
+  stride = cairo_image_surface_get_stride (self->swap_chain_surface);
+  bounds.width = cairo_image_surface_get_width (self->swap_chain_surface);
+  bounds.height = cairo_image_surface_get_height (self->swap_chain_surface);
+
+  /* In device pixels */
+  dirty = cairo_region_create ();
+  for (i = 0; i < cairo_region_num_rectangles (painted); i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (painted, i, &rect);
+      rect.x *= scale;
+      rect.y *= scale;
+      rect.width *= scale;
+      rect.height *= scale;
+      cairo_region_union_rectangle (dirty, &rect);
+    }
+  cairo_region_intersect_rectangle (dirty, &bounds);
+
+  if (cairo_region_is_empty (dirty))
+    {
+      cairo_region_destroy (dirty);
+      return;
+    }
+
+  hr = IDXGISwapChain1_GetBuffer (self->swap_chain, 0, &IID_ID3D11Texture2D, (void **) &back_buffer);
+  if (FAILED (hr))
+    goto fail;
+
+  upload = cairo_region_copy (self->buffer_stale[self->back_buffer]);
+  cairo_region_union (upload, dirty);
+  for (i = 0; i < cairo_region_num_rectangles (upload); i++)
+    {
+      cairo_rectangle_int_t rect;
+      D3D11_BOX box;
+
+      cairo_region_get_rectangle (upload, i, &rect);
+      box.left = rect.x;
+      box.top = rect.y;
+      box.front = 0;
+      box.right = rect.x + rect.width;
+      box.bottom = rect.y + rect.height;
+      box.back = 1;
+
+      ID3D11DeviceContext_UpdateSubresource (self->d3d_context,
+                                             (ID3D11Resource *) back_buffer,
+                                             0, &box,
+                                             data + rect.y * stride + rect.x * 4,
+                                             stride, 0);
+    }
+  cairo_region_destroy (upload);
+  ID3D11Texture2D_Release (back_buffer);
+
+  n_rects = cairo_region_num_rectangles (dirty);
+  rects = g_new (RECT, n_rects);
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (dirty, i, &rect);
+      rects[i].left = rect.x;
+      rects[i].top = rect.y;
+      rects[i].right = rect.x + rect.width;
+      rects[i].bottom = rect.y + rect.height;
+    }
+
+  params.DirtyRectsCount = n_rects;
+  params.pDirtyRects = rects;
+  hr = IDXGISwapChain1_Present1 (self->swap_chain, 1, 0, &params);
+  g_free (rects);
+
+  if (FAILED (hr))
+    goto fail;
+
+  /* The buffer we just presented is complete, the other one now
+   * misses what we painted */
+  cairo_region_destroy (self->buffer_stale[self->back_buffer]);
+  self->buffer_stale[self->back_buffer] = cairo_region_create ();
+  other = (self->back_buffer + 1) % G_N_ELEMENTS (self->buffer_stale);
+  cairo_region_union (self->buffer_stale[other], dirty);
+  self->back_buffer = other;
+
+  cairo_region_destroy (dirty);
+
+  gdk_win32_cairo_context_update_timings (self, surface);
+
+  return;
+
+fail:
+  /* Includes losing the device. Draw with GDI from now on, starting
+   * with a full repaint. */
+  GDK_NOTE (MISC, g_print ("Presenting with DXGI failed: 0x%lx\n", hr));
+  cairo_region_destroy (dirty);
+  gdk_win32_cairo_context_release_swap_chain (self);
+  self->swap_chain_failed = TRUE;
+  gdk_surface_invalidate_rect (surface, NULL);
+}
+
 static void
 gdk_win32_cairo_context_begin_frame (GdkDrawContext *draw_context,
                                      cairo_region_t *region)
@@ -114,13 +457,17 @@ gdk_win32_cairo_context_begin_frame (GdkDrawContext *draw_context,
   width = MAX (width, 1);
   height = MAX (height, 1);
 
+  /* Layered windows can't have a flip-model swap chain */
   if (self->layered)
-    self->window_surface = create_cairo_surface_for_layered_window (impl, width, height, scale);
-  else
-    self->window_surface = create_cairo_surface_for_surface (surface, scale);
+    gdk_win32_cairo_context_release_swap_chain (self);
 
-  if (self->layered ||
-      !self->double_buffered)
+  if (!self->layered &&
+      gdk_win32_cairo_context_ensure_swap_chain (self, surface, width, height, scale))
+    {
+      self->paint_surface = cairo_surface_reference (self->swap_chain_surface);
+    }
+  else if (self->layered ||
+           !self->double_buffered)
     {
       /* Layered windows paint on the window_surface (which is itself
        * an in-memory cache that the window maintains, since layered windows
@@ -128,10 +475,17 @@ gdk_win32_cairo_context_begin_frame (GdkDrawContext *draw_context,
        * Non-double-buffered windows paint on the window surface directly
        * as well.
        */
+      if (self->layered)
+        self->window_surface = create_cairo_surface_for_layered_window (impl, width, height, scale);
+      else
+        self->window_surface = create_cairo_surface_for_surface (surface, scale);
+
       self->paint_surface = cairo_surface_reference (self->window_surface);
     }
   else
     {
+      self->window_surface = create_cairo_surface_for_surface (surface, scale);
+
       if (width > self->db_width ||
           height > self->db_height)
         {
@@ -179,6 +533,13 @@ gdk_win32_cairo_context_end_frame (GdkDrawContext *draw_context,
   surface = gdk_draw_context_get_surface (draw_context);
   scale = gdk_surface_get_scale_factor (surface);
 
+  if (self->window_surface == NULL)
+    {
+      gdk_win32_cairo_context_present (self, surface, painted, scale);
+      g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+      return;
+    }
+
   /* The code to resize double-buffered windows immediately
    * before blitting the buffer contents onto them used
    * to be here.
@@ -237,6 +598,7 @@ gdk_win32_cairo_context_finalize (GObject *object)
   GdkWin32CairoContext *self = GDK_WIN32_CAIRO_CONTEXT (object);
 
   g_clear_pointer (&self->db_surface, cairo_surface_destroy);
+  gdk_win32_cairo_context_release_swap_chain (self);
 
   G_OBJECT_CLASS (gdk_win32_cairo_context_parent_class)->finalize (object);
 }
@@ -260,6 +622,7 @@ static void
 gdk_win32_cairo_context_init (GdkWin32CairoContext *self)
 {
   self->double_buffered = g_strcmp0 (g_getenv ("GDK_WIN32_CAIRO_DB"), "1") == 0;
+  self->swap_chain_failed = g_strcmp0 (g_getenv ("GDK_WIN32_CAIRO_DXGI"), "0") == 0;
   self->db_width = -1;
   self->db_height = -1;
 }
@@ -64,6 +64,27 @@ struct _GdkWin32CairoContext
    * this is a reference to window_surface.
    */
   cairo_surface_t *paint_surface;
+
+  /* DXGI flip-model presentation for non-layered windows.
+   * swap_chain_surface holds the whole window contents, and
+   * buffer_stale what each of the two back buffers misses of it.
+   */
+  struct ID3D11Device        *d3d_device;
+  struct ID3D11DeviceContext *d3d_context;
+  struct IDXGISwapChain1     *swap_chain;
+  cairo_surface_t            *swap_chain_surface;
+  cairo_region_t             *buffer_stale[2];
+  guint                       back_buffer;
+  guint                       swap_chain_failed : 1;
+
+  /* Maps present counts to frames, for the frame statistics */
+  struct {
+    guint  present_count;
+    gint64 frame_counter;
+  }                           presents[4];
+  gint64                      last_sync_qpc;
+  guint                       last_sync_refresh_count;
+  gint64                      refresh_interval;
 };
 
 struct _GdkWin32CairoContextClass
@@ -1876,6 +1876,7 @@ gdk_event_translate (MSG *msg,
 		     buf, sizeof (buf));
       _gdk_input_codepage = atoi (buf);
       _gdk_keymap_serial++;
+      gdk_keymap_clear_translations (_gdk_win32_display_get_keymap (_gdk_display));
       GDK_NOTE (EVENTS,
 		g_print (" cs:%lu hkl:%p%s cp:%d",
 			 (gulong) msg->wParam,
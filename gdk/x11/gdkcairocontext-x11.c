@@ -25,11 +25,51 @@
 #include "gdkprivate-x11.h"
 
 #include "gdkcairo.h"
+#include "gdkdisplay-x11.h"
+#include "gdkframeclockprivate.h"
 #include "gdksurfaceprivate.h"
 #include "gdkinternals.h"
 
 #include <X11/Xlib.h>
 
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
+#ifdef HAVE_XFIXES
+#include <X11/extensions/Xfixes.h>
+#endif
+
+#ifdef HAVE_XPRESENT
+#include <X11/extensions/Xpresent.h>
+#endif
+
+/* When the server runs on the same machine, frames are painted into
+ * image surfaces living in shared memory and handed to the server with
+ * XShmPutImage(), or presented with XPresentPixmap() if the Present
+ * extension is there, which also tells us when the frame hit the
+ * screen. There are two such buffers so that painting doesn't have
+ * to wait for the server to be done with the previous frame; whatever
+ * the buffer misses from the frames painted into the other one is
+ * copied over before painting. If both buffers are busy, or shared
+ * memory can't be used, we fall back to drawing with Xlib.
+ */
+struct _GdkX11ShmBuffer
+{
+#ifdef HAVE_XSHM
+  XShmSegmentInfo shminfo;
+#endif
+  XImage *image;
+  Pixmap pixmap;
+  cairo_surface_t *surface;
+  /* What the buffer lacks compared to the screen */
+  cairo_region_t *stale;
+  guint attached : 1;
+  guint busy : 1;
+};
+
 G_DEFINE_TYPE (GdkX11CairoContext, gdk_x11_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
 static cairo_surface_t *
@@ -54,6 +94,479 @@ create_cairo_surface_for_surface (GdkSurface *surface)
   return cairo_surface;
 }
 
+#ifdef HAVE_XSHM
+
+static void
+gdk_x11_shm_buffer_free (GdkDisplay      *display,
+                         GdkX11ShmBuffer *buffer)
+{
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+
+  if (buffer->pixmap != None)
+    XFreePixmap (xdisplay, buffer->pixmap);
+
+  if (buffer->attached)
+    XShmDetach (xdisplay, &buffer->shminfo);
+
+  g_clear_pointer (&buffer->surface, cairo_surface_destroy);
+  g_clear_pointer (&buffer->stale, cairo_region_destroy);
+
+  if (buffer->image)
+    {
+      buffer->image->data = NULL;
+      XDestroyImage (buffer->image);
+    }
+
+  if (buffer->shminfo.shmaddr != (char *) -1)
+    shmdt (buffer->shminfo.shmaddr);
+
+  if (buffer->shminfo.shmid != -1 && !buffer->attached)
+    shmctl (buffer->shminfo.shmid, IPC_RMID, NULL);
+
+  g_free (buffer);
+}
+
+static GdkX11ShmBuffer *
+gdk_x11_shm_buffer_new (GdkSurface *surface,
+                        int         width,
+                        int         height,
+                        int         scale)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  Display *xdisplay = display_x11->xdisplay;
+  Visual *visual = gdk_x11_display_get_window_visual (display_x11);
+  int depth = gdk_x11_display_get_window_depth (display_x11);
+  GdkX11ShmBuffer *buffer;
+  cairo_format_t format;
+  cairo_rectangle_int_t rect;
+
+  /* The image must have the layout of a cairo image surface */
+  if (depth == 32)
+    format = CAIRO_FORMAT_ARGB32;
+  else if (depth == 24)
+    format = CAIRO_FORMAT_RGB24;
+  else
+    return NULL;
+
+  if (visual->red_mask != 0xff0000 ||
+      visual->green_mask != 0xff00 ||
+      visual->blue_mask != 0xff)
+    return NULL;
+
+  buffer = g_new0 (GdkX11ShmBuffer, 1);
+  buffer->shminfo.shmid = -1;
+  buffer->shminfo.shmaddr = (char *) -1;
+
+  buffer->image = XShmCreateImage (xdisplay, visual, depth, ZPixmap, NULL,
+                                   &buffer->shminfo, width, height);
+  if (buffer->image == NULL ||
+      buffer->image->bits_per_pixel != 32 ||
+      buffer->image->byte_order != (G_BYTE_ORDER == G_LITTLE_ENDIAN ? LSBFirst : MSBFirst))
+    goto fail;
+
+  buffer->shminfo.shmid = shmget (IPC_PRIVATE,
+                                  buffer->image->bytes_per_line * height,
+                                  IPC_CREAT | 0600);
+  if (buffer->shminfo.shmid == -1)
+    goto fail;
+
+  buffer->shminfo.shmaddr = shmat (buffer->shminfo.shmid, NULL, 0);
+  if (buffer->shminfo.shmaddr == (char *) -1)
+    goto fail;
+
+  buffer->shminfo.readOnly = True;
+  buffer->image->data = buffer->shminfo.shmaddr;
+
+  /* This fails if the server can't see our memory, e.g. when it
+   * runs on another machine */
+  gdk_x11_display_error_trap_push (display);
+  XShmAttach (xdisplay, &buffer->shminfo);
+  if (gdk_x11_display_error_trap_pop (display))
+    goto fail;
+
+  /* The segment goes away once both sides detached from it */
+  buffer->attached = TRUE;
+  shmctl (buffer->shminfo.shmid, IPC_RMID, NULL);
+
+#ifdef HAVE_XPRESENT
+  if (display_x11->have_present && display_x11->have_shm_pixmaps)
+    buffer->pixmap = XShmCreatePixmap (xdisplay, GDK_SURFACE_XID (surface),
+                                       buffer->shminfo.shmaddr, &buffer->shminfo,
+                                       width, height, depth);
+#endif
+
+  buffer->surface = cairo_image_surface_create_for_data ((guchar *) buffer->shminfo.shmaddr,
+                                                         format, width, height,
+                                                         buffer->image->bytes_per_line);
+  cairo_surface_set_device_scale (buffer->surface, scale, scale);
+
+  rect.x = 0;
+  rect.y = 0;
+  rect.width = gdk_surface_get_width (surface);
+  rect.height = gdk_surface_get_height (surface);
+  buffer->stale = cairo_region_create_rectangle (&rect);
+
+  return buffer;
+
+fail:
+  gdk_x11_shm_buffer_free (display, buffer);
+  return NULL;
+}
+
+static void
+gdk_x11_cairo_context_clear_buffers (GdkX11CairoContext *self)
+{
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (self->buffers); i++)
+    {
+      if (self->buffers[i])
+        gdk_x11_shm_buffer_free (display, self->buffers[i]);
+      self->buffers[i] = NULL;
+    }
+
+  self->current_buffer = NULL;
+  self->last_buffer = NULL;
+}
+
+#ifdef HAVE_XPRESENT
+static void
+gdk_x11_cairo_context_complete_frame (GdkX11CairoContext *self,
+                                      GdkSurface         *surface,
+                                      guint32             serial,
+                                      guint64             ust,
+                                      guint64             msc)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  GdkFrameTimings *timings = NULL;
+  gint64 i;
+
+  if (self->last_msc != 0 && msc > self->last_msc && ust > self->last_ust)
+    self->refresh_interval = (ust - self->last_ust) / (msc - self->last_msc);
+  self->last_ust = ust;
+  self->last_msc = msc;
+
+  _gdk_x11_surface_get_toplevel (surface)->presentation_pending = FALSE;
+
+  if (clock == NULL)
+    return;
+
+  for (i = gdk_frame_clock_get_frame_counter (clock);
+       i >= gdk_frame_clock_get_history_start (clock);
+       i--)
+    {
+      if ((guint32) i == serial)
+        {
+          timings = gdk_frame_clock_get_timings (clock, i);
+          break;
+        }
+    }
+
+  if (timings == NULL || timings->complete)
+    return;
+
+  timings->presentation_time = _gdk_x11_display_server_time_to_monotonic_time (GDK_X11_DISPLAY (display), ust);
+  if (self->refresh_interval != 0)
+    timings->refresh_interval = self->refresh_interval;
+  timings->complete = TRUE;
+
+#ifdef G_ENABLE_DEBUG
+  if (GDK_DISPLAY_DEBUG_CHECK (display, FRAMES))
+    _gdk_frame_clock_debug_print_timings (clock, timings);
+
+  if (GDK_PROFILER_IS_RUNNING)
+    _gdk_frame_clock_add_timings_to_profiler (clock, timings);
+#endif /* G_ENABLE_DEBUG */
+}
+#endif /* HAVE_XPRESENT */
+
+static gboolean
+gdk_x11_cairo_context_xevent (GdkX11CairoContext *self,
+                              const XEvent       *xevent,
+                              GdkX11Display      *display_x11)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+  int i;
+
+  if (surface == NULL || GDK_SURFACE_DESTROYED (surface))
+    return FALSE;
+
+  if (xevent->type == display_x11->shm_event_base + ShmCompletion)
+    {
+      const XShmCompletionEvent *completion = (const XShmCompletionEvent *) xevent;
+
+      for (i = 0; i < G_N_ELEMENTS (self->buffers); i++)
+        {
+          if (self->buffers[i] && self->buffers[i]->shminfo.shmseg == completion->shmseg)
+            {
+              self->buffers[i]->busy = FALSE;
+              return TRUE;
+            }
+        }
+
+      return FALSE;
+    }
+
+#ifdef HAVE_XPRESENT
+  if (xevent->type == GenericEvent &&
+      xevent->xcookie.extension == display_x11->present_opcode &&
+      xevent->xcookie.data != NULL)
+    {
+      switch (xevent->xcookie.evtype)
+        {
+        case PresentIdleNotify:
+          {
+            XPresentIdleNotifyEvent *idle = xevent->xcookie.data;
+
+            if (idle->window != GDK_SURFACE_XID (surface))
+              return FALSE;
+
+            for (i = 0; i < G_N_ELEMENTS (self->buffers); i++)
+              {
+                if (self->buffers[i] && self->buffers[i]->pixmap == idle->pixmap)
+                  self->buffers[i]->busy = FALSE;
+              }
+          }
+          return TRUE;
+
+        case PresentCompleteNotify:
+          {
+            XPresentCompleteNotifyEvent *complete = xevent->xcookie.data;
+
+            if (complete->window != GDK_SURFACE_XID (surface))
+              return FALSE;
+
+            if (complete->kind == PresentCompleteKindPixmap)
+              gdk_x11_cairo_context_complete_frame (self, surface,
+                                                    complete->serial_number,
+                                                    complete->ust,
+                                                    complete->msc);
+          }
+          return TRUE;
+
+        default:
+          break;
+        }
+    }
+#endif
+
+  return FALSE;
+}
+
+static gboolean
+gdk_x11_cairo_context_begin_shm_frame (GdkX11CairoContext *self,
+                                       GdkSurface         *surface,
+                                       cairo_region_t     *region)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  GdkX11ShmBuffer *buffer;
+  cairo_region_t *stale;
+  int scale, width, height;
+  int i;
+
+  if (!display_x11->have_shm || self->shm_failed)
+    return FALSE;
+
+  scale = gdk_surface_get_scale_factor (surface);
+  width = gdk_surface_get_width (surface) * scale;
+  height = gdk_surface_get_height (surface) * scale;
+
+  if (self->xevent_handler == 0)
+    self->xevent_handler = g_signal_connect_object (display, "xevent",
+                                                    G_CALLBACK (gdk_x11_cairo_context_xevent),
+                                                    self,
+                                                    G_CONNECT_SWAPPED);
+
+#ifdef HAVE_XPRESENT
+  if (display_x11->have_present && self->present_event_id == None)
+    self->present_event_id = XPresentSelectInput (display_x11->xdisplay,
+                                                  GDK_SURFACE_XID (surface),
+                                                  PresentCompleteNotifyMask |
+                                                  PresentIdleNotifyMask);
+#endif
+
+  /* Both buffers always have the size of the surface */
+  if (self->buffers[0] &&
+      (cairo_image_surface_get_width (self->buffers[0]->surface) != width ||
+       cairo_image_surface_get_height (self->buffers[0]->surface) != height ||
+       self->buffers[0]->image->depth != gdk_x11_display_get_window_depth (display_x11)))
+    gdk_x11_cairo_context_clear_buffers (self);
+
+  /* The buffer that was presented last is up to date */
+  if (self->last_buffer && !self->last_buffer->busy)
+    buffer = self->last_buffer;
+  else
+    {
+      buffer = NULL;
+      for (i = 0; i < G_N_ELEMENTS (self->buffers); i++)
+        {
+          if (self->buffers[i] == NULL)
+            {
+              self->buffers[i] = gdk_x11_shm_buffer_new (surface, width, height, scale);
+              if (self->buffers[i] == NULL)
+                {
+                  GDK_DISPLAY_NOTE (display, MISC, g_message ("Not using MIT-SHM for drawing"));
+                  self->shm_failed = TRUE;
+                  gdk_x11_cairo_context_clear_buffers (self);
+                  return FALSE;
+                }
+            }
+
+          if (!self->buffers[i]->busy)
+            {
+              buffer = self->buffers[i];
+              break;
+            }
+        }
+
+      /* The server is still reading both of them */
+      if (buffer == NULL)
+        return FALSE;
+    }
+
+  stale = cairo_region_copy (buffer->stale);
+  cairo_region_subtract (stale, region);
+  if (!cairo_region_is_empty (stale))
+    {
+      if (self->last_buffer && self->last_buffer != buffer)
+        {
+          cairo_t *cr = cairo_create (buffer->surface);
+
+          cairo_set_source_surface (cr, self->last_buffer->surface, 0, 0);
+          gdk_cairo_region (cr, stale);
+          cairo_clip (cr);
+          cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          cairo_paint (cr);
+          cairo_destroy (cr);
+        }
+      else
+        {
+          /* Nothing to copy from, paint it instead */
+          cairo_region_union (region, stale);
+        }
+    }
+  cairo_region_destroy (stale);
+
+  cairo_region_destroy (buffer->stale);
+  buffer->stale = cairo_region_create ();
+
+  self->current_buffer = buffer;
+  self->paint_surface = cairo_surface_reference (buffer->surface);
+
+  return TRUE;
+}
+
+static void
+gdk_x11_cairo_context_end_shm_frame (GdkX11CairoContext *self,
+                                     GdkSurface         *surface,
+                                     cairo_region_t     *painted)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  GdkX11ShmBuffer *buffer = self->current_buffer;
+  gboolean presented = FALSE;
+  int scale, n_rects, i;
+
+  scale = gdk_surface_get_scale_factor (surface);
+  n_rects = cairo_region_num_rectangles (painted);
+
+  cairo_surface_flush (buffer->surface);
+
+#ifdef HAVE_XPRESENT
+  if (buffer->pixmap != None)
+    {
+      GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+      XserverRegion update = None;
+
+#ifdef HAVE_XFIXES
+      if (display_x11->have_xfixes)
+        {
+          XRectangle *rects = g_new (XRectangle, MAX (n_rects, 1));
+
+          for (i = 0; i < n_rects; i++)
+            {
+              cairo_rectangle_int_t rect;
+
+              cairo_region_get_rectangle (painted, i, &rect);
+              rects[i].x = rect.x * scale;
+              rects[i].y = rect.y * scale;
+              rects[i].width = rect.width * scale;
+              rects[i].height = rect.height * scale;
+            }
+
+          update = XFixesCreateRegion (display_x11->xdisplay, rects, n_rects);
+          g_free (rects);
+        }
+#endif
+
+      /* Without a target MSC, this shows the frame at the next vblank */
+      XPresentPixmap (display_x11->xdisplay,
+                      GDK_SURFACE_XID (surface),
+                      buffer->pixmap,
+                      clock ? (guint32) gdk_frame_clock_get_frame_counter (clock) : 0,
+                      None, update,
+                      0, 0,
+                      None, None, None,
+                      PresentOptionNone,
+                      0, 0, 0,
+                      NULL, 0);
+
+#ifdef HAVE_XFIXES
+      if (update != None)
+        XFixesDestroyRegion (display_x11->xdisplay, update);
+#endif
+
+      buffer->busy = TRUE;
+      presented = TRUE;
+    }
+  else
+#endif
+    {
+      int width = cairo_image_surface_get_width (buffer->surface);
+      int height = cairo_image_surface_get_height (buffer->surface);
+
+      if (self->gc == NULL)
+        self->gc = XCreateGC (display_x11->xdisplay, GDK_SURFACE_XID (surface), 0, NULL);
+
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+          int x, y, w, h;
+
+          cairo_region_get_rectangle (painted, i, &rect);
+          x = CLAMP (rect.x * scale, 0, width);
+          y = CLAMP (rect.y * scale, 0, height);
+          w = CLAMP ((rect.x + rect.width) * scale, 0, width) - x;
+          h = CLAMP ((rect.y + rect.height) * scale, 0, height) - y;
+
+          /* Ask for a completion event with the last one, so we
+           * know when the buffer can be painted into again */
+          XShmPutImage (display_x11->xdisplay,
+                        GDK_SURFACE_XID (surface),
+                        self->gc,
+                        buffer->image,
+                        x, y, x, y, w, h,
+                        i == n_rects - 1);
+        }
+
+      if (n_rects > 0)
+        buffer->busy = TRUE;
+    }
+
+  /* Unless the compositor reports frame timings, the Present
+   * extension's CompleteNotify completes them */
+  _gdk_x11_surface_get_toplevel (surface)->presentation_pending =
+      presented && !_gdk_x11_surface_syncs_frames (surface);
+
+  self->last_buffer = buffer;
+  self->current_buffer = NULL;
+}
+#endif /* HAVE_XSHM */
+
 static void
 gdk_x11_cairo_context_begin_frame (GdkDrawContext *draw_context,
                                    cairo_region_t *region)
@@ -64,6 +577,12 @@ gdk_x11_cairo_context_begin_frame (GdkDrawContext *draw_context,
   double sx, sy;
 
   surface = gdk_draw_context_get_surface (draw_context);
+
+#ifdef HAVE_XSHM
+  if (gdk_x11_cairo_context_begin_shm_frame (self, surface, region))
+    return;
+#endif
+
   cairo_region_get_extents (region, &clip_box);
 
   self->window_surface = create_cairo_surface_for_surface (surface);
@@ -83,6 +602,27 @@ gdk_x11_cairo_context_end_frame (GdkDrawContext *draw_context,
 {
   GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (draw_context);
   cairo_t *cr;
+  int i;
+
+#ifdef HAVE_XSHM
+  if (self->current_buffer)
+    {
+      GdkX11ShmBuffer *buffer = self->current_buffer;
+
+      gdk_x11_cairo_context_end_shm_frame (self,
+                                           gdk_draw_context_get_surface (draw_context),
+                                           painted);
+
+      for (i = 0; i < G_N_ELEMENTS (self->buffers); i++)
+        {
+          if (self->buffers[i] && self->buffers[i] != buffer)
+            cairo_region_union (self->buffers[i]->stale, painted);
+        }
+
+      g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+      return;
+    }
+#endif
 
   cr = cairo_create (self->window_surface);
 
@@ -99,6 +639,14 @@ gdk_x11_cairo_context_end_frame (GdkDrawContext *draw_context,
 
   g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
   g_clear_pointer (&self->window_surface, cairo_surface_destroy);
+
+  /* None of the buffers has this frame now */
+  for (i = 0; i < G_N_ELEMENTS (self->buffers); i++)
+    {
+      if (self->buffers[i])
+        cairo_region_union (self->buffers[i]->stale, painted);
+    }
+  self->last_buffer = NULL;
 }
 
 static cairo_t *
@@ -109,12 +657,51 @@ gdk_x11_cairo_context_cairo_create (GdkCairoContext *context)
   return cairo_create (self->paint_surface);
 }
 
+static void
+gdk_x11_cairo_context_dispose (GObject *gobject)
+{
+  GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (gobject);
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+
+#ifdef HAVE_XSHM
+  gdk_x11_cairo_context_clear_buffers (self);
+#endif
+
+  if (self->gc)
+    {
+      XFreeGC (gdk_x11_display_get_xdisplay (display), self->gc);
+      self->gc = NULL;
+    }
+
+#ifdef HAVE_XPRESENT
+  if (self->present_event_id != None)
+    {
+      GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+
+      if (surface && !GDK_SURFACE_DESTROYED (surface))
+        {
+          gdk_x11_display_error_trap_push (display);
+          XPresentFreeInput (gdk_x11_display_get_xdisplay (display),
+                             GDK_SURFACE_XID (surface),
+                             self->present_event_id);
+          gdk_x11_display_error_trap_pop_ignored (display);
+        }
+      self->present_event_id = None;
+    }
+#endif
+
+  G_OBJECT_CLASS (gdk_x11_cairo_context_parent_class)->dispose (gobject);
+}
+
 static void
 gdk_x11_cairo_context_class_init (GdkX11CairoContextClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GdkDrawContextClass *draw_context_class = GDK_DRAW_CONTEXT_CLASS (klass);
   GdkCairoContextClass *cairo_context_class = GDK_CAIRO_CONTEXT_CLASS (klass);
 
+  gobject_class->dispose = gdk_x11_cairo_context_dispose;
+
   draw_context_class->begin_frame = gdk_x11_cairo_context_begin_frame;
   draw_context_class->end_frame = gdk_x11_cairo_context_end_frame;
 
@@ -125,4 +712,3 @@ static void
 gdk_x11_cairo_context_init (GdkX11CairoContext *self)
 {
 }
-
@@ -25,6 +25,8 @@
 
 #include "gdkcairocontextprivate.h"
 
+#include <X11/Xlib.h>
+
 G_BEGIN_DECLS
 
 #define GDK_TYPE_X11_CAIRO_CONTEXT		(gdk_x11_cairo_context_get_type ())
@@ -36,6 +38,7 @@ G_BEGIN_DECLS
 
 typedef struct _GdkX11CairoContext GdkX11CairoContext;
 typedef struct _GdkX11CairoContextClass GdkX11CairoContextClass;
+typedef struct _GdkX11ShmBuffer GdkX11ShmBuffer;
 
 struct _GdkX11CairoContext
 {
@@ -43,6 +46,20 @@ struct _GdkX11CairoContext
 
   cairo_surface_t *window_surface;
   cairo_surface_t *paint_surface;
+
+  /* MIT-SHM double buffering */
+  GdkX11ShmBuffer *buffers[2];
+  GdkX11ShmBuffer *current_buffer;      /* being painted */
+  GdkX11ShmBuffer *last_buffer;         /* matches what is on screen */
+  GC gc;
+  gulong xevent_handler;
+  guint shm_failed : 1;
+
+  /* XPresent feedback */
+  XID present_event_id;
+  guint64 last_msc;
+  gint64 last_ust;
+  gint64 refresh_interval;
 };
 
 struct _GdkX11CairoContextClass
@@ -381,32 +381,98 @@ has_abs_axes (GdkDisplay      *display,
   return (has_x && has_y);
 }
 
+/* The device properties we look at when creating devices. They are
+ * interned with a single XInternAtoms() call up front.
+ */
+static const char *const device_property_atoms[] = {
+  "Abs X",
+  "Abs Y",
+  "Abs Pressure",
+  "Abs Tilt X",
+  "Abs Tilt Y",
+  "Abs Wheel",
+  "Device Product ID",
+  "libinput Tapping Enabled",
+  "Synaptics Off",
+  "Raw Touch Passthrough",
+  "Wacom Serial IDs",
+  "Wacom Tool Type"
+};
+
+/* Listing the properties of a device is a single round trip, so only
+ * the ones it actually has get fetched.
+ */
+typedef struct
+{
+  Atom *atoms;
+  int n_atoms;
+} DeviceProperties;
+
+static void
+device_properties_init (DeviceProperties *props,
+                        GdkDisplay       *display,
+                        XIDeviceInfo     *info)
+{
+  gdk_x11_display_error_trap_push (display);
+  props->atoms = XIListProperties (GDK_DISPLAY_XDISPLAY (display),
+                                   info->deviceid,
+                                   &props->n_atoms);
+  gdk_x11_display_error_trap_pop_ignored (display);
+  _gdk_x11_display_count_round_trip (display);
+
+  if (props->atoms == NULL)
+    props->n_atoms = 0;
+}
+
+static void
+device_properties_clear (DeviceProperties *props)
+{
+  if (props->atoms)
+    XFree (props->atoms);
+  props->atoms = NULL;
+  props->n_atoms = 0;
+}
+
+static gboolean
+device_properties_contain (const DeviceProperties *props,
+                           Atom                    atom)
+{
+  int i;
+
+  for (i = 0; i < props->n_atoms; i++)
+    {
+      if (props->atoms[i] == atom)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 static gboolean
-get_device_ids (GdkDisplay    *display,
-                XIDeviceInfo  *info,
-                char         **vendor_id,
-                char         **product_id)
+get_device_ids (GdkDisplay              *display,
+                XIDeviceInfo            *info,
+                const DeviceProperties  *props,
+                char                   **vendor_id,
+                char                   **product_id)
 {
   gulong nitems, bytes_after;
   guint32 *data;
   int rc, format;
   Atom prop, type;
 
-  gdk_x11_display_error_trap_push (display);
+  prop = gdk_x11_get_xatom_by_name_for_display (display, "Device Product ID");
 
-  prop = XInternAtom (GDK_DISPLAY_XDISPLAY (display), "Device Product ID", True);
+  if (!device_properties_contain (props, prop))
+    return FALSE;
 
-  if (prop == None)
-    {
-      gdk_x11_display_error_trap_pop_ignored (display);
-      return 0;
-    }
+  gdk_x11_display_error_trap_push (display);
 
   rc = XIGetProperty (GDK_DISPLAY_XDISPLAY (display),
                       info->deviceid, prop,
                       0, 2, False, XA_INTEGER, &type, &format, &nitems, &bytes_after,
                       (guchar **) &data);
   gdk_x11_display_error_trap_pop_ignored (display);
+  _gdk_x11_display_count_round_trip (display);
 
   if (rc != Success || type != XA_INTEGER || format != 32 || nitems != 2)
     return FALSE;
@@ -422,23 +488,30 @@ get_device_ids (GdkDisplay    *display,
 }
 
 static gboolean
-has_bool_prop (GdkDisplay   *display,
-               XIDeviceInfo *info,
-               const char   *prop_name)
+has_bool_prop (GdkDisplay             *display,
+               XIDeviceInfo           *info,
+               const DeviceProperties *props,
+               const char             *prop_name)
 {
   gulong nitems, bytes_after;
   guint32 *data;
   int rc, format;
-  Atom type;
+  Atom prop, type;
+
+  prop = gdk_x11_get_xatom_by_name_for_display (display, prop_name);
+
+  if (!device_properties_contain (props, prop))
+    return FALSE;
 
   gdk_x11_display_error_trap_push (display);
 
   rc = XIGetProperty (GDK_DISPLAY_XDISPLAY (display),
                       info->deviceid,
-                      gdk_x11_get_xatom_by_name_for_display (display, prop_name),
+                      prop,
                       0, 1, False, XA_INTEGER, &type, &format, &nitems, &bytes_after,
                       (guchar **) &data);
   gdk_x11_display_error_trap_pop_ignored (display);
+  _gdk_x11_display_count_round_trip (display);
 
   if (rc != Success || type != XA_INTEGER || format != 8 || nitems != 1)
     return FALSE;
@@ -449,8 +522,9 @@ has_bool_prop (GdkDisplay   *display,
 }
 
 static gboolean
-is_touchpad_device (GdkDisplay   *display,
-                    XIDeviceInfo *info)
+is_touchpad_device (GdkDisplay             *display,
+                    XIDeviceInfo           *info,
+                    const DeviceProperties *props)
 {
   /*
    * Touchpads are heuristically recognized via XI properties that the various
@@ -459,9 +533,9 @@ is_touchpad_device (GdkDisplay   *display,
    *   synaptics: Synaptics Off
    *   cmt:       Raw Touch Passthrough
    */
-  return has_bool_prop (display, info, "libinput Tapping Enabled") ||
-         has_bool_prop (display, info, "Synaptics Off") ||
-         has_bool_prop (display, info, "Raw Touch Passthrough");
+  return has_bool_prop (display, info, props, "libinput Tapping Enabled") ||
+         has_bool_prop (display, info, props, "Synaptics Off") ||
+         has_bool_prop (display, info, props, "Raw Touch Passthrough");
 }
 
 static GdkDevice *
@@ -475,10 +549,13 @@ create_device (GdkX11DeviceManagerXI2 *device_manager,
   GdkDevice *device;
   int num_touches = 0;
   char *vendor_id = NULL, *product_id = NULL;
+  DeviceProperties props;
+
+  device_properties_init (&props, display, dev);
 
   if (dev->use == XIMasterKeyboard || dev->use == XISlaveKeyboard)
     input_source = GDK_SOURCE_KEYBOARD;
-  else if (is_touchpad_device (display, dev))
+  else if (is_touchpad_device (display, dev, &props))
     input_source = GDK_SOURCE_TOUCHPAD;
   else if (dev->use == XISlavePointer &&
            is_touch_device (dev->classes, dev->num_classes, &touch_source, &num_touches))
@@ -541,7 +618,9 @@ create_device (GdkX11DeviceManagerXI2 *device_manager,
 
   if (dev->use != XIMasterKeyboard &&
       dev->use != XIMasterPointer)
-    get_device_ids (display, dev, &vendor_id, &product_id);
+    get_device_ids (display, dev, &props, &vendor_id, &product_id);
+
+  device_properties_clear (&props);
 
   device = g_object_new (GDK_TYPE_X11_DEVICE_XI2,
                          "name", dev->name,
@@ -745,7 +824,10 @@ gdk_x11_device_manager_xi2_constructed (GObject *object)
   logical_devices = g_hash_table_new (NULL, NULL);
   physical_devices = g_hash_table_new (NULL, NULL);
 
+  _gdk_x11_precache_atoms (display, device_property_atoms, G_N_ELEMENTS (device_property_atoms));
+
   info = XIQueryDevice (xdisplay, XIAllDevices, &ndevices);
+  _gdk_x11_display_count_round_trip (display);
 
   /* Initialize devices list */
   for (i = 0; i < ndevices; i++)
@@ -69,6 +69,14 @@
 
 #include <X11/extensions/shape.h>
 
+#ifdef HAVE_XSHM
+#include <X11/extensions/XShm.h>
+#endif
+
+#ifdef HAVE_XPRESENT
+#include <X11/extensions/Xpresent.h>
+#endif
+
 #ifdef HAVE_XCOMPOSITE
 #include <X11/extensions/Xcomposite.h>
 #endif
@@ -128,6 +136,12 @@ struct _GdkEventTypeX11
  * into the internal Xlib cache
  */
 static const char *const precache_atoms[] = {
+  "CLIPBOARD",
+  "CLIPBOARD_MANAGER",
+  "MANAGER",
+  "PRIMARY",
+  "SAVE_TARGETS",
+  "SM_CLIENT_ID",
   "UTF8_STRING",
   "WM_CLIENT_LEADER",
   "WM_DELETE_WINDOW",
@@ -142,11 +156,17 @@ static const char *const precache_atoms[] = {
   "_NET_CURRENT_DESKTOP",
   "_NET_FRAME_EXTENTS",
   "_NET_STARTUP_ID",
+  "_NET_SUPPORTED",
+  "_NET_SUPPORTING_WM_CHECK",
+  "_NET_WORKAREA",
   "_NET_WM_CM_S0",
   "_NET_WM_DESKTOP",
+  "_NET_WM_FRAME_DRAWN",
+  "_NET_WM_FRAME_TIMINGS",
   "_NET_WM_ICON",
   "_NET_WM_ICON_NAME",
   "_NET_WM_NAME",
+  "_NET_WM_OPAQUE_REGION",
   "_NET_WM_PID",
   "_NET_WM_PING",
   "_NET_WM_STATE",
@@ -174,7 +194,13 @@ static const char *const precache_atoms[] = {
   "_NET_WM_WINDOW_TYPE_UTILITY",
   "_NET_WM_USER_TIME",
   "_NET_WM_USER_TIME_WINDOW",
+  "_NET_WM_WINDOW_OPACITY",
   "_NET_VIRTUAL_ROOTS",
+  "_GTK_EDGE_CONSTRAINTS",
+  "_GTK_FRAME_EXTENTS",
+  "_GTK_WORKAREAS",
+  "_XSETTINGS_S0",
+  "_XSETTINGS_SETTINGS",
   "GDK_SELECTION",
   "_NET_WM_STATE_FOCUSED",
   "GDK_VISUALS",
@@ -1103,6 +1129,16 @@ find_frame_timings (GdkFrameClock *clock,
   return NULL;
 }
 
+/* Called wherever GDK waits for a reply, so that GDK_DEBUG=misc can
+ * tell how chatty startup is. This matters most on remote displays,
+ * where each round trip costs the full network latency.
+ */
+void
+_gdk_x11_display_count_round_trip (GdkDisplay *display)
+{
+  GDK_X11_DISPLAY (display)->n_round_trips++;
+}
+
 /* _NET_WM_FRAME_DRAWN and _NET_WM_FRAME_TIMINGS messages represent time
  * as a "high resolution server time" - this is the server time interpolated
  * to microsecond resolution. The advantage of this time representation
@@ -1112,9 +1148,9 @@ find_frame_timings (GdkFrameClock *clock,
  * a time representation with high accuracy. If there is not a common
  * time source, then the time synchronization will be less accurate.
  */
-static gint64
-server_time_to_monotonic_time (GdkX11Display *display_x11,
-                               gint64         server_time)
+gint64
+_gdk_x11_display_server_time_to_monotonic_time (GdkX11Display *display_x11,
+                                                gint64         server_time)
 {
   if (display_x11->server_time_query_time == 0 ||
       (!display_x11->server_time_is_monotonic_time &&
@@ -1175,7 +1211,7 @@ _gdk_wm_protocols_filter (const XEvent  *xevent,
           guint32 d3 = xevent->xclient.data.l[3];
 
           guint64 serial = ((guint64)d1 << 32) | d0;
-          gint64 frame_drawn_time = server_time_to_monotonic_time (GDK_X11_DISPLAY (display), ((guint64)d3 << 32) | d2);
+          gint64 frame_drawn_time = _gdk_x11_display_server_time_to_monotonic_time (GDK_X11_DISPLAY (display), ((guint64)d3 << 32) | d2);
           gint64 refresh_interval, presentation_time;
 
           GdkFrameClock *clock = gdk_surface_get_frame_clock (win);
@@ -1612,6 +1648,39 @@ gdk_x11_display_open (const char *display_name)
     display_x11->have_damage = TRUE;
 #endif
 
+#ifdef HAVE_XSHM
+  display_x11->have_shm = FALSE;
+  display_x11->have_shm_pixmaps = FALSE;
+  /* Shared memory only works if the server runs on this machine, which
+   * XShmAttach() only finds out asynchronously, so the cairo context
+   * still has to check for errors when creating its buffers. */
+  if (XShmQueryExtension (display_x11->xdisplay))
+    {
+      int major, minor;
+      Bool pixmaps;
+
+      if (XShmQueryVersion (display_x11->xdisplay, &major, &minor, &pixmaps))
+        {
+          display_x11->have_shm = TRUE;
+          display_x11->have_shm_pixmaps = pixmaps && XShmPixmapFormat (display_x11->xdisplay) == ZPixmap;
+          display_x11->shm_event_base = XShmGetEventBase (display_x11->xdisplay);
+        }
+    }
+#endif
+
+#ifdef HAVE_XPRESENT
+  display_x11->have_present = FALSE;
+  if (XPresentQueryExtension (display_x11->xdisplay,
+                              &display_x11->present_opcode,
+                              &ignore, &ignore))
+    {
+      int major = PRESENT_MAJOR, minor = PRESENT_MINOR;
+
+      if (XPresentQueryVersion (display_x11->xdisplay, &major, &minor))
+        display_x11->have_present = TRUE;
+    }
+#endif
+
   display->clipboard = gdk_x11_clipboard_new (display, "CLIPBOARD");
   display->primary_clipboard = gdk_x11_clipboard_new (display, "PRIMARY");
 
@@ -1625,8 +1694,15 @@ gdk_x11_display_open (const char *display_name)
   gdk_display_set_composited (GDK_DISPLAY (display),
                               XGetSelectionOwner (GDK_DISPLAY_XDISPLAY (display),
                                                   gdk_x11_get_xatom_by_name_for_display (display, cm_name)) != None);
+  _gdk_x11_display_count_round_trip (display);
   g_free (cm_name);
 
+  GDK_DISPLAY_NOTE (display, MISC,
+                    g_message ("Opened display %s: %lu requests, %u round trips for atoms, properties and devices",
+                               DisplayString (display_x11->xdisplay),
+                               NextRequest (display_x11->xdisplay) - 1,
+                               display_x11->n_round_trips));
+
   gdk_display_emit_opened (display);
 
   return display;
@@ -50,6 +50,9 @@ struct _GdkX11Display
 
   int grab_count;
 
+  /* Synchronous requests made by GDK, reported with GDK_DEBUG=misc */
+  guint n_round_trips;
+
   /* Visual infos for creating Windows */
   int window_depth;
   Visual *window_visual;
@@ -156,6 +159,17 @@ struct _GdkX11Display
   int damage_error_base;
   guint have_damage;
 #endif
+
+#ifdef HAVE_XSHM
+  int shm_event_base;
+  guint have_shm : 1;
+  guint have_shm_pixmaps : 1;
+#endif
+
+#ifdef HAVE_XPRESENT
+  int present_opcode;
+  guint have_present : 1;
+#endif
 };
 
 struct _GdkX11DisplayClass
@@ -345,7 +345,13 @@ gdk_event_source_prepare (GSource *source,
 
   *timeout = -1;
 
-  if (display->event_pause_count > 0)
+  if (_gdk_display_events_throttled (display, timeout))
+    {
+      /* XPending() would have flushed our requests otherwise */
+      XFlush (GDK_DISPLAY_XDISPLAY (display));
+      retval = FALSE;
+    }
+  else if (display->event_pause_count > 0)
     retval = _gdk_event_queue_find_first (display) != NULL;
   else
     retval = (_gdk_event_queue_find_first (display) != NULL ||
@@ -360,7 +366,16 @@ gdk_event_source_check (GSource *source)
   GdkEventSource *event_source = (GdkEventSource*) source;
   gboolean retval;
 
-  if (event_source->display->event_pause_count > 0)
+  if (_gdk_display_events_throttled (event_source->display, NULL))
+    {
+      /* Still read what arrived so the connection doesn't keep
+       * waking us up until the next frame.
+       */
+      if (event_source->event_poll_fd.revents & G_IO_IN)
+        XEventsQueued (GDK_DISPLAY_XDISPLAY (event_source->display), QueuedAfterReading);
+      retval = FALSE;
+    }
+  else if (event_source->display->event_pause_count > 0)
     retval = _gdk_event_queue_find_first (event_source->display) != NULL;
   else if (event_source->event_poll_fd.revents & G_IO_IN)
     retval = (_gdk_event_queue_find_first (event_source->display) != NULL ||
@@ -377,8 +392,14 @@ _gdk_x11_display_queue_events (GdkDisplay *display)
   Display *xdisplay = GDK_DISPLAY_XDISPLAY (display);
   XEvent xevent;
   gboolean unused;
-
-  while (!_gdk_event_queue_find_first (display) && XPending (xdisplay))
+  guint n_events;
+
+  /* Fetch what is pending in one pass, so that a whole batch of events
+   * gets dispatched before the frame clock runs.
+   */
+  for (n_events = 0;
+       n_events < GDK_MAX_EVENTS_PER_FRAME && XPending (xdisplay);
+       n_events++)
     {
       XNextEvent (xdisplay, &xevent);
 
@@ -415,16 +436,8 @@ gdk_event_source_dispatch (GSource     *source,
                            gpointer     user_data)
 {
   GdkDisplay *display = ((GdkEventSource*) source)->display;
-  GdkEvent *event;
-
-  event = gdk_display_get_event (display);
-
-  if (event)
-    {
-      _gdk_event_emit (event);
 
-      gdk_event_unref (event);
-    }
+  _gdk_display_dispatch_events (display);
 
   return TRUE;
 }
@@ -64,6 +64,11 @@ int           gdk_x11_display_get_window_depth           (GdkX11Display  *displa
 Visual *      gdk_x11_display_get_window_visual          (GdkX11Display  *display);
 Colormap      gdk_x11_display_get_window_colormap        (GdkX11Display  *display);
 
+void          _gdk_x11_display_count_round_trip          (GdkDisplay     *display);
+
+gint64        _gdk_x11_display_server_time_to_monotonic_time (GdkX11Display *display_x11,
+                                                              gint64         server_time);
+
 void _gdk_x11_display_add_window    (GdkDisplay *display,
                                      XID        *xid,
                                      GdkSurface  *window);
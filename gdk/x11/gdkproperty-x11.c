@@ -94,6 +94,7 @@ gdk_x11_get_xatom_by_name_for_display (GdkDisplay  *display,
   if (!xatom)
     {
       xatom = XInternAtom (GDK_DISPLAY_XDISPLAY (display), atom_name, FALSE);
+      _gdk_x11_display_count_round_trip (display);
       insert_atom_pair (display, atom_name, xatom);
     }
 
@@ -124,8 +125,11 @@ _gdk_x11_precache_atoms (GdkDisplay          *display,
     }
 
   if (n_xatoms)
-    XInternAtoms (GDK_DISPLAY_XDISPLAY (display),
-                  (char **) xatom_names, n_xatoms, False, xatoms);
+    {
+      XInternAtoms (GDK_DISPLAY_XDISPLAY (display),
+                    (char **) xatom_names, n_xatoms, False, xatoms);
+      _gdk_x11_display_count_round_trip (display);
+    }
 
   for (i = 0; i < n_xatoms; i++)
     insert_atom_pair (display, xatom_names[i], xatoms[i]);
@@ -165,7 +165,8 @@ get_current_desktop (GdkX11Screen *screen)
   display = GDK_DISPLAY_XDISPLAY (GDK_SCREEN_DISPLAY (screen));
   win = XRootWindow (display, gdk_x11_screen_get_screen_number (screen));
 
-  current_desktop = XInternAtom (display, "_NET_CURRENT_DESKTOP", True);
+  current_desktop = gdk_x11_get_xatom_by_name_for_display (GDK_SCREEN_DISPLAY (screen),
+                                                           "_NET_CURRENT_DESKTOP");
 
   XGetWindowProperty (display,
                       win,
@@ -174,6 +175,7 @@ get_current_desktop (GdkX11Screen *screen)
                       False, XA_CARDINAL,
                       &type, &format, &n_items, &bytes_after,
                       &data_return);
+  _gdk_x11_display_count_round_trip (GDK_SCREEN_DISPLAY (screen));
 
   if (type == XA_CARDINAL && format == 32 && n_items > 0)
     workspace = ((long *) data_return)[0];
@@ -211,7 +213,7 @@ _gdk_x11_screen_get_monitor_work_area (GdkX11Screen *x11_screen,
     return FALSE;
 
   xdisplay = gdk_x11_display_get_xdisplay (x11_screen->display);
-  net_workareas = XInternAtom (xdisplay, "_GTK_WORKAREAS", False);
+  net_workareas = gdk_x11_get_xatom_by_name_for_display (x11_screen->display, "_GTK_WORKAREAS");
 
   if (net_workareas == None)
     return FALSE;
@@ -219,6 +221,7 @@ _gdk_x11_screen_get_monitor_work_area (GdkX11Screen *x11_screen,
   current_desktop = get_current_desktop (x11_screen);
   workareas_dn_name = g_strdup_printf ("_GTK_WORKAREAS_D%d", current_desktop);
   workareas_dn = XInternAtom (xdisplay, workareas_dn_name, True);
+  _gdk_x11_display_count_round_trip (x11_screen->display);
   g_free (workareas_dn_name);
 
   if (workareas_dn == None)
@@ -244,6 +247,7 @@ _gdk_x11_screen_get_monitor_work_area (GdkX11Screen *x11_screen,
                                &ret_workarea);
 
   gdk_x11_display_error_trap_pop_ignored (x11_screen->display);
+  _gdk_x11_display_count_round_trip (x11_screen->display);
 
   if (result != Success ||
       type == None ||
@@ -301,7 +305,6 @@ gdk_x11_screen_get_work_area (GdkX11Screen *x11_screen,
   Display        *display;
 
   display = GDK_SCREEN_XDISPLAY (x11_screen);
-  workarea = XInternAtom (display, "_NET_WORKAREA", True);
 
   /* Defaults in case of error */
   area->x = 0;
@@ -313,8 +316,8 @@ gdk_x11_screen_get_work_area (GdkX11Screen *x11_screen,
                                             g_intern_static_string ("_NET_WORKAREA")))
     return;
 
-  if (workarea == None)
-    return;
+  /* The window manager set the hint, so the atom exists */
+  workarea = gdk_x11_get_xatom_by_name_for_display (x11_screen->display, "_NET_WORKAREA");
 
   win = XRootWindow (display, gdk_x11_screen_get_screen_number (x11_screen));
   result = XGetWindowProperty (display,
@@ -329,6 +332,7 @@ gdk_x11_screen_get_work_area (GdkX11Screen *x11_screen,
                                &num,
                                &leftovers,
                                &ret_workarea);
+  _gdk_x11_display_count_round_trip (x11_screen->display);
   if (result != Success ||
       type == None ||
       format == 0 ||
@@ -1116,6 +1120,7 @@ get_net_supporting_wm_check (GdkX11Screen *screen,
 		      0, G_MAXLONG, False, XA_WINDOW, &type, &format,
 		      &n_items, &bytes_after, &data);
   gdk_x11_display_error_trap_pop_ignored (display);
+  _gdk_x11_display_count_round_trip (display);
 
   if (type == XA_WINDOW)
     value = *(Window *)data;
@@ -1130,7 +1135,7 @@ static void
 fetch_net_wm_check_window (GdkX11Screen *x11_screen)
 {
   GdkDisplay *display;
-  Window window;
+  Window window, check;
   guint64 now;
   int error;
 
@@ -1158,15 +1163,18 @@ fetch_net_wm_check_window (GdkX11Screen *x11_screen)
   /* Find out if this WM goes away, so we can reset everything. */
   XSelectInput (x11_screen->xdisplay, window, StructureNotifyMask);
 
+  /* We check the window property again because after XGetWindowProperty()
+   * and before XSelectInput() the window may have been recycled in such a
+   * way that XSelectInput() doesn't fail but the window is no longer what
+   * we want. Doing it inside the trap also saves a round trip, as the
+   * reply brings back any error from XSelectInput().
+   */
+  check = get_net_supporting_wm_check (x11_screen, window);
+
   error = gdk_x11_display_error_trap_pop (display);
   if (!error)
     {
-      /* We check the window property again because after XGetWindowProperty()
-       * and before XSelectInput() the window may have been recycled in such a
-       * way that XSelectInput() doesn't fail but the window is no longer what
-       * we want.
-       */
-      if (window != get_net_supporting_wm_check (x11_screen, window))
+      if (window != check)
         return;
 
       x11_screen->wmspec_check_window = window;
@@ -1247,6 +1255,7 @@ gdk_x11_screen_supports_net_wm_hint (GdkX11Screen *x11_screen,
                           0, G_MAXLONG, False, XA_ATOM, &type, &format,
                           &supported_atoms->n_atoms, &bytes_after,
                           (guchar **)&supported_atoms->atoms);
+      _gdk_x11_display_count_round_trip (display);
 
       if (type != XA_ATOM)
         return FALSE;
@@ -1372,6 +1381,7 @@ get_netwm_cardinal_property (GdkX11Screen *x11_screen,
                       0, G_MAXLONG,
                       False, XA_CARDINAL, &type, &format, &nitems,
                       &bytes_after, &data);
+  _gdk_x11_display_count_round_trip (GDK_SCREEN_DISPLAY (x11_screen));
   if (type == XA_CARDINAL)
     {
       prop = *(gulong *)data;
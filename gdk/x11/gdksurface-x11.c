@@ -500,7 +500,7 @@ gdk_x11_surface_end_frame (GdkSurface *surface)
       impl->toplevel->configure_counter_value = 0;
     }
 
-  if (!impl->toplevel->frame_pending)
+  if (!impl->toplevel->frame_pending && !impl->toplevel->presentation_pending)
     timings->complete = TRUE;
 }
 
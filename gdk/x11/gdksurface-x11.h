@@ -130,6 +130,10 @@ struct _GdkToplevelX11
   /* If we're expecting a response from the compositor after painting a frame */
   guint frame_pending : 1;
 
+  /* If the cairo context presented the frame with XPresent and will
+   * complete its timings when the server reports it on screen */
+  guint presentation_pending : 1;
+
   /* Whether pending_counter_value/configure_counter_value are updates
    * to the extended update counter */
   guint pending_counter_value_is_extended : 1;
@@ -426,6 +426,7 @@ read_settings (GdkX11Screen *x11_screen,
 				   False, xsettings_atom,
 				   &type, &format, &n_items, &bytes_after, &data);
       gdk_x11_display_error_trap_pop_ignored (display);
+      _gdk_x11_display_count_round_trip (display);
       
       if (result == Success && type != None)
 	{
@@ -483,14 +484,21 @@ check_manager_window (GdkX11Screen *x11_screen,
 {
   GdkDisplay *display;
   Display *xdisplay;
+  Atom selection_atom;
 
   display = x11_screen->display;
   xdisplay = gdk_x11_display_get_xdisplay (display);
 
+  /* Don't keep the server grabbed while interning the atom */
+  selection_atom = get_selection_atom (x11_screen);
+
   gdk_x11_display_grab (display);
 
   if (!GDK_DISPLAY_DEBUG_CHECK (display, DEFAULT_SETTINGS))
-    x11_screen->xsettings_manager_window = XGetSelectionOwner (xdisplay, get_selection_atom (x11_screen));
+    {
+      x11_screen->xsettings_manager_window = XGetSelectionOwner (xdisplay, selection_atom);
+      _gdk_x11_display_count_round_trip (display);
+    }
 
   if (x11_screen->xsettings_manager_window != 0)
     XSelectInput (xdisplay,
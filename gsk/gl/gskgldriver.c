@@ -4,10 +4,13 @@
 
 #include "gskdebugprivate.h"
 #include "gskprofilerprivate.h"
+#include "gskrendernodeprivate.h"
 #include "gdk/gdkglcontextprivate.h"
 #include "gdk/gdktextureprivate.h"
 #include "gdk/gdkgltextureprivate.h"
 #include "gdkmemorytextureprivate.h"
+#include "gdk/gdktiledtextureprivate.h"
+#include "gdk/gdktelemetryprivate.h"
 
 #include <gdk/gdk.h>
 #include <epoxy/gl.h>
@@ -25,8 +28,21 @@ typedef struct {
   GLuint mag_filter;
   Fbo fbo;
   GdkTexture *user;
+  GskGLDriver *driver;  /* The render data key we are cached under in @user */
   guint in_use : 1;
   guint permanent : 1;
+  guint cached : 1;  /* Referenced from pointer_textures or tile_textures */
+  guint unused_frames : 8;
+
+  /* How a texture uploaded for a GdkTexture was drawn lately, see
+   * update_draw_size() */
+  guint mipmapped : 1;
+  guint downscale : 5;  /* The source was halved this many times */
+  guint small_frames : 8;
+  guint64 draw_frame;
+  int window_width;
+  int window_height;
+  gint64 saved_bytes;
 
   /* TODO: Make this optional and not for every texture... */
   TextureSlice *slices;
@@ -43,24 +59,215 @@ struct _GskGLDriver
     GQuark created_textures;
     GQuark reused_textures;
     GQuark surface_uploads;
+    GQuark streamed_uploads;
+    GQuark pending_uploads;
+    GQuark upload_bytes;
+    GQuark render_data_conflicts;
+    GQuark mipmapped_textures;
+    GQuark downscaled_bytes;
   } counters;
 
   Fbo default_fbo;
 
   GHashTable *textures;         /* texture_id -> Texture */
   GHashTable *pointer_textures; /* pointer -> texture_id */
+  GHashTable *tile_textures;    /* TileKey -> texture_id */
 
   const Texture *bound_source_texture;
 
   int max_texture_size;
+  guint64 frame_id;
+
+  GArray *pending_uploads; /* PendingUpload */
+  GArray *free_upload_buffers; /* GLuint */
 
   gboolean in_frame : 1;
+  gboolean has_upload_buffers : 1;
+  gboolean has_sync : 1;
+  gboolean has_mipmaps : 1;
 };
 
+/* A texture upload that was sourced from a pixel buffer object.
+ * The buffer can be reused once the GPU has signaled the fence. */
+typedef struct {
+  GLuint buffer_id;
+  GLsync fence;
+} PendingUpload;
+
+/* A tile of a GdkTiledTexture */
+typedef struct {
+  GdkTexture *texture;
+  guint level;
+  int col;
+  int row;
+} TileKey;
+
+/* How many idle pixel buffer objects we hold on to between frames */
+#define MAX_FREE_UPLOAD_BUFFERS 4
+
+/* How many frames a texture cached for a render node is kept
+ * around without being used, e.g. while the node is hidden.
+ */
+#define MAX_CACHED_UNUSED_FRAMES 60
+
+/* How many frames in a row a texture has to be drawn at less than
+ * half its size before its storage is replaced by a smaller mip level.
+ */
+#define DOWNSCALE_FRAMES 30
+
 G_DEFINE_TYPE (GskGLDriver, gsk_gl_driver, G_TYPE_OBJECT)
 
+static GLuint
+get_upload_buffer (GskGLDriver *self)
+{
+  GLuint buffer_id;
+
+  if (self->free_upload_buffers->len > 0)
+    {
+      buffer_id = g_array_index (self->free_upload_buffers, GLuint, self->free_upload_buffers->len - 1);
+      g_array_set_size (self->free_upload_buffers, self->free_upload_buffers->len - 1);
+      return buffer_id;
+    }
+
+  glGenBuffers (1, &buffer_id);
+
+  return buffer_id;
+}
+
+/* Move the buffers of uploads that have finished on the GPU back to
+ * the free list. With @wait, block until all of them are done. */
+static void
+collect_pending_uploads (GskGLDriver *self,
+                         gboolean     wait)
+{
+  guint i;
+
+  if (self->pending_uploads == NULL)
+    return;
+
+  for (i = 0; i < self->pending_uploads->len; )
+    {
+      PendingUpload *upload = &g_array_index (self->pending_uploads, PendingUpload, i);
+      GLenum status;
+
+      status = glClientWaitSync (upload->fence, 0, wait ? G_MAXUINT64 : 0);
+
+      if (status == GL_ALREADY_SIGNALED ||
+          status == GL_CONDITION_SATISFIED ||
+          status == GL_WAIT_FAILED)
+        {
+          glDeleteSync (upload->fence);
+
+          if (self->free_upload_buffers->len < MAX_FREE_UPLOAD_BUFFERS)
+            g_array_append_val (self->free_upload_buffers, upload->buffer_id);
+          else
+            glDeleteBuffers (1, &upload->buffer_id);
+
+          g_array_remove_index_fast (self->pending_uploads, i);
+        }
+      else
+        i++;
+    }
+}
+
+/* Streams the texture data through a pixel buffer object. The data is
+ * converted straight into the mapped buffer and the actual transfer into
+ * the texture happens asynchronously, so we don't block on the GPU
+ * consuming client memory.
+ *
+ * Returns: %FALSE if the data has to be uploaded the slow way
+ */
+static gboolean
+stream_memory_texture (GskGLDriver     *self,
+                       const guchar    *data,
+                       gsize            data_stride,
+                       GdkMemoryFormat  data_format,
+                       int              target,
+                       int              width,
+                       int              height)
+{
+  GdkMemoryFormat upload_format;
+  PendingUpload upload;
+  gsize upload_stride;
+  gsize bpp;
+  guchar *dest;
+
+  if (!self->has_upload_buffers)
+    return FALSE;
+
+  /* Deep data is uploaded straight from client memory, not worth
+   * staging several times the size of an 8 bit copy */
+  if (gdk_memory_format_is_deep (data_format))
+    return FALSE;
+
+  /* Pick the format gdk_gl_context_upload_texture() takes without conversion */
+  if (gdk_gl_context_get_use_es (self->gl_context))
+    upload_format = GDK_MEMORY_R8G8B8A8_PREMULTIPLIED;
+  else if (data_format == GDK_MEMORY_R8G8B8)
+    upload_format = GDK_MEMORY_R8G8B8;
+  else
+    upload_format = GDK_MEMORY_DEFAULT;
+
+  bpp = gdk_memory_format_bytes_per_pixel (upload_format);
+  upload_stride = width * bpp;
+
+  upload.buffer_id = get_upload_buffer (self);
+  glBindBuffer (GL_PIXEL_UNPACK_BUFFER, upload.buffer_id);
+  /* Orphan the previous storage so we never wait for the GPU here */
+  glBufferData (GL_PIXEL_UNPACK_BUFFER, upload_stride * height, NULL, GL_STREAM_DRAW);
+
+  dest = glMapBufferRange (GL_PIXEL_UNPACK_BUFFER, 0, upload_stride * height,
+                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (dest == NULL)
+    {
+      glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers (1, &upload.buffer_id);
+      return FALSE;
+    }
+
+  if (upload_format == data_format && upload_format == GDK_MEMORY_R8G8B8)
+    {
+      int y;
+
+      for (y = 0; y < height; y++)
+        memcpy (dest + y * upload_stride, data + y * data_stride, upload_stride);
+    }
+  else
+    {
+      gdk_memory_convert (dest, upload_stride, upload_format,
+                          data, data_stride, data_format,
+                          width, height);
+    }
+
+  if (!glUnmapBuffer (GL_PIXEL_UNPACK_BUFFER))
+    {
+      /* The buffer contents got lost, e.g. on a mode switch */
+      glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+      glDeleteBuffers (1, &upload.buffer_id);
+      return FALSE;
+    }
+
+  /* With a bound unpack buffer, the data pointer is an offset into it */
+  gdk_gl_context_upload_texture (self->gl_context,
+                                 NULL,
+                                 width, height, upload_stride,
+                                 upload_format, target);
+
+  glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+
+  upload.fence = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  g_array_append_val (self->pending_uploads, upload);
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (self->profiler, self->counters.streamed_uploads);
+#endif
+
+  return TRUE;
+}
+
 static void
-upload_gdk_texture (GdkTexture      *source_texture,
+upload_gdk_texture (GskGLDriver     *self,
+                    GdkTexture      *source_texture,
                     int              target,
                     int              x_offset,
                     int              y_offset,
@@ -72,6 +279,7 @@ upload_gdk_texture (GdkTexture      *source_texture,
   const guchar *data;
   gsize data_stride;
   gsize bpp;
+  gint64 upload_start;
 
   g_return_if_fail (source_texture != NULL);
   g_return_if_fail (x_offset + width <= gdk_texture_get_width (source_texture));
@@ -79,6 +287,18 @@ upload_gdk_texture (GdkTexture      *source_texture,
 
   /* Note: GdkGLTextures are already handled before we reach this and reused as-is */
 
+  /* Let the texture sample straight from the dmabuf if the backend can import it */
+  if (GDK_IS_DMABUF_TEXTURE (source_texture) &&
+      x_offset == 0 && y_offset == 0 &&
+      width == gdk_texture_get_width (source_texture) &&
+      height == gdk_texture_get_height (source_texture) &&
+      gdk_gl_context_import_dmabuf (self->gl_context,
+                                    GDK_DMABUF_TEXTURE (source_texture),
+                                    target))
+    return;
+
+  upload_start = g_get_monotonic_time ();
+
   if (GDK_IS_MEMORY_TEXTURE (source_texture))
     {
       GdkMemoryTexture *memory_texture = GDK_MEMORY_TEXTURE (source_texture);
@@ -98,10 +318,21 @@ upload_gdk_texture (GdkTexture      *source_texture,
 
   bpp = gdk_memory_format_bytes_per_pixel (data_format);
 
-  gdk_gl_context_upload_texture (gdk_gl_context_get_current (),
-                                 data + x_offset * bpp + y_offset * data_stride,
-                                 width, height, data_stride,
-                                 data_format, target);
+  if (!stream_memory_texture (self,
+                              data + x_offset * bpp + y_offset * data_stride,
+                              data_stride, data_format,
+                              target, width, height))
+    gdk_gl_context_upload_texture (gdk_gl_context_get_current (),
+                                   data + x_offset * bpp + y_offset * data_stride,
+                                   width, height, data_stride,
+                                   data_format, target);
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_add (self->profiler, self->counters.upload_bytes,
+                            (gint64) width * height * bpp);
+#endif
+
+  gdk_telemetry_end (GDK_TELEMETRY_TEXTURE_UPLOAD, upload_start, (gint64) width * height * bpp);
 
   if (surface)
     cairo_surface_destroy (surface);
@@ -129,7 +360,12 @@ texture_free (gpointer data)
   guint i;
 
   if (t->user)
-    gdk_texture_clear_render_data (t->user);
+    gdk_texture_clear_render_data (t->user, t->driver);
+
+#ifdef G_ENABLE_DEBUG
+  if (t->saved_bytes != 0)
+    gsk_profiler_counter_add (t->driver->profiler, t->driver->counters.downscaled_bytes, - t->saved_bytes);
+#endif
 
   if (t->fbo.fbo_id != 0)
     fbo_clear (&t->fbo);
@@ -161,6 +397,18 @@ gsk_gl_driver_set_texture_parameters (GskGLDriver *self,
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
+static void
+gsk_gl_driver_dispose (GObject *gobject)
+{
+  GskGLDriver *self = GSK_GL_DRIVER (gobject);
+
+  /* Textures we cached data for drop it when our weak references
+   * are notified, which may delete GL objects. */
+  gdk_gl_context_make_current (self->gl_context);
+
+  G_OBJECT_CLASS (gsk_gl_driver_parent_class)->dispose (gobject);
+}
+
 static void
 gsk_gl_driver_finalize (GObject *gobject)
 {
@@ -168,8 +416,17 @@ gsk_gl_driver_finalize (GObject *gobject)
 
   gdk_gl_context_make_current (self->gl_context);
 
+  if (self->pending_uploads)
+    {
+      collect_pending_uploads (self, TRUE);
+      glDeleteBuffers (self->free_upload_buffers->len, (GLuint *) self->free_upload_buffers->data);
+      g_array_unref (self->pending_uploads);
+      g_array_unref (self->free_upload_buffers);
+    }
+
   g_clear_pointer (&self->textures, g_hash_table_unref);
   g_clear_pointer (&self->pointer_textures, g_hash_table_unref);
+  g_clear_pointer (&self->tile_textures, g_hash_table_unref);
   g_clear_object (&self->profiler);
 
   if (self->gl_context == gdk_gl_context_get_current ())
@@ -183,6 +440,7 @@ gsk_gl_driver_class_init (GskGLDriverClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
+  gobject_class->dispose = gsk_gl_driver_dispose;
   gobject_class->finalize = gsk_gl_driver_finalize;
 }
 
@@ -207,6 +465,30 @@ gsk_gl_driver_init (GskGLDriver *self)
                                                              "surface_uploads",
                                                              "Texture uploads from surfaces this frame",
                                                              TRUE);
+  self->counters.streamed_uploads = gsk_profiler_add_counter (self->profiler,
+                                                              "streamed_uploads",
+                                                              "Texture uploads through pixel buffers this frame",
+                                                              TRUE);
+  self->counters.pending_uploads = gsk_profiler_add_counter (self->profiler,
+                                                             "pending_uploads",
+                                                             "Texture uploads not finished on the GPU",
+                                                             FALSE);
+  self->counters.upload_bytes = gsk_profiler_add_counter (self->profiler,
+                                                          "upload_bytes",
+                                                          "Bytes of texture data uploaded this frame",
+                                                          TRUE);
+  self->counters.render_data_conflicts = gsk_profiler_add_counter (self->profiler,
+                                                                   "render_data_conflicts",
+                                                                   "Textures not cached because other renderers use all render data slots",
+                                                                   TRUE);
+  self->counters.mipmapped_textures = gsk_profiler_add_counter (self->profiler,
+                                                                "mipmapped_textures",
+                                                                "Textures that got mipmaps this frame because they are drawn minified",
+                                                                TRUE);
+  self->counters.downscaled_bytes = gsk_profiler_add_counter (self->profiler,
+                                                              "downscaled_bytes",
+                                                              "Texture memory saved by keeping smaller mip levels only",
+                                                              FALSE);
 #endif
 }
 
@@ -229,13 +511,37 @@ gsk_gl_driver_begin_frame (GskGLDriver *self)
   g_return_if_fail (!self->in_frame);
 
   self->in_frame = TRUE;
+  self->frame_id++;
 
   if (self->max_texture_size < 0)
     {
+      int maj, min;
+
       glGetIntegerv (GL_MAX_TEXTURE_SIZE, (GLint *) &self->max_texture_size);
       GSK_NOTE (OPENGL, g_message ("GL max texture size: %d", self->max_texture_size));
+
+      /* Pixel buffers need GL 2.1 or GLES 3, fences and mapping ranges GL 3.2 */
+      gdk_gl_context_get_version (self->gl_context, &maj, &min);
+      if (gdk_gl_context_get_use_es (self->gl_context))
+        self->has_sync = maj >= 3;
+      else
+        self->has_sync = maj > 3 || (maj == 3 && min >= 2);
+      self->has_upload_buffers = self->has_sync;
+
+      /* Rendering into mip levels other than the base needs GLES 3 */
+      self->has_mipmaps = !gdk_gl_context_get_use_es (self->gl_context) || maj >= 3;
+
+      if (self->has_upload_buffers)
+        {
+          self->pending_uploads = g_array_new (FALSE, FALSE, sizeof (PendingUpload));
+          self->free_upload_buffers = g_array_new (FALSE, FALSE, sizeof (GLuint));
+        }
+
+      GSK_NOTE (OPENGL, g_message ("Streaming texture uploads: %s", self->has_upload_buffers ? "yes" : "no"));
     }
 
+  collect_pending_uploads (self, FALSE);
+
   glBindFramebuffer (GL_FRAMEBUFFER, 0);
 
   glActiveTexture (GL_TEXTURE0);
@@ -254,6 +560,26 @@ gsk_gl_driver_begin_frame (GskGLDriver *self)
 #endif
 }
 
+/* Texture uploads done in the current (or last) frame; only
+ * tracked when debugging is enabled
+ */
+void
+gsk_gl_driver_get_upload_stats (GskGLDriver *self,
+                                gint64      *n_uploads,
+                                gint64      *n_bytes)
+{
+  g_return_if_fail (GSK_IS_GL_DRIVER (self));
+
+#ifdef G_ENABLE_DEBUG
+  *n_uploads = gsk_profiler_counter_get (self->profiler, self->counters.surface_uploads) +
+               gsk_profiler_counter_get (self->profiler, self->counters.streamed_uploads);
+  *n_bytes = gsk_profiler_counter_get (self->profiler, self->counters.upload_bytes);
+#else
+  *n_uploads = 0;
+  *n_bytes = 0;
+#endif
+}
+
 gboolean
 gsk_gl_driver_in_frame (GskGLDriver *self)
 {
@@ -271,13 +597,22 @@ gsk_gl_driver_end_frame (GskGLDriver *self)
   self->default_fbo.fbo_id = 0;
 
 #ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_set (self->profiler, self->counters.pending_uploads,
+                            self->pending_uploads ? self->pending_uploads->len : 0);
+
   GSK_NOTE (OPENGL,
             g_message ("Textures created: %" G_GINT64_FORMAT "\n"
                      " Textures reused: %" G_GINT64_FORMAT "\n"
-                     " Surface uploads: %" G_GINT64_FORMAT,
+                     " Surface uploads: %" G_GINT64_FORMAT "\n"
+                     " Streamed uploads: %" G_GINT64_FORMAT "\n"
+                     " Pending uploads: %" G_GINT64_FORMAT,
                      gsk_profiler_counter_get (self->profiler, self->counters.created_textures),
                      gsk_profiler_counter_get (self->profiler, self->counters.reused_textures),
-                     gsk_profiler_counter_get (self->profiler, self->counters.surface_uploads)));
+                     gsk_profiler_counter_get (self->profiler, self->counters.surface_uploads),
+                     gsk_profiler_counter_get (self->profiler, self->counters.streamed_uploads),
+                     gsk_profiler_counter_get (self->profiler, self->counters.pending_uploads)));
+
+  gsk_profiler_push_samples (self->profiler);
 #endif
 
   GSK_NOTE (OPENGL,
@@ -287,11 +622,41 @@ gsk_gl_driver_end_frame (GskGLDriver *self)
   self->in_frame = FALSE;
 }
 
+static void
+remove_pointer_texture (GskGLDriver *self,
+                        int          texture_id)
+{
+  GHashTableIter pointer_iter;
+  gpointer value;
+
+  if (self->pointer_textures != NULL)
+    {
+      /* TODO: Is there a better way for this? */
+      g_hash_table_iter_init (&pointer_iter, self->pointer_textures);
+      while (g_hash_table_iter_next (&pointer_iter, NULL, &value))
+        {
+          if (GPOINTER_TO_INT (value) == texture_id)
+            g_hash_table_iter_remove (&pointer_iter);
+        }
+    }
+
+  if (self->tile_textures != NULL)
+    {
+      g_hash_table_iter_init (&pointer_iter, self->tile_textures);
+      while (g_hash_table_iter_next (&pointer_iter, NULL, &value))
+        {
+          if (GPOINTER_TO_INT (value) == texture_id)
+            g_hash_table_iter_remove (&pointer_iter);
+        }
+    }
+}
+
 int
 gsk_gl_driver_collect_textures (GskGLDriver *self)
 {
   GHashTableIter iter;
   gpointer value_p = NULL;
+  gpointer key_p = NULL;
   int old_size;
 
   g_return_val_if_fail (GSK_IS_GL_DRIVER (self), 0);
@@ -299,6 +664,53 @@ gsk_gl_driver_collect_textures (GskGLDriver *self)
 
   old_size = g_hash_table_size (self->textures);
 
+  /* The cache keeps a reference on the render nodes. If that is the only
+   * one left, nobody can ever draw the node again, so its textures can go. */
+  if (self->pointer_textures)
+    {
+      g_hash_table_iter_init (&iter, self->pointer_textures);
+      while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+        {
+          const GskTextureKey *key = key_p;
+          Texture *t;
+
+          if (!g_atomic_ref_count_compare (&((GskRenderNode *) key->pointer)->ref_count, 1))
+            continue;
+
+          t = g_hash_table_lookup (self->textures, value_p);
+          if (t != NULL)
+            {
+              t->cached = FALSE;
+              t->unused_frames = MAX_CACHED_UNUSED_FRAMES;
+            }
+
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+
+  /* Same for the tiles of textures nobody else holds on to */
+  if (self->tile_textures)
+    {
+      g_hash_table_iter_init (&iter, self->tile_textures);
+      while (g_hash_table_iter_next (&iter, &key_p, &value_p))
+        {
+          const TileKey *key = key_p;
+          Texture *t;
+
+          if (G_OBJECT (key->texture)->ref_count != 1)
+            continue;
+
+          t = g_hash_table_lookup (self->textures, value_p);
+          if (t != NULL)
+            {
+              t->cached = FALSE;
+              t->unused_frames = MAX_CACHED_UNUSED_FRAMES;
+            }
+
+          g_hash_table_iter_remove (&iter);
+        }
+    }
+
   g_hash_table_iter_init (&iter, self->textures);
   while (g_hash_table_iter_next (&iter, NULL, &value_p))
     {
@@ -310,6 +722,7 @@ gsk_gl_driver_collect_textures (GskGLDriver *self)
       if (t->in_use)
         {
           t->in_use = FALSE;
+          t->unused_frames = 0;
 
           if (t->fbo.fbo_id != 0)
             {
@@ -317,26 +730,14 @@ gsk_gl_driver_collect_textures (GskGLDriver *self)
               t->fbo.fbo_id = 0;
             }
         }
+      else if (t->cached && t->unused_frames < MAX_CACHED_UNUSED_FRAMES)
+        {
+          t->unused_frames++;
+        }
       else
         {
-          /* Remove from self->pointer_textures. */
-          /* TODO: Is there a better way for this? */
-          if (self->pointer_textures)
-            {
-              GHashTableIter pointer_iter;
-              gpointer value;
-              gpointer p;
-
-              g_hash_table_iter_init (&pointer_iter, self->pointer_textures);
-              while (g_hash_table_iter_next (&pointer_iter, &p, &value))
-                {
-                  if (GPOINTER_TO_INT (value) == t->texture_id)
-                    {
-                      g_hash_table_iter_remove (&pointer_iter);
-                      break;
-                    }
-                }
-            }
+          if (t->cached)
+            remove_pointer_texture (self, t->texture_id);
 
           g_hash_table_iter_remove (&iter);
         }
@@ -474,7 +875,7 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
 #endif
           glBindTexture (GL_TEXTURE_2D, texture_id);
           gsk_gl_driver_set_texture_parameters (self, GL_NEAREST, GL_NEAREST);
-          upload_gdk_texture (texture, GL_TEXTURE_2D, x, y, slice_width, slice_height);
+          upload_gdk_texture (self, texture, GL_TEXTURE_2D, x, y, slice_width, slice_height);
 
 #ifdef G_ENABLE_DEBUG
           gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
@@ -502,17 +903,188 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
 
   /* Use texture_free as destroy notify here since we are not inserting this Texture
    * into self->textures! */
-  gdk_texture_set_render_data (texture, self, tex, texture_free);
+  if (!gdk_texture_set_render_data (texture, self, tex, texture_free))
+    {
+      /* All render data slots are taken by other renderers, so let the
+       * slices be collected like any other unused texture. */
+      g_hash_table_insert (self->textures, GINT_TO_POINTER (slices[0].texture_id), tex);
+#ifdef G_ENABLE_DEBUG
+      gsk_profiler_counter_inc (self->profiler, self->counters.render_data_conflicts);
+#endif
+    }
 
   *out_slices = slices;
   *out_n_slices = cols * rows;
 }
 
+static GdkGLContext *
+get_share_group (GdkGLContext *context)
+{
+  GdkGLContext *shared;
+
+  while ((shared = gdk_gl_context_get_shared_context (context)) != NULL)
+    context = shared;
+
+  return context;
+}
+
+static gboolean
+texture_is_deep (GdkTexture *texture)
+{
+  return GDK_IS_MEMORY_TEXTURE (texture) &&
+         gdk_memory_format_is_deep (gdk_memory_texture_get_format (GDK_MEMORY_TEXTURE (texture)));
+}
+
+/* Replaces @t with a texture holding only mip @level of @texture
+ * and the levels below it. The copy stays on the GPU.
+ */
+static Texture *
+downscale_texture (GskGLDriver *self,
+                   Texture     *t,
+                   GdkTexture  *texture,
+                   guint        level)
+{
+  Texture *scaled;
+  GLuint fbo_id;
+
+  g_assert (t->mipmapped);
+  g_assert (level > t->downscale);
+
+  scaled = create_texture (self,
+                           MAX (gdk_texture_get_width (texture) >> level, 1),
+                           MAX (gdk_texture_get_height (texture) >> level, 1));
+
+  glGenFramebuffers (1, &fbo_id);
+  glBindFramebuffer (GL_FRAMEBUFFER, fbo_id);
+  glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                          t->texture_id, level - t->downscale);
+
+  gsk_gl_driver_bind_source_texture (self, scaled->texture_id);
+  gsk_gl_driver_set_texture_parameters (self, GL_LINEAR_MIPMAP_LINEAR, t->mag_filter);
+  glCopyTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, 0, 0, scaled->width, scaled->height, 0);
+  glGenerateMipmap (GL_TEXTURE_2D);
+
+  glBindFramebuffer (GL_FRAMEBUFFER, self->default_fbo.fbo_id);
+  glDeleteFramebuffers (1, &fbo_id);
+
+  gdk_gl_context_label_object_printf (self->gl_context, GL_TEXTURE, scaled->texture_id,
+                                      "GdkTexture<%p> %d, level %u", texture, scaled->texture_id, level);
+
+  scaled->min_filter = t->min_filter;
+  scaled->mag_filter = t->mag_filter;
+  scaled->mipmapped = TRUE;
+  scaled->downscale = level;
+  scaled->draw_frame = t->draw_frame;
+
+  /* We own the render data slot already, so this can't fail. It
+   * releases @t, which gets collected once this frame is done. */
+  gdk_texture_set_render_data (texture, self, scaled, gsk_gl_driver_release_texture);
+  scaled->user = texture;
+  scaled->driver = self;
+
+  /* Counting 8 bit RGBA, deep textures are never downscaled */
+  scaled->saved_bytes = 4 * ((gint64) gdk_texture_get_width (texture) * gdk_texture_get_height (texture) -
+                             (gint64) scaled->width * scaled->height);
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_add (self->profiler, self->counters.downscaled_bytes, scaled->saved_bytes);
+#endif
+
+  return scaled;
+}
+
+/* Textures drawn at less than half their size alias badly when
+ * sampled with linear filtering, so they get mipmaps. If that goes
+ * on for DOWNSCALE_FRAMES frames, the storage is replaced by the
+ * smallest mip level that was still large enough for all of them.
+ *
+ * Returns: the texture to draw with
+ */
+static Texture *
+update_draw_size (GskGLDriver *self,
+                  Texture     *t,
+                  GdkTexture  *texture,
+                  int          draw_width,
+                  int          draw_height)
+{
+  const int width = gdk_texture_get_width (texture);
+  const int height = gdk_texture_get_height (texture);
+  guint level;
+
+  if (!self->has_mipmaps ||
+      t->user != texture ||
+      t->min_filter != GL_LINEAR)
+    return t;
+
+  if (t->draw_frame != self->frame_id)
+    {
+      t->draw_frame = self->frame_id;
+      if (t->small_frames < G_MAXUINT8)
+        t->small_frames++;
+    }
+
+  if (draw_width * 2 > width || draw_height * 2 > height)
+    {
+      t->small_frames = 0;
+      t->window_width = 0;
+      t->window_height = 0;
+      return t;
+    }
+
+  t->window_width = MAX (t->window_width, MAX (draw_width, 1));
+  t->window_height = MAX (t->window_height, MAX (draw_height, 1));
+
+  if (!t->mipmapped)
+    {
+      gsk_gl_driver_bind_source_texture (self, t->texture_id);
+      glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glGenerateMipmap (GL_TEXTURE_2D);
+      t->mipmapped = TRUE;
+#ifdef G_ENABLE_DEBUG
+      gsk_profiler_counter_inc (self->profiler, self->counters.mipmapped_textures);
+#endif
+    }
+
+  /* Copying deep data into 8 bit storage would lose precision */
+  if (t->small_frames < DOWNSCALE_FRAMES || texture_is_deep (texture))
+    return t;
+
+  level = 0;
+  while (level < 16 &&
+         (width >> (level + 1)) >= t->window_width &&
+         (height >> (level + 1)) >= t->window_height)
+    level++;
+
+  if (level <= t->downscale)
+    return t;
+
+  return downscale_texture (self, t, texture, level);
+}
+
+/**
+ * gsk_gl_driver_get_texture_for_texture:
+ * @self: a #GskGLDriver
+ * @texture: the #GdkTexture to draw
+ * @min_filter: the minification filter
+ * @mag_filter: the magnification filter
+ * @draw_width: the width the texture is drawn at, in device pixels
+ * @draw_height: the height the texture is drawn at, in device pixels
+ *
+ * Gets a texture id for @texture, uploading it if necessary.
+ *
+ * With linear filtering, the draw size decides whether the texture
+ * gets mipmaps and how much of the texture is kept in GPU memory.
+ * Textures that were downscaled get uploaded again when they are
+ * drawn larger.
+ *
+ * Returns: the texture id
+ */
 int
 gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
                                        GdkTexture  *texture,
                                        int          min_filter,
-                                       int          mag_filter)
+                                       int          mag_filter,
+                                       int          draw_width,
+                                       int          draw_height)
 {
   Texture *t;
   GdkTexture *downloaded_texture = NULL;
@@ -521,12 +1093,22 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
   if (GDK_IS_GL_TEXTURE (texture))
     {
       GdkGLContext *texture_context = gdk_gl_texture_get_context ((GdkGLTexture *)texture);
-      GdkGLContext *shared_context = gdk_gl_context_get_shared_context (self->gl_context);
 
-      if (texture_context == self->gl_context ||
-          (gdk_gl_context_get_shared_context (texture_context) == shared_context && shared_context != NULL))
+      /* Contexts that share data with each other, directly or through
+       * a common shared context, can use each other's textures.
+       */
+      if (texture_context != NULL &&
+          get_share_group (texture_context) == get_share_group (self->gl_context))
         {
-          /* A GL texture from the same GL context is a simple task... */
+          gpointer sync = gdk_gl_texture_get_sync ((GdkGLTexture *)texture);
+
+          /* The producer may still be rendering into the texture on
+           * the GPU. Make our commands wait for it there, instead of
+           * blocking the CPU.
+           */
+          if (sync != NULL && self->has_sync)
+            glWaitSync (sync, 0, GL_TIMEOUT_IGNORED);
+
           return gdk_gl_texture_get_id ((GdkGLTexture *)texture);
         }
       else
@@ -551,10 +1133,13 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
     {
       t = gdk_texture_get_render_data (texture, self);
 
-      if (t)
+      if (t &&
+          t->min_filter == min_filter &&
+          t->mag_filter == mag_filter &&
+          (t->downscale == 0 || (draw_width <= t->width && draw_height <= t->height)))
         {
-          if (t->min_filter == min_filter && t->mag_filter == mag_filter)
-            return t->texture_id;
+          t = update_draw_size (self, t, texture, draw_width, draw_height);
+          return t->texture_id;
         }
 
       source_texture = texture;
@@ -563,7 +1148,14 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
   t = create_texture (self, gdk_texture_get_width (texture), gdk_texture_get_height (texture));
 
   if (gdk_texture_set_render_data (texture, self, t, gsk_gl_driver_release_texture))
-    t->user = texture;
+    {
+      t->user = texture;
+      t->driver = self;
+    }
+#ifdef G_ENABLE_DEBUG
+  else
+    gsk_profiler_counter_inc (self->profiler, self->counters.render_data_conflicts);
+#endif
 
   gsk_gl_driver_bind_source_texture (self, t->texture_id);
   gsk_gl_driver_init_texture (self,
@@ -577,9 +1169,20 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
   if (downloaded_texture)
     g_object_unref (downloaded_texture);
 
+  t = update_draw_size (self, t, texture, draw_width, draw_height);
+
   return t->texture_id;
 }
 
+static void
+texture_key_free (gpointer data)
+{
+  GskTextureKey *k = data;
+
+  gsk_render_node_unref (k->pointer);
+  g_free (k);
+}
+
 static guint
 texture_key_hash (gconstpointer v)
 {
@@ -611,7 +1214,7 @@ gsk_gl_driver_get_texture_for_key (GskGLDriver   *self,
   int id = 0;
 
   if (G_UNLIKELY (self->pointer_textures == NULL))
-    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal, g_free, NULL);
+    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal, texture_key_free, NULL);
 
   id = GPOINTER_TO_INT (g_hash_table_lookup (self->pointer_textures, key));
 
@@ -621,8 +1224,13 @@ gsk_gl_driver_get_texture_for_key (GskGLDriver   *self,
 
       t = g_hash_table_lookup (self->textures, GINT_TO_POINTER (id));
 
-      if (t != NULL)
-        t->in_use = TRUE;
+      if (t == NULL)
+        {
+          g_hash_table_remove (self->pointer_textures, key);
+          return 0;
+        }
+
+      t->in_use = TRUE;
     }
 
   return id;
@@ -634,16 +1242,148 @@ gsk_gl_driver_set_texture_for_key (GskGLDriver   *self,
                                    int            texture_id)
 {
   GskTextureKey *k;
+  Texture *t;
 
   if (G_UNLIKELY (self->pointer_textures == NULL))
-    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal, g_free, NULL);
+    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal, texture_key_free, NULL);
 
+  t = gsk_gl_driver_get_texture (self, texture_id);
+  if (t != NULL)
+    t->cached = TRUE;
+
+  /* Holding a reference makes sure the pointer can't be reused
+   * by a different node while the texture is cached. */
   k = g_new (GskTextureKey, 1);
   *k = *key;
+  k->pointer = gsk_render_node_ref (key->pointer);
 
   g_hash_table_insert (self->pointer_textures, k, GINT_TO_POINTER (texture_id));
 }
 
+static guint
+tile_key_hash (gconstpointer v)
+{
+  const TileKey *k = v;
+
+  return GPOINTER_TO_UINT (k->texture) ^ (k->level << 24) ^ (k->row << 12) ^ k->col;
+}
+
+static gboolean
+tile_key_equal (gconstpointer v1,
+                gconstpointer v2)
+{
+  const TileKey *k1 = v1;
+  const TileKey *k2 = v2;
+
+  return k1->texture == k2->texture &&
+         k1->level == k2->level &&
+         k1->col == k2->col &&
+         k1->row == k2->row;
+}
+
+static void
+tile_key_free (gpointer data)
+{
+  TileKey *k = data;
+
+  g_object_unref (k->texture);
+  g_slice_free (TileKey, k);
+}
+
+/**
+ * gsk_gl_driver_get_tiles:
+ * @self: a #GskGLDriver
+ * @texture: a #GdkTiledTexture
+ * @level: the mip level to use
+ * @tiles: the columns and rows of the tiles
+ * @out_texture_ids: (out caller-allocates): return location for the
+ *   texture ids, row by row. Tiles that could not be loaded are 0.
+ *
+ * Gets textures for the given tiles, uploading the ones that are not
+ * cached yet. The tiles stay cached for a few frames after they were
+ * last used, so memory use follows what is actually being drawn.
+ */
+void
+gsk_gl_driver_get_tiles (GskGLDriver        *self,
+                         GdkTexture         *texture,
+                         guint               level,
+                         const GdkRectangle *tiles,
+                         int                *out_texture_ids)
+{
+  int min_col = G_MAXINT, min_row = G_MAXINT;
+  int max_col = -1, max_row = -1;
+  int col, row, i;
+
+  if (G_UNLIKELY (self->tile_textures == NULL))
+    self->tile_textures = g_hash_table_new_full (tile_key_hash, tile_key_equal, tile_key_free, NULL);
+
+  i = 0;
+  for (row = tiles->y; row < tiles->y + tiles->height; row++)
+    for (col = tiles->x; col < tiles->x + tiles->width; col++, i++)
+      {
+        TileKey key = { texture, level, col, row };
+        Texture *t;
+
+        out_texture_ids[i] = GPOINTER_TO_INT (g_hash_table_lookup (self->tile_textures, &key));
+        t = gsk_gl_driver_get_texture (self, out_texture_ids[i]);
+        if (t != NULL)
+          {
+            t->in_use = TRUE;
+            continue;
+          }
+
+        out_texture_ids[i] = 0;
+        min_col = MIN (min_col, col);
+        min_row = MIN (min_row, row);
+        max_col = MAX (max_col, col);
+        max_row = MAX (max_row, row);
+      }
+
+  if (max_col < 0)
+    return;
+
+  /* Decode everything we need at once */
+  gdk_tiled_texture_ensure_tiles (GDK_TILED_TEXTURE (texture), level,
+                                  &(GdkRectangle) {
+                                    min_col, min_row,
+                                    max_col - min_col + 1, max_row - min_row + 1
+                                  });
+
+  i = 0;
+  for (row = tiles->y; row < tiles->y + tiles->height; row++)
+    for (col = tiles->x; col < tiles->x + tiles->width; col++, i++)
+      {
+        GdkTexture *tile;
+        TileKey *key;
+        Texture *t;
+
+        if (out_texture_ids[i] != 0)
+          continue;
+
+        tile = gdk_tiled_texture_ref_tile (GDK_TILED_TEXTURE (texture), level, col, row);
+        if (tile == NULL)
+          continue;
+
+        t = create_texture (self, tile->width, tile->height);
+        gsk_gl_driver_bind_source_texture (self, t->texture_id);
+        gsk_gl_driver_init_texture (self, t->texture_id, tile, GL_LINEAR, GL_LINEAR);
+        gdk_gl_context_label_object_printf (self->gl_context, GL_TEXTURE, t->texture_id,
+                                            "Tile %d,%d level %u of GdkTexture<%p> %d",
+                                            col, row, level, texture, t->texture_id);
+        t->cached = TRUE;
+
+        key = g_slice_new (TileKey);
+        key->texture = g_object_ref (texture);
+        key->level = level;
+        key->col = col;
+        key->row = row;
+        g_hash_table_insert (self->tile_textures, key, GINT_TO_POINTER (t->texture_id));
+
+        out_texture_ids[i] = t->texture_id;
+        g_object_unref (tile);
+      }
+}
+
 int
 gsk_gl_driver_create_texture (GskGLDriver *self,
                               float        width,
@@ -836,7 +1576,7 @@ gsk_gl_driver_init_texture (GskGLDriver     *self,
 
   gsk_gl_driver_set_texture_parameters (self, min_filter, mag_filter);
 
-  upload_gdk_texture (texture, GL_TEXTURE_2D, 0, 0, t->width, t->height);
+  upload_gdk_texture (self, texture, GL_TEXTURE_2D, 0, 0, t->width, t->height);
 
 #ifdef G_ENABLE_DEBUG
   gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
@@ -14,6 +14,7 @@ G_DECLARE_FINAL_TYPE (GskGLDriver, gsk_gl_driver, GSK, GL_DRIVER, GObject)
 typedef struct {
   float position[2];
   float uv[2];
+  float color[4]; /* Only used by programs taking the color per vertex */
 } GskQuadVertex;
 
 typedef struct {
@@ -21,6 +22,8 @@ typedef struct {
   guint texture_id;
 } TextureSlice;
 
+/* Textures cached for a render node (the pointer), kept
+ * alive for as long as the node is still used */
 typedef struct {
   gpointer pointer;
   float scale;
@@ -36,11 +39,21 @@ int             gsk_gl_driver_get_max_texture_size      (GskGLDriver     *driver
 
 void            gsk_gl_driver_begin_frame               (GskGLDriver     *driver);
 void            gsk_gl_driver_end_frame                 (GskGLDriver     *driver);
+void            gsk_gl_driver_get_upload_stats          (GskGLDriver     *driver,
+                                                         gint64          *n_uploads,
+                                                         gint64          *n_bytes);
 gboolean        gsk_gl_driver_in_frame                  (GskGLDriver     *driver);
 int             gsk_gl_driver_get_texture_for_texture   (GskGLDriver     *driver,
                                                          GdkTexture      *texture,
                                                          int              min_filter,
-                                                         int              mag_filter);
+                                                         int              mag_filter,
+                                                         int              draw_width,
+                                                         int              draw_height);
+void            gsk_gl_driver_get_tiles                 (GskGLDriver     *driver,
+                                                         GdkTexture      *texture,
+                                                         guint            level,
+                                                         const GdkRectangle *tiles,
+                                                         int             *out_texture_ids);
 int             gsk_gl_driver_get_texture_for_key       (GskGLDriver     *driver,
                                                          GskTextureKey   *key);
 void            gsk_gl_driver_set_texture_for_key       (GskGLDriver     *driver,
@@ -8,11 +8,13 @@
 
 #include "gdk/gdkglcontextprivate.h"
 #include "gdk/gdkmemorytextureprivate.h"
+#include "gdk/gdkparallelprivate.h"
 
 #include <graphene.h>
 #include <cairo.h>
 #include <epoxy/gl.h>
 #include <string.h>
+#include <math.h>
 
 /* Cache eviction strategy
  *
@@ -25,12 +27,46 @@
  * gets too high, we drop the atlas and all the items it
  * contained.
  *
+ * Before an atlas is dropped, it is compacted: glyphs that
+ * are still in use are copied to another atlas on the GPU,
+ * a few per frame, and the cache entries are updated in place.
+ *
  * Big glyphs are not stored in the atlas, they get their
  * own texture, but they are still cached.
+ *
+ * Glyphs are cached per scale. We remember the last few scales
+ * that were drawn at, and glyphs of a recent scale that wasn't
+ * used at all since the last check are left alone, so moving a
+ * window to a monitor with a different scale and back doesn't
+ * throw away the glyphs for the monitor it came from.
  */
 
 #define MAX_FRAME_AGE (60)
 #define MAX_GLYPH_SIZE 128 /* Will get its own texture if bigger */
+#define MAX_MOVED_GLYPHS 256 /* Per frame, when compacting atlases */
+
+/* Glyphs missing from the cache are not rendered right away.
+ * Their space in the atlas is allocated on lookup, and the
+ * actual rasterization happens for all of them at once in
+ * gsk_gl_glyph_cache_upload_pending(), spread over a thread
+ * pool when there are enough of them.
+ */
+#define MIN_GLYPHS_PER_JOB 16
+
+typedef struct
+{
+  GlyphCacheKey *key;
+  GskGLCachedGlyph *value;
+  cairo_scaled_font_t *scaled_font;
+  GskImageRegion region;
+  gboolean rendered;
+} PendingGlyph;
+
+typedef struct
+{
+  PendingGlyph *glyphs;
+  guint n_glyphs;
+} RenderJob;
 
 static guint    glyph_cache_hash       (gconstpointer v);
 static gboolean glyph_cache_equal      (gconstpointer v1,
@@ -51,6 +87,7 @@ gsk_gl_glyph_cache_new (GdkDisplay *display,
                                                    glyph_cache_key_free, glyph_cache_value_free);
 
   glyph_cache->atlases = gsk_gl_texture_atlases_ref (atlases);
+  glyph_cache->pending_glyphs = g_array_new (FALSE, TRUE, sizeof (PendingGlyph));
 
   glyph_cache->ref_count = 1;
 
@@ -73,6 +110,7 @@ gsk_gl_glyph_cache_unref (GskGLGlyphCache *self)
   if (self->ref_count == 1)
     {
       gsk_gl_texture_atlases_unref (self->atlases);
+      g_array_unref (self->pending_glyphs);
       g_hash_table_unref (self->hash_table);
       g_free (self);
       return;
@@ -110,27 +148,20 @@ glyph_cache_value_free (gpointer v)
   g_free (v);
 }
 
+/* Safe to call from any thread, unless the glyph
+ * has PANGO_GLYPH_UNKNOWN_FLAG set. */
 static gboolean
-render_glyph (GlyphCacheKey    *key,
-              GskGLCachedGlyph *value,
-              GskImageRegion   *region)
+render_glyph (PendingGlyph *pending)
 {
+  GlyphCacheKey *key = pending->key;
+  GskGLCachedGlyph *value = pending->value;
+  GskImageRegion *region = &pending->region;
   cairo_surface_t *surface;
   cairo_t *cr;
-  cairo_scaled_font_t *scaled_font;
-  PangoGlyphString glyph_string;
-  PangoGlyphInfo glyph_info;
   int surface_width, surface_height;
   int stride;
   unsigned char *data;
 
-  scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *)key->data.font);
-  if (G_UNLIKELY (!scaled_font || cairo_scaled_font_status (scaled_font) != CAIRO_STATUS_SUCCESS))
-    {
-      g_warning ("Failed to get a font");
-      return FALSE;
-    }
-
   surface_width = value->draw_width * key->data.scale / 1024;
   surface_height = value->draw_height * key->data.scale / 1024;
 
@@ -143,21 +174,36 @@ render_glyph (GlyphCacheKey    *key,
 
   cr = cairo_create (surface);
 
-  cairo_set_scaled_font (cr, scaled_font);
+  cairo_set_scaled_font (cr, pending->scaled_font);
   cairo_set_source_rgba (cr, 1, 1, 1, 1);
 
-  glyph_info.glyph = key->data.glyph;
-  glyph_info.geometry.width = value->draw_width * 1024;
-  if (glyph_info.glyph & PANGO_GLYPH_UNKNOWN_FLAG)
-    glyph_info.geometry.x_offset = 0;
+  if (key->data.glyph & PANGO_GLYPH_UNKNOWN_FLAG)
+    {
+      PangoGlyphString glyph_string;
+      PangoGlyphInfo glyph_info;
+
+      /* Pango draws the hex box for these itself */
+      glyph_info.glyph = key->data.glyph;
+      glyph_info.geometry.width = value->draw_width * 1024;
+      glyph_info.geometry.x_offset = 0;
+      glyph_info.geometry.y_offset = - value->draw_y * 1024;
+
+      glyph_string.num_glyphs = 1;
+      glyph_string.glyphs = &glyph_info;
+
+      pango_cairo_show_glyph_string (cr, key->data.font, &glyph_string);
+    }
   else
-    glyph_info.geometry.x_offset = - value->draw_x * 1024;
-  glyph_info.geometry.y_offset = - value->draw_y * 1024;
+    {
+      cairo_glyph_t glyph;
+
+      glyph.index = key->data.glyph;
+      glyph.x = - value->draw_x;
+      glyph.y = - value->draw_y;
 
-  glyph_string.num_glyphs = 1;
-  glyph_string.glyphs = &glyph_info;
+      cairo_show_glyphs (cr, &glyph, 1);
+    }
 
-  pango_cairo_show_glyph_string (cr, key->data.font, &glyph_string);
   cairo_destroy (cr);
 
   cairo_surface_flush (surface);
@@ -183,48 +229,166 @@ render_glyph (GlyphCacheKey    *key,
 }
 
 static void
-upload_glyph (GlyphCacheKey    *key,
-              GskGLCachedGlyph *value)
+render_glyph_range (PendingGlyph *glyphs,
+                    guint         n_glyphs)
+{
+  guint i;
+
+  for (i = 0; i < n_glyphs; i++)
+    {
+      PendingGlyph *pending = &glyphs[i];
+
+      /* Failed fonts and unknown glyphs are dealt with beforehand */
+      if (pending->scaled_font != NULL && !pending->rendered)
+        pending->rendered = render_glyph (pending);
+    }
+}
+
+static void
+render_glyphs_func (gpointer data,
+                    gpointer user_data)
 {
-  GskImageRegion r;
+  RenderJob *job = data;
+
+  render_glyph_range (job->glyphs, job->n_glyphs);
+}
+
+/* Renders @n_glyphs glyphs that can be rendered off the main thread.
+ * The calling thread takes the first share of the work. */
+static void
+render_glyphs (PendingGlyph *glyphs,
+               guint         n_glyphs)
+{
+  RenderJob *jobs;
+  guint n_jobs;
+  guint per_job;
+  guint i;
+
+  n_jobs = MIN (gdk_parallel_get_n_threads (), n_glyphs / MIN_GLYPHS_PER_JOB);
+
+  if (n_jobs <= 1)
+    {
+      render_glyph_range (glyphs, n_glyphs);
+      return;
+    }
+
+  per_job = (n_glyphs + n_jobs - 1) / n_jobs;
+  jobs = g_newa (RenderJob, n_jobs);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].glyphs = glyphs + i * per_job;
+      jobs[i].n_glyphs = MIN (per_job, n_glyphs - i * per_job);
+    }
+
+  gdk_parallel_run (jobs, sizeof (RenderJob), n_jobs, render_glyphs_func, NULL);
+}
+
+static void
+upload_glyph (PendingGlyph *pending)
+{
+  GskImageRegion *r = &pending->region;
   guchar *pixel_data;
   guchar *free_data = NULL;
   guint gl_format;
   guint gl_type;
 
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, r->stride / 4);
+
+  if (gdk_gl_context_get_use_es (gdk_gl_context_get_current ()))
+    {
+      pixel_data = free_data = g_malloc (r->width * r->height * 4);
+      gdk_memory_convert (pixel_data, r->width * 4,
+                          GDK_MEMORY_R8G8B8A8_PREMULTIPLIED,
+                          r->data, r->width * 4,
+                          GDK_MEMORY_DEFAULT, r->width, r->height);
+      gl_format = GL_RGBA;
+      gl_type = GL_UNSIGNED_BYTE;
+    }
+  else
+    {
+      pixel_data = r->data;
+      gl_format = GL_BGRA;
+      gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+    }
+
+  glTexSubImage2D (GL_TEXTURE_2D, 0, r->x, r->y, r->width, r->height,
+                   gl_format, gl_type, pixel_data);
+  glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  g_free (r->data);
+  g_free (free_data);
+}
+
+static int
+compare_pending_glyphs (gconstpointer a,
+                        gconstpointer b)
+{
+  const PendingGlyph *pa = a;
+  const PendingGlyph *pb = b;
+
+  return (int) pa->value->texture_id - (int) pb->value->texture_id;
+}
+
+void
+gsk_gl_glyph_cache_upload_pending (GskGLGlyphCache *self)
+{
+  PendingGlyph *glyphs;
+  guint n_glyphs;
+  guint texture_id;
+  guint i;
+
+  if (self->pending_glyphs->len == 0)
+    return;
+
   gdk_gl_context_push_debug_group_printf (gdk_gl_context_get_current (),
-                                          "Uploading glyph %d",
-                                          key->data.glyph);
+                                          "Uploading %u glyphs",
+                                          self->pending_glyphs->len);
 
-  if (render_glyph (key, value, &r))
+  /* Group the glyphs by texture, so we bind each atlas once */
+  g_array_sort (self->pending_glyphs, compare_pending_glyphs);
+
+  glyphs = (PendingGlyph *) self->pending_glyphs->data;
+  n_glyphs = self->pending_glyphs->len;
+
+  for (i = 0; i < n_glyphs; i++)
     {
-      glPixelStorei (GL_UNPACK_ROW_LENGTH, r.stride / 4);
-      glBindTexture (GL_TEXTURE_2D, value->texture_id);
+      PendingGlyph *pending = &glyphs[i];
 
-      if (gdk_gl_context_get_use_es (gdk_gl_context_get_current ()))
+      pending->scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *)pending->key->data.font);
+      if (G_UNLIKELY (!pending->scaled_font ||
+                      cairo_scaled_font_status (pending->scaled_font) != CAIRO_STATUS_SUCCESS))
         {
-          pixel_data = free_data = g_malloc (r.width * r.height * 4);
-          gdk_memory_convert (pixel_data, r.width * 4,
-                              GDK_MEMORY_R8G8B8A8_PREMULTIPLIED,
-                              r.data, r.width * 4,
-                              GDK_MEMORY_DEFAULT, r.width, r.height);
-          gl_format = GL_RGBA;
-          gl_type = GL_UNSIGNED_BYTE;
+          g_warning ("Failed to get a font");
+          pending->scaled_font = NULL;
+          continue;
         }
-      else
+
+      /* Pango is not thread-safe, so render these here */
+      if (pending->key->data.glyph & PANGO_GLYPH_UNKNOWN_FLAG)
+        pending->rendered = render_glyph (pending);
+    }
+
+  render_glyphs (glyphs, n_glyphs);
+
+  texture_id = 0;
+  for (i = 0; i < n_glyphs; i++)
+    {
+      PendingGlyph *pending = &glyphs[i];
+
+      if (!pending->rendered)
+        continue;
+
+      if (pending->value->texture_id != texture_id)
         {
-          pixel_data = r.data;
-          gl_format = GL_BGRA;
-          gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+          texture_id = pending->value->texture_id;
+          glBindTexture (GL_TEXTURE_2D, texture_id);
         }
 
-      glTexSubImage2D (GL_TEXTURE_2D, 0, r.x, r.y, r.width, r.height,
-                       gl_format, gl_type, pixel_data);
-      glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
-      g_free (r.data);
-      g_free (free_data);
+      upload_glyph (pending);
     }
 
+  g_array_set_size (self->pending_glyphs, 0);
+
   gdk_gl_context_pop_debug_group (gdk_gl_context_get_current ());
 }
 
@@ -269,10 +433,56 @@ add_to_cache (GskGLGlyphCache  *self,
       value->th = 1.0f;
     }
 
-  upload_glyph (key, value);
+  {
+    PendingGlyph pending = { key, value, };
+
+    g_array_append_val (self->pending_glyphs, pending);
+  }
+}
+
+static void
+note_scale_used (GskGLGlyphCache *self,
+                 guint            scale)
+{
+  guint i;
+
+  if (G_LIKELY (self->recent_scales[0] == scale))
+    {
+      self->recent_scale_timestamps[0] = self->timestamp;
+      return;
+    }
+
+  for (i = 1; i < G_N_ELEMENTS (self->recent_scales) - 1; i++)
+    {
+      if (self->recent_scales[i] == scale)
+        break;
+    }
+
+  memmove (&self->recent_scales[1], &self->recent_scales[0], i * sizeof (guint));
+  memmove (&self->recent_scale_timestamps[1], &self->recent_scale_timestamps[0], i * sizeof (int));
+  self->recent_scales[0] = scale;
+  self->recent_scale_timestamps[0] = self->timestamp;
 }
 
-void
+/* Whether @scale is one of the recent scales, but nothing was drawn
+ * at it since the last check */
+static gboolean
+is_scale_idle (GskGLGlyphCache *self,
+               guint            scale)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (self->recent_scales); i++)
+    {
+      if (self->recent_scales[i] == scale)
+        return self->recent_scale_timestamps[i] <= self->timestamp - MAX_FRAME_AGE;
+    }
+
+  return FALSE;
+}
+
+/* Returns whether the glyph was already in the cache */
+gboolean
 gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
                                   GlyphCacheKey           *lookup,
                                   GskGLDriver             *driver,
@@ -280,6 +490,8 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
 {
   GskGLCachedGlyph *value;
 
+  note_scale_used (cache, lookup->data.scale);
+
   value = g_hash_table_lookup (cache->hash_table, lookup);
 
   if (value)
@@ -292,7 +504,7 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
       value->accessed = TRUE;
 
       *cached_glyph_out = value;
-      return;
+      return TRUE;
     }
 
   {
@@ -332,6 +544,38 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
     *cached_glyph_out = value;
     g_hash_table_insert (cache->hash_table, key, value);
   }
+
+  return FALSE;
+}
+
+static void
+move_glyph (GskGLGlyphCache  *self,
+            GlyphCacheKey    *key,
+            GskGLCachedGlyph *value)
+{
+  const int width = value->draw_width * key->data.scale / 1024;
+  const int height = value->draw_height * key->data.scale / 1024;
+  GskGLTextureAtlas *atlas = NULL;
+  int x, y;
+  int packed_x = 0;
+  int packed_y = 0;
+
+  /* The packed rect includes the 1px padding around the glyph */
+  x = (int) roundf (value->tx * value->atlas->width) - 1;
+  y = (int) roundf (value->ty * value->atlas->height) - 1;
+
+  if (!gsk_gl_texture_atlases_move (self->atlases, value->atlas,
+                                    x, y, width + 2, height + 2,
+                                    &atlas, &packed_x, &packed_y))
+    return;
+
+  value->tx = (float)(packed_x + 1) / atlas->width;
+  value->ty = (float)(packed_y + 1) / atlas->height;
+  value->tw = (float)width / atlas->width;
+  value->th = (float)height / atlas->height;
+
+  value->atlas = atlas;
+  value->texture_id = atlas->texture_id;
 }
 
 void
@@ -359,6 +603,32 @@ gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self,
         }
     }
 
+  if (gsk_gl_texture_atlases_is_compacting (self->atlases))
+    {
+      guint moved = 0;
+
+      g_hash_table_iter_init (&iter, self->hash_table);
+      while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&value))
+        {
+          if (value->atlas == NULL || !value->atlas->compacting)
+            continue;
+
+          if (!value->used)
+            {
+              gsk_gl_texture_atlases_release (self->atlases, value->atlas);
+              g_hash_table_iter_remove (&iter);
+              dropped++;
+            }
+          else if (moved < MAX_MOVED_GLYPHS)
+            {
+              move_glyph (self, key, value);
+              moved++;
+            }
+        }
+
+      GSK_NOTE(GLYPH_CACHE, if (moved > 0) g_message ("Moved %d glyphs", moved));
+    }
+
   if (self->timestamp % MAX_FRAME_AGE == 30)
     {
       g_hash_table_iter_init (&iter, self->hash_table);
@@ -366,6 +636,9 @@ gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self,
         {
           if (!value->accessed)
             {
+              if (is_scale_idle (self, key->data.scale))
+                continue;
+
               if (value->atlas)
                 {
                   if (value->used)
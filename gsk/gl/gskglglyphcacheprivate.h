@@ -14,8 +14,13 @@ typedef struct
   GdkDisplay *display;
   GHashTable *hash_table;
   GskGLTextureAtlases *atlases;
+  GArray *pending_glyphs; /* Waiting to be rendered and uploaded */
 
   int timestamp;
+
+  /* Most recently used scales first, with the frame they were last used */
+  guint recent_scales[3];
+  int recent_scale_timestamps[3];
 } GskGLGlyphCache;
 
 struct _CacheKeyData
@@ -84,9 +89,10 @@ void                     gsk_gl_glyph_cache_unref           (GskGLGlyphCache
 void                     gsk_gl_glyph_cache_begin_frame     (GskGLGlyphCache        *self,
                                                              GskGLDriver            *driver,
                                                              GPtrArray              *removed_atlases);
-void                     gsk_gl_glyph_cache_lookup_or_add   (GskGLGlyphCache        *self,
+gboolean                 gsk_gl_glyph_cache_lookup_or_add   (GskGLGlyphCache        *self,
                                                              GlyphCacheKey          *lookup,
                                                              GskGLDriver            *driver,
                                                              const GskGLCachedGlyph **cached_glyph_out);
+void                     gsk_gl_glyph_cache_upload_pending  (GskGLGlyphCache        *self);
 
 #endif
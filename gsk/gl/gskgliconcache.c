@@ -5,8 +5,10 @@
 #include "gdk/gdkglcontextprivate.h"
 
 #include <epoxy/gl.h>
+#include <math.h>
 
 #define MAX_FRAME_AGE 60
+#define MAX_MOVED_ICONS 64 /* Per frame, when compacting atlases */
 
 static void
 icon_data_free (gpointer p)
@@ -55,6 +57,34 @@ gsk_gl_icon_cache_unref (GskGLIconCache *self)
   self->ref_count--;
 }
 
+static void
+move_icon (GskGLIconCache *self,
+           IconData       *icon_data)
+{
+  const int width = icon_data->source_texture->width;
+  const int height = icon_data->source_texture->height;
+  GskGLTextureAtlas *atlas = NULL;
+  int x, y;
+  int packed_x = 0;
+  int packed_y = 0;
+
+  /* Move the padding along with the icon */
+  x = (int) roundf (icon_data->x * icon_data->atlas->width) - 1;
+  y = (int) roundf (icon_data->y * icon_data->atlas->height) - 1;
+
+  if (!gsk_gl_texture_atlases_move (self->atlases, icon_data->atlas,
+                                    x, y, width + 2, height + 2,
+                                    &atlas, &packed_x, &packed_y))
+    return;
+
+  icon_data->atlas = atlas;
+  icon_data->texture_id = atlas->texture_id;
+  icon_data->x = (float)(packed_x + 1) / atlas->width;
+  icon_data->y = (float)(packed_y + 1) / atlas->height;
+  icon_data->x2 = icon_data->x + (float)width / atlas->width;
+  icon_data->y2 = icon_data->y + (float)height / atlas->height;
+}
+
 void
 gsk_gl_icon_cache_begin_frame (GskGLIconCache *self,
                                GPtrArray      *removed_atlases)
@@ -83,6 +113,32 @@ gsk_gl_icon_cache_begin_frame (GskGLIconCache *self,
       GSK_NOTE(GLYPH_CACHE, if (dropped > 0) g_message ("Dropped %d icons", dropped));
     }
 
+  /* Move icons off of atlases that are being compacted */
+  if (gsk_gl_texture_atlases_is_compacting (self->atlases))
+    {
+      guint moved = 0;
+
+      g_hash_table_iter_init (&iter, self->icons);
+      while (g_hash_table_iter_next (&iter, (gpointer *)&texture, (gpointer *)&icon_data))
+        {
+          if (!icon_data->atlas->compacting)
+            continue;
+
+          if (!icon_data->used)
+            {
+              gsk_gl_texture_atlases_release (self->atlases, icon_data->atlas);
+              g_hash_table_iter_remove (&iter);
+            }
+          else if (moved < MAX_MOVED_ICONS)
+            {
+              move_icon (self, icon_data);
+              moved++;
+            }
+        }
+
+      GSK_NOTE(GLYPH_CACHE, if (moved > 0) g_message ("Moved %d icons", moved));
+    }
+
   if (self->timestamp % MAX_FRAME_AGE == 0)
     {
       g_hash_table_iter_init (&iter, self->icons);
@@ -18,6 +18,12 @@ struct _GskGLProfiler
   GLuint gl_queries[N_QUERIES];
   GLuint active_query;
 
+  /* GL_TIMESTAMP queries, used to time parts of a frame.
+   * They can't be nested in the GL_TIME_ELAPSED query of the
+   * frame, so we take timestamps and subtract them instead.
+   */
+  GArray *timestamp_queries;
+
   gboolean has_timer : 1;
   gboolean first_frame : 1;
 };
@@ -38,6 +44,9 @@ gsk_gl_profiler_finalize (GObject *gobject)
   GskGLProfiler *self = GSK_GL_PROFILER (gobject);
 
   glDeleteQueries (N_QUERIES, self->gl_queries);
+  if (self->timestamp_queries->len > 0)
+    glDeleteQueries (self->timestamp_queries->len, (GLuint *) self->timestamp_queries->data);
+  g_array_unref (self->timestamp_queries);
 
   g_clear_object (&self->gl_context);
 
@@ -107,6 +116,7 @@ static void
 gsk_gl_profiler_init (GskGLProfiler *self)
 {
   glGenQueries (N_QUERIES, self->gl_queries);
+  self->timestamp_queries = g_array_new (FALSE, FALSE, sizeof (GLuint));
 
   self->first_frame = TRUE;
   self->has_timer = epoxy_gl_version () >= 33 || epoxy_has_gl_extension ("GL_ARB_timer_query");
@@ -173,3 +183,57 @@ gsk_gl_profiler_end_gpu_region (GskGLProfiler *profiler)
 
   return elapsed / 1000; /* Convert to usec to match other profiler APIs */
 }
+
+gboolean
+gsk_gl_profiler_has_timestamps (GskGLProfiler *profiler)
+{
+  g_return_val_if_fail (GSK_IS_GL_PROFILER (profiler), FALSE);
+
+  return profiler->has_timer;
+}
+
+/* Records the GPU time once the commands issued so far are done
+ * into the @index'th timestamp query, creating it if needed.
+ */
+void
+gsk_gl_profiler_query_timestamp (GskGLProfiler *profiler,
+                                 guint          index)
+{
+  g_return_if_fail (GSK_IS_GL_PROFILER (profiler));
+
+  if (!profiler->has_timer)
+    return;
+
+  if (index >= profiler->timestamp_queries->len)
+    {
+      guint old_len = profiler->timestamp_queries->len;
+      guint new_len = MAX (MAX (old_len * 2, 64), index + 1);
+
+      g_array_set_size (profiler->timestamp_queries, new_len);
+      glGenQueries (new_len - old_len, &g_array_index (profiler->timestamp_queries, GLuint, old_len));
+    }
+
+  glQueryCounter (g_array_index (profiler->timestamp_queries, GLuint, index), GL_TIMESTAMP);
+}
+
+/* Returns the result of a timestamp query in nanoseconds. This
+ * waits for the GPU to get to the query, so only call it after
+ * all the queries of a frame have been issued.
+ */
+guint64
+gsk_gl_profiler_get_timestamp (GskGLProfiler *profiler,
+                               guint          index)
+{
+  GLuint64 timestamp;
+
+  g_return_val_if_fail (GSK_IS_GL_PROFILER (profiler), 0);
+
+  if (!profiler->has_timer || index >= profiler->timestamp_queries->len)
+    return 0;
+
+  glGetQueryObjectui64v (g_array_index (profiler->timestamp_queries, GLuint, index),
+                         GL_QUERY_RESULT,
+                         &timestamp);
+
+  return timestamp;
+}
@@ -13,6 +13,12 @@ GskGLProfiler * gsk_gl_profiler_new                     (GdkGLContext  *context)
 void            gsk_gl_profiler_begin_gpu_region        (GskGLProfiler *profiler);
 guint64         gsk_gl_profiler_end_gpu_region          (GskGLProfiler *profiler);
 
+gboolean        gsk_gl_profiler_has_timestamps          (GskGLProfiler *profiler);
+void            gsk_gl_profiler_query_timestamp         (GskGLProfiler *profiler,
+                                                         guint          index);
+guint64         gsk_gl_profiler_get_timestamp           (GskGLProfiler *profiler,
+                                                         guint          index);
+
 G_END_DECLS
 
 #endif /* __GSK_GL_PROFILER_PRIVATE_H__ */
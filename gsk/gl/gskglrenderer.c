@@ -17,6 +17,7 @@
 #include "gskcairoblurprivate.h"
 #include "gskglshadowcacheprivate.h"
 #include "gskglnodesampleprivate.h"
+#include "gskgradientrampprivate.h"
 #include "gsktransform.h"
 #include "glutilsprivate.h"
 #include "gskglshaderprivate.h"
@@ -25,8 +26,10 @@
 
 #include "gdk/gdkgltextureprivate.h"
 #include "gdk/gdkglcontextprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 #include "gdk/gdkrgbaprivate.h"
+#include "gdk/gdktiledtextureprivate.h"
 
 #include <epoxy/gl.h>
 
@@ -494,6 +497,24 @@ static void gsk_gl_renderer_add_render_ops     (GskGLRenderer   *self,
                                                 GskRenderNode   *node,
                                                 RenderOpBuilder *builder);
 
+/* The vertex buffer is kept across frames. With persistent mapping,
+ * it is split in N_VERTEX_SEGMENTS parts that are filled in turn, each
+ * guarded by a fence so we never overwrite data the GPU still reads.
+ */
+#define N_VERTEX_SEGMENTS 3
+#define MIN_VERTEX_SEGMENT_SIZE (64 * 1024)
+
+typedef struct
+{
+  GLuint vao_id;
+  GLuint buffer_id;
+  gsize segment_size;
+  guint segment;
+  guchar *mapped; /* NULL without persistent mapping */
+  GLsync fences[N_VERTEX_SEGMENTS];
+  guint persistent : 1;
+} VertexArena;
+
 struct _GskGLRenderer
 {
   GskRenderer parent_instance;
@@ -512,20 +533,111 @@ struct _GskGLRenderer
   GskGLGlyphCache *glyph_cache;
   GskGLIconCache *icon_cache;
   GskGLShadowCache shadow_cache;
+  GskGradientRampCache gradient_ramps;
+  GskGLImage gradient_ramp_image;
+
+  VertexArena vertex_arena;
 
 #ifdef G_ENABLE_DEBUG
   struct {
     GQuark frames;
+    GQuark vertex_bytes;
+    GQuark offscreens_avoided;
+    GQuark offscreens;
+    GQuark glyph_cache_hits;
+    GQuark glyph_cache_misses;
+    GQuark ops;
+    GQuark texture_uploads;
+    GQuark upload_bytes;
   } profile_counters;
   struct {
     GQuark cpu_time;
     GQuark gpu_time;
   } profile_timers;
+
+  /* GpuSpan, for GSK_DEBUG=gpu-timing. Each span is timed by
+   * the timestamp queries 2 * i and 2 * i + 1.
+   */
+  GArray *gpu_spans;
+  guint gpu_span_depth;
 #endif
 
   cairo_region_t *render_region;
 };
 
+#ifdef G_ENABLE_DEBUG
+/* Every span costs two queries and splits up the draw calls,
+ * so we stop timing nodes after this many in a frame.
+ */
+#define MAX_GPU_SPANS 1024
+
+typedef struct
+{
+  const char *name;
+  guint depth;
+} GpuSpan;
+
+static guint
+gsk_gl_renderer_begin_gpu_span (GskGLRenderer   *self,
+                                RenderOpBuilder *builder,
+                                const char      *name)
+{
+  GpuSpan span;
+
+  if (!GSK_RENDERER_DEBUG_CHECK (GSK_RENDERER (self), GPU_TIMING) ||
+      !gsk_gl_profiler_has_timestamps (self->gl_profiler) ||
+      self->gpu_spans->len >= MAX_GPU_SPANS)
+    return G_MAXUINT;
+
+  span.name = name;
+  span.depth = self->gpu_span_depth++;
+  g_array_append_val (self->gpu_spans, span);
+
+  ops_query_timestamp (builder, 2 * (self->gpu_spans->len - 1));
+
+  return self->gpu_spans->len - 1;
+}
+
+static void
+gsk_gl_renderer_end_gpu_span (GskGLRenderer   *self,
+                              RenderOpBuilder *builder,
+                              guint            span)
+{
+  if (span == G_MAXUINT)
+    return;
+
+  ops_query_timestamp (builder, 2 * span + 1);
+  self->gpu_span_depth--;
+}
+
+static void
+gsk_gl_renderer_collect_gpu_spans (GskGLRenderer *self)
+{
+  GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+  guint64 frame_start = 0;
+  guint i;
+
+  for (i = 0; i < self->gpu_spans->len; i++)
+    {
+      const GpuSpan *span = &g_array_index (self->gpu_spans, GpuSpan, i);
+      guint64 start, end;
+
+      start = gsk_gl_profiler_get_timestamp (self->gl_profiler, 2 * i);
+      end = gsk_gl_profiler_get_timestamp (self->gl_profiler, 2 * i + 1);
+      if (i == 0)
+        frame_start = start;
+
+      gsk_profiler_add_gpu_span (profiler,
+                                 span->name,
+                                 span->depth,
+                                 start - frame_start,
+                                 end - start);
+    }
+
+  g_array_set_size (self->gpu_spans, 0);
+}
+#endif
+
 struct _GskGLRendererClass
 {
   GskRendererClass parent_class;
@@ -749,6 +861,40 @@ render_fallback_node (GskGLRenderer   *self,
   load_offscreen_vertex_data (ops_draw (builder, NULL), node, builder);
 }
 
+typedef struct
+{
+  const GskGLCachedGlyph *glyph;
+  float x;
+  float y;
+} GlyphQuad;
+
+static inline void
+draw_glyph_quad (RenderOpBuilder *builder,
+                 const GlyphQuad *quad)
+{
+  const GskGLCachedGlyph *glyph = quad->glyph;
+  const float glyph_x = quad->x;
+  const float glyph_y = quad->y;
+  const float glyph_x2 = glyph_x + glyph->draw_width;
+  const float glyph_y2 = glyph_y + glyph->draw_height;
+  const float tx = glyph->tx;
+  const float ty = glyph->ty;
+  const float tx2 = tx + glyph->tw;
+  const float ty2 = ty + glyph->th;
+
+  ops_set_texture (builder, glyph->texture_id);
+
+  ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
+    { { glyph_x,  glyph_y  }, { tx,  ty  }, },
+    { { glyph_x,  glyph_y2 }, { tx,  ty2 }, },
+    { { glyph_x2, glyph_y  }, { tx2, ty  }, },
+
+    { { glyph_x2, glyph_y2 }, { tx2, ty2 }, },
+    { { glyph_x,  glyph_y2 }, { tx,  ty2 }, },
+    { { glyph_x2, glyph_y  }, { tx2, ty  }, },
+  });
+}
+
 static inline void
 render_text_node (GskGLRenderer   *self,
                   GskRenderNode   *node,
@@ -763,12 +909,17 @@ render_text_node (GskGLRenderer   *self,
   const guint num_glyphs = gsk_text_node_get_num_glyphs (node);
   const float x = offset->x + builder->dx;
   const float y = offset->y + builder->dy;
+  GlyphQuad stack_quads[128];
+  GlyphQuad *quads;
+  guint n_quads = 0;
+  gboolean recolor;
   int i;
   int x_position = 0;
   GlyphCacheKey lookup;
 
   /* If the font has color glyphs, we don't need to recolor anything */
-  if (!force_color && gsk_text_node_has_color_glyphs (node))
+  recolor = force_color || !gsk_text_node_has_color_glyphs (node);
+  if (!recolor)
     {
       ops_set_program (builder, &self->programs->blit_program);
     }
@@ -782,14 +933,18 @@ render_text_node (GskGLRenderer   *self,
   lookup.data.font = (PangoFont *)font;
   lookup.data.scale = (guint) (text_scale * 1024);
 
+  if (num_glyphs <= G_N_ELEMENTS (stack_quads))
+    quads = stack_quads;
+  else
+    quads = g_new (GlyphQuad, num_glyphs);
+
   /* We use one quad per character, unlike the other nodes which
    * use at most one quad altogether */
   for (i = 0; i < num_glyphs; i++)
     {
       const PangoGlyphInfo *gi = &glyphs[i];
       const GskGLCachedGlyph *glyph;
-      float glyph_x, glyph_y, glyph_x2, glyph_y2;
-      float tx, ty, tx2, ty2;
+      G_GNUC_UNUSED gboolean cached; /* Only counted when debugging */
       float cx;
       float cy;
 
@@ -801,39 +956,74 @@ render_text_node (GskGLRenderer   *self,
 
       glyph_cache_key_set_glyph_and_shift (&lookup, gi->glyph, x + cx, y + cy);
 
-      gsk_gl_glyph_cache_lookup_or_add (self->glyph_cache,
-                                        &lookup,
-                                        self->gl_driver,
-                                        &glyph);
+      cached = gsk_gl_glyph_cache_lookup_or_add (self->glyph_cache,
+                                                 &lookup,
+                                                 self->gl_driver,
+                                                 &glyph);
+#ifdef G_ENABLE_DEBUG
+      gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                cached ? self->profile_counters.glyph_cache_hits
+                                       : self->profile_counters.glyph_cache_misses);
+#endif
 
-      if (glyph->texture_id == 0)
-        goto next;
+      if (glyph->texture_id != 0)
+        {
+          quads[n_quads].glyph = glyph;
+          quads[n_quads].x = floor (x + cx + 0.125) + glyph->draw_x;
+          quads[n_quads].y = floor (y + cy + 0.125) + glyph->draw_y;
+          n_quads++;
+        }
 
-      ops_set_texture (builder, glyph->texture_id);
+      x_position += gi->geometry.width;
+    }
 
-      tx  = glyph->tx;
-      ty  = glyph->ty;
-      tx2 = tx + glyph->tw;
-      ty2 = ty + glyph->th;
+  if (!recolor)
+    {
+      /* Color glyphs may overlap each other, so keep their order */
+      for (i = 0; i < n_quads; i++)
+        draw_glyph_quad (builder, &quads[i]);
+    }
+  else
+    {
+      guint j;
 
-      glyph_x = floor (x + cx + 0.125) + glyph->draw_x;
-      glyph_y = floor (y + cy + 0.125) + glyph->draw_y;
-      glyph_x2 = glyph_x + glyph->draw_width;
-      glyph_y2 = glyph_y + glyph->draw_height;
+      /* All glyphs have the same color here, and drawing one over
+       * the other gives the same result in either order. So draw
+       * them grouped by atlas, starting with the atlas that is in
+       * use already. That way, consecutive text nodes end up in
+       * a single draw, even if their glyphs are in several atlases.
+       */
+      for (i = 0; i < n_quads; i++)
+        {
+          if (quads[i].glyph->texture_id == builder->current_texture)
+            {
+              draw_glyph_quad (builder, &quads[i]);
+              quads[i].glyph = NULL;
+            }
+        }
 
-      ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
-        { { glyph_x,  glyph_y  }, { tx,  ty  }, },
-        { { glyph_x,  glyph_y2 }, { tx,  ty2 }, },
-        { { glyph_x2, glyph_y  }, { tx2, ty  }, },
+      for (i = 0; i < n_quads; i++)
+        {
+          guint texture_id;
 
-        { { glyph_x2, glyph_y2 }, { tx2, ty2 }, },
-        { { glyph_x,  glyph_y2 }, { tx,  ty2 }, },
-        { { glyph_x2, glyph_y  }, { tx2, ty  }, },
-      });
+          if (quads[i].glyph == NULL)
+            continue;
 
-next:
-      x_position += gi->geometry.width;
+          texture_id = quads[i].glyph->texture_id;
+          for (j = i; j < n_quads; j++)
+            {
+              if (quads[j].glyph != NULL &&
+                  quads[j].glyph->texture_id == texture_id)
+                {
+                  draw_glyph_quad (builder, &quads[j]);
+                  quads[j].glyph = NULL;
+                }
+            }
+        }
     }
+
+  if (quads != stack_quads)
+    g_free (quads);
 }
 
 static inline void
@@ -986,10 +1176,14 @@ render_color_node (GskGLRenderer   *self,
   load_vertex_data (ops_draw (builder, NULL), node, builder);
 }
 
+/* @node is the node @texture is drawn for, its size decides
+ * how much detail of the texture we need */
 static inline void
-upload_texture (GskGLRenderer *self,
-                GdkTexture    *texture,
-                TextureRegion *out_region)
+upload_texture (GskGLRenderer   *self,
+                GdkTexture      *texture,
+                GskRenderNode   *node,
+                RenderOpBuilder *builder,
+                TextureRegion   *out_region)
 {
   if (texture->width <= 128 &&
       texture->height <= 128 &&
@@ -1009,12 +1203,15 @@ upload_texture (GskGLRenderer *self,
     }
   else
     {
+      const float scale = ops_get_scale (builder);
 
       out_region->texture_id =
           gsk_gl_driver_get_texture_for_texture (self->gl_driver,
                                                  texture,
                                                  GL_LINEAR,
-                                                 GL_LINEAR);
+                                                 GL_LINEAR,
+                                                 ceilf (node->bounds.size.width * scale),
+                                                 ceilf (node->bounds.size.height * scale));
 
       out_region->x  = 0;
       out_region->y  = 0;
@@ -1023,6 +1220,85 @@ upload_texture (GskGLRenderer *self,
     }
 }
 
+/* Draws the visible tiles of a lazily decoded texture, at the
+ * smallest mip level that still has at least one texel per pixel */
+static inline void
+render_tiled_texture_node (GskGLRenderer   *self,
+                           GskRenderNode   *node,
+                           RenderOpBuilder *builder)
+{
+  GdkTiledTexture *texture = GDK_TILED_TEXTURE (gsk_texture_node_get_texture (node));
+  const float scale = ops_get_scale (builder);
+  const int tile_size = GDK_TILED_TEXTURE_TILE_SIZE;
+  const guint n_levels = gdk_tiled_texture_get_n_levels (texture);
+  graphene_rect_t visible;
+  GdkRectangle tiles;
+  float scale_x, scale_y;
+  int level_width, level_height;
+  int *texture_ids;
+  guint level;
+  int col, row, i;
+
+  for (level = 0; level + 1 < n_levels; level++)
+    {
+      gdk_tiled_texture_get_level_size (texture, level + 1, &level_width, &level_height);
+      if (level_width < node->bounds.size.width * scale ||
+          level_height < node->bounds.size.height * scale)
+        break;
+    }
+
+  gdk_tiled_texture_get_level_size (texture, level, &level_width, &level_height);
+  scale_x = node->bounds.size.width / level_width;
+  scale_y = node->bounds.size.height / level_height;
+
+  /* Only the tiles inside the clip */
+  if (!ops_untransform_bounds_modelview (builder, &builder->current_clip->bounds, &visible) ||
+      !graphene_rect_intersection (&visible, &node->bounds, &visible))
+    visible = node->bounds;
+
+  tiles.x = (int) floorf ((visible.origin.x - node->bounds.origin.x) / scale_x) / tile_size;
+  tiles.y = (int) floorf ((visible.origin.y - node->bounds.origin.y) / scale_y) / tile_size;
+  tiles.width = MIN (ceilf ((visible.origin.x + visible.size.width - node->bounds.origin.x) / scale_x),
+                     level_width);
+  tiles.height = MIN (ceilf ((visible.origin.y + visible.size.height - node->bounds.origin.y) / scale_y),
+                      level_height);
+  tiles.width = (tiles.width + tile_size - 1) / tile_size - tiles.x;
+  tiles.height = (tiles.height + tile_size - 1) / tile_size - tiles.y;
+  if (tiles.width <= 0 || tiles.height <= 0)
+    return;
+
+  texture_ids = g_newa (int, tiles.width * tiles.height);
+  gsk_gl_driver_get_tiles (self->gl_driver, GDK_TEXTURE (texture), level, &tiles, texture_ids);
+
+  ops_set_program (builder, &self->programs->blit_program);
+
+  i = 0;
+  for (row = tiles.y; row < tiles.y + tiles.height; row++)
+    for (col = tiles.x; col < tiles.x + tiles.width; col++, i++)
+      {
+        const int tile_width = MIN (tile_size, level_width - col * tile_size);
+        const int tile_height = MIN (tile_size, level_height - row * tile_size);
+        const float x1 = builder->dx + node->bounds.origin.x + col * tile_size * scale_x;
+        const float y1 = builder->dy + node->bounds.origin.y + row * tile_size * scale_y;
+        const float x2 = x1 + tile_width * scale_x;
+        const float y2 = y1 + tile_height * scale_y;
+
+        if (texture_ids[i] == 0)
+          continue;
+
+        ops_set_texture (builder, texture_ids[i]);
+        ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
+          { { x1, y1 }, { 0, 0 }, },
+          { { x1, y2 }, { 0, 1 }, },
+          { { x2, y1 }, { 1, 0 }, },
+
+          { { x2, y2 }, { 1, 1 }, },
+          { { x1, y2 }, { 0, 1 }, },
+          { { x2, y1 }, { 1, 0 }, },
+        });
+      }
+}
+
 static inline void
 render_texture_node (GskGLRenderer       *self,
                      GskRenderNode       *node,
@@ -1031,7 +1307,11 @@ render_texture_node (GskGLRenderer       *self,
   GdkTexture *texture = gsk_texture_node_get_texture (node);
   const int max_texture_size = gsk_gl_driver_get_max_texture_size (self->gl_driver);
 
-  if (texture->width > max_texture_size || texture->height > max_texture_size)
+  if (GDK_IS_TILED_TEXTURE (texture))
+    {
+      render_tiled_texture_node (self, node, builder);
+    }
+  else if (texture->width > max_texture_size || texture->height > max_texture_size)
     {
       const float min_x = builder->dx + node->bounds.origin.x;
       const float min_y = builder->dy + node->bounds.origin.y;
@@ -1072,7 +1352,7 @@ render_texture_node (GskGLRenderer       *self,
     {
       TextureRegion r;
 
-      upload_texture (self, texture, &r);
+      upload_texture (self, texture, node, builder, &r);
 
       ops_set_program (builder, &self->programs->blit_program);
       ops_set_texture (builder, r.texture_id);
@@ -1385,7 +1665,8 @@ render_opacity_node (GskGLRenderer   *self,
   const float opacity = gsk_opacity_node_get_opacity (node);
   float prev_opacity;
 
-  if (gsk_render_node_get_node_type (child) == GSK_CONTAINER_NODE)
+  if (gsk_render_node_get_node_type (child) == GSK_CONTAINER_NODE &&
+      !gsk_render_node_can_inherit_opacity (child))
     {
       gboolean is_offscreen;
       TextureRegion region;
@@ -1414,6 +1695,12 @@ render_opacity_node (GskGLRenderer   *self,
     }
   else
     {
+#ifdef G_ENABLE_DEBUG
+      if (gsk_render_node_get_node_type (child) == GSK_CONTAINER_NODE)
+        gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                  self->profile_counters.offscreens_avoided);
+#endif
+
       prev_opacity = ops_set_opacity (builder,
                                       builder->current_opacity * opacity);
 
@@ -1424,6 +1711,101 @@ render_opacity_node (GskGLRenderer   *self,
   ops_set_opacity (builder, prev_opacity);
 }
 
+/* A linear gradient is an affine mapping of the ramp, so we can draw
+ * the ones with too many stops for the shader with the blit program
+ * and the gradient position as the texture coordinate. */
+static gboolean
+render_gradient_ramp (GskGLRenderer   *self,
+                      GskRenderNode   *node,
+                      RenderOpBuilder *builder)
+{
+  const gsize n_color_stops = gsk_linear_gradient_node_get_n_color_stops (node);
+  const GskColorStop *stops = gsk_linear_gradient_node_peek_color_stops (node, NULL);
+  const graphene_point_t *start = gsk_linear_gradient_node_peek_start (node);
+  const graphene_point_t *end = gsk_linear_gradient_node_peek_end (node);
+  const float dx = end->x - start->x;
+  const float dy = end->y - start->y;
+  const float len2 = dx * dx + dy * dy;
+  const float x1 = node->bounds.origin.x;
+  const float y1 = node->bounds.origin.y;
+  const float x2 = x1 + node->bounds.size.width;
+  const float y2 = y1 + node->bounds.size.height;
+  float u11, u12, u21, u22, v;
+  int row;
+
+  if (len2 == 0)
+    return FALSE;
+
+  row = gsk_gradient_ramp_cache_lookup (&self->gradient_ramps, stops, n_color_stops);
+  if (row < 0)
+    return FALSE;
+
+  if (self->gradient_ramp_image.texture_id == 0)
+    gsk_gl_image_create (&self->gradient_ramp_image, self->gl_driver,
+                         GSK_GRADIENT_RAMP_WIDTH, GSK_GRADIENT_RAMP_ROWS,
+                         GL_LINEAR, GL_LINEAR);
+
+#define RAMP_U(x, y) gsk_gradient_ramp_get_u ((((x) - start->x) * dx + ((y) - start->y) * dy) / len2)
+  u11 = RAMP_U (x1, y1);
+  u12 = RAMP_U (x1, y2);
+  u21 = RAMP_U (x2, y1);
+  u22 = RAMP_U (x2, y2);
+#undef RAMP_U
+  v = gsk_gradient_ramp_get_v (row);
+
+  ops_set_program (builder, &self->programs->blit_program);
+  ops_set_texture (builder, self->gradient_ramp_image.texture_id);
+  ops_draw (builder, (GskQuadVertex[GL_N_VERTICES]) {
+    { { builder->dx + x1, builder->dy + y1 }, { u11, v }, },
+    { { builder->dx + x1, builder->dy + y2 }, { u12, v }, },
+    { { builder->dx + x2, builder->dy + y1 }, { u21, v }, },
+
+    { { builder->dx + x2, builder->dy + y2 }, { u22, v }, },
+    { { builder->dx + x1, builder->dy + y2 }, { u12, v }, },
+    { { builder->dx + x2, builder->dy + y1 }, { u21, v }, },
+  });
+
+  return TRUE;
+}
+
+static void
+upload_gradient_ramps (GskGLRenderer *self)
+{
+  const guchar *data;
+  guchar *free_data = NULL;
+  int first_row, n_rows;
+  guint gl_format;
+  guint gl_type;
+
+  data = gsk_gradient_ramp_cache_get_dirty (&self->gradient_ramps, &first_row, &n_rows);
+  if (data == NULL)
+    return;
+
+  if (gdk_gl_context_get_use_es (self->gl_context))
+    {
+      free_data = g_malloc (GSK_GRADIENT_RAMP_WIDTH * n_rows * 4);
+      gdk_memory_convert (free_data, GSK_GRADIENT_RAMP_WIDTH * 4,
+                          GDK_MEMORY_R8G8B8A8_PREMULTIPLIED,
+                          data, GSK_GRADIENT_RAMP_WIDTH * 4,
+                          GDK_MEMORY_DEFAULT, GSK_GRADIENT_RAMP_WIDTH, n_rows);
+      data = free_data;
+      gl_format = GL_RGBA;
+      gl_type = GL_UNSIGNED_BYTE;
+    }
+  else
+    {
+      gl_format = GL_BGRA;
+      gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+    }
+
+  glBindTexture (GL_TEXTURE_2D, self->gradient_ramp_image.texture_id);
+  glTexSubImage2D (GL_TEXTURE_2D, 0, 0, first_row, GSK_GRADIENT_RAMP_WIDTH, n_rows,
+                   gl_format, gl_type, data);
+
+  g_free (free_data);
+  gsk_gradient_ramp_cache_clear_dirty (&self->gradient_ramps);
+}
+
 static inline void
 render_linear_gradient_node (GskGLRenderer   *self,
                              GskRenderNode   *node,
@@ -1448,7 +1830,7 @@ render_linear_gradient_node (GskGLRenderer   *self,
 
       load_vertex_data (ops_draw (builder, NULL), node, builder);
     }
-  else
+  else if (!render_gradient_ramp (self, node, builder))
     {
       render_fallback_node (self, node, builder);
     }
@@ -1492,29 +1874,59 @@ static inline gboolean
 rounded_inner_rect_contains_rect (const GskRoundedRect  *rounded,
                                   const graphene_rect_t *rect)
 {
-  const graphene_rect_t *rounded_bounds = &rounded->bounds;
-  graphene_rect_t inner;
-  float offset_x, offset_y;
+  return gsk_rounded_rect_contains_rect (rounded, rect);
+}
+
+/* Checks whether the rounded rect @inner lies completely inside @outer,
+ * so the intersection of the two is simply @inner. This is the common
+ * case of nested rounded clips, e.g. a frame with rounded corners and
+ * its padding box.
+ */
+static inline gboolean
+rounded_rect_contains_rounded_rect (const GskRoundedRect *outer,
+                                    const GskRoundedRect *inner)
+{
+  const graphene_rect_t *ob = &outer->bounds;
+  const graphene_rect_t *ib = &inner->bounds;
+  float left, right, top, bottom;
+  int i;
+
+  if (!_graphene_rect_contains_rect (ob, ib))
+    return FALSE;
+
+  left = ib->origin.x - ob->origin.x;
+  right = (ob->origin.x + ob->size.width) - (ib->origin.x + ib->size.width);
+  top = ib->origin.y - ob->origin.y;
+  bottom = (ob->origin.y + ob->size.height) - (ib->origin.y + ib->size.height);
+
+  for (i = 0; i < 4; i++)
+    {
+      const graphene_size_t *oc = &outer->corner[i];
+      const graphene_size_t *ic = &inner->corner[i];
+      float dx, dy;
+      float u, v, r;
 
-  /* TODO: This is pretty conservative and we could to further, more
-   *       fine-grained checks to avoid offscreen drawing. */
+      dx = (i == GSK_CORNER_TOP_LEFT || i == GSK_CORNER_BOTTOM_LEFT) ? left : right;
+      dy = (i == GSK_CORNER_TOP_LEFT || i == GSK_CORNER_TOP_RIGHT) ? top : bottom;
 
-  offset_x = MAX (rounded->corner[GSK_CORNER_TOP_LEFT].width,
-                  rounded->corner[GSK_CORNER_BOTTOM_LEFT].width);
-  offset_y = MAX (rounded->corner[GSK_CORNER_TOP_LEFT].height,
-                  rounded->corner[GSK_CORNER_TOP_RIGHT].height);
+      if (oc->width <= 0 || oc->height <= 0)
+        continue;
 
+      /* Not reaching into the corner of the outer rect? */
+      if (dx >= oc->width || dy >= oc->height)
+        continue;
 
-  inner.origin.x = rounded_bounds->origin.x + offset_x;
-  inner.origin.y = rounded_bounds->origin.y + offset_y;
-  inner.size.width = rounded_bounds->size.width - offset_x -
-                     MAX (rounded->corner[GSK_CORNER_TOP_RIGHT].width,
-                          rounded->corner[GSK_CORNER_BOTTOM_RIGHT].width);
-  inner.size.height = rounded_bounds->size.height - offset_y -
-                      MAX (rounded->corner[GSK_CORNER_BOTTOM_LEFT].height,
-                           rounded->corner[GSK_CORNER_BOTTOM_RIGHT].height);
+      /* In a space where the outer corner is a unit circle, the inner
+       * corner must fit inside when rounded up to a circle. */
+      u = (dx + ic->width - oc->width) / oc->width;
+      v = (dy + ic->height - oc->height) / oc->height;
+      r = MAX (ic->width / oc->width, ic->height / oc->height);
 
-  return graphene_rect_contains_rect (&inner, rect);
+      if (sqrtf (u * u + v * v) + r > 1.0f)
+        return FALSE;
+    }
+
+  return TRUE;
 }
 
 /* Current clip is NOT rounded but new one is definitely! */
@@ -1576,9 +1988,11 @@ render_clipped_child (GskGLRenderer         *self,
                       GskRenderNode         *child)
 {
   graphene_rect_t transformed_clip;
+  graphene_rect_t child_bounds;
   GskRoundedRect intersection;
 
   ops_transform_bounds_modelview (builder, clip, &transformed_clip);
+  ops_transform_bounds_modelview (builder, &child->bounds, &child_bounds);
 
   if (builder->clip_is_rectilinear)
     {
@@ -1595,6 +2009,19 @@ render_clipped_child (GskGLRenderer         *self,
                                           builder->current_clip,
                                           &intersection))
     {
+      ops_push_clip (builder, &intersection);
+      gsk_gl_renderer_add_render_ops (self, child, builder);
+      ops_pop_clip (builder);
+    }
+  else if (rounded_inner_rect_contains_rect (builder->current_clip, &child_bounds))
+    {
+      /* The child doesn't reach into the corners of the current clip,
+       * so we only need to clip it to the intersection of the bounds. */
+      memset (&intersection, 0, sizeof (GskRoundedRect));
+      graphene_rect_intersection (&transformed_clip,
+                                  &builder->current_clip->bounds,
+                                  &intersection.bounds);
+
       ops_push_clip (builder, &intersection);
       gsk_gl_renderer_add_render_ops (self, child, builder);
       ops_pop_clip (builder);
@@ -1651,6 +2078,7 @@ render_rounded_clip_node (GskGLRenderer       *self,
   const GskRoundedRect *clip = gsk_rounded_clip_node_peek_clip (node);
   GskRenderNode *child = gsk_rounded_clip_node_get_child (node);
   GskRoundedRect transformed_clip;
+  graphene_rect_t child_bounds;
   gboolean need_offscreen;
   int i;
 
@@ -1682,11 +2110,29 @@ render_rounded_clip_node (GskGLRenderer       *self,
   /* After this point we are really working with a new and a current clip
    * which both have rounded corners. */
 
+  /* If the child doesn't reach into the corners of the new clip,
+   * the new clip has no effect */
+  ops_transform_bounds_modelview (builder, &child->bounds, &child_bounds);
+  if (rounded_inner_rect_contains_rect (&transformed_clip, &child_bounds))
+    {
+      gsk_gl_renderer_add_render_ops (self, child, builder);
+      return;
+    }
+
   if (!ops_has_clip (builder))
     need_offscreen = FALSE;
   else if (rounded_inner_rect_contains_rect (builder->current_clip,
-                                             &transformed_clip.bounds))
+                                             &transformed_clip.bounds) ||
+           rounded_rect_contains_rounded_rect (builder->current_clip,
+                                               &transformed_clip))
     need_offscreen = FALSE;
+  else if (rounded_rect_contains_rounded_rect (&transformed_clip,
+                                               builder->current_clip))
+    {
+      /* The intersection is the current clip */
+      gsk_gl_renderer_add_render_ops (self, child, builder);
+      return;
+    }
   else
     need_offscreen = TRUE;
 
@@ -3225,6 +3671,9 @@ gsk_gl_renderer_dispose (GObject *gobject)
   GskGLRenderer *self = GSK_GL_RENDERER (gobject);
 
   ops_free (&self->op_builder);
+#ifdef G_ENABLE_DEBUG
+  g_clear_pointer (&self->gpu_spans, g_array_unref);
+#endif
 
   G_OBJECT_CLASS (gsk_gl_renderer_parent_class)->dispose (gobject);
 }
@@ -3375,11 +3824,7 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
       INIT_COMMON_UNIFORM_LOCATION (prog, projection);
       INIT_COMMON_UNIFORM_LOCATION (prog, modelview);
     }
-  /* color */
-  INIT_PROGRAM_UNIFORM_LOCATION (color, color);
-
-  /* coloring */
-  INIT_PROGRAM_UNIFORM_LOCATION (coloring, color);
+  /* color and coloring take their color from the vertex data */
 
   /* color matrix */
   INIT_PROGRAM_UNIFORM_LOCATION (color_matrix, color_matrix);
@@ -3545,6 +3990,148 @@ get_icon_cache_for_display (GdkDisplay *display,
   return gsk_gl_icon_cache_ref (icon_cache);
 }
 
+static void
+vertex_arena_init (VertexArena *arena)
+{
+  memset (arena, 0, sizeof (VertexArena));
+
+  arena->persistent = epoxy_is_desktop_gl () &&
+                      (epoxy_gl_version () >= 44 || epoxy_has_gl_extension ("GL_ARB_buffer_storage"));
+
+  glGenVertexArrays (1, &arena->vao_id);
+  glGenBuffers (1, &arena->buffer_id);
+}
+
+static void
+vertex_arena_wait (VertexArena *arena,
+                   guint        segment)
+{
+  if (arena->fences[segment] == NULL)
+    return;
+
+  glClientWaitSync (arena->fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, G_MAXUINT64);
+  glDeleteSync (arena->fences[segment]);
+  arena->fences[segment] = NULL;
+}
+
+static void
+vertex_arena_finish (VertexArena *arena)
+{
+  guint i;
+
+  for (i = 0; i < N_VERTEX_SEGMENTS; i++)
+    vertex_arena_wait (arena, i);
+
+  if (arena->buffer_id != 0)
+    {
+      if (arena->mapped)
+        {
+          glBindBuffer (GL_ARRAY_BUFFER, arena->buffer_id);
+          glUnmapBuffer (GL_ARRAY_BUFFER);
+          glBindBuffer (GL_ARRAY_BUFFER, 0);
+        }
+
+      glDeleteBuffers (1, &arena->buffer_id);
+      glDeleteVertexArrays (1, &arena->vao_id);
+    }
+
+  memset (arena, 0, sizeof (VertexArena));
+}
+
+/* Gets the vertex data to the GPU and points the vertex
+ * attributes at it. Returns the number of bytes streamed. */
+static gsize
+vertex_arena_upload (VertexArena *arena,
+                     const void  *data,
+                     gsize        size)
+{
+  gsize offset = 0;
+
+  glBindVertexArray (arena->vao_id);
+  glBindBuffer (GL_ARRAY_BUFFER, arena->buffer_id);
+
+  if (!arena->persistent)
+    {
+      /* Orphaning the old storage lets the driver pipeline this */
+      glBufferData (GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
+    }
+  else
+    {
+      if (arena->mapped == NULL || size > arena->segment_size)
+        {
+          guint i;
+
+          for (i = 0; i < N_VERTEX_SEGMENTS; i++)
+            vertex_arena_wait (arena, i);
+
+          /* Buffer storage is immutable, so start over with a bigger one */
+          if (arena->mapped)
+            {
+              glUnmapBuffer (GL_ARRAY_BUFFER);
+              glDeleteBuffers (1, &arena->buffer_id);
+              glGenBuffers (1, &arena->buffer_id);
+              glBindBuffer (GL_ARRAY_BUFFER, arena->buffer_id);
+            }
+
+          arena->segment_size = MAX (MIN_VERTEX_SEGMENT_SIZE, arena->segment_size);
+          while (arena->segment_size < size)
+            arena->segment_size *= 2;
+
+          glBufferStorage (GL_ARRAY_BUFFER, arena->segment_size * N_VERTEX_SEGMENTS, NULL,
+                           GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+          arena->mapped = glMapBufferRange (GL_ARRAY_BUFFER, 0, arena->segment_size * N_VERTEX_SEGMENTS,
+                                            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+          arena->segment = 0;
+
+          if (arena->mapped == NULL)
+            {
+              /* Fall back to streaming into a mutable buffer from now on */
+              arena->persistent = FALSE;
+              glDeleteBuffers (1, &arena->buffer_id);
+              glGenBuffers (1, &arena->buffer_id);
+              glBindBuffer (GL_ARRAY_BUFFER, arena->buffer_id);
+              glBufferData (GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
+              goto out;
+            }
+        }
+      else
+        {
+          arena->segment = (arena->segment + 1) % N_VERTEX_SEGMENTS;
+        }
+
+      vertex_arena_wait (arena, arena->segment);
+
+      offset = arena->segment * arena->segment_size;
+      memcpy (arena->mapped + offset, data, size);
+    }
+
+out:
+  /* 0 = position location */
+  glEnableVertexAttribArray (0);
+  glVertexAttribPointer (0, 2, GL_FLOAT, GL_FALSE,
+                         sizeof (GskQuadVertex),
+                         (void *) (offset + G_STRUCT_OFFSET (GskQuadVertex, position)));
+  /* 1 = texture coord location */
+  glEnableVertexAttribArray (1);
+  glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE,
+                         sizeof (GskQuadVertex),
+                         (void *) (offset + G_STRUCT_OFFSET (GskQuadVertex, uv)));
+  /* 2 = color location */
+  glEnableVertexAttribArray (2);
+  glVertexAttribPointer (2, 4, GL_FLOAT, GL_FALSE,
+                         sizeof (GskQuadVertex),
+                         (void *) (offset + G_STRUCT_OFFSET (GskQuadVertex, color)));
+
+  return size;
+}
+
+static void
+vertex_arena_end_draw (VertexArena *arena)
+{
+  if (arena->persistent && arena->mapped)
+    arena->fences[arena->segment] = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
 static gboolean
 gsk_gl_renderer_realize (GskRenderer  *renderer,
                          GdkSurface    *surface,
@@ -3583,6 +4170,9 @@ gsk_gl_renderer_realize (GskRenderer  *renderer,
   self->glyph_cache = get_glyph_cache_for_display (gdk_surface_get_display (surface), self->atlases);
   self->icon_cache = get_icon_cache_for_display (gdk_surface_get_display (surface), self->atlases);
   gsk_gl_shadow_cache_init (&self->shadow_cache);
+  gsk_gradient_ramp_cache_init (&self->gradient_ramps);
+
+  vertex_arena_init (&self->vertex_arena);
 
   gdk_profiler_end_mark (before, "gl renderer realize", NULL);
 
@@ -3605,11 +4195,15 @@ gsk_gl_renderer_unrealize (GskRenderer *renderer)
   ops_reset (&self->op_builder);
   self->op_builder.programs = NULL;
 
+  vertex_arena_finish (&self->vertex_arena);
+
   g_clear_pointer (&self->programs, gsk_gl_renderer_programs_unref);
   g_clear_pointer (&self->glyph_cache, gsk_gl_glyph_cache_unref);
   g_clear_pointer (&self->icon_cache, gsk_gl_icon_cache_unref);
   g_clear_pointer (&self->atlases, gsk_gl_texture_atlases_unref);
   gsk_gl_shadow_cache_free (&self->shadow_cache, self->gl_driver);
+  gsk_gradient_ramp_cache_free (&self->gradient_ramps);
+  self->gradient_ramp_image.texture_id = 0;
 
   g_clear_object (&self->gl_profiler);
   g_clear_object (&self->gl_driver);
@@ -3677,6 +4271,10 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
                                 GskRenderNode   *node,
                                 RenderOpBuilder *builder)
 {
+#ifdef G_ENABLE_DEBUG
+  guint gpu_span = G_MAXUINT;
+#endif
+
   /* This can still happen, even if the render nodes are created using
    * GtkSnapshot, so let's just be safe. */
   if (node_is_invisible (node))
@@ -3696,6 +4294,14 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
       return;
   }
 
+#ifdef G_ENABLE_DEBUG
+  /* Containers and debug nodes don't draw anything themselves */
+  if (gsk_render_node_get_node_type (node) != GSK_CONTAINER_NODE &&
+      gsk_render_node_get_node_type (node) != GSK_DEBUG_NODE)
+    gpu_span = gsk_gl_renderer_begin_gpu_span (self, builder,
+                                               g_type_name_from_instance ((GTypeInstance *) node));
+#endif
+
   switch (gsk_render_node_get_node_type (node))
     {
     case GSK_NOT_A_RENDER_NODE:
@@ -3703,8 +4309,23 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
 
     case GSK_CONTAINER_NODE:
       {
+        graphene_rect_t clip;
+        guint *indices = NULL;
         guint i, p;
 
+        /* Big containers can find the visible children faster */
+        if (ops_untransform_bounds_modelview (builder, &builder->current_clip->bounds, &clip))
+          indices = gsk_container_node_get_children_in_rect (node, &clip, &p);
+
+        if (indices)
+          {
+            for (i = 0; i < p; i ++)
+              gsk_gl_renderer_add_render_ops (self, gsk_container_node_get_child (node, indices[i]), builder);
+
+            g_free (indices);
+            break;
+          }
+
         for (i = 0, p = gsk_container_node_get_n_children (node); i < p; i ++)
           {
             GskRenderNode *child = gsk_container_node_get_child (node, i);
@@ -3818,6 +4439,10 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
         render_fallback_node (self, node, builder);
       }
     }
+
+#ifdef G_ENABLE_DEBUG
+  gsk_gl_renderer_end_gpu_span (self, builder, gpu_span);
+#endif
 }
 
 static gboolean
@@ -3843,6 +4468,9 @@ add_offscreen_ops (GskGLRenderer         *self,
   int filter;
   GskTextureKey key;
   int cached_id;
+#ifdef G_ENABLE_DEBUG
+  guint gpu_span;
+#endif
 
   if (node_is_invisible (child_node))
     {
@@ -3858,7 +4486,7 @@ add_offscreen_ops (GskGLRenderer         *self,
       (flags & FORCE_OFFSCREEN) == 0)
     {
       GdkTexture *texture = gsk_texture_node_get_texture (child_node);
-      upload_texture (self, texture, texture_region_out);
+      upload_texture (self, texture, child_node, builder, texture_region_out);
       *is_offscreen = FALSE;
       return TRUE;
     }
@@ -3906,6 +4534,10 @@ add_offscreen_ops (GskGLRenderer         *self,
                                       width, height,
                                       filter, filter,
                                       &texture_id, &render_target);
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            self->profile_counters.offscreens);
+#endif
   if (gdk_gl_context_has_debug (self->gl_context))
     {
       gdk_gl_context_label_object_printf (self->gl_context, GL_TEXTURE, texture_id,
@@ -3925,6 +4557,10 @@ add_offscreen_ops (GskGLRenderer         *self,
                             width, height
                          ));
 
+#ifdef G_ENABLE_DEBUG
+  gpu_span = gsk_gl_renderer_begin_gpu_span (self, builder, "Offscreen");
+#endif
+
   prev_render_target = ops_set_render_target (builder, render_target);
   /* Clear since we use this rendertarget for the first time */
   ops_begin (builder, OP_CLEAR);
@@ -3975,6 +4611,10 @@ add_offscreen_ops (GskGLRenderer         *self,
   ops_set_projection (builder, &prev_projection);
   ops_set_render_target (builder, prev_render_target);
 
+#ifdef G_ENABLE_DEBUG
+  gsk_gl_renderer_end_gpu_span (self, builder, gpu_span);
+#endif
+
   *is_offscreen = TRUE;
   init_full_texture_region (texture_region_out, texture_id);
 
@@ -3993,30 +4633,27 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
   OpBufferIter iter;
   OpKind kind;
   gpointer ptr;
-  GLuint buffer_id, vao_id;
+  gsize n_bytes G_GNUC_UNUSED;
+  guint n_dropped G_GNUC_UNUSED;
 
 #if DEBUG_OPS
   g_print ("============================================\n");
 #endif
 
-  glGenVertexArrays (1, &vao_id);
-  glBindVertexArray (vao_id);
-
-  glGenBuffers (1, &buffer_id);
-  glBindBuffer (GL_ARRAY_BUFFER, buffer_id);
-
-  glBufferData (GL_ARRAY_BUFFER, vertex_data_size, vertex_data, GL_STATIC_DRAW);
+  n_dropped = ops_optimize (&self->op_builder);
+  GSK_RENDERER_NOTE (GSK_RENDERER (self), OPENGL,
+                     g_message ("Dropped %u of %u ops as redundant",
+                                n_dropped, op_buffer_n_ops (ops_get_buffer (&self->op_builder))));
 
-  /* 0 = position location */
-  glEnableVertexAttribArray (0);
-  glVertexAttribPointer (0, 2, GL_FLOAT, GL_FALSE,
-                         sizeof (GskQuadVertex),
-                         (void *) G_STRUCT_OFFSET (GskQuadVertex, position));
-  /* 1 = texture coord location */
-  glEnableVertexAttribArray (1);
-  glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE,
-                         sizeof (GskQuadVertex),
-                         (void *) G_STRUCT_OFFSET (GskQuadVertex, uv));
+  n_bytes = vertex_arena_upload (&self->vertex_arena, vertex_data, vertex_data_size);
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_add (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            self->profile_counters.vertex_bytes,
+                            n_bytes);
+  gsk_profiler_counter_add (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            self->profile_counters.ops,
+                            op_buffer_n_ops (ops_get_buffer (&self->op_builder)) - n_dropped);
+#endif
 
   op_buffer_iter_init (&iter, ops_get_buffer (&self->op_builder));
   while ((ptr = op_buffer_iter_next (&iter, &kind)))
@@ -4027,6 +4664,7 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
       if (program == NULL &&
           kind != OP_PUSH_DEBUG_GROUP &&
           kind != OP_POP_DEBUG_GROUP &&
+          kind != OP_QUERY_TIMESTAMP &&
           kind != OP_CHANGE_PROGRAM &&
           kind != OP_CHANGE_RENDER_TARGET &&
           kind != OP_CLEAR)
@@ -4176,6 +4814,13 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
           gdk_gl_context_pop_debug_group (self->gl_context);
           break;
 
+        case OP_QUERY_TIMESTAMP:
+          {
+            const OpTimestamp *op = ptr;
+            gsk_gl_profiler_query_timestamp (self->gl_profiler, op->index);
+            break;
+          }
+
         case OP_NONE:
         case OP_LAST:
         default:
@@ -4185,36 +4830,20 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
       OP_PRINT ("\n");
     }
 
-  glDeleteVertexArrays (1, &vao_id);
-  glDeleteBuffers (1, &buffer_id);
+  vertex_arena_end_draw (&self->vertex_arena);
 }
 
+/* Once-per-frame work that has to happen before the first pass of
+ * gsk_gl_renderer_do_render(), however many passes the frame takes
+ */
 static void
-gsk_gl_renderer_do_render (GskRenderer           *renderer,
-                           GskRenderNode         *root,
-                           const graphene_rect_t *viewport,
-                           int                    fbo_id,
-                           int                    scale_factor)
+gsk_gl_renderer_begin_frame (GskGLRenderer *self)
 {
-  GskGLRenderer *self = GSK_GL_RENDERER (renderer);
-  graphene_matrix_t projection;
 #ifdef G_ENABLE_DEBUG
-  GskProfiler *profiler;
-  gint64 gpu_time, cpu_time;
-  gint64 start_time G_GNUC_UNUSED;
+  GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
 #endif
   GPtrArray *removed;
 
-#ifdef G_ENABLE_DEBUG
-  profiler = gsk_renderer_get_profiler (renderer);
-#endif
-
-  if (self->gl_context == NULL)
-    {
-      GSK_RENDERER_NOTE (renderer, OPENGL, g_message ("No valid GL context associated to the renderer"));
-      return;
-    }
-
   g_assert (gsk_gl_driver_in_frame (self->gl_driver));
 
   removed = g_ptr_array_new ();
@@ -4222,8 +4851,54 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   gsk_gl_glyph_cache_begin_frame (self->glyph_cache, self->gl_driver, removed);
   gsk_gl_icon_cache_begin_frame (self->icon_cache, removed);
   gsk_gl_shadow_cache_begin_frame (&self->shadow_cache, self->gl_driver);
+  gsk_gradient_ramp_cache_begin_frame (&self->gradient_ramps);
   g_ptr_array_unref (removed);
 
+#ifdef G_ENABLE_DEBUG
+  gsk_gl_profiler_begin_gpu_region (self->gl_profiler);
+  gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
+#endif
+}
+
+static void
+gsk_gl_renderer_end_frame (GskGLRenderer *self)
+{
+#ifdef G_ENABLE_DEBUG
+  GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+  gint64 gpu_time, cpu_time;
+  gint64 start_time G_GNUC_UNUSED;
+
+  gsk_profiler_counter_inc (profiler, self->profile_counters.frames);
+
+  start_time = gsk_profiler_timer_get_start (profiler, self->profile_timers.cpu_time);
+  cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
+  gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
+
+  gpu_time = gsk_gl_profiler_end_gpu_region (self->gl_profiler);
+  gsk_profiler_timer_set (profiler, self->profile_timers.gpu_time, gpu_time);
+
+  if (self->gpu_spans->len > 0)
+    gsk_gl_renderer_collect_gpu_spans (self);
+
+  gsk_profiler_push_samples (profiler);
+
+  gdk_profiler_add_mark (start_time * 1000, cpu_time * 1000, "GL render", "");
+#endif
+}
+
+/* Renders one pass, clipped to self->render_region if set. Must be
+ * surrounded by gsk_gl_renderer_begin_frame() and _end_frame().
+ */
+static void
+gsk_gl_renderer_do_render (GskRenderer           *renderer,
+                           GskRenderNode         *root,
+                           const graphene_rect_t *viewport,
+                           int                    fbo_id,
+                           int                    scale_factor)
+{
+  GskGLRenderer *self = GSK_GL_RENDERER (renderer);
+  graphene_matrix_t projection;
+
   /* Set up the modelview and projection matrices to fit our viewport */
   init_projection_matrix (&projection, viewport);
   ops_set_projection (&self->op_builder, &projection);
@@ -4266,6 +4941,10 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   gsk_gl_renderer_add_render_ops (self, root, &self->op_builder);
   gdk_gl_context_pop_debug_group (self->gl_context);
 
+  /* The glyphs the ops refer to need to be in their atlases by now */
+  gsk_gl_glyph_cache_upload_pending (self->glyph_cache);
+  upload_gradient_ramps (self);
+
   /* We correctly reset the state everywhere */
   g_assert_cmpint (self->op_builder.current_render_target, ==, fbo_id);
   ops_pop_modelview (&self->op_builder);
@@ -4275,12 +4954,6 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   /*g_message ("Ops: %u", self->render_ops->len);*/
 
   /* Now actually draw things... */
-#ifdef G_ENABLE_DEBUG
-  gsk_gl_profiler_begin_gpu_region (self->gl_profiler);
-  gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
-#endif
-
-  /* Actually do the rendering */
   if (fbo_id != 0)
     glBindFramebuffer (GL_FRAMEBUFFER, fbo_id);
 
@@ -4299,22 +4972,23 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   gdk_gl_context_push_debug_group (self->gl_context, "Rendering ops");
   gsk_gl_renderer_render_ops (self);
   gdk_gl_context_pop_debug_group (self->gl_context);
+}
 
 #ifdef G_ENABLE_DEBUG
-  gsk_profiler_counter_inc (profiler, self->profile_counters.frames);
-
-  start_time = gsk_profiler_timer_get_start (profiler, self->profile_timers.cpu_time);
-  cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
-  gsk_profiler_timer_set (profiler, self->profile_timers.cpu_time, cpu_time);
-
-  gpu_time = gsk_gl_profiler_end_gpu_region (self->gl_profiler);
-  gsk_profiler_timer_set (profiler, self->profile_timers.gpu_time, gpu_time);
-
-  gsk_profiler_push_samples (profiler);
+/* The driver counts uploads with its own profiler; copy the totals
+ * for the frame over, so they show up in the renderer stats
+ */
+static void
+gsk_gl_renderer_collect_upload_stats (GskGLRenderer *self)
+{
+  GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+  gint64 n_uploads, n_bytes;
 
-  gdk_profiler_add_mark (start_time * 1000, cpu_time * 1000, "GL render", "");
-#endif
+  gsk_gl_driver_get_upload_stats (self->gl_driver, &n_uploads, &n_bytes);
+  gsk_profiler_counter_set (profiler, self->profile_counters.texture_uploads, n_uploads);
+  gsk_profiler_counter_set (profiler, self->profile_counters.upload_bytes, n_bytes);
 }
+#endif
 
 static GdkTexture *
 gsk_gl_renderer_render_texture (GskRenderer           *renderer,
@@ -4374,7 +5048,9 @@ gsk_gl_renderer_render_texture (GskRenderer           *renderer,
   glFramebufferTexture (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture_id, 0);
 
   /* Render the actual scene */
+  gsk_gl_renderer_begin_frame (self);
   gsk_gl_renderer_do_render (renderer, root, viewport, fbo_id, 1);
+  gsk_gl_renderer_end_frame (self);
 
   glDeleteFramebuffers (1, &fbo_id);
 
@@ -4439,6 +5115,9 @@ gsk_gl_renderer_render_texture (GskRenderer           *renderer,
                                 NULL, NULL);
 
   gsk_gl_driver_end_frame (self->gl_driver);
+#ifdef G_ENABLE_DEBUG
+  gsk_gl_renderer_collect_upload_stats (self);
+#endif
 
   gdk_gl_context_pop_debug_group (self->gl_context);
 
@@ -4446,6 +5125,114 @@ gsk_gl_renderer_render_texture (GskRenderer           *renderer,
   return texture;
 }
 
+/* Damage regions with more rectangles than this are
+ * rendered in one pass, using their extents. Every pass
+ * streams its vertices into the next vertex segment, so
+ * more passes would wait for the fence of their own frame.
+ */
+#define MAX_DAMAGE_PASSES N_VERTEX_SEGMENTS
+
+/* Splits the damage into rectangles that are rendered in separate
+ * passes, each clipped and scissored to its rectangle. This only
+ * pays off if the rectangles cover a lot less than their extents,
+ * e.g. a blinking cursor and a spinner at opposite ends of the
+ * surface.
+ */
+static cairo_region_t **
+get_render_regions (const cairo_region_t *damage,
+                    const GdkRectangle   *whole_surface,
+                    guint                *n_regions)
+{
+  cairo_region_t **regions;
+  GdkRectangle extents;
+  int n_rects;
+  gint64 area;
+  int i;
+
+  if (cairo_region_contains_rectangle (damage, whole_surface) == CAIRO_REGION_OVERLAP_IN)
+    {
+      *n_regions = 0;
+      return NULL;
+    }
+
+  cairo_region_get_extents (damage, &extents);
+
+  if (gdk_rectangle_equal (&extents, whole_surface))
+    {
+      *n_regions = 0;
+      return NULL;
+    }
+
+  n_rects = cairo_region_num_rectangles (damage);
+  area = 0;
+  for (i = 0; i < n_rects; i++)
+    {
+      GdkRectangle rect;
+
+      cairo_region_get_rectangle (damage, i, &rect);
+      area += (gint64) rect.width * rect.height;
+    }
+
+  if (n_rects == 1 || n_rects > MAX_DAMAGE_PASSES ||
+      area * 2 > (gint64) extents.width * extents.height)
+    {
+      regions = g_new (cairo_region_t *, 1);
+      regions[0] = cairo_region_create_rectangle (&extents);
+      *n_regions = 1;
+      return regions;
+    }
+
+  regions = g_new (cairo_region_t *, n_rects);
+  for (i = 0; i < n_rects; i++)
+    {
+      GdkRectangle rect;
+
+      cairo_region_get_rectangle (damage, i, &rect);
+      regions[i] = cairo_region_create_rectangle (&rect);
+    }
+
+  *n_regions = n_rects;
+  return regions;
+}
+
+/* Puts a translucent overlay on top of the repainted area. The color
+ * changes from frame to frame, so consecutive repaints can be told apart. */
+static GskRenderNode *
+add_repaint_overlay (GskRenderNode        *root,
+                     const cairo_region_t *damage)
+{
+  static guint frame;
+  GskRenderNode *nodes[MAX_DAMAGE_PASSES + 1];
+  GdkRGBA color;
+  GskRenderNode *overlay;
+  int n_rects;
+  int i;
+
+  color = (GdkRGBA) {
+            (frame % 3) == 0, (frame % 3) == 1, (frame % 3) == 2, 0.2
+          };
+  frame++;
+
+  n_rects = MIN (cairo_region_num_rectangles (damage), MAX_DAMAGE_PASSES);
+  nodes[0] = root;
+  for (i = 0; i < n_rects; i++)
+    {
+      GdkRectangle rect;
+
+      cairo_region_get_rectangle (damage, i, &rect);
+      nodes[i + 1] = gsk_color_node_new (&color,
+                                         &GRAPHENE_RECT_INIT (rect.x, rect.y,
+                                                              rect.width, rect.height));
+    }
+
+  overlay = gsk_container_node_new (nodes, n_rects + 1);
+
+  for (i = 1; i <= n_rects; i++)
+    gsk_render_node_unref (nodes[i]);
+
+  return overlay;
+}
+
 static void
 gsk_gl_renderer_render (GskRenderer          *renderer,
                         GskRenderNode        *root,
@@ -4456,6 +5243,9 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
   const cairo_region_t *damage;
   GdkRectangle whole_surface;
   GdkSurface *surface;
+  cairo_region_t **regions;
+  guint n_regions;
+  guint i;
 
   if (self->gl_context == NULL)
     return;
@@ -4477,22 +5267,7 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
                                 update_area);
 
   damage = gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->gl_context));
-
-  if (cairo_region_contains_rectangle (damage, &whole_surface) == CAIRO_REGION_OVERLAP_IN)
-    {
-      self->render_region = NULL;
-    }
-  else
-    {
-      GdkRectangle extents;
-
-      cairo_region_get_extents (damage, &extents);
-
-      if (gdk_rectangle_equal (&extents, &whole_surface))
-        self->render_region = NULL;
-      else
-        self->render_region = cairo_region_create_rectangle (&extents);
-    }
+  regions = get_render_regions (damage, &whole_surface, &n_regions);
 
   gdk_gl_context_make_current (self->gl_context);
 
@@ -4501,9 +5276,41 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
   viewport.size.width = whole_surface.width;
   viewport.size.height = whole_surface.height;
 
+  if (GSK_RENDERER_DEBUG_CHECK (renderer, REPAINTS))
+    root = add_repaint_overlay (root, damage);
+  else
+    gsk_render_node_ref (root);
+
+  GSK_RENDERER_NOTE (renderer, OPENGL,
+                     if (n_regions > 1)
+                       g_message ("Rendering damage in %u passes", n_regions));
+
   gsk_gl_driver_begin_frame (self->gl_driver);
-  gsk_gl_renderer_do_render (renderer, root, &viewport, 0, self->scale_factor);
+  gsk_gl_renderer_begin_frame (self);
+  if (n_regions == 0)
+    {
+      self->render_region = NULL;
+      gsk_gl_renderer_do_render (renderer, root, &viewport, 0, self->scale_factor);
+    }
+  else
+    {
+      for (i = 0; i < n_regions; i++)
+        {
+          self->render_region = regions[i];
+          gsk_gl_renderer_do_render (renderer, root, &viewport, 0, self->scale_factor);
+          ops_reset (&self->op_builder);
+          g_clear_pointer (&regions[i], cairo_region_destroy);
+        }
+      self->render_region = NULL;
+    }
+  gsk_gl_renderer_end_frame (self);
   gsk_gl_driver_end_frame (self->gl_driver);
+#ifdef G_ENABLE_DEBUG
+  gsk_gl_renderer_collect_upload_stats (self);
+#endif
+
+  g_free (regions);
+  gsk_render_node_unref (root);
 
   gsk_gl_renderer_clear_tree (self);
 
@@ -4511,8 +5318,6 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
   gdk_gl_context_make_current (self->gl_context);
 
   gdk_gl_context_pop_debug_group (self->gl_context);
-
-  g_clear_pointer (&self->render_region, cairo_region_destroy);
 }
 
 static void
@@ -4542,9 +5347,19 @@ gsk_gl_renderer_init (GskGLRenderer *self)
     GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
 
     self->profile_counters.frames = gsk_profiler_add_counter (profiler, "frames", "Frames", FALSE);
+    self->profile_counters.vertex_bytes = gsk_profiler_add_counter (profiler, "vertex-bytes", "Vertex data streamed", TRUE);
+    self->profile_counters.offscreens_avoided = gsk_profiler_add_counter (profiler, "opacity-offscreens-avoided", "Opacity offscreens avoided", TRUE);
+    self->profile_counters.offscreens = gsk_profiler_add_counter (profiler, "offscreens", "Offscreens", TRUE);
+    self->profile_counters.glyph_cache_hits = gsk_profiler_add_counter (profiler, "glyph-cache-hits", "Glyph cache hits", TRUE);
+    self->profile_counters.glyph_cache_misses = gsk_profiler_add_counter (profiler, "glyph-cache-misses", "Glyph cache misses", TRUE);
+    self->profile_counters.ops = gsk_profiler_add_counter (profiler, "ops", "Render ops", TRUE);
+    self->profile_counters.texture_uploads = gsk_profiler_add_counter (profiler, "texture-uploads", "Texture uploads", TRUE);
+    self->profile_counters.upload_bytes = gsk_profiler_add_counter (profiler, "upload-bytes", "Texture data uploaded", TRUE);
 
     self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
     self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
+
+    self->gpu_spans = g_array_new (FALSE, FALSE, sizeof (GpuSpan));
   }
 #endif
 }
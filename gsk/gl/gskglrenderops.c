@@ -120,6 +120,16 @@ ops_pop_debug_group (RenderOpBuilder *builder)
   ops_begin (builder, OP_POP_DEBUG_GROUP);
 }
 
+void
+ops_query_timestamp (RenderOpBuilder *builder,
+                     guint            index)
+{
+  OpTimestamp *op;
+
+  op = ops_begin (builder, OP_QUERY_TIMESTAMP);
+  op->index = index;
+}
+
 float
 ops_get_scale (const RenderOpBuilder *builder)
 {
@@ -198,6 +208,35 @@ ops_transform_bounds_modelview (const RenderOpBuilder *builder,
   gsk_transform_transform_bounds (builder->current_modelview, &r, dst);
 }
 
+/* The inverse of ops_transform_bounds_modelview(), fails for
+ * modelviews that are not 2D.
+ */
+gboolean
+ops_untransform_bounds_modelview (const RenderOpBuilder *builder,
+                                  const graphene_rect_t *src,
+                                  graphene_rect_t       *dst)
+{
+  GskTransform *inverse;
+
+  g_assert (builder->mv_stack != NULL);
+  g_assert (builder->mv_stack->len >= 1);
+
+  if (gsk_transform_get_category (builder->current_modelview) < GSK_TRANSFORM_CATEGORY_2D)
+    return FALSE;
+
+  inverse = gsk_transform_invert (gsk_transform_ref (builder->current_modelview));
+  if (inverse == NULL)
+    return FALSE;
+
+  gsk_transform_transform_bounds (inverse, src, dst);
+  gsk_transform_unref (inverse);
+
+  dst->origin.x -= builder->dx;
+  dst->origin.y -= builder->dy;
+
+  return TRUE;
+}
+
 void
 ops_init (RenderOpBuilder *builder)
 {
@@ -617,6 +656,14 @@ ops_set_opacity (RenderOpBuilder *builder,
   return prev_opacity;
 }
 
+static inline gboolean
+program_uses_vertex_color (const RenderOpBuilder *builder,
+                           const Program         *program)
+{
+  return program == &builder->programs->color_program ||
+         program == &builder->programs->coloring_program;
+}
+
 void
 ops_set_color (RenderOpBuilder *builder,
                const GdkRGBA   *color)
@@ -624,6 +671,15 @@ ops_set_color (RenderOpBuilder *builder,
   ProgramState *current_program_state = get_current_program_state (builder);
   OpColor *op;
 
+  /* The color and coloring programs read the color from the vertex
+   * data, so changing it does not need an op and consecutive draws
+   * with different colors end up in the same OP_DRAW. */
+  if (program_uses_vertex_color (builder, builder->current_program))
+    {
+      builder->current_vertex_color = *color;
+      return;
+    }
+
   if (gdk_rgba_equal (color, &current_program_state->color))
     return;
 
@@ -761,10 +817,27 @@ ops_set_border_color (RenderOpBuilder *builder,
   current_program_state->border.color = *color;
 }
 
+static inline void
+stamp_vertex_color (RenderOpBuilder *builder,
+                    GskQuadVertex   *vertices)
+{
+  const GdkRGBA *c = &builder->current_vertex_color;
+  guint i;
+
+  for (i = 0; i < GL_N_VERTICES; i++)
+    {
+      vertices[i].color[0] = c->red;
+      vertices[i].color[1] = c->green;
+      vertices[i].color[2] = c->blue;
+      vertices[i].color[3] = c->alpha;
+    }
+}
+
 GskQuadVertex *
 ops_draw (RenderOpBuilder     *builder,
           const GskQuadVertex  vertex_data[GL_N_VERTICES])
 {
+  GskQuadVertex *vertices;
   OpDraw *op;
 
   if ((op = op_buffer_peek_tail_checked (&builder->render_ops, OP_DRAW)))
@@ -781,11 +854,17 @@ ops_draw (RenderOpBuilder     *builder,
   if (vertex_data)
     {
       g_array_append_vals (builder->vertices, vertex_data, GL_N_VERTICES);
+      vertices = &g_array_index (builder->vertices, GskQuadVertex, builder->vertices->len - GL_N_VERTICES);
+      stamp_vertex_color (builder, vertices);
       return NULL; /* Better not use this on the caller side */
     }
 
   g_array_set_size (builder->vertices, builder->vertices->len + GL_N_VERTICES);
-  return &g_array_index (builder->vertices, GskQuadVertex, builder->vertices->len - GL_N_VERTICES);
+  vertices = &g_array_index (builder->vertices, GskQuadVertex, builder->vertices->len - GL_N_VERTICES);
+  stamp_vertex_color (builder, vertices);
+
+  /* Callers only fill in position and uv */
+  return vertices;
 }
 
 /* The offset is only valid for the current modelview.
@@ -820,6 +899,233 @@ ops_get_buffer (RenderOpBuilder *builder)
   return &builder->render_ops;
 }
 
+/* What the GL side has seen for one program while replaying the ops */
+typedef struct
+{
+  graphene_matrix_t modelview;
+  graphene_matrix_t projection;
+  graphene_rect_t viewport;
+  GskRoundedRect clip;
+  float opacity;
+  guint has_modelview : 1;
+  guint has_projection : 1;
+  guint has_viewport : 1;
+  guint has_clip_bounds : 1;
+  guint has_clip_corners : 1;
+  guint has_opacity : 1;
+} UniformCache;
+
+static inline gboolean
+matrix_equal (const graphene_matrix_t *a,
+              const graphene_matrix_t *b)
+{
+  return memcmp (a, b, sizeof (graphene_matrix_t)) == 0;
+}
+
+/* The builder tracks state per program, but e.g. the modelview and
+ * projection are re-sent on every push/pop and programs are switched
+ * back and forth in tree order. Walk the ops like the renderer will
+ * replay them and drop the ones that would upload a uniform value the
+ * program already has, or rebind the program that is already in use.
+ *
+ * Returns: the number of dropped ops
+ */
+guint
+ops_optimize (RenderOpBuilder *builder)
+{
+  UniformCache caches[GL_N_PROGRAMS] = { 0, };
+  UniformCache *cache = NULL;
+  const Program *program = NULL;
+  graphene_size_t gl_viewport_size = { 0, 0 };
+  gboolean has_gl_viewport = FALSE;
+  OpBufferIter iter;
+  OpKind kind;
+  gpointer ptr;
+  guint n_dropped = 0;
+
+  op_buffer_iter_init (&iter, &builder->render_ops);
+  while ((ptr = op_buffer_iter_next (&iter, &kind)))
+    {
+      /* Ops before the first program change are skipped on replay anyway */
+      if (program == NULL && kind != OP_CHANGE_PROGRAM)
+        continue;
+
+      switch (kind)
+        {
+        case OP_CHANGE_PROGRAM:
+          {
+            const OpProgram *op = ptr;
+
+            if (op->program == program)
+              {
+                op_buffer_iter_drop (&iter);
+                n_dropped++;
+                break;
+              }
+
+            /* Custom programs are not tracked */
+            program = op->program;
+            if (program->index >= 0 && program->index < GL_N_PROGRAMS)
+              cache = &caches[program->index];
+            else
+              cache = NULL;
+          }
+          break;
+
+        case OP_CHANGE_MODELVIEW:
+          {
+            const OpMatrix *op = ptr;
+
+            if (cache == NULL)
+              break;
+
+            if (cache->has_modelview && matrix_equal (&cache->modelview, &op->matrix))
+              {
+                op_buffer_iter_drop (&iter);
+                n_dropped++;
+                break;
+              }
+
+            cache->modelview = op->matrix;
+            cache->has_modelview = TRUE;
+          }
+          break;
+
+        case OP_CHANGE_PROJECTION:
+          {
+            const OpMatrix *op = ptr;
+
+            if (cache == NULL)
+              break;
+
+            if (cache->has_projection && matrix_equal (&cache->projection, &op->matrix))
+              {
+                op_buffer_iter_drop (&iter);
+                n_dropped++;
+                break;
+              }
+
+            cache->projection = op->matrix;
+            cache->has_projection = TRUE;
+          }
+          break;
+
+        case OP_CHANGE_VIEWPORT:
+          {
+            const OpViewport *op = ptr;
+
+            /* Applying the op also changes the global glViewport() */
+            if (cache != NULL &&
+                cache->has_viewport && has_gl_viewport &&
+                rect_equal (&cache->viewport, &op->viewport) &&
+                gl_viewport_size.width == op->viewport.size.width &&
+                gl_viewport_size.height == op->viewport.size.height)
+              {
+                op_buffer_iter_drop (&iter);
+                n_dropped++;
+                break;
+              }
+
+            if (cache != NULL)
+              {
+                cache->viewport = op->viewport;
+                cache->has_viewport = TRUE;
+              }
+            gl_viewport_size = op->viewport.size;
+            has_gl_viewport = TRUE;
+          }
+          break;
+
+        case OP_CHANGE_CLIP:
+          {
+            const OpClip *op = ptr;
+
+            if (cache == NULL)
+              break;
+
+            if (op->send_corners)
+              {
+                if (cache->has_clip_bounds && cache->has_clip_corners &&
+                    rounded_rect_equal (&cache->clip, &op->clip))
+                  {
+                    op_buffer_iter_drop (&iter);
+                    n_dropped++;
+                    break;
+                  }
+
+                cache->clip = op->clip;
+                cache->has_clip_bounds = TRUE;
+                cache->has_clip_corners = TRUE;
+              }
+            else
+              {
+                if (cache->has_clip_bounds &&
+                    rect_equal (&cache->clip.bounds, &op->clip.bounds))
+                  {
+                    op_buffer_iter_drop (&iter);
+                    n_dropped++;
+                    break;
+                  }
+
+                cache->clip.bounds = op->clip.bounds;
+                cache->has_clip_bounds = TRUE;
+              }
+          }
+          break;
+
+        case OP_CHANGE_OPACITY:
+          {
+            const OpOpacity *op = ptr;
+
+            if (cache == NULL)
+              break;
+
+            if (cache->has_opacity && cache->opacity == op->opacity)
+              {
+                op_buffer_iter_drop (&iter);
+                n_dropped++;
+                break;
+              }
+
+            cache->opacity = op->opacity;
+            cache->has_opacity = TRUE;
+          }
+          break;
+
+        case OP_NONE:
+        case OP_CHANGE_COLOR:
+        case OP_CHANGE_RENDER_TARGET:
+        case OP_CHANGE_SOURCE_TEXTURE:
+        case OP_CHANGE_REPEAT:
+        case OP_CHANGE_LINEAR_GRADIENT:
+        case OP_CHANGE_RADIAL_GRADIENT:
+        case OP_CHANGE_COLOR_MATRIX:
+        case OP_CHANGE_BLUR:
+        case OP_CHANGE_INSET_SHADOW:
+        case OP_CHANGE_OUTSET_SHADOW:
+        case OP_CHANGE_BORDER:
+        case OP_CHANGE_BORDER_COLOR:
+        case OP_CHANGE_BORDER_WIDTH:
+        case OP_CHANGE_CROSS_FADE:
+        case OP_CHANGE_UNBLURRED_OUTSET_SHADOW:
+        case OP_CLEAR:
+        case OP_DRAW:
+        case OP_DUMP_FRAMEBUFFER:
+        case OP_PUSH_DEBUG_GROUP:
+        case OP_POP_DEBUG_GROUP:
+        case OP_QUERY_TIMESTAMP:
+        case OP_CHANGE_BLEND:
+        case OP_CHANGE_GL_SHADER_ARGS:
+        case OP_CHANGE_EXTRA_SOURCE_TEXTURE:
+        case OP_LAST:
+        default:
+          break;
+        }
+    }
+
+  return n_dropped;
+}
+
 void
 ops_set_inset_shadow (RenderOpBuilder      *self,
                       const GskRoundedRect  outline,
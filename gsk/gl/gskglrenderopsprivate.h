@@ -209,6 +209,9 @@ typedef struct
   graphene_matrix_t current_projection;
   graphene_rect_t current_viewport;
   float current_opacity;
+  /* Stamped into the vertices of every draw, for the programs
+   * that take their color per vertex instead of as a uniform */
+  GdkRGBA current_vertex_color;
   float dx, dy;
   float scale_x, scale_y;
 
@@ -239,6 +242,8 @@ void              ops_reset              (RenderOpBuilder         *builder);
 void              ops_push_debug_group    (RenderOpBuilder         *builder,
                                            const char              *text);
 void              ops_pop_debug_group     (RenderOpBuilder         *builder);
+void              ops_query_timestamp     (RenderOpBuilder         *builder,
+                                           guint                    index);
 
 void              ops_finish             (RenderOpBuilder         *builder);
 void              ops_push_modelview     (RenderOpBuilder         *builder,
@@ -259,6 +264,9 @@ gboolean          ops_has_clip           (RenderOpBuilder         *builder);
 void              ops_transform_bounds_modelview (const RenderOpBuilder *builder,
                                                   const graphene_rect_t *src,
                                                   graphene_rect_t       *dst);
+gboolean          ops_untransform_bounds_modelview (const RenderOpBuilder *builder,
+                                                    const graphene_rect_t *src,
+                                                    graphene_rect_t       *dst);
 
 graphene_matrix_t ops_set_projection     (RenderOpBuilder         *builder,
                                           const graphene_matrix_t *projection);
@@ -333,6 +341,8 @@ void              ops_offset             (RenderOpBuilder        *builder,
                                           float                   x,
                                           float                   y);
 
+guint             ops_optimize           (RenderOpBuilder        *builder);
+
 gpointer          ops_begin              (RenderOpBuilder        *builder,
                                           OpKind                  kind);
 OpBuffer         *ops_get_buffer         (RenderOpBuilder        *builder);
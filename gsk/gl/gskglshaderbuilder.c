@@ -6,6 +6,30 @@
 
 #include <gdk/gdk.h>
 #include <epoxy/gl.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+
+static gboolean
+program_binaries_supported (void)
+{
+  int n_formats = 0;
+
+  if (g_getenv ("GSK_NO_PROGRAM_CACHE"))
+    return FALSE;
+
+  if (epoxy_is_desktop_gl ())
+    {
+      if (epoxy_gl_version () < 41 && !epoxy_has_gl_extension ("GL_ARB_get_program_binary"))
+        return FALSE;
+    }
+  else if (epoxy_gl_version () < 30)
+    return FALSE;
+
+  /* Some drivers support the API, but no formats */
+  glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+
+  return n_formats > 0;
+}
 
 void
 gsk_gl_shader_builder_init (GskGLShaderBuilder *self,
@@ -22,6 +46,8 @@ gsk_gl_shader_builder_init (GskGLShaderBuilder *self,
   g_assert (self->preamble);
   g_assert (self->vs_preamble);
   g_assert (self->fs_preamble);
+
+  self->cache_programs = program_binaries_supported ();
 }
 
 void
@@ -126,6 +152,133 @@ print_shader_info (const char *prefix,
     }
 }
 
+#define PROGRAM_BINARY_MAGIC 0x47534b50 /* "GSKP" */
+
+typedef struct
+{
+  guint32 magic;
+  guint32 format;
+} ProgramBinaryHeader;
+
+/* The binary is only good for the exact same driver and sources */
+static char *
+get_program_binary_path (const char  **vertex_sources,
+                         const int    *vertex_lengths,
+                         int           n_vertex_sources,
+                         const char  **fragment_sources,
+                         const int    *fragment_lengths,
+                         int           n_fragment_sources)
+{
+  GChecksum *checksum;
+  char *dir;
+  char *basename;
+  char *path;
+  int i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  g_checksum_update (checksum, glGetString (GL_VENDOR), -1);
+  g_checksum_update (checksum, glGetString (GL_RENDERER), -1);
+  g_checksum_update (checksum, glGetString (GL_VERSION), -1);
+
+  for (i = 0; i < n_vertex_sources; i++)
+    g_checksum_update (checksum, (const guchar *) vertex_sources[i], vertex_lengths[i]);
+
+  /* Don't let a source move between the shaders unnoticed */
+  g_checksum_update (checksum, (const guchar *) "\0", 1);
+
+  for (i = 0; i < n_fragment_sources; i++)
+    g_checksum_update (checksum, (const guchar *) fragment_sources[i], fragment_lengths[i]);
+
+  basename = g_strdup_printf ("%s.bin", g_checksum_get_string (checksum));
+  dir = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gsk-programs", NULL);
+  path = g_build_filename (dir, basename, NULL);
+
+  g_free (basename);
+  g_free (dir);
+  g_checksum_free (checksum);
+
+  return path;
+}
+
+static int
+load_program_binary (const char *path)
+{
+  ProgramBinaryHeader header;
+  char *contents;
+  gsize length;
+  int program_id;
+  int status;
+
+  if (!g_file_get_contents (path, &contents, &length, NULL))
+    return -1;
+
+  if (length <= sizeof (header))
+    goto fail;
+
+  memcpy (&header, contents, sizeof (header));
+  if (header.magic != PROGRAM_BINARY_MAGIC)
+    goto fail;
+
+  program_id = glCreateProgram ();
+  glProgramBinary (program_id, header.format,
+                   contents + sizeof (header), length - sizeof (header));
+
+  /* The driver may reject binaries at any time, e.g. after an update */
+  glGetProgramiv (program_id, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE)
+    {
+      glDeleteProgram (program_id);
+      goto fail;
+    }
+
+  g_free (contents);
+
+  return program_id;
+
+fail:
+  GSK_NOTE (SHADERS, g_message ("Discarding program binary %s", path));
+  g_unlink (path);
+  g_free (contents);
+
+  return -1;
+}
+
+static void
+save_program_binary (int         program_id,
+                     const char *path)
+{
+  ProgramBinaryHeader header;
+  GError *error = NULL;
+  char *dir;
+  char *contents;
+  int length = 0;
+  GLenum format;
+
+  glGetProgramiv (program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  contents = g_malloc (sizeof (header) + length);
+  glGetProgramBinary (program_id, length, &length, &format, contents + sizeof (header));
+
+  header.magic = PROGRAM_BINARY_MAGIC;
+  header.format = format;
+  memcpy (contents, &header, sizeof (header));
+
+  dir = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dir, 0755) != 0 ||
+      !g_file_set_contents (path, contents, sizeof (header) + length, &error))
+    {
+      GSK_NOTE (SHADERS, g_message ("Failed to save program binary %s: %s",
+                                    path, error ? error->message : g_strerror (errno)));
+      g_clear_error (&error);
+    }
+
+  g_free (dir);
+  g_free (contents);
+}
+
 int
 gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
                                       const char          *resource_path,
@@ -139,10 +292,16 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   const char *source;
   const char *vertex_shader_start;
   const char *fragment_shader_start;
+  const char *vertex_sources[8];
+  int vertex_lengths[8];
+  const char *fragment_sources[9];
+  int fragment_lengths[9];
+  char *binary_path = NULL;
   int vertex_id;
   int fragment_id;
   int program_id = -1;
   int status;
+  int i;
 
   g_assert (source_bytes);
 
@@ -160,28 +319,43 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   g_snprintf (version_buffer, sizeof (version_buffer),
               "#version %d\n", self->version);
 
+  vertex_sources[0] = version_buffer;
+  vertex_sources[1] = self->debugging ? "#define GSK_DEBUG 1\n" : "";
+  vertex_sources[2] = self->legacy ? "#define GSK_LEGACY 1\n" : "";
+  vertex_sources[3] = self->gl3 ? "#define GSK_GL3 1\n" : "";
+  vertex_sources[4] = self->gles ? "#define GSK_GLES 1\n" : "";
+  vertex_sources[5] = g_bytes_get_data (self->preamble, NULL);
+  vertex_sources[6] = g_bytes_get_data (self->vs_preamble, NULL);
+  vertex_sources[7] = vertex_shader_start;
+
+  for (i = 0; i < 7; i++)
+    vertex_lengths[i] = strlen (vertex_sources[i]);
+  vertex_lengths[7] = fragment_shader_start - vertex_shader_start;
+
+  memcpy (fragment_sources, vertex_sources, 5 * sizeof (char *));
+  fragment_sources[5] = g_bytes_get_data (self->preamble, NULL);
+  fragment_sources[6] = g_bytes_get_data (self->fs_preamble, NULL);
+  fragment_sources[7] = fragment_shader_start;
+  fragment_sources[8] = extra_fragment_snippet ? extra_fragment_snippet : "";
+
+  for (i = 0; i < 8; i++)
+    fragment_lengths[i] = strlen (fragment_sources[i]);
+  fragment_lengths[8] = extra_fragment_snippet ? extra_fragment_length : 0;
+
+  if (self->cache_programs)
+    {
+      binary_path = get_program_binary_path (vertex_sources, vertex_lengths, 8,
+                                             fragment_sources, fragment_lengths, 9);
+      program_id = load_program_binary (binary_path);
+      if (program_id >= 0)
+        {
+          GSK_NOTE (SHADERS, g_message ("Loaded program %s from %s", resource_path, binary_path));
+          goto out;
+        }
+    }
+
   vertex_id = glCreateShader (GL_VERTEX_SHADER);
-  glShaderSource (vertex_id, 8,
-                  (const char *[]) {
-                    version_buffer,
-                    self->debugging ? "#define GSK_DEBUG 1\n" : "",
-                    self->legacy ? "#define GSK_LEGACY 1\n" : "",
-                    self->gl3 ? "#define GSK_GL3 1\n" : "",
-                    self->gles ? "#define GSK_GLES 1\n" : "",
-                    g_bytes_get_data (self->preamble, NULL),
-                    g_bytes_get_data (self->vs_preamble, NULL),
-                    vertex_shader_start
-                  },
-                  (int[]) {
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    fragment_shader_start - vertex_shader_start
-                  });
+  glShaderSource (vertex_id, 8, vertex_sources, vertex_lengths);
   glCompileShader (vertex_id);
 
   if (!check_shader_error (vertex_id, error))
@@ -193,29 +367,7 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   print_shader_info ("Vertex shader", vertex_id, resource_path);
 
   fragment_id = glCreateShader (GL_FRAGMENT_SHADER);
-  glShaderSource (fragment_id, 9,
-                  (const char *[]) {
-                    version_buffer,
-                    self->debugging ? "#define GSK_DEBUG 1\n" : "",
-                    self->legacy ? "#define GSK_LEGACY 1\n" : "",
-                    self->gl3 ? "#define GSK_GL3 1\n" : "",
-                    self->gles ? "#define GSK_GLES 1\n" : "",
-                    g_bytes_get_data (self->preamble, NULL),
-                    g_bytes_get_data (self->fs_preamble, NULL),
-                    fragment_shader_start,
-                    extra_fragment_snippet ? extra_fragment_snippet : ""
-                  },
-                  (int[]) {
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    extra_fragment_length,
-                  });
+  glShaderSource (fragment_id, 9, fragment_sources, fragment_lengths);
   glCompileShader (fragment_id);
 
   if (!check_shader_error (fragment_id, error))
@@ -229,6 +381,16 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   program_id = glCreateProgram ();
   glAttachShader (program_id, vertex_id);
   glAttachShader (program_id, fragment_id);
+
+  /* The renderer sets up a single vertex layout for all programs,
+   * so make sure every program agrees on the attribute locations. */
+  glBindAttribLocation (program_id, 0, "aPosition");
+  glBindAttribLocation (program_id, 1, "aUv");
+  glBindAttribLocation (program_id, 2, "aColor");
+
+  if (self->cache_programs)
+    glProgramParameteri (program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
   glLinkProgram (program_id);
 
   glGetProgramiv (program_id, GL_LINK_STATUS, &status);
@@ -260,9 +422,12 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   glDetachShader (program_id, fragment_id);
   glDeleteShader (fragment_id);
 
+  if (binary_path)
+    save_program_binary (program_id, binary_path);
+
 out:
+  g_free (binary_path);
   g_bytes_unref (source_bytes);
 
   return program_id;
 }
-
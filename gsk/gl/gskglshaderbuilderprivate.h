@@ -18,6 +18,7 @@ typedef struct
   guint gles: 1;
   guint gl3: 1;
   guint legacy: 1;
+  guint cache_programs: 1; /* Keep program binaries in the user cache dir */
 
 } GskGLShaderBuilder;
 
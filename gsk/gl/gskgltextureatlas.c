@@ -7,6 +7,7 @@
 
 #define ATLAS_SIZE (512)
 #define MAX_OLD_RATIO 0.5
+#define MAX_COMPACT_FRAMES 30 /* Drop a compacting atlas after this many frames */
 
 static void
 free_atlas (gpointer v)
@@ -83,11 +84,26 @@ gsk_gl_texture_atlases_begin_frame (GskGLTextureAtlases *self,
     {
       GskGLTextureAtlas *atlas = g_ptr_array_index (self->atlases, i);
 
-      if (gsk_gl_texture_atlas_get_unused_ratio (atlas) > MAX_OLD_RATIO)
+      if (!atlas->compacting)
+        {
+          /* Stop packing new items onto the atlas and let the caches
+           * move what is still in use elsewhere, so we don't have to
+           * render and upload it all again. */
+          if (gsk_gl_texture_atlas_get_unused_ratio (atlas) > MAX_OLD_RATIO)
+            {
+              GSK_NOTE(GLYPH_CACHE,
+                       g_message ("Compacting atlas %d (%g.2%% old)", i,
+                                  100.0 * gsk_gl_texture_atlas_get_unused_ratio (atlas)));
+              atlas->compacting = TRUE;
+            }
+
+          continue;
+        }
+
+      if (atlas->n_items <= 0 || ++atlas->compact_frames > MAX_COMPACT_FRAMES)
         {
           GSK_NOTE(GLYPH_CACHE,
-                   g_message ("Dropping atlas %d (%g.2%% old)", i,
-                              100.0 * gsk_gl_texture_atlas_get_unused_ratio (atlas)));
+                   g_message ("Dropping atlas %d (%d items left)", i, atlas->n_items));
 
           if (atlas->texture_id != 0)
             {
@@ -151,7 +167,8 @@ gsk_gl_texture_atlases_pack (GskGLTextureAtlases *self,
     {
       atlas = g_ptr_array_index (self->atlases, i);
 
-      if (gsk_gl_texture_atlas_pack (atlas, width, height, &x, &y))
+      if (!atlas->compacting &&
+          gsk_gl_texture_atlas_pack (atlas, width, height, &x, &y))
         break;
 
       atlas = NULL;
@@ -172,6 +189,8 @@ gsk_gl_texture_atlases_pack (GskGLTextureAtlases *self,
       GSK_NOTE(GLYPH_CACHE, g_message ("adding new atlas"));
     }
 
+  atlas->n_items++;
+
   *atlas_out = atlas;
   *out_x = x;
   *out_y = y;
@@ -179,6 +198,77 @@ gsk_gl_texture_atlases_pack (GskGLTextureAtlases *self,
   return TRUE;
 }
 
+/* Moves the given (padded) rect of a compacting atlas to a new
+ * location, copying the pixels on the GPU.
+ */
+gboolean
+gsk_gl_texture_atlases_move (GskGLTextureAtlases *self,
+                             GskGLTextureAtlas   *atlas,
+                             int                  x,
+                             int                  y,
+                             int                  width,
+                             int                  height,
+                             GskGLTextureAtlas  **atlas_out,
+                             int                 *out_x,
+                             int                 *out_y)
+{
+  GskGLTextureAtlas *new_atlas;
+  int new_x, new_y;
+  int old_framebuffer;
+  guint framebuffer;
+
+  g_assert (atlas->compacting);
+
+  if (atlas->texture_id == 0)
+    return FALSE;
+
+  gsk_gl_texture_atlases_pack (self, width, height, &new_atlas, &new_x, &new_y);
+
+  /* Framebuffers are not shared between contexts, so we can't keep this around */
+  glGetIntegerv (GL_FRAMEBUFFER_BINDING, &old_framebuffer);
+  glGenFramebuffers (1, &framebuffer);
+  glBindFramebuffer (GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas->texture_id, 0);
+
+  glBindTexture (GL_TEXTURE_2D, new_atlas->texture_id);
+  glCopyTexSubImage2D (GL_TEXTURE_2D, 0, new_x, new_y, x, y, width, height);
+
+  glBindFramebuffer (GL_FRAMEBUFFER, old_framebuffer);
+  glDeleteFramebuffers (1, &framebuffer);
+
+  gsk_gl_texture_atlases_release (self, atlas);
+
+  *atlas_out = new_atlas;
+  *out_x = new_x;
+  *out_y = new_y;
+
+  return TRUE;
+}
+
+gboolean
+gsk_gl_texture_atlases_is_compacting (GskGLTextureAtlases *self)
+{
+  int i;
+
+  for (i = 0; i < self->atlases->len; i++)
+    {
+      GskGLTextureAtlas *atlas = g_ptr_array_index (self->atlases, i);
+
+      if (atlas->compacting)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Called by the caches when they drop an item from a compacting atlas */
+void
+gsk_gl_texture_atlases_release (GskGLTextureAtlases *self,
+                                GskGLTextureAtlas   *atlas)
+{
+  atlas->n_items--;
+}
+
 void
 gsk_gl_texture_atlas_init (GskGLTextureAtlas *self,
                            int                width,
@@ -19,6 +19,13 @@ struct _GskGLTextureAtlas
   int unused_pixels; /* Pixels of rects that have been used at some point,
                         But are now unused. */
 
+  int n_items; /* Cache entries currently living on this atlas */
+
+  /* Once too much of the atlas is unused, the caches move their live
+   * entries to other atlases over a few frames, then the atlas is dropped. */
+  int compact_frames;
+  guint compacting : 1;
+
   void *user_data;
 };
 typedef struct _GskGLTextureAtlas GskGLTextureAtlas;
@@ -43,6 +50,18 @@ gboolean             gsk_gl_texture_atlases_pack        (GskGLTextureAtlases *at
                                                          GskGLTextureAtlas  **atlas_out,
                                                          int                 *out_x,
                                                          int                 *out_y);
+gboolean             gsk_gl_texture_atlases_move        (GskGLTextureAtlases *atlases,
+                                                         GskGLTextureAtlas   *atlas,
+                                                         int                  x,
+                                                         int                  y,
+                                                         int                  width,
+                                                         int                  height,
+                                                         GskGLTextureAtlas  **atlas_out,
+                                                         int                 *out_x,
+                                                         int                 *out_y);
+gboolean             gsk_gl_texture_atlases_is_compacting (GskGLTextureAtlases *atlases);
+void                 gsk_gl_texture_atlases_release         (GskGLTextureAtlases *atlases,
+                                                         GskGLTextureAtlas   *atlas);
 
 void        gsk_gl_texture_atlas_init              (GskGLTextureAtlas       *self,
                                                     int                      width,
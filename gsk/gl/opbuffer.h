@@ -41,6 +41,7 @@ typedef enum
   OP_CHANGE_BLEND                      = 27,
   OP_CHANGE_GL_SHADER_ARGS             = 28,
   OP_CHANGE_EXTRA_SOURCE_TEXTURE       = 29,
+  OP_QUERY_TIMESTAMP                   = 30,
   OP_LAST
 } OpKind;
 
@@ -194,6 +195,11 @@ typedef struct
   char text[64];
 } OpDebugGroup;
 
+typedef struct
+{
+  guint index;
+} OpTimestamp;
+
 typedef struct
 {
   int source2;
@@ -252,6 +258,20 @@ op_buffer_iter_next (OpBufferIter *iter,
   return &iter->buffer->buf[entry->pos];
 }
 
+/* Turns the op last returned by op_buffer_iter_next() into
+ * an OP_NONE, which is skipped when replaying the buffer.
+ */
+static inline void
+op_buffer_iter_drop (OpBufferIter *iter)
+{
+  OpBufferEntry *entry;
+
+  g_assert (iter->pos > 1);
+
+  entry = &g_array_index (iter->index, OpBufferEntry, iter->pos - 1);
+  entry->kind = OP_NONE;
+}
+
 static inline void
 op_buffer_pop_tail (OpBuffer *buffer)
 {
@@ -185,6 +185,342 @@ flip_buffer (guchar *dst_buffer,
 #undef BLOCK_SIZE
 }
 
+/* SIMD versions of the box blur.
+ *
+ * The sliding window of blur_xspan() is inherently serial along a row,
+ * so instead of vectorizing along the row, these blur N adjacent
+ * columns at once, walking down the rows. The horizontal pass is done
+ * by transposing the buffer and running the same column pass on it.
+ *
+ * The division is done by multiplying with a fixed point reciprocal,
+ * which is chosen so that the result is exactly the same as the
+ * integer division in blur_xspan(). For box sizes where no such
+ * reciprocal fits in 16 bits we use the scalar code.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_BLUR_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define HAVE_BLUR_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef struct
+{
+  guint16 multiplier;
+  int shift;
+} Divider;
+
+typedef void (* BlurSpanFunc) (const guchar  *src,
+                               guchar        *dst,
+                               int            height,
+                               int            d,
+                               int            shift,
+                               const Divider *divider);
+
+typedef struct
+{
+  const char *name;
+  int n_columns;
+  BlurSpanFunc blur_span;
+} BlurImpl;
+
+/* Finds m and t so that (x * m) >> (16 + t) == x / d for all the
+ * x that can show up when dividing the sum of d bytes, rounded.
+ */
+static gboolean
+divider_init (Divider *divider,
+              int      d)
+{
+  /* (255 * d + d / 2) is the biggest sum + rounding */
+  guint64 max_x = 256 * d - 1;
+  int t;
+
+  if (d < 1 || d > 255)
+    return FALSE;
+
+  for (t = 0; t <= 8; t++)
+    {
+      guint64 one = G_GUINT64_CONSTANT (1) << (16 + t);
+      guint64 m = (one + d - 1) / d;
+
+      if (m > G_MAXUINT16)
+        return FALSE;
+
+      /* floor (x * m / one) is exact as long as x * (m * d - one) < one */
+      if (max_x * (m * d - one) < one)
+        {
+          divider->multiplier = m;
+          divider->shift = t;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+static inline int
+span_offset (int d,
+             int shift)
+{
+  if (d % 2 == 1)
+    return d / 2;
+  else
+    return (d - shift) / 2;
+}
+
+#ifdef HAVE_BLUR_X86
+
+#ifdef __i386__
+__attribute__((target ("sse2")))
+#endif
+static void
+blur_span_sse2 (const guchar  *src,
+                guchar        *dst,
+                int            height,
+                int            d,
+                int            shift,
+                const Divider *divider)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i round = _mm_set1_epi16 (d / 2);
+  const __m128i multiplier = _mm_set1_epi16 ((short) divider->multiplier);
+  const __m128i count = _mm_cvtsi32_si128 (divider->shift);
+  __m128i sum_lo = zero, sum_hi = zero;
+  int offset = span_offset (d, shift);
+  int i;
+
+  for (i = -d + offset; i < height + offset; i++)
+    {
+      if (i >= 0 && i < height)
+        {
+          __m128i v = _mm_loadu_si128 ((const __m128i *) (src + i * 16));
+
+          sum_lo = _mm_add_epi16 (sum_lo, _mm_unpacklo_epi8 (v, zero));
+          sum_hi = _mm_add_epi16 (sum_hi, _mm_unpackhi_epi8 (v, zero));
+        }
+
+      if (i >= offset)
+        {
+          __m128i lo, hi;
+
+          if (i >= d)
+            {
+              __m128i v = _mm_loadu_si128 ((const __m128i *) (src + (i - d) * 16));
+
+              sum_lo = _mm_sub_epi16 (sum_lo, _mm_unpacklo_epi8 (v, zero));
+              sum_hi = _mm_sub_epi16 (sum_hi, _mm_unpackhi_epi8 (v, zero));
+            }
+
+          lo = _mm_srl_epi16 (_mm_mulhi_epu16 (_mm_add_epi16 (sum_lo, round), multiplier), count);
+          hi = _mm_srl_epi16 (_mm_mulhi_epu16 (_mm_add_epi16 (sum_hi, round), multiplier), count);
+          _mm_storeu_si128 ((__m128i *) (dst + (i - offset) * 16), _mm_packus_epi16 (lo, hi));
+        }
+    }
+}
+
+__attribute__((target ("avx2")))
+static void
+blur_span_avx2 (const guchar  *src,
+                guchar        *dst,
+                int            height,
+                int            d,
+                int            shift,
+                const Divider *divider)
+{
+  const __m256i round = _mm256_set1_epi16 (d / 2);
+  const __m256i multiplier = _mm256_set1_epi16 ((short) divider->multiplier);
+  const __m128i count = _mm_cvtsi32_si128 (divider->shift);
+  __m256i sum_lo = _mm256_setzero_si256 ();
+  __m256i sum_hi = _mm256_setzero_si256 ();
+  int offset = span_offset (d, shift);
+  int i;
+
+  for (i = -d + offset; i < height + offset; i++)
+    {
+      if (i >= 0 && i < height)
+        {
+          const guchar *p = src + i * 32;
+
+          sum_lo = _mm256_add_epi16 (sum_lo, _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) p)));
+          sum_hi = _mm256_add_epi16 (sum_hi, _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (p + 16))));
+        }
+
+      if (i >= offset)
+        {
+          __m256i lo, hi;
+
+          if (i >= d)
+            {
+              const guchar *p = src + (i - d) * 32;
+
+              sum_lo = _mm256_sub_epi16 (sum_lo, _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) p)));
+              sum_hi = _mm256_sub_epi16 (sum_hi, _mm256_cvtepu8_epi16 (_mm_loadu_si128 ((const __m128i *) (p + 16))));
+            }
+
+          lo = _mm256_srl_epi16 (_mm256_mulhi_epu16 (_mm256_add_epi16 (sum_lo, round), multiplier), count);
+          hi = _mm256_srl_epi16 (_mm256_mulhi_epu16 (_mm256_add_epi16 (sum_hi, round), multiplier), count);
+          /* packus works per 128 bit lane, put the quarters back in order */
+          _mm256_storeu_si256 ((__m256i *) (dst + (i - offset) * 32),
+                               _mm256_permute4x64_epi64 (_mm256_packus_epi16 (lo, hi), 0xD8));
+        }
+    }
+}
+
+#endif /* HAVE_BLUR_X86 */
+
+#ifdef HAVE_BLUR_NEON
+
+static inline uint16x8_t
+divide_neon (uint16x8_t       sum,
+             uint16x8_t       round,
+             uint16x4_t       multiplier,
+             int32x4_t        shift)
+{
+  uint16x8_t x = vaddq_u16 (sum, round);
+  uint32x4_t lo = vshlq_u32 (vmull_u16 (vget_low_u16 (x), multiplier), shift);
+  uint32x4_t hi = vshlq_u32 (vmull_u16 (vget_high_u16 (x), multiplier), shift);
+
+  return vcombine_u16 (vmovn_u32 (lo), vmovn_u32 (hi));
+}
+
+static void
+blur_span_neon (const guchar  *src,
+                guchar        *dst,
+                int            height,
+                int            d,
+                int            shift,
+                const Divider *divider)
+{
+  const uint16x8_t round = vdupq_n_u16 (d / 2);
+  const uint16x4_t multiplier = vdup_n_u16 (divider->multiplier);
+  const int32x4_t count = vdupq_n_s32 (- (16 + divider->shift));
+  uint16x8_t sum_lo = vdupq_n_u16 (0);
+  uint16x8_t sum_hi = vdupq_n_u16 (0);
+  int offset = span_offset (d, shift);
+  int i;
+
+  for (i = -d + offset; i < height + offset; i++)
+    {
+      if (i >= 0 && i < height)
+        {
+          uint8x16_t v = vld1q_u8 (src + i * 16);
+
+          sum_lo = vaddw_u8 (sum_lo, vget_low_u8 (v));
+          sum_hi = vaddw_u8 (sum_hi, vget_high_u8 (v));
+        }
+
+      if (i >= offset)
+        {
+          uint16x8_t lo, hi;
+
+          if (i >= d)
+            {
+              uint8x16_t v = vld1q_u8 (src + (i - d) * 16);
+
+              sum_lo = vsubw_u8 (sum_lo, vget_low_u8 (v));
+              sum_hi = vsubw_u8 (sum_hi, vget_high_u8 (v));
+            }
+
+          lo = divide_neon (sum_lo, round, multiplier, count);
+          hi = divide_neon (sum_hi, round, multiplier, count);
+          vst1q_u8 (dst + (i - offset) * 16, vcombine_u8 (vqmovn_u16 (lo), vqmovn_u16 (hi)));
+        }
+    }
+}
+
+#endif /* HAVE_BLUR_NEON */
+
+static const BlurImpl *
+get_blur_impl (void)
+{
+  static const BlurImpl *impl;
+
+  if (g_once_init_enter (&impl))
+    {
+      static const BlurImpl impls[] = {
+        { "scalar", 0, NULL },
+#ifdef HAVE_BLUR_X86
+        { "sse2", 16, blur_span_sse2 },
+        { "avx2", 32, blur_span_avx2 },
+#endif
+#ifdef HAVE_BLUR_NEON
+        { "neon", 16, blur_span_neon },
+#endif
+      };
+      const BlurImpl *result = &impls[0];
+
+#ifdef HAVE_BLUR_X86
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+        result = &impls[2];
+      else if (__builtin_cpu_supports ("sse2"))
+        result = &impls[1];
+#endif
+#ifdef HAVE_BLUR_NEON
+      result = &impls[1];
+#endif
+
+      g_once_init_leave (&impl, result);
+    }
+
+  return impl;
+}
+
+/* Blurs all columns of the buffer in blocks of impl->n_columns, copying
+ * each block into a contiguous scratch area first so the kernels only
+ * ever touch memory that is hot in the cache.
+ */
+static void
+blur_columns (const BlurImpl *impl,
+              guchar         *buffer,
+              int             width,
+              int             height,
+              int             d,
+              const Divider  *divider,
+              const Divider  *divider_plus_one)
+{
+  int n = impl->n_columns;
+  guchar *scratch;
+  guchar *a, *b;
+  int x, y;
+
+  scratch = g_malloc (2 * n * height);
+  a = scratch;
+  b = scratch + n * height;
+
+  for (x = 0; x < width; x += n)
+    {
+      int n_columns = MIN (n, width - x);
+
+      for (y = 0; y < height; y++)
+        {
+          memcpy (a + y * n, buffer + y * width + x, n_columns);
+          if (n_columns < n)
+            memset (a + y * n + n_columns, 0, n - n_columns);
+        }
+
+      /* Same as blur_rows() */
+      if (d % 2 == 1)
+        {
+          impl->blur_span (a, b, height, d, 0, divider);
+          impl->blur_span (b, a, height, d, 0, divider);
+          impl->blur_span (a, b, height, d, 0, divider);
+        }
+      else
+        {
+          impl->blur_span (a, b, height, d, 1, divider);
+          impl->blur_span (b, a, height, d, -1, divider);
+          impl->blur_span (a, b, height, d + 1, 0, divider_plus_one);
+        }
+
+      for (y = 0; y < height; y++)
+        memcpy (buffer + y * width + x, b + y * n, n_columns);
+    }
+
+  g_free (scratch);
+}
+
 static void
 _boxblur (guchar      *buffer,
           int          width,
@@ -192,8 +528,31 @@ _boxblur (guchar      *buffer,
           int          radius,
           GskBlurFlags flags)
 {
+  const BlurImpl *impl = get_blur_impl ();
   guchar *flipped_buffer;
   int d = get_box_filter_size (radius);
+  Divider divider, divider_plus_one;
+
+  if (impl->blur_span != NULL &&
+      divider_init (&divider, d) &&
+      divider_init (&divider_plus_one, d + 1))
+    {
+      if (flags & GSK_BLUR_Y)
+        blur_columns (impl, buffer, width, height, d, &divider, &divider_plus_one);
+
+      if (flags & GSK_BLUR_X)
+        {
+          flipped_buffer = g_malloc (width * height);
+
+          flip_buffer (flipped_buffer, buffer, width, height);
+          blur_columns (impl, flipped_buffer, height, width, d, &divider, &divider_plus_one);
+          flip_buffer (buffer, flipped_buffer, height, width);
+
+          g_free (flipped_buffer);
+        }
+
+      return;
+    }
 
   flipped_buffer = g_malloc (width * height);
 
@@ -256,6 +615,20 @@ gsk_cairo_blur_surface (cairo_surface_t* surface,
   cairo_surface_mark_dirty (surface);
 }
 
+/*<private>
+ * gsk_cairo_blur_get_implementation:
+ *
+ * Gets the name of the box blur implementation that was picked for
+ * this CPU, for use in benchmarks.
+ *
+ * Returns: the name of the implementation
+ */
+const char *
+gsk_cairo_blur_get_implementation (void)
+{
+  return get_blur_impl ()->name;
+}
+
 /*<private>
  * gsk_cairo_blur_compute_pixels:
  * @radius: the radius to compute the pixels for
@@ -40,6 +40,7 @@ void            gsk_cairo_blur_surface          (cairo_surface_t *surface,
                                                  double           radius,
 						 GskBlurFlags     flags);
 int             gsk_cairo_blur_compute_pixels   (double           radius);
+const char *    gsk_cairo_blur_get_implementation (void);
 
 cairo_t *       gsk_cairo_blur_start_drawing    (cairo_t         *cr,
                                                  float            radius,
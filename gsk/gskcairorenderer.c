@@ -25,8 +25,12 @@
 #include "gskdebugprivate.h"
 #include "gskrendererprivate.h"
 #include "gskrendernodeprivate.h"
+#include "gdk/gdkparallelprivate.h"
 #include "gdk/gdktextureprivate.h"
 
+/* Size of the tiles in application pixels when rendering with threads */
+#define TILE_SIZE 256
+
 #ifdef G_ENABLE_DEBUG
 typedef struct {
   GQuark cpu_time;
@@ -72,10 +76,117 @@ gsk_cairo_renderer_unrealize (GskRenderer *renderer)
   g_clear_object (&self->cairo_context);
 }
 
+typedef struct
+{
+  GskRenderNode *root;
+  cairo_rectangle_int_t area;
+  double x_scale;
+  double y_scale;
+  cairo_surface_t *surface;
+} TileJob;
+
+static void
+draw_tile_func (gpointer data,
+                gpointer user_data)
+{
+  TileJob *job = data;
+  cairo_t *cr;
+
+  job->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                             ceil (job->area.width * job->x_scale),
+                                             ceil (job->area.height * job->y_scale));
+  cairo_surface_set_device_scale (job->surface, job->x_scale, job->y_scale);
+  cairo_surface_set_device_offset (job->surface,
+                                   - job->area.x * job->x_scale,
+                                   - job->area.y * job->y_scale);
+
+  cr = cairo_create (job->surface);
+  gsk_render_node_draw (job->root, cr);
+  cairo_destroy (cr);
+}
+
+/* Splits @region into tiles that get rasterized on the thread pool into
+ * image surfaces of their own, which are then composited onto @cr.
+ * Drawing the tiles into a shared target surface from several threads
+ * isn't something cairo supports.
+ *
+ * Returns: %FALSE if @root can't be rendered this way
+ */
+static gboolean
+gsk_cairo_renderer_do_render_tiled (cairo_t              *cr,
+                                    GskRenderNode        *root,
+                                    const cairo_region_t *region)
+{
+  GArray *jobs;
+  double x_scale, y_scale;
+  int r, x, y;
+  guint i;
+
+  if (gdk_parallel_get_n_threads () < 2)
+    return FALSE;
+
+  if (!gsk_render_node_prepare_threaded_draw (root))
+    return FALSE;
+
+  x_scale = y_scale = 1;
+  cairo_surface_get_device_scale (cairo_get_target (cr), &x_scale, &y_scale);
+
+  jobs = g_array_new (FALSE, FALSE, sizeof (TileJob));
+
+  for (r = 0; r < cairo_region_num_rectangles (region); r++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (region, r, &rect);
+
+      for (y = rect.y; y < rect.y + rect.height; y += TILE_SIZE)
+        for (x = rect.x; x < rect.x + rect.width; x += TILE_SIZE)
+          {
+            TileJob job;
+
+            job.root = root;
+            job.area.x = x;
+            job.area.y = y;
+            job.area.width = MIN (TILE_SIZE, rect.x + rect.width - x);
+            job.area.height = MIN (TILE_SIZE, rect.y + rect.height - y);
+            job.x_scale = x_scale;
+            job.y_scale = y_scale;
+            job.surface = NULL;
+            g_array_append_val (jobs, job);
+          }
+    }
+
+  if (jobs->len < 2)
+    {
+      g_array_free (jobs, TRUE);
+      return FALSE;
+    }
+
+  gdk_parallel_run (jobs->data, sizeof (TileJob), jobs->len, draw_tile_func, NULL);
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      TileJob *job = &g_array_index (jobs, TileJob, i);
+
+      cairo_save (cr);
+      cairo_set_source_surface (cr, job->surface, 0, 0);
+      cairo_rectangle (cr, job->area.x, job->area.y, job->area.width, job->area.height);
+      cairo_fill (cr);
+      cairo_restore (cr);
+
+      cairo_surface_destroy (job->surface);
+    }
+
+  g_array_free (jobs, TRUE);
+
+  return TRUE;
+}
+
 static void
-gsk_cairo_renderer_do_render (GskRenderer   *renderer,
-                              cairo_t       *cr,
-                              GskRenderNode *root)
+gsk_cairo_renderer_do_render (GskRenderer          *renderer,
+                              cairo_t              *cr,
+                              GskRenderNode        *root,
+                              const cairo_region_t *region)
 {
 #ifdef G_ENABLE_DEBUG
   GskCairoRenderer *self = GSK_CAIRO_RENDERER (renderer);
@@ -88,7 +199,8 @@ gsk_cairo_renderer_do_render (GskRenderer   *renderer,
   gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
 #endif
 
-  gsk_render_node_draw (root, cr);
+  if (region == NULL || !gsk_cairo_renderer_do_render_tiled (cr, root, region))
+    gsk_render_node_draw (root, cr);
 
 #ifdef G_ENABLE_DEBUG
   cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
@@ -105,6 +217,7 @@ gsk_cairo_renderer_render_texture (GskRenderer           *renderer,
 {
   GdkTexture *texture;
   cairo_surface_t *surface;
+  cairo_region_t *region;
   cairo_t *cr;
 
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, ceil (viewport->size.width), ceil (viewport->size.height));
@@ -112,7 +225,14 @@ gsk_cairo_renderer_render_texture (GskRenderer           *renderer,
 
   cairo_translate (cr, - viewport->origin.x, - viewport->origin.y);
 
-  gsk_cairo_renderer_do_render (renderer, cr, root);
+  region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) {
+                                            floor (viewport->origin.x),
+                                            floor (viewport->origin.y),
+                                            ceil (viewport->size.width),
+                                            ceil (viewport->size.height)
+                                          });
+  gsk_cairo_renderer_do_render (renderer, cr, root, region);
+  cairo_region_destroy (region);
 
   cairo_destroy (cr);
 
@@ -152,7 +272,8 @@ gsk_cairo_renderer_render (GskRenderer          *renderer,
     }
 #endif
 
-  gsk_cairo_renderer_do_render (renderer, cr, root);
+  gsk_cairo_renderer_do_render (renderer, cr, root,
+                                gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->cairo_context)));
 
   cairo_destroy (cr);
 
@@ -14,12 +14,17 @@ typedef enum {
   GSK_DEBUG_VULKAN                = 1 <<  5,
   GSK_DEBUG_FALLBACK              = 1 <<  6,
   GSK_DEBUG_GLYPH_CACHE           = 1 <<  7,
+  GSK_DEBUG_NODE_STATS            = 1 <<  8,
   /* flags below may affect behavior */
   GSK_DEBUG_GEOMETRY              = 1 <<  9,
   GSK_DEBUG_FULL_REDRAW           = 1 << 10,
   GSK_DEBUG_SYNC                  = 1 << 11,
   GSK_DEBUG_VULKAN_STAGING_IMAGE  = 1 << 12,
-  GSK_DEBUG_VULKAN_STAGING_BUFFER = 1 << 13
+  GSK_DEBUG_VULKAN_STAGING_BUFFER = 1 << 13,
+  GSK_DEBUG_REPAINTS              = 1 << 14,
+  GSK_DEBUG_NO_OFFLOAD            = 1 << 15,
+  GSK_DEBUG_GPU_TIMING            = 1 << 16,
+  GSK_DEBUG_NO_OPTIMIZE           = 1 << 17
 } GskDebugFlags;
 
 #define GSK_DEBUG_ANY ((1 << 13) - 1)
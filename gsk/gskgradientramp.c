@@ -0,0 +1,229 @@
+#include "config.h"
+
+#include "gskgradientrampprivate.h"
+
+#include <string.h>
+
+struct _GskGradientRampEntry
+{
+  GskColorStop *stops;
+  gsize n_stops;
+  guint hash;
+
+  int row;
+  guint64 last_used;
+};
+
+static guint
+stops_hash (const GskColorStop *stops,
+            gsize               n_stops)
+{
+  const guchar *p = (const guchar *) stops;
+  gsize i, n = n_stops * sizeof (GskColorStop);
+  guint h = 5381;
+
+  for (i = 0; i < n; i++)
+    h = (h << 5) + h + p[i];
+
+  return h;
+}
+
+static guint
+entry_hash (gconstpointer data)
+{
+  const GskGradientRampEntry *entry = data;
+
+  return entry->hash;
+}
+
+static gboolean
+entry_equal (gconstpointer a,
+             gconstpointer b)
+{
+  const GskGradientRampEntry *ea = a;
+  const GskGradientRampEntry *eb = b;
+
+  return ea->n_stops == eb->n_stops &&
+         memcmp (ea->stops, eb->stops, ea->n_stops * sizeof (GskColorStop)) == 0;
+}
+
+static void
+entry_free (gpointer data)
+{
+  GskGradientRampEntry *entry = data;
+
+  g_free (entry->stops);
+  g_free (entry);
+}
+
+void
+gsk_gradient_ramp_cache_init (GskGradientRampCache *self)
+{
+  memset (self, 0, sizeof (*self));
+
+  self->data = g_malloc0 (GSK_GRADIENT_RAMP_ROWS * GSK_GRADIENT_RAMP_WIDTH * 4);
+  self->entries = g_hash_table_new_full (entry_hash, entry_equal, entry_free, NULL);
+  self->dirty_start = GSK_GRADIENT_RAMP_ROWS;
+  self->dirty_end = 0;
+}
+
+void
+gsk_gradient_ramp_cache_free (GskGradientRampCache *self)
+{
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+  g_clear_pointer (&self->data, g_free);
+}
+
+void
+gsk_gradient_ramp_cache_begin_frame (GskGradientRampCache *self)
+{
+  self->frame++;
+}
+
+static inline guint32
+pack_premultiplied (float r,
+                    float g,
+                    float b,
+                    float a)
+{
+  return ((guint32) (a * 255.f + .5f) << 24) |
+         ((guint32) (r * 255.f + .5f) << 16) |
+         ((guint32) (g * 255.f + .5f) << 8) |
+         ((guint32) (b * 255.f + .5f));
+}
+
+/* Interpolates in premultiplied space, like the gradient shaders do */
+void
+gsk_gradient_ramp_fill (const GskColorStop *stops,
+                        gsize               n_stops,
+                        guint32            *ramp)
+{
+  const GskColorStop *last = &stops[n_stops - 1];
+  gsize j = 0;
+  int i;
+
+  for (i = 0; i < GSK_GRADIENT_RAMP_WIDTH; i++)
+    {
+      const float t = (float) i / (GSK_GRADIENT_RAMP_WIDTH - 1);
+      const GdkRGBA *c0, *c1;
+      float f;
+
+      if (t <= stops[0].offset)
+        {
+          c0 = c1 = &stops[0].color;
+          f = 0;
+        }
+      else if (t >= last->offset)
+        {
+          c0 = c1 = &last->color;
+          f = 0;
+        }
+      else
+        {
+          float d;
+
+          while (j + 2 < n_stops && t >= stops[j + 1].offset)
+            j++;
+
+          c0 = &stops[j].color;
+          c1 = &stops[j + 1].color;
+          d = stops[j + 1].offset - stops[j].offset;
+          f = d > 0 ? (t - stops[j].offset) / d : 1;
+        }
+
+      {
+        const float a = c0->alpha + (c1->alpha - c0->alpha) * f;
+        const float r = c0->red * c0->alpha + (c1->red * c1->alpha - c0->red * c0->alpha) * f;
+        const float g = c0->green * c0->alpha + (c1->green * c1->alpha - c0->green * c0->alpha) * f;
+        const float b = c0->blue * c0->alpha + (c1->blue * c1->alpha - c0->blue * c0->alpha) * f;
+
+        ramp[i] = pack_premultiplied (r, g, b, a);
+      }
+    }
+}
+
+/* Returns the atlas row holding the ramp for @stops, or -1 if every
+ * row is in use by the current frame. */
+int
+gsk_gradient_ramp_cache_lookup (GskGradientRampCache *self,
+                                const GskColorStop   *stops,
+                                gsize                 n_stops)
+{
+  GskGradientRampEntry key;
+  GskGradientRampEntry *entry;
+  int row = -1;
+  int i;
+
+  g_assert (n_stops > 0);
+
+  key.stops = (GskColorStop *) stops;
+  key.n_stops = n_stops;
+  key.hash = stops_hash (stops, n_stops);
+
+  entry = g_hash_table_lookup (self->entries, &key);
+  if (entry != NULL)
+    {
+      entry->last_used = self->frame;
+      return entry->row;
+    }
+
+  /* Take a free row, or evict the least recently used one */
+  for (i = 0; i < GSK_GRADIENT_RAMP_ROWS; i++)
+    {
+      if (self->rows[i] == NULL)
+        {
+          row = i;
+          break;
+        }
+
+      if (self->rows[i]->last_used < self->frame &&
+          (row < 0 || self->rows[i]->last_used < self->rows[row]->last_used))
+        row = i;
+    }
+
+  if (row < 0)
+    return -1;
+
+  if (self->rows[row] != NULL)
+    g_hash_table_remove (self->entries, self->rows[row]);
+
+  entry = g_new (GskGradientRampEntry, 1);
+  entry->stops = g_memdup (stops, n_stops * sizeof (GskColorStop));
+  entry->n_stops = n_stops;
+  entry->hash = key.hash;
+  entry->row = row;
+  entry->last_used = self->frame;
+
+  g_hash_table_add (self->entries, entry);
+  self->rows[row] = entry;
+
+  gsk_gradient_ramp_fill (stops, n_stops,
+                          (guint32 *) (self->data + row * GSK_GRADIENT_RAMP_WIDTH * 4));
+
+  self->dirty_start = MIN (self->dirty_start, row);
+  self->dirty_end = MAX (self->dirty_end, row + 1);
+
+  return row;
+}
+
+/* Returns the rows that changed since the last upload, or %NULL */
+const guchar *
+gsk_gradient_ramp_cache_get_dirty (GskGradientRampCache *self,
+                                   int                  *first_row,
+                                   int                  *n_rows)
+{
+  if (self->dirty_start >= self->dirty_end)
+    return NULL;
+
+  *first_row = self->dirty_start;
+  *n_rows = self->dirty_end - self->dirty_start;
+
+  return self->data + self->dirty_start * GSK_GRADIENT_RAMP_WIDTH * 4;
+}
+
+void
+gsk_gradient_ramp_cache_clear_dirty (GskGradientRampCache *self)
+{
+  self->dirty_start = GSK_GRADIENT_RAMP_ROWS;
+  self->dirty_end = 0;
+}
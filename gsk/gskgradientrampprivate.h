@@ -0,0 +1,57 @@
+#ifndef __GSK_GRADIENT_RAMP_PRIVATE_H__
+#define __GSK_GRADIENT_RAMP_PRIVATE_H__
+
+#include "gskrendernode.h"
+
+G_BEGIN_DECLS
+
+/* Gradients with more color stops than a shader can take are rendered
+ * from a precomputed ramp instead. Each ramp is one row of an atlas of
+ * GSK_GRADIENT_RAMP_ROWS rows, in premultiplied CAIRO_FORMAT_ARGB32. */
+#define GSK_GRADIENT_RAMP_WIDTH 256
+#define GSK_GRADIENT_RAMP_ROWS  64
+
+typedef struct _GskGradientRampEntry GskGradientRampEntry;
+
+typedef struct
+{
+  guchar *data;
+  GHashTable *entries;
+  GskGradientRampEntry *rows[GSK_GRADIENT_RAMP_ROWS];
+  guint64 frame;
+
+  int dirty_start;
+  int dirty_end;
+} GskGradientRampCache;
+
+void            gsk_gradient_ramp_cache_init            (GskGradientRampCache *self);
+void            gsk_gradient_ramp_cache_free            (GskGradientRampCache *self);
+void            gsk_gradient_ramp_cache_begin_frame     (GskGradientRampCache *self);
+int             gsk_gradient_ramp_cache_lookup          (GskGradientRampCache *self,
+                                                         const GskColorStop   *stops,
+                                                         gsize                 n_stops);
+const guchar *  gsk_gradient_ramp_cache_get_dirty       (GskGradientRampCache *self,
+                                                         int                  *first_row,
+                                                         int                  *n_rows);
+void            gsk_gradient_ramp_cache_clear_dirty     (GskGradientRampCache *self);
+
+void            gsk_gradient_ramp_fill                  (const GskColorStop   *stops,
+                                                         gsize                 n_stops,
+                                                         guint32              *ramp);
+
+/* Texture coordinates of the gradient position @offset in row @row */
+static inline float
+gsk_gradient_ramp_get_u (float offset)
+{
+  return (offset * (GSK_GRADIENT_RAMP_WIDTH - 1) + 0.5f) / GSK_GRADIENT_RAMP_WIDTH;
+}
+
+static inline float
+gsk_gradient_ramp_get_v (int row)
+{
+  return (row + 0.5f) / GSK_GRADIENT_RAMP_ROWS;
+}
+
+G_END_DECLS
+
+#endif /* __GSK_GRADIENT_RAMP_PRIVATE_H__ */
@@ -2,6 +2,8 @@
 
 #include "gskprofilerprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
 #define MAX_SAMPLES     32
 
 typedef struct {
@@ -9,6 +11,7 @@ typedef struct {
   char *description;
   gint64 value;
   gint64 n_samples;
+  guint sysprof_id;
   gboolean can_reset : 1;
 } NamedCounter;
 
@@ -21,6 +24,7 @@ typedef struct {
   gint64 max_value;
   gint64 avg_value;
   gint64 n_samples;
+  guint sysprof_id;
   gboolean in_flight : 1;
   gboolean can_reset : 1;
   gboolean invert : 1;
@@ -40,6 +44,9 @@ struct _GskProfiler
 
   Sample timer_samples[MAX_SAMPLES];
   guint last_sample;
+
+  /* GskProfilerGpuSpan, for the current frame */
+  GArray *gpu_spans;
 };
 
 G_DEFINE_TYPE (GskProfiler, gsk_profiler, G_TYPE_OBJECT)
@@ -77,6 +84,7 @@ gsk_profiler_finalize (GObject *gobject)
 
   g_clear_pointer (&self->counters, g_hash_table_unref);
   g_clear_pointer (&self->timers, g_hash_table_unref);
+  g_clear_pointer (&self->gpu_spans, g_array_unref);
 
   G_OBJECT_CLASS (gsk_profiler_parent_class)->finalize (gobject);
 }
@@ -96,6 +104,7 @@ gsk_profiler_init (GskProfiler *self)
   self->timers = g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                         NULL,
                                         named_timer_free);
+  self->gpu_spans = g_array_new (FALSE, FALSE, sizeof (GskProfilerGpuSpan));
 }
 
 GskProfiler *
@@ -115,6 +124,10 @@ named_counter_new (GQuark      id,
   res->description = g_strdup (description);
   res->can_reset = can_reset;
 
+  /* Counters are pushed to sysprof along with the samples */
+  if (GDK_PROFILER_IS_RUNNING)
+    res->sysprof_id = gdk_profiler_define_int_counter (g_quark_to_string (id), description);
+
   return res;
 }
 
@@ -163,6 +176,9 @@ named_timer_new (GQuark      id,
   res->invert = invert;
   res->can_reset = can_reset;
 
+  if (GDK_PROFILER_IS_RUNNING)
+    res->sysprof_id = gdk_profiler_define_counter (g_quark_to_string (id), description);
+
   return res;
 }
 
@@ -378,6 +394,52 @@ gsk_profiler_timer_get_start (GskProfiler *profiler,
   return timer->start_time;
 }
 
+/*< private >
+ * gsk_profiler_add_gpu_span:
+ * @profiler: a #GskProfiler
+ * @name: what the GPU was doing, such as a render node type
+ * @depth: the nesting level of the span
+ * @start: start time in nanoseconds, relative to the frame
+ * @duration: duration in nanoseconds
+ *
+ * Records how long a piece of GPU work took in the current frame.
+ * Spans are expected to be added in the order they started, with
+ * nested spans following the span containing them.
+ *
+ * The spans are cleared by gsk_profiler_reset().
+ */
+void
+gsk_profiler_add_gpu_span (GskProfiler *profiler,
+                           const char  *name,
+                           guint        depth,
+                           gint64       start,
+                           gint64       duration)
+{
+  GskProfilerGpuSpan span;
+
+  g_return_if_fail (GSK_IS_PROFILER (profiler));
+  g_return_if_fail (name != NULL);
+
+  span.name = g_intern_string (name);
+  span.depth = depth;
+  span.start = start;
+  span.duration = MAX (duration, 0);
+
+  g_array_append_val (profiler->gpu_spans, span);
+}
+
+const GskProfilerGpuSpan *
+gsk_profiler_get_gpu_spans (GskProfiler *profiler,
+                            guint       *n_spans)
+{
+  g_return_val_if_fail (GSK_IS_PROFILER (profiler), NULL);
+  g_return_val_if_fail (n_spans != NULL, NULL);
+
+  *n_spans = profiler->gpu_spans->len;
+
+  return (const GskProfilerGpuSpan *) profiler->gpu_spans->data;
+}
+
 void
 gsk_profiler_reset (GskProfiler *profiler)
 {
@@ -411,6 +473,8 @@ gsk_profiler_reset (GskProfiler *profiler)
     }
 
   profiler->last_sample = 0;
+
+  g_array_set_size (profiler->gpu_spans, 0);
 }
 
 void
@@ -440,6 +504,21 @@ gsk_profiler_push_samples (GskProfiler *profiler)
         s->value = (gint64) (1000000.0 / (double) timer->value);
       else
         s->value = timer->value;
+
+      if (timer->sysprof_id != 0)
+        gdk_profiler_set_counter (timer->sysprof_id, s->value / 1000.0);
+    }
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      g_hash_table_iter_init (&iter, profiler->counters);
+      while (g_hash_table_iter_next (&iter, NULL, &value_p))
+        {
+          NamedCounter *counter = value_p;
+
+          if (counter->sysprof_id != 0)
+            gdk_profiler_set_int_counter (counter->sysprof_id, counter->value);
+        }
     }
 }
 
@@ -525,3 +604,140 @@ gsk_profiler_append_timers (GskProfiler *profiler,
       g_string_append (buffer, "\n");
     }
 }
+
+typedef struct {
+  const char *name;
+  gint64 self_time;
+  gint64 total_time;
+  guint count;
+} SpanTotal;
+
+static int
+compare_span_totals (gconstpointer a,
+                     gconstpointer b)
+{
+  const SpanTotal *ta = a;
+  const SpanTotal *tb = b;
+
+  if (ta->self_time > tb->self_time)
+    return -1;
+  if (ta->self_time < tb->self_time)
+    return 1;
+
+  return 0;
+}
+
+/* Sums up the GPU spans of the frame by name. The self time of a
+ * span is its duration without that of the spans directly nested
+ * in it, so that e.g. a blur node doesn't get charged for drawing
+ * its child.
+ */
+void
+gsk_profiler_append_gpu_spans (GskProfiler *profiler,
+                               GString     *buffer)
+{
+  GHashTable *index;
+  GArray *totals;
+  guint i, j;
+
+  g_return_if_fail (GSK_IS_PROFILER (profiler));
+  g_return_if_fail (buffer != NULL);
+
+  if (profiler->gpu_spans->len == 0)
+    return;
+
+  index = g_hash_table_new (NULL, NULL);
+  totals = g_array_new (FALSE, TRUE, sizeof (SpanTotal));
+
+  for (i = 0; i < profiler->gpu_spans->len; i++)
+    {
+      const GskProfilerGpuSpan *span = &g_array_index (profiler->gpu_spans, GskProfilerGpuSpan, i);
+      gint64 self_time = span->duration;
+      SpanTotal *total;
+      gpointer pos;
+
+      for (j = i + 1; j < profiler->gpu_spans->len; j++)
+        {
+          const GskProfilerGpuSpan *child = &g_array_index (profiler->gpu_spans, GskProfilerGpuSpan, j);
+
+          if (child->depth <= span->depth)
+            break;
+
+          if (child->depth == span->depth + 1)
+            self_time -= child->duration;
+        }
+
+      if (!g_hash_table_lookup_extended (index, span->name, NULL, &pos))
+        {
+          pos = GUINT_TO_POINTER (totals->len);
+          g_array_set_size (totals, totals->len + 1);
+          g_array_index (totals, SpanTotal, totals->len - 1).name = span->name;
+          g_hash_table_insert (index, (gpointer) span->name, pos);
+        }
+
+      total = &g_array_index (totals, SpanTotal, GPOINTER_TO_UINT (pos));
+      total->self_time += MAX (self_time, 0);
+      total->total_time += span->duration;
+      total->count++;
+    }
+
+  g_array_sort (totals, compare_span_totals);
+
+  g_string_append (buffer, "GPU time by node (usec, self/total):\n");
+  for (i = 0; i < totals->len; i++)
+    {
+      const SpanTotal *total = &g_array_index (totals, SpanTotal, i);
+
+      g_string_append_printf (buffer, "  %s: %.2f/%.2f (%u)\n",
+                              total->name,
+                              total->self_time / 1000.0,
+                              total->total_time / 1000.0,
+                              total->count);
+    }
+
+  g_array_unref (totals);
+  g_hash_table_unref (index);
+}
+
+/*< private >
+ * gsk_profiler_get_values:
+ * @profiler: a #GskProfiler
+ *
+ * Collects the current values of all counters and timers of
+ * @profiler, keyed by their names. Timers are in microseconds.
+ *
+ * This is meant for benchmarking tools outside of GTK.
+ *
+ * Returns: (transfer floating): a #GVariant of type `a{sx}`
+ */
+GVariant *
+gsk_profiler_get_values (GskProfiler *profiler)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer value_p = NULL;
+
+  g_return_val_if_fail (GSK_IS_PROFILER (profiler), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sx}"));
+
+  g_hash_table_iter_init (&iter, profiler->counters);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      NamedCounter *counter = value_p;
+
+      g_variant_builder_add (&builder, "{sx}", g_quark_to_string (counter->id), counter->value);
+    }
+
+  g_hash_table_iter_init (&iter, profiler->timers);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      NamedTimer *timer = value_p;
+
+      g_variant_builder_add (&builder, "{sx}",
+                             g_quark_to_string (timer->id),
+                             gsk_profiler_timer_get (profiler, timer->id));
+    }
+
+  return g_variant_builder_end (&builder);
+}
@@ -1,13 +1,24 @@
 #ifndef __GSK_PROFILER_PRIVATE_H__
 #define __GSK_PROFILER_PRIVATE_H__
 
-#include <glib-object.h>
+#include <gdk/gdk.h>
 
 G_BEGIN_DECLS
 
 #define GSK_TYPE_PROFILER (gsk_profiler_get_type ())
 G_DECLARE_FINAL_TYPE (GskProfiler, gsk_profiler, GSK, PROFILER, GObject)
 
+/* A piece of GPU work, such as drawing a render node, with its
+ * start relative to the first span of the frame. Times are in
+ * nanoseconds, since single nodes often take less than a microsecond.
+ */
+typedef struct {
+  const char *name; /* interned */
+  guint depth;
+  gint64 start;
+  gint64 duration;
+} GskProfilerGpuSpan;
+
 GskProfiler *   gsk_profiler_new                (void);
 
 GQuark          gsk_profiler_add_counter        (GskProfiler *profiler,
@@ -43,6 +54,15 @@ gint64          gsk_profiler_timer_get          (GskProfiler *profiler,
 gint64          gsk_profiler_timer_get_start    (GskProfiler *profiler,
                                                  GQuark       timer_id);
 
+void            gsk_profiler_add_gpu_span       (GskProfiler *profiler,
+                                                 const char  *name,
+                                                 guint        depth,
+                                                 gint64       start,
+                                                 gint64       duration);
+const GskProfilerGpuSpan *
+                gsk_profiler_get_gpu_spans      (GskProfiler *profiler,
+                                                 guint       *n_spans);
+
 void            gsk_profiler_reset              (GskProfiler *profiler);
 
 void            gsk_profiler_push_samples       (GskProfiler *profiler);
@@ -50,6 +70,11 @@ void            gsk_profiler_append_counters    (GskProfiler *profiler,
                                                  GString     *buffer);
 void            gsk_profiler_append_timers      (GskProfiler *profiler,
                                                  GString     *buffer);
+void            gsk_profiler_append_gpu_spans   (GskProfiler *profiler,
+                                                 GString     *buffer);
+
+GDK_AVAILABLE_IN_ALL
+GVariant *      gsk_profiler_get_values         (GskProfiler *profiler);
 
 G_END_DECLS
 
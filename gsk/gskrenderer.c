@@ -40,14 +40,21 @@
 #include "gskdebugprivate.h"
 #include "gl/gskglrenderer.h"
 #include "gskprofilerprivate.h"
+#include "gskrendernodeoptimizeprivate.h"
 #include "gskrendernodeprivate.h"
+#include "gskrendernodestatsprivate.h"
 
 #include "gskenumtypes.h"
 
+#include "gdk/gdkprofilerprivate.h"
+#include "gdk/gdksurfaceprivate.h"
+
 #include <graphene-gobject.h>
 #include <cairo-gobject.h>
 #include <gdk/gdk.h>
 
+#include <math.h>
+
 #ifdef GDK_WINDOWING_X11
 #include <gdk/x11/gdkx.h>
 #endif
@@ -79,7 +86,14 @@ typedef struct
   GskRenderNode *prev_node;
   GskRenderNode *root_node;
 
+  GskRenderNodeOptimizeCache *optimize_cache;
+
   GskProfiler *profiler;
+  struct {
+    GQuark folded_transforms;
+    GQuark dropped_nodes;
+    GQuark culled_nodes;
+  } optimize_counters;
 
   GskDebugFlags debug_flags;
 
@@ -210,6 +224,13 @@ gsk_renderer_init (GskRenderer *self)
 
   priv->profiler = gsk_profiler_new ();
   priv->debug_flags = gsk_get_debug_flags ();
+
+  priv->optimize_counters.folded_transforms =
+    gsk_profiler_add_counter (priv->profiler, "optimize-folded-transforms", "Transforms folded", TRUE);
+  priv->optimize_counters.dropped_nodes =
+    gsk_profiler_add_counter (priv->profiler, "optimize-dropped-nodes", "Nodes without effect dropped", TRUE);
+  priv->optimize_counters.culled_nodes =
+    gsk_profiler_add_counter (priv->profiler, "optimize-culled-nodes", "Hidden nodes culled", TRUE);
 }
 
 /**
@@ -319,6 +340,7 @@ gsk_renderer_unrealize (GskRenderer *renderer)
   GSK_RENDERER_GET_CLASS (renderer)->unrealize (renderer);
 
   g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
+  g_clear_pointer (&priv->optimize_cache, gsk_render_node_optimize_cache_free);
 
   priv->is_realized = FALSE;
 }
@@ -362,6 +384,11 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
       viewport = &real_viewport;
     }
 
+#ifdef G_ENABLE_DEBUG
+  /* Per-frame counters, so that the values pushed to sysprof are per frame too */
+  gsk_profiler_reset (priv->profiler);
+#endif
+
   texture = GSK_RENDERER_GET_CLASS (renderer)->render_texture (renderer, root, viewport);
 
 #ifdef G_ENABLE_DEBUG
@@ -377,6 +404,19 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
 
       g_print ("%s\n***\n\n", buf->str);
 
+      g_string_free (buf, TRUE);
+    }
+
+  if (GSK_RENDERER_DEBUG_CHECK (renderer, NODE_STATS))
+    {
+      GString *buf = g_string_new ("*** Node stats ***\n\n");
+      GskRenderNodeStats stats;
+
+      gsk_render_node_get_stats (root, &stats);
+      gsk_render_node_stats_print (&stats, buf);
+
+      g_print ("%s\n***\n\n", buf->str);
+
       g_string_free (buf, TRUE);
     }
 #endif
@@ -386,6 +426,170 @@ gsk_renderer_render_texture (GskRenderer           *renderer,
   return texture;
 }
 
+/* Finds a texture node that is drawn on top of everything else and
+ * that the windowing system may be able to show by itself, such as a
+ * video frame. Returns a copy of @node without it, or %NULL.
+ */
+static GskRenderNode *
+strip_offload_node (GskRenderNode  *node,
+                    int             dx,
+                    int             dy,
+                    GskRenderNode **texture_node,
+                    GdkRectangle   *area)
+{
+  GskRenderNode *child, *result;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_TEXTURE_NODE:
+      {
+        const graphene_rect_t *bounds = &node->bounds;
+
+        if (!GDK_IS_DMABUF_TEXTURE (gsk_texture_node_get_texture (node)))
+          return NULL;
+
+        /* Subsurfaces are placed in integer coordinates */
+        if (bounds->origin.x != floorf (bounds->origin.x) ||
+            bounds->origin.y != floorf (bounds->origin.y) ||
+            bounds->size.width != floorf (bounds->size.width) ||
+            bounds->size.height != floorf (bounds->size.height) ||
+            bounds->size.width < 1 || bounds->size.height < 1)
+          return NULL;
+
+        *texture_node = node;
+        area->x = dx + bounds->origin.x;
+        area->y = dy + bounds->origin.y;
+        area->width = bounds->size.width;
+        area->height = bounds->size.height;
+
+        return gsk_container_node_new (NULL, 0);
+      }
+
+    case GSK_CONTAINER_NODE:
+      {
+        guint i, n = gsk_container_node_get_n_children (node);
+        GskRenderNode **children;
+
+        if (n == 0)
+          return NULL;
+
+        child = strip_offload_node (gsk_container_node_get_child (node, n - 1),
+                                    dx, dy, texture_node, area);
+        if (child == NULL)
+          return NULL;
+
+        children = g_newa (GskRenderNode *, n);
+        for (i = 0; i < n - 1; i++)
+          children[i] = gsk_container_node_get_child (node, i);
+        children[n - 1] = child;
+
+        result = gsk_container_node_new (children, n);
+        gsk_render_node_unref (child);
+
+        return result;
+      }
+
+    case GSK_DEBUG_NODE:
+      child = strip_offload_node (gsk_debug_node_get_child (node),
+                                  dx, dy, texture_node, area);
+      if (child == NULL)
+        return NULL;
+
+      result = gsk_debug_node_new (child, g_strdup (gsk_debug_node_get_message (node)));
+      gsk_render_node_unref (child);
+
+      return result;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskTransform *transform = gsk_transform_node_get_transform (node);
+        float tx, ty;
+
+        if (gsk_transform_get_category (transform) < GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+          return NULL;
+
+        gsk_transform_to_translate (transform, &tx, &ty);
+        if (tx != floorf (tx) || ty != floorf (ty))
+          return NULL;
+
+        child = strip_offload_node (gsk_transform_node_get_child (node),
+                                    dx + tx, dy + ty, texture_node, area);
+        if (child == NULL)
+          return NULL;
+
+        result = gsk_transform_node_new (child, transform);
+        gsk_render_node_unref (child);
+
+        return result;
+      }
+
+    default:
+      return NULL;
+    }
+}
+
+/* Lets the surface show the topmost texture of @root by itself, so
+ * the compositor can scan it out. Returns the nodes left to render. */
+static GskRenderNode *
+gsk_renderer_offload (GskRenderer   *renderer,
+                      GskRenderNode *root)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNode *texture_node = NULL;
+  GskRenderNode *stripped = NULL;
+  GdkRectangle area;
+
+  if (!GSK_RENDERER_DEBUG_CHECK (renderer, NO_OFFLOAD))
+    stripped = strip_offload_node (root, 0, 0, &texture_node, &area);
+
+  if (stripped != NULL &&
+      area.x >= 0 && area.y >= 0 &&
+      area.x + area.width <= gdk_surface_get_width (priv->surface) &&
+      area.y + area.height <= gdk_surface_get_height (priv->surface) &&
+      gdk_surface_offload_texture (priv->surface,
+                                   gsk_texture_node_get_texture (texture_node),
+                                   &area))
+    return stripped;
+
+  g_clear_pointer (&stripped, gsk_render_node_unref);
+  gdk_surface_offload_texture (priv->surface, NULL, NULL);
+
+  return gsk_render_node_ref (root);
+}
+
+static GskRenderNode *
+gsk_renderer_optimize (GskRenderer   *renderer,
+                       GskRenderNode *root)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNodeOptimizeStats stats;
+  GskRenderNode *result;
+  gint64 before G_GNUC_UNUSED;
+
+  if (GSK_RENDERER_DEBUG_CHECK (renderer, NO_OPTIMIZE))
+    {
+      g_clear_pointer (&priv->optimize_cache, gsk_render_node_optimize_cache_free);
+      return gsk_render_node_ref (root);
+    }
+
+  /* Keeps the nodes of the last frame, so that unchanged subtrees
+   * are optimized to the same nodes that the renderer may have
+   * cached things for
+   */
+  if (priv->optimize_cache == NULL)
+    priv->optimize_cache = gsk_render_node_optimize_cache_new ();
+
+  before = GDK_PROFILER_CURRENT_TIME;
+  result = gsk_render_node_optimize (root, priv->optimize_cache, &stats);
+  gdk_profiler_end_mark (before, "render node optimize", NULL);
+
+  gsk_profiler_counter_add (priv->profiler, priv->optimize_counters.folded_transforms, stats.n_folded_transforms);
+  gsk_profiler_counter_add (priv->profiler, priv->optimize_counters.dropped_nodes, stats.n_dropped_nodes);
+  gsk_profiler_counter_add (priv->profiler, priv->optimize_counters.culled_nodes, stats.n_culled_nodes);
+
+  return result;
+}
+
 /**
  * gsk_renderer_render:
  * @renderer: a #GskRenderer
@@ -410,6 +614,7 @@ gsk_renderer_render (GskRenderer          *renderer,
                      const cairo_region_t *region)
 {
   GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskRenderNode *optimized;
   cairo_region_t *clip;
 
   g_return_if_fail (GSK_IS_RENDERER (renderer));
@@ -417,6 +622,8 @@ gsk_renderer_render (GskRenderer          *renderer,
   g_return_if_fail (GSK_IS_RENDER_NODE (root));
   g_return_if_fail (priv->root_node == NULL);
 
+  root = gsk_renderer_offload (renderer, root);
+
   if (region == NULL || priv->prev_node == NULL || GSK_RENDERER_DEBUG_CHECK (renderer, FULL_REDRAW))
     {
       clip = cairo_region_create_rectangle (&(GdkRectangle) {
@@ -427,19 +634,34 @@ gsk_renderer_render (GskRenderer          *renderer,
     }
   else
     {
+      gint64 before G_GNUC_UNUSED;
+
+      before = GDK_PROFILER_CURRENT_TIME;
       clip = cairo_region_copy (region);
       gsk_render_node_diff (priv->prev_node, root, clip);
+      gdk_profiler_end_mark (before, "render node diff", NULL);
 
       if (cairo_region_is_empty (clip))
         {
           cairo_region_destroy (clip);
+          gsk_render_node_unref (root);
           return;
         }
     }
 
-  priv->root_node = gsk_render_node_ref (root);
+  priv->root_node = root;
+
+#ifdef G_ENABLE_DEBUG
+  /* Per-frame counters, so that the values pushed to sysprof are per frame too */
+  gsk_profiler_reset (priv->profiler);
+#endif
 
-  GSK_RENDERER_GET_CLASS (renderer)->render (renderer, root, clip);
+  /* The diff above and the next one work on the tree as given,
+   * so that unchanged subtrees can be skipped by identity.
+   */
+  optimized = gsk_renderer_optimize (renderer, root);
+  GSK_RENDERER_GET_CLASS (renderer)->render (renderer, optimized, clip);
+  gsk_render_node_unref (optimized);
 
 #ifdef G_ENABLE_DEBUG
   if (GSK_RENDERER_DEBUG_CHECK (renderer, RENDERER))
@@ -53,6 +53,7 @@ struct _GskRendererClass
 
 GskRenderNode *         gsk_renderer_get_root_node              (GskRenderer    *renderer);
 
+GDK_AVAILABLE_IN_ALL
 GskProfiler *           gsk_renderer_get_profiler               (GskRenderer    *renderer);
 
 GskDebugFlags           gsk_renderer_get_debug_flags            (GskRenderer    *renderer);
@@ -44,9 +44,12 @@
 #include "gskrendererprivate.h"
 #include "gskrendernodeparserprivate.h"
 
+#include "gdk/gdkallocstatsprivate.h"
+
 #include <graphene-gobject.h>
 
 #include <math.h>
+#include <string.h>
 
 #include <gobject/gvaluecollector.h>
 
@@ -139,10 +142,17 @@ value_render_node_lcopy_value (const GValue *value,
   return NULL;
 }
 
+static void gsk_render_node_arena_block_unref (GskRenderNodeArenaBlock *block);
+
 static void
 gsk_render_node_finalize (GskRenderNode *self)
 {
-  g_type_free_instance ((GTypeInstance *) self);
+  gdk_alloc_stats_remove (GDK_ALLOC_RENDER_NODE, GSK_RENDER_NODE_GET_CLASS (self)->instance_size);
+
+  if (self->arena_block)
+    gsk_render_node_arena_block_unref (self->arena_block);
+  else
+    g_type_free_instance ((GTypeInstance *) self);
 }
 
 static void
@@ -165,6 +175,19 @@ gsk_render_node_real_diff (GskRenderNode  *node1,
 {
 }
 
+static guint
+gsk_render_node_real_hash (GskRenderNode *node)
+{
+  return g_direct_hash (node);
+}
+
+static gboolean
+gsk_render_node_real_equal (GskRenderNode *node1,
+                            GskRenderNode *node2)
+{
+  return FALSE;
+}
+
 static void
 gsk_render_node_class_init (GskRenderNodeClass *klass)
 {
@@ -173,6 +196,8 @@ gsk_render_node_class_init (GskRenderNodeClass *klass)
   klass->draw = gsk_render_node_real_draw;
   klass->can_diff = gsk_render_node_real_can_diff;
   klass->diff = gsk_render_node_real_diff;
+  klass->hash = gsk_render_node_real_hash;
+  klass->equal = gsk_render_node_real_equal;
 }
 
 static void
@@ -239,7 +264,9 @@ gsk_render_node_get_type (void)
 typedef struct
 {
   GskRenderNodeType node_type;
+  gsize instance_size;
 
+  void     (* instance_init) (GskRenderNode   *node);
   void     (* finalize) (GskRenderNode        *node);
   void     (* draw)     (GskRenderNode        *node,
                          cairo_t              *cr);
@@ -248,6 +275,9 @@ typedef struct
   void     (* diff)     (GskRenderNode        *node1,
                          GskRenderNode        *node2,
                          cairo_region_t       *region);
+  guint    (* hash)     (GskRenderNode        *node);
+  gboolean (* equal)    (GskRenderNode        *node1,
+                         GskRenderNode        *node2);
 } RenderNodeClassData;
 
 static void
@@ -259,12 +289,18 @@ gsk_render_node_generic_class_init (gpointer g_class,
 
   /* Mandatory */
   node_class->node_type = node_data->node_type;
+  node_class->instance_size = node_data->instance_size;
+  node_class->instance_init = node_data->instance_init;
 
   /* Optional */
   if (node_data->finalize != NULL)
     node_class->finalize = node_data->finalize;
   if (node_data->can_diff != NULL)
     node_class->can_diff = node_data->can_diff;
+  if (node_data->hash != NULL)
+    node_class->hash = node_data->hash;
+  if (node_data->equal != NULL)
+    node_class->equal = node_data->equal;
 
   /* Mandatory */
   node_class->draw = node_data->draw;
@@ -308,6 +344,8 @@ gsk_render_node_type_register_static (const char                  *node_name,
    */
   info.class_data = g_new (RenderNodeClassData, 1);
   ((RenderNodeClassData *) info.class_data)->node_type = node_info->node_type;
+  ((RenderNodeClassData *) info.class_data)->instance_size = node_info->instance_size;
+  ((RenderNodeClassData *) info.class_data)->instance_init = node_info->instance_init;
   ((RenderNodeClassData *) info.class_data)->finalize = node_info->finalize;
   ((RenderNodeClassData *) info.class_data)->draw = node_info->draw;
   ((RenderNodeClassData *) info.class_data)->can_diff = node_info->can_diff != NULL
@@ -316,6 +354,8 @@ gsk_render_node_type_register_static (const char                  *node_name,
   ((RenderNodeClassData *) info.class_data)->diff = node_info->diff != NULL
                                                   ? node_info->diff
                                                   : gsk_render_node_diff_impossible;
+  ((RenderNodeClassData *) info.class_data)->hash = node_info->hash;
+  ((RenderNodeClassData *) info.class_data)->equal = node_info->equal;
 
   info.instance_size = node_info->instance_size;
   info.n_preallocs = 0;
@@ -325,6 +365,167 @@ gsk_render_node_type_register_static (const char                  *node_name,
   return g_type_register_static (GSK_TYPE_RENDER_NODE, node_name, &info, 0);
 }
 
+/* Render nodes are created by the tens of thousands while snapshotting
+ * and most of them are gone again by the next frame. An arena hands out
+ * node memory from large blocks instead of allocating every node on its
+ * own.
+ *
+ * Each block counts the nodes living in it, plus one reference held by
+ * the arena while the block is being filled. Nodes that outlive the
+ * arena, like the render nodes retained by widgets, just keep their
+ * block alive, so retaining a node is always safe. The price is that a
+ * long-lived node pins the whole block, which is why blocks are kept
+ * fairly small.
+ */
+#define ARENA_BLOCK_SIZE   (16 * 1024)
+#define ARENA_ALIGNMENT    16
+#define ARENA_ALIGN(size)  (((size) + ARENA_ALIGNMENT - 1) & ~(gsize) (ARENA_ALIGNMENT - 1))
+
+struct _GskRenderNodeArenaBlock
+{
+  int ref_count;
+  gsize used;
+};
+
+struct _GskRenderNodeArena
+{
+  GskRenderNodeArenaBlock *block;
+};
+
+static GPrivate current_arena;
+
+static GskRenderNodeArenaBlock *
+gsk_render_node_arena_block_new (void)
+{
+  GskRenderNodeArenaBlock *block;
+
+  /* malloc() gives us the same alignment as g_type_create_instance() */
+  block = g_malloc (ARENA_BLOCK_SIZE);
+  block->ref_count = 1;
+  block->used = ARENA_ALIGN (sizeof (GskRenderNodeArenaBlock));
+
+  return block;
+}
+
+static void
+gsk_render_node_arena_block_unref (GskRenderNodeArenaBlock *block)
+{
+  if (g_atomic_int_dec_and_test (&block->ref_count))
+    g_free (block);
+}
+
+static GskRenderNode *
+gsk_render_node_arena_alloc (GskRenderNodeArena *arena,
+                             GskRenderNodeType   node_type)
+{
+  static GskRenderNodeClass *node_classes[GSK_RENDER_NODE_TYPE_N_TYPES];
+  GskRenderNodeClass *node_class;
+  GskRenderNodeArenaBlock *block;
+  GskRenderNode *node;
+  gsize size;
+
+  node_class = g_atomic_pointer_get (&node_classes[node_type]);
+  if (G_UNLIKELY (node_class == NULL))
+    {
+      /* Keep the class alive forever, like the type itself */
+      node_class = g_type_class_ref (gsk_render_node_types[node_type]);
+      g_atomic_pointer_set (&node_classes[node_type], node_class);
+    }
+
+  size = ARENA_ALIGN (node_class->instance_size);
+  if (size > ARENA_BLOCK_SIZE / 4)
+    return NULL;
+
+  block = arena->block;
+  if (block == NULL || block->used + size > ARENA_BLOCK_SIZE)
+    {
+      if (block)
+        gsk_render_node_arena_block_unref (block);
+      block = arena->block = gsk_render_node_arena_block_new ();
+    }
+
+  node = (GskRenderNode *) ((guchar *) block + block->used);
+  block->used += size;
+  g_atomic_int_inc (&block->ref_count);
+
+  /* Do what g_type_create_instance() would do */
+  memset (node, 0, size);
+  node->parent_instance.g_class = (GTypeClass *) node_class;
+  gsk_render_node_init (node);
+  if (node_class->instance_init)
+    node_class->instance_init (node);
+  node->arena_block = block;
+
+  return node;
+}
+
+/*< private >
+ * gsk_render_node_arena_new:
+ *
+ * Creates a new arena for render nodes. Use gsk_render_node_arena_push()
+ * to make gsk_render_node_alloc() use it.
+ *
+ * Returns: (transfer full): a new arena
+ */
+GskRenderNodeArena *
+gsk_render_node_arena_new (void)
+{
+  return g_new0 (GskRenderNodeArena, 1);
+}
+
+/*< private >
+ * gsk_render_node_arena_free:
+ * @arena: (transfer full): a #GskRenderNodeArena
+ *
+ * Frees @arena. Nodes allocated from it stay valid until their
+ * last reference is dropped.
+ */
+void
+gsk_render_node_arena_free (GskRenderNodeArena *arena)
+{
+  g_assert (g_private_get (&current_arena) != arena);
+
+  if (arena->block)
+    gsk_render_node_arena_block_unref (arena->block);
+
+  g_free (arena);
+}
+
+/*< private >
+ * gsk_render_node_arena_push:
+ * @arena: a #GskRenderNodeArena
+ *
+ * Makes all nodes created in the current thread get allocated from
+ * @arena until gsk_render_node_arena_pop() is called.
+ *
+ * Returns: the previously used arena, to pass to gsk_render_node_arena_pop()
+ */
+GskRenderNodeArena *
+gsk_render_node_arena_push (GskRenderNodeArena *arena)
+{
+  GskRenderNodeArena *previous = g_private_get (&current_arena);
+
+  g_private_set (&current_arena, arena);
+
+  return previous;
+}
+
+/*< private >
+ * gsk_render_node_arena_pop:
+ * @arena: the #GskRenderNodeArena that was pushed
+ * @previous: (nullable): the return value of gsk_render_node_arena_push()
+ *
+ * Stops using @arena for node allocations in the current thread.
+ */
+void
+gsk_render_node_arena_pop (GskRenderNodeArena *arena,
+                           GskRenderNodeArena *previous)
+{
+  g_assert (g_private_get (&current_arena) == arena);
+
+  g_private_set (&current_arena, previous);
+}
+
 /*< private >
  * gsk_render_node_alloc:
  * @node_type: the #GskRenderNodeType to instantiate
@@ -336,13 +537,29 @@ gsk_render_node_type_register_static (const char                  *node_name,
 gpointer
 gsk_render_node_alloc (GskRenderNodeType node_type)
 {
+  GskRenderNodeArena *arena;
+  GskRenderNode *node = NULL;
+
   g_return_val_if_fail (node_type > GSK_NOT_A_RENDER_NODE, NULL);
   g_return_val_if_fail (node_type < GSK_RENDER_NODE_TYPE_N_TYPES, NULL);
 
   g_assert (gsk_render_node_types[node_type] != G_TYPE_INVALID);
-  return g_type_create_instance (gsk_render_node_types[node_type]);
+
+  arena = g_private_get (&current_arena);
+  if (arena != NULL)
+    node = gsk_render_node_arena_alloc (arena, node_type);
+
+  if (node == NULL)
+    node = (GskRenderNode *) g_type_create_instance (gsk_render_node_types[node_type]);
+
+  gdk_alloc_stats_add (GDK_ALLOC_RENDER_NODE, GSK_RENDER_NODE_GET_CLASS (node)->instance_size);
+
+  return node;
 }
 
+static GMutex intern_lock;
+static GHashTable *intern_table;
+
 /**
  * gsk_render_node_ref:
  * @node: a #GskRenderNode
@@ -375,8 +592,26 @@ gsk_render_node_unref (GskRenderNode *node)
 {
   g_return_if_fail (GSK_IS_RENDER_NODE (node));
 
-  if (g_atomic_ref_count_dec (&node->ref_count))
-    GSK_RENDER_NODE_GET_CLASS (node)->finalize (node);
+  if (G_UNLIKELY (node->interned))
+    {
+      gboolean last;
+
+      /* Drop the reference under the lock, so that gsk_render_node_intern()
+       * can never hand out a node that is about to be finalized.
+       */
+      g_mutex_lock (&intern_lock);
+      last = g_atomic_ref_count_dec (&node->ref_count);
+      if (last)
+        g_hash_table_remove (intern_table, node);
+      g_mutex_unlock (&intern_lock);
+
+      if (!last)
+        return;
+    }
+  else if (!g_atomic_ref_count_dec (&node->ref_count))
+    return;
+
+  GSK_RENDER_NODE_GET_CLASS (node)->finalize (node);
 }
 
 
@@ -551,9 +786,143 @@ gsk_render_node_diff (GskRenderNode  *node1,
   if (_gsk_render_node_get_node_type (node1) != _gsk_render_node_get_node_type (node2))
     return gsk_render_node_diff_impossible (node1, node2, region);
 
+  /* Widgets often recreate identical subtrees; skip those wholesale */
+  if (gsk_render_node_equal (node1, node2))
+    return;
+
   return GSK_RENDER_NODE_GET_CLASS (node1)->diff (node1, node2, region);
 }
 
+/*< private >
+ * gsk_render_node_get_hash:
+ * @node: a #GskRenderNode
+ *
+ * Gets a hash of the contents of @node, such that nodes that
+ * compare equal with gsk_render_node_equal() have the same hash.
+ *
+ * The hash is computed on first use and cached in the node,
+ * which is fine because nodes are immutable.
+ *
+ * Returns: the structural hash of @node
+ */
+guint
+gsk_render_node_get_hash (GskRenderNode *node)
+{
+  guint hash;
+
+  hash = node->hash;
+  if (G_UNLIKELY (hash == 0))
+    {
+      hash = GSK_RENDER_NODE_GET_CLASS (node)->hash (node);
+      /* 0 means "not computed" */
+      if (hash == 0)
+        hash = 1;
+      node->hash = hash;
+    }
+
+  return hash;
+}
+
+/*< private >
+ * gsk_render_node_equal:
+ * @node1: a #GskRenderNode
+ * @node2: the #GskRenderNode to compare with
+ *
+ * Checks if @node1 and @node2 render the same content.
+ *
+ * Nodes with different hashes are rejected without looking at
+ * their contents, so comparing unequal trees is cheap. Node types
+ * that don't implement structural equality only compare equal to
+ * themselves.
+ *
+ * Returns: %TRUE if the two nodes are equal
+ */
+gboolean
+gsk_render_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  if (node1 == node2)
+    return TRUE;
+
+  if (_gsk_render_node_get_node_type (node1) != _gsk_render_node_get_node_type (node2))
+    return FALSE;
+
+  if (gsk_render_node_get_hash (node1) != gsk_render_node_get_hash (node2))
+    return FALSE;
+
+  if (!graphene_rect_equal (&node1->bounds, &node2->bounds))
+    return FALSE;
+
+  return GSK_RENDER_NODE_GET_CLASS (node1)->equal (node1, node2);
+}
+
+static guint
+intern_hash (gconstpointer key)
+{
+  return gsk_render_node_get_hash ((GskRenderNode *) key);
+}
+
+static gboolean
+intern_equal (gconstpointer a,
+              gconstpointer b)
+{
+  return gsk_render_node_equal ((GskRenderNode *) a, (GskRenderNode *) b);
+}
+
+/*< private >
+ * gsk_render_node_intern:
+ * @node: (transfer full): a #GskRenderNode
+ *
+ * Looks up a node equal to @node in the global table of interned
+ * nodes, adding @node if there is none yet.
+ *
+ * This is meant for leaf nodes that are created over and over with
+ * the same contents, so that all copies share one instance and
+ * compare equal by pointer. The table does not hold a reference;
+ * nodes leave it when their last reference is dropped.
+ *
+ * Returns: (transfer full): the interned node, which may or may
+ *   not be @node
+ */
+GskRenderNode *
+gsk_render_node_intern (GskRenderNode *node)
+{
+  GskRenderNode *interned;
+
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
+
+  if (node->interned)
+    return node;
+
+  /* Make sure the hash is computed outside the lock */
+  gsk_render_node_get_hash (node);
+
+  g_mutex_lock (&intern_lock);
+
+  if (intern_table == NULL)
+    intern_table = g_hash_table_new (intern_hash, intern_equal);
+
+  interned = g_hash_table_lookup (intern_table, node);
+  if (interned != NULL)
+    {
+      g_atomic_ref_count_inc (&interned->ref_count);
+    }
+  else
+    {
+      node->interned = TRUE;
+      g_hash_table_add (intern_table, node);
+    }
+
+  g_mutex_unlock (&intern_lock);
+
+  if (interned == NULL)
+    return node;
+
+  gsk_render_node_unref (node);
+
+  return interned;
+}
+
 /**
  * gsk_render_node_write_to_file:
  * @node: a #GskRenderNode
@@ -597,8 +966,9 @@ gsk_render_node_write_to_file (GskRenderNode *node,
  * @error_func: (nullable) (scope call): Callback on parsing errors or %NULL
  * @user_data: (closure error_func): user_data for @error_func
  *
- * Loads data previously created via gsk_render_node_serialize(). For a
- * discussion of the supported format, see that function.
+ * Loads data previously created via gsk_render_node_serialize() or
+ * gsk_render_node_serialize_binary(). For a discussion of the supported
+ * formats, see those functions.
  *
  * Returns: (nullable) (transfer full): a new #GskRenderNode or %NULL on
  *     error.
@@ -0,0 +1,1591 @@
+/*
+ * Copyright © 2021 GTK developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gskrendernodebinaryprivate.h"
+
+#include "gskrendernodeprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
+
+#include <gtk/css/gtkcss.h>
+
+#include <string.h>
+
+/* The binary format is meant to be fast to load and mappable. Everything
+ * is stored as little-endian 32bit words, so the node data can be read
+ * in place. Strings (font names, transforms, debug messages, shader
+ * sources and arguments) and textures are interned and stored once,
+ * no matter how many nodes refer to them.
+ *
+ *   header:    magic[8], version, n_strings, strings_offset,
+ *              n_textures, textures_offset, root_offset
+ *   strings:   n_strings * { offset, length }
+ *   textures:  n_textures * { width, height, format, stride, offset }
+ *   nodes:     the root node, children following their parent
+ *   blobs:     string data, each one NUL-terminated and padded to 4 bytes
+ *   pixels:    texture data, each one aligned to 16 bytes
+ *
+ * Texture pixels are used without copying, so loading a mapped file
+ * does not need to touch the pixels until they are drawn.
+ */
+
+static const guchar binary_magic[8] = { 0x89, 'G', 'S', 'K', '\r', '\n', 0x1a, '\n' };
+
+#define BINARY_VERSION 1
+#define HEADER_SIZE (sizeof (binary_magic) + 6 * sizeof (guint32))
+#define STRING_ENTRY_SIZE (2 * sizeof (guint32))
+#define TEXTURE_ENTRY_SIZE (5 * sizeof (guint32))
+#define TEXTURE_ALIGNMENT 16
+#define NO_INDEX G_MAXUINT32
+#define MAX_DEPTH 1024
+
+typedef union {
+  float f;
+  guint32 u;
+} FloatBits;
+
+/* {{{ Writing */
+
+typedef struct
+{
+  GByteArray *nodes;
+  GPtrArray *strings;           /* GBytes, without the terminating NUL */
+  GHashTable *string_indices;   /* GBytes -> index + 1 */
+  GPtrArray *textures;
+  GHashTable *texture_indices;  /* GdkTexture -> index + 1 */
+} Writer;
+
+static void
+writer_init (Writer *self)
+{
+  self->nodes = g_byte_array_new ();
+  self->strings = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+  self->string_indices = g_hash_table_new (g_bytes_hash, g_bytes_equal);
+  self->textures = g_ptr_array_new_with_free_func (g_object_unref);
+  self->texture_indices = g_hash_table_new (NULL, NULL);
+}
+
+static void
+writer_clear (Writer *self)
+{
+  g_byte_array_unref (self->nodes);
+  g_hash_table_unref (self->string_indices);
+  g_ptr_array_unref (self->strings);
+  g_hash_table_unref (self->texture_indices);
+  g_ptr_array_unref (self->textures);
+}
+
+static void
+append_u32 (GByteArray *array,
+            guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (guint32));
+}
+
+static void
+set_u32 (GByteArray *array,
+         gsize       offset,
+         guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+  memcpy (array->data + offset, &value, sizeof (guint32));
+}
+
+static void
+append_padding (GByteArray *array,
+                gsize       alignment)
+{
+  static const guint8 zeroes[TEXTURE_ALIGNMENT] = { 0, };
+
+  if (array->len % alignment)
+    g_byte_array_append (array, zeroes, alignment - array->len % alignment);
+}
+
+static void
+write_u32 (Writer  *self,
+           guint32  value)
+{
+  append_u32 (self->nodes, value);
+}
+
+static void
+write_float (Writer *self,
+             float   value)
+{
+  FloatBits bits = { .f = value };
+
+  append_u32 (self->nodes, bits.u);
+}
+
+static void
+write_point (Writer                 *self,
+             const graphene_point_t *point)
+{
+  write_float (self, point->x);
+  write_float (self, point->y);
+}
+
+static void
+write_rect (Writer                *self,
+            const graphene_rect_t *rect)
+{
+  write_float (self, rect->origin.x);
+  write_float (self, rect->origin.y);
+  write_float (self, rect->size.width);
+  write_float (self, rect->size.height);
+}
+
+static void
+write_rounded_rect (Writer               *self,
+                    const GskRoundedRect *rect)
+{
+  guint i;
+
+  write_rect (self, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      write_float (self, rect->corner[i].width);
+      write_float (self, rect->corner[i].height);
+    }
+}
+
+static void
+write_rgba (Writer        *self,
+            const GdkRGBA *rgba)
+{
+  write_float (self, rgba->red);
+  write_float (self, rgba->green);
+  write_float (self, rgba->blue);
+  write_float (self, rgba->alpha);
+}
+
+static void
+write_color_stops (Writer             *self,
+                   const GskColorStop *stops,
+                   gsize               n_stops)
+{
+  gsize i;
+
+  write_u32 (self, n_stops);
+  for (i = 0; i < n_stops; i++)
+    {
+      write_float (self, stops[i].offset);
+      write_rgba (self, &stops[i].color);
+    }
+}
+
+static void
+write_blob (Writer        *self,
+            gconstpointer  data,
+            gsize          size)
+{
+  GBytes *bytes;
+  guint index;
+
+  bytes = g_bytes_new (data, size);
+  index = GPOINTER_TO_UINT (g_hash_table_lookup (self->string_indices, bytes));
+  if (index == 0)
+    {
+      g_ptr_array_add (self->strings, bytes);
+      index = self->strings->len;
+      g_hash_table_insert (self->string_indices, bytes, GUINT_TO_POINTER (index));
+    }
+  else
+    {
+      g_bytes_unref (bytes);
+    }
+
+  write_u32 (self, index - 1);
+}
+
+static void
+write_string (Writer     *self,
+              const char *string)
+{
+  if (string == NULL)
+    write_u32 (self, NO_INDEX);
+  else
+    write_blob (self, string, strlen (string));
+}
+
+static void
+write_texture (Writer     *self,
+               GdkTexture *texture)
+{
+  guint index;
+
+  index = GPOINTER_TO_UINT (g_hash_table_lookup (self->texture_indices, texture));
+  if (index == 0)
+    {
+      g_ptr_array_add (self->textures, g_object_ref (texture));
+      index = self->textures->len;
+      g_hash_table_insert (self->texture_indices, texture, GUINT_TO_POINTER (index));
+    }
+
+  write_u32 (self, index - 1);
+}
+
+static cairo_status_t
+cairo_write_array (void                *closure,
+                   const unsigned char *data,
+                   unsigned int         length)
+{
+  g_byte_array_append (closure, data, length);
+
+  return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+write_node (Writer        *self,
+            GskRenderNode *node)
+{
+  GskRenderNodeType node_type = gsk_render_node_get_node_type (node);
+  guint i;
+
+  write_u32 (self, node_type);
+
+  switch (node_type)
+    {
+    case GSK_CONTAINER_NODE:
+      write_u32 (self, gsk_container_node_get_n_children (node));
+      for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+        write_node (self, gsk_container_node_get_child (node, i));
+      break;
+
+    case GSK_CAIRO_NODE:
+      {
+        cairo_surface_t *surface = gsk_cairo_node_peek_surface (node);
+
+        write_rect (self, &node->bounds);
+        if (surface != NULL)
+          {
+            GByteArray *array = g_byte_array_new ();
+
+            cairo_surface_write_to_png_stream (surface, cairo_write_array, array);
+            write_blob (self, array->data, array->len);
+            g_byte_array_unref (array);
+          }
+        else
+          {
+            write_u32 (self, NO_INDEX);
+          }
+      }
+      break;
+
+    case GSK_COLOR_NODE:
+      write_rect (self, &node->bounds);
+      write_rgba (self, gsk_color_node_peek_color (node));
+      break;
+
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      write_rect (self, &node->bounds);
+      write_point (self, gsk_linear_gradient_node_peek_start (node));
+      write_point (self, gsk_linear_gradient_node_peek_end (node));
+      write_color_stops (self,
+                         gsk_linear_gradient_node_peek_color_stops (node, NULL),
+                         gsk_linear_gradient_node_get_n_color_stops (node));
+      break;
+
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+      write_rect (self, &node->bounds);
+      write_point (self, gsk_radial_gradient_node_peek_center (node));
+      write_float (self, gsk_radial_gradient_node_get_hradius (node));
+      write_float (self, gsk_radial_gradient_node_get_vradius (node));
+      write_float (self, gsk_radial_gradient_node_get_start (node));
+      write_float (self, gsk_radial_gradient_node_get_end (node));
+      write_color_stops (self,
+                         gsk_radial_gradient_node_peek_color_stops (node, NULL),
+                         gsk_radial_gradient_node_get_n_color_stops (node));
+      break;
+
+    case GSK_BORDER_NODE:
+      write_rounded_rect (self, gsk_border_node_peek_outline (node));
+      for (i = 0; i < 4; i++)
+        write_float (self, gsk_border_node_peek_widths (node)[i]);
+      for (i = 0; i < 4; i++)
+        write_rgba (self, &gsk_border_node_peek_colors (node)[i]);
+      break;
+
+    case GSK_TEXTURE_NODE:
+      write_rect (self, &node->bounds);
+      write_texture (self, gsk_texture_node_get_texture (node));
+      break;
+
+    case GSK_INSET_SHADOW_NODE:
+      write_rounded_rect (self, gsk_inset_shadow_node_peek_outline (node));
+      write_rgba (self, gsk_inset_shadow_node_peek_color (node));
+      write_float (self, gsk_inset_shadow_node_get_dx (node));
+      write_float (self, gsk_inset_shadow_node_get_dy (node));
+      write_float (self, gsk_inset_shadow_node_get_spread (node));
+      write_float (self, gsk_inset_shadow_node_get_blur_radius (node));
+      break;
+
+    case GSK_OUTSET_SHADOW_NODE:
+      write_rounded_rect (self, gsk_outset_shadow_node_peek_outline (node));
+      write_rgba (self, gsk_outset_shadow_node_peek_color (node));
+      write_float (self, gsk_outset_shadow_node_get_dx (node));
+      write_float (self, gsk_outset_shadow_node_get_dy (node));
+      write_float (self, gsk_outset_shadow_node_get_spread (node));
+      write_float (self, gsk_outset_shadow_node_get_blur_radius (node));
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        char *transform = gsk_transform_to_string (gsk_transform_node_get_transform (node));
+
+        write_string (self, transform);
+        g_free (transform);
+        write_node (self, gsk_transform_node_get_child (node));
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      write_float (self, gsk_opacity_node_get_opacity (node));
+      write_node (self, gsk_opacity_node_get_child (node));
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        float values[16];
+
+        graphene_matrix_to_float (gsk_color_matrix_node_peek_color_matrix (node), values);
+        for (i = 0; i < 16; i++)
+          write_float (self, values[i]);
+        graphene_vec4_to_float (gsk_color_matrix_node_peek_color_offset (node), values);
+        for (i = 0; i < 4; i++)
+          write_float (self, values[i]);
+        write_node (self, gsk_color_matrix_node_get_child (node));
+      }
+      break;
+
+    case GSK_REPEAT_NODE:
+      write_rect (self, &node->bounds);
+      write_rect (self, gsk_repeat_node_peek_child_bounds (node));
+      write_node (self, gsk_repeat_node_get_child (node));
+      break;
+
+    case GSK_CLIP_NODE:
+      write_rect (self, gsk_clip_node_peek_clip (node));
+      write_node (self, gsk_clip_node_get_child (node));
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      write_rounded_rect (self, gsk_rounded_clip_node_peek_clip (node));
+      write_node (self, gsk_rounded_clip_node_get_child (node));
+      break;
+
+    case GSK_SHADOW_NODE:
+      write_u32 (self, gsk_shadow_node_get_n_shadows (node));
+      for (i = 0; i < gsk_shadow_node_get_n_shadows (node); i++)
+        {
+          const GskShadow *shadow = gsk_shadow_node_peek_shadow (node, i);
+
+          write_rgba (self, &shadow->color);
+          write_float (self, shadow->dx);
+          write_float (self, shadow->dy);
+          write_float (self, shadow->radius);
+        }
+      write_node (self, gsk_shadow_node_get_child (node));
+      break;
+
+    case GSK_BLEND_NODE:
+      write_u32 (self, gsk_blend_node_get_blend_mode (node));
+      write_node (self, gsk_blend_node_get_bottom_child (node));
+      write_node (self, gsk_blend_node_get_top_child (node));
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      write_float (self, gsk_cross_fade_node_get_progress (node));
+      write_node (self, gsk_cross_fade_node_get_start_child (node));
+      write_node (self, gsk_cross_fade_node_get_end_child (node));
+      break;
+
+    case GSK_TEXT_NODE:
+      {
+        const PangoGlyphInfo *glyphs;
+        PangoFontDescription *desc;
+        char *font_name;
+        guint n_glyphs;
+
+        desc = pango_font_describe (gsk_text_node_peek_font (node));
+        font_name = pango_font_description_to_string (desc);
+        write_string (self, font_name);
+        g_free (font_name);
+        pango_font_description_free (desc);
+
+        write_rgba (self, gsk_text_node_peek_color (node));
+        write_point (self, gsk_text_node_get_offset (node));
+
+        glyphs = gsk_text_node_peek_glyphs (node, &n_glyphs);
+        write_u32 (self, n_glyphs);
+        for (i = 0; i < n_glyphs; i++)
+          {
+            write_u32 (self, glyphs[i].glyph);
+            write_u32 (self, glyphs[i].geometry.width);
+            write_u32 (self, glyphs[i].geometry.x_offset);
+            write_u32 (self, glyphs[i].geometry.y_offset);
+            write_u32 (self, glyphs[i].attr.is_cluster_start);
+          }
+      }
+      break;
+
+    case GSK_BLUR_NODE:
+      write_float (self, gsk_blur_node_get_radius (node));
+      write_node (self, gsk_blur_node_get_child (node));
+      break;
+
+    case GSK_DEBUG_NODE:
+      write_string (self, gsk_debug_node_get_message (node));
+      write_node (self, gsk_debug_node_get_child (node));
+      break;
+
+    case GSK_GL_SHADER_NODE:
+      {
+        GskGLShader *shader = gsk_gl_shader_node_get_shader (node);
+        GBytes *source = gsk_gl_shader_get_source (shader);
+        GBytes *args = gsk_gl_shader_node_get_args (node);
+
+        write_rect (self, &node->bounds);
+        write_blob (self, g_bytes_get_data (source, NULL), g_bytes_get_size (source));
+        write_blob (self, g_bytes_get_data (args, NULL), g_bytes_get_size (args));
+        write_u32 (self, gsk_gl_shader_node_get_n_children (node));
+        for (i = 0; i < gsk_gl_shader_node_get_n_children (node); i++)
+          write_node (self, gsk_gl_shader_node_get_child (node, i));
+      }
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      g_error ("Unhandled node: %s", g_type_name_from_instance ((GTypeInstance *) node));
+      break;
+    }
+}
+
+static GBytes *
+writer_finish (Writer *self)
+{
+  GByteArray *out;
+  gsize strings_offset, textures_offset, root_offset;
+  guint i;
+
+  out = g_byte_array_new ();
+
+  g_byte_array_append (out, binary_magic, sizeof (binary_magic));
+  append_u32 (out, BINARY_VERSION);
+  append_u32 (out, self->strings->len);
+  append_u32 (out, 0);
+  append_u32 (out, self->textures->len);
+  append_u32 (out, 0);
+  append_u32 (out, 0);
+
+  /* The tables get filled in once we know where the data goes */
+  strings_offset = out->len;
+  g_byte_array_set_size (out, out->len + self->strings->len * STRING_ENTRY_SIZE);
+  textures_offset = out->len;
+  g_byte_array_set_size (out, out->len + self->textures->len * TEXTURE_ENTRY_SIZE);
+
+  root_offset = out->len;
+  g_byte_array_append (out, self->nodes->data, self->nodes->len);
+
+  for (i = 0; i < self->strings->len; i++)
+    {
+      GBytes *bytes = g_ptr_array_index (self->strings, i);
+      gsize entry = strings_offset + i * STRING_ENTRY_SIZE;
+
+      set_u32 (out, entry, out->len);
+      set_u32 (out, entry + sizeof (guint32), g_bytes_get_size (bytes));
+      g_byte_array_append (out, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+      g_byte_array_append (out, (const guint8 *) "", 1);
+      append_padding (out, sizeof (guint32));
+    }
+
+  for (i = 0; i < self->textures->len; i++)
+    {
+      GdkTexture *texture = g_ptr_array_index (self->textures, i);
+      gsize entry = textures_offset + i * TEXTURE_ENTRY_SIZE;
+      int width = gdk_texture_get_width (texture);
+      int height = gdk_texture_get_height (texture);
+      gsize stride = width * 4;
+      gsize offset;
+
+      append_padding (out, TEXTURE_ALIGNMENT);
+      offset = out->len;
+
+      set_u32 (out, entry, width);
+      set_u32 (out, entry + 4, height);
+      set_u32 (out, entry + 8, GDK_MEMORY_DEFAULT);
+      set_u32 (out, entry + 12, stride);
+      set_u32 (out, entry + 16, offset);
+
+      g_byte_array_set_size (out, offset + stride * height);
+      gdk_texture_download (texture, out->data + offset, stride);
+    }
+
+  set_u32 (out, sizeof (binary_magic) + 2 * sizeof (guint32), strings_offset);
+  set_u32 (out, sizeof (binary_magic) + 4 * sizeof (guint32), textures_offset);
+  set_u32 (out, sizeof (binary_magic) + 5 * sizeof (guint32), root_offset);
+
+  return g_byte_array_free_to_bytes (out);
+}
+
+/**
+ * gsk_render_node_serialize_binary:
+ * @node: a #GskRenderNode
+ *
+ * Serializes the @node like gsk_render_node_serialize(), but into a
+ * compact binary format that is much faster to load.
+ *
+ * gsk_render_node_deserialize() accepts both formats. The same caveats
+ * as for gsk_render_node_serialize() apply: this is not meant as a
+ * permanent storage format, and only the same version of GTK is
+ * guaranteed to be able to load it. Files that are meant to be read or
+ * edited by humans should use the text format.
+ *
+ * Returns: a #GBytes representing the node.
+ **/
+GBytes *
+gsk_render_node_serialize_binary (GskRenderNode *node)
+{
+  Writer writer;
+  GBytes *result;
+
+  g_return_val_if_fail (GSK_IS_RENDER_NODE (node), NULL);
+
+  writer_init (&writer);
+  write_node (&writer, node);
+  result = writer_finish (&writer);
+  writer_clear (&writer);
+
+  return result;
+}
+
+/* }}} */
+/* {{{ Reading */
+
+typedef struct
+{
+  GBytes *bytes;
+  const guchar *data;
+  gsize size;
+  gsize pos;
+
+  guint32 n_strings;
+  gsize strings_offset;
+  guint32 n_textures;
+  gsize textures_offset;
+
+  /* Loaded on first use, indexed like the tables */
+  GdkTexture **textures;
+  PangoFont **fonts;
+  GskGLShader **shaders;
+  PangoContext *font_context;
+
+  GskParseErrorFunc error_func;
+  gpointer user_data;
+  gboolean failed;
+} Reader;
+
+static void G_GNUC_PRINTF (2, 3)
+reader_error (Reader     *self,
+              const char *format,
+              ...)
+{
+  GtkCssLocation location = { 0, };
+  GtkCssSection *section;
+  GError *error;
+  va_list args;
+
+  /* Offsets are meaningless once we're out of sync, so only report
+   * the first error */
+  if (self->failed)
+    return;
+  self->failed = TRUE;
+
+  if (self->error_func == NULL)
+    return;
+
+  va_start (args, format);
+  error = g_error_new_valist (GTK_CSS_PARSER_ERROR, GTK_CSS_PARSER_ERROR_SYNTAX, format, args);
+  va_end (args);
+
+  location.bytes = self->pos;
+  location.chars = self->pos;
+  location.line_bytes = self->pos;
+  location.line_chars = self->pos;
+  section = gtk_css_section_new (NULL, &location, &location);
+
+  self->error_func (section, error, self->user_data);
+
+  gtk_css_section_unref (section);
+  g_error_free (error);
+}
+
+static guint32
+get_u32 (const guchar *data)
+{
+  guint32 value;
+
+  memcpy (&value, data, sizeof (guint32));
+
+  return GUINT32_FROM_LE (value);
+}
+
+static guint32
+read_u32 (Reader *self)
+{
+  guint32 value;
+
+  if (self->failed)
+    return 0;
+
+  if (self->size - self->pos < sizeof (guint32))
+    {
+      reader_error (self, "Unexpected end of data");
+      return 0;
+    }
+
+  value = get_u32 (self->data + self->pos);
+  self->pos += sizeof (guint32);
+
+  return value;
+}
+
+static float
+read_float (Reader *self)
+{
+  FloatBits bits = { .u = read_u32 (self) };
+
+  return bits.f;
+}
+
+/* Checks that @n_items items of at least @item_size bytes can still
+ * follow, so corrupt counts don't make us allocate huge arrays */
+static gboolean
+check_count (Reader *self,
+             guint32 n_items,
+             gsize   item_size)
+{
+  if (self->failed)
+    return FALSE;
+
+  if (n_items > (self->size - self->pos) / item_size)
+    {
+      reader_error (self, "Invalid count %u", n_items);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+read_point (Reader           *self,
+            graphene_point_t *point)
+{
+  point->x = read_float (self);
+  point->y = read_float (self);
+}
+
+static void
+read_rect (Reader          *self,
+           graphene_rect_t *rect)
+{
+  rect->origin.x = read_float (self);
+  rect->origin.y = read_float (self);
+  rect->size.width = read_float (self);
+  rect->size.height = read_float (self);
+}
+
+static void
+read_rounded_rect (Reader         *self,
+                   GskRoundedRect *rect)
+{
+  guint i;
+
+  read_rect (self, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      rect->corner[i].width = read_float (self);
+      rect->corner[i].height = read_float (self);
+    }
+}
+
+static void
+read_rgba (Reader  *self,
+           GdkRGBA *rgba)
+{
+  rgba->red = read_float (self);
+  rgba->green = read_float (self);
+  rgba->blue = read_float (self);
+  rgba->alpha = read_float (self);
+}
+
+static GskColorStop *
+read_color_stops (Reader *self,
+                  gsize  *n_stops)
+{
+  GskColorStop *stops;
+  gsize i;
+
+  *n_stops = read_u32 (self);
+  if (!check_count (self, *n_stops, 5 * sizeof (guint32)))
+    return NULL;
+
+  stops = g_new (GskColorStop, *n_stops);
+  for (i = 0; i < *n_stops; i++)
+    {
+      stops[i].offset = read_float (self);
+      read_rgba (self, &stops[i].color);
+    }
+
+  return stops;
+}
+
+/* Returns a pointer into the data, or %NULL for NO_INDEX */
+static const char *
+read_blob (Reader  *self,
+           guint32 *out_index,
+           gsize   *size)
+{
+  guint32 index;
+  const guchar *entry;
+  gsize offset;
+
+  *size = 0;
+
+  index = read_u32 (self);
+  *out_index = index;
+  if (self->failed || index == NO_INDEX)
+    return NULL;
+
+  if (index >= self->n_strings)
+    {
+      reader_error (self, "Invalid string index %u", index);
+      return NULL;
+    }
+
+  entry = self->data + self->strings_offset + index * STRING_ENTRY_SIZE;
+  offset = get_u32 (entry);
+  *size = get_u32 (entry + sizeof (guint32));
+
+  /* The terminating NUL must be inside the data, too */
+  if (offset > self->size || *size >= self->size - offset ||
+      self->data[offset + *size] != '\0')
+    {
+      reader_error (self, "Invalid string %u", index);
+      *size = 0;
+      return NULL;
+    }
+
+  return (const char *) self->data + offset;
+}
+
+static const char *
+read_string (Reader *self)
+{
+  guint32 index;
+  gsize size;
+
+  return read_blob (self, &index, &size);
+}
+
+static guint32
+read_index (Reader  *self,
+            guint32  n_items)
+{
+  guint32 index;
+
+  index = read_u32 (self);
+  if (!self->failed && index >= n_items)
+    {
+      reader_error (self, "Invalid index %u", index);
+      return NO_INDEX;
+    }
+
+  return index;
+}
+
+static GdkTexture *
+read_texture (Reader *self)
+{
+  const guchar *entry;
+  guint32 index, width, height, format, stride, offset;
+  GBytes *pixels;
+
+  index = read_index (self, self->n_textures);
+  if (self->failed)
+    return NULL;
+
+  if (self->textures[index])
+    return g_object_ref (self->textures[index]);
+
+  entry = self->data + self->textures_offset + index * TEXTURE_ENTRY_SIZE;
+  width = get_u32 (entry);
+  height = get_u32 (entry + 4);
+  format = get_u32 (entry + 8);
+  stride = get_u32 (entry + 12);
+  offset = get_u32 (entry + 16);
+
+  if (width == 0 || height == 0 || width > G_MAXINT / 4 ||
+      format >= GDK_MEMORY_N_FORMATS ||
+      gdk_memory_format_is_deep (format) ||
+      stride < width * 4 ||
+      offset > self->size ||
+      (self->size - offset) / stride < height)
+    {
+      reader_error (self, "Invalid texture %u", index);
+      return NULL;
+    }
+
+  pixels = g_bytes_new_from_bytes (self->bytes, offset, (gsize) stride * height);
+  self->textures[index] = gdk_memory_texture_new (width, height, format, pixels, stride);
+  g_bytes_unref (pixels);
+
+  return g_object_ref (self->textures[index]);
+}
+
+static PangoFont *
+read_font (Reader *self)
+{
+  const char *name;
+  guint32 index;
+  gsize size;
+
+  name = read_blob (self, &index, &size);
+  if (name == NULL)
+    {
+      reader_error (self, "Text nodes need a font");
+      return NULL;
+    }
+
+  if (self->fonts[index] == NULL)
+    {
+      PangoFontDescription *desc;
+
+      if (self->font_context == NULL)
+        self->font_context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+
+      desc = pango_font_description_from_string (name);
+      self->fonts[index] = pango_context_load_font (self->font_context, desc);
+      pango_font_description_free (desc);
+
+      if (self->fonts[index] == NULL)
+        {
+          reader_error (self, "Failed to load font \"%s\"", name);
+          return NULL;
+        }
+    }
+
+  return g_object_ref (self->fonts[index]);
+}
+
+static GskGLShader *
+read_shader (Reader *self)
+{
+  const char *source;
+  guint32 index;
+  gsize size;
+
+  source = read_blob (self, &index, &size);
+  if (source == NULL)
+    {
+      reader_error (self, "Shader nodes need a shader");
+      return NULL;
+    }
+
+  if (self->shaders[index] == NULL)
+    {
+      GBytes *bytes = g_bytes_new_from_bytes (self->bytes, (const guchar *) source - self->data, size);
+
+      self->shaders[index] = gsk_gl_shader_new_from_bytes (bytes);
+      g_bytes_unref (bytes);
+    }
+
+  return g_object_ref (self->shaders[index]);
+}
+
+static GskRenderNode *read_node (Reader *self,
+                                 guint   depth);
+
+static GskRenderNode **
+read_children (Reader *self,
+               guint   depth,
+               guint  *n_children)
+{
+  GskRenderNode **children;
+  guint i;
+
+  *n_children = read_u32 (self);
+  if (!check_count (self, *n_children, sizeof (guint32)))
+    return NULL;
+
+  children = g_new0 (GskRenderNode *, MAX (*n_children, 1));
+  for (i = 0; i < *n_children; i++)
+    {
+      children[i] = read_node (self, depth + 1);
+      if (children[i] == NULL)
+        {
+          while (i-- > 0)
+            gsk_render_node_unref (children[i]);
+          g_free (children);
+          return NULL;
+        }
+    }
+
+  return children;
+}
+
+static void
+free_children (GskRenderNode **children,
+               guint           n_children)
+{
+  guint i;
+
+  for (i = 0; i < n_children; i++)
+    gsk_render_node_unref (children[i]);
+  g_free (children);
+}
+
+static GskRenderNode *
+read_node (Reader *self,
+           guint   depth)
+{
+  GskRenderNode *node = NULL;
+  GskRenderNodeType node_type;
+
+  if (depth > MAX_DEPTH)
+    {
+      reader_error (self, "Nodes are nested too deeply");
+      return NULL;
+    }
+
+  node_type = read_u32 (self);
+  if (self->failed)
+    return NULL;
+
+  switch (node_type)
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        GskRenderNode **children;
+        guint n_children;
+
+        children = read_children (self, depth, &n_children);
+        if (children == NULL)
+          return NULL;
+
+        node = gsk_container_node_new (children, n_children);
+        free_children (children, n_children);
+      }
+      break;
+
+    case GSK_CAIRO_NODE:
+      {
+        graphene_rect_t bounds;
+        const char *png;
+        guint32 index;
+        gsize size;
+
+        read_rect (self, &bounds);
+        png = read_blob (self, &index, &size);
+        if (self->failed)
+          return NULL;
+
+        node = gsk_cairo_node_new (&bounds);
+        if (png != NULL)
+          {
+            GInputStream *stream;
+            GdkPixbuf *pixbuf;
+
+            stream = g_memory_input_stream_new_from_data (png, size, NULL);
+            pixbuf = gdk_pixbuf_new_from_stream (stream, NULL, NULL);
+            g_object_unref (stream);
+
+            if (pixbuf == NULL)
+              {
+                reader_error (self, "Invalid cairo node pixels");
+                gsk_render_node_unref (node);
+                return NULL;
+              }
+            else
+              {
+                cairo_t *cr = gsk_cairo_node_get_draw_context (node);
+
+                gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+                cairo_paint (cr);
+                cairo_destroy (cr);
+                g_object_unref (pixbuf);
+              }
+          }
+      }
+      break;
+
+    case GSK_COLOR_NODE:
+      {
+        graphene_rect_t bounds;
+        GdkRGBA color;
+
+        read_rect (self, &bounds);
+        read_rgba (self, &color);
+        if (self->failed)
+          return NULL;
+
+        /* Recordings repeat the same backgrounds a lot, share them */
+        node = gsk_render_node_intern (gsk_color_node_new (&color, &bounds));
+      }
+      break;
+
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      {
+        graphene_rect_t bounds;
+        graphene_point_t start, end;
+        GskColorStop *stops;
+        gsize n_stops;
+
+        read_rect (self, &bounds);
+        read_point (self, &start);
+        read_point (self, &end);
+        stops = read_color_stops (self, &n_stops);
+        if (self->failed)
+          {
+            g_free (stops);
+            return NULL;
+          }
+        if (n_stops < 2)
+          {
+            reader_error (self, "Gradients need at least 2 color stops");
+            g_free (stops);
+            return NULL;
+          }
+
+        if (node_type == GSK_REPEATING_LINEAR_GRADIENT_NODE)
+          node = gsk_repeating_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+        else
+          node = gsk_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+        g_free (stops);
+      }
+      break;
+
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+      {
+        graphene_rect_t bounds;
+        graphene_point_t center;
+        float hradius, vradius, start, end;
+        GskColorStop *stops;
+        gsize n_stops;
+
+        read_rect (self, &bounds);
+        read_point (self, &center);
+        hradius = read_float (self);
+        vradius = read_float (self);
+        start = read_float (self);
+        end = read_float (self);
+        stops = read_color_stops (self, &n_stops);
+        if (self->failed)
+          {
+            g_free (stops);
+            return NULL;
+          }
+        if (n_stops < 2)
+          {
+            reader_error (self, "Gradients need at least 2 color stops");
+            g_free (stops);
+            return NULL;
+          }
+
+        if (node_type == GSK_REPEATING_RADIAL_GRADIENT_NODE)
+          node = gsk_repeating_radial_gradient_node_new (&bounds, &center, hradius, vradius,
+                                                         start, end, stops, n_stops);
+        else
+          node = gsk_radial_gradient_node_new (&bounds, &center, hradius, vradius,
+                                               start, end, stops, n_stops);
+        g_free (stops);
+      }
+      break;
+
+    case GSK_BORDER_NODE:
+      {
+        GskRoundedRect outline;
+        float widths[4];
+        GdkRGBA colors[4];
+        guint i;
+
+        read_rounded_rect (self, &outline);
+        for (i = 0; i < 4; i++)
+          widths[i] = read_float (self);
+        for (i = 0; i < 4; i++)
+          read_rgba (self, &colors[i]);
+        if (self->failed)
+          return NULL;
+
+        node = gsk_border_node_new (&outline, widths, colors);
+      }
+      break;
+
+    case GSK_TEXTURE_NODE:
+      {
+        graphene_rect_t bounds;
+        GdkTexture *texture;
+
+        read_rect (self, &bounds);
+        texture = read_texture (self);
+        if (texture == NULL)
+          return NULL;
+
+        node = gsk_render_node_intern (gsk_texture_node_new (texture, &bounds));
+        g_object_unref (texture);
+      }
+      break;
+
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+      {
+        GskRoundedRect outline;
+        GdkRGBA color;
+        float dx, dy, spread, blur_radius;
+
+        read_rounded_rect (self, &outline);
+        read_rgba (self, &color);
+        dx = read_float (self);
+        dy = read_float (self);
+        spread = read_float (self);
+        blur_radius = read_float (self);
+        if (self->failed)
+          return NULL;
+
+        if (node_type == GSK_INSET_SHADOW_NODE)
+          node = gsk_inset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+        else
+          node = gsk_outset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+      }
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskTransform *transform = NULL;
+        GskRenderNode *child;
+        const char *string;
+
+        string = read_string (self);
+        if (string == NULL || !gsk_transform_parse (string, &transform))
+          {
+            reader_error (self, "Invalid transform");
+            return NULL;
+          }
+
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          {
+            gsk_transform_unref (transform);
+            return NULL;
+          }
+
+        node = gsk_transform_node_new (child, transform);
+        gsk_transform_unref (transform);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      {
+        GskRenderNode *child;
+        float opacity;
+
+        opacity = read_float (self);
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_opacity_node_new (child, opacity);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        graphene_matrix_t matrix;
+        graphene_vec4_t offset;
+        GskRenderNode *child;
+        float values[16];
+        guint i;
+
+        for (i = 0; i < 16; i++)
+          values[i] = read_float (self);
+        graphene_matrix_init_from_float (&matrix, values);
+        for (i = 0; i < 4; i++)
+          values[i] = read_float (self);
+        graphene_vec4_init_from_float (&offset, values);
+
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_color_matrix_node_new (child, &matrix, &offset);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_REPEAT_NODE:
+      {
+        graphene_rect_t bounds, child_bounds;
+        GskRenderNode *child;
+
+        read_rect (self, &bounds);
+        read_rect (self, &child_bounds);
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_repeat_node_new (&bounds, child, &child_bounds);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_CLIP_NODE:
+      {
+        graphene_rect_t clip;
+        GskRenderNode *child;
+
+        read_rect (self, &clip);
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_clip_node_new (child, &clip);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      {
+        GskRoundedRect clip;
+        GskRenderNode *child;
+
+        read_rounded_rect (self, &clip);
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_rounded_clip_node_new (child, &clip);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_SHADOW_NODE:
+      {
+        GskShadow *shadows;
+        GskRenderNode *child;
+        guint32 n_shadows, i;
+
+        n_shadows = read_u32 (self);
+        if (!check_count (self, n_shadows, 7 * sizeof (guint32)))
+          return NULL;
+        if (n_shadows == 0)
+          {
+            reader_error (self, "Shadow nodes need at least one shadow");
+            return NULL;
+          }
+
+        shadows = g_new (GskShadow, n_shadows);
+        for (i = 0; i < n_shadows; i++)
+          {
+            read_rgba (self, &shadows[i].color);
+            shadows[i].dx = read_float (self);
+            shadows[i].dy = read_float (self);
+            shadows[i].radius = read_float (self);
+          }
+
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          {
+            g_free (shadows);
+            return NULL;
+          }
+
+        node = gsk_shadow_node_new (child, shadows, n_shadows);
+        gsk_render_node_unref (child);
+        g_free (shadows);
+      }
+      break;
+
+    case GSK_BLEND_NODE:
+      {
+        GskRenderNode *bottom, *top;
+        GskBlendMode mode;
+
+        mode = read_u32 (self);
+        if (!self->failed && mode > GSK_BLEND_MODE_LUMINOSITY)
+          {
+            reader_error (self, "Invalid blend mode %u", mode);
+            return NULL;
+          }
+
+        bottom = read_node (self, depth + 1);
+        if (bottom == NULL)
+          return NULL;
+        top = read_node (self, depth + 1);
+        if (top == NULL)
+          {
+            gsk_render_node_unref (bottom);
+            return NULL;
+          }
+
+        node = gsk_blend_node_new (bottom, top, mode);
+        gsk_render_node_unref (bottom);
+        gsk_render_node_unref (top);
+      }
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      {
+        GskRenderNode *start, *end;
+        float progress;
+
+        progress = read_float (self);
+        start = read_node (self, depth + 1);
+        if (start == NULL)
+          return NULL;
+        end = read_node (self, depth + 1);
+        if (end == NULL)
+          {
+            gsk_render_node_unref (start);
+            return NULL;
+          }
+
+        node = gsk_cross_fade_node_new (start, end, progress);
+        gsk_render_node_unref (start);
+        gsk_render_node_unref (end);
+      }
+      break;
+
+    case GSK_TEXT_NODE:
+      {
+        PangoGlyphString *glyphs;
+        graphene_point_t offset;
+        PangoFont *font;
+        GdkRGBA color;
+        guint32 n_glyphs, i;
+
+        font = read_font (self);
+        if (font == NULL)
+          return NULL;
+
+        read_rgba (self, &color);
+        read_point (self, &offset);
+        n_glyphs = read_u32 (self);
+        if (!check_count (self, n_glyphs, 5 * sizeof (guint32)))
+          {
+            g_object_unref (font);
+            return NULL;
+          }
+
+        glyphs = pango_glyph_string_new ();
+        pango_glyph_string_set_size (glyphs, n_glyphs);
+        for (i = 0; i < n_glyphs; i++)
+          {
+            PangoGlyphInfo *gi = &glyphs->glyphs[i];
+
+            memset (gi, 0, sizeof (PangoGlyphInfo));
+            gi->glyph = read_u32 (self);
+            gi->geometry.width = (gint32) read_u32 (self);
+            gi->geometry.x_offset = (gint32) read_u32 (self);
+            gi->geometry.y_offset = (gint32) read_u32 (self);
+            gi->attr.is_cluster_start = read_u32 (self) ? 1 : 0;
+          }
+
+        if (!self->failed)
+          {
+            node = gsk_text_node_new (font, glyphs, &color, &offset);
+            if (node == NULL)
+              reader_error (self, "Glyphs result in empty text");
+          }
+
+        pango_glyph_string_free (glyphs);
+        g_object_unref (font);
+      }
+      break;
+
+    case GSK_BLUR_NODE:
+      {
+        GskRenderNode *child;
+        float radius;
+
+        radius = read_float (self);
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_blur_node_new (child, radius);
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_DEBUG_NODE:
+      {
+        GskRenderNode *child;
+        const char *message;
+
+        message = read_string (self);
+        child = read_node (self, depth + 1);
+        if (child == NULL)
+          return NULL;
+
+        node = gsk_debug_node_new (child, g_strdup (message));
+        gsk_render_node_unref (child);
+      }
+      break;
+
+    case GSK_GL_SHADER_NODE:
+      {
+        graphene_rect_t bounds;
+        GskGLShader *shader;
+        GskRenderNode **children;
+        const char *args_data;
+        GBytes *args;
+        guint32 args_index;
+        gsize args_size;
+        guint n_children;
+
+        read_rect (self, &bounds);
+        shader = read_shader (self);
+        if (shader == NULL)
+          return NULL;
+
+        args_data = read_blob (self, &args_index, &args_size);
+        if (self->failed || args_size != gsk_gl_shader_get_args_size (shader))
+          {
+            reader_error (self, "Invalid shader arguments");
+            g_object_unref (shader);
+            return NULL;
+          }
+
+        children = read_children (self, depth, &n_children);
+        if (children == NULL)
+          {
+            g_object_unref (shader);
+            return NULL;
+          }
+        if (n_children > 4)
+          {
+            reader_error (self, "Shader nodes can have at most 4 children");
+            free_children (children, n_children);
+            g_object_unref (shader);
+            return NULL;
+          }
+
+        args = g_bytes_new (args_data, args_size);
+        node = gsk_gl_shader_node_new (shader, &bounds, args, children, n_children);
+        g_bytes_unref (args);
+        free_children (children, n_children);
+        g_object_unref (shader);
+      }
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      reader_error (self, "Invalid node type %u", node_type);
+      return NULL;
+    }
+
+  return node;
+}
+
+gboolean
+gsk_render_node_binary_check (GBytes *bytes)
+{
+  gsize size;
+  const guchar *data;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  return size >= sizeof (binary_magic) &&
+         memcmp (data, binary_magic, sizeof (binary_magic)) == 0;
+}
+
+GskRenderNode *
+gsk_render_node_deserialize_binary (GBytes            *bytes,
+                                    GskParseErrorFunc  error_func,
+                                    gpointer           user_data)
+{
+  GskRenderNode *root = NULL;
+  Reader reader = { 0, };
+  guint32 version, root_offset;
+  guint i;
+
+  reader.bytes = bytes;
+  reader.data = g_bytes_get_data (bytes, &reader.size);
+  reader.error_func = error_func;
+  reader.user_data = user_data;
+
+  if (reader.size < HEADER_SIZE)
+    {
+      reader_error (&reader, "Truncated header");
+      return NULL;
+    }
+
+  reader.pos = sizeof (binary_magic);
+  version = read_u32 (&reader);
+  if (version != BINARY_VERSION)
+    {
+      reader_error (&reader, "Unsupported version %u", version);
+      return NULL;
+    }
+
+  reader.n_strings = read_u32 (&reader);
+  reader.strings_offset = read_u32 (&reader);
+  reader.n_textures = read_u32 (&reader);
+  reader.textures_offset = read_u32 (&reader);
+  root_offset = read_u32 (&reader);
+
+  if (reader.strings_offset > reader.size ||
+      reader.n_strings > (reader.size - reader.strings_offset) / STRING_ENTRY_SIZE ||
+      reader.textures_offset > reader.size ||
+      reader.n_textures > (reader.size - reader.textures_offset) / TEXTURE_ENTRY_SIZE ||
+      root_offset > reader.size)
+    {
+      reader_error (&reader, "Invalid header");
+      return NULL;
+    }
+
+  reader.textures = g_new0 (GdkTexture *, reader.n_textures);
+  reader.fonts = g_new0 (PangoFont *, reader.n_strings);
+  reader.shaders = g_new0 (GskGLShader *, reader.n_strings);
+
+  reader.pos = root_offset;
+  root = read_node (&reader, 0);
+
+  for (i = 0; i < reader.n_textures; i++)
+    g_clear_object (&reader.textures[i]);
+  for (i = 0; i < reader.n_strings; i++)
+    {
+      g_clear_object (&reader.fonts[i]);
+      g_clear_object (&reader.shaders[i]);
+    }
+  g_free (reader.textures);
+  g_free (reader.fonts);
+  g_free (reader.shaders);
+  g_clear_object (&reader.font_context);
+
+  return root;
+}
+
+/* }}} */
@@ -49,6 +49,90 @@ rectangle_init_from_graphene (cairo_rectangle_int_t *cairo,
   cairo->height = ceilf (graphene->origin.y + graphene->size.height) - cairo->y;
 }
 
+/* Structural hashing helpers. Hashes only need to be equal for nodes
+ * that compare equal, so mixing in the raw float bits is fine as long
+ * as both zeroes end up the same.
+ */
+static inline guint
+hash_combine (guint hash,
+              guint value)
+{
+  return (hash ^ value) * 16777619u;
+}
+
+static inline guint
+hash_float (guint hash,
+            float value)
+{
+  union { float f; guint32 u; } bits;
+
+  bits.f = value == 0.f ? 0.f : value;
+
+  return hash_combine (hash, bits.u);
+}
+
+static guint
+hash_floats (guint        hash,
+             const float *values,
+             gsize        n_values)
+{
+  gsize i;
+
+  for (i = 0; i < n_values; i++)
+    hash = hash_float (hash, values[i]);
+
+  return hash;
+}
+
+static inline guint
+hash_rect (guint                  hash,
+           const graphene_rect_t *rect)
+{
+  return hash_floats (hash, (const float *) rect, 4);
+}
+
+static inline guint
+hash_rounded_rect (guint                 hash,
+                   const GskRoundedRect *rect)
+{
+  return hash_floats (hash, (const float *) rect, 12);
+}
+
+static inline guint
+hash_rgba (guint          hash,
+           const GdkRGBA *rgba)
+{
+  return hash_floats (hash, (const float *) rgba, 4);
+}
+
+static inline guint
+hash_node (GskRenderNode *node)
+{
+  return hash_rect (hash_combine (2166136261u, gsk_render_node_get_node_type (node)),
+                    &node->bounds);
+}
+
+static gboolean
+color_stops_equal (const GskColorStop *stops1,
+                   gsize               n_stops1,
+                   const GskColorStop *stops2,
+                   gsize               n_stops2)
+{
+  gsize i;
+
+  if (n_stops1 != n_stops2)
+    return FALSE;
+
+  for (i = 0; i < n_stops1; i++)
+    {
+      if (stops1[i].offset != stops2[i].offset ||
+          !gdk_rgba_equal (&stops1[i].color, &stops2[i].color))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /*** GSK_COLOR_NODE ***/
 
 struct _GskColorNode
@@ -85,6 +169,24 @@ gsk_color_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_color_node_hash (GskRenderNode *node)
+{
+  GskColorNode *self = (GskColorNode *) node;
+
+  return hash_rgba (hash_node (node), &self->color);
+}
+
+static gboolean
+gsk_color_node_equal (GskRenderNode *node1,
+                      GskRenderNode *node2)
+{
+  GskColorNode *self1 = (GskColorNode *) node1;
+  GskColorNode *self2 = (GskColorNode *) node2;
+
+  return gdk_rgba_equal (&self1->color, &self2->color);
+}
+
 /**
  * gsk_color_node_peek_color:
  * @node: (type GskColorNode): a #GskColorNode
@@ -220,6 +322,32 @@ gsk_linear_gradient_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_linear_gradient_node_hash (GskRenderNode *node)
+{
+  GskLinearGradientNode *self = (GskLinearGradientNode *) node;
+  guint hash;
+
+  hash = hash_node (node);
+  hash = hash_floats (hash, (const float *) &self->start, 2);
+  hash = hash_floats (hash, (const float *) &self->end, 2);
+  hash = hash_floats (hash, (const float *) self->stops, 5 * self->n_stops);
+
+  return hash;
+}
+
+static gboolean
+gsk_linear_gradient_node_equal (GskRenderNode *node1,
+                                GskRenderNode *node2)
+{
+  GskLinearGradientNode *self1 = (GskLinearGradientNode *) node1;
+  GskLinearGradientNode *self2 = (GskLinearGradientNode *) node2;
+
+  return graphene_point_equal (&self1->start, &self2->start) &&
+         graphene_point_equal (&self1->end, &self2->end) &&
+         color_stops_equal (self1->stops, self1->n_stops, self2->stops, self2->n_stops);
+}
+
 /**
  * gsk_linear_gradient_node_new:
  * @bounds: the rectangle to render the linear gradient into
@@ -494,6 +622,38 @@ gsk_radial_gradient_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_radial_gradient_node_hash (GskRenderNode *node)
+{
+  GskRadialGradientNode *self = (GskRadialGradientNode *) node;
+  guint hash;
+
+  hash = hash_node (node);
+  hash = hash_floats (hash, (const float *) &self->center, 2);
+  hash = hash_float (hash, self->hradius);
+  hash = hash_float (hash, self->vradius);
+  hash = hash_float (hash, self->start);
+  hash = hash_float (hash, self->end);
+  hash = hash_floats (hash, (const float *) self->stops, 5 * self->n_stops);
+
+  return hash;
+}
+
+static gboolean
+gsk_radial_gradient_node_equal (GskRenderNode *node1,
+                                GskRenderNode *node2)
+{
+  GskRadialGradientNode *self1 = (GskRadialGradientNode *) node1;
+  GskRadialGradientNode *self2 = (GskRadialGradientNode *) node2;
+
+  return graphene_point_equal (&self1->center, &self2->center) &&
+         self1->hradius == self2->hradius &&
+         self1->vradius == self2->vradius &&
+         self1->start == self2->start &&
+         self1->end == self2->end &&
+         color_stops_equal (self1->stops, self1->n_stops, self2->stops, self2->n_stops);
+}
+
 /**
  * gsk_radial_gradient_node_new:
  * @bounds: the bounds of the node
@@ -918,6 +1078,41 @@ gsk_border_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_border_node_hash (GskRenderNode *node)
+{
+  GskBorderNode *self = (GskBorderNode *) node;
+  guint hash;
+
+  hash = hash_node (node);
+  hash = hash_rounded_rect (hash, &self->outline);
+  hash = hash_floats (hash, self->border_width, 4);
+  hash = hash_floats (hash, (const float *) self->border_color, 16);
+
+  return hash;
+}
+
+static gboolean
+gsk_border_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  GskBorderNode *self1 = (GskBorderNode *) node1;
+  GskBorderNode *self2 = (GskBorderNode *) node2;
+  guint i;
+
+  if (!gsk_rounded_rect_equal (&self1->outline, &self2->outline))
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (self1->border_width[i] != self2->border_width[i] ||
+          !gdk_rgba_equal (&self1->border_color[i], &self2->border_color[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gsk_border_node_peek_outline:
  * @node: (type GskBorderNode): a #GskRenderNode for a border
@@ -1088,6 +1283,24 @@ gsk_texture_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_texture_node_hash (GskRenderNode *node)
+{
+  GskTextureNode *self = (GskTextureNode *) node;
+
+  return hash_combine (hash_node (node), g_direct_hash (self->texture));
+}
+
+static gboolean
+gsk_texture_node_equal (GskRenderNode *node1,
+                        GskRenderNode *node2)
+{
+  GskTextureNode *self1 = (GskTextureNode *) node1;
+  GskTextureNode *self2 = (GskTextureNode *) node2;
+
+  return self1->texture == self2->texture;
+}
+
 /**
  * gsk_texture_node_get_texture:
  * @node: (type GskTextureNode): a #GskRenderNode of type %GSK_TEXTURE_NODE
@@ -1543,6 +1756,38 @@ gsk_inset_shadow_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_inset_shadow_node_hash (GskRenderNode *node)
+{
+  GskInsetShadowNode *self = (GskInsetShadowNode *) node;
+  guint hash;
+
+  hash = hash_node (node);
+  hash = hash_rounded_rect (hash, &self->outline);
+  hash = hash_rgba (hash, &self->color);
+  hash = hash_float (hash, self->dx);
+  hash = hash_float (hash, self->dy);
+  hash = hash_float (hash, self->spread);
+  hash = hash_float (hash, self->blur_radius);
+
+  return hash;
+}
+
+static gboolean
+gsk_inset_shadow_node_equal (GskRenderNode *node1,
+                                GskRenderNode *node2)
+{
+  GskInsetShadowNode *self1 = (GskInsetShadowNode *) node1;
+  GskInsetShadowNode *self2 = (GskInsetShadowNode *) node2;
+
+  return gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+         gdk_rgba_equal (&self1->color, &self2->color) &&
+         self1->dx == self2->dx &&
+         self1->dy == self2->dy &&
+         self1->spread == self2->spread &&
+         self1->blur_radius == self2->blur_radius;
+}
+
 /**
  * gsk_inset_shadow_node_new:
  * @outline: outline of the region containing the shadow
@@ -1845,6 +2090,38 @@ gsk_outset_shadow_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_outset_shadow_node_hash (GskRenderNode *node)
+{
+  GskOutsetShadowNode *self = (GskOutsetShadowNode *) node;
+  guint hash;
+
+  hash = hash_node (node);
+  hash = hash_rounded_rect (hash, &self->outline);
+  hash = hash_rgba (hash, &self->color);
+  hash = hash_float (hash, self->dx);
+  hash = hash_float (hash, self->dy);
+  hash = hash_float (hash, self->spread);
+  hash = hash_float (hash, self->blur_radius);
+
+  return hash;
+}
+
+static gboolean
+gsk_outset_shadow_node_equal (GskRenderNode *node1,
+                                 GskRenderNode *node2)
+{
+  GskOutsetShadowNode *self1 = (GskOutsetShadowNode *) node1;
+  GskOutsetShadowNode *self2 = (GskOutsetShadowNode *) node2;
+
+  return gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+         gdk_rgba_equal (&self1->color, &self2->color) &&
+         self1->dx == self2->dx &&
+         self1->dy == self2->dy &&
+         self1->spread == self2->spread &&
+         self1->blur_radius == self2->blur_radius;
+}
+
 /**
  * gsk_outset_shadow_node_new:
  * @outline: outline of the region surrounded by shadow
@@ -2136,14 +2413,169 @@ gsk_cairo_node_get_draw_context (GskRenderNode *node)
 
 /**** GSK_CONTAINER_NODE ***/
 
+/* Containers with at least this many children get a bounding volume
+ * hierarchy over their children the first time they are queried, so
+ * that renderers only visit the visible ones.
+ */
+#define CONTAINER_INDEX_MIN_CHILDREN 256
+#define CONTAINER_INDEX_LEAF_SIZE 8
+
+typedef struct
+{
+  graphene_rect_t bounds;
+  guint first;    /* leaves: into indices, others: the first of two child nodes */
+  guint n_items;  /* 0 for nodes that aren't leaves */
+} GskContainerIndexNode;
+
+typedef struct
+{
+  GskContainerIndexNode *nodes;
+  guint n_nodes;
+  guint *indices; /* Children, grouped by leaf */
+} GskContainerIndex;
+
 struct _GskContainerNode
 {
   GskRenderNode render_node;
 
   guint n_children;
   GskRenderNode **children;
+
+  GskContainerIndex *index; /* Created on demand */
 };
 
+static void
+gsk_container_index_free (GskContainerIndex *index)
+{
+  g_free (index->nodes);
+  g_free (index->indices);
+  g_free (index);
+}
+
+typedef struct
+{
+  GskRenderNode **children;
+  int axis;
+} ContainerSortData;
+
+static int
+compare_child_centers (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      user_data)
+{
+  const ContainerSortData *data = user_data;
+  const graphene_rect_t *ra = &data->children[*(const guint *) a]->bounds;
+  const graphene_rect_t *rb = &data->children[*(const guint *) b]->bounds;
+  float ca, cb;
+
+  if (data->axis == 0)
+    {
+      ca = ra->origin.x + ra->size.width / 2;
+      cb = rb->origin.x + rb->size.width / 2;
+    }
+  else
+    {
+      ca = ra->origin.y + ra->size.height / 2;
+      cb = rb->origin.y + rb->size.height / 2;
+    }
+
+  return ca < cb ? -1 : (ca > cb ? 1 : 0);
+}
+
+static void
+gsk_container_index_build_node (GskContainerIndex  *index,
+                                GskRenderNode     **children,
+                                guint               node_id,
+                                guint               first,
+                                guint               n_items)
+{
+  GskContainerIndexNode *node = &index->nodes[node_id];
+  ContainerSortData data;
+  guint i, half;
+
+  graphene_rect_init_from_rect (&node->bounds, &children[index->indices[first]]->bounds);
+  for (i = 1; i < n_items; i++)
+    graphene_rect_union (&node->bounds, &children[index->indices[first + i]]->bounds, &node->bounds);
+
+  if (n_items <= CONTAINER_INDEX_LEAF_SIZE)
+    {
+      node->first = first;
+      node->n_items = n_items;
+      return;
+    }
+
+  /* Split at the median along the longer side */
+  data.children = children;
+  data.axis = node->bounds.size.width >= node->bounds.size.height ? 0 : 1;
+  g_qsort_with_data (index->indices + first, n_items, sizeof (guint), compare_child_centers, &data);
+
+  half = n_items / 2;
+  node->first = index->n_nodes;
+  node->n_items = 0;
+  index->n_nodes += 2;
+
+  gsk_container_index_build_node (index, children, node->first, first, half);
+  gsk_container_index_build_node (index, children, index->nodes[node_id].first + 1, first + half, n_items - half);
+}
+
+static GskContainerIndex *
+gsk_container_index_new (GskContainerNode *self)
+{
+  GskContainerIndex *index;
+  guint i;
+
+  index = g_new0 (GskContainerIndex, 1);
+  index->indices = g_new (guint, self->n_children);
+  for (i = 0; i < self->n_children; i++)
+    index->indices[i] = i;
+
+  /* A binary tree with at most one leaf per child */
+  index->nodes = g_new (GskContainerIndexNode, 2 * self->n_children);
+  index->n_nodes = 1;
+  gsk_container_index_build_node (index, self->children, 0, 0, self->n_children);
+
+  return index;
+}
+
+static void
+gsk_container_index_query (GskContainerIndex     *index,
+                           GskRenderNode        **children,
+                           guint                  node_id,
+                           const graphene_rect_t *rect,
+                           GArray                *result)
+{
+  const GskContainerIndexNode *node = &index->nodes[node_id];
+  guint i;
+
+  if (!graphene_rect_intersection (&node->bounds, rect, NULL))
+    return;
+
+  if (node->n_items == 0)
+    {
+      gsk_container_index_query (index, children, node->first, rect, result);
+      gsk_container_index_query (index, children, node->first + 1, rect, result);
+      return;
+    }
+
+  for (i = 0; i < node->n_items; i++)
+    {
+      guint child = index->indices[node->first + i];
+
+      if (graphene_rect_intersection (&children[child]->bounds, rect, NULL))
+        g_array_append_val (result, child);
+    }
+}
+
+static int
+compare_uint (gconstpointer a,
+              gconstpointer b)
+{
+  guint ua = *(const guint *) a;
+  guint ub = *(const guint *) b;
+
+  return ua < ub ? -1 : (ua > ub ? 1 : 0);
+}
+
 static void
 gsk_container_node_finalize (GskRenderNode *node)
 {
@@ -2154,6 +2586,7 @@ gsk_container_node_finalize (GskRenderNode *node)
     gsk_render_node_unref (container->children[i]);
 
   g_free (container->children);
+  g_clear_pointer (&container->index, gsk_container_index_free);
 
   parent_class->finalize (node);
 }
@@ -2163,11 +2596,33 @@ gsk_container_node_draw (GskRenderNode *node,
                          cairo_t       *cr)
 {
   GskContainerNode *container = (GskContainerNode *) node;
-  guint i;
+  graphene_rect_t clip;
+  double x1, y1, x2, y2;
+  guint *indices;
+  guint i, n;
+
+  /* Skip children outside the clip, tiled rendering relies on this */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  graphene_rect_init (&clip, x1, y1, x2 - x1, y2 - y1);
+
+  indices = gsk_container_node_get_children_in_rect (node, &clip, &n);
+  if (indices)
+    {
+      for (i = 0; i < n; i++)
+        gsk_render_node_draw (container->children[indices[i]], cr);
+
+      g_free (indices);
+      return;
+    }
 
   for (i = 0; i < container->n_children; i++)
     {
-      gsk_render_node_draw (container->children[i], cr);
+      GskRenderNode *child = container->children[i];
+
+      if (!graphene_rect_intersection (&clip, &child->bounds, NULL))
+        continue;
+
+      gsk_render_node_draw (child, cr);
     }
 }
 
@@ -2235,6 +2690,40 @@ gsk_container_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_container_node_hash (GskRenderNode *node)
+{
+  GskContainerNode *self = (GskContainerNode *) node;
+  guint hash;
+  guint i;
+
+  hash = hash_combine (hash_node (node), self->n_children);
+  for (i = 0; i < self->n_children; i++)
+    hash = hash_combine (hash, gsk_render_node_get_hash (self->children[i]));
+
+  return hash;
+}
+
+static gboolean
+gsk_container_node_equal (GskRenderNode *node1,
+                          GskRenderNode *node2)
+{
+  GskContainerNode *self1 = (GskContainerNode *) node1;
+  GskContainerNode *self2 = (GskContainerNode *) node2;
+  guint i;
+
+  if (self1->n_children != self2->n_children)
+    return FALSE;
+
+  for (i = 0; i < self1->n_children; i++)
+    {
+      if (!gsk_render_node_equal (self1->children[i], self2->children[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gsk_container_node_new:
  * @children: (array length=n_children) (transfer none): The children of the node
@@ -2321,14 +2810,55 @@ gsk_container_node_get_child (GskRenderNode *node,
   return self->children[idx];
 }
 
-/*** GSK_TRANSFORM_NODE ***/
-
-struct _GskTransformNode
+/*< private >
+ * gsk_container_node_get_children_in_rect:
+ * @node: (type GskContainerNode): a container #GskRenderNode
+ * @rect: the area of interest, in the coordinate system of @node
+ * @n_children: (out): return location for the number of children
+ *
+ * Finds the children of @node whose bounds intersect @rect, using
+ * an index that is built the first time this is called. This is only
+ * done for containers with many children. For small ones, %NULL is
+ * returned and the caller should just look at all children.
+ *
+ * This function is thread-safe.
+ *
+ * Returns: (nullable) (transfer full): the indexes of the children
+ *   in drawing order, or %NULL if @node is not indexed. Free with g_free().
+ */
+guint *
+gsk_container_node_get_children_in_rect (GskRenderNode         *node,
+                                         const graphene_rect_t *rect,
+                                         guint                 *n_children)
 {
-  GskRenderNode render_node;
+  GskContainerNode *self = (GskContainerNode *) node;
+  GArray *result;
 
-  GskRenderNode *child;
-  GskTransform *transform;
+  if (self->n_children < CONTAINER_INDEX_MIN_CHILDREN)
+    return NULL;
+
+  if (g_once_init_enter (&self->index))
+    g_once_init_leave (&self->index, gsk_container_index_new (self));
+
+  result = g_array_new (FALSE, FALSE, sizeof (guint));
+  gsk_container_index_query (self->index, self->children, 0, rect, result);
+
+  /* The index doesn't keep the order */
+  g_array_sort (result, compare_uint);
+
+  *n_children = result->len;
+
+  return (guint *) g_array_free (result, FALSE);
+}
+
+/*** GSK_TRANSFORM_NODE ***/
+
+struct _GskTransformNode
+{
+  GskRenderNode render_node;
+
+  GskRenderNode *child;
+  GskTransform *transform;
 };
 
 static void
@@ -2445,6 +2975,27 @@ gsk_transform_node_diff (GskRenderNode  *node1,
     }
 }
 
+static guint
+gsk_transform_node_hash (GskRenderNode *node)
+{
+  GskTransformNode *self = (GskTransformNode *) node;
+
+  /* gsk_transform_equal() is fuzzy for matrices, so only hash the category */
+  return hash_combine (hash_combine (hash_node (node), gsk_transform_get_category (self->transform)),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_transform_node_equal (GskRenderNode *node1,
+                          GskRenderNode *node2)
+{
+  GskTransformNode *self1 = (GskTransformNode *) node1;
+  GskTransformNode *self2 = (GskTransformNode *) node2;
+
+  return gsk_transform_equal (self1->transform, self2->transform) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_transform_node_new:
  * @child: The node to transform
@@ -2571,6 +3122,26 @@ gsk_opacity_node_diff (GskRenderNode  *node1,
     gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_opacity_node_hash (GskRenderNode *node)
+{
+  GskOpacityNode *self = (GskOpacityNode *) node;
+
+  return hash_combine (hash_float (hash_node (node), self->opacity),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_opacity_node_equal (GskRenderNode *node1,
+                        GskRenderNode *node2)
+{
+  GskOpacityNode *self1 = (GskOpacityNode *) node1;
+  GskOpacityNode *self2 = (GskOpacityNode *) node2;
+
+  return self1->opacity == self2->opacity &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_opacity_node_new:
  * @child: The node to draw
@@ -2763,6 +3334,33 @@ nope:
   return;
 }
 
+static guint
+gsk_color_matrix_node_hash (GskRenderNode *node)
+{
+  GskColorMatrixNode *self = (GskColorMatrixNode *) node;
+  float values[16];
+  guint hash;
+
+  graphene_matrix_to_float (&self->color_matrix, values);
+  hash = hash_floats (hash_node (node), values, 16);
+  graphene_vec4_to_float (&self->color_offset, values);
+  hash = hash_floats (hash, values, 4);
+
+  return hash_combine (hash, gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_color_matrix_node_equal (GskRenderNode *node1,
+                             GskRenderNode *node2)
+{
+  GskColorMatrixNode *self1 = (GskColorMatrixNode *) node1;
+  GskColorMatrixNode *self2 = (GskColorMatrixNode *) node2;
+
+  return graphene_matrix_equal_fast (&self1->color_matrix, &self2->color_matrix) &&
+         graphene_vec4_equal (&self1->color_offset, &self2->color_offset) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_color_matrix_node_new:
  * @child: The node to draw
@@ -2916,6 +3514,26 @@ gsk_repeat_node_draw (GskRenderNode *node,
   cairo_fill (cr);
 }
 
+static guint
+gsk_repeat_node_hash (GskRenderNode *node)
+{
+  GskRepeatNode *self = (GskRepeatNode *) node;
+
+  return hash_combine (hash_rect (hash_node (node), &self->child_bounds),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_repeat_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  GskRepeatNode *self1 = (GskRepeatNode *) node1;
+  GskRepeatNode *self2 = (GskRepeatNode *) node2;
+
+  return graphene_rect_equal (&self1->child_bounds, &self2->child_bounds) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_repeat_node_new:
  * @bounds: The bounds of the area to be painted
@@ -3053,6 +3671,26 @@ gsk_clip_node_diff (GskRenderNode  *node1,
     }
 }
 
+static guint
+gsk_clip_node_hash (GskRenderNode *node)
+{
+  GskClipNode *self = (GskClipNode *) node;
+
+  return hash_combine (hash_rect (hash_node (node), &self->clip),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_clip_node_equal (GskRenderNode *node1,
+                     GskRenderNode *node2)
+{
+  GskClipNode *self1 = (GskClipNode *) node1;
+  GskClipNode *self2 = (GskClipNode *) node2;
+
+  return graphene_rect_equal (&self1->clip, &self2->clip) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_clip_node_new:
  * @child: The node to draw
@@ -3183,6 +3821,26 @@ gsk_rounded_clip_node_diff (GskRenderNode  *node1,
     }
 }
 
+static guint
+gsk_rounded_clip_node_hash (GskRenderNode *node)
+{
+  GskRoundedClipNode *self = (GskRoundedClipNode *) node;
+
+  return hash_combine (hash_rounded_rect (hash_node (node), &self->clip),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_rounded_clip_node_equal (GskRenderNode *node1,
+                             GskRenderNode *node2)
+{
+  GskRoundedClipNode *self1 = (GskRoundedClipNode *) node1;
+  GskRoundedClipNode *self2 = (GskRoundedClipNode *) node2;
+
+  return gsk_rounded_rect_equal (&self1->clip, &self2->clip) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_rounded_clip_node_new:
  * @child: The node to draw
@@ -3372,6 +4030,41 @@ gsk_shadow_node_diff (GskRenderNode  *node1,
   cairo_region_destroy (sub);
 }
 
+static guint
+gsk_shadow_node_hash (GskRenderNode *node)
+{
+  GskShadowNode *self = (GskShadowNode *) node;
+
+  return hash_combine (hash_floats (hash_node (node), (const float *) self->shadows, 7 * self->n_shadows),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_shadow_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  GskShadowNode *self1 = (GskShadowNode *) node1;
+  GskShadowNode *self2 = (GskShadowNode *) node2;
+  gsize i;
+
+  if (self1->n_shadows != self2->n_shadows)
+    return FALSE;
+
+  for (i = 0; i < self1->n_shadows; i++)
+    {
+      GskShadow *shadow1 = &self1->shadows[i];
+      GskShadow *shadow2 = &self2->shadows[i];
+
+      if (!gdk_rgba_equal (&shadow1->color, &shadow2->color) ||
+          shadow1->dx != shadow2->dx ||
+          shadow1->dy != shadow2->dy ||
+          shadow1->radius != shadow2->radius)
+        return FALSE;
+    }
+
+  return gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_shadow_node_get_bounds (GskShadowNode *self,
                             graphene_rect_t *bounds)
@@ -3593,6 +4286,31 @@ gsk_blend_node_diff (GskRenderNode  *node1,
     }
 }
 
+static guint
+gsk_blend_node_hash (GskRenderNode *node)
+{
+  GskBlendNode *self = (GskBlendNode *) node;
+  guint hash;
+
+  hash = hash_combine (hash_node (node), self->blend_mode);
+  hash = hash_combine (hash, gsk_render_node_get_hash (self->bottom));
+  hash = hash_combine (hash, gsk_render_node_get_hash (self->top));
+
+  return hash;
+}
+
+static gboolean
+gsk_blend_node_equal (GskRenderNode *node1,
+                      GskRenderNode *node2)
+{
+  GskBlendNode *self1 = (GskBlendNode *) node1;
+  GskBlendNode *self2 = (GskBlendNode *) node2;
+
+  return self1->blend_mode == self2->blend_mode &&
+         gsk_render_node_equal (self1->bottom, self2->bottom) &&
+         gsk_render_node_equal (self1->top, self2->top);
+}
+
 /**
  * gsk_blend_node_new:
  * @bottom: The bottom node to be drawn
@@ -3742,6 +4460,31 @@ gsk_cross_fade_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_cross_fade_node_hash (GskRenderNode *node)
+{
+  GskCrossFadeNode *self = (GskCrossFadeNode *) node;
+  guint hash;
+
+  hash = hash_float (hash_node (node), self->progress);
+  hash = hash_combine (hash, gsk_render_node_get_hash (self->start));
+  hash = hash_combine (hash, gsk_render_node_get_hash (self->end));
+
+  return hash;
+}
+
+static gboolean
+gsk_cross_fade_node_equal (GskRenderNode *node1,
+                           GskRenderNode *node2)
+{
+  GskCrossFadeNode *self1 = (GskCrossFadeNode *) node1;
+  GskCrossFadeNode *self2 = (GskCrossFadeNode *) node2;
+
+  return self1->progress == self2->progress &&
+         gsk_render_node_equal (self1->start, self2->start) &&
+         gsk_render_node_equal (self1->end, self2->end);
+}
+
 /**
  * gsk_cross_fade_node_new:
  * @start: The start node to be drawn
@@ -3915,6 +4658,57 @@ gsk_text_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+static guint
+gsk_text_node_hash (GskRenderNode *node)
+{
+  GskTextNode *self = (GskTextNode *) node;
+  guint hash;
+  guint i;
+
+  hash = hash_combine (hash_node (node), g_direct_hash (self->font));
+  hash = hash_rgba (hash, &self->color);
+  hash = hash_floats (hash, (const float *) &self->offset, 2);
+  for (i = 0; i < self->num_glyphs; i++)
+    {
+      hash = hash_combine (hash, self->glyphs[i].glyph);
+      hash = hash_combine (hash, self->glyphs[i].geometry.width);
+      hash = hash_combine (hash, self->glyphs[i].geometry.x_offset);
+      hash = hash_combine (hash, self->glyphs[i].geometry.y_offset);
+    }
+
+  return hash;
+}
+
+static gboolean
+gsk_text_node_equal (GskRenderNode *node1,
+                     GskRenderNode *node2)
+{
+  GskTextNode *self1 = (GskTextNode *) node1;
+  GskTextNode *self2 = (GskTextNode *) node2;
+  guint i;
+
+  if (self1->font != self2->font ||
+      self1->num_glyphs != self2->num_glyphs ||
+      !gdk_rgba_equal (&self1->color, &self2->color) ||
+      !graphene_point_equal (&self1->offset, &self2->offset))
+    return FALSE;
+
+  for (i = 0; i < self1->num_glyphs; i++)
+    {
+      PangoGlyphInfo *info1 = &self1->glyphs[i];
+      PangoGlyphInfo *info2 = &self2->glyphs[i];
+
+      if (info1->glyph != info2->glyph ||
+          info1->geometry.width != info2->geometry.width ||
+          info1->geometry.x_offset != info2->geometry.x_offset ||
+          info1->geometry.y_offset != info2->geometry.y_offset ||
+          info1->attr.is_cluster_start != info2->attr.is_cluster_start)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static gboolean
 font_has_color_glyphs (const PangoFont *font)
 {
@@ -4272,11 +5066,28 @@ gsk_blur_node_draw (GskRenderNode *node,
   cairo_pattern_t *pattern;
   cairo_surface_t *surface;
   cairo_surface_t *image_surface;
+  graphene_rect_t area;
+  double x1, y1, x2, y2;
+  double dx, dy;
+
+  /* The blurred pixels inside the clip depend on the child's pixels
+   * up to 3 box blur radii away, so don't let the current clip cut
+   * those off. Otherwise partial redraws and tiles get wrong edges.
+   */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  dx = dy = 3 * ceil (self->radius);
+  cairo_device_to_user_distance (cr, &dx, &dy);
+  dx = fabs (dx);
+  dy = fabs (dy);
+  graphene_rect_init (&area, x1 - dx, y1 - dy, x2 - x1 + 2 * dx, y2 - y1 + 2 * dy);
+  if (!graphene_rect_intersection (&area, &node->bounds, &area))
+    return;
 
   cairo_save (cr);
 
   /* clip so the push_group() creates a smaller surface */
-  gsk_cairo_rectangle (cr, &node->bounds);
+  cairo_reset_clip (cr);
+  gsk_cairo_rectangle (cr, &area);
   cairo_clip (cr);
 
   cairo_push_group (cr);
@@ -4290,6 +5101,10 @@ gsk_blur_node_draw (GskRenderNode *node,
   cairo_surface_mark_dirty (surface);
   cairo_surface_unmap_image (surface, image_surface);
 
+  /* Go back to the original clip for drawing the result */
+  cairo_restore (cr);
+  cairo_save (cr);
+
   cairo_set_source (cr, pattern);
   cairo_rectangle (cr,
                    node->bounds.origin.x, node->bounds.origin.y,
@@ -4336,6 +5151,26 @@ gsk_blur_node_diff (GskRenderNode  *node1,
     }
 }
 
+static guint
+gsk_blur_node_hash (GskRenderNode *node)
+{
+  GskBlurNode *self = (GskBlurNode *) node;
+
+  return hash_combine (hash_float (hash_node (node), self->radius),
+                       gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_blur_node_equal (GskRenderNode *node1,
+                     GskRenderNode *node2)
+{
+  GskBlurNode *self1 = (GskBlurNode *) node1;
+  GskBlurNode *self2 = (GskBlurNode *) node2;
+
+  return self1->radius == self2->radius &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_blur_node_new:
  * @child: the child node to blur
@@ -4459,6 +5294,25 @@ gsk_debug_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff (self1->child, self2->child, region);
 }
 
+static guint
+gsk_debug_node_hash (GskRenderNode *node)
+{
+  GskDebugNode *self = (GskDebugNode *) node;
+
+  /* The message doesn't change the rendering */
+  return hash_combine (hash_node (node), gsk_render_node_get_hash (self->child));
+}
+
+static gboolean
+gsk_debug_node_equal (GskRenderNode *node1,
+                      GskRenderNode *node2)
+{
+  GskDebugNode *self1 = (GskDebugNode *) node1;
+  GskDebugNode *self2 = (GskDebugNode *) node2;
+
+  return gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_debug_node_new:
  * @child: The child to add debug info for
@@ -4769,6 +5623,372 @@ GSK_DEFINE_RENDER_NODE_TYPE (gsk_blur_node, GSK_BLUR_NODE)
 GSK_DEFINE_RENDER_NODE_TYPE (gsk_gl_shader_node, GSK_GL_SHADER_NODE)
 GSK_DEFINE_RENDER_NODE_TYPE (gsk_debug_node, GSK_DEBUG_NODE)
 
+/*< private >
+ * gsk_render_node_prepare_threaded_draw:
+ * @node: a #GskRenderNode
+ *
+ * Checks if @node can be drawn with gsk_render_node_draw() from
+ * a thread other than the main thread, and creates the state that
+ * would otherwise be created lazily while drawing, so that several
+ * threads can draw the same nodes at once.
+ *
+ * This must be called from the main thread.
+ *
+ * Returns: %TRUE if @node can be drawn from any thread
+ */
+gboolean
+gsk_render_node_prepare_threaded_draw (GskRenderNode *node)
+{
+  guint i;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_TEXTURE_NODE:
+      /* Downloading GL textures needs the GL context */
+      return !GDK_IS_GL_TEXTURE (gsk_texture_node_get_texture (node));
+
+    case GSK_TEXT_NODE:
+      /* Pango creates the scaled font on first use */
+      pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (gsk_text_node_get_font (node)));
+      return TRUE;
+
+    case GSK_CONTAINER_NODE:
+      {
+        gboolean result = TRUE;
+
+        /* Don't stop early, all children need to be prepared */
+        for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+          result &= gsk_render_node_prepare_threaded_draw (gsk_container_node_get_child (node, i));
+
+        return result;
+      }
+
+    case GSK_TRANSFORM_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_transform_node_get_child (node));
+    case GSK_OPACITY_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_opacity_node_get_child (node));
+    case GSK_COLOR_MATRIX_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_color_matrix_node_get_child (node));
+    case GSK_REPEAT_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_repeat_node_get_child (node));
+    case GSK_CLIP_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_clip_node_get_child (node));
+    case GSK_ROUNDED_CLIP_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_rounded_clip_node_get_child (node));
+    case GSK_SHADOW_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_shadow_node_get_child (node));
+    case GSK_BLUR_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_blur_node_get_child (node));
+    case GSK_DEBUG_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_debug_node_get_child (node));
+    case GSK_BLEND_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_blend_node_get_bottom_child (node)) &
+             gsk_render_node_prepare_threaded_draw (gsk_blend_node_get_top_child (node));
+    case GSK_CROSS_FADE_NODE:
+      return gsk_render_node_prepare_threaded_draw (gsk_cross_fade_node_get_start_child (node)) &
+             gsk_render_node_prepare_threaded_draw (gsk_cross_fade_node_get_end_child (node));
+
+    case GSK_GL_SHADER_NODE:
+      return FALSE;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      return TRUE;
+    }
+}
+
+/* Checking all pairs is quadratic, so give up on big containers */
+#define MAX_OPACITY_CHILDREN 32
+
+static gboolean
+rects_overlap (const graphene_rect_t *a,
+               const graphene_rect_t *b)
+{
+  return MAX (a->origin.x, b->origin.x) < MIN (a->origin.x + a->size.width, b->origin.x + b->size.width) &&
+         MAX (a->origin.y, b->origin.y) < MIN (a->origin.y + a->size.height, b->origin.y + b->size.height);
+}
+
+/*< private >
+ * gsk_render_node_can_inherit_opacity:
+ * @node: a #GskRenderNode
+ *
+ * Checks if applying an opacity to every single draw of @node gives
+ * the same result as drawing @node to an offscreen and applying the
+ * opacity to that. This is the case if no two leaf nodes overlap, as
+ * proven by their bounds.
+ *
+ * Leaf nodes are assumed to not overlap themselves, in particular
+ * glyphs of text nodes are treated that way.
+ *
+ * Renderers can use this to avoid offscreens for opacity nodes, as
+ * long as they can apply the opacity to all leaf nodes.
+ *
+ * Returns: %TRUE if the opacity can be pushed down into the leaves
+ */
+gboolean
+gsk_render_node_can_inherit_opacity (GskRenderNode *node)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_TEXT_NODE:
+    case GSK_CAIRO_NODE:
+      return TRUE;
+
+    case GSK_CONTAINER_NODE:
+      {
+        guint i, j, n_children;
+
+        n_children = gsk_container_node_get_n_children (node);
+        if (n_children > MAX_OPACITY_CHILDREN)
+          return FALSE;
+
+        for (i = 0; i < n_children; i++)
+          {
+            GskRenderNode *child = gsk_container_node_get_child (node, i);
+
+            if (!gsk_render_node_can_inherit_opacity (child))
+              return FALSE;
+
+            for (j = 0; j < i; j++)
+              {
+                if (rects_overlap (&child->bounds, &gsk_container_node_get_child (node, j)->bounds))
+                  return FALSE;
+              }
+          }
+
+        return TRUE;
+      }
+
+    case GSK_TRANSFORM_NODE:
+      return gsk_render_node_can_inherit_opacity (gsk_transform_node_get_child (node));
+    case GSK_OPACITY_NODE:
+      return gsk_render_node_can_inherit_opacity (gsk_opacity_node_get_child (node));
+    case GSK_CLIP_NODE:
+      return gsk_render_node_can_inherit_opacity (gsk_clip_node_get_child (node));
+    case GSK_ROUNDED_CLIP_NODE:
+      return gsk_render_node_can_inherit_opacity (gsk_rounded_clip_node_get_child (node));
+    case GSK_DEBUG_NODE:
+      return gsk_render_node_can_inherit_opacity (gsk_debug_node_get_child (node));
+
+    case GSK_COLOR_MATRIX_NODE:
+    case GSK_REPEAT_NODE:
+    case GSK_SHADOW_NODE:
+    case GSK_BLUR_NODE:
+    case GSK_BLEND_NODE:
+    case GSK_CROSS_FADE_NODE:
+    case GSK_GL_SHADER_NODE:
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      return FALSE;
+    }
+}
+
+static GskRenderNode *
+gsk_render_node_replace_children_internal (GskRenderNode *node,
+                                           GHashTable    *replacements,
+                                           GHashTable    *found)
+{
+  GskRenderNode *child, *replaced, *res;
+
+  replaced = g_hash_table_lookup (replacements, node);
+  if (replaced != NULL)
+    {
+      if (replaced != node)
+        g_hash_table_add (found, node);
+
+      return gsk_render_node_ref (replaced);
+    }
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_TEXT_NODE:
+    case GSK_CAIRO_NODE:
+      return gsk_render_node_ref (node);
+
+    case GSK_CONTAINER_NODE:
+      {
+        GskRenderNode **children;
+        gboolean changed = FALSE;
+        guint i, n_children;
+
+        n_children = gsk_container_node_get_n_children (node);
+        children = g_new (GskRenderNode *, n_children);
+
+        for (i = 0; i < n_children; i++)
+          {
+            child = gsk_container_node_get_child (node, i);
+            children[i] = gsk_render_node_replace_children_internal (child, replacements, found);
+            if (children[i] == NULL)
+              break;
+
+            changed |= children[i] != child;
+          }
+
+        if (i < n_children)
+          res = NULL;
+        else if (changed)
+          res = gsk_container_node_new (children, n_children);
+        else
+          res = gsk_render_node_ref (node);
+
+        while (i-- > 0)
+          gsk_render_node_unref (children[i]);
+        g_free (children);
+
+        return res;
+      }
+
+    case GSK_TRANSFORM_NODE:
+      child = gsk_transform_node_get_child (node);
+      break;
+    case GSK_OPACITY_NODE:
+      child = gsk_opacity_node_get_child (node);
+      break;
+    case GSK_COLOR_MATRIX_NODE:
+      child = gsk_color_matrix_node_get_child (node);
+      break;
+    case GSK_CLIP_NODE:
+      child = gsk_clip_node_get_child (node);
+      break;
+    case GSK_ROUNDED_CLIP_NODE:
+      child = gsk_rounded_clip_node_get_child (node);
+      break;
+    case GSK_SHADOW_NODE:
+      child = gsk_shadow_node_get_child (node);
+      break;
+    case GSK_BLUR_NODE:
+      child = gsk_blur_node_get_child (node);
+      break;
+    case GSK_DEBUG_NODE:
+      child = gsk_debug_node_get_child (node);
+      break;
+
+    case GSK_REPEAT_NODE:
+    case GSK_BLEND_NODE:
+    case GSK_CROSS_FADE_NODE:
+    case GSK_GL_SHADER_NODE:
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      return NULL;
+    }
+
+  replaced = gsk_render_node_replace_children_internal (child, replacements, found);
+  if (replaced == NULL)
+    return NULL;
+
+  if (replaced == child)
+    {
+      gsk_render_node_unref (replaced);
+      return gsk_render_node_ref (node);
+    }
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_TRANSFORM_NODE:
+      res = gsk_transform_node_new (replaced, gsk_transform_node_get_transform (node));
+      break;
+    case GSK_OPACITY_NODE:
+      res = gsk_opacity_node_new (replaced, gsk_opacity_node_get_opacity (node));
+      break;
+    case GSK_COLOR_MATRIX_NODE:
+      res = gsk_color_matrix_node_new (replaced,
+                                       gsk_color_matrix_node_peek_color_matrix (node),
+                                       gsk_color_matrix_node_peek_color_offset (node));
+      break;
+    case GSK_CLIP_NODE:
+      res = gsk_clip_node_new (replaced, gsk_clip_node_peek_clip (node));
+      break;
+    case GSK_ROUNDED_CLIP_NODE:
+      res = gsk_rounded_clip_node_new (replaced, gsk_rounded_clip_node_peek_clip (node));
+      break;
+    case GSK_SHADOW_NODE:
+      res = gsk_shadow_node_new (replaced,
+                                 gsk_shadow_node_peek_shadow (node, 0),
+                                 gsk_shadow_node_get_n_shadows (node));
+      break;
+    case GSK_BLUR_NODE:
+      res = gsk_blur_node_new (replaced, gsk_blur_node_get_radius (node));
+      break;
+    case GSK_DEBUG_NODE:
+      res = gsk_debug_node_new (replaced, g_strdup (gsk_debug_node_get_message (node)));
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  gsk_render_node_unref (replaced);
+
+  return res;
+}
+
+/*< private >
+ * gsk_render_node_replace_children:
+ * @node: a #GskRenderNode
+ * @replacements: (element-type GskRenderNode GskRenderNode): a hash table
+ *   mapping descendants of @node to the nodes to use in their place
+ *
+ * Creates a copy of @node where every occurrence of a node in
+ * @replacements has been replaced by the corresponding value.
+ *
+ * Only the nodes on the path to the replaced nodes are recreated,
+ * everything else is shared with @node. Nodes in @replacements are
+ * never descended into, so mapping a node to itself can be used to
+ * skip subtrees that are known to not contain any of the other nodes.
+ *
+ * This is used to update a retained render node when only some of
+ * its descendants changed, without having to snapshot it again.
+ *
+ * Returns: (transfer full) (nullable): the new node, or %NULL if one
+ *   of the nodes to replace could not be found, or if @node contains
+ *   nodes that can not be recreated
+ */
+GskRenderNode *
+gsk_render_node_replace_children (GskRenderNode *node,
+                                  GHashTable    *replacements)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GHashTable *found;
+  GskRenderNode *res;
+  guint n_changed;
+
+  n_changed = 0;
+  g_hash_table_iter_init (&iter, replacements);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      if (key != value)
+        n_changed++;
+    }
+
+  found = g_hash_table_new (NULL, NULL);
+
+  res = gsk_render_node_replace_children_internal (node, replacements, found);
+  if (g_hash_table_size (found) != n_changed)
+    g_clear_pointer (&res, gsk_render_node_unref);
+
+  g_hash_table_unref (found);
+
+  return res;
+}
+
 static void
 gsk_render_node_init_types_once (void)
 {
@@ -4782,6 +6002,8 @@ gsk_render_node_init_types_once (void)
       gsk_container_node_draw,
       NULL,
       gsk_container_node_diff,
+      gsk_container_node_hash,
+      gsk_container_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskContainerNode"), &node_info);
@@ -4814,6 +6036,8 @@ gsk_render_node_init_types_once (void)
       gsk_color_node_draw,
       NULL,
       gsk_color_node_diff,
+      gsk_color_node_hash,
+      gsk_color_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskColorNode"), &node_info);
@@ -4830,6 +6054,8 @@ gsk_render_node_init_types_once (void)
       gsk_linear_gradient_node_draw,
       NULL,
       gsk_linear_gradient_node_diff,
+      gsk_linear_gradient_node_hash,
+      gsk_linear_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskLinearGradientNode"), &node_info);
@@ -4846,6 +6072,8 @@ gsk_render_node_init_types_once (void)
       gsk_linear_gradient_node_draw,
       NULL,
       gsk_linear_gradient_node_diff,
+      gsk_linear_gradient_node_hash,
+      gsk_linear_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRepeatingLinearGradientNode"), &node_info);
@@ -4862,6 +6090,8 @@ gsk_render_node_init_types_once (void)
       gsk_radial_gradient_node_draw,
       NULL,
       gsk_radial_gradient_node_diff,
+      gsk_radial_gradient_node_hash,
+      gsk_radial_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRadialGradientNode"), &node_info);
@@ -4878,6 +6108,8 @@ gsk_render_node_init_types_once (void)
       gsk_radial_gradient_node_draw,
       NULL,
       gsk_radial_gradient_node_diff,
+      gsk_radial_gradient_node_hash,
+      gsk_radial_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRepeatingRadialGradientNode"), &node_info);
@@ -4894,6 +6126,8 @@ gsk_render_node_init_types_once (void)
       gsk_border_node_draw,
       NULL,
       gsk_border_node_diff,
+      gsk_border_node_hash,
+      gsk_border_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskBorderNode"), &node_info);
@@ -4910,6 +6144,8 @@ gsk_render_node_init_types_once (void)
       gsk_texture_node_draw,
       NULL,
       gsk_texture_node_diff,
+      gsk_texture_node_hash,
+      gsk_texture_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskTextureNode"), &node_info);
@@ -4926,6 +6162,8 @@ gsk_render_node_init_types_once (void)
       gsk_inset_shadow_node_draw,
       NULL,
       gsk_inset_shadow_node_diff,
+      gsk_inset_shadow_node_hash,
+      gsk_inset_shadow_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskInsetShadowNode"), &node_info);
@@ -4942,6 +6180,8 @@ gsk_render_node_init_types_once (void)
       gsk_outset_shadow_node_draw,
       NULL,
       gsk_outset_shadow_node_diff,
+      gsk_outset_shadow_node_hash,
+      gsk_outset_shadow_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskOutsetShadowNode"), &node_info);
@@ -4958,6 +6198,8 @@ gsk_render_node_init_types_once (void)
       gsk_transform_node_draw,
       gsk_transform_node_can_diff,
       gsk_transform_node_diff,
+      gsk_transform_node_hash,
+      gsk_transform_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskTransformNode"), &node_info);
@@ -4974,6 +6216,8 @@ gsk_render_node_init_types_once (void)
       gsk_opacity_node_draw,
       NULL,
       gsk_opacity_node_diff,
+      gsk_opacity_node_hash,
+      gsk_opacity_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskOpacityNode"), &node_info);
@@ -4990,6 +6234,8 @@ gsk_render_node_init_types_once (void)
       gsk_color_matrix_node_draw,
       NULL,
       gsk_color_matrix_node_diff,
+      gsk_color_matrix_node_hash,
+      gsk_color_matrix_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskColorMatrixNode"), &node_info);
@@ -5006,6 +6252,8 @@ gsk_render_node_init_types_once (void)
       gsk_repeat_node_draw,
       NULL,
       NULL,
+      gsk_repeat_node_hash,
+      gsk_repeat_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRepeatNode"), &node_info);
@@ -5022,6 +6270,8 @@ gsk_render_node_init_types_once (void)
       gsk_clip_node_draw,
       NULL,
       gsk_clip_node_diff,
+      gsk_clip_node_hash,
+      gsk_clip_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskClipNode"), &node_info);
@@ -5038,6 +6288,8 @@ gsk_render_node_init_types_once (void)
       gsk_rounded_clip_node_draw,
       NULL,
       gsk_rounded_clip_node_diff,
+      gsk_rounded_clip_node_hash,
+      gsk_rounded_clip_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRoundedClipNode"), &node_info);
@@ -5054,6 +6306,8 @@ gsk_render_node_init_types_once (void)
       gsk_shadow_node_draw,
       NULL,
       gsk_shadow_node_diff,
+      gsk_shadow_node_hash,
+      gsk_shadow_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskShadowNode"), &node_info);
@@ -5070,6 +6324,8 @@ gsk_render_node_init_types_once (void)
       gsk_blend_node_draw,
       NULL,
       gsk_blend_node_diff,
+      gsk_blend_node_hash,
+      gsk_blend_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskBlendNode"), &node_info);
@@ -5086,6 +6342,8 @@ gsk_render_node_init_types_once (void)
       gsk_cross_fade_node_draw,
       NULL,
       gsk_cross_fade_node_diff,
+      gsk_cross_fade_node_hash,
+      gsk_cross_fade_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskCrossFadeNode"), &node_info);
@@ -5102,6 +6360,8 @@ gsk_render_node_init_types_once (void)
       gsk_text_node_draw,
       NULL,
       gsk_text_node_diff,
+      gsk_text_node_hash,
+      gsk_text_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskTextNode"), &node_info);
@@ -5118,6 +6378,8 @@ gsk_render_node_init_types_once (void)
       gsk_blur_node_draw,
       NULL,
       gsk_blur_node_diff,
+      gsk_blur_node_hash,
+      gsk_blur_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskBlurNode"), &node_info);
@@ -5150,6 +6412,8 @@ gsk_render_node_init_types_once (void)
       gsk_debug_node_draw,
       gsk_debug_node_can_diff,
       gsk_debug_node_diff,
+      gsk_debug_node_hash,
+      gsk_debug_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskDebugNode"), &node_info);
@@ -0,0 +1,808 @@
+/* GSK - The GTK Scene Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gskrendernodeoptimizeprivate.h"
+
+#include "gsktransformprivate.h"
+
+#include "gdk/gdkmemorytextureprivate.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Widgets produce a lot of structure that doesn't change what ends
+ * up on screen. Removing it before rendering saves every renderer
+ * from dealing with it.
+ *
+ * Subtrees that don't change are returned as they are. Where nodes
+ * had to be recreated, the result is remembered in a
+ * GskRenderNodeOptimizeCache until the next run, so that optimizing
+ * the same input again returns the same nodes. Renderers can then
+ * keep caching things per node, and optimizing an unchanged tree
+ * does not allocate any nodes.
+ *
+ * Only containers, transforms, opacities, clips and debug nodes are
+ * looked into. Other nodes are kept together with their children.
+ *
+ * The tree is walked from the top-most node to the bottom-most one,
+ * collecting the area covered by opaque colors and textures. Nodes
+ * that end up completely below that area are culled. Below transforms
+ * other than translations this is not done, and below opacities and
+ * rounded clips nothing is added to the covered area.
+ */
+
+typedef struct
+{
+  GskRenderNodeOptimizeStats *stats;
+  /* in root coordinates, rounded inwards */
+  cairo_region_t *opaque;
+  /* The rectangles added to @opaque, in order */
+  GArray *opaque_log;
+  GskRenderNodeOptimizeCache *cache;
+  /* Cache entries used for the subtree being optimized */
+  GPtrArray *entries;
+} Optimizer;
+
+typedef struct
+{
+  /* Offset to root coordinates */
+  float dx, dy;
+  /* in root coordinates */
+  graphene_rect_t clip;
+  /* Whether the offset and clip are known */
+  gboolean can_cull;
+  /* Whether opaque content is drawn as it is */
+  gboolean can_cover;
+} Context;
+
+typedef struct _CacheEntry CacheEntry;
+
+/* What optimizing @node gave, and what it depended on */
+struct _CacheEntry
+{
+  GskRenderNode *node;
+  GskRenderNode *result;
+  Context context;
+  /* The covered area within the bounds of @node, before and after
+   * optimizing it, or %NULL if nothing could be culled
+   */
+  cairo_region_t *opaque_before;
+  cairo_region_t *opaque_after;
+  GskRenderNodeOptimizeStats stats;
+  /* The entries for the nodes below, which are reused together */
+  GPtrArray *children;
+};
+
+struct _GskRenderNodeOptimizeCache
+{
+  /* GskRenderNode => CacheEntry, from the last and the current run */
+  GHashTable *previous;
+  GHashTable *current;
+};
+
+static GskRenderNode *optimize_node (Optimizer     *self,
+                                     const Context *context,
+                                     GskRenderNode *node);
+
+static gboolean
+is_opaque (GskRenderNode *node)
+{
+  switch ((int) gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+      return gsk_color_node_peek_color (node)->alpha >= 1.0;
+
+    case GSK_TEXTURE_NODE:
+      {
+        GdkTexture *texture = gsk_texture_node_get_texture (node);
+
+        return GDK_IS_MEMORY_TEXTURE (texture) &&
+               gdk_memory_format_is_opaque (gdk_memory_texture_get_format (GDK_MEMORY_TEXTURE (texture)));
+      }
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+context_to_root (const Context         *context,
+                 const graphene_rect_t *rect,
+                 graphene_rect_t       *out_rect)
+{
+  graphene_rect_offset_r (rect, context->dx, context->dy, out_rect);
+  if (!graphene_rect_intersection (out_rect, &context->clip, out_rect))
+    graphene_rect_init (out_rect, 0, 0, 0, 0);
+}
+
+/* Returns %FALSE if nothing of @bounds is visible */
+static gboolean
+get_root_area (const Context         *context,
+               const graphene_rect_t *bounds,
+               cairo_rectangle_int_t *area)
+{
+  graphene_rect_t rect;
+
+  context_to_root (context, bounds, &rect);
+  if (rect.size.width <= 0 || rect.size.height <= 0)
+    return FALSE;
+
+  /* Round outwards */
+  area->x = floorf (rect.origin.x);
+  area->y = floorf (rect.origin.y);
+  area->width = ceilf (rect.origin.x + rect.size.width) - area->x;
+  area->height = ceilf (rect.origin.y + rect.size.height) - area->y;
+
+  return TRUE;
+}
+
+static gboolean
+is_covered (Optimizer             *self,
+            const Context         *context,
+            const graphene_rect_t *bounds)
+{
+  cairo_rectangle_int_t area;
+
+  if (!context->can_cull)
+    return FALSE;
+
+  if (!get_root_area (context, bounds, &area))
+    return TRUE;
+
+  return cairo_region_contains_rectangle (self->opaque, &area) == CAIRO_REGION_OVERLAP_IN;
+}
+
+/* The part of @bounds that the first @n_rects covered rectangles
+ * cover, or %NULL if nothing can be culled below @context
+ */
+static cairo_region_t *
+get_covered (Optimizer             *self,
+             const Context         *context,
+             const graphene_rect_t *bounds,
+             guint                  n_rects)
+{
+  cairo_rectangle_int_t area;
+  cairo_region_t *region;
+  guint i;
+
+  if (!context->can_cull)
+    return NULL;
+
+  region = cairo_region_create ();
+  if (!get_root_area (context, bounds, &area))
+    return region;
+
+  if (n_rects == self->opaque_log->len)
+    {
+      cairo_region_union (region, self->opaque);
+    }
+  else
+    {
+      for (i = 0; i < n_rects; i++)
+        cairo_region_union_rectangle (region, &g_array_index (self->opaque_log, cairo_rectangle_int_t, i));
+    }
+
+  cairo_region_intersect_rectangle (region, &area);
+
+  return region;
+}
+
+static void
+add_covered (Optimizer             *self,
+             const Context         *context,
+             const graphene_rect_t *bounds)
+{
+  graphene_rect_t rect;
+  cairo_rectangle_int_t area;
+
+  if (!context->can_cull || !context->can_cover)
+    return;
+
+  context_to_root (context, bounds, &rect);
+
+  /* Round inwards */
+  area.x = ceilf (rect.origin.x);
+  area.y = ceilf (rect.origin.y);
+  area.width = floorf (rect.origin.x + rect.size.width) - area.x;
+  area.height = floorf (rect.origin.y + rect.size.height) - area.y;
+
+  if (area.width > 0 && area.height > 0)
+    {
+      cairo_region_union_rectangle (self->opaque, &area);
+      g_array_append_val (self->opaque_log, area);
+    }
+}
+
+static void
+cache_entry_clear (gpointer data)
+{
+  CacheEntry *entry = data;
+
+  gsk_render_node_unref (entry->node);
+  gsk_render_node_unref (entry->result);
+  g_clear_pointer (&entry->opaque_before, cairo_region_destroy);
+  g_clear_pointer (&entry->opaque_after, cairo_region_destroy);
+  g_ptr_array_unref (entry->children);
+}
+
+static void
+cache_entry_unref (gpointer data)
+{
+  g_rc_box_release_full (data, cache_entry_clear);
+}
+
+static gboolean
+context_equal (const Context *a,
+               const Context *b)
+{
+  return a->dx == b->dx &&
+         a->dy == b->dy &&
+         graphene_rect_equal (&a->clip, &b->clip) &&
+         a->can_cull == b->can_cull &&
+         a->can_cover == b->can_cover;
+}
+
+static gboolean
+covered_equal (cairo_region_t *a,
+               cairo_region_t *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return cairo_region_equal (a, b);
+}
+
+static CacheEntry *
+lookup_entry (Optimizer     *self,
+              const Context *context,
+              GskRenderNode *node)
+{
+  CacheEntry *entry;
+  cairo_region_t *covered;
+  gboolean valid;
+
+  entry = g_hash_table_lookup (self->cache->current, node);
+  if (entry == NULL)
+    entry = g_hash_table_lookup (self->cache->previous, node);
+  if (entry == NULL || !context_equal (&entry->context, context))
+    return NULL;
+
+  covered = get_covered (self, context, &node->bounds, self->opaque_log->len);
+  valid = covered_equal (covered, entry->opaque_before);
+  g_clear_pointer (&covered, cairo_region_destroy);
+
+  return valid ? entry : NULL;
+}
+
+static void
+keep_entry (GskRenderNodeOptimizeCache *cache,
+            CacheEntry                 *entry)
+{
+  guint i;
+
+  g_hash_table_replace (cache->current, entry->node, g_rc_box_acquire (entry));
+
+  for (i = 0; i < entry->children->len; i++)
+    keep_entry (cache, g_ptr_array_index (entry->children, i));
+}
+
+/* Does what optimizing the node of @entry again would do */
+static GskRenderNode *
+reuse_entry (Optimizer  *self,
+             CacheEntry *entry)
+{
+  int i;
+
+  if (entry->opaque_after)
+    {
+      cairo_region_union (self->opaque, entry->opaque_after);
+      for (i = 0; i < cairo_region_num_rectangles (entry->opaque_after); i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (entry->opaque_after, i, &rect);
+          g_array_append_val (self->opaque_log, rect);
+        }
+    }
+
+  self->stats->n_folded_transforms += entry->stats.n_folded_transforms;
+  self->stats->n_dropped_nodes += entry->stats.n_dropped_nodes;
+  self->stats->n_culled_nodes += entry->stats.n_culled_nodes;
+
+  keep_entry (self->cache, entry);
+  g_ptr_array_add (self->entries, g_rc_box_acquire (entry));
+
+  return gsk_render_node_ref (entry->result);
+}
+
+static void
+add_entry (Optimizer                        *self,
+           const Context                    *context,
+           GskRenderNode                    *node,
+           GskRenderNode                    *result,
+           guint                             n_rects_before,
+           const GskRenderNodeOptimizeStats *stats_before,
+           GPtrArray                        *children)
+{
+  CacheEntry *entry;
+
+  entry = g_rc_box_new0 (CacheEntry);
+  entry->node = gsk_render_node_ref (node);
+  entry->result = gsk_render_node_ref (result);
+  entry->context = *context;
+  entry->opaque_before = get_covered (self, context, &node->bounds, n_rects_before);
+  entry->opaque_after = get_covered (self, context, &node->bounds, self->opaque_log->len);
+  entry->stats.n_folded_transforms = self->stats->n_folded_transforms - stats_before->n_folded_transforms;
+  entry->stats.n_dropped_nodes = self->stats->n_dropped_nodes - stats_before->n_dropped_nodes;
+  entry->stats.n_culled_nodes = self->stats->n_culled_nodes - stats_before->n_culled_nodes;
+  entry->children = g_ptr_array_ref (children);
+
+  g_hash_table_replace (self->cache->current, node, entry);
+  g_ptr_array_add (self->entries, g_rc_box_acquire (entry));
+}
+
+static GskRenderNode *
+optimize_container_node (Optimizer     *self,
+                         const Context *context,
+                         GskRenderNode *node)
+{
+  guint n_children = gsk_container_node_get_n_children (node);
+  GskRenderNode **children;
+  GskRenderNode *result;
+  gboolean changed = FALSE;
+  guint n_kept = 0;
+  guint i;
+
+  children = g_new (GskRenderNode *, n_children);
+
+  /* Go from top to bottom, so that the area covered by the
+   * children above is known.
+   */
+  for (i = n_children; i-- > 0; )
+    {
+      GskRenderNode *child = gsk_container_node_get_child (node, i);
+      GskRenderNode *optimized;
+
+      optimized = optimize_node (self, context, child);
+      if (optimized != child)
+        changed = TRUE;
+      if (optimized == NULL)
+        continue;
+
+      children[n_kept++] = optimized;
+    }
+
+  if (!changed && n_kept > 1)
+    {
+      result = gsk_render_node_ref (node);
+    }
+  else if (n_kept == 0)
+    {
+      self->stats->n_dropped_nodes++;
+      result = NULL;
+    }
+  else if (n_kept == 1)
+    {
+      self->stats->n_dropped_nodes++;
+      result = gsk_render_node_ref (children[0]);
+    }
+  else
+    {
+      /* Put them back into drawing order */
+      for (i = 0; i < n_kept / 2; i++)
+        {
+          GskRenderNode *tmp = children[i];
+          children[i] = children[n_kept - 1 - i];
+          children[n_kept - 1 - i] = tmp;
+        }
+
+      result = gsk_container_node_new (children, n_kept);
+    }
+
+  for (i = 0; i < n_kept; i++)
+    gsk_render_node_unref (children[i]);
+  g_free (children);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_transform_node (Optimizer     *self,
+                         const Context *context,
+                         GskRenderNode *node)
+{
+  GskTransform *transform = gsk_transform_node_get_transform (node);
+  GskRenderNode *child = gsk_transform_node_get_child (node);
+  GskRenderNode *optimized;
+  GskRenderNode *result;
+  Context child_context = *context;
+
+  if (gsk_transform_get_category (transform) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+    {
+      float dx, dy;
+
+      gsk_transform_to_translate (transform, &dx, &dy);
+      child_context.dx += dx;
+      child_context.dy += dy;
+    }
+  else
+    {
+      child_context.can_cull = FALSE;
+    }
+
+  optimized = optimize_node (self, &child_context, child);
+  if (optimized == NULL)
+    return NULL;
+
+  if (gsk_transform_get_category (transform) == GSK_TRANSFORM_CATEGORY_IDENTITY)
+    {
+      self->stats->n_folded_transforms++;
+      return optimized;
+    }
+
+  if (gsk_render_node_get_node_type (optimized) == GSK_TRANSFORM_NODE)
+    {
+      GskTransform *combined;
+
+      self->stats->n_folded_transforms++;
+
+      combined = gsk_transform_transform (gsk_transform_ref (transform),
+                                          gsk_transform_node_get_transform (optimized));
+      if (gsk_transform_get_category (combined) == GSK_TRANSFORM_CATEGORY_IDENTITY)
+        result = gsk_render_node_ref (gsk_transform_node_get_child (optimized));
+      else
+        result = gsk_transform_node_new (gsk_transform_node_get_child (optimized), combined);
+
+      gsk_transform_unref (combined);
+    }
+  else if (optimized == child)
+    {
+      result = gsk_render_node_ref (node);
+    }
+  else
+    {
+      result = gsk_transform_node_new (optimized, transform);
+    }
+
+  gsk_render_node_unref (optimized);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_opacity_node (Optimizer     *self,
+                       const Context *context,
+                       GskRenderNode *node)
+{
+  float opacity = gsk_opacity_node_get_opacity (node);
+  GskRenderNode *child = gsk_opacity_node_get_child (node);
+  GskRenderNode *optimized;
+  GskRenderNode *result;
+  Context child_context = *context;
+
+  if (opacity <= 0)
+    {
+      self->stats->n_dropped_nodes++;
+      return NULL;
+    }
+
+  if (opacity < 1.0)
+    child_context.can_cover = FALSE;
+
+  optimized = optimize_node (self, &child_context, child);
+  if (optimized == NULL)
+    return NULL;
+
+  if (opacity >= 1.0)
+    {
+      self->stats->n_dropped_nodes++;
+      return optimized;
+    }
+
+  if (optimized == child)
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_opacity_node_new (optimized, opacity);
+
+  gsk_render_node_unref (optimized);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_clip_node (Optimizer     *self,
+                    const Context *context,
+                    GskRenderNode *node)
+{
+  const graphene_rect_t *clip = gsk_clip_node_get_clip (node);
+  GskRenderNode *child = gsk_clip_node_get_child (node);
+  GskRenderNode *optimized;
+  GskRenderNode *result;
+  graphene_rect_t visible;
+  Context child_context = *context;
+
+  if (!graphene_rect_intersection (clip, &child->bounds, &visible))
+    {
+      self->stats->n_dropped_nodes++;
+      return NULL;
+    }
+
+  context_to_root (context, clip, &child_context.clip);
+
+  optimized = optimize_node (self, &child_context, child);
+  if (optimized == NULL)
+    return NULL;
+
+  if (graphene_rect_contains_rect (clip, &optimized->bounds))
+    {
+      self->stats->n_dropped_nodes++;
+      return optimized;
+    }
+
+  if (optimized == child)
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_clip_node_new (optimized, clip);
+
+  gsk_render_node_unref (optimized);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_rounded_clip_node (Optimizer     *self,
+                            const Context *context,
+                            GskRenderNode *node)
+{
+  const GskRoundedRect *clip = gsk_rounded_clip_node_get_clip (node);
+  GskRenderNode *child = gsk_rounded_clip_node_get_child (node);
+  GskRenderNode *optimized;
+  GskRenderNode *result;
+  graphene_rect_t visible;
+  Context child_context = *context;
+
+  if (!graphene_rect_intersection (&clip->bounds, &child->bounds, &visible))
+    {
+      self->stats->n_dropped_nodes++;
+      return NULL;
+    }
+
+  context_to_root (context, &clip->bounds, &child_context.clip);
+  if (!gsk_rounded_rect_is_rectilinear (clip))
+    child_context.can_cover = FALSE;
+
+  optimized = optimize_node (self, &child_context, child);
+  if (optimized == NULL)
+    return NULL;
+
+  if (gsk_rounded_rect_contains_rect (clip, &optimized->bounds))
+    {
+      self->stats->n_dropped_nodes++;
+      return optimized;
+    }
+
+  if (optimized == child)
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_rounded_clip_node_new (optimized, clip);
+
+  gsk_render_node_unref (optimized);
+
+  return result;
+}
+
+static GskRenderNode *
+optimize_debug_node (Optimizer     *self,
+                     const Context *context,
+                     GskRenderNode *node)
+{
+  GskRenderNode *child = gsk_debug_node_get_child (node);
+  GskRenderNode *optimized;
+  GskRenderNode *result;
+
+  optimized = optimize_node (self, context, child);
+  if (optimized == NULL)
+    return NULL;
+
+  if (optimized == child)
+    result = gsk_render_node_ref (node);
+  else
+    result = gsk_debug_node_new (optimized, g_strdup (gsk_debug_node_get_message (node)));
+
+  gsk_render_node_unref (optimized);
+
+  return result;
+}
+
+/* Returns a new reference, or %NULL if the node draws nothing */
+static GskRenderNode *
+optimize_node_uncached (Optimizer     *self,
+                        const Context *context,
+                        GskRenderNode *node)
+{
+  switch ((int) gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      return optimize_container_node (self, context, node);
+
+    case GSK_TRANSFORM_NODE:
+      return optimize_transform_node (self, context, node);
+
+    case GSK_OPACITY_NODE:
+      return optimize_opacity_node (self, context, node);
+
+    case GSK_CLIP_NODE:
+      return optimize_clip_node (self, context, node);
+
+    case GSK_ROUNDED_CLIP_NODE:
+      return optimize_rounded_clip_node (self, context, node);
+
+    case GSK_DEBUG_NODE:
+      return optimize_debug_node (self, context, node);
+
+    default:
+      g_assert_not_reached ();
+      return NULL;
+    }
+}
+
+/* Returns a new reference, or %NULL if the node draws nothing */
+static GskRenderNode *
+optimize_node (Optimizer     *self,
+               const Context *context,
+               GskRenderNode *node)
+{
+  GskRenderNodeOptimizeStats stats_before;
+  GPtrArray *entries;
+  CacheEntry *entry;
+  GskRenderNode *result;
+  guint n_rects_before;
+
+  if (is_covered (self, context, &node->bounds))
+    {
+      self->stats->n_culled_nodes++;
+      return NULL;
+    }
+
+  switch ((int) gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+    case GSK_TRANSFORM_NODE:
+    case GSK_OPACITY_NODE:
+    case GSK_CLIP_NODE:
+    case GSK_ROUNDED_CLIP_NODE:
+    case GSK_DEBUG_NODE:
+      break;
+
+    default:
+      if (is_opaque (node))
+        add_covered (self, context, &node->bounds);
+      return gsk_render_node_ref (node);
+    }
+
+  entry = lookup_entry (self, context, node);
+  if (entry)
+    return reuse_entry (self, entry);
+
+  entries = self->entries;
+  self->entries = g_ptr_array_new_with_free_func (cache_entry_unref);
+  n_rects_before = self->opaque_log->len;
+  stats_before = *self->stats;
+
+  result = optimize_node_uncached (self, context, node);
+
+  if (result != NULL && result != node)
+    {
+      GPtrArray *children = self->entries;
+
+      /* Nodes were recreated, so remember them for the next run */
+      self->entries = entries;
+      add_entry (self, context, node, result, n_rects_before, &stats_before, children);
+      g_ptr_array_unref (children);
+    }
+  else
+    {
+      g_ptr_array_extend_and_steal (entries, self->entries);
+      self->entries = entries;
+    }
+
+  return result;
+}
+
+/*< private >
+ * gsk_render_node_optimize_cache_new:
+ *
+ * Creates a cache for gsk_render_node_optimize().
+ *
+ * Returns: (transfer full): a new cache
+ */
+GskRenderNodeOptimizeCache *
+gsk_render_node_optimize_cache_new (void)
+{
+  GskRenderNodeOptimizeCache *cache;
+
+  cache = g_new (GskRenderNodeOptimizeCache, 1);
+  cache->previous = g_hash_table_new_full (NULL, NULL, NULL, cache_entry_unref);
+  cache->current = g_hash_table_new_full (NULL, NULL, NULL, cache_entry_unref);
+
+  return cache;
+}
+
+void
+gsk_render_node_optimize_cache_free (GskRenderNodeOptimizeCache *cache)
+{
+  g_hash_table_unref (cache->previous);
+  g_hash_table_unref (cache->current);
+  g_free (cache);
+}
+
+/*< private >
+ * gsk_render_node_optimize:
+ * @node: the root of a render node tree
+ * @stats: (out caller-allocates): return location for what was done
+ *
+ * Creates a tree that draws the same as @node, without nested or
+ * identity transforms, clips and opacities that have no effect,
+ * containers with a single child and content hidden below opaque
+ * colors and textures.
+ *
+ * Nodes created for the previous call with the same @cache are
+ * returned again for subtrees that did not change. Only the results
+ * of the previous call are kept in @cache.
+ *
+ * Returns: (transfer full): the optimized tree, which may be @node
+ */
+GskRenderNode *
+gsk_render_node_optimize (GskRenderNode              *node,
+                          GskRenderNodeOptimizeCache *cache,
+                          GskRenderNodeOptimizeStats *stats)
+{
+  Optimizer self;
+  Context context;
+  GskRenderNode *result;
+  GHashTable *previous;
+
+  memset (stats, 0, sizeof (GskRenderNodeOptimizeStats));
+
+  previous = cache->previous;
+  cache->previous = cache->current;
+  cache->current = previous;
+  g_hash_table_remove_all (cache->current);
+
+  self.stats = stats;
+  self.opaque = cairo_region_create ();
+  self.opaque_log = g_array_new (FALSE, FALSE, sizeof (cairo_rectangle_int_t));
+  self.cache = cache;
+  self.entries = g_ptr_array_new_with_free_func (cache_entry_unref);
+
+  context.dx = 0;
+  context.dy = 0;
+  context.clip = node->bounds;
+  context.can_cull = TRUE;
+  context.can_cover = TRUE;
+
+  result = optimize_node (&self, &context, node);
+  if (result == NULL)
+    result = gsk_container_node_new (NULL, 0);
+
+  cairo_region_destroy (self.opaque);
+  g_array_unref (self.opaque_log);
+  g_ptr_array_unref (self.entries);
+
+  return result;
+}
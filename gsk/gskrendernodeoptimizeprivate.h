@@ -0,0 +1,28 @@
+#ifndef __GSK_RENDER_NODE_OPTIMIZE_PRIVATE_H__
+#define __GSK_RENDER_NODE_OPTIMIZE_PRIVATE_H__
+
+#include "gskrendernodeprivate.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GskRenderNodeOptimizeCache GskRenderNodeOptimizeCache;
+typedef struct _GskRenderNodeOptimizeStats GskRenderNodeOptimizeStats;
+
+struct _GskRenderNodeOptimizeStats
+{
+  guint n_folded_transforms;
+  guint n_dropped_nodes;
+  guint n_culled_nodes;
+};
+
+GskRenderNodeOptimizeCache *
+                gsk_render_node_optimize_cache_new  (void);
+void            gsk_render_node_optimize_cache_free (GskRenderNodeOptimizeCache *cache);
+
+GskRenderNode * gsk_render_node_optimize        (GskRenderNode              *node,
+                                                 GskRenderNodeOptimizeCache *cache,
+                                                 GskRenderNodeOptimizeStats *stats);
+
+G_END_DECLS
+
+#endif /* __GSK_RENDER_NODE_OPTIMIZE_PRIVATE_H__ */
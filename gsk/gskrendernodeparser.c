@@ -23,6 +23,7 @@
 
 #include "gskrendernodeparserprivate.h"
 
+#include "gskrendernodebinaryprivate.h"
 #include "gskroundedrectprivate.h"
 #include "gskrendernodeprivate.h"
 #include "gsktransformprivate.h"
@@ -1879,6 +1880,9 @@ gsk_render_node_deserialize_from_bytes (GBytes            *bytes,
     gpointer user_data;
   } error_func_pair = { error_func, user_data };
 
+  if (gsk_render_node_binary_check (bytes))
+    return gsk_render_node_deserialize_binary (bytes, error_func, user_data);
+
   parser = gtk_css_parser_new_for_bytes (bytes, NULL, NULL, gsk_render_node_parser_error,
                                          &error_func_pair, NULL);
   root = parse_container_node (parser);
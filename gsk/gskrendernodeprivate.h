@@ -7,6 +7,8 @@
 G_BEGIN_DECLS
 
 typedef struct _GskRenderNodeClass GskRenderNodeClass;
+typedef struct _GskRenderNodeArena GskRenderNodeArena;
+typedef struct _GskRenderNodeArenaBlock GskRenderNodeArenaBlock;
 
 /* Keep this in sync with the GskRenderNodeType enumeration.
  *
@@ -27,6 +29,11 @@ struct _GskRenderNode
   gatomicrefcount ref_count;
 
   graphene_rect_t bounds;
+
+  guint hash;           /* structural hash, 0 if not computed yet */
+  guint interned : 1;
+
+  GskRenderNodeArenaBlock *arena_block;  /* NULL if allocated on the heap */
 };
 
 struct _GskRenderNodeClass
@@ -34,7 +41,9 @@ struct _GskRenderNodeClass
   GTypeClass parent_class;
 
   GskRenderNodeType node_type;
+  gsize instance_size;
 
+  void            (* instance_init) (GskRenderNode *node);
   void            (* finalize)    (GskRenderNode  *node);
   void            (* draw)        (GskRenderNode  *node,
                                    cairo_t        *cr);
@@ -43,6 +52,9 @@ struct _GskRenderNodeClass
   void            (* diff)        (GskRenderNode  *node1,
                                    GskRenderNode  *node2,
                                    cairo_region_t *region);
+  guint           (* hash)        (GskRenderNode  *node);
+  gboolean        (* equal)       (GskRenderNode  *node1,
+                                   GskRenderNode  *node2);
 };
 
 /*< private >
@@ -57,6 +69,11 @@ struct _GskRenderNodeClass
  *   unset, gsk_render_node_can_diff_true() will be used
  * @diff: (nullable): the function called by gsk_render_node_diff(); if unset,
  *   gsk_render_node_diff_impossible() will be used
+ * @hash: (nullable): the function computing the structural hash used by
+ *   gsk_render_node_get_hash(); if unset, the node's address will be used
+ * @equal: (nullable): the function used by gsk_render_node_equal() to compare
+ *   two nodes of the same type with the same hash; if unset, only identical
+ *   nodes compare equal
  *
  * A struction that contains the type information for a #GskRenderNode subclass,
  * to be used by gsk_render_node_type_register_static().
@@ -76,6 +93,9 @@ typedef struct
   void            (* diff)          (GskRenderNode        *node1,
                                      GskRenderNode        *node2,
                                      cairo_region_t       *region);
+  guint           (* hash)          (GskRenderNode        *node);
+  gboolean        (* equal)         (GskRenderNode        *node1,
+                                     GskRenderNode        *node2);
 } GskRenderNodeTypeInfo;
 
 void            gsk_render_node_init_types              (void);
@@ -85,6 +105,14 @@ GType           gsk_render_node_type_register_static    (const char
 
 gpointer        gsk_render_node_alloc                   (GskRenderNodeType            node_type);
 
+GskRenderNodeArena *
+                gsk_render_node_arena_new               (void);
+void            gsk_render_node_arena_free              (GskRenderNodeArena          *arena);
+GskRenderNodeArena *
+                gsk_render_node_arena_push              (GskRenderNodeArena          *arena);
+void            gsk_render_node_arena_pop               (GskRenderNodeArena          *arena,
+                                                         GskRenderNodeArena          *previous);
+
 gboolean        gsk_render_node_can_diff                (const GskRenderNode         *node1,
                                                          const GskRenderNode         *node2) G_GNUC_PURE;
 void            gsk_render_node_diff                    (GskRenderNode               *node1,
@@ -94,8 +122,23 @@ void            gsk_render_node_diff_impossible         (GskRenderNode
                                                          GskRenderNode               *node2,
                                                          cairo_region_t              *region);
 
+guint           gsk_render_node_get_hash                (GskRenderNode               *node);
+gboolean        gsk_render_node_equal                   (GskRenderNode               *node1,
+                                                         GskRenderNode               *node2);
+GskRenderNode * gsk_render_node_intern                  (GskRenderNode               *node);
+
 bool            gsk_border_node_get_uniform             (GskRenderNode               *self);
 
+gboolean        gsk_render_node_prepare_threaded_draw   (GskRenderNode               *node);
+gboolean        gsk_render_node_can_inherit_opacity     (GskRenderNode               *node);
+GDK_AVAILABLE_IN_ALL
+GskRenderNode * gsk_render_node_replace_children        (GskRenderNode               *node,
+                                                         GHashTable                  *replacements);
+
+guint *         gsk_container_node_get_children_in_rect (GskRenderNode               *node,
+                                                         const graphene_rect_t       *rect,
+                                                         guint                       *n_children);
+
 G_END_DECLS
 
 #endif /* __GSK_RENDER_NODE_PRIVATE_H__ */
@@ -0,0 +1,266 @@
+/* GSK - The GTK Scene Kit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gskrendernodestatsprivate.h"
+
+#include "gskroundedrectprivate.h"
+#include "gsktransformprivate.h"
+
+#include <string.h>
+
+/* The walk keeps track of the transform and clip of each node in
+ * the coordinates of the root, so the area a node draws to can be
+ * estimated. Rounded clips are treated as their bounds.
+ *
+ * What needs an offscreen depends on the renderer. The checks here
+ * follow what the GL renderer does: effects on a single color or
+ * texture can be drawn directly, anything else is drawn to an
+ * offscreen first.
+ */
+
+static gboolean
+is_simple_leaf (GskRenderNode *node)
+{
+  switch ((int) gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+    case GSK_TEXTURE_NODE:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static double
+rect_area (const graphene_rect_t *rect)
+{
+  return MAX (rect->size.width, 0) * MAX (rect->size.height, 0);
+}
+
+static void
+collect_stats (GskRenderNode         *node,
+               GskTransform          *transform,
+               const graphene_rect_t *clip,
+               guint                  depth,
+               GskRenderNodeStats    *stats,
+               double                *drawn_area)
+{
+  graphene_rect_t bounds;
+  guint i;
+
+  stats->n_nodes++;
+  stats->n_nodes_by_type[gsk_render_node_get_node_type (node)]++;
+  stats->max_depth = MAX (stats->max_depth, depth);
+
+  switch ((int) gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+        collect_stats (gsk_container_node_get_child (node, i),
+                       transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskTransform *node_transform = gsk_transform_node_get_transform (node);
+        GskRenderNode *child = gsk_transform_node_get_child (node);
+        GskTransform *child_transform;
+
+        if (gsk_transform_get_category (node_transform) == GSK_TRANSFORM_CATEGORY_IDENTITY ||
+            gsk_render_node_get_node_type (child) == GSK_TRANSFORM_NODE)
+          stats->n_redundant_transforms++;
+
+        child_transform = gsk_transform_transform (gsk_transform_ref (transform), node_transform);
+        collect_stats (child, child_transform, clip, depth + 1, stats, drawn_area);
+        gsk_transform_unref (child_transform);
+      }
+      break;
+
+    case GSK_CLIP_NODE:
+      {
+        GskRenderNode *child = gsk_clip_node_get_child (node);
+        graphene_rect_t child_clip;
+
+        if (graphene_rect_contains_rect (gsk_clip_node_get_clip (node), &child->bounds))
+          stats->n_redundant_clips++;
+
+        gsk_transform_transform_bounds (transform, gsk_clip_node_get_clip (node), &child_clip);
+        if (!graphene_rect_intersection (&child_clip, clip, &child_clip))
+          graphene_rect_init (&child_clip, 0, 0, 0, 0);
+
+        collect_stats (child, transform, &child_clip, depth + 1, stats, drawn_area);
+      }
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      {
+        const GskRoundedRect *rounded = gsk_rounded_clip_node_get_clip (node);
+        GskRenderNode *child = gsk_rounded_clip_node_get_child (node);
+        graphene_rect_t child_clip;
+
+        if (gsk_rounded_rect_contains_rect (rounded, &child->bounds))
+          stats->n_redundant_clips++;
+        else if (!gsk_rounded_rect_is_rectilinear (rounded) && !is_simple_leaf (child))
+          stats->n_offscreen_rounded_clip++;
+
+        gsk_transform_transform_bounds (transform, &rounded->bounds, &child_clip);
+        if (!graphene_rect_intersection (&child_clip, clip, &child_clip))
+          graphene_rect_init (&child_clip, 0, 0, 0, 0);
+
+        collect_stats (child, transform, &child_clip, depth + 1, stats, drawn_area);
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      {
+        GskRenderNode *child = gsk_opacity_node_get_child (node);
+
+        if (gsk_opacity_node_get_opacity (node) >= 1.0)
+          stats->n_redundant_opacities++;
+        else if (!is_simple_leaf (child))
+          stats->n_offscreen_opacity++;
+
+        collect_stats (child, transform, clip, depth + 1, stats, drawn_area);
+      }
+      break;
+
+    case GSK_BLUR_NODE:
+      if (gsk_blur_node_get_radius (node) > 0)
+        stats->n_offscreen_blur++;
+      collect_stats (gsk_blur_node_get_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_BLEND_NODE:
+      stats->n_offscreen_blend++;
+      collect_stats (gsk_blend_node_get_bottom_child (node), transform, clip, depth + 1, stats, drawn_area);
+      collect_stats (gsk_blend_node_get_top_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      stats->n_offscreen_other++;
+      collect_stats (gsk_cross_fade_node_get_start_child (node), transform, clip, depth + 1, stats, drawn_area);
+      collect_stats (gsk_cross_fade_node_get_end_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      if (!is_simple_leaf (gsk_color_matrix_node_get_child (node)))
+        stats->n_offscreen_other++;
+      collect_stats (gsk_color_matrix_node_get_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_REPEAT_NODE:
+      stats->n_offscreen_other++;
+      collect_stats (gsk_repeat_node_get_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_SHADOW_NODE:
+      stats->n_offscreen_other++;
+      collect_stats (gsk_shadow_node_get_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_DEBUG_NODE:
+      collect_stats (gsk_debug_node_get_child (node), transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    case GSK_GL_SHADER_NODE:
+      stats->n_offscreen_other += gsk_gl_shader_node_get_n_children (node);
+      for (i = 0; i < gsk_gl_shader_node_get_n_children (node); i++)
+        collect_stats (gsk_gl_shader_node_get_child (node, i),
+                       transform, clip, depth + 1, stats, drawn_area);
+      break;
+
+    default:
+      /* Everything else draws */
+      gsk_transform_transform_bounds (transform, &node->bounds, &bounds);
+      if (graphene_rect_intersection (&bounds, clip, &bounds))
+        *drawn_area += rect_area (&bounds);
+      break;
+    }
+}
+
+/*< private >
+ * gsk_render_node_get_stats:
+ * @node: the root of a render node tree
+ * @stats: (out caller-allocates): return location for the statistics
+ *
+ * Walks the tree below @node and collects statistics about it.
+ */
+void
+gsk_render_node_get_stats (GskRenderNode      *node,
+                           GskRenderNodeStats *stats)
+{
+  double drawn_area = 0;
+  double root_area;
+
+  memset (stats, 0, sizeof (GskRenderNodeStats));
+
+  collect_stats (node, NULL, &node->bounds, 1, stats, &drawn_area);
+
+  root_area = rect_area (&node->bounds);
+  if (root_area > 0)
+    stats->overdraw = drawn_area / root_area;
+}
+
+/*< private >
+ * gsk_render_node_stats_print:
+ * @stats: statistics from gsk_render_node_get_stats()
+ * @string: the string to append to
+ *
+ * Appends a human-readable summary of @stats to @string.
+ */
+void
+gsk_render_node_stats_print (const GskRenderNodeStats *stats,
+                             GString                  *string)
+{
+  guint offscreens;
+  int i;
+
+  g_string_append_printf (string, "Nodes: %u, depth %u, overdraw %.2f\n",
+                          stats->n_nodes, stats->max_depth, stats->overdraw);
+
+  for (i = 0; i < GSK_RENDER_NODE_TYPE_N_TYPES; i++)
+    {
+      if (stats->n_nodes_by_type[i] == 0)
+        continue;
+
+      g_string_append_printf (string, "  %-32s %u\n",
+                              g_type_name (gsk_render_node_types[i]),
+                              stats->n_nodes_by_type[i]);
+    }
+
+  offscreens = stats->n_offscreen_opacity +
+               stats->n_offscreen_blur +
+               stats->n_offscreen_rounded_clip +
+               stats->n_offscreen_blend +
+               stats->n_offscreen_other;
+  g_string_append_printf (string,
+                          "Likely offscreens: %u (opacity %u, blur %u, rounded clip %u, blend %u, other %u)\n",
+                          offscreens,
+                          stats->n_offscreen_opacity,
+                          stats->n_offscreen_blur,
+                          stats->n_offscreen_rounded_clip,
+                          stats->n_offscreen_blend,
+                          stats->n_offscreen_other);
+
+  g_string_append_printf (string,
+                          "Redundant nodes: %u transforms, %u clips, %u opacities\n",
+                          stats->n_redundant_transforms,
+                          stats->n_redundant_clips,
+                          stats->n_redundant_opacities);
+}
@@ -0,0 +1,42 @@
+#ifndef __GSK_RENDER_NODE_STATS_PRIVATE_H__
+#define __GSK_RENDER_NODE_STATS_PRIVATE_H__
+
+#include "gskrendernodeprivate.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GskRenderNodeStats GskRenderNodeStats;
+
+/* Statistics about a render node tree, for finding out why a
+ * frame is expensive to render.
+ */
+struct _GskRenderNodeStats
+{
+  guint n_nodes;
+  guint n_nodes_by_type[GSK_RENDER_NODE_TYPE_N_TYPES];
+  guint max_depth;
+
+  /* Area of the drawing nodes, relative to the area of the root */
+  double overdraw;
+
+  /* Nodes that renderers usually need an offscreen for */
+  guint n_offscreen_opacity;
+  guint n_offscreen_blur;
+  guint n_offscreen_rounded_clip;
+  guint n_offscreen_blend;
+  guint n_offscreen_other;
+
+  /* Nodes that don't change anything */
+  guint n_redundant_transforms;
+  guint n_redundant_clips;
+  guint n_redundant_opacities;
+};
+
+void    gsk_render_node_get_stats       (GskRenderNode            *node,
+                                         GskRenderNodeStats       *stats);
+void    gsk_render_node_stats_print     (const GskRenderNodeStats *stats,
+                                         GString                  *string);
+
+G_END_DECLS
+
+#endif /* __GSK_RENDER_NODE_STATS_PRIVATE_H__ */
@@ -400,6 +400,164 @@ gsk_rounded_rect_contains_point (const GskRoundedRect   *self,
   return gsk_rounded_rect_locate_point (self, point) == INSIDE;
 }
 
+/* A rounded rect packed for testing rects against it. All vectors
+ * are (left, top, -right, -bottom), so that checking if one of them
+ * contains a rect packed the same way is a single comparison.
+ *
+ * The bands are the parts of the rounded rect that the corners don't
+ * reach into, between the top and bottom corners and between the left
+ * and right ones. Rects touching a band need no corner math.
+ */
+typedef struct
+{
+  const GskRoundedRect *rect;
+  graphene_simd4f_t bounds;
+  graphene_simd4f_t hband;
+  graphene_simd4f_t vband;
+  gboolean empty;
+} PackedRoundedRect;
+
+static inline graphene_simd4f_t
+pack_rect (const graphene_rect_t *rect)
+{
+  return graphene_simd4f_init (rect->origin.x,
+                               rect->origin.y,
+                               - (rect->origin.x + rect->size.width),
+                               - (rect->origin.y + rect->size.height));
+}
+
+static void
+packed_rounded_rect_init (PackedRoundedRect    *packed,
+                          const GskRoundedRect *self)
+{
+  float top, right, bottom, left;
+
+  top = MAX (self->corner[GSK_CORNER_TOP_LEFT].height, self->corner[GSK_CORNER_TOP_RIGHT].height);
+  right = MAX (self->corner[GSK_CORNER_TOP_RIGHT].width, self->corner[GSK_CORNER_BOTTOM_RIGHT].width);
+  bottom = MAX (self->corner[GSK_CORNER_BOTTOM_LEFT].height, self->corner[GSK_CORNER_BOTTOM_RIGHT].height);
+  left = MAX (self->corner[GSK_CORNER_TOP_LEFT].width, self->corner[GSK_CORNER_BOTTOM_LEFT].width);
+
+  packed->rect = self;
+  packed->bounds = pack_rect (&self->bounds);
+  packed->hband = graphene_simd4f_add (packed->bounds, graphene_simd4f_init (0, top, 0, bottom));
+  packed->vband = graphene_simd4f_add (packed->bounds, graphene_simd4f_init (left, 0, right, 0));
+  packed->empty = self->bounds.size.width <= 0 || self->bounds.size.height <= 0;
+}
+
+/* Whether the area of @rect overlaps the area of @box, both packed.
+ * That is the case if each of them starts before the other one ends.
+ */
+static inline gboolean
+packed_overlaps (graphene_simd4f_t box,
+                 graphene_simd4f_t rect)
+{
+  return graphene_simd4f_cmp_lt (graphene_simd4f_add (rect, graphene_simd4f_shuffle_zwxy (box)),
+                                 graphene_simd4f_init_zero ());
+}
+
+/* Checks the point against the ellipse of @corner, if it is
+ * in the box that corner covers.
+ */
+static inline gboolean
+corner_contains_point (const GskRoundedRect *self,
+                       GskCorner             corner,
+                       float                 x,
+                       float                 y)
+{
+  const graphene_size_t *size = &self->corner[corner];
+  float cx, cy;
+
+  if (size->width <= 0 || size->height <= 0)
+    return TRUE;
+
+  if (corner == GSK_CORNER_TOP_LEFT || corner == GSK_CORNER_BOTTOM_LEFT)
+    {
+      cx = self->bounds.origin.x + size->width;
+      if (x >= cx)
+        return TRUE;
+    }
+  else
+    {
+      cx = self->bounds.origin.x + self->bounds.size.width - size->width;
+      if (x <= cx)
+        return TRUE;
+    }
+
+  if (corner == GSK_CORNER_TOP_LEFT || corner == GSK_CORNER_TOP_RIGHT)
+    {
+      cy = self->bounds.origin.y + size->height;
+      if (y >= cy)
+        return TRUE;
+    }
+  else
+    {
+      cy = self->bounds.origin.y + self->bounds.size.height - size->height;
+      if (y <= cy)
+        return TRUE;
+    }
+
+  return ellipsis_contains_point (size, &GRAPHENE_POINT_INIT (cx - x, cy - y));
+}
+
+static inline gboolean
+packed_rounded_rect_contains_rect (const PackedRoundedRect *packed,
+                                   const graphene_rect_t   *rect)
+{
+  const GskRoundedRect *self = packed->rect;
+  graphene_simd4f_t r = pack_rect (rect);
+  float x1, y1, x2, y2;
+
+  if (!graphene_simd4f_cmp_ge (r, packed->bounds))
+    return FALSE;
+
+  if (graphene_simd4f_cmp_ge (r, packed->hband) ||
+      graphene_simd4f_cmp_ge (r, packed->vband))
+    return TRUE;
+
+  /* The rect is inside the bounds, so if any of its points is outside
+   * a corner, the rect's own corner pointing the same way is, too.
+   */
+  x1 = rect->origin.x;
+  y1 = rect->origin.y;
+  x2 = rect->origin.x + rect->size.width;
+  y2 = rect->origin.y + rect->size.height;
+
+  return corner_contains_point (self, GSK_CORNER_TOP_LEFT, x1, y1) &&
+         corner_contains_point (self, GSK_CORNER_TOP_RIGHT, x2, y1) &&
+         corner_contains_point (self, GSK_CORNER_BOTTOM_RIGHT, x2, y2) &&
+         corner_contains_point (self, GSK_CORNER_BOTTOM_LEFT, x1, y2);
+}
+
+static inline gboolean
+packed_rounded_rect_intersects_rect (const PackedRoundedRect *packed,
+                                     const graphene_rect_t   *rect)
+{
+  const GskRoundedRect *self = packed->rect;
+  graphene_simd4f_t r;
+
+  if (packed->empty || rect->size.width <= 0 || rect->size.height <= 0)
+    return FALSE;
+
+  r = pack_rect (rect);
+
+  if (!packed_overlaps (packed->bounds, r))
+    return FALSE;
+
+  if (packed_overlaps (packed->hband, r) ||
+      packed_overlaps (packed->vband, r))
+    return TRUE;
+
+  /* If the bounding boxes intersect but the rectangles don't, one of the rect's corners
+   * must be in the opposite corner's outside region */
+  if (gsk_rounded_rect_locate_point (self, &rect->origin) == OUTSIDE_BOTTOM_RIGHT ||
+      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y)) == OUTSIDE_BOTTOM_LEFT ||
+      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x, rect->origin.y + rect->size.height)) == OUTSIDE_TOP_RIGHT ||
+      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y + rect->size.height)) == OUTSIDE_TOP_LEFT)
+    return FALSE;
+
+  return TRUE;
+}
+
 /**
  * gsk_rounded_rect_contains_rect:
  * @self: a #GskRoundedRect
@@ -415,19 +573,11 @@ gboolean
 gsk_rounded_rect_contains_rect (const GskRoundedRect  *self,
                                 const graphene_rect_t *rect)
 {
-  if (rect->origin.x < self->bounds.origin.x ||
-      rect->origin.y < self->bounds.origin.y ||
-      rect->origin.x + rect->size.width > self->bounds.origin.x + self->bounds.size.width ||
-      rect->origin.y + rect->size.height > self->bounds.origin.y + self->bounds.size.height)
-    return FALSE;
+  PackedRoundedRect packed;
 
-  if (!gsk_rounded_rect_contains_point (self, &rect->origin) ||
-      !gsk_rounded_rect_contains_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y)) ||
-      !gsk_rounded_rect_contains_point (self, &GRAPHENE_POINT_INIT (rect->origin.x, rect->origin.y + rect->size.height)) ||
-      !gsk_rounded_rect_contains_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y + rect->size.height)))
-    return FALSE;
+  packed_rounded_rect_init (&packed, self);
 
-  return TRUE;
+  return packed_rounded_rect_contains_rect (&packed, rect);
 }
 
 /**
@@ -445,18 +595,77 @@ gboolean
 gsk_rounded_rect_intersects_rect (const GskRoundedRect  *self,
                                   const graphene_rect_t *rect)
 {
-  if (!graphene_rect_intersection (&self->bounds, rect, NULL))
-    return FALSE;
+  PackedRoundedRect packed;
 
-  /* If the bounding boxes intersect but the rectangles don't, one of the rect's corners
-   * must be in the opposite corner's outside region */
-  if (gsk_rounded_rect_locate_point (self, &rect->origin) == OUTSIDE_BOTTOM_RIGHT ||
-      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y)) == OUTSIDE_BOTTOM_LEFT ||
-      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x, rect->origin.y + rect->size.height)) == OUTSIDE_TOP_RIGHT ||
-      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y + rect->size.height)) == OUTSIDE_TOP_LEFT)
-    return FALSE;
+  packed_rounded_rect_init (&packed, self);
 
-  return TRUE;
+  return packed_rounded_rect_intersects_rect (&packed, rect);
+}
+
+/*
+ * gsk_rounded_rect_contains_rects:
+ * @self: a #GskRoundedRect
+ * @rects: (array length=n_rects): the rectangles to check
+ * @n_rects: the number of rectangles
+ * @results: (array length=n_rects): return location for the results
+ *
+ * Like gsk_rounded_rect_contains_rect(), for many rectangles at once.
+ * This only sets up @self for the checks once.
+ *
+ * Returns: the number of rectangles that are contained in @self
+ */
+guint
+gsk_rounded_rect_contains_rects (const GskRoundedRect  *self,
+                                 const graphene_rect_t *rects,
+                                 guint                  n_rects,
+                                 gboolean              *results)
+{
+  PackedRoundedRect packed;
+  guint i, n;
+
+  packed_rounded_rect_init (&packed, self);
+
+  n = 0;
+  for (i = 0; i < n_rects; i++)
+    {
+      results[i] = packed_rounded_rect_contains_rect (&packed, &rects[i]);
+      n += results[i];
+    }
+
+  return n;
+}
+
+/*
+ * gsk_rounded_rect_intersects_rects:
+ * @self: a #GskRoundedRect
+ * @rects: (array length=n_rects): the rectangles to check
+ * @n_rects: the number of rectangles
+ * @results: (array length=n_rects): return location for the results
+ *
+ * Like gsk_rounded_rect_intersects_rect(), for many rectangles at once.
+ * This only sets up @self for the checks once.
+ *
+ * Returns: the number of rectangles that intersect @self
+ */
+guint
+gsk_rounded_rect_intersects_rects (const GskRoundedRect  *self,
+                                   const graphene_rect_t *rects,
+                                   guint                  n_rects,
+                                   gboolean              *results)
+{
+  PackedRoundedRect packed;
+  guint i, n;
+
+  packed_rounded_rect_init (&packed, self);
+
+  n = 0;
+  for (i = 0; i < n_rects; i++)
+    {
+      results[i] = packed_rounded_rect_intersects_rect (&packed, &rects[i]);
+      n += results[i];
+    }
+
+  return n;
 }
 
 static void
@@ -9,6 +9,15 @@ G_BEGIN_DECLS
 
 gboolean                 gsk_rounded_rect_is_circular           (const GskRoundedRect     *self);
 
+guint                    gsk_rounded_rect_contains_rects        (const GskRoundedRect     *self,
+                                                                 const graphene_rect_t    *rects,
+                                                                 guint                     n_rects,
+                                                                 gboolean                 *results);
+guint                    gsk_rounded_rect_intersects_rects      (const GskRoundedRect     *self,
+                                                                 const graphene_rect_t    *rects,
+                                                                 guint                     n_rects,
+                                                                 gboolean                 *results);
+
 void                     gsk_rounded_rect_path                  (const GskRoundedRect     *self,
                                                                  cairo_t                  *cr);
 void                     gsk_rounded_rect_to_float              (const GskRoundedRect     *self,
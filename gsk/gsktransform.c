@@ -45,6 +45,11 @@ struct _GskTransform
 
   GskTransformCategory category;
   GskTransform *next;
+
+  /* The whole chain as a 2D matrix, if category is 2D or better.
+   * Renderers query this a lot, so it is computed upfront.
+   */
+  float xx, yx, xy, yy, dx, dy;
 };
 
 struct _GskTransformClass
@@ -62,14 +67,6 @@ struct _GskTransformClass
                                                  float                  *out_yy,
                                                  float                  *out_dx,
                                                  float                  *out_dy);
-  void                  (* apply_affine)        (GskTransform           *transform,
-                                                 float                  *out_scale_x,
-                                                 float                  *out_scale_y,
-                                                 float                  *out_dx,
-                                                 float                  *out_dy);
-  void                  (* apply_translate)     (GskTransform           *transform,
-                                                 float                  *out_dx,
-                                                 float                  *out_dy);
   void                  (* print)               (GskTransform           *transform,
                                                  GString                *string);
   GskTransform *        (* apply)               (GskTransform           *transform,
@@ -133,6 +130,49 @@ gsk_transform_alloc (const GskTransformClass *transform_class,
   return self;
 }
 
+/*< private >
+ * gsk_transform_init_2d:
+ * @self: a newly created #GskTransform
+ *
+ * Computes the 2D matrix of the chain ending in @self, from the one
+ * of its next transform. Must be called once the class-specific
+ * fields of @self are set up.
+ *
+ * Returns: (transfer full): @self
+ */
+static gpointer
+gsk_transform_init_2d (GskTransform *self)
+{
+  if (self->category < GSK_TRANSFORM_CATEGORY_2D)
+    return self;
+
+  if (self->next)
+    {
+      self->xx = self->next->xx;
+      self->yx = self->next->yx;
+      self->xy = self->next->xy;
+      self->yy = self->next->yy;
+      self->dx = self->next->dx;
+      self->dy = self->next->dy;
+    }
+  else
+    {
+      self->xx = 1.0f;
+      self->yx = 0.0f;
+      self->xy = 0.0f;
+      self->yy = 1.0f;
+      self->dx = 0.0f;
+      self->dy = 0.0f;
+    }
+
+  self->transform_class->apply_2d (self,
+                                   &self->xx, &self->yx,
+                                   &self->xy, &self->yy,
+                                   &self->dx, &self->dy);
+
+  return self;
+}
+
 /*** IDENTITY ***/
 
 static void
@@ -158,22 +198,6 @@ gsk_identity_transform_apply_2d (GskTransform *transform,
 {
 }
 
-static void
-gsk_identity_transform_apply_affine (GskTransform *transform,
-                                     float        *out_scale_x,
-                                     float        *out_scale_y,
-                                     float        *out_dx,
-                                     float        *out_dy)
-{
-}
-
-static void
-gsk_identity_transform_apply_translate (GskTransform *transform,
-                                        float        *out_dx,
-                                        float        *out_dy)
-{
-}
-
 static void
 gsk_identity_transform_print (GskTransform *transform,
                               GString      *string)
@@ -221,8 +245,6 @@ static const GskTransformClass GSK_IDENTITY_TRANSFORM_CLASS =
   gsk_identity_transform_finalize,
   gsk_identity_transform_to_matrix,
   gsk_identity_transform_apply_2d,
-  gsk_identity_transform_apply_affine,
-  gsk_identity_transform_apply_translate,
   gsk_identity_transform_print,
   gsk_identity_transform_apply,
   gsk_identity_transform_invert,
@@ -302,70 +324,6 @@ gsk_matrix_transform_apply_2d (GskTransform *transform,
   *out_dy = graphene_matrix_get_value (&mat, 3, 1);
 }
 
-static void
-gsk_matrix_transform_apply_affine (GskTransform *transform,
-                                   float        *out_scale_x,
-                                   float        *out_scale_y,
-                                   float        *out_dx,
-                                   float        *out_dy)
-{
-  GskMatrixTransform *self = (GskMatrixTransform *) transform;
-
-  switch (transform->category)
-  {
-    case GSK_TRANSFORM_CATEGORY_UNKNOWN:
-    case GSK_TRANSFORM_CATEGORY_ANY:
-    case GSK_TRANSFORM_CATEGORY_3D:
-    case GSK_TRANSFORM_CATEGORY_2D:
-    default:
-      g_assert_not_reached ();
-      break;
-
-    case GSK_TRANSFORM_CATEGORY_2D_AFFINE:
-      *out_dx += *out_scale_x * graphene_matrix_get_x_translation (&self->matrix);
-      *out_dy += *out_scale_y * graphene_matrix_get_y_translation (&self->matrix);
-      *out_scale_x *= graphene_matrix_get_x_scale (&self->matrix);
-      *out_scale_y *= graphene_matrix_get_y_scale (&self->matrix);
-      break;
-
-    case GSK_TRANSFORM_CATEGORY_2D_TRANSLATE:
-      *out_dx += *out_scale_x * graphene_matrix_get_x_translation (&self->matrix);
-      *out_dy += *out_scale_y * graphene_matrix_get_y_translation (&self->matrix);
-      break;
-
-    case GSK_TRANSFORM_CATEGORY_IDENTITY:
-      break;
-  }
-}
-
-static void
-gsk_matrix_transform_apply_translate (GskTransform *transform,
-                                      float        *out_dx,
-                                      float        *out_dy)
-{
-  GskMatrixTransform *self = (GskMatrixTransform *) transform;
-
-  switch (transform->category)
-  {
-    case GSK_TRANSFORM_CATEGORY_UNKNOWN:
-    case GSK_TRANSFORM_CATEGORY_ANY:
-    case GSK_TRANSFORM_CATEGORY_3D:
-    case GSK_TRANSFORM_CATEGORY_2D:
-    case GSK_TRANSFORM_CATEGORY_2D_AFFINE:
-    default:
-      g_assert_not_reached ();
-      break;
-
-    case GSK_TRANSFORM_CATEGORY_2D_TRANSLATE:
-      *out_dx += graphene_matrix_get_x_translation (&self->matrix);
-      *out_dy += graphene_matrix_get_y_translation (&self->matrix);
-      break;
-
-    case GSK_TRANSFORM_CATEGORY_IDENTITY:
-      break;
-  }
-}
-
 static void
 string_append_double (GString *string,
                       double   d)
@@ -444,8 +402,6 @@ static const GskTransformClass GSK_TRANSFORM_TRANSFORM_CLASS =
   gsk_matrix_transform_finalize,
   gsk_matrix_transform_to_matrix,
   gsk_matrix_transform_apply_2d,
-  gsk_matrix_transform_apply_affine,
-  gsk_matrix_transform_apply_translate,
   gsk_matrix_transform_print,
   gsk_matrix_transform_apply,
   gsk_matrix_transform_invert,
@@ -461,7 +417,7 @@ gsk_transform_matrix_with_category (GskTransform            *next,
 
   graphene_matrix_init_from_matrix (&result->matrix, matrix);
 
-  return &result->parent;
+  return gsk_transform_init_2d (&result->parent);
 }
 
 /**
@@ -522,34 +478,6 @@ gsk_translate_transform_apply_2d (GskTransform *transform,
   *out_dy += *out_yx * self->point.x + *out_yy * self->point.y;
 }
 
-static void
-gsk_translate_transform_apply_affine (GskTransform *transform,
-                                      float        *out_scale_x,
-                                      float        *out_scale_y,
-                                      float        *out_dx,
-                                      float        *out_dy)
-{
-  GskTranslateTransform *self = (GskTranslateTransform *) transform;
-
-  g_assert (self->point.z == 0.0);
-
-  *out_dx += *out_scale_x * self->point.x;
-  *out_dy += *out_scale_y * self->point.y;
-}
-
-static void
-gsk_translate_transform_apply_translate (GskTransform *transform,
-                                         float        *out_dx,
-                                         float        *out_dy)
-{
-  GskTranslateTransform *self = (GskTranslateTransform *) transform;
-
-  g_assert (self->point.z == 0.0);
-
-  *out_dx += self->point.x;
-  *out_dy += self->point.y;
-}
-
 static GskTransform *
 gsk_translate_transform_apply (GskTransform *transform,
                                GskTransform *apply_to)
@@ -609,8 +537,6 @@ static const GskTransformClass GSK_TRANSLATE_TRANSFORM_CLASS =
   gsk_translate_transform_finalize,
   gsk_translate_transform_to_matrix,
   gsk_translate_transform_apply_2d,
-  gsk_translate_transform_apply_affine,
-  gsk_translate_transform_apply_translate,
   gsk_translate_transform_print,
   gsk_translate_transform_apply,
   gsk_translate_transform_invert,
@@ -673,7 +599,7 @@ gsk_transform_translate_3d (GskTransform             *next,
 
   graphene_point3d_init_from_point (&result->point, point);
 
-  return &result->parent;
+  return gsk_transform_init_2d (&result->parent);
 }
 
 /*** ROTATE ***/
@@ -817,8 +743,6 @@ static const GskTransformClass GSK_ROTATE_TRANSFORM_CLASS =
   gsk_rotate_transform_finalize,
   gsk_rotate_transform_to_matrix,
   gsk_rotate_transform_apply_2d,
-  NULL,
-  NULL,
   gsk_rotate_transform_print,
   gsk_rotate_transform_apply,
   gsk_rotate_transform_invert,
@@ -884,7 +808,7 @@ gsk_transform_rotate (GskTransform *next,
 
   result->angle = normalize_angle (angle);
 
-  return &result->parent;
+  return gsk_transform_init_2d (&result->parent);
 }
 
 /*** ROTATE 3D ***/
@@ -968,8 +892,6 @@ static const GskTransformClass GSK_ROTATE3D_TRANSFORM_CLASS =
   gsk_rotate3d_transform_finalize,
   gsk_rotate3d_transform_to_matrix,
   NULL,
-  NULL,
-  NULL,
   gsk_rotate3d_transform_print,
   gsk_rotate3d_transform_apply,
   gsk_rotate3d_transform_invert,
@@ -1008,7 +930,7 @@ gsk_transform_rotate_3d (GskTransform          *next,
   result->angle = normalize_angle (angle);
   graphene_vec3_init_from_vec3 (&result->axis, axis);
 
-  return &result->parent;
+  return gsk_transform_init_2d (&result->parent);
 }
 
 /*** SCALE ***/
@@ -1057,21 +979,6 @@ gsk_scale_transform_apply_2d (GskTransform *transform,
   *out_yy *= self->factor_y;
 }
 
-static void
-gsk_scale_transform_apply_affine (GskTransform *transform,
-                                  float        *out_scale_x,
-                                  float        *out_scale_y,
-                                  float        *out_dx,
-                                  float        *out_dy)
-{
-  GskScaleTransform *self = (GskScaleTransform *) transform;
-
-  g_assert (self->factor_z == 1.0);
-
-  *out_scale_x *= self->factor_x;
-  *out_scale_y *= self->factor_y;
-}
-
 static GskTransform *
 gsk_scale_transform_apply (GskTransform *transform,
                            GskTransform *apply_to)
@@ -1141,8 +1048,6 @@ static const GskTransformClass GSK_SCALE_TRANSFORM_CLASS =
   gsk_scale_transform_finalize,
   gsk_scale_transform_to_matrix,
   gsk_scale_transform_apply_2d,
-  gsk_scale_transform_apply_affine,
-  NULL,
   gsk_scale_transform_print,
   gsk_scale_transform_apply,
   gsk_scale_transform_invert,
@@ -1210,7 +1115,7 @@ gsk_transform_scale_3d (GskTransform *next,
   result->factor_y = factor_y;
   result->factor_z = factor_z;
 
-  return &result->parent;
+  return gsk_transform_init_2d (&result->parent);
 }
 
 /*** PERSPECTIVE ***/
@@ -1289,8 +1194,6 @@ static const GskTransformClass GSK_PERSPECTIVE_TRANSFORM_CLASS =
   gsk_perspective_transform_finalize,
   gsk_perspective_transform_to_matrix,
   NULL,
-  NULL,
-  NULL,
   gsk_perspective_transform_print,
   gsk_perspective_transform_apply,
   gsk_perspective_transform_invert,
@@ -1332,7 +1235,7 @@ gsk_transform_perspective (GskTransform *next,
 
   result->depth = depth;
 
-  return &result->parent;
+  return gsk_transform_init_2d (&result->parent);
 }
 
 /*** PUBLIC API ***/
@@ -1453,6 +1356,15 @@ gsk_transform_to_matrix (GskTransform      *self,
       return;
     }
 
+  if (self->category >= GSK_TRANSFORM_CATEGORY_2D)
+    {
+      graphene_matrix_init_from_2d (out_matrix,
+                                    self->xx, self->yx,
+                                    self->xy, self->yy,
+                                    self->dx, self->dy);
+      return;
+    }
+
   gsk_transform_to_matrix (self->next, out_matrix);
   self->transform_class->to_matrix (self, &m);
   graphene_matrix_multiply (&m, out_matrix, out_matrix);
@@ -1513,15 +1425,12 @@ gsk_transform_to_2d (GskTransform *self,
       return;
     }
 
-  gsk_transform_to_2d (self->next,
-                       out_xx, out_yx,
-                       out_xy, out_yy,
-                       out_dx, out_dy);
-
-  self->transform_class->apply_2d (self,
-                                   out_xx, out_yx,
-                                   out_xy, out_yy,
-                                   out_dx, out_dy);
+  *out_xx = self->xx;
+  *out_yx = self->yx;
+  *out_xy = self->xy;
+  *out_yy = self->yy;
+  *out_dx = self->dx;
+  *out_dy = self->dy;
 }
 
 /**
@@ -1571,23 +1480,10 @@ gsk_transform_to_affine (GskTransform *self,
       return;
     }
 
-  if (self->next != NULL)
-    {
-      gsk_transform_to_affine (self->next,
-                               out_scale_x, out_scale_y,
-                               out_dx, out_dy);
-    }
-  else
-    {
-      *out_scale_x = 1.0f;
-      *out_scale_y = 1.0f;
-      *out_dx = 0.0f;
-      *out_dy = 0.0f;
-    }
-
-  self->transform_class->apply_affine (self,
-                                       out_scale_x, out_scale_y,
-                                       out_dx, out_dy);
+  *out_scale_x = self->xx;
+  *out_scale_y = self->yy;
+  *out_dx = self->dx;
+  *out_dy = self->dy;
 }
 
 /**
@@ -1626,19 +1522,8 @@ gsk_transform_to_translate (GskTransform *self,
       return;
     }
 
-  if (self->next != NULL)
-    {
-      gsk_transform_to_translate (self->next,
-                                  out_dx, out_dy);
-    }
-  else
-    {
-      *out_dx = 0.0f;
-      *out_dy = 0.0f;
-    }
-
-  self->transform_class->apply_translate (self,
-                                          out_dx, out_dy);
+  *out_dx = self->dx;
+  *out_dy = self->dy;
 }
 
 /**
@@ -1764,7 +1649,7 @@ gsk_transform_get_category (GskTransform *self)
 GskTransform *
 gsk_transform_new (void)
 {
-  return gsk_transform_alloc (&GSK_IDENTITY_TRANSFORM_CLASS, GSK_TRANSFORM_CATEGORY_IDENTITY, NULL);
+  return gsk_transform_init_2d (gsk_transform_alloc (&GSK_IDENTITY_TRANSFORM_CLASS, GSK_TRANSFORM_CATEGORY_IDENTITY, NULL));
 }
 
 /**
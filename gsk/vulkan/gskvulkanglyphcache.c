@@ -361,13 +361,20 @@ gsk_vulkan_glyph_cache_lookup (GskVulkanGlyphCache *cache,
 
   if (value)
     {
-      if (cache->timestamp - value->timestamp >= MAX_AGE)
+      guint64 last_check = cache->timestamp - cache->timestamp % CHECK_INTERVAL;
+
+      /* Only glyphs that were already old at the last check are counted
+       * in old_pixels, newer ones would make it wrap around.
+       */
+      if (last_check > value->timestamp &&
+          last_check - value->timestamp >= MAX_AGE)
         {
           Atlas *atlas = g_ptr_array_index (cache->atlases, value->texture_index);
 
           atlas->old_pixels -= value->draw_width * value->draw_height;
-          value->timestamp = cache->timestamp;
         }
+
+      value->timestamp = cache->timestamp;
     }
 
   if (create && value == NULL)
@@ -476,8 +483,8 @@ gsk_vulkan_glyph_cache_begin_frame (GskVulkanGlyphCache *cache)
           g_ptr_array_remove_index (cache->atlases, i);
 
           drops[i] = 1;
-          for (j = i; j + 1 < len; j++)
-            shifts[j + 1] = shifts[j];
+          for (j = i + 1; j < len; j++)
+            shifts[j]--;
         }
     }
 
@@ -5,6 +5,7 @@
 #include "gskvulkanbufferprivate.h"
 #include "gskvulkanmemoryprivate.h"
 #include "gskvulkanpipelineprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
 
 #include <string.h>
 
@@ -198,6 +199,7 @@ gsk_vulkan_uploader_reset (GskVulkanUploader *self)
 
 static GskVulkanImage *
 gsk_vulkan_image_new (GdkVulkanContext      *context,
+                      VkFormat               format,
                       gsize                  width,
                       gsize                  height,
                       VkImageTiling          tiling,
@@ -223,7 +225,7 @@ gsk_vulkan_image_new (GdkVulkanContext      *context,
                                     .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
                                     .flags = 0,
                                     .imageType = VK_IMAGE_TYPE_2D,
-                                    .format = VK_FORMAT_B8G8R8A8_UNORM,
+                                    .format = format,
                                     .extent = { width, height, 1 },
                                     .mipLevels = 1,
                                     .arrayLayers = 1,
@@ -241,14 +243,14 @@ gsk_vulkan_image_new (GdkVulkanContext      *context,
                                 &requirements);
 
   self->memory = gsk_vulkan_memory_new (context,
-                                        requirements.memoryTypeBits,
+                                        &requirements,
                                         memory,
-                                        requirements.size);
+                                        tiling == VK_IMAGE_TILING_OPTIMAL);
 
   GSK_VK_CHECK (vkBindImageMemory, gdk_vulkan_context_get_device (context),
                                    self->vk_image,
                                    gsk_vulkan_memory_get_device_memory (self->memory),
-                                   0);
+                                   gsk_vulkan_memory_get_offset (self->memory));
   return self;
 }
 
@@ -318,34 +320,16 @@ gsk_vulkan_image_ensure_view (GskVulkanImage *self,
                                    &self->vk_image_view);
 }
 
+/* Copies @staging into a new image of @format and queues freeing it */
 static GskVulkanImage *
-gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
-                                                   guchar            *data,
-                                                   gsize              width,
-                                                   gsize              height,
-                                                   gsize              stride)
+gsk_vulkan_image_new_from_staging_buffer (GskVulkanUploader *uploader,
+                                          GskVulkanBuffer   *staging,
+                                          gsize              buffer_size,
+                                          VkFormat           format,
+                                          gsize              width,
+                                          gsize              height)
 {
   GskVulkanImage *self;
-  GskVulkanBuffer *staging;
-  gsize buffer_size = width * height * 4;
-  guchar *mem;
-
-  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, buffer_size);
-  mem = gsk_vulkan_buffer_map (staging);
-
-  if (stride == width * 4)
-    {
-      memcpy (mem, data, stride * height);
-    }
-  else
-    {
-      for (gsize i = 0; i < height; i++)
-        {
-          memcpy (mem + i * width * 4, data + i * stride, width * 4);
-        }
-    }
-
-  gsk_vulkan_buffer_unmap (staging);
 
   gsk_vulkan_uploader_add_buffer_barrier (uploader,
                                           FALSE,
@@ -361,6 +345,7 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                          });
 
   self = gsk_vulkan_image_new (uploader->vulkan,
+                               format,
                                width,
                                height,
                                VK_IMAGE_TILING_OPTIMAL,
@@ -407,11 +392,44 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
 
   uploader->staging_buffer_free_list = g_slist_prepend (uploader->staging_buffer_free_list, staging);
 
-  gsk_vulkan_image_ensure_view (self, VK_FORMAT_B8G8R8A8_UNORM);
+  gsk_vulkan_image_ensure_view (self, format);
 
   return self;
 }
 
+static GskVulkanImage *
+gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
+                                                   guchar            *data,
+                                                   gsize              width,
+                                                   gsize              height,
+                                                   gsize              stride)
+{
+  GskVulkanBuffer *staging;
+  gsize buffer_size = width * height * 4;
+  guchar *mem;
+
+  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, buffer_size);
+  mem = gsk_vulkan_buffer_map (staging);
+
+  if (stride == width * 4)
+    {
+      memcpy (mem, data, stride * height);
+    }
+  else
+    {
+      for (gsize i = 0; i < height; i++)
+        {
+          memcpy (mem + i * width * 4, data + i * stride, width * 4);
+        }
+    }
+
+  gsk_vulkan_buffer_unmap (staging);
+
+  return gsk_vulkan_image_new_from_staging_buffer (uploader, staging, buffer_size,
+                                                   VK_FORMAT_B8G8R8A8_UNORM,
+                                                   width, height);
+}
+
 static GskVulkanImage *
 gsk_vulkan_image_new_from_data_via_staging_image (GskVulkanUploader *uploader,
                                                   guchar            *data,
@@ -422,6 +440,7 @@ gsk_vulkan_image_new_from_data_via_staging_image (GskVulkanUploader *uploader,
   GskVulkanImage *self, *staging;
 
   staging = gsk_vulkan_image_new (uploader->vulkan,
+                                  VK_FORMAT_B8G8R8A8_UNORM,
                                   width,
                                   height,
                                   VK_IMAGE_TILING_LINEAR,
@@ -434,6 +453,7 @@ gsk_vulkan_image_new_from_data_via_staging_image (GskVulkanUploader *uploader,
   gsk_vulkan_image_upload_data (staging, data, width, height, stride);
 
   self = gsk_vulkan_image_new (uploader->vulkan,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                width,
                                height,
                                VK_IMAGE_TILING_OPTIMAL,
@@ -506,6 +526,7 @@ gsk_vulkan_image_new_from_data_directly (GskVulkanUploader *uploader,
   GskVulkanImage *self;
 
   self = gsk_vulkan_image_new (uploader->vulkan,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                width,
                                height,
                                VK_IMAGE_TILING_LINEAR,
@@ -542,6 +563,124 @@ gsk_vulkan_image_new_from_data (GskVulkanUploader *uploader,
     return gsk_vulkan_image_new_from_data_directly (uploader, data, width, height, stride);
 }
 
+static gboolean
+get_deep_format (GdkMemoryFormat  format,
+                 VkFormat        *out_vk_format,
+                 gsize           *out_channel_size,
+                 gsize           *out_n_channels)
+{
+  switch (format)
+    {
+    case GDK_MEMORY_R16G16B16:
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+      *out_vk_format = VK_FORMAT_R16G16B16A16_UNORM;
+      *out_channel_size = 2;
+      break;
+
+    case GDK_MEMORY_R16G16B16_FLOAT:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      *out_vk_format = VK_FORMAT_R16G16B16A16_SFLOAT;
+      *out_channel_size = 2;
+      break;
+
+    case GDK_MEMORY_R32G32B32_FLOAT:
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      *out_vk_format = VK_FORMAT_R32G32B32A32_SFLOAT;
+      *out_channel_size = 4;
+      break;
+
+    case GDK_MEMORY_B8G8R8A8_PREMULTIPLIED:
+    case GDK_MEMORY_A8R8G8B8_PREMULTIPLIED:
+    case GDK_MEMORY_R8G8B8A8_PREMULTIPLIED:
+    case GDK_MEMORY_B8G8R8A8:
+    case GDK_MEMORY_A8R8G8B8:
+    case GDK_MEMORY_R8G8B8A8:
+    case GDK_MEMORY_A8B8G8R8:
+    case GDK_MEMORY_R8G8B8:
+    case GDK_MEMORY_B8G8R8:
+    case GDK_MEMORY_N_FORMATS:
+    default:
+      return FALSE;
+    }
+
+  *out_n_channels = gdk_memory_format_bytes_per_pixel (format) / *out_channel_size;
+
+  return TRUE;
+}
+
+/* Uploads deep data without converting it to 8 bits. Vulkan
+ * implementations rarely support sampling from 3 channel formats,
+ * so those get an opaque alpha channel added on the way.
+ *
+ * Returns: (nullable): the new image, or %NULL if the device can't
+ *   filter images of @format, in which case the caller has to
+ *   convert the data itself
+ */
+GskVulkanImage *
+gsk_vulkan_image_new_from_deep_data (GskVulkanUploader *uploader,
+                                     const guchar      *data,
+                                     gsize              width,
+                                     gsize              height,
+                                     gsize              stride,
+                                     GdkMemoryFormat    format)
+{
+  static const guint16 one_u16 = 0xFFFF;
+  static const guint16 one_half = 0x3C00;
+  static const float one_float = 1.0f;
+  VkFormatProperties properties;
+  VkFormat vk_format;
+  GskVulkanBuffer *staging;
+  gsize channel_size, n_channels, buffer_size;
+  const void *one;
+  guchar *mem;
+
+  if (!get_deep_format (format, &vk_format, &channel_size, &n_channels))
+    return NULL;
+
+  vkGetPhysicalDeviceFormatProperties (gdk_vulkan_context_get_physical_device (uploader->vulkan),
+                                       vk_format,
+                                       &properties);
+  if ((properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) == 0)
+    return NULL;
+
+  if (vk_format == VK_FORMAT_R16G16B16A16_UNORM)
+    one = &one_u16;
+  else if (vk_format == VK_FORMAT_R16G16B16A16_SFLOAT)
+    one = &one_half;
+  else
+    one = &one_float;
+
+  buffer_size = width * height * 4 * channel_size;
+  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, buffer_size);
+  mem = gsk_vulkan_buffer_map (staging);
+
+  for (gsize y = 0; y < height; y++)
+    {
+      const guchar *src = data + y * stride;
+      guchar *dest = mem + y * width * 4 * channel_size;
+
+      if (n_channels == 4)
+        {
+          memcpy (dest, src, width * 4 * channel_size);
+          continue;
+        }
+
+      for (gsize x = 0; x < width; x++)
+        {
+          memcpy (dest, src, 3 * channel_size);
+          memcpy (dest + 3 * channel_size, one, channel_size);
+          src += 3 * channel_size;
+          dest += 4 * channel_size;
+        }
+    }
+
+  gsk_vulkan_buffer_unmap (staging);
+
+  return gsk_vulkan_image_new_from_staging_buffer (uploader, staging, buffer_size,
+                                                   vk_format,
+                                                   width, height);
+}
+
 GskVulkanImage *
 gsk_vulkan_image_new_for_swapchain (GdkVulkanContext *context,
                                     VkImage           image,
@@ -572,6 +711,7 @@ gsk_vulkan_image_new_for_framebuffer (GdkVulkanContext *context,
 
 
   self = gsk_vulkan_image_new (context,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                width,
                                height,
                                VK_IMAGE_TILING_OPTIMAL,
@@ -593,6 +733,7 @@ gsk_vulkan_image_new_for_atlas (GdkVulkanContext *context,
   GskVulkanImage *self;
 
   self = gsk_vulkan_image_new (context,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                width,
                                height,
                                VK_IMAGE_TILING_OPTIMAL,
@@ -614,6 +755,7 @@ gsk_vulkan_image_new_for_texture (GdkVulkanContext *context,
   GskVulkanImage *self;
 
   self = gsk_vulkan_image_new (context,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                width,
                                height,
                                VK_IMAGE_TILING_OPTIMAL,
@@ -718,7 +860,7 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
         }
       else
         {
-          for (gsize r = 0; r < regions[i].height; i++)
+          for (gsize r = 0; r < regions[i].height; r++)
             memcpy (m + r * regions[i].width * 4, regions[i].data + r * regions[i].stride, regions[i].width * 4);
         }
 
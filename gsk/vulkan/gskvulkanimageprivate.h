@@ -30,6 +30,12 @@ GskVulkanImage *        gsk_vulkan_image_new_from_data                  (GskVulk
                                                                          gsize                   width,
                                                                          gsize                   height,
                                                                          gsize                   stride);
+GskVulkanImage *        gsk_vulkan_image_new_from_deep_data             (GskVulkanUploader      *uploader,
+                                                                         const guchar           *data,
+                                                                         gsize                   width,
+                                                                         gsize                   height,
+                                                                         gsize                   stride,
+                                                                         GdkMemoryFormat         format);
 
 typedef struct {
   guchar *data;
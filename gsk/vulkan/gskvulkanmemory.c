@@ -3,49 +3,352 @@
 #include "gskvulkanpipelineprivate.h"
 #include "gskvulkanmemoryprivate.h"
 
-struct _GskVulkanMemory
+/* Allocations are carved out of large blocks of device memory, since
+ * drivers limit the number of allocations and vkAllocateMemory() is
+ * slow. Blocks are kept per memory type, and separately for optimally
+ * tiled images, so we never have to care about bufferImageGranularity.
+ *
+ * Only allocations too big to share a block get their own memory.
+ */
+#define BLOCK_SIZE (16 * 1024 * 1024)
+#define MAX_SUBALLOCATION_SIZE (BLOCK_SIZE / 4)
+/* Sizes are rounded up to this, so freed ranges are easy to reuse */
+#define ALLOCATION_GRANULE 256
+
+#define ALLOCATOR_KEY "gsk-vulkan-memory-allocator"
+
+typedef struct _GskVulkanAllocator GskVulkanAllocator;
+typedef struct _GskVulkanMemoryBlock GskVulkanMemoryBlock;
+
+typedef struct {
+  VkDeviceSize offset;
+  VkDeviceSize size;
+} FreeRange;
+
+struct _GskVulkanMemoryBlock
 {
+  VkDeviceMemory vk_memory;
+  guchar *map;
+
+  VkDeviceSize used;
+  GArray *free_ranges; /* FreeRange, sorted by offset */
+};
+
+struct _GskVulkanAllocator
+{
+  int ref_count;
+
   GdkVulkanContext *vulkan;
 
-  gsize size;
+  VkPhysicalDeviceMemoryProperties properties;
+
+  /* indexed by memory type * 2 + optimal tiling */
+  GPtrArray *blocks[VK_MAX_MEMORY_TYPES * 2];
+};
+
+struct _GskVulkanMemory
+{
+  GskVulkanAllocator *allocator;
+
+  /* NULL for dedicated allocations */
+  GskVulkanMemoryBlock *block;
+  guint pool;
 
   VkDeviceMemory vk_memory;
+  VkDeviceSize offset;
+  gsize size;
 };
 
-GskVulkanMemory *
-gsk_vulkan_memory_new (GdkVulkanContext      *context,
-                       uint32_t               allowed_types,
-                       VkMemoryPropertyFlags  flags,
-                       gsize                  size)
+static void
+gsk_vulkan_memory_block_free (gpointer data)
 {
-  VkPhysicalDeviceMemoryProperties properties;
-  GskVulkanMemory *self;
-  uint32_t i;
+  GskVulkanMemoryBlock *block = data;
 
-  self = g_slice_new0 (GskVulkanMemory);
+  g_array_unref (block->free_ranges);
 
+  g_slice_free (GskVulkanMemoryBlock, block);
+}
+
+static GskVulkanAllocator *
+gsk_vulkan_allocator_get (GdkVulkanContext *context)
+{
+  GskVulkanAllocator *self;
+
+  self = g_object_get_data (G_OBJECT (context), ALLOCATOR_KEY);
+  if (self)
+    {
+      self->ref_count++;
+      return self;
+    }
+
+  self = g_slice_new0 (GskVulkanAllocator);
+  self->ref_count = 1;
   self->vulkan = g_object_ref (context);
-  self->size = size;
 
   vkGetPhysicalDeviceMemoryProperties (gdk_vulkan_context_get_physical_device (context),
-                                       &properties);
+                                       &self->properties);
 
-  for (i = 0; i < properties.memoryTypeCount; i++)
+  /* The context does not own the allocator, so this is not a cycle */
+  g_object_set_data (G_OBJECT (context), ALLOCATOR_KEY, self);
+
+  return self;
+}
+
+static void
+gsk_vulkan_allocator_unref (GskVulkanAllocator *self)
+{
+  VkDevice device;
+  guint i, j;
+
+  self->ref_count--;
+  if (self->ref_count > 0)
+    return;
+
+  device = gdk_vulkan_context_get_device (self->vulkan);
+
+  for (i = 0; i < G_N_ELEMENTS (self->blocks); i++)
+    {
+      if (self->blocks[i] == NULL)
+        continue;
+
+      for (j = 0; j < self->blocks[i]->len; j++)
+        {
+          GskVulkanMemoryBlock *block = g_ptr_array_index (self->blocks[i], j);
+
+          vkFreeMemory (device, block->vk_memory, NULL);
+        }
+
+      g_ptr_array_unref (self->blocks[i]);
+    }
+
+  g_object_set_data (G_OBJECT (self->vulkan), ALLOCATOR_KEY, NULL);
+  g_object_unref (self->vulkan);
+
+  g_slice_free (GskVulkanAllocator, self);
+}
+
+static uint32_t
+gsk_vulkan_allocator_find_memory_type (GskVulkanAllocator    *self,
+                                       uint32_t               allowed_types,
+                                       VkMemoryPropertyFlags  flags)
+{
+  uint32_t i;
+
+  for (i = 0; i < self->properties.memoryTypeCount; i++)
     {
       if (!(allowed_types & (1 << i)))
         continue;
 
-      if ((properties.memoryTypes[i].propertyFlags & flags) == flags)
+      if ((self->properties.memoryTypes[i].propertyFlags & flags) == flags)
         break;
-  }
+    }
+
+  g_assert (i < self->properties.memoryTypeCount);
+
+  return i;
+}
+
+static gboolean
+gsk_vulkan_memory_block_alloc (GskVulkanMemoryBlock *block,
+                               VkDeviceSize          size,
+                               VkDeviceSize          alignment,
+                               VkDeviceSize         *offset)
+{
+  guint i;
+
+  for (i = 0; i < block->free_ranges->len; i++)
+    {
+      FreeRange *range = &g_array_index (block->free_ranges, FreeRange, i);
+      VkDeviceSize start, padding;
+
+      start = (range->offset + alignment - 1) / alignment * alignment;
+      padding = start - range->offset;
+
+      if (range->size < padding + size)
+        continue;
+
+      if (padding > 0)
+        {
+          FreeRange before = { range->offset, padding };
+
+          range->offset = start;
+          range->size -= padding;
+          g_array_insert_val (block->free_ranges, i, before);
+          range = &g_array_index (block->free_ranges, FreeRange, i + 1);
+          i++;
+        }
+
+      range->offset += size;
+      range->size -= size;
+      if (range->size == 0)
+        g_array_remove_index (block->free_ranges, i);
 
-  g_assert (i < properties.memoryTypeCount);
+      block->used += size;
+      *offset = start;
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+gsk_vulkan_memory_block_release (GskVulkanMemoryBlock *block,
+                                 VkDeviceSize          offset,
+                                 VkDeviceSize          size)
+{
+  FreeRange *prev, *next;
+  guint i;
+
+  block->used -= size;
+
+  for (i = 0; i < block->free_ranges->len; i++)
+    {
+      if (g_array_index (block->free_ranges, FreeRange, i).offset > offset)
+        break;
+    }
+
+  /* Merge with neighbouring free ranges, so the block does not fragment */
+  prev = i > 0 ? &g_array_index (block->free_ranges, FreeRange, i - 1) : NULL;
+  next = i < block->free_ranges->len ? &g_array_index (block->free_ranges, FreeRange, i) : NULL;
+
+  if (prev && prev->offset + prev->size == offset)
+    {
+      prev->size += size;
+      if (next && offset + size == next->offset)
+        {
+          prev->size += next->size;
+          g_array_remove_index (block->free_ranges, i);
+        }
+    }
+  else if (next && offset + size == next->offset)
+    {
+      next->offset = offset;
+      next->size += size;
+    }
+  else
+    {
+      FreeRange range = { offset, size };
+
+      g_array_insert_val (block->free_ranges, i, range);
+    }
+}
+
+static GskVulkanMemoryBlock *
+gsk_vulkan_allocator_new_block (GskVulkanAllocator *self,
+                                uint32_t            type_index)
+{
+  VkDevice device = gdk_vulkan_context_get_device (self->vulkan);
+  GskVulkanMemoryBlock *block;
+  FreeRange range = { 0, BLOCK_SIZE };
+
+  block = g_slice_new0 (GskVulkanMemoryBlock);
+
+  if (GSK_VK_CHECK (vkAllocateMemory, device,
+                                      &(VkMemoryAllocateInfo) {
+                                          .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                                          .allocationSize = BLOCK_SIZE,
+                                          .memoryTypeIndex = type_index
+                                      },
+                                      NULL,
+                                      &block->vk_memory) != VK_SUCCESS)
+    {
+      g_slice_free (GskVulkanMemoryBlock, block);
+      return NULL;
+    }
+
+  /* Memory can only be mapped once at a time, and many allocations
+   * share a block, so host-visible blocks stay mapped all the time.
+   */
+  if (self->properties.memoryTypes[type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+      void *data;
+
+      GSK_VK_CHECK (vkMapMemory, device, block->vk_memory, 0, VK_WHOLE_SIZE, 0, &data);
+      block->map = data;
+    }
+
+  block->free_ranges = g_array_new (FALSE, FALSE, sizeof (FreeRange));
+  g_array_append_val (block->free_ranges, range);
+
+  GSK_NOTE (VULKAN, g_message ("Allocated %u MB memory block for type %u",
+                               BLOCK_SIZE / (1024 * 1024), type_index));
+
+  return block;
+}
+
+static gboolean
+gsk_vulkan_memory_suballocate (GskVulkanMemory    *self,
+                               uint32_t            type_index,
+                               gboolean            optimal_tiling,
+                               VkDeviceSize        alignment)
+{
+  GskVulkanAllocator *allocator = self->allocator;
+  GskVulkanMemoryBlock *block;
+  GPtrArray *blocks;
+  guint i;
+
+  self->pool = type_index * 2 + (optimal_tiling ? 1 : 0);
+  if (allocator->blocks[self->pool] == NULL)
+    allocator->blocks[self->pool] = g_ptr_array_new_with_free_func (gsk_vulkan_memory_block_free);
+  blocks = allocator->blocks[self->pool];
+
+  for (i = 0; i < blocks->len; i++)
+    {
+      block = g_ptr_array_index (blocks, i);
+
+      if (gsk_vulkan_memory_block_alloc (block, self->size, alignment, &self->offset))
+        goto out;
+    }
+
+  block = gsk_vulkan_allocator_new_block (allocator, type_index);
+  if (block == NULL)
+    return FALSE;
+
+  g_ptr_array_add (blocks, block);
+  if (!gsk_vulkan_memory_block_alloc (block, self->size, alignment, &self->offset))
+    g_assert_not_reached ();
+
+out:
+  self->block = block;
+  self->vk_memory = block->vk_memory;
+
+  return TRUE;
+}
+
+GskVulkanMemory *
+gsk_vulkan_memory_new (GdkVulkanContext           *context,
+                       const VkMemoryRequirements *requirements,
+                       VkMemoryPropertyFlags       flags,
+                       gboolean                    optimal_tiling)
+{
+  GskVulkanMemory *self;
+  uint32_t type_index;
+
+  self = g_slice_new0 (GskVulkanMemory);
+
+  self->allocator = gsk_vulkan_allocator_get (context);
+  self->size = requirements->size;
+
+  type_index = gsk_vulkan_allocator_find_memory_type (self->allocator,
+                                                      requirements->memoryTypeBits,
+                                                      flags);
+
+  if (self->size <= MAX_SUBALLOCATION_SIZE)
+    {
+      self->size = (self->size + ALLOCATION_GRANULE - 1) / ALLOCATION_GRANULE * ALLOCATION_GRANULE;
+
+      if (gsk_vulkan_memory_suballocate (self, type_index, optimal_tiling, MAX (requirements->alignment, 1)))
+        return self;
+
+      self->size = requirements->size;
+    }
 
   GSK_VK_CHECK (vkAllocateMemory, gdk_vulkan_context_get_device (context),
                                   &(VkMemoryAllocateInfo) {
                                       .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                                      .allocationSize = size,
-                                      .memoryTypeIndex = i
+                                      .allocationSize = self->size,
+                                      .memoryTypeIndex = type_index
                                   },
                                   NULL,
                                   &self->vk_memory);
@@ -56,11 +359,31 @@ gsk_vulkan_memory_new (GdkVulkanContext      *context,
 void
 gsk_vulkan_memory_free (GskVulkanMemory *self)
 {
-  vkFreeMemory (gdk_vulkan_context_get_device (self->vulkan),
-                self->vk_memory,
-                NULL);
+  GskVulkanAllocator *allocator = self->allocator;
 
-  g_object_unref (self->vulkan);
+  if (self->block)
+    {
+      GPtrArray *blocks = allocator->blocks[self->pool];
+
+      gsk_vulkan_memory_block_release (self->block, self->offset, self->size);
+
+      /* Keep one empty block around, but no more */
+      if (self->block->used == 0 && blocks->len > 1)
+        {
+          vkFreeMemory (gdk_vulkan_context_get_device (allocator->vulkan),
+                        self->block->vk_memory,
+                        NULL);
+          g_ptr_array_remove_fast (blocks, self->block);
+        }
+    }
+  else
+    {
+      vkFreeMemory (gdk_vulkan_context_get_device (allocator->vulkan),
+                    self->vk_memory,
+                    NULL);
+    }
+
+  gsk_vulkan_allocator_unref (allocator);
 
   g_slice_free (GskVulkanMemory, self);
 }
@@ -71,12 +394,24 @@ gsk_vulkan_memory_get_device_memory (GskVulkanMemory *self)
   return self->vk_memory;
 }
 
+VkDeviceSize
+gsk_vulkan_memory_get_offset (GskVulkanMemory *self)
+{
+  return self->offset;
+}
+
 guchar *
 gsk_vulkan_memory_map (GskVulkanMemory *self)
 {
   void *data;
 
-  GSK_VK_CHECK (vkMapMemory, gdk_vulkan_context_get_device (self->vulkan),
+  if (self->block)
+    {
+      g_assert (self->block->map != NULL);
+      return self->block->map + self->offset;
+    }
+
+  GSK_VK_CHECK (vkMapMemory, gdk_vulkan_context_get_device (self->allocator->vulkan),
                              self->vk_memory,
                              0,
                              self->size,
@@ -89,7 +424,9 @@ gsk_vulkan_memory_map (GskVulkanMemory *self)
 void
 gsk_vulkan_memory_unmap (GskVulkanMemory *self)
 {
-  vkUnmapMemory (gdk_vulkan_context_get_device (self->vulkan),
+  if (self->block)
+    return;
+
+  vkUnmapMemory (gdk_vulkan_context_get_device (self->allocator->vulkan),
                  self->vk_memory);
 }
-
@@ -6,6 +6,8 @@
 #include "gskvulkanshaderprivate.h"
 
 #include <graphene.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 typedef struct _GskVulkanPipelinePrivate GskVulkanPipelinePrivate;
 
@@ -65,6 +67,152 @@ gsk_vulkan_pipeline_new (GType                    pipeline_type,
                                        VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA);
 }
 
+/* The pipeline cache is stored on disk per device, so that we don't
+ * have to compile all pipelines again every time an application starts.
+ * The driver validates the data itself, but we check the header first
+ * so we never hand it data for a different device.
+ */
+#define PIPELINE_CACHE_KEY "gsk-vulkan-pipeline-cache"
+#define PIPELINE_CACHE_HEADER_SIZE (16 + VK_UUID_SIZE)
+
+static char *
+get_pipeline_cache_path (const VkPhysicalDeviceProperties *props)
+{
+  char *basename, *path;
+
+  basename = g_strdup_printf ("vulkan-pipelines-%04x-%04x.cache",
+                              props->vendorID, props->deviceID);
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", basename, NULL);
+  g_free (basename);
+
+  return path;
+}
+
+static gboolean
+pipeline_cache_data_is_valid (const VkPhysicalDeviceProperties *props,
+                              const guchar                     *data,
+                              gsize                             size)
+{
+  guint32 header[4];
+
+  if (size < PIPELINE_CACHE_HEADER_SIZE)
+    return FALSE;
+
+  memcpy (header, data, sizeof (header));
+
+  return header[0] >= PIPELINE_CACHE_HEADER_SIZE &&
+         header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header[2] == props->vendorID &&
+         header[3] == props->deviceID &&
+         memcmp (data + 16, props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+/* Creates a pipeline cache for @context, filled from disk if there is
+ * a valid cache file. Pipelines created for @context use it until
+ * gsk_vulkan_pipeline_cache_free() is called.
+ */
+VkPipelineCache *
+gsk_vulkan_pipeline_cache_new (GdkVulkanContext *context)
+{
+  VkDevice device = gdk_vulkan_context_get_device (context);
+  VkPhysicalDeviceProperties props;
+  VkPipelineCache *cache;
+  char *path;
+  char *data = NULL;
+  gsize size = 0;
+  VkResult res;
+
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+
+  path = get_pipeline_cache_path (&props);
+  if (g_file_get_contents (path, &data, &size, NULL) &&
+      !pipeline_cache_data_is_valid (&props, (guchar *) data, size))
+    {
+      GSK_NOTE (VULKAN, g_message ("Ignoring stale pipeline cache %s", path));
+      g_clear_pointer (&data, g_free);
+      size = 0;
+    }
+
+  cache = g_new0 (VkPipelineCache, 1);
+
+  res = vkCreatePipelineCache (device,
+                               &(VkPipelineCacheCreateInfo) {
+                                   .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                   .initialDataSize = size,
+                                   .pInitialData = data,
+                               },
+                               NULL,
+                               cache);
+  if (res != VK_SUCCESS && data != NULL)
+    {
+      /* The driver didn't like the data after all, start from scratch */
+      GSK_VK_CHECK (vkCreatePipelineCache, device,
+                                           &(VkPipelineCacheCreateInfo) {
+                                               .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                           },
+                                           NULL,
+                                           cache);
+    }
+  else if (data != NULL)
+    {
+      GSK_NOTE (VULKAN, g_message ("Loaded %" G_GSIZE_FORMAT " bytes of pipeline cache from %s", size, path));
+    }
+
+  g_free (data);
+  g_free (path);
+
+  g_object_set_data (G_OBJECT (context), PIPELINE_CACHE_KEY, cache);
+
+  return cache;
+}
+
+/* Writes @cache to disk and destroys it. */
+void
+gsk_vulkan_pipeline_cache_free (GdkVulkanContext *context,
+                                VkPipelineCache  *cache)
+{
+  VkDevice device = gdk_vulkan_context_get_device (context);
+  VkPhysicalDeviceProperties props;
+  char *path, *dir;
+  gpointer data;
+  size_t size = 0;
+  GError *error = NULL;
+
+  g_object_set_data (G_OBJECT (context), PIPELINE_CACHE_KEY, NULL);
+
+  if (*cache == VK_NULL_HANDLE)
+    {
+      g_free (cache);
+      return;
+    }
+
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+  path = get_pipeline_cache_path (&props);
+  dir = g_path_get_dirname (path);
+
+  if (GSK_VK_CHECK (vkGetPipelineCacheData, device, *cache, &size, NULL) == VK_SUCCESS &&
+      size > 0)
+    {
+      data = g_malloc (size);
+
+      if (GSK_VK_CHECK (vkGetPipelineCacheData, device, *cache, &size, data) == VK_SUCCESS &&
+          g_mkdir_with_parents (dir, 0755) == 0 &&
+          !g_file_set_contents (path, data, size, &error))
+        {
+          GSK_NOTE (VULKAN, g_message ("Failed to save pipeline cache: %s", error->message));
+          g_clear_error (&error);
+        }
+
+      g_free (data);
+    }
+
+  vkDestroyPipelineCache (device, *cache, NULL);
+
+  g_free (dir);
+  g_free (path);
+  g_free (cache);
+}
+
 GskVulkanPipeline *
 gsk_vulkan_pipeline_new_full (GType                    pipeline_type,
                               GdkVulkanContext        *context,
@@ -76,6 +224,7 @@ gsk_vulkan_pipeline_new_full (GType                    pipeline_type,
 {
   GskVulkanPipelinePrivate *priv;
   GskVulkanPipeline *self;
+  VkPipelineCache *cache;
   VkDevice device;
 
   g_return_val_if_fail (g_type_is_a (pipeline_type, GSK_TYPE_VULKAN_PIPELINE), NULL);
@@ -95,8 +244,10 @@ gsk_vulkan_pipeline_new_full (GType                    pipeline_type,
   priv->vertex_shader = gsk_vulkan_shader_new_from_resource (context, GSK_VULKAN_SHADER_VERTEX, shader_name, NULL);
   priv->fragment_shader = gsk_vulkan_shader_new_from_resource (context, GSK_VULKAN_SHADER_FRAGMENT, shader_name, NULL);
 
+  cache = g_object_get_data (G_OBJECT (context), PIPELINE_CACHE_KEY);
+
   GSK_VK_CHECK (vkCreateGraphicsPipelines, device,
-                                           VK_NULL_HANDLE,
+                                           cache ? *cache : VK_NULL_HANDLE,
                                            1,
                                            &(VkGraphicsPipelineCreateInfo) {
                                                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
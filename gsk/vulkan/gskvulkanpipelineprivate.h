@@ -32,6 +32,10 @@ gsk_vulkan_handle_result (VkResult    res,
 
 #define GSK_VK_CHECK(func, ...) gsk_vulkan_handle_result (func (__VA_ARGS__), G_STRINGIFY (func))
 
+VkPipelineCache *       gsk_vulkan_pipeline_cache_new                   (GdkVulkanContext               *context);
+void                    gsk_vulkan_pipeline_cache_free                  (GdkVulkanContext               *context,
+                                                                         VkPipelineCache                *cache);
+
 GskVulkanPipeline *     gsk_vulkan_pipeline_new                         (GType                           pipeline_type,
                                                                          GdkVulkanContext               *context,
                                                                          VkPipelineLayout                layout,
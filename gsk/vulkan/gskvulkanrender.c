@@ -4,6 +4,7 @@
 
 #include "gskvulkanrenderprivate.h"
 
+#include "gskdebugprivate.h"
 #include "gskrendererprivate.h"
 #include "gskvulkanbufferprivate.h"
 #include "gskvulkancommandpoolprivate.h"
@@ -34,11 +35,14 @@ struct _GskVulkanRender
   int scale_factor;
   graphene_rect_t viewport;
   cairo_region_t *clip;
+  /* if the clip is damage in node coordinates */
+  gboolean cull_to_clip;
 
   GHashTable *framebuffers;
   GskVulkanCommandPool *command_pool;
   VkFence fence;
   VkRenderPass render_pass;
+  VkRenderPass offscreen_render_pass;
   VkDescriptorSetLayout descriptor_set_layout;
   VkPipelineLayout pipeline_layout[3]; /* indexed by number of textures */
   GskVulkanUploader *uploader;
@@ -57,11 +61,59 @@ struct _GskVulkanRender
 
   GList *render_passes;
   GSList *cleanup_images;
+  /* offscreens used by this frame, and the ones left over from the last one */
+  GSList *offscreens;
+  GSList *free_offscreens;
 
   GQuark render_pass_counter;
+  GQuark pipeline_time_counter;
   GQuark gpu_time_timer;
+
+  /* GSK_DEBUG=gpu-timing takes a timestamp before and after
+   * every render pass
+   */
+  VkQueryPool timestamp_pool;
+  guint n_timestamps;
+  float timestamp_period;
 };
 
+/* Damage regions with more rectangles than this are
+ * rendered using their extents */
+#define MAX_DAMAGE_RECTS 4
+
+/* Each rectangle of the clip gets its own render pass instance, and
+ * every one of them replays all draw commands. That only pays off for
+ * a few rectangles covering a lot less than their extents, like a
+ * blinking cursor and a spinner at opposite ends of the surface.
+ */
+static cairo_region_t *
+gsk_vulkan_render_get_damage_clip (const cairo_region_t *damage)
+{
+  cairo_rectangle_int_t extents;
+  gint64 area;
+  int i, n_rects;
+
+  cairo_region_get_extents (damage, &extents);
+
+  n_rects = cairo_region_num_rectangles (damage);
+  if (n_rects > 1 && n_rects <= MAX_DAMAGE_RECTS)
+    {
+      area = 0;
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (damage, i, &rect);
+          area += (gint64) rect.width * rect.height;
+        }
+
+      if (area * 2 <= (gint64) extents.width * extents.height)
+        return cairo_region_copy (damage);
+    }
+
+  return cairo_region_create_rectangle (&extents);
+}
+
 static void
 gsk_vulkan_render_setup (GskVulkanRender       *self,
                          GskVulkanImage        *target,
@@ -86,15 +138,12 @@ gsk_vulkan_render_setup (GskVulkanRender       *self,
     }
   if (clip)
     {
-      cairo_rectangle_int_t extents;
-      cairo_region_get_extents (clip, &extents);
-      self->clip = cairo_region_create_rectangle (&(cairo_rectangle_int_t) {
-                                                      extents.x, extents.y,
-                                                      extents.width, extents.height
-                                                  });
+      self->clip = gsk_vulkan_render_get_damage_clip (clip);
+      self->cull_to_clip = TRUE;
     }
   else
     {
+      self->cull_to_clip = FALSE;
       self->clip = cairo_region_create_rectangle (&(cairo_rectangle_int_t) {
                                                       0, 0,
                                                       gsk_vulkan_image_get_width (target),
@@ -106,6 +155,71 @@ gsk_vulkan_render_setup (GskVulkanRender       *self,
 static guint desc_set_index_hash (gconstpointer v);
 static gboolean desc_set_index_equal (gconstpointer v1, gconstpointer v2);
 
+static VkRenderPass
+gsk_vulkan_render_create_render_pass (GskVulkanRender *self,
+                                      VkImageLayout    initial_layout,
+                                      VkImageLayout    final_layout)
+{
+  VkRenderPass render_pass;
+  gboolean offscreen = final_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  /* All passes of a frame go into one command buffer, so offscreens
+   * need a dependency to make their result visible to the fragment
+   * shaders of the passes that sample them.
+   */
+  GSK_VK_CHECK (vkCreateRenderPass, gdk_vulkan_context_get_device (self->vulkan),
+                                    &(VkRenderPassCreateInfo) {
+                                        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+                                        .attachmentCount = 1,
+                                        .pAttachments = (VkAttachmentDescription[]) {
+                                           {
+                                              .format = gdk_vulkan_context_get_image_format (self->vulkan),
+                                              .samples = VK_SAMPLE_COUNT_1_BIT,
+                                              .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                              .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+                                              .initialLayout = initial_layout,
+                                              .finalLayout = final_layout,
+                                           }
+                                        },
+                                        .subpassCount = 1,
+                                        .pSubpasses = (VkSubpassDescription []) {
+                                           {
+                                              .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                              .inputAttachmentCount = 0,
+                                              .colorAttachmentCount = 1,
+                                              .pColorAttachments = (VkAttachmentReference []) {
+                                                 {
+                                                    .attachment = 0,
+                                                    .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+                                                 }
+                                              },
+                                              .pResolveAttachments = (VkAttachmentReference []) {
+                                                 {
+                                                    .attachment = VK_ATTACHMENT_UNUSED,
+                                                    .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+                                                 }
+                                              },
+                                              .pDepthStencilAttachment = NULL,
+                                           }
+                                        },
+                                        .dependencyCount = offscreen ? 1 : 0,
+                                        .pDependencies = (VkSubpassDependency []) {
+                                           {
+                                              .srcSubpass = 0,
+                                              .dstSubpass = VK_SUBPASS_EXTERNAL,
+                                              .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                              .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                              .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                              .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                                           }
+                                        }
+                                    },
+                                    NULL,
+                                    &render_pass);
+
+  return render_pass;
+}
+
 GskVulkanRender *
 gsk_vulkan_render_new (GskRenderer      *renderer,
                        GdkVulkanContext *context)
@@ -147,45 +261,16 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
                                         NULL,
                                         &self->descriptor_pool);
 
-  GSK_VK_CHECK (vkCreateRenderPass, gdk_vulkan_context_get_device (self->vulkan),
-                                    &(VkRenderPassCreateInfo) {
-                                        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-                                        .attachmentCount = 1,
-                                        .pAttachments = (VkAttachmentDescription[]) {
-                                           {
-                                              .format = gdk_vulkan_context_get_image_format (self->vulkan),
-                                              .samples = VK_SAMPLE_COUNT_1_BIT,
-                                              .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-                                              .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-                                              .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                                              .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                                           }
-                                        },
-                                        .subpassCount = 1,
-                                        .pSubpasses = (VkSubpassDescription []) {
-                                           {
-                                              .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                              .inputAttachmentCount = 0,
-                                              .colorAttachmentCount = 1,
-                                              .pColorAttachments = (VkAttachmentReference []) {
-                                                 {
-                                                    .attachment = 0,
-                                                     .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-                                                  }
-                                               },
-                                               .pResolveAttachments = (VkAttachmentReference []) {
-                                                  {
-                                                     .attachment = VK_ATTACHMENT_UNUSED,
-                                                     .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-                                                  }
-                                               },
-                                               .pDepthStencilAttachment = NULL,
-                                            }
-                                         },
-                                         .dependencyCount = 0
-                                      },
-                                      NULL,
-                                      &self->render_pass);
+  /* Offscreens cover their whole image and get cleared, so their
+   * old contents don't matter. The target keeps its contents outside
+   * the clip region.
+   */
+  self->render_pass = gsk_vulkan_render_create_render_pass (self,
+                                                            VK_IMAGE_LAYOUT_GENERAL,
+                                                            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+  self->offscreen_render_pass = gsk_vulkan_render_create_render_pass (self,
+                                                                      VK_IMAGE_LAYOUT_UNDEFINED,
+                                                                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
   GSK_VK_CHECK (vkCreateDescriptorSetLayout, device,
                                              &(VkDescriptorSetLayoutCreateInfo) {
@@ -257,6 +342,7 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
 
 #ifdef G_ENABLE_DEBUG
   self->render_pass_counter = g_quark_from_static_string ("render-passes");
+  self->pipeline_time_counter = g_quark_from_static_string ("pipeline-compile-time");
   self->gpu_time_timer = g_quark_from_static_string ("gpu-time");
 #endif
 
@@ -322,6 +408,43 @@ gsk_vulkan_render_add_cleanup_image (GskVulkanRender *self,
   self->cleanup_images = g_slist_prepend (self->cleanup_images, image);
 }
 
+/* Returns an image to render an offscreen of the given size into.
+ * Frames tend to need the same offscreens as the one before, so we
+ * keep those around and reuse them, along with their framebuffers.
+ */
+GskVulkanImage *
+gsk_vulkan_render_get_offscreen (GskVulkanRender *self,
+                                 gsize            width,
+                                 gsize            height)
+{
+  GskVulkanImage *image;
+  GSList *l;
+
+  for (l = self->free_offscreens; l; l = l->next)
+    {
+      image = l->data;
+
+      if (gsk_vulkan_image_get_width (image) == width &&
+          gsk_vulkan_image_get_height (image) == height)
+        {
+          self->free_offscreens = g_slist_delete_link (self->free_offscreens, l);
+          self->offscreens = g_slist_prepend (self->offscreens, image);
+          return image;
+        }
+    }
+
+  image = gsk_vulkan_image_new_for_texture (self->vulkan, width, height);
+  self->offscreens = g_slist_prepend (self->offscreens, image);
+
+  return image;
+}
+
+VkRenderPass
+gsk_vulkan_render_get_offscreen_render_pass (GskVulkanRender *self)
+{
+  return self->offscreen_render_pass;
+}
+
 void
 gsk_vulkan_render_add_render_pass (GskVulkanRender     *self,
                                    GskVulkanRenderPass *pass)
@@ -348,11 +471,14 @@ gsk_vulkan_render_add_node (GskVulkanRender *self,
                                      &mv,
                                      &self->viewport,
                                      self->clip,
-                                     VK_NULL_HANDLE);
+                                     self->render_pass);
 
   gsk_vulkan_render_add_render_pass (self, pass);
 
-  gsk_vulkan_render_pass_add (pass, self, node);
+  if (self->cull_to_clip)
+    gsk_vulkan_render_pass_add_culled (pass, self, node);
+  else
+    gsk_vulkan_render_pass_add (pass, self, node);
 }
 
 void
@@ -373,64 +499,116 @@ gsk_vulkan_render_upload (GskVulkanRender *self)
   gsk_vulkan_uploader_upload (self->uploader);
 }
 
+static const struct {
+  const char *name;
+  guint num_textures;
+  GskVulkanPipeline * (* create_func) (GdkVulkanContext *context, VkPipelineLayout layout, const char *name, VkRenderPass render_pass);
+} pipeline_info[GSK_VULKAN_N_PIPELINES] = {
+  { "texture",                    1, gsk_vulkan_texture_pipeline_new },
+  { "texture-clip",               1, gsk_vulkan_texture_pipeline_new },
+  { "texture-clip-rounded",       1, gsk_vulkan_texture_pipeline_new },
+  { "color",                      0, gsk_vulkan_color_pipeline_new },
+  { "color-clip",                 0, gsk_vulkan_color_pipeline_new },
+  { "color-clip-rounded",         0, gsk_vulkan_color_pipeline_new },
+  { "linear",                     0, gsk_vulkan_linear_gradient_pipeline_new },
+  { "linear-clip",                0, gsk_vulkan_linear_gradient_pipeline_new },
+  { "linear-clip-rounded",        0, gsk_vulkan_linear_gradient_pipeline_new },
+  { "color-matrix",               1, gsk_vulkan_effect_pipeline_new },
+  { "color-matrix-clip",          1, gsk_vulkan_effect_pipeline_new },
+  { "color-matrix-clip-rounded",  1, gsk_vulkan_effect_pipeline_new },
+  { "border",                     0, gsk_vulkan_border_pipeline_new },
+  { "border-clip",                0, gsk_vulkan_border_pipeline_new },
+  { "border-clip-rounded",        0, gsk_vulkan_border_pipeline_new },
+  { "inset-shadow",               0, gsk_vulkan_box_shadow_pipeline_new },
+  { "inset-shadow-clip",          0, gsk_vulkan_box_shadow_pipeline_new },
+  { "inset-shadow-clip-rounded",  0, gsk_vulkan_box_shadow_pipeline_new },
+  { "outset-shadow",              0, gsk_vulkan_box_shadow_pipeline_new },
+  { "outset-shadow-clip",         0, gsk_vulkan_box_shadow_pipeline_new },
+  { "outset-shadow-clip-rounded", 0, gsk_vulkan_box_shadow_pipeline_new },
+  { "blur",                       1, gsk_vulkan_blur_pipeline_new },
+  { "blur-clip",                  1, gsk_vulkan_blur_pipeline_new },
+  { "blur-clip-rounded",          1, gsk_vulkan_blur_pipeline_new },
+  { "mask",                       1, gsk_vulkan_text_pipeline_new },
+  { "mask-clip",                  1, gsk_vulkan_text_pipeline_new },
+  { "mask-clip-rounded",          1, gsk_vulkan_text_pipeline_new },
+  { "texture",                    1, gsk_vulkan_color_text_pipeline_new },
+  { "texture-clip",               1, gsk_vulkan_color_text_pipeline_new },
+  { "texture-clip-rounded",       1, gsk_vulkan_color_text_pipeline_new },
+  { "crossfade",                  2, gsk_vulkan_cross_fade_pipeline_new },
+  { "crossfade-clip",             2, gsk_vulkan_cross_fade_pipeline_new },
+  { "crossfade-clip-rounded",     2, gsk_vulkan_cross_fade_pipeline_new },
+  { "blendmode",                  2, gsk_vulkan_blend_mode_pipeline_new },
+  { "blendmode-clip",             2, gsk_vulkan_blend_mode_pipeline_new },
+  { "blendmode-clip-rounded",     2, gsk_vulkan_blend_mode_pipeline_new },
+};
+
 GskVulkanPipeline *
 gsk_vulkan_render_get_pipeline (GskVulkanRender       *self,
                                 GskVulkanPipelineType  type)
 {
-  static const struct {
-    const char *name;
-    guint num_textures;
-    GskVulkanPipeline * (* create_func) (GdkVulkanContext *context, VkPipelineLayout layout, const char *name, VkRenderPass render_pass);
-  } pipeline_info[GSK_VULKAN_N_PIPELINES] = {
-    { "texture",                    1, gsk_vulkan_texture_pipeline_new },
-    { "texture-clip",               1, gsk_vulkan_texture_pipeline_new },
-    { "texture-clip-rounded",       1, gsk_vulkan_texture_pipeline_new },
-    { "color",                      0, gsk_vulkan_color_pipeline_new },
-    { "color-clip",                 0, gsk_vulkan_color_pipeline_new },
-    { "color-clip-rounded",         0, gsk_vulkan_color_pipeline_new },
-    { "linear",                     0, gsk_vulkan_linear_gradient_pipeline_new },
-    { "linear-clip",                0, gsk_vulkan_linear_gradient_pipeline_new },
-    { "linear-clip-rounded",        0, gsk_vulkan_linear_gradient_pipeline_new },
-    { "color-matrix",               1, gsk_vulkan_effect_pipeline_new },
-    { "color-matrix-clip",          1, gsk_vulkan_effect_pipeline_new },
-    { "color-matrix-clip-rounded",  1, gsk_vulkan_effect_pipeline_new },
-    { "border",                     0, gsk_vulkan_border_pipeline_new },
-    { "border-clip",                0, gsk_vulkan_border_pipeline_new },
-    { "border-clip-rounded",        0, gsk_vulkan_border_pipeline_new },
-    { "inset-shadow",               0, gsk_vulkan_box_shadow_pipeline_new },
-    { "inset-shadow-clip",          0, gsk_vulkan_box_shadow_pipeline_new },
-    { "inset-shadow-clip-rounded",  0, gsk_vulkan_box_shadow_pipeline_new },
-    { "outset-shadow",              0, gsk_vulkan_box_shadow_pipeline_new },
-    { "outset-shadow-clip",         0, gsk_vulkan_box_shadow_pipeline_new },
-    { "outset-shadow-clip-rounded", 0, gsk_vulkan_box_shadow_pipeline_new },
-    { "blur",                       1, gsk_vulkan_blur_pipeline_new },
-    { "blur-clip",                  1, gsk_vulkan_blur_pipeline_new },
-    { "blur-clip-rounded",          1, gsk_vulkan_blur_pipeline_new },
-    { "mask",                       1, gsk_vulkan_text_pipeline_new },
-    { "mask-clip",                  1, gsk_vulkan_text_pipeline_new },
-    { "mask-clip-rounded",          1, gsk_vulkan_text_pipeline_new },
-    { "texture",                    1, gsk_vulkan_color_text_pipeline_new },
-    { "texture-clip",               1, gsk_vulkan_color_text_pipeline_new },
-    { "texture-clip-rounded",       1, gsk_vulkan_color_text_pipeline_new },
-    { "crossfade",                  2, gsk_vulkan_cross_fade_pipeline_new },
-    { "crossfade-clip",             2, gsk_vulkan_cross_fade_pipeline_new },
-    { "crossfade-clip-rounded",     2, gsk_vulkan_cross_fade_pipeline_new },
-    { "blendmode",                  2, gsk_vulkan_blend_mode_pipeline_new },
-    { "blendmode-clip",             2, gsk_vulkan_blend_mode_pipeline_new },
-    { "blendmode-clip-rounded",     2, gsk_vulkan_blend_mode_pipeline_new },
-  };
-
   g_return_val_if_fail (type < GSK_VULKAN_N_PIPELINES, NULL);
 
   if (self->pipelines[type] == NULL)
-    self->pipelines[type] = pipeline_info[type].create_func (self->vulkan,
-                                                             self->pipeline_layout[pipeline_info[type].num_textures],
-                                                             pipeline_info[type].name,
-                                                             self->render_pass);
+    {
+#ifdef G_ENABLE_DEBUG
+      gint64 start_time = g_get_monotonic_time ();
+      gint64 compile_time;
+#endif
+
+      self->pipelines[type] = pipeline_info[type].create_func (self->vulkan,
+                                                               self->pipeline_layout[pipeline_info[type].num_textures],
+                                                               pipeline_info[type].name,
+                                                               self->render_pass);
+
+#ifdef G_ENABLE_DEBUG
+      compile_time = g_get_monotonic_time () - start_time;
+      gsk_profiler_counter_add (gsk_renderer_get_profiler (self->renderer),
+                                self->pipeline_time_counter,
+                                compile_time);
+      GSK_RENDERER_NOTE (self->renderer, VULKAN,
+                         g_message ("Creating pipeline %s took %" G_GINT64_FORMAT " us",
+                                    pipeline_info[type].name, compile_time));
+#endif
+    }
 
   return self->pipelines[type];
 }
 
+/* Creates all pipelines once and drops them again, so that they end
+ * up in the pipeline cache and creating them for real later is cheap.
+ *
+ * This only touches state of @self that does not change after
+ * gsk_vulkan_render_new(), so it can run in a thread while @self is
+ * used for rendering. Stops early once @cancelled becomes nonzero.
+ */
+void
+gsk_vulkan_render_warm_pipelines (GskVulkanRender *self,
+                                  volatile int    *cancelled)
+{
+  GskVulkanPipeline *pipeline;
+  guint i;
+
+  for (i = 0; i < GSK_VULKAN_N_PIPELINES; i++)
+    {
+      gint64 start_time G_GNUC_UNUSED;
+
+      if (g_atomic_int_get (cancelled))
+        break;
+
+      start_time = g_get_monotonic_time ();
+
+      pipeline = pipeline_info[i].create_func (self->vulkan,
+                                               self->pipeline_layout[pipeline_info[i].num_textures],
+                                               pipeline_info[i].name,
+                                               self->render_pass);
+      g_object_unref (pipeline);
+
+      GSK_RENDERER_NOTE (self->renderer, VULKAN,
+                         g_message ("Precompiling pipeline %s took %" G_GINT64_FORMAT " us",
+                                    pipeline_info[i].name, g_get_monotonic_time () - start_time));
+    }
+}
+
 VkDescriptorSet
 gsk_vulkan_render_get_descriptor_set (GskVulkanRender *self,
                                       gsize            id)
@@ -587,44 +765,139 @@ gsk_vulkan_render_prepare_descriptor_sets (GskVulkanRender *self)
     }
 }
 
+#ifdef G_ENABLE_DEBUG
+static gboolean
+gsk_vulkan_render_ensure_timestamps (GskVulkanRender *self,
+                                     guint            n_timestamps)
+{
+  VkDevice device = gdk_vulkan_context_get_device (self->vulkan);
+
+  if (self->timestamp_period == 0)
+    {
+      VkPhysicalDeviceProperties props;
+
+      vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (self->vulkan), &props);
+      if (!props.limits.timestampComputeAndGraphics)
+        return FALSE;
+
+      self->timestamp_period = props.limits.timestampPeriod;
+    }
+
+  if (n_timestamps <= self->n_timestamps)
+    return TRUE;
+
+  if (self->timestamp_pool != VK_NULL_HANDLE)
+    vkDestroyQueryPool (device, self->timestamp_pool, NULL);
+
+  self->n_timestamps = MAX (n_timestamps, 2 * self->n_timestamps);
+  GSK_VK_CHECK (vkCreateQueryPool, device,
+                                   &(VkQueryPoolCreateInfo) {
+                                       .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                       .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                       .queryCount = self->n_timestamps
+                                   },
+                                   NULL,
+                                   &self->timestamp_pool);
+
+  return TRUE;
+}
+
+static void
+gsk_vulkan_render_collect_gpu_spans (GskVulkanRender *self,
+                                     guint            n_passes)
+{
+  VkDevice device = gdk_vulkan_context_get_device (self->vulkan);
+  GskProfiler *profiler = gsk_renderer_get_profiler (self->renderer);
+  guint64 *timestamps;
+  GList *l;
+  guint i;
+
+  GSK_VK_CHECK (vkWaitForFences, device,
+                                 1,
+                                 &self->fence,
+                                 VK_TRUE,
+                                 INT64_MAX);
+
+  timestamps = g_new (guint64, 2 * n_passes);
+  GSK_VK_CHECK (vkGetQueryPoolResults, device,
+                                       self->timestamp_pool,
+                                       0, 2 * n_passes,
+                                       sizeof (guint64) * 2 * n_passes,
+                                       timestamps,
+                                       sizeof (guint64),
+                                       VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+  for (l = self->render_passes, i = 0; l; l = l->next, i++)
+    {
+      GskVulkanRenderPass *pass = l->data;
+
+      gsk_profiler_add_gpu_span (profiler,
+                                 gsk_vulkan_render_pass_get_target (pass) == self->target ? "Frame" : "Offscreen",
+                                 0,
+                                 (timestamps[2 * i] - timestamps[0]) * self->timestamp_period,
+                                 (timestamps[2 * i + 1] - timestamps[2 * i]) * self->timestamp_period);
+    }
+
+  g_free (timestamps);
+}
+#endif
+
 void
 gsk_vulkan_render_draw (GskVulkanRender *self)
 {
+  VkCommandBuffer command_buffer;
+  gboolean time_passes = FALSE;
+  guint n_passes;
   GList *l;
+  guint i;
 
 #ifdef G_ENABLE_DEBUG
   if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC))
     gsk_profiler_timer_begin (gsk_renderer_get_profiler (self->renderer), self->gpu_time_timer);
 #endif
 
+  n_passes = g_list_length (self->render_passes);
+
+#ifdef G_ENABLE_DEBUG
+  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, GPU_TIMING))
+    time_passes = gsk_vulkan_render_ensure_timestamps (self, 2 * n_passes);
+#endif
+
   gsk_vulkan_render_prepare_descriptor_sets (self);
 
-  for (l = self->render_passes; l; l = l->next)
+  /* The passes are sorted so that offscreens come before the passes
+   * using them, and render pass dependencies order them on the GPU,
+   * so everything can go into one submission.
+   */
+  command_buffer = gsk_vulkan_command_pool_get_buffer (self->command_pool);
+
+  if (time_passes)
+    vkCmdResetQueryPool (command_buffer, self->timestamp_pool, 0, 2 * n_passes);
+
+  for (l = self->render_passes, i = 0; l; l = l->next, i++)
     {
       GskVulkanRenderPass *pass = l->data;
-      VkCommandBuffer command_buffer;
-      gsize wait_semaphore_count;
-      gsize signal_semaphore_count;
-      VkSemaphore *wait_semaphores;
-      VkSemaphore *signal_semaphores;
-
-      wait_semaphore_count = gsk_vulkan_render_pass_get_wait_semaphores (pass, &wait_semaphores);
-      signal_semaphore_count = gsk_vulkan_render_pass_get_signal_semaphores (pass, &signal_semaphores);
 
-      command_buffer = gsk_vulkan_command_pool_get_buffer (self->command_pool);
+      /* Like the GL renderer, time from the end of the previous work */
+      if (time_passes)
+        vkCmdWriteTimestamp (command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, self->timestamp_pool, 2 * i);
 
       gsk_vulkan_render_pass_draw (pass, self, 3, self->pipeline_layout, command_buffer);
 
-      gsk_vulkan_command_pool_submit_buffer (self->command_pool,
-                                             command_buffer,
-                                             wait_semaphore_count,
-                                             wait_semaphores,
-                                             signal_semaphore_count,
-                                             signal_semaphores,
-                                             l->next != NULL ? VK_NULL_HANDLE : self->fence);
+      if (time_passes)
+        vkCmdWriteTimestamp (command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, self->timestamp_pool, 2 * i + 1);
     }
 
+  gsk_vulkan_command_pool_submit_buffer (self->command_pool,
+                                         command_buffer,
+                                         0, NULL,
+                                         0, NULL,
+                                         self->fence);
+
 #ifdef G_ENABLE_DEBUG
+  if (time_passes)
+    gsk_vulkan_render_collect_gpu_spans (self, n_passes);
+
   if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC))
     {
       GskProfiler *profiler;
@@ -681,6 +954,11 @@ gsk_vulkan_render_cleanup (GskVulkanRender *self)
   g_slist_free_full (self->cleanup_images, g_object_unref);
   self->cleanup_images = NULL;
 
+  /* Offscreens the last frame did not reuse are probably not needed anymore */
+  g_slist_free_full (self->free_offscreens, g_object_unref);
+  self->free_offscreens = self->offscreens;
+  self->offscreens = NULL;
+
   g_clear_pointer (&self->clip, cairo_region_destroy);
   g_clear_object (&self->target);
 }
@@ -724,6 +1002,11 @@ gsk_vulkan_render_free (GskVulkanRender *self)
   vkDestroyRenderPass (device,
                        self->render_pass,
                        NULL);
+  vkDestroyRenderPass (device,
+                       self->offscreen_render_pass,
+                       NULL);
+
+  g_slist_free_full (self->free_offscreens, g_object_unref);
 
   vkDestroyDescriptorPool (device,
                            self->descriptor_pool,
@@ -739,6 +1022,11 @@ gsk_vulkan_render_free (GskVulkanRender *self)
                   self->fence,
                   NULL);
 
+  if (self->timestamp_pool != VK_NULL_HANDLE)
+    vkDestroyQueryPool (device,
+                        self->timestamp_pool,
+                        NULL);
+
   vkDestroySampler (device,
                     self->sampler,
                     NULL);
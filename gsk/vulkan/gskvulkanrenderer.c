@@ -11,7 +11,9 @@
 #include "gskvulkanpipelineprivate.h"
 #include "gskvulkanrenderprivate.h"
 #include "gskvulkanglyphcacheprivate.h"
+#include "gskgradientrampprivate.h"
 
+#include "gdk/gdkmemorytextureprivate.h"
 #include "gdk/gdktextureprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 
@@ -23,14 +25,35 @@ struct _GskVulkanTextureData {
   GdkTexture *texture;
   GskVulkanImage *image;
   GskVulkanRenderer *renderer;
+
+  /* How the texture was drawn lately, see get_downscale() */
+  guint downscale;  /* The image was halved this many times */
+  guint small_frames;
+  guint64 draw_frame;
+  int window_width;
+  int window_height;
+  gint64 saved_bytes;
+};
+
+typedef struct _GskVulkanFallbackData GskVulkanFallbackData;
+
+struct _GskVulkanFallbackData {
+  GskRenderNode *node;
+  GskVulkanImage *image;
+  int scale_factor;
+  guint64 last_used;
 };
 
 #ifdef G_ENABLE_DEBUG
 typedef struct {
   GQuark frames;
   GQuark render_passes;
+  GQuark pipeline_compile_time;
   GQuark fallback_pixels;
   GQuark texture_pixels;
+  GQuark offscreens_avoided;
+  GQuark render_data_conflicts;
+  GQuark downscaled_bytes;
 } ProfileCounters;
 
 typedef struct {
@@ -38,10 +61,24 @@ typedef struct {
   GQuark gpu_time;
 } ProfileTimers;
 
-static guint texture_pixels_counter;
-static guint fallback_pixels_counter;
 #endif
 
+/* How many frames we let the GPU work on while we record the next one.
+ * Each of them has its own GskVulkanRender, so command buffers,
+ * descriptor pools and vertex buffers are not shared between them.
+ */
+#define MAX_FRAMES_IN_FLIGHT 3
+
+/* How many frames a rasterized fallback node is kept around without
+ * being drawn.
+ */
+#define MAX_FALLBACK_AGE 30
+
+/* How many frames in a row a texture has to be drawn at less than
+ * half its size before it is uploaded again at a smaller size.
+ */
+#define DOWNSCALE_FRAMES 30
+
 struct _GskVulkanRenderer
 {
   GskRenderer parent_instance;
@@ -51,12 +88,24 @@ struct _GskVulkanRenderer
   guint n_targets;
   GskVulkanImage **targets;
 
-  GskVulkanRender *render;
+  GskVulkanRender *renders[MAX_FRAMES_IN_FLIGHT];
+  guint n_renders;
+  guint current_render;
+
+  VkPipelineCache *pipeline_cache;
+  GThread *warmup_thread;
+  volatile int warmup_cancelled;
 
   GSList *textures;
 
+  GHashTable *fallbacks;
+  guint64 frame_count;
+
   GskVulkanGlyphCache *glyph_cache;
 
+  GskGradientRampCache gradient_ramps;
+  GskVulkanImage *gradient_ramp_image;
+
 #ifdef G_ENABLE_DEBUG
   ProfileCounters profile_counters;
   ProfileTimers profile_timers;
@@ -112,6 +161,17 @@ gsk_vulkan_renderer_update_images_cb (GdkVulkanContext  *context,
     }
 }
 
+static gpointer
+gsk_vulkan_renderer_warm_pipelines_thread (gpointer data)
+{
+  GskVulkanRender *render = data;
+  GskVulkanRenderer *self = GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render));
+
+  gsk_vulkan_render_warm_pipelines (render, &self->warmup_cancelled);
+
+  return NULL;
+}
+
 static gboolean
 gsk_vulkan_renderer_realize (GskRenderer  *renderer,
                              GdkSurface    *window,
@@ -129,9 +189,22 @@ gsk_vulkan_renderer_realize (GskRenderer  *renderer,
                     self);
   gsk_vulkan_renderer_update_images_cb (self->vulkan, self);
 
-  self->render = gsk_vulkan_render_new (renderer, self->vulkan);
+  self->pipeline_cache = gsk_vulkan_pipeline_cache_new (self->vulkan);
+
+  self->renders[0] = gsk_vulkan_render_new (renderer, self->vulkan);
+  self->n_renders = 1;
+  self->current_render = 0;
+
+  /* Fill the pipeline cache while the application sets up its first
+   * frame, so we don't stall on shader compilation when drawing it.
+   */
+  self->warmup_cancelled = 0;
+  self->warmup_thread = g_thread_new ("gsk-vulkan-pipelines",
+                                      gsk_vulkan_renderer_warm_pipelines_thread,
+                                      self->renders[0]);
 
   self->glyph_cache = gsk_vulkan_glyph_cache_new (renderer, self->vulkan);
+  gsk_gradient_ramp_cache_init (&self->gradient_ramps);
 
   return TRUE;
 }
@@ -141,19 +214,35 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
 {
   GskVulkanRenderer *self = GSK_VULKAN_RENDERER (renderer);
   GSList *l;
+  guint i;
+
+  if (self->warmup_thread)
+    {
+      g_atomic_int_set (&self->warmup_cancelled, 1);
+      g_clear_pointer (&self->warmup_thread, g_thread_join);
+    }
 
   g_clear_object (&self->glyph_cache);
+  g_clear_object (&self->gradient_ramp_image);
+  gsk_gradient_ramp_cache_free (&self->gradient_ramps);
 
   for (l = self->textures; l; l = l->next)
     {
       GskVulkanTextureData *data = l->data;
 
       data->renderer = NULL;
-      gdk_texture_clear_render_data (data->texture);
+      gdk_texture_clear_render_data (data->texture, self);
     }
   g_clear_pointer (&self->textures, g_slist_free);
 
-  g_clear_pointer (&self->render, gsk_vulkan_render_free);
+  g_hash_table_remove_all (self->fallbacks);
+
+  for (i = 0; i < self->n_renders; i++)
+    g_clear_pointer (&self->renders[i], gsk_vulkan_render_free);
+  self->n_renders = 0;
+
+  gsk_vulkan_pipeline_cache_free (self->vulkan, self->pipeline_cache);
+  self->pipeline_cache = NULL;
 
   gsk_vulkan_renderer_free_targets (self);
   g_signal_handlers_disconnect_by_func(self->vulkan,
@@ -163,6 +252,22 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
   g_clear_object (&self->vulkan);
 }
 
+static void
+gsk_vulkan_renderer_age_fallbacks (GskVulkanRenderer *self)
+{
+  GHashTableIter iter;
+  GskVulkanFallbackData *data;
+
+  self->frame_count++;
+
+  g_hash_table_iter_init (&iter, self->fallbacks);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &data))
+    {
+      if (self->frame_count - data->last_used > MAX_FALLBACK_AGE)
+        g_hash_table_iter_remove (&iter);
+    }
+}
+
 static GdkTexture *
 gsk_vulkan_renderer_render_texture (GskRenderer           *renderer,
                                     GskRenderNode         *root,
@@ -182,12 +287,18 @@ gsk_vulkan_renderer_render_texture (GskRenderer           *renderer,
   profiler = gsk_renderer_get_profiler (renderer);
   gsk_profiler_counter_set (profiler, self->profile_counters.fallback_pixels, 0);
   gsk_profiler_counter_set (profiler, self->profile_counters.texture_pixels, 0);
+  gsk_profiler_counter_set (profiler, self->profile_counters.offscreens_avoided, 0);
   gsk_profiler_counter_set (profiler, self->profile_counters.render_passes, 0);
+  gsk_profiler_counter_set (profiler, self->profile_counters.pipeline_compile_time, 0);
   gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
 #endif
 
   render = gsk_vulkan_render_new (renderer, self->vulkan);
 
+  gsk_vulkan_glyph_cache_begin_frame (self->glyph_cache);
+  gsk_gradient_ramp_cache_begin_frame (&self->gradient_ramps);
+  gsk_vulkan_renderer_age_fallbacks (self);
+
   image = gsk_vulkan_image_new_for_framebuffer (self->vulkan,
                                                 ceil (viewport->size.width),
                                                 ceil (viewport->size.height));
@@ -213,18 +324,53 @@ gsk_vulkan_renderer_render_texture (GskRenderer           *renderer,
   gsk_profiler_push_samples (profiler);
 
   if (GDK_PROFILER_IS_RUNNING)
-    {
-      gdk_profiler_add_mark (start_time * 1000, cpu_time * 1000, "render", "");
-      gdk_profiler_set_int_counter (texture_pixels_counter,
-                                    gsk_profiler_counter_get (profiler, self->profile_counters.texture_pixels));
-      gdk_profiler_set_int_counter (fallback_pixels_counter,
-                                    gsk_profiler_counter_get (profiler, self->profile_counters.fallback_pixels));
-    }
+    gdk_profiler_add_mark (start_time * 1000, cpu_time * 1000, "render", "");
 #endif
 
   return texture;
 }
 
+/* Finds a render whose previous frame the GPU is done with. If there
+ * is none, start another one, up to MAX_FRAMES_IN_FLIGHT. After that,
+ * we reuse the oldest one, and gsk_vulkan_render_reset() waits for it.
+ */
+static GskVulkanRender *
+gsk_vulkan_renderer_get_render (GskVulkanRenderer *self)
+{
+  guint i;
+
+  for (i = 1; i <= self->n_renders; i++)
+    {
+      guint index = (self->current_render + i) % self->n_renders;
+
+      if (!gsk_vulkan_render_is_busy (self->renders[index]))
+        {
+          self->current_render = index;
+          return self->renders[index];
+        }
+    }
+
+  if (self->n_renders < MAX_FRAMES_IN_FLIGHT)
+    {
+      /* Keep the round-robin order, so the next one is the oldest */
+      self->current_render++;
+      memmove (&self->renders[self->current_render + 1],
+               &self->renders[self->current_render],
+               (self->n_renders - self->current_render) * sizeof (GskVulkanRender *));
+      self->renders[self->current_render] = gsk_vulkan_render_new (GSK_RENDERER (self), self->vulkan);
+      self->n_renders++;
+
+      GSK_RENDERER_NOTE (GSK_RENDERER (self), VULKAN,
+                         g_message ("Using %u frames in flight", self->n_renders));
+
+      return self->renders[self->current_render];
+    }
+
+  self->current_render = (self->current_render + 1) % self->n_renders;
+
+  return self->renders[self->current_render];
+}
+
 static void
 gsk_vulkan_renderer_render (GskRenderer          *renderer,
                             GskRenderNode        *root,
@@ -242,12 +388,18 @@ gsk_vulkan_renderer_render (GskRenderer          *renderer,
   profiler = gsk_renderer_get_profiler (renderer);
   gsk_profiler_counter_set (profiler, self->profile_counters.fallback_pixels, 0);
   gsk_profiler_counter_set (profiler, self->profile_counters.texture_pixels, 0);
+  gsk_profiler_counter_set (profiler, self->profile_counters.offscreens_avoided, 0);
   gsk_profiler_counter_set (profiler, self->profile_counters.render_passes, 0);
+  gsk_profiler_counter_set (profiler, self->profile_counters.pipeline_compile_time, 0);
   gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
 #endif
 
   gdk_draw_context_begin_frame (GDK_DRAW_CONTEXT (self->vulkan), region);
-  render = self->render;
+  render = gsk_vulkan_renderer_get_render (self);
+
+  gsk_vulkan_glyph_cache_begin_frame (self->glyph_cache);
+  gsk_gradient_ramp_cache_begin_frame (&self->gradient_ramps);
+  gsk_vulkan_renderer_age_fallbacks (self);
 
   clip = gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->vulkan));
   gsk_vulkan_render_reset (render, self->targets[gdk_vulkan_context_get_draw_index (self->vulkan)], NULL, clip);
@@ -270,17 +422,41 @@ gsk_vulkan_renderer_render (GskRenderer          *renderer,
   gdk_draw_context_end_frame (GDK_DRAW_CONTEXT (self->vulkan));
 }
 
+static void
+gsk_vulkan_renderer_finalize (GObject *object)
+{
+  GskVulkanRenderer *self = GSK_VULKAN_RENDERER (object);
+
+  g_hash_table_unref (self->fallbacks);
+
+  G_OBJECT_CLASS (gsk_vulkan_renderer_parent_class)->finalize (object);
+}
+
 static void
 gsk_vulkan_renderer_class_init (GskVulkanRendererClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GskRendererClass *renderer_class = GSK_RENDERER_CLASS (klass);
 
+  object_class->finalize = gsk_vulkan_renderer_finalize;
+
   renderer_class->realize = gsk_vulkan_renderer_realize;
   renderer_class->unrealize = gsk_vulkan_renderer_unrealize;
   renderer_class->render = gsk_vulkan_renderer_render;
   renderer_class->render_texture = gsk_vulkan_renderer_render_texture;
 }
 
+static void
+gsk_vulkan_fallback_data_free (gpointer p)
+{
+  GskVulkanFallbackData *data = p;
+
+  gsk_render_node_unref (data->node);
+  g_object_unref (data->image);
+
+  g_slice_free (GskVulkanFallbackData, data);
+}
+
 static void
 gsk_vulkan_renderer_init (GskVulkanRenderer *self)
 {
@@ -290,22 +466,22 @@ gsk_vulkan_renderer_init (GskVulkanRenderer *self)
 
   gsk_ensure_resources ();
 
+  self->fallbacks = g_hash_table_new_full (NULL, NULL, NULL, gsk_vulkan_fallback_data_free);
+
 #ifdef G_ENABLE_DEBUG
   self->profile_counters.frames = gsk_profiler_add_counter (profiler, "frames", "Frames", FALSE);
   self->profile_counters.render_passes = gsk_profiler_add_counter (profiler, "render-passes", "Render passes", FALSE);
+  self->profile_counters.pipeline_compile_time = gsk_profiler_add_counter (profiler, "pipeline-compile-time", "Pipeline compile time (us)", TRUE);
   self->profile_counters.fallback_pixels = gsk_profiler_add_counter (profiler, "fallback-pixels", "Fallback pixels", TRUE);
   self->profile_counters.texture_pixels = gsk_profiler_add_counter (profiler, "texture-pixels", "Texture pixels", TRUE);
+  self->profile_counters.offscreens_avoided = gsk_profiler_add_counter (profiler, "opacity-offscreens-avoided", "Opacity offscreens avoided", TRUE);
+  self->profile_counters.render_data_conflicts = gsk_profiler_add_counter (profiler, "render-data-conflicts", "Textures not cached due to render data conflicts", TRUE);
+  self->profile_counters.downscaled_bytes = gsk_profiler_add_counter (profiler, "downscaled-bytes", "Texture memory saved by uploading textures downscaled", FALSE);
 
   self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
   if (GSK_RENDERER_DEBUG_CHECK (GSK_RENDERER (self), SYNC))
     self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
 
-  if (texture_pixels_counter == 0)
-    {
-      texture_pixels_counter = gdk_profiler_define_int_counter ("texture-pixels", "Texture Pixels");
-      fallback_pixels_counter = gdk_profiler_define_int_counter ("fallback-pixels", "Fallback Pixels");
-    }
-
 #endif
 }
 
@@ -315,50 +491,253 @@ gsk_vulkan_renderer_clear_texture (gpointer p)
   GskVulkanTextureData *data = p;
 
   if (data->renderer != NULL)
-    data->renderer->textures = g_slist_remove (data->renderer->textures, data);
+    {
+      data->renderer->textures = g_slist_remove (data->renderer->textures, data);
+#ifdef G_ENABLE_DEBUG
+      if (data->saved_bytes != 0)
+        gsk_profiler_counter_add (gsk_renderer_get_profiler (GSK_RENDERER (data->renderer)),
+                                  data->renderer->profile_counters.downscaled_bytes,
+                                  - data->saved_bytes);
+#endif
+    }
 
   g_object_unref (data->image);
 
   g_slice_free (GskVulkanTextureData, data);
 }
 
+static gboolean
+texture_is_deep (GdkTexture *texture)
+{
+  return GDK_IS_MEMORY_TEXTURE (texture) &&
+         gdk_memory_format_is_deep (gdk_memory_texture_get_format (GDK_MEMORY_TEXTURE (texture)));
+}
+
+/* Scales @surface down by 2^@downscale with cairo's box filter,
+ * which unlike sampling it minified on the GPU doesn't alias.
+ */
+static cairo_surface_t *
+downscale_surface (cairo_surface_t *surface,
+                   guint            downscale)
+{
+  const int width = cairo_image_surface_get_width (surface);
+  const int height = cairo_image_surface_get_height (surface);
+  cairo_surface_t *scaled;
+  cairo_t *cr;
+
+  scaled = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                       MAX (width >> downscale, 1),
+                                       MAX (height >> downscale, 1));
+
+  cr = cairo_create (scaled);
+  cairo_scale (cr,
+               (double) cairo_image_surface_get_width (scaled) / width,
+               (double) cairo_image_surface_get_height (scaled) / height);
+  cairo_set_source_surface (cr, surface, 0, 0);
+  cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_GOOD);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  return scaled;
+}
+
+static GskVulkanImage *
+upload_texture (GskVulkanUploader *uploader,
+                GdkTexture        *texture,
+                guint              downscale)
+{
+  cairo_surface_t *surface;
+  GskVulkanImage *image;
+
+  image = NULL;
+  if (GDK_IS_MEMORY_TEXTURE (texture) && downscale == 0)
+    {
+      GdkMemoryTexture *memory_texture = GDK_MEMORY_TEXTURE (texture);
+
+      if (gdk_memory_format_is_deep (gdk_memory_texture_get_format (memory_texture)))
+        image = gsk_vulkan_image_new_from_deep_data (uploader,
+                                                     gdk_memory_texture_get_data (memory_texture),
+                                                     gdk_texture_get_width (texture),
+                                                     gdk_texture_get_height (texture),
+                                                     gdk_memory_texture_get_stride (memory_texture),
+                                                     gdk_memory_texture_get_format (memory_texture));
+    }
+
+  if (image == NULL)
+    {
+      surface = gdk_texture_download_surface (texture);
+      if (downscale > 0)
+        {
+          cairo_surface_t *scaled = downscale_surface (surface, downscale);
+          cairo_surface_destroy (surface);
+          surface = scaled;
+        }
+
+      image = gsk_vulkan_image_new_from_data (uploader,
+                                              cairo_image_surface_get_data (surface),
+                                              cairo_image_surface_get_width (surface),
+                                              cairo_image_surface_get_height (surface),
+                                              cairo_image_surface_get_stride (surface));
+      cairo_surface_destroy (surface);
+    }
+
+  return image;
+}
+
+/* Textures drawn at less than half their size for DOWNSCALE_FRAMES
+ * frames in a row get uploaded again, at the smallest power of two
+ * fraction of their size that was still large enough for all those
+ * draws. Drawing them larger brings back the full size image.
+ *
+ * Returns: how often the image for @data should be halved
+ */
+static guint
+get_downscale (GskVulkanRenderer    *self,
+               GskVulkanTextureData *data,
+               int                   draw_width,
+               int                   draw_height)
+{
+  const int width = gdk_texture_get_width (data->texture);
+  const int height = gdk_texture_get_height (data->texture);
+  guint downscale;
+
+  if (data->draw_frame != self->frame_count)
+    {
+      data->draw_frame = self->frame_count;
+      if (data->small_frames < G_MAXUINT)
+        data->small_frames++;
+    }
+
+  if (draw_width * 2 > width || draw_height * 2 > height)
+    {
+      data->small_frames = 0;
+      data->window_width = 0;
+      data->window_height = 0;
+      return 0;
+    }
+
+  data->window_width = MAX (data->window_width, MAX (draw_width, 1));
+  data->window_height = MAX (data->window_height, MAX (draw_height, 1));
+
+  if (draw_width > gsk_vulkan_image_get_width (data->image) ||
+      draw_height > gsk_vulkan_image_get_height (data->image))
+    return 0;
+
+  /* Downscaled images only have 8 bits per channel */
+  if (data->small_frames < DOWNSCALE_FRAMES || texture_is_deep (data->texture))
+    return data->downscale;
+
+  downscale = 0;
+  while (downscale < 16 &&
+         (width >> (downscale + 1)) >= data->window_width &&
+         (height >> (downscale + 1)) >= data->window_height)
+    downscale++;
+
+  return MAX (downscale, data->downscale);
+}
+
+/* @draw_width and @draw_height are the size in pixels the texture
+ * is drawn at. Pass the size of the texture when that is not known.
+ */
 GskVulkanImage *
 gsk_vulkan_renderer_ref_texture_image (GskVulkanRenderer *self,
                                        GdkTexture        *texture,
+                                       int                draw_width,
+                                       int                draw_height,
                                        GskVulkanUploader *uploader)
 {
   GskVulkanTextureData *data;
-  cairo_surface_t *surface;
-  GskVulkanImage *image;
+  guint downscale;
 
   data = gdk_texture_get_render_data (texture, self);
   if (data)
-    return g_object_ref (data->image);
+    {
+      downscale = get_downscale (self, data, draw_width, draw_height);
+      if (downscale != data->downscale)
+        {
+          gint64 saved_bytes;
+
+          g_object_unref (data->image);
+          data->image = upload_texture (uploader, texture, downscale);
+          data->downscale = downscale;
+          data->small_frames = 0;
+          data->window_width = 0;
+          data->window_height = 0;
+
+          saved_bytes = 4 * ((gint64) gdk_texture_get_width (texture) * gdk_texture_get_height (texture) -
+                             (gint64) gsk_vulkan_image_get_width (data->image) * gsk_vulkan_image_get_height (data->image));
+#ifdef G_ENABLE_DEBUG
+          gsk_profiler_counter_add (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                    self->profile_counters.downscaled_bytes,
+                                    saved_bytes - data->saved_bytes);
+#endif
+          data->saved_bytes = saved_bytes;
+        }
 
-  surface = gdk_texture_download_surface (texture);
-  image = gsk_vulkan_image_new_from_data (uploader,
-                                          cairo_image_surface_get_data (surface),
-                                          cairo_image_surface_get_width (surface),
-                                          cairo_image_surface_get_height (surface),
-                                          cairo_image_surface_get_stride (surface));
-  cairo_surface_destroy (surface);
+      return g_object_ref (data->image);
+    }
 
   data = g_slice_new0 (GskVulkanTextureData);
-  data->image = image;
+  data->image = upload_texture (uploader, texture, 0);
   data->texture = texture;
   data->renderer = self;
+  data->draw_frame = self->frame_count;
 
   if (gdk_texture_set_render_data (texture, self, data, gsk_vulkan_renderer_clear_texture))
     {
-      g_object_ref (data->image);
       self->textures = g_slist_prepend (self->textures, data);
+      return g_object_ref (data->image);
     }
   else
     {
+      GskVulkanImage *image = data->image;
+
+#ifdef G_ENABLE_DEBUG
+      gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                self->profile_counters.render_data_conflicts);
+#endif
       g_slice_free (GskVulkanTextureData, data);
+
+      return image;
     }
+}
 
-  return image;
+/* Unclipped fallback nodes only depend on the node and the scale they
+ * were rasterized at, so we can reuse the image as long as the node
+ * stays in the tree.
+ */
+GskVulkanImage *
+gsk_vulkan_renderer_ref_fallback_image (GskVulkanRenderer *self,
+                                        GskRenderNode     *node,
+                                        int                scale_factor)
+{
+  GskVulkanFallbackData *data;
+
+  data = g_hash_table_lookup (self->fallbacks, node);
+  if (data == NULL || data->scale_factor != scale_factor)
+    return NULL;
+
+  data->last_used = self->frame_count;
+
+  return g_object_ref (data->image);
+}
+
+void
+gsk_vulkan_renderer_cache_fallback_image (GskVulkanRenderer *self,
+                                          GskRenderNode     *node,
+                                          int                scale_factor,
+                                          GskVulkanImage    *image)
+{
+  GskVulkanFallbackData *data;
+
+  data = g_slice_new0 (GskVulkanFallbackData);
+  data->node = gsk_render_node_ref (node);
+  data->image = g_object_ref (image);
+  data->scale_factor = scale_factor;
+  data->last_used = self->frame_count;
+
+  g_hash_table_replace (self->fallbacks, node, data);
 }
 
 GskVulkanImage *
@@ -369,6 +748,45 @@ gsk_vulkan_renderer_ref_glyph_image (GskVulkanRenderer  *self,
   return g_object_ref (gsk_vulkan_glyph_cache_get_glyph_image (self->glyph_cache, uploader, index));
 }
 
+int
+gsk_vulkan_renderer_cache_gradient_ramp (GskVulkanRenderer  *self,
+                                         const GskColorStop *stops,
+                                         gsize               n_stops)
+{
+  return gsk_gradient_ramp_cache_lookup (&self->gradient_ramps, stops, n_stops);
+}
+
+GskVulkanImage *
+gsk_vulkan_renderer_ref_gradient_ramp_image (GskVulkanRenderer *self,
+                                             GskVulkanUploader *uploader)
+{
+  const guchar *data;
+  int first_row, n_rows;
+
+  if (self->gradient_ramp_image == NULL)
+    self->gradient_ramp_image = gsk_vulkan_image_new_for_atlas (self->vulkan,
+                                                                GSK_GRADIENT_RAMP_WIDTH,
+                                                                GSK_GRADIENT_RAMP_ROWS);
+
+  data = gsk_gradient_ramp_cache_get_dirty (&self->gradient_ramps, &first_row, &n_rows);
+  if (data != NULL)
+    {
+      GskImageRegion region = {
+        .data = (guchar *) data,
+        .width = GSK_GRADIENT_RAMP_WIDTH,
+        .height = n_rows,
+        .stride = GSK_GRADIENT_RAMP_WIDTH * 4,
+        .x = 0,
+        .y = first_row
+      };
+
+      gsk_vulkan_image_upload_regions (self->gradient_ramp_image, uploader, 1, &region);
+      gsk_gradient_ramp_cache_clear_dirty (&self->gradient_ramps);
+    }
+
+  return g_object_ref (self->gradient_ramp_image);
+}
+
 guint
 gsk_vulkan_renderer_cache_glyph (GskVulkanRenderer *self,
                                  PangoFont         *font,
@@ -8,7 +8,16 @@ G_BEGIN_DECLS
 
 GskVulkanImage *        gsk_vulkan_renderer_ref_texture_image           (GskVulkanRenderer      *self,
                                                                          GdkTexture             *texture,
+                                                                         int                     draw_width,
+                                                                         int                     draw_height,
                                                                          GskVulkanUploader      *uploader);
+GskVulkanImage *        gsk_vulkan_renderer_ref_fallback_image          (GskVulkanRenderer      *self,
+                                                                         GskRenderNode          *node,
+                                                                         int                     scale_factor);
+void                    gsk_vulkan_renderer_cache_fallback_image        (GskVulkanRenderer      *self,
+                                                                         GskRenderNode          *node,
+                                                                         int                     scale_factor,
+                                                                         GskVulkanImage         *image);
 
 typedef struct
 {
@@ -45,6 +54,12 @@ GskVulkanCachedGlyph * gsk_vulkan_renderer_get_cached_glyph (GskVulkanRenderer *
                                                              int                y,
                                                              float              scale);
 
+int                    gsk_vulkan_renderer_cache_gradient_ramp     (GskVulkanRenderer  *self,
+                                                                    const GskColorStop *stops,
+                                                                    gsize               n_stops);
+GskVulkanImage *       gsk_vulkan_renderer_ref_gradient_ramp_image (GskVulkanRenderer  *self,
+                                                                    GskVulkanUploader  *uploader);
+
 
 G_END_DECLS
 
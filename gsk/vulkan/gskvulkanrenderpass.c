@@ -24,8 +24,11 @@
 #include "gskvulkanimageprivate.h"
 #include "gskvulkanpushconstantsprivate.h"
 #include "gskvulkanrendererprivate.h"
+#include "gskgradientrampprivate.h"
 #include "gskprivate.h"
 
+#include "gdk/gdkparallelprivate.h"
+
 #define ORTHO_NEAR_PLANE        -10000
 #define ORTHO_FAR_PLANE          10000
 
@@ -64,6 +67,7 @@ struct _GskVulkanOpRender
   GskVulkanOpType      type;
   GskRenderNode       *node; /* node that's the source of this op */
   GskVulkanPipeline   *pipeline; /* pipeline to use */
+  float                opacity; /* opacity inherited from opacity nodes, must be at the same offset as in GskVulkanOpText */
   GskRoundedRect       clip; /* clip rect (or random memory if not relevant) */
   GskVulkanImage      *source; /* source image to render */
   GskVulkanImage      *source2; /* second source image to render (if relevant) */
@@ -73,6 +77,7 @@ struct _GskVulkanOpRender
   gsize                descriptor_set_index2; /* descriptor index for the second source (if relevant) */
   graphene_rect_t      source_rect; /* area that source maps to */
   graphene_rect_t      source2_rect; /* area that source2 maps to */
+  graphene_size_t      draw_size; /* pixels covered by the node, for texture nodes */
 };
 
 struct _GskVulkanOpText
@@ -80,6 +85,7 @@ struct _GskVulkanOpText
   GskVulkanOpType      type;
   GskRenderNode       *node; /* node that's the source of this op */
   GskVulkanPipeline   *pipeline; /* pipeline to use */
+  float                opacity; /* opacity inherited from opacity nodes */
   GskRoundedRect       clip; /* clip rect (or random memory if not relevant) */
   GskVulkanImage      *source; /* source image to render */
   gsize                vertex_offset; /* offset into vertex buffer */
@@ -119,13 +125,18 @@ struct _GskVulkanRenderPass
   graphene_matrix_t mv;
   graphene_matrix_t p;
 
+  /* Applied to every op, set while adding the children of opacity
+   * nodes that don't need an offscreen.
+   */
+  float opacity;
+
+  /* owned by the GskVulkanRender */
   VkRenderPass render_pass;
-  VkSemaphore signal_semaphore;
-  GArray *wait_semaphores;
   GskVulkanBuffer *vertex_data;
 
   GQuark fallback_pixels;
   GQuark texture_pixels;
+  GQuark offscreens_avoided;
 };
 
 GskVulkanRenderPass *
@@ -135,10 +146,9 @@ gsk_vulkan_render_pass_new (GdkVulkanContext  *context,
                             graphene_matrix_t *mv,
                             graphene_rect_t   *viewport,
                             cairo_region_t    *clip,
-                            VkSemaphore        signal_semaphore)
+                            VkRenderPass       render_pass)
 {
   GskVulkanRenderPass *self;
-  VkImageLayout final_layout;
 
   self = g_slice_new0 (GskVulkanRenderPass);
   self->vulkan = g_object_ref (context);
@@ -156,57 +166,14 @@ gsk_vulkan_render_pass_new (GdkVulkanContext  *context,
                               ORTHO_NEAR_PLANE,
                               ORTHO_FAR_PLANE);
 
-  if (signal_semaphore != VK_NULL_HANDLE) // this is a dependent pass
-    final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  else
-    final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-  GSK_VK_CHECK (vkCreateRenderPass, gdk_vulkan_context_get_device (self->vulkan),
-                                    &(VkRenderPassCreateInfo) {
-                                        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-                                        .attachmentCount = 1,
-                                        .pAttachments = (VkAttachmentDescription[]) {
-                                           {
-                                              .format = gdk_vulkan_context_get_image_format (self->vulkan),
-                                              .samples = VK_SAMPLE_COUNT_1_BIT,
-                                              .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-                                              .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-                                              .initialLayout = VK_IMAGE_LAYOUT_GENERAL,
-                                              .finalLayout = final_layout
-                                           }
-                                        },
-                                        .subpassCount = 1,
-                                        .pSubpasses = (VkSubpassDescription []) {
-                                           {
-                                              .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                              .inputAttachmentCount = 0,
-                                              .colorAttachmentCount = 1,
-                                              .pColorAttachments = (VkAttachmentReference []) {
-                                                 {
-                                                    .attachment = 0,
-                                                     .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-                                                  }
-                                               },
-                                               .pResolveAttachments = (VkAttachmentReference []) {
-                                                  {
-                                                     .attachment = VK_ATTACHMENT_UNUSED,
-                                                     .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-                                                  }
-                                               },
-                                               .pDepthStencilAttachment = NULL,
-                                            }
-                                         },
-                                         .dependencyCount = 0
-                                      },
-                                      NULL,
-                                      &self->render_pass);
-
-  self->signal_semaphore = signal_semaphore;
-  self->wait_semaphores = g_array_new (FALSE, FALSE, sizeof (VkSemaphore));
+  self->render_pass = render_pass;
   self->vertex_data = NULL;
+  self->opacity = 1.0;
 
 #ifdef G_ENABLE_DEBUG
   self->fallback_pixels = g_quark_from_static_string ("fallback-pixels");
   self->texture_pixels = g_quark_from_static_string ("texture-pixels");
+  self->offscreens_avoided = g_quark_from_static_string ("opacity-offscreens-avoided");
 #endif
 
   return self;
@@ -219,21 +186,75 @@ gsk_vulkan_render_pass_free (GskVulkanRenderPass *self)
   g_object_unref (self->vulkan);
   g_object_unref (self->target);
   cairo_region_destroy (self->clip);
-  vkDestroyRenderPass (gdk_vulkan_context_get_device (self->vulkan),
-                       self->render_pass,
-                       NULL);
   if (self->vertex_data)
     gsk_vulkan_buffer_free (self->vertex_data);
-  if (self->signal_semaphore != VK_NULL_HANDLE)
-    vkDestroySemaphore (gdk_vulkan_context_get_device (self->vulkan),
-                        self->signal_semaphore,
-                        NULL);
-  g_array_unref (self->wait_semaphores);
-
 
   g_slice_free (GskVulkanRenderPass, self);
 }
 
+GskVulkanImage *
+gsk_vulkan_render_pass_get_target (GskVulkanRenderPass *self)
+{
+  return self->target;
+}
+
+/* Horizontal linear gradients that span their bounds map to a stretch
+ * of a gradient ramp, so the texture pipeline can draw them when they
+ * have more stops than the gradient pipeline takes.
+ */
+static gboolean
+gsk_vulkan_render_pass_get_gradient_ramp_rect (GskVulkanRender *render,
+                                               GskRenderNode   *node,
+                                               graphene_rect_t *tex_rect)
+{
+  const graphene_point_t *start = gsk_linear_gradient_node_peek_start (node);
+  const graphene_point_t *end = gsk_linear_gradient_node_peek_end (node);
+  float t1, t2;
+  int row;
+
+  if (gsk_render_node_get_node_type (node) != GSK_LINEAR_GRADIENT_NODE ||
+      start->y != end->y || start->x == end->x)
+    return FALSE;
+
+  t1 = (node->bounds.origin.x - start->x) / (end->x - start->x);
+  t2 = (node->bounds.origin.x + node->bounds.size.width - start->x) / (end->x - start->x);
+
+  /* The atlas sampler clamps to transparent, not to the edge */
+  if (t1 < 0 || t1 > 1 || t2 < 0 || t2 > 1)
+    return FALSE;
+
+  row = gsk_vulkan_renderer_cache_gradient_ramp (GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
+                                                 gsk_linear_gradient_node_peek_color_stops (node, NULL),
+                                                 gsk_linear_gradient_node_get_n_color_stops (node));
+  if (row < 0)
+    return FALSE;
+
+  *tex_rect = GRAPHENE_RECT_INIT (gsk_gradient_ramp_get_u (t1),
+                                  gsk_gradient_ramp_get_v (row),
+                                  gsk_gradient_ramp_get_u (t2) - gsk_gradient_ramp_get_u (t1),
+                                  0);
+
+  return TRUE;
+}
+
+/* The size in pixels of the target that @bounds end up covering.
+ * The mvp maps the viewport to [-1, 1] and the viewport is in
+ * pixels of the target.
+ */
+static void
+gsk_vulkan_render_pass_get_draw_size (GskVulkanRenderPass          *self,
+                                      const GskVulkanPushConstants *constants,
+                                      const graphene_rect_t        *bounds,
+                                      graphene_size_t              *size)
+{
+  graphene_rect_t device;
+
+  graphene_matrix_transform_bounds (&constants->mvp, bounds, &device);
+
+  size->width = device.size.width * self->viewport.size.width / 2;
+  size->height = device.size.height * self->viewport.size.height / 2;
+}
+
 #define FALLBACK(...) G_STMT_START { \
   GSK_RENDERER_NOTE (gsk_vulkan_render_get_renderer (render), FALLBACK, g_message (__VA_ARGS__)); \
   goto fallback; \
@@ -246,7 +267,8 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
                                  GskRenderNode                 *node)
 {
   GskVulkanOp op = {
-    .render.node = node
+    .render.node = node,
+    .render.opacity = self->opacity
   };
   GskVulkanPipelineType pipeline_type;
 
@@ -359,7 +381,9 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
 
         if (has_color_glyphs)
           {
-            if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
+            if (self->opacity < 1.0)
+              FALLBACK ("Color glyphs can't inherit opacity");
+            else if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
               pipeline_type = GSK_VULKAN_PIPELINE_COLOR_TEXT;
             else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
               pipeline_type = GSK_VULKAN_PIPELINE_COLOR_TEXT_CLIP;
@@ -426,16 +450,18 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
       }
 
     case GSK_TEXTURE_NODE:
+      /* The effect pipeline can apply the opacity */
       if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
-        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE;
+        pipeline_type = self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX : GSK_VULKAN_PIPELINE_TEXTURE;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
-        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP;
+        pipeline_type = self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP : GSK_VULKAN_PIPELINE_TEXTURE_CLIP;
       else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
-        pipeline_type = GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
+        pipeline_type = self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP_ROUNDED : GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
       else
         FALLBACK ("Texture nodes can't deal with clip type %u", constants->clip.type);
       op.type = GSK_VULKAN_OP_TEXTURE;
       op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
+      gsk_vulkan_render_pass_get_draw_size (self, constants, &node->bounds, &op.render.draw_size);
       g_array_append_val (self->render_ops, op);
       return;
 
@@ -456,9 +482,25 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
     case GSK_LINEAR_GRADIENT_NODE:
     case GSK_REPEATING_LINEAR_GRADIENT_NODE:
       if (gsk_linear_gradient_node_get_n_color_stops (node) > GSK_VULKAN_LINEAR_GRADIENT_PIPELINE_MAX_COLOR_STOPS)
-        FALLBACK ("Linear gradient with %zu color stops, hardcoded limit is %u",
-                  gsk_linear_gradient_node_get_n_color_stops (node),
-                  GSK_VULKAN_LINEAR_GRADIENT_PIPELINE_MAX_COLOR_STOPS);
+        {
+          if (!gsk_vulkan_render_pass_get_gradient_ramp_rect (render, node, &op.render.source_rect))
+            FALLBACK ("Linear gradient with %zu color stops, hardcoded limit is %u",
+                      gsk_linear_gradient_node_get_n_color_stops (node),
+                      GSK_VULKAN_LINEAR_GRADIENT_PIPELINE_MAX_COLOR_STOPS);
+
+          if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
+            pipeline_type = self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX : GSK_VULKAN_PIPELINE_TEXTURE;
+          else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
+            pipeline_type = self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP : GSK_VULKAN_PIPELINE_TEXTURE_CLIP;
+          else if (constants->clip.type == GSK_VULKAN_CLIP_ROUNDED_CIRCULAR)
+            pipeline_type = self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX_CLIP_ROUNDED : GSK_VULKAN_PIPELINE_TEXTURE_CLIP_ROUNDED;
+          else
+            FALLBACK ("Linear gradient nodes can't deal with clip type %u", constants->clip.type);
+          op.type = GSK_VULKAN_OP_TEXTURE;
+          op.render.pipeline = gsk_vulkan_render_get_pipeline (render, pipeline_type);
+          g_array_append_val (self->render_ops, op);
+          return;
+        }
       if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
         pipeline_type = GSK_VULKAN_PIPELINE_LINEAR_GRADIENT;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
@@ -473,6 +515,25 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
       return;
 
     case GSK_OPACITY_NODE:
+      {
+        GskRenderNode *child = gsk_opacity_node_get_child (node);
+
+        /* Texture children don't need an offscreen anyway */
+        if (gsk_render_node_get_node_type (child) != GSK_TEXTURE_NODE &&
+            gsk_render_node_can_inherit_opacity (child))
+          {
+            float prev_opacity = self->opacity;
+
+#ifdef G_ENABLE_DEBUG
+            gsk_profiler_counter_inc (gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render)),
+                                      self->offscreens_avoided);
+#endif
+            self->opacity *= gsk_opacity_node_get_opacity (node);
+            gsk_vulkan_render_pass_add_node (self, render, constants, child);
+            self->opacity = prev_opacity;
+            return;
+          }
+      }
       if (gsk_vulkan_clip_contains_rect (&constants->clip, &node->bounds))
         pipeline_type = GSK_VULKAN_PIPELINE_COLOR_MATRIX;
       else if (constants->clip.type == GSK_VULKAN_CLIP_RECT)
@@ -530,7 +591,21 @@ gsk_vulkan_render_pass_add_node (GskVulkanRenderPass           *self,
 
     case GSK_CONTAINER_NODE:
       {
-        guint i;
+        guint *indices = NULL;
+        guint i, n;
+
+        /* Without a clip, its rect is not in node coordinates */
+        if (constants->clip.type != GSK_VULKAN_CLIP_NONE)
+          indices = gsk_container_node_get_children_in_rect (node, &constants->clip.rect.bounds, &n);
+
+        if (indices)
+          {
+            for (i = 0; i < n; i++)
+              gsk_vulkan_render_pass_add_node (self, render, constants, gsk_container_node_get_child (node, indices[i]));
+
+            g_free (indices);
+            return;
+          }
 
         for (i = 0; i < gsk_container_node_get_n_children (node); i++)
           {
@@ -629,15 +704,64 @@ fallback:
         g_assert_not_reached ();
         return;
     }
-  op.render.pipeline = gsk_vulkan_render_get_pipeline (render, GSK_VULKAN_PIPELINE_TEXTURE);
+  op.render.pipeline = gsk_vulkan_render_get_pipeline (render,
+                                                       self->opacity < 1.0 ? GSK_VULKAN_PIPELINE_COLOR_MATRIX
+                                                                           : GSK_VULKAN_PIPELINE_TEXTURE);
   g_array_append_val (self->render_ops, op);
 }
 #undef FALLBACK
 
-void
-gsk_vulkan_render_pass_add (GskVulkanRenderPass     *self,
-                            GskVulkanRender         *render,
-                            GskRenderNode           *node)
+static void
+gsk_vulkan_render_pass_add_culled_node (GskVulkanRenderPass          *self,
+                                        GskVulkanRender              *render,
+                                        const GskVulkanPushConstants *constants,
+                                        const graphene_rect_t        *cull,
+                                        GskRenderNode                *node)
+{
+  guint i;
+
+  if (!graphene_rect_intersection (&node->bounds, cull, NULL))
+    return;
+
+  /* Only look through nodes that don't change the coordinate system */
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        guint *indices, n;
+
+        indices = gsk_container_node_get_children_in_rect (node, cull, &n);
+        if (indices)
+          {
+            for (i = 0; i < n; i++)
+              gsk_vulkan_render_pass_add_culled_node (self, render, constants, cull,
+                                                      gsk_container_node_get_child (node, indices[i]));
+            g_free (indices);
+            break;
+          }
+
+        for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+          gsk_vulkan_render_pass_add_culled_node (self, render, constants, cull,
+                                                  gsk_container_node_get_child (node, i));
+      }
+      break;
+
+    case GSK_DEBUG_NODE:
+      gsk_vulkan_render_pass_add_culled_node (self, render, constants, cull,
+                                              gsk_debug_node_get_child (node));
+      break;
+
+    default:
+      gsk_vulkan_render_pass_add_node (self, render, constants, node);
+      break;
+    }
+}
+
+static void
+gsk_vulkan_render_pass_add_with_cull (GskVulkanRenderPass   *self,
+                                      GskVulkanRender       *render,
+                                      const graphene_rect_t *cull,
+                                      GskRenderNode         *node)
 {
   GskVulkanOp op = { 0, };
   graphene_matrix_t mvp;
@@ -647,17 +771,51 @@ gsk_vulkan_render_pass_add (GskVulkanRenderPass     *self,
   gsk_vulkan_push_constants_init (&op.constants.constants, &mvp, &self->viewport);
   g_array_append_val (self->render_ops, op);
 
-  gsk_vulkan_render_pass_add_node (self, render, &op.constants.constants, node);
+  if (cull)
+    gsk_vulkan_render_pass_add_culled_node (self, render, &op.constants.constants, cull, node);
+  else
+    gsk_vulkan_render_pass_add_node (self, render, &op.constants.constants, node);
+}
+
+void
+gsk_vulkan_render_pass_add (GskVulkanRenderPass     *self,
+                            GskVulkanRender         *render,
+                            GskRenderNode           *node)
+{
+  gsk_vulkan_render_pass_add_with_cull (self, render, NULL, node);
+}
+
+/* Like gsk_vulkan_render_pass_add(), but skips nodes outside of the
+ * pass' clip region, which is expected to be in node coordinates.
+ * The scissor would throw away their pixels anyway.
+ */
+void
+gsk_vulkan_render_pass_add_culled (GskVulkanRenderPass     *self,
+                                   GskVulkanRender         *render,
+                                   GskRenderNode           *node)
+{
+  cairo_rectangle_int_t extents;
+  graphene_rect_t cull;
+
+  cairo_region_get_extents (self->clip, &extents);
+  cull = GRAPHENE_RECT_INIT (extents.x, extents.y, extents.width, extents.height);
+
+  gsk_vulkan_render_pass_add_with_cull (self, render, &cull, node);
 }
 
+/* @scale is applied on top of the pass' transform when rendering
+ * @node to an offscreen, so effects that can't show detail, like large
+ * blurs, can render their child at lower resolution.
+ */
 static GskVulkanImage *
-gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
-                                            GskVulkanRender       *render,
-                                            GskVulkanUploader     *uploader,
-                                            GskRenderNode         *node,
-                                            const graphene_rect_t *bounds,
-                                            GskVulkanClip         *current_clip,
-                                            graphene_rect_t       *tex_rect)
+gsk_vulkan_render_pass_get_node_as_scaled_texture (GskVulkanRenderPass   *self,
+                                                   GskVulkanRender       *render,
+                                                   GskVulkanUploader     *uploader,
+                                                   GskRenderNode         *node,
+                                                   const graphene_rect_t *bounds,
+                                                   GskVulkanClip         *current_clip,
+                                                   float                  scale,
+                                                   graphene_rect_t       *tex_rect)
 {
   GskVulkanImage *result;
   cairo_surface_t *surface;
@@ -668,8 +826,13 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
     case GSK_TEXTURE_NODE:
       if (graphene_rect_equal (bounds, &node->bounds))
         {
+          GdkTexture *texture = gsk_texture_node_get_texture (node);
+
+          /* Effects may sample anywhere, so ask for all the detail */
           result = gsk_vulkan_renderer_ref_texture_image (GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
-                                                          gsk_texture_node_get_texture (node),
+                                                          texture,
+                                                          gdk_texture_get_width (texture),
+                                                          gdk_texture_get_height (texture),
                                                           uploader);
           gsk_vulkan_render_add_cleanup_image (render, result);
           *tex_rect = GRAPHENE_RECT_INIT(0, 0, 1, 1);
@@ -686,11 +849,11 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
 
     default:
       {
-        VkSemaphore semaphore;
         graphene_rect_t view;
         cairo_region_t *clip;
         GskVulkanRenderPass *pass;
         graphene_rect_t clipped;
+        graphene_matrix_t mv;
 
         if (current_clip)
           graphene_rect_intersection (&current_clip->rect.bounds, bounds, &clipped);
@@ -700,15 +863,18 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
         if (clipped.size.width == 0 || clipped.size.height == 0)
           return NULL;
 
-        graphene_matrix_transform_bounds (&self->mv, &clipped, &view);
+        graphene_matrix_init_scale (&mv, scale, scale, 1.0);
+        graphene_matrix_multiply (&self->mv, &mv, &mv);
+
+        graphene_matrix_transform_bounds (&mv, &clipped, &view);
         view.origin.x = floor (view.origin.x);
         view.origin.y = floor (view.origin.y);
         view.size.width = ceil (view.size.width);
         view.size.height = ceil (view.size.height);
 
-        result = gsk_vulkan_image_new_for_texture (self->vulkan,
-                                                   view.size.width,
-                                                   view.size.height);
+        result = gsk_vulkan_render_get_offscreen (render,
+                                                  view.size.width,
+                                                  view.size.height);
 
 #ifdef G_ENABLE_DEBUG
         {
@@ -719,17 +885,6 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
         }
 #endif
 
-        vkCreateSemaphore (gdk_vulkan_context_get_device (self->vulkan),
-                           &(VkSemaphoreCreateInfo) {
-                             VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-                             NULL,
-                             0
-                           },
-                           NULL,
-                           &semaphore);
-
-        g_array_append_val (self->wait_semaphores, semaphore);
-
         clip = cairo_region_create_rectangle (&(cairo_rectangle_int_t) {
                                                 0, 0,
                                                 gsk_vulkan_image_get_width (result),
@@ -739,16 +894,15 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
         pass = gsk_vulkan_render_pass_new (self->vulkan,
                                            result,
                                            self->scale_factor,
-                                           &self->mv,
+                                           &mv,
                                            &view,
                                            clip,
-                                           semaphore);
+                                           gsk_vulkan_render_get_offscreen_render_pass (render));
 
         cairo_region_destroy (clip);
 
         gsk_vulkan_render_add_render_pass (render, pass);
         gsk_vulkan_render_pass_add (pass, render, node);
-        gsk_vulkan_render_add_cleanup_image (render, result);
 
         /* assuming the unclipped bounds should go to texture coordinates 0..1,
          * calculate the coordinates for the clipped texture size
@@ -803,11 +957,57 @@ gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
   return result;
 }
 
-static void
-gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
-                                        GskVulkanOpRender    *op,
-                                        GskVulkanRender      *render,
-                                        GskVulkanUploader    *uploader)
+static GskVulkanImage *
+gsk_vulkan_render_pass_get_node_as_texture (GskVulkanRenderPass   *self,
+                                            GskVulkanRender       *render,
+                                            GskVulkanUploader     *uploader,
+                                            GskRenderNode         *node,
+                                            const graphene_rect_t *bounds,
+                                            GskVulkanClip         *current_clip,
+                                            graphene_rect_t       *tex_rect)
+{
+  return gsk_vulkan_render_pass_get_node_as_scaled_texture (self, render, uploader,
+                                                            node, bounds, current_clip,
+                                                            1.0, tex_rect);
+}
+
+/* The blur shader samples a fixed kernel with offsets in node
+ * coordinates, independent of the texture size. Once the radius
+ * covers a couple of device pixels, the blurred child has no detail
+ * left at full resolution, so we render it smaller and let the
+ * sampler's linear filtering scale it back up.
+ */
+#define BLUR_DOWNSCALE_MIN_RADIUS 4.0
+#define BLUR_MAX_DOWNSCALE 4
+
+static float
+get_blur_texture_scale (GskVulkanRenderPass *self,
+                        double               radius)
+{
+  double device_radius = radius * self->scale_factor;
+  int downscale = 1;
+
+  while (downscale < BLUR_MAX_DOWNSCALE &&
+         device_radius >= BLUR_DOWNSCALE_MIN_RADIUS * downscale * 2)
+    downscale *= 2;
+
+  return 1.0 / downscale;
+}
+
+/* Fallback nodes are rasterized by a thread pool while we upload the
+ * rest of the pass. Only the upload of the result has to happen on the
+ * calling thread.
+ */
+typedef struct {
+  GskVulkanRenderPass *self;
+  GskVulkanOpRender *op;
+  cairo_surface_t *surface;
+  GdkParallelTask *task; /* NULL if drawn on the calling thread */
+} FallbackJob;
+
+static cairo_surface_t *
+gsk_vulkan_render_pass_draw_fallback (GskVulkanRenderPass *self,
+                                      GskVulkanOpRender   *op)
 {
   GskRenderNode *node;
   cairo_surface_t *surface;
@@ -815,22 +1015,6 @@ gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
 
   node = op->node;
 
-  GSK_RENDERER_NOTE (gsk_vulkan_render_get_renderer (render), FALLBACK,
-            g_message ("Upload op=%s, node %s[%p], bounds %gx%g",
-                     op->type == GSK_VULKAN_OP_FALLBACK_CLIP ? "fallback-clip" :
-                     (op->type == GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP ? "fallback-rounded-clip" : "fallback"),
-                     g_type_name_from_instance ((GTypeInstance *) node), node,
-                     ceil (node->bounds.size.width),
-                     ceil (node->bounds.size.height)));
-#ifdef G_ENABLE_DEBUG
-  {
-    GskProfiler *profiler = gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render));
-    gsk_profiler_counter_add (profiler,
-                              self->fallback_pixels,
-                              ceil (node->bounds.size.width) * ceil (node->bounds.size.height));
-  }
-#endif
-
   /* XXX: We could intersect bounds with clip bounds here */
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
                                         ceil (node->bounds.size.width * self->scale_factor),
@@ -860,6 +1044,114 @@ gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
 
   cairo_destroy (cr);
 
+  return surface;
+}
+
+static void
+draw_fallback_func (gpointer data,
+                    gpointer user_data)
+{
+  FallbackJob *job = data;
+
+  job->surface = gsk_vulkan_render_pass_draw_fallback (job->self, job->op);
+}
+
+/* Looks up the fallbacks of this pass in the renderer's cache, and
+ * queues the ones that need to be rasterized. Returns the queued jobs,
+ * in the order of their ops.
+ */
+static GArray *
+gsk_vulkan_render_pass_queue_fallbacks (GskVulkanRenderPass *self,
+                                        GskVulkanRender     *render,
+                                        GdkParallelBatch    *batch)
+{
+  GskVulkanRenderer *renderer = GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render));
+  GArray *jobs;
+  guint i;
+
+  jobs = g_array_new (FALSE, FALSE, sizeof (FallbackJob));
+
+  for (i = 0; i < self->render_ops->len; i++)
+    {
+      GskVulkanOpRender *op = &g_array_index (self->render_ops, GskVulkanOp, i).render;
+      FallbackJob job;
+
+      if (op->type != GSK_VULKAN_OP_FALLBACK &&
+          op->type != GSK_VULKAN_OP_FALLBACK_CLIP &&
+          op->type != GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP)
+        continue;
+
+      if (op->type == GSK_VULKAN_OP_FALLBACK)
+        {
+          op->source = gsk_vulkan_renderer_ref_fallback_image (renderer, op->node, self->scale_factor);
+          if (op->source)
+            {
+              GSK_RENDERER_NOTE (GSK_RENDERER (renderer), FALLBACK,
+                        g_message ("Reusing fallback for node %s[%p]",
+                                   g_type_name_from_instance ((GTypeInstance *) op->node), op->node));
+              op->source_rect = GRAPHENE_RECT_INIT(0, 0, 1, 1);
+              gsk_vulkan_render_add_cleanup_image (render, op->source);
+              continue;
+            }
+        }
+
+      job.self = self;
+      job.op = op;
+      job.surface = NULL;
+      job.task = NULL;
+      g_array_append_val (jobs, job);
+    }
+
+  /* Only push once the array is done growing, the jobs must not move */
+  for (i = 0; i < jobs->len; i++)
+    {
+      FallbackJob *job = &g_array_index (jobs, FallbackJob, i);
+
+      if (gsk_render_node_prepare_threaded_draw (job->op->node))
+        job->task = gdk_parallel_batch_push (batch, job);
+    }
+
+  return jobs;
+}
+
+static void
+gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
+                                        FallbackJob          *job,
+                                        GskVulkanRender      *render,
+                                        GskVulkanUploader    *uploader)
+{
+  GskVulkanOpRender *op = job->op;
+  GskRenderNode *node;
+  cairo_surface_t *surface;
+
+  node = op->node;
+
+  GSK_RENDERER_NOTE (gsk_vulkan_render_get_renderer (render), FALLBACK,
+            g_message ("Upload op=%s, node %s[%p], bounds %gx%g",
+                     op->type == GSK_VULKAN_OP_FALLBACK_CLIP ? "fallback-clip" :
+                     (op->type == GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP ? "fallback-rounded-clip" : "fallback"),
+                     g_type_name_from_instance ((GTypeInstance *) node), node,
+                     ceil (node->bounds.size.width),
+                     ceil (node->bounds.size.height)));
+#ifdef G_ENABLE_DEBUG
+  {
+    GskProfiler *profiler = gsk_renderer_get_profiler (gsk_vulkan_render_get_renderer (render));
+    gsk_profiler_counter_add (profiler,
+                              self->fallback_pixels,
+                              ceil (node->bounds.size.width) * ceil (node->bounds.size.height));
+  }
+#endif
+
+  if (job->task)
+    {
+      gdk_parallel_task_wait (job->task);
+      surface = job->surface;
+    }
+  else
+    {
+      surface = gsk_vulkan_render_pass_draw_fallback (self, op);
+    }
+
   op->source = gsk_vulkan_image_new_from_data (uploader,
                                                cairo_image_surface_get_data (surface),
                                                cairo_image_surface_get_width (surface),
@@ -870,6 +1162,12 @@ gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
 
   cairo_surface_destroy (surface);
 
+  if (op->type == GSK_VULKAN_OP_FALLBACK)
+    gsk_vulkan_renderer_cache_fallback_image (GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
+                                              node,
+                                              self->scale_factor,
+                                              op->source);
+
   gsk_vulkan_render_add_cleanup_image (render, op->source);
 }
 
@@ -881,6 +1179,12 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
   GskVulkanOp *op;
   guint i;
   GskVulkanClip *clip = NULL;
+  GdkParallelBatch *batch;
+  GArray *fallbacks;
+  guint next_fallback = 0;
+
+  batch = gdk_parallel_batch_new (draw_fallback_func, NULL);
+  fallbacks = gsk_vulkan_render_pass_queue_fallbacks (self, render, batch);
 
   for (i = 0; i < self->render_ops->len; i++)
     {
@@ -891,7 +1195,12 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
         case GSK_VULKAN_OP_FALLBACK:
         case GSK_VULKAN_OP_FALLBACK_CLIP:
         case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
-          gsk_vulkan_render_pass_upload_fallback (self, &op->render, render, uploader);
+          /* cache hits already have their image */
+          if (op->render.source == NULL)
+            gsk_vulkan_render_pass_upload_fallback (self,
+                                                    &g_array_index (fallbacks, FallbackJob, next_fallback++),
+                                                    render,
+                                                    uploader);
           break;
 
         case GSK_VULKAN_OP_TEXT:
@@ -906,10 +1215,21 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
 
         case GSK_VULKAN_OP_TEXTURE:
           {
-            op->render.source = gsk_vulkan_renderer_ref_texture_image (GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
-                                                                       gsk_texture_node_get_texture (op->render.node),
-                                                                       uploader);
-            op->render.source_rect = GRAPHENE_RECT_INIT(0, 0, 1, 1);
+            if (gsk_render_node_get_node_type (op->render.node) == GSK_TEXTURE_NODE)
+              {
+                op->render.source = gsk_vulkan_renderer_ref_texture_image (GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
+                                                                           gsk_texture_node_get_texture (op->render.node),
+                                                                           ceilf (op->render.draw_size.width),
+                                                                           ceilf (op->render.draw_size.height),
+                                                                           uploader);
+                op->render.source_rect = GRAPHENE_RECT_INIT(0, 0, 1, 1);
+              }
+            else
+              {
+                /* A linear gradient, source_rect is its stretch of the ramp */
+                op->render.source = gsk_vulkan_renderer_ref_gradient_ramp_image (GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
+                                                                                 uploader);
+              }
             gsk_vulkan_render_add_cleanup_image (render, op->render.source);
           }
           break;
@@ -952,14 +1272,16 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
         case GSK_VULKAN_OP_BLUR:
           {
             GskRenderNode *child = gsk_blur_node_get_child (op->render.node);
-
-            op->render.source = gsk_vulkan_render_pass_get_node_as_texture (self,
-                                                                            render,
-                                                                            uploader,
-                                                                            child,
-                                                                            &child->bounds,
-                                                                            clip,
-                                                                            &op->render.source_rect);
+            float scale = get_blur_texture_scale (self, gsk_blur_node_get_radius (op->render.node));
+
+            op->render.source = gsk_vulkan_render_pass_get_node_as_scaled_texture (self,
+                                                                                   render,
+                                                                                   uploader,
+                                                                                   child,
+                                                                                   &child->bounds,
+                                                                                   clip,
+                                                                                   scale,
+                                                                                   &op->render.source_rect);
           }
           break;
 
@@ -1055,6 +1377,10 @@ gsk_vulkan_render_pass_upload (GskVulkanRenderPass  *self,
           break;
         }
     }
+
+  g_assert (next_fallback == fallbacks->len);
+  gdk_parallel_batch_finish (batch);
+  g_array_unref (fallbacks);
 }
 
 static gsize
@@ -1076,7 +1402,10 @@ gsk_vulkan_render_pass_count_vertex_data (GskVulkanRenderPass *self)
         case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
         case GSK_VULKAN_OP_TEXTURE:
         case GSK_VULKAN_OP_REPEAT:
-          op->render.vertex_count = gsk_vulkan_texture_pipeline_count_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline));
+          if (op->render.opacity < 1.0)
+            op->render.vertex_count = gsk_vulkan_effect_pipeline_count_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline));
+          else
+            op->render.vertex_count = gsk_vulkan_texture_pipeline_count_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline));
           n_bytes += op->render.vertex_count;
           break;
 
@@ -1145,6 +1474,291 @@ gsk_vulkan_render_pass_count_vertex_data (GskVulkanRenderPass *self)
   return n_bytes;
 }
 
+/* Vertex collection only reads the nodes and writes to disjoint ranges
+ * of the vertex buffer, so large passes are split across a thread pool.
+ * Text ops stay on the calling thread, as they look up glyphs in the
+ * glyph cache. */
+#define MIN_OPS_PER_JOB 64
+
+typedef struct {
+  GskVulkanRenderPass *self;
+  GskVulkanRender *render;
+  guchar *data;
+  guint start;
+  guint end;
+} CollectJob;
+
+static inline gboolean
+is_text_op (GskVulkanOp *op)
+{
+  return op->type == GSK_VULKAN_OP_TEXT ||
+         op->type == GSK_VULKAN_OP_COLOR_TEXT;
+}
+
+static void
+init_opacity_color_matrix (graphene_matrix_t *color_matrix,
+                           graphene_vec4_t   *color_offset,
+                           float              opacity)
+{
+  graphene_matrix_init_from_float (color_matrix,
+                                   (float[16]) {
+                                       1.0, 0.0, 0.0, 0.0,
+                                       0.0, 1.0, 0.0, 0.0,
+                                       0.0, 0.0, 1.0, 0.0,
+                                       0.0, 0.0, 0.0, opacity
+                                   });
+  graphene_vec4_init (color_offset, 0.0, 0.0, 0.0, 0.0);
+}
+
+static inline GdkRGBA
+apply_opacity (const GdkRGBA *color,
+               float          opacity)
+{
+  return (GdkRGBA) { color->red, color->green, color->blue, color->alpha * opacity };
+}
+
+static void
+gsk_vulkan_render_pass_collect_op_vertex_data (GskVulkanRenderPass *self,
+                                               GskVulkanRender     *render,
+                                               GskVulkanOp         *op,
+                                               guchar              *data)
+{
+  switch (op->type)
+    {
+    case GSK_VULKAN_OP_FALLBACK:
+    case GSK_VULKAN_OP_FALLBACK_CLIP:
+    case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
+    case GSK_VULKAN_OP_TEXTURE:
+      if (op->render.opacity < 1.0)
+        {
+          graphene_matrix_t color_matrix;
+          graphene_vec4_t color_offset;
+
+          init_opacity_color_matrix (&color_matrix, &color_offset, op->render.opacity);
+          gsk_vulkan_effect_pipeline_collect_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline),
+                                                          data + op->render.vertex_offset,
+                                                          &op->render.node->bounds,
+                                                          &op->render.source_rect,
+                                                          &color_matrix,
+                                                          &color_offset);
+        }
+      else
+        {
+          gsk_vulkan_texture_pipeline_collect_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline),
+                                                           data + op->render.vertex_offset,
+                                                           &op->render.node->bounds,
+                                                           &op->render.source_rect);
+        }
+      break;
+
+    case GSK_VULKAN_OP_REPEAT:
+      {
+        gsk_vulkan_texture_pipeline_collect_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline),
+                                                         data + op->render.vertex_offset,
+                                                         &op->render.node->bounds,
+                                                         &op->render.source_rect);
+      }
+      break;
+
+    case GSK_VULKAN_OP_TEXT:
+      {
+        GdkRGBA color = apply_opacity (gsk_text_node_peek_color (op->text.node), op->text.opacity);
+
+        gsk_vulkan_text_pipeline_collect_vertex_data (GSK_VULKAN_TEXT_PIPELINE (op->text.pipeline),
+                                                      data + op->text.vertex_offset,
+                                                      GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
+                                                      &op->text.node->bounds,
+                                                      (PangoFont *)gsk_text_node_peek_font (op->text.node),
+                                                      gsk_text_node_get_num_glyphs (op->text.node),
+                                                      gsk_text_node_peek_glyphs (op->text.node, NULL),
+                                                      &color,
+                                                      gsk_text_node_get_offset (op->text.node),
+                                                      op->text.start_glyph,
+                                                      op->text.num_glyphs,
+                                                      op->text.scale);
+      }
+      break;
+
+    case GSK_VULKAN_OP_COLOR_TEXT:
+      {
+        gsk_vulkan_color_text_pipeline_collect_vertex_data (GSK_VULKAN_COLOR_TEXT_PIPELINE (op->text.pipeline),
+                                                            data + op->text.vertex_offset,
+                                                            GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
+                                                            &op->text.node->bounds,
+                                                            (PangoFont *)gsk_text_node_peek_font (op->text.node),
+                                                            gsk_text_node_get_num_glyphs (op->text.node),
+                                                            gsk_text_node_peek_glyphs (op->text.node, NULL),
+                                                            gsk_text_node_get_offset (op->text.node),
+                                                            op->text.start_glyph,
+                                                            op->text.num_glyphs,
+                                                            op->text.scale);
+      }
+      break;
+
+    case GSK_VULKAN_OP_COLOR:
+      {
+        GdkRGBA color = apply_opacity (gsk_color_node_peek_color (op->render.node), op->render.opacity);
+
+        gsk_vulkan_color_pipeline_collect_vertex_data (GSK_VULKAN_COLOR_PIPELINE (op->render.pipeline),
+                                                       data + op->render.vertex_offset,
+                                                       &op->render.node->bounds,
+                                                       &color);
+      }
+      break;
+
+    case GSK_VULKAN_OP_LINEAR_GRADIENT:
+      {
+        const GskColorStop *node_stops = gsk_linear_gradient_node_peek_color_stops (op->render.node, NULL);
+        GskColorStop stops[GSK_VULKAN_LINEAR_GRADIENT_PIPELINE_MAX_COLOR_STOPS];
+        gsize i, n_stops;
+
+        n_stops = gsk_linear_gradient_node_get_n_color_stops (op->render.node);
+        for (i = 0; i < n_stops; i++)
+          {
+            stops[i].offset = node_stops[i].offset;
+            stops[i].color = apply_opacity (&node_stops[i].color, op->render.opacity);
+          }
+
+        gsk_vulkan_linear_gradient_pipeline_collect_vertex_data (GSK_VULKAN_LINEAR_GRADIENT_PIPELINE (op->render.pipeline),
+                                                                 data + op->render.vertex_offset,
+                                                                 &op->render.node->bounds,
+                                                                 gsk_linear_gradient_node_peek_start (op->render.node),
+                                                                 gsk_linear_gradient_node_peek_end (op->render.node),
+                                                                 gsk_render_node_get_node_type (op->render.node) == GSK_REPEATING_LINEAR_GRADIENT_NODE,
+                                                                 n_stops,
+                                                                 stops);
+      }
+      break;
+
+    case GSK_VULKAN_OP_OPACITY:
+      {
+        graphene_matrix_t color_matrix;
+        graphene_vec4_t color_offset;
+
+        init_opacity_color_matrix (&color_matrix, &color_offset,
+                                   op->render.opacity * gsk_opacity_node_get_opacity (op->render.node));
+        gsk_vulkan_effect_pipeline_collect_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline),
+                                                        data + op->render.vertex_offset,
+                                                        &op->render.node->bounds,
+                                                        &op->render.source_rect,
+                                                        &color_matrix,
+                                                        &color_offset);
+      }
+      break;
+
+    case GSK_VULKAN_OP_BLUR:
+      {
+        gsk_vulkan_blur_pipeline_collect_vertex_data (GSK_VULKAN_BLUR_PIPELINE (op->render.pipeline),
+                                                      data + op->render.vertex_offset,
+                                                      &op->render.node->bounds,
+                                                      &op->render.source_rect,
+                                                      gsk_blur_node_get_radius (op->render.node));
+      }
+      break;
+
+    case GSK_VULKAN_OP_COLOR_MATRIX:
+      {
+        gsk_vulkan_effect_pipeline_collect_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline),
+                                                        data + op->render.vertex_offset,
+                                                        &op->render.node->bounds,
+                                                        &op->render.source_rect,
+                                                        gsk_color_matrix_node_peek_color_matrix (op->render.node),
+                                                        gsk_color_matrix_node_peek_color_offset (op->render.node));
+      }
+      break;
+
+    case GSK_VULKAN_OP_BORDER:
+      {
+        const GdkRGBA *border_colors = gsk_border_node_peek_colors (op->render.node);
+        GdkRGBA colors[4];
+        guint i;
+
+        for (i = 0; i < 4; i++)
+          colors[i] = apply_opacity (&border_colors[i], op->render.opacity);
+
+        gsk_vulkan_border_pipeline_collect_vertex_data (GSK_VULKAN_BORDER_PIPELINE (op->render.pipeline),
+                                                        data + op->render.vertex_offset,
+                                                        gsk_border_node_peek_outline (op->render.node),
+                                                        gsk_border_node_peek_widths (op->render.node),
+                                                        colors);
+      }
+      break;
+
+    case GSK_VULKAN_OP_INSET_SHADOW:
+      {
+        GdkRGBA color = apply_opacity (gsk_inset_shadow_node_peek_color (op->render.node), op->render.opacity);
+
+        gsk_vulkan_box_shadow_pipeline_collect_vertex_data (GSK_VULKAN_BOX_SHADOW_PIPELINE (op->render.pipeline),
+                                                            data + op->render.vertex_offset,
+                                                            gsk_inset_shadow_node_peek_outline (op->render.node),
+                                                            &color,
+                                                            gsk_inset_shadow_node_get_dx (op->render.node),
+                                                            gsk_inset_shadow_node_get_dy (op->render.node),
+                                                            gsk_inset_shadow_node_get_spread (op->render.node),
+                                                            gsk_inset_shadow_node_get_blur_radius (op->render.node));
+      }
+      break;
+
+    case GSK_VULKAN_OP_OUTSET_SHADOW:
+      {
+        GdkRGBA color = apply_opacity (gsk_outset_shadow_node_peek_color (op->render.node), op->render.opacity);
+
+        gsk_vulkan_box_shadow_pipeline_collect_vertex_data (GSK_VULKAN_BOX_SHADOW_PIPELINE (op->render.pipeline),
+                                                            data + op->render.vertex_offset,
+                                                            gsk_outset_shadow_node_peek_outline (op->render.node),
+                                                            &color,
+                                                            gsk_outset_shadow_node_get_dx (op->render.node),
+                                                            gsk_outset_shadow_node_get_dy (op->render.node),
+                                                            gsk_outset_shadow_node_get_spread (op->render.node),
+                                                            gsk_outset_shadow_node_get_blur_radius (op->render.node));
+      }
+      break;
+
+    case GSK_VULKAN_OP_CROSS_FADE:
+      {
+        gsk_vulkan_cross_fade_pipeline_collect_vertex_data (GSK_VULKAN_CROSS_FADE_PIPELINE (op->render.pipeline),
+                                                            data + op->render.vertex_offset,
+                                                            &op->render.node->bounds,
+                                                            &op->render.source_rect,
+                                                            &op->render.source2_rect,
+                                                            gsk_cross_fade_node_get_progress (op->render.node));
+      }
+      break;
+
+    case GSK_VULKAN_OP_BLEND_MODE:
+      {
+        gsk_vulkan_blend_mode_pipeline_collect_vertex_data (GSK_VULKAN_BLEND_MODE_PIPELINE (op->render.pipeline),
+                                                            data + op->render.vertex_offset,
+                                                            &op->render.node->bounds,
+                                                            &op->render.source_rect,
+                                                            &op->render.source2_rect,
+                                                            gsk_blend_node_get_blend_mode (op->render.node));
+      }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    case GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS:
+      break;
+    }
+}
+
+static void
+collect_vertex_data_func (gpointer data,
+                          gpointer user_data)
+{
+  CollectJob *job = data;
+  guint i;
+
+  for (i = job->start; i < job->end; i++)
+    {
+      GskVulkanOp *op = &g_array_index (job->self->render_ops, GskVulkanOp, i);
+
+      if (!is_text_op (op))
+        gsk_vulkan_render_pass_collect_op_vertex_data (job->self, job->render, op, job->data);
+    }
+}
+
 static gsize
 gsk_vulkan_render_pass_collect_vertex_data (GskVulkanRenderPass *self,
                                             GskVulkanRender     *render,
@@ -1152,232 +1766,82 @@ gsk_vulkan_render_pass_collect_vertex_data (GskVulkanRenderPass *self,
                                             gsize                offset,
                                             gsize                total)
 {
+  GdkParallelBatch *batch;
+  CollectJob *jobs;
   GskVulkanOp *op;
   gsize n_bytes;
+  guint n_ops, n_jobs, per_job;
   guint i;
 
+  /* Assign the offsets up front, so the ops can be filled in any order */
   n_bytes = 0;
-  for (i = 0; i < self->render_ops->len; i++)
+  n_ops = self->render_ops->len;
+  for (i = 0; i < n_ops; i++)
     {
       op = &g_array_index (self->render_ops, GskVulkanOp, i);
 
       switch (op->type)
         {
-        case GSK_VULKAN_OP_FALLBACK:
-        case GSK_VULKAN_OP_FALLBACK_CLIP:
-        case GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP:
-        case GSK_VULKAN_OP_TEXTURE:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_texture_pipeline_collect_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline),
-                                                             data + n_bytes + offset,
-                                                             &op->render.node->bounds,
-                                                             &op->render.source_rect);
-            n_bytes += op->render.vertex_count;
-          }
-          break;
-
-        case GSK_VULKAN_OP_REPEAT:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_texture_pipeline_collect_vertex_data (GSK_VULKAN_TEXTURE_PIPELINE (op->render.pipeline),
-                                                             data + n_bytes + offset,
-                                                             &op->render.node->bounds,
-                                                             &op->render.source_rect);
-            n_bytes += op->render.vertex_count;
-          }
-          break;
-
         case GSK_VULKAN_OP_TEXT:
-          {
-            op->text.vertex_offset = offset + n_bytes;
-            gsk_vulkan_text_pipeline_collect_vertex_data (GSK_VULKAN_TEXT_PIPELINE (op->text.pipeline),
-                                                          data + n_bytes + offset,
-                                                          GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
-                                                          &op->text.node->bounds,
-                                                          (PangoFont *)gsk_text_node_peek_font (op->text.node),
-                                                          gsk_text_node_get_num_glyphs (op->text.node),
-                                                          gsk_text_node_peek_glyphs (op->text.node, NULL),
-                                                          gsk_text_node_peek_color (op->text.node),
-                                                          gsk_text_node_get_offset (op->text.node),
-                                                          op->text.start_glyph,
-                                                          op->text.num_glyphs,
-                                                          op->text.scale);
-            n_bytes += op->text.vertex_count;
-          }
-          break;
-
         case GSK_VULKAN_OP_COLOR_TEXT:
-          {
-            op->text.vertex_offset = offset + n_bytes;
-            gsk_vulkan_color_text_pipeline_collect_vertex_data (GSK_VULKAN_COLOR_TEXT_PIPELINE (op->text.pipeline),
-                                                                data + n_bytes + offset,
-                                                                GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render)),
-                                                                &op->text.node->bounds,
-                                                                (PangoFont *)gsk_text_node_peek_font (op->text.node),
-                                                                gsk_text_node_get_num_glyphs (op->text.node),
-                                                                gsk_text_node_peek_glyphs (op->text.node, NULL),
-                                                                gsk_text_node_get_offset (op->text.node),
-                                                                op->text.start_glyph,
-                                                                op->text.num_glyphs,
-                                                                op->text.scale);
-            n_bytes += op->text.vertex_count;
-          }
-          break;
-
-        case GSK_VULKAN_OP_COLOR:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_color_pipeline_collect_vertex_data (GSK_VULKAN_COLOR_PIPELINE (op->render.pipeline),
-                                                           data + n_bytes + offset,
-                                                           &op->render.node->bounds,
-                                                           gsk_color_node_peek_color (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
+          op->text.vertex_offset = offset + n_bytes;
+          n_bytes += op->text.vertex_count;
           break;
 
-        case GSK_VULKAN_OP_LINEAR_GRADIENT:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_linear_gradient_pipeline_collect_vertex_data (GSK_VULKAN_LINEAR_GRADIENT_PIPELINE (op->render.pipeline),
-                                                                     data + n_bytes + offset,
-                                                                     &op->render.node->bounds,
-                                                                     gsk_linear_gradient_node_peek_start (op->render.node),
-                                                                     gsk_linear_gradient_node_peek_end (op->render.node),
-                                                                     gsk_render_node_get_node_type (op->render.node) == GSK_REPEATING_LINEAR_GRADIENT_NODE,
-                                                                     gsk_linear_gradient_node_get_n_color_stops (op->render.node),
-                                                                     gsk_linear_gradient_node_peek_color_stops (op->render.node, NULL));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+        case GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS:
+          continue;
 
-        case GSK_VULKAN_OP_OPACITY:
-          {
-            graphene_matrix_t color_matrix;
-            graphene_vec4_t color_offset;
-
-            graphene_matrix_init_from_float (&color_matrix,
-                                             (float[16]) {
-                                                 1.0, 0.0, 0.0, 0.0,
-                                                 0.0, 1.0, 0.0, 0.0,
-                                                 0.0, 0.0, 1.0, 0.0,
-                                                 0.0, 0.0, 0.0, gsk_opacity_node_get_opacity (op->render.node)
-                                             });
-            graphene_vec4_init (&color_offset, 0.0, 0.0, 0.0, 0.0);
-            op->render.vertex_offset = offset + n_bytes;
-
-            gsk_vulkan_effect_pipeline_collect_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline),
-                                                            data + n_bytes + offset,
-                                                            &op->render.node->bounds,
-                                                            &op->render.source_rect,
-                                                            &color_matrix,
-                                                            &color_offset);
-            n_bytes += op->render.vertex_count;
-          }
+        default:
+          op->render.vertex_offset = offset + n_bytes;
+          n_bytes += op->render.vertex_count;
           break;
+        }
 
-        case GSK_VULKAN_OP_BLUR:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_blur_pipeline_collect_vertex_data (GSK_VULKAN_BLUR_PIPELINE (op->render.pipeline),
-                                                          data + n_bytes + offset,
-                                                          &op->render.node->bounds,
-                                                          &op->render.source_rect,
-                                                          gsk_blur_node_get_radius (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+      g_assert (n_bytes + offset <= total);
+    }
 
-        case GSK_VULKAN_OP_COLOR_MATRIX:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_effect_pipeline_collect_vertex_data (GSK_VULKAN_EFFECT_PIPELINE (op->render.pipeline),
-                                                            data + n_bytes + offset,
-                                                            &op->render.node->bounds,
-                                                            &op->render.source_rect,
-                                                            gsk_color_matrix_node_peek_color_matrix (op->render.node),
-                                                            gsk_color_matrix_node_peek_color_offset (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+  n_jobs = MIN (gdk_parallel_get_n_threads (), n_ops / MIN_OPS_PER_JOB);
 
-        case GSK_VULKAN_OP_BORDER:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_border_pipeline_collect_vertex_data (GSK_VULKAN_BORDER_PIPELINE (op->render.pipeline),
-                                                            data + n_bytes + offset,
-                                                            gsk_border_node_peek_outline (op->render.node),
-                                                            gsk_border_node_peek_widths (op->render.node),
-                                                            gsk_border_node_peek_colors (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+  if (n_jobs <= 1)
+    {
+      for (i = 0; i < n_ops; i++)
+        {
+          op = &g_array_index (self->render_ops, GskVulkanOp, i);
+          gsk_vulkan_render_pass_collect_op_vertex_data (self, render, op, data);
+        }
 
-        case GSK_VULKAN_OP_INSET_SHADOW:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_box_shadow_pipeline_collect_vertex_data (GSK_VULKAN_BOX_SHADOW_PIPELINE (op->render.pipeline),
-                                                                data + n_bytes + offset,
-                                                                gsk_inset_shadow_node_peek_outline (op->render.node),
-                                                                gsk_inset_shadow_node_peek_color (op->render.node),
-                                                                gsk_inset_shadow_node_get_dx (op->render.node),
-                                                                gsk_inset_shadow_node_get_dy (op->render.node),
-                                                                gsk_inset_shadow_node_get_spread (op->render.node),
-                                                                gsk_inset_shadow_node_get_blur_radius (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+      return n_bytes;
+    }
 
-        case GSK_VULKAN_OP_OUTSET_SHADOW:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_box_shadow_pipeline_collect_vertex_data (GSK_VULKAN_BOX_SHADOW_PIPELINE (op->render.pipeline),
-                                                                data + n_bytes + offset,
-                                                                gsk_outset_shadow_node_peek_outline (op->render.node),
-                                                                gsk_outset_shadow_node_peek_color (op->render.node),
-                                                                gsk_outset_shadow_node_get_dx (op->render.node),
-                                                                gsk_outset_shadow_node_get_dy (op->render.node),
-                                                                gsk_outset_shadow_node_get_spread (op->render.node),
-                                                                gsk_outset_shadow_node_get_blur_radius (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+  per_job = (n_ops + n_jobs - 1) / n_jobs;
+  jobs = g_newa (CollectJob, n_jobs);
 
-        case GSK_VULKAN_OP_CROSS_FADE:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_cross_fade_pipeline_collect_vertex_data (GSK_VULKAN_CROSS_FADE_PIPELINE (op->render.pipeline),
-                                                                data + n_bytes + offset,
-                                                                &op->render.node->bounds,
-                                                                &op->render.source_rect,
-                                                                &op->render.source2_rect,
-                                                                gsk_cross_fade_node_get_progress (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+  batch = gdk_parallel_batch_new (collect_vertex_data_func, NULL);
 
-        case GSK_VULKAN_OP_BLEND_MODE:
-          {
-            op->render.vertex_offset = offset + n_bytes;
-            gsk_vulkan_blend_mode_pipeline_collect_vertex_data (GSK_VULKAN_BLEND_MODE_PIPELINE (op->render.pipeline),
-                                                                data + n_bytes + offset,
-                                                                &op->render.node->bounds,
-                                                                &op->render.source_rect,
-                                                                &op->render.source2_rect,
-                                                                gsk_blend_node_get_blend_mode (op->render.node));
-            n_bytes += op->render.vertex_count;
-          }
-          break;
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].self = self;
+      jobs[i].render = render;
+      jobs[i].data = data;
+      jobs[i].start = MIN (i * per_job, n_ops);
+      jobs[i].end = MIN ((i + 1) * per_job, n_ops);
+
+      if (i > 0)
+        gdk_parallel_batch_push (batch, &jobs[i]);
+    }
 
-        default:
-          g_assert_not_reached ();
-        case GSK_VULKAN_OP_PUSH_VERTEX_CONSTANTS:
-          continue;
-        }
+  for (i = 0; i < n_ops; i++)
+    {
+      op = &g_array_index (self->render_ops, GskVulkanOp, i);
 
-      g_assert (n_bytes + offset <= total);
+      if (is_text_op (op))
+        gsk_vulkan_render_pass_collect_op_vertex_data (self, render, op, data);
     }
 
+  collect_vertex_data_func (&jobs[0], NULL);
+
+  gdk_parallel_batch_finish (batch);
+
   return n_bytes;
 }
 
@@ -1400,22 +1864,6 @@ gsk_vulkan_render_pass_get_vertex_data (GskVulkanRenderPass *self,
   return self->vertex_data;
 }
 
-gsize
-gsk_vulkan_render_pass_get_wait_semaphores (GskVulkanRenderPass  *self,
-                                            VkSemaphore         **semaphores)
-{
-  *semaphores = (VkSemaphore *)self->wait_semaphores->data;
-  return self->wait_semaphores->len;
-}
-
-gsize
-gsk_vulkan_render_pass_get_signal_semaphores (GskVulkanRenderPass  *self,
-                                              VkSemaphore         **semaphores)
-{
-  *semaphores = (VkSemaphore *)&self->signal_semaphore;
-  return self->signal_semaphore != VK_NULL_HANDLE ? 1 : 0;
-}
-
 void
 gsk_vulkan_render_pass_reserve_descriptor_sets (GskVulkanRenderPass *self,
                                                 GskVulkanRender     *render)
@@ -1473,6 +1921,16 @@ gsk_vulkan_render_pass_reserve_descriptor_sets (GskVulkanRenderPass *self,
     }
 }
 
+static inline gboolean
+is_texture_op (GskVulkanOpType type)
+{
+  return type == GSK_VULKAN_OP_FALLBACK ||
+         type == GSK_VULKAN_OP_FALLBACK_CLIP ||
+         type == GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP ||
+         type == GSK_VULKAN_OP_TEXTURE ||
+         type == GSK_VULKAN_OP_REPEAT;
+}
+
 static void
 gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                   GskVulkanRender         *render,
@@ -1481,6 +1939,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                   VkCommandBuffer          command_buffer)
 {
   GskVulkanPipeline *current_pipeline = NULL;
+  gsize current_descriptor_set = G_MAXSIZE;
   gsize current_draw_index = 0;
   GskVulkanOp *op;
   guint i, step;
@@ -1501,7 +1960,12 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
         case GSK_VULKAN_OP_TEXTURE:
         case GSK_VULKAN_OP_REPEAT:
           if (!op->render.source)
-            continue;
+            {
+              /* Its instance is still in the vertex data */
+              if (current_pipeline == op->render.pipeline)
+                current_draw_index++;
+              continue;
+            }
           if (current_pipeline != op->render.pipeline)
             {
               current_pipeline = op->render.pipeline;
@@ -1516,55 +1980,97 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                       },
                                       (VkDeviceSize[1]) { op->render.vertex_offset });
               current_draw_index = 0;
+              current_descriptor_set = G_MAXSIZE;
             }
 
-          vkCmdBindDescriptorSets (command_buffer,
-                                   VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                   gsk_vulkan_pipeline_get_pipeline_layout (current_pipeline),
-                                   0,
-                                   1,
-                                   (VkDescriptorSet[1]) {
-                                       gsk_vulkan_render_get_descriptor_set (render, op->render.descriptor_set_index)
-                                   },
-                                   0,
-                                   NULL);
+          if (current_descriptor_set != op->render.descriptor_set_index)
+            {
+              current_descriptor_set = op->render.descriptor_set_index;
+              vkCmdBindDescriptorSets (command_buffer,
+                                       VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                       gsk_vulkan_pipeline_get_pipeline_layout (current_pipeline),
+                                       0,
+                                       1,
+                                       (VkDescriptorSet[1]) {
+                                           gsk_vulkan_render_get_descriptor_set (render, current_descriptor_set)
+                                       },
+                                       0,
+                                       NULL);
+            }
 
-          current_draw_index += gsk_vulkan_texture_pipeline_draw (GSK_VULKAN_TEXTURE_PIPELINE (current_pipeline),
-                                                                  command_buffer,
-                                                                  current_draw_index, 1);
+          /* Draw all following quads sampling the same image at once,
+           * like a grid of the same icon or the tiles of a fallback.
+           */
+          for (step = 1; step + i < self->render_ops->len; step++)
+            {
+              GskVulkanOp *cmp = &g_array_index (self->render_ops, GskVulkanOp, i + step);
+              if (!is_texture_op (cmp->type) ||
+                  cmp->render.pipeline != current_pipeline ||
+                  cmp->render.source == NULL ||
+                  cmp->render.descriptor_set_index != current_descriptor_set)
+                break;
+            }
+          if (op->render.opacity < 1.0)
+            current_draw_index += gsk_vulkan_effect_pipeline_draw (GSK_VULKAN_EFFECT_PIPELINE (current_pipeline),
+                                                                   command_buffer,
+                                                                   current_draw_index, step);
+          else
+            current_draw_index += gsk_vulkan_texture_pipeline_draw (GSK_VULKAN_TEXTURE_PIPELINE (current_pipeline),
+                                                                    command_buffer,
+                                                                    current_draw_index, step);
           break;
 
         case GSK_VULKAN_OP_TEXT:
-          if (current_pipeline != op->text.pipeline)
-            {
-              current_pipeline = op->text.pipeline;
-              vkCmdBindPipeline (command_buffer,
-                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                 gsk_vulkan_pipeline_get_pipeline (current_pipeline));
-              vkCmdBindVertexBuffers (command_buffer,
-                                      0,
-                                      1,
-                                      (VkBuffer[1]) {
-                                          gsk_vulkan_buffer_get_buffer (vertex_buffer)
-                                      },
-                                      (VkDeviceSize[1]) { op->text.vertex_offset });
-              current_draw_index = 0;
-            }
+          {
+            guint num_glyphs;
 
-          vkCmdBindDescriptorSets (command_buffer,
+            if (current_pipeline != op->text.pipeline)
+              {
+                current_pipeline = op->text.pipeline;
+                vkCmdBindPipeline (command_buffer,
                                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                   gsk_vulkan_pipeline_get_pipeline_layout (current_pipeline),
-                                   0,
-                                   1,
-                                   (VkDescriptorSet[1]) {
-                                       gsk_vulkan_render_get_descriptor_set (render, op->text.descriptor_set_index)
-                                   },
-                                   0,
-                                   NULL);
+                                   gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+                vkCmdBindVertexBuffers (command_buffer,
+                                        0,
+                                        1,
+                                        (VkBuffer[1]) {
+                                            gsk_vulkan_buffer_get_buffer (vertex_buffer)
+                                        },
+                                        (VkDeviceSize[1]) { op->text.vertex_offset });
+                current_draw_index = 0;
+                current_descriptor_set = G_MAXSIZE;
+              }
 
-          current_draw_index += gsk_vulkan_text_pipeline_draw (GSK_VULKAN_TEXT_PIPELINE (current_pipeline),
-                                                               command_buffer,
-                                                               current_draw_index, op->text.num_glyphs);
+            if (current_descriptor_set != op->text.descriptor_set_index)
+              {
+                current_descriptor_set = op->text.descriptor_set_index;
+                vkCmdBindDescriptorSets (command_buffer,
+                                         VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                         gsk_vulkan_pipeline_get_pipeline_layout (current_pipeline),
+                                         0,
+                                         1,
+                                         (VkDescriptorSet[1]) {
+                                             gsk_vulkan_render_get_descriptor_set (render, current_descriptor_set)
+                                         },
+                                         0,
+                                         NULL);
+              }
+
+            /* Consecutive text from the same atlas is one draw */
+            num_glyphs = op->text.num_glyphs;
+            for (step = 1; step + i < self->render_ops->len; step++)
+              {
+                GskVulkanOp *cmp = &g_array_index (self->render_ops, GskVulkanOp, i + step);
+                if (cmp->type != GSK_VULKAN_OP_TEXT ||
+                    cmp->text.pipeline != current_pipeline ||
+                    cmp->text.descriptor_set_index != current_descriptor_set)
+                  break;
+                num_glyphs += cmp->text.num_glyphs;
+              }
+            current_draw_index += gsk_vulkan_text_pipeline_draw (GSK_VULKAN_TEXT_PIPELINE (current_pipeline),
+                                                                 command_buffer,
+                                                                 current_draw_index, num_glyphs);
+          }
           break;
 
         case GSK_VULKAN_OP_COLOR_TEXT:
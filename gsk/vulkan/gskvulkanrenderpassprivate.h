@@ -17,14 +17,20 @@ GskVulkanRenderPass *   gsk_vulkan_render_pass_new                      (GdkVulk
                                                                          graphene_matrix_t      *mv,
                                                                          graphene_rect_t        *viewport,
                                                                          cairo_region_t         *clip,
-                                                                         VkSemaphore             signal_semaphore);
+                                                                         VkRenderPass            render_pass);
 
 void                    gsk_vulkan_render_pass_free                     (GskVulkanRenderPass    *self);
 
+GskVulkanImage *        gsk_vulkan_render_pass_get_target               (GskVulkanRenderPass    *self);
+
 void                    gsk_vulkan_render_pass_add                      (GskVulkanRenderPass    *self,
                                                                          GskVulkanRender        *render,
                                                                          GskRenderNode          *node);
 
+void                    gsk_vulkan_render_pass_add_culled               (GskVulkanRenderPass    *self,
+                                                                         GskVulkanRender        *render,
+                                                                         GskRenderNode          *node);
+
 void                    gsk_vulkan_render_pass_upload                   (GskVulkanRenderPass    *self,
                                                                          GskVulkanRender        *render,
                                                                          GskVulkanUploader      *uploader);
@@ -35,10 +41,6 @@ void                    gsk_vulkan_render_pass_draw                     (GskVulk
                                                                          guint                   layout_count,
                                                                          VkPipelineLayout       *pipeline_layout,
                                                                          VkCommandBuffer         command_buffer);
-gsize                   gsk_vulkan_render_pass_get_wait_semaphores      (GskVulkanRenderPass    *self,
-                                                                         VkSemaphore           **semaphores);
-gsize                   gsk_vulkan_render_pass_get_signal_semaphores    (GskVulkanRenderPass    *self,
-                                                                         VkSemaphore           **semaphores);
 
 G_END_DECLS
 
@@ -70,6 +70,11 @@ void                    gsk_vulkan_render_add_cleanup_image             (GskVulk
 void                    gsk_vulkan_render_add_node                      (GskVulkanRender        *self,
                                                                          GskRenderNode          *node);
 
+GskVulkanImage *        gsk_vulkan_render_get_offscreen                 (GskVulkanRender        *self,
+                                                                         gsize                   width,
+                                                                         gsize                   height);
+VkRenderPass            gsk_vulkan_render_get_offscreen_render_pass     (GskVulkanRender        *self);
+
 void                    gsk_vulkan_render_add_render_pass               (GskVulkanRender        *self,
                                                                          GskVulkanRenderPass    *pass);
 
@@ -77,6 +82,8 @@ void                    gsk_vulkan_render_upload                        (GskVulk
 
 GskVulkanPipeline *     gsk_vulkan_render_get_pipeline                  (GskVulkanRender        *self,
                                                                          GskVulkanPipelineType   pipeline_type);
+void                    gsk_vulkan_render_warm_pipelines                (GskVulkanRender        *self,
+                                                                         volatile int           *cancelled);
 VkDescriptorSet         gsk_vulkan_render_get_descriptor_set            (GskVulkanRender        *self,
                                                                          gsize                   id);
 gsize                   gsk_vulkan_render_reserve_descriptor_set        (GskVulkanRender        *self,
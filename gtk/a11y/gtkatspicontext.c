@@ -81,6 +81,11 @@
  *   hold the TAB_PANEL role and be the target of the CONTROLS
  *   relation with their corresponding tabs (in the stack
  *   switcher or notebook).
+ *
+ * Contexts only export their D-Bus objects once their path is
+ * handed out, i.e. when an AT walks to them from their parent or
+ * receives a reference to them. Until then, no events are emitted
+ * for them, since nothing on the bus knows about them.
  */
 
 struct _GtkAtSpiContext
@@ -112,6 +117,11 @@ struct _GtkAtSpiContext
 
   guint registration_ids[20];
   guint n_registered_objects;
+
+  /* Whether the D-Bus objects have been exported; this happens
+   * the first time the context is handed out to an AT
+   */
+  guint registered : 1;
 };
 
 enum
@@ -327,7 +337,7 @@ collect_relations (GtkAtSpiContext *self,
           target_ctx = gtk_accessible_get_at_context (GTK_ACCESSIBLE (l->data));
           g_variant_builder_add (&b, "(so)",
                                  unique_name,
-                                 GTK_AT_SPI_CONTEXT (target_ctx)->context_path);
+                                 gtk_at_spi_context_get_context_path (GTK_AT_SPI_CONTEXT (target_ctx)));
         }
 
       g_variant_builder_add (builder, "(ua(so))", map[i].s, &b);
@@ -639,7 +649,7 @@ handle_accessible_get_property (GDBusConnection       *connection,
               if (parent_context != NULL)
                 res = g_variant_new ("(so)",
                                      g_dbus_connection_get_unique_name (self->connection),
-                                     GTK_AT_SPI_CONTEXT (parent_context)->context_path);
+                                     gtk_at_spi_context_get_context_path (GTK_AT_SPI_CONTEXT (parent_context)));
             }
           else
             {
@@ -649,7 +659,7 @@ handle_accessible_get_property (GDBusConnection       *connection,
               if (parent_context != NULL)
                 res = g_variant_new ("(so)",
                                      g_dbus_connection_get_unique_name (self->connection),
-                                     GTK_AT_SPI_CONTEXT (parent_context)->context_path);
+                                     gtk_at_spi_context_get_context_path (GTK_AT_SPI_CONTEXT (parent_context)));
             }
         }
       else if (GTK_IS_STACK_PAGE (accessible))
@@ -661,7 +671,7 @@ handle_accessible_get_property (GDBusConnection       *connection,
           if (parent_context != NULL)
             res = g_variant_new ("(so)",
                                  g_dbus_connection_get_unique_name (self->connection),
-                                 GTK_AT_SPI_CONTEXT (parent_context)->context_path);
+                                 gtk_at_spi_context_get_context_path (GTK_AT_SPI_CONTEXT (parent_context)));
         }
 
       if (res == NULL)
@@ -713,6 +723,9 @@ emit_text_changed (GtkAtSpiContext *self,
                    int              end,
                    const char      *text)
 {
+  if (!self->registered)
+    return;
+
   g_dbus_connection_emit_signal (self->connection,
                                  NULL,
                                  self->context_path,
@@ -728,6 +741,9 @@ emit_text_selection_changed (GtkAtSpiContext *self,
                              const char      *kind,
                              int              cursor_position)
 {
+  if (!self->registered)
+    return;
+
   if (strcmp (kind, "text-caret-moved") == 0)
     g_dbus_connection_emit_signal (self->connection,
                                    NULL,
@@ -752,6 +768,9 @@ static void
 emit_selection_changed (GtkAtSpiContext *self,
                         const char      *kind)
 {
+  if (!self->registered)
+    return;
+
   g_dbus_connection_emit_signal (self->connection,
                                  NULL,
                                  self->context_path,
@@ -767,6 +786,9 @@ emit_state_changed (GtkAtSpiContext *self,
                     const char      *name,
                     gboolean         enabled)
 {
+  if (!self->registered)
+    return;
+
   g_dbus_connection_emit_signal (self->connection,
                                  NULL,
                                  self->context_path,
@@ -782,6 +804,9 @@ emit_property_changed (GtkAtSpiContext *self,
                        const char      *name,
                        GVariant        *value)
 {
+  if (!self->registered)
+    return;
+
   g_dbus_connection_emit_signal (self->connection,
                                  NULL,
                                  self->context_path,
@@ -799,6 +824,9 @@ emit_bounds_changed (GtkAtSpiContext *self,
                      int              width,
                      int              height)
 {
+  if (!self->registered)
+    return;
+
   g_dbus_connection_emit_signal (self->connection,
                                  NULL,
                                  self->context_path,
@@ -815,8 +843,14 @@ emit_children_changed (GtkAtSpiContext         *self,
                        int                      idx,
                        GtkAccessibleChildState  state)
 {
-  GVariant *child_ref = gtk_at_spi_context_to_ref (child_context);
-  GVariant *context_ref = gtk_at_spi_context_to_ref (self);
+  GVariant *child_ref;
+  GVariant *context_ref;
+
+  if (!self->registered)
+    return;
+
+  child_ref = gtk_at_spi_context_to_ref (child_context);
+  context_ref = gtk_at_spi_context_to_ref (self);
 
   gtk_at_spi_emit_children_changed (self->connection,
                                     self->context_path,
@@ -842,6 +876,9 @@ gtk_at_spi_context_state_change (GtkATContext                *ctx,
   if (GTK_IS_WIDGET (accessible) && !gtk_widget_get_realized (GTK_WIDGET (accessible)))
     return;
 
+  if (!self->registered)
+    return;
+
   if (changed_states & GTK_ACCESSIBLE_STATE_CHANGE_HIDDEN)
     {
       GtkWidget *parent;
@@ -1312,6 +1349,16 @@ gtk_at_spi_context_register_object (GtkAtSpiContext *self)
     }
 
   self->interfaces = g_variant_ref_sink (g_variant_builder_end (&interfaces));
+  self->registered = TRUE;
+}
+
+static void
+gtk_at_spi_context_ensure_registered (GtkAtSpiContext *self)
+{
+  if (self->registered || self->connection == NULL)
+    return;
+
+  gtk_at_spi_context_register_object (self);
 }
 
 static void
@@ -1464,7 +1511,6 @@ gtk_at_spi_context_constructed (GObject *gobject)
   gtk_atspi_connect_selection_signals (accessible,
                                        (GtkAtspiSelectionCallback *)emit_selection_changed,
                                        self);
-  gtk_at_spi_context_register_object (self);
 
   G_OBJECT_CLASS (gtk_at_spi_context_parent_class)->constructed (gobject);
 }
@@ -1689,6 +1735,8 @@ gtk_at_spi_context_get_context_path (GtkAtSpiContext *self)
 {
   g_return_val_if_fail (GTK_IS_AT_SPI_CONTEXT (self), NULL);
 
+  gtk_at_spi_context_ensure_registered (self);
+
   return self->context_path;
 }
 
@@ -1704,6 +1752,9 @@ GVariant *
 gtk_at_spi_context_to_ref (GtkAtSpiContext *self)
 {
   const char *name = g_dbus_connection_get_unique_name (self->connection);
+
+  gtk_at_spi_context_ensure_registered (self);
+
   return g_variant_new ("(so)", name, self->context_path);
 }
 /* }}} */
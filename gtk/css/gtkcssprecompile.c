@@ -0,0 +1,76 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Build tool that converts the themes we ship as resources to
+ * precompiled token streams, see gtk_css_tokenizer_precompile().
+ *
+ * Usage: gtk-css-precompile INPUT OUTPUT
+ */
+
+#include "config.h"
+
+#include "gtkcsstokenizerprivate.h"
+
+#include <stdlib.h>
+
+int
+main (int argc, char *argv[])
+{
+  GBytes *bytes, *precompiled;
+  GError *error = NULL;
+  char *data;
+  gsize size;
+
+  if (argc != 3)
+    {
+      g_printerr ("Usage: %s INPUT OUTPUT\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  if (!g_file_get_contents (argv[1], &data, &size, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return EXIT_FAILURE;
+    }
+
+  bytes = g_bytes_new_take (data, size);
+  precompiled = gtk_css_tokenizer_precompile (bytes, &error);
+  g_bytes_unref (bytes);
+
+  if (precompiled == NULL)
+    {
+      g_printerr ("%s: %s\n", argv[1], error->message);
+      g_error_free (error);
+      return EXIT_FAILURE;
+    }
+
+  if (!g_file_set_contents (argv[2],
+                            g_bytes_get_data (precompiled, NULL),
+                            g_bytes_get_size (precompiled),
+                            &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      g_bytes_unref (precompiled);
+      return EXIT_FAILURE;
+    }
+
+  g_bytes_unref (precompiled);
+
+  return EXIT_SUCCESS;
+}
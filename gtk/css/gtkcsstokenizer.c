@@ -35,62 +35,23 @@ struct _GtkCssTokenizer
   const char            *end;
 
   GtkCssLocation         position;
+
+  /* Holds the contents of the current token */
+  GString               *buffer;
+
+  /* Only set when replaying a precompiled token stream */
+  const char            *strings;
 };
 
+static gboolean gtk_css_tokenizer_replay_token (GtkCssTokenizer  *tokenizer,
+                                                GtkCssToken      *token);
+
+/* The strings of a token belong to the tokenizer that read it, and
+ * are only valid until the next token is read. Everything that keeps
+ * them around copies them, so reading a token doesn't allocate. */
 void
 gtk_css_token_clear (GtkCssToken *token)
 {
-  switch (token->type)
-    {
-    case GTK_CSS_TOKEN_STRING:
-    case GTK_CSS_TOKEN_IDENT:
-    case GTK_CSS_TOKEN_FUNCTION:
-    case GTK_CSS_TOKEN_AT_KEYWORD:
-    case GTK_CSS_TOKEN_HASH_UNRESTRICTED:
-    case GTK_CSS_TOKEN_HASH_ID:
-    case GTK_CSS_TOKEN_URL:
-      g_free (token->string.string);
-      break;
-
-    case GTK_CSS_TOKEN_SIGNED_INTEGER_DIMENSION:
-    case GTK_CSS_TOKEN_SIGNLESS_INTEGER_DIMENSION:
-    case GTK_CSS_TOKEN_DIMENSION:
-      g_free (token->dimension.dimension);
-      break;
-
-    default:
-      g_assert_not_reached ();
-    case GTK_CSS_TOKEN_EOF:
-    case GTK_CSS_TOKEN_WHITESPACE:
-    case GTK_CSS_TOKEN_OPEN_PARENS:
-    case GTK_CSS_TOKEN_CLOSE_PARENS:
-    case GTK_CSS_TOKEN_OPEN_SQUARE:
-    case GTK_CSS_TOKEN_CLOSE_SQUARE:
-    case GTK_CSS_TOKEN_OPEN_CURLY:
-    case GTK_CSS_TOKEN_CLOSE_CURLY:
-    case GTK_CSS_TOKEN_COMMA:
-    case GTK_CSS_TOKEN_COLON:
-    case GTK_CSS_TOKEN_SEMICOLON:
-    case GTK_CSS_TOKEN_CDC:
-    case GTK_CSS_TOKEN_CDO:
-    case GTK_CSS_TOKEN_DELIM:
-    case GTK_CSS_TOKEN_SIGNED_INTEGER:
-    case GTK_CSS_TOKEN_SIGNLESS_INTEGER:
-    case GTK_CSS_TOKEN_SIGNED_NUMBER:
-    case GTK_CSS_TOKEN_SIGNLESS_NUMBER:
-    case GTK_CSS_TOKEN_PERCENTAGE:
-    case GTK_CSS_TOKEN_INCLUDE_MATCH:
-    case GTK_CSS_TOKEN_DASH_MATCH:
-    case GTK_CSS_TOKEN_PREFIX_MATCH:
-    case GTK_CSS_TOKEN_SUFFIX_MATCH:
-    case GTK_CSS_TOKEN_SUBSTRING_MATCH:
-    case GTK_CSS_TOKEN_COLUMN:
-    case GTK_CSS_TOKEN_BAD_STRING:
-    case GTK_CSS_TOKEN_BAD_URL:
-    case GTK_CSS_TOKEN_COMMENT:
-      break;
-    }
-
   token->type = GTK_CSS_TOKEN_EOF;
 }
 
@@ -526,6 +487,334 @@ gtk_css_token_init (GtkCssToken     *token,
   va_end (args);
 }
 
+/* Precompiled token streams
+ *
+ * Themes that are part of the build are tokenized ahead of time, and
+ * the tokens are stored in a compact binary format that the tokenizer
+ * replays instead of reading the text again. The format starts with
+ * the magic "GCS\0" and the length of a string table, followed by the
+ * table and one record per token: its type, its contents and the
+ * location at its end, so that sections and errors still point into
+ * the original file.
+ *
+ * All integers are stored in the variable length format used for
+ * precompiled GtkBuilder files, numbers as little endian doubles.
+ */
+
+static void
+marshal_uint32 (GString *str,
+                guint32  v)
+{
+  if (v < 128)
+    {
+      g_string_append_c (str, (guchar)v);
+    }
+  else if (v < (1<<14))
+    {
+      g_string_append_c (str, (guchar)(v >> 8) | 0x80);
+      g_string_append_c (str, (guchar)(v & 0xff));
+    }
+  else if (v < (1<<21))
+    {
+      g_string_append_c (str, (guchar)(v >> 16) | 0xc0);
+      g_string_append_c (str, (guchar)((v >> 8) & 0xff));
+      g_string_append_c (str, (guchar)(v & 0xff));
+    }
+  else if (v < (1<<28))
+    {
+      g_string_append_c (str, (guchar)(v >> 24) | 0xe0);
+      g_string_append_c (str, (guchar)((v >> 16) & 0xff));
+      g_string_append_c (str, (guchar)((v >> 8) & 0xff));
+      g_string_append_c (str, (guchar)(v & 0xff));
+    }
+  else
+    {
+      g_string_append_c (str, 0xf0);
+      g_string_append_c (str, (guchar)((v >> 24) & 0xff));
+      g_string_append_c (str, (guchar)((v >> 16) & 0xff));
+      g_string_append_c (str, (guchar)((v >> 8) & 0xff));
+      g_string_append_c (str, (guchar)(v & 0xff));
+    }
+}
+
+static guint32
+demarshal_uint32 (const char **data)
+{
+  const guchar *p = (const guchar *)*data;
+  guchar c = *p;
+
+  if (c < 128) /* 7 bit */
+    {
+      *data += 1;
+      return c;
+    }
+  else if ((c & 0xc0) == 0x80) /* 14 bit */
+    {
+      *data += 2;
+      return (c & 0x3f) << 8 | p[1];
+    }
+  else if ((c & 0xe0) == 0xc0) /* 21 bit */
+    {
+      *data += 3;
+      return (c & 0x1f) << 16 | p[1] << 8 | p[2];
+    }
+  else if ((c & 0xf0) == 0xe0) /* 28 bit */
+    {
+      *data += 4;
+      return (c & 0xf) << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    }
+  else
+    {
+      *data += 5;
+      return (guint32) p[1] << 24 | p[2] << 16 | p[3] << 8 | p[4];
+    }
+}
+
+static void
+marshal_double (GString *str,
+                double   d)
+{
+  guint64 v;
+
+  memcpy (&v, &d, sizeof (v));
+  v = GUINT64_TO_LE (v);
+  g_string_append_len (str, (const char *) &v, sizeof (v));
+}
+
+static double
+demarshal_double (const char **data)
+{
+  guint64 v;
+  double d;
+
+  memcpy (&v, *data, sizeof (v));
+  *data += sizeof (v);
+  v = GUINT64_FROM_LE (v);
+  memcpy (&d, &v, sizeof (d));
+
+  return d;
+}
+
+static void
+marshal_string (GString    *str,
+                GHashTable *strings,
+                GString    *table,
+                const char *string)
+{
+  gpointer offset;
+
+  if (!g_hash_table_lookup_extended (strings, string, NULL, &offset))
+    {
+      offset = GUINT_TO_POINTER (table->len);
+      g_string_append_len (table, string, strlen (string) + 1);
+      g_hash_table_insert (strings, g_strdup (string), offset);
+    }
+
+  marshal_uint32 (str, GPOINTER_TO_UINT (offset));
+}
+
+static const char *
+demarshal_string (const char **data,
+                  const char  *strings)
+{
+  return strings + demarshal_uint32 (data);
+}
+
+static void
+marshal_location (GString              *str,
+                  const GtkCssLocation *location)
+{
+  marshal_uint32 (str, location->bytes);
+  marshal_uint32 (str, location->chars);
+  marshal_uint32 (str, location->lines);
+  marshal_uint32 (str, location->line_bytes);
+  marshal_uint32 (str, location->line_chars);
+}
+
+static void
+demarshal_location (const char     **data,
+                    GtkCssLocation  *location)
+{
+  location->bytes = demarshal_uint32 (data);
+  location->chars = demarshal_uint32 (data);
+  location->lines = demarshal_uint32 (data);
+  location->line_bytes = demarshal_uint32 (data);
+  location->line_chars = demarshal_uint32 (data);
+}
+
+static void
+marshal_token (GString           *str,
+               GHashTable        *strings,
+               GString           *table,
+               const GtkCssToken *token)
+{
+  marshal_uint32 (str, token->type);
+
+  switch (token->type)
+    {
+    case GTK_CSS_TOKEN_STRING:
+    case GTK_CSS_TOKEN_IDENT:
+    case GTK_CSS_TOKEN_FUNCTION:
+    case GTK_CSS_TOKEN_AT_KEYWORD:
+    case GTK_CSS_TOKEN_HASH_UNRESTRICTED:
+    case GTK_CSS_TOKEN_HASH_ID:
+    case GTK_CSS_TOKEN_URL:
+      marshal_string (str, strings, table, token->string.string);
+      break;
+
+    case GTK_CSS_TOKEN_DELIM:
+      marshal_uint32 (str, token->delim.delim);
+      break;
+
+    case GTK_CSS_TOKEN_SIGNED_INTEGER:
+    case GTK_CSS_TOKEN_SIGNLESS_INTEGER:
+    case GTK_CSS_TOKEN_SIGNED_NUMBER:
+    case GTK_CSS_TOKEN_SIGNLESS_NUMBER:
+    case GTK_CSS_TOKEN_PERCENTAGE:
+      marshal_double (str, token->number.number);
+      break;
+
+    case GTK_CSS_TOKEN_SIGNED_INTEGER_DIMENSION:
+    case GTK_CSS_TOKEN_SIGNLESS_INTEGER_DIMENSION:
+    case GTK_CSS_TOKEN_DIMENSION:
+      marshal_double (str, token->dimension.value);
+      marshal_string (str, strings, table, token->dimension.dimension);
+      break;
+
+    default:
+      break;
+    }
+}
+
+static gboolean
+gtk_css_tokenizer_replay_token (GtkCssTokenizer  *tokenizer,
+                                GtkCssToken      *token)
+{
+  GtkCssTokenType type;
+  const char *string;
+  double value;
+
+  type = demarshal_uint32 (&tokenizer->data);
+
+  switch (type)
+    {
+    case GTK_CSS_TOKEN_STRING:
+    case GTK_CSS_TOKEN_IDENT:
+    case GTK_CSS_TOKEN_FUNCTION:
+    case GTK_CSS_TOKEN_AT_KEYWORD:
+    case GTK_CSS_TOKEN_HASH_UNRESTRICTED:
+    case GTK_CSS_TOKEN_HASH_ID:
+    case GTK_CSS_TOKEN_URL:
+      string = demarshal_string (&tokenizer->data, tokenizer->strings);
+      gtk_css_token_init (token, type, string);
+      break;
+
+    case GTK_CSS_TOKEN_DELIM:
+      gtk_css_token_init (token, type, (gunichar) demarshal_uint32 (&tokenizer->data));
+      break;
+
+    case GTK_CSS_TOKEN_SIGNED_INTEGER:
+    case GTK_CSS_TOKEN_SIGNLESS_INTEGER:
+    case GTK_CSS_TOKEN_SIGNED_NUMBER:
+    case GTK_CSS_TOKEN_SIGNLESS_NUMBER:
+    case GTK_CSS_TOKEN_PERCENTAGE:
+      gtk_css_token_init (token, type, demarshal_double (&tokenizer->data));
+      break;
+
+    case GTK_CSS_TOKEN_SIGNED_INTEGER_DIMENSION:
+    case GTK_CSS_TOKEN_SIGNLESS_INTEGER_DIMENSION:
+    case GTK_CSS_TOKEN_DIMENSION:
+      value = demarshal_double (&tokenizer->data);
+      string = demarshal_string (&tokenizer->data, tokenizer->strings);
+      gtk_css_token_init (token, type, value, string);
+      break;
+
+    default:
+      gtk_css_token_init (token, type);
+      break;
+    }
+
+  demarshal_location (&tokenizer->data, &tokenizer->position);
+
+  return TRUE;
+}
+
+gboolean
+gtk_css_tokenizer_is_precompiled (GBytes *bytes)
+{
+  gsize size;
+  const char *data = g_bytes_get_data (bytes, &size);
+
+  return size > 4 &&
+         data[0] == 'G' &&
+         data[1] == 'C' &&
+         data[2] == 'S' &&
+         data[3] == 0;
+}
+
+/**
+ * gtk_css_tokenizer_precompile:
+ * @bytes: the CSS text to tokenize
+ * @error: return location for an error
+ *
+ * Converts CSS text to a precompiled token stream that
+ * gtk_css_tokenizer_new() replays without tokenizing the text again.
+ * Fails if the text contains tokens that would cause errors.
+ *
+ * Returns: (nullable): the precompiled data
+ */
+GBytes *
+gtk_css_tokenizer_precompile (GBytes  *bytes,
+                              GError **error)
+{
+  GtkCssTokenizer *tokenizer;
+  GHashTable *strings;
+  GString *table, *tokens, *result;
+  GtkCssToken token;
+
+  if (gtk_css_tokenizer_is_precompiled (bytes))
+    return g_bytes_ref (bytes);
+
+  tokenizer = gtk_css_tokenizer_new (bytes);
+  strings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  table = g_string_new (NULL);
+  tokens = g_string_new (NULL);
+
+  for (;;)
+    {
+      if (!gtk_css_tokenizer_read_token (tokenizer, &token, error))
+        {
+          gtk_css_token_clear (&token);
+          g_string_free (tokens, TRUE);
+          g_string_free (table, TRUE);
+          g_hash_table_unref (strings);
+          gtk_css_tokenizer_unref (tokenizer);
+          return NULL;
+        }
+
+      if (gtk_css_token_is (&token, GTK_CSS_TOKEN_EOF))
+        break;
+
+      marshal_token (tokens, strings, table, &token);
+      marshal_location (tokens, gtk_css_tokenizer_get_location (tokenizer));
+      gtk_css_token_clear (&token);
+    }
+
+  result = g_string_new (NULL);
+  /* Magic marker */
+  g_string_append_len (result, "GCS\0", 4);
+  marshal_uint32 (result, table->len);
+  g_string_append_len (result, table->str, table->len);
+  g_string_append_len (result, tokens->str, tokens->len);
+
+  g_string_free (tokens, TRUE);
+  g_string_free (table, TRUE);
+  g_hash_table_unref (strings);
+  gtk_css_tokenizer_unref (tokenizer);
+
+  return g_string_free_to_bytes (result);
+}
+
 GtkCssTokenizer *
 gtk_css_tokenizer_new (GBytes *bytes)
 {
@@ -534,12 +823,23 @@ gtk_css_tokenizer_new (GBytes *bytes)
   tokenizer = g_slice_new0 (GtkCssTokenizer);
   tokenizer->ref_count = 1;
   tokenizer->bytes = g_bytes_ref (bytes);
+  tokenizer->buffer = g_string_new (NULL);
 
   tokenizer->data = g_bytes_get_data (bytes, NULL);
   tokenizer->end = tokenizer->data + g_bytes_get_size (bytes);
 
   gtk_css_location_init (&tokenizer->position);
 
+  if (gtk_css_tokenizer_is_precompiled (bytes))
+    {
+      guint32 len;
+
+      tokenizer->data += 4; /* Skip header */
+      len = demarshal_uint32 (&tokenizer->data);
+      tokenizer->strings = tokenizer->data;
+      tokenizer->data += len;
+    }
+
   return tokenizer;
 }
 
@@ -558,6 +858,7 @@ gtk_css_tokenizer_unref (GtkCssTokenizer *tokenizer)
   if (tokenizer->ref_count > 0)
     return;
 
+  g_string_free (tokenizer->buffer, TRUE);
   g_bytes_unref (tokenizer->bytes);
   g_slice_free (GtkCssTokenizer, tokenizer);
 }
@@ -843,7 +1144,7 @@ gtk_css_tokenizer_read_escape (GtkCssTokenizer *tokenizer)
 static char *
 gtk_css_tokenizer_read_name (GtkCssTokenizer *tokenizer)
 {
-  GString *string = g_string_new (NULL);
+  GString *string = g_string_truncate (tokenizer->buffer, 0);
 
   do {
       if (*tokenizer->data == '\\')
@@ -877,7 +1178,7 @@ gtk_css_tokenizer_read_name (GtkCssTokenizer *tokenizer)
     }
   while (tokenizer->data != tokenizer->end);
 
-  return g_string_free (string, FALSE);
+  return string->str;
 }
 
 static void
@@ -903,7 +1204,7 @@ gtk_css_tokenizer_read_url (GtkCssTokenizer  *tokenizer,
                             GtkCssToken      *token,
                             GError          **error)
 {
-  GString *url = g_string_new (NULL);
+  GString *url = g_string_truncate (tokenizer->buffer, 0);
 
   while (tokenizer->data < tokenizer->end && is_whitespace (*tokenizer->data))
     gtk_css_tokenizer_consume_whitespace (tokenizer);
@@ -940,7 +1241,6 @@ gtk_css_tokenizer_read_url (GtkCssTokenizer  *tokenizer,
       else if (is_non_printable (*tokenizer->data))
         {
           gtk_css_tokenizer_read_bad_url (tokenizer, token);
-          g_string_free (url, TRUE);
           gtk_css_tokenizer_parse_error (error, "Nonprintable character 0x%02X in url", *tokenizer->data);
           return FALSE;
         }
@@ -950,7 +1250,6 @@ gtk_css_tokenizer_read_url (GtkCssTokenizer  *tokenizer,
         {
           gtk_css_tokenizer_read_bad_url (tokenizer, token);
           gtk_css_tokenizer_parse_error (error, "Invalid character %c in url", *tokenizer->data);
-          g_string_free (url, TRUE);
           return FALSE;
         }
       else if (gtk_css_tokenizer_has_valid_escape (tokenizer))
@@ -961,7 +1260,6 @@ gtk_css_tokenizer_read_url (GtkCssTokenizer  *tokenizer,
         {
           gtk_css_tokenizer_read_bad_url (tokenizer, token);
           gtk_css_tokenizer_parse_error (error, "Newline may not follow '\' escape character");
-          g_string_free (url, TRUE);
           return FALSE;
         }
       else
@@ -970,7 +1268,7 @@ gtk_css_tokenizer_read_url (GtkCssTokenizer  *tokenizer,
         }
     }
 
-  gtk_css_token_init (token, GTK_CSS_TOKEN_URL, g_string_free (url, FALSE));
+  gtk_css_token_init (token, GTK_CSS_TOKEN_URL, url->str);
 
   return TRUE;
 }
@@ -993,10 +1291,7 @@ gtk_css_tokenizer_read_ident_like (GtkCssTokenizer  *tokenizer,
             data++;
 
           if (*data != '"' && *data != '\'')
-            {
-              g_free (name);
-              return gtk_css_tokenizer_read_url (tokenizer, token, error);
-            }
+            return gtk_css_tokenizer_read_url (tokenizer, token, error);
         }
 
       gtk_css_token_init (token, GTK_CSS_TOKEN_FUNCTION, name);
@@ -1153,7 +1448,7 @@ gtk_css_tokenizer_read_string (GtkCssTokenizer  *tokenizer,
                                GtkCssToken      *token,
                                GError          **error)
 {
-  GString *string = g_string_new (NULL);
+  GString *string = g_string_truncate (tokenizer->buffer, 0);
   char end = *tokenizer->data;
 
   gtk_css_tokenizer_consume_ascii (tokenizer);
@@ -1184,7 +1479,6 @@ gtk_css_tokenizer_read_string (GtkCssTokenizer  *tokenizer,
         }
       else if (is_newline (*tokenizer->data))
         {
-          g_string_free (string, TRUE);
           gtk_css_token_init (token, GTK_CSS_TOKEN_BAD_STRING);
           gtk_css_tokenizer_parse_error (error, "Newlines inside strings must be escaped");
           return FALSE;
@@ -1195,7 +1489,7 @@ gtk_css_tokenizer_read_string (GtkCssTokenizer  *tokenizer,
         }
     }
   
-  gtk_css_token_init (token, GTK_CSS_TOKEN_STRING, g_string_free (string, FALSE));
+  gtk_css_token_init (token, GTK_CSS_TOKEN_STRING, string->str);
 
   return TRUE;
 }
@@ -1251,6 +1545,9 @@ gtk_css_tokenizer_read_token (GtkCssTokenizer  *tokenizer,
       return TRUE;
     }
 
+  if (tokenizer->strings)
+    return gtk_css_tokenizer_replay_token (tokenizer, token);
+
   if (tokenizer->data[0] == '/' && gtk_css_tokenizer_remaining (tokenizer) > 1 &&
       tokenizer->data[1] == '*')
     return gtk_css_tokenizer_read_comment (tokenizer, token, error);
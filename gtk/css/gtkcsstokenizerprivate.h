@@ -125,6 +125,9 @@ void                    gtk_css_token_print                     (const GtkCssTok
 char *                  gtk_css_token_to_string                 (const GtkCssToken      *token);
 
 GtkCssTokenizer *       gtk_css_tokenizer_new                   (GBytes                 *bytes);
+gboolean                gtk_css_tokenizer_is_precompiled        (GBytes                 *bytes);
+GBytes *                gtk_css_tokenizer_precompile            (GBytes                 *bytes,
+                                                                 GError                **error);
 
 GtkCssTokenizer *       gtk_css_tokenizer_ref                   (GtkCssTokenizer        *tokenizer);
 void                    gtk_css_tokenizer_unref                 (GtkCssTokenizer        *tokenizer);
@@ -2,7 +2,15 @@
 #
 # Generate gtk.gresources.xml
 #
-# Usage: gen-gtk-gresources-xml SRCDIR_GTK [OUTPUT-FILE]
+# Usage: gen-gtk-gresources-xml [--precompiled-themes] [--predecoded-images] SRCDIR_GTK [OUTPUT-FILE]
+#        gen-gtk-gresources-xml --list-images SRCDIR_GTK
+#
+# With --precompiled-themes, the generated themes are taken from the
+# .css.precompiled files made by gtk-css-precompile.
+#
+# With --predecoded-images, the .predecoded files made by
+# gdk-image-predecode are added next to the PNG images. --list-images
+# prints the PNG images that this applies to.
 
 import os, sys
 import filecmp
@@ -20,13 +28,42 @@ def replace_if_changed(new, old):
   else:
     os.remove(new)
 
+precompiled = '--precompiled-themes' in sys.argv
+if precompiled:
+  sys.argv.remove('--precompiled-themes')
+
+predecoded = '--predecoded-images' in sys.argv
+if predecoded:
+  sys.argv.remove('--predecoded-images')
+
+list_images = '--list-images' in sys.argv
+if list_images:
+  sys.argv.remove('--list-images')
+
 srcdir = sys.argv[1]
 
+def theme_file(name):
+  if precompiled:
+    return '<file alias=\'{0}\'>{0}.precompiled</file>'.format(name)
+  return '<file>{0}</file>'.format(name)
+
 xml = '''<?xml version='1.0' encoding='UTF-8'?>
 <gresources>
   <gresource prefix='/org/gtk/libgtk'>
 '''
 
+images = []
+
+def image_file(name, alias=None):
+  images.append(name)
+  if alias:
+    line = '    <file alias=\'{0}\'>{1}</file>\n'.format(alias, name)
+  else:
+    line = '    <file>{0}</file>\n'.format(name)
+  if predecoded:
+    line += '    <file alias=\'{0}.predecoded\'>{1}.predecoded</file>\n'.format(alias or name, name.replace('/', '-'))
+  return line
+
 def get_files(subdir,extension):
   return sorted(filter(lambda x: x.endswith((extension)), os.listdir(os.path.join(srcdir,subdir))))
 
@@ -34,12 +71,13 @@ xml += '''
     <file>theme/Empty/gtk.css</file>
     <file>theme/Adwaita/gtk.css</file>
     <file>theme/Adwaita/gtk-dark.css</file>
-    <file>theme/Adwaita/Adwaita.css</file>
-    <file>theme/Adwaita/Adwaita-dark.css</file>
-'''
+    {0}
+    {1}
+'''.format(theme_file('theme/Adwaita/Adwaita.css'),
+           theme_file('theme/Adwaita/Adwaita-dark.css'))
 
 for f in get_files('theme/Adwaita/assets', '.png'):
-  xml += '    <file>theme/Adwaita/assets/{0}</file>\n'.format(f)
+  xml += image_file('theme/Adwaita/assets/{0}'.format(f))
 
 xml += '\n'
 
@@ -49,12 +87,13 @@ for f in get_files('theme/Adwaita/assets', '.svg'):
 xml += '''
     <file>theme/HighContrast/gtk.css</file>
     <file alias='theme/HighContrastInverse/gtk.css'>theme/HighContrast/gtk-inverse.css</file>
-    <file>theme/HighContrast/HighContrast.css</file>
-    <file>theme/HighContrast/HighContrast-inverse.css</file>
-'''
+    {0}
+    {1}
+'''.format(theme_file('theme/HighContrast/HighContrast.css'),
+           theme_file('theme/HighContrast/HighContrast-inverse.css'))
 
 for f in get_files('theme/HighContrast/assets', '.png'):
-  xml += '    <file>theme/HighContrast/assets/{0}</file>\n'.format(f)
+  xml += image_file('theme/HighContrast/assets/{0}'.format(f))
 
 xml += '\n'
 
@@ -62,7 +101,7 @@ for f in get_files('theme/HighContrast/assets', '.svg'):
   xml += '    <file>theme/HighContrast/assets/{0}</file>\n'.format(f)
 
 for f in get_files('gesture', '.symbolic.png'):
-  xml += '    <file alias=\'icons/64x64/actions/{0}\'>gesture/{0}</file>\n'.format(f)
+  xml += image_file('gesture/{0}'.format(f), 'icons/64x64/actions/{0}'.format(f))
 
 xml += '\n'
 
@@ -76,21 +115,24 @@ for s in ['16x16', '24x24', '32x32', '48x48', 'scalable']:
     icons_dir = 'icons/{0}/{1}'.format(s,c)
     if os.path.exists(os.path.join(srcdir,icons_dir)):
       for f in get_files(icons_dir, '.png'):
-        xml += '    <file>icons/{0}/{1}/{2}</file>\n'.format(s,c,f)
+        xml += image_file('icons/{0}/{1}/{2}'.format(s,c,f))
       for f in get_files(icons_dir, '.svg'):
         xml += '    <file>icons/{0}/{1}/{2}</file>\n'.format(s,c,f)
 
 for f in get_files('inspector', '.ui'):
   xml += '    <file preprocess=\'xml-stripblanks\'>inspector/{0}</file>\n'.format(f)
 
-xml += '''
-    <file>inspector/logo.png</file>
-    <file>inspector/inspector.css</file>
+xml += '\n'
+xml += image_file('inspector/logo.png')
+
+xml += '''    <file>inspector/inspector.css</file>
     <file>emoji/en.data</file>
   </gresource>
 </gresources>'''
 
-if len(sys.argv) > 2:
+if list_images:
+  print('\n'.join(images))
+elif len(sys.argv) > 2:
   outfile = sys.argv[2]
   tmpfile = outfile + '~'
   with open(tmpfile, 'w') as f:
@@ -27,11 +27,14 @@
 #include "gtktextviewprivate.h"
 #include "gtkwidgetprivate.h"
 #include "gtkcsscolorvalueprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 
 #include <math.h>
 
 #include <pango/pango.h>
+#include <pango/pangocairo.h>
 #include <cairo.h>
+#include <string.h>
 
 G_DEFINE_TYPE (GskPangoRenderer, gsk_pango_renderer, PANGO_TYPE_RENDERER)
 
@@ -497,3 +500,218 @@ gtk_snapshot_append_layout (GtkSnapshot   *snapshot,
 
   gsk_pango_renderer_release (crenderer);
 }
+
+/* Shared layouts
+ *
+ * Many widgets show the same short strings with the same style, like
+ * column headers, menu items or timestamps. Instead of shaping each of
+ * them separately, such layouts can be exchanged for a shared copy that
+ * is kept in a small process-wide LRU cache. Shared layouts live on a
+ * private context, so they are not affected when the context of the
+ * widget that created them changes, and they must never be modified.
+ */
+
+#define SHARED_LAYOUTS_MAX 256
+
+static GHashTable *shared_layouts; /* PangoLayout -> GList link in shared_layouts_lru */
+static GQueue shared_layouts_lru = G_QUEUE_INIT;
+
+static int shared_layout_hits;
+static int shared_layout_misses;
+static guint shared_layout_hits_counter;
+static guint shared_layout_misses_counter;
+
+static guint
+shared_layout_hash (gconstpointer data)
+{
+  PangoLayout *layout = (PangoLayout *) data;
+  PangoContext *context = pango_layout_get_context (layout);
+  guint hash;
+
+  hash = g_str_hash (pango_layout_get_text (layout));
+  hash ^= pango_font_description_hash (pango_context_get_font_description (context));
+  hash ^= g_direct_hash (pango_context_get_font_map (context));
+  hash ^= pango_layout_get_alignment (layout) << 24;
+
+  return hash;
+}
+
+static gboolean
+font_options_equal (const cairo_font_options_t *a,
+                    const cairo_font_options_t *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return cairo_font_options_equal (a, b);
+}
+
+static gboolean
+attr_lists_equal (PangoAttrList *a,
+                  PangoAttrList *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return pango_attr_list_equal (a, b);
+}
+
+static gboolean
+shared_layout_equal (gconstpointer data1,
+                     gconstpointer data2)
+{
+  PangoLayout *a = (PangoLayout *) data1;
+  PangoLayout *b = (PangoLayout *) data2;
+  PangoContext *ca = pango_layout_get_context (a);
+  PangoContext *cb = pango_layout_get_context (b);
+
+  return pango_context_get_font_map (ca) == pango_context_get_font_map (cb) &&
+         pango_font_description_equal (pango_context_get_font_description (ca),
+                                       pango_context_get_font_description (cb)) &&
+         pango_context_get_language (ca) == pango_context_get_language (cb) &&
+         pango_context_get_base_dir (ca) == pango_context_get_base_dir (cb) &&
+         pango_context_get_base_gravity (ca) == pango_context_get_base_gravity (cb) &&
+         pango_context_get_gravity_hint (ca) == pango_context_get_gravity_hint (cb) &&
+         pango_context_get_round_glyph_positions (ca) == pango_context_get_round_glyph_positions (cb) &&
+         pango_cairo_context_get_resolution (ca) == pango_cairo_context_get_resolution (cb) &&
+         font_options_equal (pango_cairo_context_get_font_options (ca),
+                             pango_cairo_context_get_font_options (cb)) &&
+         pango_layout_get_alignment (a) == pango_layout_get_alignment (b) &&
+         pango_layout_get_justify (a) == pango_layout_get_justify (b) &&
+         pango_layout_get_single_paragraph_mode (a) == pango_layout_get_single_paragraph_mode (b) &&
+         pango_layout_get_auto_dir (a) == pango_layout_get_auto_dir (b) &&
+         pango_layout_get_spacing (a) == pango_layout_get_spacing (b) &&
+         pango_layout_get_line_spacing (a) == pango_layout_get_line_spacing (b) &&
+         strcmp (pango_layout_get_text (a), pango_layout_get_text (b)) == 0 &&
+         attr_lists_equal (pango_layout_get_attributes (a), pango_layout_get_attributes (b));
+}
+
+/* Only layouts that don't depend on a size and that carry no per-layout
+ * state beyond what shared_layout_equal() compares can be shared.
+ */
+static gboolean
+layout_is_shareable (PangoLayout *layout)
+{
+  PangoContext *context = pango_layout_get_context (layout);
+
+  return pango_layout_get_width (layout) == -1 &&
+         pango_layout_get_height (layout) == -1 &&
+         pango_layout_get_indent (layout) == 0 &&
+         pango_layout_get_font_description (layout) == NULL &&
+         pango_layout_get_tabs (layout) == NULL &&
+         pango_context_get_matrix (context) == NULL;
+}
+
+static PangoLayout *
+create_shared_layout (PangoLayout *layout)
+{
+  PangoContext *context = pango_layout_get_context (layout);
+  PangoContext *copy_context;
+  PangoLayout *copy;
+
+  copy_context = pango_font_map_create_context (pango_context_get_font_map (context));
+  pango_context_set_font_description (copy_context, pango_context_get_font_description (context));
+  pango_context_set_language (copy_context, pango_context_get_language (context));
+  pango_context_set_base_dir (copy_context, pango_context_get_base_dir (context));
+  pango_context_set_base_gravity (copy_context, pango_context_get_base_gravity (context));
+  pango_context_set_gravity_hint (copy_context, pango_context_get_gravity_hint (context));
+  pango_context_set_round_glyph_positions (copy_context, pango_context_get_round_glyph_positions (context));
+  pango_cairo_context_set_resolution (copy_context, pango_cairo_context_get_resolution (context));
+  pango_cairo_context_set_font_options (copy_context, pango_cairo_context_get_font_options (context));
+
+  copy = pango_layout_new (copy_context);
+  pango_layout_set_text (copy, pango_layout_get_text (layout), -1);
+  pango_layout_set_attributes (copy, pango_layout_get_attributes (layout));
+  pango_layout_set_alignment (copy, pango_layout_get_alignment (layout));
+  pango_layout_set_justify (copy, pango_layout_get_justify (layout));
+  pango_layout_set_single_paragraph_mode (copy, pango_layout_get_single_paragraph_mode (layout));
+  pango_layout_set_auto_dir (copy, pango_layout_get_auto_dir (layout));
+  pango_layout_set_spacing (copy, pango_layout_get_spacing (layout));
+  pango_layout_set_line_spacing (copy, pango_layout_get_line_spacing (layout));
+  pango_layout_set_wrap (copy, pango_layout_get_wrap (layout));
+  pango_layout_set_ellipsize (copy, pango_layout_get_ellipsize (layout));
+
+  g_object_unref (copy_context);
+
+  return copy;
+}
+
+/*
+ * gsk_pango_layout_share:
+ * @layout: (transfer full): a layout that has not been laid out yet
+ *
+ * Exchanges @layout for an equivalent layout from the shared layout
+ * cache, so that layouts with identical text, attributes and context
+ * settings are only shaped once.
+ *
+ * If @layout cannot be shared, it is returned unchanged. Otherwise the
+ * returned layout is shared with other users and must not be modified;
+ * use pango_layout_copy() to get a private layout from it.
+ *
+ * Returns: (transfer full): @layout or a shared layout
+ */
+PangoLayout *
+gsk_pango_layout_share (PangoLayout *layout)
+{
+  PangoLayout *shared;
+  GList *link;
+
+  g_return_val_if_fail (PANGO_IS_LAYOUT (layout), layout);
+
+  if (!layout_is_shareable (layout))
+    return layout;
+
+  if (G_UNLIKELY (shared_layouts == NULL))
+    shared_layouts = g_hash_table_new (shared_layout_hash, shared_layout_equal);
+
+  link = g_hash_table_lookup (shared_layouts, layout);
+  if (link)
+    {
+      shared_layout_hits++;
+
+      g_queue_unlink (&shared_layouts_lru, link);
+      g_queue_push_head_link (&shared_layouts_lru, link);
+
+      shared = link->data;
+    }
+  else
+    {
+      shared_layout_misses++;
+
+      shared = create_shared_layout (layout);
+      g_queue_push_head (&shared_layouts_lru, shared);
+      g_hash_table_insert (shared_layouts, shared, shared_layouts_lru.head);
+
+      if (shared_layouts_lru.length > SHARED_LAYOUTS_MAX)
+        {
+          PangoLayout *oldest = g_queue_pop_tail (&shared_layouts_lru);
+
+          g_hash_table_remove (shared_layouts, oldest);
+          g_object_unref (oldest);
+        }
+    }
+
+  g_object_unref (layout);
+
+  return g_object_ref (shared);
+}
+
+/* Pushes the shared layout statistics since the last call to sysprof */
+void
+gsk_pango_push_profiler_counters (void)
+{
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (shared_layout_hits_counter == 0)
+        {
+          shared_layout_hits_counter = gdk_profiler_define_int_counter ("shared-layout-hits", "Shared Layout Cache Hits");
+          shared_layout_misses_counter = gdk_profiler_define_int_counter ("shared-layout-misses", "Shared Layout Cache Misses");
+        }
+
+      gdk_profiler_set_int_counter (shared_layout_hits_counter, shared_layout_hits);
+      gdk_profiler_set_int_counter (shared_layout_misses_counter, shared_layout_misses);
+    }
+
+  shared_layout_hits = 0;
+  shared_layout_misses = 0;
+}
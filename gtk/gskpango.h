@@ -84,6 +84,9 @@ void              gsk_pango_renderer_set_shape_handler (GskPangoRenderer      *c
 GskPangoRenderer *gsk_pango_renderer_acquire   (void);
 void              gsk_pango_renderer_release   (GskPangoRenderer      *crenderer);
 
+PangoLayout *     gsk_pango_layout_share       (PangoLayout           *layout);
+void              gsk_pango_push_profiler_counters (void);
+
 G_END_DECLS
 
 #endif /* __GSK_PANGO_H__ */
@@ -161,6 +161,14 @@ struct _GtkActionMuxer
   GtkAccels primary_accels;
 
   GtkBitmask *widget_actions_disabled;
+
+  /* Lookups of action names through the whole hierarchy */
+  GHashTable *resolved_actions;
+  guint resolved_generation;
+
+  /* Actions whose observers still need to hear about enabled changes */
+  GHashTable *pending_enabled;
+  guint pending_enabled_id;
 };
 
 G_DEFINE_TYPE_WITH_CODE (GtkActionMuxer, gtk_action_muxer, G_TYPE_OBJECT,
@@ -192,6 +200,25 @@ typedef struct
   gulong        handler_ids[4];
 } Group;
 
+typedef struct
+{
+  GtkActionMuxer  *muxer;   /* the muxer providing the action, or NULL */
+  GtkWidgetAction *action;  /* set for widget actions */
+  Group           *group;   /* set for actions from groups */
+} ResolvedAction;
+
+/* Bumped whenever an action name may resolve differently, that is when
+ * groups or their actions come and go, or the hierarchy changes. Resolved
+ * actions from an older generation are thrown away on the next lookup.
+ */
+static guint resolved_generation = 1;
+
+static inline void
+gtk_action_muxer_invalidate_resolved (void)
+{
+  resolved_generation++;
+}
+
 static inline guint
 get_action_position (GtkWidgetAction *action)
 {
@@ -301,18 +328,95 @@ gtk_action_muxer_find_group (GtkActionMuxer  *muxer,
   return NULL;
 }
 
+static GtkWidgetAction *
+gtk_action_muxer_find_widget_action (GtkActionMuxer *muxer,
+                                     const char     *action_name)
+{
+  GtkWidgetClass *klass;
+  GtkWidgetAction *action;
+
+  if (!muxer->widget)
+    return NULL;
+
+  klass = GTK_WIDGET_GET_CLASS (muxer->widget);
+
+  for (action = klass->priv->actions; action; action = action->next)
+    {
+      if (strcmp (action->name, action_name) == 0)
+        return action;
+    }
+
+  return NULL;
+}
+
+static inline const char *
+unprefixed_action_name (const char *action_name)
+{
+  return strchr (action_name, '.') + 1;
+}
+
+/* Finds the muxer that provides @action_name, starting at @muxer and
+ * going up the parents. The result is cached, as action helpers and
+ * menu trackers query the same actions over and over.
+ */
+static const ResolvedAction *
+gtk_action_muxer_resolve (GtkActionMuxer *muxer,
+                          const char     *action_name)
+{
+  ResolvedAction *resolved;
+  GtkActionMuxer *m;
+
+  if (muxer->resolved_actions == NULL)
+    muxer->resolved_actions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  else if (muxer->resolved_generation != resolved_generation)
+    g_hash_table_remove_all (muxer->resolved_actions);
+
+  muxer->resolved_generation = resolved_generation;
+
+  /* Groups emit ::action-removed before the action is gone, so
+   * we can't rely on the generation alone for those.
+   */
+  resolved = g_hash_table_lookup (muxer->resolved_actions, action_name);
+  if (resolved &&
+      (resolved->group == NULL ||
+       g_action_group_has_action (resolved->group->group, unprefixed_action_name (action_name))))
+    return resolved;
+
+  resolved = g_new0 (ResolvedAction, 1);
+
+  for (m = muxer; m != NULL; m = m->parent)
+    {
+      resolved->action = gtk_action_muxer_find_widget_action (m, action_name);
+      if (resolved->action == NULL)
+        resolved->group = gtk_action_muxer_find_group (m, action_name, NULL);
+
+      if (resolved->action || resolved->group)
+        {
+          resolved->muxer = m;
+          break;
+        }
+    }
+
+  g_hash_table_insert (muxer->resolved_actions, g_strdup (action_name), resolved);
+
+  return resolved;
+}
+
 GActionGroup *
 gtk_action_muxer_find (GtkActionMuxer  *muxer,
                        const char      *action_name,
                        const char     **unprefixed_name)
 {
-  Group *group;
+  const ResolvedAction *resolved;
 
-  group = gtk_action_muxer_find_group (muxer, action_name, unprefixed_name);
-  if (group)
-    return group->group;
+  resolved = gtk_action_muxer_resolve (muxer, action_name);
+  if (resolved->muxer != muxer || resolved->group == NULL)
+    return NULL;
 
-  return NULL;
+  if (unprefixed_name)
+    *unprefixed_name = unprefixed_action_name (action_name);
+
+  return resolved->group->group;
 }
 
 static inline Action *
@@ -325,36 +429,102 @@ find_observers (GtkActionMuxer *muxer,
   return NULL;
 }
 
-void
-gtk_action_muxer_action_enabled_changed (GtkActionMuxer *muxer,
+static void
+gtk_action_muxer_notify_enabled_changed (GtkActionMuxer *muxer,
                                          const char     *action_name,
                                          gboolean        enabled)
 {
-  GtkWidgetAction *iter;
   Action *action;
   GSList *node;
 
-  if (muxer->widget)
+  action = find_observers (muxer, action_name);
+
+  for (node = action ? action->watchers : NULL; node; node = node->next)
+    gtk_action_observer_action_enabled_changed (node->data, GTK_ACTION_OBSERVABLE (muxer), action_name, enabled);
+}
+
+static gboolean action_muxer_query_action (GtkActionMuxer      *muxer,
+                                           const char          *action_name,
+                                           gboolean            *enabled,
+                                           const GVariantType **parameter_type,
+                                           const GVariantType **state_type,
+                                           GVariant           **state_hint,
+                                           GVariant           **state,
+                                           gboolean             recurse);
+
+static gboolean
+gtk_action_muxer_flush_enabled_changed (gpointer data)
+{
+  GtkActionMuxer *muxer = data;
+  GHashTable *pending;
+  GHashTableIter iter;
+  const char *action_name;
+
+  pending = muxer->pending_enabled;
+  muxer->pending_enabled = NULL;
+  muxer->pending_enabled_id = 0;
+
+  /* Report the state the action has now, an action may have been
+   * toggled several times or gone away in the meantime.
+   */
+  g_hash_table_iter_init (&iter, pending);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&action_name, NULL))
     {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
+      gboolean enabled;
 
-      for (iter = priv->actions; iter; iter = iter->next)
-        {
-          if (strcmp (action_name, iter->name) == 0)
-            {
-              guint position = get_action_position (iter);
-              muxer->widget_actions_disabled =
-                _gtk_bitmask_set (muxer->widget_actions_disabled, position, !enabled);
-              break;
-            }
-        }
+      if (action_muxer_query_action (muxer, action_name,
+                                     &enabled, NULL, NULL, NULL, NULL,
+                                     FALSE))
+        gtk_action_muxer_notify_enabled_changed (muxer, action_name, enabled);
     }
 
-  action = find_observers (muxer, action_name);
+  g_hash_table_unref (pending);
 
-  for (node = action ? action->watchers : NULL; node; node = node->next)
-    gtk_action_observer_action_enabled_changed (node->data, GTK_ACTION_OBSERVABLE (muxer), action_name, enabled);
+  return G_SOURCE_REMOVE;
+}
+
+/* Changes of the enabled state are collected and passed on to observers
+ * once, before the next frame is drawn. Groups and widgets tend to flip
+ * many actions at once, and every observer may cause relayouts.
+ */
+static void
+gtk_action_muxer_queue_enabled_changed (GtkActionMuxer *muxer,
+                                        const char     *action_name)
+{
+  if (find_observers (muxer, action_name) == NULL)
+    return;
+
+  if (muxer->pending_enabled == NULL)
+    muxer->pending_enabled = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  g_hash_table_add (muxer->pending_enabled, g_strdup (action_name));
+
+  if (muxer->pending_enabled_id == 0)
+    {
+      muxer->pending_enabled_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                                   gtk_action_muxer_flush_enabled_changed,
+                                                   muxer,
+                                                   NULL);
+      g_source_set_name_by_id (muxer->pending_enabled_id, "[gtk] gtk_action_muxer_flush_enabled_changed");
+    }
+}
+
+void
+gtk_action_muxer_action_enabled_changed (GtkActionMuxer *muxer,
+                                         const char     *action_name,
+                                         gboolean        enabled)
+{
+  GtkWidgetAction *action;
+
+  action = gtk_action_muxer_find_widget_action (muxer, action_name);
+  if (action)
+    {
+      guint position = get_action_position (action);
+      muxer->widget_actions_disabled =
+        _gtk_bitmask_set (muxer->widget_actions_disabled, position, !enabled);
+    }
+
+  gtk_action_muxer_queue_enabled_changed (muxer, action_name);
 }
 
 static void
@@ -367,7 +537,7 @@ gtk_action_muxer_group_action_enabled_changed (GActionGroup *action_group,
   char *fullname;
 
   fullname = g_strconcat (group->prefix, ".", action_name, NULL);
-  gtk_action_muxer_action_enabled_changed (group->muxer, fullname, enabled);
+  gtk_action_muxer_queue_enabled_changed (group->muxer, fullname);
   g_free (fullname);
 }
 
@@ -398,15 +568,6 @@ gtk_action_muxer_group_action_state_changed (GActionGroup *action_group,
   g_free (fullname);
 }
 
-static gboolean action_muxer_query_action (GtkActionMuxer      *muxer,
-                                           const char          *action_name,
-                                           gboolean            *enabled,
-                                           const GVariantType **parameter_type,
-                                           const GVariantType **state_type,
-                                           GVariant           **state_hint,
-                                           GVariant           **state,
-                                           gboolean             recurse);
-
 static void
 notify_observers_added (GtkActionMuxer *muxer,
                         GtkActionMuxer *parent)
@@ -511,6 +672,8 @@ gtk_action_muxer_action_added_to_group (GActionGroup *action_group,
   GVariant *state;
   char *fullname;
 
+  gtk_action_muxer_invalidate_resolved ();
+
   fullname = g_strconcat (group->prefix, ".", action_name, NULL);
 
    if (muxer->parent)
@@ -555,6 +718,8 @@ gtk_action_muxer_action_removed_from_group (GActionGroup *action_group,
   char *fullname;
   Action *action;
 
+  gtk_action_muxer_invalidate_resolved ();
+
   fullname = g_strconcat (group->prefix, ".", action_name, NULL);
   gtk_action_muxer_action_removed (muxer, fullname);
   g_free (fullname);
@@ -731,60 +896,45 @@ action_muxer_query_action (GtkActionMuxer      *muxer,
                            GVariant           **state,
                            gboolean             recurse)
 {
+  const ResolvedAction *resolved;
   GtkWidgetAction *action;
-  Group *group;
-  const char *unprefixed_name;
 
-  if (muxer->widget)
-    {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
+  resolved = gtk_action_muxer_resolve (muxer, action_name);
 
-      for (action = priv->actions; action; action = action->next)
-        {
-          guint position;
-
-          if (strcmp (action->name, action_name) != 0)
-            continue;
-
-          position = get_action_position (action);
-
-          if (enabled)
-            *enabled = !_gtk_bitmask_get (muxer->widget_actions_disabled, position);
-          if (parameter_type)
-            *parameter_type = action->parameter_type;
-          if (state_type)
-            *state_type = action->state_type;
-
-          if (state_hint)
-            *state_hint = NULL;
-          if (state)
-            *state = NULL;
-
-          if (action->pspec)
-            {
-              if (state)
-                *state = prop_action_get_state (muxer->widget, action);
-              if (state_hint)
-                *state_hint = prop_action_get_state_hint (muxer->widget, action);
-            }
-
-          return TRUE;
-        }
-    }
+  if (resolved->muxer == NULL ||
+      (resolved->muxer != muxer && !recurse))
+    return FALSE;
+
+  if (resolved->group)
+    return g_action_group_query_action (resolved->group->group,
+                                        unprefixed_action_name (action_name),
+                                        enabled, parameter_type,
+                                        state_type, state_hint, state);
 
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
+  action = resolved->action;
+  muxer = resolved->muxer;
 
-  if (group)
-    return g_action_group_query_action (group->group, unprefixed_name, enabled,
-                                        parameter_type, state_type, state_hint, state);
+  if (enabled)
+    *enabled = !_gtk_bitmask_get (muxer->widget_actions_disabled, get_action_position (action));
+  if (parameter_type)
+    *parameter_type = action->parameter_type;
+  if (state_type)
+    *state_type = action->state_type;
 
-  if (muxer->parent && recurse)
-    return gtk_action_muxer_query_action (muxer->parent, action_name,
-                                          enabled, parameter_type,
-                                          state_type, state_hint, state);
+  if (state_hint)
+    *state_hint = NULL;
+  if (state)
+    *state = NULL;
 
-  return FALSE;
+  if (action->pspec)
+    {
+      if (state)
+        *state = prop_action_get_state (muxer->widget, action);
+      if (state_hint)
+        *state_hint = prop_action_get_state_hint (muxer->widget, action);
+    }
+
+  return TRUE;
 }
 
 gboolean
@@ -816,40 +966,30 @@ gtk_action_muxer_activate_action (GtkActionMuxer *muxer,
                                   const char     *action_name,
                                   GVariant       *parameter)
 {
-  const char *unprefixed_name;
-  Group *group;
+  const ResolvedAction *resolved;
 
-  if (muxer->widget)
+  resolved = gtk_action_muxer_resolve (muxer, action_name);
+
+  if (resolved->group)
     {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
-      GtkWidgetAction *action;
+      g_action_group_activate_action (resolved->group->group,
+                                      unprefixed_action_name (action_name),
+                                      parameter);
+    }
+  else if (resolved->action)
+    {
+      GtkWidgetAction *action = resolved->action;
+
+      muxer = resolved->muxer;
 
-      for (action = priv->actions; action; action = action->next)
+      if (!_gtk_bitmask_get (muxer->widget_actions_disabled, get_action_position (action)))
         {
-          if (strcmp (action->name, action_name) == 0)
-            {
-              guint position = get_action_position (action);
-
-              if (!_gtk_bitmask_get (muxer->widget_actions_disabled, position))
-                {
-                  if (action->activate)
-                    action->activate (muxer->widget, action->name, parameter);
-                  else if (action->pspec)
-                    prop_action_activate (muxer->widget, action, parameter);
-                }
-
-              return;
-            }
+          if (action->activate)
+            action->activate (muxer->widget, action->name, parameter);
+          else if (action->pspec)
+            prop_action_activate (muxer->widget, action, parameter);
         }
     }
-
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
-
-  if (group)
-    g_action_group_activate_action (group->group, unprefixed_name, parameter);
-  else if (muxer->parent)
-    gtk_action_muxer_activate_action (muxer->parent, action_name, parameter);
 }
 
 void
@@ -857,33 +997,21 @@ gtk_action_muxer_change_action_state (GtkActionMuxer *muxer,
                                       const char     *action_name,
                                       GVariant       *state)
 {
-  GtkWidgetAction *action;
-  const char *unprefixed_name;
-  Group *group;
-
-  if (muxer->widget)
-    {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
+  const ResolvedAction *resolved;
 
-      for (action = priv->actions; action; action = action->next)
-        {
-          if (strcmp (action->name, action_name) == 0)
-            {
-              if (action->pspec)
-                prop_action_set_state (muxer->widget, action, state);
+  resolved = gtk_action_muxer_resolve (muxer, action_name);
 
-              return;
-            }
-        }
+  if (resolved->group)
+    {
+      g_action_group_change_action_state (resolved->group->group,
+                                          unprefixed_action_name (action_name),
+                                          state);
+    }
+  else if (resolved->action)
+    {
+      if (resolved->action->pspec)
+        prop_action_set_state (resolved->muxer->widget, resolved->action, state);
     }
-
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
-
-  if (group)
-    g_action_group_change_action_state (group->group, unprefixed_name, state);
-  else if (muxer->parent)
-    gtk_action_muxer_change_action_state (muxer->parent, action_name, state);
 }
 
 static void
@@ -1033,6 +1161,7 @@ gtk_action_muxer_finalize (GObject *object)
     }
   if (muxer->groups)
     g_hash_table_unref (muxer->groups);
+  g_clear_pointer (&muxer->resolved_actions, g_hash_table_unref);
 
   gtk_accels_clear (&muxer->primary_accels);
 
@@ -1050,6 +1179,10 @@ gtk_action_muxer_dispose (GObject *object)
   if (muxer->observed_actions)
     g_hash_table_remove_all (muxer->observed_actions);
 
+  g_clear_handle_id (&muxer->pending_enabled_id, g_source_remove);
+  g_clear_pointer (&muxer->pending_enabled, g_hash_table_unref);
+  gtk_action_muxer_invalidate_resolved ();
+
   muxer->widget = NULL;
 
   G_OBJECT_CLASS (gtk_action_muxer_parent_class)->dispose (object);
@@ -1150,7 +1283,8 @@ gtk_action_muxer_observer_action_enabled_changed (GtkActionObserver   *observer,
                                                   const char          *action_name,
                                                   gboolean             enabled)
 {
-  gtk_action_muxer_action_enabled_changed (GTK_ACTION_MUXER (observer), action_name, enabled);
+  /* Already batched by the muxer we got this from */
+  gtk_action_muxer_notify_enabled_changed (GTK_ACTION_MUXER (observer), action_name, enabled);
 }
 
 static void
@@ -1248,6 +1382,7 @@ gtk_action_muxer_insert (GtkActionMuxer *muxer,
   group->prefix = g_strdup (prefix);
 
   g_hash_table_insert (muxer->groups, group->prefix, group);
+  gtk_action_muxer_invalidate_resolved ();
 
   actions = g_action_group_list_actions (group->group);
   for (i = 0; actions[i]; i++)
@@ -1291,6 +1426,7 @@ gtk_action_muxer_remove (GtkActionMuxer *muxer,
       int i;
 
       g_hash_table_steal (muxer->groups, prefix);
+      gtk_action_muxer_invalidate_resolved ();
 
       actions = g_action_group_list_actions (group->group);
       for (i = 0; actions[i]; i++)
@@ -1353,6 +1489,7 @@ gtk_action_muxer_set_parent (GtkActionMuxer *muxer,
     }
 
   muxer->parent = parent;
+  gtk_action_muxer_invalidate_resolved ();
 
   if (muxer->parent != NULL)
     {
@@ -38,6 +38,7 @@
 #include "gtkaccessiblevalueprivate.h"
 #include "gtkaccessibleprivate.h"
 #include "gtkdebug.h"
+#include "gdkprofilerprivate.h"
 #include "gtktestatcontextprivate.h"
 #include "gtktypebuiltins.h"
 
@@ -67,11 +68,23 @@ static GParamSpec *obj_props[N_PROPS];
 
 static guint obj_signals[LAST_SIGNAL];
 
+/* Contexts with changes that haven't been sent to the AT yet */
+static GQueue pending_contexts = G_QUEUE_INIT;
+static guint flush_source_id;
+
+static guint emitted_changes;
+static guint coalesced_changes;
+static guint emitted_changes_counter;
+static guint coalesced_changes_counter;
+
 static void
 gtk_at_context_finalize (GObject *gobject)
 {
   GtkATContext *self = GTK_AT_CONTEXT (gobject);
 
+  if (self->queued)
+    g_queue_remove (&pending_contexts, self);
+
   gtk_accessible_attribute_set_unref (self->properties);
   gtk_accessible_attribute_set_unref (self->relations);
   gtk_accessible_attribute_set_unref (self->states);
@@ -511,12 +524,102 @@ gtk_at_context_create (GtkAccessibleRole  accessible_role,
   return res;
 }
 
+static void
+gtk_at_context_flush (GtkATContext *self)
+{
+  if (self->pending_states)
+    {
+      GtkAccessibleStateChange changed_states = self->updated_states;
+      GtkAccessiblePropertyChange changed_properties = self->updated_properties;
+      GtkAccessibleRelationChange changed_relations = self->updated_relations;
+
+      self->pending_states = FALSE;
+      self->updated_properties = 0;
+      self->updated_relations = 0;
+      self->updated_states = 0;
+
+      GTK_AT_CONTEXT_GET_CLASS (self)->state_change (self,
+                                                     changed_states, changed_properties, changed_relations,
+                                                     self->states, self->properties, self->relations);
+      g_signal_emit (self, obj_signals[STATE_CHANGE], 0);
+      emitted_changes++;
+    }
+
+  if (self->pending_bounds)
+    {
+      self->pending_bounds = FALSE;
+
+      GTK_AT_CONTEXT_GET_CLASS (self)->bounds_change (self);
+      emitted_changes++;
+    }
+}
+
+static gboolean
+gtk_at_context_flush_pending (gpointer data)
+{
+  GtkATContext *self;
+
+  flush_source_id = 0;
+
+  /* Flushing may queue more changes, those are sent right away too */
+  while ((self = g_queue_pop_head (&pending_contexts)))
+    {
+      self->queued = FALSE;
+
+      g_object_ref (self);
+      gtk_at_context_flush (self);
+      g_object_unref (self);
+    }
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (emitted_changes_counter == 0)
+        {
+          emitted_changes_counter = gdk_profiler_define_int_counter ("a11y-changes", "Accessibility Changes Emitted");
+          coalesced_changes_counter = gdk_profiler_define_int_counter ("a11y-coalesced-changes", "Accessibility Changes Coalesced");
+        }
+
+      gdk_profiler_set_int_counter (emitted_changes_counter, emitted_changes);
+      gdk_profiler_set_int_counter (coalesced_changes_counter, coalesced_changes);
+    }
+
+  emitted_changes = 0;
+  coalesced_changes = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Changes are collected per context and sent once layout and drawing
+ * for the frame are done, so that a widget changing a lot of state,
+ * or moving around a lot, only talks to the AT once.
+ */
+static void
+gtk_at_context_queue_flush (GtkATContext *self)
+{
+  if (!self->queued)
+    {
+      self->queued = TRUE;
+      g_queue_push_tail (&pending_contexts, self);
+    }
+
+  if (flush_source_id == 0)
+    {
+      flush_source_id = g_idle_add_full (GDK_PRIORITY_REDRAW + 10,
+                                         gtk_at_context_flush_pending,
+                                         NULL, NULL);
+      g_source_set_name_by_id (flush_source_id, "[gtk] gtk_at_context_flush_pending");
+    }
+}
+
 /*< private >
  * gtk_at_context_update:
  * @self: a #GtkATContext
  *
  * Notifies the AT connected to this #GtkATContext that the accessible
  * state and its properties have changed.
+ *
+ * The notification is sent after the current frame, together with
+ * any other changes made to @self until then.
  */
 void
 gtk_at_context_update (GtkATContext *self)
@@ -529,21 +632,11 @@ gtk_at_context_update (GtkATContext *self)
       self->updated_states == 0)
     return;
 
-  GtkAccessibleStateChange changed_states =
-    gtk_accessible_attribute_set_get_changed (self->states);
-  GtkAccessiblePropertyChange changed_properties =
-    gtk_accessible_attribute_set_get_changed (self->properties);
-  GtkAccessibleRelationChange changed_relations =
-    gtk_accessible_attribute_set_get_changed (self->relations);
+  if (self->pending_states)
+    coalesced_changes++;
 
-  GTK_AT_CONTEXT_GET_CLASS (self)->state_change (self,
-                                                 changed_states, changed_properties, changed_relations,
-                                                 self->states, self->properties, self->relations);
-  g_signal_emit (self, obj_signals[STATE_CHANGE], 0);
-
-  self->updated_properties = 0;
-  self->updated_relations = 0;
-  self->updated_states = 0;
+  self->pending_states = TRUE;
+  gtk_at_context_queue_flush (self);
 }
 
 /*< private >
@@ -985,7 +1078,11 @@ gtk_at_context_platform_changed (GtkATContext                *self,
 void
 gtk_at_context_bounds_changed (GtkATContext *self)
 {
-  GTK_AT_CONTEXT_GET_CLASS (self)->bounds_change (self);
+  if (self->pending_bounds)
+    coalesced_changes++;
+
+  self->pending_bounds = TRUE;
+  gtk_at_context_queue_flush (self);
 }
 
 void
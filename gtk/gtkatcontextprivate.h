@@ -116,6 +116,10 @@ struct _GtkATContext
   GtkAccessiblePropertyChange updated_properties;
   GtkAccessibleRelationChange updated_relations;
   GtkAccessiblePlatformChange updated_platform;
+
+  guint queued         : 1;
+  guint pending_states : 1;
+  guint pending_bounds : 1;
 };
 
 struct _GtkATContextClass
@@ -61,6 +61,38 @@ G_DEFINE_BOXED_TYPE (GtkBitset, gtk_bitset,
                      gtk_bitset_ref,
                      gtk_bitset_unref)
 
+/* Ranges at least this large are turned into run containers after
+ * adding them. This is the size where an array container becomes a
+ * bitset, and a run container is a lot smaller than either. */
+#define GTK_BITSET_MIN_RUN_OPTIMIZE_RANGE 4096
+
+/* Like roaring_bitmap_run_optimize(), but only looks at the containers
+ * that include [@first, @last], so bulk additions don't touch the whole set.
+ */
+static void
+gtk_bitset_run_optimize_range (GtkBitset *self,
+                               guint      first,
+                               guint      last)
+{
+  roaring_array_t *ra = &self->roaring.high_low_container;
+  int32_t i;
+
+  i = ra_get_index (ra, first >> 16);
+  if (i < 0)
+    i = -i - 1;
+
+  for (; i < ra->size && ra->keys[i] <= (last >> 16); i++)
+    {
+      uint8_t typecode_original, typecode_after;
+      void *c, *c1;
+
+      ra_unshare_container_at_index (ra, i);
+      c = ra_get_container_at_index (ra, i, &typecode_original);
+      c1 = convert_run_optimize (c, typecode_original, &typecode_after);
+      ra_set_container_at_index (ra, i, c1, typecode_after);
+    }
+}
+
 /**
  * gtk_bitset_ref:
  * @self: (allow-none): a #GtkBitset
@@ -327,6 +359,69 @@ gtk_bitset_copy (const GtkBitset *self)
   return copy;
 }
 
+/**
+ * gtk_bitset_new_from_bytes:
+ * @bytes: data created with gtk_bitset_serialize()
+ *
+ * Creates a bitset from data previously created with
+ * gtk_bitset_serialize().
+ *
+ * If @bytes does not contain a valid bitset, %NULL is returned.
+ *
+ * Returns: (nullable): A new bitset or %NULL
+ **/
+GtkBitset *
+gtk_bitset_new_from_bytes (GBytes *bytes)
+{
+  roaring_bitmap_t *roaring;
+  GtkBitset *self;
+  gconstpointer data;
+  gsize size;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  data = g_bytes_get_data (bytes, &size);
+  roaring = roaring_bitmap_portable_deserialize_safe (data, size);
+  if (roaring == NULL)
+    return NULL;
+
+  self = g_slice_new0 (GtkBitset);
+  self->ref_count = 1;
+  /* take over the containers */
+  self->roaring = *roaring;
+  free (roaring);
+
+  return self;
+}
+
+/**
+ * gtk_bitset_serialize:
+ * @self: a #GtkBitset
+ *
+ * Serializes @self into a compact binary representation that can be
+ * stored or sent to other processes, and turned back into a bitset
+ * with gtk_bitset_new_from_bytes().
+ *
+ * The data uses the portable format of roaring bitmaps, so it does
+ * not depend on the endianness or word size of the machine.
+ *
+ * Returns: (transfer full): a #GBytes with the serialized bitset
+ **/
+GBytes *
+gtk_bitset_serialize (const GtkBitset *self)
+{
+  char *data;
+  gsize size;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  size = roaring_bitmap_portable_size_in_bytes (&self->roaring);
+  data = g_malloc (size);
+  size = roaring_bitmap_portable_serialize (&self->roaring, data);
+
+  return g_bytes_new_take (data, size);
+}
+
 /**
  * gtk_bitset_remove_all:
  * @self: a #GtkBitset
@@ -402,6 +497,9 @@ gtk_bitset_add_range (GtkBitset *self,
   g_return_if_fail (start + n_items == 0 || start + n_items > start);
 
   roaring_bitmap_add_range_closed (&self->roaring, start, start + n_items - 1);
+
+  if (n_items >= GTK_BITSET_MIN_RUN_OPTIMIZE_RANGE)
+    gtk_bitset_run_optimize_range (self, start, start + n_items - 1);
 }
 
 /**
@@ -447,6 +545,9 @@ gtk_bitset_add_range_closed (GtkBitset *self,
   g_return_if_fail (first <= last);
 
   roaring_bitmap_add_range_closed (&self->roaring, first, last);
+
+  if (last - first >= GTK_BITSET_MIN_RUN_OPTIMIZE_RANGE - 1)
+    gtk_bitset_run_optimize_range (self, first, last);
 }
 
 /**
@@ -68,6 +68,10 @@ GtkBitset *             gtk_bitset_copy                         (const GtkBitset
 GDK_AVAILABLE_IN_ALL
 GtkBitset *             gtk_bitset_new_range                    (guint                   start,
                                                                  guint                   n_items);
+GDK_AVAILABLE_IN_ALL
+GtkBitset *             gtk_bitset_new_from_bytes               (GBytes                 *bytes);
+GDK_AVAILABLE_IN_ALL
+GBytes *                gtk_bitset_serialize                    (const GtkBitset        *self);
 
 GDK_AVAILABLE_IN_ALL
 void                    gtk_bitset_remove_all                   (GtkBitset              *self);
@@ -278,6 +278,7 @@ gtk_box_class_init (GtkBoxClass *class)
 
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BOX_LAYOUT);
   gtk_widget_class_set_css_name (widget_class, I_("box"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
 }
 static void
 gtk_box_init (GtkBox *box)
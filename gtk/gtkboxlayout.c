@@ -212,6 +212,7 @@ gtk_box_layout_compute_size (GtkBoxLayout *self,
   int required_min = 0, required_nat = 0;
   int largest_min = 0, largest_nat = 0;
   int spacing = get_spacing (self, gtk_widget_get_css_node (widget));
+  GtkMeasureShare share = { NULL, };
 
   for (child = gtk_widget_get_first_child (widget);
        child != NULL;
@@ -223,10 +224,10 @@ gtk_box_layout_compute_size (GtkBoxLayout *self,
       if (!gtk_widget_should_layout (child))
         continue;
 
-      gtk_widget_measure (child, self->orientation,
-                          for_size,
-                          &child_min, &child_nat,
-                          NULL, NULL);
+      gtk_widget_measure_shared (child, self->orientation,
+                                 for_size, &share,
+                                 &child_min, &child_nat,
+                                 NULL, NULL);
 
       largest_min = MAX (largest_min, child_min);
       largest_nat = MAX (largest_nat, child_nat);
@@ -277,6 +278,7 @@ gtk_box_layout_compute_opposite_size (GtkBoxLayout *self,
   int n_extra_widgets = 0;
   int spacing;
   gboolean have_baseline;
+  GtkMeasureShare share = { NULL, };
 
   count_expand_children (widget, self->orientation, &nvis_children, &nexpand_children);
 
@@ -295,11 +297,11 @@ gtk_box_layout_compute_opposite_size (GtkBoxLayout *self,
       if (!gtk_widget_should_layout (child))
         continue;
 
-      gtk_widget_measure (child,
-                          self->orientation,
-                          -1,
-                          &sizes[i].minimum_size, &sizes[i].natural_size,
-                          NULL, NULL);
+      gtk_widget_measure_shared (child,
+                                 self->orientation,
+                                 -1, &share,
+                                 &sizes[i].minimum_size, &sizes[i].natural_size,
+                                 NULL, NULL);
 
       children_minimum_size += sizes[i].minimum_size;
       i += 1;
@@ -336,6 +338,7 @@ gtk_box_layout_compute_opposite_size (GtkBoxLayout *self,
     }
 
   have_baseline = FALSE;
+  share = (GtkMeasureShare) { NULL, };
   for (i = 0, child = _gtk_widget_get_first_child (widget);
        child != NULL;
        child = _gtk_widget_get_next_sibling (child))
@@ -372,11 +375,11 @@ gtk_box_layout_compute_opposite_size (GtkBoxLayout *self,
 
       child_minimum_baseline = child_natural_baseline = -1;
       /* Assign the child's position. */
-      gtk_widget_measure (child,
-                          OPPOSITE_ORIENTATION (self->orientation),
-                          child_size,
-                          &child_minimum, &child_natural,
-                          &child_minimum_baseline, &child_natural_baseline);
+      gtk_widget_measure_shared (child,
+                                 OPPOSITE_ORIENTATION (self->orientation),
+                                 child_size, &share,
+                                 &child_minimum, &child_natural,
+                                 &child_minimum_baseline, &child_natural_baseline);
 
       if (child_minimum_baseline >= 0)
         {
@@ -473,6 +476,7 @@ gtk_box_layout_allocate (GtkLayoutManager *layout_manager,
   int x = 0, y = 0, i;
   int child_size;
   int spacing;
+  GtkMeasureShare share = { NULL, };
 
   count_expand_children (widget, self->orientation, &nvis_children, &nexpand_children);
 
@@ -501,11 +505,12 @@ gtk_box_layout_allocate (GtkLayoutManager *layout_manager,
       if (!gtk_widget_should_layout (child))
         continue;
 
-      gtk_widget_measure (child,
-                          self->orientation,
-                          self->orientation == GTK_ORIENTATION_HORIZONTAL ? height : width,
-                          &sizes[i].minimum_size, &sizes[i].natural_size,
-                          NULL, NULL);
+      gtk_widget_measure_shared (child,
+                                 self->orientation,
+                                 self->orientation == GTK_ORIENTATION_HORIZONTAL ? height : width,
+                                 &share,
+                                 &sizes[i].minimum_size, &sizes[i].natural_size,
+                                 NULL, NULL);
 
       children_minimum_size += sizes[i].minimum_size;
 
@@ -119,6 +119,14 @@
  * to this rule is that an object has to be constructed before it can
  * be used as the value of a construct-only property.
  *
+ * An `<object>` inside a `<child>` element can be marked with the
+ * “lazy” attribute, to defer constructing it and its children until
+ * it is retrieved with gtk_builder_get_object(), or with
+ * gtk_widget_get_template_child() in templates. It is then added to
+ * its parent. This is useful for parts of a large UI that are rarely
+ * shown, like popovers. Lazy objects need an id, and other objects
+ * cannot refer to them or their children.
+ *
  * It is also possible to bind a property value to another object's
  * property value using the attributes
  * "bind-source" to specify the source object of the binding, and
@@ -226,6 +234,8 @@
 
 
 static void gtk_builder_finalize       (GObject         *object);
+static GObject *gtk_builder_create_lazy_object (GtkBuilder *builder,
+                                                const char *name);
 static void gtk_builder_set_property   (GObject         *object,
                                         guint            prop_id,
                                         const GValue    *value,
@@ -267,8 +277,18 @@ typedef struct
   GType template_type;
   GObject *current_object;
   GtkBuilderScope *scope;
+  GtkBuilderPrecompiled *precompiled;
+  GHashTable *lazy_objects; /* id → GtkBuilderLazyObject */
 } GtkBuilderPrivate;
 
+struct _GtkBuilderLazyObject
+{
+  char *parent_id;
+  char *prev_id; /* the child before this one, or %NULL if it is the first */
+  char *type;
+  GBytes *bytes;
+};
+
 G_DEFINE_TYPE_WITH_PRIVATE (GtkBuilder, gtk_builder, G_TYPE_OBJECT)
 
 static void
@@ -375,6 +395,7 @@ gtk_builder_finalize (GObject *object)
 #endif
 
   g_hash_table_destroy (priv->objects);
+  g_clear_pointer (&priv->lazy_objects, g_hash_table_unref);
 
   g_slist_free_full (priv->signals, (GDestroyNotify)_free_signal_info);
 
@@ -963,6 +984,33 @@ _gtk_builder_apply_properties (GtkBuilder  *builder,
   object_properties_destroy (&parameters);
 }
 
+static void
+gtk_builder_add_to_parent (GtkBuilder *builder,
+                           GObject    *parent,
+                           GObject    *object,
+                           const char *type)
+{
+  GTK_NOTE (BUILDER,
+            g_message ("adding %s to %s", object_get_id (object), object_get_id (parent)));
+
+  if (G_IS_LIST_STORE (parent))
+    {
+      if (type != NULL)
+        {
+          GTK_BUILDER_WARN_INVALID_CHILD_TYPE (parent, type);
+        }
+      else
+        {
+          g_list_store_append (G_LIST_STORE (parent), object);
+        }
+    }
+  else
+    {
+      g_assert (GTK_IS_BUILDABLE (parent));
+      gtk_buildable_add_child (GTK_BUILDABLE (parent), builder, object, type);
+    }
+}
+
 void
 _gtk_builder_add (GtkBuilder *builder,
                   ChildInfo  *child_info)
@@ -992,26 +1040,7 @@ _gtk_builder_add (GtkBuilder *builder,
 
   parent = ((ObjectInfo*)child_info->parent)->object;
 
-  GTK_NOTE (BUILDER,
-            g_message ("adding %s to %s", object_get_id (object), object_get_id (parent)));
-
-  if (G_IS_LIST_STORE (parent))
-    {
-      if (child_info->type != NULL)
-        {
-          GTK_BUILDER_WARN_INVALID_CHILD_TYPE (parent, child_info->type);
-        }
-      else
-        {
-          g_list_store_append (G_LIST_STORE (parent), object);
-        }
-    }
-  else
-    {
-      g_assert (GTK_IS_BUILDABLE (parent));
-      gtk_buildable_add_child (GTK_BUILDABLE (parent), builder, object,
-                               child_info->type);
-    }
+  gtk_builder_add_to_parent (builder, parent, object, child_info->type);
 
   child_info->added = TRUE;
 }
@@ -1358,6 +1387,131 @@ gtk_builder_extend_with_template (GtkBuilder   *builder,
   return TRUE;
 }
 
+typedef struct
+{
+  GBytes *source;
+  GtkBuilderPrecompiled *precompiled;
+} PrecompiledResource;
+
+G_LOCK_DEFINE_STATIC (precompiled_resources);
+static GHashTable *precompiled_resources; /* resource path → PrecompiledResource */
+
+static void
+precompiled_resource_free (PrecompiledResource *resource)
+{
+  g_bytes_unref (resource->source);
+  _gtk_builder_precompiled_free (resource->precompiled);
+  g_slice_free (PrecompiledResource, resource);
+}
+
+/* UI resources are usually loaded many times, so we precompile them
+ * on first use and keep the result, along with the names resolved
+ * while replaying it. Entries are never freed, since other builders
+ * may be replaying them. If a resource was replaced, it is parsed
+ * from the source again.
+ */
+static GtkBuilderPrecompiled *
+gtk_builder_lookup_precompiled_resource (const char *resource_path,
+                                         GBytes     *data)
+{
+  PrecompiledResource *resource;
+  GtkBuilderPrecompiled *precompiled;
+  GBytes *bytes;
+
+  G_LOCK (precompiled_resources);
+
+  if (precompiled_resources == NULL)
+    precompiled_resources = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free, (GDestroyNotify) precompiled_resource_free);
+
+  resource = g_hash_table_lookup (precompiled_resources, resource_path);
+  if (resource)
+    {
+      if (g_bytes_get_data (resource->source, NULL) == g_bytes_get_data (data, NULL))
+        precompiled = resource->precompiled;
+      else
+        precompiled = NULL;
+
+      G_UNLOCK (precompiled_resources);
+      return precompiled;
+    }
+
+  if (_gtk_buildable_parser_is_precompiled (g_bytes_get_data (data, NULL), g_bytes_get_size (data)))
+    bytes = g_bytes_ref (data);
+  else
+    bytes = _gtk_buildable_parser_precompile (g_bytes_get_data (data, NULL),
+                                              g_bytes_get_size (data),
+                                              NULL);
+
+  /* Let the regular parser report errors */
+  if (bytes == NULL)
+    {
+      G_UNLOCK (precompiled_resources);
+      return NULL;
+    }
+
+  resource = g_slice_new (PrecompiledResource);
+  resource->source = g_bytes_ref (data);
+  resource->precompiled = _gtk_builder_precompiled_new (bytes);
+  g_bytes_unref (bytes);
+
+  g_hash_table_insert (precompiled_resources, g_strdup (resource_path), resource);
+  precompiled = resource->precompiled;
+
+  G_UNLOCK (precompiled_resources);
+
+  return precompiled;
+}
+
+static void
+gtk_builder_parse_resource (GtkBuilder             *builder,
+                            const char             *resource_path,
+                            GBytes                 *data,
+                            GtkBuilderPrecompiled  *precompiled,
+                            GError                **error)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  char *filename_for_errors;
+  char *slash;
+
+  g_free (priv->filename);
+  g_free (priv->resource_prefix);
+  priv->filename = g_strdup (".");
+
+  slash = strrchr (resource_path, '/');
+  if (slash != NULL)
+    priv->resource_prefix = g_strndup (resource_path, slash - resource_path + 1);
+  else
+    priv->resource_prefix = g_strdup ("/");
+
+  filename_for_errors = g_strconcat ("<resource>", resource_path, NULL);
+
+  if (precompiled)
+    {
+      GBytes *bytes = _gtk_builder_precompiled_get_bytes (precompiled);
+
+      /* Names only resolve the same way for the default scope */
+      if (G_OBJECT_TYPE (gtk_builder_get_scope (builder)) == GTK_TYPE_BUILDER_CSCOPE)
+        priv->precompiled = precompiled;
+
+      _gtk_builder_parser_parse_buffer (builder, filename_for_errors,
+                                        g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes),
+                                        NULL,
+                                        error);
+
+      priv->precompiled = NULL;
+    }
+  else
+    {
+      _gtk_builder_parser_parse_buffer (builder, filename_for_errors,
+                                        g_bytes_get_data (data, NULL), g_bytes_get_size (data),
+                                        NULL,
+                                        error);
+    }
+
+  g_free (filename_for_errors);
+}
+
 /**
  * gtk_builder_add_from_resource:
  * @builder: a #GtkBuilder
@@ -1384,11 +1538,9 @@ gtk_builder_add_from_resource (GtkBuilder   *builder,
                                const char   *resource_path,
                                GError      **error)
 {
-  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  GtkBuilderPrecompiled *precompiled;
   GError *tmp_error;
   GBytes *data;
-  char *filename_for_errors;
-  char *slash;
 
   g_return_val_if_fail (GTK_IS_BUILDER (builder), 0);
   g_return_val_if_fail (resource_path != NULL, 0);
@@ -1403,24 +1555,10 @@ gtk_builder_add_from_resource (GtkBuilder   *builder,
       return 0;
     }
 
-  g_free (priv->filename);
-  g_free (priv->resource_prefix);
-  priv->filename = g_strdup (".");
-
-  slash = strrchr (resource_path, '/');
-  if (slash != NULL)
-    priv->resource_prefix = g_strndup (resource_path, slash - resource_path + 1);
-  else
-    priv->resource_prefix = g_strdup ("/");
+  precompiled = gtk_builder_lookup_precompiled_resource (resource_path, data);
 
-  filename_for_errors = g_strconcat ("<resource>", resource_path, NULL);
+  gtk_builder_parse_resource (builder, resource_path, data, precompiled, &tmp_error);
 
-  _gtk_builder_parser_parse_buffer (builder, filename_for_errors,
-                                    g_bytes_get_data (data, NULL), g_bytes_get_size (data),
-                                    NULL,
-                                    &tmp_error);
-
-  g_free (filename_for_errors);
   g_bytes_unref (data);
 
   if (tmp_error != NULL)
@@ -1432,6 +1570,265 @@ gtk_builder_add_from_resource (GtkBuilder   *builder,
   return TRUE;
 }
 
+/* Loading happens in two steps: the worker reads the data and turns it
+ * into the precompiled format, which also checks that it is well-formed.
+ * Objects are created when the precompiled data is replayed on the
+ * thread that started the load, since they are not thread-safe.
+ */
+typedef struct {
+  char *filename;
+  char *resource_path;
+  GBytes *data;
+  GBytes *precompiled_bytes;             /* for files */
+  GtkBuilderPrecompiled *precompiled;    /* for resources, owned by the cache */
+} BuilderLoad;
+
+static void
+builder_load_free (BuilderLoad *load)
+{
+  g_free (load->filename);
+  g_free (load->resource_path);
+  g_clear_pointer (&load->data, g_bytes_unref);
+  g_clear_pointer (&load->precompiled_bytes, g_bytes_unref);
+  g_slice_free (BuilderLoad, load);
+}
+
+static void
+builder_load_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancellable)
+{
+  BuilderLoad *load = task_data;
+  GError *error = NULL;
+
+  if (load->resource_path)
+    {
+      load->data = g_resources_lookup_data (load->resource_path, 0, &error);
+      if (load->data == NULL)
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+
+      load->precompiled = gtk_builder_lookup_precompiled_resource (load->resource_path, load->data);
+    }
+  else
+    {
+      char *buffer;
+      gsize length;
+
+      if (!g_file_get_contents (load->filename, &buffer, &length, &error))
+        {
+          g_task_return_error (task, error);
+          return;
+        }
+
+      load->data = g_bytes_new_take (buffer, length);
+
+      /* Let the regular parser report errors */
+      if (!_gtk_buildable_parser_is_precompiled (buffer, length))
+        load->precompiled_bytes = _gtk_buildable_parser_precompile (buffer, length, NULL);
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+builder_load_done (GObject      *source,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  GtkBuilder *builder = GTK_BUILDER (source);
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  GTask *task = user_data;
+  BuilderLoad *load = g_task_get_task_data (G_TASK (result));
+  GError *error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return;
+    }
+
+  if (load->resource_path)
+    {
+      gtk_builder_parse_resource (builder, load->resource_path, load->data, load->precompiled, &error);
+    }
+  else
+    {
+      GBytes *bytes = load->precompiled_bytes ? load->precompiled_bytes : load->data;
+
+      g_free (priv->filename);
+      g_free (priv->resource_prefix);
+      priv->filename = g_strdup (load->filename);
+      priv->resource_prefix = NULL;
+
+      _gtk_builder_parser_parse_buffer (builder, load->filename,
+                                        g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes),
+                                        NULL,
+                                        &error);
+    }
+
+  if (error)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+
+  g_object_unref (task);
+}
+
+static void
+gtk_builder_load_async (GtkBuilder          *builder,
+                        BuilderLoad         *load,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data,
+                        gpointer             source_tag)
+{
+  GTask *task, *load_task;
+
+  task = g_task_new (builder, cancellable, callback, user_data);
+  g_task_set_source_tag (task, source_tag);
+
+  load_task = g_task_new (builder, cancellable, builder_load_done, task);
+  g_task_set_source_tag (load_task, gtk_builder_load_async);
+  g_task_set_task_data (load_task, load, (GDestroyNotify) builder_load_free);
+  g_task_run_in_thread (load_task, builder_load_thread);
+  g_object_unref (load_task);
+}
+
+/**
+ * gtk_builder_add_from_file_async:
+ * @builder: a #GtkBuilder
+ * @filename: the name of the file to parse
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): callback to call when the file has been added
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Asynchronously parses a file containing a [GtkBuilder UI definition][BUILDER-UI]
+ * and merges it with the current contents of @builder.
+ *
+ * The file is read and parsed in a thread. The objects are created
+ * afterwards in the thread-default main context of the caller, so
+ * the builder must not be used from other threads in the meantime.
+ *
+ * When the operation is finished @callback will be called. You can then
+ * call gtk_builder_add_from_file_finish() to get the result.
+ */
+void
+gtk_builder_add_from_file_async (GtkBuilder          *builder,
+                                 const char          *filename,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+  BuilderLoad *load;
+
+  g_return_if_fail (GTK_IS_BUILDER (builder));
+  g_return_if_fail (filename != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load = g_slice_new0 (BuilderLoad);
+  load->filename = g_strdup (filename);
+
+  gtk_builder_load_async (builder, load, cancellable, callback, user_data,
+                          gtk_builder_add_from_file_async);
+}
+
+/**
+ * gtk_builder_add_from_file_finish:
+ * @builder: a #GtkBuilder
+ * @result: a #GAsyncResult
+ * @error: (allow-none): return location for an error, or %NULL
+ *
+ * Finishes an asynchronous load started with gtk_builder_add_from_file_async().
+ *
+ * See gtk_builder_add_from_file() for the possible errors.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurred
+ */
+gboolean
+gtk_builder_add_from_file_finish (GtkBuilder    *builder,
+                                  GAsyncResult  *result,
+                                  GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, builder), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gtk_builder_add_from_file_async, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/**
+ * gtk_builder_add_from_resource_async:
+ * @builder: a #GtkBuilder
+ * @resource_path: the path of the resource file to parse
+ * @cancellable: (nullable): optional #GCancellable object, %NULL to ignore
+ * @callback: (scope async): callback to call when the resource has been added
+ * @user_data: (closure): the data to pass to @callback
+ *
+ * Asynchronously parses a resource file containing a
+ * [GtkBuilder UI definition][BUILDER-UI] and merges it with the
+ * current contents of @builder.
+ *
+ * See gtk_builder_add_from_file_async() for how the work is split
+ * between threads.
+ *
+ * When the operation is finished @callback will be called. You can then
+ * call gtk_builder_add_from_resource_finish() to get the result.
+ */
+void
+gtk_builder_add_from_resource_async (GtkBuilder          *builder,
+                                     const char          *resource_path,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data)
+{
+  BuilderLoad *load;
+
+  g_return_if_fail (GTK_IS_BUILDER (builder));
+  g_return_if_fail (resource_path != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  load = g_slice_new0 (BuilderLoad);
+  load->resource_path = g_strdup (resource_path);
+
+  gtk_builder_load_async (builder, load, cancellable, callback, user_data,
+                          gtk_builder_add_from_resource_async);
+}
+
+/**
+ * gtk_builder_add_from_resource_finish:
+ * @builder: a #GtkBuilder
+ * @result: a #GAsyncResult
+ * @error: (allow-none): return location for an error, or %NULL
+ *
+ * Finishes an asynchronous load started with gtk_builder_add_from_resource_async().
+ *
+ * See gtk_builder_add_from_resource() for the possible errors.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurred
+ */
+gboolean
+gtk_builder_add_from_resource_finish (GtkBuilder    *builder,
+                                      GAsyncResult  *result,
+                                      GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, builder), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gtk_builder_add_from_resource_async, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 /**
  * gtk_builder_add_objects_from_resource:
  * @builder: a #GtkBuilder
@@ -1636,17 +2033,25 @@ gtk_builder_get_object (GtkBuilder  *builder,
 {
   GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
 
+  GObject *object;
+
   g_return_val_if_fail (GTK_IS_BUILDER (builder), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
-  return g_hash_table_lookup (priv->objects, name);
+  object = g_hash_table_lookup (priv->objects, name);
+  if (object == NULL && priv->lazy_objects != NULL)
+    object = gtk_builder_create_lazy_object (builder, name);
+
+  return object;
 }
 
 /**
  * gtk_builder_get_objects:
  * @builder: a #GtkBuilder
  *
- * Gets all objects that have been constructed by @builder. Note that
+ * Gets all objects that have been constructed by @builder. Objects
+ * marked as lazy that have not been looked up yet are not included.
+ * Note that
  * this function does not increment the reference counts of the returned
  * objects.
  *
@@ -2707,6 +3112,228 @@ _gtk_builder_get_template_type (GtkBuilder *builder)
   return priv->template_type;
 }
 
+/* @precompiled must stay alive while @builder parses it */
+void
+_gtk_builder_set_precompiled (GtkBuilder            *builder,
+                              GtkBuilderPrecompiled *precompiled)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  priv->precompiled = precompiled;
+}
+
+GtkBuilderPrecompiled *
+_gtk_builder_get_precompiled (GtkBuilder *builder)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  return priv->precompiled;
+}
+
+void
+_gtk_builder_lazy_object_free (GtkBuilderLazyObject *lazy)
+{
+  g_free (lazy->parent_id);
+  g_free (lazy->prev_id);
+  g_free (lazy->type);
+  g_bytes_unref (lazy->bytes);
+  g_slice_free (GtkBuilderLazyObject, lazy);
+}
+
+void
+_gtk_builder_take_lazy_object (GtkBuilder           *builder,
+                               const char           *id,
+                               GtkBuilderLazyObject *lazy)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  if (priv->lazy_objects == NULL)
+    priv->lazy_objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, (GDestroyNotify) _gtk_builder_lazy_object_free);
+
+  g_hash_table_insert (priv->lazy_objects, g_strdup (id), lazy);
+}
+
+/* @bytes is precompiled data for an interface holding just the object */
+void
+_gtk_builder_add_lazy_object (GtkBuilder *builder,
+                              const char *id,
+                              const char *parent_id,
+                              const char *prev_id,
+                              const char *type,
+                              GBytes     *bytes)
+{
+  GtkBuilderLazyObject *lazy;
+
+  lazy = g_slice_new (GtkBuilderLazyObject);
+  lazy->parent_id = g_strdup (parent_id);
+  lazy->prev_id = g_strdup (prev_id);
+  lazy->type = g_strdup (type);
+  lazy->bytes = g_bytes_ref (bytes);
+
+  _gtk_builder_take_lazy_object (builder, id, lazy);
+}
+
+gboolean
+_gtk_builder_has_lazy_object (GtkBuilder *builder,
+                              const char *id)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  return priv->lazy_objects != NULL &&
+         g_hash_table_contains (priv->lazy_objects, id);
+}
+
+/* Makes @lazy follow the siblings before it that are still lazy in
+ * @lazy_objects, for building it with a builder that does not know them
+ */
+void
+_gtk_builder_lazy_object_skip_siblings (GtkBuilderLazyObject *lazy,
+                                        GHashTable           *lazy_objects)
+{
+  GtkBuilderLazyObject *prev;
+
+  while (lazy->prev_id &&
+         (prev = g_hash_table_lookup (lazy_objects, lazy->prev_id)) != NULL)
+    {
+      g_free (lazy->prev_id);
+      lazy->prev_id = g_strdup (prev->prev_id);
+    }
+}
+
+/* Returns the lazy objects that have not been built, so they can
+ * outlive @builder, or %NULL if there are none
+ */
+GHashTable *
+_gtk_builder_steal_lazy_objects (GtkBuilder *builder)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  GHashTable *lazy_objects;
+
+  lazy_objects = g_steal_pointer (&priv->lazy_objects);
+  if (lazy_objects && g_hash_table_size (lazy_objects) == 0)
+    g_clear_pointer (&lazy_objects, g_hash_table_unref);
+
+  return lazy_objects;
+}
+
+/* Finds the built object that @lazy goes after, skipping siblings
+ * that are lazy too. Returns %FALSE if it is not known, and %TRUE
+ * with @prev set to %NULL if @lazy goes first.
+ */
+static gboolean
+gtk_builder_find_lazy_sibling (GtkBuilder            *builder,
+                               GtkBuilderLazyObject  *lazy,
+                               GObject              **prev)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  const char *id = lazy->prev_id;
+
+  while (id)
+    {
+      *prev = g_hash_table_lookup (priv->objects, id);
+      if (*prev)
+        return TRUE;
+
+      lazy = priv->lazy_objects ? g_hash_table_lookup (priv->lazy_objects, id) : NULL;
+      if (lazy == NULL)
+        return FALSE;
+
+      id = lazy->prev_id;
+    }
+
+  *prev = NULL;
+  return TRUE;
+}
+
+/* Moves @object, which was appended to @parent, to where it was declared */
+static void
+gtk_builder_reorder_lazy_object (GObject *parent,
+                                 GObject *object,
+                                 GObject *prev)
+{
+  if (GTK_IS_WIDGET (parent) && GTK_IS_WIDGET (object))
+    {
+      if (gtk_widget_get_parent (GTK_WIDGET (object)) != GTK_WIDGET (parent))
+        return;
+
+      if (prev && (!GTK_IS_WIDGET (prev) ||
+                   gtk_widget_get_parent (GTK_WIDGET (prev)) != GTK_WIDGET (parent)))
+        return;
+
+      gtk_widget_insert_after (GTK_WIDGET (object), GTK_WIDGET (parent), prev ? GTK_WIDGET (prev) : NULL);
+    }
+  else if (G_IS_LIST_STORE (parent))
+    {
+      GListStore *store = G_LIST_STORE (parent);
+      guint position, prev_position;
+
+      if (!g_list_store_find (store, object, &position))
+        return;
+
+      if (prev == NULL)
+        prev_position = G_MAXUINT;
+      else if (!g_list_store_find (store, prev, &prev_position))
+        return;
+
+      g_object_ref (object);
+      g_list_store_remove (store, position);
+      if (prev_position != G_MAXUINT && prev_position > position)
+        prev_position--;
+      g_list_store_insert (store, prev_position + 1, object);
+      g_object_unref (object);
+    }
+}
+
+static GObject *
+gtk_builder_create_lazy_object (GtkBuilder *builder,
+                                const char *name)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  GtkBuilderLazyObject *lazy;
+  GObject *object, *parent, *prev;
+  gboolean has_prev;
+  GError *error = NULL;
+  gpointer key;
+  char *filename;
+
+  if (!g_hash_table_steal_extended (priv->lazy_objects, name, &key, (gpointer *) &lazy))
+    return NULL;
+
+  g_free (key);
+
+  parent = gtk_builder_get_object (builder, lazy->parent_id);
+  has_prev = gtk_builder_find_lazy_sibling (builder, lazy, &prev);
+
+  filename = g_strconcat ("<lazy object ", name, ">", NULL);
+  _gtk_builder_parser_parse_buffer (builder, filename,
+                                    g_bytes_get_data (lazy->bytes, NULL),
+                                    g_bytes_get_size (lazy->bytes),
+                                    NULL,
+                                    &error);
+  g_free (filename);
+
+  if (error)
+    {
+      g_critical ("Failed to build lazy object '%s': %s", name, error->message);
+      g_error_free (error);
+      _gtk_builder_lazy_object_free (lazy);
+      return NULL;
+    }
+
+  object = g_hash_table_lookup (priv->objects, name);
+  if (object && parent)
+    {
+      gtk_builder_add_to_parent (builder, parent, object, lazy->type);
+      if (has_prev)
+        gtk_builder_reorder_lazy_object (parent, object, prev);
+    }
+
+  _gtk_builder_lazy_object_free (lazy);
+
+  return object;
+}
+
 /**
  * gtk_builder_create_closure:
  * @builder: a #GtkBuilder
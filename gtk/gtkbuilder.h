@@ -107,6 +107,26 @@ gboolean     gtk_builder_add_from_resource       (GtkBuilder    *builder,
                                                   const char    *resource_path,
                                                   GError       **error);
 GDK_AVAILABLE_IN_ALL
+void         gtk_builder_add_from_file_async     (GtkBuilder          *builder,
+                                                  const char          *filename,
+                                                  GCancellable        *cancellable,
+                                                  GAsyncReadyCallback  callback,
+                                                  gpointer             user_data);
+GDK_AVAILABLE_IN_ALL
+gboolean     gtk_builder_add_from_file_finish    (GtkBuilder    *builder,
+                                                  GAsyncResult  *result,
+                                                  GError       **error);
+GDK_AVAILABLE_IN_ALL
+void         gtk_builder_add_from_resource_async (GtkBuilder          *builder,
+                                                  const char          *resource_path,
+                                                  GCancellable        *cancellable,
+                                                  GAsyncReadyCallback  callback,
+                                                  gpointer             user_data);
+GDK_AVAILABLE_IN_ALL
+gboolean     gtk_builder_add_from_resource_finish (GtkBuilder    *builder,
+                                                  GAsyncResult  *result,
+                                                  GError       **error);
+GDK_AVAILABLE_IN_ALL
 gboolean     gtk_builder_add_from_string         (GtkBuilder    *builder,
                                                   const char    *buffer,
                                                   gssize         length,
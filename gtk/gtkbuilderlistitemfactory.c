@@ -63,6 +63,7 @@ struct _GtkBuilderListItemFactory
   GtkBuilderScope *scope;
   GBytes *bytes;
   GBytes *data;
+  GtkBuilderPrecompiled *precompiled;
   char *resource;
 };
 
@@ -100,6 +101,8 @@ gtk_builder_list_item_factory_setup (GtkListItemFactory *factory,
   gtk_builder_set_current_object (builder, G_OBJECT (list_item));
   if (self->scope)
     gtk_builder_set_scope (builder, self->scope);
+  if (self->precompiled)
+    _gtk_builder_set_precompiled (builder, self->precompiled);
 
   if (!gtk_builder_extend_with_template (builder, G_OBJECT (list_item), G_OBJECT_TYPE (list_item),
                                          (const char *)g_bytes_get_data (self->data, NULL),
@@ -182,6 +185,10 @@ gtk_builder_list_item_factory_set_bytes (GtkBuilderListItemFactory *self,
         }
     }
 
+  if (self->data &&
+      _gtk_buildable_parser_is_precompiled (g_bytes_get_data (self->data, NULL), g_bytes_get_size (self->data)))
+    self->precompiled = _gtk_builder_precompiled_new (self->data);
+
   return TRUE;
 }
 
@@ -242,6 +249,7 @@ gtk_builder_list_item_factory_finalize (GObject *object)
   g_clear_object (&self->scope);
   g_bytes_unref (self->bytes);
   g_bytes_unref (self->data);
+  g_clear_pointer (&self->precompiled, _gtk_builder_precompiled_free);
   g_free (self->resource);
 
   G_OBJECT_CLASS (gtk_builder_list_item_factory_parent_class)->finalize (object);
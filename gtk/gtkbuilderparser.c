@@ -544,6 +544,142 @@ is_requested_object (const char *object,
   return FALSE;
 }
 
+static void
+free_lazy_object_info (LazyObjectInfo *info)
+{
+  if (info->recorder)
+    _gtk_buildable_recorder_free (info->recorder);
+  g_free (info->id);
+  g_free (info->parent_id);
+  g_free (info->prev_id);
+  g_free (info->type);
+  g_slice_free (LazyObjectInfo, info);
+}
+
+/* Lazy objects are inserted after the child that preceded them */
+static void
+record_child_id (ObjectInfo *parent_info,
+                 const char *id)
+{
+  g_free (parent_info->last_child_id);
+  parent_info->last_child_id = g_strdup (id);
+}
+
+static gboolean
+state_is_lazy_object (ParserData *data)
+{
+  CommonInfo *info = state_peek_info (data, CommonInfo);
+
+  return info != NULL && info->tag_type == TAG_LAZY_OBJECT;
+}
+
+/* Lazy objects are not built while parsing. Everything up to the end
+ * of the object is recorded, and built when the object is looked up,
+ * see gtk_builder_get_object().
+ */
+static void
+parse_lazy_object (GtkBuildableParseContext  *context,
+                   ParserData                *data,
+                   ChildInfo                 *child_info,
+                   const char                *object_id,
+                   const char                *element_name,
+                   const char               **names,
+                   const char               **values,
+                   GError                   **error)
+{
+  LazyObjectInfo *lazy_info;
+  ObjectInfo *parent_info;
+  const char **object_names, **object_values;
+  int i, n;
+
+  if (child_info == NULL || child_info->tag_type != TAG_CHILD ||
+      child_info->internal_child != NULL)
+    {
+      error_invalid_tag (data, element_name, NULL, error);
+      return;
+    }
+
+  if (object_id == NULL)
+    {
+      error_missing_attribute (data, element_name, "id", error);
+      return;
+    }
+
+  lazy_info = g_slice_new0 (LazyObjectInfo);
+  lazy_info->tag_type = TAG_LAZY_OBJECT;
+  lazy_info->recorder = _gtk_buildable_recorder_new ();
+  lazy_info->id = g_strdup (object_id);
+  parent_info = (ObjectInfo *)child_info->parent;
+  lazy_info->parent_id = g_strdup (parent_info->id);
+  lazy_info->prev_id = g_strdup (parent_info->last_child_id);
+  lazy_info->type = g_strdup (child_info->type);
+  state_push (data, lazy_info);
+
+  /* Record a standalone interface with the object, minus the lazy flag */
+  if (data->domain)
+    {
+      const char *interface_names[] = { "domain", NULL };
+      const char *interface_values[] = { data->domain, NULL };
+
+      _gtk_buildable_recorder_start_element (lazy_info->recorder, "interface",
+                                             interface_names, interface_values);
+    }
+  else
+    {
+      const char *empty[] = { NULL };
+
+      _gtk_buildable_recorder_start_element (lazy_info->recorder, "interface", empty, empty);
+    }
+
+  n = g_strv_length ((char **)names);
+  object_names = g_newa (const char *, n + 1);
+  object_values = g_newa (const char *, n + 1);
+  for (i = 0, n = 0; names[i]; i++)
+    {
+      if (strcmp (names[i], "lazy") == 0)
+        continue;
+
+      object_names[n] = names[i];
+      object_values[n] = values[i];
+      n++;
+    }
+  object_names[n] = NULL;
+  object_values[n] = NULL;
+
+  _gtk_buildable_recorder_start_element (lazy_info->recorder, element_name,
+                                         object_names, object_values);
+
+  gtk_buildable_parse_context_push (context, &_gtk_buildable_recorder_parser, lazy_info->recorder);
+}
+
+static void
+end_lazy_object (GtkBuildableParseContext *context,
+                 ParserData               *data)
+{
+  LazyObjectInfo *lazy_info = state_pop_info (data, LazyObjectInfo);
+  ChildInfo *child_info = state_peek_info (data, ChildInfo);
+  GBytes *bytes;
+
+  gtk_buildable_parse_context_pop (context);
+
+  _gtk_buildable_recorder_end_element (lazy_info->recorder);
+  _gtk_buildable_recorder_end_element (lazy_info->recorder);
+  bytes = _gtk_buildable_recorder_free_to_bytes (lazy_info->recorder);
+  lazy_info->recorder = NULL;
+
+  _gtk_builder_add_lazy_object (data->builder,
+                                lazy_info->id,
+                                lazy_info->parent_id,
+                                lazy_info->prev_id,
+                                lazy_info->type,
+                                bytes);
+
+  record_child_id ((ObjectInfo *)child_info->parent, lazy_info->id);
+
+  g_bytes_unref (bytes);
+  free_lazy_object_info (lazy_info);
+}
+
 static void
 parse_object (GtkBuildableParseContext  *context,
               ParserData                *data,
@@ -560,6 +696,7 @@ parse_object (GtkBuildableParseContext  *context,
   const char *type_func = NULL;
   const char *object_id = NULL;
   char *internal_id = NULL;
+  gboolean lazy = FALSE;
   int line;
 
   child_info = state_peek_info (data, ChildInfo);
@@ -580,6 +717,7 @@ parse_object (GtkBuildableParseContext  *context,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "constructor", &constructor,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "type-func", &type_func,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "id", &object_id,
+                                    G_MARKUP_COLLECT_BOOLEAN|G_MARKUP_COLLECT_OPTIONAL, "lazy", &lazy,
                                     G_MARKUP_COLLECT_INVALID))
     {
       _gtk_builder_prefix_error (data->builder, &data->ctx, error);
@@ -592,6 +730,14 @@ parse_object (GtkBuildableParseContext  *context,
       return;
     }
 
+  /* Objects that are only partially requested are built right away */
+  if (lazy && data->requested_objects == NULL)
+    {
+      parse_lazy_object (context, data, child_info, object_id,
+                         element_name, names, values, error);
+      return;
+    }
+
   if (type_func)
     {
       /* Call the GType function, and return the GType, it's guaranteed afterwards
@@ -612,7 +758,7 @@ parse_object (GtkBuildableParseContext  *context,
     {
       g_assert_nonnull (object_class);
 
-      object_type = gtk_builder_get_type_from_name (data->builder, object_class);
+      object_type = _gtk_builder_precompiled_get_type_from_name (data->precompiled, data->builder, object_class);
       if (object_type == G_TYPE_INVALID)
         {
           g_set_error (error,
@@ -791,6 +937,7 @@ free_object_info (ObjectInfo *info)
   g_slist_free_full (info->properties, (GDestroyNotify)free_property_info);
   g_free (info->constructor);
   g_free (info->id);
+  g_free (info->last_child_id);
   g_slice_free (ObjectInfo, info);
 }
 
@@ -885,7 +1032,7 @@ parse_property (ParserData   *data,
       return;
     }
 
-  pspec = g_object_class_find_property (object_info->oclass, name);
+  pspec = _gtk_builder_precompiled_find_property (data->precompiled, object_info->oclass, name);
 
   if (!pspec)
     {
@@ -977,7 +1124,7 @@ parse_binding (ParserData   *data,
       return;
     }
 
-  pspec = g_object_class_find_property (object_info->oclass, name);
+  pspec = _gtk_builder_precompiled_find_property (data->precompiled, object_info->oclass, name);
 
   if (!pspec)
     {
@@ -1138,7 +1285,7 @@ parse_constant_expression (ParserData   *data,
     type = G_TYPE_INVALID;
   else
     {
-      type = gtk_builder_get_type_from_name (data->builder, type_name);
+      type = _gtk_builder_precompiled_get_type_from_name (data->precompiled, data->builder, type_name);
       if (type == G_TYPE_INVALID)
         {
           g_set_error (error,
@@ -1190,7 +1337,7 @@ parse_closure_expression (ParserData   *data,
       return;
     }
 
-  type = gtk_builder_get_type_from_name (data->builder, type_name);
+  type = _gtk_builder_precompiled_get_type_from_name (data->precompiled, data->builder, type_name);
   if (type == G_TYPE_INVALID)
     {
       g_set_error (error,
@@ -1254,7 +1401,7 @@ parse_lookup_expression (ParserData   *data,
     }
   else
     {
-      type = gtk_builder_get_type_from_name (data->builder, type_name);
+      type = _gtk_builder_precompiled_get_type_from_name (data->precompiled, data->builder, type_name);
       if (type == G_TYPE_INVALID)
         {
           g_set_error (error,
@@ -1902,6 +2049,11 @@ end_element (GtkBuildableParseContext  *context,
       else
         g_assert_not_reached ();
     }
+  else if (strcmp (element_name, "object") == 0 &&
+           state_is_lazy_object (data))
+    {
+      end_lazy_object (context, data);
+    }
   else if (strcmp (element_name, "object") == 0 ||
            strcmp (element_name, "template") == 0)
     {
@@ -1935,7 +2087,11 @@ end_element (GtkBuildableParseContext  *context,
           return;
         }
       if (child_info)
-        child_info->object = object_info->object;
+        {
+          child_info->object = object_info->object;
+          if (child_info->parent)
+            record_child_id ((ObjectInfo *)child_info->parent, object_info->id);
+        }
       if (prop_info)
         g_string_assign (prop_info->text, object_info->id);
 
@@ -2127,6 +2283,9 @@ free_info (CommonInfo *info)
       case TAG_CHILD:
         free_child_info ((ChildInfo *)info);
         break;
+      case TAG_LAZY_OBJECT:
+        free_lazy_object_info ((LazyObjectInfo *)info);
+        break;
       case TAG_BINDING:
         _free_binding_info ((BindingInfo *)info, NULL);
         break;
@@ -2184,6 +2343,11 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   data.object_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
                                            (GDestroyNotify)g_free, NULL);
 
+  data.precompiled = _gtk_builder_get_precompiled (builder);
+  if (data.precompiled &&
+      g_bytes_get_data (_gtk_builder_precompiled_get_bytes (data.precompiled), NULL) != (gconstpointer) buffer)
+    data.precompiled = NULL;
+
   if (requested_objs)
     {
       data.inside_requested_object = FALSE;
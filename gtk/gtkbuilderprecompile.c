@@ -111,11 +111,13 @@ record_data_string_lookup (GHashTable *strings, const char *str, gssize len)
   return s->string;
 }
 
-typedef struct {
+typedef struct _GtkBuildableRecorder RecordData;
+
+struct _GtkBuildableRecorder {
   GHashTable *strings;
   RecordDataTree *root;
   RecordDataTree *current;
-} RecordData;
+};
 
 static void
 record_start_element (GMarkupParseContext  *context,
@@ -302,35 +304,29 @@ marshal_tree (GString *marshaled,
  *
  * returns: A #GByte with the precompiled data
  **/
-GBytes *
-_gtk_buildable_parser_precompile (const char          *text,
-                                  gssize               text_len,
-                                  GError             **error)
+static void
+record_data_init (RecordData *data)
+{
+  data->strings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)record_data_string_free);
+  data->root = record_data_tree_new (NULL, RECORD_TYPE_ELEMENT, NULL);
+  data->current = data->root;
+}
+
+static void
+record_data_clear (RecordData *data)
+{
+  record_data_tree_free (data->root);
+  g_hash_table_destroy (data->strings);
+}
+
+static GBytes *
+record_data_marshal (RecordData *data)
 {
-  GMarkupParseContext *ctx;
-  RecordData data = { 0 };
   GList *string_table, *l;
   GString *marshaled;
   int offset;
 
-  data.strings = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify)record_data_string_free);
-  data.root = record_data_tree_new (NULL, RECORD_TYPE_ELEMENT, NULL);
-  data.current = data.root;
-
-  ctx = g_markup_parse_context_new (&record_parser, G_MARKUP_TREAT_CDATA_AS_TEXT,
-                                    &data, NULL);
-
-  if (!g_markup_parse_context_parse (ctx, text, text_len, error))
-    {
-      record_data_tree_free (data.root);
-      g_hash_table_destroy (data.strings);
-      g_markup_parse_context_free (ctx);
-      return NULL;
-    }
-
-  g_markup_parse_context_free (ctx);
-
-  string_table = g_hash_table_get_values (data.strings);
+  string_table = g_hash_table_get_values (data->strings);
 
   string_table = g_list_sort (string_table, compare_string);
 
@@ -355,14 +351,138 @@ _gtk_buildable_parser_precompile (const char          *text,
 
   g_list_free (string_table);
 
-  marshal_tree (marshaled, data.strings, data.root);
-
-  record_data_tree_free (data.root);
-  g_hash_table_destroy (data.strings);
+  marshal_tree (marshaled, data->strings, data->root);
 
   return g_string_free_to_bytes (marshaled);
 }
 
+GBytes *
+_gtk_buildable_parser_precompile (const char          *text,
+                                  gssize               text_len,
+                                  GError             **error)
+{
+  GMarkupParseContext *ctx;
+  RecordData data = { 0 };
+  GBytes *bytes;
+
+  record_data_init (&data);
+
+  ctx = g_markup_parse_context_new (&record_parser, G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                    &data, NULL);
+
+  if (!g_markup_parse_context_parse (ctx, text, text_len, error))
+    {
+      record_data_clear (&data);
+      g_markup_parse_context_free (ctx);
+      return NULL;
+    }
+
+  g_markup_parse_context_free (ctx);
+
+  bytes = record_data_marshal (&data);
+  record_data_clear (&data);
+
+  return bytes;
+}
+
+/*****************************************  Record a GtkBuildable parser call ***************************/
+
+/* Records the elements that a GtkBuildableParseContext feeds to a
+ * subparser, so they can be replayed later, see lazy objects in
+ * GtkBuilder.
+ */
+
+static void
+recorder_start_element (GtkBuildableParseContext  *context,
+                        const char                *element_name,
+                        const char               **names,
+                        const char               **values,
+                        gpointer                   user_data,
+                        GError                   **error)
+{
+  record_start_element (NULL, element_name, names, values, user_data, error);
+}
+
+static void
+recorder_end_element (GtkBuildableParseContext  *context,
+                      const char                *element_name,
+                      gpointer                   user_data,
+                      GError                   **error)
+{
+  record_end_element (NULL, element_name, user_data, error);
+}
+
+static void
+recorder_text (GtkBuildableParseContext  *context,
+               const char                *text,
+               gsize                      text_len,
+               gpointer                   user_data,
+               GError                   **error)
+{
+  record_text (NULL, text, text_len, user_data, error);
+}
+
+const GtkBuildableParser _gtk_buildable_recorder_parser =
+{
+  recorder_start_element,
+  recorder_end_element,
+  recorder_text,
+  NULL,
+};
+
+GtkBuildableRecorder *
+_gtk_buildable_recorder_new (void)
+{
+  GtkBuildableRecorder *recorder;
+
+  recorder = g_slice_new0 (GtkBuildableRecorder);
+  record_data_init (recorder);
+
+  return recorder;
+}
+
+void
+_gtk_buildable_recorder_free (GtkBuildableRecorder *recorder)
+{
+  record_data_clear (recorder);
+  g_slice_free (GtkBuildableRecorder, recorder);
+}
+
+void
+_gtk_buildable_recorder_start_element (GtkBuildableRecorder  *recorder,
+                                       const char            *element_name,
+                                       const char           **names,
+                                       const char           **values)
+{
+  record_start_element (NULL, element_name, names, values, recorder, NULL);
+}
+
+void
+_gtk_buildable_recorder_end_element (GtkBuildableRecorder *recorder)
+{
+  record_end_element (NULL, NULL, recorder, NULL);
+}
+
+/**
+ * _gtk_buildable_recorder_free_to_bytes:
+ * @recorder: a #GtkBuildableRecorder
+ *
+ * Frees @recorder and returns what it recorded, in the same
+ * format as _gtk_buildable_parser_precompile().
+ *
+ * Returns: A #GBytes with the precompiled data
+ */
+GBytes *
+_gtk_buildable_recorder_free_to_bytes (GtkBuildableRecorder *recorder)
+{
+  GBytes *bytes;
+
+  bytes = record_data_marshal (recorder);
+  _gtk_buildable_recorder_free (recorder);
+
+  return bytes;
+}
+
 /*****************************************  Replay GMarkup parser callbacks ***************************/
 
 static guint32
@@ -561,3 +681,155 @@ _gtk_buildable_parser_replay_precompiled (GtkBuildableParseContext *context,
 
   return TRUE;
 }
+
+/*****************************************  Resolve names in precompiled data ***************************/
+
+/* Strings in precompiled data are unique, so their address identifies
+ * them as long as the data is alive. For data that is replayed over and
+ * over, like templates, we remember what the type and property names
+ * resolved to, instead of looking them up for every object.
+ */
+struct _GtkBuilderPrecompiled
+{
+  GBytes *bytes;
+  const char *start;
+  const char *end;
+
+  GMutex lock;
+  GHashTable *types;  /* type name → GType */
+  GHashTable *pspecs; /* GType → (property name → GParamSpec) */
+};
+
+GtkBuilderPrecompiled *
+_gtk_builder_precompiled_new (GBytes *bytes)
+{
+  GtkBuilderPrecompiled *precompiled;
+  gsize size;
+
+  precompiled = g_slice_new0 (GtkBuilderPrecompiled);
+  precompiled->bytes = g_bytes_ref (bytes);
+  precompiled->start = g_bytes_get_data (bytes, &size);
+  precompiled->end = precompiled->start + size;
+
+  g_mutex_init (&precompiled->lock);
+  precompiled->types = g_hash_table_new (NULL, NULL);
+  precompiled->pspecs = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_hash_table_unref);
+
+  return precompiled;
+}
+
+void
+_gtk_builder_precompiled_free (GtkBuilderPrecompiled *precompiled)
+{
+  g_hash_table_unref (precompiled->types);
+  g_hash_table_unref (precompiled->pspecs);
+  g_mutex_clear (&precompiled->lock);
+  g_bytes_unref (precompiled->bytes);
+
+  g_slice_free (GtkBuilderPrecompiled, precompiled);
+}
+
+GBytes *
+_gtk_builder_precompiled_get_bytes (GtkBuilderPrecompiled *precompiled)
+{
+  return precompiled->bytes;
+}
+
+static gboolean
+gtk_builder_precompiled_owns (GtkBuilderPrecompiled *precompiled,
+                              const char            *string)
+{
+  return precompiled != NULL &&
+         string >= precompiled->start &&
+         string < precompiled->end;
+}
+
+/**
+ * _gtk_builder_precompiled_get_type_from_name:
+ * @precompiled: (nullable): the precompiled data being parsed
+ * @builder: a #GtkBuilder
+ * @type_name: type name to look up
+ *
+ * Like gtk_builder_get_type_from_name(), but remembers the result
+ * when @type_name points into @precompiled.
+ *
+ * Returns: the #GType found, or %G_TYPE_INVALID
+ */
+GType
+_gtk_builder_precompiled_get_type_from_name (GtkBuilderPrecompiled *precompiled,
+                                             GtkBuilder            *builder,
+                                             const char            *type_name)
+{
+  GType type;
+
+  if (!gtk_builder_precompiled_owns (precompiled, type_name))
+    return gtk_builder_get_type_from_name (builder, type_name);
+
+  g_mutex_lock (&precompiled->lock);
+  type = GPOINTER_TO_SIZE (g_hash_table_lookup (precompiled->types, type_name));
+  g_mutex_unlock (&precompiled->lock);
+
+  if (type != G_TYPE_INVALID)
+    return type;
+
+  type = gtk_builder_get_type_from_name (builder, type_name);
+
+  /* Classes of dynamic types may go away, and be registered anew */
+  if (type != G_TYPE_INVALID && g_type_get_plugin (type) == NULL)
+    {
+      g_mutex_lock (&precompiled->lock);
+      g_hash_table_insert (precompiled->types, (gpointer) type_name, GSIZE_TO_POINTER (type));
+      g_mutex_unlock (&precompiled->lock);
+    }
+
+  return type;
+}
+
+/**
+ * _gtk_builder_precompiled_find_property:
+ * @precompiled: (nullable): the precompiled data being parsed
+ * @oclass: the class to look up the property in
+ * @property_name: property name to look up
+ *
+ * Like g_object_class_find_property(), but remembers the result
+ * when @property_name points into @precompiled.
+ *
+ * Returns: (transfer none) (nullable): the #GParamSpec found
+ */
+GParamSpec *
+_gtk_builder_precompiled_find_property (GtkBuilderPrecompiled *precompiled,
+                                        GObjectClass          *oclass,
+                                        const char            *property_name)
+{
+  GType type = G_OBJECT_CLASS_TYPE (oclass);
+  GHashTable *pspecs;
+  GParamSpec *pspec;
+
+  if (!gtk_builder_precompiled_owns (precompiled, property_name) ||
+      g_type_get_plugin (type) != NULL)
+    return g_object_class_find_property (oclass, property_name);
+
+  g_mutex_lock (&precompiled->lock);
+  pspecs = g_hash_table_lookup (precompiled->pspecs, GSIZE_TO_POINTER (type));
+  pspec = pspecs ? g_hash_table_lookup (pspecs, property_name) : NULL;
+  g_mutex_unlock (&precompiled->lock);
+
+  if (pspec)
+    return pspec;
+
+  pspec = g_object_class_find_property (oclass, property_name);
+  if (pspec == NULL)
+    return NULL;
+
+  g_mutex_lock (&precompiled->lock);
+  pspecs = g_hash_table_lookup (precompiled->pspecs, GSIZE_TO_POINTER (type));
+  if (pspecs == NULL)
+    {
+      pspecs = g_hash_table_new (NULL, NULL);
+      g_hash_table_insert (precompiled->pspecs, GSIZE_TO_POINTER (type), pspecs);
+    }
+  g_hash_table_insert (pspecs, (gpointer) property_name, pspec);
+  g_mutex_unlock (&precompiled->lock);
+
+  return pspec;
+}
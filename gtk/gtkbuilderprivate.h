@@ -34,6 +34,7 @@ enum {
   TAG_INTERFACE,
   TAG_TEMPLATE,
   TAG_EXPRESSION,
+  TAG_LAZY_OBJECT,
 };
 
 typedef struct {
@@ -52,6 +53,7 @@ typedef struct {
   GObject *object;
   CommonInfo *parent;
   gboolean applied_properties;
+  char *last_child_id;
 } ObjectInfo;
 
 typedef struct {
@@ -139,6 +141,16 @@ typedef struct
   int col;
 } BindingExpressionInfo;
 
+/* An object whose construction is deferred until it is looked up */
+typedef struct {
+  guint tag_type;
+  struct _GtkBuildableRecorder *recorder;
+  char *id;
+  char *parent_id;
+  char *prev_id;
+  char *type;
+} LazyObjectInfo;
+
 typedef struct {
   guint    tag_type;
   char    *library;
@@ -169,6 +181,10 @@ typedef struct {
   GObject *child;
 } SubParser;
 
+typedef struct _GtkBuilderPrecompiled GtkBuilderPrecompiled;
+typedef struct _GtkBuildableRecorder GtkBuildableRecorder;
+typedef struct _GtkBuilderLazyObject GtkBuilderLazyObject;
+
 typedef struct {
   const char *last_element;
   GtkBuilder *builder;
@@ -188,6 +204,8 @@ typedef struct {
   int object_counter;
 
   GHashTable *object_ids;
+
+  GtkBuilderPrecompiled *precompiled; /* NULL unless replaying it */
 } ParserData;
 
 typedef GType (*GTypeGetFunc) (void);
@@ -202,6 +220,42 @@ gboolean _gtk_buildable_parser_replay_precompiled (GtkBuildableParseContext *con
                                                    const char           *data,
                                                    gssize                data_len,
                                                    GError              **error);
+GtkBuilderPrecompiled * _gtk_builder_precompiled_new       (GBytes                *bytes);
+void                    _gtk_builder_precompiled_free      (GtkBuilderPrecompiled *precompiled);
+GBytes *                _gtk_builder_precompiled_get_bytes (GtkBuilderPrecompiled *precompiled);
+GType        _gtk_builder_precompiled_get_type_from_name (GtkBuilderPrecompiled *precompiled,
+                                                          GtkBuilder            *builder,
+                                                          const char            *type_name);
+GParamSpec * _gtk_builder_precompiled_find_property      (GtkBuilderPrecompiled *precompiled,
+                                                          GObjectClass          *oclass,
+                                                          const char            *property_name);
+extern const GtkBuildableParser _gtk_buildable_recorder_parser;
+GtkBuildableRecorder * _gtk_buildable_recorder_new           (void);
+void                   _gtk_buildable_recorder_free          (GtkBuildableRecorder  *recorder);
+void                   _gtk_buildable_recorder_start_element (GtkBuildableRecorder  *recorder,
+                                                              const char            *element_name,
+                                                              const char           **names,
+                                                              const char           **values);
+void                   _gtk_buildable_recorder_end_element   (GtkBuildableRecorder  *recorder);
+GBytes *               _gtk_buildable_recorder_free_to_bytes (GtkBuildableRecorder  *recorder);
+void                    _gtk_builder_set_precompiled (GtkBuilder            *builder,
+                                                      GtkBuilderPrecompiled *precompiled);
+GtkBuilderPrecompiled * _gtk_builder_get_precompiled (GtkBuilder            *builder);
+void         _gtk_builder_add_lazy_object    (GtkBuilder            *builder,
+                                              const char            *id,
+                                              const char            *parent_id,
+                                              const char            *prev_id,
+                                              const char            *type,
+                                              GBytes                *bytes);
+gboolean     _gtk_builder_has_lazy_object    (GtkBuilder            *builder,
+                                              const char            *id);
+GHashTable * _gtk_builder_steal_lazy_objects (GtkBuilder            *builder);
+void         _gtk_builder_take_lazy_object   (GtkBuilder            *builder,
+                                              const char            *id,
+                                              GtkBuilderLazyObject  *lazy);
+void         _gtk_builder_lazy_object_free   (GtkBuilderLazyObject  *lazy);
+void         _gtk_builder_lazy_object_skip_siblings (GtkBuilderLazyObject *lazy,
+                                                     GHashTable           *lazy_objects);
 void _gtk_builder_parser_parse_buffer (GtkBuilder *builder,
                                        const char *filename,
                                        const char *buffer,
@@ -298,6 +298,7 @@ gtk_button_class_init (GtkButtonClass *klass)
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_BUTTON);
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
   gtk_widget_class_set_css_name (widget_class, I_("button"));
+  gtk_widget_class_set_measure_equal_func (widget_class, gtk_widget_measure_equal_style);
 }
 
 static void
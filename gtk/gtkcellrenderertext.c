@@ -162,6 +162,19 @@ static GParamSpec *text_cell_renderer_props [LAST_PROP];
 
 typedef struct _GtkCellRendererTextPrivate       GtkCellRendererTextPrivate;
 
+/* Tree views measure every row, and the same strings tend to show
+ * up in many of them. So sizes are cached per string, for as long
+ * as the properties that affect them stay the same.
+ */
+#define MAX_CACHED_SIZES 1024
+
+typedef struct
+{
+  PangoRectangle logical; /* of the unwrapped text, width < 0 if not measured */
+  int for_width;          /* of the last height-for-width request without padding, or -1 */
+  int height;
+} TextSize;
+
 struct _GtkCellRendererTextPrivate
 {
   GtkWidget *entry;
@@ -206,6 +219,21 @@ struct _GtkCellRendererTextPrivate
 
   gulong focus_out_id;
   gulong entry_menu_popdown_timeout;
+
+  PangoLayout *layout; /* reused for all rows */
+
+  /* What the sizes were measured with */
+  GHashTable           *sizes;
+  int                   sizes_char_width;
+  PangoContext         *sizes_context;
+  guint                 sizes_context_serial;
+  PangoFontDescription *sizes_font;
+  double                sizes_font_scale;
+  PangoLanguage        *sizes_language;
+  int                   sizes_rise;
+  PangoEllipsizeMode    sizes_ellipsize;
+  PangoWrapMode         sizes_wrap_mode;
+  gboolean              sizes_single_paragraph;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkCellRendererText, gtk_cell_renderer_text, GTK_TYPE_CELL_RENDERER)
@@ -661,6 +689,11 @@ gtk_cell_renderer_text_finalize (GObject *object)
 
   g_clear_object (&priv->entry);
 
+  g_clear_object (&priv->layout);
+  g_clear_pointer (&priv->sizes, g_hash_table_unref);
+  g_clear_object (&priv->sizes_context);
+  g_clear_pointer (&priv->sizes_font, pango_font_description_free);
+
   G_OBJECT_CLASS (gtk_cell_renderer_text_parent_class)->finalize (object);
 }
 
@@ -1432,12 +1465,32 @@ get_layout (GtkCellRendererText *celltext,
   GtkCellRendererTextPrivate *priv = gtk_cell_renderer_text_get_instance_private (celltext);
   PangoAttrList *attr_list;
   PangoLayout *layout;
+  PangoContext *context;
   PangoUnderline uline;
   int xpad;
   gboolean placeholder_layout = show_placeholder_text (celltext);
 
-  layout = gtk_widget_create_pango_layout (widget, placeholder_layout ?
-                                           priv->placeholder_text : priv->text);
+  /* Everything about the layout is set up below, so the one from
+   * the last row can be used again, unless somebody kept it.
+   */
+  context = gtk_widget_get_pango_context (widget);
+  if (priv->layout &&
+      G_OBJECT (priv->layout)->ref_count == 1 &&
+      pango_layout_get_context (priv->layout) == context)
+    {
+      layout = g_object_ref (priv->layout);
+      pango_layout_context_changed (layout);
+      pango_layout_set_text (layout,
+                             placeholder_layout ? priv->placeholder_text :
+                             priv->text ? priv->text : "",
+                             -1);
+    }
+  else
+    {
+      layout = gtk_widget_create_pango_layout (widget, placeholder_layout ?
+                                               priv->placeholder_text : priv->text);
+      g_set_object (&priv->layout, layout);
+    }
 
   gtk_cell_renderer_get_padding (GTK_CELL_RENDERER (celltext), &xpad, NULL);
 
@@ -1882,6 +1935,82 @@ gtk_cell_renderer_text_set_fixed_height_from_font (GtkCellRendererText *renderer
     }
 }
 
+/* Returns the cached sizes for the current text, or %NULL
+ * if they can't be cached.
+ */
+static TextSize *
+lookup_text_size (GtkCellRendererText *celltext,
+                  GtkWidget           *widget)
+{
+  GtkCellRendererTextPrivate *priv = gtk_cell_renderer_text_get_instance_private (celltext);
+  PangoContext *context;
+  double font_scale;
+  PangoLanguage *language;
+  PangoEllipsizeMode ellipsize;
+  PangoWrapMode wrap_mode;
+  int rise;
+  const char *text;
+  TextSize *size;
+
+  /* Attributes from markup can be different for every row */
+  if (priv->extra_attrs)
+    return NULL;
+
+  context = gtk_widget_get_pango_context (widget);
+  font_scale = priv->scale_set ? priv->font_scale : 1.0;
+  language = priv->language_set ? priv->language : NULL;
+  rise = priv->rise_set ? priv->rise : 0;
+  ellipsize = priv->ellipsize_set ? priv->ellipsize : PANGO_ELLIPSIZE_NONE;
+  wrap_mode = priv->wrap_width != -1 ? priv->wrap_mode : PANGO_WRAP_CHAR;
+
+  if (priv->sizes == NULL ||
+      priv->sizes_context != context ||
+      priv->sizes_context_serial != pango_context_get_serial (context) ||
+      !pango_font_description_equal (priv->sizes_font, priv->font) ||
+      priv->sizes_font_scale != font_scale ||
+      priv->sizes_language != language ||
+      priv->sizes_rise != rise ||
+      priv->sizes_ellipsize != ellipsize ||
+      priv->sizes_wrap_mode != wrap_mode ||
+      priv->sizes_single_paragraph != priv->single_paragraph)
+    {
+      if (priv->sizes)
+        g_hash_table_remove_all (priv->sizes);
+      else
+        priv->sizes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+      priv->sizes_char_width = -1;
+      g_set_object (&priv->sizes_context, context);
+      priv->sizes_context_serial = pango_context_get_serial (context);
+      g_clear_pointer (&priv->sizes_font, pango_font_description_free);
+      priv->sizes_font = pango_font_description_copy (priv->font);
+      priv->sizes_font_scale = font_scale;
+      priv->sizes_language = language;
+      priv->sizes_rise = rise;
+      priv->sizes_ellipsize = ellipsize;
+      priv->sizes_wrap_mode = wrap_mode;
+      priv->sizes_single_paragraph = priv->single_paragraph;
+    }
+
+  text = show_placeholder_text (celltext) ? priv->placeholder_text : priv->text;
+  if (text == NULL)
+    text = "";
+
+  size = g_hash_table_lookup (priv->sizes, text);
+  if (size)
+    return size;
+
+  if (g_hash_table_size (priv->sizes) >= MAX_CACHED_SIZES)
+    g_hash_table_remove_all (priv->sizes);
+
+  size = g_new (TextSize, 1);
+  size->logical.width = -1;
+  size->for_width = -1;
+  g_hash_table_insert (priv->sizes, g_strdup (text), size);
+
+  return size;
+}
+
 static void
 gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
                                             GtkWidget       *widget,
@@ -1894,6 +2023,7 @@ gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
   PangoContext               *context;
   PangoFontMetrics           *metrics;
   PangoRectangle              rect;
+  TextSize                   *size;
   int char_width, text_width, ellipsize_chars, xpad;
   int min_width, nat_width;
 
@@ -1907,23 +2037,39 @@ gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
    */
   gtk_cell_renderer_get_padding (cell, &xpad, NULL);
 
-  layout = get_layout (celltext, widget, NULL, 0);
+  size = lookup_text_size (celltext, widget);
+  if (size && size->logical.width >= 0 && priv->sizes_char_width >= 0)
+    {
+      rect = size->logical;
+      char_width = priv->sizes_char_width;
+    }
+  else
+    {
+      layout = get_layout (celltext, widget, NULL, 0);
 
-  /* Fetch the length of the complete unwrapped text */
-  pango_layout_set_width (layout, -1);
-  pango_layout_get_extents (layout, NULL, &rect);
-  text_width = rect.width;
+      /* Fetch the length of the complete unwrapped text */
+      pango_layout_set_width (layout, -1);
+      pango_layout_get_extents (layout, NULL, &rect);
 
-  /* Fetch the average size of a character */
-  context = pango_layout_get_context (layout);
-  metrics = pango_context_get_metrics (context,
-                                       pango_context_get_font_description (context),
-                                       pango_context_get_language (context));
+      /* Fetch the average size of a character */
+      context = pango_layout_get_context (layout);
+      metrics = pango_context_get_metrics (context,
+                                           pango_context_get_font_description (context),
+                                           pango_context_get_language (context));
 
-  char_width = pango_font_metrics_get_approximate_char_width (metrics);
+      char_width = pango_font_metrics_get_approximate_char_width (metrics);
 
-  pango_font_metrics_unref (metrics);
-  g_object_unref (layout);
+      pango_font_metrics_unref (metrics);
+      g_object_unref (layout);
+
+      if (size)
+        {
+          size->logical = rect;
+          priv->sizes_char_width = char_width;
+        }
+    }
+
+  text_width = rect.width;
 
   /* enforce minimum width for ellipsized labels at ~3 chars */
   if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
@@ -1973,22 +2119,37 @@ gtk_cell_renderer_text_get_preferred_height_for_width (GtkCellRenderer *cell,
 {
   GtkCellRendererText *celltext = GTK_CELL_RENDERER_TEXT (cell);
   PangoLayout         *layout;
+  TextSize            *size;
   int                  text_height, xpad, ypad;
 
   gtk_cell_renderer_get_padding (cell, &xpad, &ypad);
 
-  layout = get_layout (celltext, widget, NULL, 0);
+  size = lookup_text_size (celltext, widget);
+  if (size && size->for_width == width - xpad * 2)
+    {
+      text_height = size->height;
+    }
+  else
+    {
+      layout = get_layout (celltext, widget, NULL, 0);
+
+      pango_layout_set_width (layout, (width - xpad * 2) * PANGO_SCALE);
+      pango_layout_get_pixel_size (layout, NULL, &text_height);
 
-  pango_layout_set_width (layout, (width - xpad * 2) * PANGO_SCALE);
-  pango_layout_get_pixel_size (layout, NULL, &text_height);
+      g_object_unref (layout);
+
+      if (size)
+        {
+          size->for_width = width - xpad * 2;
+          size->height = text_height;
+        }
+    }
 
   if (minimum_height)
     *minimum_height = text_height + ypad * 2;
 
   if (natural_height)
     *natural_height = text_height + ypad * 2;
-
-  g_object_unref (layout);
 }
 
 static void
@@ -210,6 +210,7 @@ gtk_center_box_class_init (GtkCenterBoxClass *klass)
 
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_CENTER_LAYOUT);
   gtk_widget_class_set_css_name (widget_class, I_("box"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
 }
 
 static void
@@ -378,9 +378,12 @@ gtk_column_view_allocate_columns (GtkColumnView *self,
                                   int            width)
 {
   guint i, n;
-  int x;
+  int x, visible_x, visible_width;
   GtkRequestedSize *sizes;
 
+  visible_x = gtk_adjustment_get_value (self->hadjustment);
+  visible_width = width;
+
   n = g_list_model_get_n_items (G_LIST_MODEL (self->columns));
 
   sizes = g_newa (GtkRequestedSize, n);
@@ -399,6 +402,9 @@ gtk_column_view_allocate_columns (GtkColumnView *self,
           col_size = sizes[i].minimum_size;
 
           gtk_column_view_column_allocate (column, x, col_size);
+          gtk_column_view_column_set_in_view (column,
+                                              x < visible_x + visible_width &&
+                                              x + col_size > visible_x);
           if (self->in_column_reorder && i == self->drag_pos)
             gtk_column_view_column_set_header_position (column, self->drag_x);
 
@@ -104,18 +104,16 @@ gtk_column_view_cell_measure (GtkWidget      *widget,
             for_size = MIN (for_size, unadj_width);
         }
     }
+  else if (fixed_width > -1)
+    {
+      /* The width is known, no need to ask the child */
+      *minimum = 0;
+      *natural = unadj_width;
+      return;
+    }
 
   if (child)
     gtk_widget_measure (child, orientation, for_size, minimum, natural, minimum_baseline, natural_baseline);
-
-  if (orientation == GTK_ORIENTATION_HORIZONTAL)
-    {
-      if (fixed_width > -1)
-        {
-          *minimum = 0;
-          *natural = unadj_width;
-        }
-    }
 }
 
 static void
@@ -136,6 +134,19 @@ gtk_column_view_cell_size_allocate (GtkWidget *widget,
     }
 }
 
+static void
+gtk_column_view_cell_snapshot (GtkWidget   *widget,
+                               GtkSnapshot *snapshot)
+{
+  GtkColumnViewCell *self = GTK_COLUMN_VIEW_CELL (widget);
+
+  /* Don't bother drawing columns that are scrolled out of view */
+  if (!gtk_column_view_column_get_in_view (self->column))
+    return;
+
+  GTK_WIDGET_CLASS (gtk_column_view_cell_parent_class)->snapshot (widget, snapshot);
+}
+
 static void
 gtk_column_view_cell_root (GtkWidget *widget)
 {
@@ -199,6 +210,7 @@ gtk_column_view_cell_class_init (GtkColumnViewCellClass *klass)
   widget_class->unroot = gtk_column_view_cell_unroot;
   widget_class->measure = gtk_column_view_cell_measure;
   widget_class->size_allocate = gtk_column_view_cell_size_allocate;
+  widget_class->snapshot = gtk_column_view_cell_snapshot;
   widget_class->get_request_mode = gtk_column_view_cell_get_request_mode;
 
   gobject_class->dispose = gtk_column_view_cell_dispose;
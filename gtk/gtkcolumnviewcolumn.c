@@ -73,6 +73,7 @@ struct _GtkColumnViewColumn
   guint visible     : 1;
   guint resizable   : 1;
   guint expand      : 1;
+  guint in_view     : 1; /* intersects the visible part of the view */
 
   GMenuModel *menu;
 
@@ -351,6 +352,7 @@ gtk_column_view_column_init (GtkColumnViewColumn *self)
   self->resizable = FALSE;
   self->expand = FALSE;
   self->fixed_width = -1;
+  self->in_view = TRUE;
 }
 
 /**
@@ -431,9 +433,13 @@ gtk_column_view_column_queue_resize (GtkColumnViewColumn *self)
   if (self->header)
     gtk_widget_queue_resize (self->header);
 
+  /* The cells only need to be allocated the new column width.
+   * Their own size requests are still valid, so when the column is measured
+   * again, only cells whose contents changed need to be measured.
+   */
   for (cell = self->first_cell; cell; cell = gtk_column_view_cell_get_next (cell))
     {
-      gtk_widget_queue_resize (GTK_WIDGET (cell));
+      gtk_widget_queue_allocate (GTK_WIDGET (cell));
     }
 }
 
@@ -504,6 +510,35 @@ gtk_column_view_column_get_allocation (GtkColumnViewColumn *self,
     *size = self->allocation_size;
 }
 
+/* Cells of columns that are scrolled out of view skip drawing, so
+ * redraw them when they come back.
+ */
+void
+gtk_column_view_column_set_in_view (GtkColumnViewColumn *self,
+                                    gboolean             in_view)
+{
+  GtkColumnViewCell *cell;
+
+  if (self->in_view == in_view)
+    return;
+
+  self->in_view = in_view;
+
+  if (!in_view)
+    return;
+
+  for (cell = self->first_cell; cell; cell = gtk_column_view_cell_get_next (cell))
+    {
+      gtk_widget_queue_draw (GTK_WIDGET (cell));
+    }
+}
+
+gboolean
+gtk_column_view_column_get_in_view (GtkColumnViewColumn *self)
+{
+  return self->in_view;
+}
+
 static void
 gtk_column_view_column_create_cells (GtkColumnViewColumn *self)
 {
@@ -975,6 +1010,8 @@ void
 gtk_column_view_column_set_fixed_width (GtkColumnViewColumn *self,
                                         int                  fixed_width)
 {
+  GtkColumnViewCell *cell;
+
   g_return_if_fail (GTK_IS_COLUMN_VIEW_COLUMN (self));
   g_return_if_fail (fixed_width >= -1);
 
@@ -985,6 +1022,12 @@ gtk_column_view_column_set_fixed_width (GtkColumnViewColumn *self,
 
   gtk_column_view_column_queue_resize (self);
 
+  /* The cells' size requests depend on the fixed width */
+  for (cell = self->first_cell; cell; cell = gtk_column_view_cell_get_next (cell))
+    {
+      gtk_widget_queue_resize (GTK_WIDGET (cell));
+    }
+
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_FIXED_WIDTH]);
 }
 
@@ -30,7 +30,7 @@
 
 
 #define GTK_COMPOSE_TABLE_MAGIC "GtkComposeTable"
-#define GTK_COMPOSE_TABLE_VERSION (1)
+#define GTK_COMPOSE_TABLE_VERSION (2)
 
 typedef struct {
   gunichar     *sequence;
@@ -534,63 +534,59 @@ gtk_compose_hash_get_cache_path (guint32 hash)
   return path;
 }
 
+/* The cache is mapped into memory and used as it is, so the data is
+ * stored in the byte order of the machine that wrote it, and it is
+ * aligned for reading guint16 values. The layout is:
+ *
+ *   "GtkComposeTable"    magic
+ *   'l' or 'B'           byte order
+ *   guint16              version
+ *   guint16              max_seq_len
+ *   guint16              n_seqs
+ *   guint16[]            n_seqs * (max_seq_len + 2) sequence data
+ *
+ * Caches written with another byte order or version are rebuilt.
+ */
+#define GTK_COMPOSE_TABLE_BYTE_ORDER (G_BYTE_ORDER == G_LITTLE_ENDIAN ? 'l' : 'B')
+#define GTK_COMPOSE_TABLE_HEADER_SIZE (sizeof (GTK_COMPOSE_TABLE_MAGIC) + 3 * sizeof (guint16))
+
+G_STATIC_ASSERT (sizeof (GTK_COMPOSE_TABLE_MAGIC) % sizeof (guint16) == 0);
+
 static char *
 gtk_compose_table_serialize (GtkComposeTable *compose_table,
                              gsize           *count)
 {
   char *p, *contents;
-  gsize length, total_length;
-  guint16 bytes;
-  const char *header = GTK_COMPOSE_TABLE_MAGIC;
+  gsize data_length, total_length;
   const guint16 version = GTK_COMPOSE_TABLE_VERSION;
   guint16 max_seq_len = compose_table->max_seq_len;
   guint16 index_stride = max_seq_len + 2;
   guint16 n_seqs = compose_table->n_seqs;
-  guint32 i;
 
   g_return_val_if_fail (compose_table != NULL, NULL);
   g_return_val_if_fail (max_seq_len > 0, NULL);
   g_return_val_if_fail (index_stride > 0, NULL);
 
-  length = strlen (header);
-  total_length = length + sizeof (guint16) * (3 +  index_stride * n_seqs);
+  data_length = sizeof (guint16) * index_stride * n_seqs;
+  total_length = GTK_COMPOSE_TABLE_HEADER_SIZE + data_length;
   if (count)
     *count = total_length;
 
   p = contents = g_slice_alloc (total_length);
 
-  memcpy (p, header, length);
-  p += length;
-
-  /* Copy by byte for endian */
-#define BYTE_COPY_FROM_BUF(element)                                           \
-  bytes = GUINT16_TO_BE ((element));                                          \
-  memcpy (p, &bytes, length);                                                 \
-  p += length;                                                                \
-  if (p - contents > total_length)                                            \
-    {                                                                         \
-      g_warning ("data size %lld is bigger than %" G_GSIZE_FORMAT,            \
-                 (long long) (p - contents), total_length);                   \
-      g_free (contents);                                                      \
-      if (count)                                                              \
-        {                                                                     \
-          *count = 0;                                                         \
-        }                                                                     \
-      return NULL;                                                            \
-    }
-
-  length = sizeof (guint16);
+  /* Copies the terminating nul too, which is replaced below */
+  memcpy (p, GTK_COMPOSE_TABLE_MAGIC, sizeof (GTK_COMPOSE_TABLE_MAGIC));
+  p += sizeof (GTK_COMPOSE_TABLE_MAGIC) - 1;
+  *p++ = GTK_COMPOSE_TABLE_BYTE_ORDER;
 
-  BYTE_COPY_FROM_BUF (version);
-  BYTE_COPY_FROM_BUF (max_seq_len);
-  BYTE_COPY_FROM_BUF (n_seqs);
+  memcpy (p, &version, sizeof (guint16));
+  p += sizeof (guint16);
+  memcpy (p, &max_seq_len, sizeof (guint16));
+  p += sizeof (guint16);
+  memcpy (p, &n_seqs, sizeof (guint16));
+  p += sizeof (guint16);
 
-  for (i = 0; i < (guint32) index_stride * n_seqs; i++)
-    {
-      BYTE_COPY_FROM_BUF (compose_table->data[i]);
-    }
-
-#undef BYTE_COPY_FROM_BUF
+  memcpy (p, compose_table->data, data_length);
 
   return contents;
 }
@@ -609,20 +605,17 @@ gtk_compose_table_load_cache (const char *compose_file)
 {
   guint32 hash;
   char *path = NULL;
-  char *contents = NULL;
-  char *p;
+  GMappedFile *mapped = NULL;
+  const char *contents;
+  const char *p;
   GStatBuf original_buf;
   GStatBuf cache_buf;
   gsize total_length;
-  gsize length;
   GError *error = NULL;
-  guint16 bytes;
   guint16 version;
   guint16 max_seq_len;
   guint16 index_stride;
   guint16 n_seqs;
-  guint32 i;
-  guint16 *gtk_compose_seqs = NULL;
   GtkComposeTable *retval;
 
   hash = g_str_hash (compose_file);
@@ -635,81 +628,77 @@ gtk_compose_table_load_cache (const char *compose_file)
   g_stat (path, &cache_buf);
   if (original_buf.st_mtime > cache_buf.st_mtime)
     goto out_load_cache;
-  if (!g_file_get_contents (path, &contents, &total_length, &error))
+
+  /* The pages are shared with all other processes that map the
+   * same cache. Saving a new cache replaces the file instead of
+   * writing to it, so the mapping stays valid.
+   */
+  mapped = g_mapped_file_new (path, FALSE, &error);
+  if (mapped == NULL)
     {
-      g_warning ("Failed to get cache content %s: %s", path, error->message);
+      g_warning ("Failed to map cache %s: %s", path, error->message);
       g_error_free (error);
       goto out_load_cache;
     }
 
-  /* Copy by byte for endian */
-#define BYTE_COPY_TO_BUF(element)                                       \
-  memcpy (&bytes, p, length);                                           \
-  element = GUINT16_FROM_BE (bytes);                                    \
-  p += length;                                                          \
-  if (p - contents > total_length)                                      \
-    {                                                                   \
-      g_warning ("Broken cache content %s in %s", path, #element);      \
-      goto out_load_cache;                                              \
-    }
+  contents = g_mapped_file_get_contents (mapped);
+  total_length = g_mapped_file_get_length (mapped);
 
-  p = contents;
-  if (g_ascii_strncasecmp (p, GTK_COMPOSE_TABLE_MAGIC,
-                           strlen (GTK_COMPOSE_TABLE_MAGIC)) != 0)
+  if (total_length < GTK_COMPOSE_TABLE_HEADER_SIZE)
     {
-      g_warning ("The file is not a GtkComposeTable cache file %s", path);
+      g_warning ("Broken cache content %s at head", path);
       goto out_load_cache;
     }
-  p += strlen (GTK_COMPOSE_TABLE_MAGIC);
-  if (p - contents > total_length)
+
+  p = contents;
+  if (memcmp (p, GTK_COMPOSE_TABLE_MAGIC, sizeof (GTK_COMPOSE_TABLE_MAGIC) - 1) != 0)
     {
-      g_warning ("Broken cache content %s at head", path);
+      g_warning ("The file is not a GtkComposeTable cache file %s", path);
       goto out_load_cache;
     }
+  p += sizeof (GTK_COMPOSE_TABLE_MAGIC) - 1;
 
-  length = sizeof (guint16);
+  /* Written on a different machine, or by an older version;
+   * not worth a warning, it is rebuilt */
+  if (*p++ != GTK_COMPOSE_TABLE_BYTE_ORDER)
+    goto out_load_cache;
 
-  BYTE_COPY_TO_BUF (version);
+  memcpy (&version, p, sizeof (guint16));
+  p += sizeof (guint16);
   if (version != GTK_COMPOSE_TABLE_VERSION)
-    {
-      g_warning ("cache version is different %u != %u",
-                 version, GTK_COMPOSE_TABLE_VERSION);
-      goto out_load_cache;
-    }
+    goto out_load_cache;
 
-  BYTE_COPY_TO_BUF (max_seq_len);
-  BYTE_COPY_TO_BUF (n_seqs);
+  memcpy (&max_seq_len, p, sizeof (guint16));
+  p += sizeof (guint16);
+  memcpy (&n_seqs, p, sizeof (guint16));
+  p += sizeof (guint16);
 
-  if (max_seq_len == 0 || n_seqs == 0)
+  if (max_seq_len == 0 || max_seq_len > GTK_MAX_COMPOSE_LEN || n_seqs == 0)
     {
       g_warning ("cache size is not correct %d %d", max_seq_len, n_seqs);
       goto out_load_cache;
     }
 
   index_stride = max_seq_len + 2;
-  gtk_compose_seqs = g_new0 (guint16, n_seqs * index_stride);
-
-  for (i = 0; i < (guint32) index_stride * n_seqs; i++)
+  if (total_length != GTK_COMPOSE_TABLE_HEADER_SIZE + sizeof (guint16) * index_stride * n_seqs)
     {
-      BYTE_COPY_TO_BUF (gtk_compose_seqs[i]);
+      g_warning ("Broken cache content %s, unexpected size", path);
+      goto out_load_cache;
     }
 
   retval = g_new0 (GtkComposeTable, 1);
-  retval->data = gtk_compose_seqs;
+  retval->data = (guint16 *) p;
   retval->max_seq_len = max_seq_len;
   retval->n_seqs = n_seqs;
   retval->id = hash;
+  retval->mapped = mapped;
 
-  g_free (contents);
   g_free (path);
 
   return retval;
 
-#undef BYTE_COPY_TO_BUF
-
 out_load_cache:
-  g_free (gtk_compose_seqs);
-  g_free (contents);
+  g_clear_pointer (&mapped, g_mapped_file_unref);
   g_free (path);
   return NULL;
 }
@@ -859,7 +848,7 @@ gtk_compose_table_list_add_array (GSList        *compose_tables,
   for (i = 0; i < length; i++)
     gtk_compose_seqs[i] = data[i];
 
-  compose_table = g_new (GtkComposeTable, 1);
+  compose_table = g_new0 (GtkComposeTable, 1);
   compose_table->data = gtk_compose_seqs;
   compose_table->max_seq_len = max_seq_len;
   compose_table->n_seqs = n_seqs;
@@ -32,6 +32,8 @@ struct _GtkComposeTable
   int max_seq_len;
   int n_seqs;
   guint32 id;
+  /* If set, @data points into this cache file and is read-only */
+  GMappedFile *mapped;
 };
 
 struct _GtkComposeTableCompact
@@ -24,6 +24,8 @@
 #include "gtkconstraintexpressionprivate.h"
 #include "gtkconstraintsolverprivate.h"
 
+#include <string.h>
+
 /* {{{ Variables */
 
 typedef enum {
@@ -369,13 +371,26 @@ gtk_constraint_variable_is_dummy (const GtkConstraintVariable *variable)
  * GtkConstraintVariableSet:
  *
  * A set of variables.
+ *
+ * Sets are used for the columns of the tableau, and most of them only
+ * contain a handful of variables, so the variables are kept in a sorted
+ * array instead of a tree, and small sets do not need a separate
+ * allocation at all.
  */
+#define N_INLINE_VARIABLES      4
+
 struct _GtkConstraintVariableSet {
-  /* List<Variable>, owns a reference */
-  GSequence *set;
+  /* Array<Variable>, sorted by id, owns a reference; points to
+   * inline_variables until the set grows past N_INLINE_VARIABLES
+   */
+  GtkConstraintVariable **variables;
+  guint n_variables;
+  guint n_allocated;
 
   /* Age of the set, to guard against mutations while iterating */
   gint64 age;
+
+  GtkConstraintVariable *inline_variables[N_INLINE_VARIABLES];
 };
 
 /*< private >
@@ -387,9 +402,15 @@ struct _GtkConstraintVariableSet {
 void
 gtk_constraint_variable_set_free (GtkConstraintVariableSet *set)
 {
+  guint i;
+
   g_return_if_fail (set != NULL);
 
-  g_sequence_free (set->set);
+  for (i = 0; i < set->n_variables; i++)
+    gtk_constraint_variable_unref (set->variables[i]);
+
+  if (set->variables != set->inline_variables)
+    g_free (set->variables);
 
   g_free (set);
 }
@@ -406,24 +427,35 @@ gtk_constraint_variable_set_new (void)
 {
   GtkConstraintVariableSet *res = g_new (GtkConstraintVariableSet, 1);
 
-  res->set = g_sequence_new ((GDestroyNotify) gtk_constraint_variable_unref);
+  res->variables = res->inline_variables;
+  res->n_variables = 0;
+  res->n_allocated = N_INLINE_VARIABLES;
 
   res->age = 0;
 
   return res;
 }
 
-static int
-sort_by_variable_id (gconstpointer a,
-                     gconstpointer b,
-                     gpointer      data)
+/* Returns the position of the first variable in @set whose id is
+ * not lower than the id of @variable
+ */
+static guint
+gtk_constraint_variable_set_search (const GtkConstraintVariableSet *set,
+                                    const GtkConstraintVariable *variable)
 {
-  const GtkConstraintVariable *va = a, *vb = b;
+  guint lo = 0, hi = set->n_variables;
 
-  if (va == vb)
-    return 0;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (set->variables[mid]->_id < variable->_id)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
 
-  return va->_id - vb->_id;
+  return lo;
 }
 
 /*< private >
@@ -444,17 +476,30 @@ gboolean
 gtk_constraint_variable_set_add (GtkConstraintVariableSet *set,
                                  GtkConstraintVariable *variable)
 {
-  GSequenceIter *iter;
+  guint pos;
 
-  iter = g_sequence_search (set->set, variable, sort_by_variable_id, NULL);
-  if (!g_sequence_iter_is_end (iter))
+  pos = gtk_constraint_variable_set_search (set, variable);
+  if (pos < set->n_variables && set->variables[pos] == variable)
+    return FALSE;
+
+  if (set->n_variables == set->n_allocated)
     {
-      GtkConstraintVariable *v = g_sequence_get (iter);
-      if (v->_id == variable->_id)
-        return FALSE;
+      set->n_allocated *= 2;
+
+      if (set->variables == set->inline_variables)
+        {
+          set->variables = g_new (GtkConstraintVariable *, set->n_allocated);
+          memcpy (set->variables, set->inline_variables,
+                  sizeof (GtkConstraintVariable *) * set->n_variables);
+        }
+      else
+        set->variables = g_renew (GtkConstraintVariable *, set->variables, set->n_allocated);
     }
 
-  g_sequence_insert_before (iter, gtk_constraint_variable_ref (variable));
+  memmove (&set->variables[pos + 1], &set->variables[pos],
+           sizeof (GtkConstraintVariable *) * (set->n_variables - pos));
+  set->variables[pos] = gtk_constraint_variable_ref (variable);
+  set->n_variables += 1;
 
   set->age += 1;
 
@@ -477,18 +522,21 @@ gboolean
 gtk_constraint_variable_set_remove (GtkConstraintVariableSet *set,
                                     GtkConstraintVariable *variable)
 {
-  GSequenceIter *iter;
+  guint pos;
 
-  iter = g_sequence_lookup (set->set, variable, sort_by_variable_id, NULL);
-  if (iter != NULL)
-    {
-      g_sequence_remove (iter);
-      set->age += 1;
+  pos = gtk_constraint_variable_set_search (set, variable);
+  if (pos >= set->n_variables || set->variables[pos] != variable)
+    return FALSE;
 
-      return TRUE;
-    }
+  set->n_variables -= 1;
+  memmove (&set->variables[pos], &set->variables[pos + 1],
+           sizeof (GtkConstraintVariable *) * (set->n_variables - pos));
+
+  gtk_constraint_variable_unref (variable);
+
+  set->age += 1;
 
-  return FALSE;
+  return TRUE;
 }
 
 /*< private >
@@ -502,19 +550,20 @@ gtk_constraint_variable_set_remove (GtkConstraintVariableSet *set,
 int
 gtk_constraint_variable_set_size (GtkConstraintVariableSet *set)
 {
-  return g_sequence_get_length (set->set);
+  return set->n_variables;
 }
 
 gboolean
 gtk_constraint_variable_set_is_empty (GtkConstraintVariableSet *set)
 {
-  return g_sequence_is_empty (set->set);
+  return set->n_variables == 0;
 }
 
 gboolean
 gtk_constraint_variable_set_is_singleton (GtkConstraintVariableSet *set)
 {
-  return g_sequence_iter_next (g_sequence_get_begin_iter (set->set)) == g_sequence_get_end_iter (set->set);
+  /* An empty set has no variable other than the first one, either */
+  return set->n_variables <= 1;
 }
 
 /*< private >
@@ -525,7 +574,7 @@ gtk_constraint_variable_set_is_singleton (GtkConstraintVariableSet *set)
 /* Keep in sync with GtkConstraintVariableSetIter */
 typedef struct {
   GtkConstraintVariableSet *set;
-  GSequenceIter *iter;
+  gsize position;
   gint64 age;
 } RealVariableSetIter;
 
@@ -548,7 +597,7 @@ gtk_constraint_variable_set_iter_init (GtkConstraintVariableSetIter *iter,
   g_return_if_fail (set != NULL);
 
   riter->set = set;
-  riter->iter = g_sequence_get_begin_iter (set->set);
+  riter->position = 0;
   riter->age = set->age;
 }
 
@@ -572,11 +621,11 @@ gtk_constraint_variable_set_iter_next (GtkConstraintVariableSetIter *iter,
 
   g_assert (riter->age == riter->set->age);
 
-  if (g_sequence_iter_is_end (riter->iter))
+  if (riter->position >= riter->set->n_variables)
     return FALSE;
 
-  *variable_p = g_sequence_get (riter->iter);
-  riter->iter = g_sequence_iter_next (riter->iter);
+  *variable_p = riter->set->variables[riter->position];
+  riter->position += 1;
 
   return TRUE;
 }
@@ -628,8 +677,6 @@ gtk_constraint_variable_pair_free (GtkConstraintVariablePair *pair)
  * Term:
  * @variable: a #GtkConstraintVariable
  * @coefficient: the coefficient applied to the @variable
- * @next: the next term in the expression
- * @prev: the previous term in the expression;
  *
  * A tuple of (@variable, @coefficient) in an equation.
  *
@@ -640,55 +687,85 @@ typedef struct _Term Term;
 struct _Term {
   GtkConstraintVariable *variable;
   double coefficient;
-
-  Term *next;
-  Term *prev;
 };
 
-static Term *
-term_new (GtkConstraintVariable *variable,
-          double coefficient)
+/* Most rows in the tableau only have a few terms, so we store them
+ * inline in the expression, and only move them to the heap when the
+ * row grows
+ */
+#define N_INLINE_TERMS          4
+
+/* Rows larger than this get an index for looking up terms; smaller
+ * rows are scanned linearly, which is faster than hashing
+ */
+#define TERMS_INDEX_THRESHOLD   16
+
+struct _GtkConstraintExpression
 {
-  Term *res = g_new (Term, 1);
+  double constant;
 
-  res->variable = gtk_constraint_variable_ref (variable);
-  res->coefficient = coefficient;
-  res->next = res->prev = NULL;
+  /* Array<Term>, in insertion order; points to inline_terms until
+   * the expression grows past N_INLINE_TERMS
+   */
+  Term *terms;
+  guint n_terms;
+  guint n_allocated;
 
-  return res;
-}
+  /* HashTable<Variable, position + 1>; only built once the expression
+   * grows past TERMS_INDEX_THRESHOLD
+   */
+  GHashTable *index;
+
+  /* Used by GtkConstraintExpressionIter to guard against changes
+   * in the expression while iterating
+   */
+  gint64 age;
+
+  Term inline_terms[N_INLINE_TERMS];
+};
 
 static void
-term_free (gpointer data)
+gtk_constraint_expression_build_index (GtkConstraintExpression *self)
 {
-  Term *term = data;
+  guint i;
 
-  if (term == NULL)
-    return;
+  g_assert (self->index == NULL);
 
-  gtk_constraint_variable_unref (term->variable);
+  self->index = g_hash_table_new (NULL, NULL);
 
-  g_free (term);
+  for (i = 0; i < self->n_terms; i++)
+    g_hash_table_insert (self->index, self->terms[i].variable, GUINT_TO_POINTER (i + 1));
 }
 
-struct _GtkConstraintExpression
+static int
+gtk_constraint_expression_find_term (const GtkConstraintExpression *self,
+                                     const GtkConstraintVariable *variable)
 {
-  double constant;
+  guint i;
 
-  /* HashTable<Variable, Term>; the key is the term's variable,
-   * and the value is owned by the hash table
-   */
-  GHashTable *terms;
+  if (self->index != NULL)
+    return GPOINTER_TO_UINT (g_hash_table_lookup (self->index, variable)) - 1;
 
-  /* List of terms, in insertion order */
-  Term *first_term;
-  Term *last_term;
+  for (i = 0; i < self->n_terms; i++)
+    {
+      if (self->terms[i].variable == variable)
+        return i;
+    }
 
-  /* Used by GtkConstraintExpressionIter to guard against changes
-   * in the expression while iterating
-   */
-  gint64 age;
-};
+  return -1;
+}
+
+static inline Term *
+gtk_constraint_expression_lookup_term (const GtkConstraintExpression *self,
+                                       const GtkConstraintVariable *variable)
+{
+  int pos = gtk_constraint_expression_find_term (self, variable);
+
+  if (pos < 0)
+    return NULL;
+
+  return &self->terms[pos];
+}
 
 /*< private >
  * gtk_constraint_expression_add_term:
@@ -708,27 +785,29 @@ gtk_constraint_expression_add_term (GtkConstraintExpression *self,
 {
   Term *term;
 
-  if (self->terms == NULL)
+  if (self->n_terms == self->n_allocated)
     {
-      g_assert (self->first_term == NULL && self->last_term == NULL);
-      self->terms = g_hash_table_new_full (NULL, NULL,
-                                           NULL,
-                                           term_free);
-    }
-
-  term = term_new (variable, coefficient);
+      self->n_allocated *= 2;
 
-  g_hash_table_insert (self->terms, term->variable, term);
-
-  if (self->first_term == NULL)
-    self->first_term = term;
+      if (self->terms == self->inline_terms)
+        {
+          self->terms = g_new (Term, self->n_allocated);
+          memcpy (self->terms, self->inline_terms, sizeof (Term) * self->n_terms);
+        }
+      else
+        self->terms = g_renew (Term, self->terms, self->n_allocated);
+    }
 
-  term->prev = self->last_term;
+  term = &self->terms[self->n_terms];
+  term->variable = gtk_constraint_variable_ref (variable);
+  term->coefficient = coefficient;
 
-  if (self->last_term != NULL)
-    self->last_term->next = term;
+  self->n_terms += 1;
 
-  self->last_term = term;
+  if (self->index != NULL)
+    g_hash_table_insert (self->index, variable, GUINT_TO_POINTER (self->n_terms));
+  else if (self->n_terms > TERMS_INDEX_THRESHOLD)
+    gtk_constraint_expression_build_index (self);
 
   /* Increase the age of the expression, so that we can catch
    * mutations from within an iteration over the terms
@@ -740,48 +819,28 @@ static void
 gtk_constraint_expression_remove_term (GtkConstraintExpression *self,
                                        GtkConstraintVariable *variable)
 {
-  Term *term, *iter;
+  GtkConstraintVariable *term_variable;
+  guint i;
+  int pos;
 
-  if (self->terms == NULL)
+  pos = gtk_constraint_expression_find_term (self, variable);
+  if (pos < 0)
     return;
 
-  term = g_hash_table_lookup (self->terms, variable);
-  if (term == NULL)
-    return;
+  term_variable = self->terms[pos].variable;
 
-  /* Keep the variable alive for the duration of the function */
-  gtk_constraint_variable_ref (variable);
+  self->n_terms -= 1;
+  memmove (&self->terms[pos], &self->terms[pos + 1], sizeof (Term) * (self->n_terms - pos));
 
-  iter = self->first_term;
-  while (iter != NULL)
+  if (self->index != NULL)
     {
-      Term *next = iter->next;
-      Term *prev = iter->prev;
-
-      if (iter == term)
-        {
-          if (prev != NULL)
-            prev->next = next;
-          if (next != NULL)
-            next->prev = prev;
+      g_hash_table_remove (self->index, term_variable);
 
-          if (iter == self->first_term)
-            self->first_term = next;
-          if (iter == self->last_term)
-            self->last_term = prev;
-
-          iter->next = NULL;
-          iter->prev = NULL;
-
-          break;
-        }
-
-      iter = next;
+      for (i = pos; i < self->n_terms; i++)
+        g_hash_table_insert (self->index, self->terms[i].variable, GUINT_TO_POINTER (i + 1));
     }
 
-  g_hash_table_remove (self->terms, variable);
-
-  gtk_constraint_variable_unref (variable);
+  gtk_constraint_variable_unref (term_variable);
 
   self->age += 1;
 }
@@ -800,9 +859,10 @@ gtk_constraint_expression_new (double constant)
   GtkConstraintExpression *res = g_rc_box_new (GtkConstraintExpression);
 
   res->age = 0;
-  res->terms = NULL;
-  res->first_term = NULL;
-  res->last_term = NULL;
+  res->terms = res->inline_terms;
+  res->n_terms = 0;
+  res->n_allocated = N_INLINE_TERMS;
+  res->index = NULL;
   res->constant = constant;
 
   return res;
@@ -847,13 +907,21 @@ static void
 gtk_constraint_expression_clear (gpointer data)
 {
   GtkConstraintExpression *self = data;
+  guint i;
+
+  for (i = 0; i < self->n_terms; i++)
+    gtk_constraint_variable_unref (self->terms[i].variable);
 
-  g_clear_pointer (&self->terms, g_hash_table_unref);
+  if (self->terms != self->inline_terms)
+    g_free (self->terms);
+
+  g_clear_pointer (&self->index, g_hash_table_unref);
 
   self->age = 0;
   self->constant = 0.0;
-  self->first_term = NULL;
-  self->last_term = NULL;
+  self->terms = NULL;
+  self->n_terms = 0;
+  self->n_allocated = 0;
 }
 
 /*< private >
@@ -879,7 +947,7 @@ gtk_constraint_expression_unref (GtkConstraintExpression *expression)
 gboolean
 gtk_constraint_expression_is_constant (const GtkConstraintExpression *expression)
 {
-  return expression->terms == NULL;
+  return expression->n_terms == 0;
 }
 
 /*< private >
@@ -918,17 +986,14 @@ GtkConstraintExpression *
 gtk_constraint_expression_clone (GtkConstraintExpression *expression)
 {
   GtkConstraintExpression *res;
-  Term *iter;
+  guint i;
 
   res = gtk_constraint_expression_new (expression->constant);
 
-  iter = expression->first_term;
-  while (iter != NULL)
-    {
-      gtk_constraint_expression_add_term (res, iter->variable, iter->coefficient);
-
-      iter = iter->next;
-    }
+  for (i = 0; i < expression->n_terms; i++)
+    gtk_constraint_expression_add_term (res,
+                                        expression->terms[i].variable,
+                                        expression->terms[i].coefficient);
 
   return res;
 }
@@ -959,31 +1024,29 @@ gtk_constraint_expression_add_variable (GtkConstraintExpression *expression,
                                         GtkConstraintVariable *subject,
                                         GtkConstraintSolver *solver)
 {
+  Term *t;
+
   /* If the expression already contains the variable, update the coefficient */
-  if (expression->terms != NULL)
+  t = gtk_constraint_expression_lookup_term (expression, variable);
+  if (t != NULL)
     {
-      Term *t = g_hash_table_lookup (expression->terms, variable);
+      double new_coefficient = t->coefficient + coefficient;
 
-      if (t != NULL)
+      /* Setting the coefficient to 0 will remove the variable */
+      if (G_APPROX_VALUE (new_coefficient, 0.0, 0.001))
         {
-          double new_coefficient = t->coefficient + coefficient;
-
-          /* Setting the coefficient to 0 will remove the variable */
-          if (G_APPROX_VALUE (new_coefficient, 0.0, 0.001))
-            {
-              /* Update the tableau if needed */
-              if (solver != NULL)
-                gtk_constraint_solver_note_removed_variable (solver, variable, subject);
-
-              gtk_constraint_expression_remove_term (expression, variable);
-            }
-          else
-            {
-              t->coefficient = new_coefficient;
-            }
+          /* Update the tableau if needed */
+          if (solver != NULL)
+            gtk_constraint_solver_note_removed_variable (solver, variable, subject);
 
-          return;
+          gtk_constraint_expression_remove_term (expression, variable);
         }
+      else
+        {
+          t->coefficient = new_coefficient;
+        }
+
+      return;
     }
 
   /* Otherwise, add the variable if the coefficient is non-zero */
@@ -1029,15 +1092,12 @@ gtk_constraint_expression_set_variable (GtkConstraintExpression *expression,
                                         GtkConstraintVariable *variable,
                                         double coefficient)
 {
-  if (expression->terms != NULL)
-    {
-      Term *t = g_hash_table_lookup (expression->terms, variable);
+  Term *t = gtk_constraint_expression_lookup_term (expression, variable);
 
-      if (t != NULL)
-        {
-          t->coefficient = coefficient;
-          return;
-        }
+  if (t != NULL)
+    {
+      t->coefficient = coefficient;
+      return;
     }
 
   gtk_constraint_expression_add_term (expression, variable, coefficient);
@@ -1076,21 +1136,18 @@ gtk_constraint_expression_add_expression (GtkConstraintExpression *a_expr,
                                           GtkConstraintVariable *subject,
                                           GtkConstraintSolver *solver)
 {
-  Term *iter;
+  guint i;
 
   a_expr->constant += (n * b_expr->constant);
 
-  iter = b_expr->last_term;
-  while (iter != NULL)
+  for (i = b_expr->n_terms; i > 0; i--)
     {
-      Term *next = iter->prev;
+      const Term *t = &b_expr->terms[i - 1];
 
       gtk_constraint_expression_add_variable (a_expr,
-                                              iter->variable, n * iter->coefficient,
+                                              t->variable, n * t->coefficient,
                                               subject,
                                               solver);
-
-      iter = next;
     }
 }
 
@@ -1196,21 +1253,12 @@ GtkConstraintExpression *
 gtk_constraint_expression_multiply_by (GtkConstraintExpression *expression,
                                        double factor)
 {
-  GHashTableIter iter;
-  gpointer value_p;
+  guint i;
 
   expression->constant *= factor;
 
-  if (expression->terms == NULL)
-    return expression;
-
-  g_hash_table_iter_init (&iter, expression->terms);
-  while (g_hash_table_iter_next (&iter, NULL, &value_p))
-    {
-      Term *t = value_p;
-
-      t->coefficient *= factor;
-    }
+  for (i = 0; i < expression->n_terms; i++)
+    expression->terms[i].coefficient *= factor;
 
   return expression;
 }
@@ -1269,7 +1317,7 @@ gtk_constraint_expression_new_subject (GtkConstraintExpression *expression,
 
   g_assert (!gtk_constraint_expression_is_constant (expression));
 
-  term = g_hash_table_lookup (expression->terms, subject);
+  term = gtk_constraint_expression_lookup_term (expression, subject);
   g_assert (term != NULL);
   g_assert (!G_APPROX_VALUE (term->coefficient, 0.0, 0.001));
 
@@ -1334,10 +1382,7 @@ gtk_constraint_expression_get_coefficient (GtkConstraintExpression *expression,
   g_return_val_if_fail (expression != NULL, 0.0);
   g_return_val_if_fail (variable != NULL, 0.0);
 
-  if (expression->terms == NULL)
-    return 0.0;
-
-  term = g_hash_table_lookup (expression->terms, variable);
+  term = gtk_constraint_expression_lookup_term (expression, variable);
   if (term == NULL)
     return 0.0;
 
@@ -1365,9 +1410,9 @@ gtk_constraint_expression_substitute_out (GtkConstraintExpression *expression,
                                           GtkConstraintSolver *solver)
 {
   double multiplier;
-  Term *iter;
+  guint i;
 
-  if (expression->terms == NULL)
+  if (expression->n_terms == 0)
     return;
 
   multiplier = gtk_constraint_expression_get_coefficient (expression, out_var);
@@ -1375,18 +1420,15 @@ gtk_constraint_expression_substitute_out (GtkConstraintExpression *expression,
 
   expression->constant = expression->constant + multiplier * expr->constant;
 
-  iter = expr->first_term;
-  while (iter != NULL)
+  for (i = 0; i < expr->n_terms; i++)
     {
-      GtkConstraintVariable *clv = iter->variable;
-      double coeff = iter->coefficient;
-      Term *next = iter->next;
+      GtkConstraintVariable *clv = expr->terms[i].variable;
+      double coeff = expr->terms[i].coefficient;
+      Term *t = gtk_constraint_expression_lookup_term (expression, clv);
 
-      if (expression->terms != NULL &&
-          g_hash_table_contains (expression->terms, clv))
+      if (t != NULL)
         {
-          double old_coefficient = gtk_constraint_expression_get_coefficient (expression, clv);
-          double new_coefficient = old_coefficient + multiplier * coeff;
+          double new_coefficient = t->coefficient + multiplier * coeff;
 
           if (G_APPROX_VALUE (new_coefficient, 0.0, 0.001))
             {
@@ -1396,17 +1438,15 @@ gtk_constraint_expression_substitute_out (GtkConstraintExpression *expression,
               gtk_constraint_expression_remove_term (expression, clv);
             }
           else
-            gtk_constraint_expression_set_variable (expression, clv, new_coefficient);
+            t->coefficient = new_coefficient;
         }
       else
         {
-          gtk_constraint_expression_set_variable (expression, clv, multiplier * coeff);
+          gtk_constraint_expression_add_term (expression, clv, multiplier * coeff);
 
           if (solver != NULL)
             gtk_constraint_solver_note_added_variable (solver, clv, subject);
         }
-
-      iter = next;
     }
 }
 
@@ -1422,23 +1462,18 @@ gtk_constraint_expression_substitute_out (GtkConstraintExpression *expression,
 GtkConstraintVariable *
 gtk_constraint_expression_get_pivotable_variable (GtkConstraintExpression *expression)
 {
-  Term *iter;
+  guint i;
 
-  if (expression->terms == NULL)
+  if (expression->n_terms == 0)
     {
       g_critical ("Expression %p is a constant", expression);
       return NULL;
     }
 
-  iter = expression->first_term;
-  while (iter != NULL)
+  for (i = 0; i < expression->n_terms; i++)
     {
-      Term *next = iter->next;
-
-      if (gtk_constraint_variable_is_pivotable (iter->variable))
-        return iter->variable;
-
-      iter = next;
+      if (gtk_constraint_variable_is_pivotable (expression->terms[i].variable))
+        return expression->terms[i].variable;
     }
 
   return NULL;
@@ -1459,7 +1494,7 @@ gtk_constraint_expression_to_string (const GtkConstraintExpression *expression)
 {
   gboolean needs_plus = FALSE;
   GString *buf;
-  Term *iter;
+  guint i;
 
   if (expression == NULL)
     return g_strdup ("<null>");
@@ -1470,33 +1505,27 @@ gtk_constraint_expression_to_string (const GtkConstraintExpression *expression)
     {
       g_string_append_printf (buf, "%g", expression->constant);
 
-      if (expression->terms != NULL)
+      if (expression->n_terms > 0)
         needs_plus = TRUE;
     }
 
-  if (expression->terms == NULL)
-    return g_string_free (buf, FALSE);
-
-  iter = expression->first_term;
-  while (iter != NULL)
+  for (i = 0; i < expression->n_terms; i++)
     {
-      char *str = gtk_constraint_variable_to_string (iter->variable);
-      Term *next = iter->next;
+      const Term *t = &expression->terms[i];
+      char *str = gtk_constraint_variable_to_string (t->variable);
 
       if (needs_plus)
         g_string_append (buf, " + ");
 
-      if (G_APPROX_VALUE (iter->coefficient, 1.0, 0.001))
+      if (G_APPROX_VALUE (t->coefficient, 1.0, 0.001))
         g_string_append_printf (buf, "%s", str);
       else
-        g_string_append_printf (buf, "(%g * %s)", iter->coefficient, str);
+        g_string_append_printf (buf, "(%g * %s)", t->coefficient, str);
 
       g_free (str);
 
       if (!needs_plus)
         needs_plus = TRUE;
-
-      iter = next;
     }
 
   return g_string_free (buf, FALSE);
@@ -1505,7 +1534,7 @@ gtk_constraint_expression_to_string (const GtkConstraintExpression *expression)
 /* Keep in sync with GtkConstraintExpressionIter */
 typedef struct {
   GtkConstraintExpression *expression;
-  Term *current;
+  gssize position;
   gint64 age;
 } RealExpressionIter;
 
@@ -1525,7 +1554,7 @@ gtk_constraint_expression_iter_init (GtkConstraintExpressionIter *iter,
   RealExpressionIter *riter = REAL_EXPRESSION_ITER (iter);
 
   riter->expression = expression;
-  riter->current = NULL;
+  riter->position = -1;
   riter->age = expression->age;
 }
 
@@ -1550,18 +1579,21 @@ gtk_constraint_expression_iter_next (GtkConstraintExpressionIter *iter,
 
   g_assert (riter->age == riter->expression->age);
 
-  if (riter->current == NULL)
-    riter->current = riter->expression->first_term;
+  if (riter->position < 0)
+    riter->position = 0;
   else
-    riter->current = riter->current->next;
+    riter->position += 1;
 
-  if (riter->current != NULL)
+  if ((gsize) riter->position >= riter->expression->n_terms)
     {
-      *coefficient = riter->current->coefficient;
-      *variable = riter->current->variable;
+      riter->position = -1;
+      return FALSE;
     }
 
-  return riter->current != NULL;
+  *coefficient = riter->expression->terms[riter->position].coefficient;
+  *variable = riter->expression->terms[riter->position].variable;
+
+  return TRUE;
 }
 
 /*< private >
@@ -1585,18 +1617,18 @@ gtk_constraint_expression_iter_prev (GtkConstraintExpressionIter *iter,
 
   g_assert (riter->age == riter->expression->age);
 
-  if (riter->current == NULL)
-    riter->current = riter->expression->last_term;
-  else
-    riter->current = riter->current->prev;
+  if (riter->position < 0)
+    riter->position = riter->expression->n_terms;
 
-  if (riter->current != NULL)
-    {
-      *coefficient = riter->current->coefficient;
-      *variable = riter->current->variable;
-    }
+  riter->position -= 1;
 
-  return riter->current != NULL;
+  if (riter->position < 0)
+    return FALSE;
+
+  *coefficient = riter->expression->terms[riter->position].coefficient;
+  *variable = riter->expression->terms[riter->position].variable;
+
+  return TRUE;
 }
 
 typedef enum {
@@ -256,6 +256,17 @@ struct _GtkConstraintLayout
 
   GListStore *constraints_observer;
   GListStore *guides_observer;
+
+  /* The required stay constraints that keep the layout at its
+   * allocated size; they stay in the solver across allocations
+   * until the layout is measured or its constraints change.
+   */
+  GtkConstraintRef *stay_top;
+  GtkConstraintRef *stay_left;
+  GtkConstraintRef *stay_width;
+  GtkConstraintRef *stay_height;
+  int stay_width_value;
+  int stay_height_value;
 };
 
 G_DEFINE_TYPE (GtkConstraintLayoutChild, gtk_constraint_layout_child, GTK_TYPE_LAYOUT_CHILD)
@@ -282,6 +293,37 @@ gtk_constraint_layout_get_solver (GtkConstraintLayout *self)
   return self->solver;
 }
 
+/*< private >
+ * gtk_constraint_layout_clear_allocation:
+ * @layout: a #GtkConstraintLayout
+ *
+ * Removes the stay constraints that keep the layout at its
+ * allocated size from the solver. This needs to happen before
+ * measuring the layout or changing its constraints.
+ */
+void
+gtk_constraint_layout_clear_allocation (GtkConstraintLayout *layout)
+{
+  GtkConstraintRef **stays[] = {
+    &layout->stay_top,
+    &layout->stay_left,
+    &layout->stay_width,
+    &layout->stay_height,
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (stays); i++)
+    {
+      if (*stays[i] == NULL)
+        continue;
+
+      if (layout->solver != NULL)
+        gtk_constraint_solver_remove_constraint (layout->solver, *stays[i]);
+
+      *stays[i] = NULL;
+    }
+}
+
 static const char * const attribute_names[] = {
   [GTK_CONSTRAINT_ATTRIBUTE_NONE]     = "none",
   [GTK_CONSTRAINT_ATTRIBUTE_LEFT]     = "left",
@@ -550,6 +592,8 @@ gtk_constraint_layout_finalize (GObject *gobject)
                                     (gpointer *)&self->guides_observer);
     }
 
+  gtk_constraint_layout_clear_allocation (self);
+
   g_clear_pointer (&self->bound_attributes, g_hash_table_unref);
   g_clear_pointer (&self->constraints, g_hash_table_unref);
   g_clear_pointer (&self->guides, g_hash_table_unref);
@@ -763,6 +807,8 @@ layout_add_constraint (GtkConstraintLayout *self,
   if (solver == NULL)
     return;
 
+  gtk_constraint_layout_clear_allocation (self);
+
   attr = gtk_constraint_get_target_attribute (constraint);
   target = gtk_constraint_get_target (constraint);
   if (target == NULL || target == GTK_CONSTRAINT_TARGET (layout_widget))
@@ -921,6 +967,9 @@ gtk_constraint_layout_measure (GtkLayoutManager *manager,
   if (solver == NULL)
     return;
 
+  /* The size is not bound to the allocation while measuring */
+  gtk_constraint_layout_clear_allocation (self);
+
   gtk_constraint_solver_freeze (solver);
 
   /* We measure each child in the layout and impose restrictions on the
@@ -1012,7 +1061,6 @@ gtk_constraint_layout_allocate (GtkLayoutManager *manager,
                                 int               baseline)
 {
   GtkConstraintLayout *self = GTK_CONSTRAINT_LAYOUT (manager);
-  GtkConstraintRef *stay_w, *stay_h, *stay_t, *stay_l;
   GtkConstraintSolver *solver;
   GtkConstraintVariable *layout_top, *layout_height;
   GtkConstraintVariable *layout_left, *layout_width;
@@ -1023,29 +1071,49 @@ gtk_constraint_layout_allocate (GtkLayoutManager *manager,
     return;
 
   /* We add required stay constraints to ensure that the layout remains
-   * within the bounds of the allocation
+   * within the bounds of the allocation. They are kept around, so that
+   * allocating the same size again does not need to touch the tableau.
    */
   layout_top = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_TOP);
   layout_left = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_LEFT);
   layout_width = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_WIDTH);
   layout_height = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_HEIGHT);
 
-  gtk_constraint_variable_set_value (layout_top, 0.0);
-  stay_t = gtk_constraint_solver_add_stay_variable (solver,
-                                                    layout_top,
-                                                    GTK_CONSTRAINT_STRENGTH_REQUIRED);
-  gtk_constraint_variable_set_value (layout_left, 0.0);
-  stay_l = gtk_constraint_solver_add_stay_variable (solver,
-                                                    layout_left,
-                                                    GTK_CONSTRAINT_STRENGTH_REQUIRED);
-  gtk_constraint_variable_set_value (layout_width, width);
-  stay_w = gtk_constraint_solver_add_stay_variable (solver,
-                                                    layout_width,
-                                                    GTK_CONSTRAINT_STRENGTH_REQUIRED);
-  gtk_constraint_variable_set_value (layout_height, height);
-  stay_h = gtk_constraint_solver_add_stay_variable (solver,
-                                                    layout_height,
-                                                    GTK_CONSTRAINT_STRENGTH_REQUIRED);
+  if (self->stay_top == NULL)
+    {
+      gtk_constraint_variable_set_value (layout_top, 0.0);
+      self->stay_top = gtk_constraint_solver_add_stay_variable (solver,
+                                                                layout_top,
+                                                                GTK_CONSTRAINT_STRENGTH_REQUIRED);
+    }
+  if (self->stay_left == NULL)
+    {
+      gtk_constraint_variable_set_value (layout_left, 0.0);
+      self->stay_left = gtk_constraint_solver_add_stay_variable (solver,
+                                                                 layout_left,
+                                                                 GTK_CONSTRAINT_STRENGTH_REQUIRED);
+    }
+  if (self->stay_width == NULL || self->stay_width_value != width)
+    {
+      if (self->stay_width != NULL)
+        gtk_constraint_solver_remove_constraint (solver, self->stay_width);
+      gtk_constraint_variable_set_value (layout_width, width);
+      self->stay_width = gtk_constraint_solver_add_stay_variable (solver,
+                                                                  layout_width,
+                                                                  GTK_CONSTRAINT_STRENGTH_REQUIRED);
+      self->stay_width_value = width;
+    }
+  if (self->stay_height == NULL || self->stay_height_value != height)
+    {
+      if (self->stay_height != NULL)
+        gtk_constraint_solver_remove_constraint (solver, self->stay_height);
+      gtk_constraint_variable_set_value (layout_height, height);
+      self->stay_height = gtk_constraint_solver_add_stay_variable (solver,
+                                                                   layout_height,
+                                                                   GTK_CONSTRAINT_STRENGTH_REQUIRED);
+      self->stay_height_value = height;
+    }
+
   GTK_NOTE (LAYOUT,
             g_print ("Layout [%p]: { .x: %g, .y: %g, .w: %g, .h: %g }\n",
                      self,
@@ -1118,12 +1186,6 @@ gtk_constraint_layout_allocate (GtkLayoutManager *manager,
         }
     }
 #endif
-
-  /* The allocation stay constraints are not needed any more */
-  gtk_constraint_solver_remove_constraint (solver, stay_w);
-  gtk_constraint_solver_remove_constraint (solver, stay_h);
-  gtk_constraint_solver_remove_constraint (solver, stay_t);
-  gtk_constraint_solver_remove_constraint (solver, stay_l);
 }
 
 static void
@@ -1163,6 +1225,8 @@ gtk_constraint_layout_unroot (GtkLayoutManager *manager)
   GHashTableIter iter;
   gpointer key;
 
+  gtk_constraint_layout_clear_allocation (self);
+
   /* Detach all constraints we're holding, as we're removing the layout
    * from the global solver, and they should not contribute to the other
    * layouts
@@ -34,4 +34,7 @@ gtk_constraint_layout_get_attribute (GtkConstraintLayout    *layout,
                                      GtkWidget              *widget,
                                      GHashTable             *bound_attributes);
 
+void
+gtk_constraint_layout_clear_allocation (GtkConstraintLayout *layout);
+
 G_END_DECLS
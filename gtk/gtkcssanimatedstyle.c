@@ -162,6 +162,15 @@ gtk_css_animated_style_set_animated_value (GtkCssAnimatedStyle *animated,
   gtk_internal_return_if_fail (GTK_IS_CSS_ANIMATED_STYLE (style));
   gtk_internal_return_if_fail (value != NULL);
 
+  /* Keep sharing the group with the base style while an animation
+   * holds a value, like during a delay or a constant keyframe, so the
+   * style change for this tick doesn't need to look at the group. */
+  if (_gtk_css_value_equal (gtk_css_style_get_value (style, id), value))
+    {
+      gtk_css_value_unref (value);
+      return;
+    }
+
   switch (id)
     {
     case GTK_CSS_PROPERTY_COLOR:
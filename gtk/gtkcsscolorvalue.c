@@ -345,13 +345,19 @@ apply_mix (const GdkRGBA *in1,
     }
 }
 
+/* Resolving a symbolic color remembers the last result, so that
+ * styles computed from the same colors share their values. Colors
+ * are resolved on several threads at once, see gtkcssnode.c.
+ */
+G_LOCK_DEFINE_STATIC (last_value);
+
 GtkCssValue *
 _gtk_css_color_value_resolve (GtkCssValue      *color,
                               GtkStyleProvider *provider,
                               GtkCssValue      *current,
                               GSList           *cycle_list)
 {
-  GtkCssValue *value;
+  GtkCssValue *value, *old_value;
 
   gtk_internal_return_val_if_fail (color != NULL, NULL);
 
@@ -466,18 +472,22 @@ _gtk_css_color_value_resolve (GtkCssValue      *color,
       g_assert_not_reached ();
     }
 
+  G_LOCK (last_value);
   if (color->last_value != NULL &&
       _gtk_css_value_equal (color->last_value, value))
     {
-      _gtk_css_value_unref (value);
+      old_value = value;
       value = _gtk_css_value_ref (color->last_value);
     }
   else
     {
-      if (color->last_value != NULL)
-        _gtk_css_value_unref (color->last_value);
+      old_value = color->last_value;
       color->last_value = _gtk_css_value_ref (value);
     }
+  G_UNLOCK (last_value);
+
+  if (old_value != NULL)
+    _gtk_css_value_unref (old_value);
 
   return value;
 }
@@ -217,6 +217,9 @@ gtk_css_font_size_get_default_px (GtkStyleProvider *provider,
   GtkSettings *settings;
   int font_size;
 
+  if (gtk_css_value_compute_needs_main_thread ())
+    return DEFAULT_FONT_SIZE_PT * get_dpi (style) / 72.0;
+
   settings = gtk_style_provider_get_settings (provider);
   if (settings == NULL)
     return DEFAULT_FONT_SIZE_PT * get_dpi (style) / 72.0;
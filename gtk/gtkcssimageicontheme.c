@@ -24,6 +24,7 @@
 #include <math.h>
 
 #include "gtk/css/gtkcssserializerprivate.h"
+#include "gtkcssvalueprivate.h"
 #include "gtksettingsprivate.h"
 #include "gtksnapshot.h"
 #include "gtkstyleproviderprivate.h"
@@ -149,6 +150,9 @@ gtk_css_image_icon_theme_compute (GtkCssImage      *image,
   GtkSettings *settings;
   GdkDisplay *display;
 
+  if (gtk_css_value_compute_needs_main_thread ())
+    return g_object_ref (image);
+
   copy = g_object_new (GTK_TYPE_CSS_IMAGE_ICON_THEME, NULL);
   copy->name = g_strdup (icon_theme->name);
   settings = gtk_style_provider_get_settings (provider);
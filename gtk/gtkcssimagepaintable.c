@@ -21,6 +21,7 @@
 
 #include "gtkcssimagepaintableprivate.h"
 
+#include "gtkcssvalueprivate.h"
 #include "gtkprivate.h"
 
 G_DEFINE_TYPE (GtkCssImagePaintable, gtk_css_image_paintable, GTK_TYPE_CSS_IMAGE)
@@ -102,6 +103,13 @@ gtk_css_image_paintable_compute (GtkCssImage      *image,
                                  GtkCssStyle      *style,
                                  GtkCssStyle      *parent_style)
 {
+  GtkCssImagePaintable *paintable = GTK_CSS_IMAGE_PAINTABLE (image);
+
+  /* Textures never change, other paintables are application code */
+  if (!GDK_IS_TEXTURE (paintable->paintable) &&
+      gtk_css_value_compute_needs_main_thread ())
+    return g_object_ref (image);
+
   return gtk_css_image_paintable_get_static_image (image);
 }
 
@@ -23,6 +23,7 @@
 #include "gtkcssimageprivate.h"
 #include "gtkcsspalettevalueprivate.h"
 #include "gtkcsscolorvalueprivate.h"
+#include "gtkcssvalueprivate.h"
 #include "gtkiconthemeprivate.h"
 #include "gdkpixbufutilsprivate.h"
 
@@ -172,25 +173,18 @@ gtk_css_image_recolor_snapshot (GtkCssImage *image,
                                 double       height)
 {
   GtkCssImageRecolor *recolor = GTK_CSS_IMAGE_RECOLOR (image);
-  const GdkRGBA *fg = &recolor->color;
-  const GdkRGBA *sc = &recolor->success;
-  const GdkRGBA *wc = &recolor->warning;
-  const GdkRGBA *ec = &recolor->error;
   graphene_matrix_t matrix;
   graphene_vec4_t offset;
 
   if (recolor->texture == NULL)
     return;
 
-  graphene_matrix_init_from_float (&matrix,
-          (float[16]) {
-                       sc->red - fg->red, sc->green - fg->green, sc->blue - fg->blue, 0,
-                       wc->red - fg->red, wc->green - fg->green, wc->blue - fg->blue, 0,
-                       ec->red - fg->red, ec->green - fg->green, ec->blue - fg->blue, 0,
-                       0, 0, 0, fg->alpha
-                      });
+  if (recolor->color.alpha == 0.0f)
+    return;
 
-  graphene_vec4_init (&offset, fg->red, fg->green, fg->blue, 0);
+  gtk_icon_theme_init_symbolic_color_matrix (&matrix, &offset,
+                                             &recolor->color, &recolor->success,
+                                             &recolor->warning, &recolor->error);
   gtk_snapshot_push_color_matrix (snapshot, &matrix, &offset);
 
   gtk_snapshot_append_texture (snapshot,
@@ -213,6 +207,9 @@ gtk_css_image_recolor_compute (GtkCssImage      *image,
   int scale;
   GError *error = NULL;
 
+  if (recolor->texture == NULL && gtk_css_value_compute_needs_main_thread ())
+    return g_object_ref (image);
+
   scale = gtk_style_provider_get_scale (provider);
 
   if (recolor->palette)
@@ -25,12 +25,57 @@
 
 #include "gtkcssimageinvalidprivate.h"
 #include "gtkcssimagepaintableprivate.h"
+#include "gtkcssvalueprivate.h"
 #include "gtkstyleproviderprivate.h"
 
 #include "gtk/css/gtkcssdataurlprivate.h"
 
 G_DEFINE_TYPE (GtkCssImageUrl, _gtk_css_image_url, GTK_TYPE_CSS_IMAGE)
 
+/* Images that are loaded right now, by file. Every url() for the same
+ * file shares the decoded texture, even across style providers and
+ * theme reloads, as long as one of them is still alive. The images
+ * are not owned by the table, they remove themselves when finalized.
+ */
+static GHashTable *loaded_images;
+
+static void
+loaded_image_finalized (gpointer  data,
+                        GObject  *image)
+{
+  g_hash_table_remove (loaded_images, data);
+}
+
+static GtkCssImage *
+gtk_css_image_url_lookup_loaded (GFile *file)
+{
+  GtkCssImage *image;
+
+  if (loaded_images == NULL)
+    return NULL;
+
+  image = g_hash_table_lookup (loaded_images, file);
+  if (image == NULL)
+    return NULL;
+
+  return g_object_ref (image);
+}
+
+static void
+gtk_css_image_url_add_loaded (GFile       *file,
+                              GtkCssImage *image)
+{
+  GFile *key;
+
+  if (G_UNLIKELY (loaded_images == NULL))
+    loaded_images = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                           g_object_unref, NULL);
+
+  key = g_object_ref (file);
+  g_hash_table_insert (loaded_images, key, image);
+  g_object_weak_ref (G_OBJECT (image), loaded_image_finalized, key);
+}
+
 static GtkCssImage *
 gtk_css_image_url_load_image (GtkCssImageUrl  *url,
                               GError         **error)
@@ -38,6 +83,10 @@ gtk_css_image_url_load_image (GtkCssImageUrl  *url,
   GdkTexture *texture;
   GError *local_error = NULL;
 
+  if (url->loaded_image)
+    return url->loaded_image;
+
+  url->loaded_image = gtk_css_image_url_lookup_loaded (url->file);
   if (url->loaded_image)
     return url->loaded_image;
 
@@ -78,6 +127,7 @@ gtk_css_image_url_load_image (GtkCssImageUrl  *url,
   else
     {
       url->loaded_image = gtk_css_image_paintable_new (GDK_PAINTABLE (texture), GDK_PAINTABLE (texture));
+      gtk_css_image_url_add_loaded (url->file, url->loaded_image);
       g_object_unref (texture);
     }
 
@@ -132,6 +182,9 @@ gtk_css_image_url_compute (GtkCssImage      *image,
   GtkCssImage *copy;
   GError *error = NULL;
 
+  if (url->loaded_image == NULL && gtk_css_value_compute_needs_main_thread ())
+    return g_object_ref (image);
+
   copy = gtk_css_image_url_load_image (url, &error);
   if (error)
     {
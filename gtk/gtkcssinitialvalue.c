@@ -49,6 +49,9 @@ gtk_css_value_initial_compute (GtkCssValue      *value,
   switch (property_id)
     {
     case GTK_CSS_PROPERTY_DPI:
+      if (gtk_css_value_compute_needs_main_thread ())
+        break;
+
       settings = gtk_style_provider_get_settings (provider);
       if (settings)
         {
@@ -62,6 +65,8 @@ gtk_css_value_initial_compute (GtkCssValue      *value,
       break;
 
     case GTK_CSS_PROPERTY_FONT_FAMILY:
+      if (gtk_css_value_compute_needs_main_thread ())
+        break;
       settings = gtk_style_provider_get_settings (provider);
       if (settings && gtk_settings_get_font_family (settings) != NULL)
         return _gtk_css_string_value_new (gtk_settings_get_font_family (settings));
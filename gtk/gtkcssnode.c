@@ -28,6 +28,8 @@
 #include "gtktypebuiltins.h"
 #include "gtkprivate.h"
 #include "gdkprofilerprivate.h"
+#include "gdktelemetryprivate.h"
+#include "gdk/gdkparallelprivate.h"
 
 /*
  * CSS nodes are the backbone of the GtkStyleContext implementation and
@@ -322,6 +324,7 @@ lookup_in_global_parent_cache (GtkCssNode                  *node,
   g_assert (node->cache == NULL);
   node->cache = gtk_css_node_style_cache_lookup (parent->cache,
                                                  decl,
+                                                 node,
                                                  gtk_css_node_is_first_child (node),
                                                  gtk_css_node_is_last_child (node));
   if (node->cache == NULL)
@@ -350,27 +353,340 @@ store_in_global_parent_cache (GtkCssNode                  *node,
 
   node->cache = gtk_css_node_style_cache_insert (parent->cache,
                                                  (GtkCssNodeDeclaration *) decl,
+                                                 node,
                                                  gtk_css_node_is_first_child (node),
                                                  gtk_css_node_is_last_child (node),
                                                  style);
 }
 
+static gboolean
+gtk_css_style_needs_recreation (GtkCssStyle  *style,
+                                GtkCssChange  change)
+{
+  gtk_internal_return_val_if_fail (GTK_IS_CSS_STATIC_STYLE (style), TRUE);
+
+  /* Try to avoid invalidating if we can */
+  if (change & GTK_CSS_RADICAL_CHANGE)
+    return TRUE;
+
+  if (gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style)) & change)
+    return TRUE;
+  else
+    return FALSE;
+}
+
+/* Restyling in parallel
+ *
+ * When a large part of the tree needs new styles, like after a theme
+ * change or when a big window is shown for the first time, validation
+ * computes the static styles of the nodes below the one it is at on
+ * the thread pool before it goes on. Only the lookup and computation
+ * happen there. Setting the style, creating animations and emitting
+ * style-changed stays on the main thread, in the same order as before.
+ *
+ * A precomputed style is only used if everything it was computed from
+ * is still the same when the walk gets to the node: the declaration,
+ * the style provider, the change flags and the parent's style. So
+ * nodes whose parent ends up with a different style, like an animated
+ * one, are computed again by the walk. So are those that use values
+ * that can only be computed on the main thread, see
+ * gtk_css_value_compute_needs_main_thread(). If the walk reaches such
+ * a node with a big subtree, it precomputes that subtree again.
+ */
+
+/* Fewer nodes than this are not worth waking up other threads for */
+#define PARALLEL_RESTYLE_MIN_NODES 64
+
+typedef struct _GtkCssRestyle GtkCssRestyle;
+typedef struct _GtkCssRestyleJob GtkCssRestyleJob;
+
+struct _GtkCssRestyleJob
+{
+  GtkCssNode *node;
+  GtkCssRestyleJob *parent;       /* job of the parent node, if any */
+  GPtrArray *children;            /* jobs of child nodes */
+  guint n_descendants;            /* number of jobs below this one */
+
+  /* What the style is computed from */
+  GtkCssNodeDeclaration *decl;
+  GtkStyleProvider *provider;
+  GtkCssChange change;
+  GtkCssStyle *parent_style;
+
+  GtkCssStyle *style;             /* NULL if not computed */
+};
+
+struct _GtkCssRestyle
+{
+  GHashTable *jobs;               /* GtkCssNode => GtkCssRestyleJob */
+  GHashTable *pending;            /* nodes whose children could not be precomputed yet */
+};
+
+/* Set during gtk_css_node_validate() if restyling in parallel is possible */
+static GtkCssRestyle *current_restyle;
+
+static void
+gtk_css_restyle_job_free (gpointer data)
+{
+  GtkCssRestyleJob *job = data;
+
+  g_ptr_array_unref (job->children);
+  gtk_css_node_declaration_unref (job->decl);
+  g_object_unref (job->provider);
+  g_clear_object (&job->parent_style);
+  g_clear_object (&job->style);
+
+  g_slice_free (GtkCssRestyleJob, job);
+}
+
+static GtkCssRestyleJob *
+gtk_css_restyle_job_new (GtkCssNode       *node,
+                         GtkCssRestyleJob *parent)
+{
+  GtkCssRestyleJob *job;
+
+  job = g_slice_new0 (GtkCssRestyleJob);
+  job->node = node;
+  job->parent = parent;
+  job->children = g_ptr_array_new ();
+  job->decl = gtk_css_node_declaration_ref (node->decl);
+  job->provider = g_object_ref (gtk_css_node_get_style_provider (node));
+
+  /* Same as in gtk_css_node_create_style() */
+  if (node->pending_changes & GTK_CSS_CHANGE_NEEDS_RECOMPUTE)
+    job->change = 0;
+  else
+    job->change = gtk_css_static_style_get_change (gtk_css_style_get_static_style (node->style));
+
+  /* A parent with a job gets its style on another thread */
+  if (parent == NULL)
+    job->parent_style = g_object_ref (node->parent->style);
+
+  return job;
+}
+
+static void gtk_css_restyle_job_run_func (gpointer data,
+                                          gpointer unused);
+
+/* Runs on any thread, with the main thread waiting */
+static void
+gtk_css_restyle_job_run (GtkCssRestyleJob       *job,
+                         GtkCountingBloomFilter *filter)
+{
+  guint i;
+
+  if (job->parent)
+    {
+      if (job->parent->style == NULL)
+        return;
+
+      job->parent_style = g_object_ref (job->parent->style);
+    }
+
+  job->style = gtk_css_static_style_new_compute_threaded (job->provider,
+                                                          filter,
+                                                          job->node,
+                                                          job->parent_style,
+                                                          job->change);
+  if (job->style == NULL || job->children->len == 0)
+    return;
+
+  /* Hand the children of big subtrees to other threads,
+   * the pool runs them here if no thread is free */
+  if (job->children->len > 1 &&
+      job->n_descendants >= PARALLEL_RESTYLE_MIN_NODES)
+    {
+      gdk_parallel_run (job->children->pdata,
+                        sizeof (gpointer),
+                        job->children->len,
+                        gtk_css_restyle_job_run_func,
+                        NULL);
+      return;
+    }
+
+  gtk_css_node_declaration_add_bloom_hashes (job->decl, filter);
+
+  for (i = 0; i < job->children->len; i++)
+    gtk_css_restyle_job_run (g_ptr_array_index (job->children, i), filter);
+
+  gtk_css_node_declaration_remove_bloom_hashes (job->decl, filter);
+}
+
+static void
+gtk_css_restyle_job_run_func (gpointer data,
+                              gpointer unused)
+{
+  GtkCssRestyleJob *job = *(GtkCssRestyleJob **) data;
+  GtkCountingBloomFilter filter = GTK_COUNTING_BLOOM_FILTER_INIT;
+  GtkCssNode *parent;
+
+  for (parent = job->node->parent; parent; parent = parent->parent)
+    gtk_css_node_declaration_add_bloom_hashes (parent->decl, &filter);
+
+  gtk_css_restyle_job_run (job, &filter);
+}
+
+/* Creates jobs for the nodes below @node that will get a new style,
+ * as far as the style their parent ends up with is known. Jobs for
+ * the children of @node go into @jobs.
+ *
+ * Returns: the number of jobs created
+ */
+static guint
+gtk_css_restyle_collect (GtkCssRestyle    *restyle,
+                         GtkCssNode       *node,
+                         GtkCssRestyleJob *job,
+                         GPtrArray        *jobs)
+{
+  GtkCssRestyleJob *child_job;
+  GtkCssNode *child;
+  guint n_jobs = 0;
+
+  if (job == NULL && node->style_is_invalid)
+    {
+      /* The parent style is only known once the walk gets here */
+      g_hash_table_add (restyle->pending, node);
+      return 0;
+    }
+
+  for (child = node->first_child; child; child = child->next_sibling)
+    {
+      /* Like gtk_css_node_validate_internal() */
+      if (!child->visible || !child->invalid)
+        continue;
+
+      if (child->style_is_invalid &&
+          gtk_css_style_needs_recreation (GTK_CSS_STYLE (gtk_css_style_get_static_style (child->style)),
+                                          child->pending_changes))
+        {
+          child_job = gtk_css_restyle_job_new (child, job);
+          g_hash_table_replace (restyle->jobs, child, child_job);
+          g_ptr_array_add (jobs, child_job);
+
+          child_job->n_descendants = gtk_css_restyle_collect (restyle, child, child_job, child_job->children);
+          n_jobs += 1 + child_job->n_descendants;
+        }
+      else
+        {
+          n_jobs += gtk_css_restyle_collect (restyle, child, NULL, jobs);
+        }
+    }
+
+  return n_jobs;
+}
+
+static void
+gtk_css_restyle_drop_jobs (GtkCssRestyle *restyle,
+                           GPtrArray     *jobs)
+{
+  guint i;
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      GtkCssRestyleJob *job = g_ptr_array_index (jobs, i);
+
+      gtk_css_restyle_drop_jobs (restyle, job->children);
+      g_hash_table_remove (restyle->jobs, job->node);
+    }
+
+  g_ptr_array_set_size (jobs, 0);
+}
+
+/* Called by the walk when @cssnode has its new style, before it goes
+ * on to the children.
+ */
+static void
+gtk_css_node_precompute_styles (GtkCssNode *cssnode)
+{
+  GtkCssRestyle *restyle = current_restyle;
+  GtkCssRestyleJob *job;
+  GPtrArray *jobs;
+  guint n_jobs;
+
+  if (restyle == NULL || cssnode->first_child == NULL)
+    return;
+
+  job = g_hash_table_lookup (restyle->jobs, cssnode);
+  if (job)
+    {
+      /* The children were computed for the style we have, or are
+       * too few to compute again */
+      if (job->style == cssnode->style ||
+          job->n_descendants < PARALLEL_RESTYLE_MIN_NODES)
+        return;
+
+      gtk_css_restyle_drop_jobs (restyle, job->children);
+    }
+  else if (!g_hash_table_remove (restyle->pending, cssnode))
+    {
+      return;
+    }
+
+  jobs = g_ptr_array_new ();
+
+  n_jobs = gtk_css_restyle_collect (restyle, cssnode, NULL, jobs);
+  if (n_jobs >= PARALLEL_RESTYLE_MIN_NODES)
+    gdk_parallel_run (jobs->pdata,
+                      sizeof (gpointer),
+                      jobs->len,
+                      gtk_css_restyle_job_run_func,
+                      NULL);
+  else
+    gtk_css_restyle_drop_jobs (restyle, jobs);
+
+  g_ptr_array_unref (jobs);
+}
+
+static GtkCssStyle *
+gtk_css_node_get_precomputed_style (GtkCssNode       *cssnode,
+                                    GtkStyleProvider *provider,
+                                    GtkCssChange      change)
+{
+  GtkCssRestyleJob *job;
+
+  if (current_restyle == NULL)
+    return NULL;
+
+  job = g_hash_table_lookup (current_restyle->jobs, cssnode);
+  if (job == NULL || job->style == NULL)
+    return NULL;
+
+  if (job->decl != cssnode->decl ||
+      job->provider != provider ||
+      job->change != change ||
+      cssnode->parent == NULL ||
+      job->parent_style != cssnode->parent->style)
+    return NULL;
+
+  return g_object_ref (job->style);
+}
+
+/* Precomputed styles depend on the declarations of the ancestors and
+ * on the position among the siblings, so any change to the tree
+ * makes them useless.
+ */
+static void
+gtk_css_node_discard_precomputed_styles (void)
+{
+  if (current_restyle == NULL)
+    return;
+
+  g_hash_table_remove_all (current_restyle->jobs);
+  g_hash_table_remove_all (current_restyle->pending);
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode                   *cssnode,
                            const GtkCountingBloomFilter *filter,
                            GtkCssChange                  change)
 {
   const GtkCssNodeDeclaration *decl;
+  GtkStyleProvider *provider;
   GtkCssStyle *style;
   GtkCssChange style_change;
 
   decl = gtk_css_node_get_declaration (cssnode);
-
-  style = lookup_in_global_parent_cache (cssnode, decl);
-  if (style)
-    return g_object_ref (style);
-
-  created_styles++;
+  provider = gtk_css_node_get_style_provider (cssnode);
 
   if (change & GTK_CSS_CHANGE_NEEDS_RECOMPUTE)
     {
@@ -382,10 +698,22 @@ gtk_css_node_create_style (GtkCssNode                   *cssnode,
       style_change = gtk_css_static_style_get_change (gtk_css_style_get_static_style (cssnode->style));
     }
 
-  style = gtk_css_static_style_new_compute (gtk_css_node_get_style_provider (cssnode),
-                                            filter,
-                                            cssnode,
-                                            style_change);
+  /* Prefer the precomputed style over the cache, the children's
+   * precomputed styles were computed for it */
+  style = gtk_css_node_get_precomputed_style (cssnode, provider, style_change);
+  if (style == NULL)
+    {
+      style = lookup_in_global_parent_cache (cssnode, decl);
+      if (style)
+        return g_object_ref (style);
+
+      style = gtk_css_static_style_new_compute (provider,
+                                                filter,
+                                                cssnode,
+                                                style_change);
+    }
+
+  created_styles++;
 
   store_in_global_parent_cache (cssnode, decl, style);
 
@@ -398,22 +726,6 @@ should_create_transitions (GtkCssChange change)
   return (change & GTK_CSS_CHANGE_ANIMATIONS) == 0;
 }
 
-static gboolean
-gtk_css_style_needs_recreation (GtkCssStyle  *style,
-                                GtkCssChange  change)
-{
-  gtk_internal_return_val_if_fail (GTK_IS_CSS_STATIC_STYLE (style), TRUE);
-
-  /* Try to avoid invalidating if we can */
-  if (change & GTK_CSS_RADICAL_CHANGE)
-    return TRUE;
-
-  if (gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style)) & change)
-    return TRUE;
-  else
-    return FALSE;
-}
-
 static GtkCssStyle *
 gtk_css_node_real_update_style (GtkCssNode                   *cssnode,
                                 const GtkCountingBloomFilter *filter,
@@ -721,6 +1033,8 @@ gtk_css_node_reposition (GtkCssNode *node,
   /* Take a reference here so the whole function has a reference */
   g_object_ref (node);
 
+  gtk_css_node_discard_precomputed_styles ();
+
   if (node->visible)
     {
       if (node->next_sibling)
@@ -883,11 +1197,14 @@ gtk_css_node_get_next_sibling (GtkCssNode *cssnode)
 
 static gboolean
 gtk_css_node_set_style (GtkCssNode  *cssnode,
-                        GtkCssStyle *style)
+                        GtkCssStyle *style,
+                        gboolean    *inherited_changed)
 {
   GtkCssStyleChange change;
   gboolean style_changed;
 
+  *inherited_changed = FALSE;
+
   if (cssnode->style == style)
     return FALSE;
 
@@ -896,6 +1213,7 @@ gtk_css_node_set_style (GtkCssNode  *cssnode,
   style_changed = gtk_css_style_change_has_change (&change);
   if (style_changed)
     {
+      *inherited_changed = gtk_css_style_change_changes_inherited (&change);
       g_signal_emit (cssnode, cssnode_signals[STYLE_CHANGED], 0, &change);
     }
   else if (GTK_IS_CSS_ANIMATED_STYLE (cssnode->style) || GTK_IS_CSS_ANIMATED_STYLE (style))
@@ -915,18 +1233,32 @@ gtk_css_node_set_style (GtkCssNode  *cssnode,
   return style_changed;
 }
 
+/* Children only see the parent's inherited properties, unless they
+ * inherit others explicitly. So when only non-inherited properties
+ * changed, like the background of a hovered row, only those children
+ * get a PARENT_STYLE change that forces them to be restyled.
+ */
+static gboolean
+gtk_css_node_depends_on_parent_style (GtkCssNode *cssnode)
+{
+  GtkCssStaticStyle *style = gtk_css_style_get_static_style (cssnode->style);
+
+  return (gtk_css_static_style_get_change (style) & GTK_CSS_CHANGE_PARENT_STYLE) != 0;
+}
+
 static void
 gtk_css_node_propagate_pending_changes (GtkCssNode *cssnode,
-                                        gboolean    style_changed)
+                                        gboolean    style_changed,
+                                        gboolean    inherited_changed)
 {
   GtkCssChange change, child_change;
   GtkCssNode *child;
 
   change = _gtk_css_change_for_child (cssnode->pending_changes);
-  if (style_changed)
+  if (inherited_changed)
     change |= GTK_CSS_CHANGE_PARENT_STYLE;
 
-  if (!cssnode->needs_propagation && change == 0)
+  if (!cssnode->needs_propagation && change == 0 && !style_changed)
     return;
 
   for (child = gtk_css_node_get_first_child (cssnode);
@@ -934,7 +1266,11 @@ gtk_css_node_propagate_pending_changes (GtkCssNode *cssnode,
        child = gtk_css_node_get_next_sibling (child))
     {
       child_change = child->pending_changes;
-      gtk_css_node_invalidate (child, change);
+      if (style_changed && !inherited_changed &&
+          gtk_css_node_depends_on_parent_style (child))
+        gtk_css_node_invalidate (child, change | GTK_CSS_CHANGE_PARENT_STYLE);
+      else
+        gtk_css_node_invalidate (child, change);
       if (child->visible)
         change |= _gtk_css_change_for_sibling (child_change);
     }
@@ -953,7 +1289,7 @@ gtk_css_node_do_ensure_style (GtkCssNode                   *cssnode,
                               const GtkCountingBloomFilter *filter,
                               gint64                        current_time)
 {
-  gboolean style_changed;
+  gboolean style_changed, inherited_changed;
 
   if (cssnode->style_is_invalid)
     {
@@ -967,15 +1303,16 @@ gtk_css_node_do_ensure_style (GtkCssNode                   *cssnode,
                                                                   current_time,
                                                                   cssnode->style);
 
-      style_changed = gtk_css_node_set_style (cssnode, new_style);
+      style_changed = gtk_css_node_set_style (cssnode, new_style, &inherited_changed);
       g_object_unref (new_style);
     }
   else
     {
       style_changed = FALSE;
+      inherited_changed = FALSE;
     }
 
-  gtk_css_node_propagate_pending_changes (cssnode, style_changed);
+  gtk_css_node_propagate_pending_changes (cssnode, style_changed, inherited_changed);
 
   cssnode->pending_changes = 0;
   cssnode->style_is_invalid = FALSE;
@@ -1016,9 +1353,19 @@ gtk_css_node_get_style (GtkCssNode *cssnode)
 {
   if (gtk_css_node_needs_new_style (cssnode))
     {
+      GtkCountingBloomFilter filter = GTK_COUNTING_BLOOM_FILTER_INIT;
       gint64 timestamp = gtk_css_node_get_timestamp (cssnode);
+      GtkCssNode *parent;
+
+      /* Outside of validation we have to collect the ancestors ourselves,
+       * so that selectors with descendant combinators can still be
+       * rejected without walking up the tree. Parents that get styled on
+       * the way find themselves in the filter too, which just means it
+       * rejects a bit less for them. */
+      for (parent = cssnode->parent; parent; parent = parent->parent)
+        gtk_css_node_declaration_add_bloom_hashes (parent->decl, &filter);
 
-      gtk_css_node_ensure_style (cssnode, NULL, timestamp);
+      gtk_css_node_ensure_style (cssnode, &filter, timestamp);
     }
 
   return cssnode->style;
@@ -1033,6 +1380,8 @@ gtk_css_node_set_visible (GtkCssNode *cssnode,
   if (cssnode->visible == visible)
     return;
 
+  gtk_css_node_discard_precomputed_styles ();
+
   cssnode->visible = visible;
   g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_VISIBLE]);
 
@@ -1097,6 +1446,7 @@ gtk_css_node_set_name (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_set_name (&cssnode->decl, name))
     {
+      gtk_css_node_discard_precomputed_styles ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_NAME);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_NAME]);
     }
@@ -1114,6 +1464,7 @@ gtk_css_node_set_id (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_set_id (&cssnode->decl, id))
     {
+      gtk_css_node_discard_precomputed_styles ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_ID);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_ID]);
     }
@@ -1138,6 +1489,8 @@ gtk_css_node_set_state (GtkCssNode    *cssnode,
       GtkStateFlags states = old_state ^ state_flags;
       GtkCssChange change = 0;
 
+      gtk_css_node_discard_precomputed_styles ();
+
       if (states & GTK_STATE_FLAG_PRELIGHT)
         change |= GTK_CSS_CHANGE_HOVER;
       if (states & GTK_STATE_FLAG_INSENSITIVE)
@@ -1168,6 +1521,7 @@ gtk_css_node_clear_classes (GtkCssNode *cssnode)
 {
   if (gtk_css_node_declaration_clear_classes (&cssnode->decl))
     {
+      gtk_css_node_discard_precomputed_styles ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1219,6 +1573,7 @@ gtk_css_node_add_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_add_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_discard_precomputed_styles ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1230,6 +1585,7 @@ gtk_css_node_remove_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_remove_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_discard_precomputed_styles ();
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1260,6 +1616,7 @@ gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
 {
   GtkCssNode *child;
 
+  gtk_css_node_discard_precomputed_styles ();
   gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
 
   for (child = cssnode->first_child;
@@ -1339,6 +1696,8 @@ gtk_css_node_validate_internal (GtkCssNode             *cssnode,
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->validate (cssnode);
 
+  gtk_css_node_precompute_styles (cssnode);
+
   for (child = gtk_css_node_get_first_child (cssnode);
        child;
        child = gtk_css_node_get_next_sibling (child))
@@ -1363,25 +1722,50 @@ void
 gtk_css_node_validate (GtkCssNode *cssnode)
 {
   GtkCountingBloomFilter filter = GTK_COUNTING_BLOOM_FILTER_INIT;
+  GtkCssRestyle restyle, *saved_restyle;
   gint64 timestamp;
+  gint64 validate_start;
   gint64 before G_GNUC_UNUSED;
 
   before = GDK_PROFILER_CURRENT_TIME;
+  validate_start = g_get_monotonic_time ();
 
   g_assert (cssnode->parent == NULL);
 
   timestamp = gtk_css_node_get_timestamp (cssnode);
 
+  /* Validation can run again from signal handlers */
+  saved_restyle = current_restyle;
+  if (gtk_get_n_threads () > 1)
+    {
+      restyle.jobs = g_hash_table_new_full (NULL, NULL, NULL, gtk_css_restyle_job_free);
+      restyle.pending = g_hash_table_new (NULL, NULL);
+      g_hash_table_add (restyle.pending, cssnode);
+      current_restyle = &restyle;
+    }
+  else
+    current_restyle = NULL;
+
   gtk_css_node_validate_internal (cssnode, &filter, timestamp);
 
+  if (current_restyle)
+    {
+      g_hash_table_unref (restyle.jobs);
+      g_hash_table_unref (restyle.pending);
+    }
+  current_restyle = saved_restyle;
+
+  gdk_telemetry_end (GDK_TELEMETRY_STYLE, validate_start, invalidated_nodes);
+
   if (GDK_PROFILER_IS_RUNNING)
     {
       gdk_profiler_end_mark (before,  "css validation", "");
       gdk_profiler_set_int_counter (invalidated_nodes_counter, invalidated_nodes);
       gdk_profiler_set_int_counter (created_styles_counter, created_styles);
-      invalidated_nodes = 0;
-      created_styles = 0;
     }
+
+  invalidated_nodes = 0;
+  created_styles = 0;
 }
 
 GtkStyleProvider *
@@ -21,8 +21,16 @@
 
 #include <string.h>
 
+/* Declarations are interned: there is only ever one declaration
+ * with a given name, id, state and set of classes. They are never
+ * changed once created, the setters below replace the declaration
+ * they are given with the interned one for the changed values.
+ * That way, nodes that look the same share their declaration, and
+ * style cache lookups can compare pointers.
+ */
 struct _GtkCssNodeDeclaration {
   guint refcount;
+  guint hash;
   GQuark name;
   GQuark id;
   GtkStateFlags state;
@@ -30,6 +38,17 @@ struct _GtkCssNodeDeclaration {
   GQuark classes[0];
 };
 
+static GtkCssNodeDeclaration empty_declaration = {
+  1, /* need to own a ref ourselves so this one is never freed */
+  0,
+  0,
+  0,
+  0,
+  0
+};
+
+static GHashTable *interned_declarations;
+
 static inline gsize
 sizeof_node (guint n_classes)
 {
@@ -43,61 +62,122 @@ sizeof_this_node (GtkCssNodeDeclaration *decl)
   return sizeof_node (decl->n_classes);
 }
 
-static void
-gtk_css_node_declaration_make_writable (GtkCssNodeDeclaration **decl)
+static guint
+compute_hash (const GtkCssNodeDeclaration *decl)
 {
-  if ((*decl)->refcount == 1)
-    return;
+  guint hash, i;
+
+  hash = GPOINTER_TO_UINT (decl->name);
+  hash <<= 5;
+  hash ^= GPOINTER_TO_UINT (decl->id);
+
+  for (i = 0; i < decl->n_classes; i++)
+    {
+      hash <<= 5;
+      hash += decl->classes[i];
+    }
+
+  hash ^= decl->state;
+
+  return hash;
+}
+
+static guint
+interned_hash (gconstpointer elem)
+{
+  const GtkCssNodeDeclaration *decl = elem;
+
+  return decl->hash;
+}
+
+static gboolean
+interned_equal (gconstpointer elem1,
+                gconstpointer elem2)
+{
+  const GtkCssNodeDeclaration *decl1 = elem1;
+  const GtkCssNodeDeclaration *decl2 = elem2;
+  guint i;
+
+  if (decl1->hash != decl2->hash)
+    return FALSE;
+
+  if (decl1->name != decl2->name)
+    return FALSE;
+
+  if (decl1->state != decl2->state)
+    return FALSE;
+
+  if (decl1->id != decl2->id)
+    return FALSE;
+
+  if (decl1->n_classes != decl2->n_classes)
+    return FALSE;
+
+  for (i = 0; i < decl1->n_classes; i++)
+    {
+      if (decl1->classes[i] != decl2->classes[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
 
-  (*decl)->refcount--;
+static GHashTable *
+get_interned_declarations (void)
+{
+  if (G_UNLIKELY (interned_declarations == NULL))
+    {
+      /* The table does not own a reference, declarations
+       * remove themselves when they are freed.
+       */
+      interned_declarations = g_hash_table_new (interned_hash, interned_equal);
+      g_hash_table_add (interned_declarations, &empty_declaration);
+    }
 
-  *decl = g_memdup (*decl, sizeof_this_node (*decl));
-  (*decl)->refcount = 1;
+  return interned_declarations;
 }
 
+/* Replaces *decl with the interned version of @scratch,
+ * which is a temporary declaration that is not kept.
+ */
 static void
-gtk_css_node_declaration_make_writable_resize (GtkCssNodeDeclaration **decl,
-                                               gsize                   offset,
-                                               gsize                   bytes_added,
-                                               gsize                   bytes_removed)
+gtk_css_node_declaration_intern (GtkCssNodeDeclaration **decl,
+                                 GtkCssNodeDeclaration  *scratch)
 {
-  gsize old_size = sizeof_this_node (*decl);
-  gsize new_size = old_size + bytes_added - bytes_removed;
+  GHashTable *interned = get_interned_declarations ();
+  GtkCssNodeDeclaration *result;
+
+  scratch->hash = compute_hash (scratch);
 
-  if ((*decl)->refcount == 1)
+  result = g_hash_table_lookup (interned, scratch);
+  if (result)
     {
-      if (bytes_removed > 0 && old_size - offset - bytes_removed > 0)
-        memmove (((char *) *decl) + offset, ((char *) *decl) + offset + bytes_removed, old_size - offset - bytes_removed);
-      *decl = g_realloc (*decl, new_size);
-      if (bytes_added > 0 && old_size - offset > 0)
-        memmove (((char *) *decl) + offset + bytes_added, ((char *) *decl) + offset, old_size - offset);
+      gtk_css_node_declaration_ref (result);
     }
   else
     {
-      GtkCssNodeDeclaration *old = *decl;
-
-      old->refcount--;
-  
-      *decl = g_malloc (new_size);
-      memcpy (*decl, old, offset);
-      if (old_size - offset - bytes_removed > 0)
-        memcpy (((char *) *decl) + offset + bytes_added, ((char *) old) + offset + bytes_removed, old_size - offset - bytes_removed);
-      (*decl)->refcount = 1;
+      result = g_memdup (scratch, sizeof_this_node (scratch));
+      result->refcount = 1;
+      g_hash_table_add (interned, result);
     }
+
+  gtk_css_node_declaration_unref (*decl);
+  *decl = result;
+}
+
+static GtkCssNodeDeclaration *
+copy_to_scratch (const GtkCssNodeDeclaration *decl,
+                 gpointer                     scratch)
+{
+  return memcpy (scratch, decl, sizeof_node (decl->n_classes));
 }
 
 GtkCssNodeDeclaration *
 gtk_css_node_declaration_new (void)
 {
-  static GtkCssNodeDeclaration empty = {
-    1, /* need to own a ref ourselves so the copy-on-write path kicks in when people change things */
-    0,
-    0,
-    0,
-    0
-  };
-
-  return gtk_css_node_declaration_ref (&empty);
+  get_interned_declarations ();
+
+  return gtk_css_node_declaration_ref (&empty_declaration);
 }
 
 GtkCssNodeDeclaration *
@@ -115,6 +195,7 @@ gtk_css_node_declaration_unref (GtkCssNodeDeclaration *decl)
   if (decl->refcount > 0)
     return;
 
+  g_hash_table_remove (interned_declarations, decl);
   g_free (decl);
 }
 
@@ -122,11 +203,14 @@ gboolean
 gtk_css_node_declaration_set_name (GtkCssNodeDeclaration **decl,
                                    GQuark                  name)
 {
+  GtkCssNodeDeclaration *scratch;
+
   if ((*decl)->name == name)
     return FALSE;
 
-  gtk_css_node_declaration_make_writable (decl);
-  (*decl)->name = name;
+  scratch = copy_to_scratch (*decl, g_alloca (sizeof_this_node (*decl)));
+  scratch->name = name;
+  gtk_css_node_declaration_intern (decl, scratch);
 
   return TRUE;
 }
@@ -141,11 +225,14 @@ gboolean
 gtk_css_node_declaration_set_id (GtkCssNodeDeclaration **decl,
                                  GQuark                  id)
 {
+  GtkCssNodeDeclaration *scratch;
+
   if ((*decl)->id == id)
     return FALSE;
 
-  gtk_css_node_declaration_make_writable (decl);
-  (*decl)->id = id;
+  scratch = copy_to_scratch (*decl, g_alloca (sizeof_this_node (*decl)));
+  scratch->id = id;
+  gtk_css_node_declaration_intern (decl, scratch);
 
   return TRUE;
 }
@@ -160,11 +247,14 @@ gboolean
 gtk_css_node_declaration_set_state (GtkCssNodeDeclaration **decl,
                                     GtkStateFlags           state)
 {
+  GtkCssNodeDeclaration *scratch;
+
   if ((*decl)->state == state)
     return FALSE;
-  
-  gtk_css_node_declaration_make_writable (decl);
-  (*decl)->state = state;
+
+  scratch = copy_to_scratch (*decl, g_alloca (sizeof_this_node (*decl)));
+  scratch->state = state;
+  gtk_css_node_declaration_intern (decl, scratch);
 
   return TRUE;
 }
@@ -224,17 +314,17 @@ gboolean
 gtk_css_node_declaration_add_class (GtkCssNodeDeclaration **decl,
                                     GQuark                  class_quark)
 {
+  GtkCssNodeDeclaration *scratch;
   guint pos;
 
   if (find_class (*decl, class_quark, &pos))
     return FALSE;
 
-  gtk_css_node_declaration_make_writable_resize (decl,
-                                                 (char *) &(*decl)->classes[pos] - (char *) *decl,
-                                                 sizeof (GQuark),
-                                                 0);
-  (*decl)->n_classes++;
-  (*decl)->classes[pos] = class_quark;
+  scratch = copy_to_scratch (*decl, g_alloca (sizeof_node ((*decl)->n_classes + 1)));
+  memcpy (&scratch->classes[pos + 1], &(*decl)->classes[pos], sizeof (GQuark) * ((*decl)->n_classes - pos));
+  scratch->classes[pos] = class_quark;
+  scratch->n_classes++;
+  gtk_css_node_declaration_intern (decl, scratch);
 
   return TRUE;
 }
@@ -243,16 +333,16 @@ gboolean
 gtk_css_node_declaration_remove_class (GtkCssNodeDeclaration **decl,
                                        GQuark                  class_quark)
 {
+  GtkCssNodeDeclaration *scratch;
   guint pos;
 
   if (!find_class (*decl, class_quark, &pos))
     return FALSE;
 
-  gtk_css_node_declaration_make_writable_resize (decl,
-                                                 (char *) &(*decl)->classes[pos] - (char *) *decl,
-                                                 0,
-                                                 sizeof (GQuark));
-  (*decl)->n_classes--;
+  scratch = copy_to_scratch (*decl, g_alloca (sizeof_this_node (*decl)));
+  memmove (&scratch->classes[pos], &scratch->classes[pos + 1], sizeof (GQuark) * (scratch->n_classes - pos - 1));
+  scratch->n_classes--;
+  gtk_css_node_declaration_intern (decl, scratch);
 
   return TRUE;
 }
@@ -260,14 +350,14 @@ gtk_css_node_declaration_remove_class (GtkCssNodeDeclaration **decl,
 gboolean
 gtk_css_node_declaration_clear_classes (GtkCssNodeDeclaration **decl)
 {
+  GtkCssNodeDeclaration scratch;
+
   if ((*decl)->n_classes == 0)
     return FALSE;
 
-  gtk_css_node_declaration_make_writable_resize (decl,
-                                                 (char *) (*decl)->classes - (char *) *decl,
-                                                 0,
-                                                 sizeof (GQuark) * (*decl)->n_classes);
-  (*decl)->n_classes = 0;
+  scratch = **decl;
+  scratch.n_classes = 0;
+  gtk_css_node_declaration_intern (decl, &scratch);
 
   return TRUE;
 }
@@ -350,53 +440,16 @@ guint
 gtk_css_node_declaration_hash (gconstpointer elem)
 {
   const GtkCssNodeDeclaration *decl = elem;
-  guint hash, i;
-  
-  hash = GPOINTER_TO_UINT (decl->name);
-  hash <<= 5;
-  hash ^= GPOINTER_TO_UINT (decl->id);
-
-  for (i = 0; i < decl->n_classes; i++)
-    {
-      hash <<= 5;
-      hash += decl->classes[i];
-    }
 
-  hash ^= decl->state;
-
-  return hash;
+  return decl->hash;
 }
 
+/* Declarations are interned, so equal ones are the same */
 gboolean
 gtk_css_node_declaration_equal (gconstpointer elem1,
                                 gconstpointer elem2)
 {
-  const GtkCssNodeDeclaration *decl1 = elem1;
-  const GtkCssNodeDeclaration *decl2 = elem2;
-  guint i;
-
-  if (decl1 == decl2)
-    return TRUE;
-
-  if (decl1->name != decl2->name)
-    return FALSE;
-
-  if (decl1->state != decl2->state)
-    return FALSE;
-
-  if (decl1->id != decl2->id)
-    return FALSE;
-
-  if (decl1->n_classes != decl2->n_classes)
-    return FALSE;
-
-  for (i = 0; i < decl1->n_classes; i++)
-    {
-      if (decl1->classes[i] != decl2->classes[i])
-        return FALSE;
-    }
-
-  return TRUE;
+  return elem1 == elem2;
 }
 
 static int
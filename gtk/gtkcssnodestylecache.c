@@ -20,14 +20,37 @@
 #include "gtkcssnodestylecacheprivate.h"
 
 #include "gtkdebug.h"
+#include "gtkcssnodeprivate.h"
 #include "gtkcssstaticstyleprivate.h"
 
+/* Caches are shared between all nodes that have the same declarations
+ * on the path from the root, so all rows of a list with the same
+ * declaration use the same cache for their children.
+ *
+ * Styles that depend on the position among the siblings are cached by
+ * that position, in a separate table per declaration, so that the nth
+ * child of every row can still share its style. Only nodes whose
+ * declaration has such styles need to compute their position.
+ */
 struct _GtkCssNodeStyleCache {
   guint        ref_count;
   GtkCssStyle *style;
   GHashTable  *children;
+  GHashTable  *positional; /* GtkCssNodeDeclaration => PositionalChildren */
 };
 
+typedef struct {
+  GtkCssChange  change;   /* The positions the entries are keyed by */
+  GHashTable   *children; /* PositionKey => GtkCssNodeStyleCache */
+} PositionalChildren;
+
+typedef struct {
+  guint nth;
+  guint nth_last;
+  guint is_first : 1;
+  guint is_last  : 1;
+} PositionKey;
+
 #define UNPACK_DECLARATION(packed) ((GtkCssNodeDeclaration *) (GPOINTER_TO_SIZE (packed) & ~0x3))
 #define UNPACK_FLAGS(packed) (GPOINTER_TO_SIZE (packed) & 0x3)
 #define PACK(decl, first_child, last_child) GSIZE_TO_POINTER (GPOINTER_TO_SIZE (decl) | ((first_child) ? 0x2 : 0) | ((last_child) ? 0x1 : 0))
@@ -64,6 +87,8 @@ gtk_css_node_style_cache_unref (GtkCssNodeStyleCache *cache)
   g_object_unref (cache->style);
   if (cache->children)
     g_hash_table_unref (cache->children);
+  if (cache->positional)
+    g_hash_table_unref (cache->positional);
 
   g_slice_free (GtkCssNodeStyleCache, cache);
 }
@@ -102,15 +127,88 @@ may_be_stored_in_cache (GtkCssStyle *style)
   if (change & GTK_CSS_CHANGE_ANY_SIBLING)
     return FALSE;
 
-  /* Again, the cache is shared between all children of the parent.
-   * If the position is relevant, no child has the same style.
-   */
-  if (change & (GTK_CSS_CHANGE_NTH_CHILD | GTK_CSS_CHANGE_NTH_LAST_CHILD))
-    return FALSE;
-
   return TRUE;
 }
 
+static void
+positional_children_free (gpointer data)
+{
+  PositionalChildren *positional = data;
+
+  g_hash_table_unref (positional->children);
+  g_slice_free (PositionalChildren, positional);
+}
+
+static guint
+position_key_hash (gconstpointer item)
+{
+  const PositionKey *key = item;
+
+  return (key->nth * 31 + key->nth_last) << 2 | key->is_first << 1 | key->is_last;
+}
+
+static gboolean
+position_key_equal (gconstpointer item1,
+                    gconstpointer item2)
+{
+  const PositionKey *key1 = item1;
+  const PositionKey *key2 = item2;
+
+  return key1->nth == key2->nth &&
+         key1->nth_last == key2->nth_last &&
+         key1->is_first == key2->is_first &&
+         key1->is_last == key2->is_last;
+}
+
+static void
+position_key_free (gpointer item)
+{
+  g_slice_free (PositionKey, item);
+}
+
+/* Fills in the positions that @change depends on, counting from 1.
+ * Like match_position() in gtkcssselector.c, the node itself always
+ * counts, and of its siblings only the visible ones do.
+ *
+ * This walks the siblings, so restyling all n children of a node costs
+ * O(n²) here. That is the price of sharing their styles, and only nodes
+ * whose declaration has position-dependent entries pay it.
+ */
+static void
+position_key_init (PositionKey  *key,
+                   GtkCssNode   *node,
+                   GtkCssChange  change,
+                   gboolean      is_first,
+                   gboolean      is_last)
+{
+  GtkCssNode *iter;
+
+  key->nth = 0;
+  key->nth_last = 0;
+  key->is_first = is_first;
+  key->is_last = is_last;
+
+  if (change & GTK_CSS_CHANGE_NTH_CHILD)
+    {
+      key->nth = 1;
+      for (iter = gtk_css_node_get_previous_sibling (node); iter; iter = gtk_css_node_get_previous_sibling (iter))
+        {
+          if (gtk_css_node_get_visible (iter))
+            key->nth++;
+        }
+    }
+
+  if (change & GTK_CSS_CHANGE_NTH_LAST_CHILD)
+    {
+      key->nth_last = 1;
+      for (iter = gtk_css_node_get_next_sibling (node); iter; iter = gtk_css_node_get_next_sibling (iter))
+        {
+          if (gtk_css_node_get_visible (iter))
+            key->nth_last++;
+        }
+    }
+}
+
 static guint
 gtk_css_node_style_cache_decl_hash (gconstpointer item)
 {
@@ -135,18 +233,74 @@ gtk_css_node_style_cache_decl_free (gpointer item)
   gtk_css_node_declaration_unref (UNPACK_DECLARATION (item));
 }
 
+static GtkCssNodeStyleCache *
+gtk_css_node_style_cache_insert_positional (GtkCssNodeStyleCache   *parent,
+                                            GtkCssNodeDeclaration  *decl,
+                                            GtkCssNode             *node,
+                                            gboolean                is_first,
+                                            gboolean                is_last,
+                                            GtkCssChange            change,
+                                            GtkCssStyle            *style)
+{
+  PositionalChildren *positional;
+  GtkCssNodeStyleCache *result;
+  PositionKey *key;
+
+  if (parent->positional == NULL)
+    parent->positional = g_hash_table_new_full (gtk_css_node_declaration_hash,
+                                                gtk_css_node_declaration_equal,
+                                                (GDestroyNotify) gtk_css_node_declaration_unref,
+                                                positional_children_free);
+
+  positional = g_hash_table_lookup (parent->positional, decl);
+  if (positional == NULL)
+    {
+      positional = g_slice_new (PositionalChildren);
+      positional->change = change;
+      positional->children = g_hash_table_new_full (position_key_hash,
+                                                    position_key_equal,
+                                                    position_key_free,
+                                                    (GDestroyNotify) gtk_css_node_style_cache_unref);
+      g_hash_table_insert (parent->positional, gtk_css_node_declaration_ref (decl), positional);
+    }
+  else if ((positional->change & change) != change)
+    {
+      /* The existing entries are keyed by fewer positions, start over */
+      positional->change |= change;
+      g_hash_table_remove_all (positional->children);
+    }
+
+  key = g_slice_new (PositionKey);
+  position_key_init (key, node, positional->change, is_first, is_last);
+
+  result = gtk_css_node_style_cache_new (style);
+
+  g_hash_table_insert (positional->children, key, gtk_css_node_style_cache_ref (result));
+
+  return result;
+}
+
 GtkCssNodeStyleCache *
 gtk_css_node_style_cache_insert (GtkCssNodeStyleCache   *parent,
                                  GtkCssNodeDeclaration  *decl,
+                                 GtkCssNode             *node,
                                  gboolean                is_first,
                                  gboolean                is_last,
                                  GtkCssStyle            *style)
 {
   GtkCssNodeStyleCache *result;
+  GtkCssChange change;
 
   if (!may_be_stored_in_cache (style))
     return NULL;
 
+  change = gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style));
+  change &= GTK_CSS_CHANGE_NTH_CHILD | GTK_CSS_CHANGE_NTH_LAST_CHILD;
+  if (change)
+    return gtk_css_node_style_cache_insert_positional (parent, decl, node,
+                                                       is_first, is_last,
+                                                       change, style);
+
   if (parent->children == NULL)
     parent->children = g_hash_table_new_full (gtk_css_node_style_cache_decl_hash,
                                               gtk_css_node_style_cache_decl_equal,
@@ -165,15 +319,28 @@ gtk_css_node_style_cache_insert (GtkCssNodeStyleCache   *parent,
 GtkCssNodeStyleCache *
 gtk_css_node_style_cache_lookup (GtkCssNodeStyleCache        *parent,
                                  const GtkCssNodeDeclaration *decl,
+                                 GtkCssNode                  *node,
                                  gboolean                     is_first,
                                  gboolean                     is_last)
 {
-  GtkCssNodeStyleCache *result;
+  GtkCssNodeStyleCache *result = NULL;
 
-  if (parent->children == NULL)
-    return NULL;
+  if (parent->children)
+    result = g_hash_table_lookup (parent->children, PACK (decl, is_first, is_last));
+
+  if (result == NULL && parent->positional)
+    {
+      PositionalChildren *positional = g_hash_table_lookup (parent->positional, decl);
+
+      if (positional)
+        {
+          PositionKey key;
+
+          position_key_init (&key, node, positional->change, is_first, is_last);
+          result = g_hash_table_lookup (positional->children, &key);
+        }
+    }
 
-  result = g_hash_table_lookup (parent->children, PACK (decl, is_first, is_last));
   if (result == NULL)
     return NULL;
 
@@ -33,11 +33,13 @@ GtkCssStyle *           gtk_css_node_style_cache_get_style      (GtkCssNodeStyle
 
 GtkCssNodeStyleCache *  gtk_css_node_style_cache_insert         (GtkCssNodeStyleCache   *parent,
                                                                  GtkCssNodeDeclaration  *decl,
+                                                                 GtkCssNode             *node,
                                                                  gboolean                is_first,
                                                                  gboolean                is_last,
                                                                  GtkCssStyle            *style);
 GtkCssNodeStyleCache *  gtk_css_node_style_cache_lookup         (GtkCssNodeStyleCache        *parent,
                                                                  const GtkCssNodeDeclaration *decl,
+                                                                 GtkCssNode                  *node,
                                                                  gboolean                     is_first,
                                                                  gboolean                     is_last);
 
@@ -1889,23 +1889,50 @@ gtk_css_selector_tree_found_match (const GtkCssSelectorTree  *tree,
     gtk_css_selector_matches_insert_sorted (results, matches[i]);
 }
 
+/* How often selectors after a descendant or child combinator were
+ * rejected by the ancestor bloom filter, compared against a node
+ * anyway, and matched. The inspector shows these.
+ *
+ * Lookups run on several threads while styles are computed in
+ * parallel, so they count into a MatchStats and add it up once.
+ */
+static int ancestor_rejected;
+static int ancestor_checked;
+static int ancestor_matched;
+
+typedef struct {
+  guint rejected;
+  guint checked;
+  guint matched;
+} MatchStats;
+
 static gboolean
 gtk_css_selector_tree_match (const GtkCssSelectorTree      *tree,
                              const GtkCountingBloomFilter  *filter,
                              gboolean                       match_filter,
                              GtkCssNode                    *node,
-                             GtkCssSelectorMatches         *results)
+                             GtkCssSelectorMatches         *results,
+                             MatchStats                    *stats)
 {
   const GtkCssSelectorTree *prev;
   GtkCssNode *child;
 
   if (match_filter && tree->selector.class->category == GTK_CSS_SELECTOR_CATEGORY_SIMPLE_RADICAL &&
       !gtk_counting_bloom_filter_may_contain (filter, gtk_css_selector_hash_one (&tree->selector)))
-    return FALSE;
+    {
+      stats->rejected++;
+      return FALSE;
+    }
+
+  if (match_filter)
+    stats->checked++;
 
   if (!gtk_css_selector_match_one (&tree->selector, node))
     return TRUE;
 
+  if (match_filter)
+    stats->matched++;
+
   gtk_css_selector_tree_found_match (tree, results);
 
   if (filter && !gtk_css_selector_is_simple (&tree->selector))
@@ -1919,7 +1946,7 @@ gtk_css_selector_tree_match (const GtkCssSelectorTree      *tree,
            child;
            child = gtk_css_selector_iterator (&tree->selector, node, child))
         {
-          if (!gtk_css_selector_tree_match (prev, filter, match_filter, child, results))
+          if (!gtk_css_selector_tree_match (prev, filter, match_filter, child, results, stats))
             break;
         }
     }
@@ -1934,13 +1961,31 @@ _gtk_css_selector_tree_match_all (const GtkCssSelectorTree     *tree,
                                   GtkCssSelectorMatches        *out_tree_rules)
 {
   const GtkCssSelectorTree *iter;
+  MatchStats stats = { 0, };
 
   for (iter = tree;
        iter != NULL;
        iter = gtk_css_selector_tree_get_sibling (iter))
     {
-      gtk_css_selector_tree_match (iter, filter, FALSE, node, out_tree_rules);
+      gtk_css_selector_tree_match (iter, filter, FALSE, node, out_tree_rules, &stats);
     }
+
+  if (stats.rejected)
+    g_atomic_int_add (&ancestor_rejected, stats.rejected);
+  if (stats.checked)
+    g_atomic_int_add (&ancestor_checked, stats.checked);
+  if (stats.matched)
+    g_atomic_int_add (&ancestor_matched, stats.matched);
+}
+
+void
+_gtk_css_selector_tree_get_match_stats (guint *rejected,
+                                        guint *checked,
+                                        guint *matched)
+{
+  *rejected = g_atomic_int_get (&ancestor_rejected);
+  *checked = g_atomic_int_get (&ancestor_checked);
+  *matched = g_atomic_int_get (&ancestor_matched);
 }
 
 gboolean
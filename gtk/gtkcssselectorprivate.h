@@ -60,6 +60,9 @@ GtkCssChange gtk_css_selector_tree_get_change_all    (const GtkCssSelectorTree *
 void         _gtk_css_selector_tree_match_print      (const GtkCssSelectorTree *tree,
 						      GString                  *str);
 gboolean     _gtk_css_selector_tree_is_empty         (const GtkCssSelectorTree *tree) G_GNUC_CONST;
+void         _gtk_css_selector_tree_get_match_stats  (guint                    *rejected,
+                                                      guint                    *checked,
+                                                      guint                    *matched);
 
 
 
@@ -213,6 +213,8 @@ gtk_css_ ## NAME ## _values_new_compute (GtkCssStaticStyle *sstyle, \
                                           lookup->values[id].value, \
                                           lookup->values[id].section); \
     } \
+\
+  style->NAME = (GtkCss ## TYPE ## Values *)gtk_css_values_intern ((GtkCssValues *)style->NAME); \
 } \
 static GtkBitmask * gtk_css_ ## NAME ## _values_mask; \
 static GtkCssValues * gtk_css_ ## NAME ## _initial_values; \
@@ -982,15 +984,15 @@ gtk_css_lookup_resolve (GtkCssLookup      *lookup,
     gtk_css_other_values_new_compute (sstyle, provider, parent_style, lookup);
 }
 
-GtkCssStyle *
-gtk_css_static_style_new_compute (GtkStyleProvider             *provider,
-                                  const GtkCountingBloomFilter *filter,
-                                  GtkCssNode                   *node,
-                                  GtkCssChange                  change)
+static GtkCssStyle *
+gtk_css_static_style_compute (GtkStyleProvider             *provider,
+                              const GtkCountingBloomFilter *filter,
+                              GtkCssNode                   *node,
+                              GtkCssStyle                  *parent_style,
+                              GtkCssChange                  change)
 {
   GtkCssStaticStyle *result;
   GtkCssLookup lookup;
-  GtkCssNode *parent;
 
   _gtk_css_lookup_init (&lookup);
 
@@ -1005,21 +1007,77 @@ gtk_css_static_style_new_compute (GtkStyleProvider             *provider,
 
   result->change = change;
 
-  if (node)
-    parent = gtk_css_node_get_parent (node);
-  else
-    parent = NULL;
-
   gtk_css_lookup_resolve (&lookup,
                           provider,
                           result,
-                          parent ? gtk_css_node_get_style (parent) : NULL);
+                          parent_style);
 
   _gtk_css_lookup_destroy (&lookup);
 
   return GTK_CSS_STYLE (result);
 }
 
+GtkCssStyle *
+gtk_css_static_style_new_compute (GtkStyleProvider             *provider,
+                                  const GtkCountingBloomFilter *filter,
+                                  GtkCssNode                   *node,
+                                  GtkCssChange                  change)
+{
+  GtkCssNode *parent;
+
+  if (node)
+    parent = gtk_css_node_get_parent (node);
+  else
+    parent = NULL;
+
+  return gtk_css_static_style_compute (provider,
+                                       filter,
+                                       node,
+                                       parent ? gtk_css_node_get_style (parent) : NULL,
+                                       change);
+}
+
+/*<private>
+ * gtk_css_static_style_new_compute_threaded:
+ * @provider: the style provider of @node
+ * @filter: the ancestors of @node
+ * @node: the node to compute the style for
+ * @parent_style: (nullable): the style @node's parent will have
+ * @change: the change flags to keep, or 0 to compute them
+ *
+ * Computes the style for @node like gtk_css_static_style_new_compute(),
+ * but without touching anything but @node and its ancestors' declarations,
+ * so it can run on any thread while the main thread waits. @parent_style
+ * is passed in because the parent may not have its new style yet.
+ *
+ * Values that can only be computed on the main thread make this fail,
+ * see gtk_css_value_compute_needs_main_thread().
+ *
+ * Returns: (nullable) (transfer full): the new style, or %NULL if it
+ *   has to be computed on the main thread
+ */
+GtkCssStyle *
+gtk_css_static_style_new_compute_threaded (GtkStyleProvider             *provider,
+                                           const GtkCountingBloomFilter *filter,
+                                           GtkCssNode                   *node,
+                                           GtkCssStyle                  *parent_style,
+                                           GtkCssChange                  change)
+{
+  GtkCssStyle *result;
+  gboolean failed;
+
+  gtk_css_value_begin_threaded_compute (&failed);
+
+  result = gtk_css_static_style_compute (provider, filter, node, parent_style, change);
+
+  gtk_css_value_end_threaded_compute ();
+
+  if (failed)
+    g_clear_object (&result);
+
+  return result;
+}
+
 G_STATIC_ASSERT (GTK_CSS_PROPERTY_BORDER_TOP_STYLE == GTK_CSS_PROPERTY_BORDER_TOP_WIDTH - 1);
 G_STATIC_ASSERT (GTK_CSS_PROPERTY_BORDER_RIGHT_STYLE == GTK_CSS_PROPERTY_BORDER_RIGHT_WIDTH - 1);
 G_STATIC_ASSERT (GTK_CSS_PROPERTY_BORDER_BOTTOM_STYLE == GTK_CSS_PROPERTY_BORDER_BOTTOM_WIDTH - 1);
@@ -1072,6 +1130,13 @@ gtk_css_static_style_compute_value (GtkCssStaticStyle *style,
    */
   if (specified)
     {
+      /* Computed values only ever look at inherited properties of the
+       * parent, unless they are told to inherit explicitly. Remember
+       * that, so changes to the parent's other properties can skip us. */
+      if (specified == _gtk_css_inherit_value_get () &&
+          !_gtk_css_style_property_is_inherit (_gtk_css_style_property_lookup_by_id (id)))
+        style->change |= GTK_CSS_CHANGE_PARENT_STYLE;
+
       value = _gtk_css_value_compute (specified, id, provider, (GtkCssStyle *)style, parent_style);
     }
   else if (parent_style && _gtk_css_style_property_is_inherit (_gtk_css_style_property_lookup_by_id (id)))
@@ -57,6 +57,11 @@ GtkCssStyle *           gtk_css_static_style_new_compute        (GtkStyleProvide
                                                                  const GtkCountingBloomFilter   *filter,
                                                                  GtkCssNode                     *node,
                                                                  GtkCssChange                    change);
+GtkCssStyle *           gtk_css_static_style_new_compute_threaded (GtkStyleProvider             *provider,
+                                                                 const GtkCountingBloomFilter   *filter,
+                                                                 GtkCssNode                     *node,
+                                                                 GtkCssStyle                    *parent_style,
+                                                                 GtkCssChange                    change);
 GtkCssChange            gtk_css_static_style_get_change         (GtkCssStaticStyle              *style);
 
 G_END_DECLS
@@ -39,6 +39,8 @@
 #include "gtkstylepropertyprivate.h"
 #include "gtkstyleproviderprivate.h"
 
+#include <string.h>
+
 G_DEFINE_ABSTRACT_TYPE (GtkCssStyle, gtk_css_style, G_TYPE_OBJECT)
 
 static GtkCssSection *
@@ -707,7 +709,101 @@ static const int values_size[] = {
 
 GtkCssValues *gtk_css_values_ref (GtkCssValues *values)
 {
-  values->ref_count++;
+  g_atomic_int_inc (&values->ref_count);
+
+  return values;
+}
+
+/* Computed groups are interned, so styles that end up with the same
+ * values share one group. Computing a value usually hands back the
+ * same refcounted GtkCssValue for the same input, so comparing the
+ * value pointers is enough to find most duplicates without hashing
+ * the values themselves. Interned groups must not be modified; the
+ * animated style copies a group before changing it.
+ *
+ * Styles are computed on several threads at once, so the table is
+ * locked. A group whose last reference is being dropped on another
+ * thread may still be in the table; it must not be handed out again.
+ */
+static GHashTable *interned_values;
+G_LOCK_DEFINE_STATIC (interned_values);
+
+static gboolean
+gtk_css_values_ref_if_alive (GtkCssValues *values)
+{
+  int ref_count;
+
+  do
+    {
+      ref_count = g_atomic_int_get (&values->ref_count);
+      if (ref_count == 0)
+        return FALSE;
+    }
+  while (!g_atomic_int_compare_and_exchange (&values->ref_count, ref_count, ref_count + 1));
+
+  return TRUE;
+}
+
+static guint
+gtk_css_values_hash (gconstpointer data)
+{
+  const GtkCssValues *values = data;
+  GtkCssValue **v = GET_VALUES (values);
+  guint hash = TYPE_INDEX (values->type);
+  int i;
+
+  for (i = 0; i < N_VALUES (values->type); i++)
+    hash = (hash << 5) - hash + GPOINTER_TO_UINT (v[i]);
+
+  return hash;
+}
+
+static gboolean
+gtk_css_values_equal (gconstpointer a,
+                      gconstpointer b)
+{
+  const GtkCssValues *values1 = a;
+  const GtkCssValues *values2 = b;
+
+  if (TYPE_INDEX (values1->type) != TYPE_INDEX (values2->type))
+    return FALSE;
+
+  return memcmp (GET_VALUES (values1),
+                 GET_VALUES (values2),
+                 N_VALUES (values1->type) * sizeof (GtkCssValue *)) == 0;
+}
+
+/*<private>
+ * gtk_css_values_intern:
+ * @values: (transfer full): a newly computed group
+ *
+ * Looks for a group with the same values and returns that one
+ * instead of @values if there is one.
+ *
+ * Returns: (transfer full): the interned group
+ */
+GtkCssValues *
+gtk_css_values_intern (GtkCssValues *values)
+{
+  GtkCssValues *interned;
+
+  G_LOCK (interned_values);
+
+  if (G_UNLIKELY (interned_values == NULL))
+    interned_values = g_hash_table_new (gtk_css_values_hash, gtk_css_values_equal);
+
+  interned = g_hash_table_lookup (interned_values, values);
+  if (interned && gtk_css_values_ref_if_alive (interned))
+    {
+      G_UNLOCK (interned_values);
+      gtk_css_values_unref (values);
+      return interned;
+    }
+
+  /* Replaces a dying group, it will not remove us when it is freed */
+  g_hash_table_add (interned_values, values);
+
+  G_UNLOCK (interned_values);
 
   return values;
 }
@@ -718,6 +814,12 @@ gtk_css_values_free (GtkCssValues *values)
   int i;
   GtkCssValue **v = GET_VALUES (values);
 
+  G_LOCK (interned_values);
+  if (interned_values &&
+      g_hash_table_lookup (interned_values, values) == values)
+    g_hash_table_remove (interned_values, values);
+  G_UNLOCK (interned_values);
+
   for (i = 0; i < N_VALUES (values->type); i++)
     {
       if (v[i])
@@ -732,9 +834,7 @@ void gtk_css_values_unref (GtkCssValues *values)
   if (!values)
     return;
 
-  values->ref_count--;
-
-  if (values->ref_count == 0)
+  if (g_atomic_int_dec_and_test (&values->ref_count))
     gtk_css_values_free (values);
 }
 
@@ -159,6 +159,30 @@ gtk_css_style_change_changes_property (GtkCssStyleChange *change,
   return _gtk_bitmask_get (change->changes, id);
 }
 
+/* Whether the change is visible to children that don't explicitly
+ * inherit properties that aren't inherited by default. */
+gboolean
+gtk_css_style_change_changes_inherited (GtkCssStyleChange *change)
+{
+  static GtkBitmask *inherited;
+
+  if (G_UNLIKELY (inherited == NULL))
+    {
+      GtkBitmask *mask = _gtk_bitmask_new ();
+      guint i;
+
+      for (i = 0; i < GTK_CSS_PROPERTY_N_PROPERTIES; i++)
+        {
+          if (_gtk_css_style_property_is_inherit (_gtk_css_style_property_lookup_by_id (i)))
+            mask = _gtk_bitmask_set (mask, i, TRUE);
+        }
+
+      inherited = mask;
+    }
+
+  return _gtk_bitmask_intersects (change->changes, inherited);
+}
+
 void
 gtk_css_style_change_print (GtkCssStyleChange *change,
                             GString           *string)
@@ -43,6 +43,7 @@ gboolean        gtk_css_style_change_affects            (GtkCssStyleChange
                                                          GtkCssAffects           affects);
 gboolean        gtk_css_style_change_changes_property   (GtkCssStyleChange      *change,
                                                          guint                   id);
+gboolean        gtk_css_style_change_changes_inherited  (GtkCssStyleChange      *change);
 void            gtk_css_style_change_print              (GtkCssStyleChange      *change, GString *string);
 
 char *          gtk_css_style_change_to_string          (GtkCssStyleChange      *change);
@@ -23,6 +23,8 @@
 #include "gtkcssstyleprivate.h"
 #include "gtkstyleproviderprivate.h"
 
+#include "gdk/gdkallocstatsprivate.h"
+
 struct _GtkCssValue {
   GTK_CSS_VALUE_BASE
 };
@@ -147,6 +149,8 @@ _gtk_css_value_alloc (const GtkCssValueClass *klass,
   value->class = klass;
   value->ref_count = 1;
 
+  gdk_alloc_stats_add (GDK_ALLOC_CSS_VALUE, size);
+
 #ifdef CSS_VALUE_ACCOUNTING
   {
     ValueAccounting *c;
@@ -165,7 +169,7 @@ gtk_css_value_ref (GtkCssValue *value)
 {
   gtk_internal_return_val_if_fail (value != NULL, NULL);
 
-  value->ref_count += 1;
+  g_atomic_int_inc (&value->ref_count);
 
   return value;
 }
@@ -176,8 +180,7 @@ gtk_css_value_unref (GtkCssValue *value)
   if (value == NULL)
     return;
 
-  value->ref_count -= 1;
-  if (value->ref_count > 0)
+  if (!g_atomic_int_dec_and_test (&value->ref_count))
     return;
 
 #ifdef CSS_VALUE_ACCOUNTING
@@ -189,6 +192,9 @@ gtk_css_value_unref (GtkCssValue *value)
   }
 #endif
 
+  /* The size is not stored in the value */
+  gdk_alloc_stats_remove (GDK_ALLOC_CSS_VALUE, -1);
+
   value->class->free (value);
 }
 
@@ -224,6 +230,58 @@ _gtk_css_value_compute (GtkCssValue      *value,
   return value->class->compute (value, property_id, provider, style, parent_style);
 }
 
+/* Points to the failed flag of the style computation running on this
+ * thread, if it is not running on the main thread.
+ */
+static GPrivate threaded_compute;
+
+/*<private>
+ * gtk_css_value_begin_threaded_compute:
+ * @failed: (out): set to %TRUE if a value could not be computed
+ *
+ * Marks the calling thread as computing values away from the main
+ * thread, until gtk_css_value_end_threaded_compute() is called.
+ *
+ * Computations that need the main thread set @failed and return
+ * early. The caller must throw away everything it computed then.
+ */
+void
+gtk_css_value_begin_threaded_compute (gboolean *failed)
+{
+  *failed = FALSE;
+  g_private_set (&threaded_compute, failed);
+}
+
+void
+gtk_css_value_end_threaded_compute (void)
+{
+  g_private_set (&threaded_compute, NULL);
+}
+
+/*<private>
+ * gtk_css_value_compute_needs_main_thread:
+ *
+ * Compute functions that look at things only the main thread may
+ * touch, like the settings, the icon theme or images that still need
+ * to be loaded, call this first. If it returns %TRUE, they must not
+ * touch them and return any value instead; the style that value
+ * ends up in is thrown away and computed again on the main thread.
+ *
+ * Returns: %TRUE if the value must not be computed on this thread
+ */
+gboolean
+gtk_css_value_compute_needs_main_thread (void)
+{
+  gboolean *failed = g_private_get (&threaded_compute);
+
+  if (failed == NULL)
+    return FALSE;
+
+  *failed = TRUE;
+
+  return TRUE;
+}
+
 gboolean
 _gtk_css_value_equal (const GtkCssValue *value1,
                       const GtkCssValue *value2)
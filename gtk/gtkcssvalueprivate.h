@@ -78,6 +78,9 @@ GtkCssValue *_gtk_css_value_compute                   (GtkCssValue
                                                        GtkStyleProvider           *provider,
                                                        GtkCssStyle                *style,
                                                        GtkCssStyle                *parent_style) G_GNUC_PURE;
+void            gtk_css_value_begin_threaded_compute  (gboolean                   *failed);
+void            gtk_css_value_end_threaded_compute    (void);
+gboolean        gtk_css_value_compute_needs_main_thread (void);
 gboolean     _gtk_css_value_equal                     (const GtkCssValue          *value1,
                                                        const GtkCssValue          *value2) G_GNUC_PURE;
 gboolean     _gtk_css_value_equal0                    (const GtkCssValue          *value1,
@@ -55,6 +55,14 @@
 /* random number that everyone else seems to use, too */
 #define FILES_PER_QUERY 100
 
+/* We start with small queries so the first files show up quickly, and
+ * then double the size of every query up to this, so large directories
+ * don't cause an ::items-changed for every 100 files.
+ * Native files are cheap to enumerate, so we allow bigger queries for them.
+ */
+#define MAX_FILES_PER_QUERY 1600
+#define MAX_FILES_PER_NATIVE_QUERY (64 * FILES_PER_QUERY)
+
 enum {
   PROP_0,
   PROP_ATTRIBUTES,
@@ -77,6 +85,7 @@ struct _GtkDirectoryList
   int io_priority;
 
   GCancellable *cancellable;
+  guint files_per_query; /* size of the next query */
   GError *error; /* Error while loading */
   GSequence *items; /* Use GPtrArray or GListStore here? */
 };
@@ -442,8 +451,10 @@ gtk_directory_list_got_files_cb (GObject      *source,
     }
   g_list_free (files);
 
+  self->files_per_query = MIN (2 * self->files_per_query,
+                               g_file_is_native (self->file) ? MAX_FILES_PER_NATIVE_QUERY : MAX_FILES_PER_QUERY);
   g_file_enumerator_next_files_async (enumerator,
-                                      g_file_is_native (self->file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
+                                      self->files_per_query,
                                       self->io_priority,
                                       self->cancellable,
                                       gtk_directory_list_got_files_cb,
@@ -481,8 +492,9 @@ gtk_directory_list_got_enumerator_cb (GObject      *source,
       return;
     }
 
+  self->files_per_query = FILES_PER_QUERY;
   g_file_enumerator_next_files_async (enumerator,
-                                      g_file_is_native (file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
+                                      self->files_per_query,
                                       self->io_priority,
                                       self->cancellable,
                                       gtk_directory_list_got_files_cb,
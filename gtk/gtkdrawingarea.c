@@ -29,6 +29,7 @@
 #include "gtkprivate.h"
 #include "gtksnapshot.h"
 #include "gtkwidgetprivate.h"
+#include "gdk/gdktextureprivate.h"
 
 typedef struct _GtkDrawingAreaPrivate GtkDrawingAreaPrivate;
 
@@ -39,12 +40,22 @@ struct _GtkDrawingAreaPrivate {
   GtkDrawingAreaDrawFunc draw_func;
   gpointer draw_func_target;
   GDestroyNotify draw_func_target_destroy_notify;
+
+  /* retained mode */
+  guint retained : 1;
+  cairo_surface_t *retained_surface;
+  GdkTexture *retained_texture;
+  cairo_region_t *dirty_region;
+  int retained_width;
+  int retained_height;
+  int retained_scale;
 };
 
 enum {
   PROP_0,
   PROP_CONTENT_WIDTH,
   PROP_CONTENT_HEIGHT,
+  PROP_RETAINED,
   LAST_PROP
 };
 
@@ -140,6 +151,19 @@ static guint signals[LAST_SIGNAL] = { 0, };
  *
  * If you need more complex control over your widget, you should consider
  * creating your own #GtkWidget subclass.
+ *
+ * # Retained drawing
+ *
+ * Normally the draw function is called every time the drawing area is
+ * snapshot, which includes redraws caused by GTK itself, for example
+ * when the style of the drawing area changes. For contents that are
+ * expensive to draw, the drawing area can be put in retained mode with
+ * gtk_drawing_area_set_retained(). It then keeps the result of the last
+ * call to the draw function and reuses it, until the size or the scale
+ * factor of the drawing area changes, or until the application calls
+ * gtk_drawing_area_invalidate(). Use gtk_drawing_area_invalidate_rect()
+ * to only redraw a part of the contents; the draw function is then
+ * called with a cairo context that is clipped to the invalid region.
  */
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkDrawingArea, gtk_drawing_area, GTK_TYPE_WIDGET)
@@ -162,6 +186,10 @@ gtk_drawing_area_set_property (GObject      *gobject,
       gtk_drawing_area_set_content_height (self, g_value_get_int (value));
       break;
 
+    case PROP_RETAINED:
+      gtk_drawing_area_set_retained (self, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
@@ -186,11 +214,25 @@ gtk_drawing_area_get_property (GObject    *gobject,
       g_value_set_int (value, priv->content_height);
       break;
 
+    case PROP_RETAINED:
+      g_value_set_boolean (value, priv->retained);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
 }
 
+static void
+gtk_drawing_area_clear_retained (GtkDrawingArea *self)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_clear_pointer (&priv->retained_surface, cairo_surface_destroy);
+  g_clear_object (&priv->retained_texture);
+  g_clear_pointer (&priv->dirty_region, cairo_region_destroy);
+}
+
 static void
 gtk_drawing_area_dispose (GObject *object)
 {
@@ -204,6 +246,8 @@ gtk_drawing_area_dispose (GObject *object)
   priv->draw_func_target = NULL;
   priv->draw_func_target_destroy_notify = NULL;
 
+  gtk_drawing_area_clear_retained (self);
+
   G_OBJECT_CLASS (gtk_drawing_area_parent_class)->dispose (object);
 }
 
@@ -238,6 +282,67 @@ gtk_drawing_area_size_allocate (GtkWidget *widget,
   g_signal_emit (widget, signals[RESIZE], 0, width, height);
 }
 
+/* Brings the retained contents up to date. Only the dirty region is
+ * redrawn if there is one, the rest is copied from the previous
+ * contents. The previous texture can't be drawn into, since textures
+ * are immutable and renderers may still have it uploaded.
+ */
+static void
+gtk_drawing_area_update_retained (GtkDrawingArea *self,
+                                  int             width,
+                                  int             height,
+                                  int             scale)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  if (priv->retained_texture != NULL &&
+      (priv->retained_width != width ||
+       priv->retained_height != height ||
+       priv->retained_scale != scale))
+    gtk_drawing_area_clear_retained (self);
+
+  if (priv->retained_texture != NULL &&
+      (priv->dirty_region == NULL || cairo_region_is_empty (priv->dirty_region)))
+    return;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        width * scale,
+                                        height * scale);
+  cairo_surface_set_device_scale (surface, scale, scale);
+
+  cr = cairo_create (surface);
+
+  if (priv->retained_surface != NULL && priv->dirty_region != NULL)
+    {
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_set_source_surface (cr, priv->retained_surface, 0, 0);
+      cairo_paint (cr);
+
+      gdk_cairo_region (cr, priv->dirty_region);
+      cairo_clip (cr);
+
+      cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+      cairo_paint (cr);
+      cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+    }
+
+  priv->draw_func (self,
+                   cr,
+                   width, height,
+                   priv->draw_func_target);
+  cairo_destroy (cr);
+
+  gtk_drawing_area_clear_retained (self);
+
+  priv->retained_surface = surface;
+  priv->retained_texture = gdk_texture_new_for_surface (surface);
+  priv->retained_width = width;
+  priv->retained_height = height;
+  priv->retained_scale = scale;
+}
+
 static void
 gtk_drawing_area_snapshot (GtkWidget   *widget,
                            GtkSnapshot *snapshot)
@@ -253,6 +358,19 @@ gtk_drawing_area_snapshot (GtkWidget   *widget,
   width = gtk_widget_get_width (widget);
   height = gtk_widget_get_height (widget);
 
+  if (priv->retained)
+    {
+      if (width <= 0 || height <= 0)
+        return;
+
+      gtk_drawing_area_update_retained (self,
+                                        width, height,
+                                        gtk_widget_get_scale_factor (widget));
+      gtk_snapshot_append_texture (snapshot,
+                                   priv->retained_texture,
+                                   &GRAPHENE_RECT_INIT (0, 0, width, height));
+      return;
+    }
 
   cr = gtk_snapshot_append_cairo (snapshot,
                                   &GRAPHENE_RECT_INIT (
@@ -304,6 +422,19 @@ gtk_drawing_area_class_init (GtkDrawingAreaClass *class)
                       0, G_MAXINT, 0,
                       GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkDrawingArea:retained:
+   *
+   * Whether the drawing area keeps its contents between redraws.
+   * See gtk_drawing_area_set_retained() for details.
+   */
+  props[PROP_RETAINED] =
+    g_param_spec_boolean ("retained",
+                          P_("Retained"),
+                          P_("Whether the contents are kept until invalidated"),
+                          FALSE,
+                          GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, LAST_PROP, props);
 
   /**
@@ -467,6 +598,7 @@ gtk_drawing_area_get_content_height (GtkDrawingArea *self)
  *
  * If what you are drawing does change, call gtk_widget_queue_draw() on the
  * drawing area. This will cause a redraw and will call @draw_func again.
+ * In retained mode, call gtk_drawing_area_invalidate() instead.
  */
 void
 gtk_drawing_area_set_draw_func (GtkDrawingArea         *self,
@@ -485,6 +617,117 @@ gtk_drawing_area_set_draw_func (GtkDrawingArea         *self,
   priv->draw_func_target = user_data;
   priv->draw_func_target_destroy_notify = destroy;
 
+  gtk_drawing_area_invalidate (self);
+}
+
+/**
+ * gtk_drawing_area_set_retained:
+ * @self: a #GtkDrawingArea
+ * @retained: %TRUE to keep the contents until they are invalidated
+ *
+ * Sets whether the drawing area keeps the result of its draw function
+ * between redraws.
+ *
+ * In retained mode, the draw function is only called again when the
+ * size or the scale factor of the drawing area changes, or when the
+ * contents have been invalidated with gtk_drawing_area_invalidate() or
+ * gtk_drawing_area_invalidate_rect(). Calling gtk_widget_queue_draw()
+ * is not enough, since GTK queues redraws for its own reasons as well.
+ *
+ * The contents are kept as an image at the scale factor of the drawing
+ * area, so this is best used for contents that are expensive to draw
+ * and change rarely.
+ */
+void
+gtk_drawing_area_set_retained (GtkDrawingArea *self,
+                               gboolean        retained)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_return_if_fail (GTK_IS_DRAWING_AREA (self));
+
+  retained = !!retained;
+
+  if (priv->retained == retained)
+    return;
+
+  priv->retained = retained;
+
+  gtk_drawing_area_clear_retained (self);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_RETAINED]);
+}
+
+/**
+ * gtk_drawing_area_get_retained:
+ * @self: a #GtkDrawingArea
+ *
+ * Returns whether the drawing area is in retained mode.
+ * See gtk_drawing_area_set_retained().
+ *
+ * Returns: %TRUE if the contents are kept until invalidated
+ */
+gboolean
+gtk_drawing_area_get_retained (GtkDrawingArea *self)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_DRAWING_AREA (self), FALSE);
+
+  return priv->retained;
+}
+
+/**
+ * gtk_drawing_area_invalidate:
+ * @self: a #GtkDrawingArea
+ *
+ * Invalidates all of the contents of the drawing area and queues a
+ * redraw, so that the draw function is called again.
+ *
+ * If the drawing area is not in retained mode, this is the same as
+ * calling gtk_widget_queue_draw().
+ */
+void
+gtk_drawing_area_invalidate (GtkDrawingArea *self)
+{
+  g_return_if_fail (GTK_IS_DRAWING_AREA (self));
+
+  gtk_drawing_area_clear_retained (self);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+/**
+ * gtk_drawing_area_invalidate_rect:
+ * @self: a #GtkDrawingArea
+ * @rect: the area to invalidate, in widget coordinates
+ *
+ * Invalidates a part of the contents of the drawing area and queues
+ * a redraw.
+ *
+ * In retained mode, the draw function will be called with a cairo
+ * context that is clipped to all areas invalidated since the last
+ * redraw, and that area will have been cleared. The rest of the
+ * contents is kept. Otherwise, this is the same as calling
+ * gtk_drawing_area_invalidate().
+ */
+void
+gtk_drawing_area_invalidate_rect (GtkDrawingArea     *self,
+                                  const GdkRectangle *rect)
+{
+  GtkDrawingAreaPrivate *priv = gtk_drawing_area_get_instance_private (self);
+
+  g_return_if_fail (GTK_IS_DRAWING_AREA (self));
+  g_return_if_fail (rect != NULL);
+
+  if (priv->retained_texture != NULL)
+    {
+      if (priv->dirty_region == NULL)
+        priv->dirty_region = cairo_region_create_rectangle (rect);
+      else
+        cairo_region_union_rectangle (priv->dirty_region, rect);
+    }
+
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
@@ -79,6 +79,14 @@ struct _GtkDropTarget
   GdkDragAction actions;
   guint preload : 1;
 
+  /* The result of matching against the last drop's formats. Drags
+   * usually cross the same targets many times with the same formats.
+   */
+  GdkContentFormats *match_formats;
+  GdkContentFormats *match_drop_formats;
+  GType match_gtype;
+  guint match : 1;
+
   guint dropping : 1;
   graphene_point_t coords;
   GdkDrop *drop;
@@ -242,6 +250,31 @@ gtk_drop_target_load_local (GtkDropTarget *self,
   return FALSE;
 }
 
+static void
+gtk_drop_target_match (GtkDropTarget     *self,
+                       GdkContentFormats *drop_formats)
+{
+  if (self->match_formats == self->formats &&
+      self->match_drop_formats == drop_formats)
+    return;
+
+  g_clear_pointer (&self->match_formats, gdk_content_formats_unref);
+  g_clear_pointer (&self->match_drop_formats, gdk_content_formats_unref);
+
+  if (self->formats == NULL)
+    {
+      self->match_gtype = G_TYPE_INVALID;
+      self->match = TRUE;
+      return;
+    }
+
+  self->match_formats = gdk_content_formats_ref (self->formats);
+  self->match_drop_formats = gdk_content_formats_ref (drop_formats);
+  self->match_gtype = gdk_content_formats_match_gtype (self->formats, drop_formats);
+  self->match = self->match_gtype != G_TYPE_INVALID ||
+                gdk_content_formats_match_mime_type (self->formats, drop_formats) != NULL;
+}
+
 static gboolean
 gtk_drop_target_load (GtkDropTarget *self)
 {
@@ -255,7 +288,8 @@ gtk_drop_target_load (GtkDropTarget *self)
   if (self->cancellable)
     return FALSE;
 
-  type = gdk_content_formats_match_gtype (self->formats, gdk_drop_get_formats (self->drop));
+  gtk_drop_target_match (self, gdk_drop_get_formats (self->drop));
+  type = self->match_gtype;
 
   if (gtk_drop_target_load_local (self, type))
     return TRUE;
@@ -302,7 +336,9 @@ gtk_drop_target_accept (GtkDropTarget *self,
   if (self->formats == NULL)
     return TRUE;
 
-  return gdk_content_formats_match (self->formats, gdk_drop_get_formats (drop));
+  gtk_drop_target_match (self, gdk_drop_get_formats (drop));
+
+  return self->match;
 }
 
 static GdkDragAction
@@ -484,6 +520,8 @@ gtk_drop_target_finalize (GObject *object)
   GtkDropTarget *self = GTK_DROP_TARGET (object);
 
   g_clear_pointer (&self->formats, gdk_content_formats_unref);
+  g_clear_pointer (&self->match_formats, gdk_content_formats_unref);
+  g_clear_pointer (&self->match_drop_formats, gdk_content_formats_unref);
 
   G_OBJECT_CLASS (gtk_drop_target_parent_class)->finalize (object);
 }
@@ -83,6 +83,11 @@ struct _GtkDropTargetAsync
   GdkContentFormats *formats;
   GdkDragAction actions;
 
+  /* The result of matching against the last drop's formats */
+  GdkContentFormats *match_formats;
+  GdkContentFormats *match_drop_formats;
+  gboolean match;
+
   GdkDrop *drop;
   gboolean rejected;
 };
@@ -141,7 +146,18 @@ gtk_drop_target_async_accept (GtkDropTargetAsync *self,
   if (self->formats == NULL)
     return TRUE;
 
-  return gdk_content_formats_match (self->formats, gdk_drop_get_formats (drop));
+  if (self->match_formats != self->formats ||
+      self->match_drop_formats != gdk_drop_get_formats (drop))
+    {
+      g_clear_pointer (&self->match_formats, gdk_content_formats_unref);
+      g_clear_pointer (&self->match_drop_formats, gdk_content_formats_unref);
+
+      self->match_formats = gdk_content_formats_ref (self->formats);
+      self->match_drop_formats = gdk_content_formats_ref (gdk_drop_get_formats (drop));
+      self->match = gdk_content_formats_match (self->formats, self->match_drop_formats);
+    }
+
+  return self->match;
 }
 
 static GdkDragAction
@@ -313,6 +329,8 @@ gtk_drop_target_async_finalize (GObject *object)
   GtkDropTargetAsync *self = GTK_DROP_TARGET_ASYNC (object);
 
   g_clear_pointer (&self->formats, gdk_content_formats_unref);
+  g_clear_pointer (&self->match_formats, gdk_content_formats_unref);
+  g_clear_pointer (&self->match_drop_formats, gdk_content_formats_unref);
 
   G_OBJECT_CLASS (gtk_drop_target_async_parent_class)->finalize (object);
 }
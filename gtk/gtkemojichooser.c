@@ -23,6 +23,9 @@
 #include "gtkbox.h"
 #include "gtkbutton.h"
 #include "gtkcssprovider.h"
+#include "gtkcssnodeprivate.h"
+#include "gtkcssstylechangeprivate.h"
+#include "gtkcssstyleprivate.h"
 #include "gtkentry.h"
 #include "gtkflowboxprivate.h"
 #include "gtkstack.h"
@@ -33,6 +36,8 @@
 #include "gtkintl.h"
 #include "gtkprivate.h"
 #include "gtksearchentryprivate.h"
+#include "gtksnapshotprivate.h"
+#include "gtkstylecontext.h"
 #include "gtktext.h"
 #include "gtknative.h"
 #include "gtkwidgetprivate.h"
@@ -75,10 +80,30 @@ GType gtk_emoji_chooser_child_get_type (void);
 
 #define GTK_TYPE_EMOJI_CHOOSER_CHILD (gtk_emoji_chooser_child_get_type ())
 
+/* Emoji are not put into labels. Their text is shaped once, with a
+ * layout shared by all emoji in the chooser, and only the glyphs are
+ * kept. They all use the same font, so the renderer's glyph cache
+ * holds each emoji image once.
+ */
+typedef struct
+{
+  PangoFont *font;
+  PangoGlyphString *glyphs;
+  int x; /* in Pango units */
+} EmojiGlyphs;
+
 typedef struct
 {
   GtkFlowBoxChild parent;
   GtkWidget *variations;
+
+  char *text;
+
+  /* shaped lazily, see gtk_emoji_chooser_child_ensure_glyphs() */
+  EmojiGlyphs *glyphs;
+  guint n_glyphs;
+  PangoRectangle extents;
+  int baseline;
 } GtkEmojiChooserChild;
 
 typedef struct
@@ -91,6 +116,23 @@ G_DEFINE_TYPE (GtkEmojiChooserChild, gtk_emoji_chooser_child, GTK_TYPE_FLOW_BOX_
 static void
 gtk_emoji_chooser_child_init (GtkEmojiChooserChild *child)
 {
+  /* There is no child widget to lay out, we measure the glyphs */
+  gtk_widget_set_layout_manager (GTK_WIDGET (child), NULL);
+}
+
+static void
+gtk_emoji_chooser_child_clear_glyphs (GtkEmojiChooserChild *child)
+{
+  guint i;
+
+  for (i = 0; i < child->n_glyphs; i++)
+    {
+      g_object_unref (child->glyphs[i].font);
+      pango_glyph_string_free (child->glyphs[i].glyphs);
+    }
+
+  g_clear_pointer (&child->glyphs, g_free);
+  child->n_glyphs = 0;
 }
 
 static void
@@ -99,10 +141,138 @@ gtk_emoji_chooser_child_dispose (GObject *object)
   GtkEmojiChooserChild *child = (GtkEmojiChooserChild *)object;
 
   g_clear_pointer (&child->variations, gtk_widget_unparent);
+  gtk_emoji_chooser_child_clear_glyphs (child);
 
   G_OBJECT_CLASS (gtk_emoji_chooser_child_parent_class)->dispose (object);
 }
 
+static void
+gtk_emoji_chooser_child_finalize (GObject *object)
+{
+  GtkEmojiChooserChild *child = (GtkEmojiChooserChild *)object;
+
+  g_free (child->text);
+
+  G_OBJECT_CLASS (gtk_emoji_chooser_child_parent_class)->finalize (object);
+}
+
+static PangoLayout *get_emoji_layout (GtkEmojiChooser *chooser,
+                                      GtkWidget       *child);
+
+static void
+gtk_emoji_chooser_child_ensure_glyphs (GtkEmojiChooserChild *child)
+{
+  GtkWidget *chooser;
+  PangoLayout *layout;
+  PangoLayoutIter *iter;
+  GArray *glyphs;
+
+  if (child->glyphs != NULL || child->text == NULL)
+    return;
+
+  chooser = gtk_widget_get_ancestor (GTK_WIDGET (child), GTK_TYPE_EMOJI_CHOOSER);
+  if (chooser == NULL)
+    return;
+
+  layout = get_emoji_layout (GTK_EMOJI_CHOOSER (chooser), GTK_WIDGET (child));
+  pango_layout_set_text (layout, child->text, -1);
+  pango_layout_get_extents (layout, NULL, &child->extents);
+  child->baseline = pango_layout_get_baseline (layout);
+
+  glyphs = g_array_new (FALSE, FALSE, sizeof (EmojiGlyphs));
+
+  iter = pango_layout_get_iter (layout);
+  do
+    {
+      PangoLayoutRun *run = pango_layout_iter_get_run_readonly (iter);
+      PangoRectangle rect;
+      EmojiGlyphs g;
+
+      if (run == NULL)
+        continue;
+
+      pango_layout_iter_get_run_extents (iter, NULL, &rect);
+
+      g.font = g_object_ref (run->item->analysis.font);
+      g.glyphs = pango_glyph_string_copy (run->glyphs);
+      g.x = rect.x;
+      g_array_append_val (glyphs, g);
+    }
+  while (pango_layout_iter_next_run (iter));
+  pango_layout_iter_free (iter);
+
+  child->n_glyphs = glyphs->len;
+  child->glyphs = (EmojiGlyphs *) g_array_free (glyphs, FALSE);
+}
+
+static void
+gtk_emoji_chooser_child_measure (GtkWidget      *widget,
+                                 GtkOrientation  orientation,
+                                 int             for_size,
+                                 int            *minimum,
+                                 int            *natural,
+                                 int            *minimum_baseline,
+                                 int            *natural_baseline)
+{
+  GtkEmojiChooserChild *child = (GtkEmojiChooserChild *)widget;
+
+  gtk_emoji_chooser_child_ensure_glyphs (child);
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      *minimum = *natural = PANGO_PIXELS_CEIL (child->extents.width);
+    }
+  else
+    {
+      *minimum = *natural = PANGO_PIXELS_CEIL (child->extents.height);
+      *minimum_baseline = *natural_baseline = PANGO_PIXELS (child->baseline);
+    }
+}
+
+static void
+gtk_emoji_chooser_child_snapshot (GtkWidget   *widget,
+                                  GtkSnapshot *snapshot)
+{
+  GtkEmojiChooserChild *child = (GtkEmojiChooserChild *)widget;
+  GdkRGBA color;
+  float x, y;
+  guint i;
+
+  gtk_emoji_chooser_child_ensure_glyphs (child);
+
+  gtk_style_context_get_color (gtk_widget_get_style_context (widget), &color);
+
+  /* center the text, like a label would */
+  x = (gtk_widget_get_width (widget) - (float) child->extents.width / PANGO_SCALE) / 2;
+  y = (gtk_widget_get_height (widget) - (float) child->extents.height / PANGO_SCALE) / 2;
+
+  for (i = 0; i < child->n_glyphs; i++)
+    gtk_snapshot_append_text (snapshot,
+                              child->glyphs[i].font,
+                              child->glyphs[i].glyphs,
+                              &color,
+                              x + (float) child->glyphs[i].x / PANGO_SCALE,
+                              y + (float) child->baseline / PANGO_SCALE);
+
+  GTK_WIDGET_CLASS (gtk_emoji_chooser_child_parent_class)->snapshot (widget, snapshot);
+}
+
+static void
+gtk_emoji_chooser_child_css_changed (GtkWidget         *widget,
+                                     GtkCssStyleChange *change)
+{
+  GtkEmojiChooserChild *child = (GtkEmojiChooserChild *)widget;
+
+  GTK_WIDGET_CLASS (gtk_emoji_chooser_child_parent_class)->css_changed (widget, change);
+
+  if (change == NULL ||
+      gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_TEXT_SIZE | GTK_CSS_AFFECTS_TEXT_ATTRS))
+    {
+      gtk_emoji_chooser_child_clear_glyphs (child);
+      gtk_widget_queue_resize (widget);
+    }
+}
+
 static void
 gtk_emoji_chooser_child_size_allocate (GtkWidget *widget,
                                        int        width,
@@ -163,6 +333,10 @@ gtk_emoji_chooser_child_class_init (GtkEmojiChooserChildClass *class)
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (class);
 
   object_class->dispose = gtk_emoji_chooser_child_dispose;
+  object_class->finalize = gtk_emoji_chooser_child_finalize;
+  widget_class->measure = gtk_emoji_chooser_child_measure;
+  widget_class->snapshot = gtk_emoji_chooser_child_snapshot;
+  widget_class->css_changed = gtk_emoji_chooser_child_css_changed;
   widget_class->size_allocate = gtk_emoji_chooser_child_size_allocate;
   widget_class->focus = gtk_emoji_chooser_child_focus;
   widget_class->grab_focus = gtk_emoji_chooser_child_grab_focus;
@@ -199,6 +373,9 @@ struct _GtkEmojiChooser
   GtkWidget *scrolled_window;
 
   int emoji_max_width;
+  PangoLayout *probe_layout;  /* for checking emoji before adding them */
+  PangoLayout *emoji_layout;  /* for shaping them, in the emoji font */
+  PangoFontDescription *emoji_font;
 
   EmojiSection recent;
   EmojiSection people;
@@ -242,6 +419,9 @@ gtk_emoji_chooser_finalize (GObject *object)
 
   g_clear_pointer (&chooser->data, g_variant_unref);
   g_clear_object (&chooser->settings);
+  g_clear_object (&chooser->probe_layout);
+  g_clear_object (&chooser->emoji_layout);
+  g_clear_pointer (&chooser->emoji_font, pango_font_description_free);
 
   G_OBJECT_CLASS (gtk_emoji_chooser_parent_class)->finalize (object);
 }
@@ -402,7 +582,6 @@ emoji_activated (GtkFlowBox      *box,
 {
   GtkEmojiChooser *chooser = data;
   char *text;
-  GtkWidget *label;
   GVariant *item;
   gunichar modifier;
 
@@ -417,8 +596,7 @@ emoji_activated (GtkFlowBox      *box,
         gtk_popover_popdown (GTK_POPOVER (popover));
     }
 
-  label = gtk_flow_box_child_get_child (child);
-  text = g_strdup (gtk_label_get_label (GTK_LABEL (label)));
+  text = g_strdup (((GtkEmojiChooserChild *) child)->text);
 
   item = (GVariant*) g_object_get_data (G_OBJECT (child), "emoji-data");
   modifier = (gunichar) GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (child), "modifier"));
@@ -538,9 +716,7 @@ add_emoji (GtkWidget    *box,
            gunichar      modifier,
            GtkEmojiChooser *chooser)
 {
-  GtkWidget *child;
-  GtkWidget *label;
-  PangoAttrList *attrs;
+  GtkEmojiChooserChild *child;
   GVariant *codes;
   char text[64];
   char *p = text;
@@ -563,33 +739,58 @@ add_emoji (GtkWidget    *box,
   p += g_unichar_to_utf8 (0xFE0F, p); /* U+FE0F is the Emoji variation selector */
   p[0] = 0;
 
-  label = gtk_label_new (text);
-  attrs = pango_attr_list_new ();
-  pango_attr_list_insert (attrs, pango_attr_scale_new (PANGO_SCALE_X_LARGE));
-  gtk_label_set_attributes (GTK_LABEL (label), attrs);
-  pango_attr_list_unref (attrs);
-
-  layout = gtk_label_get_layout (GTK_LABEL (label));
+  layout = chooser->probe_layout;
+  pango_layout_set_text (layout, text, -1);
   pango_layout_get_extents (layout, &rect, NULL);
 
   /* Check for fallback rendering that generates too wide items */
   if (pango_layout_get_unknown_glyphs_count (layout) > 0 ||
       rect.width >= 1.5 * chooser->emoji_max_width)
-    {
-      g_object_ref_sink (label);
-      g_object_unref (label);
-      return;
-    }
+    return;
 
   child = g_object_new (GTK_TYPE_EMOJI_CHOOSER_CHILD, NULL);
+  child->text = g_strdup (text);
   g_object_set_data_full (G_OBJECT (child), "emoji-data",
                           g_variant_ref (item),
                           (GDestroyNotify)g_variant_unref);
   if (modifier != 0)
     g_object_set_data (G_OBJECT (child), "modifier", GUINT_TO_POINTER (modifier));
 
-  gtk_flow_box_child_set_child (GTK_FLOW_BOX_CHILD (child), label);
-  gtk_flow_box_insert (GTK_FLOW_BOX (box), child, prepend ? 0 : -1);
+  gtk_flow_box_insert (GTK_FLOW_BOX (box), GTK_WIDGET (child), prepend ? 0 : -1);
+}
+
+/* Emoji are shown with the font of their CSS node, which is the same
+ * for all of them, plus the scale that labels used to add.
+ */
+static PangoLayout *
+get_emoji_layout (GtkEmojiChooser *chooser,
+                  GtkWidget       *child)
+{
+  PangoFontDescription *font;
+
+  font = gtk_css_style_get_pango_font (gtk_css_node_get_style (gtk_widget_get_css_node (child)));
+
+  if (chooser->emoji_layout == NULL ||
+      !pango_font_description_equal (font, chooser->emoji_font))
+    {
+      PangoAttrList *attrs;
+
+      g_clear_object (&chooser->emoji_layout);
+      g_clear_pointer (&chooser->emoji_font, pango_font_description_free);
+
+      chooser->emoji_layout = gtk_widget_create_pango_layout (GTK_WIDGET (chooser), NULL);
+      pango_layout_set_font_description (chooser->emoji_layout, font);
+      attrs = pango_attr_list_new ();
+      pango_attr_list_insert (attrs, pango_attr_scale_new (PANGO_SCALE_X_LARGE));
+      pango_layout_set_attributes (chooser->emoji_layout, attrs);
+      pango_attr_list_unref (attrs);
+
+      chooser->emoji_font = font;
+    }
+  else
+    pango_font_description_free (font);
+
+  return chooser->emoji_layout;
 }
 
 GBytes *
@@ -971,7 +1172,8 @@ gtk_emoji_chooser_init (GtkEmojiChooser *chooser)
     pango_layout_get_extents (layout, &rect, NULL);
     chooser->emoji_max_width = rect.width;
 
-    g_object_unref (layout);
+    /* reused for checking all the emoji in add_emoji() */
+    chooser->probe_layout = layout;
   }
 
   adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (chooser->scrolled_window));
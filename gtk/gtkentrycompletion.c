@@ -85,6 +85,7 @@
 #include "gtkwidgetprivate.h"
 #include "gtknative.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #define PAGE_STEP 14
@@ -156,6 +157,7 @@ static gboolean gtk_entry_completion_insert_completion   (GtkEntryCompletion *co
 static void     gtk_entry_completion_insert_completion_text (GtkEntryCompletion *completion,
                                                              const char *text);
 static void     connect_completion_signals                  (GtkEntryCompletion *completion);
+static void     gtk_entry_completion_clear_index            (GtkEntryCompletion *completion);
 static void     disconnect_completion_signals               (GtkEntryCompletion *completion);
 
 
@@ -664,6 +666,8 @@ gtk_entry_completion_finalize (GObject *object)
   g_free (completion->case_normalized_key);
   g_free (completion->completion_prefix);
 
+  gtk_entry_completion_clear_index (completion);
+
   if (completion->match_notify)
     (* completion->match_notify) (completion->match_data);
 
@@ -698,6 +702,245 @@ gtk_entry_completion_get_area (GtkCellLayout *cell_layout)
   return completion->cell_area;
 }
 
+/* With the default match function, completing is a prefix search
+ * on the normalized and casefolded strings of the text column. For
+ * large list models, those strings are sorted into an index in a
+ * thread, so that a key can be looked up with a binary search instead
+ * of normalizing every row on every keystroke. Until the index is
+ * ready, and after the model changes, rows are matched one by one.
+ */
+#define INDEX_MIN_ROWS 1000
+
+typedef struct {
+  const char *key;
+  guint row;
+} GtkCompletionIndexEntry;
+
+typedef struct _GtkCompletionIndex {
+  GStringChunk *strings;
+  GtkCompletionIndexEntry *entries;
+  guint n_entries;
+} GtkCompletionIndex;
+
+static void
+gtk_completion_index_free (GtkCompletionIndex *index)
+{
+  g_string_chunk_free (index->strings);
+  g_free (index->entries);
+  g_free (index);
+}
+
+static int
+compare_index_entries (gconstpointer a,
+                       gconstpointer b)
+{
+  const GtkCompletionIndexEntry *ea = a;
+  const GtkCompletionIndexEntry *eb = b;
+  int res;
+
+  res = strcmp (ea->key, eb->key);
+  if (res == 0)
+    res = (ea->row > eb->row) - (ea->row < eb->row);
+
+  return res;
+}
+
+static void
+build_index_thread (GTask        *task,
+                    gpointer      source_object,
+                    gpointer      task_data,
+                    GCancellable *cancellable)
+{
+  GPtrArray *items = task_data;
+  GtkCompletionIndex *index;
+  guint i;
+
+  index = g_new0 (GtkCompletionIndex, 1);
+  index->strings = g_string_chunk_new (4096);
+  index->entries = g_new (GtkCompletionIndexEntry, items->len);
+
+  for (i = 0; i < items->len; i++)
+    {
+      const char *item = g_ptr_array_index (items, i);
+      char *normalized, *casefolded;
+
+      if (item == NULL)
+        continue;
+
+      if ((i & 1023) == 0 && g_cancellable_is_cancelled (cancellable))
+        break;
+
+      /* same as gtk_entry_completion_default_completion_func() */
+      normalized = g_utf8_normalize (item, -1, G_NORMALIZE_ALL);
+      if (normalized == NULL)
+        continue;
+
+      casefolded = g_utf8_casefold (normalized, -1);
+      index->entries[index->n_entries].key = g_string_chunk_insert (index->strings, casefolded);
+      index->entries[index->n_entries].row = i;
+      index->n_entries++;
+
+      g_free (casefolded);
+      g_free (normalized);
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      gtk_completion_index_free (index);
+      return;
+    }
+
+  qsort (index->entries, index->n_entries, sizeof (GtkCompletionIndexEntry), compare_index_entries);
+
+  g_task_return_pointer (task, index, (GDestroyNotify) gtk_completion_index_free);
+}
+
+static void
+build_index_done (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      data)
+{
+  GtkEntryCompletion *completion = GTK_ENTRY_COMPLETION (source);
+  GtkCompletionIndex *index;
+
+  index = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (index == NULL)
+    return;
+
+  g_clear_object (&completion->index_cancellable);
+  completion->index = index;
+}
+
+static void
+index_model_changed (GtkEntryCompletion *completion)
+{
+  gtk_entry_completion_clear_index (completion);
+}
+
+static void
+gtk_entry_completion_clear_index (GtkEntryCompletion *completion)
+{
+  if (completion->index_cancellable)
+    {
+      g_cancellable_cancel (completion->index_cancellable);
+      g_clear_object (&completion->index_cancellable);
+    }
+
+  if (completion->index_model)
+    {
+      g_signal_handlers_disconnect_by_func (completion->index_model,
+                                            index_model_changed,
+                                            completion);
+      g_clear_object (&completion->index_model);
+    }
+
+  g_clear_pointer (&completion->index, gtk_completion_index_free);
+}
+
+static gboolean
+gtk_entry_completion_can_index (GtkEntryCompletion *completion,
+                                GtkTreeModel       *model)
+{
+  return completion->match_func == NULL &&
+         completion->text_column >= 0 &&
+         (gtk_tree_model_get_flags (model) & GTK_TREE_MODEL_LIST_ONLY) != 0 &&
+         gtk_tree_model_get_column_type (model, completion->text_column) == G_TYPE_STRING &&
+         gtk_tree_model_iter_n_children (model, NULL) >= INDEX_MIN_ROWS;
+}
+
+/* Reading the model is not thread-safe, so the strings are
+ * collected here and only normalized and sorted in the thread.
+ */
+static void
+gtk_entry_completion_build_index (GtkEntryCompletion *completion,
+                                  GtkTreeModel       *model)
+{
+  GPtrArray *items;
+  GTask *task;
+  GtkTreeIter iter;
+
+  items = g_ptr_array_new_full (gtk_tree_model_iter_n_children (model, NULL), g_free);
+
+  if (gtk_tree_model_get_iter_first (model, &iter))
+    {
+      do
+        {
+          char *item;
+
+          gtk_tree_model_get (model, &iter, completion->text_column, &item, -1);
+          g_ptr_array_add (items, item);
+        }
+      while (gtk_tree_model_iter_next (model, &iter));
+    }
+
+  completion->index_model = g_object_ref (model);
+  g_signal_connect_swapped (model, "row-inserted", G_CALLBACK (index_model_changed), completion);
+  g_signal_connect_swapped (model, "row-changed", G_CALLBACK (index_model_changed), completion);
+  g_signal_connect_swapped (model, "row-deleted", G_CALLBACK (index_model_changed), completion);
+  g_signal_connect_swapped (model, "rows-reordered", G_CALLBACK (index_model_changed), completion);
+
+  completion->index_cancellable = g_cancellable_new ();
+
+  task = g_task_new (completion, completion->index_cancellable, build_index_done, NULL);
+  g_task_set_source_tag (task, gtk_entry_completion_build_index);
+  g_task_set_task_data (task, items, (GDestroyNotify) g_ptr_array_unref);
+  g_task_run_in_thread (task, build_index_thread);
+  g_object_unref (task);
+}
+
+/* Returns the rows matching the current key, or %NULL
+ * if there is no index to look them up yet.
+ */
+static GtkBitset *
+gtk_entry_completion_lookup_index (GtkEntryCompletion *completion,
+                                   GtkTreeModel       *model)
+{
+  GtkCompletionIndex *index;
+  const char *key = completion->case_normalized_key;
+  gsize key_len;
+  GtkBitset *matches;
+  guint lo, hi;
+
+  if (completion->index_model != model ||
+      !gtk_entry_completion_can_index (completion, model))
+    {
+      gtk_entry_completion_clear_index (completion);
+      if (gtk_entry_completion_can_index (completion, model))
+        gtk_entry_completion_build_index (completion, model);
+      return NULL;
+    }
+
+  index = completion->index;
+  if (index == NULL)
+    return NULL;
+
+  /* find the first key that is not smaller than the typed one... */
+  lo = 0;
+  hi = index->n_entries;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (strcmp (index->entries[mid].key, key) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  /* ... all keys with the typed prefix follow it */
+  key_len = strlen (key);
+  matches = gtk_bitset_new_empty ();
+  for (; lo < index->n_entries; lo++)
+    {
+      if (strncmp (index->entries[lo].key, key, key_len) != 0)
+        break;
+
+      gtk_bitset_add (matches, index->entries[lo].row);
+    }
+
+  return matches;
+}
+
 /* all those callbacks */
 static gboolean
 gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
@@ -754,7 +997,16 @@ gtk_entry_completion_visible_func (GtkTreeModel *model,
   if (!completion->case_normalized_key)
     return ret;
 
-  if (completion->match_func)
+  if (completion->index_matches)
+    {
+      GtkTreePath *path;
+
+      path = gtk_tree_model_get_path (model, iter);
+      ret = gtk_bitset_contains (completion->index_matches,
+                                 gtk_tree_path_get_indices (path)[0]);
+      gtk_tree_path_free (path);
+    }
+  else if (completion->match_func)
     ret = (* completion->match_func) (completion,
                                             completion->case_normalized_key,
                                             iter,
@@ -1024,8 +1276,16 @@ gtk_entry_completion_complete (GtkEntryCompletion *completion)
   completion->case_normalized_key = g_utf8_casefold (tmp, -1);
   g_free (tmp);
 
+  /* The matches are only valid until the model changes,
+   * so they are only used for this refilter.
+   */
+  completion->index_matches = gtk_entry_completion_lookup_index (completion,
+                                                                 gtk_tree_model_filter_get_model (completion->filter_model));
+
   gtk_tree_model_filter_refilter (completion->filter_model);
 
+  g_clear_pointer (&completion->index_matches, gtk_bitset_unref);
+
   if (!gtk_tree_model_get_iter_first (GTK_TREE_MODEL (completion->filter_model), &iter))
     g_signal_emit (completion, entry_completion_signals[NO_MATCHES], 0);
 
@@ -19,6 +19,7 @@
 #define __GTK_ENTRY_PRIVATE_H__
 
 #include "gtkentry.h"
+#include "gtkbitset.h"
 
 #include "gtkentrycompletion.h"
 #include "gtkeventcontrollermotion.h"
@@ -77,6 +78,12 @@ struct _GtkEntryCompletion
   char *completion_prefix;
 
   GSource *check_completion_idle;
+
+  /* Prefix index over text_column, see gtk_entry_completion_complete() */
+  struct _GtkCompletionIndex *index;
+  GtkTreeModel *index_model;
+  GCancellable *index_cancellable;
+  GtkBitset *index_matches;
 };
 
 struct _GtkEntryCompletionClass
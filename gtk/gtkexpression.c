@@ -1051,6 +1051,7 @@ struct _GtkPropertyExpression
   GtkExpression *expr;
 
   GParamSpec *pspec;
+  GQuark notify_detail; /* cached for connecting watches */
 };
 
 static void
@@ -1133,6 +1134,7 @@ struct _GtkPropertyExpressionWatch
 
   GtkPropertyExpression *expr;
   gpointer               this;
+  GObject               *object; /* no reference, the object closure is connected to */
   GClosure              *closure;
   guchar                 sub[0];
 };
@@ -1146,6 +1148,7 @@ gtk_property_expression_watch_destroy_closure (GtkPropertyExpressionWatch *pwatc
   g_closure_invalidate (pwatch->closure);
   g_closure_unref (pwatch->closure);
   pwatch->closure = NULL;
+  pwatch->object = NULL;
 }
 
 static void
@@ -1157,23 +1160,37 @@ gtk_property_expression_watch_notify_cb (GObject                    *object,
 }
 
 static void
-gtk_property_expression_watch_create_closure (GtkPropertyExpressionWatch *pwatch)
+gtk_property_expression_watch_connect (GtkPropertyExpressionWatch *pwatch,
+                                       GObject                    *object)
 {
-  GObject *object;
+  static guint notify_signal_id = 0;
 
-  object = gtk_property_expression_get_object (pwatch->expr, pwatch->this);
-  if (object == NULL)
-    return;
+  if (G_UNLIKELY (notify_signal_id == 0))
+    notify_signal_id = g_signal_lookup ("notify", G_TYPE_OBJECT);
 
   pwatch->closure = g_cclosure_new (G_CALLBACK (gtk_property_expression_watch_notify_cb), pwatch, NULL);
+  g_object_watch_closure (object, pwatch->closure);
   if (!g_signal_connect_closure_by_id (object,
-                                       g_signal_lookup ("notify", G_OBJECT_TYPE (object)),
-                                       g_quark_from_string (pwatch->expr->pspec->name),
+                                       notify_signal_id,
+                                       pwatch->expr->notify_detail,
                                        g_closure_ref (pwatch->closure),
                                        FALSE))
     {
       g_assert_not_reached ();
     }
+  pwatch->object = object;
+}
+
+static void
+gtk_property_expression_watch_create_closure (GtkPropertyExpressionWatch *pwatch)
+{
+  GObject *object;
+
+  object = gtk_property_expression_get_object (pwatch->expr, pwatch->this);
+  if (object == NULL)
+    return;
+
+  gtk_property_expression_watch_connect (pwatch, object);
 
   g_object_unref (object);
 }
@@ -1182,9 +1199,29 @@ static void
 gtk_property_expression_watch_expr_notify_cb (gpointer data)
 {
   GtkPropertyExpressionWatch *pwatch = data;
+  GObject *object;
+
+  object = gtk_property_expression_get_object (pwatch->expr, pwatch->this);
+
+  /* If we still end up at the same object, our value didn't change,
+   * so there's no need to reconnect or to notify.
+   * The closure is watched on the object, so it gets invalidated when
+   * that object is finalized. If it is invalid, the object we found
+   * is a new one that happens to have the same address.
+   */
+  if (object == pwatch->object &&
+      (object == NULL || !pwatch->closure->is_invalid))
+    {
+      g_clear_object (&object);
+      return;
+    }
 
   gtk_property_expression_watch_destroy_closure (pwatch);
-  gtk_property_expression_watch_create_closure (pwatch);
+  if (object)
+    {
+      gtk_property_expression_watch_connect (pwatch, object);
+      g_object_unref (object);
+    }
   pwatch->notify (pwatch->user_data);
 }
 
@@ -1338,6 +1375,7 @@ gtk_property_expression_new_for_pspec (GtkExpression *expression,
   self = (GtkPropertyExpression *) result;
 
   self->pspec = pspec;
+  self->notify_detail = g_quark_from_string (pspec->name);
   self->expr = expression;
 
   return result;
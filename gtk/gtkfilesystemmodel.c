@@ -116,6 +116,15 @@
  * freeze_updates()) during the initial population process.  When the model is
  * frozen, sorting will not happen.  The model will sort itself when the freeze
  * count goes back to zero, via corresponding calls to thaw_updates().
+ *
+ * Files added while frozen are appended to the end of model->files and kept
+ * invisible (node->frozen_add).  Unless something else requires a full re-sort
+ * (model->sort_on_thaw), thawing only sorts these new nodes and merges them
+ * into the already sorted ones.  The existing rows keep their relative order
+ * that way, so no rows-reordered signal needs to be emitted, and the cost of
+ * a thaw depends on the number of new files rather than on the size of the
+ * directory.  Outside of frozen periods, a single added file is inserted at
+ * its sorted position directly.
  */
 
 /*** DEFINES ***/
@@ -778,13 +787,118 @@ gtk_file_system_model_sort (GtkFileSystemModel *model)
   model->sort_on_thaw = FALSE;
 }
 
+/* Returns the first index in [start, end) whose node sorts after the node
+ * at @id, assuming that range is sorted.
+ */
+static guint
+node_find_sorted_position (SortData *data,
+                           guint     id,
+                           guint     start,
+                           guint     end)
+{
+  GtkFileSystemModel *model = data->model;
+
+  while (start < end)
+    {
+      guint mid = start + (end - start) / 2;
+
+      if (compare_array_element (get_node (model, mid), get_node (model, id), data) <= 0)
+        start = mid + 1;
+      else
+        end = mid;
+    }
+
+  return start;
+}
+
 static void
-gtk_file_system_model_sort_node (GtkFileSystemModel *model, guint node)
+gtk_file_system_model_sort_node (GtkFileSystemModel *model, guint id)
 {
-  /* FIXME: improve */
+  SortData data;
+
+  if (get_node (model, id)->frozen_add)
+    return; /* will be merged when thawing */
+
+  if (!sort_data_init (&data, model))
+    return;
+
+  /* Most changes don't affect the sort order, so avoid re-sorting
+   * everything if the node is still in place.
+   */
+  if ((id <= 1 ||
+       compare_array_element (get_node (model, id - 1), get_node (model, id), &data) <= 0) &&
+      (id + 1 >= model->files->len ||
+       get_node (model, id + 1)->frozen_add ||
+       compare_array_element (get_node (model, id), get_node (model, id + 1), &data) <= 0))
+    return;
+
   gtk_file_system_model_sort (model);
 }
 
+/* Sorts the nodes that were added while the model was frozen, which are at
+ * the end of the array, and merges them into the sorted nodes before them.
+ */
+static void
+gtk_file_system_model_merge_frozen (GtkFileSystemModel *model)
+{
+  SortData data;
+  GArray *merged;
+  guint first, first_changed;
+  guint i, j, n;
+
+  if (!sort_data_init (&data, model))
+    return;
+
+  first = model->files->len;
+  while (first > 1 && get_node (model, first - 1)->frozen_add)
+    first--;
+
+  if (first == model->files->len)
+    return;
+
+  g_qsort_with_data (get_node (model, first),
+                     model->files->len - first,
+                     model->node_size,
+                     compare_array_element,
+                     &data);
+
+  /* node_get_for_file() may have indexed the new nodes already */
+  g_hash_table_remove_all (model->file_lookup);
+
+  if (first == 1)
+    {
+      node_invalidate_index (model, first);
+      return;
+    }
+
+  merged = g_array_sized_new (FALSE, FALSE, model->node_size, model->files->len);
+  g_array_append_vals (merged, get_node (model, 0), 1);
+
+  first_changed = first;
+  i = 1;
+  for (j = first; j < model->files->len; j++)
+    {
+      /* the new nodes are sorted, so each one only needs to be
+       * looked up in the part following the previous one
+       */
+      n = node_find_sorted_position (&data, j, i, first);
+      g_array_append_vals (merged, get_node (model, i), n - i);
+      i = n;
+
+      if (first_changed == first)
+        first_changed = merged->len;
+
+      g_array_append_vals (merged, get_node (model, j), 1);
+    }
+  g_array_append_vals (merged, get_node (model, i), first - i);
+
+  /* the nodes were moved, not copied */
+  g_array_free (model->files, TRUE);
+  model->files = merged;
+
+  node_invalidate_index (model, first_changed);
+}
+
 static gboolean
 gtk_file_system_model_get_sort_column_id (GtkTreeSortable  *sortable,
                                           int              *sort_column_id,
@@ -1801,6 +1915,8 @@ add_file (GtkFileSystemModel *model,
 	  GFileInfo          *info)
 {
   FileModelNode *node;
+  SortData data;
+  guint id, pos;
   
   g_return_if_fail (GTK_IS_FILE_SYSTEM_MODEL (model));
   g_return_if_fail (G_IS_FILE (file));
@@ -1813,12 +1929,40 @@ add_file (GtkFileSystemModel *model,
   node->frozen_add = model->frozen ? TRUE : FALSE;
 
   g_array_append_vals (model->files, node, 1);
-  g_slice_free1 (model->node_size, node);
 
-  if (!model->frozen)
-    node_compute_visibility_and_filters (model, model->files->len -1);
+  /* New nodes are merged into the sorted ones when thawing */
+  if (model->frozen)
+    {
+      g_slice_free1 (model->node_size, node);
+      return;
+    }
+
+  id = model->files->len - 1;
+
+  if (sort_data_init (&data, model))
+    {
+      pos = node_find_sorted_position (&data, id, 1, id);
+      if (pos < id)
+        {
+          /* the sort function may have filled in some values */
+          memcpy (node, get_node (model, id), model->node_size);
+          g_array_remove_index (model->files, id);
+          g_array_insert_vals (model->files, pos, node, 1);
+
+          if (pos <= g_hash_table_size (model->file_lookup))
+            {
+              adjust_file_lookup (model, pos, 1);
+              g_hash_table_insert (model->file_lookup, file, GUINT_TO_POINTER (pos));
+            }
+
+          node_invalidate_index (model, pos);
+          id = pos;
+        }
+    }
+
+  g_slice_free1 (model->node_size, node);
 
-  gtk_file_system_model_sort_node (model, model->files->len -1);
+  node_compute_visibility_and_filters (model, id);
 }
 
 /**
@@ -2002,6 +2146,8 @@ thaw_updates (GtkFileSystemModel *model)
     gtk_file_system_model_refilter_all (model);
   if (model->sort_on_thaw)
     gtk_file_system_model_sort (model);
+  else if (stuff_added)
+    gtk_file_system_model_merge_frozen (model);
   if (stuff_added)
     {
       guint i;
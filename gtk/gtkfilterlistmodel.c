@@ -25,6 +25,17 @@
 #include "gtkintl.h"
 #include "gtkprivate.h"
 
+/* Time we spend in the filter callback before returning to the main loop
+ *
+ * Like in GtkSortListModel, we emit ::items-changed after every step, so
+ * doing more work per step reduces the overhead in the list widgets, while
+ * still filtering slow filters in small enough steps to stay responsive.
+ */
+#define GTK_FILTER_STEP_TIME_US (1000) /* 1 millisecond */
+
+/* Items we filter between looking at the clock */
+#define GTK_FILTER_ITEMS_PER_TIME_CHECK (64)
+
 /**
  * SECTION:gtkfilterlistmodel
  * @title: GtkFilterListModel
@@ -156,9 +167,12 @@ gtk_filter_list_model_run_filter_on_item (GtkFilterListModel *self,
   return visible;
 }
 
+/* Filters pending items until @end_time is reached, pass
+ * G_MAXINT64 to filter all of them.
+ */
 static void
 gtk_filter_list_model_run_filter (GtkFilterListModel *self,
-                                  guint               n_steps)
+                                  gint64              end_time)
 {
   GtkBitsetIter iter;
   guint i, pos;
@@ -170,11 +184,17 @@ gtk_filter_list_model_run_filter (GtkFilterListModel *self,
     return;
 
   for (i = 0, more = gtk_bitset_iter_init_first (&iter, self->pending, &pos);
-       i < n_steps && more;
+       more;
        i++, more = gtk_bitset_iter_next (&iter, &pos))
     {
+      if (i > 0 && i % GTK_FILTER_ITEMS_PER_TIME_CHECK == 0 &&
+          end_time < G_MAXINT64 && g_get_monotonic_time () >= end_time)
+        break;
+
       if (gtk_filter_list_model_run_filter_on_item (self, pos))
         gtk_bitset_add (self->matches, pos);
+      else
+        gtk_bitset_remove (self->matches, pos);
     }
 
   if (more)
@@ -228,7 +248,7 @@ gtk_filter_list_model_run_filter_cb (gpointer data)
   GtkBitset *old;
 
   old = gtk_bitset_copy (self->matches);
-  gtk_filter_list_model_run_filter (self, 512);
+  gtk_filter_list_model_run_filter (self, g_get_monotonic_time () + GTK_FILTER_STEP_TIME_US);
 
   if (self->pending == NULL)
     gtk_filter_list_model_stop_filtering (self);
@@ -261,7 +281,7 @@ gtk_filter_list_model_start_filtering (GtkFilterListModel *self,
 
   if (!self->incremental)
     {
-      gtk_filter_list_model_run_filter (self, G_MAXUINT);
+      gtk_filter_list_model_run_filter (self, G_MAXINT64);
       g_assert (self->pending == NULL);
       return;
     }
@@ -505,7 +525,9 @@ gtk_filter_list_model_refilter (GtkFilterListModel *self,
             gtk_bitset_subtract (pending, self->matches);
             break;
           case GTK_FILTER_CHANGE_MORE_STRICT:
-            self->matches = gtk_bitset_new_empty ();
+            /* keep the matches while they are retested, so incremental
+             * filtering only ever removes items */
+            self->matches = gtk_bitset_copy (old);
             pending = gtk_bitset_copy (old);
             break;
           }
@@ -803,15 +825,17 @@ gtk_filter_list_model_set_incremental (GtkFilterListModel *self,
 
   if (!incremental)
     {
-      GtkBitset *old;
-      gtk_filter_list_model_run_filter (self, G_MAXUINT);
+      if (self->pending)
+        {
+          GtkBitset *old;
 
-      old = gtk_bitset_copy (self->matches);
-      gtk_filter_list_model_run_filter (self, 512);
+          old = gtk_bitset_copy (self->matches);
+          gtk_filter_list_model_run_filter (self, G_MAXINT64);
 
-      gtk_filter_list_model_stop_filtering (self);
+          gtk_filter_list_model_stop_filtering (self);
 
-      gtk_filter_list_model_emit_items_changed_for_changes (self, old);
+          gtk_filter_list_model_emit_items_changed_for_changes (self, old);
+        }
     }
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_INCREMENTAL]);
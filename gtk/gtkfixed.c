@@ -166,6 +166,7 @@ gtk_fixed_class_init (GtkFixedClass *klass)
   widget_class->get_request_mode = gtk_fixed_get_request_mode;
 
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_FIXED_LAYOUT);
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
 }
 
 static GtkBuildableIface *parent_buildable_iface;
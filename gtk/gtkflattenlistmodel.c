@@ -65,6 +65,11 @@ struct _GtkFlattenListModel
 
   GListModel *model;
   GtkRbTree *items; /* NULL if model == NULL */
+
+  /* The model of the last item we looked up, so iterating
+   * through the items doesn't need to search the tree. */
+  FlattenNode *cached_node;
+  guint cached_start; /* position of the first item in cached_node */
 };
 
 struct _GtkFlattenListModelClass
@@ -187,10 +192,18 @@ gtk_flatten_list_model_get_item (GListModel *list,
   if (!self->items)
     return NULL;
 
+  if (self->cached_node &&
+      position >= self->cached_start &&
+      position - self->cached_start < g_list_model_get_n_items (self->cached_node->model))
+    return g_list_model_get_item (self->cached_node->model, position - self->cached_start);
+
   node = gtk_flatten_list_model_get_nth (self->items, position, &model_pos);
   if (node == NULL)
     return NULL;
 
+  self->cached_node = node;
+  self->cached_start = position - model_pos;
+
   return g_list_model_get_item (node->model, model_pos);
 }
 
@@ -242,6 +255,12 @@ gtk_flatten_list_model_items_changed_cb (GListModel          *model,
         }
     }
 
+  /* Models before the cached one move it, models after it don't */
+  if (self->cached_node &&
+      _node != self->cached_node &&
+      real_position - position <= self->cached_start)
+    self->cached_node = NULL;
+
   g_list_model_items_changed (G_LIST_MODEL (self), real_position, removed, added);
 }
 
@@ -287,13 +306,22 @@ gtk_flatten_list_model_add_items (GtkFlattenListModel *self,
                                   guint                position,
                                   guint                n)
 {
-  FlattenNode *node;
+  FlattenNode *node = NULL;
+  gboolean populate;
   guint added, i;
 
+  /* Filling an empty list is common enough to build it in one go */
+  populate = after == NULL && gtk_rb_tree_get_root (self->items) == NULL;
+  if (populate)
+    node = gtk_rb_tree_populate (self->items, n);
+
   added = 0;
   for (i = 0; i < n; i++)
     {
-      node = gtk_rb_tree_insert_before (self->items, after);
+      if (populate)
+        node = i == 0 ? node : gtk_rb_tree_node_get_next (node);
+      else
+        node = gtk_rb_tree_insert_before (self->items, after);
       node->model = g_list_model_get_item (self->model, position + i);
       g_signal_connect (node->model,
                         "items-changed",
@@ -356,6 +384,8 @@ gtk_flatten_list_model_model_items_changed_cb (GListModel          *model,
   FlattenNode *node;
   guint i, real_position, real_removed, real_added;
 
+  self->cached_node = NULL;
+
   node = gtk_flatten_list_model_get_nth_model (self->items, position, &real_position);
 
   real_removed = 0;
@@ -381,6 +411,7 @@ gtk_flatten_list_clear_model (GtkFlattenListModel *self)
       g_signal_handlers_disconnect_by_func (self->model, gtk_flatten_list_model_model_items_changed_cb, self);
       g_clear_object (&self->model);
       g_clear_pointer (&self->items, gtk_rb_tree_unref);
+      self->cached_node = NULL;
     }
 }
 
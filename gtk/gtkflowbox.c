@@ -47,6 +47,14 @@
  *
  * The children of a GtkFlowBox can be dynamically sorted and filtered.
  *
+ * A GtkFlowBox that is bound to a model with gtk_flow_box_bind_model()
+ * can be made to only create children for the items that are scrolled
+ * into view by setting the #GtkFlowBox:virtualized property. This needs
+ * the scroll adjustments to be set with gtk_flow_box_set_vadjustment()
+ * or gtk_flow_box_set_hadjustment(), depending on the orientation.
+ * Children are recycled for other items while scrolling, and lines
+ * without children are estimated to be as large as the average line.
+ *
  * Although a GtkFlowBox must have only #GtkFlowBoxChild children,
  * you can add any kind of widget to it via gtk_flow_box_insert(), and
  * a GtkFlowBoxChild widget will automatically be inserted between
@@ -83,14 +91,17 @@
 #include "gtkaccessible.h"
 #include "gtkadjustment.h"
 #include "gtkbinlayout.h"
+#include "gtkbitset.h"
 #include "gtkbuildable.h"
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkeventcontrollerkey.h"
 #include "gtkgestureclick.h"
 #include "gtkgesturedrag.h"
 #include "gtkintl.h"
+#include "gtklistitemmanagerprivate.h"
 #include "gtkmain.h"
 #include "gtkmarshalers.h"
+#include "gtkmultiselection.h"
 #include "gtkorientable.h"
 #include "gtkprivate.h"
 #include "gtkrender.h"
@@ -129,6 +140,17 @@ static void gtk_flow_box_set_accept_unpaired_release (GtkFlowBox *box,
                                                       gboolean    accept);
 
 static void gtk_flow_box_check_model_compat  (GtkFlowBox *box);
+static void gtk_flow_box_bind_model_children   (GtkFlowBox *box);
+static void gtk_flow_box_unbind_model_children (GtkFlowBox *box);
+static void gtk_flow_box_update_virtual_range  (GtkFlowBox *box);
+static void gtk_flow_box_sync_virtual_children (GtkFlowBox *box);
+static void gtk_flow_box_track_child           (GtkFlowBox         *box,
+                                                GtkListItemTracker *tracker,
+                                                GtkFlowBoxChild    *child);
+static GtkFlowBoxChild *gtk_flow_box_ensure_virtual_child (GtkFlowBox *box,
+                                                           int         position);
+static void gtk_flow_box_adjustment_changed  (GtkAdjustment *adjustment,
+                                              GtkFlowBox    *box);
 
 static void
 path_from_horizontal_line_rects (cairo_t      *cr,
@@ -267,6 +289,8 @@ struct _GtkFlowBoxChildPrivate
   GtkWidget     *child;
   GSequenceIter *iter;
   gboolean       selected;
+  gpointer       item;
+  guint          position;
 };
 
 #define CHILD_PRIV(child) ((GtkFlowBoxChildPrivate*)gtk_flow_box_child_get_instance_private ((GtkFlowBoxChild*)(child)))
@@ -424,6 +448,7 @@ gtk_flow_box_child_dispose (GObject *object)
   GtkFlowBoxChildPrivate *priv = CHILD_PRIV (self);
 
   g_clear_pointer (&priv->child, gtk_widget_unparent);
+  g_clear_object (&priv->item);
 
   G_OBJECT_CLASS (gtk_flow_box_child_parent_class)->dispose (object);
 }
@@ -551,6 +576,7 @@ gtk_flow_box_child_class_init (GtkFlowBoxChildClass *class)
 
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
   gtk_widget_class_set_css_name (widget_class, I_("flowboxchild"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_GRID_CELL);
 }
 
@@ -558,6 +584,7 @@ static void
 gtk_flow_box_child_init (GtkFlowBoxChild *child)
 {
   gtk_widget_set_focusable (GTK_WIDGET (child), TRUE);
+  gtk_widget_set_render_boundary (GTK_WIDGET (child), TRUE);
 }
 
 /* Public API {{{2 */
@@ -631,6 +658,10 @@ gtk_flow_box_child_get_index (GtkFlowBoxChild *child)
 
   priv = CHILD_PRIV (child);
 
+  /* Only children of virtualized boxes have an item */
+  if (priv->iter != NULL && priv->item != NULL)
+    return priv->position;
+
   if (priv->iter != NULL)
     return g_sequence_iter_get_position (priv->iter);
 
@@ -701,6 +732,9 @@ gtk_flow_box_child_changed (GtkFlowBoxChild *child)
 #define AUTOSCROLL_FACTOR 20
 #define AUTOSCROLL_FACTOR_FAST 10
 
+/* Lines kept around before and after the visible ones in virtualized mode */
+#define VIRTUAL_EXTRA_LINES 4
+
 /* GObject boilerplate {{{2 */
 
 enum {
@@ -726,6 +760,7 @@ enum {
   PROP_SELECTION_MODE,
   PROP_ACTIVATE_ON_SINGLE_CLICK,
   PROP_ACCEPT_UNPAIRED_RELEASE,
+  PROP_VIRTUALIZED,
 
   /* orientable */
   PROP_ORIENTATION,
@@ -811,6 +846,16 @@ struct _GtkFlowBoxPrivate {
   GDestroyNotify              create_widget_func_data_destroy;
 
   gboolean           disable_move_cursor;
+
+  /* Virtualized mode, only set up while a model is bound */
+  gboolean            virtualized;
+  GtkListItemManager *item_manager;
+  GtkSelectionModel  *selection;
+  GtkListItemTracker *anchor;
+  GtkListItemTracker *cursor_tracker;
+  GtkListItemTracker *selected_tracker;
+  int                 line_size;
+  guint               tracked_line_length;
 };
 
 #define BOX_PRIV(box) ((GtkFlowBoxPrivate*)gtk_flow_box_get_instance_private ((GtkFlowBox*)(box)))
@@ -873,7 +918,7 @@ gtk_flow_box_apply_filter (GtkFlowBox      *box,
   gboolean do_show;
 
   do_show = TRUE;
-  if (priv->filter_func != NULL)
+  if (priv->filter_func != NULL && priv->item_manager == NULL)
     do_show = priv->filter_func (child, priv->filter_data);
 
   gtk_widget_set_child_visible (GTK_WIDGET (child), do_show);
@@ -900,7 +945,8 @@ static void
 gtk_flow_box_apply_sort (GtkFlowBox      *box,
                          GtkFlowBoxChild *child)
 {
-  if (BOX_PRIV (box)->sort_func != NULL)
+  if (BOX_PRIV (box)->sort_func != NULL &&
+      BOX_PRIV (box)->item_manager == NULL)
     {
       g_sequence_sort_changed (CHILD_PRIV (child)->iter,
                                (GCompareDataFunc)gtk_flow_box_sort, box);
@@ -911,8 +957,8 @@ gtk_flow_box_apply_sort (GtkFlowBox      *box,
 /* Sel ection utilities {{{3 */
 
 static gboolean
-gtk_flow_box_child_set_selected (GtkFlowBoxChild *child,
-                                 gboolean         selected)
+gtk_flow_box_child_update_selected (GtkFlowBoxChild *child,
+                                    gboolean         selected)
 {
   if (CHILD_PRIV (child)->selected != selected)
     {
@@ -933,9 +979,53 @@ gtk_flow_box_child_set_selected (GtkFlowBoxChild *child,
   return FALSE;
 }
 
+static gboolean
+gtk_flow_box_child_set_selected (GtkFlowBoxChild *child,
+                                 gboolean         selected)
+{
+  GtkFlowBox *box;
+
+  if (!gtk_flow_box_child_update_selected (child, selected))
+    return FALSE;
+
+  /* Virtualized children get recycled, so their selection lives in the model */
+  box = gtk_flow_box_child_get_box (child);
+  if (box && BOX_PRIV (box)->selection && CHILD_PRIV (child)->item)
+    {
+      if (selected)
+        gtk_selection_model_select_item (BOX_PRIV (box)->selection, CHILD_PRIV (child)->position, FALSE);
+      else
+        gtk_selection_model_unselect_item (BOX_PRIV (box)->selection, CHILD_PRIV (child)->position);
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_flow_box_set_selected_child (GtkFlowBox      *box,
+                                 GtkFlowBoxChild *child)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  priv->selected_child = child;
+  if (priv->item_manager == NULL)
+    return;
+
+  if (child)
+    {
+      gtk_flow_box_track_child (box, priv->selected_tracker, child);
+    }
+  else
+    {
+      gtk_list_item_tracker_clear (priv->item_manager, priv->selected_tracker);
+      gtk_flow_box_sync_virtual_children (box);
+    }
+}
+
 static gboolean
 gtk_flow_box_unselect_all_internal (GtkFlowBox *box)
 {
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
   GtkFlowBoxChild *child;
   GSequenceIter *iter;
   gboolean dirty = FALSE;
@@ -943,6 +1033,23 @@ gtk_flow_box_unselect_all_internal (GtkFlowBox *box)
   if (BOX_PRIV (box)->selection_mode == GTK_SELECTION_NONE)
     return FALSE;
 
+  if (priv->selection)
+    {
+      GtkBitset *selected;
+
+      /* Also covers the items that don't have children, the children
+       * get updated by the item manager
+       */
+      selected = gtk_selection_model_get_selection (priv->selection);
+      dirty = !gtk_bitset_is_empty (selected);
+      gtk_bitset_unref (selected);
+
+      gtk_selection_model_unselect_all (priv->selection);
+      priv->selected_child = NULL;
+
+      return dirty;
+    }
+
   for (iter = g_sequence_get_begin_iter (BOX_PRIV (box)->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -971,11 +1078,53 @@ gtk_flow_box_unselect_child_internal (GtkFlowBox      *box,
   g_signal_emit (box, signals[SELECTED_CHILDREN_CHANGED], 0);
 }
 
+/* Scrolls to where a virtualized child is estimated to be,
+ * in case it is outside of the lines that are laid out
+ */
+static void
+gtk_flow_box_scroll_to_virtual_child (GtkFlowBox      *box,
+                                      GtkFlowBoxChild *child)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkAdjustment *adjustment;
+  guint start, n_items, line_length;
+  int offset, spacing;
+
+  if (!gtk_list_item_tracker_get_range (priv->item_manager, priv->anchor, &start, &n_items) ||
+      (start <= CHILD_PRIV (child)->position && CHILD_PRIV (child)->position < start + n_items))
+    return;
+
+  if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      adjustment = priv->vadjustment;
+      spacing = priv->row_spacing;
+    }
+  else
+    {
+      adjustment = priv->hadjustment;
+      spacing = priv->column_spacing;
+    }
+
+  if (adjustment == NULL || priv->line_size <= 0)
+    return;
+
+  line_length = MAX (priv->cur_children_per_line, 1);
+  offset = CHILD_PRIV (child)->position / line_length * (priv->line_size + spacing);
+  gtk_adjustment_clamp_page (adjustment, offset, offset + priv->line_size);
+}
+
 static void
 gtk_flow_box_update_cursor (GtkFlowBox      *box,
                             GtkFlowBoxChild *child)
 {
-  BOX_PRIV (box)->cursor_child = child;
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  priv->cursor_child = child;
+  if (priv->item_manager)
+    {
+      gtk_flow_box_track_child (box, priv->cursor_tracker, child);
+      gtk_flow_box_scroll_to_virtual_child (box, child);
+    }
   gtk_widget_grab_focus (GTK_WIDGET (child));
 }
 
@@ -992,7 +1141,7 @@ gtk_flow_box_select_child_internal (GtkFlowBox      *box,
     gtk_flow_box_unselect_all_internal (box);
 
   gtk_flow_box_child_set_selected (child, TRUE);
-  BOX_PRIV (box)->selected_child = child;
+  gtk_flow_box_set_selected_child (box, child);
 
   g_signal_emit (box, signals[SELECTED_CHILDREN_CHANGED], 0);
 }
@@ -1003,8 +1152,22 @@ gtk_flow_box_select_all_between (GtkFlowBox      *box,
                                  GtkFlowBoxChild *child2,
 				 gboolean         modify)
 {
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
   GSequenceIter *iter, *iter1, *iter2;
 
+  if (priv->selection && !modify)
+    {
+      guint pos1, pos2;
+
+      pos1 = child1 ? CHILD_PRIV (child1)->position : 0;
+      pos2 = child2 ? CHILD_PRIV (child2)->position : g_list_model_get_n_items (G_LIST_MODEL (priv->selection)) - 1;
+      gtk_selection_model_select_range (priv->selection,
+                                        MIN (pos1, pos2),
+                                        MAX (pos1, pos2) - MIN (pos1, pos2) + 1,
+                                        FALSE);
+      return;
+    }
+
   if (child1)
     iter1 = CHILD_PRIV (child1)->iter;
   else
@@ -1059,7 +1222,7 @@ gtk_flow_box_update_selection (GtkFlowBox      *box,
     {
       gtk_flow_box_unselect_all_internal (box);
       gtk_flow_box_child_set_selected (child, TRUE);
-      priv->selected_child = child;
+      gtk_flow_box_set_selected_child (box, child);
     }
   else if (priv->selection_mode == GTK_SELECTION_SINGLE)
     {
@@ -1068,7 +1231,7 @@ gtk_flow_box_update_selection (GtkFlowBox      *box,
       was_selected = CHILD_PRIV (child)->selected;
       gtk_flow_box_unselect_all_internal (box);
       gtk_flow_box_child_set_selected (child, modify ? !was_selected : TRUE);
-      priv->selected_child = CHILD_PRIV (child)->selected ? child : NULL;
+      gtk_flow_box_set_selected_child (box, CHILD_PRIV (child)->selected ? child : NULL);
     }
   else /* GTK_SELECTION_MULTIPLE */
     {
@@ -1078,7 +1241,7 @@ gtk_flow_box_update_selection (GtkFlowBox      *box,
           if (priv->selected_child == NULL)
             {
               gtk_flow_box_child_set_selected (child, TRUE);
-              priv->selected_child = child;
+              gtk_flow_box_set_selected_child (box, child);
             }
           else
             gtk_flow_box_select_all_between (box, priv->selected_child, child, FALSE);
@@ -1093,7 +1256,7 @@ gtk_flow_box_update_selection (GtkFlowBox      *box,
             {
               gtk_flow_box_unselect_all_internal (box);
               gtk_flow_box_child_set_selected (child, !CHILD_PRIV (child)->selected);
-              priv->selected_child = child;
+              gtk_flow_box_set_selected_child (box, child);
             }
         }
     }
@@ -1522,6 +1685,47 @@ get_offset_pixels (GtkAlign align,
   return offset;
 }
 
+/* The number of lines that don't have children in virtualized mode */
+static int
+gtk_flow_box_get_n_virtual_lines (GtkFlowBox *box,
+                                  int         line_length,
+                                  int         n_lines)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  int n_items;
+
+  if (priv->item_manager == NULL)
+    return 0;
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->selection));
+
+  return MAX ((n_items + line_length - 1) / line_length - n_lines, 0);
+}
+
+/* In virtualized mode, lines without children are assumed
+ * to be as large as the average line that has some
+ */
+static void
+gtk_flow_box_add_virtual_lines (GtkFlowBox *box,
+                                int         line_length,
+                                int         n_lines,
+                                int         spacing,
+                                int        *min_size,
+                                int        *nat_size)
+{
+  int n_missing;
+
+  if (n_lines <= 0)
+    return;
+
+  n_missing = gtk_flow_box_get_n_virtual_lines (box, line_length, n_lines);
+  if (n_missing <= 0)
+    return;
+
+  *min_size += n_missing * ((*min_size - (n_lines - 1) * spacing) / n_lines + spacing);
+  *nat_size += n_missing * ((*nat_size - (n_lines - 1) * spacing) / n_lines + spacing);
+}
+
 static void
 gtk_flow_box_size_allocate (GtkWidget *widget,
                             int        width,
@@ -1543,6 +1747,7 @@ gtk_flow_box_size_allocate (GtkWidget *widget,
   int line_offset, item_offset, n_children, n_lines, line_count;
   int extra_pixels = 0, extra_per_item = 0, extra_extra = 0;
   int extra_line_pixels = 0, extra_per_line = 0, extra_line_extra = 0;
+  int virtual_line_size = 0, prev_line = -1;
   int i, this_line_size;
   GSequenceIter *iter;
 
@@ -1635,6 +1840,11 @@ gtk_flow_box_size_allocate (GtkWidget *widget,
                                                  &min_fixed_line_size,
                                                  &nat_fixed_line_size);
 
+      /* Leave room for the lines without children */
+      virtual_line_size = min_fixed_line_size;
+      avail_other_size -= gtk_flow_box_get_n_virtual_lines (box, line_length, n_lines) *
+                          (virtual_line_size + line_spacing);
+
       /* resolve a fixed 'line_size' */
       line_size = (avail_other_size - (n_lines - 1) * line_spacing) / n_lines;
 
@@ -1709,6 +1919,27 @@ gtk_flow_box_size_allocate (GtkWidget *widget,
             }
         }
 
+      if (priv->item_manager)
+        {
+          int n_sized_lines = 0;
+
+          /* Leave room for the lines without children, at their average size */
+          for (i = 0; i < n_lines; i++)
+            {
+              if (line_sizes[i].natural_size > 0)
+                {
+                  virtual_line_size += line_sizes[i].minimum_size;
+                  n_sized_lines++;
+                }
+            }
+
+          if (n_sized_lines > 0)
+            virtual_line_size /= n_sized_lines;
+
+          avail_other_size -= gtk_flow_box_get_n_virtual_lines (box, line_length, n_lines) *
+                              (virtual_line_size + line_spacing);
+        }
+
       /* Distribute space among lines naturally */
       if (avail_other_size > 0)
         extra_line_pixels = gtk_distribute_natural_allocation (avail_other_size, n_lines, line_sizes);
@@ -1840,6 +2071,15 @@ gtk_flow_box_size_allocate (GtkWidget *widget,
             }
         }
 
+      /* Leave room for the lines without children in front of this one */
+      if (priv->item_manager && position == 0)
+        {
+          int child_line = CHILD_PRIV (child)->position / line_length;
+
+          line_offset += MAX (child_line - prev_line - 1, 0) * (virtual_line_size + line_spacing);
+          prev_line = child_line;
+        }
+
       /* Push the index along for the last line when spreading to the end */
       if (item_align == GTK_ALIGN_END && line_count == n_lines -1)
         {
@@ -1890,6 +2130,12 @@ gtk_flow_box_size_allocate (GtkWidget *widget,
 
   g_free (item_sizes);
   g_free (line_sizes);
+
+  if (priv->item_manager)
+    {
+      priv->line_size = virtual_line_size;
+      gtk_flow_box_update_virtual_range (box);
+    }
 }
 
 static GtkSizeRequestMode
@@ -2164,10 +2410,14 @@ gtk_flow_box_measure (GtkWidget      *widget,
 
                   min_width += (lines - 1) * priv->column_spacing;
                   nat_width += (lines - 1) * priv->column_spacing;
+
+                  gtk_flow_box_add_virtual_lines (box, line_length, lines, priv->column_spacing,
+                                                  &min_width, &nat_width);
                 }
               else
                 {
                   int min_line_width, nat_line_width, i;
+                  int n_lines = 0;
                   gboolean first_line = TRUE;
                   GtkRequestedSize *item_sizes;
                   GSequenceIter *iter;
@@ -2216,9 +2466,13 @@ gtk_flow_box_measure (GtkWidget      *widget,
 
                           min_width += min_line_width;
                           nat_width += nat_line_width;
+                          n_lines++;
                         }
                     }
                   g_free (item_sizes);
+
+                  gtk_flow_box_add_virtual_lines (box, line_length, n_lines, priv->column_spacing,
+                                                  &min_width, &nat_width);
                 }
             }
 
@@ -2403,10 +2657,14 @@ gtk_flow_box_measure (GtkWidget      *widget,
 
                   min_height += (lines - 1) * priv->row_spacing;
                   nat_height += (lines - 1) * priv->row_spacing;
+
+                  gtk_flow_box_add_virtual_lines (box, line_length, lines, priv->row_spacing,
+                                                  &min_height, &nat_height);
                 }
               else
                 {
                   int min_line_height, nat_line_height, i;
+                  int n_lines = 0;
                   gboolean first_line = TRUE;
                   GtkRequestedSize *item_sizes;
                   GSequenceIter *iter;
@@ -2454,10 +2712,14 @@ gtk_flow_box_measure (GtkWidget      *widget,
 
                           min_height += min_line_height;
                           nat_height += nat_line_height;
+                          n_lines++;
                         }
                     }
 
                   g_free (item_sizes);
+
+                  gtk_flow_box_add_virtual_lines (box, line_length, n_lines, priv->row_spacing,
+                                                  &min_height, &nat_height);
                 }
             }
           else /* GTK_ORIENTATION_VERTICAL */
@@ -3052,6 +3314,12 @@ gtk_flow_box_remove (GtkFlowBox *box,
         }
     }
 
+  if (priv->item_manager)
+    {
+      g_warning ("Children of a virtualized GtkFlowBox can only be removed from its model");
+      return;
+    }
+
   was_visible = child_is_visible (GTK_WIDGET (child));
   was_selected = CHILD_PRIV (child)->selected;
 
@@ -3234,7 +3502,14 @@ gtk_flow_box_move_cursor (GtkFlowBox      *box,
   switch ((guint) step)
     {
     case GTK_MOVEMENT_VISUAL_POSITIONS:
-      if (priv->cursor_child != NULL)
+      if (priv->cursor_child != NULL && priv->item_manager)
+        {
+          if (gtk_widget_get_direction (GTK_WIDGET (box)) == GTK_TEXT_DIR_RTL)
+            count = - count;
+
+          child = gtk_flow_box_ensure_virtual_child (box, (int) CHILD_PRIV (priv->cursor_child)->position + count);
+        }
+      else if (priv->cursor_child != NULL)
         {
           iter = CHILD_PRIV (priv->cursor_child)->iter;
           if (gtk_widget_get_direction (GTK_WIDGET (box)) == GTK_TEXT_DIR_RTL)
@@ -3257,6 +3532,12 @@ gtk_flow_box_move_cursor (GtkFlowBox      *box,
       break;
 
     case GTK_MOVEMENT_BUFFER_ENDS:
+      if (priv->item_manager)
+        {
+          child = gtk_flow_box_ensure_virtual_child (box, count < 0 ? 0 : (int) g_list_model_get_n_items (G_LIST_MODEL (priv->selection)) - 1);
+          break;
+        }
+
       if (count < 0)
         iter = gtk_flow_box_get_first_focusable (box);
       else
@@ -3266,7 +3547,13 @@ gtk_flow_box_move_cursor (GtkFlowBox      *box,
       break;
 
     case GTK_MOVEMENT_DISPLAY_LINES:
-      if (priv->cursor_child != NULL)
+      if (priv->cursor_child != NULL && priv->item_manager)
+        {
+          child = gtk_flow_box_ensure_virtual_child (box,
+                                                     (int) CHILD_PRIV (priv->cursor_child)->position +
+                                                     count * priv->cur_children_per_line);
+        }
+      else if (priv->cursor_child != NULL)
         {
           iter = CHILD_PRIV (priv->cursor_child)->iter;
 
@@ -3292,7 +3579,17 @@ gtk_flow_box_move_cursor (GtkFlowBox      *box,
       if (adjustment)
         page_size = gtk_adjustment_get_page_increment (adjustment);
 
-      if (priv->cursor_child != NULL)
+      if (priv->cursor_child != NULL && priv->item_manager)
+        {
+          int n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->selection));
+          int stride = priv->line_size + (vertical ? priv->column_spacing : priv->row_spacing);
+          int page_lines = MAX (page_size / MAX (stride, 1), 1);
+          int target = (int) CHILD_PRIV (priv->cursor_child)->position +
+                       count * page_lines * priv->cur_children_per_line;
+
+          child = gtk_flow_box_ensure_virtual_child (box, CLAMP (target, 0, n_items - 1));
+        }
+      else if (priv->cursor_child != NULL)
         {
           child = priv->cursor_child;
           iter = CHILD_PRIV (child)->iter;
@@ -3436,6 +3733,9 @@ gtk_flow_box_get_property (GObject    *object,
     case PROP_ACCEPT_UNPAIRED_RELEASE:
       g_value_set_boolean (value, priv->accept_unpaired_release);
       break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, priv->virtualized);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3493,6 +3793,9 @@ gtk_flow_box_set_property (GObject      *object,
     case PROP_ACCEPT_UNPAIRED_RELEASE:
       gtk_flow_box_set_accept_unpaired_release (box, g_value_get_boolean (value));
       break;
+    case PROP_VIRTUALIZED:
+      gtk_flow_box_set_virtualized (box, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3509,6 +3812,15 @@ gtk_flow_box_dispose (GObject *obj)
   if (priv->sort_destroy != NULL)
     priv->sort_destroy (priv->sort_data);
 
+  if (priv->hadjustment)
+    g_signal_handlers_disconnect_by_func (priv->hadjustment, gtk_flow_box_adjustment_changed, obj);
+  if (priv->vadjustment)
+    g_signal_handlers_disconnect_by_func (priv->vadjustment, gtk_flow_box_adjustment_changed, obj);
+
+  /* Virtualized children belong to the item manager */
+  if (priv->item_manager)
+    gtk_flow_box_unbind_model_children (GTK_FLOW_BOX (obj));
+
   if (priv->children)
     {
       GSequenceIter *iter;
@@ -3620,6 +3932,21 @@ gtk_flow_box_class_init (GtkFlowBoxClass *class)
                           FALSE,
                           GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkFlowBox:virtualized:
+   *
+   * Whether a bound model only gets children created for the items
+   * that are visible.
+   *
+   * See gtk_flow_box_set_virtualized().
+   */
+  props[PROP_VIRTUALIZED] =
+    g_param_spec_boolean ("virtualized",
+                          P_("Virtualized"),
+                          P_("Only create children for visible items of the model"),
+                          FALSE,
+                          GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   /**
    * GtkFlowBox:homogeneous:
    *
@@ -3951,6 +4278,375 @@ gtk_flow_box_init (GtkFlowBox *box)
   gtk_widget_add_controller (GTK_WIDGET (box), controller);
 }
 
+/* Virtualized mode {{{2 */
+
+/* Makes priv->children match the children the item manager has created.
+ * The sequence holds a reference on its children, so children the item
+ * manager let go of stay alive until they are dropped here.
+ */
+static void
+gtk_flow_box_sync_virtual_children (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkListItemManagerItem *item;
+  GSequence *old_children;
+  GSequenceIter *iter;
+
+  old_children = priv->children;
+  for (iter = g_sequence_get_begin_iter (old_children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    CHILD_PRIV (g_sequence_get (iter))->iter = NULL;
+
+  priv->children = g_sequence_new (g_object_unref);
+  for (item = gtk_list_item_manager_get_first (priv->item_manager);
+       item != NULL;
+       item = gtk_rb_tree_node_get_next (item))
+    {
+      if (item->widget == NULL)
+        continue;
+
+      CHILD_PRIV (item->widget)->iter = g_sequence_append (priv->children, g_object_ref (item->widget));
+    }
+
+  /* Forget about children that are gone */
+  if (priv->selected_child && CHILD_PRIV (priv->selected_child)->iter == NULL)
+    priv->selected_child = NULL;
+  if (priv->cursor_child && CHILD_PRIV (priv->cursor_child)->iter == NULL)
+    priv->cursor_child = NULL;
+  if (priv->active_child && CHILD_PRIV (priv->active_child)->iter == NULL)
+    priv->active_child = NULL;
+  if (priv->rubberband_first && CHILD_PRIV (priv->rubberband_first)->iter == NULL)
+    priv->rubberband_first = NULL;
+  if (priv->rubberband_last && CHILD_PRIV (priv->rubberband_last)->iter == NULL)
+    priv->rubberband_last = NULL;
+
+  g_sequence_free (old_children);
+
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
+/* Trackers keep whole lines around, so that the children
+ * get flowed into the same lines as without virtualization
+ */
+static void
+gtk_flow_box_set_tracker_line (GtkFlowBox         *box,
+                               GtkListItemTracker *tracker,
+                               guint               position)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  guint line_length, n_items, column;
+
+  line_length = MAX (priv->cur_children_per_line, 1);
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->selection));
+  column = position % line_length;
+
+  gtk_list_item_tracker_set_position (priv->item_manager,
+                                      tracker,
+                                      position,
+                                      column,
+                                      MIN (line_length - 1 - column, n_items - 1 - position));
+}
+
+static void
+gtk_flow_box_track_child (GtkFlowBox         *box,
+                          GtkListItemTracker *tracker,
+                          GtkFlowBoxChild    *child)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  guint position;
+
+  if (child == NULL)
+    return;
+
+  position = CHILD_PRIV (child)->position;
+  if (gtk_list_item_tracker_get_position (priv->item_manager, tracker) == position)
+    return;
+
+  gtk_flow_box_set_tracker_line (box, tracker, position);
+  gtk_flow_box_sync_virtual_children (box);
+}
+
+/* Moves the cursor tracker to @position, so that a child exists for it */
+static GtkFlowBoxChild *
+gtk_flow_box_ensure_virtual_child (GtkFlowBox *box,
+                                   int         position)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkListItemManagerItem *item;
+
+  if (position < 0 ||
+      (guint) position >= g_list_model_get_n_items (G_LIST_MODEL (priv->selection)))
+    return NULL;
+
+  gtk_flow_box_set_tracker_line (box, priv->cursor_tracker, position);
+  gtk_flow_box_sync_virtual_children (box);
+
+  item = gtk_list_item_manager_get_nth (priv->item_manager, position, NULL);
+
+  return GTK_FLOW_BOX_CHILD (item->widget);
+}
+
+static void
+gtk_flow_box_update_virtual_range (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkAdjustment *adjustment;
+  guint n_items, line_length, first_line, n_lines, n_children, position, start, n;
+  int spacing;
+
+  if (priv->item_manager == NULL)
+    return;
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->selection));
+  if (n_items == 0)
+    return;
+
+  line_length = MAX (priv->cur_children_per_line, 1);
+
+  if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      adjustment = priv->vadjustment;
+      spacing = priv->row_spacing;
+    }
+  else
+    {
+      adjustment = priv->hadjustment;
+      spacing = priv->column_spacing;
+    }
+
+  if (adjustment == NULL)
+    {
+      /* Without scrolling, all children are visible */
+      first_line = 0;
+      n_lines = (n_items + line_length - 1) / line_length;
+    }
+  else if (priv->line_size <= 0)
+    {
+      /* Nothing was allocated yet, start at the top */
+      first_line = 0;
+      n_lines = VIRTUAL_EXTRA_LINES;
+    }
+  else
+    {
+      double value = gtk_adjustment_get_value (adjustment);
+      double page_size = gtk_adjustment_get_page_size (adjustment);
+      int stride = priv->line_size + spacing;
+
+      first_line = MAX (value, 0) / stride;
+      n_lines = ceil (page_size / stride) + 1;
+    }
+
+  position = MIN (first_line, (n_items - 1) / line_length) * line_length;
+  n_children = n_lines * line_length;
+
+  /* Keep the children while they cover what is visible */
+  if (priv->tracked_line_length == line_length &&
+      gtk_list_item_tracker_get_range (priv->item_manager, priv->anchor, &start, &n) &&
+      start <= position &&
+      MIN (position + n_children, n_items) <= start + n &&
+      n <= n_children + 3 * VIRTUAL_EXTRA_LINES * line_length)
+    return;
+
+  /* The line length changed or the window moved, line everything up again */
+  priv->tracked_line_length = line_length;
+  gtk_list_item_tracker_set_position (priv->item_manager,
+                                      priv->anchor,
+                                      position,
+                                      MIN (VIRTUAL_EXTRA_LINES * line_length, position),
+                                      MIN (n_children + VIRTUAL_EXTRA_LINES * line_length - 1, n_items - 1 - position));
+
+  position = gtk_list_item_tracker_get_position (priv->item_manager, priv->cursor_tracker);
+  if (position != GTK_INVALID_LIST_POSITION)
+    gtk_flow_box_set_tracker_line (box, priv->cursor_tracker, position);
+
+  position = gtk_list_item_tracker_get_position (priv->item_manager, priv->selected_tracker);
+  if (position != GTK_INVALID_LIST_POSITION)
+    gtk_flow_box_set_tracker_line (box, priv->selected_tracker, position);
+
+  gtk_flow_box_sync_virtual_children (box);
+}
+
+static void
+gtk_flow_box_adjustment_changed (GtkAdjustment *adjustment,
+                                 GtkFlowBox    *box)
+{
+  gtk_flow_box_update_virtual_range (box);
+}
+
+static GtkWidget *
+gtk_flow_box_create_virtual_child (gpointer user_data)
+{
+  return gtk_flow_box_child_new ();
+}
+
+static void
+gtk_flow_box_update_virtual_child (GtkWidget *widget,
+                                   guint      position,
+                                   gpointer   item,
+                                   gboolean   selected,
+                                   gpointer   user_data)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (user_data);
+  GtkFlowBoxChild *child = GTK_FLOW_BOX_CHILD (widget);
+  GtkFlowBoxChildPrivate *child_priv = CHILD_PRIV (child);
+
+  child_priv->position = position;
+
+  if (child_priv->item != item)
+    {
+      gtk_flow_box_child_set_child (child, NULL);
+      g_clear_object (&child_priv->item);
+
+      if (item)
+        {
+          GtkWidget *content;
+
+          child_priv->item = g_object_ref (item);
+
+          content = priv->create_widget_func (item, priv->create_widget_func_data);
+          if (g_object_is_floating (content))
+            g_object_ref_sink (content);
+
+          if (GTK_IS_FLOW_BOX_CHILD (content))
+            {
+              g_warning ("The widget creation function of a virtualized GtkFlowBox must not return a GtkFlowBoxChild");
+            }
+          else
+            {
+              gtk_widget_show (content);
+              gtk_flow_box_child_set_child (child, content);
+            }
+
+          g_object_unref (content);
+        }
+    }
+
+  gtk_flow_box_child_update_selected (child, selected);
+}
+
+static gpointer
+gtk_flow_box_get_virtual_child_item (GtkWidget *widget)
+{
+  return CHILD_PRIV (widget)->item;
+}
+
+static guint
+gtk_flow_box_get_virtual_child_position (GtkWidget *widget)
+{
+  return CHILD_PRIV (widget)->position;
+}
+
+static const GtkListItemManagerWidgetFuncs virtual_child_funcs = {
+  gtk_flow_box_create_virtual_child,
+  gtk_flow_box_update_virtual_child,
+  gtk_flow_box_get_virtual_child_item,
+  gtk_flow_box_get_virtual_child_position
+};
+
+static void
+gtk_flow_box_virtual_items_changed (GListModel *model,
+                                    guint       position,
+                                    guint       removed,
+                                    guint       added,
+                                    GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  gboolean had_selected_child = priv->selected_child != NULL;
+
+  /* Positions moved, so the lines need to be lined up again */
+  priv->tracked_line_length = 0;
+  gtk_flow_box_sync_virtual_children (box);
+  gtk_flow_box_update_virtual_range (box);
+
+  if (had_selected_child && priv->selected_child == NULL)
+    g_signal_emit (box, signals[SELECTED_CHILDREN_CHANGED], 0);
+}
+
+static void
+gtk_flow_box_bind_model_children (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  if (!priv->virtualized)
+    {
+      g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_flow_box_bound_model_changed), box);
+      gtk_flow_box_bound_model_changed (priv->bound_model, 0, 0, g_list_model_get_n_items (priv->bound_model), box);
+      return;
+    }
+
+  priv->selection = GTK_SELECTION_MODEL (gtk_multi_selection_new (g_object_ref (priv->bound_model)));
+  priv->item_manager = gtk_list_item_manager_new_for_size (GTK_WIDGET (box),
+                                                           "flowboxchild",
+                                                           GTK_ACCESSIBLE_ROLE_GRID_CELL,
+                                                           sizeof (GtkListItemManagerItem),
+                                                           sizeof (GtkListItemManagerItemAugment),
+                                                           gtk_list_item_manager_augment_node);
+  gtk_list_item_manager_set_widget_funcs (priv->item_manager, &virtual_child_funcs, box);
+  priv->anchor = gtk_list_item_tracker_new (priv->item_manager);
+  priv->cursor_tracker = gtk_list_item_tracker_new (priv->item_manager);
+  priv->selected_tracker = gtk_list_item_tracker_new (priv->item_manager);
+  priv->line_size = 0;
+  priv->tracked_line_length = 0;
+
+  gtk_list_item_manager_set_model (priv->item_manager, priv->selection);
+  /* Connected after the item manager, so its children are up to date */
+  g_signal_connect (priv->selection, "items-changed", G_CALLBACK (gtk_flow_box_virtual_items_changed), box);
+
+  gtk_flow_box_update_virtual_range (box);
+  gtk_flow_box_sync_virtual_children (box);
+}
+
+static void
+gtk_flow_box_unbind_model_children (GtkFlowBox *box)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GtkWidget *child;
+
+  if (priv->item_manager)
+    {
+      GSequence *children;
+      GSequenceIter *iter;
+
+      g_signal_handlers_disconnect_by_func (priv->selection, gtk_flow_box_virtual_items_changed, box);
+
+      gtk_list_item_tracker_free (priv->item_manager, priv->anchor);
+      gtk_list_item_tracker_free (priv->item_manager, priv->cursor_tracker);
+      gtk_list_item_tracker_free (priv->item_manager, priv->selected_tracker);
+      priv->anchor = NULL;
+      priv->cursor_tracker = NULL;
+      priv->selected_tracker = NULL;
+
+      /* This unparents all children */
+      g_clear_object (&priv->item_manager);
+      g_clear_object (&priv->selection);
+
+      priv->selected_child = NULL;
+      priv->cursor_child = NULL;
+      priv->active_child = NULL;
+      priv->rubberband_first = NULL;
+      priv->rubberband_last = NULL;
+
+      children = priv->children;
+      priv->children = g_sequence_new (NULL);
+      for (iter = g_sequence_get_begin_iter (children);
+           !g_sequence_iter_is_end (iter);
+           iter = g_sequence_iter_next (iter))
+        CHILD_PRIV (g_sequence_get (iter))->iter = NULL;
+      g_sequence_free (children);
+
+      gtk_widget_queue_resize (GTK_WIDGET (box));
+    }
+  else
+    {
+      if (priv->bound_model)
+        g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_flow_box_bound_model_changed, box);
+
+      while ((child = gtk_widget_get_first_child (GTK_WIDGET (box))))
+        gtk_flow_box_remove (box, child);
+    }
+}
+
 static void
 gtk_flow_box_bound_model_changed (GListModel *list,
                                   guint       position,
@@ -4081,6 +4777,12 @@ gtk_flow_box_insert (GtkFlowBox *box,
 
   priv = BOX_PRIV (box);
 
+  if (priv->item_manager)
+    {
+      g_warning ("Children can only be added to a virtualized GtkFlowBox through its model");
+      return;
+    }
+
   if (GTK_IS_FLOW_BOX_CHILD (widget))
     child = GTK_FLOW_BOX_CHILD (widget);
   else
@@ -4115,6 +4817,9 @@ gtk_flow_box_insert (GtkFlowBox *box,
  *
  * Gets the nth child in the @box.
  *
+ * If @box is virtualized, %NULL is also returned for items that
+ * currently don't have a child.
+ *
  * Returns: (transfer none) (nullable): the child widget, which will
  *     always be a #GtkFlowBoxChild or %NULL in case no child widget
  *     with the given index exists.
@@ -4123,11 +4828,28 @@ GtkFlowBoxChild *
 gtk_flow_box_get_child_at_index (GtkFlowBox *box,
                                  int         idx)
 {
+  GtkFlowBoxPrivate *priv;
   GSequenceIter *iter;
 
   g_return_val_if_fail (GTK_IS_FLOW_BOX (box), NULL);
 
-  iter = g_sequence_get_iter_at_pos (BOX_PRIV (box)->children, idx);
+  priv = BOX_PRIV (box);
+
+  if (priv->item_manager)
+    {
+      GtkListItemManagerItem *item;
+
+      if (idx < 0)
+        return NULL;
+
+      item = gtk_list_item_manager_get_nth (priv->item_manager, idx, NULL);
+      if (item && item->widget)
+        return GTK_FLOW_BOX_CHILD (item->widget);
+
+      return NULL;
+    }
+
+  iter = g_sequence_get_iter_at_pos (priv->children, idx);
   if (!g_sequence_iter_is_end (iter))
     return g_sequence_get (iter);
 
@@ -4190,8 +4912,19 @@ gtk_flow_box_set_hadjustment (GtkFlowBox    *box,
 
   g_object_ref (adjustment);
   if (priv->hadjustment)
-    g_object_unref (priv->hadjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->hadjustment, gtk_flow_box_adjustment_changed, box);
+      g_object_unref (priv->hadjustment);
+    }
   priv->hadjustment = adjustment;
+
+  /* Virtualized boxes create the children that get scrolled into view */
+  g_signal_connect (adjustment, "value-changed",
+                    G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+  g_signal_connect (adjustment, "changed",
+                    G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+
+  gtk_flow_box_update_virtual_range (box);
 }
 
 /**
@@ -4224,8 +4957,19 @@ gtk_flow_box_set_vadjustment (GtkFlowBox    *box,
 
   g_object_ref (adjustment);
   if (priv->vadjustment)
-    g_object_unref (priv->vadjustment);
+    {
+      g_signal_handlers_disconnect_by_func (priv->vadjustment, gtk_flow_box_adjustment_changed, box);
+      g_object_unref (priv->vadjustment);
+    }
   priv->vadjustment = adjustment;
+
+  /* Virtualized boxes create the children that get scrolled into view */
+  g_signal_connect (adjustment, "value-changed",
+                    G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+  g_signal_connect (adjustment, "changed",
+                    G_CALLBACK (gtk_flow_box_adjustment_changed), box);
+
+  gtk_flow_box_update_virtual_range (box);
 }
 
 static void
@@ -4271,24 +5015,21 @@ gtk_flow_box_bind_model (GtkFlowBox                 *box,
                          GDestroyNotify              user_data_free_func)
 {
   GtkFlowBoxPrivate *priv = BOX_PRIV (box);
-  GtkWidget *child;
 
   g_return_if_fail (GTK_IS_FLOW_BOX (box));
   g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
   g_return_if_fail (model == NULL || create_widget_func != NULL);
 
+  gtk_flow_box_unbind_model_children (box);
+
   if (priv->bound_model)
     {
       if (priv->create_widget_func_data_destroy)
         priv->create_widget_func_data_destroy (priv->create_widget_func_data);
 
-      g_signal_handlers_disconnect_by_func (priv->bound_model, gtk_flow_box_bound_model_changed, box);
       g_clear_object (&priv->bound_model);
     }
 
-  while ((child = gtk_widget_get_first_child (GTK_WIDGET (box))))
-    gtk_flow_box_remove (box, child);
-
   if (model == NULL)
     return;
 
@@ -4298,9 +5039,7 @@ gtk_flow_box_bind_model (GtkFlowBox                 *box,
   priv->create_widget_func_data_destroy = user_data_free_func;
 
   gtk_flow_box_check_model_compat (box);
-
-  g_signal_connect (priv->bound_model, "items-changed", G_CALLBACK (gtk_flow_box_bound_model_changed), box);
-  gtk_flow_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+  gtk_flow_box_bind_model_children (box);
 }
 
 /* Setters and getters {{{2 */
@@ -4550,6 +5289,61 @@ gtk_flow_box_get_activate_on_single_click (GtkFlowBox *box)
   return BOX_PRIV (box)->activate_on_single_click;
 }
 
+/**
+ * gtk_flow_box_set_virtualized:
+ * @box: a #GtkFlowBox
+ * @virtualized: %TRUE to only create children for visible items
+ *
+ * Sets whether children for a model bound with gtk_flow_box_bind_model()
+ * are only created for the items that are visible.
+ *
+ * This allows binding models with a large number of items. Children
+ * are reused for other items when scrolling, so the create-widget
+ * function can be called again for the same item.
+ *
+ * If a model is already bound to @box, all children are recreated.
+ */
+void
+gtk_flow_box_set_virtualized (GtkFlowBox *box,
+                              gboolean    virtualized)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+
+  g_return_if_fail (GTK_IS_FLOW_BOX (box));
+
+  virtualized = virtualized != FALSE;
+  if (priv->virtualized == virtualized)
+    return;
+
+  priv->virtualized = virtualized;
+
+  if (priv->bound_model)
+    {
+      gtk_flow_box_unbind_model_children (box);
+      gtk_flow_box_check_model_compat (box);
+      gtk_flow_box_bind_model_children (box);
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (box), props[PROP_VIRTUALIZED]);
+}
+
+/**
+ * gtk_flow_box_get_virtualized:
+ * @box: a #GtkFlowBox
+ *
+ * Returns whether children are only created for visible items
+ * of a bound model.
+ *
+ * Returns: %TRUE if the flow box is virtualized
+ */
+gboolean
+gtk_flow_box_get_virtualized (GtkFlowBox *box)
+{
+  g_return_val_if_fail (GTK_IS_FLOW_BOX (box), FALSE);
+
+  return BOX_PRIV (box)->virtualized;
+}
+
 static void
 gtk_flow_box_set_accept_unpaired_release (GtkFlowBox *box,
                                           gboolean    accept)
@@ -4569,6 +5363,9 @@ gtk_flow_box_set_accept_unpaired_release (GtkFlowBox *box,
  *
  * Creates a list of all selected children.
  *
+ * If @box is virtualized, only the selected children that
+ * currently exist are returned.
+ *
  * Returns: (element-type GtkFlowBoxChild) (transfer container):
  *     A #GList containing the #GtkWidget for each selected child.
  *     Free with g_list_free() when done.
@@ -4695,6 +5492,9 @@ gtk_flow_box_unselect_all (GtkFlowBox *box)
  *
  * Note that the selection cannot be modified from within
  * this function.
+ *
+ * If @box is virtualized, only the selected children that
+ * currently exist are passed to @func.
  */
 void
 gtk_flow_box_selected_foreach (GtkFlowBox            *box,
@@ -4949,7 +5749,7 @@ gtk_flow_box_invalidate_sort (GtkFlowBox *box)
 
   priv = BOX_PRIV (box);
 
-  if (priv->sort_func != NULL)
+  if (priv->sort_func != NULL && priv->item_manager == NULL)
     {
       g_sequence_sort (priv->children, (GCompareDataFunc)gtk_flow_box_sort, box);
       g_sequence_foreach (priv->children, gtk_flow_box_reorder_foreach, &previous);
@@ -55,7 +55,6 @@
 #include "gtkroot.h"
 #include "gtkfilterlistmodel.h"
 #include "gtkflattenlistmodel.h"
-#include "gtkslicelistmodel.h"
 #include "gtkmaplistmodel.h"
 #include "gtklistitem.h"
 #include "gtksignallistitemfactory.h"
@@ -68,6 +67,9 @@
 #if defined(HAVE_PANGOFT) && defined(HAVE_HARFBUZZ)
 #include <pango/pangofc-font.h>
 #endif
+#ifdef HAVE_PANGOFT
+#include <pango/pangofc-fontmap.h>
+#endif
 
 #include "language-names.h"
 #include "script-names.h"
@@ -134,6 +136,8 @@ struct _GtkFontChooserWidget
   GtkWidget         *language_list;
   GtkStringList     *languages;
   GHashTable        *language_table;
+  GHashTable        *face_languages;    /* family and style -> PangoLanguage ** */
+  GCancellable      *scan_cancellable;
 
   PangoLanguage     *filter_language;
   gboolean           filter_by_language;
@@ -343,6 +347,11 @@ output_cb (GtkSpinButton *spin,
   return TRUE;
 }
 
+#ifdef HAVE_PANGOFT
+static PangoLanguage ** get_face_languages (GtkFontChooserWidget *self,
+                                            PangoFontFace        *face);
+#endif
+
 static gboolean
 user_filter_cb (gpointer item,
                 gpointer data)
@@ -370,41 +379,20 @@ user_filter_cb (gpointer item,
   if (self->filter_by_language &&
       self->filter_language)
     {
-      PangoFontDescription *desc;
-      PangoContext *context;
-      PangoFont *font;
-      gboolean ret;
-
-      desc = pango_font_face_describe (face);
-      pango_font_description_set_size (desc, 20);
-
-      context = gtk_widget_get_pango_context (GTK_WIDGET (self));
-      font = pango_context_load_font (context, desc);
+      PangoLanguage **langs;
+      int i;
 
-      ret = TRUE;
+      langs = get_face_languages (self, face);
+      if (langs == NULL)
+        return TRUE;
 
-      if (PANGO_IS_FC_FONT (font))
+      for (i = 0; langs[i]; i++)
         {
-          PangoLanguage **langs;
-          int i;
-
-          ret = FALSE;
-
-          langs = pango_fc_font_get_languages (PANGO_FC_FONT (font));
-          for (i = 0; langs[i]; i++)
-            {
-              if (langs[i] == self->filter_language)
-                {
-                  ret = TRUE;
-                  break;
-                }
-            }
+          if (langs[i] == self->filter_language)
+            return TRUE;
         }
 
-      g_object_unref (font);
-      pango_font_description_free (desc);
-
-      return ret;
+      return FALSE;
     }
 #endif
 
@@ -725,34 +713,48 @@ get_font_name (GObject  *ignore,
     }
 }
 
+/* Rows are bound over and over while scrolling, so the attributes
+ * for showing a face in itself are kept on the face, and shared by
+ * all rows and font choosers showing it.
+ */
 static PangoAttrList *
 get_font_attributes (GObject  *ignore,
                      gpointer  item)
 {
+  static GQuark attrs_quark;
   PangoAttribute *attribute;
   PangoAttrList *attrs;
+  PangoFontFace *face;
+  PangoFontDescription *font_desc;
 
-  attrs = pango_attr_list_new ();
+  if (item == NULL)
+    return pango_attr_list_new ();
 
-  if (item)
+  if (PANGO_IS_FONT_FAMILY (item))
+    face = pango_font_family_get_face (item, NULL);
+  else
+    face = item;
+
+  if (face == NULL)
+    return pango_attr_list_new ();
+
+  if (G_UNLIKELY (attrs_quark == 0))
+    attrs_quark = g_quark_from_static_string ("gtk-font-chooser-attributes");
+
+  attrs = g_object_get_qdata (G_OBJECT (face), attrs_quark);
+  if (attrs == NULL)
     {
-      PangoFontFace *face;
-      PangoFontDescription *font_desc;
+      attrs = pango_attr_list_new ();
+      font_desc = pango_font_face_describe (face);
+      attribute = pango_attr_font_desc_new (font_desc);
+      pango_attr_list_insert (attrs, attribute);
+      pango_font_description_free (font_desc);
 
-      if (PANGO_IS_FONT_FAMILY (item))
-        face = pango_font_family_get_face (item, NULL);
-      else
-        face = item;
-      if (face)
-        {
-          font_desc = pango_font_face_describe (face);
-          attribute = pango_attr_font_desc_new (font_desc);
-          pango_attr_list_insert (attrs, attribute);
-          pango_font_description_free (font_desc);
-        }
+      g_object_set_qdata_full (G_OBJECT (face), attrs_quark,
+                               attrs, (GDestroyNotify) pango_attr_list_unref);
     }
 
-  return attrs;
+  return pango_attr_list_ref (attrs);
 }
 
 static void
@@ -870,8 +872,15 @@ gtk_font_chooser_widget_dispose (GObject *object)
   self->filter_func = NULL;
   g_clear_pointer (&self->filter_data, self->filter_data_destroy);
 
+  if (self->scan_cancellable)
+    {
+      g_cancellable_cancel (self->scan_cancellable);
+      g_clear_object (&self->scan_cancellable);
+    }
+
   g_clear_pointer (&self->stack, gtk_widget_unparent);
   g_clear_pointer (&self->language_table, g_hash_table_unref);
+  g_clear_pointer (&self->face_languages, g_hash_table_unref);
 
   G_OBJECT_CLASS (gtk_font_chooser_widget_parent_class)->dispose (object);
 }
@@ -1041,109 +1050,226 @@ select_added (GListModel *model,
 }
 
 static void
-add_languages_from_font (GtkFontChooserWidget *self,
-                         gpointer              item)
+add_language (GtkFontChooserWidget *self,
+              PangoLanguage        *lang)
 {
-  PangoFontFace *face;
-  PangoFontDescription *desc;
-  PangoFont *font;
-  PangoContext *context;
+  GtkSelectionModel *model;
+  PangoLanguage *default_lang;
+  const char *l;
+  gulong id = 0;
 
-  if (PANGO_IS_FONT_FAMILY (item))
-    face = pango_font_family_get_face (PANGO_FONT_FAMILY (item), NULL);
-  else
-    face = PANGO_FONT_FACE (item);
+  if (g_hash_table_contains (self->language_table, lang))
+    return;
 
-  if (!face)
+  g_hash_table_add (self->language_table, lang);
+  if (!get_language_name (lang))
     return;
 
-  desc = pango_font_face_describe (face);
-  pango_font_description_set_size (desc, 20);
+  model = gtk_list_view_get_model (GTK_LIST_VIEW (self->language_list));
+  default_lang = pango_language_get_default ();
+  l = pango_language_to_string (lang);
 
-  context = gtk_widget_get_pango_context (GTK_WIDGET (self));
-  font = pango_context_load_font (context, desc);
+  /* Pre-select the default language */
+  if (pango_language_matches (default_lang, l))
+    id = g_signal_connect (model, "items-changed", G_CALLBACK (select_added), NULL);
 
-  if (PANGO_IS_FC_FONT (font))
+  gtk_string_list_append (self->languages, l);
+
+  if (id)
+    g_signal_handler_disconnect (model, id);
+}
+
+static char *
+face_languages_key (PangoFontFace *face)
+{
+  return g_strconcat (pango_font_family_get_name (pango_font_face_get_family (face)),
+                      "\n",
+                      pango_font_face_get_face_name (face),
+                      NULL);
+}
+
+/* Returns the languages covered by @face, or %NULL if they
+ * can't be determined. They are looked up in the table from
+ * scan_languages_thread(), and only if the face is not found
+ * there, by loading the font. Either way, the result is kept
+ * on the face.
+ */
+static PangoLanguage **
+get_face_languages (GtkFontChooserWidget *self,
+                    PangoFontFace        *face)
+{
+  static GQuark languages_quark;
+  PangoLanguage **langs;
+
+  if (G_UNLIKELY (languages_quark == 0))
+    languages_quark = g_quark_from_static_string ("gtk-font-chooser-languages");
+
+  langs = g_object_get_qdata (G_OBJECT (face), languages_quark);
+  if (langs)
+    return langs;
+
+  if (self->face_languages)
     {
-      GtkSelectionModel *model = gtk_list_view_get_model (GTK_LIST_VIEW (self->language_list));
-      PangoLanguage *default_lang = pango_language_get_default ();
-      PangoLanguage **langs;
-      int i;
+      char *key = face_languages_key (face);
 
-      langs = pango_fc_font_get_languages (PANGO_FC_FONT (font));
-      for (i = 0; langs[i]; i++)
-        {
-          if (!g_hash_table_contains (self->language_table, langs[i]))
-            {
-              g_hash_table_add (self->language_table, langs[i]);
-              if (get_language_name (langs[i]))
-                {
-                  const char *l = pango_language_to_string (langs[i]);
-                  gulong id = 0;
+      langs = g_hash_table_lookup (self->face_languages, key);
+      langs = g_memdup (langs, langs ? (g_strv_length ((char **) langs) + 1) * sizeof (PangoLanguage *) : 0);
+      g_free (key);
+    }
 
-                  /* Pre-select the default language */
-                  if (pango_language_matches (default_lang, l))
-                    id = g_signal_connect (model, "items-changed", G_CALLBACK (select_added), NULL);
+  if (langs == NULL)
+    {
+      PangoFontDescription *desc;
+      PangoContext *context;
+      PangoFont *font;
 
-                  gtk_string_list_append (self->languages, l);
+      desc = pango_font_face_describe (face);
+      pango_font_description_set_size (desc, 20);
 
-                  if (id)
-                    g_signal_handler_disconnect (model, id);
-                }
-            }
+      context = gtk_widget_get_pango_context (GTK_WIDGET (self));
+      font = pango_context_load_font (context, desc);
+
+      if (PANGO_IS_FC_FONT (font))
+        {
+          PangoLanguage **font_langs = pango_fc_font_get_languages (PANGO_FC_FONT (font));
+
+          langs = g_memdup (font_langs, (g_strv_length ((char **) font_langs) + 1) * sizeof (PangoLanguage *));
         }
+
+      g_object_unref (font);
+      pango_font_description_free (desc);
     }
 
-  g_object_unref (font);
-  pango_font_description_free (desc);
+  if (langs)
+    g_object_set_qdata_full (G_OBJECT (face), languages_quark, langs, g_free);
+
+  return langs;
 }
-#endif
 
-/* We incrementally populate our fontlist to prevent blocking
- * the font chooser for a long time with expensive FcFontSort
- * calls in pango for every row in the list).
+/* Finding the languages through pango means loading every font,
+ * which is too slow with many fonts installed. Fontconfig already
+ * knows them, so they are read from there in a thread, for all
+ * fonts at once.
  */
-static gboolean
-add_to_fontlist (GtkWidget     *widget,
-                 GdkFrameClock *clock,
-                 gpointer       user_data)
+static void
+scan_languages_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  FcConfig *config = task_data;
+  GHashTable *table;
+  FcPattern *pattern;
+  FcObjectSet *objects;
+  FcFontSet *fonts;
+  int i;
+
+  pattern = FcPatternCreate ();
+  objects = FcObjectSetBuild (FC_FAMILY, FC_STYLE, FC_LANG, NULL);
+  fonts = FcFontList (config, pattern, objects);
+  FcObjectSetDestroy (objects);
+  FcPatternDestroy (pattern);
+
+  table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  for (i = 0; fonts && i < fonts->nfont; i++)
+    {
+      FcChar8 *family, *style;
+      FcLangSet *langset;
+      FcStrSet *strs;
+      FcStrList *list;
+      FcChar8 *lang;
+      GPtrArray *langs;
+
+      if ((i & 255) == 0 && g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (FcPatternGetString (fonts->fonts[i], FC_FAMILY, 0, &family) != FcResultMatch ||
+          FcPatternGetString (fonts->fonts[i], FC_STYLE, 0, &style) != FcResultMatch ||
+          FcPatternGetLangSet (fonts->fonts[i], FC_LANG, 0, &langset) != FcResultMatch)
+        continue;
+
+      langs = g_ptr_array_new ();
+      strs = FcLangSetGetLangs (langset);
+      list = FcStrListCreate (strs);
+      while ((lang = FcStrListNext (list)))
+        g_ptr_array_add (langs, pango_language_from_string ((const char *) lang));
+      FcStrListDone (list);
+      FcStrSetDestroy (strs);
+      g_ptr_array_add (langs, NULL);
+
+      g_hash_table_insert (table,
+                           g_strconcat ((const char *) family, "\n", (const char *) style, NULL),
+                           g_ptr_array_free (langs, FALSE));
+    }
+
+  if (fonts)
+    FcFontSetDestroy (fonts);
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_hash_table_unref (table);
+      return;
+    }
+
+  g_task_return_pointer (task, table, (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+scan_languages_done (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      data)
 {
-  GtkFontChooserWidget *self = GTK_FONT_CHOOSER_WIDGET (widget);
-  GtkSliceListModel *model = user_data;
-  GListModel *child_model;
-  guint i G_GNUC_UNUSED;
-  guint n G_GNUC_UNUSED;
+  GtkFontChooserWidget *self = GTK_FONT_CHOOSER_WIDGET (source);
+  GHashTable *table;
+  GHashTableIter iter;
+  PangoLanguage **langs;
+  int i;
+
+  table = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (table == NULL)
+    return;
 
-  if (gtk_filter_list_model_get_model (self->filter_model) != G_LIST_MODEL (model))
-    return G_SOURCE_REMOVE;
+  g_clear_object (&self->scan_cancellable);
+  g_clear_pointer (&self->face_languages, g_hash_table_unref);
+  self->face_languages = table;
 
-  child_model = gtk_slice_list_model_get_model (model);
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &langs))
+    {
+      for (i = 0; langs[i]; i++)
+        add_language (self, langs[i]);
+    }
+}
 
-  n = gtk_slice_list_model_get_size (model);
+static void
+scan_languages (GtkFontChooserWidget *self,
+                PangoFontMap         *fontmap)
+{
+  GTask *task;
+  FcConfig *config;
 
-#ifdef HAVE_PANGOFT
-  for (i = n; i < n + 10; i++)
+  if (self->scan_cancellable)
     {
-      gpointer item = g_list_model_get_item (child_model, i);
-      if (!item)
-        break;
-      add_languages_from_font (self, item);
-      g_object_unref (item);
+      g_cancellable_cancel (self->scan_cancellable);
+      g_clear_object (&self->scan_cancellable);
     }
-#endif
 
-  n += 10;
+  if (!PANGO_IS_FC_FONT_MAP (fontmap))
+    return;
 
-  if (n >= g_list_model_get_n_items (child_model))
-    n = G_MAXUINT;
+  /* NULL means the current configuration, which is what pango uses then */
+  config = FcConfigReference (pango_fc_font_map_get_config (PANGO_FC_FONT_MAP (fontmap)));
 
-  gtk_slice_list_model_set_size (model, n);
+  self->scan_cancellable = g_cancellable_new ();
 
-  if (n == G_MAXUINT)
-    return G_SOURCE_REMOVE;
-  else
-    return G_SOURCE_CONTINUE;
+  task = g_task_new (self, self->scan_cancellable, scan_languages_done, NULL);
+  g_task_set_source_tag (task, scan_languages);
+  g_task_set_task_data (task, config, (GDestroyNotify) FcConfigDestroy);
+  g_task_run_in_thread (task, scan_languages_thread);
+  g_object_unref (task);
 }
+#endif
 
 static void
 update_fontlist (GtkFontChooserWidget *self)
@@ -1160,11 +1286,12 @@ update_fontlist (GtkFontChooserWidget *self)
   else
     model = G_LIST_MODEL (gtk_flatten_list_model_new (G_LIST_MODEL (g_object_ref (fontmap))));
 
-  model = G_LIST_MODEL (gtk_slice_list_model_new (model, 0, 20));
-  gtk_widget_add_tick_callback (GTK_WIDGET (self), add_to_fontlist, g_object_ref (model), g_object_unref);
-
   gtk_filter_list_model_set_model (self->filter_model, model);
   g_object_unref (model);
+
+#ifdef HAVE_PANGOFT
+  scan_languages (self, fontmap);
+#endif
 }
 
 #ifdef HAVE_PANGOFT
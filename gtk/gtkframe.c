@@ -195,6 +195,7 @@ gtk_frame_class_init (GtkFrameClass *class)
   g_object_class_install_properties (gobject_class, LAST_PROP, frame_props);
 
   gtk_widget_class_set_css_name (widget_class, I_("frame"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
 }
 
 static GtkBuildableIface *parent_buildable_iface;
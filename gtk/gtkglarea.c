@@ -30,6 +30,7 @@
 #include "gtksnapshot.h"
 #include "gtknative.h"
 #include "gtkwidgetprivate.h"
+#include "gdk/gdkgltextureprivate.h"
 
 #include <epoxy/gl.h>
 
@@ -149,8 +150,16 @@ typedef struct {
   int width;
   int height;
   GdkTexture *holder;
+  GLsync sync;
 } Texture;
 
+/* Textures are recycled once the renderer is done with them. One is
+ * rendered to while the renderer may still be using the previous one
+ * or two, so there is no need to wait for it. Spare textures beyond
+ * that are deleted.
+ */
+#define MAX_SPARE_TEXTURES 2
+
 typedef struct {
   GdkGLContext *context;
   GError *error;
@@ -171,6 +180,7 @@ typedef struct {
   gboolean needs_render;
   gboolean auto_render;
   gboolean use_es;
+  gboolean has_sync;
 } GtkGLAreaPrivate;
 
 enum {
@@ -287,6 +297,19 @@ gtk_gl_area_realize (GtkWidget *widget)
                          GDK_GL_ERROR_NOT_AVAILABLE,
                          _("OpenGL context creation failed"));
 
+  /* Fences need GL 3.2 or GLES 3 */
+  priv->has_sync = FALSE;
+  if (priv->context != NULL)
+    {
+      int major, minor;
+
+      gdk_gl_context_get_version (priv->context, &major, &minor);
+      if (gdk_gl_context_get_use_es (priv->context))
+        priv->has_sync = major >= 3;
+      else
+        priv->has_sync = major > 3 || (major == 3 && minor >= 2);
+    }
+
   priv->needs_resize = TRUE;
 }
 
@@ -390,6 +413,12 @@ delete_one_texture (gpointer data)
   if (texture->holder)
     gdk_gl_texture_release (GDK_GL_TEXTURE (texture->holder));
 
+  if (texture->sync)
+    {
+      glDeleteSync (texture->sync);
+      texture->sync = NULL;
+    }
+
   if (texture->id != 0)
     {
       glDeleteTextures (1, &texture->id);
@@ -413,6 +442,7 @@ gtk_gl_area_ensure_texture (GtkGLArea *area)
   if (priv->texture == NULL)
     {
       GList *l, *link;
+      guint n_spare = 0;
 
       l = priv->textures;
       while (l)
@@ -424,12 +454,18 @@ gtk_gl_area_ensure_texture (GtkGLArea *area)
           if (texture->holder)
             continue;
 
-          priv->textures = g_list_delete_link (priv->textures, link);
-
           if (priv->texture == NULL)
-            priv->texture = texture;
+            {
+              priv->textures = g_list_delete_link (priv->textures, link);
+              priv->texture = texture;
+            }
+          else if (n_spare < MAX_SPARE_TEXTURES)
+            n_spare++;
           else
-            delete_one_texture (texture);
+            {
+              priv->textures = g_list_delete_link (priv->textures, link);
+              delete_one_texture (texture);
+            }
         }
     }
 
@@ -440,6 +476,7 @@ gtk_gl_area_ensure_texture (GtkGLArea *area)
       priv->texture->width = 0;
       priv->texture->height = 0;
       priv->texture->holder = NULL;
+      priv->texture->sync = NULL;
 
       glGenTextures (1, &priv->texture->id);
     }
@@ -729,6 +766,16 @@ gtk_gl_area_snapshot (GtkWidget   *widget,
             }
 
           g_signal_emit (area, area_signals[RENDER], 0, priv->context, &unused);
+
+          /* Let the renderer wait for the rendering on the GPU. The
+           * flush makes the commands visible to other contexts.
+           */
+          if (priv->texture->sync)
+            glDeleteSync (priv->texture->sync);
+          priv->texture->sync = NULL;
+          if (priv->has_sync)
+            priv->texture->sync = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+          glFlush ();
         }
 
       priv->needs_render = FALSE;
@@ -742,6 +789,7 @@ gtk_gl_area_snapshot (GtkWidget   *widget,
                                             texture->width,
                                             texture->height,
                                             release_texture, texture);
+      gdk_gl_texture_set_sync (GDK_GL_TEXTURE (texture->holder), texture->sync);
 
       /* Our texture is rendered by OpenGL, so it is upside down,
        * compared to what GSK expects, so flip it back.
@@ -426,6 +426,9 @@ typedef struct {
   GtkWidget *widget;
 
   GridLines lines[2];
+
+  /* Last child measurement, reused for identical siblings */
+  GtkMeasureShare share;
 } GridRequest;
 
 struct _GtkGridLayout
@@ -601,19 +604,19 @@ compute_request_for_child (GridRequest        *request,
 
       size = compute_allocation_for_child (request, grid_child, 1 - orientation);
 
-      gtk_widget_measure (child,
-                          orientation,
-                          size,
-                          minimum, natural,
-                          minimum_baseline, natural_baseline);
+      gtk_widget_measure_shared (child,
+                                 orientation,
+                                 size, &request->share,
+                                 minimum, natural,
+                                 minimum_baseline, natural_baseline);
     }
   else
     {
-      gtk_widget_measure (child,
-                          orientation,
-                          -1,
-                          minimum, natural,
-                          minimum_baseline, natural_baseline);
+      gtk_widget_measure_shared (child,
+                                 orientation,
+                                 -1, &request->share,
+                                 minimum, natural,
+                                 minimum_baseline, natural_baseline);
     }
 }
 
@@ -635,6 +638,7 @@ grid_request_non_spanning (GridRequest    *request,
   int natural, natural_baseline;
 
   lines = &request->lines[orientation];
+  request->share = (GtkMeasureShare) { NULL, };
 
   for (child = gtk_widget_get_first_child (request->widget);
        child != NULL;
@@ -774,6 +778,7 @@ grid_request_spanning (GridRequest    *request,
   linedata = &self->linedata[orientation];
   lines = &request->lines[orientation];
   spacing = get_spacing (request->layout, request->widget, orientation);
+  request->share = (GtkMeasureShare) { NULL, };
 
   for (child = gtk_widget_get_first_child (request->widget);
        child != NULL;
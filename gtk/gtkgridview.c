@@ -98,6 +98,8 @@ struct _GtkGridView
   guint n_columns;
   int unknown_row_height;
   double column_width;
+  /* all rows are unknown_row_height high */
+  gboolean uniform_rows;
 };
 
 struct _GtkGridViewClass
@@ -126,6 +128,7 @@ enum
   PROP_MODEL,
   PROP_SINGLE_CLICK_ACTIVATE,
   PROP_ENABLE_RUBBERBAND,
+  PROP_PREFETCH,
 
   N_PROPS
 };
@@ -165,7 +168,8 @@ dump (GtkGridView *self)
                cell->parent.widget ? " (widget)" : "", cell->size);
     }
 
-  g_print ("  => %u widgets in %u list rows\n", n_widgets, n_list_rows);
+  g_print ("  => %u widgets (%u prefetched) in %u list rows\n",
+           n_widgets, gtk_list_base_get_n_prefetched (GTK_LIST_BASE (self)), n_list_rows);
 }
 
 static void
@@ -313,6 +317,58 @@ gtk_grid_view_get_cell_at_y (GtkGridView *self,
   return cell;
 }
 
+/*<private>
+ * gtk_grid_view_get_position_at_y:
+ * @self: a #GtkGridView
+ * @y: an offset in direction of @self's orientation
+ * @position: (out caller-allocates) (optional): stores the position
+ *     index of the first item in the row
+ * @offset: (out caller-allocates) (optional): stores the offset
+ *     in pixels between y and top of the row
+ * @size: (out caller-allocates) (optional): stores the height
+ *     of the row
+ *
+ * Like gtk_grid_view_get_cell_at_y(), but when all rows have the same
+ * height, the row is found arithmetically without looking at the cells.
+ *
+ * Returns: %TRUE if there is a row at offset @y
+ **/
+static gboolean
+gtk_grid_view_get_position_at_y (GtkGridView *self,
+                                 int          y,
+                                 guint       *position,
+                                 int         *offset,
+                                 int         *size)
+{
+  guint row, n_rows;
+
+  if (!self->uniform_rows)
+    return gtk_grid_view_get_cell_at_y (self, y, position, offset, size) != NULL;
+
+  n_rows = (gtk_list_base_get_n_items (GTK_LIST_BASE (self)) + self->n_columns - 1) / self->n_columns;
+  if (y < 0 || y / self->unknown_row_height >= n_rows)
+    {
+      if (position)
+        *position = 0;
+      if (offset)
+        *offset = 0;
+      if (size)
+        *size = 0;
+      return FALSE;
+    }
+
+  row = y / self->unknown_row_height;
+
+  if (position)
+    *position = row * self->n_columns;
+  if (offset)
+    *offset = y - row * self->unknown_row_height;
+  if (size)
+    *size = self->unknown_row_height;
+
+  return TRUE;
+}
+
 static gboolean
 gtk_grid_view_get_allocation_along (GtkListBase *base,
                                     guint        pos,
@@ -323,6 +379,24 @@ gtk_grid_view_get_allocation_along (GtkListBase *base,
   Cell *cell, *tmp;
   int y;
 
+  if (self->uniform_rows)
+    {
+      if (pos >= gtk_list_base_get_n_items (base))
+        {
+          if (offset)
+            *offset = 0;
+          if (size)
+            *size = 0;
+          return FALSE;
+        }
+
+      if (offset)
+        *offset = pos / self->n_columns * self->unknown_row_height;
+      if (size)
+        *size = self->unknown_row_height;
+      return TRUE;
+    }
+
   cell = gtk_list_item_manager_get_root (self->item_manager);
   y = 0;
   pos -= pos % self->n_columns;
@@ -429,11 +503,11 @@ gtk_grid_view_get_position_from_allocation (GtkListBase           *base,
     return FALSE;
 
   n_items = gtk_list_base_get_n_items (base);
-  if (!gtk_grid_view_get_cell_at_y (self,
-                                    along,
-                                    &pos,
-                                    &offset,
-                                    &size))
+  if (!gtk_grid_view_get_position_at_y (self,
+                                        along,
+                                        &pos,
+                                        &offset,
+                                        &size))
     return FALSE;
 
   pos += floor (across / self->column_width);
@@ -474,9 +548,9 @@ gtk_grid_view_get_items_in_rect (GtkListBase        *base,
 
   first_column = floor (rect->x / self->column_width);
   last_column = floor ((rect->x + rect->width) / self->column_width);
-  if (!gtk_grid_view_get_cell_at_y (self, rect->y, &first_row, NULL, NULL))
+  if (!gtk_grid_view_get_position_at_y (self, rect->y, &first_row, NULL, NULL))
     first_row = rect->y < 0 ? 0 : n_items - 1;
-  if (!gtk_grid_view_get_cell_at_y (self, rect->y + rect->height, &last_row, NULL, NULL))
+  if (!gtk_grid_view_get_position_at_y (self, rect->y + rect->height, &last_row, NULL, NULL))
     last_row = rect->y < 0 ? 0 : n_items - 1;
 
   gtk_bitset_add_rectangle (result,
@@ -814,6 +888,9 @@ gtk_grid_view_size_allocate (GtkWidget *widget,
 
   /* step 3: determine height of rows with only unknown items */
   self->unknown_row_height = gtk_grid_view_get_unknown_row_size (self, heights);
+  /* get_unknown_row_size() sorted the heights, so this checks they're all the same */
+  self->uniform_rows = self->unknown_row_height > 0 &&
+                       g_array_index (heights, int, 0) == g_array_index (heights, int, heights->len - 1);
   g_array_free (heights, TRUE);
 
   i = 0;
@@ -959,6 +1036,10 @@ gtk_grid_view_get_property (GObject    *object,
       g_value_set_boolean (value, gtk_list_base_get_enable_rubberband (GTK_LIST_BASE (self)));
       break;
 
+    case PROP_PREFETCH:
+      g_value_set_uint (value, gtk_list_base_get_prefetch (GTK_LIST_BASE (self)));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -999,6 +1080,10 @@ gtk_grid_view_set_property (GObject      *object,
       gtk_grid_view_set_enable_rubberband (self, g_value_get_boolean (value));
       break;
 
+    case PROP_PREFETCH:
+      gtk_grid_view_set_prefetch (self, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -1125,6 +1210,18 @@ gtk_grid_view_class_init (GtkGridViewClass *klass)
                           FALSE,
                           G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkGridView:prefetch:
+   *
+   * Number of items ahead of the visible ones to create widgets for
+   */
+  properties[PROP_PREFETCH] =
+    g_param_spec_uint ("prefetch",
+                       P_("Prefetch"),
+                       P_("Number of items ahead of the visible ones to create widgets for"),
+                       0, G_MAXUINT, 0,
+                       G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, N_PROPS, properties);
 
   /**
@@ -1464,3 +1561,45 @@ gtk_grid_view_get_enable_rubberband (GtkGridView *self)
 
   return gtk_list_base_get_enable_rubberband (GTK_LIST_BASE (self));
 }
+
+/**
+ * gtk_grid_view_set_prefetch:
+ * @self: a #GtkGridView
+ * @n_items: the number of items to prefetch
+ *
+ * Sets how many items beyond the visible ones should get widgets,
+ * in the direction @self is being scrolled.
+ *
+ * Those items are bound before they become visible, so widgets that
+ * load their contents asynchronously, like thumbnails, can start
+ * doing so early.
+ */
+void
+gtk_grid_view_set_prefetch (GtkGridView *self,
+                            guint        n_items)
+{
+  g_return_if_fail (GTK_IS_GRID_VIEW (self));
+
+  if (n_items == gtk_list_base_get_prefetch (GTK_LIST_BASE (self)))
+    return;
+
+  gtk_list_base_set_prefetch (GTK_LIST_BASE (self), n_items);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PREFETCH]);
+}
+
+/**
+ * gtk_grid_view_get_prefetch:
+ * @self: a #GtkGridView
+ *
+ * Returns how many items beyond the visible ones get widgets.
+ *
+ * Returns: the number of prefetched items
+ */
+guint
+gtk_grid_view_get_prefetch (GtkGridView *self)
+{
+  g_return_val_if_fail (GTK_IS_GRID_VIEW (self), 0);
+
+  return gtk_list_base_get_prefetch (GTK_LIST_BASE (self));
+}
@@ -79,6 +79,12 @@ void            gtk_grid_view_set_enable_rubberband             (GtkGridView
 GDK_AVAILABLE_IN_ALL
 gboolean        gtk_grid_view_get_enable_rubberband             (GtkGridView            *self);
 
+GDK_AVAILABLE_IN_ALL
+void            gtk_grid_view_set_prefetch                      (GtkGridView            *self,
+                                                                 guint                   n_items);
+GDK_AVAILABLE_IN_ALL
+guint           gtk_grid_view_get_prefetch                      (GtkGridView            *self);
+
 GDK_AVAILABLE_IN_ALL
 void            gtk_grid_view_set_single_click_activate         (GtkGridView            *self,
                                                                  gboolean                single_click_activate);
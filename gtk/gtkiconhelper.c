@@ -49,6 +49,13 @@ struct _GtkIconHelper
   GtkWidget *owner;
   GtkCssNode *node;
   GdkPaintable *paintable;
+  int paintable_scale;
+
+  /* Kept around when the scale factor changes, so that moving a window
+   * back to the monitor it came from doesn't reload its icons */
+  GdkPaintable *previous_paintable;
+  int previous_scale;
+  guint previous_is_symbolic : 1;
 };
 
 static GtkIconLookupFlags
@@ -134,8 +141,8 @@ gtk_icon_helper_load_paintable (GtkIconHelper   *self,
         gicon = g_themed_icon_new (gtk_image_definition_get_icon_name (self->def));
       paintable = ensure_paintable_for_gicon (self,
                                               gtk_css_node_get_style (self->node),
-                                              gtk_widget_get_scale_factor (self->owner),
                                               gtk_widget_get_direction (self->owner),
+                                              gtk_widget_get_scale_factor (self->owner),
                                               preload,
                                               gicon,
                                               &symbolic);
@@ -145,8 +152,8 @@ gtk_icon_helper_load_paintable (GtkIconHelper   *self,
     case GTK_IMAGE_GICON:
       paintable = ensure_paintable_for_gicon (self,
                                               gtk_css_node_get_style (self->node),
-                                              gtk_widget_get_scale_factor (self->owner),
                                               gtk_widget_get_direction (self->owner),
+                                              gtk_widget_get_scale_factor (self->owner),
                                               preload,
                                               gtk_image_definition_get_gicon (self->def),
                                               &symbolic);
@@ -173,6 +180,7 @@ gtk_icon_helper_ensure_paintable (GtkIconHelper *self, gboolean preload)
     return;
 
   self->paintable = gtk_icon_helper_load_paintable (self, preload, &symbolic);
+  self->paintable_scale = gtk_widget_get_scale_factor (self->owner);
   self->texture_is_symbolic = symbolic;
 }
 
@@ -337,6 +345,7 @@ void
 gtk_icon_helper_invalidate (GtkIconHelper *self)
 {
   g_clear_object (&self->paintable);
+  g_clear_object (&self->previous_paintable);
   self->texture_is_symbolic = FALSE;
 
   if (!GTK_IS_CSS_TRANSIENT_NODE (self->node))
@@ -352,6 +361,7 @@ gtk_icon_helper_invalidate_for_change (GtkIconHelper     *self,
     {
       /* Avoid the queue_resize in gtk_icon_helper_invalidate */
       g_clear_object (&self->paintable);
+      g_clear_object (&self->previous_paintable);
       self->texture_is_symbolic = FALSE;
       gtk_widget_queue_draw (self->owner);
     }
@@ -372,6 +382,35 @@ gtk_icon_helper_invalidate_for_change (GtkIconHelper     *self,
   gtk_icon_helper_ensure_paintable (self, TRUE);
 }
 
+static void
+gtk_icon_helper_scale_changed (GtkIconHelper *self)
+{
+  int scale = gtk_widget_get_scale_factor (self->owner);
+  GdkPaintable *paintable = self->paintable;
+  gboolean symbolic = self->texture_is_symbolic;
+  int paintable_scale = self->paintable_scale;
+
+  if (self->previous_paintable && self->previous_scale == scale)
+    {
+      self->paintable = self->previous_paintable;
+      self->paintable_scale = scale;
+      self->texture_is_symbolic = self->previous_is_symbolic;
+    }
+  else
+    {
+      self->paintable = NULL;
+      self->texture_is_symbolic = FALSE;
+      g_clear_object (&self->previous_paintable);
+    }
+
+  self->previous_paintable = paintable;
+  self->previous_scale = paintable_scale;
+  self->previous_is_symbolic = symbolic;
+
+  if (!GTK_IS_CSS_TRANSIENT_NODE (self->node))
+    gtk_widget_queue_resize (self->owner);
+}
+
 static void
 gtk_icon_helper_take_definition (GtkIconHelper      *self,
                                  GtkImageDefinition *def)
@@ -391,6 +430,7 @@ void
 _gtk_icon_helper_clear (GtkIconHelper *self)
 {
   g_clear_object (&self->paintable);
+  g_clear_object (&self->previous_paintable);
   self->texture_is_symbolic = FALSE;
 
   if (gtk_image_definition_get_storage_type (self->def) != GTK_IMAGE_EMPTY)
@@ -408,6 +448,7 @@ gtk_icon_helper_finalize (GObject *object)
 
   _gtk_icon_helper_clear (self);
   g_signal_handlers_disconnect_by_func (self->owner, G_CALLBACK (gtk_icon_helper_invalidate), self);
+  g_signal_handlers_disconnect_by_func (self->owner, G_CALLBACK (gtk_icon_helper_scale_changed), self);
   gtk_image_definition_unref (self->def);
 
   G_OBJECT_CLASS (gtk_icon_helper_parent_class)->finalize (object);
@@ -441,7 +482,7 @@ gtk_icon_helper_new (GtkCssNode *css_node,
   self->node = css_node;
   self->owner = owner;
   g_signal_connect_swapped (owner, "direction-changed", G_CALLBACK (gtk_icon_helper_invalidate), self);
-  g_signal_connect_swapped (owner, "notify::scale-factor", G_CALLBACK (gtk_icon_helper_invalidate), self);
+  g_signal_connect_swapped (owner, "notify::scale-factor", G_CALLBACK (gtk_icon_helper_scale_changed), self);
 
   return self;
 }
@@ -0,0 +1,174 @@
+/* GTK - The GIMP Toolkit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkiconrastercacheprivate.h"
+
+#include <glib/gstdio.h>
+#include <string.h>
+
+/* Rasterizing SVG icons is by far the most expensive part of loading
+ * them, and the result only depends on the file and the size we ask
+ * for. So we keep the rendered pixels in the user's cache directory,
+ * in the layout that GdkMemoryTexture wants, and map them straight
+ * into a texture on the next run.
+ *
+ * Files are named after a checksum of the source path, its mtime,
+ * the size, scale and whether the icon is symbolic, so changed icons
+ * simply miss. Files are written atomically, which makes it safe to
+ * keep them mapped while another process replaces them.
+ */
+
+#define RASTER_CACHE_MAGIC   0x52435447 /* "GTCR" */
+#define RASTER_CACHE_VERSION 1
+
+typedef struct {
+  guint32 magic;
+  guint32 version;
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 format;
+} RasterCacheHeader;
+
+static char *
+get_cache_path (const char *filename,
+                int         pixel_size,
+                int         scale,
+                gboolean    symbolic,
+                gboolean    create_dir)
+{
+  GStatBuf stat_buf;
+  char *key, *basename, *dir, *path;
+
+  if (g_stat (filename, &stat_buf) != 0)
+    return NULL;
+
+  key = g_strdup_printf ("%s\n%" G_GINT64_FORMAT "\n%d@%d%s",
+                         filename, (gint64) stat_buf.st_mtime,
+                         pixel_size, scale,
+                         symbolic ? "\nsymbolic" : "");
+  basename = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  g_free (key);
+
+  dir = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "icons", NULL);
+  if (create_dir && g_mkdir_with_parents (dir, 0755) != 0)
+    path = NULL;
+  else
+    path = g_build_filename (dir, basename, NULL);
+
+  g_free (dir);
+  g_free (basename);
+
+  return path;
+}
+
+GdkTexture *
+gtk_icon_raster_cache_lookup (const char *filename,
+                              int         pixel_size,
+                              int         scale,
+                              gboolean    symbolic)
+{
+  RasterCacheHeader header;
+  GMappedFile *mapped;
+  GBytes *bytes, *pixels;
+  GdkTexture *texture;
+  const char *data;
+  gsize length;
+  char *path;
+
+  path = get_cache_path (filename, pixel_size, scale, symbolic, FALSE);
+  if (path == NULL)
+    return NULL;
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  g_free (path);
+  if (mapped == NULL)
+    return NULL;
+
+  bytes = g_mapped_file_get_bytes (mapped);
+  g_mapped_file_unref (mapped);
+
+  data = g_bytes_get_data (bytes, &length);
+  if (length < sizeof (RasterCacheHeader))
+    {
+      g_bytes_unref (bytes);
+      return NULL;
+    }
+
+  memcpy (&header, data, sizeof (RasterCacheHeader));
+
+  if (header.magic != RASTER_CACHE_MAGIC ||
+      header.version != RASTER_CACHE_VERSION ||
+      header.format != GDK_MEMORY_DEFAULT ||
+      header.width == 0 || header.height == 0 ||
+      header.width > G_MAXINT / 4 ||
+      header.stride < header.width * 4 ||
+      (length - sizeof (RasterCacheHeader)) / header.stride < header.height)
+    {
+      g_bytes_unref (bytes);
+      return NULL;
+    }
+
+  pixels = g_bytes_new_from_bytes (bytes,
+                                   sizeof (RasterCacheHeader),
+                                   (gsize) header.stride * header.height);
+  g_bytes_unref (bytes);
+
+  texture = gdk_memory_texture_new (header.width, header.height,
+                                    GDK_MEMORY_DEFAULT,
+                                    pixels,
+                                    header.stride);
+  g_bytes_unref (pixels);
+
+  return texture;
+}
+
+void
+gtk_icon_raster_cache_store (const char *filename,
+                             int         pixel_size,
+                             int         scale,
+                             gboolean    symbolic,
+                             GdkTexture *texture)
+{
+  RasterCacheHeader header;
+  guchar *data;
+  gsize length;
+  char *path;
+
+  path = get_cache_path (filename, pixel_size, scale, symbolic, TRUE);
+  if (path == NULL)
+    return;
+
+  header.magic = RASTER_CACHE_MAGIC;
+  header.version = RASTER_CACHE_VERSION;
+  header.width = gdk_texture_get_width (texture);
+  header.height = gdk_texture_get_height (texture);
+  header.stride = header.width * 4;
+  header.format = GDK_MEMORY_DEFAULT;
+
+  length = sizeof (RasterCacheHeader) + (gsize) header.stride * header.height;
+  data = g_malloc (length);
+  memcpy (data, &header, sizeof (RasterCacheHeader));
+  gdk_texture_download (texture, data + sizeof (RasterCacheHeader), header.stride);
+
+  /* A failure here just means we render the icon again next time */
+  g_file_set_contents (path, (const char *) data, length, NULL);
+
+  g_free (data);
+  g_free (path);
+}
@@ -43,6 +43,7 @@
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkdebug.h"
 #include "gtkiconcacheprivate.h"
+#include "gtkiconrastercacheprivate.h"
 #include "gtkintl.h"
 #include "gtkmain.h"
 #include "gtksettingsprivate.h"
@@ -326,6 +327,7 @@ struct _GtkIconTheme
    */
   GList *themes;
   GHashTable *unthemed_icons;
+  GHashTable *theme_lookups;   /* IconLookup, valid as long as themes */
 
   /* GdkDisplay for the icon theme (may be NULL) */
   GdkDisplay *display;
@@ -450,6 +452,27 @@ typedef struct
   gboolean is_resource;
 } UnthemedIcon;
 
+typedef struct
+{
+  char *icon_name;
+  int size;
+  int scale;
+} IconLookupKey;
+
+/* The result of looking up one icon name in the whole list of
+ * themes, so that inherited themes only have to be walked once
+ * for each name, size and scale.
+ */
+typedef struct
+{
+  IconLookupKey key;
+  int theme_index;      /* in themes, or -1 if no theme has the icon */
+  char *filename;
+  guint is_svg      : 1;
+  guint is_resource : 1;
+  guint is_symbolic : 1;
+} IconLookup;
+
 typedef struct
 {
   char *dir;
@@ -465,11 +488,12 @@ static IconTheme *       theme_new                        (const char       *the
 static void              theme_dir_size_destroy           (IconThemeDirSize *dir_size);
 static void              theme_dir_destroy                (IconThemeDir     *dir);
 static void              theme_destroy                    (IconTheme        *theme);
-static GtkIconPaintable *theme_lookup_icon                (IconTheme        *theme,
+static gboolean          theme_lookup_icon                (IconTheme        *theme,
                                                            const char       *icon_name,
                                                            int               size,
                                                            int               scale,
-                                                           gboolean          allow_svg);
+                                                           gboolean          allow_svg,
+                                                           IconLookup       *lookup);
 static gboolean          theme_has_icon                   (IconTheme        *theme,
                                                            const char       *icon_name);
 static void              theme_subdir_load                (GtkIconTheme     *self,
@@ -1293,6 +1317,7 @@ gtk_icon_theme_init (GtkIconTheme *self)
   self->themes_valid = FALSE;
   self->themes = NULL;
   self->unthemed_icons = NULL;
+  self->theme_lookups = NULL;
 
   self->pixbuf_supports_svg = pixbuf_supports_svg ();
 }
@@ -1371,9 +1396,11 @@ blow_themes (GtkIconTheme *self)
       g_list_free_full (self->themes, (GDestroyNotify) theme_destroy);
       g_array_set_size (self->dir_mtimes, 0);
       g_hash_table_destroy (self->unthemed_icons);
+      g_hash_table_destroy (self->theme_lookups);
     }
   self->themes = NULL;
   self->unthemed_icons = NULL;
+  self->theme_lookups = NULL;
   self->themes_valid = FALSE;
   self->serial++;
 }
@@ -1962,6 +1989,34 @@ add_unthemed_icon (GtkIconTheme *self,
     }
 }
 
+static guint
+icon_lookup_hash (gconstpointer data)
+{
+  const IconLookupKey *key = data;
+
+  return g_str_hash (key->icon_name) ^ (key->size << 8) ^ key->scale;
+}
+
+static gboolean
+icon_lookup_equal (gconstpointer a,
+                   gconstpointer b)
+{
+  const IconLookupKey *key_a = a;
+  const IconLookupKey *key_b = b;
+
+  return key_a->size == key_b->size &&
+         key_a->scale == key_b->scale &&
+         strcmp (key_a->icon_name, key_b->icon_name) == 0;
+}
+
+static void
+free_icon_lookup (IconLookup *lookup)
+{
+  g_free (lookup->key.icon_name);
+  g_free (lookup->filename);
+  g_slice_free (IconLookup, lookup);
+}
+
 static void
 load_themes (GtkIconTheme *self)
 {
@@ -1980,6 +2035,8 @@ load_themes (GtkIconTheme *self)
 
   self->unthemed_icons = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                 g_free, (GDestroyNotify)free_unthemed_icon);
+  self->theme_lookups = g_hash_table_new_full (icon_lookup_hash, icon_lookup_equal,
+                                               (GDestroyNotify)free_icon_lookup, NULL);
 
   for (base = 0; self->search_path[base]; base++)
     {
@@ -2139,6 +2196,45 @@ icon_uri_is_symbolic (const char *icon_name,
   return FALSE;
 }
 
+static const IconLookup *
+lookup_icon_in_themes (GtkIconTheme *self,
+                       const char   *icon_name,
+                       int           size,
+                       int           scale)
+{
+  IconLookupKey key;
+  IconLookup *lookup;
+  GList *l;
+  int i;
+
+  key.icon_name = (char *) icon_name;
+  key.size = size;
+  key.scale = scale;
+
+  lookup = g_hash_table_lookup (self->theme_lookups, &key);
+  if (lookup)
+    return lookup;
+
+  lookup = g_slice_new0 (IconLookup);
+  lookup->key.icon_name = g_strdup (icon_name);
+  lookup->key.size = size;
+  lookup->key.scale = scale;
+  lookup->theme_index = -1;
+
+  for (l = self->themes, i = 0; l; l = l->next, i++)
+    {
+      if (theme_lookup_icon (l->data, icon_name, size, scale, self->pixbuf_supports_svg, lookup))
+        {
+          lookup->theme_index = i;
+          break;
+        }
+    }
+
+  g_hash_table_add (self->theme_lookups, lookup);
+
+  return lookup;
+}
+
 static GtkIconPaintable *
 real_choose_icon (GtkIconTheme      *self,
                   const char        *icon_names[],
@@ -2147,11 +2243,9 @@ real_choose_icon (GtkIconTheme      *self,
                   GtkIconLookupFlags flags,
                   gboolean           non_blocking)
 {
-  GList *l;
   GtkIconPaintable *icon = NULL;
   UnthemedIcon *unthemed_icon = NULL;
-  const char *icon_name = NULL;
-  IconTheme *theme = NULL;
+  const IconLookup *lookup, *best = NULL;
   int i;
   IconKey key;
 
@@ -2179,33 +2273,37 @@ real_choose_icon (GtkIconTheme      *self,
    *
    * In other words: We prefer symbolic icons in inherited themes over
    * generic icons in the theme.
+   *
+   * Either way, the earliest theme wins, and then the earliest name.
    */
-  for (l = self->themes; l; l = l->next)
+  for (i = 0; icon_names[i] && icon_name_is_symbolic (icon_names[i], -1); i++)
     {
-      theme = l->data;
-      for (i = 0; icon_names[i] && icon_name_is_symbolic (icon_names[i], -1); i++)
-        {
-          icon_name = icon_names[i];
-          icon = theme_lookup_icon (theme, icon_name, size, scale, self->pixbuf_supports_svg);
-          if (icon)
-            goto out;
-        }
+      lookup = lookup_icon_in_themes (self, icon_names[i], size, scale);
+      if (lookup->theme_index >= 0 &&
+          (best == NULL || lookup->theme_index < best->theme_index))
+        best = lookup;
     }
 
-  for (l = self->themes; l; l = l->next)
+  if (best == NULL)
     {
-      theme = l->data;
-
       for (i = 0; icon_names[i]; i++)
         {
-          icon_name = icon_names[i];
-          icon = theme_lookup_icon (theme, icon_name, size, scale, self->pixbuf_supports_svg);
-          if (icon)
-            goto out;
+          lookup = lookup_icon_in_themes (self, icon_names[i], size, scale);
+          if (lookup->theme_index >= 0 &&
+              (best == NULL || lookup->theme_index < best->theme_index))
+            best = lookup;
         }
     }
 
-  theme = NULL;
+  if (best)
+    {
+      icon = icon_paintable_new (best->key.icon_name, size, scale);
+      icon->filename = g_strdup (best->filename);
+      icon->is_svg = best->is_svg;
+      icon->is_resource = best->is_resource;
+      icon->is_symbolic = best->is_symbolic;
+      goto out;
+    }
 
   for (i = 0; icon_names[i]; i++)
     {
@@ -2475,6 +2573,8 @@ gtk_icon_theme_lookup_icon (GtkIconTheme       *self,
 
   gtk_icon_theme_lock (self);
 
+  /* Preloading doesn't change which icon is chosen, so don't let
+   * it split the cache */
   if (fallbacks)
     {
       gsize n_fallbacks = g_strv_length ((char **) fallbacks);
@@ -2484,7 +2584,7 @@ gtk_icon_theme_lookup_icon (GtkIconTheme       *self,
       memcpy (&names[1], fallbacks, sizeof (char *) * n_fallbacks);
       names[n_fallbacks + 1] = NULL;
 
-      icon = choose_icon (self, names, size, scale, direction, flags, FALSE);
+      icon = choose_icon (self, names, size, scale, direction, flags & ~GTK_ICON_LOOKUP_PRELOAD, FALSE);
 
       g_free (names);
     }
@@ -2495,7 +2595,7 @@ gtk_icon_theme_lookup_icon (GtkIconTheme       *self,
       names[0] = icon_name;
       names[1] = NULL;
 
-      icon = choose_icon (self, names, size, scale, direction, flags, FALSE);
+      icon = choose_icon (self, names, size, scale, direction, flags & ~GTK_ICON_LOOKUP_PRELOAD, FALSE);
     }
 
   gtk_icon_theme_unlock (self);
@@ -2523,6 +2623,106 @@ gtk_icon_theme_lookup_icon (GtkIconTheme       *self,
   return icon;
 }
 
+static void
+preload_icons_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  GPtrArray *icons = task_data;
+  guint i;
+
+  for (i = 0; i < icons->len; i++)
+    {
+      GtkIconPaintable *icon = g_ptr_array_index (icons, i);
+
+      /* Some other thread is already loading this one */
+      if (!g_mutex_trylock (&icon->texture_lock))
+        continue;
+
+      icon_ensure_texture__locked (icon, TRUE);
+      g_mutex_unlock (&icon->texture_lock);
+    }
+
+  g_task_return_pointer (task, NULL, NULL);
+}
+
+/**
+ * gtk_icon_theme_preload_icons:
+ * @self: a #GtkIconTheme
+ * @icon_names: (array zero-terminated=1): the names of the icons to preload
+ * @size: desired icon size
+ * @scale: the window scale the icons will be displayed on
+ * @direction: text direction the icons will be displayed in
+ * @flags: flags modifying the behavior of the icon lookup
+ *
+ * Looks up all of @icon_names like gtk_icon_theme_lookup_icon() and
+ * starts loading their textures in the background, all in a single
+ * thread pool job.
+ *
+ * This is useful when many icons are about to be shown at once, for
+ * example in the rows of a file list. Icons that are small enough are
+ * kept in the cache of recently used icons, so that later lookups with
+ * the same parameters find them already loaded.
+ */
+void
+gtk_icon_theme_preload_icons (GtkIconTheme       *self,
+                              const char * const *icon_names,
+                              int                 size,
+                              int                 scale,
+                              GtkTextDirection    direction,
+                              GtkIconLookupFlags  flags)
+{
+  GPtrArray *icons;
+  GTask *task;
+  int i;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (self));
+  g_return_if_fail (icon_names != NULL);
+  g_return_if_fail (scale >= 1);
+
+  icons = g_ptr_array_new_with_free_func (g_object_unref);
+
+  gtk_icon_theme_lock (self);
+
+  for (i = 0; icon_names[i]; i++)
+    {
+      const char *names[2];
+      GtkIconPaintable *icon;
+      gboolean has_texture = TRUE;
+
+      names[0] = icon_names[i];
+      names[1] = NULL;
+
+      icon = choose_icon (self, names, size, scale, direction, flags & ~GTK_ICON_LOOKUP_PRELOAD, FALSE);
+
+      /* If we fail to get the lock some other thread is loading it */
+      if (g_mutex_trylock (&icon->texture_lock))
+        {
+          has_texture = icon->texture != NULL;
+          g_mutex_unlock (&icon->texture_lock);
+        }
+
+      if (has_texture)
+        g_object_unref (icon);
+      else
+        g_ptr_array_add (icons, icon);
+    }
+
+  gtk_icon_theme_unlock (self);
+
+  if (icons->len == 0)
+    {
+      g_ptr_array_unref (icons);
+      return;
+    }
+
+  task = g_task_new (self, NULL, NULL, NULL);
+  g_task_set_task_data (task, icons, (GDestroyNotify) g_ptr_array_unref);
+  g_task_run_in_thread (task, preload_icons_thread);
+  g_object_unref (task);
+}
+
 /* Error quark */
 GQuark
 gtk_icon_theme_error_quark (void)
@@ -3003,12 +3203,13 @@ compare_dir_size_matches (IconThemeDirSize *dir_a, int difference_a,
   return diff_a <= diff_b;
 }
 
-static GtkIconPaintable *
+static gboolean
 theme_lookup_icon (IconTheme   *theme,
-                   const char *icon_name, /* interned */
+                   const char  *icon_name,
                    int          size,
                    int          scale,
-                   gboolean     allow_svg)
+                   gboolean     allow_svg,
+                   IconLookup  *lookup)
 {
   IconThemeDirSize *min_dir_size;
   IconThemeFile *min_file;
@@ -3063,23 +3264,20 @@ theme_lookup_icon (IconTheme   *theme,
 
   if (min_dir_size)
     {
-      GtkIconPaintable *icon;
       IconThemeDir *dir = &g_array_index (theme->dirs, IconThemeDir, min_file->dir_index);
       char *filename;
 
-      icon = icon_paintable_new (icon_name, size, scale);
-
       filename = g_strconcat (icon_name, string_from_suffix (min_suffix), NULL);
-      icon->filename = g_build_filename (dir->path, filename, NULL);
-      icon->is_svg = min_suffix == ICON_CACHE_FLAG_SVG_SUFFIX;
-      icon->is_resource = dir->is_resource;
-      icon->is_symbolic = icon_uri_is_symbolic (filename, -1);
+      lookup->filename = g_build_filename (dir->path, filename, NULL);
+      lookup->is_svg = min_suffix == ICON_CACHE_FLAG_SVG_SUFFIX;
+      lookup->is_resource = dir->is_resource;
+      lookup->is_symbolic = icon_uri_is_symbolic (filename, -1);
       g_free (filename);
 
-      return icon;
+      return TRUE;
     }
 
-  return NULL;
+  return FALSE;
 }
 
 static gboolean
@@ -3719,6 +3917,7 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
   GdkPixbuf *source_pixbuf;
   gint64 before;
   int pixel_size;
+  gboolean use_raster_cache = FALSE;
   GError *load_error = NULL;
 
   icon_cache_mark_used_if_cached (icon);
@@ -3760,9 +3959,16 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
                                                                     TRUE, &load_error);
         }
       else
-        source_pixbuf = _gdk_pixbuf_new_from_resource (icon->filename,
-                                                       g_str_has_suffix (icon->filename, ".xpm") ? "xpm" : "png",
-                                                       &load_error);
+        {
+          /* Our own icons are shipped predecoded */
+          icon->texture = gdk_texture_new_from_predecoded_resource (icon->filename);
+          if (icon->texture)
+            goto out;
+
+          source_pixbuf = _gdk_pixbuf_new_from_resource (icon->filename,
+                                                         g_str_has_suffix (icon->filename, ".xpm") ? "xpm" : "png",
+                                                         &load_error);
+        }
 
       if (source_pixbuf == NULL)
         {
@@ -3775,6 +3981,19 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
       GLoadableIcon *loadable;
       GInputStream *stream;
 
+      /* Rendering SVGs is expensive, try the result from last time */
+      if (icon->is_svg)
+        {
+          icon->texture = gtk_icon_raster_cache_lookup (icon->filename,
+                                                        pixel_size,
+                                                        icon->desired_scale,
+                                                        gtk_icon_paintable_is_symbolic (icon));
+          if (icon->texture)
+            goto out;
+
+          use_raster_cache = TRUE;
+        }
+
       loadable = icon_get_loadable (icon);
       stream = g_loadable_icon_load (loadable,
                                      pixel_size,
@@ -3817,6 +4036,7 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
 
   if (!source_pixbuf)
     {
+      use_raster_cache = FALSE;
       source_pixbuf = _gdk_pixbuf_new_from_resource (IMAGE_MISSING_RESOURCE_PATH, "png", NULL);
       icon->icon_name = g_strdup ("image-missing");
       icon->is_symbolic = FALSE;
@@ -3829,6 +4049,14 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
 
   g_assert (icon->texture != NULL);
 
+  if (use_raster_cache)
+    gtk_icon_raster_cache_store (icon->filename,
+                                 pixel_size,
+                                 icon->desired_scale,
+                                 gtk_icon_paintable_is_symbolic (icon),
+                                 icon->texture);
+
+out:
   if (GDK_PROFILER_IS_RUNNING)
     {
       gint64 end = GDK_PROFILER_CURRENT_TIME;
@@ -3859,13 +4087,18 @@ gtk_icon_paintable_ensure_texture (GtkIconPaintable *self)
   return texture;
 }
 
-static void
-init_color_matrix (graphene_matrix_t *color_matrix,
-                   graphene_vec4_t   *color_offset,
-                   const GdkRGBA     *foreground_color,
-                   const GdkRGBA     *success_color,
-                   const GdkRGBA     *warning_color,
-                   const GdkRGBA     *error_color)
+/* Symbolic textures are masks, with the success, warning and error
+ * weights in the color channels. This matrix turns them into the
+ * final colors when drawing, so the same texture can be shared by
+ * all colors.
+ */
+void
+gtk_icon_theme_init_symbolic_color_matrix (graphene_matrix_t *color_matrix,
+                                           graphene_vec4_t   *color_offset,
+                                           const GdkRGBA     *foreground_color,
+                                           const GdkRGBA     *success_color,
+                                           const GdkRGBA     *warning_color,
+                                           const GdkRGBA     *error_color)
 {
   GdkRGBA fg_default = { 0.7450980392156863, 0.7450980392156863, 0.7450980392156863, 1.0};
   GdkRGBA success_default = { 0.3046921492332342,0.6015716792553597, 0.023437857633325704, 1.0};
@@ -3941,9 +4174,9 @@ gtk_icon_paintable_snapshot_with_colors (GtkIconPaintable *icon,
       graphene_matrix_t matrix;
       graphene_vec4_t offset;
 
-      init_color_matrix (&matrix, &offset,
-                         foreground_color, success_color,
-                         warning_color, error_color);
+      gtk_icon_theme_init_symbolic_color_matrix (&matrix, &offset,
+                                                 foreground_color, success_color,
+                                                 warning_color, error_color);
 
       gtk_snapshot_push_color_matrix (snapshot, &matrix, &offset);
     }
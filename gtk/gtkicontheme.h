@@ -128,6 +128,13 @@ GtkIconPaintable *gtk_icon_theme_lookup_icon         (GtkIconTheme
                                                       GtkTextDirection             direction,
                                                       GtkIconLookupFlags           flags);
 GDK_AVAILABLE_IN_ALL
+void              gtk_icon_theme_preload_icons       (GtkIconTheme                *self,
+                                                      const char * const          *icon_names,
+                                                      int                          size,
+                                                      int                          scale,
+                                                      GtkTextDirection             direction,
+                                                      GtkIconLookupFlags           flags);
+GDK_AVAILABLE_IN_ALL
 GtkIconPaintable *gtk_icon_theme_lookup_by_gicon     (GtkIconTheme                *self,
                                                       GIcon                       *icon,
                                                       int                          size,
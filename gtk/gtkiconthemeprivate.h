@@ -32,6 +32,12 @@ void gtk_icon_theme_lookup_symbolic_colors   (GtkCssStyle      *style,
                                               GdkRGBA          *success_out,
                                               GdkRGBA          *warning_out,
                                               GdkRGBA          *error_out);
+void gtk_icon_theme_init_symbolic_color_matrix (graphene_matrix_t *color_matrix,
+                                                graphene_vec4_t   *color_offset,
+                                                const GdkRGBA     *foreground_color,
+                                                const GdkRGBA     *success_color,
+                                                const GdkRGBA     *warning_color,
+                                                const GdkRGBA     *error_color);
 void gtk_icon_paintable_snapshot_with_colors (GtkIconPaintable *icon,
                                               GtkSnapshot      *snapshot,
                                               double            width,
@@ -62,6 +62,11 @@
  * gdk_texture_new_from_file(), then create the #GtkImage with
  * gtk_image_new_from_paintable().
  *
+ * Files are loaded synchronously. To keep many images from blocking
+ * the user interface, load them with gdk_texture_new_from_file_async()
+ * at the size they will be displayed at, and set the result with
+ * gtk_image_set_from_paintable().
+ *
  * Sometimes an application will want to avoid depending on external data
  * files, such as image files. See the documentation of #GResource for details.
  * In this case, the #GtkImage:resource, gtk_image_new_from_resource() and
@@ -109,6 +114,8 @@ static void gtk_image_measure (GtkWidget      *widget,
                                int           *natural,
                                int           *minimum_baseline,
                                int           *natural_baseline);
+static gboolean gtk_image_measure_equal    (GtkWidget    *widget,
+                                            GtkWidget    *other);
 
 static void gtk_image_css_changed          (GtkWidget    *widget,
                                             GtkCssStyleChange *change);
@@ -265,6 +272,7 @@ gtk_image_class_init (GtkImageClass *class)
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, image_props);
 
   gtk_widget_class_set_css_name (widget_class, I_("image"));
+  gtk_widget_class_set_measure_equal_func (widget_class, gtk_image_measure_equal);
 
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_IMG);
 }
@@ -1255,6 +1263,18 @@ gtk_image_measure (GtkWidget      *widget,
     }
 }
 
+/* The size of the icon helper only depends on the style and the pixel size */
+static gboolean
+gtk_image_measure_equal (GtkWidget *widget,
+                         GtkWidget *other)
+{
+  GtkImage *image = GTK_IMAGE (widget);
+  GtkImage *other_image = GTK_IMAGE (other);
+
+  return _gtk_icon_helper_get_pixel_size (image->icon_helper) ==
+         _gtk_icon_helper_get_pixel_size (other_image->icon_helper);
+}
+
 static void
 gtk_image_css_changed (GtkWidget         *widget,
                        GtkCssStyleChange *change)
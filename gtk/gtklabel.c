@@ -26,6 +26,7 @@
 
 #include "gtklabelprivate.h"
 
+#include "gskpango.h"
 #include "gtkbuildable.h"
 #include "gtkbuilderprivate.h"
 #include "gtkcssstylepropertyprivate.h"
@@ -251,6 +252,16 @@
 typedef struct _GtkLabelClass         GtkLabelClass;
 typedef struct _GtkLabelSelectionInfo GtkLabelSelectionInfo;
 
+/* Number of widths for which the height of a wrapping label is remembered */
+#define N_MEASURED_HEIGHTS 4
+
+typedef struct
+{
+  int width;
+  int height;
+  int baseline;
+} GtkLabelMeasuredHeight;
+
 struct _GtkLabel
 {
   GtkWidget parent_instance;
@@ -282,12 +293,21 @@ struct _GtkLabel
   guint    single_line_mode   : 1;
   guint    in_click           : 1;
   guint    track_links        : 1;
+  guint    layout_is_shared   : 1;
 
   guint    mnemonic_keyval;
+  guint    layout_context_serial;
 
   int      width_chars;
   int      max_width_chars;
   int      lines;
+
+  /* Heights for widths, valid until the layout changes. Measuring
+   * happens again after every queue_resize, often for the same widths.
+   */
+  GtkLabelMeasuredHeight measured_heights[N_MEASURED_HEIGHTS];
+  guint    n_measured_heights;
+  guint    next_measured_height;
 };
 
 struct _GtkLabelClass
@@ -425,6 +445,8 @@ static void gtk_label_state_flags_changed   (GtkWidget        *widget,
                                              GtkStateFlags     prev_state);
 static void gtk_label_css_changed       (GtkWidget         *widget,
                                          GtkCssStyleChange *change);
+static void gtk_label_direction_changed (GtkWidget         *widget,
+                                         GtkTextDirection   previous_direction);
 static void gtk_label_snapshot          (GtkWidget         *widget,
                                          GtkSnapshot       *snapshot);
 static gboolean gtk_label_focus         (GtkWidget         *widget,
@@ -567,6 +589,8 @@ static void     gtk_label_measure (GtkWidget     *widget,
                                    int            *natural,
                                    int            *minimum_baseline,
                                    int            *natural_baseline);
+static gboolean gtk_label_measure_equal (GtkWidget     *widget,
+                                         GtkWidget     *other);
 
 
 
@@ -611,6 +635,7 @@ gtk_label_class_init (GtkLabelClass *class)
   widget_class->size_allocate = gtk_label_size_allocate;
   widget_class->state_flags_changed = gtk_label_state_flags_changed;
   widget_class->css_changed = gtk_label_css_changed;
+  widget_class->direction_changed = gtk_label_direction_changed;
   widget_class->query_tooltip = gtk_label_query_tooltip;
   widget_class->snapshot = gtk_label_snapshot;
   widget_class->unrealize = gtk_label_unrealize;
@@ -1079,6 +1104,7 @@ gtk_label_class_init (GtkLabelClass *class)
 
   gtk_widget_class_set_css_name (widget_class, I_("label"));
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_LABEL);
+  gtk_widget_class_set_measure_equal_func (widget_class, gtk_label_measure_equal);
 
   quark_mnemonics_visible_connected = g_quark_from_static_string ("gtk-label-mnemonics-visible-connected");
 
@@ -2710,6 +2736,7 @@ gtk_label_set_wrap_mode (GtkLabel *self,
       self->wrap_mode = wrap_mode;
       g_object_notify_by_pspec (G_OBJECT (self), label_props[PROP_WRAP_MODE]);
 
+      gtk_label_clear_layout (self);
       gtk_widget_queue_resize (GTK_WIDGET (self));
     }
 }
@@ -2764,10 +2791,19 @@ gtk_label_finalize (GObject *object)
   G_OBJECT_CLASS (gtk_label_parent_class)->finalize (object);
 }
 
+static void
+gtk_label_clear_measured_heights (GtkLabel *self)
+{
+  self->n_measured_heights = 0;
+  self->next_measured_height = 0;
+}
+
 static void
 gtk_label_clear_layout (GtkLabel *self)
 {
   g_clear_object (&self->layout);
+  self->layout_is_shared = FALSE;
+  gtk_label_clear_measured_heights (self);
 }
 
 /**
@@ -2813,7 +2849,8 @@ gtk_label_get_measuring_layout (GtkLabel    *self,
    * because we don't need it to be properly setup at that point.
    * This way we can make use of caching upon the label's creation.
    */
-  if (gtk_widget_get_width (GTK_WIDGET (self)) <= 1)
+  if (gtk_widget_get_width (GTK_WIDGET (self)) <= 1 &&
+      !self->layout_is_shared)
     {
       g_object_ref (self->layout);
       pango_layout_set_width (self->layout, width);
@@ -2857,6 +2894,14 @@ gtk_label_update_layout_attributes (GtkLabel      *self,
       return;
     }
 
+  /* Shared layouts must not be modified, create a new one instead */
+  if (self->layout_is_shared)
+    {
+      gtk_label_clear_layout (self);
+      pango_attr_list_unref (style_attrs);
+      return;
+    }
+
   if (self->select_info && self->select_info->links)
     {
       guint i;
@@ -2915,6 +2960,7 @@ gtk_label_update_layout_attributes (GtkLabel      *self,
   attrs = _gtk_pango_attr_list_merge (attrs, self->attrs);
 
   pango_layout_set_attributes (self->layout, attrs);
+  gtk_label_clear_measured_heights (self);
 
   pango_attr_list_unref (attrs);
 }
@@ -2922,11 +2968,19 @@ gtk_label_update_layout_attributes (GtkLabel      *self,
 static void
 gtk_label_ensure_layout (GtkLabel *self)
 {
+  PangoLayout *layout;
   PangoAlignment align;
   gboolean rtl;
 
   if (self->layout)
-    return;
+    {
+      /* Shared layouts don't follow changes to our context */
+      if (!self->layout_is_shared ||
+          self->layout_context_serial == pango_context_get_serial (gtk_widget_get_pango_context (GTK_WIDGET (self))))
+        return;
+
+      gtk_label_clear_layout (self);
+    }
 
   align = PANGO_ALIGN_LEFT; /* Quiet gcc */
   rtl = _gtk_widget_get_direction (GTK_WIDGET (self)) == GTK_TEXT_DIR_RTL;
@@ -2962,6 +3016,17 @@ gtk_label_ensure_layout (GtkLabel *self)
 
   if (self->ellipsize || self->wrap)
     pango_layout_set_width (self->layout, gtk_widget_get_width (GTK_WIDGET (self)) * PANGO_SCALE);
+
+  /* Selectable labels and labels with links update their layout
+   * with the selection and link state, so they keep their own.
+   */
+  if (self->select_info == NULL)
+    {
+      layout = self->layout;
+      self->layout = gsk_pango_layout_share (layout);
+      self->layout_is_shared = self->layout != layout;
+      self->layout_context_serial = pango_context_get_serial (gtk_widget_get_pango_context (GTK_WIDGET (self)));
+    }
 }
 
 static GtkSizeRequestMode
@@ -2984,8 +3049,25 @@ get_height_for_width (GtkLabel *self,
                       int      *minimum_baseline,
                       int      *natural_baseline)
 {
+  GtkLabelMeasuredHeight *measured;
   PangoLayout *layout;
   int text_height, baseline;
+  guint i;
+
+  for (i = 0; i < self->n_measured_heights; i++)
+    {
+      measured = &self->measured_heights[i];
+
+      if (measured->width == width)
+        {
+          *minimum_height = *natural_height = measured->height;
+          *minimum_baseline = *natural_baseline = measured->baseline;
+          return;
+        }
+    }
+
+  /* Start from a fresh layout, see gtk_label_ensure_layout() */
+  g_clear_object (&self->layout);
 
   layout = gtk_label_get_measuring_layout (self, NULL, width * PANGO_SCALE);
 
@@ -2999,6 +3081,13 @@ get_height_for_width (GtkLabel *self,
   *natural_baseline = baseline;
 
   g_object_unref (layout);
+
+  measured = &self->measured_heights[self->next_measured_height];
+  measured->width = width;
+  measured->height = text_height;
+  measured->baseline = baseline;
+  self->next_measured_height = (self->next_measured_height + 1) % N_MEASURED_HEIGHTS;
+  self->n_measured_heights = MIN (self->n_measured_heights + 1, N_MEASURED_HEIGHTS);
 }
 
 static int
@@ -3172,14 +3261,43 @@ gtk_label_measure (GtkWidget      *widget,
 
   if (orientation == GTK_ORIENTATION_VERTICAL && for_size != -1 && self->wrap)
     {
-      gtk_label_clear_layout (self);
-
       get_height_for_width (self, for_size, minimum, natural, minimum_baseline, natural_baseline);
     }
   else
     gtk_label_get_preferred_size (widget, orientation, minimum, natural, minimum_baseline, natural_baseline);
 }
 
+static gboolean
+attr_lists_equal (PangoAttrList *a,
+                  PangoAttrList *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return pango_attr_list_equal (a, b);
+}
+
+/* Compares everything that goes into the layout besides the style */
+static gboolean
+gtk_label_measure_equal (GtkWidget *widget,
+                         GtkWidget *other)
+{
+  GtkLabel *self = GTK_LABEL (widget);
+  GtkLabel *other_label = GTK_LABEL (other);
+
+  return g_strcmp0 (self->text, other_label->text) == 0 &&
+         self->wrap == other_label->wrap &&
+         self->wrap_mode == other_label->wrap_mode &&
+         self->ellipsize == other_label->ellipsize &&
+         self->single_line_mode == other_label->single_line_mode &&
+         self->width_chars == other_label->width_chars &&
+         self->max_width_chars == other_label->max_width_chars &&
+         self->lines == other_label->lines &&
+         _gtk_widget_get_direction (widget) == _gtk_widget_get_direction (other) &&
+         attr_lists_equal (self->attrs, other_label->attrs) &&
+         attr_lists_equal (self->markup_attrs, other_label->markup_attrs);
+}
+
 static void
 get_layout_location (GtkLabel  *self,
                      int       *xp,
@@ -3335,6 +3453,16 @@ gtk_label_state_flags_changed (GtkWidget     *widget,
     GTK_WIDGET_CLASS (gtk_label_parent_class)->state_flags_changed (widget, prev_state);
 }
 
+static void
+gtk_label_direction_changed (GtkWidget        *widget,
+                             GtkTextDirection  previous_direction)
+{
+  /* The alignment of the layout depends on the direction */
+  gtk_label_clear_layout (GTK_LABEL (widget));
+
+  GTK_WIDGET_CLASS (gtk_label_parent_class)->direction_changed (widget, previous_direction);
+}
+
 static void 
 gtk_label_css_changed (GtkWidget         *widget,
                        GtkCssStyleChange *change)
@@ -3345,6 +3473,9 @@ gtk_label_css_changed (GtkWidget         *widget,
 
   GTK_WIDGET_CLASS (gtk_label_parent_class)->css_changed (widget, change);
 
+  if (change == NULL || gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_TEXT_SIZE))
+    gtk_label_clear_measured_heights (self);
+
   if (gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_TEXT_ATTRS))
     {
       new_attrs = gtk_css_style_get_pango_attributes (gtk_css_style_change_get_new_style (change));
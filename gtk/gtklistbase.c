@@ -68,6 +68,10 @@ struct _GtkListBasePrivate
   GtkPackType anchor_side_across;
   guint center_widgets;
   guint above_below_widgets;
+  /* extra items ahead of the anchor in the direction we last scrolled */
+  GtkListItemTracker *prefetch;
+  guint n_prefetch;
+  int prefetch_direction; /* 1 or -1 once the anchor moved, 0 before */
   /* the last item that was selected - basically the location to extend selections from */
   GtkListItemTracker *selected;
   /* the item that has input focus */
@@ -589,6 +593,11 @@ gtk_list_base_dispose (GObject *object)
       gtk_list_item_tracker_free (priv->item_manager, priv->focus);
       priv->focus = NULL;
     }
+  if (priv->prefetch)
+    {
+      gtk_list_item_tracker_free (priv->item_manager, priv->prefetch);
+      priv->prefetch = NULL;
+    }
   g_clear_object (&priv->item_manager);
 
   g_clear_object (&priv->model);
@@ -1939,6 +1948,40 @@ gtk_list_base_get_anchor (GtkListBase *self)
                                              priv->anchor);
 }
 
+/* Places the prefetch window next to the items kept alive around
+ * the anchor, on the side the anchor last moved to
+ */
+static void
+gtk_list_base_update_prefetch (GtkListBase *self)
+{
+  GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
+  guint anchor_pos, items_before, n_before, n_after;
+
+  if (priv->prefetch == NULL || priv->prefetch_direction == 0)
+    return;
+
+  anchor_pos = gtk_list_item_tracker_get_position (priv->item_manager, priv->anchor);
+  if (anchor_pos == GTK_INVALID_LIST_POSITION)
+    return;
+
+  items_before = round (priv->center_widgets * CLAMP (priv->anchor_align_along, 0, 1));
+  n_before = items_before + priv->above_below_widgets;
+  n_after = priv->center_widgets - items_before + priv->above_below_widgets;
+
+  if (priv->prefetch_direction > 0)
+    gtk_list_item_tracker_set_position (priv->item_manager,
+                                        priv->prefetch,
+                                        anchor_pos + n_after + 1,
+                                        0,
+                                        priv->n_prefetch - 1);
+  else
+    gtk_list_item_tracker_set_position (priv->item_manager,
+                                        priv->prefetch,
+                                        anchor_pos > n_before ? anchor_pos - n_before - 1 : 0,
+                                        priv->n_prefetch - 1,
+                                        0);
+}
+
 /*
  * gtk_list_base_set_anchor:
  * @self: a #GtkListBase
@@ -1984,9 +2027,16 @@ gtk_list_base_set_anchor (GtkListBase *self,
                           GtkPackType  anchor_side_along)
 {
   GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
-  guint items_before;
+  guint items_before, old_pos;
 
+  old_pos = gtk_list_item_tracker_get_position (priv->item_manager, priv->anchor);
   items_before = round (priv->center_widgets * CLAMP (anchor_align_along, 0, 1));
+
+  /* Move the anchor and the prefetch window together, so items that
+   * stay in one of them keep their widgets
+   */
+  gtk_list_item_manager_freeze_trackers (priv->item_manager);
+
   gtk_list_item_tracker_set_position (priv->item_manager,
                                       priv->anchor,
                                       anchor_pos,
@@ -1998,6 +2048,12 @@ gtk_list_base_set_anchor (GtkListBase *self,
   priv->anchor_align_along = anchor_align_along;
   priv->anchor_side_along = anchor_side_along;
 
+  if (old_pos != GTK_INVALID_LIST_POSITION && anchor_pos != old_pos)
+    priv->prefetch_direction = anchor_pos > old_pos ? 1 : -1;
+  gtk_list_base_update_prefetch (self);
+
+  gtk_list_item_manager_thaw_trackers (priv->item_manager);
+
   gtk_widget_queue_allocate (GTK_WIDGET (self));
 }
 
@@ -2041,6 +2097,83 @@ gtk_list_base_set_anchor_max_widgets (GtkListBase *self,
                             priv->anchor_side_along);
 }
 
+/*
+ * gtk_list_base_set_prefetch:
+ * @self: a #GtkListBase
+ * @n_prefetch: the number of items to prefetch
+ *
+ * Sets how many items beyond the ones kept alive around the anchor
+ * should get widgets, in the direction the list was last scrolled.
+ * Those items get bound before they scroll into view, so that their
+ * widgets can start loading their contents early.
+ *
+ * The window is only placed once the list is scrolled. Setting
+ * this to 0 disables prefetching.
+ **/
+void
+gtk_list_base_set_prefetch (GtkListBase *self,
+                            guint        n_prefetch)
+{
+  GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
+
+  if (priv->n_prefetch == n_prefetch)
+    return;
+
+  priv->n_prefetch = n_prefetch;
+
+  if (n_prefetch == 0)
+    {
+      gtk_list_item_tracker_free (priv->item_manager, priv->prefetch);
+      priv->prefetch = NULL;
+    }
+  else
+    {
+      if (priv->prefetch == NULL)
+        priv->prefetch = gtk_list_item_tracker_new (priv->item_manager);
+
+      gtk_list_base_update_prefetch (self);
+    }
+}
+
+guint
+gtk_list_base_get_prefetch (GtkListBase *self)
+{
+  GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
+
+  return priv->n_prefetch;
+}
+
+/*
+ * gtk_list_base_get_n_prefetched:
+ * @self: a #GtkListBase
+ *
+ * Returns the number of items in the prefetch window that are not
+ * also kept alive around the anchor. Unlike gtk_list_base_get_prefetch(),
+ * this is what the window currently covers.
+ *
+ * Returns: the number of prefetched items
+ **/
+guint
+gtk_list_base_get_n_prefetched (GtkListBase *self)
+{
+  GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
+  guint start, n_items, anchor_start, anchor_n_items, overlap_start, overlap_end;
+
+  if (priv->prefetch == NULL ||
+      !gtk_list_item_tracker_get_range (priv->item_manager, priv->prefetch, &start, &n_items))
+    return 0;
+
+  if (!gtk_list_item_tracker_get_range (priv->item_manager, priv->anchor, &anchor_start, &anchor_n_items))
+    return n_items;
+
+  overlap_start = MAX (start, anchor_start);
+  overlap_end = MIN (start + n_items, anchor_start + anchor_n_items);
+  if (overlap_end <= overlap_start)
+    return n_items;
+
+  return n_items - (overlap_end - overlap_start);
+}
+
 /*
  * gtk_list_base_grab_focus_on_item:
  * @self: a #GtkListBase
@@ -93,6 +93,10 @@ void                   gtk_list_base_set_anchor                 (GtkListBase
 void                   gtk_list_base_set_anchor_max_widgets     (GtkListBase            *self,
                                                                  guint                   n_center,
                                                                  guint                   n_above_below);
+void                   gtk_list_base_set_prefetch               (GtkListBase            *self,
+                                                                 guint                   n_prefetch);
+guint                  gtk_list_base_get_prefetch               (GtkListBase            *self);
+guint                  gtk_list_base_get_n_prefetched           (GtkListBase            *self);
 void                   gtk_list_base_select_item                (GtkListBase            *self,
                                                                  guint                   pos,
                                                                  gboolean                modify,
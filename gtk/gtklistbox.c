@@ -23,11 +23,14 @@
 #include "gtkactionhelperprivate.h"
 #include "gtkadjustmentprivate.h"
 #include "gtkbinlayout.h"
+#include "gtkbitset.h"
 #include "gtkbuildable.h"
 #include "gtkgestureclick.h"
 #include "gtkintl.h"
+#include "gtklistitemmanagerprivate.h"
 #include "gtkmain.h"
 #include "gtkmarshalers.h"
+#include "gtkmultiselection.h"
 #include "gtkprivate.h"
 #include "gtkscrollable.h"
 #include "gtktypebuiltins.h"
@@ -86,6 +89,22 @@
  * the style of [list presentation](ListContainers.html#list-styles):
  * .rich-list, .navigation-sidebar or .data-table.
  *
+ * # Virtualized lists
+ *
+ * A #GtkListBox that is bound to a model with gtk_list_box_bind_model()
+ * creates a row for every item of the model by default. For large models,
+ * the #GtkListBox:virtualized property can be set to only create rows for
+ * the items that are scrolled into view, plus a few around them. The rows
+ * are recycled for other items while scrolling, and the widgets inside them
+ * are created by the create-widget function whenever a row gets a new item.
+ *
+ * Items without a row are estimated to be as high as the average row
+ * that exists. Selection is kept for all items of the model,
+ * but functions like gtk_list_box_get_row_at_index() or
+ * gtk_list_box_get_selected_rows() only know about the rows that currently
+ * exist. Sorting and filtering must be done by the model, and header
+ * functions are not supported.
+ *
  * # Accessibility
  *
  * GtkListBox uses the #GTK_ACCESSIBLE_ROLE_LIST role and GtkListBoxRow uses
@@ -138,6 +157,15 @@ struct _GtkListBox
   GtkListBoxCreateWidgetFunc create_widget_func;
   gpointer create_widget_func_data;
   GDestroyNotify create_widget_func_data_destroy;
+
+  /* Virtualized mode, only set up while a model is bound */
+  gboolean virtualized;
+  GtkListItemManager *item_manager;
+  GtkSelectionModel *selection;
+  GtkListItemTracker *anchor;
+  GtkListItemTracker *cursor_tracker;
+  GtkListItemTracker *selected_tracker;
+  int row_height;
 };
 
 struct _GtkListBoxClass
@@ -166,6 +194,8 @@ typedef struct
   GSequenceIter *iter;
   GtkWidget *header;
   GtkActionHelper *action_helper;
+  gpointer item;
+  guint position;
   int y;
   int height;
   guint visible     :1;
@@ -197,6 +227,7 @@ enum {
   PROP_ACTIVATE_ON_SINGLE_CLICK,
   PROP_ACCEPT_UNPAIRED_RELEASE,
   PROP_SHOW_SEPARATORS,
+  PROP_VIRTUALIZED,
   LAST_PROPERTY
 };
 
@@ -215,6 +246,9 @@ enum {
 
 #define ROW_PRIV(row) ((GtkListBoxRowPrivate*)gtk_list_box_row_get_instance_private ((GtkListBoxRow*)(row)))
 
+/* Rows kept around before and after the visible ones in virtualized mode */
+#define GTK_LIST_BOX_VIRTUAL_EXTRA_ROWS 16
+
 static GtkBuildableIface *parent_buildable_iface;
 
 static void     gtk_list_box_buildable_interface_init   (GtkBuildableIface *iface);
@@ -314,6 +348,17 @@ static void                 gtk_list_box_bound_model_changed            (GListMo
                                                                          gpointer             user_data);
 
 static void                 gtk_list_box_check_model_compat             (GtkListBox          *box);
+static void                 gtk_list_box_bind_model_rows                (GtkListBox          *box);
+static void                 gtk_list_box_unbind_model_rows              (GtkListBox          *box);
+static void                 gtk_list_box_update_virtual_range           (GtkListBox          *box);
+static void                 gtk_list_box_sync_virtual_rows              (GtkListBox          *box);
+static GtkListBoxRow *      gtk_list_box_ensure_virtual_row             (GtkListBox          *box,
+                                                                         int                  position);
+static void                 gtk_list_box_track_row                      (GtkListBox          *box,
+                                                                         GtkListItemTracker  *tracker,
+                                                                         GtkListBoxRow       *row);
+static void                 gtk_list_box_adjustment_value_changed       (GtkAdjustment       *adjustment,
+                                                                         GtkListBox          *box);
 
 static void gtk_list_box_measure (GtkWidget     *widget,
                                   GtkOrientation  orientation,
@@ -388,6 +433,9 @@ gtk_list_box_get_property (GObject    *obj,
     case PROP_SHOW_SEPARATORS:
       g_value_set_boolean (value, box->show_separators);
       break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, box->virtualized);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, property_id, pspec);
       break;
@@ -416,6 +464,9 @@ gtk_list_box_set_property (GObject      *obj,
     case PROP_SHOW_SEPARATORS:
       gtk_list_box_set_show_separators (box, g_value_get_boolean (value));
       break;
+    case PROP_VIRTUALIZED:
+      gtk_list_box_set_virtualized (box, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, property_id, pspec);
       break;
@@ -425,8 +476,16 @@ gtk_list_box_set_property (GObject      *obj,
 static void
 gtk_list_box_dispose (GObject *object)
 {
+  GtkListBox *box = GTK_LIST_BOX (object);
   GtkWidget *child;
 
+  if (box->adjustment)
+    g_signal_handlers_disconnect_by_func (box->adjustment, gtk_list_box_adjustment_value_changed, box);
+
+  /* Virtualized rows belong to the item manager */
+  if (box->item_manager)
+    gtk_list_box_unbind_model_rows (box);
+
   while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
     gtk_list_box_remove (GTK_LIST_BOX (object), child);
 
@@ -517,6 +576,21 @@ gtk_list_box_class_init (GtkListBoxClass *klass)
                           FALSE,
                           G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkListBox:virtualized:
+   *
+   * Whether a bound model only gets rows created for the items
+   * that are visible.
+   *
+   * See gtk_list_box_set_virtualized().
+   */
+  properties[PROP_VIRTUALIZED] =
+    g_param_spec_boolean ("virtualized",
+                          P_("Virtualized"),
+                          P_("Only create rows for visible items of the model"),
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (object_class, LAST_PROPERTY, properties);
 
   /**
@@ -749,6 +823,9 @@ gtk_list_box_get_selected_row (GtkListBox *box)
  * If @_index is negative or larger than the number of items in the
  * list, %NULL is returned.
  *
+ * If @box is virtualized, %NULL is also returned for items that
+ * currently don't have a row.
+ *
  * Returns: (transfer none) (nullable): the child #GtkWidget or %NULL
  */
 GtkListBoxRow *
@@ -759,6 +836,20 @@ gtk_list_box_get_row_at_index (GtkListBox *box,
 
   g_return_val_if_fail (GTK_IS_LIST_BOX (box), NULL);
 
+  if (box->item_manager)
+    {
+      GtkListItemManagerItem *item;
+
+      if (index_ < 0)
+        return NULL;
+
+      item = gtk_list_item_manager_get_nth (box->item_manager, index_, NULL);
+      if (item && item->widget)
+        return GTK_LIST_BOX_ROW (item->widget);
+
+      return NULL;
+    }
+
   iter = g_sequence_get_iter_at_pos (box->children, index_);
   if (!g_sequence_iter_is_end (iter))
     return g_sequence_get (iter);
@@ -927,6 +1018,9 @@ gtk_list_box_selected_rows_changed (GtkListBox *box)
  * Calls a function for each selected child.
  *
  * Note that the selection cannot be modified from within this function.
+ *
+ * If @box is virtualized, only the selected rows that currently
+ * exist are passed to @func.
  */
 void
 gtk_list_box_selected_foreach (GtkListBox            *box,
@@ -954,6 +1048,9 @@ gtk_list_box_selected_foreach (GtkListBox            *box,
  *
  * Creates a list of all selected children.
  *
+ * If @box is virtualized, only the selected rows that currently
+ * exist are returned.
+ *
  * Returns: (element-type GtkListBoxRow) (transfer container):
  *     A #GList containing the #GtkWidget for each selected child.
  *     Free with g_list_free() when done.
@@ -1034,8 +1131,22 @@ gtk_list_box_set_adjustment (GtkListBox    *box,
   if (adjustment)
     g_object_ref_sink (adjustment);
   if (box->adjustment)
-    g_object_unref (box->adjustment);
+    {
+      g_signal_handlers_disconnect_by_func (box->adjustment, gtk_list_box_adjustment_value_changed, box);
+      g_object_unref (box->adjustment);
+    }
   box->adjustment = adjustment;
+
+  if (adjustment)
+    {
+      /* Virtualized boxes create the rows that get scrolled into view */
+      g_signal_connect (adjustment, "value-changed",
+                        G_CALLBACK (gtk_list_box_adjustment_value_changed), box);
+      g_signal_connect (adjustment, "changed",
+                        G_CALLBACK (gtk_list_box_adjustment_value_changed), box);
+    }
+
+  gtk_list_box_update_virtual_range (box);
 }
 
 /**
@@ -1232,6 +1343,9 @@ gtk_list_box_set_header_func (GtkListBox                 *box,
   box->update_header_func = update_header;
   box->update_header_func_target = user_data;
   box->update_header_func_target_destroy_notify = destroy;
+
+  gtk_list_box_check_model_compat (box);
+
   gtk_list_box_invalidate_headers (box);
 }
 
@@ -1291,7 +1405,7 @@ gtk_list_box_invalidate_sort (GtkListBox *box)
 
   g_return_if_fail (GTK_IS_LIST_BOX (box));
 
-  if (box->sort_func == NULL)
+  if (box->sort_func == NULL || box->item_manager != NULL)
     return;
 
   g_sequence_sort (box->children, (GCompareDataFunc)do_sort, box);
@@ -1381,6 +1495,10 @@ gtk_list_box_got_row_changed (GtkListBox    *box,
   g_return_if_fail (GTK_IS_LIST_BOX (box));
   g_return_if_fail (GTK_IS_LIST_BOX_ROW (row));
 
+  /* The model takes care of virtualized rows */
+  if (box->item_manager)
+    return;
+
   prev_next = gtk_list_box_get_next_visible (box, row_priv->iter);
   if (box->sort_func != NULL)
     {
@@ -1476,6 +1594,27 @@ gtk_list_box_add_move_binding (GtkWidgetClass  *widget_class,
                                        "(iibb)", step, count, TRUE, TRUE);
 }
 
+/* Where a virtualized row that has not been allocated yet is going to end up */
+static int
+gtk_list_box_estimate_row_y (GtkListBox    *box,
+                             GtkListBoxRow *row)
+{
+  GSequenceIter *iter;
+  GtkListBoxRowPrivate *before;
+
+  iter = ROW_PRIV (row)->iter;
+  while (!g_sequence_iter_is_begin (iter))
+    {
+      iter = g_sequence_iter_prev (iter);
+      before = ROW_PRIV (g_sequence_get (iter));
+      if (before->height > 0)
+        return before->y + before->height +
+               (ROW_PRIV (row)->position - before->position - 1) * box->row_height;
+    }
+
+  return ROW_PRIV (row)->position * box->row_height;
+}
+
 static void
 ensure_row_visible (GtkListBox    *box,
                     GtkListBoxRow *row)
@@ -1487,6 +1626,13 @@ ensure_row_visible (GtkListBox    *box,
   if (!box->adjustment)
     return;
 
+  if (box->item_manager && ROW_PRIV (row)->height <= 0)
+    {
+      y = gtk_list_box_estimate_row_y (box, row);
+      gtk_adjustment_clamp_page (box->adjustment, y, y + box->row_height);
+      return;
+    }
+
   if (!gtk_widget_compute_bounds (GTK_WIDGET (row), GTK_WIDGET (box), &rect))
     return;
 
@@ -1513,6 +1659,8 @@ gtk_list_box_update_cursor (GtkListBox    *box,
                             gboolean grab_focus)
 {
   box->cursor_row = row;
+  if (box->item_manager)
+    gtk_list_box_track_row (box, box->cursor_tracker, row);
   ensure_row_visible (box, row);
   if (grab_focus)
     {
@@ -1544,8 +1692,8 @@ row_is_visible (GtkListBoxRow *row)
 }
 
 static gboolean
-gtk_list_box_row_set_selected (GtkListBoxRow *row,
-                               gboolean       selected)
+gtk_list_box_row_update_selected (GtkListBoxRow *row,
+                                  gboolean       selected)
 {
   if (!ROW_PRIV (row)->selectable)
     return FALSE;
@@ -1570,6 +1718,47 @@ gtk_list_box_row_set_selected (GtkListBoxRow *row,
   return FALSE;
 }
 
+static gboolean
+gtk_list_box_row_set_selected (GtkListBoxRow *row,
+                               gboolean       selected)
+{
+  GtkListBox *box;
+
+  if (!gtk_list_box_row_update_selected (row, selected))
+    return FALSE;
+
+  /* Virtualized rows get recycled, so their selection lives in the model */
+  box = gtk_list_box_row_get_box (row);
+  if (box && box->selection && ROW_PRIV (row)->item)
+    {
+      if (selected)
+        gtk_selection_model_select_item (box->selection, ROW_PRIV (row)->position, FALSE);
+      else
+        gtk_selection_model_unselect_item (box->selection, ROW_PRIV (row)->position);
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_list_box_set_selected_row (GtkListBox    *box,
+                               GtkListBoxRow *row)
+{
+  box->selected_row = row;
+  if (box->item_manager == NULL)
+    return;
+
+  if (row)
+    {
+      gtk_list_box_track_row (box, box->selected_tracker, row);
+    }
+  else
+    {
+      gtk_list_item_tracker_clear (box->item_manager, box->selected_tracker);
+      gtk_list_box_sync_virtual_rows (box);
+    }
+}
+
 static gboolean
 gtk_list_box_unselect_all_internal (GtkListBox *box)
 {
@@ -1580,6 +1769,23 @@ gtk_list_box_unselect_all_internal (GtkListBox *box)
   if (box->selection_mode == GTK_SELECTION_NONE)
     return FALSE;
 
+  if (box->selection)
+    {
+      GtkBitset *selected;
+
+      /* Also covers the items that don't have rows, the rows get
+       * updated by the item manager
+       */
+      selected = gtk_selection_model_get_selection (box->selection);
+      dirty = !gtk_bitset_is_empty (selected);
+      gtk_bitset_unref (selected);
+
+      gtk_selection_model_unselect_all (box->selection);
+      box->selected_row = NULL;
+
+      return dirty;
+    }
+
   for (iter = g_sequence_get_begin_iter (box->children);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -1628,7 +1834,7 @@ gtk_list_box_select_row_internal (GtkListBox    *box,
     gtk_list_box_unselect_all_internal (box);
 
   gtk_list_box_row_set_selected (row, TRUE);
-  box->selected_row = row;
+  gtk_list_box_set_selected_row (box, row);
 
   g_signal_emit (box, signals[ROW_SELECTED], 0, row);
   g_signal_emit (box, signals[SELECTED_ROWS_CHANGED], 0);
@@ -1642,6 +1848,19 @@ gtk_list_box_select_all_between (GtkListBox    *box,
 {
   GSequenceIter *iter, *iter1, *iter2;
 
+  if (box->selection && !modify)
+    {
+      guint pos1, pos2;
+
+      pos1 = row1 ? ROW_PRIV (row1)->position : 0;
+      pos2 = row2 ? ROW_PRIV (row2)->position : g_list_model_get_n_items (G_LIST_MODEL (box->selection)) - 1;
+      gtk_selection_model_select_range (box->selection,
+                                        MIN (pos1, pos2),
+                                        MAX (pos1, pos2) - MIN (pos1, pos2) + 1,
+                                        FALSE);
+      return;
+    }
+
   if (row1)
     iter1 = ROW_PRIV (row1)->iter;
   else
@@ -1700,7 +1919,7 @@ gtk_list_box_update_selection_full (GtkListBox    *box,
     {
       gtk_list_box_unselect_all_internal (box);
       gtk_list_box_row_set_selected (row, TRUE);
-      box->selected_row = row;
+      gtk_list_box_set_selected_row (box, row);
       g_signal_emit (box, signals[ROW_SELECTED], 0, row);
     }
   else if (box->selection_mode == GTK_SELECTION_SINGLE)
@@ -1710,7 +1929,7 @@ gtk_list_box_update_selection_full (GtkListBox    *box,
       was_selected = ROW_PRIV (row)->selected;
       gtk_list_box_unselect_all_internal (box);
       gtk_list_box_row_set_selected (row, modify ? !was_selected : TRUE);
-      box->selected_row = ROW_PRIV (row)->selected ? row : NULL;
+      gtk_list_box_set_selected_row (box, ROW_PRIV (row)->selected ? row : NULL);
       g_signal_emit (box, signals[ROW_SELECTED], 0, box->selected_row);
     }
   else /* GTK_SELECTION_MULTIPLE */
@@ -1726,7 +1945,7 @@ gtk_list_box_update_selection_full (GtkListBox    *box,
           if (selected_row == NULL)
             {
               gtk_list_box_row_set_selected (row, TRUE);
-              box->selected_row = row;
+              gtk_list_box_set_selected_row (box, row);
               g_signal_emit (box, signals[ROW_SELECTED], 0, row);
             }
           else
@@ -1744,7 +1963,7 @@ gtk_list_box_update_selection_full (GtkListBox    *box,
             {
               gtk_list_box_unselect_all_internal (box);
               gtk_list_box_row_set_selected (row, !ROW_PRIV (row)->selected);
-              box->selected_row = row;
+              gtk_list_box_set_selected_row (box, row);
               g_signal_emit (box, signals[ROW_SELECTED], 0, row);
             }
         }
@@ -2060,7 +2279,7 @@ gtk_list_box_apply_filter (GtkListBox    *box,
   gboolean do_show;
 
   do_show = TRUE;
-  if (box->filter_func != NULL)
+  if (box->filter_func != NULL && box->item_manager == NULL)
     do_show = box->filter_func (row, box->filter_func_target);
 
   gtk_widget_set_child_visible (GTK_WIDGET (row), do_show);
@@ -2197,6 +2416,9 @@ gtk_list_box_update_header (GtkListBox    *box,
   if (iter == NULL || g_sequence_iter_is_end (iter))
     return;
 
+  if (box->item_manager)
+    return;
+
   row = g_sequence_get (iter);
   g_object_ref (row);
 
@@ -2323,6 +2545,12 @@ gtk_list_box_remove (GtkListBox *box,
     }
 
   row = GTK_LIST_BOX_ROW (child);
+  if (box->item_manager)
+    {
+      g_warning ("Rows of a virtualized GtkListBox can only be removed from its model");
+      return;
+    }
+
   iter = ROW_PRIV (row)->iter;
   if (g_sequence_iter_get_sequence (iter) != box->children)
     {
@@ -2405,6 +2633,40 @@ gtk_list_box_get_request_mode (GtkWidget *widget)
   return GTK_SIZE_REQUEST_HEIGHT_FOR_WIDTH;
 }
 
+/* In virtualized mode, items without a row are assumed
+ * to be as high as the average row that exists.
+ */
+static int
+gtk_list_box_estimate_row_height (GtkListBox *box,
+                                  int         for_size)
+{
+  GSequenceIter *iter;
+  int row_min;
+  int total = 0;
+  int n_rows = 0;
+
+  for (iter = g_sequence_get_begin_iter (box->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GtkListBoxRow *row = g_sequence_get (iter);
+
+      if (!row_is_visible (row))
+        continue;
+
+      gtk_widget_measure (GTK_WIDGET (row), GTK_ORIENTATION_VERTICAL, for_size,
+                          &row_min, NULL,
+                          NULL, NULL);
+      total += row_min;
+      n_rows++;
+    }
+
+  if (n_rows == 0)
+    return 0;
+
+  return total / n_rows;
+}
+
 static void
 gtk_list_box_measure (GtkWidget     *widget,
                       GtkOrientation  orientation,
@@ -2500,6 +2762,14 @@ gtk_list_box_measure (GtkWidget     *widget,
           *minimum += row_min;
         }
 
+      if (box->item_manager)
+        {
+          guint n_items = g_list_model_get_n_items (G_LIST_MODEL (box->selection));
+          guint n_rows = g_sequence_get_length (box->children);
+
+          *minimum += (n_items - n_rows) * gtk_list_box_estimate_row_height (box, for_size);
+        }
+
       /* We always allocate the minimum height, since handling expanding rows
        * is way too costly, and unlikely to be used, as lists are generally put
        * inside a scrolling window anyway.
@@ -2520,7 +2790,13 @@ gtk_list_box_size_allocate (GtkWidget *widget,
   GtkListBoxRow *row;
   GSequenceIter *iter;
   int child_min;
+  guint next_position = 0;
 
+  if (box->item_manager)
+    {
+      box->row_height = gtk_list_box_estimate_row_height (box, width);
+      gtk_list_box_update_virtual_range (box);
+    }
 
   child_allocation.x = 0;
   child_allocation.y = 0;
@@ -2548,6 +2824,14 @@ gtk_list_box_size_allocate (GtkWidget *widget,
        iter = g_sequence_iter_next (iter))
     {
       row = g_sequence_get (iter);
+
+      if (box->item_manager)
+        {
+          /* Leave room for the items in front of the row that don't have one */
+          child_allocation.y += (ROW_PRIV (row)->position - next_position) * box->row_height;
+          next_position = ROW_PRIV (row)->position + 1;
+        }
+
       if (!row_is_visible (row))
         {
           ROW_PRIV (row)->y = child_allocation.y;
@@ -2635,6 +2919,12 @@ gtk_list_box_insert (GtkListBox *box,
   g_return_if_fail (GTK_IS_LIST_BOX (box));
   g_return_if_fail (GTK_IS_WIDGET (child));
 
+  if (box->item_manager)
+    {
+      g_warning ("Rows can only be added to a virtualized GtkListBox through its model");
+      return;
+    }
+
   if (GTK_IS_LIST_BOX_ROW (child))
     row = GTK_LIST_BOX_ROW (child);
   else
@@ -2762,13 +3052,19 @@ gtk_list_box_move_cursor (GtkListBox      *box,
   switch ((guint) step)
     {
     case GTK_MOVEMENT_BUFFER_ENDS:
-      if (count < 0)
+      if (box->item_manager)
+        row = gtk_list_box_ensure_virtual_row (box, count < 0 ? 0 : (int) g_list_model_get_n_items (G_LIST_MODEL (box->selection)) - 1);
+      else if (count < 0)
         row = gtk_list_box_get_first_focusable (box);
       else
         row = gtk_list_box_get_last_focusable (box);
       break;
     case GTK_MOVEMENT_DISPLAY_LINES:
-      if (box->cursor_row != NULL)
+      if (box->cursor_row != NULL && box->item_manager)
+        {
+          row = gtk_list_box_ensure_virtual_row (box, (int) ROW_PRIV (box->cursor_row)->position + count);
+        }
+      else if (box->cursor_row != NULL)
         {
           int i = count;
 
@@ -2794,7 +3090,16 @@ gtk_list_box_move_cursor (GtkListBox      *box,
       if (box->adjustment != NULL)
         page_size = gtk_adjustment_get_page_increment (box->adjustment);
 
-      if (box->cursor_row != NULL)
+      if (box->cursor_row != NULL && box->item_manager)
+        {
+          int n_items = g_list_model_get_n_items (G_LIST_MODEL (box->selection));
+          int page_rows = MAX (page_size / MAX (box->row_height, 1), 1);
+
+          row = gtk_list_box_ensure_virtual_row (box,
+                                                 CLAMP ((int) ROW_PRIV (box->cursor_row)->position + count * page_rows,
+                                                        0, n_items - 1));
+        }
+      else if (box->cursor_row != NULL)
         {
           start_y = ROW_PRIV (box->cursor_row)->y;
           height = gtk_widget_get_height (GTK_WIDGET (box));
@@ -3132,7 +3437,14 @@ gtk_list_box_row_get_index (GtkListBoxRow *row)
   g_return_val_if_fail (GTK_IS_LIST_BOX_ROW (row), -1);
 
   if (priv->iter != NULL)
-    return g_sequence_iter_get_position (priv->iter);
+    {
+      GtkListBox *box = gtk_list_box_row_get_box (row);
+
+      if (box && box->item_manager)
+        return priv->position;
+
+      return g_sequence_iter_get_position (priv->iter);
+    }
 
   return -1;
 }
@@ -3410,6 +3722,7 @@ gtk_list_box_row_dispose (GObject *object)
 
   g_clear_object (&priv->action_helper);
   g_clear_pointer (&priv->child, gtk_widget_unparent);
+  g_clear_object (&priv->item);
 
   G_OBJECT_CLASS (gtk_list_box_row_parent_class)->dispose (object);
 }
@@ -3507,6 +3820,7 @@ gtk_list_box_row_class_init (GtkListBoxRowClass *klass)
 
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
   gtk_widget_class_set_css_name (widget_class, I_("row"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_LIST_ITEM);
 }
 
@@ -3517,6 +3831,7 @@ gtk_list_box_row_init (GtkListBoxRow *row)
   ROW_PRIV (row)->selectable = TRUE;
 
   gtk_widget_set_focusable (GTK_WIDGET (row), TRUE);
+  gtk_widget_set_render_boundary (GTK_WIDGET (row), TRUE);
   gtk_widget_add_css_class (GTK_WIDGET (row), "activatable");
 }
 
@@ -3542,6 +3857,354 @@ gtk_list_box_buildable_interface_init (GtkBuildableIface *iface)
   iface->add_child = gtk_list_box_buildable_add_child;
 }
 
+/* Makes box->children match the rows the item manager has created.
+ * The sequence holds a reference on its rows, so rows the item manager
+ * let go of stay alive until they are dropped here.
+ */
+static void
+gtk_list_box_sync_virtual_rows (GtkListBox *box)
+{
+  GtkListItemManagerItem *item;
+  GSequence *old_children;
+  GSequenceIter *iter;
+  int n_visible_rows = 0;
+
+  old_children = box->children;
+  for (iter = g_sequence_get_begin_iter (old_children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    ROW_PRIV (g_sequence_get (iter))->iter = NULL;
+
+  box->children = g_sequence_new (g_object_unref);
+  for (item = gtk_list_item_manager_get_first (box->item_manager);
+       item != NULL;
+       item = gtk_rb_tree_node_get_next (item))
+    {
+      GtkListBoxRowPrivate *row_priv;
+
+      if (item->widget == NULL)
+        continue;
+
+      row_priv = ROW_PRIV (GTK_LIST_BOX_ROW (item->widget));
+      row_priv->iter = g_sequence_append (box->children, g_object_ref (item->widget));
+      row_priv->visible = gtk_widget_get_visible (item->widget);
+      if (row_priv->visible)
+        n_visible_rows++;
+    }
+
+  /* Forget about rows that are gone */
+  if (box->selected_row && ROW_PRIV (box->selected_row)->iter == NULL)
+    box->selected_row = NULL;
+  if (box->cursor_row && ROW_PRIV (box->cursor_row)->iter == NULL)
+    box->cursor_row = NULL;
+  if (box->active_row && ROW_PRIV (box->active_row)->iter == NULL)
+    box->active_row = NULL;
+  if (box->drag_highlighted_row && ROW_PRIV (box->drag_highlighted_row)->iter == NULL)
+    gtk_list_box_drag_unhighlight_row (box);
+
+  g_sequence_free (old_children);
+
+  list_box_add_visible_rows (box, n_visible_rows - box->n_visible_rows);
+  gtk_widget_queue_resize (GTK_WIDGET (box));
+}
+
+static void
+gtk_list_box_track_row (GtkListBox         *box,
+                        GtkListItemTracker *tracker,
+                        GtkListBoxRow      *row)
+{
+  guint position;
+
+  if (row == NULL)
+    return;
+
+  position = ROW_PRIV (row)->position;
+  if (gtk_list_item_tracker_get_position (box->item_manager, tracker) == position)
+    return;
+
+  gtk_list_item_tracker_set_position (box->item_manager, tracker, position, 0, 0);
+  gtk_list_box_sync_virtual_rows (box);
+}
+
+/* Moves the cursor tracker to @position, so that a row exists for it */
+static GtkListBoxRow *
+gtk_list_box_ensure_virtual_row (GtkListBox *box,
+                                 int         position)
+{
+  GtkListItemManagerItem *item;
+
+  if (position < 0 ||
+      (guint) position >= g_list_model_get_n_items (G_LIST_MODEL (box->selection)))
+    return NULL;
+
+  gtk_list_item_tracker_set_position (box->item_manager, box->cursor_tracker, position, 0, 0);
+  gtk_list_box_sync_virtual_rows (box);
+
+  item = gtk_list_item_manager_get_nth (box->item_manager, position, NULL);
+
+  return GTK_LIST_BOX_ROW (item->widget);
+}
+
+static guint
+gtk_list_box_get_position_at_y (GtkListBox *box,
+                                int         y)
+{
+  GtkListBoxRowPrivate *before = NULL;
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (box->children);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GtkListBoxRowPrivate *row_priv = ROW_PRIV (g_sequence_get (iter));
+
+      if (row_priv->height <= 0)
+        continue;
+      if (row_priv->y > y)
+        break;
+
+      before = row_priv;
+    }
+
+  if (before == NULL)
+    return MAX (y, 0) / box->row_height;
+
+  if (y < before->y + before->height)
+    return before->position;
+
+  return before->position + 1 + (y - before->y - before->height) / box->row_height;
+}
+
+static void
+gtk_list_box_update_virtual_range (GtkListBox *box)
+{
+  guint n_items, position, n_rows, start, n;
+
+  if (box->item_manager == NULL)
+    return;
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (box->selection));
+  if (n_items == 0)
+    return;
+
+  if (box->adjustment == NULL)
+    {
+      /* Without a scrolling parent, all rows are visible */
+      position = 0;
+      n_rows = n_items;
+    }
+  else if (box->row_height <= 0)
+    {
+      /* Nothing was allocated yet, start at the top */
+      position = 0;
+      n_rows = GTK_LIST_BOX_VIRTUAL_EXTRA_ROWS;
+    }
+  else
+    {
+      double value = gtk_adjustment_get_value (box->adjustment);
+      double page_size = gtk_adjustment_get_page_size (box->adjustment);
+
+      position = MIN (gtk_list_box_get_position_at_y (box, value), n_items - 1);
+      n_rows = ceil (page_size / box->row_height) + 1;
+    }
+
+  /* Keep the rows while they cover what is visible */
+  if (gtk_list_item_tracker_get_range (box->item_manager, box->anchor, &start, &n) &&
+      start <= position &&
+      MIN (position + n_rows, n_items) <= start + n &&
+      n <= n_rows + 3 * GTK_LIST_BOX_VIRTUAL_EXTRA_ROWS)
+    return;
+
+  gtk_list_item_tracker_set_position (box->item_manager,
+                                      box->anchor,
+                                      position,
+                                      GTK_LIST_BOX_VIRTUAL_EXTRA_ROWS,
+                                      n_rows + GTK_LIST_BOX_VIRTUAL_EXTRA_ROWS);
+  gtk_list_box_sync_virtual_rows (box);
+}
+
+static void
+gtk_list_box_adjustment_value_changed (GtkAdjustment *adjustment,
+                                       GtkListBox    *box)
+{
+  gtk_list_box_update_virtual_range (box);
+}
+
+static GtkWidget *
+gtk_list_box_create_virtual_row (gpointer user_data)
+{
+  return gtk_list_box_row_new ();
+}
+
+static void
+gtk_list_box_update_virtual_row (GtkWidget *widget,
+                                 guint      position,
+                                 gpointer   item,
+                                 gboolean   selected,
+                                 gpointer   user_data)
+{
+  GtkListBox *box = user_data;
+  GtkListBoxRow *row = GTK_LIST_BOX_ROW (widget);
+  GtkListBoxRowPrivate *row_priv = ROW_PRIV (row);
+
+  row_priv->position = position;
+
+  if (row_priv->item != item)
+    {
+      gtk_list_box_row_set_child (row, NULL);
+      g_clear_object (&row_priv->item);
+      row_priv->y = 0;
+      row_priv->height = 0;
+
+      if (item)
+        {
+          GtkWidget *child;
+
+          row_priv->item = g_object_ref (item);
+
+          child = box->create_widget_func (item, box->create_widget_func_data);
+          if (g_object_is_floating (child))
+            g_object_ref_sink (child);
+
+          if (GTK_IS_LIST_BOX_ROW (child))
+            {
+              g_warning ("The widget creation function of a virtualized GtkListBox must not return a GtkListBoxRow");
+            }
+          else
+            {
+              gtk_widget_show (child);
+              gtk_list_box_row_set_child (row, child);
+            }
+
+          g_object_unref (child);
+        }
+    }
+
+  gtk_list_box_update_row_style (box, row);
+  gtk_list_box_row_update_selected (row, selected);
+}
+
+static gpointer
+gtk_list_box_get_virtual_row_item (GtkWidget *widget)
+{
+  return ROW_PRIV (GTK_LIST_BOX_ROW (widget))->item;
+}
+
+static guint
+gtk_list_box_get_virtual_row_position (GtkWidget *widget)
+{
+  return ROW_PRIV (GTK_LIST_BOX_ROW (widget))->position;
+}
+
+static const GtkListItemManagerWidgetFuncs virtual_row_funcs = {
+  gtk_list_box_create_virtual_row,
+  gtk_list_box_update_virtual_row,
+  gtk_list_box_get_virtual_row_item,
+  gtk_list_box_get_virtual_row_position
+};
+
+static void
+gtk_list_box_virtual_items_changed (GListModel *model,
+                                    guint       position,
+                                    guint       removed,
+                                    guint       added,
+                                    GtkListBox *box)
+{
+  gboolean had_selected_row = box->selected_row != NULL;
+
+  gtk_list_box_sync_virtual_rows (box);
+  gtk_list_box_update_virtual_range (box);
+
+  if (had_selected_row && box->selected_row == NULL)
+    {
+      g_signal_emit (box, signals[ROW_SELECTED], 0, NULL);
+      g_signal_emit (box, signals[SELECTED_ROWS_CHANGED], 0);
+    }
+}
+
+static void
+gtk_list_box_bind_model_rows (GtkListBox *box)
+{
+  if (!box->virtualized)
+    {
+      g_signal_connect (box->bound_model, "items-changed", G_CALLBACK (gtk_list_box_bound_model_changed), box);
+      gtk_list_box_bound_model_changed (box->bound_model, 0, 0, g_list_model_get_n_items (box->bound_model), box);
+      return;
+    }
+
+  box->selection = GTK_SELECTION_MODEL (gtk_multi_selection_new (g_object_ref (box->bound_model)));
+  box->item_manager = gtk_list_item_manager_new_for_size (GTK_WIDGET (box),
+                                                          "row",
+                                                          GTK_ACCESSIBLE_ROLE_LIST_ITEM,
+                                                          sizeof (GtkListItemManagerItem),
+                                                          sizeof (GtkListItemManagerItemAugment),
+                                                          gtk_list_item_manager_augment_node);
+  gtk_list_item_manager_set_widget_funcs (box->item_manager, &virtual_row_funcs, box);
+  box->anchor = gtk_list_item_tracker_new (box->item_manager);
+  box->cursor_tracker = gtk_list_item_tracker_new (box->item_manager);
+  box->selected_tracker = gtk_list_item_tracker_new (box->item_manager);
+  box->row_height = 0;
+
+  gtk_list_item_manager_set_model (box->item_manager, box->selection);
+  /* Connected after the item manager, so its rows are up to date */
+  g_signal_connect (box->selection, "items-changed", G_CALLBACK (gtk_list_box_virtual_items_changed), box);
+
+  gtk_list_box_update_virtual_range (box);
+  gtk_list_box_sync_virtual_rows (box);
+}
+
+static void
+gtk_list_box_unbind_model_rows (GtkListBox *box)
+{
+  GSequenceIter *iter;
+
+  if (box->item_manager)
+    {
+      GSequence *children;
+
+      g_signal_handlers_disconnect_by_func (box->selection, gtk_list_box_virtual_items_changed, box);
+
+      gtk_list_item_tracker_free (box->item_manager, box->anchor);
+      gtk_list_item_tracker_free (box->item_manager, box->cursor_tracker);
+      gtk_list_item_tracker_free (box->item_manager, box->selected_tracker);
+      box->anchor = NULL;
+      box->cursor_tracker = NULL;
+      box->selected_tracker = NULL;
+
+      /* This unparents all rows */
+      g_clear_object (&box->item_manager);
+      g_clear_object (&box->selection);
+
+      box->selected_row = NULL;
+      box->cursor_row = NULL;
+      box->active_row = NULL;
+      gtk_list_box_drag_unhighlight_row (box);
+
+      children = box->children;
+      box->children = g_sequence_new (NULL);
+      for (iter = g_sequence_get_begin_iter (children);
+           !g_sequence_iter_is_end (iter);
+           iter = g_sequence_iter_next (iter))
+        ROW_PRIV (g_sequence_get (iter))->iter = NULL;
+      g_sequence_free (children);
+
+      list_box_add_visible_rows (box, -box->n_visible_rows);
+      gtk_widget_queue_resize (GTK_WIDGET (box));
+    }
+  else if (box->bound_model)
+    {
+      g_signal_handlers_disconnect_by_func (box->bound_model, gtk_list_box_bound_model_changed, box);
+    }
+
+  iter = g_sequence_get_begin_iter (box->children);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      GtkWidget *row = g_sequence_get (iter);
+      iter = g_sequence_iter_next (iter);
+      gtk_list_box_remove (box, row);
+    }
+}
+
 static void
 gtk_list_box_bound_model_changed (GListModel *list,
                                   guint       position,
@@ -3592,6 +4255,9 @@ gtk_list_box_check_model_compat (GtkListBox *box)
   if (box->bound_model &&
       (box->sort_func || box->filter_func))
     g_warning ("GtkListBox with a model will ignore sort and filter functions");
+
+  if (box->bound_model && box->virtualized && box->update_header_func)
+    g_warning ("A virtualized GtkListBox will ignore header functions");
 }
 
 /**
@@ -3627,30 +4293,20 @@ gtk_list_box_bind_model (GtkListBox                 *box,
                          gpointer                    user_data,
                          GDestroyNotify              user_data_free_func)
 {
-  GSequenceIter *iter;
-
   g_return_if_fail (GTK_IS_LIST_BOX (box));
   g_return_if_fail (model == NULL || G_IS_LIST_MODEL (model));
   g_return_if_fail (model == NULL || create_widget_func != NULL);
 
+  gtk_list_box_unbind_model_rows (box);
+
   if (box->bound_model)
     {
       if (box->create_widget_func_data_destroy)
         box->create_widget_func_data_destroy (box->create_widget_func_data);
 
-      g_signal_handlers_disconnect_by_func (box->bound_model, gtk_list_box_bound_model_changed, box);
       g_clear_object (&box->bound_model);
     }
 
-  iter = g_sequence_get_begin_iter (box->children);
-  while (!g_sequence_iter_is_end (iter))
-    {
-      GtkWidget *row = g_sequence_get (iter);
-      iter = g_sequence_iter_next (iter);
-      gtk_list_box_remove (box, row);
-    }
-
-
   if (model == NULL)
     return;
 
@@ -3660,9 +4316,7 @@ gtk_list_box_bind_model (GtkListBox                 *box,
   box->create_widget_func_data_destroy = user_data_free_func;
 
   gtk_list_box_check_model_compat (box);
-
-  g_signal_connect (box->bound_model, "items-changed", G_CALLBACK (gtk_list_box_bound_model_changed), box);
-  gtk_list_box_bound_model_changed (model, 0, 0, g_list_model_get_n_items (model), box);
+  gtk_list_box_bind_model_rows (box);
 }
 
 /**
@@ -3708,3 +4362,56 @@ gtk_list_box_get_show_separators (GtkListBox *box)
 
   return box->show_separators;
 }
+
+/**
+ * gtk_list_box_set_virtualized:
+ * @box: a #GtkListBox
+ * @virtualized: %TRUE to only create rows for visible items
+ *
+ * Sets whether rows for a model bound with gtk_list_box_bind_model()
+ * are only created for the items that are visible.
+ *
+ * This allows binding models with a large number of items. Rows
+ * are reused for other items when scrolling, so the create-widget
+ * function can be called again for the same item.
+ *
+ * If a model is already bound to @box, all rows are recreated.
+ */
+void
+gtk_list_box_set_virtualized (GtkListBox *box,
+                              gboolean    virtualized)
+{
+  g_return_if_fail (GTK_IS_LIST_BOX (box));
+
+  virtualized = virtualized != FALSE;
+  if (box->virtualized == virtualized)
+    return;
+
+  box->virtualized = virtualized;
+
+  if (box->bound_model)
+    {
+      gtk_list_box_unbind_model_rows (box);
+      gtk_list_box_check_model_compat (box);
+      gtk_list_box_bind_model_rows (box);
+    }
+
+  g_object_notify_by_pspec (G_OBJECT (box), properties[PROP_VIRTUALIZED]);
+}
+
+/**
+ * gtk_list_box_get_virtualized:
+ * @box: a #GtkListBox
+ *
+ * Returns whether rows are only created for visible items
+ * of a bound model.
+ *
+ * Returns: %TRUE if the list box is virtualized
+ */
+gboolean
+gtk_list_box_get_virtualized (GtkListBox *box)
+{
+  g_return_val_if_fail (GTK_IS_LIST_BOX (box), FALSE);
+
+  return box->virtualized;
+}
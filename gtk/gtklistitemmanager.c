@@ -26,6 +26,12 @@
 
 #define GTK_LIST_VIEW_MAX_LIST_ITEMS 200
 
+/* Released list items we keep around for reuse. Those are unbound and
+ * hidden, but stay inside the list widget, so they don't get torn down
+ * and set up again by unrooting and rooting them.
+ */
+#define GTK_LIST_ITEM_MANAGER_MAX_POOLED 32
+
 struct _GtkListItemManager
 {
   GObject parent_instance;
@@ -37,8 +43,13 @@ struct _GtkListItemManager
   const char *item_css_name;
   GtkAccessibleRole item_role;
 
+  const GtkListItemManagerWidgetFuncs *widget_funcs;
+  gpointer widget_funcs_data;
+
   GtkRbTree *items;
   GSList *trackers;
+  guint trackers_frozen;
+  GQueue pool;
 };
 
 struct _GtkListItemManagerClass
@@ -49,7 +60,7 @@ struct _GtkListItemManagerClass
 struct _GtkListItemTracker
 {
   guint position;
-  GtkListItemWidget *widget;
+  GtkWidget *widget;
   guint n_before;
   guint n_after;
 };
@@ -74,6 +85,54 @@ static void             gtk_list_item_manager_release_list_item (GtkListItemMana
                                                                  GtkWidget              *widget);
 G_DEFINE_TYPE (GtkListItemManager, gtk_list_item_manager, G_TYPE_OBJECT)
 
+static GtkWidget *
+gtk_list_item_manager_default_create (gpointer user_data)
+{
+  GtkListItemManager *self = user_data;
+
+  return gtk_list_item_widget_new (self->factory,
+                                   self->item_css_name,
+                                   self->item_role);
+}
+
+static void
+gtk_list_item_manager_default_update (GtkWidget *widget,
+                                      guint      position,
+                                      gpointer   item,
+                                      gboolean   selected,
+                                      gpointer   user_data)
+{
+  gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (widget), position, item, selected);
+}
+
+static gpointer
+gtk_list_item_manager_default_get_item (GtkWidget *widget)
+{
+  return gtk_list_item_widget_get_item (GTK_LIST_ITEM_WIDGET (widget));
+}
+
+static guint
+gtk_list_item_manager_default_get_position (GtkWidget *widget)
+{
+  return gtk_list_item_widget_get_position (GTK_LIST_ITEM_WIDGET (widget));
+}
+
+static const GtkListItemManagerWidgetFuncs default_widget_funcs = {
+  gtk_list_item_manager_default_create,
+  gtk_list_item_manager_default_update,
+  gtk_list_item_manager_default_get_item,
+  gtk_list_item_manager_default_get_position
+};
+
+#define widget_create(self) \
+  ((self)->widget_funcs->create ((self)->widget_funcs_data))
+#define widget_update(self, widget, position, item, selected) \
+  ((self)->widget_funcs->update ((widget), (position), (item), (selected), (self)->widget_funcs_data))
+#define widget_get_item(self, widget) \
+  ((self)->widget_funcs->get_item (widget))
+#define widget_get_position(self, widget) \
+  ((self)->widget_funcs->get_position (widget))
+
 void
 gtk_list_item_manager_augment_node (GtkRbTree *tree,
                                     gpointer   node_augment,
@@ -129,6 +188,8 @@ gtk_list_item_manager_new_for_size (GtkWidget            *widget,
   self->widget = widget;
   self->item_css_name = g_intern_string (item_css_name);
   self->item_role = item_role;
+  self->widget_funcs = &default_widget_funcs;
+  self->widget_funcs_data = self;
 
   self->items = gtk_rb_tree_new_for_size (element_size,
                                           augment_size,
@@ -597,7 +658,7 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
       if (tracker->widget == NULL)
         continue;
 
-      if (g_hash_table_lookup (change, gtk_list_item_widget_get_item (tracker->widget)))
+      if (g_hash_table_lookup (change, widget_get_item (self, tracker->widget)))
         break;
     }
 
@@ -680,7 +741,7 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
         }
       else if (tracker->position >= position)
         {
-          if (g_hash_table_lookup (change, gtk_list_item_widget_get_item (tracker->widget)))
+          if (g_hash_table_lookup (change, widget_get_item (self, tracker->widget)))
             {
               /* The item is gone. Guess a good new position */
               tracker->position = position + (tracker->position - position) * added / removed;
@@ -698,7 +759,7 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
               /* item was put in its right place in the expensive loop above,
                * and we updated its position while at it. So grab it from there.
                */
-              tracker->position = gtk_list_item_widget_get_position (tracker->widget);
+              tracker->position = widget_get_position (self, tracker->widget);
             }
         }
       else
@@ -725,7 +786,7 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
       item = gtk_list_item_manager_get_nth (self, tracker->position, NULL);
       g_assert (item != NULL);
       g_assert (item->widget);
-      tracker->widget = GTK_LIST_ITEM_WIDGET (item->widget);
+      tracker->widget = item->widget;
     }
 
   g_hash_table_unref (change);
@@ -787,12 +848,22 @@ gtk_list_item_manager_clear_model (GtkListItemManager *self)
   g_clear_object (&self->model);
 }
 
+static void
+gtk_list_item_manager_clear_pool (GtkListItemManager *self)
+{
+  GtkWidget *widget;
+
+  while ((widget = g_queue_pop_head (&self->pool)))
+    gtk_widget_unparent (widget);
+}
+
 static void
 gtk_list_item_manager_dispose (GObject *object)
 {
   GtkListItemManager *self = GTK_LIST_ITEM_MANAGER (object);
 
   gtk_list_item_manager_clear_model (self);
+  gtk_list_item_manager_clear_pool (self);
 
   g_clear_object (&self->factory);
 
@@ -829,6 +900,8 @@ gtk_list_item_manager_set_factory (GtkListItemManager *self,
 
   n_items = self->model ? g_list_model_get_n_items (G_LIST_MODEL (self->model)) : 0;
   gtk_list_item_manager_remove_items (self, NULL, 0, n_items);
+  /* pooled widgets were set up by the old factory */
+  gtk_list_item_manager_clear_pool (self);
 
   g_set_object (&self->factory, factory);
 
@@ -846,7 +919,43 @@ gtk_list_item_manager_set_factory (GtkListItemManager *self,
 
       item = gtk_list_item_manager_get_nth (self, tracker->position, NULL);
       g_assert (item);
-      tracker->widget = GTK_LIST_ITEM_WIDGET (item->widget);
+      tracker->widget = item->widget;
+    }
+}
+
+/*
+ * gtk_list_item_manager_set_widget_funcs:
+ * @self: a #GtkListItemManager
+ * @funcs: (nullable): the functions to manage widgets with or %NULL
+ *     for the default #GtkListItemWidgets
+ * @user_data: data passed to @funcs
+ *
+ * Makes @self create and bind widgets with @funcs, so widgets other
+ * than the ones of #GtkListView and #GtkGridView can use it to only
+ * keep widgets for the items they show.
+ *
+ * This must be called before a model is set.
+ **/
+void
+gtk_list_item_manager_set_widget_funcs (GtkListItemManager                  *self,
+                                        const GtkListItemManagerWidgetFuncs *funcs,
+                                        gpointer                             user_data)
+{
+  g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
+  g_return_if_fail (self->model == NULL);
+
+  /* pooled widgets were created by the old functions */
+  gtk_list_item_manager_clear_pool (self);
+
+  if (funcs)
+    {
+      self->widget_funcs = funcs;
+      self->widget_funcs_data = user_data;
+    }
+  else
+    {
+      self->widget_funcs = &default_widget_funcs;
+      self->widget_funcs_data = self;
     }
 }
 
@@ -925,15 +1034,22 @@ gtk_list_item_manager_acquire_list_item (GtkListItemManager *self,
   g_return_val_if_fail (GTK_IS_LIST_ITEM_MANAGER (self), NULL);
   g_return_val_if_fail (prev_sibling == NULL || GTK_IS_WIDGET (prev_sibling), NULL);
 
-  result = gtk_list_item_widget_new (self->factory,
-                                     self->item_css_name,
-                                     self->item_role);
+  result = g_queue_pop_head (&self->pool);
+  if (result)
+    {
+      gtk_widget_set_child_visible (result, TRUE);
+    }
+  else
+    {
+      result = widget_create (self);
+    }
 
-  gtk_list_item_widget_set_single_click_activate (GTK_LIST_ITEM_WIDGET (result), self->single_click_activate);
+  if (GTK_IS_LIST_ITEM_WIDGET (result))
+    gtk_list_item_widget_set_single_click_activate (GTK_LIST_ITEM_WIDGET (result), self->single_click_activate);
 
   item = g_list_model_get_item (G_LIST_MODEL (self->model), position);
   selected = gtk_selection_model_is_selected (self->model, position);
-  gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (result), position, item, selected);
+  widget_update (self, result, position, item, selected);
   g_object_unref (item);
   gtk_widget_insert_after (result, self->widget, prev_sibling);
 
@@ -971,11 +1087,11 @@ gtk_list_item_manager_try_reacquire_list_item (GtkListItemManager *self,
   item = g_list_model_get_item (G_LIST_MODEL (self->model), position);
   if (g_hash_table_steal_extended (change, item, NULL, (gpointer *) &result))
     {
-      GtkListItemWidget *list_item = GTK_LIST_ITEM_WIDGET (result);
-      gtk_list_item_widget_update (list_item,
-                                   position,
-                                   gtk_list_item_widget_get_item (list_item),
-                                   gtk_selection_model_is_selected (self->model, position));
+      widget_update (self,
+                     result,
+                     position,
+                     widget_get_item (self, result),
+                     gtk_selection_model_is_selected (self->model, position));
       gtk_widget_insert_after (result, self->widget, prev_sibling);
       /* XXX: Should we let the listview do this? */
       gtk_widget_queue_resize (result);
@@ -1013,10 +1129,7 @@ gtk_list_item_manager_move_list_item (GtkListItemManager     *self,
 
   item = g_list_model_get_item (G_LIST_MODEL (self->model), position);
   selected = gtk_selection_model_is_selected (self->model, position);
-  gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (list_item),
-                               position,
-                               item,
-                               selected);
+  widget_update (self, list_item, position, item, selected);
   gtk_widget_insert_after (list_item, _gtk_widget_get_parent (list_item), prev_sibling);
   g_object_unref (item);
 }
@@ -1035,17 +1148,17 @@ gtk_list_item_manager_update_list_item (GtkListItemManager *self,
                                         GtkWidget          *item,
                                         guint               position)
 {
-  GtkListItemWidget *list_item = GTK_LIST_ITEM_WIDGET (item);
   gboolean selected;
 
   g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
-  g_return_if_fail (GTK_IS_LIST_ITEM_WIDGET (item));
+  g_return_if_fail (GTK_IS_WIDGET (item));
 
   selected = gtk_selection_model_is_selected (self->model, position);
-  gtk_list_item_widget_update (list_item,
-                               position,
-                               gtk_list_item_widget_get_item (list_item),
-                               selected);
+  widget_update (self,
+                 item,
+                 position,
+                 widget_get_item (self, item),
+                 selected);
 }
 
 /*
@@ -1065,11 +1178,11 @@ gtk_list_item_manager_release_list_item (GtkListItemManager *self,
                                          GtkWidget          *item)
 {
   g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
-  g_return_if_fail (GTK_IS_LIST_ITEM_WIDGET (item));
+  g_return_if_fail (GTK_IS_WIDGET (item));
 
   if (change != NULL)
     {
-      if (!g_hash_table_replace (change, gtk_list_item_widget_get_item (GTK_LIST_ITEM_WIDGET (item)), item))
+      if (!g_hash_table_replace (change, widget_get_item (self, item), item))
         {
           g_warning ("FIXME: Handle the same item multiple times in the list.\nLars says this totally should not happen, but here we are.");
         }
@@ -1077,6 +1190,16 @@ gtk_list_item_manager_release_list_item (GtkListItemManager *self,
       return;
     }
 
+  if (g_queue_get_length (&self->pool) < GTK_LIST_ITEM_MANAGER_MAX_POOLED &&
+      _gtk_widget_get_parent (item) == self->widget)
+    {
+      /* unbind, but keep it set up */
+      widget_update (self, item, GTK_INVALID_LIST_POSITION, NULL, FALSE);
+      gtk_widget_set_child_visible (item, FALSE);
+      g_queue_push_tail (&self->pool, item);
+      return;
+    }
+
   gtk_widget_unparent (item);
 }
 
@@ -1094,7 +1217,7 @@ gtk_list_item_manager_set_single_click_activate (GtkListItemManager *self,
        item != NULL;
        item = gtk_rb_tree_node_get_next (item))
     {
-      if (item->widget)
+      if (item->widget && GTK_IS_LIST_ITEM_WIDGET (item->widget))
         gtk_list_item_widget_set_single_click_activate (GTK_LIST_ITEM_WIDGET (item->widget), single_click_activate);
     }
 }
@@ -1161,11 +1284,77 @@ gtk_list_item_tracker_set_position (GtkListItemManager *self,
   tracker->n_before = n_before;
   tracker->n_after = n_after;
 
+  /* The widget gets looked up when thawing */
+  if (self->trackers_frozen)
+    return;
+
   gtk_list_item_manager_ensure_items (self, NULL, G_MAXUINT);
 
   item = gtk_list_item_manager_get_nth (self, position, NULL);
   if (item)
-    tracker->widget = GTK_LIST_ITEM_WIDGET (item->widget);
+    tracker->widget = item->widget;
+
+  gtk_widget_queue_resize (self->widget);
+}
+
+/*
+ * gtk_list_item_manager_freeze_trackers:
+ * @self: a #GtkListItemManager
+ *
+ * Delays creating and releasing widgets for trackers that are moved
+ * until gtk_list_item_manager_thaw_trackers(). This way, items that
+ * stay tracked by one of several moved trackers keep their widgets.
+ **/
+void
+gtk_list_item_manager_freeze_trackers (GtkListItemManager *self)
+{
+  self->trackers_frozen++;
+}
+
+void
+gtk_list_item_manager_thaw_trackers (GtkListItemManager *self)
+{
+  GSList *l;
+
+  g_return_if_fail (self->trackers_frozen > 0);
+
+  self->trackers_frozen--;
+  if (self->trackers_frozen)
+    return;
+
+  gtk_list_item_manager_ensure_items (self, NULL, G_MAXUINT);
+
+  for (l = self->trackers; l; l = l->next)
+    {
+      GtkListItemTracker *tracker = l->data;
+      GtkListItemManagerItem *item;
+
+      if (tracker->widget != NULL ||
+          tracker->position == GTK_INVALID_LIST_POSITION)
+        continue;
+
+      item = gtk_list_item_manager_get_nth (self, tracker->position, NULL);
+      if (item)
+        tracker->widget = item->widget;
+    }
+
+  gtk_widget_queue_resize (self->widget);
+}
+
+/* Stops @tracker from keeping any widgets around */
+void
+gtk_list_item_tracker_clear (GtkListItemManager *self,
+                             GtkListItemTracker *tracker)
+{
+  if (tracker->position == GTK_INVALID_LIST_POSITION)
+    return;
+
+  gtk_list_item_tracker_unset_position (self, tracker);
+
+  if (self->trackers_frozen)
+    return;
+
+  gtk_list_item_manager_ensure_items (self, NULL, G_MAXUINT);
 
   gtk_widget_queue_resize (self->widget);
 }
@@ -1176,3 +1365,20 @@ gtk_list_item_tracker_get_position (GtkListItemManager *self,
 {
   return tracker->position;
 }
+
+/* Returns the items that @tracker keeps widgets for */
+gboolean
+gtk_list_item_tracker_get_range (GtkListItemManager *self,
+                                 GtkListItemTracker *tracker,
+                                 guint              *out_start,
+                                 guint              *out_n_items)
+{
+  if (self->model == NULL)
+    return FALSE;
+
+  return gtk_list_item_tracker_query_range (self,
+                                            tracker,
+                                            g_list_model_get_n_items (G_LIST_MODEL (self->model)),
+                                            out_start,
+                                            out_n_items);
+}
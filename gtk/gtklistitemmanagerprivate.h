@@ -42,6 +42,7 @@ typedef struct _GtkListItemManagerClass GtkListItemManagerClass;
 typedef struct _GtkListItemManagerItem GtkListItemManagerItem; /* sorry */
 typedef struct _GtkListItemManagerItemAugment GtkListItemManagerItemAugment;
 typedef struct _GtkListItemTracker GtkListItemTracker;
+typedef struct _GtkListItemManagerWidgetFuncs GtkListItemManagerWidgetFuncs;
 
 struct _GtkListItemManagerItem
 {
@@ -54,6 +55,22 @@ struct _GtkListItemManagerItemAugment
   guint n_items;
 };
 
+/* How the manager creates and binds the widgets for its items.
+ * update() gets called with GTK_INVALID_LIST_POSITION and a %NULL
+ * item when a widget is put into the pool for reuse.
+ */
+struct _GtkListItemManagerWidgetFuncs
+{
+  GtkWidget *           (* create)                              (gpointer                user_data);
+  void                  (* update)                              (GtkWidget              *widget,
+                                                                 guint                   position,
+                                                                 gpointer                item,
+                                                                 gboolean                selected,
+                                                                 gpointer                user_data);
+  gpointer              (* get_item)                            (GtkWidget              *widget);
+  guint                 (* get_position)                        (GtkWidget              *widget);
+};
+
 
 GType                   gtk_list_item_manager_get_type          (void) G_GNUC_CONST;
 
@@ -84,6 +101,9 @@ gpointer                gtk_list_item_manager_get_item_augment  (GtkListItemMana
 void                    gtk_list_item_manager_set_factory       (GtkListItemManager     *self,
                                                                  GtkListItemFactory     *factory);
 GtkListItemFactory *    gtk_list_item_manager_get_factory       (GtkListItemManager     *self);
+void                    gtk_list_item_manager_set_widget_funcs  (GtkListItemManager     *self,
+                                                                 const GtkListItemManagerWidgetFuncs *funcs,
+                                                                 gpointer                user_data);
 void                    gtk_list_item_manager_set_model         (GtkListItemManager     *self,
                                                                  GtkSelectionModel      *model);
 GtkSelectionModel *     gtk_list_item_manager_get_model         (GtkListItemManager     *self);
@@ -103,8 +123,16 @@ void                    gtk_list_item_tracker_set_position      (GtkListItemMana
                                                                  guint                   position,
                                                                  guint                   n_before,
                                                                  guint                   n_after);
+void                    gtk_list_item_tracker_clear             (GtkListItemManager     *self,
+                                                                 GtkListItemTracker     *tracker);
 guint                   gtk_list_item_tracker_get_position      (GtkListItemManager     *self,
                                                                  GtkListItemTracker     *tracker);
+gboolean                gtk_list_item_tracker_get_range         (GtkListItemManager     *self,
+                                                                 GtkListItemTracker     *tracker,
+                                                                 guint                  *out_start,
+                                                                 guint                  *out_n_items);
+void                    gtk_list_item_manager_freeze_trackers   (GtkListItemManager     *self);
+void                    gtk_list_item_manager_thaw_trackers     (GtkListItemManager     *self);
 
 
 G_END_DECLS
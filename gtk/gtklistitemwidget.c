@@ -311,6 +311,7 @@ gtk_list_item_widget_class_init (GtkListItemWidgetClass *klass)
 
   /* This gets overwritten by gtk_list_item_widget_new() but better safe than sorry */
   gtk_widget_class_set_css_name (widget_class, I_("row"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
 }
 
@@ -425,6 +426,7 @@ gtk_list_item_widget_init (GtkListItemWidget *self)
   GtkGesture *gesture;
 
   gtk_widget_set_focusable (GTK_WIDGET (self), TRUE);
+  gtk_widget_set_render_boundary (GTK_WIDGET (self), TRUE);
 
   gesture = gtk_gesture_click_new ();
   gtk_event_controller_set_propagation_phase (GTK_EVENT_CONTROLLER (gesture),
@@ -670,20 +670,16 @@ gtk_list_store_get_value (GtkTreeModel *tree_model,
   GtkListStore *list_store = GTK_LIST_STORE (tree_model);
   GtkListStorePrivate *priv = list_store->priv;
   GtkTreeDataList *list;
-  int tmp_column = column;
 
   g_return_if_fail (column < priv->n_columns);
   g_return_if_fail (iter_is_valid (iter, list_store));
 		    
   list = g_sequence_get (iter->user_data);
 
-  while (tmp_column-- > 0 && list)
-    list = list->next;
-
   if (list == NULL)
     g_value_init (value, priv->column_headers[column]);
   else
-    _gtk_tree_data_list_node_to_value (list,
+    _gtk_tree_data_list_node_to_value (&list[column],
 				       priv->column_headers[column],
 				       value);
 }
@@ -820,7 +816,6 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
 {
   GtkListStorePrivate *priv = list_store->priv;
   GtkTreeDataList *list;
-  GtkTreeDataList *prev;
   int old_column = column;
   GValue real_value = G_VALUE_INIT;
   gboolean converted = FALSE;
@@ -850,48 +845,15 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
       converted = TRUE;
     }
 
-  prev = list = g_sequence_get (iter->user_data);
-
-  while (list != NULL)
-    {
-      if (column == 0)
-	{
-	  if (converted)
-	    _gtk_tree_data_list_value_to_node (list, &real_value);
-	  else
-	    _gtk_tree_data_list_value_to_node (list, value);
-	  retval = TRUE;
-	  if (converted)
-	    g_value_unset (&real_value);
-         if (sort && GTK_LIST_STORE_IS_SORTED (list_store))
-            gtk_list_store_sort_iter_changed (list_store, iter, old_column);
-	  return retval;
-	}
-
-      column--;
-      prev = list;
-      list = list->next;
-    }
-
-  if (g_sequence_get (iter->user_data) == NULL)
+  list = g_sequence_get (iter->user_data);
+  if (list == NULL)
     {
-      list = _gtk_tree_data_list_alloc();
+      list = _gtk_tree_data_list_alloc (priv->n_columns);
       g_sequence_set (iter->user_data, list);
-      list->next = NULL;
-    }
-  else
-    {
-      list = prev->next = _gtk_tree_data_list_alloc ();
-      list->next = NULL;
     }
 
-  while (column != 0)
-    {
-      list->next = _gtk_tree_data_list_alloc ();
-      list = list->next;
-      list->next = NULL;
-      column --;
-    }
+  /* The cells of a row are allocated in one block */
+  list = &list[column];
 
   if (converted)
     _gtk_tree_data_list_value_to_node (list, &real_value);
@@ -1572,32 +1534,12 @@ gtk_list_store_drag_data_received (GtkTreeDragDest *drag_dest,
       if (retval)
         {
           GtkTreeDataList *dl = g_sequence_get (src_iter.user_data);
-          GtkTreeDataList *copy_head = NULL;
-          GtkTreeDataList *copy_prev = NULL;
-          GtkTreeDataList *copy_iter = NULL;
 	  GtkTreePath *path;
-          int col;
-
-          col = 0;
-          while (dl)
-            {
-              copy_iter = _gtk_tree_data_list_node_copy (dl,
-                                                         priv->column_headers[col]);
-
-              if (copy_head == NULL)
-                copy_head = copy_iter;
-
-              if (copy_prev)
-                copy_prev->next = copy_iter;
-
-              copy_prev = copy_iter;
-
-              dl = dl->next;
-              ++col;
-            }
 
 	  dest_iter.stamp = priv->stamp;
-          g_sequence_set (dest_iter.user_data, copy_head);
+          if (dl)
+            g_sequence_set (dest_iter.user_data,
+                            _gtk_tree_data_list_copy (dl, priv->n_columns, priv->column_headers));
 
 	  path = gtk_list_store_get_path (tree_model, &dest_iter);
 	  gtk_tree_model_row_changed (tree_model, path, &dest_iter);
@@ -149,6 +149,7 @@ struct _ListRow
 {
   GtkListItemManagerItem parent;
   guint height; /* per row */
+  guint measured : 1; /* height is part of the estimate */
 };
 
 struct _ListRowAugment
@@ -165,6 +166,7 @@ enum
   PROP_SHOW_SEPARATORS,
   PROP_SINGLE_CLICK_ACTIVATE,
   PROP_ENABLE_RUBBERBAND,
+  PROP_PREFETCH,
 
   N_PROPS
 };
@@ -198,7 +200,8 @@ dump (GtkListView *self)
       g_print ("  %4u%s (%upx)\n", row->parent.n_items, row->parent.widget ? " (widget)" : "", row->height);
     }
 
-  g_print ("  => %u widgets in %u list rows\n", n_widgets, n_list_rows);
+  g_print ("  => %u widgets (%u prefetched) in %u list rows\n",
+           n_widgets, gtk_list_base_get_n_prefetched (GTK_LIST_BASE (self)), n_list_rows);
 }
 
 static void
@@ -471,6 +474,54 @@ gtk_list_view_get_unknown_row_height (GtkListView *self,
   return g_array_index (heights, int, heights->len / 2);
 }
 
+/* Sum up this many row heights before weighting older ones less */
+#define GTK_LIST_VIEW_MAX_ROW_HEIGHTS 1024
+
+static void
+gtk_list_view_reset_row_height_estimate (GtkListView *self)
+{
+  ListRow *row;
+
+  self->row_height_sum = 0;
+  self->n_row_heights = 0;
+
+  for (row = gtk_list_item_manager_get_first (self->item_manager);
+       row != NULL;
+       row = gtk_rb_tree_node_get_next (row))
+    row->measured = FALSE;
+}
+
+static void
+gtk_list_view_add_row_height (GtkListView *self,
+                              ListRow     *row)
+{
+  if (row->measured)
+    return;
+
+  row->measured = TRUE;
+
+  if (self->n_row_heights >= GTK_LIST_VIEW_MAX_ROW_HEIGHTS)
+    {
+      self->row_height_sum /= 2;
+      self->n_row_heights /= 2;
+    }
+
+  self->row_height_sum += row->height;
+  self->n_row_heights++;
+}
+
+/* Unlike the median of the currently visible rows, this doesn't change
+ * with every scroll and so keeps the scrollbar steady. */
+static guint
+gtk_list_view_get_estimated_row_height (GtkListView *self,
+                                        GArray      *heights)
+{
+  if (self->n_row_heights == 0)
+    return gtk_list_view_get_unknown_row_height (self, heights);
+
+  return (self->row_height_sum + self->n_row_heights / 2) / self->n_row_heights;
+}
+
 static void
 gtk_list_view_measure_across (GtkWidget      *widget,
                               GtkOrientation  orientation,
@@ -584,7 +635,7 @@ gtk_list_view_size_allocate (GtkWidget *widget,
   GtkListView *self = GTK_LIST_VIEW (widget);
   ListRow *row;
   GArray *heights;
-  int min, nat, row_height;
+  int min, nat, row_height, list_width;
   int x, y;
   GtkOrientation orientation, opposite_orientation;
   GtkScrollablePolicy scroll_policy;
@@ -601,11 +652,17 @@ gtk_list_view_size_allocate (GtkWidget *widget,
   gtk_widget_measure (widget, opposite_orientation,
                       -1,
                       &min, &nat, NULL, NULL);
-  self->list_width = orientation == GTK_ORIENTATION_VERTICAL ? width : height;
+  list_width = orientation == GTK_ORIENTATION_VERTICAL ? width : height;
   if (scroll_policy == GTK_SCROLL_MINIMUM)
-    self->list_width = MAX (min, self->list_width);
+    list_width = MAX (min, list_width);
   else
-    self->list_width = MAX (nat, self->list_width);
+    list_width = MAX (nat, list_width);
+  /* row heights depend on the width */
+  if (list_width != self->list_width)
+    {
+      self->list_width = list_width;
+      gtk_list_view_reset_row_height_estimate (self);
+    }
 
   /* step 2: determine height of known list items */
   heights = g_array_new (FALSE, FALSE, sizeof (int));
@@ -629,11 +686,12 @@ gtk_list_view_size_allocate (GtkWidget *widget,
           row->height = row_height;
           gtk_rb_tree_node_mark_dirty (row);
         }
+      gtk_list_view_add_row_height (self, row);
       g_array_append_val (heights, row_height);
     }
 
   /* step 3: determine height of unknown items */
-  row_height = gtk_list_view_get_unknown_row_height (self, heights);
+  row_height = gtk_list_view_get_estimated_row_height (self, heights);
   g_array_free (heights, TRUE);
 
   for (row = gtk_list_item_manager_get_first (self->item_manager);
@@ -643,6 +701,8 @@ gtk_list_view_size_allocate (GtkWidget *widget,
       if (row->parent.widget)
         continue;
 
+      /* count its height again when it gets a widget again */
+      row->measured = FALSE;
       if (row->height != row_height)
         {
           row->height = row_height;
@@ -722,6 +782,10 @@ gtk_list_view_get_property (GObject    *object,
       g_value_set_boolean (value, gtk_list_base_get_enable_rubberband (GTK_LIST_BASE (self)));
       break;
 
+    case PROP_PREFETCH:
+      g_value_set_uint (value, gtk_list_base_get_prefetch (GTK_LIST_BASE (self)));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -758,6 +822,10 @@ gtk_list_view_set_property (GObject      *object,
       gtk_list_view_set_enable_rubberband (self, g_value_get_boolean (value));
       break;
 
+    case PROP_PREFETCH:
+      gtk_list_view_set_prefetch (self, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -868,6 +936,18 @@ gtk_list_view_class_init (GtkListViewClass *klass)
                           FALSE,
                           G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkListView:prefetch:
+   *
+   * Number of items ahead of the visible ones to create widgets for
+   */
+  properties[PROP_PREFETCH] =
+    g_param_spec_uint ("prefetch",
+                       P_("Prefetch"),
+                       P_("Number of items ahead of the visible ones to create widgets for"),
+                       0, G_MAXUINT, 0,
+                       G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, N_PROPS, properties);
 
   /**
@@ -1034,6 +1114,7 @@ gtk_list_view_set_factory (GtkListView        *self,
     return;
 
   gtk_list_item_manager_set_factory (self->item_manager, factory);
+  gtk_list_view_reset_row_height_estimate (self);
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_FACTORY]);
 }
@@ -1157,3 +1238,45 @@ gtk_list_view_get_enable_rubberband (GtkListView *self)
 
   return gtk_list_base_get_enable_rubberband (GTK_LIST_BASE (self));
 }
+
+/**
+ * gtk_list_view_set_prefetch:
+ * @self: a #GtkListView
+ * @n_items: the number of items to prefetch
+ *
+ * Sets how many items beyond the visible ones should get widgets,
+ * in the direction @self is being scrolled.
+ *
+ * Those items are bound before they become visible, so widgets that
+ * load their contents asynchronously, like thumbnails, can start
+ * doing so early.
+ */
+void
+gtk_list_view_set_prefetch (GtkListView *self,
+                            guint        n_items)
+{
+  g_return_if_fail (GTK_IS_LIST_VIEW (self));
+
+  if (n_items == gtk_list_base_get_prefetch (GTK_LIST_BASE (self)))
+    return;
+
+  gtk_list_base_set_prefetch (GTK_LIST_BASE (self), n_items);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PREFETCH]);
+}
+
+/**
+ * gtk_list_view_get_prefetch:
+ * @self: a #GtkListView
+ *
+ * Returns how many items beyond the visible ones get widgets.
+ *
+ * Returns: the number of prefetched items
+ */
+guint
+gtk_list_view_get_prefetch (GtkListView *self)
+{
+  g_return_val_if_fail (GTK_IS_LIST_VIEW (self), 0);
+
+  return gtk_list_base_get_prefetch (GTK_LIST_BASE (self));
+}
@@ -81,6 +81,12 @@ void            gtk_list_view_set_enable_rubberband             (GtkListView
 GDK_AVAILABLE_IN_ALL
 gboolean        gtk_list_view_get_enable_rubberband             (GtkListView            *self);
 
+GDK_AVAILABLE_IN_ALL
+void            gtk_list_view_set_prefetch                      (GtkListView            *self,
+                                                                 guint                   n_items);
+GDK_AVAILABLE_IN_ALL
+guint           gtk_list_view_get_prefetch                      (GtkListView            *self);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkListView, g_object_unref)
 
 G_END_DECLS
@@ -33,6 +33,11 @@ struct _GtkListView
   gboolean show_separators;
 
   int list_width;
+
+  /* heights of rows when they were first allocated, the average is
+   * used as the height of rows that have no widget */
+  guint64 row_height_sum;
+  guint n_row_heights;
 };
 
 struct _GtkListViewClass
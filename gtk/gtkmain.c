@@ -93,6 +93,9 @@
 
 #include "gdk/gdk.h"
 #include "gdk/gdk-private.h"
+#include "gdk/gdktelemetryprivate.h"
+#include "gdk/gdkparallelprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 #include "gsk/gskprivate.h"
 #include "gsk/gskrendernodeprivate.h"
 #include "gtknative.h"
@@ -244,6 +247,16 @@ gtk_simulate_touchscreen (void)
   return (gtk_get_debug_flags () & GTK_DEBUG_TOUCHSCREEN) != 0;
 }
 
+/* The number of threads to split work over with gdk_parallel_run() */
+guint
+gtk_get_n_threads (void)
+{
+  if (gtk_get_debug_flags () & GTK_DEBUG_NO_THREADS)
+    return 1;
+
+  return gdk_parallel_get_n_threads ();
+}
+
 #ifdef G_ENABLE_DEBUG
 static const GdkDebugKey gtk_debug_keys[] = {
   { "keybindings", GTK_DEBUG_KEYBINDINGS, "Information about keyboard shortcuts" },
@@ -264,6 +277,8 @@ static const GdkDebugKey gtk_debug_keys[] = {
   { "touchscreen", GTK_DEBUG_TOUCHSCREEN, "Pretend the pointer is a touchscreen" },
   { "snapshot", GTK_DEBUG_SNAPSHOT, "Generate debug render nodes" },
   { "accessibility", GTK_DEBUG_A11Y, "Information about accessibility state changes" },
+  { "telemetry", GTK_DEBUG_TELEMETRY, "Print recent frame timings on SIGUSR2" },
+  { "no-threads", GTK_DEBUG_NO_THREADS, "Do not split work over threads" },
 };
 #endif /* G_ENABLE_DEBUG */
 
@@ -535,12 +550,15 @@ do_pre_parse_initialization (void)
 {
   const char *env_string;
   double slowdown;
+  gint64 before G_GNUC_UNUSED;
 
   if (pre_initialized)
     return;
 
   pre_initialized = TRUE;
 
+  before = GDK_PROFILER_CURRENT_TIME;
+
   if (_gtk_module_has_mixed_deps (NULL))
     g_error ("GTK 2/3 symbols detected. Using GTK 2/3 and GTK 4 in the same process is not supported");
 
@@ -551,6 +569,9 @@ do_pre_parse_initialization (void)
                                               gtk_debug_keys,
                                               G_N_ELEMENTS (gtk_debug_keys));
   any_display_debug_flags_set = debug_flags[0].flags > 0;
+
+  if (debug_flags[0].flags & GTK_DEBUG_TELEMETRY)
+    gdk_telemetry_install_dump_signal ();
 #else
   if (g_getenv ("GTK_DEBUG"))
     g_warning ("GTK_DEBUG set but ignored because GTK isn't built with G_ENABLE_DEBUG");
@@ -563,8 +584,12 @@ do_pre_parse_initialization (void)
       _gtk_set_slowdown (slowdown);
     }
 
+  gdk_profiler_end_mark (before, "gtk init", "pre-parse");
+
   /* Trigger fontconfig initialization early */
+  before = GDK_PROFILER_CURRENT_TIME;
   pango_cairo_font_map_get_default ();
+  gdk_profiler_end_mark (before, "gtk init", "fonts");
 }
 
 static void
@@ -592,10 +617,13 @@ static void
 do_post_parse_initialization (void)
 {
   GdkDisplayManager *display_manager;
+  gint64 before G_GNUC_UNUSED;
 
   if (gtk_initialized)
     return;
 
+  before = GDK_PROFILER_CURRENT_TIME;
+
   gettext_initialization ();
 
 #ifdef SIGPIPE
@@ -611,11 +639,11 @@ do_post_parse_initialization (void)
 
   gtk_initialized = TRUE;
 
-#ifdef G_OS_UNIX
-  gtk_print_backends_init ();
-#endif
-  gtk_im_modules_init ();
-  gtk_media_file_extension_init ();
+  /* Print backends, input methods and media backends are
+   * initialized when they are first used, to keep startup fast.
+   */
+
+  gdk_profiler_end_mark (before, "gtk init", "post-parse");
 
   display_manager = gdk_display_manager_get ();
   if (gdk_display_manager_get_default_display (display_manager) != NULL)
@@ -648,6 +676,7 @@ gboolean
 gtk_init_check (void)
 {
   gboolean ret;
+  gint64 before G_GNUC_UNUSED;
 
   if (gtk_initialized)
     return TRUE;
@@ -660,7 +689,9 @@ gtk_init_check (void)
   do_pre_parse_initialization ();
   do_post_parse_initialization ();
 
+  before = GDK_PROFILER_CURRENT_TIME;
   ret = gdk_display_open_default () != NULL;
+  gdk_profiler_end_mark (before, "gtk init", "display");
 
   if (ret && (gtk_get_debug_flags () & GTK_DEBUG_INTERACTIVE))
     gtk_window_set_interactive_debugging (TRUE);
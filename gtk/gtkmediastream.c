@@ -42,9 +42,47 @@
  * gtk_media_stream_seek_failed(),
  * gtk_media_stream_gerror(),
  * gtk_media_stream_error(),
- * gtk_media_stream_error_valist().
+ * gtk_media_stream_error_valist(),
+ * gtk_media_stream_queue_frame(),
+ * gtk_media_stream_clear_frames().
+ *
+ * # Frame queue
+ *
+ * Implementations can hand decoded frames to the stream ahead of time
+ * with gtk_media_stream_queue_frame(), each tagged with the monotonic
+ * time it should appear on screen. The stream then acts as a paintable
+ * showing the current frame, see gtk_media_stream_get_current_frame().
+ *
+ * Whoever displays the stream should call gtk_media_stream_select_frame()
+ * once per frame with the time the frame is expected to be presented,
+ * #GtkVideo does that from its frame clock. This way the frame that is
+ * shown is the one belonging to the time it is seen, instead of
+ * whatever happened to be decoded last, which avoids judder when the
+ * video and display rates do not match. Frames that are skipped and
+ * frames that stay on screen for too long are counted, see
+ * gtk_media_stream_get_n_dropped_frames() and
+ * gtk_media_stream_get_n_duplicated_frames().
+ *
+ * If nobody selects frames, the stream switches frames on its own when
+ * they are due.
  */
 
+/* Frames queued beyond this are dropped from the front */
+#define MAX_QUEUED_FRAMES 8
+
+/* If no frame has been selected for this long (in µs), the stream
+ * assumes that nobody selects frames and does it on its own.
+ */
+#define SELECT_TIMEOUT (100 * 1000)
+
+typedef struct _GtkMediaStreamFrame GtkMediaStreamFrame;
+
+struct _GtkMediaStreamFrame
+{
+  GdkPaintable *paintable;
+  gint64 presentation_time;
+};
+
 typedef struct _GtkMediaStreamPrivate GtkMediaStreamPrivate;
 
 struct _GtkMediaStreamPrivate
@@ -54,6 +92,14 @@ struct _GtkMediaStreamPrivate
   GError *error;
   double volume;
 
+  GQueue frames;                /* of GtkMediaStreamFrame, by presentation time */
+  GtkMediaStreamFrame current_frame;
+  gint64 frame_interval;        /* between the last two frames shown */
+  gint64 last_select_time;
+  guint select_source;
+  guint n_dropped_frames;
+  guint n_duplicated_frames;
+
   guint has_audio : 1;
   guint has_video : 1;
   guint playing : 1;
@@ -86,26 +132,87 @@ enum {
 
 static GParamSpec *properties[N_PROPS] = { NULL, };
 
+static void gtk_media_stream_paintable_init (GdkPaintableInterface *iface);
+
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GtkMediaStream, gtk_media_stream, G_TYPE_OBJECT,
+                                  G_IMPLEMENT_INTERFACE (GDK_TYPE_PAINTABLE,
+                                                         gtk_media_stream_paintable_init)
+                                  G_ADD_PRIVATE (GtkMediaStream))
+
 static void
 gtk_media_stream_paintable_snapshot (GdkPaintable *paintable,
                                      GdkSnapshot  *snapshot,
                                      double        width,
                                      double        height)
 {
+  GtkMediaStream *self = GTK_MEDIA_STREAM (paintable);
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  if (priv->current_frame.paintable)
+    gdk_paintable_snapshot (priv->current_frame.paintable, snapshot, width, height);
+}
+
+static GdkPaintable *
+gtk_media_stream_paintable_get_current_image (GdkPaintable *paintable)
+{
+  GtkMediaStream *self = GTK_MEDIA_STREAM (paintable);
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  if (priv->current_frame.paintable)
+    return gdk_paintable_get_current_image (priv->current_frame.paintable);
+
+  return gdk_paintable_new_empty (0, 0);
+}
+
+static int
+gtk_media_stream_paintable_get_intrinsic_width (GdkPaintable *paintable)
+{
+  GtkMediaStream *self = GTK_MEDIA_STREAM (paintable);
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  if (priv->current_frame.paintable)
+    return gdk_paintable_get_intrinsic_width (priv->current_frame.paintable);
+
+  return 0;
+}
+
+static int
+gtk_media_stream_paintable_get_intrinsic_height (GdkPaintable *paintable)
+{
+  GtkMediaStream *self = GTK_MEDIA_STREAM (paintable);
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  if (priv->current_frame.paintable)
+    return gdk_paintable_get_intrinsic_height (priv->current_frame.paintable);
+
+  return 0;
+}
+
+static double
+gtk_media_stream_paintable_get_intrinsic_aspect_ratio (GdkPaintable *paintable)
+{
+  GtkMediaStream *self = GTK_MEDIA_STREAM (paintable);
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  if (priv->current_frame.paintable)
+    return gdk_paintable_get_intrinsic_aspect_ratio (priv->current_frame.paintable);
+
+  return 0.0;
 }
 
 static void
 gtk_media_stream_paintable_init (GdkPaintableInterface *iface)
 {
-  /* We implement the behavior for "no video stream" here */
+  /* We implement the behavior for "no video stream" here,
+   * and for streams that use the frame queue.
+   */
   iface->snapshot = gtk_media_stream_paintable_snapshot;
+  iface->get_current_image = gtk_media_stream_paintable_get_current_image;
+  iface->get_intrinsic_width = gtk_media_stream_paintable_get_intrinsic_width;
+  iface->get_intrinsic_height = gtk_media_stream_paintable_get_intrinsic_height;
+  iface->get_intrinsic_aspect_ratio = gtk_media_stream_paintable_get_intrinsic_aspect_ratio;
 }
 
-G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GtkMediaStream, gtk_media_stream, G_TYPE_OBJECT,
-                                  G_IMPLEMENT_INTERFACE (GDK_TYPE_PAINTABLE,
-                                                         gtk_media_stream_paintable_init)
-                                  G_ADD_PRIVATE (GtkMediaStream))
-
 #define GTK_MEDIA_STREAM_WARN_NOT_IMPLEMENTED_METHOD(obj,method) \
   g_critical ("Media stream of type '%s' does not implement GtkMediaStream::" # method, G_OBJECT_TYPE_NAME (obj))
 
@@ -251,6 +358,13 @@ gtk_media_stream_get_property (GObject    *object,
     }
 }
 
+static void
+gtk_media_stream_frame_free (GtkMediaStreamFrame *frame)
+{
+  g_object_unref (frame->paintable);
+  g_slice_free (GtkMediaStreamFrame, frame);
+}
+
 static void
 gtk_media_stream_dispose (GObject *object)
 {
@@ -259,6 +373,10 @@ gtk_media_stream_dispose (GObject *object)
 
   g_clear_error (&priv->error);
 
+  g_clear_handle_id (&priv->select_source, g_source_remove);
+  g_queue_clear_full (&priv->frames, (GDestroyNotify) gtk_media_stream_frame_free);
+  g_clear_object (&priv->current_frame.paintable);
+
   G_OBJECT_CLASS (gtk_media_stream_parent_class)->dispose (object);
 }
 
@@ -456,6 +574,7 @@ gtk_media_stream_init (GtkMediaStream *self)
   GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
 
   priv->volume = 1.0;
+  g_queue_init (&priv->frames);
 }
 
 /**
@@ -1347,3 +1466,283 @@ gtk_media_stream_seek_failed (GtkMediaStream *self)
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SEEKING]);
 }
 
+
+static gboolean
+gtk_media_stream_select_cb (gpointer data);
+
+static void
+gtk_media_stream_schedule_select (GtkMediaStream *self)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+  GtkMediaStreamFrame *frame;
+  gint64 now, due_time;
+
+  if (priv->select_source != 0 || g_queue_is_empty (&priv->frames))
+    return;
+
+  now = g_get_monotonic_time ();
+
+  /* While somebody selects frames, only check back when they might
+   * have stopped doing so.
+   */
+  if (priv->last_select_time != 0 &&
+      now - priv->last_select_time < SELECT_TIMEOUT)
+    {
+      due_time = priv->last_select_time + SELECT_TIMEOUT;
+    }
+  else
+    {
+      frame = g_queue_peek_head (&priv->frames);
+      due_time = frame->presentation_time;
+    }
+
+  priv->select_source = g_timeout_add (due_time > now ? (due_time - now) / 1000 : 0,
+                                       gtk_media_stream_select_cb,
+                                       self);
+  g_source_set_name_by_id (priv->select_source, "[gtk] gtk_media_stream_select_cb");
+}
+
+static gboolean
+gtk_media_stream_advance (GtkMediaStream *self,
+                          gint64          presentation_time)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+  GtkMediaStreamFrame *frame, *next;
+  GdkPaintable *old;
+  gboolean size_changed;
+
+  frame = NULL;
+  while ((next = g_queue_peek_head (&priv->frames)) &&
+         next->presentation_time <= presentation_time)
+    {
+      g_queue_pop_head (&priv->frames);
+
+      /* Only the last frame that is due gets shown */
+      if (frame)
+        {
+          priv->n_dropped_frames++;
+          gtk_media_stream_frame_free (frame);
+        }
+      frame = next;
+    }
+
+  if (frame == NULL)
+    {
+      /* The next frame should be on screen by now, but the
+       * implementation did not deliver it in time.
+       */
+      if (priv->playing &&
+          priv->current_frame.paintable != NULL &&
+          priv->frame_interval > 0 &&
+          presentation_time >= priv->current_frame.presentation_time + priv->frame_interval)
+        priv->n_duplicated_frames++;
+
+      return FALSE;
+    }
+
+  old = priv->current_frame.paintable;
+
+  if (old != NULL)
+    priv->frame_interval = frame->presentation_time - priv->current_frame.presentation_time;
+
+  if (old == NULL ||
+      gdk_paintable_get_intrinsic_width (old) != gdk_paintable_get_intrinsic_width (frame->paintable) ||
+      gdk_paintable_get_intrinsic_height (old) != gdk_paintable_get_intrinsic_height (frame->paintable) ||
+      gdk_paintable_get_intrinsic_aspect_ratio (old) != gdk_paintable_get_intrinsic_aspect_ratio (frame->paintable))
+    size_changed = TRUE;
+  else
+    size_changed = FALSE;
+
+  priv->current_frame = *frame;
+  g_slice_free (GtkMediaStreamFrame, frame);
+  g_clear_object (&old);
+
+  if (size_changed)
+    gdk_paintable_invalidate_size (GDK_PAINTABLE (self));
+  gdk_paintable_invalidate_contents (GDK_PAINTABLE (self));
+
+  return TRUE;
+}
+
+static gboolean
+gtk_media_stream_select_cb (gpointer data)
+{
+  GtkMediaStream *self = data;
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+  gint64 now;
+
+  priv->select_source = 0;
+
+  now = g_get_monotonic_time ();
+  if (priv->last_select_time == 0 ||
+      now - priv->last_select_time >= SELECT_TIMEOUT)
+    {
+      priv->last_select_time = 0;
+      gtk_media_stream_advance (self, now);
+    }
+
+  gtk_media_stream_schedule_select (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * gtk_media_stream_queue_frame:
+ * @self: a #GtkMediaStream
+ * @frame: the frame to show
+ * @presentation_time: the monotonic time in microseconds at which
+ *     @frame should be on screen
+ *
+ * Media stream implementations call this function to queue a decoded
+ * frame for display. They should queue frames a little ahead of time,
+ * so that the frame matching the time it is seen can be picked with
+ * gtk_media_stream_select_frame().
+ *
+ * Queued frames with a presentation time that is not before
+ * @presentation_time are discarded, so implementations can simply
+ * queue new frames after a seek.
+ **/
+void
+gtk_media_stream_queue_frame (GtkMediaStream *self,
+                              GdkPaintable   *frame,
+                              gint64          presentation_time)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+  GtkMediaStreamFrame *queued;
+
+  g_return_if_fail (GTK_IS_MEDIA_STREAM (self));
+  g_return_if_fail (GDK_IS_PAINTABLE (frame));
+
+  while ((queued = g_queue_peek_tail (&priv->frames)) &&
+         queued->presentation_time >= presentation_time)
+    {
+      g_queue_pop_tail (&priv->frames);
+      gtk_media_stream_frame_free (queued);
+    }
+
+  queued = g_slice_new (GtkMediaStreamFrame);
+  queued->paintable = g_object_ref (frame);
+  queued->presentation_time = presentation_time;
+  g_queue_push_tail (&priv->frames, queued);
+
+  if (g_queue_get_length (&priv->frames) > MAX_QUEUED_FRAMES)
+    {
+      priv->n_dropped_frames++;
+      gtk_media_stream_frame_free (g_queue_pop_head (&priv->frames));
+    }
+
+  gtk_media_stream_schedule_select (self);
+}
+
+/**
+ * gtk_media_stream_clear_frames:
+ * @self: a #GtkMediaStream
+ *
+ * Discards all frames queued with gtk_media_stream_queue_frame(),
+ * including the one currently shown.
+ **/
+void
+gtk_media_stream_clear_frames (GtkMediaStream *self)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  g_return_if_fail (GTK_IS_MEDIA_STREAM (self));
+
+  g_clear_handle_id (&priv->select_source, g_source_remove);
+  g_queue_clear_full (&priv->frames, (GDestroyNotify) gtk_media_stream_frame_free);
+  priv->frame_interval = 0;
+
+  if (priv->current_frame.paintable)
+    {
+      g_clear_object (&priv->current_frame.paintable);
+      priv->current_frame.presentation_time = 0;
+
+      gdk_paintable_invalidate_size (GDK_PAINTABLE (self));
+      gdk_paintable_invalidate_contents (GDK_PAINTABLE (self));
+    }
+}
+
+/**
+ * gtk_media_stream_select_frame:
+ * @self: a #GtkMediaStream
+ * @presentation_time: the monotonic time in microseconds at which
+ *     the next frame will be presented
+ *
+ * Makes the latest queued frame that is due at @presentation_time
+ * the current frame. Frames before it are dropped.
+ *
+ * Widgets displaying the stream call this once for every frame they
+ * draw, usually from a tick callback using the presentation time
+ * predicted by the #GdkFrameClock. As long as this happens, the stream
+ * does not switch frames on its own.
+ *
+ * Returns: %TRUE if the current frame changed
+ **/
+gboolean
+gtk_media_stream_select_frame (GtkMediaStream *self,
+                               gint64          presentation_time)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_MEDIA_STREAM (self), FALSE);
+
+  priv->last_select_time = g_get_monotonic_time ();
+
+  return gtk_media_stream_advance (self, presentation_time);
+}
+
+/**
+ * gtk_media_stream_get_current_frame:
+ * @self: a #GtkMediaStream
+ *
+ * Gets the frame from the frame queue that is currently shown.
+ *
+ * Returns: (nullable) (transfer none): the current frame or %NULL
+ **/
+GdkPaintable *
+gtk_media_stream_get_current_frame (GtkMediaStream *self)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_MEDIA_STREAM (self), NULL);
+
+  return priv->current_frame.paintable;
+}
+
+/**
+ * gtk_media_stream_get_n_dropped_frames:
+ * @self: a #GtkMediaStream
+ *
+ * Returns the number of queued frames that were never shown, because
+ * a later frame was already due when they would have been selected.
+ *
+ * Returns: the number of dropped frames
+ **/
+guint
+gtk_media_stream_get_n_dropped_frames (GtkMediaStream *self)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_MEDIA_STREAM (self), 0);
+
+  return priv->n_dropped_frames;
+}
+
+/**
+ * gtk_media_stream_get_n_duplicated_frames:
+ * @self: a #GtkMediaStream
+ *
+ * Returns the number of times a frame stayed on screen while
+ * playing because the next frame was not queued in time.
+ *
+ * Returns: the number of duplicated frames
+ **/
+guint
+gtk_media_stream_get_n_duplicated_frames (GtkMediaStream *self)
+{
+  GtkMediaStreamPrivate *priv = gtk_media_stream_get_instance_private (self);
+
+  g_return_val_if_fail (GTK_IS_MEDIA_STREAM (self), 0);
+
+  return priv->n_duplicated_frames;
+}
@@ -149,6 +149,23 @@ void                    gtk_media_stream_error_valist           (GtkMediaStream
                                                                  int             code,
                                                                  const char     *format,
                                                                  va_list         args) G_GNUC_PRINTF (4, 0);
+GDK_AVAILABLE_IN_ALL
+void                    gtk_media_stream_queue_frame            (GtkMediaStream *self,
+                                                                 GdkPaintable   *frame,
+                                                                 gint64          presentation_time);
+GDK_AVAILABLE_IN_ALL
+void                    gtk_media_stream_clear_frames           (GtkMediaStream *self);
+
+/* for displaying queued frames */
+GDK_AVAILABLE_IN_ALL
+gboolean                gtk_media_stream_select_frame           (GtkMediaStream *self,
+                                                                 gint64          presentation_time);
+GDK_AVAILABLE_IN_ALL
+GdkPaintable *          gtk_media_stream_get_current_frame      (GtkMediaStream *self);
+GDK_AVAILABLE_IN_ALL
+guint                   gtk_media_stream_get_n_dropped_frames   (GtkMediaStream *self);
+GDK_AVAILABLE_IN_ALL
+guint                   gtk_media_stream_get_n_duplicated_frames (GtkMediaStream *self);
 
 G_END_DECLS
 
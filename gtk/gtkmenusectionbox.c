@@ -53,6 +53,15 @@ struct _GtkMenuSectionBox
   GtkPopoverMenuFlags  flags;
   GtkSizeGroup        *indicators;
   GHashTable          *custom_slots;
+
+  /* Submenus are filled when they are first shown */
+  GtkMenuTrackerItem  *pending_submenu;
+
+  /* Widgets of removed items, kept around until the next idle in case
+   * the same items are added back, as menus rebuilt from scratch do.
+   */
+  GQueue               recycled;
+  guint                recycle_idle;
 };
 
 typedef struct
@@ -179,6 +188,50 @@ gtk_menu_section_box_schedule_separator_sync (GtkMenuSectionBox *box)
     }
 }
 
+static gboolean
+menu_model_has_custom_items (GMenuModel *model)
+{
+  int i, n;
+
+  n = g_menu_model_get_n_items (model);
+  for (i = 0; i < n; i++)
+    {
+      GMenuLinkIter *iter;
+      gboolean found = FALSE;
+
+      if (g_menu_model_get_item_attribute (model, i, "custom", "&s", NULL))
+        return TRUE;
+
+      iter = g_menu_model_iterate_item_links (model, i);
+      while (!found && g_menu_link_iter_next (iter))
+        {
+          GMenuModel *link = g_menu_link_iter_get_value (iter);
+
+          found = menu_model_has_custom_items (link);
+          g_object_unref (link);
+        }
+      g_object_unref (iter);
+
+      if (found)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+nested_submenu_show (GtkWidget *submenu)
+{
+  GMenuModel *model;
+
+  model = g_object_steal_data (G_OBJECT (submenu), "pending-model");
+  if (model == NULL)
+    return;
+
+  gtk_popover_menu_set_menu_model (GTK_POPOVER_MENU (submenu), model);
+  g_object_unref (model);
+}
+
 static void
 gtk_popover_item_activate (GtkWidget *button,
                            gpointer   user_data)
@@ -205,6 +258,65 @@ gtk_popover_item_activate (GtkWidget *button,
     }
 }
 
+static gboolean
+gtk_menu_section_box_handle_recycle (gpointer user_data)
+{
+  GtkMenuSectionBox *box = user_data;
+
+  g_queue_clear_full (&box->recycled, g_object_unref);
+  box->recycle_idle = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gtk_menu_section_box_can_recycle (GtkMenuTrackerItem *item)
+{
+  return !gtk_menu_tracker_item_get_is_separator (item) &&
+         !gtk_menu_tracker_item_get_has_link (item, G_MENU_LINK_SUBMENU) &&
+         gtk_menu_tracker_item_get_custom (item) == NULL;
+}
+
+static void
+gtk_menu_section_box_recycle (GtkMenuSectionBox *box,
+                              GtkWidget         *widget)
+{
+  g_queue_push_tail (&box->recycled, g_object_ref (widget));
+
+  if (box->recycle_idle == 0)
+    {
+      box->recycle_idle = g_idle_add_full (G_PRIORITY_DEFAULT,
+                                           gtk_menu_section_box_handle_recycle,
+                                           box, NULL);
+      g_source_set_name_by_id (box->recycle_idle, "[gtk] menu section box handle recycle");
+    }
+}
+
+/* Returns a reference to a recycled widget for an item equal to @item */
+static GtkWidget *
+gtk_menu_section_box_take_recycled (GtkMenuSectionBox  *box,
+                                    GtkMenuTrackerItem *item)
+{
+  GList *l;
+
+  for (l = box->recycled.head; l; l = l->next)
+    {
+      GtkMenuTrackerItem *recycled_item;
+
+      recycled_item = g_object_get_data (G_OBJECT (l->data), "GtkMenuTrackerItem");
+      if (_gtk_menu_tracker_item_is_equal (recycled_item, item))
+        {
+          GtkWidget *widget = l->data;
+
+          g_queue_delete_link (&box->recycled, l);
+
+          return widget;
+        }
+    }
+
+  return NULL;
+}
+
 static void
 gtk_menu_section_box_remove_func (int      position,
                                   gpointer user_data)
@@ -233,6 +345,9 @@ gtk_menu_section_box_remove_func (int      position,
         gtk_stack_remove (GTK_STACK (stack), subbox);
     }
 
+  if (gtk_menu_section_box_can_recycle (item))
+    gtk_menu_section_box_recycle (box, widget);
+
   gtk_box_remove (GTK_BOX (box->item_box), widget);
 
   gtk_menu_section_box_schedule_separator_sync (box);
@@ -299,6 +414,7 @@ gtk_menu_section_box_insert_func (GtkMenuTrackerItem *item,
 {
   GtkMenuSectionBox *box = user_data;
   GtkWidget *widget;
+  gboolean recycled = FALSE;
 
   if (gtk_menu_tracker_item_get_is_separator (item))
     {
@@ -313,7 +429,19 @@ gtk_menu_section_box_insert_func (GtkMenuTrackerItem *item,
 
           model = _gtk_menu_tracker_item_get_link (item, G_MENU_LINK_SUBMENU);
 
-          submenu = gtk_popover_menu_new_from_model_full (model, box->flags);
+          if (menu_model_has_custom_items (model))
+            {
+              submenu = gtk_popover_menu_new_from_model_full (model, box->flags);
+            }
+          else
+            {
+              submenu = gtk_popover_menu_new_from_model_full (NULL, box->flags);
+              g_object_set_data_full (G_OBJECT (submenu), "pending-model",
+                                      g_object_ref (model), g_object_unref);
+              g_signal_connect (submenu, "show", G_CALLBACK (nested_submenu_show), NULL);
+            }
+          g_object_unref (model);
+
           gtk_popover_set_has_arrow (GTK_POPOVER (submenu), FALSE);
           gtk_widget_set_valign (submenu, GTK_ALIGN_START);
 
@@ -360,6 +488,12 @@ gtk_menu_section_box_insert_func (GtkMenuTrackerItem *item,
           g_hash_table_insert (box->custom_slots, slot_id, widget);
         }
     }
+  else if ((widget = gtk_menu_section_box_take_recycled (box, item)))
+    {
+      /* The widget stays bound to its old item, which is equal */
+      item = g_object_get_data (G_OBJECT (widget), "GtkMenuTrackerItem");
+      recycled = TRUE;
+    }
   else
     {
       widget = g_object_new (GTK_TYPE_MODEL_BUTTON,
@@ -406,6 +540,8 @@ gtk_menu_section_box_insert_func (GtkMenuTrackerItem *item,
       gtk_widget_set_halign (widget, GTK_ALIGN_FILL);
     }
   gtk_box_append (GTK_BOX (box->item_box), widget);
+  if (recycled)
+    g_object_unref (widget);
 
   if (position == 0)
     gtk_box_reorder_child_after (GTK_BOX (box->item_box), widget, NULL);
@@ -470,6 +606,10 @@ gtk_menu_section_box_dispose (GObject *object)
 
   g_clear_object (&box->separator);
 
+  g_clear_handle_id (&box->recycle_idle, g_source_remove);
+  g_queue_clear_full (&box->recycled, g_object_unref);
+  g_clear_object (&box->pending_submenu);
+
   if (box->tracker)
     {
       gtk_menu_tracker_free (box->tracker);
@@ -482,10 +622,28 @@ gtk_menu_section_box_dispose (GObject *object)
   G_OBJECT_CLASS (gtk_menu_section_box_parent_class)->dispose (object);
 }
 
+static void
+gtk_menu_section_box_map (GtkWidget *widget)
+{
+  GtkMenuSectionBox *box = GTK_MENU_SECTION_BOX (widget);
+
+  if (box->pending_submenu)
+    {
+      box->tracker = gtk_menu_tracker_new_for_item_link (box->pending_submenu, G_MENU_LINK_SUBMENU, FALSE, FALSE,
+                                                         gtk_menu_section_box_insert_func,
+                                                         gtk_menu_section_box_remove_func,
+                                                         box);
+      g_clear_object (&box->pending_submenu);
+    }
+
+  GTK_WIDGET_CLASS (gtk_menu_section_box_parent_class)->map (widget);
+}
+
 static void
 gtk_menu_section_box_class_init (GtkMenuSectionBoxClass *class)
 {
   G_OBJECT_CLASS (class)->dispose = gtk_menu_section_box_dispose;
+  GTK_WIDGET_CLASS (class)->map = gtk_menu_section_box_map;
 }
 
 static void
@@ -542,6 +700,7 @@ gtk_menu_section_box_new_submenu (GtkMenuTrackerItem *item,
 {
   GtkMenuSectionBox *box;
   GtkWidget *button;
+  GMenuModel *model;
 
   box = g_object_new (GTK_TYPE_MENU_SECTION_BOX, NULL);
   box->indicators = gtk_size_group_new (GTK_SIZE_GROUP_HORIZONTAL);
@@ -567,10 +726,18 @@ gtk_menu_section_box_new_submenu (GtkMenuTrackerItem *item,
   gtk_stack_add_named (GTK_STACK (gtk_widget_get_ancestor (GTK_WIDGET (toplevel), GTK_TYPE_STACK)),
                        GTK_WIDGET (box), gtk_menu_tracker_item_get_label (item));
 
-  box->tracker = gtk_menu_tracker_new_for_item_link (item, G_MENU_LINK_SUBMENU, FALSE, FALSE,
-                                                     gtk_menu_section_box_insert_func,
-                                                     gtk_menu_section_box_remove_func,
-                                                     box);
+  /* Custom children can be added to the popover at any time, so
+   * their slots need to exist right away.
+   */
+  model = _gtk_menu_tracker_item_get_link (item, G_MENU_LINK_SUBMENU);
+  if (menu_model_has_custom_items (model))
+    box->tracker = gtk_menu_tracker_new_for_item_link (item, G_MENU_LINK_SUBMENU, FALSE, FALSE,
+                                                       gtk_menu_section_box_insert_func,
+                                                       gtk_menu_section_box_remove_func,
+                                                       box);
+  else
+    box->pending_submenu = g_object_ref (item);
+  g_object_unref (model);
 }
 
 static GtkWidget *
@@ -715,6 +715,68 @@ gtk_menu_tracker_item_get_special (GtkMenuTrackerItem *self)
   return special;
 }
 
+/*< private >
+ * _gtk_menu_tracker_item_is_equal:
+ * @self: a #GtkMenuTrackerItem
+ * @other: another #GtkMenuTrackerItem
+ *
+ * Checks whether two items without links look and act the same,
+ * so that a widget created for one can be used for the other.
+ *
+ * Returns: %TRUE if @self and @other are interchangeable
+ */
+gboolean
+_gtk_menu_tracker_item_is_equal (GtkMenuTrackerItem *self,
+                                 GtkMenuTrackerItem *other)
+{
+  const char * const attributes[] = {
+    G_MENU_ATTRIBUTE_LABEL,
+    G_MENU_ATTRIBUTE_ICON,
+    "verb-icon",
+    "accel",
+    "custom",
+    "display-hint",
+    "text-direction",
+    "hidden-when",
+  };
+  guint i;
+
+  if (self->observable != other->observable ||
+      self->is_separator != other->is_separator ||
+      self->hidden_when != other->hidden_when ||
+      g_strcmp0 (self->action_namespace, other->action_namespace) != 0 ||
+      g_strcmp0 (self->action_and_target, other->action_and_target) != 0)
+    return FALSE;
+
+  if (gtk_menu_tracker_item_get_has_link (self, G_MENU_LINK_SUBMENU) ||
+      gtk_menu_tracker_item_get_has_link (self, G_MENU_LINK_SECTION) ||
+      gtk_menu_tracker_item_get_has_link (other, G_MENU_LINK_SUBMENU) ||
+      gtk_menu_tracker_item_get_has_link (other, G_MENU_LINK_SECTION))
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (attributes); i++)
+    {
+      GVariant *a, *b;
+      gboolean equal;
+
+      a = g_menu_item_get_attribute_value (self->item, attributes[i], NULL);
+      b = g_menu_item_get_attribute_value (other->item, attributes[i], NULL);
+
+      if (a == NULL || b == NULL)
+        equal = a == b;
+      else
+        equal = g_variant_equal (a, b);
+
+      g_clear_pointer (&a, g_variant_unref);
+      g_clear_pointer (&b, g_variant_unref);
+
+      if (!equal)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 const char *
 gtk_menu_tracker_item_get_custom (GtkMenuTrackerItem *self)
 {
@@ -83,6 +83,9 @@ GMenuModel *           _gtk_menu_tracker_item_get_link                  (GtkMenu
 
 char *                _gtk_menu_tracker_item_get_link_namespace        (GtkMenuTrackerItem *self);
 
+gboolean               _gtk_menu_tracker_item_is_equal                  (GtkMenuTrackerItem *self,
+                                                                         GtkMenuTrackerItem *other);
+
 gboolean                gtk_menu_tracker_item_may_disappear             (GtkMenuTrackerItem *self);
 
 gboolean                gtk_menu_tracker_item_get_is_visible            (GtkMenuTrackerItem *self);
@@ -222,6 +222,17 @@ gtk_multi_selection_items_changed_cb (GListModel        *model,
   GHashTable *pending = NULL;
   guint i;
 
+  /* Nothing is selected from here on, so no tracked positions change.
+   * This is the common case of appending to a list.
+   */
+  if (gtk_bitset_is_empty (self->selected) ||
+      gtk_bitset_get_maximum (self->selected) < position)
+    {
+      gtk_bitset_splice (self->selected, position, removed, added);
+      g_list_model_items_changed (G_LIST_MODEL (self), position, removed, added);
+      return;
+    }
+
   gtk_bitset_splice (self->selected, position, removed, added);
 
   g_hash_table_iter_init (&iter, self->items);
@@ -26,6 +26,8 @@
 #include "gtksorterprivate.h"
 #include "gtktypebuiltins.h"
 
+#include <string.h>
+
 #define GDK_ARRAY_TYPE_NAME GtkSorters
 #define GDK_ARRAY_NAME gtk_sorters
 #define GDK_ARRAY_ELEMENT_TYPE GtkSorter *
@@ -66,6 +68,8 @@ struct _GtkMultiSortKeys
   GtkMultiSortKey keys[];
 };
 
+static const GtkSortKeysClass GTK_MULTI_SORT_KEYS_CLASS;
+
 static void
 gtk_multi_sort_keys_free (GtkSortKeys *keys)
 {
@@ -146,6 +150,99 @@ gtk_multi_sort_keys_clear_key (GtkSortKeys *keys,
     gtk_sort_keys_clear_key (self->keys[i].keys, key + self->keys[i].offset);
 }
 
+/* Multi keys with a single sorter are that sorter's keys, so treat other
+ * keys as a multi key with one entry */
+static const GtkMultiSortKey *
+gtk_multi_sort_keys_get_entries (GtkSortKeys     *keys,
+                                 GtkMultiSortKey *single,
+                                 guint           *n_entries)
+{
+  if (keys->klass == &GTK_MULTI_SORT_KEYS_CLASS)
+    {
+      GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
+
+      *n_entries = self->n_keys;
+      return self->keys;
+    }
+
+  single->offset = 0;
+  single->keys = keys;
+  *n_entries = 1;
+  return single;
+}
+
+static gboolean
+gtk_multi_sort_keys_can_convert (GtkSortKeys *keys,
+                                 GtkSortKeys *other)
+{
+  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
+  const GtkMultiSortKey *entries;
+  GtkMultiSortKey single;
+  guint i, j, n_entries;
+
+  entries = gtk_multi_sort_keys_get_entries (other, &single, &n_entries);
+
+  for (i = 0; i < self->n_keys; i++)
+    {
+      for (j = 0; j < n_entries; j++)
+        {
+          if (gtk_sort_keys_is_compatible (self->keys[i].keys, entries[j].keys))
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Moves the keys of sorters that are still in use, so when a sorter is
+ * added in front, only keys for that sorter need to be computed */
+static void
+gtk_multi_sort_keys_convert_key (GtkSortKeys *keys,
+                                 gpointer     item,
+                                 gpointer     key_memory,
+                                 GtkSortKeys *other,
+                                 gpointer     other_key_memory)
+{
+  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
+  const GtkMultiSortKey *entries;
+  GtkMultiSortKey single;
+  char *key = (char *) key_memory;
+  char *other_key = (char *) other_key_memory;
+  gboolean *used;
+  guint i, j, n_entries;
+
+  entries = gtk_multi_sort_keys_get_entries (other, &single, &n_entries);
+  used = g_newa (gboolean, n_entries);
+  memset (used, 0, sizeof (gboolean) * n_entries);
+
+  for (i = 0; i < self->n_keys; i++)
+    {
+      for (j = 0; j < n_entries; j++)
+        {
+          if (!used[j] && gtk_sort_keys_is_compatible (self->keys[i].keys, entries[j].keys))
+            break;
+        }
+
+      if (j < n_entries)
+        {
+          memcpy (key + self->keys[i].offset,
+                  other_key + entries[j].offset,
+                  gtk_sort_keys_get_key_size (self->keys[i].keys));
+          used[j] = TRUE;
+        }
+      else
+        {
+          gtk_sort_keys_init_key (self->keys[i].keys, item, key + self->keys[i].offset);
+        }
+    }
+
+  for (j = 0; j < n_entries; j++)
+    {
+      if (!used[j])
+        gtk_sort_keys_clear_key (entries[j].keys, other_key + entries[j].offset);
+    }
+}
+
 static const GtkSortKeysClass GTK_MULTI_SORT_KEYS_CLASS =
 {
   gtk_multi_sort_keys_free,
@@ -153,6 +250,9 @@ static const GtkSortKeysClass GTK_MULTI_SORT_KEYS_CLASS =
   gtk_multi_sort_keys_is_compatible,
   gtk_multi_sort_keys_init_key,
   gtk_multi_sort_keys_clear_key,
+  FALSE,
+  gtk_multi_sort_keys_can_convert,
+  gtk_multi_sort_keys_convert_key,
 };
 
 static GtkSortKeys *
@@ -51,6 +51,11 @@
  * gdk_texture_new_from_file(), then create the #GtkPicture with
  * gtk_picture_new_for_paintable().
  *
+ * Files are loaded synchronously. To keep big images or many pictures
+ * from blocking the user interface, load them with
+ * gdk_texture_new_from_file_async(), optionally at the size they will
+ * be displayed at, and set the result with gtk_picture_set_paintable().
+ *
  * Sometimes an application will want to avoid depending on external data
  * files, such as image files. See the documentation of #GResource for details.
  * In this case, gtk_picture_new_for_resource() and gtk_picture_set_resource()
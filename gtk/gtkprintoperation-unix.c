@@ -363,20 +363,26 @@ unix_finish_send  (GtkPrintJob  *job,
 }
 
 static void
-unix_end_run (GtkPrintOperation *op,
-	      gboolean           wait,
-	      gboolean           cancelled)
+unix_finish_surface_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
 {
-  GtkPrintOperationUnix *op_unix = op->priv->platform_data;
+  cairo_surface_t *surface = task_data;
 
-  cairo_surface_finish (op_unix->surface);
-  
-  if (cancelled)
-    return;
+  cairo_surface_finish (surface);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+unix_surface_finished (GObject      *source,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+  GtkPrintOperation *op = GTK_PRINT_OPERATION (source);
+  GtkPrintOperationUnix *op_unix = op->priv->platform_data;
 
-  if (wait)
-    op_unix->loop = g_main_loop_new (NULL, FALSE);
-  
   /* TODO: Check for error */
   if (op_unix->job != NULL)
     {
@@ -385,6 +391,36 @@ unix_end_run (GtkPrintOperation *op,
                           unix_finish_send, 
                           op, NULL);
     }
+}
+
+static void
+unix_end_run (GtkPrintOperation *op,
+	      gboolean           wait,
+	      gboolean           cancelled)
+{
+  GtkPrintOperationUnix *op_unix = op->priv->platform_data;
+  GTask *task;
+
+  if (cancelled)
+    {
+      cairo_surface_finish (op_unix->surface);
+      return;
+    }
+
+  if (wait)
+    op_unix->loop = g_main_loop_new (NULL, FALSE);
+
+  /* Finishing the surface writes out everything that is shared
+   * between pages, like the fonts. That can take a long time for
+   * large documents, so don't block the main loop with it.
+   */
+  task = g_task_new (op, NULL, unix_surface_finished, NULL);
+  g_task_set_source_tag (task, unix_end_run);
+  g_task_set_task_data (task,
+                        cairo_surface_reference (op_unix->surface),
+                        (GDestroyNotify) cairo_surface_destroy);
+  g_task_run_in_thread (task, unix_finish_surface_thread);
+  g_object_unref (task);
 
   if (wait)
     {
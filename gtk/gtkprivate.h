@@ -121,6 +121,8 @@ void _gtk_load_dll_with_libgtk3_manifest (const char *dllname);
 
 gboolean        gtk_simulate_touchscreen (void);
 
+guint           gtk_get_n_threads        (void);
+
 void  gtk_set_display_debug_flags (GdkDisplay *display,
                                    guint       flags);
 guint gtk_get_display_debug_flags (GdkDisplay *display);
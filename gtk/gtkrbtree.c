@@ -21,6 +21,10 @@
 
 #include "gtkdebug.h"
 
+#include "gdk/gdkallocstatsprivate.h"
+
+#include <string.h>
+
 /* Define the following to print adds and removals to stdout.
  * The format of the printout will be suitable for addition as a new test to
  * testsuite/gtk/rbtree-crash.c
@@ -31,6 +35,19 @@
 #undef DUMP_MODIFICATION
 
 typedef struct _GtkRbNode GtkRbNode;
+typedef struct _GtkRbSlab GtkRbSlab;
+
+/* Nodes are allocated from slabs owned by their tree, so nodes of one
+ * tree are close together in memory, and adding and removing nodes
+ * does not need the allocator. Removed nodes are kept in a free list
+ * for reuse, the slabs are only released once the tree is empty.
+ */
+#define MIN_SLAB_NODES 16
+#define MAX_SLAB_NODES 1024
+
+/* Nodes get the same alignment malloc() would give them */
+#define NODE_ALIGN (2 * sizeof (gpointer))
+#define ALIGN_SIZE(size) (((size) + NODE_ALIGN - 1) & ~(NODE_ALIGN - 1))
 
 struct _GtkRbTree
 {
@@ -43,8 +60,21 @@ struct _GtkRbTree
   GDestroyNotify clear_augment_func;
 
   GtkRbNode *root;
+
+  gsize node_size;
+  GtkRbSlab *slabs;
+  GtkRbNode *free_nodes; /* linked through their left pointer */
+};
+
+struct _GtkRbSlab
+{
+  GtkRbSlab *next;
+  guint n_nodes;
+  guint n_used;
 };
 
+#define SLAB_HEADER_SIZE ALIGN_SIZE (sizeof (GtkRbSlab))
+
 struct _GtkRbNode
 {
   guint red :1;
@@ -107,9 +137,49 @@ set_parent (GtkRbTree *tree,
 }
 
 static inline gsize
-gtk_rb_node_get_size (GtkRbTree *tree)
+gtk_rb_slab_get_size (GtkRbTree *tree,
+                      guint      n_nodes)
+{
+  return SLAB_HEADER_SIZE + n_nodes * tree->node_size;
+}
+
+static GtkRbNode *
+gtk_rb_slab_alloc_node (GtkRbTree *tree)
+{
+  GtkRbSlab *slab = tree->slabs;
+
+  if (slab == NULL || slab->n_used == slab->n_nodes)
+    {
+      guint n_nodes;
+
+      /* Small trees stay small, big ones don't need many slabs */
+      n_nodes = slab ? MIN (slab->n_nodes * 2, MAX_SLAB_NODES) : MIN_SLAB_NODES;
+
+      slab = g_malloc (gtk_rb_slab_get_size (tree, n_nodes));
+      gdk_alloc_stats_add (GDK_ALLOC_RB_TREE, gtk_rb_slab_get_size (tree, n_nodes));
+      slab->n_nodes = n_nodes;
+      slab->n_used = 0;
+      slab->next = tree->slabs;
+      tree->slabs = slab;
+    }
+
+  return (GtkRbNode *) (((guchar *) slab) + SLAB_HEADER_SIZE + tree->node_size * slab->n_used++);
+}
+
+static void
+gtk_rb_tree_free_slabs (GtkRbTree *tree)
 {
-  return sizeof (GtkRbNode) + tree->element_size + tree->augment_size;
+  GtkRbSlab *slab, *next;
+
+  for (slab = tree->slabs; slab; slab = next)
+    {
+      next = slab->next;
+      gdk_alloc_stats_remove (GDK_ALLOC_RB_TREE, gtk_rb_slab_get_size (tree, slab->n_nodes));
+      g_free (slab);
+    }
+
+  tree->slabs = NULL;
+  tree->free_nodes = NULL;
 }
 
 static GtkRbNode *
@@ -117,7 +187,17 @@ gtk_rb_node_new (GtkRbTree *tree)
 {
   GtkRbNode *result;
 
-  result = g_slice_alloc0 (gtk_rb_node_get_size (tree));
+  if (tree->free_nodes)
+    {
+      result = tree->free_nodes;
+      tree->free_nodes = result->left;
+    }
+  else
+    {
+      result = gtk_rb_slab_alloc_node (tree);
+    }
+
+  memset (result, 0, tree->node_size);
 
   result->red = TRUE;
   result->dirty = TRUE;
@@ -134,7 +214,8 @@ gtk_rb_node_free (GtkRbTree *tree,
   if (tree->clear_augment_func)
     tree->clear_augment_func (NODE_TO_AUG_POINTER (tree, node));
 
-  g_slice_free1 (gtk_rb_node_get_size (tree), node);
+  node->left = tree->free_nodes;
+  tree->free_nodes = node;
 }
 
 static void
@@ -520,6 +601,8 @@ gtk_rb_tree_new_for_size (gsize                element_size,
   tree->clear_func = clear_func;
   tree->clear_augment_func = clear_augment_func;
 
+  tree->node_size = ALIGN_SIZE (sizeof (GtkRbNode) + element_size + augment_size);
+
   return tree;
 }
 
@@ -540,7 +623,9 @@ gtk_rb_tree_unref (GtkRbTree *tree)
 
   if (tree->root)
     gtk_rb_node_free_deep (tree, tree->root);
-    
+
+  gtk_rb_tree_free_slabs (tree);
+
   g_slice_free (GtkRbTree, tree);
 }
 
@@ -783,6 +868,9 @@ gtk_rb_tree_remove (GtkRbTree *tree,
     }
 
   gtk_rb_node_free (tree, real_node);
+
+  if (tree->root == NULL)
+    gtk_rb_tree_free_slabs (tree);
 }
 
 void
@@ -796,5 +884,74 @@ gtk_rb_tree_remove_all (GtkRbTree *tree)
     gtk_rb_node_free_deep (tree, tree->root);
 
   tree->root = NULL;
+
+  gtk_rb_tree_free_slabs (tree);
+}
+
+/* Builds a subtree of @n_nodes nodes, with all leaves at @depth
+ * or one above it. The nodes at @depth are the red ones.
+ */
+static GtkRbNode *
+gtk_rb_node_build (GtkRbTree *tree,
+                   GtkRbNode *parent_node,
+                   guint      n_nodes,
+                   guint      depth,
+                   guint      red_depth)
+{
+  GtkRbNode *result;
+  guint n_left;
+
+  if (n_nodes == 0)
+    return NULL;
+
+  n_left = n_nodes / 2;
+
+  result = gtk_rb_node_new (tree);
+  result->red = depth == red_depth;
+  set_parent (tree, result, parent_node);
+
+  result->left = gtk_rb_node_build (tree, result, n_left, depth + 1, red_depth);
+  result->right = gtk_rb_node_build (tree, result, n_nodes - n_left - 1, depth + 1, red_depth);
+
+  return result;
+}
+
+/*
+ * gtk_rb_tree_populate:
+ * @tree: an empty tree
+ * @n_nodes: the number of nodes to add
+ *
+ * Adds @n_nodes nodes to the empty @tree at once. This takes
+ * linear time, unlike adding them one by one, which rebalances
+ * the tree after each node.
+ *
+ * Returns: the first of the new nodes, or %NULL if @n_nodes is 0
+ */
+gpointer
+gtk_rb_tree_populate (GtkRbTree *tree,
+                      guint      n_nodes)
+{
+  guint red_depth;
+
+  g_return_val_if_fail (tree->root == NULL, NULL);
+
+#ifdef DUMP_MODIFICATION
+  g_print ("populate (tree, %u); /* 0x%p */\n", n_nodes, tree);
+#endif /* DUMP_MODIFICATION */
+
+  if (n_nodes == 0)
+    return NULL;
+
+  /* The deepest level is the only one that may not be full,
+   * making it red keeps all paths at the same black height.
+   * A root on its own stays black.
+   */
+  red_depth = g_bit_storage (n_nodes) - 1;
+  if (red_depth == 0)
+    red_depth = G_MAXUINT;
+
+  gtk_rb_node_build (tree, NULL, n_nodes, 0, red_depth);
+
+  return NODE_TO_POINTER (gtk_rb_node_get_first (tree->root));
 }
 
@@ -160,6 +160,21 @@ struct _GtkRecentInfo
   int ref_count;
 };
 
+/* Writes happen on a worker thread. Data queued while a write is in
+ * progress replaces any older queued data, so a burst of changes ends
+ * up as at most two writes. The writer is shared with the thread, so
+ * it is refcounted.
+ */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+
+  char *filename;
+  GBytes *pending;
+  gboolean writing;
+} RecentWriter;
+
 struct _GtkRecentManagerPrivate
 {
   char *filename;
@@ -170,6 +185,15 @@ struct _GtkRecentManagerPrivate
 
   GBookmarkFile *recent_items;
 
+  /* checksum of the file contents matching recent_items, used to
+   * recognize our own writes when the file monitor reports them
+   */
+  char *checksum;
+  GCancellable *load_cancellable;
+  guint is_loaded : 1;
+
+  RecentWriter *writer;
+
   GFileMonitor *monitor;
 
   guint changed_timeout;
@@ -216,6 +240,8 @@ static void     gtk_recent_manager_enabled_changed     (GtkRecentManager  *manag
 
 
 static void     build_recent_items_list                (GtkRecentManager  *manager);
+static void     load_recent_items_list                 (GtkRecentManager  *manager);
+static void     ensure_recent_items_list               (GtkRecentManager  *manager);
 static void     purge_recent_items_list                (GtkRecentManager  *manager,
                                                         GError           **error);
 
@@ -251,6 +277,137 @@ has_case_prefix (const char *haystack,
   return *n == '\0';
 }
 
+static RecentWriter *
+recent_writer_new (const char *filename)
+{
+  RecentWriter *writer;
+
+  writer = g_atomic_rc_box_new0 (RecentWriter);
+  g_mutex_init (&writer->lock);
+  g_cond_init (&writer->cond);
+  writer->filename = g_strdup (filename);
+
+  return writer;
+}
+
+static void
+recent_writer_clear (gpointer data)
+{
+  RecentWriter *writer = data;
+
+  g_mutex_clear (&writer->lock);
+  g_cond_clear (&writer->cond);
+  g_free (writer->filename);
+  g_clear_pointer (&writer->pending, g_bytes_unref);
+}
+
+static void
+recent_writer_unref (RecentWriter *writer)
+{
+  g_atomic_rc_box_release_full (writer, recent_writer_clear);
+}
+
+static void
+recent_writer_write (RecentWriter *writer,
+                     GBytes       *bytes)
+{
+  GError *write_error = NULL;
+  gconstpointer data;
+  gsize size;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (!g_file_set_contents (writer->filename, data, size, &write_error))
+    {
+      char *utf8 = g_filename_to_utf8 (writer->filename, -1, NULL, NULL, NULL);
+      g_warning ("Attempting to store changes into '%s', but failed: %s",
+                 utf8 ? utf8 : "(invalid filename)",
+                 write_error->message);
+      g_free (utf8);
+      g_error_free (write_error);
+    }
+
+  if (g_chmod (writer->filename, 0600) < 0)
+    {
+      char *utf8 = g_filename_to_utf8 (writer->filename, -1, NULL, NULL, NULL);
+      g_warning ("Attempting to set the permissions of '%s', but failed: %s",
+                 utf8 ? utf8 : "(invalid filename)",
+                 g_strerror (errno));
+      g_free (utf8);
+    }
+}
+
+static void
+recent_writer_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  RecentWriter *writer = task_data;
+
+  g_mutex_lock (&writer->lock);
+
+  while (writer->pending != NULL)
+    {
+      GBytes *bytes = g_steal_pointer (&writer->pending);
+
+      g_mutex_unlock (&writer->lock);
+      recent_writer_write (writer, bytes);
+      g_bytes_unref (bytes);
+      g_mutex_lock (&writer->lock);
+    }
+
+  writer->writing = FALSE;
+  g_cond_broadcast (&writer->cond);
+
+  g_mutex_unlock (&writer->lock);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/* Takes ownership of @bytes */
+static void
+recent_writer_queue (RecentWriter *writer,
+                     GBytes       *bytes)
+{
+  GTask *task;
+
+  g_mutex_lock (&writer->lock);
+
+  g_clear_pointer (&writer->pending, g_bytes_unref);
+  writer->pending = bytes;
+
+  if (writer->writing)
+    {
+      g_mutex_unlock (&writer->lock);
+      return;
+    }
+
+  writer->writing = TRUE;
+
+  g_mutex_unlock (&writer->lock);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, recent_writer_queue);
+  g_task_set_task_data (task,
+                        g_atomic_rc_box_acquire (writer),
+                        (GDestroyNotify) recent_writer_unref);
+  g_task_run_in_thread (task, recent_writer_thread);
+  g_object_unref (task);
+}
+
+/* Waits until everything queued so far is on disk */
+static void
+recent_writer_flush (RecentWriter *writer)
+{
+  g_mutex_lock (&writer->lock);
+
+  while (writer->writing)
+    g_cond_wait (&writer->cond, &writer->lock);
+
+  g_mutex_unlock (&writer->lock);
+}
+
 GQuark
 gtk_recent_manager_error_quark (void)
 {
@@ -380,10 +537,14 @@ gtk_recent_manager_finalize (GObject *object)
   GtkRecentManagerPrivate *priv = manager->priv;
 
   g_free (priv->filename);
+  g_free (priv->checksum);
 
   if (priv->recent_items != NULL)
     g_bookmark_file_free (priv->recent_items);
 
+  if (priv->writer != NULL)
+    recent_writer_unref (priv->writer);
+
   G_OBJECT_CLASS (gtk_recent_manager_parent_class)->finalize (object);
 }
 
@@ -409,6 +570,12 @@ gtk_recent_manager_dispose (GObject *gobject)
       priv->changed_age = 0;
     }
 
+  if (priv->load_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_clear_object (&priv->load_cancellable);
+    }
+
   if (priv->is_dirty)
     {
       g_object_ref (manager);
@@ -416,6 +583,10 @@ gtk_recent_manager_dispose (GObject *gobject)
       g_object_unref (manager);
     }
 
+  /* don't let the last changes get lost */
+  if (priv->writer != NULL)
+    recent_writer_flush (priv->writer);
+
   G_OBJECT_CLASS (gtk_recent_manager_parent_class)->dispose (gobject);
 }
 
@@ -438,8 +609,17 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
       GError *write_error;
 
       /* we are marked as dirty, so we dump the content of our
-       * recently used items list
+       * recently used items list; a reload that is still going on
+       * would only be overwritten by this.
        */
+      ensure_recent_items_list (manager);
+
+      if (priv->load_cancellable != NULL)
+        {
+          g_cancellable_cancel (priv->load_cancellable);
+          g_clear_object (&priv->load_cancellable);
+        }
+
       if (!priv->recent_items)
         {
           /* if no container object has been defined, we create a new
@@ -482,10 +662,13 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
             }
         }
 
-      if (priv->filename != NULL)
+      if (priv->writer != NULL)
         {
+          char *data;
+          gsize length;
+
           write_error = NULL;
-          g_bookmark_file_to_file (priv->recent_items, priv->filename, &write_error);
+          data = g_bookmark_file_to_data (priv->recent_items, &length, &write_error);
           if (write_error)
             {
               char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
@@ -495,14 +678,17 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
               g_free (utf8);
               g_error_free (write_error);
             }
-
-          if (g_chmod (priv->filename, 0600) < 0)
+          else
             {
-              char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
-              g_warning ("Attempting to set the permissions of '%s', but failed: %s",
-                         utf8 ? utf8 : "(invalid filename)",
-                         g_strerror (errno));
-              g_free (utf8);
+              g_free (priv->checksum);
+              priv->checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                                            (const guchar *) data,
+                                                            length);
+
+              /* only serializing happens here, the file is written
+               * on a worker thread
+               */
+              recent_writer_queue (priv->writer, g_bytes_new_take (data, length));
             }
         }
 
@@ -511,11 +697,14 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
     }
   else
     {
-      /* we are not marked as dirty, so we have been called
-       * because the recently used resources file has been
-       * changed (and not from us).
+      /* we are not marked as dirty, so either a reload of the
+       * recently used resources file just finished (and is still
+       * marked as running while emitting), or somebody else emitted
+       * the signal. Check the file again in the latter case; this is
+       * cheap if it did not change.
        */
-      build_recent_items_list (manager);
+      if (priv->is_loaded && priv->load_cancellable == NULL)
+        load_recent_items_list (manager);
     }
 
   g_object_thaw_notify (G_OBJECT (manager));
@@ -535,7 +724,7 @@ gtk_recent_manager_monitor_changed (GFileMonitor      *monitor,
     case G_FILE_MONITOR_EVENT_CHANGED:
     case G_FILE_MONITOR_EVENT_CREATED:
     case G_FILE_MONITOR_EVENT_DELETED:
-      gtk_recent_manager_changed (manager);
+      load_recent_items_list (manager);
       break;
 
     case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
@@ -604,6 +793,12 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
           priv->monitor = NULL;
         }
 
+      if (priv->writer)
+        {
+          recent_writer_flush (priv->writer);
+          g_clear_pointer (&priv->writer, recent_writer_unref);
+        }
+
       if (!filename || *filename == '\0')
         return;
       else
@@ -640,75 +835,275 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
                           manager);
 
       g_object_unref (file);
+
+      priv->writer = recent_writer_new (priv->filename);
     }
 
-  build_recent_items_list (manager);
+  priv->is_loaded = FALSE;
+  load_recent_items_list (manager);
+}
+
+typedef struct
+{
+  char *filename;
+  char *known_checksum;
+
+  GBookmarkFile *items;
+  char *checksum;
+  GError *error;
+} RecentLoad;
+
+static void
+recent_load_free (gpointer data)
+{
+  RecentLoad *load = data;
+
+  g_free (load->filename);
+  g_free (load->known_checksum);
+  if (load->items)
+    g_bookmark_file_free (load->items);
+  g_free (load->checksum);
+  g_clear_error (&load->error);
+  g_free (load);
 }
 
-/* reads the recently used resources file and builds the items list.
- * we keep the items list inside the parser object, and build the
+/* May run on a worker thread. If the contents match the known checksum,
+ * they are not parsed again, and neither items nor error are set.
+ */
+static void
+recent_load_run (RecentLoad *load)
+{
+  char *contents;
+  gsize length;
+
+  if (!g_file_get_contents (load->filename, &contents, &length, &load->error))
+    return;
+
+  load->checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                                (const guchar *) contents,
+                                                length);
+
+  if (g_strcmp0 (load->checksum, load->known_checksum) != 0)
+    {
+      load->items = g_bookmark_file_new ();
+      if (!g_bookmark_file_load_from_data (load->items, contents, length, &load->error))
+        g_clear_pointer (&load->items, g_bookmark_file_free);
+    }
+
+  g_free (contents);
+}
+
+static gboolean
+recent_load_is_unchanged (RecentLoad *load)
+{
+  return load->items == NULL && load->error == NULL;
+}
+
+/* we keep the items list inside the parser object, and build the
  * RecentInfo object only on user’s demand to avoid useless replication.
  * this function resets the dirty bit of the manager.
  */
 static void
-build_recent_items_list (GtkRecentManager *manager)
+apply_recent_load (GtkRecentManager *manager,
+                   RecentLoad       *load)
 {
   GtkRecentManagerPrivate *priv = manager->priv;
-  GError *read_error;
   int size;
 
-  if (!priv->recent_items)
-    {
-      priv->recent_items = g_bookmark_file_new ();
-      priv->size = 0;
-    }
+  priv->is_loaded = TRUE;
 
-  if (priv->filename != NULL)
+  if (load->error)
     {
-      /* the file exists, and it's valid (we hope); if not, destroy the container
-       * object and hope for a better result when the next "changed" signal is
-       * fired.
+      /* the file does not exist, or it's not valid; destroy the container
+       * object and hope for a better result when the file changes again.
+       *
+       * if the file does not exist we just wait for the first write
+       * operation on this recent manager instance, to avoid creating
+       * empty files and leading to spurious file system events (Sabayon
+       * will not be happy about those)
        */
-      read_error = NULL;
-      g_bookmark_file_load_from_file (priv->recent_items, priv->filename, &read_error);
-      if (read_error)
+      if (load->error->domain == G_FILE_ERROR &&
+          load->error->code != G_FILE_ERROR_NOENT)
         {
-          /* if the file does not exist we just wait for the first write
-           * operation on this recent manager instance, to avoid creating
-           * empty files and leading to spurious file system events (Sabayon
-           * will not be happy about those)
-           */
-          if (read_error->domain == G_FILE_ERROR &&
-              read_error->code != G_FILE_ERROR_NOENT)
-            {
-              char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
-              g_warning ("Attempting to read the recently used resources "
-                         "file at '%s', but the parser failed: %s.",
-                         utf8 ? utf8 : "(invalid filename)",
-                         read_error->message);
-              g_free (utf8);
-            }
+          char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
+          g_warning ("Attempting to read the recently used resources "
+                     "file at '%s', but the parser failed: %s.",
+                     utf8 ? utf8 : "(invalid filename)",
+                     load->error->message);
+          g_free (utf8);
+        }
 
-          g_bookmark_file_free (priv->recent_items);
-          priv->recent_items = NULL;
+      g_clear_pointer (&priv->recent_items, g_bookmark_file_free);
+      g_clear_pointer (&priv->checksum, g_free);
+    }
+  else if (load->items)
+    {
+      if (priv->recent_items)
+        g_bookmark_file_free (priv->recent_items);
+      priv->recent_items = g_steal_pointer (&load->items);
 
-          g_error_free (read_error);
-        }
-      else
+      g_free (priv->checksum);
+      priv->checksum = g_steal_pointer (&load->checksum);
+
+      size = g_bookmark_file_get_size (priv->recent_items);
+      if (priv->size != size)
         {
-          size = g_bookmark_file_get_size (priv->recent_items);
-          if (priv->size != size)
-            {
-              priv->size = size;
+          priv->size = size;
 
-              g_object_notify (G_OBJECT (manager), "size");
-            }
+          g_object_notify (G_OBJECT (manager), "size");
         }
     }
 
   priv->is_dirty = FALSE;
 }
 
+/* reads the recently used resources file and builds the items list,
+ * blocking until it is done.
+ */
+static void
+build_recent_items_list (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentLoad *load;
+
+  if (!priv->recent_items)
+    {
+      priv->recent_items = g_bookmark_file_new ();
+      priv->size = 0;
+    }
+
+  if (priv->filename == NULL)
+    {
+      priv->is_loaded = TRUE;
+      priv->is_dirty = FALSE;
+      return;
+    }
+
+  load = g_new0 (RecentLoad, 1);
+  load->filename = g_strdup (priv->filename);
+
+  recent_load_run (load);
+  apply_recent_load (manager, load);
+
+  recent_load_free (load);
+}
+
+static void
+load_recent_items_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  RecentLoad *load = task_data;
+
+  if (!g_cancellable_is_cancelled (cancellable))
+    recent_load_run (load);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+load_recent_items_done (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  GtkRecentManager *manager;
+  GtkRecentManagerPrivate *priv;
+  GCancellable *cancellable;
+  RecentLoad *load;
+  gboolean was_loaded;
+
+  /* the manager may be gone if we were cancelled */
+  if (!g_task_propagate_boolean (G_TASK (result), NULL))
+    return;
+
+  manager = user_data;
+  priv = manager->priv;
+  load = g_task_get_task_data (G_TASK (result));
+  cancellable = g_task_get_cancellable (G_TASK (result));
+  was_loaded = priv->is_loaded;
+
+  /* local changes win, they are about to be written anyway */
+  if (recent_load_is_unchanged (load) || (was_loaded && priv->is_dirty))
+    {
+      g_clear_object (&priv->load_cancellable);
+      return;
+    }
+
+  g_object_freeze_notify (G_OBJECT (manager));
+
+  apply_recent_load (manager, load);
+
+  /* the first load does not change anything anybody could have seen */
+  if (was_loaded)
+    g_signal_emit (manager, signal_changed, 0);
+
+  g_object_thaw_notify (G_OBJECT (manager));
+
+  if (priv->load_cancellable == cancellable)
+    g_clear_object (&priv->load_cancellable);
+}
+
+/* reads the recently used resources file on a worker thread, and
+ * replaces the items list with its contents unless it is modified
+ * in the meantime. Contents that match what we last read or wrote
+ * are not parsed again, so our own writes are cheap to notice.
+ */
+static void
+load_recent_items_list (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  RecentLoad *load;
+  GTask *task;
+
+  if (priv->load_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_clear_object (&priv->load_cancellable);
+    }
+
+  if (priv->filename == NULL)
+    {
+      build_recent_items_list (manager);
+      return;
+    }
+
+  load = g_new0 (RecentLoad, 1);
+  load->filename = g_strdup (priv->filename);
+  load->known_checksum = g_strdup (priv->checksum);
+
+  priv->load_cancellable = g_cancellable_new ();
+
+  /* no source object, so that a pending load does not keep the
+   * manager alive; it is cancelled in dispose instead.
+   */
+  task = g_task_new (NULL, priv->load_cancellable, load_recent_items_done, manager);
+  g_task_set_source_tag (task, load_recent_items_list);
+  g_task_set_task_data (task, load, recent_load_free);
+  g_task_run_in_thread (task, load_recent_items_thread);
+  g_object_unref (task);
+}
+
+/* the public API is synchronous, so if the list is needed before
+ * the first load finished, we read it right away.
+ */
+static void
+ensure_recent_items_list (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  if (priv->is_loaded)
+    return;
+
+  if (priv->load_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_clear_object (&priv->load_cancellable);
+    }
+
+  build_recent_items_list (manager);
+}
+
 
 /********************
  * GtkRecentManager *
@@ -951,6 +1346,7 @@ gtk_recent_manager_add_full (GtkRecentManager    *manager,
     return TRUE;
 
   priv = manager->priv;
+  ensure_recent_items_list (manager);
 
   if (!priv->recent_items)
     {
@@ -1019,6 +1415,7 @@ gtk_recent_manager_remove_item (GtkRecentManager  *manager,
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   priv = manager->priv;
+  ensure_recent_items_list (manager);
 
   if (!priv->recent_items)
     {
@@ -1072,6 +1469,7 @@ gtk_recent_manager_has_item (GtkRecentManager *manager,
   g_return_val_if_fail (uri != NULL, FALSE);
 
   priv = manager->priv;
+  ensure_recent_items_list (manager);
   g_return_val_if_fail (priv->recent_items != NULL, FALSE);
 
   return g_bookmark_file_has_item (priv->recent_items, uri);
@@ -1171,6 +1569,7 @@ gtk_recent_manager_lookup_item (GtkRecentManager  *manager,
   g_return_val_if_fail (error == NULL || *error == NULL, NULL);
 
   priv = manager->priv;
+  ensure_recent_items_list (manager);
   if (!priv->recent_items)
     {
       priv->recent_items = g_bookmark_file_new ();
@@ -1233,6 +1632,7 @@ gtk_recent_manager_move_item (GtkRecentManager  *recent_manager,
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
   priv = recent_manager->priv;
+  ensure_recent_items_list (recent_manager);
 
   if (!priv->recent_items)
     {
@@ -1295,6 +1695,7 @@ gtk_recent_manager_get_items (GtkRecentManager *manager)
   g_return_val_if_fail (GTK_IS_RECENT_MANAGER (manager), NULL);
 
   priv = manager->priv;
+  ensure_recent_items_list (manager);
   if (!priv->recent_items)
     return NULL;
 
@@ -1352,6 +1753,7 @@ gtk_recent_manager_purge_items (GtkRecentManager  *manager,
   g_return_val_if_fail (GTK_IS_RECENT_MANAGER (manager), -1);
 
   priv = manager->priv;
+  ensure_recent_items_list (manager);
   if (!priv->recent_items)
     return 0;
 
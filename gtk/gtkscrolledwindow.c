@@ -51,7 +51,7 @@
 #include "gtksnapshot.h"
 #include "gtkstylecontextprivate.h"
 #include "gtktypebuiltins.h"
-#include "gtkviewport.h"
+#include "gtkviewportprivate.h"
 #include "gtkwidgetprivate.h"
 
 #include <math.h>
@@ -3254,6 +3254,11 @@ gtk_scrolled_window_cancel_deceleration (GtkScrolledWindow *scrolled_window)
 static void
 kinetic_scroll_data_free (KineticScrollData *data)
 {
+  GtkScrolledWindowPrivate *priv = gtk_scrolled_window_get_instance_private (data->scrolled_window);
+
+  if (GTK_IS_VIEWPORT (priv->child))
+    gtk_viewport_set_cache_content (GTK_VIEWPORT (priv->child), FALSE);
+
   if (data->hscrolling)
     gtk_kinetic_scrolling_free (data->hscrolling);
   if (data->vscrolling)
@@ -3315,6 +3320,12 @@ gtk_scrolled_window_start_deceleration (GtkScrolledWindow *scrolled_window)
                                    priv->y_velocity);
     }
 
+  /* Only the scroll offset changes from frame to frame now, so let
+   * the viewport scroll its content from cached textures
+   */
+  if (GTK_IS_VIEWPORT (priv->child))
+    gtk_viewport_set_cache_content (GTK_VIEWPORT (priv->child), TRUE);
+
   priv->deceleration_id = gtk_widget_add_tick_callback (GTK_WIDGET (scrolled_window),
                                                         scrolled_window_deceleration_cb, data,
                                                         (GDestroyNotify) kinetic_scroll_data_free);
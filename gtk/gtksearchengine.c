@@ -23,6 +23,7 @@
 #include "gtksearchengine.h"
 #include "gtksearchenginemodel.h"
 #include "gtksearchenginequartz.h"
+#include "gtksearchenginesimple.h"
 #include "gtkintl.h"
 
 #include <gdk/gdk.h> /* for GDK_WINDOWING_MACOS */
@@ -349,6 +350,13 @@ _gtk_search_engine_new (void)
     }
 #endif
 
+  if (!engine->priv->native)
+    {
+      engine->priv->native = _gtk_search_engine_simple_new ();
+      g_debug ("Using simple search engine");
+      connect_engine_signals (engine->priv->native, engine);
+    }
+
   engine->priv->hits = g_hash_table_new_full (search_hit_hash, search_hit_equal,
                                               (GDestroyNotify)_gtk_search_hit_free, NULL);
 
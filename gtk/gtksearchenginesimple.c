@@ -0,0 +1,413 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+
+#include "gtksearchenginesimple.h"
+#include "gtkquery.h"
+
+/* This engine is used when no indexer is available. It crawls the
+ * query location with a few threads that share a queue of directories
+ * still to be enumerated. Every thread takes a directory, enumerates
+ * it and queues the subdirectories it finds, so the crawl is spread
+ * over all threads no matter how the tree is shaped.
+ *
+ * Matches are handed to the main thread as soon as a directory is
+ * done, so results show up while the crawl goes on. They are passed
+ * without info, the file chooser queries the attributes it needs for
+ * the few files that match.
+ */
+
+#define N_CRAWLERS 4
+
+#define CRAWL_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                         G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME "," \
+                         G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                         G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+                         G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP
+
+typedef struct
+{
+  GtkSearchEngineSimple *engine; /* only valid while not cancelled */
+  GtkQuery *query;
+  GCancellable *cancellable;
+
+  GMutex lock;
+  GCond cond;
+
+  /* protected by lock */
+  GQueue directories;
+  guint n_busy;         /* crawlers enumerating a directory */
+  guint n_crawlers;     /* crawlers still running */
+  GList *hits;          /* not yet passed to the main thread */
+  guint send_hits_id;
+  gboolean got_results;
+} SearchThreadData;
+
+struct _GtkSearchEngineSimple
+{
+  GtkSearchEngine parent;
+
+  GtkQuery *query;
+
+  SearchThreadData *active_search;
+};
+
+struct _GtkSearchEngineSimpleClass
+{
+  GtkSearchEngineClass parent_class;
+};
+
+G_DEFINE_TYPE (GtkSearchEngineSimple, _gtk_search_engine_simple, GTK_TYPE_SEARCH_ENGINE)
+
+static SearchThreadData *
+search_thread_data_new (GtkSearchEngineSimple *engine,
+                        GtkQuery              *query)
+{
+  SearchThreadData *data;
+  GFile *location;
+
+  data = g_atomic_rc_box_new0 (SearchThreadData);
+  data->engine = engine;
+  data->cancellable = g_cancellable_new ();
+  g_mutex_init (&data->lock);
+  g_cond_init (&data->cond);
+  g_queue_init (&data->directories);
+
+  /* The crawlers get their own copy, so that the query can be
+   * changed while they run.
+   */
+  data->query = gtk_query_new ();
+  gtk_query_set_text (data->query, gtk_query_get_text (query));
+
+  location = gtk_query_get_location (query);
+  if (location)
+    g_object_ref (location);
+  else
+    location = g_file_new_for_path (g_get_home_dir ());
+
+  gtk_query_set_location (data->query, location);
+  g_queue_push_tail (&data->directories, location);
+
+  /* matching sets up some state on first use, do that here */
+  gtk_query_matches_string (data->query, "");
+
+  return data;
+}
+
+static void
+search_thread_data_clear (gpointer p)
+{
+  SearchThreadData *data = p;
+
+  g_object_unref (data->query);
+  g_object_unref (data->cancellable);
+  g_mutex_clear (&data->lock);
+  g_cond_clear (&data->cond);
+  g_queue_clear_full (&data->directories, g_object_unref);
+  g_list_free_full (data->hits, (GDestroyNotify) _gtk_search_hit_free);
+}
+
+static SearchThreadData *
+search_thread_data_ref (SearchThreadData *data)
+{
+  return g_atomic_rc_box_acquire (data);
+}
+
+static void
+search_thread_data_unref (SearchThreadData *data)
+{
+  g_atomic_rc_box_release_full (data, search_thread_data_clear);
+}
+
+/* Runs on the main thread, takes the lock */
+static GList *
+steal_hits (SearchThreadData *data)
+{
+  GList *hits;
+
+  g_mutex_lock (&data->lock);
+  hits = g_list_reverse (data->hits);
+  data->hits = NULL;
+  data->send_hits_id = 0;
+  g_mutex_unlock (&data->lock);
+
+  return hits;
+}
+
+static gboolean
+send_hits (gpointer user_data)
+{
+  SearchThreadData *data = user_data;
+  GList *hits;
+
+  hits = steal_hits (data);
+
+  if (hits && !g_cancellable_is_cancelled (data->cancellable))
+    _gtk_search_engine_hits_added (GTK_SEARCH_ENGINE (data->engine), hits);
+
+  g_list_free_full (hits, (GDestroyNotify) _gtk_search_hit_free);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+search_finished (gpointer user_data)
+{
+  SearchThreadData *data = user_data;
+
+  send_hits (data);
+
+  if (!g_cancellable_is_cancelled (data->cancellable))
+    {
+      if (data->engine->active_search == data)
+        {
+          data->engine->active_search = NULL;
+          search_thread_data_unref (data);
+        }
+
+      _gtk_search_engine_finished (GTK_SEARCH_ENGINE (data->engine), data->got_results);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called with the lock held */
+static void
+queue_hit (SearchThreadData *data,
+           GFile            *file)
+{
+  GtkSearchHit *hit;
+
+  hit = g_new (GtkSearchHit, 1);
+  hit->file = g_object_ref (file);
+  hit->info = NULL;
+
+  data->hits = g_list_prepend (data->hits, hit);
+  data->got_results = TRUE;
+
+  if (data->send_hits_id == 0)
+    {
+      data->send_hits_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                            send_hits,
+                                            search_thread_data_ref (data),
+                                            (GDestroyNotify) search_thread_data_unref);
+      g_source_set_name_by_id (data->send_hits_id, "[gtk] send_hits");
+    }
+}
+
+static void
+crawl_directory (SearchThreadData *data,
+                 GFile            *dir,
+                 GQueue           *subdirs,
+                 GQueue           *matches)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GFile *child;
+
+  enumerator = g_file_enumerate_children (dir,
+                                          CRAWL_ATTRIBUTES,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          data->cancellable,
+                                          NULL);
+  if (enumerator == NULL)
+    return;
+
+  while (g_file_enumerator_iterate (enumerator, &info, &child, data->cancellable, NULL))
+    {
+      const char *display_name;
+
+      if (info == NULL)
+        break;
+
+      if (g_file_info_get_is_hidden (info) || g_file_info_get_is_backup (info))
+        continue;
+
+      display_name = g_file_info_get_display_name (info);
+      if (display_name && gtk_query_matches_string (data->query, display_name))
+        g_queue_push_tail (matches, g_object_ref (child));
+
+      /* symlinks are not followed, so there are no loops */
+      if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+        g_queue_push_tail (subdirs, g_object_ref (child));
+    }
+
+  g_object_unref (enumerator);
+}
+
+static gpointer
+crawler_thread (gpointer user_data)
+{
+  SearchThreadData *data = user_data;
+  GQueue subdirs = G_QUEUE_INIT;
+  GQueue matches = G_QUEUE_INIT;
+  GFile *dir;
+
+  g_mutex_lock (&data->lock);
+
+  while (TRUE)
+    {
+      while (g_queue_is_empty (&data->directories) &&
+             data->n_busy > 0 &&
+             !g_cancellable_is_cancelled (data->cancellable))
+        g_cond_wait (&data->cond, &data->lock);
+
+      if (g_cancellable_is_cancelled (data->cancellable) ||
+          g_queue_is_empty (&data->directories))
+        break;
+
+      /* Taking the most recently found directory keeps the
+       * crawl depth-first, which is kinder to disk caches.
+       */
+      dir = g_queue_pop_tail (&data->directories);
+      data->n_busy++;
+
+      g_mutex_unlock (&data->lock);
+
+      crawl_directory (data, dir, &subdirs, &matches);
+      g_object_unref (dir);
+
+      g_mutex_lock (&data->lock);
+
+      data->n_busy--;
+
+      while (!g_queue_is_empty (&matches))
+        {
+          GFile *file = g_queue_pop_head (&matches);
+          queue_hit (data, file);
+          g_object_unref (file);
+        }
+
+      while (!g_queue_is_empty (&subdirs))
+        g_queue_push_tail (&data->directories, g_queue_pop_head (&subdirs));
+
+      /* wake up idle crawlers for the new work, or to let them
+       * know that there is none left
+       */
+      g_cond_broadcast (&data->cond);
+    }
+
+  g_cond_broadcast (&data->cond);
+
+  data->n_crawlers--;
+  if (data->n_crawlers == 0)
+    {
+      guint id;
+
+      id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                            search_finished,
+                            search_thread_data_ref (data),
+                            (GDestroyNotify) search_thread_data_unref);
+      g_source_set_name_by_id (id, "[gtk] search_finished");
+    }
+
+  g_mutex_unlock (&data->lock);
+
+  search_thread_data_unref (data);
+
+  return NULL;
+}
+
+static void
+gtk_search_engine_simple_start (GtkSearchEngine *engine)
+{
+  GtkSearchEngineSimple *simple;
+  SearchThreadData *data;
+  guint i;
+
+  simple = GTK_SEARCH_ENGINE_SIMPLE (engine);
+
+  if (simple->active_search != NULL || simple->query == NULL)
+    return;
+
+  data = search_thread_data_new (simple, simple->query);
+  data->n_crawlers = N_CRAWLERS;
+
+  for (i = 0; i < N_CRAWLERS; i++)
+    g_thread_unref (g_thread_new ("gtk-search-crawler",
+                                  crawler_thread,
+                                  search_thread_data_ref (data)));
+
+  simple->active_search = data;
+}
+
+static void
+gtk_search_engine_simple_stop (GtkSearchEngine *engine)
+{
+  GtkSearchEngineSimple *simple = GTK_SEARCH_ENGINE_SIMPLE (engine);
+  SearchThreadData *data = simple->active_search;
+
+  if (data == NULL)
+    return;
+
+  g_cancellable_cancel (data->cancellable);
+
+  g_mutex_lock (&data->lock);
+  g_cond_broadcast (&data->cond);
+  g_mutex_unlock (&data->lock);
+
+  simple->active_search = NULL;
+  search_thread_data_unref (data);
+}
+
+static void
+gtk_search_engine_simple_set_query (GtkSearchEngine *engine,
+                                    GtkQuery        *query)
+{
+  GtkSearchEngineSimple *simple = GTK_SEARCH_ENGINE_SIMPLE (engine);
+
+  g_set_object (&simple->query, query);
+}
+
+static void
+gtk_search_engine_simple_dispose (GObject *object)
+{
+  GtkSearchEngineSimple *simple = GTK_SEARCH_ENGINE_SIMPLE (object);
+
+  gtk_search_engine_simple_stop (GTK_SEARCH_ENGINE (simple));
+
+  g_clear_object (&simple->query);
+
+  G_OBJECT_CLASS (_gtk_search_engine_simple_parent_class)->dispose (object);
+}
+
+static void
+_gtk_search_engine_simple_class_init (GtkSearchEngineSimpleClass *class)
+{
+  GObjectClass *gobject_class;
+  GtkSearchEngineClass *engine_class;
+
+  gobject_class = G_OBJECT_CLASS (class);
+  gobject_class->dispose = gtk_search_engine_simple_dispose;
+
+  engine_class = GTK_SEARCH_ENGINE_CLASS (class);
+  engine_class->set_query = gtk_search_engine_simple_set_query;
+  engine_class->start = gtk_search_engine_simple_start;
+  engine_class->stop = gtk_search_engine_simple_stop;
+}
+
+static void
+_gtk_search_engine_simple_init (GtkSearchEngineSimple *engine)
+{
+}
+
+GtkSearchEngine *
+_gtk_search_engine_simple_new (void)
+{
+  return g_object_new (GTK_TYPE_SEARCH_ENGINE_SIMPLE, NULL);
+}
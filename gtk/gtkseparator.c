@@ -153,6 +153,8 @@ gtk_separator_class_init (GtkSeparatorClass *class)
   g_object_class_override_property (object_class, PROP_ORIENTATION, "orientation");
 
   gtk_widget_class_set_css_name (widget_class, I_("separator"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
+  gtk_widget_class_set_measure_equal_func (widget_class, gtk_widget_measure_equal_style);
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_SEPARATOR);
 }
 
@@ -118,6 +118,12 @@ struct _GtkSettings
   gboolean font_size_absolute;
   char *font_family;
   cairo_font_options_t *font_options;
+
+  /* Changes not yet applied, see queue_impact() */
+  guint pending_impact;
+  guint pending_system_settings;
+  guint pending_theme : 1;
+  guint apply_changes_id;
 };
 
 struct _GtkSettingsClass
@@ -987,6 +993,8 @@ gtk_settings_finalize (GObject *object)
 
   object_list = g_slist_remove (object_list, settings);
 
+  g_clear_handle_id (&settings->apply_changes_id, g_source_remove);
+
   for (i = 0; i < class_n_properties; i++)
     g_value_unset (&settings->property_values[i].value);
   g_free (settings->property_values);
@@ -1226,16 +1234,110 @@ settings_update_font_values (GtkSettings *settings)
     pango_font_description_free (desc);
 }
 
+/* How much of the UI has to be updated when a setting changes.
+ * Settings with no impact are read when needed, or by the widgets
+ * that connect to their notify signal.
+ */
+typedef enum {
+  SETTING_IMPACT_NONE  = 0,
+  SETTING_IMPACT_PAINT = 1 << 0, /* text renders differently, sizes stay */
+  SETTING_IMPACT_STYLE = 1 << 1, /* styles have to be recomputed */
+  SETTING_IMPACT_FONT  = 1 << 2, /* text has to be measured again */
+} SettingImpact;
+
+static SettingImpact
+settings_get_impact (guint property_id)
+{
+  switch (property_id)
+    {
+    case PROP_XFT_ANTIALIAS:
+    case PROP_XFT_HINTING:
+    case PROP_XFT_HINTSTYLE:
+    case PROP_XFT_RGBA:
+      return SETTING_IMPACT_PAINT;
+    case PROP_ENABLE_ANIMATIONS:
+      return SETTING_IMPACT_STYLE;
+    case PROP_FONT_NAME:
+      return SETTING_IMPACT_STYLE | SETTING_IMPACT_FONT;
+    case PROP_XFT_DPI:
+    case PROP_FONTCONFIG_TIMESTAMP:
+      return SETTING_IMPACT_FONT;
+    default:
+      return SETTING_IMPACT_NONE;
+    }
+}
+
+static gboolean
+settings_apply_changes (gpointer data)
+{
+  GtkSettings *settings = data;
+  guint impact = settings->pending_impact;
+  guint system_settings = settings->pending_system_settings;
+  gboolean theme = settings->pending_theme;
+  GtkSystemSetting setting;
+
+  settings->apply_changes_id = 0;
+  settings->pending_impact = 0;
+  settings->pending_system_settings = 0;
+  settings->pending_theme = FALSE;
+
+  /* Loading the theme restyles everything anyway */
+  if (theme)
+    settings_update_theme (settings);
+  else if (impact & SETTING_IMPACT_STYLE)
+    settings_invalidate_style (settings);
+
+  for (setting = GTK_SYSTEM_SETTING_DPI; setting <= GTK_SYSTEM_SETTING_ICON_THEME; setting++)
+    {
+      if (system_settings & (1 << setting))
+        gtk_system_setting_changed (settings->display, setting);
+    }
+
+  /* A font config change updates the font options as well */
+  if ((impact & SETTING_IMPACT_PAINT) &&
+      !(system_settings & (1 << GTK_SYSTEM_SETTING_FONT_CONFIG)))
+    gtk_font_options_changed (settings->display);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Changes are collected and applied together before the next frame,
+ * so that a batch of new settings, as sent by XSettings or the portal,
+ * causes a single restyle or relayout.
+ */
+static void
+queue_impact (GtkSettings      *settings,
+              guint             impact,
+              GtkSystemSetting  system_setting)
+{
+  settings->pending_impact |= impact;
+  if (impact & SETTING_IMPACT_FONT)
+    settings->pending_system_settings |= 1 << system_setting;
+
+  if (settings->apply_changes_id == 0)
+    {
+      settings->apply_changes_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                                    settings_apply_changes,
+                                                    settings,
+                                                    NULL);
+      g_source_set_name_by_id (settings->apply_changes_id, "[gtk] settings_apply_changes");
+    }
+}
+
 static void
 gtk_settings_notify (GObject    *object,
                      GParamSpec *pspec)
 {
   GtkSettings *settings = GTK_SETTINGS (object);
   guint property_id = pspec->param_id;
+  SettingImpact impact;
 
   if (settings->display == NULL) /* initialization */
     return;
 
+  /* Cached values are updated right away, so that getters
+   * see them. Invalidation is left to settings_apply_changes().
+   */
   switch (property_id)
     {
     case PROP_DOUBLE_CLICK_TIME:
@@ -1244,35 +1346,44 @@ gtk_settings_notify (GObject    *object,
       break;
     case PROP_FONT_NAME:
       settings_update_font_values (settings);
-      settings_invalidate_style (settings);
-      gtk_system_setting_changed (settings->display, GTK_SYSTEM_SETTING_FONT_NAME);
-      break;
-    case PROP_THEME_NAME:
-    case PROP_APPLICATION_PREFER_DARK_THEME:
-      settings_update_theme (settings);
-      break;
-    case PROP_XFT_DPI:
-      gtk_system_setting_changed (settings->display, GTK_SYSTEM_SETTING_DPI);
       break;
     case PROP_XFT_ANTIALIAS:
     case PROP_XFT_HINTING:
     case PROP_XFT_HINTSTYLE:
     case PROP_XFT_RGBA:
       settings_update_font_options (settings);
-      gtk_system_setting_changed (settings->display, GTK_SYSTEM_SETTING_FONT_CONFIG);
-      break;
-    case PROP_FONTCONFIG_TIMESTAMP:
-      if (settings_update_fontconfig (settings))
-        gtk_system_setting_changed (settings->display, GTK_SYSTEM_SETTING_FONT_CONFIG);
-      break;
-    case PROP_ENABLE_ANIMATIONS:
-      settings_invalidate_style (settings);
       break;
     case PROP_CURSOR_THEME_NAME:
     case PROP_CURSOR_THEME_SIZE:
       settings_update_cursor_theme (settings);
       break;
+    case PROP_THEME_NAME:
+    case PROP_APPLICATION_PREFER_DARK_THEME:
+      settings->pending_theme = TRUE;
+      queue_impact (settings, SETTING_IMPACT_STYLE, 0);
+      return;
+    case PROP_FONTCONFIG_TIMESTAMP:
+      if (!settings_update_fontconfig (settings))
+        return;
+      break;
+    default:
+      break;
+    }
+
+  impact = settings_get_impact (property_id);
+  if (impact == SETTING_IMPACT_NONE)
+    return;
+
+  switch (property_id)
+    {
+    case PROP_FONT_NAME:
+      queue_impact (settings, impact, GTK_SYSTEM_SETTING_FONT_NAME);
+      break;
+    case PROP_XFT_DPI:
+      queue_impact (settings, impact, GTK_SYSTEM_SETTING_DPI);
+      break;
     default:
+      queue_impact (settings, impact, GTK_SYSTEM_SETTING_FONT_CONFIG);
       break;
     }
 }
@@ -19,7 +19,7 @@
 
 #include "config.h"
 
-#include "gtkshortcut.h"
+#include "gtkshortcutprivate.h"
 
 #include "gtkintl.h"
 #include "gtkshortcutaction.h"
@@ -74,6 +74,11 @@ G_DEFINE_TYPE (GtkShortcut, gtk_shortcut, G_TYPE_OBJECT)
 
 static GParamSpec *properties[N_PROPS] = { NULL, };
 
+/* Bumped whenever any shortcut changes its trigger, so that
+ * shortcut controllers know to rebuild their trigger index
+ */
+static guint trigger_serial;
+
 static void
 gtk_shortcut_dispose (GObject *object)
 {
@@ -356,11 +361,18 @@ gtk_shortcut_set_trigger (GtkShortcut *self,
 
   if (g_set_object (&self->trigger, trigger))
     {
+      trigger_serial++;
       g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TRIGGER]);
       g_object_unref (trigger);
     }
 }
 
+guint
+gtk_shortcut_get_trigger_serial (void)
+{
+  return trigger_serial;
+}
+
 /**
  * gtk_shortcut_get_arguments:
  * @self: a #GtkShortcut
@@ -75,6 +75,7 @@
 #include "gtkintl.h"
 #include "gtkshortcut.h"
 #include "gtkshortcutmanager.h"
+#include "gtkshortcutprivate.h"
 #include "gtkshortcuttrigger.h"
 #include "gtktypebuiltins.h"
 #include "gtkwidgetprivate.h"
@@ -94,6 +95,15 @@ struct _GtkShortcutController
   guint custom_shortcuts : 1;
 
   guint last_activated;
+
+  /* Maps keyvals to the positions of the shortcuts whose
+   * triggers can match them; built on the first key event
+   * and dropped whenever the shortcuts change
+   */
+  GHashTable *trigger_index;
+  /* Positions of shortcuts with triggers we can't index */
+  GArray *unindexed;
+  guint trigger_serial;
 };
 
 struct _GtkShortcutControllerClass
@@ -175,6 +185,201 @@ G_DEFINE_TYPE_WITH_CODE (GtkShortcutController, gtk_shortcut_controller,
                          G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, gtk_shortcut_controller_list_model_init)
                          G_IMPLEMENT_INTERFACE (GTK_TYPE_BUILDABLE, gtk_shortcut_controller_buildable_init))
 
+static void
+gtk_shortcut_controller_clear_index (GtkShortcutController *self)
+{
+  g_clear_pointer (&self->trigger_index, g_hash_table_unref);
+  g_clear_pointer (&self->unindexed, g_array_unref);
+}
+
+static guint
+normalize_keyval (guint keyval)
+{
+  /* Matches what gdk_key_event_matches() and the mnemonic trigger
+   * do with Shift, so that both the event and the trigger side end
+   * up in the same bucket
+   */
+  if (keyval == GDK_KEY_ISO_Left_Tab)
+    return GDK_KEY_Tab;
+
+  return gdk_keyval_to_lower (keyval);
+}
+
+/* Collects the keyvals that @trigger can match. Returns %FALSE
+ * if the trigger can't be described by its keyvals, in which case
+ * it must always be tried.
+ */
+static gboolean
+collect_trigger_keyvals (GtkShortcutTrigger *trigger,
+                         GArray             *keyvals)
+{
+  guint keyval;
+
+  if (GTK_IS_KEYVAL_TRIGGER (trigger))
+    keyval = gtk_keyval_trigger_get_keyval (GTK_KEYVAL_TRIGGER (trigger));
+  else if (GTK_IS_MNEMONIC_TRIGGER (trigger))
+    keyval = gtk_mnemonic_trigger_get_keyval (GTK_MNEMONIC_TRIGGER (trigger));
+  else if (GTK_IS_ALTERNATIVE_TRIGGER (trigger))
+    return collect_trigger_keyvals (gtk_alternative_trigger_get_first (GTK_ALTERNATIVE_TRIGGER (trigger)), keyvals) &&
+           collect_trigger_keyvals (gtk_alternative_trigger_get_second (GTK_ALTERNATIVE_TRIGGER (trigger)), keyvals);
+  else if (GTK_IS_NEVER_TRIGGER (trigger))
+    return TRUE;
+  else
+    return FALSE;
+
+  keyval = normalize_keyval (keyval);
+  g_array_append_val (keyvals, keyval);
+
+  return TRUE;
+}
+
+static void
+gtk_shortcut_controller_ensure_index (GtkShortcutController *self)
+{
+  GArray *keyvals;
+  guint i, j, n;
+
+  if (self->trigger_index != NULL &&
+      self->trigger_serial == gtk_shortcut_get_trigger_serial ())
+    return;
+
+  gtk_shortcut_controller_clear_index (self);
+
+  self->trigger_index = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_array_unref);
+  self->unindexed = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->trigger_serial = gtk_shortcut_get_trigger_serial ();
+
+  keyvals = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (i = 0, n = g_list_model_get_n_items (self->shortcuts); i < n; i++)
+    {
+      gpointer item = g_list_model_get_item (self->shortcuts, i);
+
+      /* Anything that isn't a shortcut never triggers */
+      if (!GTK_IS_SHORTCUT (item))
+        {
+          g_object_unref (item);
+          continue;
+        }
+
+      g_array_set_size (keyvals, 0);
+      if (!collect_trigger_keyvals (gtk_shortcut_get_trigger (item), keyvals))
+        {
+          g_array_append_val (self->unindexed, i);
+          g_object_unref (item);
+          continue;
+        }
+
+      for (j = 0; j < keyvals->len; j++)
+        {
+          gpointer key = GUINT_TO_POINTER (g_array_index (keyvals, guint, j));
+          GArray *bucket;
+
+          bucket = g_hash_table_lookup (self->trigger_index, key);
+          if (bucket == NULL)
+            {
+              bucket = g_array_new (FALSE, FALSE, sizeof (guint));
+              g_hash_table_insert (self->trigger_index, key, bucket);
+            }
+          else if (g_array_index (bucket, guint, bucket->len - 1) == i)
+            continue;
+
+          g_array_append_val (bucket, i);
+        }
+
+      g_object_unref (item);
+    }
+
+  g_array_unref (keyvals);
+}
+
+static void
+add_candidates (GArray *candidates,
+                GArray *positions,
+                guint   offset,
+                guint   n_items)
+{
+  guint i;
+
+  for (i = 0; i < positions->len; i++)
+    {
+      guint position = g_array_index (positions, guint, i);
+      guint rotated = (position + n_items - offset) % n_items;
+
+      g_array_append_val (candidates, rotated);
+    }
+}
+
+static void
+add_candidates_for_keyval (GtkShortcutController *self,
+                           GArray                *candidates,
+                           guint                  keyval,
+                           guint                  offset,
+                           guint                  n_items)
+{
+  GArray *bucket;
+
+  bucket = g_hash_table_lookup (self->trigger_index, GUINT_TO_POINTER (normalize_keyval (keyval)));
+  if (bucket)
+    add_candidates (candidates, bucket, offset, n_items);
+}
+
+static int
+compare_candidates (gconstpointer a,
+                    gconstpointer b)
+{
+  guint pos_a = *(const guint *) a;
+  guint pos_b = *(const guint *) b;
+
+  return pos_a < pos_b ? -1 : (pos_a > pos_b);
+}
+
+/* Returns the shortcuts that may trigger for @event, as offsets
+ * from the last activated shortcut, in ascending order and possibly
+ * with duplicates.
+ *
+ * Besides the keyval of the event, shortcuts can match any keyval
+ * on the same key in a different layout, so we look those up too.
+ */
+static GArray *
+gtk_shortcut_controller_get_candidates (GtkShortcutController *self,
+                                        GdkEvent              *event)
+{
+  GArray *candidates;
+  guint n_items, offset;
+  guint *keyvals;
+  int i, n_keyvals;
+
+  candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  n_items = g_list_model_get_n_items (self->shortcuts);
+  if (n_items == 0)
+    return candidates;
+
+  gtk_shortcut_controller_ensure_index (self);
+
+  offset = (self->last_activated + 1) % n_items;
+
+  add_candidates (candidates, self->unindexed, offset, n_items);
+  add_candidates_for_keyval (self, candidates, gdk_key_event_get_keyval (event), offset, n_items);
+
+  if (gdk_display_map_keycode (gdk_event_get_display (event),
+                               gdk_key_event_get_keycode (event),
+                               NULL,
+                               &keyvals,
+                               &n_keyvals))
+    {
+      for (i = 0; i < n_keyvals; i++)
+        add_candidates_for_keyval (self, candidates, keyvals[i], offset, n_items);
+
+      g_free (keyvals);
+    }
+
+  g_array_sort (candidates, compare_candidates);
+
+  return candidates;
+}
+
 static gboolean
 gtk_shortcut_controller_is_rooted (GtkShortcutController *self)
 {
@@ -214,6 +419,7 @@ gtk_shortcut_controller_set_property (GObject      *object,
             self->custom_shortcuts = FALSE;
           }
         g_signal_connect_swapped (self->shortcuts, "items-changed", G_CALLBACK (g_list_model_items_changed), self);
+        g_signal_connect_swapped (self->shortcuts, "items-changed", G_CALLBACK (gtk_shortcut_controller_clear_index), self);
       }
       break;
 
@@ -266,7 +472,9 @@ gtk_shortcut_controller_finalize (GObject *object)
   GtkShortcutController *self = GTK_SHORTCUT_CONTROLLER (object);
 
   g_signal_handlers_disconnect_by_func (self->shortcuts, g_list_model_items_changed, self);
+  g_signal_handlers_disconnect_by_func (self->shortcuts, gtk_shortcut_controller_clear_index, self);
   g_clear_object (&self->shortcuts);
+  gtk_shortcut_controller_clear_index (self);
 
   G_OBJECT_CLASS (gtk_shortcut_controller_parent_class)->finalize (object);
 }
@@ -294,11 +502,14 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
 {
   GtkShortcutController *self = GTK_SHORTCUT_CONTROLLER (controller);
   int i, p;
+  GArray *candidates;
   GArray *shortcuts = NULL;
   gboolean has_exact = FALSE;
   gboolean retval = FALSE;
 
-  for (i = 0, p = g_list_model_get_n_items (self->shortcuts); i < p; i++)
+  candidates = gtk_shortcut_controller_get_candidates (self, event);
+
+  for (i = 0; i < candidates->len; i++)
     {
       GtkShortcut *shortcut;
       ShortcutData *data;
@@ -306,7 +517,11 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
       GtkWidget *widget;
       GtkNative *native;
 
-      index = (self->last_activated + 1 + i) % g_list_model_get_n_items (self->shortcuts);
+      if (i > 0 &&
+          g_array_index (candidates, guint, i) == g_array_index (candidates, guint, i - 1))
+        continue;
+
+      index = (self->last_activated + 1 + g_array_index (candidates, guint, i)) % g_list_model_get_n_items (self->shortcuts);
       shortcut = g_list_model_get_item (self->shortcuts, index);
       if (!GTK_IS_SHORTCUT (shortcut))
         {
@@ -387,6 +602,8 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
     }
 #endif
 
+  g_array_unref (candidates);
+
   if (!shortcuts)
     return retval;
 
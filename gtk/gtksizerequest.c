@@ -33,6 +33,51 @@
 #include "gtkcssnumbervalueprivate.h"
 #include "gtklayoutmanagerprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
+
+static int measure_cache_hits;
+static int measure_cache_misses;
+static int measure_shared;
+static guint measure_cache_hits_counter;
+static guint measure_cache_misses_counter;
+static guint measure_shared_counter;
+
+/* Nesting of gtk_widget_measure() calls, to only mark the outermost */
+static guint measure_depth;
+
+/* Per widget type statistics, only collected while profiling */
+typedef struct {
+  int hits;
+  int misses;
+  guint hits_counter;
+  guint misses_counter;
+} MeasureCacheStats;
+
+static GHashTable *measure_cache_type_stats; /* GType -> MeasureCacheStats */
+
+static void
+count_measure_cache_lookup (GtkWidget *widget,
+                            gboolean   found)
+{
+  GType type = G_OBJECT_TYPE (widget);
+  MeasureCacheStats *stats;
+
+  if (G_UNLIKELY (measure_cache_type_stats == NULL))
+    measure_cache_type_stats = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
+  stats = g_hash_table_lookup (measure_cache_type_stats, GSIZE_TO_POINTER (type));
+  if (stats == NULL)
+    {
+      stats = g_new0 (MeasureCacheStats, 1);
+      g_hash_table_insert (measure_cache_type_stats, GSIZE_TO_POINTER (type), stats);
+    }
+
+  if (found)
+    stats->hits++;
+  else
+    stats->misses++;
+}
 
 #ifdef G_ENABLE_CONSISTENCY_CHECKS
 static GQuark recursion_check_quark = 0;
@@ -170,6 +215,14 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                                                    &min_baseline,
                                                    &nat_baseline);
 
+  if (found_in_cache)
+    measure_cache_hits++;
+  else
+    measure_cache_misses++;
+
+  if (GDK_PROFILER_IS_RUNNING)
+    count_measure_cache_lookup (widget, found_in_cache);
+
   if (!found_in_cache)
     {
       GtkWidgetClass *widget_class;
@@ -406,6 +459,14 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                                       nat_size,
 				      min_baseline,
 				      nat_baseline);
+
+      gtk_widget_check_request_changed (widget,
+                                        orientation,
+                                        for_size,
+                                        min_size,
+                                        nat_size,
+                                        min_baseline,
+                                        nat_baseline);
     }
 
   if (minimum)
@@ -477,6 +538,9 @@ gtk_widget_measure (GtkWidget        *widget,
                     int              *minimum_baseline,
                     int              *natural_baseline)
 {
+  gint64 before = 0;
+  int misses_before = 0;
+
   g_return_if_fail (GTK_IS_WIDGET (widget));
   g_return_if_fail (for_size >= -1);
   g_return_if_fail (orientation == GTK_ORIENTATION_HORIZONTAL ||
@@ -499,6 +563,13 @@ gtk_widget_measure (GtkWidget        *widget,
       return;
     }
 
+  if (measure_depth == 0 && gdk_profiler_is_collecting ())
+    {
+      before = GDK_PROFILER_CURRENT_TIME;
+      misses_before = measure_cache_misses;
+    }
+  measure_depth++;
+
   if (G_LIKELY (!_gtk_widget_get_sizegroups (widget)))
     {
       gtk_widget_query_size_for_orientation (widget, orientation, for_size, minimum, natural,
@@ -541,6 +612,119 @@ gtk_widget_measure (GtkWidget        *widget,
       if (natural)
         *natural = nat_result;
     }
+
+  measure_depth--;
+
+  /* Measuring from the cache is not worth a mark */
+  if (before != 0 && measure_cache_misses != misses_before)
+    gdk_profiler_end_mark (before, "measure", G_OBJECT_TYPE_NAME (widget));
+}
+
+/*< private >
+ * gtk_widget_measure_shared:
+ * @widget: A #GtkWidget instance
+ * @orientation: the orientation to measure
+ * @for_size: Size for the opposite of @orientation
+ * @share: the last measurement of the calling loop, zeroed before
+ *   the first call
+ * @minimum: (out) (optional): location to store the minimum size, or %NULL
+ * @natural: (out) (optional): location to store the natural size, or %NULL
+ * @minimum_baseline: (out) (optional): location to store the baseline
+ *   position for the minimum size, or %NULL
+ * @natural_baseline: (out) (optional): location to store the baseline
+ *   position for the natural size, or %NULL
+ *
+ * Like gtk_widget_measure(), but when @widget measures the same as the
+ * widget measured in the previous call with @share, the sizes of that
+ * widget are reused, see gtk_widget_measure_equal().
+ *
+ * Layout managers use this for children that are often identical,
+ * like the buttons of a toolbar. The reused sizes are stored in the
+ * size request cache of @widget as if it had been measured.
+ */
+void
+gtk_widget_measure_shared (GtkWidget       *widget,
+                           GtkOrientation   orientation,
+                           int              for_size,
+                           GtkMeasureShare *share,
+                           int             *minimum,
+                           int             *natural,
+                           int             *minimum_baseline,
+                           int             *natural_baseline)
+{
+  int min_size, nat_size;
+  int min_baseline, nat_baseline;
+  gboolean shareable;
+
+  shareable = _gtk_widget_get_visible (widget) &&
+              !_gtk_widget_get_sizegroups (widget);
+
+  if (shareable &&
+      share->widget != NULL &&
+      share->orientation == orientation &&
+      share->for_size == for_size &&
+      gtk_widget_measure_equal (widget, share->widget))
+    {
+      SizeRequestCache *cache;
+      int cache_for_size = for_size;
+
+      gtk_widget_ensure_resize (widget);
+
+      cache = _gtk_widget_peek_request_cache (widget);
+      if (G_UNLIKELY (!cache->request_mode_valid))
+        {
+          cache->request_mode = fetch_request_mode (widget);
+          cache->request_mode_valid = TRUE;
+        }
+
+      if (cache->request_mode == GTK_SIZE_REQUEST_CONSTANT_SIZE)
+        cache_for_size = -1;
+
+      min_size = share->minimum;
+      nat_size = share->natural;
+      min_baseline = share->minimum_baseline;
+      nat_baseline = share->natural_baseline;
+
+      if (!_gtk_size_request_cache_lookup (cache, orientation, cache_for_size,
+                                           &min_size, &nat_size,
+                                           &min_baseline, &nat_baseline))
+        {
+          measure_shared++;
+
+          _gtk_size_request_cache_commit (cache, orientation, cache_for_size,
+                                          min_size, nat_size,
+                                          min_baseline, nat_baseline);
+          gtk_widget_check_request_changed (widget, orientation, cache_for_size,
+                                            min_size, nat_size,
+                                            min_baseline, nat_baseline);
+        }
+    }
+  else
+    {
+      gtk_widget_measure (widget, orientation, for_size,
+                          &min_size, &nat_size,
+                          &min_baseline, &nat_baseline);
+
+      if (shareable)
+        {
+          share->widget = widget;
+          share->orientation = orientation;
+          share->for_size = for_size;
+          share->minimum = min_size;
+          share->natural = nat_size;
+          share->minimum_baseline = min_baseline;
+          share->natural_baseline = nat_baseline;
+        }
+    }
+
+  if (minimum)
+    *minimum = min_size;
+  if (natural)
+    *natural = nat_size;
+  if (minimum_baseline)
+    *minimum_baseline = min_baseline;
+  if (natural_baseline)
+    *natural_baseline = nat_baseline;
 }
 
 /**
@@ -748,3 +932,62 @@ gtk_distribute_natural_allocation (int               extra_space,
 
   return extra_space;
 }
+
+/* Pushes the measure cache statistics since the last call to sysprof */
+void
+gtk_size_request_push_profiler_counters (void)
+{
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (measure_cache_hits_counter == 0)
+        {
+          measure_cache_hits_counter = gdk_profiler_define_int_counter ("measure-cache-hits", "Size Request Cache Hits");
+          measure_cache_misses_counter = gdk_profiler_define_int_counter ("measure-cache-misses", "Size Request Cache Misses");
+          measure_shared_counter = gdk_profiler_define_int_counter ("measure-shared", "Sizes shared between identical siblings");
+        }
+
+      gdk_profiler_set_int_counter (measure_cache_hits_counter, measure_cache_hits);
+      gdk_profiler_set_int_counter (measure_cache_misses_counter, measure_cache_misses);
+      gdk_profiler_set_int_counter (measure_shared_counter, measure_shared);
+
+      if (measure_cache_type_stats)
+        {
+          GHashTableIter iter;
+          gpointer key, value;
+
+          g_hash_table_iter_init (&iter, measure_cache_type_stats);
+          while (g_hash_table_iter_next (&iter, &key, &value))
+            {
+              MeasureCacheStats *stats = value;
+              const char *type_name = g_type_name (GPOINTER_TO_SIZE (key));
+
+              if (stats->hits_counter == 0)
+                {
+                  char *name, *description;
+
+                  name = g_strdup_printf ("%s hits", type_name);
+                  description = g_strdup_printf ("Size Request Cache Hits for %s", type_name);
+                  stats->hits_counter = gdk_profiler_define_int_counter (name, description);
+                  g_free (name);
+                  g_free (description);
+
+                  name = g_strdup_printf ("%s misses", type_name);
+                  description = g_strdup_printf ("Size Request Cache Misses for %s", type_name);
+                  stats->misses_counter = gdk_profiler_define_int_counter (name, description);
+                  g_free (name);
+                  g_free (description);
+                }
+
+              gdk_profiler_set_int_counter (stats->hits_counter, stats->hits);
+              gdk_profiler_set_int_counter (stats->misses_counter, stats->misses);
+
+              stats->hits = 0;
+              stats->misses = 0;
+            }
+        }
+    }
+
+  measure_cache_hits = 0;
+  measure_cache_misses = 0;
+  measure_shared = 0;
+}
@@ -23,6 +23,8 @@
 
 #include "gtksizerequestcacheprivate.h"
 
+#include "gdk/gdkallocstatsprivate.h"
+
 #include <string.h>
 
 void
@@ -31,42 +33,133 @@ _gtk_size_request_cache_init (SizeRequestCache *cache)
   memset (cache, 0, sizeof (SizeRequestCache));
 }
 
+static guint
+get_n_allocated (const SizeRequestCache *cache,
+                 GtkOrientation          orientation)
+{
+  if (cache->flags[orientation].n_allocated)
+    return cache->flags[orientation].n_allocated;
+
+  return GTK_SIZE_REQUEST_CACHED_SIZES;
+}
+
 static void
-free_sizes_x (SizeRequestX **sizes)
+free_sizes_x (SizeRequestX **sizes,
+              guint          n_allocated)
 {
-  int i;
+  guint i;
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
-    g_slice_free (SizeRequestX, sizes[i]);
+  for (i = 0; i < n_allocated && sizes[i] != NULL; i++)
+    {
+      gdk_alloc_stats_remove (GDK_ALLOC_SIZE_REQUEST, sizeof (SizeRequestX));
+      g_slice_free (SizeRequestX, sizes[i]);
+    }
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  gdk_alloc_stats_remove (GDK_ALLOC_SIZE_REQUEST, sizeof (SizeRequestX *) * n_allocated);
+  g_slice_free1 (sizeof (SizeRequestX *) * n_allocated, sizes);
 }
 
 static void
-free_sizes_y (SizeRequestY **sizes)
+free_sizes_y (SizeRequestY **sizes,
+              guint          n_allocated)
 {
-  int i;
+  guint i;
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
-    g_slice_free (SizeRequestY, sizes[i]);
+  for (i = 0; i < n_allocated && sizes[i] != NULL; i++)
+    {
+      gdk_alloc_stats_remove (GDK_ALLOC_SIZE_REQUEST, sizeof (SizeRequestY));
+      g_slice_free (SizeRequestY, sizes[i]);
+    }
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  gdk_alloc_stats_remove (GDK_ALLOC_SIZE_REQUEST, sizeof (SizeRequestY *) * n_allocated);
+  g_slice_free1 (sizeof (SizeRequestY *) * n_allocated, sizes);
 }
 
 void
 _gtk_size_request_cache_free (SizeRequestCache *cache)
 {
   if (cache->requests_x)
-    free_sizes_x (cache->requests_x);
+    free_sizes_x (cache->requests_x, get_n_allocated (cache, GTK_ORIENTATION_HORIZONTAL));
   if (cache->requests_y)
-    free_sizes_y (cache->requests_y);
+    free_sizes_y (cache->requests_y, get_n_allocated (cache, GTK_ORIENTATION_VERTICAL));
 }
 
 void
 _gtk_size_request_cache_clear (SizeRequestCache *cache)
 {
+  guint n_allocated_x, n_allocated_y;
+
+  /* Keep the grown size, the widget is likely
+   * to be measured for many sizes again.
+   */
+  n_allocated_x = cache->flags[GTK_ORIENTATION_HORIZONTAL].n_allocated;
+  n_allocated_y = cache->flags[GTK_ORIENTATION_VERTICAL].n_allocated;
+
   _gtk_size_request_cache_free (cache);
   _gtk_size_request_cache_init (cache);
+
+  cache->flags[GTK_ORIENTATION_HORIZONTAL].n_allocated = n_allocated_x;
+  cache->flags[GTK_ORIENTATION_VERTICAL].n_allocated = n_allocated_y;
+}
+
+/* Picks the slot for a new cached request, replacing the
+ * oldest one when the cache is full. Once a whole cache
+ * worth of entries has been evicted, the cache is grown
+ * instead, up to GTK_SIZE_REQUEST_MAX_CACHED_SIZES.
+ */
+static guint
+pick_request_slot (SizeRequestCache *cache,
+                   GtkOrientation    orientation,
+                   gpointer        **requests)
+{
+  guint n_allocated, n_sizes;
+
+  n_allocated = get_n_allocated (cache, orientation);
+  n_sizes = cache->flags[orientation].n_cached_requests;
+
+  if (n_sizes == n_allocated &&
+      n_allocated < GTK_SIZE_REQUEST_MAX_CACHED_SIZES &&
+      cache->flags[orientation].n_evictions >= n_allocated)
+    {
+      guint new_allocated = MIN (n_allocated * 2, GTK_SIZE_REQUEST_MAX_CACHED_SIZES);
+
+      if (*requests)
+        {
+          gpointer *new_requests = g_slice_alloc0 (sizeof (gpointer) * new_allocated);
+
+          memcpy (new_requests, *requests, sizeof (gpointer) * n_allocated);
+          gdk_alloc_stats_remove (GDK_ALLOC_SIZE_REQUEST, sizeof (gpointer) * n_allocated);
+          g_slice_free1 (sizeof (gpointer) * n_allocated, *requests);
+          gdk_alloc_stats_add (GDK_ALLOC_SIZE_REQUEST, sizeof (gpointer) * new_allocated);
+          *requests = new_requests;
+        }
+
+      cache->flags[orientation].n_allocated = new_allocated;
+      cache->flags[orientation].n_evictions = 0;
+      n_allocated = new_allocated;
+    }
+
+  if (n_sizes < n_allocated)
+    {
+      cache->flags[orientation].n_cached_requests++;
+      cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
+    }
+  else
+    {
+      if (cache->flags[orientation].n_evictions < GTK_SIZE_REQUEST_MAX_CACHED_SIZES)
+        cache->flags[orientation].n_evictions++;
+
+      if (++cache->flags[orientation].last_cached_request == n_allocated)
+        cache->flags[orientation].last_cached_request = 0;
+    }
+
+  if (*requests == NULL)
+    {
+      *requests = g_slice_alloc0 (sizeof (gpointer) * n_allocated);
+      gdk_alloc_stats_add (GDK_ALLOC_SIZE_REQUEST, sizeof (gpointer) * n_allocated);
+    }
+
+  return cache->flags[orientation].last_cached_request;
 }
 
 void
@@ -130,26 +223,16 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	}
 
       /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
+       * will immediately be used to cache the new computed size */
+      i = pick_request_slot (cache, orientation, (gpointer **) &cache->requests_x);
 
-      if (cache->requests_x == NULL)
-	cache->requests_x = g_slice_alloc0 (sizeof (SizeRequestX *) * GTK_SIZE_REQUEST_CACHED_SIZES);
-
-      if (cache->requests_x[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_x[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestX);
+      if (cache->requests_x[i] == NULL)
+        {
+          cache->requests_x[i] = g_slice_new (SizeRequestX);
+          gdk_alloc_stats_add (GDK_ALLOC_SIZE_REQUEST, sizeof (SizeRequestX));
+        }
 
-      cached_size = cache->requests_x[cache->flags[orientation].last_cached_request];
+      cached_size = cache->requests_x[i];
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -174,26 +257,16 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	}
 
       /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
+       * will immediately be used to cache the new computed size */
+      i = pick_request_slot (cache, orientation, (gpointer **) &cache->requests_y);
 
-      if (cache->requests_y == NULL)
-	cache->requests_y = g_slice_alloc0 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES);
-
-      if (cache->requests_y[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_y[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestY);
+      if (cache->requests_y[i] == NULL)
+        {
+          cache->requests_y[i] = g_slice_new (SizeRequestY);
+          gdk_alloc_stats_add (GDK_ALLOC_SIZE_REQUEST, sizeof (SizeRequestY));
+        }
 
-      cached_size = cache->requests_y[cache->flags[orientation].last_cached_request];
+      cached_size = cache->requests_y[i];
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -38,6 +38,13 @@ G_BEGIN_DECLS
  */
 #define GTK_SIZE_REQUEST_CACHED_SIZES   (5)
 
+/* Widgets that keep evicting cached sizes, like
+ * wrapping labels in a flow box while the window
+ * is resized, get their cache grown up to this
+ * many entries per orientation.
+ */
+#define GTK_SIZE_REQUEST_MAX_CACHED_SIZES (40)
+
 typedef struct {
   int minimum_size;
   int natural_size;
@@ -74,8 +81,10 @@ typedef struct {
   GtkSizeRequestMode request_mode   : 3;
   guint       request_mode_valid    : 1;
   struct {
-    guint       n_cached_requests   : 3;
-    guint       last_cached_request : 3;
+    guint       n_cached_requests   : 6;
+    guint       last_cached_request : 6;
+    guint       n_allocated         : 6; /* 0 means GTK_SIZE_REQUEST_CACHED_SIZES */
+    guint       n_evictions         : 6;
     guint       cached_size_valid   : 1;
   }           flags[2];
 } SizeRequestCache;
@@ -38,6 +38,7 @@
 #define GDK_ARRAY_TYPE_NAME GtkSnapshotNodes
 #define GDK_ARRAY_ELEMENT_TYPE GskRenderNode *
 #define GDK_ARRAY_FREE_FUNC gsk_render_node_unref
+#define GDK_ARRAY_PREALLOC 32
 #include "gdk/gdkarrayimpl.c"
 
 /**
@@ -205,6 +206,22 @@ gtk_snapshot_collect_default (GtkSnapshot       *snapshot,
   return node;
 }
 
+/* Used for pushes that would not change anything, like an opacity
+ * of 1 or a blur radius of 0. Popping such a state moves its nodes
+ * to the parent, like gtk_snapshot_restore() does, so no node is
+ * created for it, not even a container.
+ */
+static GskRenderNode *
+gtk_snapshot_collect_passthrough (GtkSnapshot       *snapshot,
+                                  GtkSnapshotState  *state,
+                                  GskRenderNode    **nodes,
+                                  guint              n_nodes)
+{
+  g_assert_not_reached ();
+
+  return NULL;
+}
+
 static GtkSnapshotState *
 gtk_snapshot_push_state (GtkSnapshot            *snapshot,
                          GskTransform           *transform,
@@ -329,6 +346,14 @@ gtk_snapshot_free_to_paintable (GtkSnapshot           *snapshot,
   return result;
 }
 
+static void
+gtk_snapshot_push_passthrough (GtkSnapshot *snapshot)
+{
+  gtk_snapshot_push_state (snapshot,
+                           gtk_snapshot_get_current_state (snapshot)->transform,
+                           gtk_snapshot_collect_passthrough);
+}
+
 static GskRenderNode *
 gtk_snapshot_collect_autopush_transform (GtkSnapshot      *snapshot,
                                          GtkSnapshotState *state,
@@ -418,9 +443,7 @@ gtk_snapshot_push_debug (GtkSnapshot *snapshot,
     }
   else
     {
-      gtk_snapshot_push_state (snapshot,
-                               current_state->transform,
-                               gtk_snapshot_collect_default);
+      gtk_snapshot_push_passthrough (snapshot);
     }
 }
 
@@ -470,6 +493,12 @@ gtk_snapshot_push_opacity (GtkSnapshot *snapshot,
   GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
+  if (opacity >= 1.0)
+    {
+      gtk_snapshot_push_passthrough (snapshot);
+      return;
+    }
+
   state = gtk_snapshot_push_state (snapshot,
                                    current_state->transform,
                                    gtk_snapshot_collect_opacity);
@@ -517,6 +546,12 @@ gtk_snapshot_push_blur (GtkSnapshot *snapshot,
   const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
+  if (radius == 0.0)
+    {
+      gtk_snapshot_push_passthrough (snapshot);
+      return;
+    }
+
   state = gtk_snapshot_push_state (snapshot,
                                    current_state->transform,
                                    gtk_snapshot_collect_blur);
@@ -627,6 +662,13 @@ gtk_snapshot_push_color_matrix (GtkSnapshot             *snapshot,
   const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
+  if (graphene_matrix_is_identity (color_matrix) &&
+      graphene_vec4_equal (color_offset, graphene_vec4_zero ()))
+    {
+      gtk_snapshot_push_passthrough (snapshot);
+      return;
+    }
+
   state = gtk_snapshot_push_state (snapshot,
                                    current_state->transform,
                                    gtk_snapshot_collect_color_matrix);
@@ -1103,6 +1145,12 @@ gtk_snapshot_push_shadow (GtkSnapshot     *snapshot,
   const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
+  if (n_shadows == 0)
+    {
+      gtk_snapshot_push_passthrough (snapshot);
+      return;
+    }
+
   state = gtk_snapshot_push_state (snapshot,
                                    current_state->transform,
                                    gtk_snapshot_collect_shadow);
@@ -1308,7 +1356,8 @@ gtk_snapshot_pop_one (GtkSnapshot *snapshot)
   state = gtk_snapshot_get_current_state (snapshot);
   state_index = gtk_snapshot_states_get_size (&snapshot->state_stack) - 1;
 
-  if (state->collect_func)
+  if (state->collect_func &&
+      state->collect_func != gtk_snapshot_collect_passthrough)
     {
       node = state->collect_func (snapshot,
                                   state,
@@ -95,6 +95,34 @@ gtk_sort_keys_needs_clear_key (GtkSortKeys *self)
   return self->klass->clear_key != NULL;
 }
 
+gboolean
+gtk_sort_keys_has_threadsafe_compare (GtkSortKeys *self)
+{
+  return self->klass->threadsafe_compare;
+}
+
+/*<private>
+ * gtk_sort_keys_can_convert:
+ * @self: the new sort keys
+ * @other: the sort keys that were used before
+ *
+ * Checks if keys created by @other can be converted to keys for @self
+ * with gtk_sort_keys_convert_key(), which is cheaper than creating
+ * them from scratch. This is only interesting if @self and @other
+ * are not compatible.
+ *
+ * Returns: %TRUE if keys can be converted
+ **/
+gboolean
+gtk_sort_keys_can_convert (GtkSortKeys *self,
+                           GtkSortKeys *other)
+{
+  if (self->klass->can_convert == NULL)
+    return FALSE;
+
+  return self->klass->can_convert (self, other);
+}
+
 static void
 gtk_equal_sort_keys_free (GtkSortKeys *keys)
 {
@@ -48,6 +48,18 @@ struct _GtkSortKeysClass
                                                                  gpointer                key_memory);
   void                  (* clear_key)                           (GtkSortKeys            *self,
                                                                  gpointer                key_memory);
+
+  /* key_compare only looks at the key memory and may be called from other threads */
+  gboolean threadsafe_compare;
+
+  /* optional: create keys reusing parts of keys from incompatible other keys */
+  gboolean              (* can_convert)                         (GtkSortKeys            *self,
+                                                                 GtkSortKeys            *other);
+  void                  (* convert_key)                         (GtkSortKeys            *self,
+                                                                 gpointer                item,
+                                                                 gpointer                key_memory,
+                                                                 GtkSortKeys            *other,
+                                                                 gpointer                other_key_memory);
 };
 
 GtkSortKeys *           gtk_sort_keys_alloc                     (const GtkSortKeysClass *klass,
@@ -67,6 +79,9 @@ GCompareDataFunc        gtk_sort_keys_get_key_compare_func      (GtkSortKeys
 gboolean                gtk_sort_keys_is_compatible             (GtkSortKeys            *self,
                                                                  GtkSortKeys            *other);
 gboolean                gtk_sort_keys_needs_clear_key           (GtkSortKeys            *self);
+gboolean                gtk_sort_keys_has_threadsafe_compare    (GtkSortKeys            *self);
+gboolean                gtk_sort_keys_can_convert               (GtkSortKeys            *self,
+                                                                 GtkSortKeys            *other);
 
 #define GTK_SORT_KEYS_ALIGN(_size,_align) (((_size) + (_align) - 1) & ~((_align) - 1))
 static inline int
@@ -93,5 +108,17 @@ gtk_sort_keys_clear_key (GtkSortKeys *self,
     self->klass->clear_key (self, key_memory);
 }
 
+/* Initializes a key for @item, moving over what it can from @other_key_memory
+ * and clearing the rest of it. Only valid if gtk_sort_keys_can_convert() */
+static inline void
+gtk_sort_keys_convert_key (GtkSortKeys *self,
+                           gpointer     item,
+                           gpointer     key_memory,
+                           GtkSortKeys *other,
+                           gpointer     other_key_memory)
+{
+  self->klass->convert_key (self, item, key_memory, other, other_key_memory);
+}
+
 #endif /* __GTK_SORT_KEYS_PRIVATE_H__ */
 
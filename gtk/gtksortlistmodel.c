@@ -27,6 +27,8 @@
 #include "gtksorterprivate.h"
 #include "timsort/gtktimsortprivate.h"
 
+#include "gdk/gdkparallelprivate.h"
+
 /* The maximum amount of items to merge for a single merge step
  *
  * Making this smaller will result in more steps, which has more overhead and slows
@@ -52,6 +54,13 @@
  */
 #define GTK_SORT_STEP_TIME_US (1000) /* 1 millisecond */
 
+/* The minimum amount of items each thread sorts when sorting in parallel
+ *
+ * Large non-incremental sorts with keys that can be compared from any thread
+ * sort this many items per core first, and then merge the results.
+ */
+#define GTK_SORT_MIN_ITEMS_PER_JOB (16384)
+
 /**
  * SECTION:gtksortlistmodel
  * @title: GtkSortListModel
@@ -96,6 +105,7 @@ struct _GtkSortListModel
   GtkSortKeys *sort_keys;
   gsize key_size;
   gpointer keys;
+  guint n_keys_allocated; /* so appending doesn't move the keys every time */
   GtkBitset *missing_keys;
 
   gpointer *positions;
@@ -302,6 +312,127 @@ sort_func (gconstpointer a,
   return *sa < *sb ? -1 : 1;
 }
 
+typedef struct _SortJob SortJob;
+
+struct _SortJob
+{
+  GtkSortKeys *sort_keys;
+  gpointer *base;
+  gsize len;
+  gpointer *start_change;
+  gpointer *end_change;
+};
+
+static void
+sort_job_func (gpointer data,
+               gpointer user_data)
+{
+  SortJob *job = data;
+  GtkTimSort sort;
+  GtkTimSortRun change;
+
+  job->start_change = job->base + job->len;
+  job->end_change = job->base;
+
+  gtk_tim_sort_init (&sort, job->base, job->len, sizeof (gpointer), sort_func, job->sort_keys);
+  while (gtk_tim_sort_step (&sort, &change))
+    {
+      if (change.len)
+        {
+          job->start_change = MIN (job->start_change, (gpointer *) change.base);
+          job->end_change = MAX (job->end_change, ((gpointer *) change.base) + change.len);
+        }
+    }
+  gtk_tim_sort_finish (&sort);
+}
+
+/* Splits a fresh sort into one chunk per core and sorts those in
+ * threads, leaving only the merges of the chunks to the main sort.
+ * Keys are still created here, as items and expressions must not be
+ * touched outside the main thread.
+ * Returns %FALSE if the sort isn't worth splitting, otherwise the
+ * range of items that changed.
+ */
+static gboolean
+gtk_sort_list_model_presort (GtkSortListModel *self,
+                             guint            *out_position,
+                             guint            *out_n_items)
+{
+  gsize runs[GTK_TIM_SORT_MAX_PENDING + 1];
+  gpointer *start_change, *end_change;
+  SortJob *jobs;
+  guint n_jobs, per_job, i;
+
+  if (!gtk_sort_keys_has_threadsafe_compare (self->sort_keys))
+    return FALSE;
+
+  n_jobs = MIN (gtk_get_n_threads (), self->n_items / GTK_SORT_MIN_ITEMS_PER_JOB);
+  n_jobs = MIN (n_jobs, GTK_TIM_SORT_MAX_PENDING);
+  if (n_jobs <= 1)
+    return FALSE;
+
+  /* only split sorts that don't resume previous work */
+  gtk_tim_sort_get_runs (&self->sort, runs);
+  if (runs[0] != 0)
+    return FALSE;
+
+  if (!gtk_bitset_is_empty (self->missing_keys))
+    {
+      GtkBitsetIter iter;
+      guint pos;
+
+      for (gtk_bitset_iter_init_first (&iter, self->missing_keys, &pos);
+           gtk_bitset_iter_is_valid (&iter);
+           gtk_bitset_iter_next (&iter, &pos))
+        {
+          gpointer item = g_list_model_get_item (self->model, pos);
+          gtk_sort_keys_init_key (self->sort_keys, item, key_from_pos (self, pos));
+          g_object_unref (item);
+        }
+      gtk_bitset_remove_all (self->missing_keys);
+    }
+
+  per_job = (self->n_items + n_jobs - 1) / n_jobs;
+  jobs = g_newa (SortJob, n_jobs);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].sort_keys = self->sort_keys;
+      jobs[i].base = self->positions + i * per_job;
+      jobs[i].len = MIN (per_job, self->n_items - i * per_job);
+      runs[i] = jobs[i].len;
+    }
+  runs[n_jobs] = 0;
+
+  gdk_parallel_run (jobs, sizeof (SortJob), n_jobs, sort_job_func, NULL);
+
+  start_change = self->positions + self->n_items;
+  end_change = self->positions;
+  for (i = 0; i < n_jobs; i++)
+    {
+      if (jobs[i].start_change < jobs[i].end_change)
+        {
+          start_change = MIN (start_change, jobs[i].start_change);
+          end_change = MAX (end_change, jobs[i].end_change);
+        }
+    }
+
+  if (start_change < end_change)
+    {
+      *out_position = start_change - self->positions;
+      *out_n_items = end_change - start_change;
+    }
+  else
+    {
+      *out_position = 0;
+      *out_n_items = 0;
+    }
+
+  gtk_tim_sort_set_runs (&self->sort, runs);
+
+  return TRUE;
+}
+
 static gboolean
 gtk_sort_list_model_start_sorting (GtkSortListModel *self,
                                    gsize            *runs)
@@ -332,11 +463,32 @@ gtk_sort_list_model_finish_sorting (GtkSortListModel *self,
                                     guint            *pos,
                                     guint            *n_items)
 {
+  guint presort_pos, presort_n_items;
+
   gtk_tim_sort_set_max_merge_size (&self->sort, 0);
 
+  if (!gtk_sort_list_model_presort (self, &presort_pos, &presort_n_items))
+    presort_pos = presort_n_items = 0;
+
   gtk_sort_list_model_sort_step (self, TRUE, pos, n_items);
   gtk_tim_sort_finish (&self->sort);
 
+  if (presort_n_items > 0)
+    {
+      if (*n_items > 0)
+        {
+          guint end = MAX (*pos + *n_items, presort_pos + presort_n_items);
+
+          *pos = MIN (*pos, presort_pos);
+          *n_items = end - *pos;
+        }
+      else
+        {
+          *pos = presort_pos;
+          *n_items = presort_n_items;
+        }
+    }
+
   gtk_sort_list_model_stop_sorting (self, NULL);
 }
 
@@ -374,6 +526,7 @@ gtk_sort_list_model_clear_keys (GtkSortListModel *self)
   g_clear_pointer (&self->keys, g_free);
   g_clear_pointer (&self->sort_keys, gtk_sort_keys_unref);
   self->key_size = 0;
+  self->n_keys_allocated = 0;
 }
 
 static void
@@ -435,9 +588,49 @@ gtk_sort_list_model_create_keys (GtkSortListModel *self)
   self->sort_keys = gtk_sorter_get_keys (self->sorter);
   self->key_size = gtk_sort_keys_get_key_size (self->sort_keys);
   self->keys = g_malloc_n (self->n_items, self->key_size);
+  self->n_keys_allocated = self->n_items;
   self->missing_keys = gtk_bitset_new_range (0, self->n_items);
 }
 
+/* Replaces the keys with keys for @new_keys, reusing what the old keys
+ * computed where possible. Keys that were missing stay missing. */
+static void
+gtk_sort_list_model_convert_keys (GtkSortListModel *self,
+                                  GtkSortKeys      *new_keys)
+{
+  GtkSortKeys *old_sort_keys = self->sort_keys;
+  char *old_keys = self->keys;
+  gsize old_key_size = self->key_size;
+  GtkBitsetIter iter;
+  GtkBitset *known;
+  guint i, pos;
+
+  self->sort_keys = new_keys;
+  self->key_size = gtk_sort_keys_get_key_size (new_keys);
+  self->keys = g_malloc_n (self->n_keys_allocated, self->key_size);
+
+  known = gtk_bitset_new_range (0, self->n_items);
+  gtk_bitset_subtract (known, self->missing_keys);
+
+  for (gtk_bitset_iter_init_first (&iter, known, &pos);
+       gtk_bitset_iter_is_valid (&iter);
+       gtk_bitset_iter_next (&iter, &pos))
+    {
+      gpointer item = g_list_model_get_item (self->model, pos);
+      gtk_sort_keys_convert_key (new_keys, item, key_from_pos (self, pos),
+                                 old_sort_keys, old_keys + pos * old_key_size);
+      g_object_unref (item);
+    }
+
+  gtk_bitset_unref (known);
+
+  for (i = 0; i < self->n_items; i++)
+    self->positions[i] = key_from_pos (self, ((char *) self->positions[i] - old_keys) / old_key_size);
+
+  g_free (old_keys);
+  gtk_sort_keys_unref (old_sort_keys);
+}
+
 static void
 gtk_sort_list_model_create_items (GtkSortListModel *self)
 {
@@ -456,6 +649,23 @@ gtk_sort_list_model_create_items (GtkSortListModel *self)
     self->positions[i] = key_from_pos (self, i);
 }
 
+static void
+gtk_sort_list_model_resize_keys (GtkSortListModel *self,
+                                 guint             n_keys)
+{
+  /* Grow by doubling, so that the keys only move occasionally when
+   * items keep getting appended, but give back memory after large
+   * removals. */
+  if (n_keys > self->n_keys_allocated)
+    self->n_keys_allocated = MAX (n_keys, 2 * self->n_keys_allocated);
+  else if (n_keys < self->n_keys_allocated / 4)
+    self->n_keys_allocated = n_keys;
+  else
+    return;
+
+  self->keys = g_realloc_n (self->keys, self->n_keys_allocated, self->key_size);
+}
+
 /* This realloc()s the arrays but does not set the added values. */
 static void
 gtk_sort_list_model_update_items (GtkSortListModel *self,
@@ -484,11 +694,11 @@ gtk_sort_list_model_update_items (GtkSortListModel *self,
       memmove (key_from_pos (self, position + added),
                key_from_pos (self, position + removed),
                self->key_size * (n_items - position - removed));
-      self->keys = g_realloc_n (self->keys, n_items - removed + added, self->key_size);
+      gtk_sort_list_model_resize_keys (self, n_items - removed + added);
     }
   else if (removed < added)
     {
-      self->keys = g_realloc_n (self->keys, n_items - removed + added, self->key_size);
+      gtk_sort_list_model_resize_keys (self, n_items - removed + added);
       memmove (key_from_pos (self, position + added),
                key_from_pos (self, position + removed),
                self->key_size * (n_items - position - removed));
@@ -500,7 +710,16 @@ gtk_sort_list_model_update_items (GtkSortListModel *self,
   valid_run_end = 0;
   run_index = 0;
   run_end = 0;
-  for (i = 0; i < n_items;)
+  i = 0;
+  if (removed == 0 && position == n_items && self->keys == old_keys)
+    {
+      /* Appending without moving the keys: All positions and runs
+       * are still valid, the new items are merged in by sorting. */
+      i = valid = n_items;
+      while (runs[valid_run] != 0)
+        valid_run++;
+    }
+  for (; i < n_items;)
     {
       if (runs[run_index] == 0)
         {
@@ -697,7 +916,16 @@ gtk_sort_list_model_sorter_changed_cb (GtkSorter        *sorter,
         {
           GtkSortKeys *new_keys = gtk_sorter_get_keys (sorter);
 
-          if (!gtk_sort_keys_is_compatible (new_keys, self->sort_keys))
+          if (gtk_sort_keys_is_compatible (new_keys, self->sort_keys))
+            {
+              gtk_sort_keys_unref (self->sort_keys);
+              self->sort_keys = new_keys;
+            }
+          else if (self->key_size > 0 && gtk_sort_keys_can_convert (new_keys, self->sort_keys))
+            {
+              gtk_sort_list_model_convert_keys (self, new_keys);
+            }
+          else
             {
               char *old_keys = self->keys;
               gsize old_key_size = self->key_size;
@@ -711,11 +939,6 @@ gtk_sort_list_model_sorter_changed_cb (GtkSorter        *sorter,
 
               gtk_sort_keys_unref (new_keys);
             }
-          else
-            {
-              gtk_sort_keys_unref (self->sort_keys);
-              self->sort_keys = new_keys;
-            }
         }
 
       if (gtk_sort_list_model_start_sorting (self, NULL))
@@ -24,6 +24,7 @@
 #include <gtk/gtk.h>
 #include "gtkstack.h"
 #include "gtkenums.h"
+#include "gtkgizmoprivate.h"
 #include "gtkaccessibleprivate.h"
 #include "gtkatcontextprivate.h"
 #include "gtkprivate.h"
@@ -206,6 +207,13 @@ struct _GtkStackPage
 
   GtkATContext *at_context;
 
+  /* Set for pages added with gtk_stack_add_lazy() until they
+   * are first shown; @widget is a placeholder until then.
+   */
+  GtkStackCreatePageFunc create_func;
+  gpointer create_func_data;
+  GDestroyNotify create_func_data_destroy;
+
   guint needs_attention : 1;
   guint visible         : 1;
   guint use_underline   : 1;
@@ -265,6 +273,9 @@ gtk_stack_page_finalize (GObject *object)
 {
   GtkStackPage *page = GTK_STACK_PAGE (object);
 
+  if (page->create_func_data_destroy)
+    page->create_func_data_destroy (page->create_func_data);
+
   g_clear_object (&page->widget);
   g_free (page->name);
   g_free (page->title);
@@ -593,6 +604,8 @@ static void     gtk_stack_set_property                   (GObject       *object,
 static void     gtk_stack_unschedule_ticks               (GtkStack      *stack);
 
 
+static void     gtk_stack_page_create_child              (GtkStack     *stack,
+                                                          GtkStackPage *child_info);
 static void     gtk_stack_add_page                       (GtkStack     *stack,
                                                           GtkStackPage *page);
 
@@ -1226,6 +1239,7 @@ set_visible_child (GtkStack               *stack,
 
   if (child_info)
     {
+      gtk_stack_page_create_child (stack, child_info);
       gtk_widget_set_child_visible (child_info->widget, TRUE);
 
       if (contains_focus)
@@ -1391,6 +1405,98 @@ gtk_stack_add_named (GtkStack   *stack,
   return gtk_stack_add_internal (stack, child, name, NULL);
 }
 
+/**
+ * gtk_stack_add_lazy:
+ * @stack: a #GtkStack
+ * @name: (nullable): the name for the page or %NULL
+ * @title: (nullable): a human-readable title for the page or %NULL
+ * @create_func: (scope notified): function that creates the page's child
+ * @user_data: (closure): user data passed to @create_func
+ * @user_data_free_func: function for freeing @user_data
+ *
+ * Adds a page to @stack whose child is only created when the page
+ * is shown for the first time, by calling @create_func.
+ *
+ * Until then, gtk_stack_page_get_child() returns an empty placeholder
+ * widget, which is also what a homogeneous @stack measures for the
+ * page. Once @create_func has run, the returned widget replaces the
+ * placeholder and @user_data is freed.
+ *
+ * Returns: (transfer none): the #GtkStackPage that was added
+ */
+GtkStackPage *
+gtk_stack_add_lazy (GtkStack               *stack,
+                    const char             *name,
+                    const char             *title,
+                    GtkStackCreatePageFunc  create_func,
+                    gpointer                user_data,
+                    GDestroyNotify          user_data_free_func)
+{
+  GtkStackPage *child_info;
+
+  g_return_val_if_fail (GTK_IS_STACK (stack), NULL);
+  g_return_val_if_fail (create_func != NULL, NULL);
+
+  child_info = g_object_new (GTK_TYPE_STACK_PAGE, NULL);
+  child_info->widget = g_object_ref_sink (gtk_gizmo_new ("widget", NULL, NULL, NULL, NULL, NULL, NULL));
+  child_info->name = g_strdup (name);
+  child_info->title = g_strdup (title);
+  child_info->create_func = create_func;
+  child_info->create_func_data = user_data;
+  child_info->create_func_data_destroy = user_data_free_func;
+
+  gtk_stack_add_page (stack, child_info);
+
+  g_object_unref (child_info);
+
+  return child_info;
+}
+
+/* Replaces the placeholder of a lazy page with its real child */
+static void
+gtk_stack_page_create_child (GtkStack     *stack,
+                             GtkStackPage *child_info)
+{
+  GtkStackCreatePageFunc create_func = child_info->create_func;
+  GtkWidget *placeholder;
+  GtkWidget *child;
+
+  if (create_func == NULL)
+    return;
+
+  child_info->create_func = NULL;
+  child = create_func (child_info, child_info->create_func_data);
+
+  if (child_info->create_func_data_destroy)
+    child_info->create_func_data_destroy (child_info->create_func_data);
+  child_info->create_func_data = NULL;
+  child_info->create_func_data_destroy = NULL;
+
+  g_return_if_fail (GTK_IS_WIDGET (child));
+
+  placeholder = child_info->widget;
+  g_signal_handlers_disconnect_by_func (placeholder,
+                                        stack_child_visibility_notify_cb,
+                                        stack);
+
+  /* Accept both floating and full references, like
+   * gtk_list_box_bind_model() does.
+   */
+  if (g_object_is_floating (child))
+    g_object_ref_sink (child);
+
+  child_info->widget = child;
+  gtk_widget_set_child_visible (child, gtk_widget_get_child_visible (placeholder));
+  gtk_widget_insert_after (child, GTK_WIDGET (stack), placeholder);
+  gtk_widget_unparent (placeholder);
+  g_object_unref (placeholder);
+
+  g_signal_connect (child, "notify::visible",
+                    G_CALLBACK (stack_child_visibility_notify_cb), stack);
+
+  g_object_notify_by_pspec (G_OBJECT (child_info), stack_page_props[CHILD_PROP_CHILD]);
+}
+
 static GtkStackPage *
 gtk_stack_add_internal (GtkStack   *stack,
                         GtkWidget  *child,
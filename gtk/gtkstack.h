@@ -44,6 +44,19 @@ typedef struct _GtkStack GtkStack;
 
 typedef struct _GtkStackPage GtkStackPage;
 
+/**
+ * GtkStackCreatePageFunc:
+ * @page: the #GtkStackPage that is shown for the first time
+ * @user_data: (closure): user data
+ *
+ * Called by #GtkStack to create the child of a page that was added
+ * with gtk_stack_add_lazy().
+ *
+ * Returns: (transfer full): a #GtkWidget for @page
+ */
+typedef GtkWidget * (* GtkStackCreatePageFunc) (GtkStackPage *page,
+                                                gpointer      user_data);
+
 typedef enum {
   GTK_STACK_TRANSITION_TYPE_NONE,
   GTK_STACK_TRANSITION_TYPE_CROSSFADE,
@@ -125,6 +138,13 @@ GtkStackPage *         gtk_stack_add_titled              (GtkStack
                                                           const char             *name,
                                                           const char             *title);
 GDK_AVAILABLE_IN_ALL
+GtkStackPage *         gtk_stack_add_lazy                (GtkStack               *stack,
+                                                          const char             *name,
+                                                          const char             *title,
+                                                          GtkStackCreatePageFunc  create_func,
+                                                          gpointer                user_data,
+                                                          GDestroyNotify          user_data_free_func);
+GDK_AVAILABLE_IN_ALL
 void                   gtk_stack_remove                  (GtkStack               *stack,
                                                           GtkWidget              *child);
 
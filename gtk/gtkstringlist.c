@@ -60,10 +60,30 @@
 
  */
 
-#define GDK_ARRAY_ELEMENT_TYPE GtkStringObject *
+/* Items are only turned into a GtkStringObject when somebody asks for
+ * the object. Until then, we store the string itself, tagged by setting
+ * the lowest bit of the pointer, which is never set for malloc()ed memory.
+ */
+#define IS_STRING(item) (GPOINTER_TO_SIZE (item) & 0x1)
+#define TO_STRING(item) ((char *) GSIZE_TO_POINTER (GPOINTER_TO_SIZE (item) & ~(gsize) 0x1))
+#define FROM_STRING(str) (GSIZE_TO_POINTER (GPOINTER_TO_SIZE (str) | 0x1))
+
+static void
+free_string_or_object (gpointer item)
+{
+  if (item == NULL)
+    return;
+
+  if (IS_STRING (item))
+    g_free (TO_STRING (item));
+  else
+    g_object_unref (item);
+}
+
+#define GDK_ARRAY_ELEMENT_TYPE gpointer
 #define GDK_ARRAY_NAME objects
 #define GDK_ARRAY_TYPE_NAME Objects
-#define GDK_ARRAY_FREE_FUNC g_object_unref
+#define GDK_ARRAY_FREE_FUNC free_string_or_object
 #include "gdk/gdkarrayimpl.c"
 
 struct _GtkStringObject
@@ -226,11 +246,17 @@ gtk_string_list_get_item (GListModel *list,
                           guint       position)
 {
   GtkStringList *self = GTK_STRING_LIST (list);
+  gpointer *item;
 
   if (position >= objects_get_size (&self->items))
     return NULL;
 
-  return g_object_ref (objects_get (&self->items, position));
+  item = objects_index (&self->items, position);
+
+  if (IS_STRING (*item))
+    *item = gtk_string_object_new_take (TO_STRING (*item));
+
+  return g_object_ref (*item);
 }
 
 static void
@@ -497,7 +523,7 @@ gtk_string_list_splice (GtkStringList      *self,
 
   for (i = 0; i < n_additions; i++)
     {
-      *objects_index (&self->items, position + i) = gtk_string_object_new (additions[i]);
+      *objects_index (&self->items, position + i) = FROM_STRING (g_strdup (additions[i]));
     }
 
   if (n_removals || n_additions)
@@ -520,7 +546,7 @@ gtk_string_list_append (GtkStringList *self,
 {
   g_return_if_fail (GTK_IS_STRING_LIST (self));
 
-  objects_append (&self->items, gtk_string_object_new (string));
+  objects_append (&self->items, FROM_STRING (g_strdup (string)));
 
   g_list_model_items_changed (G_LIST_MODEL (self), objects_get_size (&self->items) - 1, 0, 1);
 }
@@ -546,7 +572,7 @@ gtk_string_list_take (GtkStringList *self,
 {
   g_return_if_fail (GTK_IS_STRING_LIST (self));
 
-  objects_append (&self->items, gtk_string_object_new_take (string));
+  objects_append (&self->items, FROM_STRING (string));
 
   g_list_model_items_changed (G_LIST_MODEL (self), objects_get_size (&self->items) - 1, 0, 1);
 }
@@ -585,10 +611,17 @@ const char *
 gtk_string_list_get_string (GtkStringList *self,
                             guint          position)
 {
+  gpointer item;
+
   g_return_val_if_fail (GTK_IS_STRING_LIST (self), NULL);
 
   if (position >= objects_get_size (&self->items))
     return NULL;
 
-  return objects_get (&self->items, position)->string;
+  item = objects_get (&self->items, position);
+
+  if (IS_STRING (item))
+    return TO_STRING (item);
+  else
+    return GTK_STRING_OBJECT (item)->string;
 }
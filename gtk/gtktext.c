@@ -492,6 +492,7 @@ static PangoLayout *gtk_text_ensure_layout            (GtkText       *self,
                                                        gboolean       include_preedit);
 static void         gtk_text_reset_layout             (GtkText       *self);
 static void         gtk_text_recompute                (GtkText       *self);
+static void         gtk_text_update_positions         (GtkText       *self);
 static int          gtk_text_find_position            (GtkText       *self,
                                                        int            x);
 static void         gtk_text_get_cursor_locations     (GtkText       *self,
@@ -3162,6 +3163,9 @@ gtk_text_focus_changed (GtkEventControllerFocus *controller,
   if (seat)
     keyboard = gdk_seat_get_keyboard (seat);
 
+  /* The base direction of neutral text depends on the focus */
+  gtk_text_reset_layout (self);
+
   gtk_widget_queue_draw (widget);
 
   if (gtk_event_controller_focus_is_focus (controller))
@@ -3525,8 +3529,9 @@ buffer_inserted_text (GtkEntryBuffer *buffer,
   if (selection_bound > position)
     selection_bound += n_chars;
 
+  gtk_text_reset_layout (self);
   gtk_text_set_positions (self, current_pos, selection_bound);
-  gtk_text_recompute (self);
+  gtk_text_update_positions (self);
 
   gtk_text_history_text_inserted (priv->history, position, chars, -1);
 
@@ -3607,8 +3612,9 @@ buffer_deleted_text_after (GtkEntryBuffer *buffer,
   if (selection_bound > position)
     selection_bound -= MIN (selection_bound, end_pos) - position;
 
+  gtk_text_reset_layout (self);
   gtk_text_set_positions (self, current_pos, selection_bound);
-  gtk_text_recompute (self);
+  gtk_text_update_positions (self);
 
   /* We might have deleted the selection */
   gtk_text_update_primary_selection (self);
@@ -4318,7 +4324,15 @@ gtk_text_set_positions (GtkText *self,
   if (changed)
     {
       gtk_text_update_clipboard_actions (self);
-      gtk_text_recompute (self);
+
+      /* The layout only depends on the cursor when it shows preedit
+       * text at the cursor, so plain cursor and selection moves can
+       * keep the shaped text around.
+       */
+      if (priv->preedit_length > 0)
+        gtk_text_recompute (self);
+      else
+        gtk_text_update_positions (self);
     }
 }
 
@@ -4338,6 +4352,12 @@ static void
 gtk_text_recompute (GtkText *self)
 {
   gtk_text_reset_layout (self);
+  gtk_text_update_positions (self);
+}
+
+static void
+gtk_text_update_positions (GtkText *self)
+{
   gtk_widget_queue_draw (GTK_WIDGET (self));
 
   if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
@@ -64,10 +64,12 @@
 #include "gtktextlayoutprivate.h"
 #include "gtktextiterprivate.h"
 #include "gtkdebug.h"
+#include "gtkprivate.h"
 #include "gtktextmarkprivate.h"
 #include "gtktextsegment.h"
 #include "gtkpango.h"
 #include "gdk-private.h"
+#include "gdk/gdkparallelprivate.h"
 
 /*
  * Types
@@ -214,6 +216,24 @@ struct _GtkTextBTree {
   int end_iter_segment_char_offset;
   guint end_iter_line_stamp;
   guint end_iter_segment_stamp;
+
+  /* Cache the line of the last line number or char index lookup,
+   * so that lookups nearby only need to walk a few lines. Either
+   * index may be -1 if it isn't known.
+   */
+  GtkTextLine *index_line;
+  int index_line_number;
+  int index_line_char_index;
+  guint index_line_stamp;
+
+  /* While tags are applied in a batch, the regions to redisplay
+   * are collected here as char offsets, -1 if empty.
+   */
+  int tag_batch_depth;
+  int tag_batch_invalid_start;
+  int tag_batch_invalid_end;
+  int tag_batch_redraw_start;
+  int tag_batch_redraw_end;
   
   GHashTable *child_anchor_table;
 };
@@ -429,6 +449,9 @@ _gtk_text_btree_new (GtkTextTagTable *table,
   tree->end_iter_line = NULL;
   tree->end_iter_segment_byte_index = 0;
   tree->end_iter_segment_char_offset = 0;
+
+  tree->index_line_stamp = tree->chars_changed_stamp - 1;
+  tree->index_line = NULL;
   
   g_object_ref (tree->table);
 
@@ -593,11 +616,11 @@ gtk_text_btree_resolve_bidi (GtkTextIter *start,
       
       while (seg)
         {
-          if (seg->type == &gtk_text_char_type && seg->byte_count > 0)
+          if (_gtk_text_segment_has_chars (seg) && seg->byte_count > 0)
             {
 	      PangoDirection pango_dir;
 
-              pango_dir = gdk_find_base_dir (seg->body.chars, seg->byte_count);
+              pango_dir = gdk_find_base_dir (_gtk_char_segment_get_chars (seg), seg->byte_count);
 	      
               if (pango_dir != PANGO_DIRECTION_NEUTRAL)
                 {
@@ -1090,10 +1113,189 @@ _gtk_text_btree_delete (GtkTextIter *start,
   gtk_text_btree_resolve_bidi (start, end);
 }
 
-void
-_gtk_text_btree_insert (GtkTextIter *iter,
-                        const char *text,
-                        int          len)
+/* Inserts with at least this many bytes per core have their
+ * segments created in parallel before being linked into the tree.
+ */
+#define GTK_TEXT_BTREE_MIN_BYTES_PER_JOB (64 * 1024)
+
+typedef struct
+{
+  GBytes *bytes;           /* if set, text is borrowed from it */
+  const char *text;
+  int len;
+  int start;               /* first byte the job may start a line at */
+  int end;                 /* lines starting here belong to the next job */
+  GPtrArray *segments;     /* one char segment per line */
+  gboolean ends_line;      /* the last segment ends with a delimiter */
+} InsertJob;
+
+static GtkTextLineSegment *
+new_char_segment (GBytes     *bytes,
+                  const char *text,
+                  int         len)
+{
+  if (bytes)
+    return _gtk_borrowed_char_segment_new (bytes, text, len);
+  else
+    return _gtk_char_segment_new (text, len);
+}
+
+/* Returns the start of the first line at or after @pos */
+static int
+find_line_start (const char *text,
+                 int         len,
+                 int         pos)
+{
+  const char *prev;
+  int delim, eol;
+
+  if (pos == 0)
+    return 0;
+
+  /* Start from the character before @pos, so a delimiter right
+   * before @pos or a \r\n around it ends that line correctly.
+   */
+  prev = g_utf8_find_prev_char (text, text + pos);
+  pango_find_paragraph_boundary (prev, len - (prev - text), &delim, &eol);
+
+  return (prev - text) + eol;
+}
+
+static void
+insert_job_func (gpointer data,
+                 gpointer unused)
+{
+  InsertJob *job = data;
+  int sol, eol, delim;
+
+  job->ends_line = FALSE;
+  job->segments = g_ptr_array_new ();
+
+  eol = find_line_start (job->text, job->len, job->start);
+  while (eol < job->len && eol < job->end)
+    {
+      sol = eol;
+
+      pango_find_paragraph_boundary (job->text + sol,
+                                     job->len - sol,
+                                     &delim,
+                                     &eol);
+      delim += sol;
+      eol += sol;
+
+      g_ptr_array_add (job->segments, new_char_segment (job->bytes, &job->text[sol], eol - sol));
+      job->ends_line = delim != eol;
+    }
+}
+
+/* Adds @seg after @cur_seg in @line. If the segment ends with a
+ * paragraph delimiter, the rest of the line is moved to a new line,
+ * which becomes the line to insert into.
+ */
+static void
+insert_char_segment (GtkTextLine        **line,
+                     GtkTextLineSegment **cur_seg,
+                     GtkTextLineSegment  *seg,
+                     gboolean             ends_line)
+{
+  GtkTextLine *newline;
+
+  if (*cur_seg == NULL)
+    {
+      seg->next = (*line)->segments;
+      (*line)->segments = seg;
+    }
+  else
+    {
+      seg->next = (*cur_seg)->next;
+      (*cur_seg)->next = seg;
+    }
+
+  if (!ends_line)
+    {
+      *cur_seg = seg;
+      return;
+    }
+
+  newline = gtk_text_line_new ();
+  gtk_text_line_set_parent (newline, (*line)->parent);
+  newline->next = (*line)->next;
+  (*line)->next = newline;
+  newline->segments = seg->next;
+  seg->next = NULL;
+  *line = newline;
+  *cur_seg = NULL;
+}
+
+/* Creates the segments of large insertions in threads, splitting the
+ * text at paragraph boundaries. Only linking the lines into the tree
+ * is left for the calling thread.
+ * Returns %FALSE if the text is too short to be worth splitting.
+ */
+static gboolean
+insert_text_in_parallel (GBytes              *bytes,
+                         const char          *text,
+                         int                  len,
+                         GtkTextLine        **line,
+                         GtkTextLineSegment **cur_seg,
+                         int                 *line_count_delta,
+                         int                 *char_count_delta)
+{
+  InsertJob *jobs;
+  guint n_jobs, per_job, i, j;
+
+  /* Segments look up debug flags on the default display */
+  if (gtk_get_debug_flags () != 0)
+    return FALSE;
+
+  n_jobs = MIN (gtk_get_n_threads (), len / GTK_TEXT_BTREE_MIN_BYTES_PER_JOB);
+  if (n_jobs <= 1)
+    return FALSE;
+
+  per_job = (len + n_jobs - 1) / n_jobs;
+  jobs = g_newa (InsertJob, n_jobs);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].bytes = bytes;
+      jobs[i].text = text;
+      jobs[i].len = len;
+      jobs[i].start = MIN (i * per_job, len);
+      jobs[i].end = MIN ((i + 1) * per_job, len);
+    }
+
+  gdk_parallel_run (jobs, sizeof (InsertJob), n_jobs, insert_job_func, NULL);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      for (j = 0; j < jobs[i].segments->len; j++)
+        {
+          GtkTextLineSegment *seg = g_ptr_array_index (jobs[i].segments, j);
+          gboolean ends_line;
+
+          /* only the very last line may lack a delimiter */
+          if (j + 1 < jobs[i].segments->len)
+            ends_line = TRUE;
+          else
+            ends_line = jobs[i].ends_line;
+
+          *char_count_delta += seg->char_count;
+          insert_char_segment (line, cur_seg, seg, ends_line);
+          if (ends_line)
+            *line_count_delta += 1;
+        }
+
+      g_ptr_array_unref (jobs[i].segments);
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_text_btree_insert_text (GtkTextIter *iter,
+                            const char  *text,
+                            int          len,
+                            GBytes      *bytes)
 {
   GtkTextLineSegment *prev_seg;     /* The segment just before the first
                                      * new segment (NULL means new segment
@@ -1105,7 +1307,6 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   GtkTextLine *line;           /* Current line (new segments are
                                 * added to this line). */
   GtkTextLineSegment *seg;
-  GtkTextLine *newline;
   int chunk_len;                        /* # characters in current chunk. */
   int sol;                           /* start of line */
   int eol;                           /* Pointer to character just after last
@@ -1119,6 +1320,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   int char_count_delta;                /* change to number of chars */
   GtkTextBTree *tree;
   int start_byte_index;
+  int end_byte_index;
   GtkTextLine *start_line;
 
   g_return_if_fail (text != NULL);
@@ -1156,66 +1358,58 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   sol = 0;
   line_count_delta = 0;
   char_count_delta = 0;
-  while (eol < len)
+  if (!insert_text_in_parallel (bytes, text, len, &line, &cur_seg,
+                                &line_count_delta, &char_count_delta))
     {
-      sol = eol;
-      
-      pango_find_paragraph_boundary (text + sol,
-                                     len - sol,
-                                     &delim,
-                                     &eol);      
+      while (eol < len)
+        {
+          sol = eol;
 
-      /* make these relative to the start of the text */
-      delim += sol;
-      eol += sol;
+          pango_find_paragraph_boundary (text + sol,
+                                         len - sol,
+                                         &delim,
+                                         &eol);
 
-      g_assert (eol >= sol);
-      g_assert (delim >= sol);
-      g_assert (eol >= delim);
-      g_assert (sol >= 0);
-      g_assert (eol <= len);
-      
-      chunk_len = eol - sol;
+          /* make these relative to the start of the text */
+          delim += sol;
+          eol += sol;
 
-      g_assert (g_utf8_validate (&text[sol], chunk_len, NULL));
-      seg = _gtk_char_segment_new (&text[sol], chunk_len);
+          g_assert (eol >= sol);
+          g_assert (delim >= sol);
+          g_assert (eol >= delim);
+          g_assert (sol >= 0);
+          g_assert (eol <= len);
 
-      char_count_delta += seg->char_count;
+          chunk_len = eol - sol;
 
-      if (cur_seg == NULL)
-        {
-          seg->next = line->segments;
-          line->segments = seg;
-        }
-      else
-        {
-          seg->next = cur_seg->next;
-          cur_seg->next = seg;
-        }
+          g_assert (g_utf8_validate (&text[sol], chunk_len, NULL));
+          seg = new_char_segment (bytes, &text[sol], chunk_len);
 
-      if (delim == eol)
-        {
-          /* chunk didn't end with a paragraph separator */
-          g_assert (eol == len);
-          break;
-        }
+          char_count_delta += seg->char_count;
 
-      /*
-       * The chunk ended with a newline, so create a new GtkTextLine
-       * and move the remainder of the old line to it.
-       */
+          /* A chunk that ends with a newline gets moved
+           * to a new GtkTextLine with the remainder of the old line.
+           */
+          insert_char_segment (&line, &cur_seg, seg, delim != eol);
 
-      newline = gtk_text_line_new ();
-      gtk_text_line_set_parent (newline, line->parent);
-      newline->next = line->next;
-      line->next = newline;
-      newline->segments = seg->next;
-      seg->next = NULL;
-      line = newline;
-      cur_seg = NULL;
-      line_count_delta++;
+          if (delim == eol)
+            {
+              /* chunk didn't end with a paragraph separator */
+              g_assert (eol == len);
+              break;
+            }
+
+          line_count_delta++;
+        }
     }
 
+  /* The inserted text ends right after cur_seg, or at the start
+   * of a new line if it ended with a paragraph delimiter.
+   */
+  end_byte_index = line == start_line ? start_byte_index : 0;
+  if (cur_seg != NULL && cur_seg != prev_seg)
+    end_byte_index += cur_seg->byte_count;
+
   /*
    * Cleanup the starting line for the insertion, plus the ending
    * line if it's different.
@@ -1229,6 +1423,9 @@ _gtk_text_btree_insert (GtkTextIter *iter,
 
   post_insert_fixup (tree, line, line_count_delta, char_count_delta);
 
+  /* The stamp was bumped before the lines were rearranged */
+  tree->index_line = NULL;
+
   /* Invalidate our region, and reset the iterator the user
      passed in to point to the end of the inserted text. */
   {
@@ -1240,12 +1437,10 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                       &start,
                                       start_line,
                                       start_byte_index);
-    end = start;
-
-    /* We could almost certainly be more efficient here
-       by saving the information from the insertion loop
-       above. FIXME */
-    gtk_text_iter_forward_chars (&end, char_count_delta);
+    _gtk_text_btree_get_iter_at_line (tree,
+                                      &end,
+                                      line,
+                                      end_byte_index);
 
     DV (g_print ("invalidating due to inserting some text (%s)\n", G_STRLOC));
     _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
@@ -1258,6 +1453,28 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   }
 }
 
+void
+_gtk_text_btree_insert (GtkTextIter *iter,
+                        const char *text,
+                        int          len)
+{
+  gtk_text_btree_insert_text (iter, text, len, NULL);
+}
+
+/* Like _gtk_text_btree_insert(), but @text is part of @bytes
+ * and is referenced instead of copied where possible.
+ */
+void
+_gtk_text_btree_insert_borrowed (GtkTextIter *iter,
+                                 const char  *text,
+                                 int          len,
+                                 GBytes      *bytes)
+{
+  g_return_if_fail (bytes != NULL);
+
+  gtk_text_btree_insert_text (iter, text, len, bytes);
+}
+
 static void
 insert_paintable_or_widget_segment (GtkTextIter        *iter,
                                     GtkTextLineSegment *seg)
@@ -1744,12 +1961,46 @@ iter_stack_invert (IterStack *stack)
     }
 }
 
+static void
+extend_tag_batch_region (int               *region_start,
+                         int               *region_end,
+                         const GtkTextIter *start,
+                         const GtkTextIter *end)
+{
+  int start_offset = gtk_text_iter_get_offset (start);
+  int end_offset = gtk_text_iter_get_offset (end);
+
+  if (*region_start < 0)
+    {
+      *region_start = start_offset;
+      *region_end = end_offset;
+    }
+  else
+    {
+      *region_start = MIN (*region_start, start_offset);
+      *region_end = MAX (*region_end, end_offset);
+    }
+}
+
 static void
 queue_tag_redisplay (GtkTextBTree      *tree,
                      GtkTextTag        *tag,
                      const GtkTextIter *start,
                      const GtkTextIter *end)
 {
+  if (tree->tag_batch_depth > 0)
+    {
+      if (_gtk_text_tag_affects_size (tag))
+        extend_tag_batch_region (&tree->tag_batch_invalid_start,
+                                 &tree->tag_batch_invalid_end,
+                                 start, end);
+      else if (_gtk_text_tag_affects_nonsize_appearance (tag))
+        extend_tag_batch_region (&tree->tag_batch_redraw_start,
+                                 &tree->tag_batch_redraw_end,
+                                 start, end);
+      return;
+    }
+
   if (_gtk_text_tag_affects_size (tag))
     {
       DV (g_print ("invalidating due to size-affecting tag (%s)\n", G_STRLOC));
@@ -1764,6 +2015,49 @@ queue_tag_redisplay (GtkTextBTree      *tree,
   /* We don't need to do anything if the tag doesn't affect display */
 }
 
+/* Tags applied between these only queue a single redisplay
+ * of the region they cover, when the batch ends.
+ */
+void
+_gtk_text_btree_begin_tag_batch (GtkTextBTree *tree)
+{
+  if (tree->tag_batch_depth == 0)
+    {
+      tree->tag_batch_invalid_start = tree->tag_batch_invalid_end = -1;
+      tree->tag_batch_redraw_start = tree->tag_batch_redraw_end = -1;
+    }
+
+  tree->tag_batch_depth++;
+}
+
+void
+_gtk_text_btree_end_tag_batch (GtkTextBTree *tree)
+{
+  GtkTextIter start, end;
+
+  g_return_if_fail (tree->tag_batch_depth > 0);
+
+  if (--tree->tag_batch_depth > 0)
+    return;
+
+  if (tree->tag_batch_invalid_start >= 0)
+    {
+      _gtk_text_btree_get_iter_at_char (tree, &start, tree->tag_batch_invalid_start);
+      _gtk_text_btree_get_iter_at_char (tree, &end, tree->tag_batch_invalid_end);
+
+      DV (g_print ("invalidating due to size-affecting tags (%s)\n", G_STRLOC));
+      _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
+    }
+
+  if (tree->tag_batch_redraw_start >= 0)
+    {
+      _gtk_text_btree_get_iter_at_char (tree, &start, tree->tag_batch_redraw_start);
+      _gtk_text_btree_get_iter_at_char (tree, &end, tree->tag_batch_redraw_end);
+
+      redisplay_region (tree, &start, &end, FALSE);
+    }
+}
+
 void
 _gtk_text_btree_tag (const GtkTextIter *start_orig,
                      const GtkTextIter *end_orig,
@@ -2024,6 +2318,151 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
 }
 
 
+/*
+ * Line index cache
+ */
+
+static inline gboolean
+index_cache_valid (GtkTextBTree *tree)
+{
+  return tree->index_line != NULL &&
+         tree->index_line_stamp == tree->chars_changed_stamp;
+}
+
+static void
+index_cache_update (GtkTextBTree *tree,
+                    GtkTextLine  *line,
+                    int           line_number,
+                    int           char_index)
+{
+  tree->index_line = line;
+  tree->index_line_number = line_number;
+  tree->index_line_char_index = char_index;
+  tree->index_line_stamp = tree->chars_changed_stamp;
+}
+
+/* Finds the indexes of @line relative to the cached line, if both
+ * are attached to the same level-0 node. Unknown indexes are set
+ * to -1.
+ */
+static gboolean
+index_cache_lookup (GtkTextBTree *tree,
+                    GtkTextLine  *line,
+                    int          *line_number,
+                    int          *char_index)
+{
+  GtkTextLine *start, *end, *l;
+  int n_lines, n_chars;
+  int sign;
+
+  *line_number = -1;
+  *char_index = -1;
+
+  if (!index_cache_valid (tree) ||
+      tree->index_line->parent != line->parent)
+    return FALSE;
+
+  /* Walk from whichever line comes first to the other one */
+  for (l = tree->index_line; l != NULL && l != line; l = l->next)
+    ;
+
+  if (l != NULL)
+    {
+      start = tree->index_line;
+      end = line;
+      sign = 1;
+    }
+  else
+    {
+      start = line;
+      end = tree->index_line;
+      sign = -1;
+    }
+
+  n_lines = 0;
+  n_chars = 0;
+  for (l = start; l != end; l = l->next)
+    {
+      n_lines += 1;
+      if (tree->index_line_char_index >= 0)
+        n_chars += _gtk_text_line_char_count (l);
+    }
+
+  if (tree->index_line_number >= 0)
+    *line_number = tree->index_line_number + sign * n_lines;
+  if (tree->index_line_char_index >= 0)
+    *char_index = tree->index_line_char_index + sign * n_chars;
+
+  return TRUE;
+}
+
+static GtkTextLine *
+index_cache_find_line (GtkTextBTree *tree,
+                       int           line_number)
+{
+  GtkTextLine *line;
+  int char_index;
+  int n;
+
+  if (!index_cache_valid (tree) ||
+      tree->index_line_number < 0 ||
+      line_number < tree->index_line_number)
+    return NULL;
+
+  line = tree->index_line;
+  char_index = tree->index_line_char_index;
+  for (n = tree->index_line_number; n < line_number && line != NULL; n++)
+    {
+      if (char_index >= 0)
+        char_index += _gtk_text_line_char_count (line);
+      line = line->next;
+    }
+
+  if (line != NULL)
+    index_cache_update (tree, line, line_number, char_index);
+
+  return line;
+}
+
+static GtkTextLine *
+index_cache_find_line_at_char (GtkTextBTree *tree,
+                               int           char_index,
+                               int          *line_start_index)
+{
+  GtkTextLine *line;
+  int line_number;
+  int start;
+
+  if (!index_cache_valid (tree) ||
+      tree->index_line_char_index < 0 ||
+      char_index < tree->index_line_char_index)
+    return NULL;
+
+  line = tree->index_line;
+  line_number = tree->index_line_number;
+  start = tree->index_line_char_index;
+  while (line != NULL)
+    {
+      int chars = _gtk_text_line_char_count (line);
+
+      if (char_index < start + chars)
+        break;
+
+      start += chars;
+      line = line->next;
+      if (line_number >= 0)
+        line_number += 1;
+    }
+
+  if (line == NULL)
+    return NULL;
+
+  *line_start_index = start;
+  index_cache_update (tree, line, line_number, start);
+
+  return line;
+}
+
 /*
  * "Getters"
  */
@@ -2055,6 +2494,10 @@ get_line_internal (GtkTextBTree *tree,
   if (real_line_number)
     *real_line_number = line_number;
 
+  line = index_cache_find_line (tree, line_number);
+  if (line != NULL)
+    return line;
+
   node = tree->root_node;
   lines_left = line_number;
 
@@ -2094,6 +2537,9 @@ get_line_internal (GtkTextBTree *tree,
 #endif
       lines_left -= 1;
     }
+
+  index_cache_update (tree, line, line_number, -1);
+
   return line;
 }
 
@@ -2147,6 +2593,10 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
 
   *real_char_index = char_index;
 
+  line = index_cache_find_line_at_char (tree, char_index, line_start_index);
+  if (line != NULL)
+    return line;
+
   /*
    * Work down through levels of the tree until a GtkTextBTreeNode is found at
    * level 0.
@@ -2170,6 +2620,7 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
       /* Start of a line */
 
       *line_start_index = char_index;
+      index_cache_update (tree, node->children.line, -1, char_index);
       return node->children.line;
     }
 
@@ -2204,9 +2655,44 @@ _gtk_text_btree_get_line_at_char (GtkTextBTree      *tree,
   g_assert (seg != NULL);
 
   *line_start_index = char_index - chars_left;
+  index_cache_update (tree, line, -1, *line_start_index);
   return line;
 }
 
+int
+_gtk_text_btree_get_line_number (GtkTextBTree *tree,
+                                 GtkTextLine  *line)
+{
+  int line_number;
+  int char_index;
+
+  if (index_cache_lookup (tree, line, &line_number, &char_index) &&
+      line_number >= 0)
+    return line_number;
+
+  line_number = _gtk_text_line_get_number (line);
+  index_cache_update (tree, line, line_number, char_index);
+
+  return line_number;
+}
+
+int
+_gtk_text_btree_get_line_char_index (GtkTextBTree *tree,
+                                     GtkTextLine  *line)
+{
+  int line_number;
+  int char_index;
+
+  if (index_cache_lookup (tree, line, &line_number, &char_index) &&
+      char_index >= 0)
+    return char_index;
+
+  char_index = _gtk_text_line_char_index (line);
+  index_cache_update (tree, line, line_number, char_index);
+
+  return char_index;
+}
+
 /* It returns an array sorted by tags priority, ready to pass to
  * _gtk_text_attributes_fill_from_tags() */
 GtkTextTag**
@@ -2340,7 +2826,7 @@ copy_segment (GString *string,
   seg = _gtk_text_iter_get_indexable_segment (start);
   end_seg = _gtk_text_iter_get_indexable_segment (end);
 
-  if (seg->type == &gtk_text_char_type)
+  if (_gtk_text_segment_has_chars (seg))
     {
       gboolean copy = TRUE;
       int copy_bytes = 0;
@@ -2375,7 +2861,7 @@ copy_segment (GString *string,
           g_assert ((copy_start + copy_bytes) <= seg->byte_count);
 
           g_string_append_len (string,
-                               seg->body.chars + copy_start,
+                               _gtk_char_segment_get_chars (seg) + copy_start,
                                copy_bytes);
         }
 
@@ -3468,8 +3954,8 @@ ensure_end_iter_segment (GtkTextBTree *tree)
       
       tree->end_iter_segment_stamp = tree->segments_changed_stamp;
 
-      g_assert (tree->end_iter_segment->type == &gtk_text_char_type);
-      g_assert (tree->end_iter_segment->body.chars[tree->end_iter_segment_byte_index] == '\n');
+      g_assert (_gtk_text_segment_has_chars (tree->end_iter_segment));
+      g_assert (_gtk_char_segment_get_chars (tree->end_iter_segment)[tree->end_iter_segment_byte_index] == '\n');
     }
 }
 
@@ -3760,85 +4246,38 @@ _gtk_text_line_byte_count (GtkTextLine *line)
 int
 _gtk_text_line_char_index (GtkTextLine *target_line)
 {
-  GSList *node_stack = NULL;
-  GtkTextBTreeNode *iter;
+  GtkTextBTreeNode *node, *parent, *node2;
   GtkTextLine *line;
   int num_chars;
 
-  /* Push all our parent nodes onto a stack */
-  iter = target_line->parent;
+  /* Since we don't store char counts in lines, only in segments, we
+   * have to iterate over the lines adding up segment char counts
+   * until we find our line.
+   */
+  node = target_line->parent;
 
-  g_assert (iter != NULL);
+  g_assert (node != NULL);
 
-  while (iter != NULL)
+  num_chars = 0;
+  for (line = node->children.line; line != target_line; line = line->next)
     {
-      node_stack = g_slist_prepend (node_stack, iter);
+      g_assert (line != NULL);
 
-      iter = iter->parent;
+      num_chars += _gtk_text_line_char_count (line);
     }
 
-  /* Check that we have the root node on top of the stack. */
-  g_assert (node_stack != NULL &&
-            node_stack->data != NULL &&
-            ((GtkTextBTreeNode*)node_stack->data)->parent == NULL);
-
-  /* Add up chars in all nodes before the nodes in our stack.
-   */
-
-  num_chars = 0;
-  iter = node_stack->data;
-  while (iter != NULL)
+  /* Add up chars in all nodes before ours, level by level */
+  for (parent = node->parent; parent != NULL;
+       node = parent, parent = parent->parent)
     {
-      GtkTextBTreeNode *child_iter;
-      GtkTextBTreeNode *next_node;
-
-      next_node = node_stack->next ?
-        node_stack->next->data : NULL;
-      node_stack = g_slist_remove (node_stack, node_stack->data);
-
-      if (iter->level == 0)
-        {
-          /* stack should be empty when we're on the last node */
-          g_assert (node_stack == NULL);
-          break; /* Our children are now lines */
-        }
-
-      g_assert (next_node != NULL);
-      g_assert (iter != NULL);
-      g_assert (next_node->parent == iter);
-
-      /* Add up chars before us in the tree */
-      child_iter = iter->children.node;
-      while (child_iter != next_node)
+      for (node2 = parent->children.node; node2 != node; node2 = node2->next)
         {
-          g_assert (child_iter != NULL);
-
-          num_chars += child_iter->num_chars;
+          g_assert (node2 != NULL);
 
-          child_iter = child_iter->next;
+          num_chars += node2->num_chars;
         }
-
-      iter = next_node;
-    }
-
-  g_assert (iter != NULL);
-  g_assert (iter == target_line->parent);
-
-  /* Since we don't store char counts in lines, only in segments, we
-     have to iterate over the lines adding up segment char counts
-     until we find our line.  */
-  line = iter->children.line;
-  while (line != target_line)
-    {
-      g_assert (line != NULL);
-
-      num_chars += _gtk_text_line_char_count (line);
-
-      line = line->next;
     }
 
-  g_assert (line == target_line);
-
   return num_chars;
 }
 
@@ -3976,8 +4415,8 @@ _gtk_text_line_byte_to_char (GtkTextLine *line,
     return char_offset + byte_offset;
   else
     {
-      if (seg->type == &gtk_text_char_type)
-        return char_offset + g_utf8_strlen (seg->body.chars, byte_offset);
+      if (_gtk_text_segment_has_chars (seg))
+        return char_offset + g_utf8_strlen (_gtk_char_segment_get_chars (seg), byte_offset);
       else
         {
           g_assert (seg->char_count == 1);
@@ -4182,9 +4621,9 @@ _gtk_text_line_byte_to_char_offsets (GtkTextLine *line,
    * want to go. Count chars into the current segment.
    */
 
-  if (seg->type == &gtk_text_char_type)
+  if (_gtk_text_segment_has_chars (seg))
     {
-      *seg_char_offset = g_utf8_strlen (seg->body.chars, offset);
+      *seg_char_offset = g_utf8_strlen (_gtk_char_segment_get_chars (seg), offset);
 
       g_assert (*seg_char_offset < seg->char_count);
 
@@ -4227,18 +4666,18 @@ _gtk_text_line_char_to_byte_offsets (GtkTextLine *line,
   /* offset is now the number of chars into the current segment we
      want to go. Count bytes into the current segment. */
 
-  if (seg->type == &gtk_text_char_type)
+  if (_gtk_text_segment_has_chars (seg))
     {
       const char *p;
 
       /* if in the last fourth of the segment walk backwards */
       if (seg->char_count - offset < seg->char_count / 4)
-        p = g_utf8_offset_to_pointer (seg->body.chars + seg->byte_count, 
+        p = g_utf8_offset_to_pointer (_gtk_char_segment_get_chars (seg) + seg->byte_count, 
                                       offset - seg->char_count);
       else
-        p = g_utf8_offset_to_pointer (seg->body.chars, offset);
+        p = g_utf8_offset_to_pointer (_gtk_char_segment_get_chars (seg), offset);
 
-      *seg_byte_offset = p - seg->body.chars;
+      *seg_byte_offset = p - _gtk_char_segment_get_chars (seg);
 
       g_assert (*seg_byte_offset < seg->byte_count);
 
@@ -5465,6 +5904,58 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
     }
 }
 
+/**
+ * _gtk_text_btree_get_first_invalid_line:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID for the view
+ *
+ * Finds the first line that needs to be validated for the given view,
+ * following the node summaries down the tree.
+ *
+ * Returns: the first invalid line, or %NULL if the view is valid
+ **/
+GtkTextLine *
+_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                        gpointer      view_id)
+{
+  GtkTextBTreeNode *node;
+  GtkTextLine *line;
+
+  g_return_val_if_fail (tree != NULL, NULL);
+
+  if (_gtk_text_btree_is_valid (tree, view_id))
+    return NULL;
+
+  node = tree->root_node;
+  while (node->level > 0)
+    {
+      GtkTextBTreeNode *child;
+
+      for (child = node->children.node; child != NULL; child = child->next)
+        {
+          NodeData *nd = node_data_find (child->node_data, view_id);
+
+          if (nd == NULL || !nd->valid)
+            break;
+        }
+
+      if (child == NULL)
+        return NULL;
+
+      node = child;
+    }
+
+  for (line = node->children.line; line != NULL; line = line->next)
+    {
+      GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+
+      if (ld == NULL || !ld->valid)
+        return line;
+    }
+
+  return NULL;
+}
+
 static void
 gtk_text_btree_node_remove_view (BTreeView *view, GtkTextBTreeNode *node, gpointer view_id)
 {
@@ -6788,7 +7279,7 @@ gtk_text_btree_node_check_consistency (GtkTextBTree     *tree,
                   g_error ("gtk_text_btree_node_check_consistency: wrong segment order for gravity");
                 }
               if ((segPtr->next == NULL)
-                  && (segPtr->type != &gtk_text_char_type))
+                  && (!_gtk_text_segment_has_chars (segPtr)))
                 {
                   g_error ("gtk_text_btree_node_check_consistency: line ended with wrong type");
                 }
@@ -7090,7 +7581,7 @@ _gtk_text_btree_check (GtkTextBTree *tree)
 
       seg = seg->next;
     }
-  if (seg->type != &gtk_text_char_type)
+  if (!_gtk_text_segment_has_chars (seg))
     {
       g_error ("_gtk_text_btree_check: last line has bogus segment type");
     }
@@ -7103,10 +7594,10 @@ _gtk_text_btree_check (GtkTextBTree *tree)
       g_error ("_gtk_text_btree_check: last line has wrong # characters: %d",
                seg->byte_count);
     }
-  if ((seg->body.chars[0] != '\n') || (seg->body.chars[1] != 0))
+  if ((_gtk_char_segment_get_chars (seg)[0] != '\n') || (_gtk_char_segment_get_chars (seg)[1] != 0))
     {
       g_error ("_gtk_text_btree_check: last line had bad value: %s",
-               seg->body.chars);
+               _gtk_char_segment_get_chars (seg));
     }
 }
 #endif /* G_ENABLE_DEBUG */
@@ -7181,9 +7672,9 @@ _gtk_text_btree_spew_line_short (GtkTextLine *line, int indent)
   seg = line->segments;
   while (seg != NULL)
     {
-      if (seg->type == &gtk_text_char_type)
+      if (_gtk_text_segment_has_chars (seg))
         {
-          char * str = g_strndup (seg->body.chars, MIN (seg->byte_count, 10));
+          char * str = g_strndup (_gtk_char_segment_get_chars (seg), MIN (seg->byte_count, 10));
           char * s;
           s = str;
           while (*s)
@@ -7291,9 +7782,9 @@ _gtk_text_btree_spew_segment (GtkTextBTree* tree, GtkTextLineSegment * seg)
   printf ("     segment: %p type: %s bytes: %d chars: %d\n",
           seg, seg->type->name, seg->byte_count, seg->char_count);
 
-  if (seg->type == &gtk_text_char_type)
+  if (_gtk_text_segment_has_chars (seg))
     {
-      char * str = g_strndup (seg->body.chars, seg->byte_count);
+      char * str = g_strndup (_gtk_char_segment_get_chars (seg), seg->byte_count);
       printf ("       '%s'\n", str);
       g_free (str);
     }
@@ -68,6 +68,10 @@ void _gtk_text_btree_delete           (GtkTextIter  *start,
 void _gtk_text_btree_insert           (GtkTextIter  *iter,
                                        const char   *text,
                                        int           len);
+void _gtk_text_btree_insert_borrowed  (GtkTextIter  *iter,
+                                       const char   *text,
+                                       int           len,
+                                       GBytes       *bytes);
 void _gtk_text_btree_insert_paintable (GtkTextIter  *iter,
                                        GdkPaintable *texture);
 
@@ -107,6 +111,8 @@ gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
 void         _gtk_text_btree_validate_line     (GtkTextBTree      *tree,
                                                 GtkTextLine       *line,
                                                 gpointer           view_id);
+GtkTextLine *_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                                   gpointer      view_id);
 
 /* Tag */
 
@@ -114,6 +120,8 @@ void _gtk_text_btree_tag (const GtkTextIter *start,
                           const GtkTextIter *end,
                           GtkTextTag        *tag,
                           gboolean           apply);
+void _gtk_text_btree_begin_tag_batch (GtkTextBTree *tree);
+void _gtk_text_btree_end_tag_batch   (GtkTextBTree *tree);
 
 /* "Getters" */
 
@@ -128,6 +136,10 @@ GtkTextLine * _gtk_text_btree_get_line_at_char  (GtkTextBTree      *tree,
                                                  int                char_index,
                                                  int               *line_start_index,
                                                  int               *real_char_index);
+int           _gtk_text_btree_get_line_number   (GtkTextBTree      *tree,
+                                                 GtkTextLine       *line);
+int           _gtk_text_btree_get_line_char_index (GtkTextBTree    *tree,
+                                                 GtkTextLine       *line);
 GtkTextTag**  _gtk_text_btree_get_tags          (const GtkTextIter *iter,
                                                  int               *num_tags);
 char         *_gtk_text_btree_get_text          (const GtkTextIter *start,
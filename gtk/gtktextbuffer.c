@@ -66,6 +66,10 @@ struct _GtkTextBufferPrivate
 
   GtkTextHistory *history;
 
+  /* Bytes that text inserted from gtk_text_buffer_set_text_from_bytes()
+   * comes from, while that insertion is emitted */
+  GBytes *insert_bytes;
+
   guint user_action_count;
 
   /* Whether the buffer has been modified since last save */
@@ -1208,10 +1212,75 @@ gtk_text_buffer_set_text (GtkTextBuffer *buffer,
 
  
 
+/**
+ * gtk_text_buffer_set_text_from_bytes:
+ * @buffer: a #GtkTextBuffer
+ * @bytes: UTF-8 text to insert
+ *
+ * Deletes current contents of @buffer, and inserts the text in @bytes
+ * instead, like gtk_text_buffer_set_text(). @bytes must contain valid
+ * UTF-8.
+ *
+ * Instead of copying the text, the buffer keeps a reference on @bytes
+ * and uses its contents directly until the text is edited. This makes
+ * it possible to show large files, for example from a #GMappedFile,
+ * without keeping a second copy of them in memory.
+ **/
+void
+gtk_text_buffer_set_text_from_bytes (GtkTextBuffer *buffer,
+                                     GBytes        *bytes)
+{
+  GtkTextBufferPrivate *priv;
+  GtkTextIter start, end;
+  const char *text;
+  gsize len;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (bytes != NULL);
+
+  priv = buffer->priv;
+  text = g_bytes_get_data (bytes, &len);
+  g_return_if_fail (len <= G_MAXINT);
+
+  gtk_text_history_begin_irreversible_action (priv->history);
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+
+  gtk_text_buffer_delete (buffer, &start, &end);
+
+  if (len > 0)
+    {
+      GBytes *old_bytes = priv->insert_bytes;
+
+      priv->insert_bytes = bytes;
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, 0);
+      gtk_text_buffer_insert (buffer, &start, text, len);
+      priv->insert_bytes = old_bytes;
+    }
+
+  gtk_text_history_end_irreversible_action (priv->history);
+}
+
 /*
  * Insertion
  */
 
+static gboolean
+text_is_in_bytes (GBytes     *bytes,
+                  const char *text,
+                  int         len)
+{
+  const char *data;
+  gsize size;
+
+  if (bytes == NULL)
+    return FALSE;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  return text >= data && text + len <= data + size;
+}
+
 static void
 gtk_text_buffer_real_insert_text (GtkTextBuffer *buffer,
                                   GtkTextIter   *iter,
@@ -1226,7 +1295,10 @@ gtk_text_buffer_real_insert_text (GtkTextBuffer *buffer,
                                   text,
                                   len);
 
-  _gtk_text_btree_insert (iter, text, len);
+  if (text_is_in_bytes (buffer->priv->insert_bytes, text, len))
+    _gtk_text_btree_insert_borrowed (iter, text, len, buffer->priv->insert_bytes);
+  else
+    _gtk_text_btree_insert (iter, text, len);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
   g_object_notify_by_pspec (G_OBJECT (buffer), text_buffer_props[PROP_CURSOR_POSITION]);
@@ -2979,6 +3051,66 @@ gtk_text_buffer_apply_tag (GtkTextBuffer     *buffer,
   gtk_text_buffer_emit_tag (buffer, tag, TRUE, start, end);
 }
 
+/**
+ * gtk_text_buffer_apply_tag_ranges:
+ * @buffer: a #GtkTextBuffer
+ * @ranges: (array length=n_ranges): the ranges to tag
+ * @n_ranges: the number of ranges
+ *
+ * Applies each tag in @ranges to its range of the buffer, like
+ * calling gtk_text_buffer_apply_tag() for every range, but much
+ * cheaper when many ranges are tagged at once, e.g. for syntax
+ * highlighting.
+ *
+ * Unless the “apply-tag” signal is connected to or overridden,
+ * the tags are applied without emitting it, and views are only
+ * told to redisplay the region covering all ranges once.
+ *
+ * The ranges should be sorted by their start offset.
+ **/
+void
+gtk_text_buffer_apply_tag_ranges (GtkTextBuffer         *buffer,
+                                  const GtkTextTagRange *ranges,
+                                  guint                  n_ranges)
+{
+  GtkTextBufferPrivate *priv;
+  gboolean emit;
+  guint i;
+
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (ranges != NULL || n_ranges == 0);
+
+  priv = buffer->priv;
+
+  emit = GTK_TEXT_BUFFER_GET_CLASS (buffer)->apply_tag != gtk_text_buffer_real_apply_tag ||
+         g_signal_has_handler_pending (buffer, signals[APPLY_TAG], 0, FALSE);
+
+  _gtk_text_btree_begin_tag_batch (get_btree (buffer));
+
+  for (i = 0; i < n_ranges; i++)
+    {
+      const GtkTextTagRange *range = &ranges[i];
+      GtkTextIter start, end;
+
+      if (!GTK_IS_TEXT_TAG (range->tag) ||
+          range->tag->priv->table != priv->tag_table)
+        {
+          g_warning ("Can only apply tags that are in the tag table for the buffer");
+          continue;
+        }
+
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, range->start);
+      gtk_text_buffer_get_iter_at_offset (buffer, &end, range->end);
+
+      if (emit)
+        gtk_text_buffer_emit_tag (buffer, range->tag, TRUE, &start, &end);
+      else
+        _gtk_text_btree_tag (&start, &end, range->tag, TRUE);
+    }
+
+  _gtk_text_btree_end_tag_batch (get_btree (buffer));
+}
+
 /**
  * gtk_text_buffer_remove_tag:
  * @buffer: a #GtkTextBuffer
@@ -5016,3 +5148,43 @@ gtk_text_buffer_set_max_undo_levels (GtkTextBuffer *buffer,
 
   gtk_text_history_set_max_undo_levels (buffer->priv->history, max_undo_levels);
 }
+
+/**
+ * gtk_text_buffer_get_max_undo_size:
+ * @buffer: a #GtkTextBuffer
+ *
+ * Gets the maximum number of bytes of text kept for undo, see
+ * gtk_text_buffer_set_max_undo_size().
+ *
+ * Returns: the maximum size of the undo history, or 0 if unlimited
+ */
+gsize
+gtk_text_buffer_get_max_undo_size (GtkTextBuffer *buffer)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), 0);
+
+  return gtk_text_history_get_max_undo_size (buffer->priv->history);
+}
+
+/**
+ * gtk_text_buffer_set_max_undo_size:
+ * @buffer: a #GtkTextBuffer
+ * @max_undo_size: the maximum number of bytes to keep for undo
+ *
+ * Sets the maximum number of bytes of inserted or removed text that
+ * is kept for undo. When the history grows larger, the oldest undo
+ * actions are dropped, in addition to the limit set with
+ * gtk_text_buffer_set_max_undo_levels(). The most recent action is
+ * always kept. If 0, the size of the history is not limited.
+ *
+ * Large texts of older actions are kept compressed, so the history
+ * may store more text than @max_undo_size.
+ */
+void
+gtk_text_buffer_set_max_undo_size (GtkTextBuffer *buffer,
+                                   gsize          max_undo_size)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+
+  gtk_text_history_set_max_undo_size (buffer->priv->history, max_undo_size);
+}
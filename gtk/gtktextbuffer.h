@@ -64,6 +64,24 @@ typedef enum
 
 typedef struct _GtkTextBTree GtkTextBTree;
 
+/**
+ * GtkTextTagRange:
+ * @tag: the tag to apply
+ * @start: character offset of the start of the range
+ * @end: character offset of the end of the range
+ *
+ * A range of text to apply a tag to, used with
+ * gtk_text_buffer_apply_tag_ranges().
+ */
+typedef struct _GtkTextTagRange GtkTextTagRange;
+
+struct _GtkTextTagRange
+{
+  GtkTextTag *tag;
+  int start;
+  int end;
+};
+
 #define GTK_TYPE_TEXT_BUFFER            (gtk_text_buffer_get_type ())
 #define GTK_TEXT_BUFFER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_TYPE_TEXT_BUFFER, GtkTextBuffer))
 #define GTK_TEXT_BUFFER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTK_TYPE_TEXT_BUFFER, GtkTextBufferClass))
@@ -180,6 +198,9 @@ GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_set_text          (GtkTextBuffer *buffer,
                                         const char    *text,
                                         int            len);
+GDK_AVAILABLE_IN_ALL
+void gtk_text_buffer_set_text_from_bytes (GtkTextBuffer *buffer,
+                                          GBytes        *bytes);
 
 /* Insert into the buffer */
 GDK_AVAILABLE_IN_ALL
@@ -336,6 +357,10 @@ void gtk_text_buffer_apply_tag             (GtkTextBuffer     *buffer,
                                             const GtkTextIter *start,
                                             const GtkTextIter *end);
 GDK_AVAILABLE_IN_ALL
+void gtk_text_buffer_apply_tag_ranges      (GtkTextBuffer         *buffer,
+                                            const GtkTextTagRange *ranges,
+                                            guint                  n_ranges);
+GDK_AVAILABLE_IN_ALL
 void gtk_text_buffer_remove_tag            (GtkTextBuffer     *buffer,
                                             GtkTextTag        *tag,
                                             const GtkTextIter *start,
@@ -472,6 +497,11 @@ GDK_AVAILABLE_IN_ALL
 void            gtk_text_buffer_set_max_undo_levels       (GtkTextBuffer *buffer,
                                                            guint          max_undo_levels);
 GDK_AVAILABLE_IN_ALL
+gsize           gtk_text_buffer_get_max_undo_size         (GtkTextBuffer *buffer);
+GDK_AVAILABLE_IN_ALL
+void            gtk_text_buffer_set_max_undo_size         (GtkTextBuffer *buffer,
+                                                           gsize          max_undo_size);
+GDK_AVAILABLE_IN_ALL
 void            gtk_text_buffer_undo                      (GtkTextBuffer *buffer);
 GDK_AVAILABLE_IN_ALL
 void            gtk_text_buffer_redo                      (GtkTextBuffer *buffer);
@@ -16,6 +16,8 @@
 
 #include "config.h"
 
+#include <gio/gio.h>
+
 #include "gtkistringprivate.h"
 #include "gtktexthistoryprivate.h"
 
@@ -36,7 +38,21 @@
  * gtk_text_history_end_irreversible_action() can be used to denote a
  * section of operations that cannot be undone. This will cause all previous
  * changes tracked by the GtkTextHistory to be discarded.
+ *
+ * Large texts of actions that are a few steps down the undo queue are
+ * kept compressed, and decompressed again when they are undone or
+ * chained to. Besides the number of undo levels, the history can be
+ * limited in the number of bytes it stores, in which case the oldest
+ * actions are dropped first.
+ */
+
+/* Texts smaller than this are not worth compressing */
+#define COMPRESS_MIN_BYTES 1024
+
+/* Actions this close to the end of the undo queue are left alone,
+ * as they are likely to be undone or chained to soon.
  */
+#define COMPRESS_DEPTH 4
 
 typedef struct _Action     Action;
 typedef enum   _ActionKind ActionKind;
@@ -58,14 +74,17 @@ struct _Action
   GList link;
   guint is_modified : 1;
   guint is_modified_set : 1;
+  guint is_sealed : 1;
   union {
     struct {
       IString istr;
+      GBytes *compressed;
       guint begin;
       guint end;
     } insert;
     struct {
       IString istr;
+      GBytes *compressed;
       guint begin;
       guint end;
       struct {
@@ -99,6 +118,9 @@ struct _GtkTextHistory
   guint               in_user;
   guint               max_undo_levels;
 
+  gsize               size;
+  gsize               max_undo_size;
+
   guint               can_undo : 1;
   guint               can_redo : 1;
   guint               is_modified : 1;
@@ -107,7 +129,8 @@ struct _GtkTextHistory
   guint               enabled : 1;
 };
 
-static void action_free (Action *action);
+static void  action_free     (Action *action);
+static gsize action_get_size (const Action *action);
 
 G_DEFINE_TYPE (GtkTextHistory, gtk_text_history, G_TYPE_OBJECT)
 
@@ -152,6 +175,18 @@ clear_action_queue (GQueue *queue)
     }
 }
 
+static void
+gtk_text_history_clear_queue (GtkTextHistory *self,
+                              GQueue         *queue)
+{
+  const GList *iter;
+
+  for (iter = queue->head; iter; iter = iter->next)
+    self->size -= action_get_size (iter->data);
+
+  clear_action_queue (queue);
+}
+
 static Action *
 action_new (ActionKind kind)
 {
@@ -164,22 +199,205 @@ action_new (ActionKind kind)
   return action;
 }
 
+static inline gboolean
+action_has_text (const Action *action)
+{
+  return action->kind == ACTION_KIND_INSERT ||
+         action->kind == ACTION_KIND_DELETE_BACKSPACE ||
+         action->kind == ACTION_KIND_DELETE_KEY ||
+         action->kind == ACTION_KIND_DELETE_PROGRAMMATIC ||
+         action->kind == ACTION_KIND_DELETE_SELECTION;
+}
+
+static inline IString *
+action_get_istring (Action *action)
+{
+  if (action->kind == ACTION_KIND_INSERT)
+    return &action->u.insert.istr;
+  else
+    return &action->u.delete.istr;
+}
+
+static inline GBytes **
+action_get_compressed (Action *action)
+{
+  if (action->kind == ACTION_KIND_INSERT)
+    return &action->u.insert.compressed;
+  else
+    return &action->u.delete.compressed;
+}
+
 static void
 action_free (Action *action)
 {
-  if (action->kind == ACTION_KIND_INSERT)
-    istring_clear (&action->u.insert.istr);
-  else if (action->kind == ACTION_KIND_DELETE_BACKSPACE ||
-           action->kind == ACTION_KIND_DELETE_KEY ||
-           action->kind == ACTION_KIND_DELETE_PROGRAMMATIC ||
-           action->kind == ACTION_KIND_DELETE_SELECTION)
-    istring_clear (&action->u.delete.istr);
+  if (action_has_text (action))
+    {
+      g_clear_pointer (action_get_compressed (action), g_bytes_unref);
+      istring_clear (action_get_istring (action));
+    }
   else if (action->kind == ACTION_KIND_GROUP)
     clear_action_queue (&action->u.group.actions);
 
   g_slice_free (Action, action);
 }
 
+/* The number of bytes the action keeps on the heap for its text */
+static gsize
+action_get_size (const Action *action)
+{
+  if (action_has_text (action))
+    {
+      Action *a = (Action *) action;
+      GBytes *compressed = *action_get_compressed (a);
+      IString *istr = action_get_istring (a);
+
+      if (compressed != NULL)
+        return g_bytes_get_size (compressed);
+      else if (!istring_is_inline (istr))
+        return istr->n_bytes;
+    }
+  else if (action->kind == ACTION_KIND_GROUP)
+    {
+      const GList *iter;
+      gsize size = 0;
+
+      for (iter = action->u.group.actions.head; iter; iter = iter->next)
+        size += action_get_size (iter->data);
+
+      return size;
+    }
+
+  return 0;
+}
+
+static GBytes *
+compress_text (const char *text,
+               gsize       len)
+{
+  GZlibCompressor *compressor;
+  GOutputStream *memory;
+  GOutputStream *stream;
+  GBytes *bytes = NULL;
+
+  compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, 1);
+  memory = g_memory_output_stream_new_resizable ();
+  stream = g_converter_output_stream_new (memory, G_CONVERTER (compressor));
+
+  if (g_output_stream_write_all (stream, text, len, NULL, NULL, NULL) &&
+      g_output_stream_close (stream, NULL, NULL))
+    bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (memory));
+
+  g_object_unref (stream);
+  g_object_unref (memory);
+  g_object_unref (compressor);
+
+  return bytes;
+}
+
+static char *
+decompress_text (GBytes *bytes,
+                 gsize   len)
+{
+  GZlibDecompressor *decompressor;
+  GInputStream *memory;
+  GInputStream *stream;
+  char *text;
+  gsize n_read = 0;
+
+  decompressor = g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW);
+  memory = g_memory_input_stream_new_from_bytes (bytes);
+  stream = g_converter_input_stream_new (memory, G_CONVERTER (decompressor));
+
+  text = g_malloc (len + 1);
+  if (!g_input_stream_read_all (stream, text, len, &n_read, NULL, NULL) || n_read != len)
+    g_critical ("Failed to restore text of undo action");
+  text[n_read] = 0;
+
+  g_object_unref (stream);
+  g_object_unref (memory);
+  g_object_unref (decompressor);
+
+  return text;
+}
+
+/* Compresses the text of the action and its children, returning
+ * how many bytes that saved.
+ */
+static gsize
+action_compress (Action *action)
+{
+  gsize saved = 0;
+
+  if (action->is_sealed)
+    return 0;
+
+  action->is_sealed = TRUE;
+
+  if (action_has_text (action))
+    {
+      IString *istr = action_get_istring (action);
+      GBytes **compressed = action_get_compressed (action);
+      GBytes *bytes;
+
+      if (*compressed != NULL || istr->n_bytes < COMPRESS_MIN_BYTES)
+        return 0;
+
+      bytes = compress_text (istr->u.str, istr->n_bytes);
+      if (bytes == NULL || g_bytes_get_size (bytes) >= istr->n_bytes)
+        {
+          g_clear_pointer (&bytes, g_bytes_unref);
+          return 0;
+        }
+
+      /* Keep the lengths, the text is restored from the compressed bytes */
+      saved = istr->n_bytes - g_bytes_get_size (bytes);
+      g_clear_pointer (&istr->u.str, g_free);
+      *compressed = bytes;
+    }
+  else if (action->kind == ACTION_KIND_GROUP)
+    {
+      const GList *iter;
+
+      for (iter = action->u.group.actions.head; iter; iter = iter->next)
+        saved += action_compress (iter->data);
+    }
+
+  return saved;
+}
+
+/* Restores the text of the action and its children, returning
+ * how many bytes that takes in addition.
+ */
+static gsize
+action_decompress (Action *action)
+{
+  gsize added = 0;
+
+  action->is_sealed = FALSE;
+
+  if (action_has_text (action))
+    {
+      IString *istr = action_get_istring (action);
+      GBytes **compressed = action_get_compressed (action);
+
+      if (*compressed == NULL)
+        return 0;
+
+      istr->u.str = decompress_text (*compressed, istr->n_bytes);
+      added = istr->n_bytes - g_bytes_get_size (*compressed);
+      g_clear_pointer (compressed, g_bytes_unref);
+    }
+  else if (action->kind == ACTION_KIND_GROUP)
+    {
+      const GList *iter;
+
+      for (iter = action->u.group.actions.head; iter; iter = iter->next)
+        added += action_decompress (iter->data);
+    }
+
+  return added;
+}
+
 static gboolean
 action_group_is_empty (const Action *action)
 {
@@ -384,21 +602,23 @@ gtk_text_history_do_select (GtkTextHistory *self,
   self->funcs.select (self->funcs_data, selection_insert, selection_bound);
 }
 
+static void
+gtk_text_history_drop (GtkTextHistory *self,
+                       GQueue         *queue,
+                       Action         *action)
+{
+  g_queue_unlink (queue, &action->link);
+  self->size -= action_get_size (action);
+  action_free (action);
+}
+
 static void
 gtk_text_history_truncate_one (GtkTextHistory *self)
 {
   if (self->undo_queue.length > 0)
-    {
-      Action *action = g_queue_peek_head (&self->undo_queue);
-      g_queue_unlink (&self->undo_queue, &action->link);
-      action_free (action);
-    }
+    gtk_text_history_drop (self, &self->undo_queue, g_queue_peek_head (&self->undo_queue));
   else if (self->redo_queue.length > 0)
-    {
-      Action *action = g_queue_peek_tail (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &action->link);
-      action_free (action);
-    }
+    gtk_text_history_drop (self, &self->redo_queue, g_queue_peek_tail (&self->redo_queue));
   else
     {
       g_assert_not_reached ();
@@ -410,11 +630,54 @@ gtk_text_history_truncate (GtkTextHistory *self)
 {
   g_assert (GTK_IS_TEXT_HISTORY (self));
 
-  if (self->max_undo_levels == 0)
-    return;
+  if (self->max_undo_levels > 0)
+    {
+      while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
+        gtk_text_history_truncate_one (self);
+    }
+
+  if (self->max_undo_size > 0)
+    {
+      while (self->size > self->max_undo_size)
+        {
+          Action *head = g_queue_peek_head (&self->undo_queue);
+          Action *last = g_queue_peek_tail (&self->undo_queue);
+
+          /* Always keep the most recent action, even if it is too large */
+          if (last != NULL && last->kind == ACTION_KIND_BARRIER && last->link.prev != NULL)
+            last = last->link.prev->data;
+
+          if (head != last)
+            gtk_text_history_drop (self, &self->undo_queue, head);
+          else if (self->redo_queue.length > 0)
+            gtk_text_history_drop (self, &self->redo_queue, g_queue_peek_tail (&self->redo_queue));
+          else
+            break;
+        }
+    }
+}
+
+/* Compresses the actions that went deep enough into the undo queue,
+ * stopping at the first one that has been looked at before.
+ */
+static void
+gtk_text_history_compress (GtkTextHistory *self)
+{
+  const GList *iter;
+  guint depth = 0;
+
+  for (iter = self->undo_queue.tail; iter; iter = iter->prev)
+    {
+      Action *action = iter->data;
+
+      if (depth++ < COMPRESS_DEPTH)
+        continue;
+
+      if (action->is_sealed)
+        break;
 
-  while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
-    gtk_text_history_truncate_one (self);
+      self->size -= action_compress (action);
+    }
 }
 
 static void
@@ -422,8 +685,8 @@ gtk_text_history_finalize (GObject *object)
 {
   GtkTextHistory *self = (GtkTextHistory *)object;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   G_OBJECT_CLASS (gtk_text_history_parent_class)->finalize (object);
 }
@@ -498,19 +761,37 @@ gtk_text_history_push (GtkTextHistory *self,
   g_assert (self->enabled);
   g_assert (action != NULL);
 
-  while (self->redo_queue.length > 0)
-    {
-      peek = g_queue_peek_head (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &peek->link);
-      action_free (peek);
-    }
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
   in_user_action = self->in_user > 0;
 
-  if (peek == NULL || !action_chain (peek, action, in_user_action))
-    g_queue_push_tail_link (&self->undo_queue, &action->link);
+  if (peek == NULL)
+    {
+      g_queue_push_tail_link (&self->undo_queue, &action->link);
+      self->size += action_get_size (action);
+    }
+  else
+    {
+      gsize size = action_get_size (action);
+      gsize peek_size;
+
+      /* Chaining needs the text of peek, or adds to its children */
+      if (peek->is_sealed)
+        self->size += action_decompress (peek);
+
+      /* Chaining text may move it out of the inline buffer */
+      peek_size = action_has_text (peek) ? action_get_size (peek) : 0;
 
+      if (!action_chain (peek, action, in_user_action))
+        g_queue_push_tail_link (&self->undo_queue, &action->link);
+      else if (action_has_text (peek))
+        size = action_get_size (peek) - peek_size;
+
+      self->size += size;
+    }
+
+  gtk_text_history_compress (self);
   gtk_text_history_truncate (self);
   gtk_text_history_update_state (self);
 }
@@ -711,6 +992,7 @@ gtk_text_history_undo (GtkTextHistory *self)
 
       g_queue_unlink (&self->undo_queue, &action->link);
       g_queue_push_head_link (&self->redo_queue, &action->link);
+      self->size += action_decompress (action);
       gtk_text_history_reverse (self, action);
       gtk_text_history_update_state (self);
 
@@ -744,6 +1026,7 @@ gtk_text_history_redo (GtkTextHistory *self)
 
       g_queue_unlink (&self->redo_queue, &action->link);
       g_queue_push_tail_link (&self->undo_queue, &action->link);
+      self->size += action_decompress (action);
 
       peek = g_queue_peek_head (&self->redo_queue);
 
@@ -791,7 +1074,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
   return_if_applying (self);
   return_if_irreversible (self);
 
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
 
@@ -843,8 +1126,8 @@ gtk_text_history_begin_irreversible_action (GtkTextHistory *self)
 
   self->irreversible++;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   gtk_text_history_update_state (self);
 }
@@ -865,8 +1148,8 @@ gtk_text_history_end_irreversible_action (GtkTextHistory *self)
 
   self->irreversible--;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   gtk_text_history_update_state (self);
 }
@@ -1034,8 +1317,8 @@ gtk_text_history_set_enabled (GtkTextHistory *self,
         {
           self->irreversible = 0;
           self->in_user = 0;
-          clear_action_queue (&self->undo_queue);
-          clear_action_queue (&self->redo_queue);
+          gtk_text_history_clear_queue (self, &self->undo_queue);
+          gtk_text_history_clear_queue (self, &self->redo_queue);
         }
 
       gtk_text_history_update_state (self);
@@ -1062,3 +1345,25 @@ gtk_text_history_set_max_undo_levels (GtkTextHistory *self,
       gtk_text_history_truncate (self);
     }
 }
+
+gsize
+gtk_text_history_get_max_undo_size (GtkTextHistory *self)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_HISTORY (self), 0);
+
+  return self->max_undo_size;
+}
+
+void
+gtk_text_history_set_max_undo_size (GtkTextHistory *self,
+                                    gsize           max_undo_size)
+{
+  g_return_if_fail (GTK_IS_TEXT_HISTORY (self));
+
+  if (self->max_undo_size != max_undo_size)
+    {
+      self->max_undo_size = max_undo_size;
+      gtk_text_history_truncate (self);
+      gtk_text_history_update_state (self);
+    }
+}
@@ -288,8 +288,8 @@ iter_init_from_byte_offset (GtkTextIter *iter,
 
   iter_set_from_byte_offset (real, line, line_byte_offset);
 
-  if (real->segment->type == &gtk_text_char_type &&
-      (real->segment->body.chars[real->segment_byte_offset] & 0xc0) == 0x80)
+  if (_gtk_text_segment_has_chars (real->segment) &&
+      (_gtk_char_segment_get_chars (real->segment)[real->segment_byte_offset] & 0xc0) == 0x80)
     g_warning ("Incorrect line byte index %d falls in the middle of a UTF-8 "
                "character; this will crash the text buffer. "
                "Byte indexes must refer to the start of a character.",
@@ -610,7 +610,7 @@ gtk_text_iter_get_offset (const GtkTextIter *iter)
       ensure_char_offsets (real);
       
       real->cached_char_index =
-        _gtk_text_line_char_index (real->line);
+        _gtk_text_btree_get_line_char_index (real->tree, real->line);
       real->cached_char_index += real->line_char_offset;
     }
 
@@ -643,7 +643,7 @@ gtk_text_iter_get_line (const GtkTextIter *iter)
 
   if (real->cached_line_number < 0)
     real->cached_line_number =
-      _gtk_text_line_get_number (real->line);
+      _gtk_text_btree_get_line_number (real->tree, real->line);
 
   check_invariants (iter);
 
@@ -873,11 +873,11 @@ gtk_text_iter_get_char (const GtkTextIter *iter)
 
   if (gtk_text_iter_is_end (iter))
     return 0;
-  else if (real->segment->type == &gtk_text_char_type)
+  else if (_gtk_text_segment_has_chars (real->segment))
     {
       ensure_byte_offsets (real);
       
-      return g_utf8_get_char (real->segment->body.chars +
+      return g_utf8_get_char (_gtk_char_segment_get_chars (real->segment) +
                               real->segment_byte_offset);
     }
   else
@@ -1893,13 +1893,13 @@ forward_char (GtkTextRealIter *real)
       /* Just moving within a segment. Keep byte count
          up-to-date, if it was already up-to-date. */
 
-      g_assert (real->segment->type == &gtk_text_char_type);
+      g_assert (_gtk_text_segment_has_chars (real->segment));
 
       if (real->line_byte_offset >= 0)
         {
           int bytes;
           const char * start =
-            real->segment->body.chars + real->segment_byte_offset;
+            _gtk_char_segment_get_chars (real->segment) + real->segment_byte_offset;
 
           bytes = g_utf8_next_char (start) - start;
 
@@ -2371,7 +2371,7 @@ gtk_text_iter_backward_chars (GtkTextIter *iter, int count)
     {
       /* Optimize the within-segment case */
       g_assert (real->segment->char_count > 0);
-      g_assert (real->segment->type == &gtk_text_char_type);
+      g_assert (_gtk_text_segment_has_chars (real->segment));
 
       if (real->line_byte_offset >= 0)
         {
@@ -2380,13 +2380,13 @@ gtk_text_iter_backward_chars (GtkTextIter *iter, int count)
 
           /* if in the last fourth of the segment walk backwards */
           if (count < real->segment_char_offset / 4)
-            p = g_utf8_offset_to_pointer (real->segment->body.chars + real->segment_byte_offset, 
+            p = g_utf8_offset_to_pointer (_gtk_char_segment_get_chars (real->segment) + real->segment_byte_offset, 
                                           -count);
           else
-            p = g_utf8_offset_to_pointer (real->segment->body.chars,
+            p = g_utf8_offset_to_pointer (_gtk_char_segment_get_chars (real->segment),
                                           real->segment_char_offset - count);
 
-          new_byte_offset = p - real->segment->body.chars;
+          new_byte_offset = p - _gtk_char_segment_get_chars (real->segment);
           real->line_byte_offset -= (real->segment_byte_offset - new_byte_offset);
           real->segment_byte_offset = new_byte_offset;
         }
@@ -3829,8 +3829,8 @@ gtk_text_iter_set_line_index (GtkTextIter *iter,
   else
     gtk_text_iter_forward_line (iter);
 
-  if (real->segment->type == &gtk_text_char_type &&
-      (real->segment->body.chars[real->segment_byte_offset] & 0xc0) == 0x80)
+  if (_gtk_text_segment_has_chars (real->segment) &&
+      (_gtk_char_segment_get_chars (real->segment)[real->segment_byte_offset] & 0xc0) == 0x80)
     g_warning ("%s: Incorrect byte offset %d falls in the middle of a UTF-8 "
                "character; this will crash the text buffer. "
                "Byte indexes must refer to the start of a character.",
@@ -5811,10 +5811,10 @@ _gtk_text_iter_check (const GtkTextIter *iter)
           if (seg_byte_offset != real->segment_byte_offset)
             g_error ("wrong segment byte offset was stored in iterator");
 
-          if (byte_segment->type == &gtk_text_char_type)
+          if (_gtk_text_segment_has_chars (byte_segment))
             {
               const char *p;
-              p = byte_segment->body.chars + seg_byte_offset;
+              p = _gtk_char_segment_get_chars (byte_segment) + seg_byte_offset;
               
               if (!gtk_text_byte_begins_utf8_char (p))
                 g_error ("broken iterator byte index pointed into the middle of a character");
@@ -5842,10 +5842,10 @@ _gtk_text_iter_check (const GtkTextIter *iter)
           if (seg_char_offset != real->segment_char_offset)
             g_error ("wrong segment char offset was stored in iterator");
 
-          if (char_segment->type == &gtk_text_char_type)
+          if (_gtk_text_segment_has_chars (char_segment))
             {
               const char *p;
-              p = g_utf8_offset_to_pointer (char_segment->body.chars,
+              p = g_utf8_offset_to_pointer (_gtk_char_segment_get_chars (char_segment),
                                             seg_char_offset);
 
               /* hmm, not likely to happen eh */
@@ -5865,13 +5865,13 @@ _gtk_text_iter_check (const GtkTextIter *iter)
 
       /* Make sure the segment offsets are equivalent, if it's a char
          segment. */
-      if (char_segment->type == &gtk_text_char_type)
+      if (_gtk_text_segment_has_chars (char_segment))
         {
           int byte_offset = 0;
           int char_offset = 0;
           while (char_offset < seg_char_offset)
             {
-              const char * start = char_segment->body.chars + byte_offset;
+              const char * start = _gtk_char_segment_get_chars (char_segment) + byte_offset;
               byte_offset += g_utf8_next_char (start) - start;
               char_offset += 1;
             }
@@ -5880,12 +5880,12 @@ _gtk_text_iter_check (const GtkTextIter *iter)
             g_error ("byte offset did not correspond to char offset");
 
           char_offset =
-            g_utf8_strlen (char_segment->body.chars, seg_byte_offset);
+            g_utf8_strlen (_gtk_char_segment_get_chars (char_segment), seg_byte_offset);
 
           if (char_offset != seg_char_offset)
             g_error ("char offset did not correspond to byte offset");
 
-          if (!gtk_text_byte_begins_utf8_char (char_segment->body.chars + seg_byte_offset))
+          if (!gtk_text_byte_begins_utf8_char (_gtk_char_segment_get_chars (char_segment) + seg_byte_offset))
             g_error ("byte index for iterator does not index the start of a character");
         }
     }
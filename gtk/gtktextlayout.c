@@ -90,9 +90,12 @@
 #include "gskpango.h"
 #include "gtkintl.h"
 #include "gtksnapshotprivate.h"
+#include "gtkprivate.h"
 #include "gtkwidgetprivate.h"
 #include "gtktextviewprivate.h"
 
+#include "gdk/gdkparallelprivate.h"
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -109,6 +112,16 @@ struct _GtkTextLayoutPrivate
 
   /* Cache for GtkTextLineDisplay to reduce overhead creating layouts */
   GtkTextLineDisplayCache *cache;
+
+  /* Sizes of invalid lines that were shaped ahead of validation,
+   * only good while the btree stamps match */
+  GHashTable *shaped_lines;
+  guint shaped_chars_stamp;
+  guint shaped_segments_stamp;
+
+  /* Bumped whenever cached render nodes of line displays go stale
+   * without the lines themselves changing, e.g. on state changes */
+  guint node_generation;
 };
 
 static void gtk_text_layout_invalidated     (GtkTextLayout     *layout);
@@ -125,6 +138,14 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
 
+static GtkTextLineDisplay *gtk_text_layout_build_display (GtkTextLayout        *layout,
+                                                          GtkTextLine          *line,
+                                                          gboolean              size_only,
+                                                          gboolean             *needs_size);
+static void                gtk_text_layout_size_display  (GtkTextLayout        *layout,
+                                                          GtkTextLineDisplay   *display,
+                                                          const PangoRectangle *extents);
+
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
 static void gtk_text_layout_after_mark_set_handler     (GtkTextBuffer     *buffer,
@@ -194,6 +215,7 @@ gtk_text_layout_dispose (GObject *object)
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
   g_clear_pointer (&priv->cache, gtk_text_line_display_cache_free);
+  g_clear_pointer (&priv->shaped_lines, g_hash_table_unref);
 
   gtk_text_layout_set_buffer (layout, NULL);
 
@@ -281,6 +303,7 @@ gtk_text_layout_init (GtkTextLayout *text_layout)
 
   text_layout->cursor_visible = TRUE;
   priv->cache = gtk_text_line_display_cache_new ();
+  priv->shaped_lines = g_hash_table_new_full (NULL, NULL, NULL, g_free);
 }
 
 GtkTextLayout*
@@ -307,6 +330,8 @@ void
 gtk_text_layout_set_buffer (GtkTextLayout *layout,
                             GtkTextBuffer *buffer)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (buffer == NULL || GTK_IS_TEXT_BUFFER (buffer));
 
@@ -315,6 +340,9 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
 
   free_style_cache (layout);
 
+  if (priv->shaped_lines != NULL)
+    g_hash_table_remove_all (priv->shaped_lines);
+
   if (layout->buffer)
     {
       _gtk_text_btree_remove_view (_gtk_text_buffer_get_btree (layout->buffer),
@@ -380,6 +408,25 @@ gtk_text_layout_default_style_changed (GtkTextLayout *layout)
   gtk_text_layout_invalidate_all (layout);
 }
 
+/**
+ * gtk_text_layout_invalidate_nodes:
+ * @layout: a #GtkTextLayout
+ *
+ * Drops the render nodes cached on line displays, without invalidating
+ * the layout itself. Use this when the colors used for rendering change,
+ * but sizes do not.
+ */
+void
+gtk_text_layout_invalidate_nodes (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  priv->node_generation++;
+}
+
 void
 gtk_text_layout_set_default_style (GtkTextLayout     *layout,
                                    GtkTextAttributes *values)
@@ -799,6 +846,9 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
       else
         gtk_text_line_display_cache_invalidate_line (priv->cache, line);
     }
+
+  if (!cursors_only && priv->shaped_lines != NULL)
+    g_hash_table_remove (priv->shaped_lines, line);
 }
 
 /* Now invalidate the paragraph containing the cursor
@@ -1067,6 +1117,279 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
     }
 }
 
+/* Lines shaped in one go ahead of validation, and the minimum number
+ * of lines each thread shapes. Shaping is only split across threads
+ * when there is enough work for more than one of them.
+ */
+#define GTK_TEXT_LAYOUT_SHAPE_AHEAD 512
+#define GTK_TEXT_LAYOUT_MIN_LINES_PER_JOB 32
+
+typedef struct
+{
+  int width;
+  int height;
+  int top_ink;
+  int bottom_ink;
+} ShapedLine;
+
+typedef struct
+{
+  GtkTextLine *line;
+  GtkTextLineDisplay *display;
+  PangoRectangle ink_rect;
+  PangoRectangle logical_rect;
+} ShapeLine;
+
+typedef struct
+{
+  ShapeLine *lines;
+  guint n_lines;
+  PangoContext *ltr_context; /* the layout's, only read */
+  PangoContext *rtl_context;
+} ShapeJob;
+
+/* Pango objects may only be used by one thread at a time, and that
+ * includes the font map with its caches. So every job shapes with its
+ * own copy of the layout's contexts, on the default font map of the
+ * thread it runs on. Those are all set up from the same fontconfig
+ * configuration, so they find the same fonts as the widget's.
+ */
+static PangoContext *
+copy_pango_context (PangoContext *context,
+                    PangoFontMap *font_map)
+{
+  PangoContext *copy;
+
+  copy = pango_font_map_create_context (font_map);
+  pango_context_set_font_description (copy, pango_context_get_font_description (context));
+  pango_context_set_language (copy, pango_context_get_language (context));
+  pango_context_set_base_dir (copy, pango_context_get_base_dir (context));
+  pango_context_set_base_gravity (copy, pango_context_get_base_gravity (context));
+  pango_context_set_gravity_hint (copy, pango_context_get_gravity_hint (context));
+  pango_context_set_matrix (copy, pango_context_get_matrix (context));
+  pango_context_set_round_glyph_positions (copy, pango_context_get_round_glyph_positions (context));
+  pango_cairo_context_set_resolution (copy, pango_cairo_context_get_resolution (context));
+  pango_cairo_context_set_font_options (copy, pango_cairo_context_get_font_options (context));
+
+  return copy;
+}
+
+/* Copies what set_para_values() and gtk_text_layout_build_display()
+ * set up on the layout of @display onto a new layout for @context.
+ */
+static PangoLayout *
+copy_pango_layout (PangoLayout  *layout,
+                   PangoContext *context)
+{
+  PangoLayout *copy;
+  PangoTabArray *tabs;
+
+  copy = pango_layout_new (context);
+  pango_layout_set_text (copy, pango_layout_get_text (layout), -1);
+  pango_layout_set_attributes (copy, pango_layout_get_attributes (layout));
+  pango_layout_set_width (copy, pango_layout_get_width (layout));
+  pango_layout_set_wrap (copy, pango_layout_get_wrap (layout));
+  pango_layout_set_indent (copy, pango_layout_get_indent (layout));
+  pango_layout_set_spacing (copy, pango_layout_get_spacing (layout));
+  pango_layout_set_justify (copy, pango_layout_get_justify (layout));
+  pango_layout_set_alignment (copy, pango_layout_get_alignment (layout));
+
+  tabs = pango_layout_get_tabs (layout);
+  if (tabs)
+    {
+      pango_layout_set_tabs (copy, tabs);
+      pango_tab_array_free (tabs);
+    }
+
+  return copy;
+}
+
+/* Runs on a pool thread, or on the main thread when it helps out.
+ * The copies are made and dropped here, so the fonts they load are
+ * only ever touched by the thread whose font map they belong to.
+ */
+static void
+shape_job_func (gpointer data,
+                gpointer unused)
+{
+  ShapeJob *job = data;
+  PangoFontMap *font_map;
+  PangoContext *ltr_context, *rtl_context;
+  guint i;
+
+  font_map = pango_cairo_font_map_get_default ();
+  ltr_context = copy_pango_context (job->ltr_context, font_map);
+  rtl_context = copy_pango_context (job->rtl_context, font_map);
+
+  for (i = 0; i < job->n_lines; i++)
+    {
+      ShapeLine *l = &job->lines[i];
+      PangoLayout *layout;
+
+      layout = copy_pango_layout (l->display->layout,
+                                  l->display->direction == GTK_TEXT_DIR_RTL
+                                  ? rtl_context
+                                  : ltr_context);
+      pango_layout_get_extents (layout, &l->ink_rect, &l->logical_rect);
+      g_object_unref (layout);
+    }
+
+  g_object_unref (ltr_context);
+  g_object_unref (rtl_context);
+}
+
+/* Lines with widgets, paintables or the cursor need the main thread
+ * for more than measuring their text, so they are left to validation.
+ */
+static gboolean
+line_can_shape_ahead (GtkTextLayout *layout,
+                      GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  GtkTextLineSegment *seg;
+
+  if (line == priv->cursor_line)
+    return FALSE;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (_gtk_text_segment_has_chars (seg) ||
+          seg->type == &gtk_text_toggle_on_type ||
+          seg->type == &gtk_text_toggle_off_type)
+        continue;
+
+      if ((seg->type == &gtk_text_right_mark_type ||
+           seg->type == &gtk_text_left_mark_type) &&
+          !_gtk_text_btree_mark_is_insert (btree, seg->body.mark.obj))
+        continue;
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_text_layout_check_shaped_lines (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  guint chars_stamp, segments_stamp;
+
+  chars_stamp = _gtk_text_btree_get_chars_changed_stamp (btree);
+  segments_stamp = _gtk_text_btree_get_segments_changed_stamp (btree);
+
+  if (priv->shaped_chars_stamp != chars_stamp ||
+      priv->shaped_segments_stamp != segments_stamp)
+    {
+      g_hash_table_remove_all (priv->shaped_lines);
+      priv->shaped_chars_stamp = chars_stamp;
+      priv->shaped_segments_stamp = segments_stamp;
+    }
+}
+
+/* Shapes the next invalid lines in threads, so validating them only
+ * has to pick up their sizes. Text and attributes are still collected
+ * here, as tags and styles must not be touched outside the main thread.
+ */
+static void
+gtk_text_layout_shape_ahead (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  GtkTextLine *line;
+  ShapeLine *lines;
+  ShapeJob *jobs;
+  guint n_lines, n_walked, n_jobs, per_job, i, j;
+
+  gtk_text_layout_check_shaped_lines (layout);
+
+  if (g_hash_table_size (priv->shaped_lines) >= GTK_TEXT_LAYOUT_SHAPE_AHEAD / 4)
+    return;
+
+  /* Other threads can only recreate the default font map. Fonts that
+   * were added to a custom one would be missing there. */
+  if (pango_context_get_font_map (layout->ltr_context) != pango_cairo_font_map_get_default () ||
+      pango_context_get_font_map (layout->rtl_context) != pango_cairo_font_map_get_default ())
+    return;
+
+  lines = g_new (ShapeLine, GTK_TEXT_LAYOUT_SHAPE_AHEAD);
+  n_lines = 0;
+  n_walked = 0;
+  for (line = _gtk_text_btree_get_first_invalid_line (btree, layout);
+       line != NULL &&
+       n_lines + g_hash_table_size (priv->shaped_lines) < GTK_TEXT_LAYOUT_SHAPE_AHEAD &&
+       n_walked < 4 * GTK_TEXT_LAYOUT_SHAPE_AHEAD;
+       line = _gtk_text_line_next_excluding_last (line), n_walked++)
+    {
+      GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
+
+      if ((line_data && line_data->valid) ||
+          g_hash_table_contains (priv->shaped_lines, line) ||
+          !line_can_shape_ahead (layout, line))
+        continue;
+
+      lines[n_lines++].line = line;
+    }
+
+  n_jobs = MIN (gtk_get_n_threads (), n_lines / GTK_TEXT_LAYOUT_MIN_LINES_PER_JOB);
+  if (n_jobs <= 1)
+    {
+      g_free (lines);
+      return;
+    }
+
+  j = 0;
+  for (i = 0; i < n_lines; i++)
+    {
+      gboolean needs_size;
+
+      lines[i].display = gtk_text_layout_build_display (layout, lines[i].line, TRUE, &needs_size);
+      if (needs_size)
+        lines[j++] = lines[i];
+      else
+        gtk_text_line_display_unref (lines[i].display);
+    }
+  n_lines = j;
+
+  per_job = (n_lines + n_jobs - 1) / n_jobs;
+  jobs = g_newa (ShapeJob, n_jobs);
+
+  for (i = 0; i < n_jobs; i++)
+    {
+      jobs[i].lines = lines + MIN (i * per_job, n_lines);
+      jobs[i].n_lines = MIN (per_job, n_lines - MIN (i * per_job, n_lines));
+      jobs[i].ltr_context = layout->ltr_context;
+      jobs[i].rtl_context = layout->rtl_context;
+    }
+
+  gdk_parallel_run (jobs, sizeof (ShapeJob), n_jobs, shape_job_func, NULL);
+
+  for (i = 0; i < n_lines; i++)
+    {
+      ShapeLine *l = &lines[i];
+      ShapedLine *shaped;
+
+      gtk_text_layout_size_display (layout, l->display, &l->logical_rect);
+
+      /* Same as pango_layout_get_pixel_extents() */
+      pango_extents_to_pixels (&l->ink_rect, NULL);
+      pango_extents_to_pixels (&l->logical_rect, NULL);
+
+      shaped = g_new (ShapedLine, 1);
+      shaped->width = l->display->width;
+      shaped->height = l->display->height;
+      shaped->top_ink = MAX (0, l->logical_rect.x - l->ink_rect.x);
+      shaped->bottom_ink = MAX (0, l->logical_rect.x + l->logical_rect.width - l->ink_rect.x - l->ink_rect.width);
+      g_hash_table_insert (priv->shaped_lines, l->line, shaped);
+
+      gtk_text_line_display_unref (l->display);
+    }
+
+  g_free (lines);
+}
+
 /**
  * gtk_text_layout_validate:
  * @tree: a #GtkTextLayout
@@ -1084,6 +1407,9 @@ gtk_text_layout_validate (GtkTextLayout *layout,
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
+  if (max_pixels > 0 && !gtk_text_layout_is_valid (layout))
+    gtk_text_layout_shape_ahead (layout);
+
   while (max_pixels > 0 &&
          _gtk_text_btree_validate (_gtk_text_buffer_get_btree (layout->buffer),
                                    layout,  max_pixels,
@@ -1102,6 +1428,7 @@ gtk_text_layout_wrap (GtkTextLayout   *layout,
                       /* may be NULL */
                       GtkTextLineData *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
   PangoRectangle ink_rect, logical_rect;
 
@@ -1114,6 +1441,26 @@ gtk_text_layout_wrap (GtkTextLayout   *layout,
       _gtk_text_line_add_data (line, line_data);
     }
 
+  if (priv->shaped_lines != NULL && g_hash_table_size (priv->shaped_lines) > 0)
+    {
+      ShapedLine *shaped;
+
+      gtk_text_layout_check_shaped_lines (layout);
+
+      shaped = g_hash_table_lookup (priv->shaped_lines, line);
+      if (shaped != NULL)
+        {
+          line_data->width = shaped->width;
+          line_data->height = shaped->height;
+          line_data->top_ink = shaped->top_ink;
+          line_data->bottom_ink = shaped->bottom_ink;
+          line_data->valid = TRUE;
+          g_hash_table_remove (priv->shaped_lines, line);
+
+          return line_data;
+        }
+    }
+
   display = gtk_text_layout_get_line_display (layout, line, TRUE);
   line_data->width = display->width;
   line_data->height = display->height;
@@ -2194,7 +2541,7 @@ gtk_text_layout_update_display_cursors (GtkTextLayout      *layout,
   while (seg != NULL)
     {
       /* Displayable segments */
-      if (seg->type == &gtk_text_char_type ||
+      if (_gtk_text_segment_has_chars (seg) ||
           seg->type == &gtk_text_paintable_type ||
           seg->type == &gtk_text_child_type)
         {
@@ -2315,10 +2662,55 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
-GtkTextLineDisplay *
-gtk_text_layout_create_display (GtkTextLayout *layout,
-                                GtkTextLine   *line,
-                                gboolean       size_only)
+/* Sets the size of @display from the logical @extents of its layout */
+static void
+gtk_text_layout_size_display (GtkTextLayout        *layout,
+                              GtkTextLineDisplay   *display,
+                              const PangoRectangle *extents)
+{
+  int text_pixel_width;
+  int h_margin;
+  int h_padding;
+
+  text_pixel_width = PIXEL_BOUND (extents->width);
+
+  h_margin = display->left_margin + display->right_margin;
+  h_padding = layout->left_padding + layout->right_padding;
+
+  display->width = text_pixel_width + h_margin + h_padding;
+  display->height += PANGO_PIXELS (extents->height);
+
+  /* If we aren't wrapping, we need to do the alignment of each
+   * paragraph ourselves.
+   */
+  if (pango_layout_get_width (display->layout) < 0)
+    {
+      int excess = display->total_width - text_pixel_width;
+
+      switch (pango_layout_get_alignment (display->layout))
+        {
+        case PANGO_ALIGN_LEFT:
+        default:
+          break;
+        case PANGO_ALIGN_CENTER:
+          display->x_offset += excess / 2;
+          break;
+        case PANGO_ALIGN_RIGHT:
+          display->x_offset += excess;
+          break;
+        }
+    }
+}
+
+/* Creates the display for @line with its text and attributes set,
+ * but without asking Pango for the size, so the text is not shaped
+ * yet. @needs_size is set to %FALSE for lines that take no space.
+ */
+static GtkTextLineDisplay *
+gtk_text_layout_build_display (GtkTextLayout *layout,
+                               GtkTextLine   *line,
+                               gboolean       size_only,
+                               gboolean      *needs_size)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
@@ -2326,10 +2718,8 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   GtkTextIter iter;
   GtkTextAttributes *style;
   char *text;
-  int text_pixel_width;
   PangoAttrList *attrs;
   int text_allocated, layout_byte_offset, buffer_byte_offset;
-  PangoRectangle extents;
   gboolean para_values_set = FALSE;
   GSList *cursor_byte_offsets = NULL;
   GSList *cursor_segs = NULL;
@@ -2338,14 +2728,10 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   PangoDirection base_dir;
   GPtrArray *tags;
   gboolean initial_toggle_segments;
-  int h_margin;
-  int h_padding;
   PangoAttribute *last_font_attr = NULL;
   PangoAttribute *last_scale_attr = NULL;
   PangoAttribute *last_fallback_attr = NULL;
 
-  g_return_val_if_fail (line != NULL, NULL);
-
   display = g_rc_box_new0 (GtkTextLineDisplay);
 
   display->mru_link.data = display;
@@ -2360,9 +2746,12 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   if (totally_invisible_line (layout, line, &iter))
     {
       display->layout = pango_layout_new (layout->ltr_context);
+      *needs_size = FALSE;
       return g_steal_pointer (&display);
     }
 
+  *needs_size = TRUE;
+
   /* Find the bidi base direction */
   base_dir = line->dir_propagated_forward;
   if (base_dir == PANGO_DIRECTION_NEUTRAL)
@@ -2391,7 +2780,7 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   while (seg != NULL)
     {
       /* Displayable segments */
-      if (seg->type == &gtk_text_char_type ||
+      if (_gtk_text_segment_has_chars (seg) ||
           seg->type == &gtk_text_paintable_type ||
           seg->type == &gtk_text_child_type)
         {
@@ -2416,7 +2805,7 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
            */
           if (!style->invisible)
             {
-              if (seg->type == &gtk_text_char_type)
+              if (_gtk_text_segment_has_chars (seg))
                 {
                   /* We don't want to split segments because of marks,
                    * so we scan forward for more segments only
@@ -2430,9 +2819,9 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   
                   while (seg)
                     {
-                      if (seg->type == &gtk_text_char_type)
+                      if (_gtk_text_segment_has_chars (seg))
                         {
-                          memcpy (text + layout_byte_offset, seg->body.chars, seg->byte_count);
+                          memcpy (text + layout_byte_offset, _gtk_char_segment_get_chars (seg), seg->byte_count);
                           layout_byte_offset += seg->byte_count;
                           buffer_byte_offset += seg->byte_count;
                           bytes += seg->byte_count;
@@ -2629,38 +3018,6 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
-  pango_layout_get_extents (display->layout, NULL, &extents);
-
-  text_pixel_width = PIXEL_BOUND (extents.width);
-  display->width = text_pixel_width + display->left_margin + display->right_margin;
-
-  h_margin = display->left_margin + display->right_margin;
-  h_padding = layout->left_padding + layout->right_padding;
-
-  display->width = text_pixel_width + h_margin + h_padding;
-  display->height += PANGO_PIXELS (extents.height);
-
-  /* If we aren't wrapping, we need to do the alignment of each
-   * paragraph ourselves.
-   */
-  if (pango_layout_get_width (display->layout) < 0)
-    {
-      int excess = display->total_width - text_pixel_width;
-
-      switch (pango_layout_get_alignment (display->layout))
-        {
-        case PANGO_ALIGN_LEFT:
-        default:
-          break;
-        case PANGO_ALIGN_CENTER:
-          display->x_offset += excess / 2;
-          break;
-        case PANGO_ALIGN_RIGHT:
-          display->x_offset += excess;
-          break;
-        }
-    }
-  
   /* Free this if we aren't in a loop */
   if (layout->wrap_loop_count == 0)
     invalidate_cached_style (layout);
@@ -2672,12 +3029,33 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
 
   display->has_children = saw_widget;
 
-  if (saw_widget)
-    allocate_child_widgets (layout, display);
-  
   return g_steal_pointer (&display);
 }
 
+GtkTextLineDisplay *
+gtk_text_layout_create_display (GtkTextLayout *layout,
+                                GtkTextLine   *line,
+                                gboolean       size_only)
+{
+  GtkTextLineDisplay *display;
+  PangoRectangle extents;
+  gboolean needs_size;
+
+  g_return_val_if_fail (line != NULL, NULL);
+
+  display = gtk_text_layout_build_display (layout, line, size_only, &needs_size);
+  if (!needs_size)
+    return display;
+
+  pango_layout_get_extents (display->layout, NULL, &extents);
+  gtk_text_layout_size_display (layout, display, &extents);
+
+  if (display->has_children)
+    allocate_child_widgets (layout, display);
+
+  return display;
+}
+
 GtkTextLineDisplay *
 gtk_text_layout_get_line_display (GtkTextLayout *layout,
                                   GtkTextLine   *line,
@@ -4135,6 +4513,33 @@ snapshot_shape (PangoAttrShape         *attr,
   return FALSE;
 }
 
+/* The selection and the block cursor are part of the paragraph node,
+ * so it can only be reused if they did not change since. The regular
+ * cursors are painted on top and don't matter here.
+ */
+static gboolean
+line_display_node_is_valid (GtkTextLayout      *layout,
+                            GtkTextLineDisplay *line_display,
+                            int                 selection_start_index,
+                            int                 selection_end_index,
+                            float               cursor_alpha)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (line_display->node_generation != priv->node_generation)
+    return FALSE;
+
+  if (line_display->node_selection_start != selection_start_index ||
+      line_display->node_selection_end != selection_end_index)
+    return FALSE;
+
+  if (line_display->has_block_cursor &&
+      line_display->node_cursor_alpha != cursor_alpha)
+    return FALSE;
+
+  return TRUE;
+}
+
 void
 gtk_text_layout_snapshot (GtkTextLayout      *layout,
                           GtkWidget          *widget,
@@ -4245,6 +4650,13 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
                 selection_end_index = -1;
             }
 
+          if (line_display->node != NULL &&
+              !line_display_node_is_valid (layout, line_display,
+                                           selection_start_index,
+                                           selection_end_index,
+                                           cursor_alpha))
+            g_clear_pointer (&line_display->node, gsk_render_node_unref);
+
           if (line_display->node == NULL)
             {
               gtk_snapshot_push_collect (snapshot);
@@ -4253,6 +4665,10 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
                            cursor_alpha);
 
               line_display->node = gtk_snapshot_pop_collect (snapshot);
+              line_display->node_generation = priv->node_generation;
+              line_display->node_selection_start = selection_start_index;
+              line_display->node_selection_end = selection_end_index;
+              line_display->node_cursor_alpha = cursor_alpha;
             }
 
           if (line_display->node != NULL)
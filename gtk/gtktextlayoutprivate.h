@@ -186,6 +186,8 @@ struct _GtkTextLineDisplay
 {
   PangoLayout *layout;
 
+  /* Rendered paragraph, only reused while the state it was
+   * rendered with (see node_*) is unchanged */
   GskRenderNode *node;
 
   GArray *cursors;      /* indexes of cursors in the PangoLayout, and mark names */
@@ -223,6 +225,11 @@ struct _GtkTextLineDisplay
   guint has_children : 1;
 
   GdkRGBA pg_bg_rgba;
+
+  guint node_generation;
+  int node_selection_start;
+  int node_selection_end;
+  float node_cursor_alpha;
 };
 
 #ifdef GTK_COMPILATION
@@ -247,6 +254,7 @@ void		   gtk_text_layout_set_overwrite_mode	 (GtkTextLayout     *layout,
 void               gtk_text_layout_set_keyboard_direction (GtkTextLayout     *layout,
 							   GtkTextDirection keyboard_dir);
 void               gtk_text_layout_default_style_changed (GtkTextLayout     *layout);
+void               gtk_text_layout_invalidate_nodes      (GtkTextLayout     *layout);
 
 void gtk_text_layout_set_screen_width       (GtkTextLayout     *layout,
                                              int                width);
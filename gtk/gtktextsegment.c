@@ -156,6 +156,8 @@ gtk_text_line_segment_split (const GtkTextIter *iter)
         + 1 + (chars)))
 #define TSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
         + sizeof (GtkTextToggleBody)))
+#define BSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
+        + sizeof (GtkTextBorrowedBody)))
 
 /*
  * Type functions
@@ -175,12 +177,13 @@ char_segment_self_check (GtkTextLineSegment *seg)
       g_error ("segment has size <= 0");
     }
 
-  if (strlen (seg->body.chars) != seg->byte_count)
+  if (seg->type == &gtk_text_char_type &&
+      strlen (seg->body.chars) != seg->byte_count)
     {
       g_error ("segment has wrong size");
     }
 
-  if (g_utf8_strlen (seg->body.chars, seg->byte_count) != seg->char_count)
+  if (g_utf8_strlen (_gtk_char_segment_get_chars (seg), seg->byte_count) != seg->char_count)
     {
       g_error ("char segment has wrong character count");
     }
@@ -237,12 +240,47 @@ _gtk_char_segment_new_from_two_strings (const char *text1,
   return seg;
 }
 
+/* Text is only borrowed when that takes less memory than copying it */
+GtkTextLineSegment*
+_gtk_borrowed_char_segment_new (GBytes     *bytes,
+                                const char *text,
+                                guint       len)
+{
+  GtkTextLineSegment *seg;
+
+  if (len < sizeof (GtkTextBorrowedBody))
+    return _gtk_char_segment_new (text, len);
+
+  g_assert (gtk_text_byte_begins_utf8_char (text));
+
+  seg = g_slice_alloc (BSEG_SIZE);
+  seg->type = &gtk_text_borrowed_char_type;
+  seg->next = NULL;
+  seg->byte_count = len;
+  seg->body.borrowed.chars = text;
+  seg->body.borrowed.bytes = g_bytes_ref (bytes);
+
+  seg->char_count = g_utf8_strlen (text, len);
+
+  if (GTK_DEBUG_CHECK (TEXT))
+    char_segment_self_check (seg);
+
+  return seg;
+}
+
 static void
 _gtk_char_segment_free (GtkTextLineSegment *seg)
 {
   if (seg == NULL)
     return;
 
+  if (seg->type == &gtk_text_borrowed_char_type)
+    {
+      g_bytes_unref (seg->body.borrowed.bytes);
+      g_slice_free1 (BSEG_SIZE, seg);
+      return;
+    }
+
   g_assert (seg->type == &gtk_text_char_type);
 
   g_slice_free1 (CSEG_SIZE (seg->byte_count), seg);
@@ -278,11 +316,22 @@ char_segment_split_func (GtkTextLineSegment *seg, int index)
       char_segment_self_check (seg);
     }
 
-  new1 = _gtk_char_segment_new (seg->body.chars, index);
-  new2 = _gtk_char_segment_new (seg->body.chars + index, seg->byte_count - index);
+  if (seg->type == &gtk_text_borrowed_char_type)
+    {
+      new1 = _gtk_borrowed_char_segment_new (seg->body.borrowed.bytes,
+                                             seg->body.borrowed.chars, index);
+      new2 = _gtk_borrowed_char_segment_new (seg->body.borrowed.bytes,
+                                             seg->body.borrowed.chars + index,
+                                             seg->byte_count - index);
+    }
+  else
+    {
+      new1 = _gtk_char_segment_new (seg->body.chars, index);
+      new2 = _gtk_char_segment_new (seg->body.chars + index, seg->byte_count - index);
+    }
 
-  g_assert (gtk_text_byte_begins_utf8_char (new1->body.chars));
-  g_assert (gtk_text_byte_begins_utf8_char (new2->body.chars));
+  g_assert (gtk_text_byte_begins_utf8_char (_gtk_char_segment_get_chars (new1)));
+  g_assert (gtk_text_byte_begins_utf8_char (_gtk_char_segment_get_chars (new2)));
   g_assert (new1->byte_count + new2->byte_count == seg->byte_count);
   g_assert (new1->char_count + new2->char_count == seg->char_count);
 
@@ -332,18 +381,30 @@ char_segment_cleanup_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
     char_segment_self_check (segPtr);
 
   segPtr2 = segPtr->next;
-  if ((segPtr2 == NULL) || (segPtr2->type != &gtk_text_char_type))
+  if ((segPtr2 == NULL) || !_gtk_text_segment_has_chars (segPtr2))
     {
       return segPtr;
     }
 
-  newPtr =
-    _gtk_char_segment_new_from_two_strings (segPtr->body.chars, 
-					    segPtr->byte_count,
-					    segPtr->char_count,
-                                            segPtr2->body.chars, 
-					    segPtr2->byte_count,
-					    segPtr2->char_count);
+  /* Pieces of borrowed text that were split apart are joined
+   * without copying, anything else gets copied. So editing a line
+   * of borrowed text copies that line.
+   */
+  if (segPtr->type == &gtk_text_borrowed_char_type &&
+      segPtr2->type == &gtk_text_borrowed_char_type &&
+      segPtr->body.borrowed.bytes == segPtr2->body.borrowed.bytes &&
+      segPtr->body.borrowed.chars + segPtr->byte_count == segPtr2->body.borrowed.chars)
+    newPtr = _gtk_borrowed_char_segment_new (segPtr->body.borrowed.bytes,
+                                             segPtr->body.borrowed.chars,
+                                             segPtr->byte_count + segPtr2->byte_count);
+  else
+    newPtr =
+      _gtk_char_segment_new_from_two_strings (_gtk_char_segment_get_chars (segPtr),
+                                              segPtr->byte_count,
+                                              segPtr->char_count,
+                                              _gtk_char_segment_get_chars (segPtr2),
+                                              segPtr2->byte_count,
+                                              segPtr2->char_count);
 
   newPtr->next = segPtr2->next;
 
@@ -415,7 +476,7 @@ char_segment_check_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
 
   if (segPtr->next != NULL)
     {
-      if (segPtr->next->type == &gtk_text_char_type)
+      if (_gtk_text_segment_has_chars (segPtr->next))
         {
           g_error ("adjacent character segments weren't merged");
         }
@@ -630,6 +691,21 @@ const GtkTextLineSegmentClass gtk_text_char_type = {
   char_segment_check_func                               /* checkFunc */
 };
 
+/*
+ * Type record for character segments that reference text
+ * they don't own:
+ */
+
+const GtkTextLineSegmentClass gtk_text_borrowed_char_type = {
+  "borrowedCharacter",                          /* name */
+  0,                                            /* leftGravity */
+  char_segment_split_func,                              /* splitFunc */
+  char_segment_delete_func,                             /* deleteFunc */
+  char_segment_cleanup_func,                            /* cleanupFunc */
+  NULL,         /* lineChangeFunc */
+  char_segment_check_func                               /* checkFunc */
+};
+
 /*
  * Type record for segments marking the beginning of a tagged
  * range:
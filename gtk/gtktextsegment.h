@@ -60,6 +60,14 @@ struct _GtkTextToggleBody {
 };
 
 
+/* Body of a character segment that references text it doesn't own,
+ * such as a mapped file. The text is not nul-terminated. */
+typedef struct _GtkTextBorrowedBody GtkTextBorrowedBody;
+struct _GtkTextBorrowedBody {
+  const char *chars;
+  GBytes *bytes;                    /* keeps chars alive */
+};
+
 /* Class struct for segments */
 
 /* Split seg at index, returning list of two new segments, and freeing seg */
@@ -142,6 +150,7 @@ struct _GtkTextLineSegment {
     char chars[4];                      /* Characters that make up character
                                          * info.  Actual length varies to
                                          * hold as many characters as needed.*/
+    GtkTextBorrowedBody borrowed;       /* Characters owned by someone else */
     GtkTextToggleBody toggle;           /* Information about tag toggle. */
     GtkTextMarkBody mark;               /* Information about mark. */
     GtkTextPaintable paintable;         /* Child texture */
@@ -150,6 +159,23 @@ struct _GtkTextLineSegment {
 };
 
 
+/* Character segments either own their text or borrow it */
+static inline gboolean
+_gtk_text_segment_has_chars (const GtkTextLineSegment *seg)
+{
+  return seg->type == &gtk_text_char_type ||
+         seg->type == &gtk_text_borrowed_char_type;
+}
+
+static inline const char *
+_gtk_char_segment_get_chars (const GtkTextLineSegment *seg)
+{
+  if (seg->type == &gtk_text_borrowed_char_type)
+    return seg->body.borrowed.chars;
+
+  return seg->body.chars;
+}
+
 GtkTextLineSegment  *gtk_text_line_segment_split (const GtkTextIter *iter);
 
 GtkTextLineSegment *_gtk_char_segment_new                  (const char     *text,
@@ -160,6 +186,9 @@ GtkTextLineSegment *_gtk_char_segment_new_from_two_strings (const char     *text
                                                             const char     *text2,
                                                             guint           len2,
 							    guint           chars2);
+GtkTextLineSegment *_gtk_borrowed_char_segment_new         (GBytes         *bytes,
+                                                            const char     *text,
+                                                            guint           len);
 GtkTextLineSegment *_gtk_toggle_segment_new                (GtkTextTagInfo *info,
                                                             gboolean        on);
 
@@ -42,6 +42,7 @@ typedef struct _GtkTextMarkBody GtkTextMarkBody;
 
 /* In gtktextbtree.c */
 extern G_GNUC_INTERNAL const GtkTextLineSegmentClass gtk_text_char_type;
+extern G_GNUC_INTERNAL const GtkTextLineSegmentClass gtk_text_borrowed_char_type;
 extern G_GNUC_INTERNAL const GtkTextLineSegmentClass gtk_text_toggle_on_type;
 extern G_GNUC_INTERNAL const GtkTextLineSegmentClass gtk_text_toggle_off_type;
 
@@ -4919,6 +4919,10 @@ gtk_text_view_state_flags_changed (GtkWidget     *widget,
 
   gtk_css_node_set_state (priv->selection_node, state);
 
+  /* Selection colors and the block cursor depend on the state */
+  if (priv->layout)
+    gtk_text_layout_invalidate_nodes (priv->layout);
+
   gtk_widget_queue_draw (widget);
 }
 
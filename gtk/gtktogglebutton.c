@@ -34,6 +34,7 @@
 #include "gtkmain.h"
 #include "gtkmarshalers.h"
 #include "gtkprivate.h"
+#include "gtkwidgetprivate.h"
 
 /**
  * SECTION:gtktogglebutton
@@ -287,6 +288,7 @@ gtk_toggle_button_class_init (GtkToggleButtonClass *class)
                   G_TYPE_NONE, 0);
 
   gtk_widget_class_set_css_name (widget_class, I_("button"));
+  gtk_widget_class_set_measure_equal_func (widget_class, gtk_widget_measure_equal_style);
 }
 
 static void
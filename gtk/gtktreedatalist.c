@@ -23,13 +23,22 @@
 #include <string.h>
 
 /* node allocation
+ *
+ * The nodes of a row are allocated together, as one block of
+ * @n_columns zeroed nodes that are already linked up. This saves an
+ * allocation per cell and keeps the cells of a row next to each other.
  */
 GtkTreeDataList *
-_gtk_tree_data_list_alloc (void)
+_gtk_tree_data_list_alloc (int n_columns)
 {
   GtkTreeDataList *list;
+  int i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
 
-  list = g_slice_new0 (GtkTreeDataList);
+  list = g_new0 (GtkTreeDataList, n_columns);
+  for (i = 0; i < n_columns - 1; i++)
+    list[i].next = &list[i + 1];
 
   return list;
 }
@@ -38,14 +47,11 @@ void
 _gtk_tree_data_list_free (GtkTreeDataList *list,
 			  GType           *column_headers)
 {
-  GtkTreeDataList *tmp, *next;
+  GtkTreeDataList *tmp;
   int i = 0;
 
-  tmp = list;
-
-  while (tmp)
+  for (tmp = list; tmp; tmp = tmp->next)
     {
-      next = tmp->next;
       if (g_type_is_a (column_headers [i], G_TYPE_STRING))
 	g_free ((char *) tmp->data.v_pointer);
       else if (g_type_is_a (column_headers [i], G_TYPE_OBJECT) && tmp->data.v_pointer != NULL)
@@ -55,10 +61,10 @@ _gtk_tree_data_list_free (GtkTreeDataList *list,
       else if (g_type_is_a (column_headers [i], G_TYPE_VARIANT) && tmp->data.v_pointer != NULL)
 	g_variant_unref ((gpointer) tmp->data.v_pointer);
 
-      g_slice_free (GtkTreeDataList, tmp);
       i++;
-      tmp = next;
     }
+
+  g_free (list);
 }
 
 gboolean
@@ -258,17 +264,11 @@ _gtk_tree_data_list_value_to_node (GtkTreeDataList *list,
     }
 }
 
-GtkTreeDataList *
-_gtk_tree_data_list_node_copy (GtkTreeDataList *list,
-                               GType            type)
+static void
+node_copy (GtkTreeDataList *list,
+           GtkTreeDataList *new_list,
+           GType            type)
 {
-  GtkTreeDataList *new_list;
-
-  g_return_val_if_fail (list != NULL, NULL);
-  
-  new_list = _gtk_tree_data_list_alloc ();
-  new_list->next = NULL;
-
   switch (get_fundamental_type (type))
     {
     case G_TYPE_BOOLEAN:
@@ -312,6 +312,22 @@ _gtk_tree_data_list_node_copy (GtkTreeDataList *list,
       g_warning ("Unsupported node type (%s) copied.", g_type_name (type));
       break;
     }
+}
+
+GtkTreeDataList *
+_gtk_tree_data_list_copy (GtkTreeDataList *list,
+                          int              n_columns,
+                          GType           *column_headers)
+{
+  GtkTreeDataList *new_list, *tmp;
+  int i;
+
+  g_return_val_if_fail (list != NULL, NULL);
+
+  new_list = _gtk_tree_data_list_alloc (n_columns);
+
+  for (i = 0, tmp = new_list; i < n_columns && list; i++, list = list->next, tmp = tmp->next)
+    node_copy (list, tmp, column_headers[i]);
 
   return new_list;
 }
@@ -49,7 +49,7 @@ typedef struct _GtkTreeDataSortHeader
   GDestroyNotify destroy;
 } GtkTreeDataSortHeader;
 
-GtkTreeDataList *_gtk_tree_data_list_alloc          (void);
+GtkTreeDataList *_gtk_tree_data_list_alloc          (int              n_columns);
 void             _gtk_tree_data_list_free           (GtkTreeDataList *list,
 						     GType           *column_headers);
 gboolean         _gtk_tree_data_list_check_type     (GType            type);
@@ -59,8 +59,9 @@ void             _gtk_tree_data_list_node_to_value  (GtkTreeDataList *list,
 void             _gtk_tree_data_list_value_to_node  (GtkTreeDataList *list,
 						     GValue          *value);
 
-GtkTreeDataList *_gtk_tree_data_list_node_copy      (GtkTreeDataList *list,
-                                                     GType            type);
+GtkTreeDataList *_gtk_tree_data_list_copy           (GtkTreeDataList *list,
+                                                     int              n_columns,
+                                                     GType           *column_headers);
 
 /* Header code */
 int                    _gtk_tree_data_list_compare_func (GtkTreeModel *model,
@@ -315,16 +315,17 @@ gtk_tree_list_model_get_nth (GtkTreeListModel *self,
   g_return_val_if_reached (NULL);
 }
 
+/* @position is the local position of @node in its parent */
 static GListModel *
-tree_node_create_model (GtkTreeListModel *self,
-                        TreeNode         *node)
+tree_node_create_model_at (GtkTreeListModel *self,
+                           TreeNode         *node,
+                           guint             position)
 {
   TreeNode *parent = node->parent;
   GListModel *model;
   GObject *item;
 
-  item = g_list_model_get_item (parent->model,
-                                tree_node_get_local_position (parent->children, node));
+  item = g_list_model_get_item (parent->model, position);
   model = self->create_func (item, self->user_data);
   g_object_unref (item);
   if (model == NULL)
@@ -333,6 +334,15 @@ tree_node_create_model (GtkTreeListModel *self,
   return model;
 }
 
+static GListModel *
+tree_node_create_model (GtkTreeListModel *self,
+                        TreeNode         *node)
+{
+  return tree_node_create_model_at (self,
+                                    node,
+                                    tree_node_get_local_position (node->parent->children, node));
+}
+
 static gpointer
 tree_node_get_item (TreeNode *node)
 {
@@ -360,8 +370,9 @@ tree_node_get_row (TreeNode *node)
 }
 
 static guint
-gtk_tree_list_model_expand_node (GtkTreeListModel *self,
-                                 TreeNode         *node);
+gtk_tree_list_model_expand_node_at (GtkTreeListModel *self,
+                                    TreeNode         *node,
+                                    guint             position);
 
 static void
 gtk_tree_list_model_items_changed_cb (GListModel *model,
@@ -425,7 +436,7 @@ gtk_tree_list_model_items_changed_cb (GListModel *model,
     {
       for (i = 0; i < added; i++)
         {
-          tree_added += gtk_tree_list_model_expand_node (self, child);
+          tree_added += gtk_tree_list_model_expand_node_at (self, child, position + i);
           child = gtk_rb_tree_node_get_next (child);
         }
     }
@@ -506,19 +517,23 @@ gtk_tree_list_model_init_node (GtkTreeListModel *list,
                                     NULL);
 
   n = g_list_model_get_n_items (model);
-  node = NULL;
+  node = gtk_rb_tree_populate (self->children, n);
   for (i = 0; i < n; i++)
     {
-      node = gtk_rb_tree_insert_after (self->children, node);
       node->parent = self;
       if (list->autoexpand)
-        gtk_tree_list_model_expand_node (list, node);
+        gtk_tree_list_model_expand_node_at (list, node, i);
+      node = gtk_rb_tree_node_get_next (node);
     }
 }
 
+/* Autoexpanding creates all children in order, so callers that know
+ * the position pass it instead of looking it up for every child.
+ */
 static guint
-gtk_tree_list_model_expand_node (GtkTreeListModel *self,
-                                 TreeNode         *node)
+gtk_tree_list_model_expand_node_at (GtkTreeListModel *self,
+                                    TreeNode         *node,
+                                    guint             position)
 {
   GListModel *model;
 
@@ -528,7 +543,7 @@ gtk_tree_list_model_expand_node (GtkTreeListModel *self,
   if (node->model != NULL)
     return 0;
 
-  model = tree_node_create_model (self, node);
+  model = tree_node_create_model_at (self, node, position);
 
   if (model == NULL)
     return 0;
@@ -540,6 +555,18 @@ gtk_tree_list_model_expand_node (GtkTreeListModel *self,
   return tree_node_get_n_children (node);
 }
 
+static guint
+gtk_tree_list_model_expand_node (GtkTreeListModel *self,
+                                 TreeNode         *node)
+{
+  if (node->empty || node->model != NULL)
+    return 0;
+
+  return gtk_tree_list_model_expand_node_at (self,
+                                             node,
+                                             tree_node_get_local_position (node->parent->children, node));
+}
+
 static guint
 gtk_tree_list_model_collapse_node (GtkTreeListModel *self,
                                    TreeNode         *node)
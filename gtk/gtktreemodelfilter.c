@@ -287,6 +287,11 @@ struct _GtkTreeModelFilterPrivate
 
   guint in_row_deleted       : 1;
   guint virtual_root_deleted : 1;
+  guint incremental          : 1;
+
+  /* incremental refiltering */
+  guint refilter_source;
+  GtkTreeRowReference *refilter_row; /* next child row, NULL to start over */
 
   /* signal ids */
   gulong changed_id;
@@ -301,9 +306,13 @@ enum
 {
   PROP_0,
   PROP_CHILD_MODEL,
-  PROP_VIRTUAL_ROOT
+  PROP_VIRTUAL_ROOT,
+  PROP_INCREMENTAL
 };
 
+/* Number of child rows refiltered per idle when refiltering incrementally */
+#define GTK_TREE_MODEL_FILTER_REFILTER_ROWS 512
+
 /* Set this to 0 to disable caching of child iterators.  This
  * allows for more stringent testing.  It is recommended to set this
  * to one when refactoring this code and running the unit tests to
@@ -337,6 +346,7 @@ static void         gtk_tree_model_filter_get_property                    (GObje
                                                                            guint                    prop_id,
                                                                            GValue                 *value,
                                                                            GParamSpec             *pspec);
+static void         gtk_tree_model_filter_stop_refilter                   (GtkTreeModelFilter     *filter);
 
 /* signal handlers */
 static void         gtk_tree_model_filter_row_changed                     (GtkTreeModel           *c_model,
@@ -541,6 +551,20 @@ gtk_tree_model_filter_class_init (GtkTreeModelFilterClass *filter_class)
                                                        P_("The virtual root (relative to the child model) for this filtermodel"),
                                                        GTK_TYPE_TREE_PATH,
                                                        GTK_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+  /**
+   * GtkTreeModelFilter:incremental:
+   *
+   * If gtk_tree_model_filter_refilter() should refilter the child
+   * model in chunks from idle handlers instead of all at once.
+   */
+  g_object_class_install_property (object_class,
+                                   PROP_INCREMENTAL,
+                                   g_param_spec_boolean ("incremental",
+                                                         P_("Incremental"),
+                                                         P_("Refilter the model incrementally"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY));
 }
 
 static void
@@ -584,6 +608,7 @@ gtk_tree_model_filter_finalize (GObject *object)
       filter->priv->virtual_root_deleted = TRUE;
     }
 
+  gtk_tree_model_filter_stop_refilter (filter);
   gtk_tree_model_filter_set_model (filter, NULL);
 
   if (filter->priv->virtual_root)
@@ -620,6 +645,9 @@ gtk_tree_model_filter_set_property (GObject      *object,
       case PROP_VIRTUAL_ROOT:
         gtk_tree_model_filter_set_root (filter, g_value_get_boxed (value));
         break;
+      case PROP_INCREMENTAL:
+        gtk_tree_model_filter_set_incremental (filter, g_value_get_boolean (value));
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -642,6 +670,9 @@ gtk_tree_model_filter_get_property (GObject    *object,
       case PROP_VIRTUAL_ROOT:
         g_value_set_boxed (value, filter->priv->virtual_root);
         break;
+      case PROP_INCREMENTAL:
+        g_value_set_boolean (value, filter->priv->incremental);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -4230,24 +4261,180 @@ gtk_tree_model_filter_refilter_helper (GtkTreeModel *model,
   return FALSE;
 }
 
+/* Refilters up to @n_rows rows of the child model, in the same order
+ * as gtk_tree_model_foreach(). The position is kept in a row reference,
+ * so it stays valid while the child model changes between steps.
+ * If that row is deleted, we start over, refiltering a row twice is
+ * harmless.
+ *
+ * Returns: %TRUE if there are rows left to refilter
+ */
+static gboolean
+gtk_tree_model_filter_refilter_step (GtkTreeModelFilter *filter,
+                                     guint               n_rows)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter c_iter, c_next;
+  GtkTreePath *c_path = NULL;
+  guint i;
+
+  if (filter->priv->refilter_row)
+    {
+      c_path = gtk_tree_row_reference_get_path (filter->priv->refilter_row);
+      g_clear_pointer (&filter->priv->refilter_row, gtk_tree_row_reference_free);
+    }
+  if (c_path == NULL)
+    c_path = gtk_tree_path_new_first ();
+
+  if (!gtk_tree_model_get_iter (c_model, &c_iter, c_path))
+    {
+      gtk_tree_path_free (c_path);
+      return FALSE;
+    }
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gtk_tree_model_filter_row_changed (c_model, c_path, &c_iter, filter);
+
+      if (gtk_tree_model_iter_children (c_model, &c_next, &c_iter))
+        {
+          gtk_tree_path_down (c_path);
+          c_iter = c_next;
+          continue;
+        }
+
+      while (TRUE)
+        {
+          c_next = c_iter;
+          if (gtk_tree_model_iter_next (c_model, &c_next))
+            {
+              gtk_tree_path_next (c_path);
+              c_iter = c_next;
+              break;
+            }
+
+          if (!gtk_tree_model_iter_parent (c_model, &c_next, &c_iter))
+            {
+              gtk_tree_path_free (c_path);
+              return FALSE;
+            }
+
+          gtk_tree_path_up (c_path);
+          c_iter = c_next;
+        }
+    }
+
+  filter->priv->refilter_row = gtk_tree_row_reference_new (c_model, c_path);
+  gtk_tree_path_free (c_path);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_tree_model_filter_refilter_cb (gpointer data)
+{
+  GtkTreeModelFilter *filter = data;
+
+  if (gtk_tree_model_filter_refilter_step (filter, GTK_TREE_MODEL_FILTER_REFILTER_ROWS))
+    return G_SOURCE_CONTINUE;
+
+  filter->priv->refilter_source = 0;
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_tree_model_filter_stop_refilter (GtkTreeModelFilter *filter)
+{
+  g_clear_handle_id (&filter->priv->refilter_source, g_source_remove);
+  g_clear_pointer (&filter->priv->refilter_row, gtk_tree_row_reference_free);
+}
+
 /**
  * gtk_tree_model_filter_refilter:
  * @filter: A #GtkTreeModelFilter.
  *
  * Emits ::row_changed for each row in the child model, which causes
  * the filter to re-evaluate whether a row is visible or not.
+ *
+ * If #GtkTreeModelFilter:incremental is set, this only starts
+ * refiltering, and the rows are re-evaluated in chunks from idle
+ * handlers. Calling this again while a refilter is ongoing
+ * starts over.
  */
 void
 gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
 {
   g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
 
+  gtk_tree_model_filter_stop_refilter (filter);
+
+  if (filter->priv->incremental)
+    {
+      filter->priv->refilter_source = g_idle_add (gtk_tree_model_filter_refilter_cb, filter);
+      g_source_set_name_by_id (filter->priv->refilter_source, "[gtk] gtk_tree_model_filter_refilter_cb");
+      return;
+    }
+
   /* S L O W */
   gtk_tree_model_foreach (filter->priv->child_model,
                           gtk_tree_model_filter_refilter_helper,
                           filter);
 }
 
+/**
+ * gtk_tree_model_filter_set_incremental:
+ * @filter: A #GtkTreeModelFilter
+ * @incremental: %TRUE to refilter incrementally
+ *
+ * Sets whether gtk_tree_model_filter_refilter() refilters the
+ * child model incrementally.
+ *
+ * Refiltering a large model at once can block the UI for a
+ * noticeable time. When refiltering incrementally, rows are
+ * re-evaluated in chunks from idle handlers, so rows will keep
+ * appearing and disappearing for a while after refiltering starts.
+ *
+ * When incremental refiltering is turned off while a refilter is
+ * ongoing, the rest of the model is refiltered right away.
+ */
+void
+gtk_tree_model_filter_set_incremental (GtkTreeModelFilter *filter,
+                                       gboolean            incremental)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  if (filter->priv->incremental == incremental)
+    return;
+
+  filter->priv->incremental = incremental;
+
+  if (!incremental && filter->priv->refilter_source)
+    {
+      g_clear_handle_id (&filter->priv->refilter_source, g_source_remove);
+      gtk_tree_model_filter_refilter_step (filter, G_MAXUINT);
+    }
+
+  g_object_notify (G_OBJECT (filter), "incremental");
+}
+
+/**
+ * gtk_tree_model_filter_get_incremental:
+ * @filter: A #GtkTreeModelFilter
+ *
+ * Returns whether incremental refiltering is enabled.
+ *
+ * See gtk_tree_model_filter_set_incremental().
+ *
+ * Returns: %TRUE if incremental refiltering is enabled
+ */
+gboolean
+gtk_tree_model_filter_get_incremental (GtkTreeModelFilter *filter)
+{
+  g_return_val_if_fail (GTK_IS_TREE_MODEL_FILTER (filter), FALSE);
+
+  return filter->priv->incremental;
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
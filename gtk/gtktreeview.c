@@ -8593,16 +8593,14 @@ gtk_tree_view_build_tree (GtkTreeView   *tree_view,
   do
     {
       gtk_tree_model_ref_node (priv->model, iter);
-      temp = gtk_tree_rbtree_insert_after (tree, temp, 0, FALSE);
 
+      /* With a known fixed height, insert the nodes valid right away
+       * instead of fixing up the tree three times per row.
+       */
       if (priv->fixed_height > 0)
-        {
-          if (GTK_TREE_RBNODE_FLAG_SET (temp, GTK_TREE_RBNODE_INVALID))
-	    {
-              gtk_tree_rbtree_node_set_height (tree, temp, priv->fixed_height);
-	      gtk_tree_rbtree_node_mark_valid (tree, temp);
-	    }
-        }
+        temp = gtk_tree_rbtree_insert_after (tree, temp, priv->fixed_height, TRUE);
+      else
+        temp = gtk_tree_rbtree_insert_after (tree, temp, 0, FALSE);
 
       if (priv->is_list)
         continue;
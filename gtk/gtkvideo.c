@@ -57,6 +57,7 @@ struct _GtkVideo
   GtkWidget *controls_revealer;
   GtkWidget *controls;
   guint controls_hide_source;
+  guint tick_id;
 
   guint autoplay : 1;
   guint loop : 1;
@@ -513,6 +514,28 @@ gtk_video_update_error (GtkVideo *self)
   gtk_video_update_overlay_icon (self);
 }
 
+static gboolean
+gtk_video_tick (GtkWidget     *widget,
+                GdkFrameClock *frame_clock,
+                gpointer       unused)
+{
+  GtkVideo *self = GTK_VIDEO (widget);
+  gint64 frame_time, refresh_interval, presentation_time;
+
+  /* Pick the frame for when this frame will be seen, not for now */
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  gdk_frame_clock_get_refresh_info (frame_clock,
+                                    frame_time,
+                                    &refresh_interval,
+                                    &presentation_time);
+  if (presentation_time == 0)
+    presentation_time = frame_time + refresh_interval;
+
+  gtk_media_stream_select_frame (self->media_stream, presentation_time);
+
+  return G_SOURCE_CONTINUE;
+}
+
 static void
 gtk_video_update_playing (GtkVideo *self)
 {
@@ -524,6 +547,16 @@ gtk_video_update_playing (GtkVideo *self)
     playing = FALSE;
 
   gtk_widget_set_visible (self->overlay_icon, !playing);
+
+  if (playing && self->tick_id == 0)
+    {
+      self->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), gtk_video_tick, NULL, NULL);
+    }
+  else if (!playing && self->tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->tick_id);
+      self->tick_id = 0;
+    }
 }
 
 static void
@@ -24,18 +24,22 @@
 
 #include "config.h"
 
-#include "gtkviewport.h"
+#include "gtkviewportprivate.h"
 
 #include "gtkadjustmentprivate.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
+#include "gtknative.h"
 #include "gtkprivate.h"
 #include "gtkscrollable.h"
+#include "gtksnapshot.h"
 #include "gtktypebuiltins.h"
 #include "gtkwidgetprivate.h"
 #include "gtkbuildable.h"
 #include "gtktext.h"
 
+#include <math.h>
+
 
 /**
  * SECTION:gtkviewport
@@ -73,8 +77,16 @@ struct _GtkViewport
   guint hscroll_policy : 1;
   guint vscroll_policy : 1;
   guint scroll_to_focus : 1;
+  guint cache_content : 1;
 
   gulong focus_handler;
+
+  /* Tiles of the child's render node, kept while scrolling
+   * with gtk_viewport_set_cache_content()
+   */
+  GskRenderNode *cached_content;
+  int cached_scale;
+  GHashTable *tiles;
 };
 
 struct _GtkViewportClass
@@ -102,6 +114,9 @@ static void gtk_viewport_get_property             (GObject         *object,
                                                    GValue          *value,
                                                    GParamSpec      *pspec);
 static void gtk_viewport_dispose                  (GObject         *object);
+static void gtk_viewport_finalize                 (GObject         *object);
+static void gtk_viewport_snapshot                 (GtkWidget       *widget,
+                                                   GtkSnapshot     *snapshot);
 static void gtk_viewport_size_allocate            (GtkWidget       *widget,
                                                    int              width,
                                                    int              height,
@@ -115,6 +130,7 @@ static void viewport_set_adjustment               (GtkViewport      *viewport,
 
 static void setup_focus_change_handler (GtkViewport *viewport);
 static void clear_focus_change_handler (GtkViewport *viewport);
+static void gtk_viewport_clear_tiles   (GtkViewport *viewport);
 
 static void gtk_viewport_buildable_init (GtkBuildableIface *iface);
 
@@ -312,10 +328,22 @@ gtk_viewport_dispose (GObject *object)
 
   g_clear_pointer (&viewport->child, gtk_widget_unparent);
 
+  gtk_viewport_clear_tiles (viewport);
+
   G_OBJECT_CLASS (gtk_viewport_parent_class)->dispose (object);
 
 }
 
+static void
+gtk_viewport_finalize (GObject *object)
+{
+  GtkViewport *viewport = GTK_VIEWPORT (object);
+
+  g_hash_table_unref (viewport->tiles);
+
+  G_OBJECT_CLASS (gtk_viewport_parent_class)->finalize (object);
+}
+
 static void
 gtk_viewport_root (GtkWidget *widget)
 {
@@ -335,9 +363,183 @@ gtk_viewport_unroot (GtkWidget *widget)
   if (viewport->scroll_to_focus)
     clear_focus_change_handler (viewport);
 
+  /* The tiles belong to the renderer of our current native */
+  gtk_viewport_clear_tiles (viewport);
+
   GTK_WIDGET_CLASS (gtk_viewport_parent_class)->unroot (widget);
 }
 
+/* Size of the tiles the child is rendered into while caching */
+#define TILE_SIZE 256
+
+#define TILE_KEY(x, y) GUINT_TO_POINTER ((((guint) (x) & 0xffff) << 16) | ((guint) (y) & 0xffff))
+#define TILE_KEY_X(key) ((gint16) (GPOINTER_TO_UINT (key) >> 16))
+#define TILE_KEY_Y(key) ((gint16) (GPOINTER_TO_UINT (key) & 0xffff))
+
+static void
+gtk_viewport_clear_tiles (GtkViewport *viewport)
+{
+  g_hash_table_remove_all (viewport->tiles);
+  g_clear_pointer (&viewport->cached_content, gsk_render_node_unref);
+}
+
+static GdkTexture *
+gtk_viewport_render_tile (GskRenderer   *renderer,
+                          GskRenderNode *content,
+                          int            x,
+                          int            y,
+                          int            scale)
+{
+  GskTransform *transform;
+  GskRenderNode *node;
+  GdkTexture *texture;
+
+  transform = gsk_transform_scale (NULL, scale, scale);
+  node = gsk_transform_node_new (content, transform);
+  texture = gsk_renderer_render_texture (renderer, node,
+                                         &GRAPHENE_RECT_INIT (x * TILE_SIZE * scale,
+                                                              y * TILE_SIZE * scale,
+                                                              TILE_SIZE * scale,
+                                                              TILE_SIZE * scale));
+  gsk_render_node_unref (node);
+  gsk_transform_unref (transform);
+
+  return texture;
+}
+
+/* Draws @node, the child's node including its scroll offset, from
+ * textures of the child's content. Tiles are rendered the first time
+ * they are exposed and kept as long as the content node stays the
+ * same and they are within a page of the visible area.
+ */
+static gboolean
+gtk_viewport_snapshot_tiles (GtkViewport   *viewport,
+                             GskRenderNode *node,
+                             GtkSnapshot   *snapshot)
+{
+  GtkWidget *widget = GTK_WIDGET (viewport);
+  GskRenderNode *content;
+  GskRenderer *renderer;
+  GtkNative *native;
+  GHashTableIter iter;
+  gpointer key;
+  graphene_rect_t visible, area;
+  float dx, dy;
+  int width, height, scale;
+  int x0, y0, x1, y1, x, y;
+
+  if (gsk_render_node_get_node_type (node) == GSK_TRANSFORM_NODE)
+    {
+      GskTransform *transform = gsk_transform_node_get_transform (node);
+
+      if (gsk_transform_get_category (transform) < GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+        return FALSE;
+
+      gsk_transform_to_translate (transform, &dx, &dy);
+      content = gsk_transform_node_get_child (node);
+    }
+  else
+    {
+      dx = dy = 0;
+      content = node;
+    }
+
+  native = gtk_widget_get_native (widget);
+  renderer = native ? gtk_native_get_renderer (native) : NULL;
+  if (renderer == NULL)
+    return FALSE;
+
+  scale = gtk_widget_get_scale_factor (widget);
+  if (content != viewport->cached_content || scale != viewport->cached_scale)
+    {
+      gtk_viewport_clear_tiles (viewport);
+      viewport->cached_content = gsk_render_node_ref (content);
+      viewport->cached_scale = scale;
+    }
+
+  width = gtk_widget_get_width (widget);
+  height = gtk_widget_get_height (widget);
+  graphene_rect_init (&visible, -dx, -dy, width, height);
+  graphene_rect_inset_r (&visible, - width, - height, &area);
+
+  /* Drop the tiles that scrolled too far away */
+  x0 = floor (area.origin.x / TILE_SIZE);
+  y0 = floor (area.origin.y / TILE_SIZE);
+  x1 = ceil ((area.origin.x + area.size.width) / TILE_SIZE);
+  y1 = ceil ((area.origin.y + area.size.height) / TILE_SIZE);
+
+  g_hash_table_iter_init (&iter, viewport->tiles);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      if (TILE_KEY_X (key) < x0 || TILE_KEY_X (key) >= x1 ||
+          TILE_KEY_Y (key) < y0 || TILE_KEY_Y (key) >= y1)
+        g_hash_table_iter_remove (&iter);
+    }
+
+  if (!graphene_rect_intersection (&visible, &content->bounds, &visible))
+    return TRUE;
+
+  x0 = floor (visible.origin.x / TILE_SIZE);
+  y0 = floor (visible.origin.y / TILE_SIZE);
+  x1 = ceil ((visible.origin.x + visible.size.width) / TILE_SIZE);
+  y1 = ceil ((visible.origin.y + visible.size.height) / TILE_SIZE);
+
+  gtk_snapshot_save (snapshot);
+  gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (dx, dy));
+
+  for (y = y0; y < y1; y++)
+    for (x = x0; x < x1; x++)
+      {
+        GdkTexture *texture;
+
+        texture = g_hash_table_lookup (viewport->tiles, TILE_KEY (x, y));
+        if (texture == NULL)
+          {
+            texture = gtk_viewport_render_tile (renderer, content, x, y, scale);
+            g_hash_table_insert (viewport->tiles, TILE_KEY (x, y), texture);
+          }
+
+        gtk_snapshot_append_texture (snapshot, texture,
+                                     &GRAPHENE_RECT_INIT (x * TILE_SIZE, y * TILE_SIZE,
+                                                          TILE_SIZE, TILE_SIZE));
+      }
+
+  gtk_snapshot_restore (snapshot);
+
+  return TRUE;
+}
+
+static void
+gtk_viewport_snapshot (GtkWidget   *widget,
+                       GtkSnapshot *snapshot)
+{
+  GtkViewport *viewport = GTK_VIEWPORT (widget);
+  GtkSnapshot *child_snapshot;
+  GskRenderNode *node;
+
+  /* Rendering tiles needs the renderer, so snapshots on
+   * worker threads take the regular path.
+   */
+  if (!viewport->cache_content ||
+      viewport->child == NULL ||
+      !g_main_context_is_owner (g_main_context_default ()))
+    {
+      GTK_WIDGET_CLASS (gtk_viewport_parent_class)->snapshot (widget, snapshot);
+      return;
+    }
+
+  child_snapshot = gtk_snapshot_new ();
+  gtk_widget_snapshot_child (widget, viewport->child, child_snapshot);
+  node = gtk_snapshot_free_to_node (child_snapshot);
+  if (node == NULL)
+    return;
+
+  if (!gtk_viewport_snapshot_tiles (viewport, node, snapshot))
+    gtk_snapshot_append_node (snapshot, node);
+
+  gsk_render_node_unref (node);
+}
+
 static void
 gtk_viewport_class_init (GtkViewportClass *class)
 {
@@ -348,11 +550,13 @@ gtk_viewport_class_init (GtkViewportClass *class)
   widget_class = (GtkWidgetClass*) class;
 
   gobject_class->dispose = gtk_viewport_dispose;
+  gobject_class->finalize = gtk_viewport_finalize;
   gobject_class->set_property = gtk_viewport_set_property;
   gobject_class->get_property = gtk_viewport_get_property;
 
   widget_class->size_allocate = gtk_viewport_size_allocate;
   widget_class->measure = gtk_viewport_measure;
+  widget_class->snapshot = gtk_viewport_snapshot;
   widget_class->root = gtk_viewport_root;
   widget_class->unroot = gtk_viewport_unroot;
   widget_class->compute_expand = gtk_viewport_compute_expand;
@@ -382,6 +586,7 @@ gtk_viewport_class_init (GtkViewportClass *class)
                                                         GTK_PARAM_READWRITE));
 
   gtk_widget_class_set_css_name (widget_class, I_("viewport"));
+  gtk_widget_class_set_snapshot_thread_safe (widget_class, TRUE);
 }
 
 static void
@@ -470,6 +675,9 @@ gtk_viewport_init (GtkViewport *viewport)
   widget = GTK_WIDGET (viewport);
 
   gtk_widget_set_overflow (widget, GTK_OVERFLOW_HIDDEN);
+  gtk_widget_set_render_boundary (widget, TRUE);
+
+  viewport->tiles = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
 
   viewport->hadjustment = NULL;
   viewport->vadjustment = NULL;
@@ -731,3 +939,33 @@ gtk_viewport_get_child (GtkViewport *viewport)
   return viewport->child;
 }
 
+/*< private >
+ * gtk_viewport_set_cache_content:
+ * @viewport: a #GtkViewport
+ * @cache_content: whether to draw the child from cached tiles
+ *
+ * While @cache_content is set, @viewport renders its child into
+ * textures and scrolls by moving those, only rendering again for
+ * newly exposed areas or when the child's content changes.
+ *
+ * This is meant for short periods with a scroll offset change in
+ * every frame, like kinetic scrolling.
+ */
+void
+gtk_viewport_set_cache_content (GtkViewport *viewport,
+                                gboolean     cache_content)
+{
+  g_return_if_fail (GTK_IS_VIEWPORT (viewport));
+
+  cache_content = !!cache_content;
+
+  if (viewport->cache_content == cache_content)
+    return;
+
+  viewport->cache_content = cache_content;
+
+  if (!cache_content)
+    gtk_viewport_clear_tiles (viewport);
+
+  gtk_widget_queue_draw (GTK_WIDGET (viewport));
+}
@@ -0,0 +1,29 @@
+/* GTK - The GIMP Toolkit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_VIEWPORT_PRIVATE_H__
+#define __GTK_VIEWPORT_PRIVATE_H__
+
+#include "gtkviewport.h"
+
+G_BEGIN_DECLS
+
+void gtk_viewport_set_cache_content (GtkViewport *viewport,
+                                     gboolean     cache_content);
+
+G_END_DECLS
+
+#endif /* __GTK_VIEWPORT_PRIVATE_H__ */
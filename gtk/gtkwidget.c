@@ -30,17 +30,21 @@
 #include "gtkaccessibleprivate.h"
 #include "gtkactionobserverprivate.h"
 #include "gtkapplicationprivate.h"
+#include "gtkbinlayout.h"
 #include "gtkbuildable.h"
 #include "gtkbuilderprivate.h"
 #include "gtkconstraint.h"
+#include "gtkcssarrayvalueprivate.h"
 #include "gtkcssboxesprivate.h"
 #include "gtkcssfiltervalueprivate.h"
+#include "gtkcssimagevalueprivate.h"
 #include "gtkcsstransformvalueprivate.h"
 #include "gtkcssfontvariationsvalueprivate.h"
 #include "gtkcssnumbervalueprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkcsswidgetnodeprivate.h"
 #include "gtkdebug.h"
+#include "gskpango.h"
 #include "gtkgesturedrag.h"
 #include "gtkgestureprivate.h"
 #include "gtkgesturesingle.h"
@@ -77,6 +81,7 @@
 #include "inspector/window.h"
 
 #include "gdk/gdkeventsprivate.h"
+#include "gdk/gdkparallelprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 #include "gsk/gskdebugprivate.h"
 #include "gsk/gskrendererprivate.h"
@@ -669,10 +674,24 @@ static GQuark		quark_pango_context = 0;
 static GQuark		quark_mnemonic_labels = 0;
 static GQuark           quark_size_groups = 0;
 static GQuark           quark_auto_children = 0;
+static GQuark           quark_lazy_template_children = 0;
 static GQuark           quark_action_muxer = 0;
 static GQuark           quark_font_options = 0;
 static GQuark           quark_font_map = 0;
 
+static int              allocated_widgets;
+static int              snapshotted_widgets;
+static int              reused_render_nodes;
+static int              spliced_render_nodes;
+static int              threaded_snapshots;
+static int              skipped_allocations;
+static guint            allocated_widgets_counter;
+static guint            snapshotted_widgets_counter;
+static guint            reused_render_nodes_counter;
+static guint            spliced_render_nodes_counter;
+static guint            threaded_snapshots_counter;
+static guint            skipped_allocations_counter;
+
 /* --- functions --- */
 GType
 gtk_widget_get_type (void)
@@ -770,6 +789,12 @@ gtk_widget_base_class_init (gpointer g_class)
     }
 
   priv->accessible_role = GTK_ACCESSIBLE_ROLE_WIDGET;
+
+  /* Subclasses can override snapshot() and measure(), so they need
+   * to opt in again
+   */
+  priv->snapshot_thread_safe = FALSE;
+  priv->measure_equal = NULL;
 }
 
 static void
@@ -881,6 +906,7 @@ gtk_widget_class_init (GtkWidgetClass *klass)
   quark_mnemonic_labels = g_quark_from_static_string ("gtk-mnemonic-labels");
   quark_size_groups = g_quark_from_static_string ("gtk-widget-size-groups");
   quark_auto_children = g_quark_from_static_string ("gtk-widget-auto-children");
+  quark_lazy_template_children = g_quark_from_static_string ("gtk-widget-lazy-template-children");
   quark_action_muxer = g_quark_from_static_string ("gtk-widget-action-muxer");
   quark_font_options = g_quark_from_static_string ("gtk-widget-font-options");
   quark_font_map = g_quark_from_static_string ("gtk-widget-font-map");
@@ -1621,6 +1647,16 @@ gtk_widget_class_init (GtkWidgetClass *klass)
                               _gtk_marshal_BOOLEAN__INT_INT_BOOLEAN_OBJECTv);
 
   gtk_widget_class_set_css_name (klass, I_("widget"));
+
+  if (allocated_widgets_counter == 0)
+    {
+      allocated_widgets_counter = gdk_profiler_define_int_counter ("allocated-widgets", "Widget Allocations");
+      snapshotted_widgets_counter = gdk_profiler_define_int_counter ("snapshotted-widgets", "Widget Snapshots");
+      reused_render_nodes_counter = gdk_profiler_define_int_counter ("reused-render-nodes", "Widget Render Nodes Reused");
+      spliced_render_nodes_counter = gdk_profiler_define_int_counter ("spliced-render-nodes", "Widget Render Nodes Spliced");
+      threaded_snapshots_counter = gdk_profiler_define_int_counter ("threaded-snapshots", "Widget Subtrees Snapshotted in Threads");
+      skipped_allocations_counter = gdk_profiler_define_int_counter ("skipped-allocations", "Widget Allocations Skipped");
+    }
 }
 
 static void
@@ -3373,6 +3409,8 @@ gtk_widget_get_surface_allocation (GtkWidget     *widget,
 void
 gtk_widget_queue_draw (GtkWidget *widget)
 {
+  gboolean splice = FALSE;
+
   g_return_if_fail (GTK_IS_WIDGET (widget));
 
   /* Just return if the widget isn't mapped */
@@ -3386,15 +3424,66 @@ gtk_widget_queue_draw (GtkWidget *widget)
       if (priv->draw_needed)
         break;
 
-      priv->draw_needed = TRUE;
-      g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+      if (splice)
+        {
+          /* Above a render boundary, the contents of the widgets stay
+           * the same, only the node of the boundary needs replacing
+           */
+          if (priv->child_draw_needed)
+            break;
+
+          priv->child_draw_needed = TRUE;
+        }
+      else
+        {
+          priv->draw_needed = TRUE;
+
+          /* Render boundaries keep their old node around, so that
+           * their parent can find it when splicing in the new one
+           */
+          if (!priv->render_boundary)
+            g_clear_pointer (&priv->render_node, gsk_render_node_unref);
+        }
+
       if (GTK_IS_NATIVE (widget) && _gtk_widget_get_realized (widget))
         gdk_surface_queue_render (gtk_native_get_surface (GTK_NATIVE (widget)));
+
+      if (priv->render_boundary)
+        splice = TRUE;
     }
 }
 
+/*< private >
+ * gtk_widget_set_render_boundary:
+ * @widget: a #GtkWidget
+ * @render_boundary: whether @widget is a render boundary
+ *
+ * Marks @widget as a render boundary.
+ *
+ * When a render boundary, or any of its descendants, is redrawn, its
+ * ancestors do not get snapshotted again. Instead, the new render node
+ * of the boundary is spliced into their retained render nodes.
+ *
+ * This is meant for widgets that get redrawn often and independently
+ * of their surroundings, like list rows or the contents of a scrolled
+ * window. Their parent must draw them with gtk_widget_snapshot_child()
+ * and must not change its own rendering depending on their contents.
+ */
+void
+gtk_widget_set_render_boundary (GtkWidget *widget,
+                                gboolean   render_boundary)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  priv->render_boundary = render_boundary;
+}
+
 static void
 gtk_widget_set_alloc_needed (GtkWidget *widget);
+static void
+gtk_widget_clear_old_requests (GtkWidget *widget);
+static gboolean
+gtk_widget_children_request_changed (GtkWidget *widget);
 /**
  * gtk_widget_queue_allocate:
  * @widget: a #GtkWidget
@@ -3416,6 +3505,7 @@ gtk_widget_queue_allocate (GtkWidget *widget)
   if (_gtk_widget_get_realized (widget))
     gtk_widget_queue_draw (widget);
 
+  widget->priv->resize_from_child = FALSE;
   gtk_widget_set_alloc_needed (widget);
 }
 
@@ -3430,18 +3520,26 @@ gtk_widget_get_resize_needed (GtkWidget *widget)
 /*
  * gtk_widget_queue_resize_internal:
  * @widget: a #GtkWidget
+ * @from_child: %TRUE if the resize is only propagated from a child
  * 
  * Queue a resize on a widget, and on all other widgets grouped with this widget.
  */
 static void
-gtk_widget_queue_resize_internal (GtkWidget *widget)
+gtk_widget_queue_resize_internal (GtkWidget *widget,
+                                  gboolean   from_child)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
   GSList *groups, *l, *widgets;
 
+  if (!from_child)
+    priv->resize_from_child = FALSE;
+
   if (gtk_widget_get_resize_needed (widget))
     return;
 
+  if (from_child && !priv->alloc_needed)
+    priv->resize_from_child = TRUE;
+
   priv->resize_needed = TRUE;
   gtk_widget_set_alloc_needed (widget);
 
@@ -3454,7 +3552,7 @@ gtk_widget_queue_resize_internal (GtkWidget *widget)
   {
     for (widgets = gtk_size_group_get_widgets (l->data); widgets; widgets = widgets->next)
       {
-        gtk_widget_queue_resize_internal (widgets->data);
+        gtk_widget_queue_resize_internal (widgets->data, FALSE);
       }
   }
 
@@ -3466,7 +3564,7 @@ gtk_widget_queue_resize_internal (GtkWidget *widget)
           if (GTK_IS_NATIVE (widget))
             gtk_widget_queue_allocate (parent);
           else
-            gtk_widget_queue_resize_internal (parent);
+            gtk_widget_queue_resize_internal (parent, TRUE);
         }
     }
 }
@@ -3494,7 +3592,7 @@ gtk_widget_queue_resize (GtkWidget *widget)
   if (_gtk_widget_get_realized (widget))
     gtk_widget_queue_draw (widget);
 
-  gtk_widget_queue_resize_internal (widget);
+  gtk_widget_queue_resize_internal (widget, FALSE);
 }
 
 /**
@@ -3884,10 +3982,24 @@ gtk_widget_allocate (GtkWidget    *widget,
   if (!alloc_needed && !size_changed && !baseline_changed)
     goto skip_allocate;
 
+  /* If we only got here because children were resized and none of
+   * them changed their size request, our size_allocate() would hand
+   * out the same allocations again. Just let the resized children
+   * reallocate themselves.
+   */
+  if (priv->resize_from_child && !size_changed && !baseline_changed &&
+      !gtk_widget_children_request_changed (widget))
+    {
+      skipped_allocations++;
+      goto skip_allocate;
+    }
+
   priv->width = adjusted.width;
   priv->height = adjusted.height;
   priv->baseline = baseline;
 
+  allocated_widgets++;
+
   if (priv->layout_manager != NULL)
     {
       gtk_layout_manager_allocate (priv->layout_manager, widget,
@@ -3923,9 +4035,16 @@ gtk_widget_allocate (GtkWidget    *widget,
     gtk_accessible_bounds_changed (GTK_ACCESSIBLE (widget));
 
 skip_allocate:
+  priv->resize_from_child = FALSE;
+  gtk_widget_clear_old_requests (widget);
+
   if (size_changed || baseline_changed)
     gtk_widget_queue_draw (widget);
-  else if (transform_changed && priv->parent)
+
+  /* The transform is part of the parent's node, so it needs to be
+   * redrawn even if our own redraw only makes it splice in our node
+   */
+  if (transform_changed && priv->parent)
     gtk_widget_queue_draw (priv->parent);
 
 out:
@@ -7106,6 +7225,9 @@ gtk_widget_real_destroy (GtkWidget *object)
 {
   GtkWidget *widget = GTK_WIDGET (object);
 
+  /* Template children that were never needed are not built now */
+  g_object_set_qdata (G_OBJECT (widget), quark_lazy_template_children, NULL);
+
   if (g_object_get_qdata (G_OBJECT (widget), quark_auto_children))
     {
       GtkWidgetClass *class;
@@ -7143,7 +7265,9 @@ gtk_widget_real_destroy (GtkWidget *object)
                                                                          class_type,
                                                                          child_class->name);
 
-                  g_assert (child_object);
+                  /* Lazy children may not have been built */
+                  if (child_object == NULL)
+                    continue;
 
                   if (!G_IS_OBJECT (child_object))
                     {
@@ -7235,6 +7359,9 @@ gtk_widget_finalize (GObject *object)
 
   g_clear_pointer (&priv->transform, gsk_transform_unref);
   g_clear_pointer (&priv->allocated_transform, gsk_transform_unref);
+  g_clear_pointer (&priv->box_node, gsk_render_node_unref);
+  g_clear_pointer (&priv->previous_render_node, gsk_render_node_unref);
+  g_clear_object (&priv->box_node_style);
 
   gtk_css_widget_node_widget_destroyed (GTK_CSS_WIDGET_NODE (priv->cssnode));
   g_object_unref (priv->cssnode);
@@ -7242,6 +7369,7 @@ gtk_widget_finalize (GObject *object)
   g_clear_object (&priv->context);
 
   _gtk_size_request_cache_free (&priv->requests);
+  gtk_widget_clear_old_requests (widget);
 
   l = priv->event_controllers;
   while (l)
@@ -7337,6 +7465,9 @@ gtk_widget_real_unmap (GtkWidget *widget)
 
       gtk_widget_update_paintables (widget);
 
+      g_clear_pointer (&priv->box_node, gsk_render_node_unref);
+      g_clear_object (&priv->box_node_style);
+
       gtk_widget_unset_state_flags (widget,
                                     GTK_STATE_FLAG_PRELIGHT |
                                     GTK_STATE_FLAG_ACTIVE);
@@ -7770,7 +7901,15 @@ gtk_widget_queue_compute_expand (GtkWidget *widget)
    * a relayout as well
    */
   if (changed_anything)
-    gtk_widget_queue_resize (widget);
+    {
+      gtk_widget_queue_resize (widget);
+
+      /* The expand flags change how the parents distribute space,
+       * even if no size request changes.
+       */
+      for (parent = widget->priv->parent; parent != NULL; parent = parent->priv->parent)
+        parent->priv->resize_from_child = FALSE;
+    }
 }
 
 /**
@@ -10270,7 +10409,101 @@ gtk_widget_ensure_resize (GtkWidget *widget)
     return;
 
   priv->resize_needed = FALSE;
-  _gtk_size_request_cache_clear (&priv->requests);
+
+  /* Keep the sizes the current allocation was based on around,
+   * so we can tell whether the new ones are any different.
+   */
+  if (priv->old_requests == NULL)
+    {
+      priv->old_requests = g_slice_dup (SizeRequestCache, &priv->requests);
+      _gtk_size_request_cache_init (&priv->requests);
+      priv->requests.flags[GTK_ORIENTATION_HORIZONTAL].n_allocated = priv->old_requests->flags[GTK_ORIENTATION_HORIZONTAL].n_allocated;
+      priv->requests.flags[GTK_ORIENTATION_VERTICAL].n_allocated = priv->old_requests->flags[GTK_ORIENTATION_VERTICAL].n_allocated;
+    }
+  else
+    _gtk_size_request_cache_clear (&priv->requests);
+
+  priv->request_unchanged = FALSE;
+  priv->request_changed = FALSE;
+}
+
+static void
+gtk_widget_clear_old_requests (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (priv->old_requests == NULL)
+    return;
+
+  _gtk_size_request_cache_free (priv->old_requests);
+  g_slice_free (SizeRequestCache, priv->old_requests);
+  priv->old_requests = NULL;
+}
+
+/* Called for every size newly measured for @widget. Compares
+ * it with the size measured before the last resize, if any.
+ */
+void
+gtk_widget_check_request_changed (GtkWidget      *widget,
+                                  GtkOrientation  orientation,
+                                  int             for_size,
+                                  int             minimum,
+                                  int             natural,
+                                  int             minimum_baseline,
+                                  int             natural_baseline)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  int old_minimum, old_natural;
+  int old_minimum_baseline = -1;
+  int old_natural_baseline = -1;
+
+  if (priv->old_requests == NULL || priv->request_changed)
+    return;
+
+  if (_gtk_size_request_cache_lookup (priv->old_requests,
+                                      orientation,
+                                      for_size,
+                                      &old_minimum,
+                                      &old_natural,
+                                      &old_minimum_baseline,
+                                      &old_natural_baseline) &&
+      old_minimum == minimum &&
+      old_natural == natural &&
+      old_minimum_baseline == minimum_baseline &&
+      old_natural_baseline == natural_baseline)
+    {
+      priv->request_unchanged = TRUE;
+    }
+  else
+    {
+      priv->request_unchanged = FALSE;
+      priv->request_changed = TRUE;
+    }
+}
+
+/* Whether any child of @widget was resized since the last allocation
+ * without verifiably keeping its size request. Children that were not
+ * measured again since their resize count as changed.
+ */
+static gboolean
+gtk_widget_children_request_changed (GtkWidget *widget)
+{
+  GtkWidget *child;
+
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      GtkWidgetPrivate *priv = child->priv;
+
+      if (priv->resize_needed)
+        return TRUE;
+
+      if (priv->old_requests != NULL && !priv->request_unchanged)
+        return TRUE;
+    }
+
+  return FALSE;
 }
 
 void
@@ -10392,6 +10625,42 @@ gtk_system_setting_changed (GdkDisplay       *display,
   g_list_free (toplevels);
 }
 
+static void
+gtk_widget_font_options_changed (GtkWidget *widget)
+{
+  GtkWidget *child;
+
+  gtk_widget_update_pango_context (widget);
+  gtk_widget_queue_draw (widget);
+
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    gtk_widget_font_options_changed (child);
+}
+
+/* Unlike gtk_system_setting_changed() with GTK_SYSTEM_SETTING_FONT_CONFIG,
+ * this only updates how text is rendered. Font metrics are not hinted,
+ * so nothing needs to be measured again.
+ */
+void
+gtk_font_options_changed (GdkDisplay *display)
+{
+  GList *list, *toplevels;
+
+  toplevels = gtk_window_list_toplevels ();
+  g_list_foreach (toplevels, (GFunc) g_object_ref, NULL);
+
+  for (list = toplevels; list; list = list->next)
+    {
+      if (gtk_widget_get_display (list->data) == display)
+        gtk_widget_font_options_changed (list->data);
+      g_object_unref (list->data);
+    }
+
+  g_list_free (toplevels);
+}
+
 GtkCssNode *
 gtk_widget_get_css_node (GtkWidget *widget)
 {
@@ -10573,6 +10842,7 @@ template_data_free (GtkWidgetTemplate *template_data)
   if (template_data)
     {
       g_bytes_unref (template_data->data);
+      g_clear_pointer (&template_data->precompiled, _gtk_builder_precompiled_free);
       g_slist_free_full (template_data->children, (GDestroyNotify)template_child_class_free);
 
       g_object_unref (template_data->scope);
@@ -10659,6 +10929,88 @@ setup_template_child (GtkWidgetTemplate   *template_data,
   return TRUE;
 }
 
+static void
+expose_template_objects (GtkBuilder *builder,
+                         GtkWidget  *widget)
+{
+  GtkWidget *child;
+
+  for (child = _gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      const char *id = gtk_buildable_get_buildable_id (GTK_BUILDABLE (child));
+
+      /* Composite children may reuse ids internally, the first one wins */
+      if (id && !gtk_builder_get_object (builder, id))
+        gtk_builder_expose_object (builder, id, G_OBJECT (child));
+
+      expose_template_objects (builder, child);
+    }
+}
+
+/* Builds a template child that was marked as lazy, with a new builder
+ * that knows the template widgets by their ids
+ */
+static GObject *
+create_lazy_template_child (GtkWidget  *widget,
+                            GType       widget_type,
+                            const char *name)
+{
+  GtkWidgetTemplate *template;
+  AutomaticChildClass *child_class = NULL;
+  GtkBuilderLazyObject *lazy;
+  GHashTable *lazy_children, *lazy_objects;
+  GtkBuilder *builder;
+  GObject *object;
+  gpointer key;
+  GSList *l;
+
+  lazy_children = g_object_get_qdata (G_OBJECT (widget), quark_lazy_template_children);
+  if (lazy_children == NULL)
+    return NULL;
+
+  lazy_objects = g_hash_table_lookup (lazy_children, GSIZE_TO_POINTER (widget_type));
+  if (lazy_objects == NULL)
+    return NULL;
+
+  template = GTK_WIDGET_CLASS (g_type_class_peek (widget_type))->priv->template;
+  for (l = template->children; l; l = l->next)
+    {
+      if (strcmp (((AutomaticChildClass *) l->data)->name, name) == 0)
+        {
+          child_class = l->data;
+          break;
+        }
+    }
+
+  if (child_class == NULL ||
+      !g_hash_table_steal_extended (lazy_objects, name, &key, (gpointer *) &lazy))
+    return NULL;
+
+  builder = gtk_builder_new ();
+
+  if (template->scope)
+    gtk_builder_set_scope (builder, template->scope);
+
+  gtk_builder_set_current_object (builder, G_OBJECT (widget));
+  gtk_builder_expose_object (builder, g_type_name (widget_type), G_OBJECT (widget));
+  expose_template_objects (builder, widget);
+
+  /* The new builder does not know the other lazy children */
+  _gtk_builder_lazy_object_skip_siblings (lazy, lazy_objects);
+  _gtk_builder_take_lazy_object (builder, key, lazy);
+  g_free (key);
+
+  object = gtk_builder_get_object (builder, name);
+  if (object)
+    setup_template_child (template, widget_type, child_class, widget, builder);
+
+  g_object_unref (builder);
+
+  return object;
+}
+
 /**
  * gtk_widget_init_template:
  * @widget: a #GtkWidget
@@ -10687,6 +11039,7 @@ gtk_widget_init_template (GtkWidget *widget)
   GtkBuilder *builder;
   GError *error = NULL;
   GObject *object;
+  GHashTable *lazy_objects;
   GSList *l;
   GType class_type;
 
@@ -10705,6 +11058,9 @@ gtk_widget_init_template (GtkWidget *widget)
 
   gtk_builder_set_current_object (builder, G_OBJECT (widget));
 
+  if (template->precompiled)
+    _gtk_builder_set_precompiled (builder, template->precompiled);
+
   /* This will build the template XML as children to the widget instance, also it
    * will validate that the template is created for the correct GType and assert that
    * there is no infinite recursion.
@@ -10731,6 +11087,10 @@ gtk_widget_init_template (GtkWidget *widget)
     {
       AutomaticChildClass *child_class = l->data;
 
+      /* Lazy children are built by gtk_widget_get_template_child() */
+      if (_gtk_builder_has_lazy_object (builder, child_class->name))
+        continue;
+
       /* This will setup the pointer of an automated child, and cause
        * it to be available in any GtkBuildable.get_internal_child()
        * invocations which may follow by reference in child classes.
@@ -10746,6 +11106,25 @@ gtk_widget_init_template (GtkWidget *widget)
 	}
     }
 
+  /* The builder holds a reference on the widget, so only the
+   * lazy objects are kept
+   */
+  lazy_objects = _gtk_builder_steal_lazy_objects (builder);
+  if (lazy_objects)
+    {
+      GHashTable *lazy_children;
+
+      lazy_children = g_object_get_qdata (object, quark_lazy_template_children);
+      if (lazy_children == NULL)
+        {
+          lazy_children = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_hash_table_unref);
+          g_object_set_qdata_full (object, quark_lazy_template_children,
+                                   lazy_children, (GDestroyNotify) g_hash_table_unref);
+        }
+
+      g_hash_table_insert (lazy_children, GSIZE_TO_POINTER (class_type), lazy_objects);
+    }
+
   g_object_unref (builder);
 }
 
@@ -10792,6 +11171,10 @@ gtk_widget_class_set_template (GtkWidgetClass    *widget_class,
     widget_class->priv->template->data = data;
   else
     widget_class->priv->template->data = g_bytes_ref (template_bytes);
+
+  if (_gtk_buildable_parser_is_precompiled (g_bytes_get_data (widget_class->priv->template->data, NULL),
+                                            g_bytes_get_size (widget_class->priv->template->data)))
+    widget_class->priv->template->precompiled = _gtk_builder_precompiled_new (widget_class->priv->template->data);
 }
 
 /**
@@ -10963,6 +11346,10 @@ gtk_widget_class_bind_template_child_full (GtkWidgetClass *widget_class,
  * gtk_widget_class_bind_template_child_full() or one of its
  * variants.
  *
+ * Children that are marked as lazy in the template XML are built
+ * by the first call to this function. Until then, the instance
+ * structure members bound to them are %NULL.
+ *
  * This function is only meant to be called for code which is private to the @widget_type which
  * declared the child and is meant for language bindings which cannot easily make use
  * of the GObject structure offsets.
@@ -10986,6 +11373,9 @@ gtk_widget_get_template_child (GtkWidget   *widget,
   if (auto_child_hash)
     ret = g_hash_table_lookup (auto_child_hash, name);
 
+  if (ret == NULL)
+    ret = create_lazy_template_child (widget, widget_type, name);
+
   return ret;
 }
 
@@ -11258,6 +11648,39 @@ gtk_widget_list_controllers (GtkWidget           *widget,
   return (GtkEventController **)g_ptr_array_free (controllers, FALSE);
 }
 
+/* The background and border only depend on the style and the size,
+ * so they are kept across snapshots. Redrawing a widget because of its
+ * contents then hands the same nodes to the renderer, and its caches
+ * that are keyed by node, like the ones for shadows, keep hitting.
+ * Animated and dynamic values give every frame a new style, so they
+ * don't need to be handled here.
+ */
+static void
+gtk_widget_snapshot_css_box (GtkWidget   *widget,
+                             GtkCssBoxes *boxes,
+                             GtkSnapshot *snapshot)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (priv->box_node_style != boxes->style ||
+      priv->box_node_width != priv->width ||
+      priv->box_node_height != priv->height)
+    {
+      g_clear_pointer (&priv->box_node, gsk_render_node_unref);
+      g_set_object (&priv->box_node_style, boxes->style);
+      priv->box_node_width = priv->width;
+      priv->box_node_height = priv->height;
+
+      gtk_snapshot_push_collect (snapshot);
+      gtk_css_style_snapshot_background (boxes, snapshot);
+      gtk_css_style_snapshot_border (boxes, snapshot);
+      priv->box_node = gtk_snapshot_pop_collect (snapshot);
+    }
+
+  if (priv->box_node)
+    gtk_snapshot_append_node (snapshot, priv->box_node);
+}
+
 static GskRenderNode *
 gtk_widget_create_render_node (GtkWidget   *widget,
                                GtkSnapshot *snapshot)
@@ -11290,8 +11713,7 @@ gtk_widget_create_render_node (GtkWidget   *widget,
   if (opacity < 1.0)
     gtk_snapshot_push_opacity (snapshot, opacity);
 
-  gtk_css_style_snapshot_background (&boxes, snapshot);
-  gtk_css_style_snapshot_border (&boxes, snapshot);
+  gtk_widget_snapshot_css_box (widget, &boxes, snapshot);
 
   if (priv->overflow == GTK_OVERFLOW_HIDDEN)
     {
@@ -11317,14 +11739,117 @@ gtk_widget_create_render_node (GtkWidget   *widget,
 }
 
 static void
-gtk_widget_do_snapshot (GtkWidget *widget,
+gtk_widget_do_snapshot (GtkWidget   *widget,
+                        GtkSnapshot *snapshot);
+
+/* Updates the retained render node of a widget whose own contents did
+ * not change, but that has descendants behind a render boundary that
+ * need to be redrawn: the children get snapshotted, and their new nodes
+ * replace the old ones inside the retained node.
+ *
+ * Returns: %FALSE if the node could not be updated that way, and the
+ *   widget needs to be snapshotted normally
+ */
+static gboolean
+gtk_widget_splice_render_node (GtkWidget   *widget,
+                               GtkSnapshot *snapshot)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  GHashTable *replacements;
+  GskRenderNode *render_node;
+  GtkWidget *child;
+  gboolean result = FALSE;
+
+  if (priv->render_node == NULL)
+    return FALSE;
+
+  /* Unchanged children map to themselves, so that their nodes are
+   * not searched for the changed ones
+   */
+  replacements = g_hash_table_new_full (NULL, NULL,
+                                        (GDestroyNotify) gsk_render_node_unref,
+                                        (GDestroyNotify) gsk_render_node_unref);
+
+  for (child = priv->first_child;
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
+      GskRenderNode *old_node;
+
+      if (GTK_IS_NATIVE (child))
+        continue;
+
+      if (child_priv->snapshot_ahead)
+        {
+          /* Already snapshotted by gtk_widget_snapshot_in_threads() */
+          child_priv->snapshot_ahead = FALSE;
+          old_node = g_steal_pointer (&child_priv->previous_render_node);
+
+          if (old_node == NULL || child_priv->render_node == NULL)
+            {
+              g_clear_pointer (&old_node, gsk_render_node_unref);
+              goto out;
+            }
+
+          g_hash_table_insert (replacements, old_node, gsk_render_node_ref (child_priv->render_node));
+          continue;
+        }
+
+      if (!child_priv->draw_needed && !child_priv->child_draw_needed)
+        {
+          if (child_priv->mapped && child_priv->render_node != NULL)
+            g_hash_table_insert (replacements,
+                                 gsk_render_node_ref (child_priv->render_node),
+                                 gsk_render_node_ref (child_priv->render_node));
+          continue;
+        }
+
+      if (!child_priv->mapped || child_priv->render_node == NULL)
+        goto out;
+
+      old_node = gsk_render_node_ref (child_priv->render_node);
+
+      gtk_widget_do_snapshot (child, snapshot);
+
+      if (child_priv->render_node == NULL)
+        {
+          gsk_render_node_unref (old_node);
+          goto out;
+        }
+
+      g_hash_table_insert (replacements, old_node, gsk_render_node_ref (child_priv->render_node));
+    }
+
+  render_node = gsk_render_node_replace_children (priv->render_node, replacements);
+  if (render_node == NULL)
+    goto out;
+
+  gsk_render_node_unref (priv->render_node);
+  priv->render_node = render_node;
+
+  result = TRUE;
+
+out:
+  g_hash_table_unref (replacements);
+
+  return result;
+}
+
+static void
+gtk_widget_do_snapshot (GtkWidget   *widget,
                         GtkSnapshot *snapshot)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
   GskRenderNode *render_node;
+  gint64 before = 0;
 
-  if (!priv->draw_needed)
-    return;
+  if (!priv->draw_needed && !priv->child_draw_needed)
+    {
+      if (priv->render_node)
+        g_atomic_int_inc (&reused_render_nodes);
+      return;
+    }
 
   g_assert (priv->mapped);
 
@@ -11334,15 +11859,36 @@ gtk_widget_do_snapshot (GtkWidget *widget,
       return;
     }
 
+  if (!priv->draw_needed &&
+      gtk_widget_splice_render_node (widget, snapshot))
+    {
+      g_atomic_int_inc (&spliced_render_nodes);
+      priv->child_draw_needed = FALSE;
+      gtk_widget_update_paintables (widget);
+      return;
+    }
+
   gtk_widget_push_paintables (widget);
 
+  g_atomic_int_inc (&snapshotted_widgets);
+
+  /* One mark per widget is too much for sysprof, but lets the
+   * inspector find the widgets that take longest to snapshot.
+   */
+  if (gdk_profiler_is_collecting ())
+    before = GDK_PROFILER_CURRENT_TIME;
+
   render_node = gtk_widget_create_render_node (widget, snapshot);
+
+  if (before != 0)
+    gdk_profiler_end_markf (before, "snapshot widget", "%s %p", G_OBJECT_TYPE_NAME (widget), widget);
   /* This can happen when nested drawing happens and a widget contains itself
    * or when we replace a clipped area */
   g_clear_pointer (&priv->render_node, gsk_render_node_unref);
   priv->render_node = render_node;
 
   priv->draw_needed = FALSE;
+  priv->child_draw_needed = FALSE;
 
   gtk_widget_pop_paintables (widget);
   gtk_widget_update_paintables (widget);
@@ -11363,6 +11909,155 @@ gtk_widget_snapshot (GtkWidget   *widget,
     gtk_snapshot_append_node (snapshot, priv->render_node);
 }
 
+/* Render boundaries whose dirty widgets all have thread-safe snapshot
+ * implementations get snapshotted on worker threads before the main
+ * snapshot. The main snapshot then finds them clean and just appends
+ * their retained nodes, so the order of the nodes does not change.
+ */
+typedef struct
+{
+  GtkWidget *widget;
+} SnapshotJob;
+
+static gboolean
+gtk_widget_can_snapshot_in_thread (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  GtkCssStyle *style;
+  GtkWidget *child;
+  guint i;
+
+  if (!priv->draw_needed && !priv->child_draw_needed)
+    return TRUE;
+
+  if (GTK_IS_NATIVE (widget) ||
+      priv->paintables != NULL ||
+      _gtk_widget_get_alloc_needed (widget))
+    return FALSE;
+
+  /* Widgets that only have children to redraw usually get their node
+   * spliced, but if that fails they are snapshotted in full on the
+   * same thread. So they need to be as safe as the ones to redraw.
+   */
+  if (!GTK_WIDGET_GET_CLASS (widget)->priv->snapshot_thread_safe)
+    return FALSE;
+
+  /* CSS images may load their contents when they are first drawn */
+  style = gtk_css_node_get_style (priv->cssnode);
+  if (_gtk_css_image_value_get_image (style->border->border_image_source) != NULL)
+    return FALSE;
+
+  for (i = 0; i < _gtk_css_array_value_get_n_values (style->background->background_image); i++)
+    {
+      GtkCssValue *image = _gtk_css_array_value_get_nth (style->background->background_image, i);
+
+      if (_gtk_css_image_value_get_image (image) != NULL)
+        return FALSE;
+    }
+
+  for (child = priv->first_child;
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      if (_gtk_widget_get_mapped (child) &&
+          !gtk_widget_can_snapshot_in_thread (child))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_widget_collect_threaded_snapshots (GtkWidget *widget,
+                                       GPtrArray *widgets)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  GtkWidget *child;
+
+  for (child = priv->first_child;
+       child != NULL;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
+
+      if (!child_priv->mapped || GTK_IS_NATIVE (child))
+        continue;
+
+      if (!child_priv->draw_needed && !child_priv->child_draw_needed)
+        continue;
+
+      if (child_priv->render_boundary &&
+          gtk_widget_can_snapshot_in_thread (child))
+        g_ptr_array_add (widgets, child);
+      else
+        gtk_widget_collect_threaded_snapshots (child, widgets);
+    }
+}
+
+static void
+snapshot_job_func (gpointer data,
+                   gpointer user_data)
+{
+  SnapshotJob *job = data;
+  GskRenderNodeArena *arena, *previous_arena;
+  GtkSnapshot *snapshot;
+  GskRenderNode *node;
+
+  arena = gsk_render_node_arena_new ();
+  previous_arena = gsk_render_node_arena_push (arena);
+
+  /* The node ends up retained in the widget, the snapshot stays empty */
+  snapshot = gtk_snapshot_new ();
+  gtk_widget_do_snapshot (job->widget, snapshot);
+  node = gtk_snapshot_free_to_node (snapshot);
+  g_clear_pointer (&node, gsk_render_node_unref);
+
+  gsk_render_node_arena_pop (arena, previous_arena);
+  gsk_render_node_arena_free (arena);
+}
+
+static void
+gtk_widget_snapshot_in_threads (GtkWidget *widget)
+{
+  SnapshotJob *jobs;
+  GPtrArray *widgets;
+  guint i;
+
+  if (gtk_get_n_threads () < 2)
+    return;
+
+  widgets = g_ptr_array_new ();
+  gtk_widget_collect_threaded_snapshots (widget, widgets);
+
+  /* Not worth the synchronization for a single subtree */
+  if (widgets->len < 2)
+    {
+      g_ptr_array_unref (widgets);
+      return;
+    }
+
+  jobs = g_new (SnapshotJob, widgets->len);
+  for (i = 0; i < widgets->len; i++)
+    {
+      GtkWidgetPrivate *priv;
+
+      jobs[i].widget = g_ptr_array_index (widgets, i);
+
+      /* Keep the old node, the parent may need it for splicing */
+      priv = gtk_widget_get_instance_private (jobs[i].widget);
+      priv->snapshot_ahead = TRUE;
+      if (priv->render_node)
+        priv->previous_render_node = gsk_render_node_ref (priv->render_node);
+    }
+
+  gdk_parallel_run (jobs, sizeof (SnapshotJob), widgets->len, snapshot_job_func, NULL);
+
+  threaded_snapshots += widgets->len;
+
+  g_free (jobs);
+  g_ptr_array_unref (widgets);
+}
+
 void
 gtk_widget_render (GtkWidget            *widget,
                    GdkSurface           *surface,
@@ -11371,6 +12066,7 @@ gtk_widget_render (GtkWidget            *widget,
   GtkSnapshot *snapshot;
   GskRenderer *renderer;
   GskRenderNode *root;
+  GskRenderNodeArena *arena, *previous_arena;
   double x, y;
   gint64 before_snapshot G_GNUC_UNUSED;
   gint64 before_render G_GNUC_UNUSED;
@@ -11385,17 +12081,43 @@ gtk_widget_render (GtkWidget            *widget,
   if (renderer == NULL)
     return;
 
+  /* Nodes retained in priv->render_node keep their arena block alive,
+   * so it is fine for them to outlive the frame.
+   */
+  arena = gsk_render_node_arena_new ();
+  previous_arena = gsk_render_node_arena_push (arena);
+
+  gtk_widget_snapshot_in_threads (widget);
+
   snapshot = gtk_snapshot_new ();
   gtk_native_get_surface_transform (GTK_NATIVE (widget), &x, &y);
   gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (x, y));
   gtk_widget_snapshot (widget, snapshot);
   root = gtk_snapshot_free_to_node (snapshot);
 
+  gsk_render_node_arena_pop (arena, previous_arena);
+  gsk_render_node_arena_free (arena);
+
   if (GDK_PROFILER_IS_RUNNING)
     {
       before_render = GDK_PROFILER_CURRENT_TIME;
       gdk_profiler_add_mark (before_snapshot, (before_render - before_snapshot), "widget snapshot", "");
-    }
+
+      gdk_profiler_set_int_counter (allocated_widgets_counter, allocated_widgets);
+      gdk_profiler_set_int_counter (snapshotted_widgets_counter, snapshotted_widgets);
+      gdk_profiler_set_int_counter (reused_render_nodes_counter, reused_render_nodes);
+      gdk_profiler_set_int_counter (spliced_render_nodes_counter, spliced_render_nodes);
+      gdk_profiler_set_int_counter (threaded_snapshots_counter, threaded_snapshots);
+      gdk_profiler_set_int_counter (skipped_allocations_counter, skipped_allocations);
+    }
+  gtk_size_request_push_profiler_counters ();
+  gsk_pango_push_profiler_counters ();
+  allocated_widgets = 0;
+  snapshotted_widgets = 0;
+  reused_render_nodes = 0;
+  spliced_render_nodes = 0;
+  threaded_snapshots = 0;
+  skipped_allocations = 0;
 
   if (root != NULL)
     {
@@ -11751,6 +12473,9 @@ gtk_widget_snapshot_child (GtkWidget   *widget,
 
   gtk_widget_do_snapshot (child, snapshot);
 
+  priv->snapshot_ahead = FALSE;
+  g_clear_pointer (&priv->previous_render_node, gsk_render_node_unref);
+
   if (!priv->render_node)
     return;
 
@@ -12563,6 +13288,133 @@ gtk_widget_class_set_accessible_role (GtkWidgetClass    *widget_class,
   priv->accessible_role = accessible_role;
 }
 
+/*< private >
+ * gtk_widget_class_set_snapshot_thread_safe:
+ * @widget_class: a #GtkWidgetClass
+ * @thread_safe: whether the snapshot() implementation is thread-safe
+ *
+ * Declares that the snapshot() implementation of @widget_class only
+ * reads the state of the widget and appends nodes to the snapshot, so
+ * it can be called on a worker thread.
+ *
+ * Render boundaries where all widgets that need to be redrawn are
+ * thread-safe may be snapshotted in parallel with each other.
+ *
+ * This is not inherited by subclasses.
+ */
+void
+gtk_widget_class_set_snapshot_thread_safe (GtkWidgetClass *widget_class,
+                                           gboolean        thread_safe)
+{
+  g_return_if_fail (GTK_IS_WIDGET_CLASS (widget_class));
+
+  widget_class->priv->snapshot_thread_safe = thread_safe;
+}
+
+/*< private >
+ * gtk_widget_class_set_measure_equal_func:
+ * @widget_class: a #GtkWidgetClass
+ * @measure_equal: function comparing the measure() inputs of two widgets
+ *
+ * Declares that measure() of @widget_class only depends on the CSS
+ * style, the children and the state compared by @measure_equal, so
+ * that identical siblings can share a measurement, see
+ * gtk_widget_measure_shared().
+ *
+ * This is not inherited by subclasses.
+ */
+void
+gtk_widget_class_set_measure_equal_func (GtkWidgetClass            *widget_class,
+                                         GtkWidgetMeasureEqualFunc  measure_equal)
+{
+  g_return_if_fail (GTK_IS_WIDGET_CLASS (widget_class));
+
+  widget_class->priv->measure_equal = measure_equal;
+}
+
+/*< private >
+ * gtk_widget_measure_equal:
+ * @widget: a #GtkWidget
+ * @other: another #GtkWidget
+ *
+ * Checks whether gtk_widget_measure() returns the same sizes for
+ * @widget and @other. This is only known for widgets whose class
+ * set a measure_equal function and that have the same type, CSS
+ * style, size request and margins, and children that are equal
+ * in the same way. %FALSE is returned when in doubt.
+ *
+ * Returns: %TRUE if @widget and @other measure the same
+ */
+gboolean
+gtk_widget_measure_equal (GtkWidget *widget,
+                          GtkWidget *other)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+  GtkWidgetPrivate *other_priv = gtk_widget_get_instance_private (other);
+  GtkWidgetMeasureEqualFunc measure_equal;
+  GtkWidget *child, *other_child;
+
+  if (widget == other)
+    return TRUE;
+
+  if (G_OBJECT_TYPE (widget) != G_OBJECT_TYPE (other))
+    return FALSE;
+
+  measure_equal = GTK_WIDGET_GET_CLASS (widget)->priv->measure_equal;
+  if (measure_equal == NULL)
+    return FALSE;
+
+  if (gtk_css_node_get_style (priv->cssnode) != gtk_css_node_get_style (other_priv->cssnode) ||
+      priv->width_request != other_priv->width_request ||
+      priv->height_request != other_priv->height_request ||
+      memcmp (&priv->margin, &other_priv->margin, sizeof (GtkBorder)) != 0)
+    return FALSE;
+
+  /* Other layout managers have properties of their own */
+  if ((priv->layout_manager != NULL || other_priv->layout_manager != NULL) &&
+      (!GTK_IS_BIN_LAYOUT (priv->layout_manager) || !GTK_IS_BIN_LAYOUT (other_priv->layout_manager)))
+    return FALSE;
+
+  for (child = priv->first_child, other_child = other_priv->first_child;
+       child != NULL && other_child != NULL;
+       child = _gtk_widget_get_next_sibling (child), other_child = _gtk_widget_get_next_sibling (other_child))
+    {
+      gboolean should_layout = gtk_widget_should_layout (child);
+
+      if (should_layout != gtk_widget_should_layout (other_child))
+        return FALSE;
+
+      if (should_layout &&
+          (_gtk_widget_get_sizegroups (child) != NULL ||
+           _gtk_widget_get_sizegroups (other_child) != NULL ||
+           !gtk_widget_measure_equal (child, other_child)))
+        return FALSE;
+    }
+
+  if (child != NULL || other_child != NULL)
+    return FALSE;
+
+  return measure_equal (widget, other);
+}
+
+/*< private >
+ * gtk_widget_measure_equal_style:
+ * @widget: a #GtkWidget
+ * @other: another #GtkWidget
+ *
+ * A #GtkWidgetMeasureEqualFunc for classes that have no state
+ * of their own affecting their size, like containers using a
+ * #GtkBinLayout.
+ *
+ * Returns: %TRUE
+ */
+gboolean
+gtk_widget_measure_equal_style (GtkWidget *widget,
+                                GtkWidget *other)
+{
+  return TRUE;
+}
+
 /**
  * gtk_widget_class_get_accessible_role:
  * @widget_class: a #GtkWidgetClass
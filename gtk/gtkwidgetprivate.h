@@ -86,9 +86,15 @@ struct _GtkWidgetPrivate
   guint resize_needed         : 1; /* queue_resize() has been called but no get_preferred_size() yet */
   guint alloc_needed          : 1; /* this widget needs a size_allocate() call */
   guint alloc_needed_on_child : 1; /* 0 or more children - or this widget - need a size_allocate() call */
+  guint resize_from_child     : 1; /* the queued resize only came from children */
+  guint request_unchanged     : 1; /* sizes measured since the resize match old_requests */
+  guint request_changed       : 1; /* a size measured since the resize didn't match */
 
   /* Queue-draw related flags */
   guint draw_needed           : 1;
+  guint child_draw_needed     : 1; /* only render boundaries below need to be redrawn */
+  guint render_boundary       : 1; /* redraws get spliced into the parent's node */
+  guint snapshot_ahead        : 1; /* snapshotted in a thread, see previous_render_node */
   /* Expand-related flags */
   guint need_compute_expand   : 1; /* Need to recompute computed_[hv]_expand */
   guint computed_hexpand      : 1; /* computed results (composite of child flags) */
@@ -162,9 +168,19 @@ struct _GtkWidgetPrivate
 
   /* The widget's requested sizes */
   SizeRequestCache requests;
+  /* The requested sizes before the last resize, until the next allocation */
+  SizeRequestCache *old_requests;
 
   /* The render node we draw or %NULL if not yet created.*/
   GskRenderNode *render_node;
+  GskRenderNode *previous_render_node;
+
+  /* The CSS background and border from the last snapshot, and the
+   * style and size they were created for */
+  GskRenderNode *box_node;
+  GtkCssStyle *box_node_style;
+  int box_node_width;
+  int box_node_height;
 
   /* The layout manager, or %NULL */
   GtkLayoutManager *layout_manager;
@@ -201,10 +217,29 @@ struct _GtkWidgetPrivate
 typedef struct
 {
   GBytes *data;
+  struct _GtkBuilderPrecompiled *precompiled;
   GSList *children;
   GtkBuilderScope *scope;
 } GtkWidgetTemplate;
 
+/* Compares the state that measure() depends on, besides the CSS style
+ * and children, see gtk_widget_measure_equal()
+ */
+typedef gboolean (* GtkWidgetMeasureEqualFunc) (GtkWidget *widget,
+                                                GtkWidget *other);
+
+/* The last size measured by gtk_widget_measure_shared() */
+typedef struct
+{
+  GtkWidget *widget;
+  GtkOrientation orientation;
+  int for_size;
+  int minimum;
+  int natural;
+  int minimum_baseline;
+  int natural_baseline;
+} GtkMeasureShare;
+
 struct _GtkWidgetClassPrivate
 {
   GtkWidgetTemplate *template;
@@ -213,6 +248,8 @@ struct _GtkWidgetClassPrivate
   GType layout_manager_type;
   GtkWidgetAction *actions;
   GtkAccessibleRole accessible_role;
+  GtkWidgetMeasureEqualFunc measure_equal;
+  guint snapshot_thread_safe : 1;
 };
 
 void          gtk_widget_root               (GtkWidget *widget);
@@ -223,7 +260,32 @@ void         _gtk_widget_set_visible_flag   (GtkWidget *widget,
 gboolean     _gtk_widget_get_alloc_needed   (GtkWidget *widget);
 gboolean     gtk_widget_needs_allocate      (GtkWidget *widget);
 void         gtk_widget_ensure_resize       (GtkWidget *widget);
+void         gtk_widget_check_request_changed (GtkWidget      *widget,
+                                               GtkOrientation  orientation,
+                                               int             for_size,
+                                               int             minimum,
+                                               int             natural,
+                                               int             minimum_baseline,
+                                               int             natural_baseline);
 void         gtk_widget_ensure_allocate     (GtkWidget *widget);
+void         gtk_widget_set_render_boundary (GtkWidget *widget,
+                                             gboolean   render_boundary);
+void         gtk_widget_class_set_snapshot_thread_safe (GtkWidgetClass *widget_class,
+                                                        gboolean        thread_safe);
+void         gtk_widget_class_set_measure_equal_func (GtkWidgetClass            *widget_class,
+                                                      GtkWidgetMeasureEqualFunc  measure_equal);
+gboolean     gtk_widget_measure_equal       (GtkWidget *widget,
+                                             GtkWidget *other);
+gboolean     gtk_widget_measure_equal_style (GtkWidget *widget,
+                                             GtkWidget *other);
+void         gtk_widget_measure_shared      (GtkWidget       *widget,
+                                             GtkOrientation   orientation,
+                                             int              for_size,
+                                             GtkMeasureShare *share,
+                                             int             *minimum,
+                                             int             *natural,
+                                             int             *minimum_baseline,
+                                             int             *natural_baseline);
 void          _gtk_widget_scale_changed     (GtkWidget *widget);
 
 void         gtk_widget_render              (GtkWidget            *widget,
@@ -268,6 +330,7 @@ void              gtk_widget_system_setting_changed        (GtkWidget
                                                             GtkSystemSetting     setting);
 void              gtk_system_setting_changed               (GdkDisplay          *display,
                                                             GtkSystemSetting     setting);
+void              gtk_font_options_changed                 (GdkDisplay          *display);
 
 void              _gtk_widget_update_parent_muxer          (GtkWidget    *widget);
 GtkActionMuxer *  _gtk_widget_get_action_muxer             (GtkWidget    *widget,
@@ -302,6 +365,7 @@ void              gtk_widget_adjust_size_request           (GtkWidget      *widg
 void              gtk_widget_adjust_baseline_request       (GtkWidget *widget,
                                                             int       *minimum_baseline,
                                                             int       *natural_baseline);
+void              gtk_size_request_push_profiler_counters  (void);
 
 typedef void    (*GtkCallback)     (GtkWidget        *widget,
                                     gpointer          data);
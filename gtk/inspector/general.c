@@ -33,6 +33,7 @@
 #include "gtkbox.h"
 #include "gtkbinlayout.h"
 #include "gtkmediafileprivate.h"
+#include "gtkcssselectorprivate.h"
 
 
 #ifdef GDK_WINDOWING_X11
@@ -73,6 +74,7 @@ struct _GtkInspectorGeneral
   GtkWidget *monitor_box;
   GtkWidget *gl_box;
   GtkWidget *vulkan_box;
+  GtkWidget *css_box;
   GtkWidget *device_box;
   GtkWidget *gtk_version;
   GtkWidget *gdk_backend;
@@ -94,6 +96,10 @@ struct _GtkInspectorGeneral
   GtkWidget *display_name;
   GtkWidget *display_rgba;
   GtkWidget *display_composited;
+  GtkWidget *css_rejected;
+  GtkWidget *css_checked;
+  GtkWidget *css_matched;
+  guint css_update_source_id;
   GtkSizeGroup *labels;
 
   GdkDisplay *display;
@@ -196,7 +202,7 @@ add_check_row (GtkInspectorGeneral *gen,
   gtk_size_group_add_widget (GTK_SIZE_GROUP (gen->labels), label);
 }
 
-static void
+static GtkWidget *
 add_label_row (GtkInspectorGeneral *gen,
                GtkListBox          *list,
                const char          *name,
@@ -232,6 +238,8 @@ add_label_row (GtkInspectorGeneral *gen,
   gtk_list_box_insert (GTK_LIST_BOX (list), row, -1);
 
   gtk_size_group_add_widget (GTK_SIZE_GROUP (gen->labels), label);
+
+  return label;
 }
 
 #ifdef GDK_WINDOWING_X11
@@ -631,6 +639,47 @@ init_display (GtkInspectorGeneral *gen)
   populate_display (gen->display, gen);
 }
 
+static void
+set_count_label (GtkWidget *label,
+                 guint      count)
+{
+  char *text;
+
+  text = g_strdup_printf ("%u", count);
+  gtk_label_set_text (GTK_LABEL (label), text);
+  g_free (text);
+}
+
+static gboolean
+update_css (gpointer data)
+{
+  GtkInspectorGeneral *gen = data;
+  guint rejected, checked, matched;
+
+  _gtk_css_selector_tree_get_match_stats (&rejected, &checked, &matched);
+
+  set_count_label (gen->css_rejected, rejected);
+  set_count_label (gen->css_checked, checked);
+  set_count_label (gen->css_matched, matched);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+init_css (GtkInspectorGeneral *gen)
+{
+  GtkListBox *list = GTK_LIST_BOX (gen->css_box);
+
+  add_label_row (gen, list, "Ancestor selectors", NULL, 0);
+  gen->css_rejected = add_label_row (gen, list, "Rejected by bloom filter", NULL, 10);
+  gen->css_checked = add_label_row (gen, list, "Checked", NULL, 10);
+  gen->css_matched = add_label_row (gen, list, "Matched", NULL, 10);
+
+  update_css (gen);
+  gen->css_update_source_id = g_timeout_add_seconds (1, update_css, gen);
+  g_source_set_name_by_id (gen->css_update_source_id, "[gtk] inspector css stats");
+}
+
 static void
 init_pango (GtkInspectorGeneral *gen)
 {
@@ -881,8 +930,12 @@ keynav_failed (GtkWidget *widget, GtkDirectionType direction, GtkInspectorGenera
   else if (direction == GTK_DIR_DOWN && widget == gen->gl_box)
     next = gen->vulkan_box;
   else if (direction == GTK_DIR_DOWN && widget == gen->vulkan_box)
+    next = gen->css_box;
+  else if (direction == GTK_DIR_DOWN && widget == gen->css_box)
     next = gen->device_box;
   else if (direction == GTK_DIR_UP && widget == gen->device_box)
+    next = gen->css_box;
+  else if (direction == GTK_DIR_UP && widget == gen->css_box)
     next = gen->vulkan_box;
   else if (direction == GTK_DIR_UP && widget == gen->vulkan_box)
     next = gen->gl_box;
@@ -919,6 +972,7 @@ gtk_inspector_general_constructed (GObject *object)
    g_signal_connect (gen->monitor_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
    g_signal_connect (gen->gl_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
    g_signal_connect (gen->vulkan_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
+   g_signal_connect (gen->css_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
    g_signal_connect (gen->device_box, "keynav-failed", G_CALLBACK (keynav_failed), gen);
 }
 
@@ -928,6 +982,7 @@ gtk_inspector_general_dispose (GObject *object)
   GtkInspectorGeneral *gen = GTK_INSPECTOR_GENERAL (object);
   GList *list, *l;
 
+  g_clear_handle_id (&gen->css_update_source_id, g_source_remove);
   g_clear_pointer (&gen->swin, gtk_widget_unparent);
 
   g_signal_handlers_disconnect_by_func (gen->display, G_CALLBACK (seat_added), gen);
@@ -959,6 +1014,7 @@ gtk_inspector_general_class_init (GtkInspectorGeneralClass *klass)
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, monitor_box);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, gl_box);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, vulkan_box);
+  gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, css_box);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, gtk_version);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, gdk_backend);
   gtk_widget_class_bind_template_child (widget_class, GtkInspectorGeneral, gsk_renderer);
@@ -998,6 +1054,7 @@ gtk_inspector_general_set_display (GtkInspectorGeneral *gen,
   init_media (gen);
   init_gl (gen);
   init_vulkan (gen);
+  init_css (gen);
   init_device (gen);
 }
 
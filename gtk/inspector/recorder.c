@@ -19,8 +19,11 @@
 
 #include "recorder.h"
 
+#include <string.h>
+
 #include <gtk/gtkbinlayout.h>
 #include <gtk/gtkbox.h>
+#include <gtk/gtkdrawingarea.h>
 #include <gtk/gtkfilechooserdialog.h>
 #include <gtk/gtksignallistitemfactory.h>
 #include <gtk/gtklabel.h>
@@ -33,6 +36,7 @@
 #include <gtk/gtkpopover.h>
 #include <gtk/gtksingleselection.h>
 #include <gtk/gtktogglebutton.h>
+#include <gtk/gtktooltip.h>
 #include <gtk/gtktreeexpander.h>
 #include <gtk/gtktreelistmodel.h>
 #include <gtk/gtktreemodel.h>
@@ -44,6 +48,7 @@
 
 #include <glib/gi18n-lib.h>
 #include <gdk/gdktextureprivate.h>
+#include "gdk/gdkprofilerprivate.h"
 #include "gtk/gtkdebug.h"
 #include "gtk/gtkbuiltiniconprivate.h"
 #include "gtk/gtkrendernodepaintableprivate.h"
@@ -71,6 +76,11 @@ struct _GtkInspectorRecorder
 
   GtkInspectorRecording *recording; /* start recording if recording or NULL if not */
 
+  /* Profiler marks may come in from snapshot threads */
+  GMutex marks_lock;
+  GArray *frame_marks;
+  GPtrArray *frame_recordings; /* render recordings of the current frame */
+
   gboolean debug_nodes;
 };
 
@@ -1230,6 +1240,231 @@ toggle_dark_mode (GtkToggleButton *button,
     }
 }
 
+/* The flame views show spans of a frame, one row per nesting
+ * level, scaled so that the frame fills the width.
+ */
+#define FLAME_ROW_HEIGHT 18
+
+typedef struct
+{
+  const char *name;
+  const char *detail;
+  guint depth;
+  gint64 start;
+  gint64 duration;
+} FlameSpan;
+
+static gint64
+get_flame_duration (GArray *spans)
+{
+  gint64 end = 0;
+  guint i;
+
+  for (i = 0; i < spans->len; i++)
+    {
+      const FlameSpan *span = &g_array_index (spans, FlameSpan, i);
+
+      end = MAX (end, span->start + span->duration);
+    }
+
+  return end;
+}
+
+static void
+flame_view_draw (GtkDrawingArea *area,
+                 cairo_t        *cr,
+                 int             width,
+                 int             height,
+                 gpointer        data)
+{
+  GArray *spans = data;
+  gint64 duration;
+  guint i;
+
+  duration = get_flame_duration (spans);
+  if (duration == 0)
+    return;
+
+  for (i = 0; i < spans->len; i++)
+    {
+      const FlameSpan *span = &g_array_index (spans, FlameSpan, i);
+      double x, w, y;
+      guint hash;
+
+      x = (double) span->start * width / duration;
+      w = MAX ((double) span->duration * width / duration, 1);
+      y = span->depth * FLAME_ROW_HEIGHT;
+
+      /* Give each kind of span a stable color */
+      hash = g_str_hash (span->name);
+      cairo_set_source_rgb (cr,
+                            0.8 + 0.2 * ((hash & 0xff) / 255.),
+                            0.3 + 0.5 * (((hash >> 8) & 0xff) / 255.),
+                            0.2 * (((hash >> 16) & 0xff) / 255.));
+      cairo_rectangle (cr, x, y, w, FLAME_ROW_HEIGHT - 1);
+      cairo_fill (cr);
+
+      if (w > 20)
+        {
+          PangoLayout *layout;
+
+          layout = gtk_widget_create_pango_layout (GTK_WIDGET (area), span->name);
+          pango_layout_set_width (layout, (w - 4) * PANGO_SCALE);
+          pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_END);
+
+          cairo_set_source_rgb (cr, 0, 0, 0);
+          cairo_move_to (cr, x + 2, y + 1);
+          pango_cairo_show_layout (cr, layout);
+
+          g_object_unref (layout);
+        }
+    }
+}
+
+static gboolean
+flame_view_query_tooltip (GtkWidget  *widget,
+                          int         x,
+                          int         y,
+                          gboolean    keyboard_mode,
+                          GtkTooltip *tooltip,
+                          gpointer    data)
+{
+  GArray *spans = data;
+  gint64 duration;
+  int width;
+  guint i;
+
+  duration = get_flame_duration (spans);
+  width = gtk_widget_get_width (widget);
+  if (duration == 0 || width == 0)
+    return FALSE;
+
+  /* Later spans are drawn on top, so look at them first */
+  for (i = spans->len; i > 0; i--)
+    {
+      const FlameSpan *span = &g_array_index (spans, FlameSpan, i - 1);
+      double sx, sw;
+      char *text;
+
+      if (y / FLAME_ROW_HEIGHT != span->depth)
+        continue;
+
+      sx = (double) span->start * width / duration;
+      sw = MAX ((double) span->duration * width / duration, 1);
+      if (x < sx || x >= sx + sw)
+        continue;
+
+      if (span->detail && span->detail[0])
+        text = g_strdup_printf ("%s (%s): %.2f µs", span->name, span->detail, span->duration / 1000.0);
+      else
+        text = g_strdup_printf ("%s: %.2f µs", span->name, span->duration / 1000.0);
+      gtk_tooltip_set_text (tooltip, text);
+      g_free (text);
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Takes ownership of @spans. The recording is kept alive for
+ * the strings the spans point to.
+ */
+static GtkWidget *
+create_flame_view (GtkInspectorRenderRecording *recording,
+                   GArray                      *spans)
+{
+  GtkWidget *area;
+  guint i, max_depth;
+
+  if (spans->len == 0)
+    {
+      g_array_unref (spans);
+      return NULL;
+    }
+
+  max_depth = 0;
+  for (i = 0; i < spans->len; i++)
+    max_depth = MAX (max_depth, g_array_index (spans, FlameSpan, i).depth);
+
+  area = gtk_drawing_area_new ();
+  gtk_drawing_area_set_content_height (GTK_DRAWING_AREA (area), (max_depth + 1) * FLAME_ROW_HEIGHT);
+  gtk_drawing_area_set_draw_func (GTK_DRAWING_AREA (area),
+                                  flame_view_draw,
+                                  spans,
+                                  (GDestroyNotify) g_array_unref);
+  g_object_set_data_full (G_OBJECT (area), "recording", g_object_ref (recording), g_object_unref);
+  gtk_widget_set_has_tooltip (area, TRUE);
+  g_signal_connect (area, "query-tooltip", G_CALLBACK (flame_view_query_tooltip), spans);
+
+  return area;
+}
+
+static GtkWidget *
+create_gpu_flame_view (GtkInspectorRenderRecording *recording)
+{
+  const GskProfilerGpuSpan *gpu_spans;
+  GArray *spans;
+  guint i, n_spans;
+
+  gpu_spans = gtk_inspector_render_recording_get_gpu_spans (recording, &n_spans);
+
+  spans = g_array_sized_new (FALSE, FALSE, sizeof (FlameSpan), n_spans);
+  for (i = 0; i < n_spans; i++)
+    {
+      FlameSpan span = {
+        gpu_spans[i].name,
+        NULL,
+        gpu_spans[i].depth,
+        gpu_spans[i].start,
+        gpu_spans[i].duration
+      };
+
+      g_array_append_val (spans, span);
+    }
+
+  return create_flame_view (recording, spans);
+}
+
+static GtkWidget *
+create_frame_flame_view (GtkInspectorRenderRecording *recording)
+{
+  const GtkInspectorFrameSpan *frame_spans;
+  GArray *spans;
+  guint i, n_spans;
+
+  frame_spans = gtk_inspector_render_recording_get_frame_spans (recording, &n_spans);
+
+  spans = g_array_sized_new (FALSE, FALSE, sizeof (FlameSpan), n_spans);
+  for (i = 0; i < n_spans; i++)
+    {
+      FlameSpan span = {
+        frame_spans[i].name,
+        frame_spans[i].message,
+        frame_spans[i].depth,
+        frame_spans[i].start,
+        frame_spans[i].duration
+      };
+
+      g_array_append_val (spans, span);
+    }
+
+  return create_flame_view (recording, spans);
+}
+
+static void
+append_flame_view (GtkWidget *box,
+                   GtkWidget *button,
+                   GtkWidget *flame_view)
+{
+  if (flame_view == NULL)
+    return;
+
+  gtk_widget_hide (flame_view);
+  gtk_box_append (GTK_BOX (box), flame_view);
+  g_object_bind_property (button, "active", flame_view, "visible", 0);
+}
+
 static GtkWidget *
 gtk_inspector_recorder_recordings_list_create_widget (gpointer item,
                                                       gpointer user_data)
@@ -1241,6 +1476,7 @@ gtk_inspector_recorder_recordings_list_create_widget (gpointer item,
     {
       cairo_region_t *region;
       GtkWidget *hbox, *label, *button;
+      char *info;
 
       widget = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
 
@@ -1265,10 +1501,18 @@ gtk_inspector_recorder_recordings_list_create_widget (gpointer item,
 
       gtk_box_append (GTK_BOX (hbox), button);
 
-      label = gtk_label_new (gtk_inspector_render_recording_get_profiler_info (GTK_INSPECTOR_RENDER_RECORDING (recording)));
+      info = g_strconcat (gtk_inspector_render_recording_get_profiler_info (GTK_INSPECTOR_RENDER_RECORDING (recording)),
+                          gtk_inspector_render_recording_get_frame_info (GTK_INSPECTOR_RENDER_RECORDING (recording)),
+                          gtk_inspector_render_recording_get_node_info (GTK_INSPECTOR_RENDER_RECORDING (recording)),
+                          NULL);
+      label = gtk_label_new (info);
+      g_free (info);
       gtk_widget_hide (label);
       gtk_box_append (GTK_BOX (widget), label);
       g_object_bind_property (button, "active", label, "visible", 0);
+
+      append_flame_view (widget, button, create_frame_flame_view (GTK_INSPECTOR_RENDER_RECORDING (recording)));
+      append_flame_view (widget, button, create_gpu_flame_view (GTK_INSPECTOR_RENDER_RECORDING (recording)));
     }
   else
     {
@@ -1383,9 +1627,25 @@ gtk_inspector_recorder_dispose (GObject *object)
   g_clear_object (&recorder->render_node_root_model);
   g_clear_object (&recorder->render_node_selection);
 
+  if (gtk_inspector_recorder_is_recording (recorder))
+    gdk_profiler_set_mark_func (NULL, NULL);
+
   G_OBJECT_CLASS (gtk_inspector_recorder_parent_class)->dispose (object);
 }
 
+static void
+gtk_inspector_recorder_finalize (GObject *object)
+{
+  GtkInspectorRecorder *recorder = GTK_INSPECTOR_RECORDER (object);
+
+  g_clear_object (&recorder->recording);
+  g_array_unref (recorder->frame_marks);
+  g_ptr_array_unref (recorder->frame_recordings);
+  g_mutex_clear (&recorder->marks_lock);
+
+  G_OBJECT_CLASS (gtk_inspector_recorder_parent_class)->finalize (object);
+}
+
 static void
 gtk_inspector_recorder_class_init (GtkInspectorRecorderClass *klass)
 {
@@ -1395,6 +1655,7 @@ gtk_inspector_recorder_class_init (GtkInspectorRecorderClass *klass)
   object_class->get_property = gtk_inspector_recorder_get_property;
   object_class->set_property = gtk_inspector_recorder_set_property;
   object_class->dispose = gtk_inspector_recorder_dispose;
+  object_class->finalize = gtk_inspector_recorder_finalize;
 
   props[PROP_RECORDING] =
     g_param_spec_boolean ("recording",
@@ -1430,6 +1691,25 @@ gtk_inspector_recorder_class_init (GtkInspectorRecorderClass *klass)
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
 }
 
+static void
+clear_frame_span (gpointer data)
+{
+  GtkInspectorFrameSpan *span = data;
+
+  g_free (span->message);
+}
+
+static GArray *
+frame_marks_new (void)
+{
+  GArray *marks;
+
+  marks = g_array_new (FALSE, FALSE, sizeof (GtkInspectorFrameSpan));
+  g_array_set_clear_func (marks, clear_frame_span);
+
+  return marks;
+}
+
 static void
 gtk_inspector_recorder_init (GtkInspectorRecorder *recorder)
 {
@@ -1437,6 +1717,10 @@ gtk_inspector_recorder_init (GtkInspectorRecorder *recorder)
 
   gtk_widget_init_template (GTK_WIDGET (recorder));
 
+  g_mutex_init (&recorder->marks_lock);
+  recorder->frame_marks = frame_marks_new ();
+  recorder->frame_recordings = g_ptr_array_new_with_free_func (g_object_unref);
+
   gtk_list_box_bind_model (GTK_LIST_BOX (recorder->recordings_list),
                            recorder->recordings,
                            gtk_inspector_recorder_recordings_list_create_widget,
@@ -1473,6 +1757,103 @@ gtk_inspector_recorder_add_recording (GtkInspectorRecorder  *recorder,
   g_list_store_append (G_LIST_STORE (recorder->recordings), recording);
 }
 
+static int
+compare_frame_spans (gconstpointer a,
+                     gconstpointer b)
+{
+  const GtkInspectorFrameSpan *sa = a;
+  const GtkInspectorFrameSpan *sb = b;
+
+  if (sa->start != sb->start)
+    return sa->start < sb->start ? -1 : 1;
+
+  /* Outer spans first */
+  if (sa->duration != sb->duration)
+    return sa->duration > sb->duration ? -1 : 1;
+
+  return 0;
+}
+
+/* Hands the marks collected since the last frame to the render
+ * recordings of that frame and shows them.
+ */
+static void
+gtk_inspector_recorder_finish_frame (GtkInspectorRecorder *recorder)
+{
+  GArray *marks;
+  GArray *ends;
+  gint64 origin;
+  guint i;
+
+  g_mutex_lock (&recorder->marks_lock);
+  marks = recorder->frame_marks;
+  recorder->frame_marks = frame_marks_new ();
+  g_mutex_unlock (&recorder->marks_lock);
+
+  if (recorder->frame_recordings->len == 0)
+    {
+      g_array_unref (marks);
+      return;
+    }
+
+  g_array_sort (marks, compare_frame_spans);
+
+  origin = marks->len > 0 ? g_array_index (marks, GtkInspectorFrameSpan, 0).start : 0;
+  ends = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  for (i = 0; i < marks->len; i++)
+    {
+      GtkInspectorFrameSpan *span = &g_array_index (marks, GtkInspectorFrameSpan, i);
+      gint64 end = span->start + span->duration;
+
+      while (ends->len > 0 && g_array_index (ends, gint64, ends->len - 1) <= span->start)
+        g_array_set_size (ends, ends->len - 1);
+
+      span->depth = ends->len;
+      g_array_append_val (ends, end);
+
+      span->start -= origin;
+    }
+
+  g_array_unref (ends);
+
+  for (i = 0; i < recorder->frame_recordings->len; i++)
+    {
+      GtkInspectorRenderRecording *recording = g_ptr_array_index (recorder->frame_recordings, i);
+
+      gtk_inspector_render_recording_set_frame_spans (recording, marks);
+      gtk_inspector_recorder_add_recording (recorder, GTK_INSPECTOR_RECORDING (recording));
+    }
+
+  g_ptr_array_set_size (recorder->frame_recordings, 0);
+  g_array_unref (marks);
+}
+
+static void
+gtk_inspector_recorder_add_mark (gint64      begin_time,
+                                 gint64      duration,
+                                 const char *name,
+                                 const char *message,
+                                 gpointer    user_data)
+{
+  GtkInspectorRecorder *recorder = user_data;
+  GtkInspectorFrameSpan span;
+
+  span.name = g_intern_string (name);
+  span.message = g_strdup (message);
+  span.start = begin_time;
+  span.duration = duration;
+  span.depth = 0;
+
+  g_mutex_lock (&recorder->marks_lock);
+  g_array_append_val (recorder->frame_marks, span);
+  g_mutex_unlock (&recorder->marks_lock);
+
+  /* Emitted on the main thread once everything else in the frame is done */
+  if (strcmp (name, "frameclock cycle") == 0)
+    gtk_inspector_recorder_finish_frame (recorder);
+}
+
 void
 gtk_inspector_recorder_set_recording (GtkInspectorRecorder *recorder,
                                       gboolean              recording)
@@ -1484,9 +1865,12 @@ gtk_inspector_recorder_set_recording (GtkInspectorRecorder *recorder,
     {
       recorder->recording = gtk_inspector_start_recording_new ();
       gtk_inspector_recorder_add_recording (recorder, recorder->recording);
+      gdk_profiler_set_mark_func (gtk_inspector_recorder_add_mark, recorder);
     }
   else
     {
+      gtk_inspector_recorder_finish_frame (recorder);
+      gdk_profiler_set_mark_func (NULL, NULL);
       g_clear_object (&recorder->recording);
     }
 
@@ -1522,8 +1906,9 @@ gtk_inspector_recorder_record_render (GtkInspectorRecorder *recorder,
                                                     gdk_surface_get_height (surface) },
                                                   region,
                                                   node);
-  gtk_inspector_recorder_add_recording (recorder, recording);
-  g_object_unref (recording);
+
+  /* Shown once the frame is done and its marks are in */
+  g_ptr_array_add (recorder->frame_recordings, recording);
 }
 
 void
@@ -17,9 +17,12 @@
 
 #include "config.h"
 #include <glib/gi18n-lib.h>
+#include <string.h>
 
 #include "renderrecording.h"
 
+#include "gsk/gskrendernodestatsprivate.h"
+
 G_DEFINE_TYPE (GtkInspectorRenderRecording, gtk_inspector_render_recording, GTK_TYPE_INSPECTOR_RECORDING)
 
 static void
@@ -30,6 +33,10 @@ gtk_inspector_render_recording_finalize (GObject *object)
   g_clear_pointer (&recording->clip_region, cairo_region_destroy);
   g_clear_pointer (&recording->node, gsk_render_node_unref);
   g_clear_pointer (&recording->profiler_info, g_free);
+  g_clear_pointer (&recording->gpu_spans, g_array_unref);
+  g_clear_pointer (&recording->frame_spans, g_array_unref);
+  g_clear_pointer (&recording->frame_info, g_free);
+  g_clear_pointer (&recording->node_info, g_free);
 
   G_OBJECT_CLASS (gtk_inspector_render_recording_parent_class)->finalize (object);
 }
@@ -51,12 +58,33 @@ static void
 collect_profiler_info (GtkInspectorRenderRecording *recording,
                        GskProfiler                 *profiler)
 {
+  const GskProfilerGpuSpan *spans;
   GString *string;
+  guint n_spans;
 
   string = g_string_new (NULL);
   gsk_profiler_append_timers (profiler, string);
   gsk_profiler_append_counters (profiler, string);
+  gsk_profiler_append_gpu_spans (profiler, string);
   recording->profiler_info = g_string_free (string, FALSE);
+
+  spans = gsk_profiler_get_gpu_spans (profiler, &n_spans);
+  recording->gpu_spans = g_array_sized_new (FALSE, FALSE, sizeof (GskProfilerGpuSpan), n_spans);
+  g_array_append_vals (recording->gpu_spans, spans, n_spans);
+}
+
+static void
+collect_node_info (GtkInspectorRenderRecording *recording,
+                   GskRenderNode               *node)
+{
+  GskRenderNodeStats stats;
+  GString *string;
+
+  gsk_render_node_get_stats (node, &stats);
+
+  string = g_string_new (NULL);
+  gsk_render_node_stats_print (&stats, string);
+  recording->node_info = g_string_free (string, FALSE);
 }
 
 GtkInspectorRecording *
@@ -76,6 +104,7 @@ gtk_inspector_render_recording_new (gint64                timestamp,
   recording->area = *area;
   recording->clip_region = cairo_region_copy (clip_region);
   recording->node = gsk_render_node_ref (node);
+  collect_node_info (recording, node);
 
   return GTK_INSPECTOR_RECORDING (recording);
 }
@@ -104,4 +133,188 @@ gtk_inspector_render_recording_get_profiler_info (GtkInspectorRenderRecording *r
   return recording->profiler_info;
 }
 
+const GskProfilerGpuSpan *
+gtk_inspector_render_recording_get_gpu_spans (GtkInspectorRenderRecording *recording,
+                                              guint                       *n_spans)
+{
+  *n_spans = recording->gpu_spans->len;
+
+  return (const GskProfilerGpuSpan *) recording->gpu_spans->data;
+}
+
+typedef struct
+{
+  const char *message;
+  gint64 self_time;
+} WidgetTime;
+
+static int
+compare_widget_times (gconstpointer a,
+                      gconstpointer b)
+{
+  const WidgetTime *wa = a;
+  const WidgetTime *wb = b;
+
+  if (wa->self_time > wb->self_time)
+    return -1;
+  if (wa->self_time < wb->self_time)
+    return 1;
+
+  return 0;
+}
+
+#define N_SLOWEST_WIDGETS 10
+
+/* Sums up the time of each phase of the frame, counting nested
+ * marks of the same phase once, and finds the widgets that took
+ * longest to snapshot, not counting their children.
+ */
+static char *
+collect_frame_info (GArray *spans)
+{
+  GString *string;
+  GArray *phases;
+  GArray *widgets;
+  GArray *parents;
+  guint i, j;
+
+  string = g_string_new (NULL);
+  phases = g_array_new (FALSE, TRUE, sizeof (WidgetTime));
+  widgets = g_array_new (FALSE, TRUE, sizeof (WidgetTime));
+  parents = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (i = 0; i < spans->len; i++)
+    {
+      const GtkInspectorFrameSpan *span = &g_array_index (spans, GtkInspectorFrameSpan, i);
+      gboolean nested = FALSE;
+
+      g_array_set_size (parents, span->depth);
+      g_array_append_val (parents, i);
+
+      for (j = 0; j < span->depth; j++)
+        {
+          const GtkInspectorFrameSpan *parent = &g_array_index (spans, GtkInspectorFrameSpan, g_array_index (parents, guint, j));
+
+          if (parent->name == span->name)
+            nested = TRUE;
+        }
+
+      if (!nested)
+        {
+          WidgetTime *phase = NULL;
+
+          for (j = 0; j < phases->len; j++)
+            {
+              if (g_array_index (phases, WidgetTime, j).message == span->name)
+                phase = &g_array_index (phases, WidgetTime, j);
+            }
+
+          if (phase == NULL)
+            {
+              g_array_set_size (phases, phases->len + 1);
+              phase = &g_array_index (phases, WidgetTime, phases->len - 1);
+              phase->message = span->name;
+            }
+
+          phase->self_time += span->duration;
+        }
+
+      if (strcmp (span->name, "snapshot widget") == 0)
+        {
+          WidgetTime widget = { span->message, span->duration };
+
+          /* Take our time out of the closest widget containing us */
+          for (j = span->depth; j > 0; j--)
+            {
+              guint parent = g_array_index (parents, guint, j - 1);
+
+              if (g_array_index (spans, GtkInspectorFrameSpan, parent).name == span->name)
+                {
+                  guint k;
+
+                  for (k = 0; k < widgets->len; k++)
+                    {
+                      WidgetTime *w = &g_array_index (widgets, WidgetTime, k);
+
+                      if (w->message == g_array_index (spans, GtkInspectorFrameSpan, parent).message)
+                        w->self_time -= span->duration;
+                    }
+                  break;
+                }
+            }
+
+          g_array_append_val (widgets, widget);
+        }
+    }
+
+  if (phases->len > 0)
+    {
+      g_string_append (string, "Frame phases (usec):\n");
+      for (i = 0; i < phases->len; i++)
+        {
+          const WidgetTime *phase = &g_array_index (phases, WidgetTime, i);
+
+          g_string_append_printf (string, "  %s: %.2f\n", phase->message, phase->self_time / 1000.0);
+        }
+    }
+
+  if (widgets->len > 0)
+    {
+      g_array_sort (widgets, compare_widget_times);
+
+      g_string_append (string, "Slowest widget snapshots (usec, without children):\n");
+      for (i = 0; i < MIN (widgets->len, N_SLOWEST_WIDGETS); i++)
+        {
+          const WidgetTime *widget = &g_array_index (widgets, WidgetTime, i);
+
+          g_string_append_printf (string, "  %s: %.2f\n", widget->message, widget->self_time / 1000.0);
+        }
+    }
+
+  g_array_unref (parents);
+  g_array_unref (widgets);
+  g_array_unref (phases);
+
+  return g_string_free (string, FALSE);
+}
+
+/* @spans are sorted by start, with their depth set */
+void
+gtk_inspector_render_recording_set_frame_spans (GtkInspectorRenderRecording *recording,
+                                                GArray                      *spans)
+{
+  g_clear_pointer (&recording->frame_spans, g_array_unref);
+  g_clear_pointer (&recording->frame_info, g_free);
+
+  recording->frame_spans = g_array_ref (spans);
+  recording->frame_info = collect_frame_info (spans);
+}
+
+const GtkInspectorFrameSpan *
+gtk_inspector_render_recording_get_frame_spans (GtkInspectorRenderRecording *recording,
+                                                guint                       *n_spans)
+{
+  if (recording->frame_spans == NULL)
+    {
+      *n_spans = 0;
+      return NULL;
+    }
+
+  *n_spans = recording->frame_spans->len;
+
+  return (const GtkInspectorFrameSpan *) recording->frame_spans->data;
+}
+
+const char *
+gtk_inspector_render_recording_get_frame_info (GtkInspectorRenderRecording *recording)
+{
+  return recording->frame_info ? recording->frame_info : "";
+}
+
+const char *
+gtk_inspector_render_recording_get_node_info (GtkInspectorRenderRecording *recording)
+{
+  return recording->node_info;
+}
+
 // vim: set et sw=2 ts=2:
@@ -36,6 +36,18 @@ G_BEGIN_DECLS
 
 typedef struct _GtkInspectorRenderRecordingPrivate GtkInspectorRenderRecordingPrivate;
 
+/* A profiler mark of the frame that a recording was made in,
+ * with its start in nanoseconds since the first mark
+ */
+typedef struct
+{
+  const char *name; /* interned */
+  char *message;
+  gint64 start;
+  gint64 duration;
+  guint depth;
+} GtkInspectorFrameSpan;
+
 typedef struct _GtkInspectorRenderRecording
 {
   GtkInspectorRecording parent;
@@ -44,6 +56,10 @@ typedef struct _GtkInspectorRenderRecording
   cairo_region_t *clip_region;
   GskRenderNode *node;
   char *profiler_info;
+  GArray *gpu_spans;
+  GArray *frame_spans;
+  char *frame_info;
+  char *node_info;
 } GtkInspectorRenderRecording;
 
 typedef struct _GtkInspectorRenderRecordingClass
@@ -67,6 +83,20 @@ const cairo_rectangle_int_t *
                 gtk_inspector_render_recording_get_area      (GtkInspectorRenderRecording       *recording);
 const char *    gtk_inspector_render_recording_get_profiler_info
                                                              (GtkInspectorRenderRecording       *recording);
+const GskProfilerGpuSpan *
+                gtk_inspector_render_recording_get_gpu_spans (GtkInspectorRenderRecording       *recording,
+                                                              guint                             *n_spans);
+void            gtk_inspector_render_recording_set_frame_spans
+                                                             (GtkInspectorRenderRecording       *recording,
+                                                              GArray                            *spans);
+const GtkInspectorFrameSpan *
+                gtk_inspector_render_recording_get_frame_spans
+                                                             (GtkInspectorRenderRecording       *recording,
+                                                              guint                             *n_spans);
+const char *    gtk_inspector_render_recording_get_frame_info
+                                                             (GtkInspectorRenderRecording       *recording);
+const char *    gtk_inspector_render_recording_get_node_info
+                                                             (GtkInspectorRenderRecording       *recording);
 
 
 G_END_DECLS
@@ -33,6 +33,8 @@
 #include "gtkmain.h"
 #include "gtkliststore.h"
 
+#include "gdk/gdkallocstatsprivate.h"
+
 #include <glib/gi18n-lib.h>
 
 enum
@@ -61,6 +63,7 @@ struct _GtkInspectorStatisticsPrivate
   guint update_source_id;
   GtkWidget *search_entry;
   GtkWidget *search_bar;
+  GtkWidget *alloc_stats;
 };
 
 typedef struct {
@@ -132,12 +135,45 @@ add_type_count (GtkInspectorStatistics *sl, GType type)
   return cumulative;
 }
 
+static void
+update_alloc_stats (GtkInspectorStatistics *sl)
+{
+  GString *text;
+  int i;
+
+  text = g_string_new ("");
+
+  for (i = 0; i < GDK_ALLOC_N_SUBSYSTEMS; i++)
+    {
+      GdkAllocStats stats;
+      char *bytes;
+
+      if (!gdk_alloc_stats_get (i, &stats))
+        break;
+
+      bytes = g_format_size (MAX (stats.live_bytes, 0));
+      if (text->len > 0)
+        g_string_append_c (text, '\n');
+      g_string_append_printf (text, "%s: %" G_GSSIZE_FORMAT " live, %s (%" G_GSSIZE_FORMAT " allocated in total)",
+                              gdk_alloc_stats_get_name (i),
+                              stats.live, bytes, stats.allocations);
+      g_free (bytes);
+    }
+
+  gtk_label_set_text (GTK_LABEL (sl->priv->alloc_stats), text->str);
+  gtk_widget_set_visible (sl->priv->alloc_stats, text->len > 0);
+
+  g_string_free (text, TRUE);
+}
+
 static gboolean
 update_type_counts (gpointer data)
 {
   GtkInspectorStatistics *sl = data;
   GType type;
 
+  update_alloc_stats (sl);
+
   for (type = G_TYPE_INTERFACE; type <= G_TYPE_FUNDAMENTAL_MAX; type += (1 << G_TYPE_FUNDAMENTAL_SHIFT))
     {
       if (!G_TYPE_IS_INSTANTIATABLE (type))
@@ -384,6 +420,14 @@ gtk_inspector_statistics_init (GtkInspectorStatistics *sl)
   gtk_tree_view_set_search_equal_func (sl->priv->view, match_row, sl, NULL);
 }
 
+static gboolean
+has_alloc_stats (void)
+{
+  GdkAllocStats stats;
+
+  return gdk_alloc_stats_get (GDK_ALLOC_CSS_VALUE, &stats);
+}
+
 static void
 constructed (GObject *object)
 {
@@ -399,7 +443,12 @@ constructed (GObject *object)
       if (instance_counts_enabled ())
         gtk_label_set_text (GTK_LABEL (sl->priv->excuse), _("GLib must be configured with -Dbuildtype=debug"));
       gtk_stack_set_visible_child_name (GTK_STACK (sl->priv->stack), "excuse");
-      gtk_widget_set_sensitive (sl->priv->button, FALSE);
+
+      /* The allocation counters don't need GObject instance counts */
+      if (has_alloc_stats ())
+        update_alloc_stats (sl);
+      else
+        gtk_widget_set_sensitive (sl->priv->button, FALSE);
     }
 }
 
@@ -489,6 +538,7 @@ gtk_inspector_statistics_class_init (GtkInspectorStatisticsClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_entry);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_bar);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, excuse);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, alloc_stats);
 
 }
 
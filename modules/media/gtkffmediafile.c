@@ -52,10 +52,10 @@ struct _GtkFfMediaFile
   enum AVPixelFormat sws_pix_fmt;
   GdkMemoryFormat memory_format;
 
-  GtkVideoFrameFFMpeg current_frame;
+  GtkVideoFrameFFMpeg current_frame; /* last frame queued on the stream */
   GtkVideoFrameFFMpeg next_frame;
 
-  gint64 start_time; /* monotonic time when we displayed the last frame */
+  gint64 start_time; /* monotonic time of timestamp 0 */
   guint next_frame_cb; /* Source ID of next frame callback */
 };
 
@@ -101,20 +101,21 @@ gtk_ff_media_file_paintable_snapshot (GdkPaintable *paintable,
                                       double        width,
                                       double        height)
 {
-  GtkFfMediaFile *video = GTK_FF_MEDIA_FILE (paintable);
+  GdkPaintable *frame;
 
-  if (!gtk_video_frame_ffmpeg_is_empty (&video->current_frame))
-    {
-      gdk_paintable_snapshot (GDK_PAINTABLE (video->current_frame.texture), snapshot, width, height);
-    }
+  frame = gtk_media_stream_get_current_frame (GTK_MEDIA_STREAM (paintable));
+  if (frame)
+    gdk_paintable_snapshot (frame, snapshot, width, height);
 }
 
 static GdkPaintable *
 gtk_ff_media_file_paintable_get_current_image (GdkPaintable *paintable)
 {
   GtkFfMediaFile *video = GTK_FF_MEDIA_FILE (paintable);
+  GdkPaintable *frame;
 
-  if (gtk_video_frame_ffmpeg_is_empty (&video->current_frame))
+  frame = gtk_media_stream_get_current_frame (GTK_MEDIA_STREAM (paintable));
+  if (frame == NULL)
     {
       if (video->codec_ctx)
         return gdk_paintable_new_empty (video->codec_ctx->width, video->codec_ctx->height);
@@ -122,7 +123,7 @@ gtk_ff_media_file_paintable_get_current_image (GdkPaintable *paintable)
         return gdk_paintable_new_empty (0, 0);
     }
 
-  return GDK_PAINTABLE (g_object_ref (video->current_frame.texture));
+  return g_object_ref (frame);
 }
 
 static int
@@ -564,7 +565,9 @@ gtk_ff_media_file_open (GtkMediaFile *file)
   gdk_paintable_invalidate_size (GDK_PAINTABLE (video));
 
   if (gtk_ff_media_file_decode_frame (video, &video->current_frame))
-    gdk_paintable_invalidate_contents (GDK_PAINTABLE (video));
+    gtk_media_stream_queue_frame (GTK_MEDIA_STREAM (video),
+                                  GDK_PAINTABLE (video->current_frame.texture),
+                                  g_get_monotonic_time ());
 
   if (gtk_media_stream_get_playing (GTK_MEDIA_STREAM (video)))
     gtk_ff_media_file_play (GTK_MEDIA_STREAM (video));
@@ -584,12 +587,16 @@ gtk_ff_media_file_close (GtkMediaFile *file)
   gtk_video_frame_ffmpeg_clear (&video->next_frame);
   gtk_video_frame_ffmpeg_clear (&video->current_frame);
 
+  gtk_media_stream_clear_frames (GTK_MEDIA_STREAM (video));
   gdk_paintable_invalidate_size (GDK_PAINTABLE (video));
-  gdk_paintable_invalidate_contents (GDK_PAINTABLE (video));
 }
 
 static gboolean
 gtk_ff_media_file_next_frame_cb (gpointer data);
+
+/* Frames are queued on the stream one frame ahead, so we wake up
+ * when the last queued frame is due and queue the one after it.
+ */
 static void
 gtk_ff_media_file_queue_frame (GtkFfMediaFile *video)
 {
@@ -597,7 +604,10 @@ gtk_ff_media_file_queue_frame (GtkFfMediaFile *video)
   guint delay;
 
   time = g_get_monotonic_time ();
-  frame_time = video->start_time + video->next_frame.timestamp;
+  if (gtk_video_frame_ffmpeg_is_empty (&video->current_frame))
+    frame_time = time;
+  else
+    frame_time = video->start_time + video->current_frame.timestamp;
   delay = time > frame_time ? 0 : (frame_time - time) / 1000;
 
   video->next_frame_cb = g_timeout_add (delay, gtk_ff_media_file_next_frame_cb, video);
@@ -627,6 +637,10 @@ gtk_ff_media_file_next_frame_cb (gpointer data)
 
   video->next_frame_cb = 0;
 
+  if (!gtk_video_frame_ffmpeg_is_empty (&video->current_frame))
+    gtk_media_stream_update (GTK_MEDIA_STREAM (video),
+                             video->current_frame.timestamp);
+
   if (gtk_video_frame_ffmpeg_is_empty (&video->next_frame))
     {
       if (!gtk_media_stream_get_loop (GTK_MEDIA_STREAM (video)) ||
@@ -643,9 +657,9 @@ gtk_ff_media_file_next_frame_cb (gpointer data)
   gtk_video_frame_ffmpeg_move (&video->current_frame,
                                &video->next_frame);
 
-  gtk_media_stream_update (GTK_MEDIA_STREAM (video),
-                           video->current_frame.timestamp);
-  gdk_paintable_invalidate_contents (GDK_PAINTABLE (video));
+  gtk_media_stream_queue_frame (GTK_MEDIA_STREAM (video),
+                                GDK_PAINTABLE (video->current_frame.texture),
+                                video->start_time + video->current_frame.timestamp);
 
   /* ignore failure here, we'll handle the empty frame case above
    * the next time we're called. */
@@ -671,6 +685,7 @@ gtk_ff_media_file_play (GtkMediaStream *stream)
     {
       if (gtk_ff_media_file_restart (video))
         {
+          gtk_video_frame_ffmpeg_clear (&video->current_frame);
           video->start_time = g_get_monotonic_time () - video->next_frame.timestamp;
         }
       else
@@ -726,8 +741,12 @@ gtk_ff_media_file_seek (GtkMediaStream *stream,
   gtk_video_frame_ffmpeg_clear (&video->next_frame);
   gtk_video_frame_ffmpeg_clear (&video->current_frame);
   if (gtk_ff_media_file_decode_frame (video, &video->current_frame))
-    gtk_media_stream_update (stream, video->current_frame.timestamp);
-  gdk_paintable_invalidate_contents (GDK_PAINTABLE (video));
+    {
+      gtk_media_stream_update (stream, video->current_frame.timestamp);
+      gtk_media_stream_queue_frame (stream,
+                                    GDK_PAINTABLE (video->current_frame.texture),
+                                    g_get_monotonic_time ());
+    }
 
   if (gtk_media_stream_get_playing (stream))
     {
@@ -37,11 +37,22 @@ GST_DEBUG_CATEGORY (gtk_debug_gst_sink);
 
 #define FORMATS "{ BGRA, ARGB, RGBA, ABGR, RGB, BGR }"
 
+/* From drm_fourcc.h: use the layout the buffer was allocated with */
+#ifndef DRM_FORMAT_MOD_INVALID
+#define DRM_FORMAT_MOD_INVALID ((guint64) 0x00ffffffffffffffULL)
+#endif
+
+/* Only opaque formats, GDK wants premultiplied alpha in dmabufs */
+#define DMABUF_FORMATS "{ BGRx, RGBx }"
+
+/* Dmabufs go first, so decoders that can export them do so and
+ * the frames reach the GPU without being copied */
 static GstStaticPadTemplate gtk_gst_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (FORMATS))
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES (GST_CAPS_FEATURE_MEMORY_DMABUF, DMABUF_FORMATS) "; "
+                     GST_VIDEO_CAPS_MAKE (FORMATS))
     );
 
 G_DEFINE_TYPE_WITH_CODE (GtkGstSink, gtk_gst_sink,
@@ -85,6 +96,9 @@ gtk_gst_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
   if (!gst_video_info_from_caps (&self->v_info, caps))
     return FALSE;
 
+  self->use_dmabuf = gst_caps_features_contains (gst_caps_get_features (caps, 0),
+                                                 GST_CAPS_FEATURE_MEMORY_DMABUF);
+
   return TRUE;
 }
 
@@ -111,6 +125,64 @@ gtk_gst_memory_format_from_video (GstVideoFormat format)
   }
 }
 
+static guint32
+gtk_gst_drm_fourcc_from_video (GstVideoFormat format)
+{
+  switch ((guint) format)
+  {
+    case GST_VIDEO_FORMAT_BGRx:
+      return GST_MAKE_FOURCC ('X', 'R', '2', '4');
+    case GST_VIDEO_FORMAT_RGBx:
+      return GST_MAKE_FOURCC ('X', 'B', '2', '4');
+    default:
+      g_assert_not_reached ();
+      return 0;
+  }
+}
+
+static GdkTexture *
+gtk_gst_sink_texture_from_dmabuf (GtkGstSink *self,
+                                  GstBuffer  *buffer)
+{
+  GstVideoMeta *meta;
+  GstMemory *memory;
+  guint offset, stride;
+  int fd;
+
+  if (gst_buffer_n_memory (buffer) != 1)
+    return NULL;
+
+  memory = gst_buffer_peek_memory (buffer, 0);
+  if (!gst_is_dmabuf_memory (memory))
+    return NULL;
+
+  fd = gst_dmabuf_memory_get_fd (memory);
+
+  meta = gst_buffer_get_video_meta (buffer);
+  if (meta)
+    {
+      offset = meta->offset[0];
+      stride = meta->stride[0];
+    }
+  else
+    {
+      offset = GST_VIDEO_INFO_PLANE_OFFSET (&self->v_info, 0);
+      stride = GST_VIDEO_INFO_PLANE_STRIDE (&self->v_info, 0);
+    }
+
+  /* The buffer keeps the fd open as long as the texture uses it */
+  return gdk_dmabuf_texture_new (GST_VIDEO_INFO_WIDTH (&self->v_info),
+                                 GST_VIDEO_INFO_HEIGHT (&self->v_info),
+                                 gtk_gst_drm_fourcc_from_video (GST_VIDEO_INFO_FORMAT (&self->v_info)),
+                                 DRM_FORMAT_MOD_INVALID,
+                                 1,
+                                 &fd,
+                                 (guint[1]) { memory->offset + offset },
+                                 &stride,
+                                 (GDestroyNotify) gst_buffer_unref,
+                                 gst_buffer_ref (buffer));
+}
+
 static GdkTexture *
 gtk_gst_sink_texture_from_buffer (GtkGstSink *self,
                                   GstBuffer  *buffer)
@@ -119,6 +191,15 @@ gtk_gst_sink_texture_from_buffer (GtkGstSink *self,
   GdkTexture *texture;
   GBytes *bytes;
 
+  if (self->use_dmabuf)
+    {
+      texture = gtk_gst_sink_texture_from_dmabuf (self, buffer);
+      if (texture == NULL)
+        GST_WARNING ("Dropping buffer %p without the negotiated dmabuf memory", buffer);
+
+      return texture;
+    }
+
   if (!gst_video_frame_map (&frame, &self->v_info, buffer, GST_MAP_READ))
     return NULL;
 
@@ -26,6 +26,7 @@
 #include <gst/gst.h>
 #include <gst/video/gstvideosink.h>
 #include <gst/video/video.h>
+#include <gst/allocators/gstdmabuf.h>
 
 #define GTK_TYPE_GST_SINK            (gtk_gst_sink_get_type())
 #define GTK_GST_SINK(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GTK_TYPE_GST_SINK,GtkGstSink))
@@ -46,6 +47,7 @@ struct _GtkGstSink
   GstVideoSink         parent;
 
   GstVideoInfo         v_info;
+  gboolean             use_dmabuf;
   GtkGstPaintable *    paintable;
 };
 
@@ -32,6 +32,8 @@ main (int argc, char **argv)
 
   surface = cairo_image_surface_create (CAIRO_FORMAT_A8, size, size);
 
+  g_print ("Using the %s implementation\n", gsk_cairo_blur_get_implementation ());
+
   cr = cairo_create (surface);
 
   /* We do everything three times, first two as warmup */
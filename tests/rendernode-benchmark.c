@@ -0,0 +1,253 @@
+/* Renders captured render node files offscreen with the available
+ * renderers and reports per-frame timings and renderer statistics.
+ *
+ * The statistics come from the renderer's profiler, so apart from
+ * the wall clock time they are only available in debug builds.
+ */
+
+#include <gtk/gtk.h>
+#include <string.h>
+#include <gsk/gskrendererprivate.h>
+#include <gsk/gl/gskglrenderer.h>
+#ifdef GDK_RENDERING_VULKAN
+#include <gsk/vulkan/gskvulkanrenderer.h>
+#endif
+
+static char **renderer_names = NULL;
+static int runs = 100;
+static int warmup = 5;
+
+static GOptionEntry options[] = {
+  { "renderer", 'r', 0, G_OPTION_ARG_STRING_ARRAY, &renderer_names, "Renderer to use (cairo, opengl or vulkan), can be repeated", "RENDERER" },
+  { "runs", 'n', 0, G_OPTION_ARG_INT, &runs, "Render each node N times", "N" },
+  { "warmup", 'w', 0, G_OPTION_ARG_INT, &warmup, "Render N times before measuring", "N" },
+  { NULL }
+};
+
+typedef struct {
+  gint64 total;
+  gint64 min;
+  gint64 max;
+} Stat;
+
+static void
+stat_add (GHashTable *stats,
+          const char *name,
+          gint64      value)
+{
+  Stat *stat;
+
+  stat = g_hash_table_lookup (stats, name);
+  if (stat == NULL)
+    {
+      stat = g_new (Stat, 1);
+      stat->total = 0;
+      stat->min = G_MAXINT64;
+      stat->max = G_MININT64;
+      g_hash_table_insert (stats, g_strdup (name), stat);
+    }
+
+  stat->total += value;
+  stat->min = MIN (stat->min, value);
+  stat->max = MAX (stat->max, value);
+}
+
+static void
+deserialize_error_func (const GtkCssSection *section,
+                        const GError        *error,
+                        gpointer             user_data)
+{
+  char *section_str = gtk_css_section_to_string (section);
+
+  g_warning ("Error at %s: %s", section_str, error->message);
+
+  g_free (section_str);
+}
+
+static GskRenderNode *
+load_node (const char *filename)
+{
+  GError *error = NULL;
+  GskRenderNode *node;
+  GBytes *bytes;
+  char *contents;
+  gsize len;
+
+  if (!g_file_get_contents (filename, &contents, &len, &error))
+    {
+      g_printerr ("Could not open node file: %s\n", error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  bytes = g_bytes_new_take (contents, len);
+  node = gsk_render_node_deserialize (bytes, deserialize_error_func, NULL);
+  g_bytes_unref (bytes);
+
+  return node;
+}
+
+static GskRenderer *
+create_renderer (const char *name)
+{
+  if (g_ascii_strcasecmp (name, "cairo") == 0)
+    return gsk_cairo_renderer_new ();
+  else if (g_ascii_strcasecmp (name, "opengl") == 0 ||
+           g_ascii_strcasecmp (name, "gl") == 0)
+    return gsk_gl_renderer_new ();
+#ifdef GDK_RENDERING_VULKAN
+  else if (g_ascii_strcasecmp (name, "vulkan") == 0)
+    return gsk_vulkan_renderer_new ();
+#endif
+
+  return NULL;
+}
+
+static void
+print_stats (GHashTable *stats)
+{
+  GList *names, *l;
+
+  names = g_list_sort (g_hash_table_get_keys (stats), (GCompareFunc) strcmp);
+
+  for (l = names; l; l = l->next)
+    {
+      const Stat *stat = g_hash_table_lookup (stats, l->data);
+
+      g_print ("  %-28s avg %12.2f  min %10" G_GINT64_FORMAT "  max %10" G_GINT64_FORMAT "\n",
+               (const char *) l->data,
+               (double) stat->total / runs,
+               stat->min,
+               stat->max);
+    }
+
+  g_list_free (names);
+}
+
+static void
+benchmark_node (GskRenderNode *node,
+                const char    *renderer_name,
+                GdkSurface    *surface)
+{
+  GskRenderer *renderer;
+  GError *error = NULL;
+  GHashTable *stats;
+  int run;
+
+  renderer = create_renderer (renderer_name);
+  if (renderer == NULL)
+    {
+      g_print ("%s: not available\n", renderer_name);
+      return;
+    }
+
+  if (!gsk_renderer_realize (renderer, surface, &error))
+    {
+      g_print ("%s: %s\n", renderer_name, error->message);
+      g_error_free (error);
+      g_object_unref (renderer);
+      return;
+    }
+
+  for (run = 0; run < warmup; run++)
+    g_object_unref (gsk_renderer_render_texture (renderer, node, NULL));
+
+  stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  for (run = 0; run < runs; run++)
+    {
+      GdkTexture *texture;
+      GVariant *values;
+      GVariantIter iter;
+      const char *name;
+      gint64 value;
+      gint64 start;
+
+      start = g_get_monotonic_time ();
+      texture = gsk_renderer_render_texture (renderer, node, NULL);
+      stat_add (stats, "wall-time", g_get_monotonic_time () - start);
+
+      values = g_variant_ref_sink (gsk_profiler_get_values (gsk_renderer_get_profiler (renderer)));
+      g_variant_iter_init (&iter, values);
+      while (g_variant_iter_next (&iter, "{&sx}", &name, &value))
+        stat_add (stats, name, value);
+      g_variant_unref (values);
+
+      g_object_unref (texture);
+    }
+
+  g_print ("%s (%s), %d runs, times in usec:\n", renderer_name, G_OBJECT_TYPE_NAME (renderer), runs);
+  print_stats (stats);
+
+  g_hash_table_unref (stats);
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *default_renderers[] = {
+    "cairo",
+    "opengl",
+#ifdef GDK_RENDERING_VULKAN
+    "vulkan",
+#endif
+    NULL
+  };
+  GOptionContext *context;
+  GError *error = NULL;
+  GdkSurface *surface;
+  int i, j;
+
+  context = g_option_context_new ("NODE-FILE…");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (argc < 2)
+    {
+      g_printerr ("Usage: %s [OPTIONS] NODE-FILE…\n", argv[0]);
+      return 1;
+    }
+
+  if (runs < 1 || warmup < 0)
+    {
+      g_printerr ("Number of runs must be at least 1.\n");
+      return 1;
+    }
+
+  gtk_init ();
+
+  if (renderer_names == NULL)
+    renderer_names = g_strdupv ((char **) default_renderers);
+
+  surface = gdk_surface_new_toplevel (gdk_display_get_default ());
+
+  for (i = 1; i < argc; i++)
+    {
+      GskRenderNode *node;
+
+      node = load_node (argv[i]);
+      if (node == NULL)
+        continue;
+
+      g_print ("%s\n", argv[i]);
+
+      for (j = 0; renderer_names[j]; j++)
+        benchmark_node (node, renderer_names[j], surface);
+
+      g_print ("\n");
+
+      gsk_render_node_unref (node);
+    }
+
+  gdk_surface_destroy (surface);
+  g_object_unref (surface);
+  g_strfreev (renderer_names);
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+/* Measures the transform operations renderers use a lot, on chains
+ * of the depth that nested widgets produce.
+ */
+
+#include <gtk/gtk.h>
+
+static int depth = 32;
+static int runs = 100000;
+
+static GOptionEntry options[] = {
+  { "depth", 'd', 0, G_OPTION_ARG_INT, &depth, "Build chains of N steps", "N" },
+  { "runs", 'n', 0, G_OPTION_ARG_INT, &runs, "Run each operation N times", "N" },
+  { NULL }
+};
+
+static GskTransform *
+build_chain (gboolean with_rotation)
+{
+  GskTransform *transform = NULL;
+  int i;
+
+  /* Consecutive translations get merged, so alternate them with
+   * something else to get a deep chain.
+   */
+  for (i = 0; i < depth; i++)
+    {
+      if (i % 2 == 0)
+        transform = gsk_transform_translate (transform, &GRAPHENE_POINT_INIT (i, 2 * i));
+      else if (with_rotation)
+        transform = gsk_transform_rotate (transform, 90);
+      else
+        transform = gsk_transform_scale (transform, 1.5, 1.5);
+    }
+
+  return transform;
+}
+
+static void
+report (const char *name,
+        gint64      start)
+{
+  g_print ("  %-24s %8.1f ns\n",
+           name,
+           (g_get_monotonic_time () - start) * 1000.0 / runs);
+}
+
+static void
+benchmark_chain (const char   *name,
+                 GskTransform *transform)
+{
+  graphene_matrix_t matrix;
+  graphene_rect_t bounds;
+  float a, b, c, d;
+  gint64 start;
+  int i;
+
+  g_print ("%s, category %d:\n", name, gsk_transform_get_category (transform));
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < runs; i++)
+    gsk_transform_to_matrix (transform, &matrix);
+  report ("to_matrix", start);
+
+  if (gsk_transform_get_category (transform) >= GSK_TRANSFORM_CATEGORY_2D_AFFINE)
+    {
+      start = g_get_monotonic_time ();
+      for (i = 0; i < runs; i++)
+        gsk_transform_to_affine (transform, &a, &b, &c, &d);
+      report ("to_affine", start);
+    }
+
+  if (gsk_transform_get_category (transform) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+    {
+      start = g_get_monotonic_time ();
+      for (i = 0; i < runs; i++)
+        gsk_transform_to_translate (transform, &a, &b);
+      report ("to_translate", start);
+    }
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < runs; i++)
+    gsk_transform_transform_bounds (transform, &GRAPHENE_RECT_INIT (0, 0, 100, 100), &bounds);
+  report ("transform_bounds", start);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < runs; i++)
+    gsk_transform_unref (gsk_transform_translate (gsk_transform_ref (transform),
+                                                  &GRAPHENE_POINT_INIT (1, 1)));
+  report ("translate", start);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < runs; i++)
+    gsk_transform_unref (gsk_transform_scale (gsk_transform_ref (transform), 2, 2));
+  report ("scale", start);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GskTransform *transform;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (depth < 1 || runs < 1)
+    {
+      g_printerr ("Depth and number of runs must be at least 1.\n");
+      return 1;
+    }
+
+  transform = build_chain (FALSE);
+  benchmark_chain ("translations and scales", transform);
+  gsk_transform_unref (transform);
+
+  transform = build_chain (TRUE);
+  benchmark_chain ("translations and rotations", transform);
+  gsk_transform_unref (transform);
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../gtk/css/gtkcsstokenizerprivate.h"
+
+#include <locale.h>
+
+/* Checks that replaying a precompiled token stream gives the same
+ * tokens at the same locations as tokenizing the text */
+static void
+test_precompile (gconstpointer data)
+{
+  const char *path = data;
+  GtkCssTokenizer *text, *precompiled;
+  GBytes *bytes, *compiled;
+  GError *error = NULL;
+  char *contents;
+  gsize size;
+
+  g_file_get_contents (path, &contents, &size, &error);
+  g_assert_no_error (error);
+  bytes = g_bytes_new_take (contents, size);
+
+  compiled = gtk_css_tokenizer_precompile (bytes, &error);
+  if (compiled == NULL)
+    {
+      /* Only valid files can be precompiled */
+      g_test_skip (error->message);
+      g_error_free (error);
+      g_bytes_unref (bytes);
+      return;
+    }
+
+  g_assert_true (gtk_css_tokenizer_is_precompiled (compiled));
+  g_assert_false (gtk_css_tokenizer_is_precompiled (bytes));
+
+  text = gtk_css_tokenizer_new (bytes);
+  precompiled = gtk_css_tokenizer_new (compiled);
+
+  for (;;)
+    {
+      GtkCssToken expected, token;
+      const GtkCssLocation *l1, *l2;
+      char *s1, *s2;
+
+      g_assert_true (gtk_css_tokenizer_read_token (text, &expected, NULL));
+      g_assert_true (gtk_css_tokenizer_read_token (precompiled, &token, NULL));
+
+      s1 = gtk_css_token_to_string (&expected);
+      s2 = gtk_css_token_to_string (&token);
+      g_assert_cmpint (expected.type, ==, token.type);
+      g_assert_cmpstr (s1, ==, s2);
+      g_free (s1);
+      g_free (s2);
+
+      l1 = gtk_css_tokenizer_get_location (text);
+      l2 = gtk_css_tokenizer_get_location (precompiled);
+      g_assert_cmpmem (l1, sizeof (GtkCssLocation), l2, sizeof (GtkCssLocation));
+
+      if (gtk_css_token_is (&expected, GTK_CSS_TOKEN_EOF))
+        break;
+
+      gtk_css_token_clear (&expected);
+      gtk_css_token_clear (&token);
+    }
+
+  gtk_css_tokenizer_unref (text);
+  gtk_css_tokenizer_unref (precompiled);
+  g_bytes_unref (compiled);
+  g_bytes_unref (bytes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GDir *dir;
+  const char *name;
+  char *path;
+
+  g_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  path = g_test_build_filename (G_TEST_DIST, "parser", NULL);
+  dir = g_dir_open (path, 0, NULL);
+  g_assert_nonnull (dir);
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      char *test_name;
+
+      if (!g_str_has_suffix (name, ".css") || g_str_has_suffix (name, ".ref.css"))
+        continue;
+
+      test_name = g_strdup_printf ("/css/precompile/%s", name);
+      g_test_add_data_func_full (test_name,
+                                 g_build_filename (path, name, NULL),
+                                 test_precompile,
+                                 g_free);
+      g_free (test_name);
+    }
+
+  g_dir_close (dir);
+  g_free (path);
+
+  return g_test_run ();
+}
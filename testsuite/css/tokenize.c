@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2020 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../gtk/css/gtkcsstokenizerprivate.h"
+
+#include <locale.h>
+
+/* Tokenizes the stylesheet given on the commandline, by default the
+ * generated Adwaita theme. With -m perf, reports how many tokens per
+ * second are read from the text and from its precompiled form.
+ */
+
+#define PERF_RUNS 20
+
+static GBytes *
+load_stylesheet (const char *path)
+{
+  GError *error = NULL;
+  char *contents;
+  gsize size;
+
+  g_file_get_contents (path, &contents, &size, &error);
+  g_assert_no_error (error);
+
+  return g_bytes_new_take (contents, size);
+}
+
+static guint
+tokenize (GBytes *bytes)
+{
+  GtkCssTokenizer *tokenizer;
+  GtkCssToken token;
+  GError *error = NULL;
+  guint n_tokens = 0;
+
+  tokenizer = gtk_css_tokenizer_new (bytes);
+
+  for (;;)
+    {
+      gboolean ok;
+
+      ok = gtk_css_tokenizer_read_token (tokenizer, &token, &error);
+      g_assert_no_error (error);
+      g_assert_true (ok);
+
+      if (gtk_css_token_is (&token, GTK_CSS_TOKEN_EOF))
+        break;
+
+      n_tokens++;
+      gtk_css_token_clear (&token);
+    }
+
+  gtk_css_tokenizer_unref (tokenizer);
+
+  return n_tokens;
+}
+
+static void
+test_tokenize (gconstpointer data)
+{
+  GBytes *bytes, *compiled;
+  GError *error = NULL;
+
+  bytes = load_stylesheet (data);
+  compiled = gtk_css_tokenizer_precompile (bytes, &error);
+  g_assert_no_error (error);
+
+  g_assert_cmpuint (tokenize (bytes), >, 0);
+  g_assert_cmpuint (tokenize (bytes), ==, tokenize (compiled));
+
+  g_bytes_unref (compiled);
+  g_bytes_unref (bytes);
+}
+
+static void
+test_tokenize_perf (gconstpointer data)
+{
+  GBytes *bytes, *compiled;
+  GError *error = NULL;
+  double text, precompiled;
+  guint n_tokens = 0;
+  int i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  bytes = load_stylesheet (data);
+  compiled = gtk_css_tokenizer_precompile (bytes, &error);
+  g_assert_no_error (error);
+
+  g_test_timer_start ();
+  for (i = 0; i < PERF_RUNS; i++)
+    n_tokens = tokenize (bytes);
+  text = g_test_timer_elapsed () / PERF_RUNS;
+
+  g_test_timer_start ();
+  for (i = 0; i < PERF_RUNS; i++)
+    tokenize (compiled);
+  precompiled = g_test_timer_elapsed () / PERF_RUNS;
+
+  g_test_maximized_result (n_tokens / text,
+                           "%u tokens: %g tokens/s from text, %g tokens/s precompiled",
+                           n_tokens, n_tokens / text, n_tokens / precompiled);
+
+  g_bytes_unref (compiled);
+  g_bytes_unref (bytes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *path;
+
+  g_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  if (argc < 2)
+    {
+      g_printerr ("Usage: %s [OPTION...] STYLESHEET\n", argv[0]);
+      return 1;
+    }
+
+  path = argv[1];
+
+  g_test_add_data_func ("/css/tokenize/stylesheet", path, test_tokenize);
+  g_test_add_data_func ("/css/tokenize/perf", path, test_tokenize_perf);
+
+  return g_test_run ();
+}
@@ -70,6 +70,81 @@ test_clipboard_basic (void)
   g_value_unset (&value);
 }
 
+static void
+serialized (GObject      *source,
+            GAsyncResult *res,
+            gpointer      data)
+{
+  gboolean *done = data;
+  GError *error = NULL;
+
+  g_assert_true (gdk_content_serialize_finish (res, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+
+  g_main_context_wakeup (NULL);
+}
+
+static GBytes *
+serialize_texture (GdkTexture *texture,
+                   const char *mime_type)
+{
+  GOutputStream *stream;
+  GValue value = G_VALUE_INIT;
+  GBytes *bytes;
+  gboolean done;
+
+  stream = g_memory_output_stream_new_resizable ();
+  g_value_init (&value, GDK_TYPE_TEXTURE);
+  g_value_set_object (&value, texture);
+
+  done = FALSE;
+  gdk_content_serialize_async (stream, mime_type, &value,
+                               G_PRIORITY_DEFAULT, NULL,
+                               serialized, &done);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_output_stream_close (stream, NULL, NULL);
+  bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (stream));
+
+  g_value_unset (&value);
+  g_object_unref (stream);
+
+  return bytes;
+}
+
+static void
+test_clipboard_texture_serialize (void)
+{
+  GdkTexture *texture;
+  GBytes *bytes, *bytes2;
+  guchar *data;
+  int i;
+
+  data = g_malloc (64 * 64 * 4);
+  for (i = 0; i < 64 * 64 * 4; i++)
+    data[i] = i % 251;
+
+  bytes = g_bytes_new_take (data, 64 * 64 * 4);
+  texture = gdk_memory_texture_new (64, 64, GDK_MEMORY_DEFAULT, bytes, 64 * 4);
+  g_bytes_unref (bytes);
+
+  /* The second time around, the cached encoding is written */
+  bytes = serialize_texture (texture, "image/png");
+  bytes2 = serialize_texture (texture, "image/png");
+
+  g_assert_cmpuint (g_bytes_get_size (bytes), >, 8);
+  g_assert_true (g_bytes_equal (bytes, bytes2));
+  g_assert_cmpmem (g_bytes_get_data (bytes, NULL), 8, "\x89PNG\r\n\x1a\n", 8);
+
+  g_bytes_unref (bytes);
+  g_bytes_unref (bytes2);
+  g_object_unref (texture);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -78,6 +153,7 @@ main (int argc, char *argv[])
   gtk_init ();
 
   g_test_add_func ("/clipboard/basic", test_clipboard_basic);
+  g_test_add_func ("/clipboard/texture-serialize", test_clipboard_texture_serialize);
 
   return g_test_run ();
 }
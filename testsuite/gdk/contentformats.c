@@ -0,0 +1,106 @@
+#include <gtk/gtk.h>
+
+static GdkContentFormats *
+make_formats (const char *prefix,
+              guint       n_mime_types)
+{
+  GdkContentFormatsBuilder *builder;
+  guint i;
+
+  builder = gdk_content_formats_builder_new ();
+
+  for (i = 0; i < n_mime_types; i++)
+    {
+      char *mime_type = g_strdup_printf ("%s/type-%u", prefix, i);
+      gdk_content_formats_builder_add_mime_type (builder, mime_type);
+      g_free (mime_type);
+    }
+
+  return gdk_content_formats_builder_free_to_formats (builder);
+}
+
+static void
+test_contain_mime_type (void)
+{
+  GdkContentFormats *formats;
+  char *mime_type;
+  guint i;
+
+  formats = make_formats ("application", 100);
+
+  for (i = 0; i < 200; i++)
+    {
+      mime_type = g_strdup_printf ("application/type-%u", i);
+      g_assert_true (gdk_content_formats_contain_mime_type (formats, mime_type) == (i < 100));
+      g_free (mime_type);
+    }
+
+  g_assert_false (gdk_content_formats_contain_mime_type (formats, "text/plain"));
+  g_assert_false (gdk_content_formats_contain_gtype (formats, G_TYPE_STRING));
+
+  gdk_content_formats_unref (formats);
+}
+
+static void
+test_contain_gtype (void)
+{
+  GdkContentFormats *formats;
+
+  formats = gdk_content_formats_new_for_gtype (GDK_TYPE_TEXTURE);
+
+  g_assert_true (gdk_content_formats_contain_gtype (formats, GDK_TYPE_TEXTURE));
+  g_assert_false (gdk_content_formats_contain_gtype (formats, G_TYPE_STRING));
+  g_assert_false (gdk_content_formats_contain_gtype (formats, GDK_TYPE_RGBA));
+
+  gdk_content_formats_unref (formats);
+}
+
+static void
+test_match (void)
+{
+  GdkContentFormats *first, *second, *third;
+  const char *mime_types[] = { "text/plain", "image/type-7" };
+  guint i;
+
+  first = make_formats ("image", 50);
+  second = make_formats ("video", 50);
+  third = gdk_content_formats_new (mime_types, G_N_ELEMENTS (mime_types));
+
+  g_assert_false (gdk_content_formats_match (first, second));
+  g_assert_null (gdk_content_formats_match_mime_type (first, second));
+  g_assert_true (gdk_content_formats_match (first, third));
+  g_assert_cmpstr (gdk_content_formats_match_mime_type (third, first), ==, "image/type-7");
+
+  /* every prefix of a formats matches itself */
+  for (i = 1; i < 50; i++)
+    {
+      GdkContentFormats *prefix = make_formats ("image", i);
+
+      g_assert_true (gdk_content_formats_match (prefix, first));
+      g_assert_cmpstr (gdk_content_formats_match_mime_type (prefix, first), ==, "image/type-0");
+      g_assert_false (gdk_content_formats_match (prefix, second));
+
+      gdk_content_formats_unref (prefix);
+    }
+
+  second = gdk_content_formats_union (second, third);
+  g_assert_true (gdk_content_formats_match (first, second));
+  g_assert_true (gdk_content_formats_contain_mime_type (second, "video/type-49"));
+  g_assert_true (gdk_content_formats_contain_mime_type (second, "text/plain"));
+
+  gdk_content_formats_unref (first);
+  gdk_content_formats_unref (second);
+  gdk_content_formats_unref (third);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/contentformats/contain-mime-type", test_contain_mime_type);
+  g_test_add_func ("/contentformats/contain-gtype", test_contain_gtype);
+  g_test_add_func ("/contentformats/match", test_match);
+
+  return g_test_run ();
+}
@@ -0,0 +1,113 @@
+#include <string.h>
+#include <unistd.h>
+#include <gdk/gdk.h>
+
+/* Without a GPU, dmabuf textures are downloaded through a memory
+ * mapping. A plain file can stand in for the dmabuf for that. */
+
+#define FOURCC(a, b, c, d) ((guint32) (a) | ((guint32) (b) << 8) | \
+                            ((guint32) (c) << 16) | ((guint32) (d) << 24))
+
+#define DRM_FORMAT_MOD_LINEAR 0
+
+#define WIDTH 5
+#define HEIGHT 3
+#define STRIDE 32
+#define OFFSET 64
+
+typedef struct {
+  const char *name;
+  guint32 fourcc;
+  gsize bpp;
+  guchar pixel[4];  /* in memory order */
+  guint32 expected; /* as CAIRO_FORMAT_ARGB32 */
+} TestData;
+
+static const TestData tests[] = {
+  { "argb8888", FOURCC ('A', 'R', '2', '4'), 4, { 0x66, 0x22, 0x44, 0xAA }, 0xAA442266 },
+  { "xrgb8888", FOURCC ('X', 'R', '2', '4'), 4, { 0x66, 0x22, 0x44, 0x00 }, 0xFF442266 },
+  { "abgr8888", FOURCC ('A', 'B', '2', '4'), 4, { 0x44, 0x22, 0x66, 0xAA }, 0xAA442266 },
+  { "xbgr8888", FOURCC ('X', 'B', '2', '4'), 4, { 0x44, 0x22, 0x66, 0x12 }, 0xFF442266 },
+  { "bgra8888", FOURCC ('B', 'A', '2', '4'), 4, { 0xAA, 0x44, 0x22, 0x66 }, 0xAA442266 },
+  { "rgb888",   FOURCC ('R', 'G', '2', '4'), 3, { 0x66, 0x22, 0x44 },       0xFF442266 },
+  { "bgr888",   FOURCC ('B', 'G', '2', '4'), 3, { 0x44, 0x22, 0x66 },       0xFF442266 },
+};
+
+static int
+create_buffer (const TestData *test)
+{
+  guchar data[OFFSET + STRIDE * HEIGHT] = { 0, };
+  char *path;
+  int x, y, fd;
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      memcpy (data + OFFSET + y * STRIDE + x * test->bpp, test->pixel, test->bpp);
+
+  fd = g_file_open_tmp ("dmabuftexture-XXXXXX", &path, NULL);
+  g_assert_cmpint (fd, >=, 0);
+  unlink (path);
+  g_free (path);
+
+  g_assert_cmpint (write (fd, data, sizeof (data)), ==, sizeof (data));
+
+  return fd;
+}
+
+static void
+close_buffer (gpointer data)
+{
+  close (GPOINTER_TO_INT (data));
+}
+
+static void
+test_download (gconstpointer data)
+{
+  const TestData *test = data;
+  GdkTexture *texture;
+  guint32 pixels[WIDTH * HEIGHT];
+  guint offset = OFFSET, stride = STRIDE;
+  int fd, i;
+
+  g_assert_true (gdk_dmabuf_texture_is_supported_fourcc (test->fourcc));
+
+  fd = create_buffer (test);
+  texture = gdk_dmabuf_texture_new (WIDTH, HEIGHT,
+                                    test->fourcc, DRM_FORMAT_MOD_LINEAR,
+                                    1, &fd, &offset, &stride,
+                                    close_buffer, GINT_TO_POINTER (fd));
+
+  gdk_texture_download (texture, (guchar *) pixels, WIDTH * 4);
+
+  for (i = 0; i < WIDTH * HEIGHT; i++)
+    g_assert_cmphex (pixels[i], ==, test->expected);
+
+  g_object_unref (texture);
+}
+
+static void
+test_unsupported (void)
+{
+  /* NV12 needs a YUV conversion we don't do */
+  g_assert_false (gdk_dmabuf_texture_is_supported_fourcc (FOURCC ('N', 'V', '1', '2')));
+}
+
+int
+main (int argc, char *argv[])
+{
+  gsize i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      char *test_name = g_strdup_printf ("/dmabuftexture/download/%s", tests[i].name);
+
+      g_test_add_data_func (test_name, &tests[i], test_download);
+      g_free (test_name);
+    }
+
+  g_test_add_func ("/dmabuftexture/unsupported", test_unsupported);
+
+  return g_test_run ();
+}
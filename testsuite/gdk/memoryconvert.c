@@ -0,0 +1,197 @@
+#include <locale.h>
+#include <gdk/gdk.h>
+
+/* Checks the (possibly vectorized) conversions done when downloading
+ * memory textures against straightforward per-pixel loops, for all
+ * widths around the vector sizes. With -m perf, also compares their
+ * speed on a full HD image.
+ */
+
+typedef struct {
+  gsize bytes_per_pixel;
+  gboolean premultiplied;
+  int r, g, b, a;  /* byte offsets, -1 if the format has no alpha */
+} FormatInfo;
+
+/* The 8 bit formats; deep ones are covered by the memorytexture test */
+static const FormatInfo formats[] = {
+  { 4, TRUE,  2, 1, 0, 3 },
+  { 4, TRUE,  1, 2, 3, 0 },
+  { 4, TRUE,  0, 1, 2, 3 },
+  { 4, FALSE, 2, 1, 0, 3 },
+  { 4, FALSE, 1, 2, 3, 0 },
+  { 4, FALSE, 0, 1, 2, 3 },
+  { 4, FALSE, 3, 2, 1, 0 },
+  { 3, TRUE,  0, 1, 2, -1 },
+  { 3, TRUE,  2, 1, 0, -1 },
+};
+
+static inline guchar
+premultiply (guchar c,
+             guchar a)
+{
+  guint t = c * a + 0x80;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static void
+convert_reference (guchar          *dest_data,
+                   gsize            dest_stride,
+                   const guchar    *src_data,
+                   gsize            src_stride,
+                   GdkMemoryFormat  src_format,
+                   int              width,
+                   int              height)
+{
+  const FormatInfo *src = &formats[src_format];
+  const FormatInfo *dest = &formats[GDK_MEMORY_DEFAULT];
+  int x, y;
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          const guchar *s = src_data + y * src_stride + x * src->bytes_per_pixel;
+          guchar *d = dest_data + y * dest_stride + x * 4;
+          guchar a = src->a < 0 ? 0xFF : s[src->a];
+
+          if (src->premultiplied)
+            {
+              d[dest->r] = s[src->r];
+              d[dest->g] = s[src->g];
+              d[dest->b] = s[src->b];
+            }
+          else
+            {
+              d[dest->r] = premultiply (s[src->r], a);
+              d[dest->g] = premultiply (s[src->g], a);
+              d[dest->b] = premultiply (s[src->b], a);
+            }
+          d[dest->a] = a;
+        }
+    }
+}
+
+static GBytes *
+create_random_data (gsize size)
+{
+  guchar *data;
+  gsize i;
+
+  data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+
+  return g_bytes_new_take (data, size);
+}
+
+static void
+test_convert (gconstpointer data)
+{
+  GdkMemoryFormat format = GPOINTER_TO_UINT (data);
+  gsize bpp = formats[format].bytes_per_pixel;
+  int width, height = 3;
+
+  for (width = 1; width <= 40; width++)
+    {
+      /* An odd stride, so rows don't start aligned */
+      gsize stride = width * bpp + 3;
+      GBytes *bytes = create_random_data (stride * height);
+      GdkTexture *texture;
+      guchar *expected, *result;
+
+      texture = gdk_memory_texture_new (width, height, format, bytes, stride);
+
+      expected = g_malloc0 (width * height * 4);
+      convert_reference (expected, width * 4,
+                         g_bytes_get_data (bytes, NULL), stride,
+                         format, width, height);
+
+      result = g_malloc0 (width * height * 4);
+      gdk_texture_download (texture, result, width * 4);
+
+      g_assert_cmpmem (expected, width * height * 4, result, width * height * 4);
+
+      g_free (expected);
+      g_free (result);
+      g_object_unref (texture);
+      g_bytes_unref (bytes);
+    }
+}
+
+#define PERF_WIDTH 1920
+#define PERF_HEIGHT 1080
+#define PERF_RUNS 20
+
+static void
+test_convert_perf (gconstpointer data)
+{
+  GdkMemoryFormat format = GPOINTER_TO_UINT (data);
+  gsize stride = PERF_WIDTH * formats[format].bytes_per_pixel;
+  GBytes *bytes;
+  GdkTexture *texture;
+  guchar *result;
+  double reference, elapsed;
+  int i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  bytes = create_random_data (stride * PERF_HEIGHT);
+  texture = gdk_memory_texture_new (PERF_WIDTH, PERF_HEIGHT, format, bytes, stride);
+  result = g_malloc (PERF_WIDTH * PERF_HEIGHT * 4);
+
+  g_test_timer_start ();
+  for (i = 0; i < PERF_RUNS; i++)
+    convert_reference (result, PERF_WIDTH * 4,
+                       g_bytes_get_data (bytes, NULL), stride,
+                       format, PERF_WIDTH, PERF_HEIGHT);
+  reference = g_test_timer_elapsed () / PERF_RUNS;
+
+  g_test_timer_start ();
+  for (i = 0; i < PERF_RUNS; i++)
+    gdk_texture_download (texture, result, PERF_WIDTH * 4);
+  elapsed = g_test_timer_elapsed () / PERF_RUNS;
+
+  g_test_minimized_result (elapsed,
+                           "converting %dx%d: %gms, per-pixel loop: %gms",
+                           PERF_WIDTH, PERF_HEIGHT, elapsed * 1000, reference * 1000);
+
+  g_free (result);
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GdkMemoryFormat format;
+  GEnumClass *enum_class;
+
+  g_test_init (&argc, &argv, NULL);
+
+  enum_class = g_type_class_ref (GDK_TYPE_MEMORY_FORMAT);
+
+  for (format = 0; format < G_N_ELEMENTS (formats); format++)
+    {
+      char *test_name;
+
+      test_name = g_strdup_printf ("/memoryconvert/convert/%s",
+                                   g_enum_get_value (enum_class, format)->value_nick);
+      g_test_add_data_func (test_name, GUINT_TO_POINTER (format), test_convert);
+      g_free (test_name);
+
+      test_name = g_strdup_printf ("/memoryconvert/perf/%s",
+                                   g_enum_get_value (enum_class, format)->value_nick);
+      g_test_add_data_func (test_name, GUINT_TO_POINTER (format), test_convert_perf);
+      g_free (test_name);
+    }
+
+  g_type_class_unref (enum_class);
+
+  return g_test_run ();
+}
@@ -2,7 +2,7 @@
 #include <gdk/gdk.h>
 
 /* maximum bytes per pixel */
-#define MAX_BPP 4
+#define MAX_BPP 16
 
 typedef enum {
   BLUE,
@@ -34,6 +34,19 @@ typedef struct _TestData {
 
 #define RGBA(a, b, c, d) { 0x ## a, 0x ## b, 0x ## c, 0x ## d }
 
+/* Deep formats are in native endianness */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define U16(x) (0x ## x & 0xFF), (0x ## x >> 8)
+#define U32(x) (0x ## x & 0xFF), ((0x ## x >> 8) & 0xFF), ((0x ## x >> 16) & 0xFF), (0x ## x >> 24)
+#else
+#define U16(x) (0x ## x >> 8), (0x ## x & 0xFF)
+#define U32(x) (0x ## x >> 24), ((0x ## x >> 16) & 0xFF), ((0x ## x >> 8) & 0xFF), (0x ## x & 0xFF)
+#endif
+#define RGB16(a, b, c) { U16(a), U16(b), U16(c) }
+#define RGBA16(a, b, c, d) { U16(a), U16(b), U16(c), U16(d) }
+#define RGB32(a, b, c) { U32(a), U32(b), U32(c) }
+#define RGBA32(a, b, c, d) { U32(a), U32(b), U32(c), U32(d) }
+
 static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,00,00,FF), RGBA(00,FF,00,FF), RGBA(00,00,FF,FF), RGBA(00,00,00,00), RGBA(66,22,44,AA) } },
   { 4, FALSE, { RGBA(FF,00,00,FF), RGBA(FF,00,FF,00), RGBA(FF,FF,00,00), RGBA(00,00,00,00), RGBA(AA,44,22,66) } },
@@ -44,6 +57,12 @@ static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,FF,00,00), RGBA(FF,00,FF,00), RGBA(FF,00,00,FF), RGBA(00,00,00,00), RGBA(AA,99,33,66) } },
   { 3, TRUE,  { RGBA(00,00,FF,00), RGBA(00,FF,00,00), RGBA(FF,00,00,00), RGBA(00,00,00,00), RGBA(44,22,66,00) } },
   { 3, TRUE,  { RGBA(FF,00,00,00), RGBA(00,FF,00,00), RGBA(00,00,FF,00), RGBA(00,00,00,00), RGBA(66,22,44,00) } },
+  { 6, TRUE,  { RGB16(0000,0000,FFFF), RGB16(0000,FFFF,0000), RGB16(FFFF,0000,0000), RGB16(0000,0000,0000), RGB16(4444,2222,6666) } },
+  { 8, FALSE, { RGBA16(0000,0000,FFFF,FFFF), RGBA16(0000,FFFF,0000,FFFF), RGBA16(FFFF,0000,0000,FFFF), RGBA16(0000,0000,0000,0000), RGBA16(4444,2222,6666,AAAA) } },
+  { 6, TRUE,  { RGB16(0000,0000,3C00), RGB16(0000,3C00,0000), RGB16(3C00,0000,0000), RGB16(0000,0000,0000), RGB16(3444,3044,3666) } },
+  { 8, FALSE, { RGBA16(0000,0000,3C00,3C00), RGBA16(0000,3C00,0000,3C00), RGBA16(3C00,0000,0000,3C00), RGBA16(0000,0000,0000,0000), RGBA16(3444,3044,3666,3955) } },
+  { 12, TRUE, { RGB32(00000000,00000000,3F800000), RGB32(00000000,3F800000,00000000), RGB32(3F800000,00000000,00000000), RGB32(00000000,00000000,00000000), RGB32(3E888889,3E088889,3ECCCCCD) } },
+  { 16, FALSE, { RGBA32(00000000,00000000,3F800000,3F800000), RGBA32(00000000,3F800000,00000000,3F800000), RGBA32(3F800000,00000000,00000000,3F800000), RGBA32(00000000,00000000,00000000,00000000), RGBA32(3E888889,3E088889,3ECCCCCD,3F2AAAAB) } },
 };
 
 static void
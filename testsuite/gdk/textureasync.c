@@ -0,0 +1,144 @@
+#include <gdk/gdk.h>
+
+/* Checks loading textures in a thread with
+ * gdk_texture_new_from_file_async().
+ */
+
+static GFile *
+create_image_file (int width,
+                   int height)
+{
+  GdkPixbuf *pixbuf;
+  GFileIOStream *iostream;
+  GFile *file;
+  GError *error = NULL;
+
+  file = g_file_new_tmp ("textureasync-XXXXXX.png", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, width, height);
+  gdk_pixbuf_fill (pixbuf, 0xFF000080);
+  gdk_pixbuf_save (pixbuf, g_file_peek_path (file), "png", &error, NULL);
+  g_assert_no_error (error);
+  g_object_unref (pixbuf);
+
+  return file;
+}
+
+typedef struct {
+  GMainLoop *loop;
+  GdkTexture *texture;
+  GError *error;
+} LoadResult;
+
+static void
+load_done (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  LoadResult *res = data;
+
+  res->texture = gdk_texture_new_from_file_finish (result, &res->error);
+  g_main_loop_quit (res->loop);
+}
+
+static void
+load (GFile        *file,
+      int           width,
+      int           height,
+      GCancellable *cancellable,
+      LoadResult   *res)
+{
+  res->loop = g_main_loop_new (NULL, FALSE);
+  res->texture = NULL;
+  res->error = NULL;
+
+  gdk_texture_new_from_file_async (file, width, height, G_PRIORITY_DEFAULT,
+                                   cancellable, load_done, res);
+  g_main_loop_run (res->loop);
+  g_main_loop_unref (res->loop);
+}
+
+static void
+test_load (void)
+{
+  GFile *file = create_image_file (40, 20);
+  LoadResult res;
+  guint32 pixel[40 * 20];
+
+  load (file, -1, -1, NULL, &res);
+  g_assert_no_error (res.error);
+  g_assert_cmpint (gdk_texture_get_width (res.texture), ==, 40);
+  g_assert_cmpint (gdk_texture_get_height (res.texture), ==, 20);
+
+  gdk_texture_download (res.texture, (guchar *) pixel, 40 * 4);
+  g_assert_cmphex (pixel[0], ==, 0x80800000);
+
+  g_object_unref (res.texture);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static void
+test_downscale (void)
+{
+  GFile *file = create_image_file (40, 20);
+  LoadResult res;
+
+  /* Keeps the aspect ratio */
+  load (file, 10, 10, NULL, &res);
+  g_assert_no_error (res.error);
+  g_assert_cmpint (gdk_texture_get_width (res.texture), ==, 10);
+  g_assert_cmpint (gdk_texture_get_height (res.texture), ==, 5);
+  g_object_unref (res.texture);
+
+  /* Never scales up */
+  load (file, 100, -1, NULL, &res);
+  g_assert_no_error (res.error);
+  g_assert_cmpint (gdk_texture_get_width (res.texture), ==, 40);
+  g_assert_cmpint (gdk_texture_get_height (res.texture), ==, 20);
+  g_object_unref (res.texture);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static void
+test_errors (void)
+{
+  GFile *file = g_file_new_for_path ("/does/not/exist.png");
+  GCancellable *cancellable;
+  LoadResult res;
+
+  load (file, -1, -1, NULL, &res);
+  g_assert_error (res.error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+  g_assert_null (res.texture);
+  g_clear_error (&res.error);
+  g_object_unref (file);
+
+  file = create_image_file (40, 20);
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  load (file, -1, -1, cancellable, &res);
+  g_assert_error (res.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (res.texture);
+  g_clear_error (&res.error);
+
+  g_object_unref (cancellable);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/textureasync/load", test_load);
+  g_test_add_func ("/textureasync/downscale", test_downscale);
+  g_test_add_func ("/textureasync/errors", test_errors);
+
+  return g_test_run ();
+}
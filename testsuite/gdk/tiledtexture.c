@@ -0,0 +1,143 @@
+#include <gdk/gdk.h>
+
+/* Checks textures for images that are too big to be decoded at once.
+ * Those get decoded in tiles of 512x512, on demand.
+ */
+
+#define TILE_SIZE 512
+#define N_COLS 9
+#define N_ROWS 8
+#define WIDTH (N_COLS * TILE_SIZE)
+#define HEIGHT (N_ROWS * TILE_SIZE)
+
+/* Every tile gets a color of its own */
+static guint32
+tile_color (int col,
+            int row)
+{
+  return 0xFF000000 | (col * 20) << 16 | (row * 20) << 8 | 0x40;
+}
+
+static GFile *
+create_image_file (void)
+{
+  GdkPixbuf *pixbuf;
+  GFileIOStream *iostream;
+  GFile *file;
+  GError *error = NULL;
+  guchar *pixels;
+  int stride;
+  int x, y;
+
+  file = g_file_new_tmp ("tiledtexture-XXXXXX.png", &iostream, &error);
+  g_assert_no_error (error);
+  g_object_unref (iostream);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, WIDTH, HEIGHT);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  stride = gdk_pixbuf_get_rowstride (pixbuf);
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      {
+        guchar *p = pixels + y * stride + x * 3;
+
+        p[0] = (x / TILE_SIZE) * 20;
+        p[1] = (y / TILE_SIZE) * 20;
+        p[2] = 0x40;
+      }
+
+  gdk_pixbuf_save (pixbuf, g_file_peek_path (file), "png", &error,
+                   "compression", "1",
+                   NULL);
+  g_assert_no_error (error);
+  g_object_unref (pixbuf);
+
+  return file;
+}
+
+static void
+check_download (GdkTexture *texture)
+{
+  guint32 *data;
+  int col, row;
+
+  data = g_new (guint32, WIDTH * HEIGHT);
+  gdk_texture_download (texture, (guchar *) data, WIDTH * 4);
+
+  for (row = 0; row < N_ROWS; row++)
+    for (col = 0; col < N_COLS; col++)
+      {
+        int x = col * TILE_SIZE;
+        int y = row * TILE_SIZE;
+
+        g_assert_cmphex (data[y * WIDTH + x], ==, tile_color (col, row));
+        g_assert_cmphex (data[(y + TILE_SIZE / 2) * WIDTH + x + TILE_SIZE / 2], ==, tile_color (col, row));
+        g_assert_cmphex (data[(y + TILE_SIZE - 1) * WIDTH + x + TILE_SIZE - 1], ==, tile_color (col, row));
+      }
+
+  g_free (data);
+}
+
+static void
+test_download (void)
+{
+  GFile *file = create_image_file ();
+  GdkTexture *texture;
+  GError *error = NULL;
+
+  texture = gdk_texture_new_from_file (file, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (texture), ==, WIDTH);
+  g_assert_cmpint (gdk_texture_get_height (texture), ==, HEIGHT);
+
+  check_download (texture);
+  /* Again, from what was kept in the cache */
+  check_download (texture);
+
+  g_object_unref (texture);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static gpointer
+download_thread (gpointer texture)
+{
+  check_download (texture);
+
+  return NULL;
+}
+
+/* Renderers draw textures from several threads at once */
+static void
+test_threads (void)
+{
+  GFile *file = create_image_file ();
+  GdkTexture *texture;
+  GError *error = NULL;
+  GThread *threads[2];
+  guint i;
+
+  texture = gdk_texture_new_from_file (file, &error);
+  g_assert_no_error (error);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_new ("download", download_thread, texture);
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+
+  g_object_unref (texture);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/tiledtexture/download", test_download);
+  g_test_add_func ("/tiledtexture/threads", test_threads);
+
+  return g_test_run ();
+}
@@ -149,6 +149,38 @@ deserialize_error_func (const GtkCssSection *section,
   g_string_append_c (errors, '\n');
 }
 
+/* The binary format must load back into the same nodes */
+static gboolean
+check_binary_roundtrip (GskRenderNode *node,
+                        GBytes        *expected)
+{
+  GskRenderNode *loaded;
+  GBytes *binary, *bytes;
+  gboolean result;
+
+  binary = gsk_render_node_serialize_binary (node);
+  loaded = gsk_render_node_deserialize (binary, NULL, NULL);
+  g_bytes_unref (binary);
+
+  if (loaded == NULL)
+    {
+      g_print ("Failed to load binary serialization\n");
+      return FALSE;
+    }
+
+  bytes = gsk_render_node_serialize (loaded);
+  gsk_render_node_unref (loaded);
+
+  result = g_bytes_equal (bytes, expected);
+  if (!result)
+    g_print ("Binary serialization doesn't round-trip:\n%s\n",
+             (const char *) g_bytes_get_data (bytes, NULL));
+
+  g_bytes_unref (bytes);
+
+  return result;
+}
+
 static gboolean
 parse_node_file (GFile *file, gboolean generate)
 {
@@ -173,6 +205,10 @@ parse_node_file (GFile *file, gboolean generate)
   node = gsk_render_node_deserialize (bytes, deserialize_error_func, errors);
   g_bytes_unref (bytes);
   bytes = gsk_render_node_serialize (node);
+
+  if (!generate && !check_binary_roundtrip (node, bytes))
+    result = FALSE;
+
   gsk_render_node_unref (node);
 
   if (generate)
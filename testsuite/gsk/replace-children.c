@@ -0,0 +1,217 @@
+/* Tests for gsk_render_node_replace_children()
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include "gsk/gskrendernodeprivate.h"
+
+static GskRenderNode *
+color_node (float x)
+{
+  return gsk_color_node_new (&(GdkRGBA) { 1, 0, 0, 1 },
+                             &GRAPHENE_RECT_INIT (x, 0, 10, 10));
+}
+
+static GskRenderNode *
+container_node (GskRenderNode *first,
+                ...)
+{
+  GPtrArray *children;
+  GskRenderNode *child, *res;
+  va_list args;
+
+  children = g_ptr_array_new ();
+
+  va_start (args, first);
+  for (child = first; child != NULL; child = va_arg (args, GskRenderNode *))
+    g_ptr_array_add (children, child);
+  va_end (args);
+
+  res = gsk_container_node_new ((GskRenderNode **) children->pdata, children->len);
+  g_ptr_array_unref (children);
+
+  return res;
+}
+
+static GskRenderNode *
+replace (GskRenderNode *node,
+         GskRenderNode *old_child,
+         GskRenderNode *new_child)
+{
+  GHashTable *replacements;
+  GskRenderNode *res;
+
+  replacements = g_hash_table_new (NULL, NULL);
+  g_hash_table_insert (replacements, old_child, new_child);
+  res = gsk_render_node_replace_children (node, replacements);
+  g_hash_table_unref (replacements);
+
+  return res;
+}
+
+static void
+test_container (void)
+{
+  GskRenderNode *a, *b, *c, *d, *node, *res;
+
+  a = color_node (0);
+  b = color_node (10);
+  c = color_node (20);
+  d = color_node (30);
+  node = container_node (a, b, c, NULL);
+
+  res = replace (node, b, d);
+  g_assert_nonnull (res);
+  g_assert_true (res != node);
+  g_assert_cmpint (gsk_render_node_get_node_type (res), ==, GSK_CONTAINER_NODE);
+  g_assert_cmpuint (gsk_container_node_get_n_children (res), ==, 3);
+  g_assert_true (gsk_container_node_get_child (res, 0) == a);
+  g_assert_true (gsk_container_node_get_child (res, 1) == d);
+  g_assert_true (gsk_container_node_get_child (res, 2) == c);
+
+  /* The original node is left alone */
+  g_assert_true (gsk_container_node_get_child (node, 1) == b);
+
+  gsk_render_node_unref (res);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (a);
+  gsk_render_node_unref (b);
+  gsk_render_node_unref (c);
+  gsk_render_node_unref (d);
+}
+
+static void
+test_transform (void)
+{
+  GskRenderNode *a, *b, *d, *container, *node, *res, *child;
+  GskTransform *transform;
+
+  a = color_node (0);
+  b = color_node (10);
+  d = color_node (30);
+  container = container_node (a, b, NULL);
+  transform = gsk_transform_translate (NULL, &GRAPHENE_POINT_INIT (5, 5));
+  node = gsk_transform_node_new (container, transform);
+
+  res = replace (node, b, d);
+  g_assert_nonnull (res);
+  g_assert_cmpint (gsk_render_node_get_node_type (res), ==, GSK_TRANSFORM_NODE);
+  g_assert_true (gsk_transform_equal (gsk_transform_node_get_transform (res), transform));
+
+  child = gsk_transform_node_get_child (res);
+  g_assert_cmpint (gsk_render_node_get_node_type (child), ==, GSK_CONTAINER_NODE);
+  g_assert_true (child != container);
+  g_assert_true (gsk_container_node_get_child (child, 0) == a);
+  g_assert_true (gsk_container_node_get_child (child, 1) == d);
+
+  gsk_render_node_unref (res);
+  gsk_render_node_unref (node);
+  gsk_transform_unref (transform);
+  gsk_render_node_unref (container);
+  gsk_render_node_unref (a);
+  gsk_render_node_unref (b);
+  gsk_render_node_unref (d);
+}
+
+static void
+test_clip (void)
+{
+  GskRenderNode *b, *d, *node, *res;
+  const graphene_rect_t clip = GRAPHENE_RECT_INIT (0, 0, 15, 15);
+
+  b = color_node (10);
+  d = color_node (30);
+  node = gsk_clip_node_new (b, &clip);
+
+  res = replace (node, b, d);
+  g_assert_nonnull (res);
+  g_assert_cmpint (gsk_render_node_get_node_type (res), ==, GSK_CLIP_NODE);
+  g_assert_true (graphene_rect_equal (gsk_clip_node_peek_clip (res), &clip));
+  g_assert_true (gsk_clip_node_get_child (res) == d);
+
+  gsk_render_node_unref (res);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (b);
+  gsk_render_node_unref (d);
+}
+
+static void
+test_not_found (void)
+{
+  GskRenderNode *a, *b, *d, *node;
+
+  a = color_node (0);
+  b = color_node (10);
+  d = color_node (30);
+  node = container_node (a, NULL);
+
+  g_assert_null (replace (node, b, d));
+
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (a);
+  gsk_render_node_unref (b);
+  gsk_render_node_unref (d);
+}
+
+static void
+test_blend (void)
+{
+  GskRenderNode *a, *b, *d, *blend, *node, *res;
+  GHashTable *replacements;
+
+  a = color_node (0);
+  b = color_node (10);
+  d = color_node (30);
+  blend = gsk_blend_node_new (a, b, GSK_BLEND_MODE_MULTIPLY);
+  node = container_node (blend, NULL);
+
+  /* Blend nodes can not be recreated with a new child */
+  g_assert_null (replace (node, b, d));
+
+  /* But they can be kept as they are next to a replaced sibling */
+  gsk_render_node_unref (node);
+  node = container_node (blend, a, NULL);
+
+  replacements = g_hash_table_new (NULL, NULL);
+  g_hash_table_insert (replacements, blend, blend);
+  g_hash_table_insert (replacements, a, d);
+  res = gsk_render_node_replace_children (node, replacements);
+  g_hash_table_unref (replacements);
+
+  g_assert_nonnull (res);
+  g_assert_true (gsk_container_node_get_child (res, 0) == blend);
+  g_assert_true (gsk_container_node_get_child (res, 1) == d);
+
+  gsk_render_node_unref (res);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (blend);
+  gsk_render_node_unref (a);
+  gsk_render_node_unref (b);
+  gsk_render_node_unref (d);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/replace-children/container", test_container);
+  g_test_add_func ("/replace-children/transform", test_transform);
+  g_test_add_func ("/replace-children/clip", test_clip);
+  g_test_add_func ("/replace-children/not-found", test_not_found);
+  g_test_add_func ("/replace-children/blend", test_blend);
+
+  return g_test_run ();
+}
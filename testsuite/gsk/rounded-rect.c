@@ -87,6 +87,60 @@ test_intersects_rect (void)
 #undef HALF_THE_POINTS
 }
 
+static void
+test_benchmark (void)
+{
+  guint n = g_test_perf () ? 1000000 : 1000;
+  graphene_rect_t *rects;
+  GskRoundedRect rounded;
+  guint i, contained, intersecting;
+  double elapsed;
+
+  gsk_rounded_rect_init (&rounded,
+                         &GRAPHENE_RECT_INIT (0, 0, 400, 300),
+                         &GRAPHENE_SIZE_INIT (10, 10),
+                         &GRAPHENE_SIZE_INIT (20, 5),
+                         &GRAPHENE_SIZE_INIT (0, 0),
+                         &GRAPHENE_SIZE_INIT (30, 40));
+
+  rects = g_new (graphene_rect_t, n);
+  for (i = 0; i < n; i++)
+    graphene_rect_init (&rects[i],
+                        g_test_rand_double_range (-50, 450),
+                        g_test_rand_double_range (-50, 350),
+                        g_test_rand_double_range (1, 100),
+                        g_test_rand_double_range (1, 100));
+
+  g_test_timer_start ();
+
+  contained = 0;
+  for (i = 0; i < n; i++)
+    contained += gsk_rounded_rect_contains_rect (&rounded, &rects[i]);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "checking %u rects for containment: %gsec", n, elapsed);
+
+  g_test_timer_start ();
+
+  intersecting = 0;
+  for (i = 0; i < n; i++)
+    intersecting += gsk_rounded_rect_intersects_rect (&rounded, &rects[i]);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "checking %u rects for intersection: %gsec", n, elapsed);
+
+  g_assert_cmpuint (contained, <=, intersecting);
+  for (i = 0; i < n; i++)
+    {
+      if (gsk_rounded_rect_contains_rect (&rounded, &rects[i]))
+        g_assert_true (gsk_rounded_rect_intersects_rect (&rounded, &rects[i]));
+    }
+
+  g_free (rects);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -95,6 +149,7 @@ main (int   argc,
 
   g_test_add_func ("/rounded-rect/contains-rect", test_contains_rect);
   g_test_add_func ("/rounded-rect/intersects-rect", test_intersects_rect);
+  g_test_add_func ("/rounded-rect/benchmark", test_benchmark);
 
   return g_test_run ();
 }
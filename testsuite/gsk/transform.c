@@ -250,6 +250,66 @@ test_conversions_transformed (void)
     }
 }
 
+/* Chains are flattened when they are built, so check the result
+ * against matrices computed step by step.
+ */
+static void
+test_conversions_chain (void)
+{
+  GskTransform *transform = NULL;
+  graphene_matrix_t expected, step, matrix;
+  float f[16] = { 1, 0, 0, 0,
+                  0, 1, 0, 0,
+                  0, 0, 1, 0,
+                  0, 0, 0, 1 };
+  guint i;
+
+  graphene_matrix_init_identity (&expected);
+
+  for (i = 0; i < 24; i++)
+    {
+      switch (i % 4)
+        {
+        case 0:
+          transform = gsk_transform_translate (transform, &GRAPHENE_POINT_INIT (3, 5));
+          graphene_matrix_init_translate (&step, &GRAPHENE_POINT3D_INIT (3, 5, 0));
+          break;
+
+        case 1:
+          transform = gsk_transform_scale (transform, 2, 0.5);
+          graphene_matrix_init_scale (&step, 2, 0.5, 1);
+          break;
+
+        case 2:
+          transform = gsk_transform_rotate (transform, 90);
+          graphene_matrix_init_rotate (&step, 90, graphene_vec3_z_axis ());
+          break;
+
+        case 3:
+          transform = gsk_transform_translate (transform, &GRAPHENE_POINT_INIT (-7, 1));
+          graphene_matrix_init_translate (&step, &GRAPHENE_POINT3D_INIT (-7, 1, 0));
+          break;
+
+        default:
+          g_assert_not_reached ();
+        }
+
+      graphene_matrix_multiply (&step, &expected, &expected);
+
+      gsk_transform_to_matrix (transform, &matrix);
+      graphene_assert_fuzzy_matrix_equal (&matrix, &expected, EPSILON);
+
+      gsk_transform_to_2d (transform,
+                           &f[4 * 0 + 0], &f[4 * 0 + 1],
+                           &f[4 * 1 + 0], &f[4 * 1 + 1],
+                           &f[4 * 3 + 0], &f[4 * 3 + 1]);
+      graphene_matrix_init_from_float (&matrix, f);
+      graphene_assert_fuzzy_matrix_equal (&matrix, &expected, EPSILON);
+    }
+
+  gsk_transform_unref (transform);
+}
+
 static void
 test_invert (void)
 {
@@ -530,6 +590,7 @@ main (int   argc,
 
   g_test_add_func ("/transform/conversions/simple", test_conversions_simple);
   g_test_add_func ("/transform/conversions/transformed", test_conversions_transformed);
+  g_test_add_func ("/transform/conversions/chain", test_conversions_chain);
   g_test_add_func ("/transform/identity", test_identity);
   g_test_add_func ("/transform/identity-equal", test_identity_equal);
   g_test_add_func ("/transform/invert", test_invert);
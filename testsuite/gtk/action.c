@@ -717,6 +717,55 @@ test_enabled (void)
   g_object_unref (g_object_ref_sink (text));
 }
 
+/* Test that enabled changes of group actions reach
+ * widgets once the main loop has run, and that the
+ * last change wins.
+ */
+static void
+test_enabled_batched (void)
+{
+  GtkWidget *window;
+  GtkWidget *button;
+  GSimpleActionGroup *actions;
+  GAction *action;
+  GActionEntry entries[] = {
+    { "action", activate, NULL, NULL, NULL },
+  };
+  int activated = 0;
+
+  window = gtk_window_new ();
+  button = gtk_button_new ();
+  gtk_window_set_child (GTK_WINDOW (window), button);
+
+  actions = g_simple_action_group_new ();
+  g_action_map_add_action_entries (G_ACTION_MAP (actions),
+                                   entries, G_N_ELEMENTS (entries),
+                                   &activated);
+  gtk_widget_insert_action_group (window, "win", G_ACTION_GROUP (actions));
+
+  gtk_actionable_set_action_name (GTK_ACTIONABLE (button), "win.action");
+  g_assert_true (gtk_widget_get_sensitive (button));
+
+  action = g_action_map_lookup_action (G_ACTION_MAP (actions), "action");
+
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (action), FALSE);
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_false (gtk_widget_get_sensitive (button));
+
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (action), TRUE);
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (action), FALSE);
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (action), TRUE);
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_true (gtk_widget_get_sensitive (button));
+
+  gtk_widget_activate_action (button, "win.action", NULL);
+  g_assert_cmpint (activated, ==, 1);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+
+  g_object_unref (actions);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -732,6 +781,7 @@ main (int   argc,
   g_test_add_func ("/action/overlap2", test_overlap2);
   g_test_add_func ("/action/introspection", test_introspection);
   g_test_add_func ("/action/enabled", test_enabled);
+  g_test_add_func ("/action/enabled-batched", test_enabled_batched);
 
   return g_test_run();
 }
@@ -0,0 +1,275 @@
+/* Tests for skipping allocations when child requests did not change
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <gtk/gtk.h>
+
+/* A widget that counts its allocations. With children, it lays
+ * them out in a row, at their natural widths.
+ */
+#define GTK_TYPE_GIZMO                 (gtk_gizmo_get_type ())
+#define GTK_GIZMO(obj)                 (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_TYPE_GIZMO, GtkGizmo))
+
+typedef struct _GtkGizmo GtkGizmo;
+
+struct _GtkGizmo {
+  GtkWidget parent;
+
+  int width;
+  int height;
+  guint n_allocations;
+};
+
+typedef GtkWidgetClass GtkGizmoClass;
+
+G_DEFINE_TYPE (GtkGizmo, gtk_gizmo, GTK_TYPE_WIDGET);
+
+static void
+gtk_gizmo_measure (GtkWidget      *widget,
+                   GtkOrientation  orientation,
+                   int             for_size,
+                   int            *minimum,
+                   int            *natural,
+                   int            *minimum_baseline,
+                   int            *natural_baseline)
+{
+  GtkGizmo *self = GTK_GIZMO (widget);
+  GtkWidget *child;
+
+  if (orientation == GTK_ORIENTATION_HORIZONTAL)
+    *minimum = *natural = self->width;
+  else
+    *minimum = *natural = self->height;
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      int child_min, child_nat;
+
+      if (!gtk_widget_should_layout (child))
+        continue;
+
+      gtk_widget_measure (child, orientation, -1, &child_min, &child_nat, NULL, NULL);
+      if (orientation == GTK_ORIENTATION_HORIZONTAL)
+        {
+          *minimum += child_min;
+          *natural += child_nat;
+        }
+      else
+        {
+          *minimum = MAX (*minimum, child_min);
+          *natural = MAX (*natural, child_nat);
+        }
+    }
+}
+
+static void
+gtk_gizmo_size_allocate (GtkWidget *widget,
+                         int        width,
+                         int        height,
+                         int        baseline)
+{
+  GtkGizmo *self = GTK_GIZMO (widget);
+  GtkWidget *child;
+  int x = 0;
+
+  self->n_allocations++;
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      int child_width;
+
+      if (!gtk_widget_should_layout (child))
+        continue;
+
+      gtk_widget_measure (child, GTK_ORIENTATION_HORIZONTAL, -1, NULL, &child_width, NULL, NULL);
+      gtk_widget_size_allocate (child, &(GtkAllocation) { x, 0, child_width, height }, -1);
+      x += child_width;
+    }
+}
+
+static void
+gtk_gizmo_dispose (GObject *object)
+{
+  GtkWidget *child;
+
+  while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
+    gtk_widget_unparent (child);
+
+  G_OBJECT_CLASS (gtk_gizmo_parent_class)->dispose (object);
+}
+
+static void
+gtk_gizmo_class_init (GtkGizmoClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->dispose = gtk_gizmo_dispose;
+
+  widget_class->measure = gtk_gizmo_measure;
+  widget_class->size_allocate = gtk_gizmo_size_allocate;
+}
+
+static void
+gtk_gizmo_init (GtkGizmo *self)
+{
+}
+
+static GtkGizmo *
+add_child (GtkWidget *parent,
+           int        width,
+           int        height)
+{
+  GtkGizmo *child = g_object_new (GTK_TYPE_GIZMO, NULL);
+
+  child->width = width;
+  child->height = height;
+  gtk_widget_set_parent (GTK_WIDGET (child), parent);
+
+  return child;
+}
+
+/* Does what the frame clock would do for a toplevel */
+static void
+layout (GtkWidget *widget)
+{
+  int width, height;
+
+  gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, NULL, &width, NULL, NULL);
+  gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, -1, NULL, &height, NULL, NULL);
+  gtk_widget_allocate (widget, MAX (width, 300), MAX (height, 100), -1, NULL);
+}
+
+static float
+get_x (GtkGizmo  *child,
+       GtkWidget *parent)
+{
+  graphene_rect_t bounds;
+
+  g_assert_true (gtk_widget_compute_bounds (GTK_WIDGET (child), parent, &bounds));
+
+  return bounds.origin.x;
+}
+
+typedef struct {
+  GtkWidget *parent;
+  GtkGizmo *a, *b, *c;
+} Fixture;
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  data)
+{
+  fixture->parent = g_object_ref_sink (g_object_new (GTK_TYPE_GIZMO, NULL));
+  fixture->a = add_child (fixture->parent, 50, 20);
+  fixture->b = add_child (fixture->parent, 50, 20);
+  fixture->c = add_child (fixture->parent, 50, 20);
+
+  layout (fixture->parent);
+  g_assert_cmpuint (GTK_GIZMO (fixture->parent)->n_allocations, ==, 1);
+  g_assert_cmpfloat (get_x (fixture->c, fixture->parent), ==, 100);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  data)
+{
+  g_object_unref (fixture->parent);
+}
+
+static void
+test_request_changed (Fixture       *fixture,
+                      gconstpointer  data)
+{
+  GtkGizmo *parent = GTK_GIZMO (fixture->parent);
+
+  fixture->b->width = 80;
+  gtk_widget_queue_resize (GTK_WIDGET (fixture->b));
+  layout (fixture->parent);
+
+  /* The siblings after the leaf moved */
+  g_assert_cmpuint (parent->n_allocations, ==, 2);
+  g_assert_cmpfloat (get_x (fixture->a, fixture->parent), ==, 0);
+  g_assert_cmpfloat (get_x (fixture->c, fixture->parent), ==, 130);
+  g_assert_cmpint (gtk_widget_get_width (GTK_WIDGET (fixture->b)), ==, 80);
+}
+
+static void
+test_request_unchanged (Fixture       *fixture,
+                        gconstpointer  data)
+{
+  GtkGizmo *parent = GTK_GIZMO (fixture->parent);
+  guint n_allocations = fixture->b->n_allocations;
+
+  gtk_widget_queue_resize (GTK_WIDGET (fixture->b));
+  layout (fixture->parent);
+
+  /* Only the leaf that asked for it is allocated again */
+  g_assert_cmpuint (parent->n_allocations, ==, 1);
+  g_assert_cmpuint (fixture->b->n_allocations, ==, n_allocations + 1);
+  g_assert_cmpfloat (get_x (fixture->c, fixture->parent), ==, 100);
+}
+
+static void
+test_expand_changed (Fixture       *fixture,
+                     gconstpointer  data)
+{
+  GtkGizmo *parent = GTK_GIZMO (fixture->parent);
+
+  gtk_widget_set_hexpand (GTK_WIDGET (fixture->b), TRUE);
+  layout (fixture->parent);
+
+  /* No request changed, but the parent may hand out space differently */
+  g_assert_cmpuint (parent->n_allocations, ==, 2);
+}
+
+static void
+test_visibility_changed (Fixture       *fixture,
+                         gconstpointer  data)
+{
+  GtkGizmo *parent = GTK_GIZMO (fixture->parent);
+
+  gtk_widget_hide (GTK_WIDGET (fixture->b));
+  layout (fixture->parent);
+
+  g_assert_cmpuint (parent->n_allocations, ==, 2);
+  g_assert_cmpfloat (get_x (fixture->c, fixture->parent), ==, 50);
+
+  gtk_widget_show (GTK_WIDGET (fixture->b));
+  layout (fixture->parent);
+
+  g_assert_cmpuint (parent->n_allocations, ==, 3);
+  g_assert_cmpfloat (get_x (fixture->c, fixture->parent), ==, 100);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add ("/allocation/request-changed", Fixture, NULL,
+              fixture_setup, test_request_changed, fixture_teardown);
+  g_test_add ("/allocation/request-unchanged", Fixture, NULL,
+              fixture_setup, test_request_unchanged, fixture_teardown);
+  g_test_add ("/allocation/expand-changed", Fixture, NULL,
+              fixture_setup, test_expand_changed, fixture_teardown);
+  g_test_add ("/allocation/visibility-changed", Fixture, NULL,
+              fixture_setup, test_visibility_changed, fixture_teardown);
+
+  return g_test_run ();
+}
@@ -21,6 +21,7 @@
 #include <libintl.h>
 #include <locale.h>
 #include <math.h>
+#include <glib/gstdio.h>
 
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
@@ -2506,6 +2507,117 @@ test_expressions (void)
     }
 }
 
+static void
+test_lazy_objects (void)
+{
+  const char buffer[] =
+    "<interface>"
+    "  <object class='GtkBox' id='box'>"
+    "    <child>"
+    "      <object class='GtkLabel' id='label'/>"
+    "    </child>"
+    "    <child>"
+    "      <object class='GtkBox' id='lazy' lazy='true'>"
+    "        <child>"
+    "          <object class='GtkButton' id='button'>"
+    "            <property name='label'>Hello</property>"
+    "          </object>"
+    "        </child>"
+    "      </object>"
+    "    </child>"
+    "    <child>"
+    "      <object class='GtkLabel' id='label2'/>"
+    "    </child>"
+    "  </object>"
+    "</interface>";
+  GtkBuilder *builder;
+  GObject *box, *label, *label2, *lazy, *button;
+
+  builder = builder_new_from_string (buffer, -1, NULL);
+  box = gtk_builder_get_object (builder, "box");
+  g_assert_true (GTK_IS_BOX (box));
+
+  /* Only the labels were built */
+  label = gtk_builder_get_object (builder, "label");
+  label2 = gtk_builder_get_object (builder, "label2");
+  g_assert_true (gtk_widget_get_next_sibling (GTK_WIDGET (label)) == GTK_WIDGET (label2));
+  g_assert_null (gtk_widget_get_next_sibling (GTK_WIDGET (label2)));
+  g_assert_null (gtk_builder_get_object (builder, "button"));
+
+  /* The lazy box goes where it was declared, not at the end */
+  lazy = gtk_builder_get_object (builder, "lazy");
+  g_assert_true (GTK_IS_BOX (lazy));
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (lazy)) == GTK_WIDGET (box));
+  g_assert_true (gtk_widget_get_prev_sibling (GTK_WIDGET (lazy)) == GTK_WIDGET (label));
+  g_assert_true (gtk_widget_get_next_sibling (GTK_WIDGET (lazy)) == GTK_WIDGET (label2));
+
+  button = gtk_builder_get_object (builder, "button");
+  g_assert_true (GTK_IS_BUTTON (button));
+  g_assert_cmpstr (gtk_button_get_label (GTK_BUTTON (button)), ==, "Hello");
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (button)) == GTK_WIDGET (lazy));
+
+  g_object_unref (builder);
+}
+
+static void
+file_loaded (GObject      *source,
+             GAsyncResult *result,
+             gpointer      data)
+{
+  gboolean *done = data;
+  GError *error = NULL;
+
+  g_assert_true (gtk_builder_add_from_file_finish (GTK_BUILDER (source), result, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static void
+test_add_from_file_async (void)
+{
+  const char buffer[] =
+    "<interface>"
+    "  <object class='GtkBox' id='box'>"
+    "    <child>"
+    "      <object class='GtkLabel' id='label'>"
+    "        <property name='label'>Hello</property>"
+    "      </object>"
+    "    </child>"
+    "  </object>"
+    "</interface>";
+  GtkBuilder *builder;
+  GObject *box, *label;
+  GError *error = NULL;
+  gboolean done = FALSE;
+  char *filename;
+  int fd;
+
+  fd = g_file_open_tmp ("builder-XXXXXX.ui", &filename, &error);
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+  g_file_set_contents (filename, buffer, -1, &error);
+  g_assert_no_error (error);
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_file_async (builder, filename, NULL, file_loaded, &done);
+  g_assert_null (gtk_builder_get_object (builder, "box"));
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  box = gtk_builder_get_object (builder, "box");
+  label = gtk_builder_get_object (builder, "label");
+  g_assert_true (GTK_IS_BOX (box));
+  g_assert_true (GTK_IS_LABEL (label));
+  g_assert_cmpstr (gtk_label_get_label (GTK_LABEL (label)), ==, "Hello");
+  g_assert_true (gtk_widget_get_parent (GTK_WIDGET (label)) == GTK_WIDGET (box));
+
+  g_object_unref (builder);
+  g_remove (filename);
+  g_free (filename);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -2553,6 +2665,8 @@ main (int argc, char **argv)
   g_test_add_func ("/Builder/Shortcuts", test_shortcuts);
   g_test_add_func ("/Builder/Transforms", test_transforms);
   g_test_add_func ("/Builder/Expressions", test_expressions);
+  g_test_add_func ("/Builder/LazyObjects", test_lazy_objects);
+  g_test_add_func ("/Builder/AddFromFileAsync", test_add_from_file_async);
 
   return g_test_run();
 }
@@ -0,0 +1,217 @@
+/* GtkConstraintLayout tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <gtk/gtk.h>
+
+#define GTK_TYPE_GIZMO                 (gtk_gizmo_get_type ())
+
+typedef struct _GtkGizmo GtkGizmo;
+
+struct _GtkGizmo {
+  GtkWidget parent;
+};
+
+typedef GtkWidgetClass GtkGizmoClass;
+
+G_DEFINE_TYPE (GtkGizmo, gtk_gizmo, GTK_TYPE_WIDGET);
+
+static void
+gtk_gizmo_dispose (GObject *object)
+{
+  GtkWidget *child;
+
+  while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
+    gtk_widget_unparent (child);
+
+  G_OBJECT_CLASS (gtk_gizmo_parent_class)->dispose (object);
+}
+
+static void
+gtk_gizmo_class_init (GtkGizmoClass *klass)
+{
+  G_OBJECT_CLASS (klass)->dispose = gtk_gizmo_dispose;
+
+  gtk_widget_class_set_layout_manager_type (GTK_WIDGET_CLASS (klass), GTK_TYPE_CONSTRAINT_LAYOUT);
+}
+
+static void
+gtk_gizmo_init (GtkGizmo *self)
+{
+}
+
+/* The layout only has a solver once it is in a toplevel */
+static GtkWidget *
+create_layout_widget (GtkWidget **window)
+{
+  GtkWidget *widget;
+
+  *window = gtk_window_new ();
+  widget = g_object_new (GTK_TYPE_GIZMO, NULL);
+  gtk_window_set_child (GTK_WINDOW (*window), widget);
+
+  return widget;
+}
+
+static void
+add_constraint (GtkWidget              *widget,
+                gpointer                target,
+                GtkConstraintAttribute  target_attribute,
+                GtkConstraintRelation   relation,
+                gpointer                source,
+                GtkConstraintAttribute  source_attribute,
+                double                  constant)
+{
+  GtkConstraint *constraint;
+
+  if (source != NULL || source_attribute != GTK_CONSTRAINT_ATTRIBUTE_NONE)
+    constraint = gtk_constraint_new (target, target_attribute, relation,
+                                     source, source_attribute,
+                                     1.0, constant,
+                                     GTK_CONSTRAINT_STRENGTH_REQUIRED);
+  else
+    constraint = gtk_constraint_new_constant (target, target_attribute, relation,
+                                              constant,
+                                              GTK_CONSTRAINT_STRENGTH_REQUIRED);
+
+  gtk_constraint_layout_add_constraint (GTK_CONSTRAINT_LAYOUT (gtk_widget_get_layout_manager (widget)),
+                                        constraint);
+}
+
+/* Measuring after an allocation must not report the allocated size,
+ * even though the layout keeps the allocation in its solver
+ */
+static void
+test_measure_after_allocate (void)
+{
+  GtkWidget *window, *widget, *child;
+  int min, nat;
+
+  widget = create_layout_widget (&window);
+  child = gtk_label_new (NULL);
+  gtk_widget_set_parent (child, widget);
+
+  add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_START, GTK_CONSTRAINT_RELATION_EQ,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_START, 0);
+  add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_END, GTK_CONSTRAINT_RELATION_EQ,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_END, 0);
+  add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_TOP, GTK_CONSTRAINT_RELATION_EQ,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_TOP, 0);
+  add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_BOTTOM, GTK_CONSTRAINT_RELATION_EQ,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_BOTTOM, 0);
+  add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_WIDTH, GTK_CONSTRAINT_RELATION_GE,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_NONE, 50);
+  add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_HEIGHT, GTK_CONSTRAINT_RELATION_GE,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_NONE, 20);
+
+  gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat, NULL, NULL);
+  g_assert_cmpint (min, ==, 50);
+  gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, -1, &min, &nat, NULL, NULL);
+  g_assert_cmpint (min, ==, 20);
+
+  gtk_widget_allocate (widget, 400, 100, -1, NULL);
+  g_assert_cmpint (gtk_widget_get_width (child), ==, 400);
+  g_assert_cmpint (gtk_widget_get_height (child), ==, 100);
+
+  gtk_widget_queue_resize (widget);
+  gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat, NULL, NULL);
+  g_assert_cmpint (min, ==, 50);
+  gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, -1, &min, &nat, NULL, NULL);
+  g_assert_cmpint (min, ==, 20);
+
+  /* And the allocation still applies afterwards */
+  gtk_widget_allocate (widget, 300, 80, -1, NULL);
+  g_assert_cmpint (gtk_widget_get_width (child), ==, 300);
+  g_assert_cmpint (gtk_widget_get_height (child), ==, 80);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+#define PERF_N_CHILDREN 125
+#define PERF_N_ALLOCATIONS 100
+
+/* Allocation passes on a layout with about 500 constraints, at an
+ * unchanged size and at a changing size
+ */
+static void
+test_allocate_performance (void)
+{
+  GtkWidget *window, *widget, *child, *prev;
+  double same_size, resized;
+  int i, width, height;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  widget = create_layout_widget (&window);
+
+  prev = NULL;
+  for (i = 0; i < PERF_N_CHILDREN; i++)
+    {
+      child = gtk_label_new (NULL);
+      gtk_widget_set_parent (child, widget);
+
+      add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_START, GTK_CONSTRAINT_RELATION_EQ,
+                      prev, prev ? GTK_CONSTRAINT_ATTRIBUTE_END : GTK_CONSTRAINT_ATTRIBUTE_START, 2);
+      add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_TOP, GTK_CONSTRAINT_RELATION_EQ,
+                      NULL, GTK_CONSTRAINT_ATTRIBUTE_TOP, 0);
+      add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_BOTTOM, GTK_CONSTRAINT_RELATION_EQ,
+                      NULL, GTK_CONSTRAINT_ATTRIBUTE_BOTTOM, 0);
+      add_constraint (widget, child, GTK_CONSTRAINT_ATTRIBUTE_WIDTH, GTK_CONSTRAINT_RELATION_GE,
+                      NULL, GTK_CONSTRAINT_ATTRIBUTE_NONE, 4);
+
+      prev = child;
+    }
+  add_constraint (widget, prev, GTK_CONSTRAINT_ATTRIBUTE_END, GTK_CONSTRAINT_RELATION_LE,
+                  NULL, GTK_CONSTRAINT_ATTRIBUTE_END, 0);
+
+  gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, &width, NULL, NULL, NULL);
+  gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, -1, &height, NULL, NULL, NULL);
+  width = MAX (width, 1000);
+  height = MAX (height, 100);
+  gtk_widget_allocate (widget, width, height, -1, NULL);
+
+  g_test_timer_start ();
+  for (i = 0; i < PERF_N_ALLOCATIONS; i++)
+    {
+      gtk_widget_queue_allocate (widget);
+      gtk_widget_allocate (widget, width, height, -1, NULL);
+    }
+  same_size = g_test_timer_elapsed ();
+
+  g_test_timer_start ();
+  for (i = 0; i < PERF_N_ALLOCATIONS; i++)
+    gtk_widget_allocate (widget, width + 1 + i % 2, height, -1, NULL);
+  resized = g_test_timer_elapsed ();
+
+  g_test_minimized_result (same_size,
+                           "%d allocations: same size %gms, changing size %gms",
+                           PERF_N_ALLOCATIONS, same_size * 1000, resized * 1000);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/constraint-layout/measure-after-allocate", test_measure_after_allocate);
+  g_test_add_func ("/constraint-layout/allocate/performance", test_allocate_performance);
+
+  return g_test_run ();
+}
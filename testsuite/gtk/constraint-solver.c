@@ -359,6 +359,59 @@ constraint_solver_paper (void)
   g_object_unref (solver);
 }
 
+static void
+constraint_solver_wide_expression (void)
+{
+  GtkConstraintSolver *solver = gtk_constraint_solver_new ();
+  GtkConstraintVariable *vars[32];
+  GtkConstraintExpression *e;
+  GtkConstraintExpressionIter iter;
+  GtkConstraintVariable *t_v;
+  double t_c;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    vars[i] = gtk_constraint_solver_create_variable (solver, NULL, "v", 0.0);
+
+  e = gtk_constraint_expression_new (0.0);
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      gtk_constraint_expression_add_variable (e, vars[i], i + 1, NULL, NULL);
+      gtk_constraint_expression_add_variable (e, vars[i], i + 1, NULL, NULL);
+    }
+
+  /* Remove every other term */
+  for (i = 0; i < G_N_ELEMENTS (vars); i += 2)
+    gtk_constraint_expression_add_variable (e, vars[i], -2.0 * (i + 1), NULL, NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    {
+      double expected = i % 2 == 0 ? 0.0 : 2.0 * (i + 1);
+
+      g_assert_cmpfloat_with_epsilon (gtk_constraint_expression_get_coefficient (e, vars[i]),
+                                      expected,
+                                      0.001);
+    }
+
+  /* Terms are kept in insertion order */
+  i = 1;
+  gtk_constraint_expression_iter_init (&iter, e);
+  while (gtk_constraint_expression_iter_next (&iter, &t_v, &t_c))
+    {
+      g_assert_true (t_v == vars[i]);
+      g_assert_cmpfloat_with_epsilon (t_c, 2.0 * (i + 1), 0.001);
+      i += 2;
+    }
+  g_assert_cmpuint (i, ==, G_N_ELEMENTS (vars) + 1);
+
+  gtk_constraint_expression_unref (e);
+
+  for (i = 0; i < G_N_ELEMENTS (vars); i++)
+    gtk_constraint_variable_unref (vars[i]);
+
+  g_object_unref (solver);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -375,6 +428,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/constraint-solver/cassowary", constraint_solver_cassowary);
   g_test_add_func ("/constraint-solver/edit/required", constraint_solver_edit_var_required);
   g_test_add_func ("/constraint-solver/edit/suggest", constraint_solver_edit_var_suggest);
+  g_test_add_func ("/constraint-solver/expression/wide", constraint_solver_wide_expression);
 
   return g_test_run ();
 }
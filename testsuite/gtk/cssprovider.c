@@ -33,6 +33,52 @@ test_section_load_nonexisting_file (void)
   g_object_unref (provider);
 }
 
+/* Styles that depend on the position are shared between siblings at the
+ * same position. A hidden child still has its own position, so it must
+ * not share the style of the visible child in front of it.
+ */
+static void
+test_nth_child_hidden (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *box;
+  GtkWidget *labels[4];
+  GdkRGBA red = { 1, 0, 0, 1 };
+  GdkRGBA blue = { 0, 0, 1, 1 };
+  GdkRGBA color;
+  int i;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   ".nth-test label { color: blue; }\n"
+                                   ".nth-test label:nth-child(3) { color: red; }",
+                                   -1);
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (provider),
+                                              GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  g_object_ref_sink (box);
+  gtk_widget_add_css_class (box, "nth-test");
+  for (i = 0; i < 4; i++)
+    {
+      labels[i] = gtk_label_new ("");
+      gtk_box_append (GTK_BOX (box), labels[i]);
+    }
+  gtk_widget_hide (labels[2]);
+
+  for (i = 0; i < 4; i++)
+    {
+      gtk_style_context_get_color (gtk_widget_get_style_context (labels[i]), &color);
+      g_assert_true (gdk_rgba_equal (&color, i == 2 ? &red : &blue));
+    }
+
+  g_object_unref (box);
+  gtk_style_context_remove_provider_for_display (gdk_display_get_default (),
+                                                 GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -41,6 +87,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/cssprovider/section-in-load-from-data", test_section_in_load_from_data);
   g_test_add_func ("/cssprovider/load-nonexisting-file", test_section_load_nonexisting_file);
+  g_test_add_func ("/cssprovider/nth-child-hidden", test_nth_child_hidden);
 
   return g_test_run ();
 }
@@ -265,6 +265,102 @@ test_nested (void)
   gtk_expression_unref (expr);
 }
 
+/* Notifications of the intermediate property that don't
+ * change the object must not cause a notification of the
+ * watch, but the watch must keep following the object.
+ */
+static void
+test_nested_same_object (void)
+{
+  GtkExpression *list_expr;
+  GtkExpression *filter_expr;
+  GtkExpression *expr;
+  GtkStringFilter *filter;
+  GListModel *list;
+  GtkFilterListModel *filtered;
+  GtkExpressionWatch *watch;
+  guint counter = 0;
+
+  filter = gtk_string_filter_new (NULL);
+  list = G_LIST_MODEL (g_list_store_new (G_TYPE_OBJECT));
+  filtered = gtk_filter_list_model_new (list, g_object_ref (GTK_FILTER (filter)));
+
+  list_expr = gtk_object_expression_new (G_OBJECT (filtered));
+  filter_expr = gtk_property_expression_new (GTK_TYPE_FILTER_LIST_MODEL, list_expr, "filter");
+  expr = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, filter_expr, "search");
+
+  watch = gtk_expression_watch (expr, NULL, inc_counter, &counter, NULL);
+
+  g_object_notify (G_OBJECT (filtered), "filter");
+  g_assert_cmpint (counter, ==, 0);
+
+  gtk_string_filter_set_search (filter, "salad");
+  g_assert_cmpint (counter, ==, 1);
+  counter = 0;
+
+  gtk_filter_list_model_set_filter (filtered, NULL);
+  g_assert_cmpint (counter, ==, 1);
+  counter = 0;
+
+  g_object_notify (G_OBJECT (filtered), "filter");
+  g_assert_cmpint (counter, ==, 0);
+
+  gtk_string_filter_set_search (filter, "bar");
+  g_assert_cmpint (counter, ==, 0);
+
+  gtk_expression_watch_unwatch (watch);
+
+  g_object_unref (filter);
+  g_object_unref (filtered);
+  gtk_expression_unref (expr);
+}
+
+/* Replace the filter while notifications are frozen, so the
+ * watch only hears about it once the old filter is gone. The new
+ * filter may well end up at the address of the old one, and the
+ * watch must still notice that it is a different object.
+ */
+static void
+test_nested_object_replaced (void)
+{
+  GtkExpression *list_expr;
+  GtkExpression *filter_expr;
+  GtkExpression *expr;
+  GtkStringFilter *filter;
+  GListModel *list;
+  GtkFilterListModel *filtered;
+  GtkExpressionWatch *watch;
+  guint counter = 0;
+
+  filter = gtk_string_filter_new (NULL);
+  list = G_LIST_MODEL (g_list_store_new (G_TYPE_OBJECT));
+  filtered = gtk_filter_list_model_new (list, GTK_FILTER (filter));
+
+  list_expr = gtk_object_expression_new (G_OBJECT (filtered));
+  filter_expr = gtk_property_expression_new (GTK_TYPE_FILTER_LIST_MODEL, list_expr, "filter");
+  expr = gtk_property_expression_new (GTK_TYPE_STRING_FILTER, filter_expr, "search");
+
+  watch = gtk_expression_watch (expr, NULL, inc_counter, &counter, NULL);
+
+  g_object_freeze_notify (G_OBJECT (filtered));
+  gtk_filter_list_model_set_filter (filtered, NULL);
+  filter = gtk_string_filter_new (NULL);
+  gtk_filter_list_model_set_filter (filtered, GTK_FILTER (filter));
+  g_object_unref (filter);
+  g_assert_cmpint (counter, ==, 0);
+  g_object_thaw_notify (G_OBJECT (filtered));
+  g_assert_cmpint (counter, ==, 1);
+  counter = 0;
+
+  gtk_string_filter_set_search (filter, "salad");
+  g_assert_cmpint (counter, ==, 1);
+
+  gtk_expression_watch_unwatch (watch);
+
+  g_object_unref (filtered);
+  gtk_expression_unref (expr);
+}
+
 /* This test uses the same setup as the last test, but
  * passes the filter as the "this" object when creating
  * the watch.
@@ -716,6 +812,8 @@ main (int argc, char *argv[])
   g_test_add_func ("/expression/constant-watch-this-destroyed", test_constant_watch_this_destroyed);
   g_test_add_func ("/expression/object", test_object);
   g_test_add_func ("/expression/nested", test_nested);
+  g_test_add_func ("/expression/nested-same-object", test_nested_same_object);
+  g_test_add_func ("/expression/nested-object-replaced", test_nested_object_replaced);
   g_test_add_func ("/expression/nested-this-destroyed", test_nested_this_destroyed);
   g_test_add_func ("/expression/type-mismatch", test_type_mismatch);
   g_test_add_func ("/expression/this", test_this);
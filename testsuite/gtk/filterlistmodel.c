@@ -376,6 +376,137 @@ test_incremental (void)
   g_object_unref (filter);
 }
 
+static gboolean
+is_smaller_than_limit (gpointer item,
+                       gpointer data)
+{
+  guint *limit = data;
+
+  return GPOINTER_TO_UINT (g_object_get_qdata (item, number_quark)) < *limit;
+}
+
+static void
+test_strictness (gconstpointer data)
+{
+  gboolean incremental = GPOINTER_TO_INT (data);
+  GtkFilterListModel *filter;
+  GtkFilter *custom;
+  guint limit = 8;
+
+  filter = new_model (10, is_smaller_than_limit, &limit);
+  gtk_filter_list_model_set_incremental (filter, incremental);
+  custom = gtk_filter_list_model_get_filter (filter);
+  assert_model (filter, "1 2 3 4 5 6 7");
+  assert_changes (filter, "");
+
+  /* only the matched items are retested, and they stay visible meanwhile */
+  limit = 5;
+  gtk_filter_changed (custom, GTK_FILTER_CHANGE_MORE_STRICT);
+  if (incremental)
+    {
+      assert_model (filter, "1 2 3 4 5 6 7");
+      assert_changes (filter, "");
+      while (g_main_context_pending (NULL))
+        g_main_context_iteration (NULL, TRUE);
+    }
+  assert_model (filter, "1 2 3 4");
+  assert_changes (filter, "4-3");
+
+  limit = 7;
+  gtk_filter_changed (custom, GTK_FILTER_CHANGE_LESS_STRICT);
+  if (incremental)
+    {
+      assert_model (filter, "1 2 3 4");
+      assert_changes (filter, "");
+      while (g_main_context_pending (NULL))
+        g_main_context_iteration (NULL, TRUE);
+    }
+  assert_model (filter, "1 2 3 4 5 6");
+  assert_changes (filter, "4+2");
+
+  g_object_unref (filter);
+}
+
+#define PERF_N_ITEMS 1000000
+
+/* Types a search into a string filter one character at a time, which
+ * makes the filter stricter with every keystroke, and compares it with
+ * filtering the whole list for every keystroke.
+ */
+static void
+test_strictness_perf (void)
+{
+  const char *search[] = { "1", "12", "123", "1234", "12345" };
+  GtkFilterListModel *filter;
+  GtkStringFilter *string_filter;
+  GtkStringList *list;
+  double stricter, different;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < PERF_N_ITEMS; i++)
+    {
+      char *s = g_strdup_printf ("%u", g_test_rand_int ());
+      gtk_string_list_take (list, s);
+    }
+
+  string_filter = gtk_string_filter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string"));
+  filter = gtk_filter_list_model_new (G_LIST_MODEL (list), g_object_ref (GTK_FILTER (string_filter)));
+
+  g_test_timer_start ();
+  for (i = 0; i < G_N_ELEMENTS (search); i++)
+    gtk_string_filter_set_search (string_filter, search[i]);
+  stricter = g_test_timer_elapsed ();
+
+  g_test_timer_start ();
+  for (i = 0; i < G_N_ELEMENTS (search); i++)
+    {
+      /* clearing the search matches everything without filtering */
+      gtk_string_filter_set_search (string_filter, NULL);
+      gtk_string_filter_set_search (string_filter, search[i]);
+    }
+  different = g_test_timer_elapsed ();
+
+  g_test_minimized_result (stricter,
+                           "typing \"%s\" over %u items: %gms, refiltering everything: %gms",
+                           search[G_N_ELEMENTS (search) - 1], PERF_N_ITEMS,
+                           stricter * 1000, different * 1000);
+
+  g_object_unref (filter);
+  g_object_unref (string_filter);
+}
+
+static void
+test_incremental_finish (void)
+{
+  GtkFilterListModel *filter;
+  GtkFilter *custom;
+
+  filter = new_model (1000, is_larger_than, GUINT_TO_POINTER (10000));
+  gtk_filter_list_model_set_incremental (filter, TRUE);
+  assert_model (filter, "");
+  assert_changes (filter, "");
+
+  custom = GTK_FILTER (gtk_custom_filter_new (is_near, GUINT_TO_POINTER (512), NULL));
+  gtk_filter_list_model_set_filter (filter, custom);
+  g_object_unref (custom);
+  assert_changes (filter, "");
+
+  /* turning incremental off finishes the filtering right away */
+  gtk_filter_list_model_set_incremental (filter, FALSE);
+  g_assert_cmpuint (gtk_filter_list_model_get_pending (filter), ==, 0);
+  assert_model (filter, "510 511 512 513 514");
+  assert_changes (filter, "0+5");
+
+  g_object_unref (filter);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -389,6 +520,10 @@ main (int argc, char *argv[])
   g_test_add_func ("/filterlistmodel/empty_set_filter", test_empty_set_filter);
   g_test_add_func ("/filterlistmodel/change_filter", test_change_filter);
   g_test_add_func ("/filterlistmodel/incremental", test_incremental);
+  g_test_add_func ("/filterlistmodel/incremental/finish", test_incremental_finish);
+  g_test_add_data_func ("/filterlistmodel/strictness", GINT_TO_POINTER (FALSE), test_strictness);
+  g_test_add_data_func ("/filterlistmodel/incremental/strictness", GINT_TO_POINTER (TRUE), test_strictness);
+  g_test_add_func ("/filterlistmodel/strictness/perf", test_strictness_perf);
 
   return g_test_run ();
 }
@@ -6827,6 +6827,82 @@ test_row_changed (void)
 }
 
 
+static int incremental_threshold;
+
+static gboolean
+incremental_visible_func (GtkTreeModel *model,
+                          GtkTreeIter  *iter,
+                          gpointer      data)
+{
+  int value;
+
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+
+  return value < incremental_threshold;
+}
+
+static void
+run_main_loop (void)
+{
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+}
+
+static void
+test_incremental_refilter (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *filter;
+  GtkTreeIter iter, child;
+  int i;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  for (i = 0; i < 2000; i++)
+    {
+      gtk_tree_store_insert_with_values (store, &iter, NULL, -1, 0, i, -1);
+      gtk_tree_store_insert_with_values (store, &child, &iter, -1, 0, i, -1);
+    }
+
+  incremental_threshold = G_MAXINT;
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          incremental_visible_func,
+                                          NULL, NULL);
+  gtk_tree_model_filter_set_incremental (GTK_TREE_MODEL_FILTER (filter), TRUE);
+  g_assert_true (gtk_tree_model_filter_get_incremental (GTK_TREE_MODEL_FILTER (filter)));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 2000);
+
+  /* Nothing happens until the main loop runs */
+  incremental_threshold = 10;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 2000);
+
+  run_main_loop ();
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 10);
+  g_assert_true (gtk_tree_model_get_iter_first (filter, &iter));
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, &iter), ==, 1);
+
+  /* Turning it off finishes the refilter */
+  incremental_threshold = 5;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_main_context_iteration (NULL, FALSE);
+  gtk_tree_model_filter_set_incremental (GTK_TREE_MODEL_FILTER (filter), FALSE);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 5);
+
+  /* Changing the model while refiltering */
+  gtk_tree_model_filter_set_incremental (GTK_TREE_MODEL_FILTER (filter), TRUE);
+  incremental_threshold = 1000;
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+  g_main_context_iteration (NULL, FALSE);
+  g_assert_true (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  gtk_tree_store_remove (store, &iter);
+  run_main_loop ();
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 999);
+
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -7190,4 +7266,6 @@ register_filter_model_tests (void)
                    specific_bug_679910);
 
   g_test_add_func ("/TreeModelFilter/signal/row-changed", test_row_changed);
+
+  g_test_add_func ("/TreeModelFilter/incremental/refilter", test_incremental_refilter);
 }
@@ -394,6 +394,42 @@ test_submodel_remove (void)
   g_object_unref (flat);
 }
 
+/* Reads the model between all changes, so looking up items
+ * has to cope with the submodels around it changing. */
+static void
+test_submodel_lookup (void)
+{
+  GtkFlattenListModel *flat;
+  GListStore *model, *store[3];
+
+  model = g_list_store_new (G_TYPE_LIST_MODEL);
+  store[0] = add_store (model, 1, 3, 1);
+  store[1] = add_store (model, 5, 4, 1);
+  store[2] = add_store (model, 10, 12, 1);
+  flat = new_model (model);
+  assert_model (flat, "1 2 3 10 11 12");
+  assert_changes (flat, "");
+
+  insert (store[1], 0, 4);
+  assert_model (flat, "1 2 3 4 10 11 12");
+  assert_changes (flat, "+3");
+
+  g_list_store_remove (store[0], 0);
+  assert_model (flat, "2 3 4 10 11 12");
+  assert_changes (flat, "-0");
+
+  insert (store[2], 0, 9);
+  assert_model (flat, "2 3 4 9 10 11 12");
+  assert_changes (flat, "+3");
+
+  g_list_store_remove (model, 0);
+  assert_model (flat, "4 9 10 11 12");
+  assert_changes (flat, "0-2");
+
+  g_object_unref (model);
+  g_object_unref (flat);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -411,6 +447,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/flattenlistmodel/submodel/add2", test_submodel_add2);
   g_test_add_func ("/flattenlistmodel/model/remove", test_model_remove);
   g_test_add_func ("/flattenlistmodel/submodel/remove", test_submodel_remove);
+  g_test_add_func ("/flattenlistmodel/submodel/lookup", test_submodel_lookup);
 #endif
 
   return g_test_run ();
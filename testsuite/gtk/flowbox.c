@@ -48,12 +48,131 @@ test_measure_crash (void)
   gtk_window_destroy (GTK_WINDOW (window));
 }
 
+static GtkWidget *
+create_label (gpointer item,
+              gpointer data)
+{
+  int *count = data;
+
+  (*count)++;
+
+  return gtk_label_new (gtk_string_object_get_string (GTK_STRING_OBJECT (item)));
+}
+
+static int
+count_children (GtkFlowBox *box)
+{
+  GtkWidget *child;
+  int n_children = 0;
+
+  for (child = gtk_widget_get_first_child (GTK_WIDGET (box));
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      if (GTK_IS_FLOW_BOX_CHILD (child) && gtk_widget_get_child_visible (child))
+        n_children++;
+    }
+
+  return n_children;
+}
+
+static void
+wait_for_layout (void)
+{
+  gboolean done = FALSE;
+
+  g_timeout_add (500, main_loop_quit_cb, &done);
+  while (!done)
+    g_main_context_iteration (NULL, FALSE);
+}
+
+static void
+test_virtualized (void)
+{
+  GtkWidget *window, *sw;
+  GtkFlowBox *box;
+  GtkFlowBoxChild *child;
+  GtkStringList *model;
+  GtkAdjustment *adjustment;
+  int i, count;
+  char *s;
+
+  model = gtk_string_list_new (NULL);
+  for (i = 0; i < 10000; i++)
+    {
+      s = g_strdup_printf ("%d", i);
+      gtk_string_list_append (model, s);
+      g_free (s);
+    }
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+  sw = gtk_scrolled_window_new ();
+  gtk_window_set_child (GTK_WINDOW (window), sw);
+  box = GTK_FLOW_BOX (gtk_flow_box_new ());
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), GTK_WIDGET (box));
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw));
+  gtk_flow_box_set_vadjustment (box, adjustment);
+
+  count = 0;
+  gtk_flow_box_set_virtualized (box, TRUE);
+  g_assert_true (gtk_flow_box_get_virtualized (box));
+  gtk_flow_box_bind_model (box, G_LIST_MODEL (model), create_label, &count, NULL);
+
+  show_and_wait (window);
+
+  /* Only the lines around the visible ones have children */
+  g_assert_cmpint (count, <, 500);
+  g_assert_cmpint (count_children (box), <, 500);
+  child = gtk_flow_box_get_child_at_index (box, 0);
+  g_assert_nonnull (child);
+  g_assert_cmpint (gtk_flow_box_child_get_index (child), ==, 0);
+  g_assert_null (gtk_flow_box_get_child_at_index (box, 9999));
+
+  /* Selecting all selects the items without children, too */
+  gtk_flow_box_set_selection_mode (box, GTK_SELECTION_MULTIPLE);
+  gtk_flow_box_select_all (box);
+  g_assert_true (gtk_flow_box_child_is_selected (child));
+
+  gtk_adjustment_set_value (adjustment,
+                            gtk_adjustment_get_upper (adjustment) -
+                            gtk_adjustment_get_page_size (adjustment));
+  wait_for_layout ();
+
+  g_assert_cmpint (count_children (box), <, 500);
+  child = gtk_flow_box_get_child_at_index (box, 9999);
+  g_assert_nonnull (child);
+  g_assert_cmpint (gtk_flow_box_child_get_index (child), ==, 9999);
+  g_assert_true (gtk_flow_box_child_is_selected (child));
+
+  gtk_flow_box_unselect_all (box);
+  g_assert_false (gtk_flow_box_child_is_selected (child));
+  g_assert_null (gtk_flow_box_get_selected_children (box));
+
+  /* Model changes are picked up */
+  gtk_adjustment_set_value (adjustment, 0);
+  gtk_string_list_splice (model, 0, 0, (const char *[]) { "new", NULL });
+  wait_for_layout ();
+
+  child = gtk_flow_box_get_child_at_index (box, 0);
+  g_assert_nonnull (child);
+  g_assert_cmpstr (gtk_label_get_label (GTK_LABEL (gtk_flow_box_child_get_child (child))), ==, "new");
+
+  gtk_string_list_splice (model, 0, g_list_model_get_n_items (G_LIST_MODEL (model)), NULL);
+  g_assert_cmpint (count_children (box), ==, 0);
+  g_assert_null (gtk_flow_box_get_child_at_index (box, 0));
+
+  gtk_window_destroy (GTK_WINDOW (window));
+  g_object_unref (model);
+}
+
 int
 main (int argc, char *argv[])
 {
   gtk_test_init (&argc, &argv);
 
   g_test_add_func ("/flowbox/measure-crash", test_measure_crash);
+  g_test_add_func ("/flowbox/virtualized", test_virtualized);
 
   return g_test_run ();
 }
@@ -130,6 +130,43 @@ test_attach (void)
   g_assert_cmpint (height, ==,  3);
 }
 
+/* test that identical labels share their size, but
+ * a label that only differs in its attributes does not
+ */
+static void
+test_measure_shared (void)
+{
+  GtkWidget *grid, *small, *big;
+  PangoAttrList *attrs;
+  int i, min, nat, small_nat, big_nat;
+
+  grid = gtk_grid_new ();
+  g_object_ref_sink (grid);
+
+  for (i = 0; i < 3; i++)
+    {
+      small = gtk_label_new ("Label");
+      gtk_grid_attach (GTK_GRID (grid), small, 0, i, 1, 1);
+    }
+
+  big = gtk_label_new ("Label");
+  attrs = pango_attr_list_new ();
+  pango_attr_list_insert (attrs, pango_attr_scale_new (3.0));
+  gtk_label_set_attributes (GTK_LABEL (big), attrs);
+  pango_attr_list_unref (attrs);
+  gtk_grid_attach (GTK_GRID (grid), big, 0, 3, 1, 1);
+
+  gtk_widget_measure (grid, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat, NULL, NULL);
+
+  gtk_widget_measure (small, GTK_ORIENTATION_HORIZONTAL, -1, NULL, &small_nat, NULL, NULL);
+  gtk_widget_measure (big, GTK_ORIENTATION_HORIZONTAL, -1, NULL, &big_nat, NULL, NULL);
+
+  g_assert_cmpint (small_nat, <, big_nat);
+  g_assert_cmpint (nat, ==, big_nat);
+
+  g_object_unref (grid);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -137,6 +174,7 @@ main (int   argc,
   gtk_test_init (&argc, &argv);
 
   g_test_add_func ("/grid/attach", test_attach);
+  g_test_add_func ("/grid/measure-shared", test_measure_shared);
 
   return g_test_run();
 }
@@ -652,6 +652,27 @@ test_size (void)
   assert_icon_lookup_size ("size-test", 45, GTK_TEXT_DIR_NONE, 0, FALSE, "/icons/35+/size-test.svg", 45);
 }
 
+static void
+test_preload (void)
+{
+  const char *names[] = { "size-test", "simple", NULL };
+  GtkIconTheme *theme;
+  GtkIconPaintable *first, *second;
+
+  theme = get_test_icontheme (FALSE);
+
+  gtk_icon_theme_preload_icons (theme, names, 16, 1, GTK_TEXT_DIR_NONE, 0);
+
+  /* Both lookups find the icon that was preloaded */
+  first = gtk_icon_theme_lookup_icon (theme, "size-test", NULL, 16, 1, GTK_TEXT_DIR_NONE, 0);
+  second = gtk_icon_theme_lookup_icon (theme, "size-test", NULL, 16, 1, GTK_TEXT_DIR_NONE, GTK_ICON_LOOKUP_PRELOAD);
+  g_assert_true (first == second);
+  g_assert_cmpstr (gtk_icon_paintable_get_icon_name (first), ==, "size-test");
+
+  g_object_unref (first);
+  g_object_unref (second);
+}
+
 static void
 test_list (void)
 {
@@ -813,6 +834,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/icontheme/svg-size", test_svg_size);
   g_test_add_func ("/icontheme/size", test_size);
   g_test_add_func ("/icontheme/list", test_list);
+  g_test_add_func ("/icontheme/preload", test_preload);
   g_test_add_func ("/icontheme/inherit", test_inherit);
   g_test_add_func ("/icontheme/nonsquare-symbolic", test_nonsquare_symbolic);
 
@@ -442,6 +442,136 @@ test_header (void)
   g_object_unref (list);
 }
 
+static gboolean
+main_loop_quit_cb (gpointer data)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+
+  g_main_context_wakeup (NULL);
+
+  return FALSE;
+}
+
+static void
+wait_for_layout (void)
+{
+  gboolean done = FALSE;
+
+  g_timeout_add (500, main_loop_quit_cb, &done);
+  while (!done)
+    g_main_context_iteration (NULL, FALSE);
+}
+
+static GtkWidget *
+create_label (gpointer item,
+              gpointer data)
+{
+  int *count = data;
+
+  (*count)++;
+
+  return gtk_label_new (gtk_string_object_get_string (GTK_STRING_OBJECT (item)));
+}
+
+static int
+count_rows (GtkListBox *list)
+{
+  GtkWidget *row;
+  int n_rows = 0;
+
+  for (row = gtk_widget_get_first_child (GTK_WIDGET (list));
+       row != NULL;
+       row = gtk_widget_get_next_sibling (row))
+    {
+      if (GTK_IS_LIST_BOX_ROW (row) && gtk_widget_get_child_visible (row))
+        n_rows++;
+    }
+
+  return n_rows;
+}
+
+static void
+test_virtualized (void)
+{
+  GtkWidget *window, *sw;
+  GtkListBox *list;
+  GtkListBoxRow *row;
+  GtkStringList *model;
+  GtkAdjustment *adjustment;
+  int i, count;
+  char *s;
+
+  model = gtk_string_list_new (NULL);
+  for (i = 0; i < 10000; i++)
+    {
+      s = g_strdup_printf ("%d", i);
+      gtk_string_list_append (model, s);
+      g_free (s);
+    }
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+  sw = gtk_scrolled_window_new ();
+  gtk_window_set_child (GTK_WINDOW (window), sw);
+  list = GTK_LIST_BOX (gtk_list_box_new ());
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), GTK_WIDGET (list));
+
+  count = 0;
+  gtk_list_box_set_virtualized (list, TRUE);
+  g_assert_true (gtk_list_box_get_virtualized (list));
+  gtk_list_box_bind_model (list, G_LIST_MODEL (model), create_label, &count, NULL);
+
+  gtk_widget_show (window);
+  wait_for_layout ();
+
+  /* Only the rows around the visible ones exist */
+  g_assert_cmpint (count, <, 100);
+  g_assert_cmpint (count_rows (list), <, 100);
+  row = gtk_list_box_get_row_at_index (list, 0);
+  g_assert_nonnull (row);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, 0);
+  g_assert_null (gtk_list_box_get_row_at_index (list, 9999));
+
+  /* Selecting all selects the items without rows, too */
+  gtk_list_box_set_selection_mode (list, GTK_SELECTION_MULTIPLE);
+  gtk_list_box_select_all (list);
+  g_assert_true (gtk_list_box_row_is_selected (row));
+
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw));
+  gtk_adjustment_set_value (adjustment,
+                            gtk_adjustment_get_upper (adjustment) -
+                            gtk_adjustment_get_page_size (adjustment));
+  wait_for_layout ();
+
+  g_assert_cmpint (count_rows (list), <, 100);
+  row = gtk_list_box_get_row_at_index (list, 9999);
+  g_assert_nonnull (row);
+  g_assert_cmpint (gtk_list_box_row_get_index (row), ==, 9999);
+  g_assert_true (gtk_list_box_row_is_selected (row));
+
+  gtk_list_box_unselect_all (list);
+  g_assert_false (gtk_list_box_row_is_selected (row));
+  g_assert_null (gtk_list_box_get_selected_rows (list));
+
+  /* Model changes are picked up */
+  gtk_adjustment_set_value (adjustment, 0);
+  gtk_string_list_splice (model, 0, 0, (const char *[]) { "new", NULL });
+  wait_for_layout ();
+
+  row = gtk_list_box_get_row_at_index (list, 0);
+  g_assert_nonnull (row);
+  g_assert_cmpstr (gtk_label_get_label (GTK_LABEL (gtk_list_box_row_get_child (row))), ==, "new");
+
+  gtk_string_list_splice (model, 0, g_list_model_get_n_items (G_LIST_MODEL (model)), NULL);
+  g_assert_cmpint (count_rows (list), ==, 0);
+  g_assert_null (gtk_list_box_get_row_at_index (list, 0));
+
+  gtk_window_destroy (GTK_WINDOW (window));
+  g_object_unref (model);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -452,6 +582,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/listbox/multi-selection", test_multi_selection);
   g_test_add_func ("/listbox/filter", test_filter);
   g_test_add_func ("/listbox/header", test_header);
+  g_test_add_func ("/listbox/virtualized", test_virtualized);
 
   return g_test_run ();
 }
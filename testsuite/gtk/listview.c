@@ -0,0 +1,169 @@
+/* GtkListView tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#define N_ITEMS 2000
+
+typedef struct {
+  gboolean bound[N_ITEMS];
+} BoundItems;
+
+static void
+setup_item (GtkSignalListItemFactory *factory,
+            GtkListItem              *item,
+            gpointer                  data)
+{
+  gtk_list_item_set_child (item, gtk_label_new (NULL));
+}
+
+static void
+bind_item (GtkSignalListItemFactory *factory,
+           GtkListItem              *item,
+           BoundItems               *items)
+{
+  guint pos = gtk_list_item_get_position (item);
+
+  g_assert_false (items->bound[pos]);
+  items->bound[pos] = TRUE;
+}
+
+static void
+unbind_item (GtkSignalListItemFactory *factory,
+             GtkListItem              *item,
+             BoundItems               *items)
+{
+  guint pos = gtk_list_item_get_position (item);
+
+  g_assert_true (items->bound[pos]);
+  items->bound[pos] = FALSE;
+}
+
+/* Returns the first and last bound item, and checks that the
+ * bound items are contiguous
+ */
+static guint
+get_bound_range (BoundItems *items,
+                 guint      *first,
+                 guint      *last)
+{
+  guint i, n;
+
+  n = 0;
+  *first = *last = 0;
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      if (!items->bound[i])
+        continue;
+
+      if (n == 0)
+        *first = i;
+      *last = i;
+      n++;
+    }
+
+  g_assert_cmpuint (n, ==, *last - *first + 1);
+
+  return n;
+}
+
+static GtkWidget *
+create_list_view (BoundItems *items)
+{
+  GtkStringList *strings;
+  GtkListItemFactory *factory;
+  GtkWidget *view;
+  guint i;
+
+  strings = gtk_string_list_new (NULL);
+  for (i = 0; i < N_ITEMS; i++)
+    {
+      char *s = g_strdup_printf ("%u", i);
+      gtk_string_list_append (strings, s);
+      g_free (s);
+    }
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_item), NULL);
+  g_signal_connect (factory, "bind", G_CALLBACK (bind_item), items);
+  g_signal_connect (factory, "unbind", G_CALLBACK (unbind_item), items);
+
+  view = gtk_list_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (strings))),
+                            factory);
+  g_object_ref_sink (view);
+
+  return view;
+}
+
+static void
+test_prefetch (void)
+{
+  BoundItems *items;
+  GtkWidget *view;
+  guint n, n_anchor, first, last, anchor_first, anchor_last;
+
+  items = g_new0 (BoundItems, 1);
+  view = create_list_view (items);
+
+  n_anchor = get_bound_range (items, &first, &last);
+  g_assert_cmpuint (n_anchor, >, 0);
+  g_assert_cmpuint (n_anchor, <, N_ITEMS / 4);
+
+  /* Nothing is prefetched before the list moved */
+  gtk_list_view_set_prefetch (GTK_LIST_VIEW (view), 50);
+  g_assert_cmpuint (get_bound_range (items, &first, &last), ==, n_anchor);
+
+  /* Scrolling down prefetches items below the anchor */
+  gtk_widget_activate_action (view, "list.scroll-to-item", "u", N_ITEMS / 2);
+  n = get_bound_range (items, &first, &last);
+  g_assert_cmpuint (n, ==, n_anchor + 50);
+
+  gtk_list_view_set_prefetch (GTK_LIST_VIEW (view), 0);
+  g_assert_cmpuint (get_bound_range (items, &anchor_first, &anchor_last), ==, n_anchor);
+  g_assert_cmpuint (first, ==, anchor_first);
+  g_assert_cmpuint (last, ==, anchor_last + 50);
+
+  /* Changing the size of the window applies right away */
+  gtk_list_view_set_prefetch (GTK_LIST_VIEW (view), 50);
+  gtk_list_view_set_prefetch (GTK_LIST_VIEW (view), 80);
+  n = get_bound_range (items, &first, &last);
+  g_assert_cmpuint (n, ==, n_anchor + 80);
+  g_assert_cmpuint (first, ==, anchor_first);
+  g_assert_cmpuint (last, ==, anchor_last + 80);
+
+  /* Scrolling up prefetches items above the anchor */
+  gtk_widget_activate_action (view, "list.scroll-to-item", "u", N_ITEMS / 4);
+  n = get_bound_range (items, &first, &last);
+  g_assert_cmpuint (n, ==, n_anchor + 80);
+
+  gtk_list_view_set_prefetch (GTK_LIST_VIEW (view), 20);
+  g_assert_cmpuint (get_bound_range (items, &anchor_first, &anchor_last), ==, n_anchor + 20);
+  g_assert_cmpuint (anchor_first, ==, first + 60);
+  g_assert_cmpuint (anchor_last, ==, last);
+
+  g_object_unref (view);
+  g_free (items);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/listview/prefetch", test_prefetch);
+
+  return g_test_run ();
+}
@@ -468,6 +468,43 @@ test_readd (void)
   g_object_unref (selection);
 }
 
+static void
+test_append (void)
+{
+  GtkSelectionModel *selection;
+  GListStore *store;
+  gboolean ret;
+
+  store = new_store (1, 5, 1);
+
+  selection = new_model (store);
+  ret = gtk_selection_model_select_range (selection, 1, 2, FALSE);
+  g_assert_true (ret);
+  assert_selection (selection, "2 3");
+  assert_selection_changes (selection, "1:2");
+
+  /* changes after the selection don't move it */
+  add (store, 6);
+  assert_changes (selection, "+5");
+  assert_selection (selection, "2 3");
+
+  splice (store, 4, 2, (guint[]) { 7, 8, 9 }, 3);
+  assert_changes (selection, "4-2+3");
+  assert_selection (selection, "2 3");
+
+  /* but changes before it still do */
+  splice (store, 0, 1, NULL, 0);
+  assert_changes (selection, "-0");
+  assert_selection (selection, "2 3");
+
+  g_list_model_items_changed (G_LIST_MODEL (store), 0, 3, 3);
+  assert_changes (selection, "0-3+3");
+  assert_selection (selection, "2 3");
+
+  g_object_unref (store);
+  g_object_unref (selection);
+}
+
 static void
 test_set_selection (void)
 {
@@ -688,6 +725,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/multiselection/selection", test_selection);
   g_test_add_func ("/multiselection/select-range", test_select_range);
   g_test_add_func ("/multiselection/readd", test_readd);
+  g_test_add_func ("/multiselection/append", test_append);
   g_test_add_func ("/multiselection/set_selection", test_set_selection);
   g_test_add_func ("/multiselection/selection-filter", test_selection_filter);
   g_test_add_func ("/multiselection/set-model", test_set_model);
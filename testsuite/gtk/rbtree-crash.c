@@ -289,6 +289,57 @@ test_crash2 (void)
   gtk_rb_tree_unref (tree);
 }
 
+static guint
+get_depth (Node *node)
+{
+  if (node == NULL)
+    return 0;
+
+  return 1 + MAX (get_depth (gtk_rb_tree_node_get_left (node)),
+                  get_depth (gtk_rb_tree_node_get_right (node)));
+}
+
+static void
+test_populate (void)
+{
+  GtkRbTree *tree;
+  Node *node;
+  guint n, i;
+
+  for (n = 0; n < 100; n++)
+    {
+      tree = gtk_rb_tree_new (Node, Aug, augment, NULL, NULL);
+
+      node = gtk_rb_tree_populate (tree, n);
+      g_assert_true (node == gtk_rb_tree_get_first (tree));
+
+      for (i = 0; node; i++)
+        node = gtk_rb_tree_node_get_next (node);
+      g_assert_cmpuint (i, ==, n);
+
+      if (n > 0)
+        {
+          Aug *aug = gtk_rb_tree_get_augment (tree, gtk_rb_tree_get_root (tree));
+          g_assert_cmpuint (aug->n_items, ==, n);
+        }
+
+      /* the rebalancing must keep working on the built tree */
+      for (i = 0; i < n; i++)
+        {
+          add (tree, g_test_rand_int_range (0, n + i + 1));
+          delete (tree, g_test_rand_int_range (0, n + i + 1));
+          add (tree, g_test_rand_int_range (0, n + i + 1));
+        }
+
+      g_assert_cmpuint (get_depth (gtk_rb_tree_get_root (tree)), <=, 2 * g_bit_storage (2 * n + 1));
+
+      gtk_rb_tree_remove_all (tree);
+      g_assert_null (gtk_rb_tree_get_root (tree));
+
+      gtk_rb_tree_unref (tree);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -297,6 +348,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/rbtree/crash", test_crash);
   g_test_add_func ("/rbtree/crash2", test_crash2);
+  g_test_add_func ("/rbtree/populate", test_populate);
 
   return g_test_run ();
 }
@@ -0,0 +1,90 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+static void
+append_colors (GtkSnapshot *snapshot)
+{
+  GdkRGBA red = { 1, 0, 0, 1 };
+  GdkRGBA blue = { 0, 0, 1, 1 };
+
+  gtk_snapshot_append_color (snapshot, &red, &GRAPHENE_RECT_INIT (0, 0, 10, 10));
+  gtk_snapshot_append_color (snapshot, &blue, &GRAPHENE_RECT_INIT (10, 0, 10, 10));
+}
+
+/* Pushes that don't change anything must not add nodes,
+ * not even containers.
+ */
+static void
+test_trivial_push (void)
+{
+  GtkSnapshot *snapshot;
+  GskRenderNode *node;
+  graphene_matrix_t matrix;
+
+  snapshot = gtk_snapshot_new ();
+
+  gtk_snapshot_push_opacity (snapshot, 1.0);
+  gtk_snapshot_push_blur (snapshot, 0.0);
+  graphene_matrix_init_identity (&matrix);
+  gtk_snapshot_push_color_matrix (snapshot, &matrix, graphene_vec4_zero ());
+  gtk_snapshot_push_debug (snapshot, "debug");
+  append_colors (snapshot);
+  gtk_snapshot_pop (snapshot);
+  gtk_snapshot_pop (snapshot);
+  gtk_snapshot_pop (snapshot);
+  gtk_snapshot_pop (snapshot);
+
+  node = gtk_snapshot_free_to_node (snapshot);
+
+  g_assert_cmpint (gsk_render_node_get_node_type (node), ==, GSK_CONTAINER_NODE);
+  g_assert_cmpint (gsk_container_node_get_n_children (node), ==, 2);
+  g_assert_cmpint (gsk_render_node_get_node_type (gsk_container_node_get_child (node, 0)), ==, GSK_COLOR_NODE);
+  g_assert_cmpint (gsk_render_node_get_node_type (gsk_container_node_get_child (node, 1)), ==, GSK_COLOR_NODE);
+
+  gsk_render_node_unref (node);
+}
+
+static void
+test_opacity_push (void)
+{
+  GtkSnapshot *snapshot;
+  GskRenderNode *node;
+
+  snapshot = gtk_snapshot_new ();
+
+  gtk_snapshot_push_opacity (snapshot, 0.5);
+  append_colors (snapshot);
+  gtk_snapshot_pop (snapshot);
+
+  node = gtk_snapshot_free_to_node (snapshot);
+
+  g_assert_cmpint (gsk_render_node_get_node_type (node), ==, GSK_OPACITY_NODE);
+  g_assert_cmpint (gsk_render_node_get_node_type (gsk_opacity_node_get_child (node)), ==, GSK_CONTAINER_NODE);
+
+  gsk_render_node_unref (node);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/snapshot/trivial-push", test_trivial_push);
+  g_test_add_func ("/snapshot/opacity-push", test_opacity_push);
+
+  return g_test_run ();
+}
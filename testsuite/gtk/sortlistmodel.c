@@ -372,6 +372,56 @@ test_add_items (void)
   g_object_unref (sort);
 }
 
+/* Appending to the store is what log viewers and chats do.
+ * Make sure the keys growing does not get in the way of
+ * reporting exactly where the new items went. */
+static void
+test_append_items (void)
+{
+  GtkSortListModel *sort;
+  GListStore *store;
+  GString *expected;
+  guint i;
+
+  store = new_store ((guint[]) { 10, 20, 30, 0 });
+  sort = new_model (store);
+  assert_model (sort, "10 20 30");
+  assert_changes (sort, "");
+
+  add (store, 40);
+  assert_model (sort, "10 20 30 40");
+  assert_changes (sort, "+3");
+  add (store, 25);
+  assert_model (sort, "10 20 25 30 40");
+  assert_changes (sort, "+2");
+  add (store, 5);
+  assert_model (sort, "5 10 20 25 30 40");
+  assert_changes (sort, "+0");
+  splice (store, 6, 0, (guint[]) { 50, 35 }, 2);
+  assert_model (sort, "5 10 20 25 30 35 40 50");
+  assert_changes (sort, "5-1+3");
+
+  expected = g_string_new ("5 10 20 25 30 35 40 50");
+  for (i = 0; i < 1000; i++)
+    {
+      GString *changes = g_object_get_qdata (G_OBJECT (sort), changes_quark);
+      char *change;
+
+      add (store, 100 + i);
+      g_string_append_printf (expected, " %u", 100 + i);
+      g_assert_cmpuint (get (G_LIST_MODEL (sort), 8 + i), ==, 100 + i);
+      change = g_strdup_printf ("+%u", 8 + i);
+      g_assert_cmpstr (changes->str, ==, change);
+      g_free (change);
+      ignore_changes (sort);
+    }
+  assert_model (sort, expected->str);
+
+  g_string_free (expected, TRUE);
+  g_object_unref (store);
+  g_object_unref (sort);
+}
+
 static void
 test_remove_items (void)
 {
@@ -434,6 +484,42 @@ test_stability (void)
   g_object_unref (sort);
 }
 
+/* Test that keys of sorters that stay in a multisorter are
+ * reused correctly when sorters are added and removed.
+ */
+static void
+test_multi_sorter_keys (void)
+{
+  GtkSortListModel *sort;
+  GListStore *store;
+  GtkMultiSorter *multi;
+
+  store = new_store ((guint[]) { 12, 1, 22, 11, 2, 21, 0 });
+  multi = gtk_multi_sorter_new ();
+  gtk_multi_sorter_append (multi, GTK_SORTER (gtk_custom_sorter_new (compare, NULL, NULL)));
+  sort = gtk_sort_list_model_new (g_object_ref (G_LIST_MODEL (store)), g_object_ref (GTK_SORTER (multi)));
+  assert_model (sort, "1 2 11 12 21 22");
+
+  gtk_multi_sorter_append (multi, GTK_SORTER (gtk_custom_sorter_new (compare_modulo, GUINT_TO_POINTER (10), NULL)));
+  assert_model (sort, "1 2 11 12 21 22");
+
+  gtk_multi_sorter_remove (multi, 0);
+  assert_model (sort, "1 11 21 12 22 2");
+
+  gtk_multi_sorter_append (multi, GTK_SORTER (gtk_custom_sorter_new (compare, NULL, NULL)));
+  assert_model (sort, "1 11 21 2 12 22");
+
+  splice (store, 0, 1, (guint[]) { 31, 3 }, 2);
+  assert_model (sort, "1 11 21 31 2 22 3");
+
+  gtk_multi_sorter_remove (multi, 0);
+  assert_model (sort, "1 2 3 11 21 22 31");
+
+  g_object_unref (multi);
+  g_object_unref (store);
+  g_object_unref (sort);
+}
+
 static GListStore *
 new_shuffled_store (guint size)
 {
@@ -517,6 +603,49 @@ test_incremental_remove (void)
   g_object_unref (removed);
 }
 
+static guint
+get_number (GObject *object)
+{
+  return GPOINTER_TO_UINT (g_object_get_qdata (object, number_quark));
+}
+
+/* Large sorts with a numeric sorter are split across threads,
+ * check that they still end up sorted with a single change.
+ */
+static void
+test_threaded (void)
+{
+  GListStore *store;
+  GtkSortListModel *model;
+  GtkSorter *sorter;
+  GString *changes;
+  guint i;
+  const guint n_items = 100000;
+
+  store = new_shuffled_store (n_items);
+  model = new_model (store);
+  ignore_changes (model);
+
+  sorter = GTK_SORTER (gtk_numeric_sorter_new (gtk_cclosure_expression_new (G_TYPE_UINT,
+                                                                            NULL,
+                                                                            0, NULL,
+                                                                            G_CALLBACK (get_number),
+                                                                            NULL, NULL)));
+  gtk_numeric_sorter_set_sort_order (GTK_NUMERIC_SORTER (sorter), GTK_SORT_DESCENDING);
+  gtk_sort_list_model_set_sorter (model, sorter);
+  g_object_unref (sorter);
+
+  for (i = 0; i < n_items; i++)
+    g_assert_cmpuint (n_items - i, ==, get (G_LIST_MODEL (model), i));
+
+  changes = g_object_get_qdata (G_OBJECT (model), changes_quark);
+  g_assert_null (strchr (changes->str, ','));
+  ignore_changes (model);
+
+  g_object_unref (store);
+  g_object_unref (model);
+}
+
 static void
 test_out_of_bounds_access (void)
 {
@@ -549,10 +678,13 @@ main (int argc, char *argv[])
   g_test_add_func ("/sortlistmodel/set-sorter", test_set_sorter);
 #if GLIB_CHECK_VERSION (2, 58, 0) /* g_list_store_splice() is broken before 2.58 */
   g_test_add_func ("/sortlistmodel/add_items", test_add_items);
+  g_test_add_func ("/sortlistmodel/append_items", test_append_items);
   g_test_add_func ("/sortlistmodel/remove_items", test_remove_items);
 #endif
   g_test_add_func ("/sortlistmodel/stability", test_stability);
+  g_test_add_func ("/sortlistmodel/multi-sorter-keys", test_multi_sorter_keys);
   g_test_add_func ("/sortlistmodel/incremental/remove", test_incremental_remove);
+  g_test_add_func ("/sortlistmodel/threaded", test_threaded);
   g_test_add_func ("/sortlistmodel/oob-access", test_out_of_bounds_access);
 
   return g_test_run ();
@@ -0,0 +1,160 @@
+/* GtkStack tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+typedef struct {
+  guint n_created;
+  guint n_freed;
+  GtkStackPage *page;
+} LazyData;
+
+static GtkWidget *
+create_page (GtkStackPage *page,
+             gpointer      user_data)
+{
+  LazyData *data = user_data;
+
+  data->n_created++;
+  data->page = page;
+
+  return gtk_label_new ("lazy");
+}
+
+static void
+free_data (gpointer user_data)
+{
+  LazyData *data = user_data;
+
+  data->n_freed++;
+}
+
+static void
+show_page (GtkStack   *stack,
+           const char *name)
+{
+  gtk_stack_set_visible_child_full (stack, name, GTK_STACK_TRANSITION_TYPE_NONE);
+}
+
+static void
+test_lazy_create_once (void)
+{
+  GtkWidget *stack, *first, *last, *placeholder, *child;
+  GtkStackPage *page;
+  LazyData data = { 0, };
+
+  stack = g_object_ref_sink (gtk_stack_new ());
+  first = gtk_label_new ("first");
+  last = gtk_label_new ("last");
+
+  gtk_stack_add_named (GTK_STACK (stack), first, "first");
+  page = gtk_stack_add_lazy (GTK_STACK (stack), "lazy", "Lazy",
+                             create_page, &data, free_data);
+  gtk_stack_add_named (GTK_STACK (stack), last, "last");
+
+  /* Adding the page does not create its child */
+  g_assert_cmpuint (data.n_created, ==, 0);
+  g_assert_cmpuint (data.n_freed, ==, 0);
+  g_assert_true (gtk_stack_get_visible_child (GTK_STACK (stack)) == first);
+
+  placeholder = gtk_stack_page_get_child (page);
+  g_assert_nonnull (placeholder);
+  g_object_ref (placeholder);
+  g_assert_true (gtk_widget_get_parent (placeholder) == stack);
+  g_assert_true (gtk_stack_get_child_by_name (GTK_STACK (stack), "lazy") == placeholder);
+
+  /* Neither does showing other pages */
+  show_page (GTK_STACK (stack), "last");
+  g_assert_cmpuint (data.n_created, ==, 0);
+
+  show_page (GTK_STACK (stack), "lazy");
+  g_assert_cmpuint (data.n_created, ==, 1);
+  g_assert_cmpuint (data.n_freed, ==, 1);
+  g_assert_true (data.page == page);
+
+  /* The child takes the place of the placeholder */
+  child = gtk_stack_page_get_child (page);
+  g_assert_true (GTK_IS_LABEL (child));
+  g_assert_null (gtk_widget_get_parent (placeholder));
+  g_assert_true (gtk_widget_get_parent (child) == stack);
+  g_assert_true (gtk_widget_get_prev_sibling (child) == first);
+  g_assert_true (gtk_widget_get_next_sibling (child) == last);
+  g_assert_true (gtk_stack_get_visible_child (GTK_STACK (stack)) == child);
+  g_assert_true (gtk_stack_get_child_by_name (GTK_STACK (stack), "lazy") == child);
+  g_assert_true (gtk_stack_get_page (GTK_STACK (stack), child) == page);
+  g_assert_cmpstr (gtk_stack_page_get_title (page), ==, "Lazy");
+
+  /* Showing the page again does not create it again */
+  show_page (GTK_STACK (stack), "first");
+  show_page (GTK_STACK (stack), "lazy");
+  g_assert_cmpuint (data.n_created, ==, 1);
+  g_assert_cmpuint (data.n_freed, ==, 1);
+  g_assert_true (gtk_stack_page_get_child (page) == child);
+
+  g_object_unref (placeholder);
+  g_object_unref (stack);
+
+  g_assert_cmpuint (data.n_freed, ==, 1);
+}
+
+static void
+test_lazy_first_page (void)
+{
+  GtkWidget *stack;
+  GtkStackPage *page;
+  LazyData data = { 0, };
+
+  stack = g_object_ref_sink (gtk_stack_new ());
+
+  /* The first page of a stack is shown right away */
+  page = gtk_stack_add_lazy (GTK_STACK (stack), "lazy", NULL,
+                             create_page, &data, free_data);
+  g_assert_cmpuint (data.n_created, ==, 1);
+  g_assert_cmpuint (data.n_freed, ==, 1);
+  g_assert_true (gtk_stack_get_visible_child (GTK_STACK (stack)) == gtk_stack_page_get_child (page));
+
+  g_object_unref (stack);
+}
+
+static void
+test_lazy_never_shown (void)
+{
+  GtkWidget *stack;
+  LazyData data = { 0, };
+
+  stack = g_object_ref_sink (gtk_stack_new ());
+  gtk_stack_add_named (GTK_STACK (stack), gtk_label_new ("first"), "first");
+  gtk_stack_add_lazy (GTK_STACK (stack), "lazy", NULL,
+                      create_page, &data, free_data);
+
+  g_object_unref (stack);
+
+  /* The user data is freed without ever calling the function */
+  g_assert_cmpuint (data.n_created, ==, 0);
+  g_assert_cmpuint (data.n_freed, ==, 1);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/stack/lazy/create-once", test_lazy_create_once);
+  g_test_add_func ("/stack/lazy/first-page", test_lazy_first_page);
+  g_test_add_func ("/stack/lazy/never-shown", test_lazy_never_shown);
+
+  return g_test_run ();
+}
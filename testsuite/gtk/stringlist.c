@@ -230,6 +230,34 @@ test_take (void)
   g_object_unref (list);
 }
 
+static void
+test_get_item (void)
+{
+  GtkStringList *list;
+  GtkStringObject *item, *again;
+
+  list = new_model ((const char *[]){ "a", "b", "c", NULL });
+
+  /* objects are created on demand, but stay the same afterwards */
+  g_assert_cmpstr (gtk_string_list_get_string (list, 1), ==, "b");
+  item = g_list_model_get_item (G_LIST_MODEL (list), 1);
+  g_assert_cmpstr (gtk_string_object_get_string (item), ==, "b");
+  g_assert_cmpstr (gtk_string_list_get_string (list, 1), ==, "b");
+  again = g_list_model_get_item (G_LIST_MODEL (list), 1);
+  g_assert_true (item == again);
+  g_object_unref (again);
+
+  /* and outlive the list */
+  gtk_string_list_remove (list, 1);
+  assert_changes (list, "-1");
+  g_assert_cmpstr (gtk_string_object_get_string (item), ==, "b");
+  g_object_unref (item);
+
+  assert_model (list, "a c");
+
+  g_object_unref (list);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -244,6 +272,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/stringlist/splice", test_splice);
   g_test_add_func ("/stringlist/add_remove", test_add_remove);
   g_test_add_func ("/stringlist/take", test_take);
+  g_test_add_func ("/stringlist/get_item", test_get_item);
 
   return g_test_run ();
 }
@@ -17,6 +17,7 @@
  * Authors: Tristan Van Berkom <tristanvb@openismus.com>
  */
 #include <gtk/gtk.h>
+#include <string.h>
 
 #ifdef HAVE_UNIX_PRINT_WIDGETS
 #  include <gtk/gtkunixprint.h>
@@ -388,6 +389,91 @@ test_font_chooser_dialog_show (void)
   gtk_window_destroy (GTK_WINDOW (widget));
 }
 
+#define MY_TYPE_LAZY_BOX (my_lazy_box_get_type ())
+#define MY_LAZY_BOX(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), MY_TYPE_LAZY_BOX, MyLazyBox))
+
+#define MY_LAZY_BOX_TEMPLATE \
+"<interface>\n" \
+" <template class=\"MyLazyBox\" parent=\"GtkBox\">\n" \
+"  <child>\n" \
+"   <object class=\"GtkLabel\" id=\"first\"/>\n" \
+"  </child>\n" \
+"  <child>\n" \
+"   <object class=\"GtkBox\" id=\"lazy\" lazy=\"true\">\n" \
+"    <child>\n" \
+"     <object class=\"GtkButton\" id=\"button\"/>\n" \
+"    </child>\n" \
+"   </object>\n" \
+"  </child>\n" \
+"  <child>\n" \
+"   <object class=\"GtkLabel\" id=\"last\"/>\n" \
+"  </child>\n" \
+" </template>\n" \
+"</interface>\n"
+
+typedef struct
+{
+  GtkBox parent_instance;
+  GtkWidget *first;
+  GtkWidget *lazy;
+  GtkWidget *last;
+} MyLazyBox;
+
+typedef GtkBoxClass MyLazyBoxClass;
+
+G_DEFINE_TYPE (MyLazyBox, my_lazy_box, GTK_TYPE_BOX)
+
+static void
+my_lazy_box_init (MyLazyBox *box)
+{
+  gtk_widget_init_template (GTK_WIDGET (box));
+}
+
+static void
+my_lazy_box_class_init (MyLazyBoxClass *klass)
+{
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+  GBytes *template;
+
+  template = g_bytes_new_static (MY_LAZY_BOX_TEMPLATE, strlen (MY_LAZY_BOX_TEMPLATE));
+  gtk_widget_class_set_template (widget_class, template);
+  g_bytes_unref (template);
+
+  gtk_widget_class_bind_template_child (widget_class, MyLazyBox, first);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyBox, lazy);
+  gtk_widget_class_bind_template_child (widget_class, MyLazyBox, last);
+}
+
+static void
+test_lazy_child (void)
+{
+  MyLazyBox *box;
+  GObject *lazy;
+
+  box = g_object_new (MY_TYPE_LAZY_BOX, NULL);
+  g_object_ref_sink (box);
+
+  g_assert (GTK_IS_LABEL (box->first));
+  g_assert (GTK_IS_LABEL (box->last));
+  g_assert (box->lazy == NULL);
+  g_assert (gtk_widget_get_next_sibling (box->first) == box->last);
+
+  lazy = gtk_widget_get_template_child (GTK_WIDGET (box), MY_TYPE_LAZY_BOX, "lazy");
+  g_assert (GTK_IS_BOX (lazy));
+  g_assert (box->lazy == GTK_WIDGET (lazy));
+  g_assert (GTK_IS_BUTTON (gtk_widget_get_first_child (box->lazy)));
+
+  /* It is built in place, between the labels */
+  g_assert (gtk_widget_get_parent (box->lazy) == GTK_WIDGET (box));
+  g_assert (gtk_widget_get_prev_sibling (box->lazy) == box->first);
+  g_assert (gtk_widget_get_next_sibling (box->lazy) == box->last);
+
+  /* Only once */
+  g_assert (gtk_widget_get_template_child (GTK_WIDGET (box), MY_TYPE_LAZY_BOX, "lazy") == lazy);
+
+  g_object_unref (box);
+}
+
 #ifdef HAVE_UNIX_PRINT_WIDGETS
 static void
 test_page_setup_unix_dialog_basic (void)
@@ -474,6 +560,7 @@ main (int argc, char **argv)
   g_test_add_func ("/template/GtkFontChooserWidget/basic", test_font_chooser_widget_basic);
   g_test_add_func ("/template/GtkFontChooserDialog/basic", test_font_chooser_dialog_basic);
   g_test_add_func ("/template/GtkFontChooserDialog/show", test_font_chooser_dialog_show);
+  g_test_add_func ("/template/lazy-child", test_lazy_child);
 
 #ifdef HAVE_UNIX_PRINT_WIDGETS
   g_test_add_func ("/template/GtkPageSetupUnixDialog/basic", test_page_setup_unix_dialog_basic);
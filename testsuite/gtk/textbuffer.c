@@ -1581,6 +1581,336 @@ test_get_iter (void)
   g_object_unref (buffer);
 }
 
+static char *
+create_bulk_text (guint size)
+{
+  const char *pieces[] = { "a", "bc", " ", "\xc3\xa4", "\xe2\x82\xac", "\n", "\r\n", "\r", "\xe2\x80\xa9" };
+  GString *str;
+
+  str = g_string_sized_new (size + 4);
+  while (str->len < size)
+    g_string_append (str, pieces[g_test_rand_int_range (0, G_N_ELEMENTS (pieces))]);
+
+  return g_string_free (str, FALSE);
+}
+
+static int
+count_paragraphs (const char *text)
+{
+  int len = strlen (text);
+  int n, pos, delim, eol;
+
+  for (n = 1, pos = 0; pos < len; pos += eol)
+    {
+      pango_find_paragraph_boundary (text + pos, len - pos, &delim, &eol);
+      if (delim != eol)
+        n++;
+    }
+
+  return n;
+}
+
+/* Large insertions create their segments in threads, which
+ * is skipped while debug flags are set.
+ */
+static void
+test_bulk_insert (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end, iter;
+  char *text, *expected, *contents;
+  GtkDebugFlags flags;
+  guint size;
+
+  size = (g_get_num_processors () + 1) * 64 * 1024 + g_test_rand_int_range (0, 4096);
+  text = create_bulk_text (size);
+  expected = g_strconcat ("ab", text, "cd", NULL);
+
+  flags = gtk_get_debug_flags ();
+  gtk_set_debug_flags (0);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "abcd", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 2);
+  gtk_text_buffer_insert (buffer, &iter, text, -1);
+
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, 2 + g_utf8_strlen (text, -1));
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, g_utf8_strlen (expected, -1));
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, count_paragraphs (expected));
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  contents = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+  g_assert_cmpstr (contents, ==, expected);
+  g_free (contents);
+
+  gtk_set_debug_flags (flags);
+
+  g_object_unref (buffer);
+  g_free (expected);
+  g_free (text);
+}
+
+static void
+test_bulk_insert_perf (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  GtkDebugFlags flags;
+  double bulk, single, lines;
+  char *text;
+  int len, pos, delim, eol;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  text = create_bulk_text (64 * 1024 * 1024);
+  len = strlen (text);
+
+  flags = gtk_get_debug_flags ();
+  gtk_set_debug_flags (0);
+
+  buffer = gtk_text_buffer_new (NULL);
+  g_test_timer_start ();
+  gtk_text_buffer_set_text (buffer, text, len);
+  bulk = g_test_timer_elapsed ();
+  g_object_unref (buffer);
+
+  /* the same text without splitting it over threads */
+  gtk_set_debug_flags (GTK_DEBUG_NO_THREADS);
+  buffer = gtk_text_buffer_new (NULL);
+  g_test_timer_start ();
+  gtk_text_buffer_set_text (buffer, text, len);
+  single = g_test_timer_elapsed ();
+  g_object_unref (buffer);
+  gtk_set_debug_flags (0);
+
+  /* what streaming the text in a line at a time costs */
+  buffer = gtk_text_buffer_new (NULL);
+  g_test_timer_start ();
+  for (pos = 0; pos < len; pos += eol)
+    {
+      pango_find_paragraph_boundary (text + pos, len - pos, &delim, &eol);
+      gtk_text_buffer_get_end_iter (buffer, &iter);
+      gtk_text_buffer_insert (buffer, &iter, text + pos, eol);
+    }
+  lines = g_test_timer_elapsed ();
+  g_object_unref (buffer);
+
+  gtk_set_debug_flags (flags);
+
+  g_test_minimized_result (bulk,
+                           "inserting %d bytes: %gms at once, %gms on one thread, %gms line by line",
+                           len, bulk * 1000, single * 1000, lines * 1000);
+
+  g_free (text);
+}
+
+static void
+set_flag (gpointer data)
+{
+  *(gboolean *) data = TRUE;
+}
+
+static void
+test_set_text_from_bytes (void)
+{
+  const char *text = "a line that is long enough to be borrowed\n"
+                     "another line of borrowed text, with \xc3\xa4 in it\n"
+                     "short\n"
+                     "the last line without a newline at the end";
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  gboolean freed = FALSE;
+  GBytes *bytes;
+  char *data;
+
+  data = g_strdup (text);
+  bytes = g_bytes_new_with_free_func (data, strlen (data), set_flag, &freed);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text_from_bytes (buffer, bytes);
+  g_bytes_unref (bytes);
+  g_assert_false (freed);
+  check_buffer_contents (buffer, text);
+  g_assert_cmpint (gtk_text_buffer_get_line_count (buffer), ==, 4);
+
+  /* editing copies the edited line only */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 1, 8);
+  gtk_text_buffer_insert (buffer, &start, "EDIT", -1);
+  check_buffer_contents (buffer,
+                         "a line that is long enough to be borrowed\n"
+                         "another EDITline of borrowed text, with \xc3\xa4 in it\n"
+                         "short\n"
+                         "the last line without a newline at the end");
+
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 0, 2);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &end, 0, 7);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 3, 4);
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &end, 3, 9);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  check_buffer_contents (buffer,
+                         "a that is long enough to be borrowed\n"
+                         "another EDITline of borrowed text, with \xc3\xa4 in it\n"
+                         "short\n"
+                         "the line without a newline at the end");
+
+  /* the text is not needed anymore once it is gone from the buffer */
+  gtk_text_buffer_set_text (buffer, "", -1);
+  g_assert_true (freed);
+
+  g_object_unref (buffer);
+}
+
+static void
+count_apply_tag (GtkTextBuffer     *buffer,
+                 GtkTextTag        *tag,
+                 const GtkTextIter *start,
+                 const GtkTextIter *end,
+                 gpointer           data)
+{
+  int *count = data;
+
+  (*count)++;
+}
+
+static void
+check_tag_ranges (GtkTextBuffer *buffer,
+                  GtkTextTag    *tag,
+                  const char    *expected)
+{
+  GtkTextIter iter;
+  int i;
+
+  for (i = 0; expected[i]; i++)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, i);
+      g_assert_cmpint (gtk_text_iter_has_tag (&iter, tag), ==, expected[i] == 'x');
+    }
+}
+
+static void
+test_apply_tag_ranges (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextTag *bold, *red;
+  GtkTextIter start, end;
+  GtkTextTagRange ranges[4];
+  gulong handler;
+  int count = 0;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, "int main (void)\n{\n  return 0;\n}\n", -1);
+
+  bold = gtk_text_buffer_create_tag (buffer, NULL, "weight", PANGO_WEIGHT_BOLD, NULL);
+  red = gtk_text_buffer_create_tag (buffer, NULL, "foreground", "red", NULL);
+
+  ranges[0] = (GtkTextTagRange) { bold, 0, 3 };
+  ranges[1] = (GtkTextTagRange) { red, 4, 8 };
+  ranges[2] = (GtkTextTagRange) { bold, 10, 14 };
+  ranges[3] = (GtkTextTagRange) { bold, 20, 26 };
+
+  gtk_text_buffer_apply_tag_ranges (buffer, ranges, G_N_ELEMENTS (ranges));
+
+  check_tag_ranges (buffer, bold, "xxx_______xxxx______xxxxxx___");
+  check_tag_ranges (buffer, red,  "____xxxx_____________________");
+
+  /* The result is the same as applying the tags one by one */
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  gtk_text_buffer_remove_all_tags (buffer, &start, &end);
+  check_tag_ranges (buffer, bold, "_____________________________");
+
+  handler = g_signal_connect (buffer, "apply-tag", G_CALLBACK (count_apply_tag), &count);
+  gtk_text_buffer_apply_tag_ranges (buffer, ranges, G_N_ELEMENTS (ranges));
+  g_assert_cmpint (count, ==, G_N_ELEMENTS (ranges));
+  g_signal_handler_disconnect (buffer, handler);
+
+  check_tag_ranges (buffer, bold, "xxx_______xxxx______xxxxxx___");
+  check_tag_ranges (buffer, red,  "____xxxx_____________________");
+
+  g_object_unref (buffer);
+}
+
+static void
+insert_user_action (GtkTextBuffer *buffer,
+                    const char    *text)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_begin_user_action (buffer);
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  gtk_text_buffer_insert (buffer, &iter, text, -1);
+  gtk_text_buffer_end_user_action (buffer);
+}
+
+static char *
+get_all_text (GtkTextBuffer *buffer)
+{
+  GtkTextIter start, end;
+
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+
+  return gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+}
+
+static void
+test_undo_size (void)
+{
+  GtkTextBuffer *buffer;
+  const int n_texts = 8;
+  char *texts[8];
+  GString *expected;
+  char *contents;
+  int i;
+
+  buffer = gtk_text_buffer_new (NULL);
+  g_assert_cmpuint (gtk_text_buffer_get_max_undo_size (buffer), ==, 0);
+
+  /* Large enough to be compressed once they are a few actions deep */
+  expected = g_string_new (NULL);
+  for (i = 0; i < n_texts; i++)
+    {
+      texts[i] = g_strnfill (4096 + i, 'a' + i);
+      insert_user_action (buffer, texts[i]);
+      g_string_append (expected, texts[i]);
+    }
+
+  for (i = n_texts - 1; i >= 0; i--)
+    {
+      g_assert_true (gtk_text_buffer_get_can_undo (buffer));
+      gtk_text_buffer_undo (buffer);
+    }
+  g_assert_false (gtk_text_buffer_get_can_undo (buffer));
+  g_assert_cmpint (gtk_text_buffer_get_char_count (buffer), ==, 0);
+
+  for (i = 0; i < n_texts; i++)
+    gtk_text_buffer_redo (buffer);
+
+  contents = get_all_text (buffer);
+  g_assert_cmpstr (contents, ==, expected->str);
+  g_free (contents);
+
+  /* With a tiny budget only the most recent action is kept */
+  gtk_text_buffer_set_max_undo_size (buffer, 1);
+  g_assert_cmpuint (gtk_text_buffer_get_max_undo_size (buffer), ==, 1);
+  insert_user_action (buffer, texts[0]);
+  g_assert_true (gtk_text_buffer_get_can_undo (buffer));
+  gtk_text_buffer_undo (buffer);
+  g_assert_false (gtk_text_buffer_get_can_undo (buffer));
+
+  contents = get_all_text (buffer);
+  g_assert_cmpstr (contents, ==, expected->str);
+  g_free (contents);
+
+  for (i = 0; i < n_texts; i++)
+    g_free (texts[i]);
+  g_string_free (expected, TRUE);
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1600,6 +1930,11 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Tag", test_tag);
   g_test_add_func ("/TextBuffer/Clipboard", test_clipboard);
   g_test_add_func ("/TextBuffer/Get iter", test_get_iter);
+  g_test_add_func ("/TextBuffer/Bulk insert", test_bulk_insert);
+  g_test_add_func ("/TextBuffer/Bulk insert performance", test_bulk_insert_perf);
+  g_test_add_func ("/TextBuffer/Set text from bytes", test_set_text_from_bytes);
+  g_test_add_func ("/TextBuffer/Apply tag ranges", test_apply_tag_ranges);
+  g_test_add_func ("/TextBuffer/Undo size", test_undo_size);
 
   return g_test_run();
 }
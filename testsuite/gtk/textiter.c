@@ -780,6 +780,111 @@ test_backward_line (void)
   g_object_unref (buffer);
 }
 
+static GtkTextBuffer *
+create_numbered_buffer (int n_lines)
+{
+  GtkTextBuffer *buffer;
+  GString *str;
+  int i;
+
+  str = g_string_new (NULL);
+  for (i = 0; i < n_lines; i++)
+    g_string_append_printf (str, "line %d\n", i);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, str->str, str->len);
+  g_string_free (str, TRUE);
+
+  return buffer;
+}
+
+static int
+numbered_line_offset (int line)
+{
+  int offset = 0;
+  int i;
+
+  for (i = 0; i < line; i++)
+    offset += strlen ("line \n") + (i < 10 ? 1 : i < 100 ? 2 : i < 1000 ? 3 : 4);
+
+  return offset;
+}
+
+static void
+test_line_index (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  int lines[] = { 0, 1, 2, 5, 4, 3, 500, 501, 499, 1000, 999, 12, 13, 11, 1999 };
+  guint i;
+
+  buffer = create_numbered_buffer (2000);
+
+  /* Mix line number and offset lookups, going back and forth,
+   * so that both work from each other's cached results */
+  for (i = 0; i < G_N_ELEMENTS (lines); i++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, lines[i]);
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, numbered_line_offset (lines[i]));
+
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, numbered_line_offset (lines[i]) + 2);
+      g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, lines[i]);
+      g_assert_cmpint (gtk_text_iter_get_line_offset (&iter), ==, 2);
+    }
+
+  for (i = 0; i < 2000; i++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, i);
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, numbered_line_offset (i));
+    }
+
+  /* Edits must not leave stale results behind */
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 1000);
+  gtk_text_buffer_insert (buffer, &iter, "x\ny\n", -1);
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, 1003);
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, numbered_line_offset (1001) + 4);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, numbered_line_offset (1001) + 4);
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, 1003);
+
+  g_object_unref (buffer);
+}
+
+static void
+test_line_index_perf (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  int n_lines = 100000;
+  guint64 sum = 0;
+  double elapsed;
+  int offset;
+  int i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("only run with -m perf");
+      return;
+    }
+
+  buffer = create_numbered_buffer (n_lines);
+
+  /* What a highlighter does: walk the lines converting back and forth */
+  g_test_timer_start ();
+  for (i = 0; i < n_lines; i++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, i);
+      offset = gtk_text_iter_get_offset (&iter);
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, offset + 1);
+      sum += offset + gtk_text_iter_get_line (&iter);
+    }
+  elapsed = g_test_timer_elapsed ();
+
+  g_test_minimized_result (elapsed, "%d lines: %.3f ms (%" G_GUINT64_FORMAT ")",
+                           n_lines, elapsed * 1000., sum);
+
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -797,6 +902,8 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Visible Cursor Positions", test_visible_cursor_positions);
   g_test_add_func ("/TextIter/Sentence Boundaries", test_sentence_boundaries);
   g_test_add_func ("/TextIter/Backward line", test_backward_line);
+  g_test_add_func ("/TextIter/Line index", test_line_index);
+  g_test_add_func ("/TextIter/Line index performance", test_line_index_perf);
 
   return g_test_run();
 }
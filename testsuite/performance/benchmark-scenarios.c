@@ -0,0 +1,382 @@
+/* Workloads for the benchmarks run by test-performance.
+ *
+ * Each scenario builds a window, changes something on every frame
+ * for a fixed number of frames and then quits, so that the profiler
+ * marks GTK emits along the way can be collected for each phase.
+ */
+
+#include <gtk/gtk.h>
+#include <string.h>
+
+static char *opt_scenario;
+static char *opt_node;
+static int opt_frames = 300;
+
+static GOptionEntry options[] = {
+  { "scenario", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_scenario, "Scenario to run", "NAME" },
+  { "frames", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &opt_frames, "Number of frames to run", "COUNT" },
+  { "node", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &opt_node, "Render node file for node-replay", "FILE" },
+  { NULL, }
+};
+
+/* A widget drawing a fixed render node, optionally blurred */
+
+typedef struct
+{
+  GtkWidget parent_instance;
+
+  GskRenderNode *node;
+  float blur_radius;
+} NodeWidget;
+
+typedef GtkWidgetClass NodeWidgetClass;
+
+static GType node_widget_get_type (void);
+G_DEFINE_TYPE (NodeWidget, node_widget, GTK_TYPE_WIDGET)
+
+static void
+node_widget_snapshot (GtkWidget   *widget,
+                      GtkSnapshot *snapshot)
+{
+  NodeWidget *self = (NodeWidget *) widget;
+
+  if (self->node == NULL)
+    return;
+
+  if (self->blur_radius > 0)
+    gtk_snapshot_push_blur (snapshot, self->blur_radius);
+
+  gtk_snapshot_append_node (snapshot, self->node);
+
+  if (self->blur_radius > 0)
+    gtk_snapshot_pop (snapshot);
+}
+
+static void
+node_widget_finalize (GObject *object)
+{
+  NodeWidget *self = (NodeWidget *) object;
+
+  g_clear_pointer (&self->node, gsk_render_node_unref);
+
+  G_OBJECT_CLASS (node_widget_parent_class)->finalize (object);
+}
+
+static void
+node_widget_class_init (NodeWidgetClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = node_widget_finalize;
+  klass->snapshot = node_widget_snapshot;
+}
+
+static void
+node_widget_init (NodeWidget *self)
+{
+  gtk_widget_set_hexpand (GTK_WIDGET (self), TRUE);
+  gtk_widget_set_vexpand (GTK_WIDGET (self), TRUE);
+}
+
+/* list-scroll: scroll a long list view up and down */
+
+static void
+setup_list_item (GtkSignalListItemFactory *factory,
+                 GtkListItem              *item)
+{
+  gtk_list_item_set_child (item, gtk_label_new (NULL));
+}
+
+static void
+bind_list_item (GtkSignalListItemFactory *factory,
+                GtkListItem              *item)
+{
+  GtkStringObject *string = gtk_list_item_get_item (item);
+
+  gtk_label_set_label (GTK_LABEL (gtk_list_item_get_child (item)),
+                       gtk_string_object_get_string (string));
+}
+
+static GtkWidget *
+create_list_scroll (void)
+{
+  GtkStringList *strings;
+  GtkListItemFactory *factory;
+  GtkWidget *sw;
+  guint i;
+
+  strings = gtk_string_list_new (NULL);
+  for (i = 0; i < 100000; i++)
+    {
+      char *s = g_strdup_printf ("Item %u", i);
+      gtk_string_list_append (strings, s);
+      g_free (s);
+    }
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_list_item), NULL);
+  g_signal_connect (factory, "bind", G_CALLBACK (bind_list_item), NULL);
+
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw),
+                                 gtk_list_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (strings))),
+                                                    factory));
+
+  return sw;
+}
+
+static void
+step_list_scroll (GtkWidget *sw,
+                  guint      frame)
+{
+  GtkAdjustment *adjustment;
+  double fraction;
+
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw));
+  fraction = (frame % 100) / 100.;
+  gtk_adjustment_set_value (adjustment,
+                            gtk_adjustment_get_lower (adjustment) +
+                            fraction * (gtk_adjustment_get_upper (adjustment) -
+                                        gtk_adjustment_get_page_size (adjustment)));
+}
+
+/* css-restyle: toggle a style class that affects many descendants */
+
+static GtkWidget *
+create_css_restyle (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *grid;
+  int x, y;
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   ".restyled button { color: red; padding: 4px; }"
+                                   ".restyled button label { font-weight: bold; }",
+                                   -1);
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (provider),
+                                              GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+  g_object_unref (provider);
+
+  grid = gtk_grid_new ();
+  for (y = 0; y < 30; y++)
+    for (x = 0; x < 30; x++)
+      {
+        char *label = g_strdup_printf ("%d", x + 30 * y);
+        gtk_grid_attach (GTK_GRID (grid), gtk_button_new_with_label (label), x, y, 1, 1);
+        g_free (label);
+      }
+
+  return grid;
+}
+
+static void
+step_css_restyle (GtkWidget *grid,
+                  guint      frame)
+{
+  if (frame % 2)
+    gtk_widget_add_css_class (grid, "restyled");
+  else
+    gtk_widget_remove_css_class (grid, "restyled");
+}
+
+/* text-load: replace the contents of a text view */
+
+static GtkWidget *
+create_text_load (void)
+{
+  GtkWidget *sw;
+
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), gtk_text_view_new ());
+
+  return sw;
+}
+
+static void
+step_text_load (GtkWidget *sw,
+                guint      frame)
+{
+  static GString *text;
+  GtkWidget *view;
+
+  if (text == NULL)
+    {
+      guint i;
+
+      text = g_string_new (NULL);
+      for (i = 0; i < 5000; i++)
+        g_string_append_printf (text, "Line %u: The quick brown fox jumps over the lazy dog.\n", i);
+    }
+
+  view = gtk_scrolled_window_get_child (GTK_SCROLLED_WINDOW (sw));
+  gtk_text_buffer_set_text (gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)),
+                            text->str + frame % 64,
+                            text->len - frame % 64);
+}
+
+/* blur: blur a fixed node with a changing radius */
+
+static GtkWidget *
+create_blur (void)
+{
+  NodeWidget *self;
+  GtkSnapshot *snapshot;
+  int x, y;
+
+  self = g_object_new (node_widget_get_type (), NULL);
+
+  snapshot = gtk_snapshot_new ();
+  for (y = 0; y < 20; y++)
+    for (x = 0; x < 20; x++)
+      gtk_snapshot_append_color (snapshot,
+                                 &(GdkRGBA) { x / 20., y / 20., (x + y) % 2, 1 },
+                                 &GRAPHENE_RECT_INIT (x * 40, y * 30, 40, 30));
+  self->node = gtk_snapshot_free_to_node (snapshot);
+
+  return GTK_WIDGET (self);
+}
+
+static void
+step_blur (GtkWidget *widget,
+           guint      frame)
+{
+  NodeWidget *self = (NodeWidget *) widget;
+
+  self->blur_radius = 1 + frame % 16;
+  gtk_widget_queue_draw (widget);
+}
+
+/* node-replay: draw a recorded render node over and over */
+
+static void
+node_parse_error (const GtkCssSection *section,
+                  const GError        *error,
+                  gpointer             user_data)
+{
+  g_printerr ("Error parsing %s: %s\n", opt_node, error->message);
+}
+
+static GtkWidget *
+create_node_replay (void)
+{
+  NodeWidget *self;
+  GError *error = NULL;
+  char *contents;
+  gsize length;
+  GBytes *bytes;
+
+  if (opt_node == NULL)
+    g_error ("node-replay needs --node");
+
+  if (!g_file_get_contents (opt_node, &contents, &length, &error))
+    g_error ("%s", error->message);
+
+  self = g_object_new (node_widget_get_type (), NULL);
+
+  bytes = g_bytes_new_take (contents, length);
+  self->node = gsk_render_node_deserialize (bytes, node_parse_error, NULL);
+  g_bytes_unref (bytes);
+
+  if (self->node == NULL)
+    g_error ("Could not load %s", opt_node);
+
+  return GTK_WIDGET (self);
+}
+
+static void
+step_node_replay (GtkWidget *widget,
+                  guint      frame)
+{
+  gtk_widget_queue_draw (widget);
+}
+
+static const struct {
+  const char *name;
+  GtkWidget * (* create) (void);
+  void (* step) (GtkWidget *widget, guint frame);
+} scenarios[] = {
+  { "list-scroll", create_list_scroll, step_list_scroll },
+  { "css-restyle", create_css_restyle, step_css_restyle },
+  { "text-load", create_text_load, step_text_load },
+  { "blur", create_blur, step_blur },
+  { "node-replay", create_node_replay, step_node_replay },
+};
+
+static guint scenario;
+static guint frame;
+static gboolean done;
+
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *frame_clock,
+         gpointer       user_data)
+{
+  if (frame >= opt_frames)
+    {
+      done = TRUE;
+      g_main_context_wakeup (NULL);
+      return G_SOURCE_REMOVE;
+    }
+
+  scenarios[scenario].step (widget, frame++);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+quit_cb (GtkWidget *widget,
+         gpointer   data)
+{
+  done = TRUE;
+  g_main_context_wakeup (NULL);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GtkWidget *window;
+  GtkWidget *content;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (opt_scenario == NULL)
+    opt_scenario = g_strdup (scenarios[0].name);
+
+  for (scenario = 0; scenario < G_N_ELEMENTS (scenarios); scenario++)
+    {
+      if (strcmp (scenarios[scenario].name, opt_scenario) == 0)
+        break;
+    }
+
+  if (scenario == G_N_ELEMENTS (scenarios))
+    {
+      g_printerr ("Unknown scenario: %s\n", opt_scenario);
+      return 1;
+    }
+
+  gtk_init ();
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+  g_signal_connect (window, "destroy", G_CALLBACK (quit_cb), NULL);
+
+  content = scenarios[scenario].create ();
+  gtk_window_set_child (GTK_WINDOW (window), content);
+  gtk_widget_add_tick_callback (content, tick_cb, NULL, NULL);
+
+  gtk_widget_show (window);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  return 0;
+}
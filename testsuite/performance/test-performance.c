@@ -9,10 +9,20 @@
 
 typedef struct {
   const char *mark;
+  gboolean found;
+  /* The first occurrence in each run */
+  GArray *values;
+  /* Every occurrence, in all but the first run */
+  GArray *samples;
+} Phase;
+
+typedef struct {
+  Phase *phases;
+  guint n_phases;
   const char *detail;
   gboolean do_start;
+  gboolean keep_samples;
   gint64 start_time;
-  gint64 value;
 } Data;
 
 static bool
@@ -20,19 +30,37 @@ callback (const SysprofCaptureFrame *frame,
           gpointer                   user_data)
 {
   Data *data = user_data;
+  guint i;
 
   if (frame->type == SYSPROF_CAPTURE_FRAME_MARK)
     {
       SysprofCaptureMark *mark = (SysprofCaptureMark *)frame;
-      if (strcmp (mark->group, "gtk") == 0 &&
-          strcmp (mark->name, data->mark) == 0 &&
-          (data->detail == NULL || strcmp (mark->message, data->detail) == 0))
+
+      if (strcmp (mark->group, "gtk") != 0 ||
+          (data->detail != NULL && strcmp (mark->message, data->detail) != 0))
+        return TRUE;
+
+      for (i = 0; i < data->n_phases; i++)
         {
+          Phase *phase = &data->phases[i];
+          gint64 value;
+
+          if (strcmp (mark->name, phase->mark) != 0)
+            continue;
+
           if (data->do_start)
-            data->value = frame->time - data->start_time;
+            value = frame->time - data->start_time;
           else
-            data->value = mark->duration;
-          return FALSE;
+            value = mark->duration;
+
+          if (!phase->found)
+            {
+              g_array_append_val (phase->values, value);
+              phase->found = TRUE;
+            }
+
+          if (data->keep_samples && !data->do_start)
+            g_array_append_val (phase->samples, value);
         }
     }
 
@@ -42,24 +70,83 @@ callback (const SysprofCaptureFrame *frame,
 #define MILLISECONDS(v) ((v) / (1000.0 * G_TIME_SPAN_MILLISECOND))
 
 static int opt_rep = 10;
-static char *opt_mark;
+static char **opt_marks;
 static char *opt_detail;
 static char *opt_name;
 static char *opt_output;
+static char *opt_json;
 static gboolean opt_start_time;
 static GMainLoop *main_loop;
 static GError *failure;
 
 static GOptionEntry options[] = {
-  { "mark", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_mark, "Name of the mark", "NAME" },
+  { "mark", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING_ARRAY, &opt_marks, "Name of the mark, can be repeated", "NAME" },
   { "detail", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_detail, "Detail of the mark", "DETAIL" },
   { "start", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &opt_start_time, "Measure the start time", NULL },
   { "runs", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &opt_rep, "Number of runs", "COUNT" },
   { "name", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_name, "Name of this test", "NAME" },
   { "output", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_output, "Directory to save syscap files", "DIRECTORY" },
+  { "json", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_FILENAME, &opt_json, "Save the results as JSON", "FILE" },
   { NULL, }
 };
 
+static int
+compare_values (gconstpointer a,
+                gconstpointer b)
+{
+  gint64 v1 = *(const gint64 *) a;
+  gint64 v2 = *(const gint64 *) b;
+
+  return v1 < v2 ? -1 : (v1 > v2);
+}
+
+/* Nearest-rank percentile of sorted values */
+static gint64
+percentile (GArray *values,
+            int     p)
+{
+  guint rank;
+
+  rank = (p * values->len + 99) / 100;
+  if (rank > 0)
+    rank--;
+
+  return g_array_index (values, gint64, rank);
+}
+
+static void
+append_json_stats (GString    *string,
+                   const char *name,
+                   GArray     *values)
+{
+  gint64 total = 0;
+  guint i;
+
+  if (values->len == 0)
+    {
+      g_string_append_printf (string, "\"%s\": null", name);
+      return;
+    }
+
+  g_array_sort (values, compare_values);
+
+  for (i = 0; i < values->len; i++)
+    total += g_array_index (values, gint64, i);
+
+  g_string_append_printf (string,
+                          "\"%s\": { \"count\": %u, \"min\": %g, \"max\": %g, \"mean\": %g, "
+                          "\"median\": %g, \"p90\": %g, \"p95\": %g, \"p99\": %g }",
+                          name,
+                          values->len,
+                          MILLISECONDS (g_array_index (values, gint64, 0)),
+                          MILLISECONDS (g_array_index (values, gint64, values->len - 1)),
+                          MILLISECONDS (total / values->len),
+                          MILLISECONDS (percentile (values, 50)),
+                          MILLISECONDS (percentile (values, 90)),
+                          MILLISECONDS (percentile (values, 95)),
+                          MILLISECONDS (percentile (values, 99)));
+}
+
 static gboolean
 start_in_main (gpointer data)
 {
@@ -90,9 +177,6 @@ main (int argc, char *argv[])
   GError *error = NULL;
   Data data;
   SysprofCaptureFrameType type;
-  gint64 *values;
-  gint64 min, max, total;
-  int count;
   char *output_dir = NULL;
   char **spawn_env;
   char *workdir;
@@ -100,6 +184,8 @@ main (int argc, char *argv[])
 
   context = g_option_context_new ("COMMANDLINE");
   g_option_context_add_main_entries (context, options, NULL);
+  /* Leave the options of the command alone */
+  g_option_context_set_strict_posix (context, TRUE);
   if (!g_option_context_parse (context, &argc, &argv, &error))
     g_error ("Parsing options: %s", error->message);
 
@@ -146,7 +232,22 @@ main (int argc, char *argv[])
 
   opt_rep++;
 
-  values = g_new (gint64, opt_rep);
+  if (opt_marks == NULL)
+    {
+      opt_marks = g_new0 (char *, 2);
+      opt_marks[0] = g_strdup ("css validation");
+    }
+
+  data.n_phases = g_strv_length (opt_marks);
+  data.phases = g_new0 (Phase, data.n_phases);
+  for (i = 0; i < data.n_phases; i++)
+    {
+      data.phases[i].mark = opt_marks[i];
+      data.phases[i].values = g_array_new (FALSE, FALSE, sizeof (gint64));
+      data.phases[i].samples = g_array_new (FALSE, FALSE, sizeof (gint64));
+    }
+  data.detail = opt_detail;
+  data.do_start = opt_start_time;
 
   for (i = 0; i < opt_rep; i++)
     {
@@ -198,11 +299,11 @@ main (int argc, char *argv[])
 
       sysprof_capture_writer_unref (writer);
 
-      data.mark = opt_mark ? opt_mark : "css validation";
-      data.detail = opt_detail ? opt_detail : NULL;
-      data.do_start = opt_start_time;
       data.start_time = sysprof_capture_reader_get_start_time (reader);
-      data.value = 0;
+      /* Ignore the first run, to avoid cache effects */
+      data.keep_samples = i > 0;
+      for (j = 0; j < data.n_phases; j++)
+        data.phases[j].found = FALSE;
 
       cursor = sysprof_capture_cursor_new (reader);
 
@@ -212,7 +313,14 @@ main (int argc, char *argv[])
 
       sysprof_capture_cursor_foreach (cursor, callback, &data);
 
-      values[i] = data.value;
+      for (j = 0; j < data.n_phases; j++)
+        {
+          if (!data.phases[j].found)
+            {
+              gint64 value = 0;
+              g_array_append_val (data.phases[j].values, value);
+            }
+        }
 
       sysprof_capture_cursor_unref (cursor);
       sysprof_capture_reader_unref (reader);
@@ -244,25 +352,75 @@ main (int argc, char *argv[])
 
   g_free (workdir);
 
-  min = G_MAXINT64;
-  max = 0;
-  count = 0;
-  total = 0;
+  for (i = 0; i < data.n_phases; i++)
+    {
+      Phase *phase = &data.phases[i];
+      gint64 min, max, total;
+      int count;
+
+      min = G_MAXINT64;
+      max = 0;
+      count = 0;
+      total = 0;
+
+      /* Ignore the first run, to avoid cache effects */
+      g_array_remove_index (phase->values, 0);
+
+      for (j = 0; j < phase->values->len; j++)
+        {
+          gint64 value = g_array_index (phase->values, gint64, j);
+
+          if (min > value)
+            min = value;
+          if (max < value)
+            max = value;
+          count++;
+          total += value;
+        }
+
+      if (data.n_phases > 1)
+        g_print ("%s: ", phase->mark);
+
+      g_print ("%d runs, min %g, max %g, avg %g\n",
+               count,
+               MILLISECONDS (min),
+               MILLISECONDS (max),
+               MILLISECONDS (total / count));
+    }
+
+  if (opt_json)
+    {
+      GString *json = g_string_new ("{\n");
+
+      g_string_append_printf (json, "  \"name\": \"%s\",\n", opt_name ? opt_name : "gtk");
+      g_string_append_printf (json, "  \"runs\": %d,\n", opt_rep - 1);
+      g_string_append (json, "  \"phases\": {\n");
+
+      for (i = 0; i < data.n_phases; i++)
+        {
+          Phase *phase = &data.phases[i];
+
+          g_string_append_printf (json, "    \"%s\": {\n      ", phase->mark);
+          append_json_stats (json, "runs", phase->values);
+          g_string_append (json, ",\n      ");
+          append_json_stats (json, "samples", phase->samples);
+          g_string_append_printf (json, "\n    }%s\n", i + 1 < data.n_phases ? "," : "");
+        }
+
+      g_string_append (json, "  }\n}\n");
+
+      if (!g_file_set_contents (opt_json, json->str, json->len, &error))
+        g_error ("Saving results: %s", error->message);
+
+      g_string_free (json, TRUE);
+    }
 
-  /* Ignore the first run, to avoid cache effects */
-  for (i = 1; i < opt_rep; i++)
+  for (i = 0; i < data.n_phases; i++)
     {
-      if (min > values[i])
-        min = values[i];
-      if (max < values[i])
-        max = values[i];
-      count++;
-      total += values[i];
+      g_array_unref (data.phases[i].values);
+      g_array_unref (data.phases[i].samples);
     }
+  g_free (data.phases);
 
-  g_print ("%d runs, min %g, max %g, avg %g\n",
-           count,
-           MILLISECONDS (min),
-           MILLISECONDS (max),
-           MILLISECONDS (total / count));
+  return 0;
 }
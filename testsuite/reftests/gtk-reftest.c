@@ -47,6 +47,7 @@ static char *arg_output_dir = NULL;
 static char *arg_base_dir = NULL;
 static char *arg_direction = NULL;
 static char *arg_compare_dir = NULL;
+static char *arg_cache_dir = NULL;
 
 static const GOptionEntry test_args[] = {
   { "output",         'o', 0, G_OPTION_ARG_FILENAME, &arg_output_dir,
@@ -57,6 +58,8 @@ static const GOptionEntry test_args[] = {
     "Set text direction", "ltr|rtl" },
   { "compare-with",    0, 0, G_OPTION_ARG_FILENAME, &arg_compare_dir,
     "Directory to compare with", "DIR" },
+  { "cache",           0, 0, G_OPTION_ARG_FILENAME, &arg_cache_dir,
+    "Directory to cache reference images in", "DIR" },
   { NULL }
 };
 
@@ -235,6 +238,119 @@ get_reference_image (const char *ui_file)
   return reference_image;
 }
 
+static void
+checksum_add_file (GChecksum  *checksum,
+                   const char *filename)
+{
+  char *contents;
+  gsize length;
+
+  if (filename == NULL ||
+      !g_file_get_contents (filename, &contents, &length, NULL))
+    {
+      g_checksum_update (checksum, (const guchar *) "", 1);
+      return;
+    }
+
+  g_checksum_update (checksum, (const guchar *) contents, length);
+  g_free (contents);
+}
+
+static void
+checksum_add_string (GChecksum  *checksum,
+                     const char *string)
+{
+  if (string == NULL)
+    string = "";
+
+  /* include the terminator, so that adjacent strings can't run together */
+  g_checksum_update (checksum, (const guchar *) string, strlen (string) + 1);
+}
+
+/* References are usually shared by many tests and don't change
+ * between runs, so their renderings can be kept in a cache directory.
+ * The key covers everything the rendering depends on, apart from
+ * GTK itself and the files the reference refers to, so the cache
+ * must be cleared when those change.
+ */
+static char *
+get_cached_reference_image (const char *ui_file,
+                            const char *reference_file)
+{
+  GChecksum *checksum;
+  char *css_file;
+  char *filename;
+  char *result;
+
+  if (!arg_cache_dir)
+    return NULL;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  checksum_add_string (checksum, G_STRINGIFY (GTK_MAJOR_VERSION) "."
+                                 G_STRINGIFY (GTK_MINOR_VERSION) "."
+                                 G_STRINGIFY (GTK_MICRO_VERSION));
+  checksum_add_string (checksum, g_getenv ("GSK_RENDERER"));
+  checksum_add_string (checksum, g_getenv ("GDK_RENDERING"));
+  checksum_add_string (checksum, g_getenv ("GDK_SCALE"));
+  checksum_add_string (checksum, g_getenv ("GTK_THEME"));
+  checksum_add_string (checksum, arg_direction);
+
+  css_file = get_test_file (ui_file, ".css", TRUE);
+  checksum_add_file (checksum, css_file);
+  checksum_add_file (checksum, reference_file);
+  g_free (css_file);
+
+  filename = g_strconcat (g_checksum_get_string (checksum), ".png", NULL);
+  result = g_build_filename (arg_cache_dir, filename, NULL);
+
+  g_free (filename);
+  g_checksum_free (checksum);
+
+  return result;
+}
+
+static cairo_surface_t *
+snapshot_reference_file (const char *ui_file,
+                         const char *reference_file)
+{
+  cairo_surface_t *image;
+  char *cache_file;
+
+  cache_file = get_cached_reference_image (ui_file, reference_file);
+  if (cache_file == NULL)
+    return reftest_snapshot_ui_file (reference_file);
+
+  image = cairo_image_surface_create_from_png (cache_file);
+  if (cairo_surface_status (image) == CAIRO_STATUS_SUCCESS)
+    {
+      g_test_message ("Using cached reference image %s", cache_file);
+      g_free (cache_file);
+      return image;
+    }
+  cairo_surface_destroy (image);
+
+  image = reftest_snapshot_ui_file (reference_file);
+
+  /* Tests run in parallel, so write to a temporary file and move it
+   * into place, to never let anyone see a half-written image.
+   */
+  if (g_mkdir_with_parents (arg_cache_dir, 0755) == 0)
+    {
+      char *tmp_file = g_strdup_printf ("%s.%08x.tmp", cache_file, g_random_int ());
+
+      if (cairo_surface_write_to_png (image, tmp_file) != CAIRO_STATUS_SUCCESS ||
+          g_rename (tmp_file, cache_file) != 0)
+        g_unlink (tmp_file);
+
+      g_free (tmp_file);
+    }
+
+  g_free (cache_file);
+
+  return image;
+}
+
 static GtkStyleProvider *
 add_extra_css (const char *testname,
                const char *extension)
@@ -306,7 +422,7 @@ test_ui_file (GFile *file)
   if ((reference_file = get_reference_image (ui_file)) != NULL)
     reference_image = cairo_image_surface_create_from_png (reference_file);
   else if ((reference_file = get_test_file (ui_file, ".ref.ui", TRUE)) != NULL)
-    reference_image = reftest_snapshot_ui_file (reference_file);
+    reference_image = snapshot_reference_file (ui_file, reference_file);
   else
     {
       reference_image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);